@@ -35,6 +35,8 @@
 #include <alsa/asoundlib.h>
 #include <QThread>
 
+#include <atomic>
+
 #include "AudioDevice.h"
 
 
@@ -79,15 +81,40 @@ public:
 
 	static DeviceInfoCollection getAvailableDevices();
 
+	f_cnt_t outputLatency() const override
+	{
+		return m_delay.load( std::memory_order_relaxed );
+	}
+
 private:
+	//! Sample formats written to the device
+	enum SampleFormats
+	{
+		FormatS16,
+		FormatS32,
+		FormatFloat
+	} ;
+
 	void startProcessing() override;
 	void stopProcessing() override;
 	void applyQualitySettings() override;
 	void run() override;
 
+	//! Writes each period straight into the ring of the device, in its
+	//! native format, waking up on the poll descriptors of the device
+	void runMmap();
+	//! Converts frames to the format of the device, interleaved at dst
+	void convertFrames( const surroundSampleFrame * src, fpp_t frames,
+								void * dst );
+
+	//! Sets the hardware and software parameters, using mmap access if
+	//! enabled and available
+	int setParams();
 	int setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access );
 	int setSWParams();
 	int handleError( int _err );
+	//! Queries the delay of the device after writing a period
+	void updateDelay();
 
 
 	snd_pcm_t * m_handle;
@@ -100,6 +127,11 @@ private:
 
 	bool m_convertEndian;
 
+	bool m_mmap;
+	SampleFormats m_format;
+
+	std::atomic<f_cnt_t> m_delay;
+
 } ;
 
 #endif
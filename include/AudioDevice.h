@@ -29,8 +29,11 @@
 #include <samplerate.h>
 
 #include "lmms_basics.h"
+#include "PolyphaseResampler.h"
+#include "SampleConversion.h"
 
 
+class AudioFileDevice;
 class AudioPort;
 class Mixer;
 class QThread;
@@ -77,7 +80,11 @@ public:
 		return m_channels;
 	}
 
-	void processNextBuffer();
+	virtual void processNextBuffer();
+
+	//! Write a buffer the device didn't fetch from the mixer itself, e.g.
+	//! the output of a single audio port. Resamples if needed.
+	void processExternalBuffer( const surroundSampleFrame * _ab );
 
 	virtual void startProcessing()
 	{
@@ -88,6 +95,47 @@ public:
 
 	virtual void applyQualitySettings();
 
+	//! Whether the mixer should render in its own thread and pass the
+	//! periods through a FIFO; devices calling Mixer::nextBuffer() from a
+	//! realtime callback that can take the time to render return false
+	virtual bool needsFifo() const
+	{
+		return true;
+	}
+
+	//! The frames the device buffers before they are audible, as reported
+	//! by the driver, or -1 if it doesn't report it. Can be called from any
+	//! thread.
+	virtual f_cnt_t outputLatency() const
+	{
+		return -1;
+	}
+
+	//! Whether the device can export through its audio server running
+	//! faster than realtime, see startFreewheel()
+	virtual bool supportsFreewheel() const
+	{
+		return false;
+	}
+
+	/*! \brief Make the audio server run as fast as its clients allow
+	 *
+	 *  The device keeps rendering to the server and writes what it plays,
+	 *  or what comes back from other clients its output is routed
+	 *  through, to @p output, which has to have the device's sample rate.
+	 *  Returns false if the server doesn't allow it.
+	 */
+	virtual bool startFreewheel( AudioFileDevice * /* output */ )
+	{
+		return false;
+	}
+
+	//! Write what is still on its way to the output and return to
+	//! realtime
+	virtual void stopFreewheel()
+	{
+	}
+
 
 
 protected:
@@ -102,7 +150,14 @@ protected:
 	// called by according driver for fetching new sound-data
 	fpp_t getNextBuffer( surroundSampleFrame * _ab );
 
-	// convert a given audio-buffer to a buffer in signed 16-bit samples
+	// called by getNextBuffer() with each period as it comes from the
+	// mixer, at the processing rate
+	virtual void bufferFetched( const surroundSampleFrame * /* _ab */ )
+	{
+	}
+
+	// convert a given audio-buffer to a buffer in signed 16-bit samples,
+	// dithered by ditherer()
 	// returns num of bytes in outbuf
 	int convertToS16( const surroundSampleFrame * _ab,
 						const fpp_t _frames,
@@ -114,7 +169,8 @@ protected:
 	void clearS16Buffer( int_sample_t * _outbuf,
 							const fpp_t _frames );
 
-	// resample given buffer from samplerate _src_sr to samplerate _dst_sr
+	// resample given buffer from samplerate _src_sr to samplerate _dst_sr,
+	// writing at most _frames frames; only call from one thread at a time
 	fpp_t resample( const surroundSampleFrame * _src,
 					const fpp_t _frames,
 					surroundSampleFrame * _dst,
@@ -131,8 +187,17 @@ protected:
 		return m_mixer;
 	}
 
+	//! The dither state of the device's output, off by default
+	SampleConversion::Ditherer & ditherer()
+	{
+		return m_ditherer;
+	}
+
 	bool hqAudio() const;
 
+	//! To be called by devices when the output ran dry, from any thread
+	void reportUnderrun();
+
 	static void stopProcessingThread( QThread * thread );
 
 
@@ -148,11 +213,14 @@ private:
 
 	QMutex m_devMutex;
 
+	PolyphaseResampler m_resampler;
 	SRC_DATA m_srcData;
 	SRC_STATE * m_srcState;
 
 	surroundSampleFrame * m_buffer;
 
+	SampleConversion::Ditherer m_ditherer;
+
 } ;
 
 
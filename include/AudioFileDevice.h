@@ -27,10 +27,17 @@
 #define AUDIO_FILE_DEVICE_H
 
 #include <QtCore/QFile>
+#include <QtCore/QStringList>
+
+#include <memory>
+#include <vector>
 
 #include "AudioDevice.h"
+#include "MixerProfiler.h"
 #include "OutputSettings.h"
 
+class PeriodBufferFifo;
+
 
 class AudioFileDevice : public AudioDevice
 {
@@ -47,6 +54,44 @@ public:
 
 	OutputSettings const & getOutputSettings() const { return m_outputSettings; }
 
+	/*! \brief Also write every period to another file
+	 *
+	 *  The mirror keeps its own format and settings and is resampled to its
+	 *  own sample rate, so one render pass can be exported to several
+	 *  formats. Takes ownership of the device.
+	 */
+	void addMirror( AudioFileDevice * mirror );
+
+	//! The files written by this device and its mirrors
+	QStringList outputFiles() const;
+
+	/*! \brief Encode the periods on a thread of their own
+	 *
+	 *  From now on, processNextBuffer() only renders and queues the period,
+	 *  so rendering doesn't wait for the encoder unless the queue of
+	 *  queueDepth periods is full. Meant for exports, which don't run the
+	 *  mixer's FIFO writer.
+	 */
+	void startEncoderThread( int queueDepth );
+
+	//! Wait until the queued periods are encoded and stop the thread; must
+	//! be called before the device is destroyed
+	void stopEncoderThread();
+
+	//! Time spent by the encoder threads of this device and its mirrors,
+	//! in nanoseconds
+	quint64 encodingTime() const;
+
+	void processNextBuffer() override;
+
+	//! Write frames rendered elsewhere, e.g. by another process, which
+	//! are at the sample rate of the device and have the master gain
+	//! applied already
+	void writeFrames( const surroundSampleFrame * frames, fpp_t count )
+	{
+		writeBuffer( frames, count, 1.0f );
+	}
+
 
 protected:
 	int writeData( const void* data, int len );
@@ -62,8 +107,39 @@ protected:
 	}
 
 private:
+	class EncoderThread;
+
+	struct QueuedPeriod
+	{
+		fpp_t frames;
+		float masterGain;
+	} ;
+
+	void bufferFetched( const surroundSampleFrame * _ab ) override;
+
+	//! Resample a period at the processing rate and write or queue it
+	void processMirroredBuffer( const surroundSampleFrame * _ab );
+
+	//! Pass the buffer last acquired from m_encoderQueue to the encoder
+	void queuePeriod( fpp_t frames );
+
+	//! Run by the encoder thread
+	void encodeQueuedPeriods();
+
 	QFile m_outputFile;
 	OutputSettings m_outputSettings;
+
+	std::unique_ptr<PeriodBufferFifo> m_encoderQueue;
+	std::unique_ptr<EncoderThread> m_encoderThread;
+	// the length and gain of each buffer in m_encoderQueue
+	std::vector<QueuedPeriod> m_queuedPeriods;
+	// only touched by the rendering thread
+	long m_queuedCount;
+	// only touched by the encoder thread
+	long m_encodedCount;
+	MixerProfiler::TimeCounter m_encodingTime;
+
+	std::vector<std::unique_ptr<AudioFileDevice>> m_mirrors;
 } ;
 
 
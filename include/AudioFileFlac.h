@@ -28,7 +28,7 @@
 #include "lmmsconfig.h"
 
 #include "AudioFileDevice.h"
-#include <sndfile.h>
+#include "SndfileBlockWriter.h"
 
 class AudioFileFlac: public AudioFileDevice
 {
@@ -62,6 +62,9 @@ private:
 	SF_INFO  m_sfinfo;
 	SNDFILE* m_sf;
 
+	SndfileBlockWriter<int32_t> m_intBlock;
+	SndfileBlockWriter<int16_t> m_shortBlock;
+
 	virtual void writeBuffer(surroundSampleFrame const* _ab,
 						fpp_t const frames,
 						float master_gain) override;
@@ -34,6 +34,8 @@
 
 #include "lame/lame.h"
 
+#include <vector>
+
 
 class AudioFileMP3 : public AudioFileDevice
 {
@@ -67,6 +69,7 @@ private:
 
 private:
 	lame_t m_lame;
+	std::vector<float> m_interleavedBuffer;
 };
 
 #endif
@@ -28,8 +28,7 @@
 
 #include "lmmsconfig.h"
 #include "AudioFileDevice.h"
-
-#include <sndfile.h>
+#include "SndfileBlockWriter.h"
 
 
 class AudioFileWave : public AudioFileDevice
@@ -64,6 +63,12 @@ private:
 private:
 	SF_INFO m_si;
 	SNDFILE * m_sf;
+
+	// the samples converted to the bit depth of the file, of which only
+	// the one used has a buffer
+	SndfileBlockWriter<float> m_floatBlock;
+	SndfileBlockWriter<int32_t> m_intBlock;
+	SndfileBlockWriter<int16_t> m_shortBlock;
 } ;
 
 #endif
@@ -35,15 +35,19 @@
 #endif
 
 #include <atomic>
+#include <vector>
 #include <QtCore/QVector>
 #include <QtCore/QList>
 #include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
 
 #include "AudioDevice.h"
 #include "AudioDeviceSetupWidget.h"
 
 class QLineEdit;
 class LcdSpinBox;
+class LedCheckBox;
 class MidiJack;
 
 
@@ -79,6 +83,8 @@ public:
 	private:
 		QLineEdit * m_clientName;
 		LcdSpinBox * m_channels;
+		LedCheckBox * m_native;
+		LedCheckBox * m_portOutputs;
 
 	} ;
 
@@ -94,15 +100,47 @@ private:
 	virtual void stopProcessing();
 	virtual void applyQualitySettings();
 
+	bool needsFifo() const override
+	{
+		return !m_native;
+	}
+
+	f_cnt_t outputLatency() const override;
+
+	bool supportsFreewheel() const override
+	{
+		return true;
+	}
+
+	bool startFreewheel( AudioFileDevice * output ) override;
+	void stopFreewheel() override;
+
 	virtual void registerPort( AudioPort * _port );
 	virtual void unregisterPort( AudioPort * _port );
 	virtual void renamePort( AudioPort * _port );
 
 	int processCallback( jack_nframes_t _nframes, void * _udata );
 
+	//! Renders whole periods from the process callback straight into the
+	//! port buffers; returns the frames done
+	jack_nframes_t renderNative( jack_nframes_t nframes );
+	//! Writes the output of the registered audio ports for the period
+	//! just rendered to their JACK ports at offset
+	void writePortOutputs( jack_nframes_t nframes, jack_nframes_t offset,
+							fpp_t frames );
+	//! Silences the JACK ports of the audio ports from offset on
+	void clearPortOutputs( jack_nframes_t nframes, jack_nframes_t offset );
+	//! Writes the cycle just played, or what came back to the export
+	//! ports, to the output of a freewheeling export
+	void writeFreewheelOutput( AudioFileDevice * output,
+						jack_nframes_t nframes );
+
 	static int staticProcessCallback( jack_nframes_t _nframes,
 							void * _udata );
 	static void shutdownCallback( void * _udata );
+	static int xrunCallback( void * _udata );
+	static int bufferSizeCallback( jack_nframes_t _nframes,
+							void * _udata );
 
 
 	jack_client_t * m_client;
@@ -110,8 +148,15 @@ private:
 	bool m_active;
 	std::atomic<bool> m_stopped;
 
+	// the mixer renders in the process callback instead of a FIFO writer
+	const bool m_native;
+	// audio ports get their own JACK ports, only in native mode
+	const bool m_portOutputs;
+
 	std::atomic<MidiJack *> m_midiClient;
 	QVector<jack_port_t *> m_outputPorts;
+	// the export in freewheel mode records these if they are connected
+	jack_port_t * m_exportPorts[DEFAULT_CHANNELS];
 	jack_default_audio_sample_t * * m_tempOutBufs;
 	surroundSampleFrame * m_outBuf;
 
@@ -119,7 +164,6 @@ private:
 	f_cnt_t m_framesToDoInCurBuf;
 
 
-#ifdef AUDIO_PORT_SUPPORT
 	struct StereoPort
 	{
 		jack_port_t * ports[2];
@@ -127,7 +171,18 @@ private:
 
 	typedef QMap<AudioPort *, StereoPort> JackPortMap;
 	JackPortMap m_portMap;
-#endif
+	// guards m_portMap; the process callback only tries to lock it
+	QMutex m_portMapMutex;
+
+	// the export output while freewheeling
+	std::atomic<AudioFileDevice *> m_freewheelOutput;
+	bool m_freewheelFromExportPorts;
+	// frames of latency still to skip at the start of the export
+	f_cnt_t m_freewheelSkip;
+	// frames left to write once stopFreewheel() was called, or -1
+	std::atomic<f_cnt_t> m_freewheelTail;
+	QSemaphore m_freewheelDone;
+	std::vector<surroundSampleFrame> m_freewheelBuffer;
 
 signals:
 	void zombified();
@@ -0,0 +1,114 @@
+/*
+ * AudioPipeWire.h - device-class that renders in the PipeWire process callback
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef AUDIO_PIPEWIRE_H
+#define AUDIO_PIPEWIRE_H
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_HAVE_PIPEWIRE
+
+#include <atomic>
+#include <QtCore/QMutex>
+
+#include <pipewire/pipewire.h>
+
+#include "AudioDevice.h"
+#include "AudioDeviceSetupWidget.h"
+
+class LcdSpinBox;
+class QLineEdit;
+
+
+/*! \brief Output through a PipeWire stream
+ *
+ *  The mixer renders in the process callback of the stream, so there is no
+ *  FIFO between the mixer and the graph. The callback takes whatever
+ *  quantum the graph runs at, continuing the current period where the last
+ *  callback stopped.
+ */
+class AudioPipeWire : public AudioDevice
+{
+public:
+	AudioPipeWire( bool & _success_ful, Mixer * _mixer );
+	virtual ~AudioPipeWire();
+
+	inline static QString name()
+	{
+		return QT_TRANSLATE_NOOP( "AudioDeviceSetupWidget", "PipeWire" );
+	}
+
+	class setupWidget : public AudioDeviceSetupWidget
+	{
+	public:
+		setupWidget( QWidget * _parent );
+		virtual ~setupWidget();
+
+		void saveSettings() override;
+
+	private:
+		QLineEdit * m_target;
+		LcdSpinBox * m_channels;
+	} ;
+
+private:
+	void startProcessing() override;
+	void stopProcessing() override;
+	void applyQualitySettings() override;
+
+	bool needsFifo() const override
+	{
+		return false;
+	}
+
+	//! Offers planar float at the current sample rate to the graph
+	void updateFormat( bool connect );
+
+	void processCallback();
+	void stateChanged( pw_stream_state state, const char * error );
+
+	static void staticProcessCallback( void * _udata );
+	static void staticStateChanged( void * _udata, pw_stream_state old,
+				pw_stream_state state, const char * error );
+
+	pw_thread_loop * m_loop;
+	pw_stream * m_stream;
+	pw_stream_events m_streamEvents;
+	pw_stream_state m_state;
+
+	std::atomic<bool> m_stopped;
+	// held by the process callback, so stopping can wait for it
+	QMutex m_processMutex;
+
+	// the period being played and its frames already written
+	const surroundSampleFrame * m_period;
+	fpp_t m_periodDone;
+
+} ;
+
+
+#endif	/* LMMS_HAVE_PIPEWIRE */
+
+#endif	/* AUDIO_PIPEWIRE_H */
@@ -25,14 +25,18 @@
 #ifndef AUDIO_PORT_H
 #define AUDIO_PORT_H
 
+#include <functional>
 #include <memory>
 #include <QtCore/QString>
 #include <QtCore/QMutex>
 #include <QtCore/QMutexLocker>
 
 #include "MemoryManager.h"
+#include "MixerProfiler.h"
+#include "MixHelpers.h"
 #include "PlayHandle.h"
 
+class AudioDevice;
 class EffectChain;
 class FloatModel;
 class BoolModel;
@@ -70,6 +74,9 @@ public:
 
 	void setExtOutputEnabled( bool _enabled );
 
+	//! Whether the port is muted, in which case buffer() is not updated
+	bool isMuted() const;
+
 
 	// next effect-channel after this audio-port
 	// (-1 = none  0 = master)
@@ -97,7 +104,56 @@ public:
 	void setName( const QString & _new_name );
 
 
-	bool processEffects();
+	//! Additionally write the output of this port to @p device every
+	//! period (e.g. to export it as a stem), nullptr to stop
+	void setStemOutput( AudioDevice * device )
+	{
+		m_stemOutput = device;
+	}
+
+	AudioDevice * stemOutput() const
+	{
+		return m_stemOutput;
+	}
+
+
+	//! Reserve (or release) the buffer for addFrozenFrames(), call with
+	//! the mixer locked
+	void setFrozen( bool frozen );
+
+	//! Play @p frames frames of @p src at @p offset in the current period
+	//! instead of the output of the play handles and the effects, e.g. the
+	//! rendering of a frozen track
+	void addFrozenFrames( const sampleFrame * src, f_cnt_t frames,
+						f_cnt_t offset );
+
+
+	//! Time spent rendering the play handles of this port and processing
+	//! the port itself
+	MixerProfiler::TimeCounter & processingTime()
+	{
+		return m_processingTime;
+	}
+
+	//! Samples in denormal range in the output of the play handles
+	const MixerProfiler::DenormalCounter & denormals() const
+	{
+		return m_denormals;
+	}
+
+
+	//! Called with the play handles of the port in doProcessing(), after
+	//! all of them were rendered and before their buffers are mixed into
+	//! the given port buffer - returns whether it added sound to it
+	typedef std::function<bool( const PlayHandleList &, sampleFrame * )> PreMixHandler;
+	void setPreMixHandler( const PreMixHandler & handler )
+	{
+		m_preMixHandler = handler;
+	}
+
+
+	//! Sets analysis to the analysis of the port's output
+	bool processEffects( MixHelpers::BufferAnalysis * analysis );
 
 	// ThreadableJob stuff
 	void doProcessing() override;
@@ -110,6 +166,8 @@ public:
 	void removePlayHandle( PlayHandle * handle );
 
 private:
+	void writeStem();
+
 	volatile bool m_bufferUsage;
 
 	sampleFrame * m_portBuffer;
@@ -129,6 +187,26 @@ private:
 	FloatModel * m_panningModel;
 	BoolModel * m_mutedModel;
 
+	AudioDevice * m_stemOutput;
+
+	PreMixHandler m_preMixHandler;
+
+	// frames added by addFrozenFrames() for the current period, only
+	// allocated while the port is frozen
+	sampleFrame * m_frozenBuffer;
+	bool m_hasFrozenFrames;
+
+	// set when there was neither input nor a running effect in the last
+	// period, so the buffer is still clear and processing can be skipped
+	bool m_sleeping;
+
+	MixerProfiler::TimeCounter m_processingTime;
+	MixerProfiler::DenormalCounter m_denormals;
+
+	// batch of the mixer the last notes of this port went into while
+	// grouping the play handles of a period, -1 if none
+	int m_noteBatch;
+
 	friend class Mixer;
 	friend class MixerWorkerThread;
 
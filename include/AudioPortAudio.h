@@ -62,6 +62,7 @@ public:
 
 class ComboBox;
 class LcdSpinBox;
+class LedCheckBox;
 
 
 class AudioPortAudio : public AudioDevice
@@ -93,6 +94,7 @@ public:
 	private:
 		ComboBox * m_backend;
 		ComboBox * m_device;
+		LedCheckBox * m_native;
 		AudioPortAudioSetupUtil m_setupUtil;
 
 	} ;
@@ -102,6 +104,16 @@ private:
 	virtual void stopProcessing();
 	virtual void applyQualitySettings();
 
+	bool needsFifo() const override
+	{
+		return !m_native;
+	}
+
+	f_cnt_t outputLatency() const override;
+
+	PaError openStream();
+	void renderNative( float * _outputBuffer, unsigned long _framesPerBuffer );
+
 #ifdef PORTAUDIO_V19
 	static int _process_callback( const void *_inputBuffer, void * _outputBuffer,
 		unsigned long _framesPerBuffer,
@@ -117,6 +129,7 @@ private:
 #define Pa_GetDefaultInputDevice Pa_GetDefaultInputDeviceID
 #define Pa_GetDefaultOutputDevice Pa_GetDefaultOutputDeviceID
 #define Pa_IsStreamActive Pa_StreamActive
+#define paFramesPerBufferUnspecified 0
 
 	static int _process_callback( void * _inputBuffer, void * _outputBuffer,
 		unsigned long _framesPerBuffer, PaTimestamp _outTime, void * _arg );
@@ -148,6 +161,10 @@ private:
 
 	bool m_stopped;
 
+	// render in the stream callback at the block size of the host
+	const bool m_native;
+	unsigned long m_requestedFrames;
+
 } ;
 
 #endif
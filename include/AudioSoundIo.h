@@ -39,6 +39,7 @@
 
 class ComboBox;
 class LcdSpinBox;
+class LedCheckBox;
 
 // Exists only to work around "Error: Meta object features not supported for nested classes"
 class AudioSoundIoSetupUtil : public QObject
@@ -80,6 +81,7 @@ public:
 		AudioSoundIoSetupUtil m_setupUtil;
 		ComboBox * m_backend;
 		ComboBox * m_device;
+		LedCheckBox * m_native;
 
 		ComboBoxModel m_backendModel;
 		ComboBoxModel m_deviceModel;
@@ -101,6 +103,11 @@ private:
 	virtual void startProcessing();
 	virtual void stopProcessing();
 
+	bool needsFifo() const override
+	{
+		return !m_native;
+	}
+
 	SoundIo *m_soundio;
 	SoundIoOutStream *m_outstream;
 
@@ -112,6 +119,9 @@ private:
 	bool m_stopped;
 	bool m_outstreamStarted;
 
+	// render in the write callback, in whole periods where possible
+	bool m_native;
+
 	int m_disconnectErr;
 	void onBackendDisconnect(int err);
 
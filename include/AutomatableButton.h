@@ -94,6 +94,9 @@ public:
 
 	void modelChanged() override;
 
+protected:
+	void modelDataChanged() override;
+
 
 private slots:
 	void updateButtons();
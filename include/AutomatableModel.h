@@ -25,10 +25,13 @@
 #ifndef AUTOMATABLE_MODEL_H
 #define AUTOMATABLE_MODEL_H
 
+#include <atomic>
+
 #include <QtCore/QMap>
 #include <QtCore/QMutex>
 
 #include "JournallingObject.h"
+#include "lmms_basics.h"
 #include "Model.h"
 #include "TimePos.h"
 #include "ValueBuffer.h"
@@ -210,6 +213,13 @@ public:
 	void setInitValue( const float value );
 
 	void setAutomatedValue( const float value );
+	//! Returns the value setAutomatedValue() gives the model for value
+	float automatedValueOf( const float value ) const;
+	//! Sets the frames offset to offset + frames of the period the song is
+	//! processed for to values of an automation pattern, which
+	//! valueBuffer() returns in that period
+	void setAutomatedValueBuffer( const float * values, f_cnt_t offset,
+							f_cnt_t frames );
 	void setValue( const float value );
 
 	void incValue( int steps )
@@ -299,16 +309,6 @@ public:
 		m_hasStrictStepSize = b;
 	}
 
-	static void incrementPeriodCounter()
-	{
-		++s_periodCounter;
-	}
-
-	static void resetPeriodCounter()
-	{
-		s_periodCounter = 0;
-	}
-
 	bool useControllerValue()
 	{
 		return m_useControllerValue;
@@ -368,6 +368,10 @@ private:
 	void linkModel( AutomatableModel* model );
 	void unlinkModel( AutomatableModel* model );
 
+	//! Calculates m_valueBuffer for the current period, returns whether
+	//! there is sample-exact data
+	bool updateValueBuffer();
+
 	//! @brief Scales @value from linear to logarithmic.
 	//! Value should be within [0,1]
 	template<class T> T logToLinearScale( T value ) const;
@@ -404,13 +408,16 @@ private:
 
 
 	ValueBuffer m_valueBuffer;
-	long m_lastUpdatedPeriod;
-	static long s_periodCounter;
+	std::atomic<long> m_lastUpdatedPeriod;
+	// the period whose buffer a thread has started to calculate
+	std::atomic<long> m_claimedPeriod;
+	// frames set by setAutomatedValueBuffer() in m_automatedPeriod
+	ValueBuffer m_automatedBuffer;
+	long m_automatedPeriod;
+	f_cnt_t m_automatedFrames;
 
 	bool m_hasSampleExactData;
 
-	// prevent several threads from attempting to write the same vb at the same time
-	QMutex m_valueBufferMutex;
 
 	bool m_useControllerValue;
 
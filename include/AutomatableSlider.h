@@ -57,6 +57,7 @@ protected:
 	void wheelEvent( QWheelEvent * _me ) override;
 
 	void modelChanged() override;
+	void modelDataChanged() override;
 
 
 private:
@@ -26,6 +26,8 @@
 #ifndef AUTOMATION_EDITOR_H
 #define AUTOMATION_EDITOR_H
 
+#include <vector>
+
 #include <QVector>
 #include <QWidget>
 
@@ -108,7 +110,6 @@ protected:
 	float getLevel( int y );
 	int xCoordOfTick( int tick );
 	float yCoordOfLevel( float level );
-	inline void drawLevelTick(QPainter & p, int tick, float value);
 
 	timeMap::iterator getNodeAt(int x, int y, bool outValue = false, int r = 5);
 
@@ -218,6 +219,38 @@ private:
 
 	void drawCross(QPainter & p );
 	void drawAutomationPoint( QPainter & p, timeMap::iterator it );
+
+	struct CurveKey
+	{
+		const AutomationPattern * pattern;
+		int position;
+		int ppb;
+		int columns;
+
+		bool operator==( const CurveKey & other ) const
+		{
+			return pattern == other.pattern && position == other.position &&
+				ppb == other.ppb && columns == other.columns;
+		}
+	} ;
+	// the curve reduced to its lowest and highest value in each pixel
+	// column, NaN before the first node. Only computed again after edits,
+	// scrolling and zooming, and for node drags only where it changed.
+	std::vector<float> m_curveMin;
+	std::vector<float> m_curveMax;
+	CurveKey m_curveKey;
+	unsigned m_curveRevision;
+	// the columns to compute again
+	int m_curveDirtyFrom;
+	int m_curveDirtyTo;
+	void updateCurve();
+	void drawCurve( QPainter & p );
+	//! Marks the curve around the nodes from @p fromTick to @p toTick as
+	//! changed. Returns whether the rest of the curve is up to date.
+	bool invalidateCurve( int fromTick, int toTick );
+	//! After an edit of the nodes passed to invalidateCurve(), which
+	//! returned @p upToDate
+	void curveEdited( int fromTick, int toTick, bool upToDate );
 	bool inBBEditor();
 
 	QColor m_barLineColor;
@@ -30,11 +30,17 @@
 #include <QtCore/QMap>
 #include <QtCore/QPointer>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "AutomationNode.h"
+#include "LocklessList.h"
 #include "TrackContentObject.h"
 
 
 class AutomationTrack;
+class QTimer;
 class TimePos;
 
 
@@ -93,6 +99,10 @@ public:
 		const bool ignoreSurroundingPoints = true
 	);
 
+	//! Puts a node for each tick of @p values at once, which is much faster
+	//! than putting them one by one. The ticks aren't quantized.
+	void putValues(const QMap<int, float> & values);
+
 	void removeNode(const TimePos & time);
 	void removeNodes(const int tick0, const int tick1);
 
@@ -139,6 +149,11 @@ public:
 	}
 
 	float valueAt( const TimePos & _time ) const;
+	//! Renders the curve for one frame after the other, starting
+	//! @p offset ticks after @p time and advancing by @p step ticks per
+	//! frame; the frames have to stay before the node following @p time
+	void valuesAt( const TimePos & time, float offset, float step,
+					float * values, int frames ) const;
 	float *valuesAfter( const TimePos & _time ) const;
 
 	const QString name() const;
@@ -159,11 +174,20 @@ public:
 	static void resolveAllIDs();
 
 	bool isRecording() const { return m_isRecording; }
-	void setRecording( const bool b ) { m_isRecording = b; }
+	//! While recording, every change of the first object is recorded, and
+	//! the song adds the value of each tick it plays
+	void setRecording( const bool b );
+	//! Adds a value to record at @p time, relative to the start of the
+	//! pattern, without locking; it is merged into the pattern on the GUI
+	//! thread, so the editor never sees the nodes change while painting
+	void queueRecordedValue( const TimePos & time, float value );
 
 	static int quantization() { return s_quantization; }
 	static void setQuantization(int q) { s_quantization = q; }
 
+	//! Returns a number that changes whenever the curve of any pattern does
+	static unsigned editRevision() { return s_editRevision; }
+
 public slots:
 	void clear();
 	void objectDestroyed( jo_id_t );
@@ -171,11 +195,38 @@ public slots:
 	void flipY();
 	void flipX( int length = -1 );
 
+private slots:
+	void recordObjectChange();
+	void mergeRecordedValues();
+
 private:
+	struct RecordedValue
+	{
+		tick_t time;
+		float value;
+	} ;
+
+	//! A node and the curve to the next one, for playback
+	struct Segment
+	{
+		int pos;
+		float inValue;
+		//! The value at pos + offset, for offsets up to the next node, is
+		//! ((a * t + b) * t + c) * t + d with t = offset * scale
+		float a, b, c, d;
+		float scale;
+	} ;
+
 	void cleanObjects();
+	//! Marks m_segments as outdated after an edit
+	void invalidateSegments();
 	void generateTangents();
 	void generateTangents(timeMap::iterator it, int numToGenerate);
 	float valueAt( timeMap::const_iterator v, int offset ) const;
+	void compileSegments() const;
+	//! The index of the segment containing @p time, starting the search
+	//! at the one last used, or -1 if @p time is before the first node
+	int findSegment( int time ) const;
 
 	// Mutex to make methods involving automation patterns thread safe
 	// Mutable so we can lock it from const objects
@@ -190,14 +241,29 @@ private:
 	bool m_hasAutomation;
 	ProgressionTypes m_progressionType;
 
+	// m_timeMap as an array, rebuilt on the first valueAt() after
+	// an edit, so playback needs no map lookups
+	mutable std::vector<Segment> m_segments;
+	mutable bool m_segmentsValid;
+	mutable int m_lastSegment;
+
 	bool m_dragging;
 	bool m_dragKeepOutValue; // Should we keep the current dragged node's outValue?
 	float m_dragOutValue; // The outValue of the dragged node's
 
 	bool m_isRecording;
 	float m_lastRecordedValue;
+	// values to record, from any thread, created when recording starts
+	std::unique_ptr<LocklessList<RecordedValue>> m_recordedValues;
+	QTimer * m_recordTimer;
+	QMetaObject::Connection m_recordConnection;
 
 	static int s_quantization;
+	static std::atomic<unsigned> s_editRevision;
+
+	// values that can be queued between two merges
+	static const int RecordQueueSize = 4096;
+	static const int RecordMergeInterval = 20; // ms
 
 	static const float DEFAULT_MIN_VALUE;
 	static const float DEFAULT_MAX_VALUE;
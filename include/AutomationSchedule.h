@@ -0,0 +1,187 @@
+/*
+ * AutomationSchedule.h - automation of a track container, prepared for playback
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AUTOMATION_SCHEDULE_H
+#define AUTOMATION_SCHEDULE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+
+#include "AutomatableModel.h"
+#include "Track.h"
+
+class AutomationPattern;
+class TrackContainer;
+
+
+/*! \brief The automation of a track container, prepared for playback
+ *
+ *  Gives the same values as TrackContainer::automatedValuesAt(), but keeps
+ *  for every automated model the TCOs that may automate it, sorted by their
+ *  start, and a cursor into them that follows the play position. Applying
+ *  the automation of a period then costs little more than one valueAt()
+ *  per model, instead of collecting and sorting the TCOs of all tracks and
+ *  filling a map.
+ *
+ *  The schedule is rebuilt when the arrangement changes, which the tracks,
+ *  TCOs and patterns announce through arrangementChanged(). Mute states and
+ *  whether a pattern has automation are checked while applying, so toggling
+ *  them does not trigger a rebuild.
+ */
+class AutomationSchedule
+{
+public:
+	AutomationSchedule();
+	~AutomationSchedule();
+
+	//! Marks all schedules as outdated; call whenever tracks or TCOs are
+	//! added, removed, reordered, moved or resized, or a pattern gains or
+	//! loses models
+	static void arrangementChanged()
+	{
+		++s_revision;
+	}
+
+	//! Returns a number that changes with every arrangementChanged()
+	static unsigned revision()
+	{
+		return s_revision;
+	}
+
+	//! Returns whether the schedule still fits the given arguments of build()
+	bool isCurrent(const TrackContainer* container, int tcoNum) const;
+
+	/*! \brief Builds the schedule for the given tracks
+	 *
+	 *  \param container The container holding the tracks
+	 *  \param tracks The tracks to take the automation from, in the order
+	 *	of TrackContainer::automatedValuesFromTracks()
+	 *  \param tcoNum As for TrackContainer::automatedValuesAt(); if not
+	 *	negative, container has to be the BB track container
+	 */
+	void build(const TrackContainer* container, const TrackList& tracks, int tcoNum = -1);
+
+	//! Sets all automated models to their values at time, except the ones in
+	//! skip, which are given to their controllers instead. Models that
+	//! stopped being automated since the last call go back to their
+	//! controllers, too.
+	void apply(TimePos time, const QSet<const AutomatableModel*>& skip);
+
+	/*! \brief Renders the automation of the last apply() frame by frame
+	 *
+	 *  Passes the curves of the automation patterns to
+	 *  AutomatableModel::setAutomatedValueBuffer(), so models are automated
+	 *  sample-exactly within a period.
+	 *
+	 *  \param ticks Ticks since the time given to apply(), less than one
+	 *  \param offset The first frame in the period
+	 *  \param frames Number of frames, which have to stay within the tick
+	 */
+	void render(float ticks, f_cnt_t offset, f_cnt_t frames);
+
+	//! Gives all models automated by the last apply() back to their controllers
+	void release();
+
+	//! Forgets the schedule without touching any model
+	void clear();
+
+	//! Returns the slot of model for valueAt(), or -1 if nothing in the
+	//! schedule may automate it
+	int slotOf(const AutomatableModel* model) const;
+
+	//! Returns the end of the last TCO that may automate a slot
+	tick_t endOf(int slot) const;
+
+	/*! \brief Evaluates the automation of a slot without applying it
+	 *
+	 *  Gives the value apply() would pass to setAutomatedValue(), or returns
+	 *  false if nothing automates the slot at time. Moves the cursor of the
+	 *  slot like apply(), so it is cheapest for increasing times.
+	 */
+	bool valueAt(int slot, tick_t time, float& value);
+
+private:
+	//! A TCO that may automate models
+	struct Source
+	{
+		TrackContentObject* tco;
+		//! null for a BBTCO
+		AutomationPattern* pattern;
+		//! for a BBTCO, the schedule of its beat/bassline
+		AutomationSchedule* bb;
+	} ;
+
+	//! Where a pattern automates a slot
+	struct Position
+	{
+		AutomationPattern* pattern;
+		//! relative to the start of the pattern
+		tick_t time;
+		//! whether the value stays the same until the next tick, as time
+		//! was clamped to the end of a TCO
+		bool held;
+	} ;
+
+	struct Slot
+	{
+		QPointer<AutomatableModel> model;
+		//! indices into m_sources, sorted by start
+		std::vector<int> sources;
+		//! for BB sources, the slot of the model in their schedule
+		std::vector<int> bbSlots;
+		//! number of sources starting at or before the last position
+		size_t cursor;
+		bool automated;
+		//! where the last apply() took the value from, if it was applied
+		Position position;
+	} ;
+
+	//! Finds where a slot is automated at a time relative to the start of
+	//! the container, or returns false if nothing automates it there
+	bool find(Slot& slot, tick_t time, Position& position);
+	//! Maps a time relative to the start of a BBTCO to the time in the
+	//! schedule of its beat/bassline
+	static tick_t bbTime(const Source& source, tick_t time);
+
+	static std::atomic<unsigned> s_revision;
+
+	unsigned m_revision;
+	const TrackContainer* m_container;
+	int m_tcoNum;
+	//! if m_tcoNum is not negative, the length of that beat/bassline in ticks
+	tick_t m_bbLength;
+
+	std::vector<Source> m_sources;
+	std::vector<Slot> m_slots;
+	std::vector<std::unique_ptr<AutomationSchedule>> m_bbSchedules;
+	std::vector<float> m_frames;
+
+} ;
+
+
+#endif
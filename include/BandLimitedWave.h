@@ -54,7 +54,7 @@ const int TLENS[MAXTBL+1] = { 2 << 0, 3 << 0, 2 << 1, 3 << 1,
 typedef struct
 {
 public:
-	inline sample_t sampleAt( int table, int ph )
+	inline sample_t sampleAt( int table, int ph ) const
 	{
 		if( table % 2 == 0 )
 		{	return m_data[ TLENS[ table ] + ph ]; }
@@ -158,12 +158,31 @@ public:
 	*/
 	};
 
+	/*! \brief Block version of oscillate() for a constant wavelength.
+	 *  \param _ph The phases of the samples.
+	 *  \param _out The output, which may be the same array as _ph.
+	 */
+	static void oscillate( const float * _ph, sample_t * _out, int _frames,
+						float _wavelen, Waveforms _wave )
+	{
+		oscillate( _ph, _out, _frames, _wavelen, s_waveforms[_wave] );
+	}
+
+	/*! \brief Block version of oscillate() for the mipmap of any waveform, e.g. one from
+	 *  WaveMipMapCache. Negative phases are wrapped.
+	 */
+	static void oscillate( const float * _ph, sample_t * _out, int _frames,
+						float _wavelen, const WaveMipMap & _waveform );
+
 
 	static void generateWaves();
 
 	static bool s_wavesGenerated;
 
-	static WaveMipMap s_waveforms [NumBLWaveforms];
+	/*! \brief The mipmaps of all NumBLWaveforms waveforms. They point into the memory-mapped table cache
+	 *  which is shared by all LMMS processes, or into a private copy if the cache can't be used.
+	 */
+	static const WaveMipMap * s_waveforms;
 
 	static QString s_wavetableDir;
 };
@@ -0,0 +1,306 @@
+/*
+ * BasicFilterBatch.h - runs the filters of several voices side by side
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef BASIC_FILTER_BATCH_H
+#define BASIC_FILTER_BATCH_H
+
+#include "BasicFilters.h"
+
+
+/*! \brief Processes the BasicFilters of up to MaxVoices stereo voices at once
+ *
+ *  The state and coefficients of every voice are copied into one lane per
+ *  voice and channel, so a frame of all voices is a single pass over
+ *  fixed-size arrays the compiler turns into SIMD code. Each lane computes
+ *  exactly what BasicFilters::update() computes for its voice, and voices
+ *  that start or end within the period can be deactivated for some frames.
+ *
+ *  All voices must have been given the same filter type, and only the Moog
+ *  and biquad types (including their doubled variants) are supported, see
+ *  supports(). Call store() to hand the state back to the voices' filters.
+ */
+class BasicFilterBatch
+{
+public:
+	static const int MaxVoices = 4;
+	static const int Lanes = MaxVoices * DEFAULT_CHANNELS;
+
+	typedef BasicFilters<DEFAULT_CHANNELS> Filter;
+
+	//! Whether a filter of this type can be processed in a batch
+	static bool supports( const int filterType )
+	{
+		switch( filterType )
+		{
+			case Filter::LowPass:
+			case Filter::HiPass:
+			case Filter::BandPass_CSG:
+			case Filter::BandPass_CZPG:
+			case Filter::Notch:
+			case Filter::AllPass:
+			case Filter::Moog:
+			case Filter::DoubleLowPass:
+			case Filter::DoubleMoog:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	BasicFilterBatch( Filter * const * filters, const int voices ) :
+		m_voices( voices ),
+		m_moog( filters[0]->m_type == Filter::Moog ),
+		m_double( filters[0]->m_doubleFilter )
+	{
+		for( int v = 0; v < MaxVoices; ++v )
+		{
+			m_active[v] = true;
+		}
+		for( int l = 0; l < Lanes; ++l )
+		{
+			m_r[l] = m_p[l] = m_k[l] = 0.0f;
+			m_a1[l] = m_a2[l] = m_b0[l] = m_b1[l] = m_b2[l] = 0.0f;
+			for( int s = 0; s < NumStages; ++s )
+			{
+				for( int v = 0; v < StateSize; ++v )
+				{
+					m_state[s][v][l] = 0.0f;
+				}
+			}
+		}
+		for( int v = 0; v < m_voices; ++v )
+		{
+			m_filters[v] = filters[v];
+			loadCoeffs( v );
+			for( int s = 0; s < ( m_double ? 2 : 1 ); ++s )
+			{
+				const Filter * f = s == 0 ? filters[v] : filters[v]->m_subFilter;
+				for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+				{
+					float ( * state )[Lanes] = m_state[s];
+					const int l = v * DEFAULT_CHANNELS + ch;
+					if( m_moog )
+					{
+						state[Y1][l] = f->m_y1[ch];
+						state[Y2][l] = f->m_y2[ch];
+						state[Y3][l] = f->m_y3[ch];
+						state[Y4][l] = f->m_y4[ch];
+						state[OldX][l] = f->m_oldx[ch];
+						state[OldY1][l] = f->m_oldy1[ch];
+						state[OldY2][l] = f->m_oldy2[ch];
+						state[OldY3][l] = f->m_oldy3[ch];
+					}
+					else
+					{
+						state[Z1][l] = f->m_biQuad.m_z1[ch];
+						state[Z2][l] = f->m_biQuad.m_z2[ch];
+					}
+				}
+			}
+		}
+	}
+
+	//! Copies the coefficients of a voice's filter again, e.g. after
+	//! calcFilterCoeffs() was called for it
+	inline void loadCoeffs( const int voice )
+	{
+		const Filter * f = m_filters[voice];
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			const int l = voice * DEFAULT_CHANNELS + ch;
+			m_r[l] = f->m_r;
+			m_p[l] = f->m_p;
+			m_k[l] = f->m_k;
+			m_a1[l] = f->m_biQuad.m_a1;
+			m_a2[l] = f->m_biQuad.m_a2;
+			m_b0[l] = f->m_biQuad.m_b0;
+			m_b1[l] = f->m_biQuad.m_b1;
+			m_b2[l] = f->m_biQuad.m_b2;
+		}
+	}
+
+	//! Inactive voices keep their state until they are activated again,
+	//! their lanes are still computed but have no effect
+	inline void setActive( const int voice, const bool active )
+	{
+		if( active == m_active[voice] )
+		{
+			return;
+		}
+		// save and restore the state instead of masking every frame, as
+		// this only happens when a voice starts or ends within the period
+		const int first = voice * DEFAULT_CHANNELS;
+		for( int s = 0; s < NumStages; ++s )
+		{
+			for( int v = 0; v < StateSize; ++v )
+			{
+				for( int l = first; l < first + DEFAULT_CHANNELS; ++l )
+				{
+					if( active )
+					{
+						m_state[s][v][l] = m_savedState[s][v][l];
+					}
+					else
+					{
+						m_savedState[s][v][l] = m_state[s][v][l];
+					}
+				}
+			}
+		}
+		m_active[voice] = active;
+	}
+
+	//! Filters one frame of all voices in place, lane l is channel
+	//! l % DEFAULT_CHANNELS of voice l / DEFAULT_CHANNELS
+	inline void process( float * io )
+	{
+		if( m_moog )
+		{
+			processMoog( m_state[0], io );
+			if( m_double )
+			{
+				processMoog( m_state[1], io );
+			}
+		}
+		else
+		{
+			processBiQuad( m_state[0], io );
+			if( m_double )
+			{
+				processBiQuad( m_state[1], io );
+			}
+		}
+	}
+
+	//! Writes the state of the lanes back to the voices' filters
+	void store()
+	{
+		for( int v = 0; v < m_voices; ++v )
+		{
+			setActive( v, true );
+			for( int s = 0; s < ( m_double ? 2 : 1 ); ++s )
+			{
+				Filter * f = s == 0 ? m_filters[v] : m_filters[v]->m_subFilter;
+				for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+				{
+					float ( * state )[Lanes] = m_state[s];
+					const int l = v * DEFAULT_CHANNELS + ch;
+					if( m_moog )
+					{
+						f->m_y1[ch] = state[Y1][l];
+						f->m_y2[ch] = state[Y2][l];
+						f->m_y3[ch] = state[Y3][l];
+						f->m_y4[ch] = state[Y4][l];
+						f->m_oldx[ch] = state[OldX][l];
+						f->m_oldy1[ch] = state[OldY1][l];
+						f->m_oldy2[ch] = state[OldY2][l];
+						f->m_oldy3[ch] = state[OldY3][l];
+					}
+					else
+					{
+						f->m_biQuad.m_z1[ch] = state[Z1][l];
+						f->m_biQuad.m_z2[ch] = state[Z2][l];
+					}
+				}
+			}
+		}
+	}
+
+
+private:
+	enum MoogState { Y1, Y2, Y3, Y4, OldX, OldY1, OldY2, OldY3, StateSize };
+	enum BiQuadState { Z1, Z2 };
+	// the second stage is the sub filter of doubled filter types
+	static const int NumStages = 2;
+
+	// same as qBound( -10.0f, x, 10.0f ) but written as selects
+	static inline float clip( const float x )
+	{
+		const float t = 10.0f < x ? 10.0f : x;
+		return -10.0f < t ? t : -10.0f;
+	}
+
+	inline void processMoog( float ( * s )[Lanes], float * __restrict io )
+	{
+		float * __restrict y1 = s[Y1];
+		float * __restrict y2 = s[Y2];
+		float * __restrict y3 = s[Y3];
+		float * __restrict y4 = s[Y4];
+		float * __restrict oldx = s[OldX];
+		float * __restrict oldy1 = s[OldY1];
+		float * __restrict oldy2 = s[OldY2];
+		float * __restrict oldy3 = s[OldY3];
+		for( int l = 0; l < Lanes; ++l )
+		{
+			const float x = io[l] - m_r[l] * y4[l];
+			y1[l] = clip( ( x + oldx[l] ) * m_p[l] - m_k[l] * y1[l] );
+			y2[l] = clip( ( y1[l] + oldy1[l] ) * m_p[l] - m_k[l] * y2[l] );
+			y3[l] = clip( ( y2[l] + oldy2[l] ) * m_p[l] - m_k[l] * y3[l] );
+			y4[l] = clip( ( y3[l] + oldy3[l] ) * m_p[l] - m_k[l] * y4[l] );
+			oldx[l] = x;
+			oldy1[l] = y1[l];
+			oldy2[l] = y2[l];
+			oldy3[l] = y3[l];
+		}
+		// a separate loop, GCC doesn't vectorize the clipper otherwise
+		for( int l = 0; l < Lanes; ++l )
+		{
+			io[l] = y4[l] - y4[l] * y4[l] * y4[l] * ( 1.0f / 6.0f );
+		}
+	}
+
+	inline void processBiQuad( float ( * s )[Lanes], float * __restrict io )
+	{
+		float * __restrict z1 = s[Z1];
+		float * __restrict z2 = s[Z2];
+		for( int l = 0; l < Lanes; ++l )
+		{
+			// biquad filter in transposed form
+			const float in = io[l];
+			const float out = z1[l] + m_b0[l] * in;
+			z1[l] = m_b1[l] * in + z2[l] - m_a1[l] * out;
+			z2[l] = m_b2[l] * in - m_a2[l] * out;
+			io[l] = out;
+		}
+	}
+
+	Filter * m_filters[MaxVoices];
+	const int m_voices;
+	const bool m_moog;
+	const bool m_double;
+
+	bool m_active[MaxVoices];
+
+	// coefficients
+	float m_r[Lanes], m_p[Lanes], m_k[Lanes];
+	float m_a1[Lanes], m_a2[Lanes], m_b0[Lanes], m_b1[Lanes], m_b2[Lanes];
+
+	// per stage the MoogState or BiQuadState of every lane
+	float m_state[NumStages][StateSize][Lanes];
+	float m_savedState[NumStages][StateSize][Lanes];
+
+} ;
+
+
+#endif
@@ -44,6 +44,7 @@
 #include "MemoryManager.h"
 
 template<ch_cnt_t CHANNELS=DEFAULT_CHANNELS> class BasicFilters;
+class BasicFilterBatch;
 
 template<ch_cnt_t CHANNELS>
 class LinkwitzRiley
@@ -180,6 +181,7 @@ private:
 	float m_z1 [CHANNELS], m_z2 [CHANNELS];
 	
 	friend class BasicFilters<CHANNELS>; // needed for subfilter stuff in BasicFilters
+	friend class BasicFilterBatch;
 };
 typedef BiQuad<2> StereoBiQuad;
 
@@ -910,6 +912,8 @@ private:
 	float m_sampleRatio;
 	BasicFilters<CHANNELS> * m_subFilter;
 
+	friend class BasicFilterBatch;
+
 } ;
 
 
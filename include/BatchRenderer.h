@@ -0,0 +1,103 @@
+/*
+ * BatchRenderer.h - renders many projects with one engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <memory>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QObject>
+#include <QtCore/QTextStream>
+
+#include "Mixer.h"
+#include "OutputSettings.h"
+#include "ProjectRenderer.h"
+
+class RenderManager;
+
+
+/*! \brief Renders a list of jobs one after another with the same engine
+ *
+ *  Plugin discovery, wavetables, the sample and soundfont caches and the
+ *  remote plugin hosts are only set up once, so short projects don't pay
+ *  the startup time for each render. Each line of the job list is
+ *
+ *      project [TAB output [TAB formats]]
+ *
+ *  where formats is a comma-separated list like "wav,mp3". Without an
+ *  output, the files are put next to the project. Empty lines and lines
+ *  starting with '#' are skipped. The list is read a job at a time, so it
+ *  can be a pipe another process writes jobs to as they come in.
+ */
+class BatchRenderer : public QObject
+{
+	Q_OBJECT
+public:
+	//! \param jobFile The job list, or "-" to read it from stdin
+	BatchRenderer( const Mixer::qualitySettings & qualitySettings,
+			const OutputSettings & outputSettings,
+			ProjectRenderer::ExportFileFormats defaultFormat,
+			bool renderLoop, const QString & jobFile );
+	virtual ~BatchRenderer();
+
+	bool isReady() const
+	{
+		return m_jobFile.isOpen();
+	}
+
+	//! Start rendering; when the list ends, the application is quit with
+	//! EXIT_FAILURE if any job failed
+	void start();
+
+private slots:
+	void nextJob();
+	void jobFinished();
+
+private:
+	//! Returns false if the job couldn't be started
+	bool startJob( const QString & line );
+	void finishJob( bool successful );
+
+	const Mixer::qualitySettings m_qualitySettings;
+	const OutputSettings m_outputSettings;
+	const ProjectRenderer::ExportFileFormats m_defaultFormat;
+	const bool m_renderLoop;
+
+	QFile m_jobFile;
+	QTextStream m_jobs;
+
+	std::unique_ptr<RenderManager> m_activeJob;
+	QStringList m_activeOutputs;
+	QElapsedTimer m_jobTimer;
+
+	int m_jobCount;
+	int m_failedCount;
+
+} ;
+
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * BinaryDocument.h - compact binary encoding of XML documents
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef BINARY_DOCUMENT_H
+#define BINARY_DOCUMENT_H
+
+#include <QByteArray>
+
+#include "lmms_export.h"
+
+class QDomDocument;
+
+
+/*! \brief Encodes a DOM tree without its XML text, for the document of
+ *  .mmpb projects.
+ *
+ *  Names of elements and attributes are stored once in a table. Attribute
+ *  values which are integers or floats, as written by the models, are
+ *  stored as numbers, but only if formatting them again gives the same
+ *  text, so encoding is lossless. Runs of sibling elements without
+ *  children and with the same attributes, like the notes of a pattern or
+ *  the nodes of an automation pattern, are stored as one array per
+ *  attribute, integers as differences to the previous element.
+ */
+class LMMS_EXPORT BinaryDocument
+{
+public:
+	static QByteArray encode(const QDomDocument & document);
+	//! Replaces the contents of @p document, returns false if @p data is
+	//! not a valid encoding
+	static bool decode(const QByteArray & data, QDomDocument & document);
+} ;
+
+
+#endif
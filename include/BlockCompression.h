@@ -0,0 +1,87 @@
+/*
+ * BlockCompression.h - compression of project files in parallel blocks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+#include "lmms_export.h"
+
+
+/*! \brief Compression of .mmpz and .xptz files.
+ *
+ *  The data is split into blocks which are compressed independently, so
+ *  compressing and uncompressing use all cores and the XML can be read
+ *  while it's uncompressed, see Reader. Files written by qCompress(), as
+ *  by LMMS before, are still uncompressed.
+ */
+class LMMS_EXPORT BlockCompression
+{
+public:
+	static QByteArray compress(const QByteArray & data);
+	//! Uncompresses data written by compress() or qCompress(), returns an
+	//! empty array if it's neither
+	static QByteArray uncompress(const QByteArray & data);
+	//! Whether @p data starts like the output of compress()
+	static bool isCompressed(const QByteArray & data);
+
+	//! Reads the uncompressed data of a device holding the output of
+	//! compress(), uncompressing one block at a time
+	class LMMS_EXPORT Reader : public QIODevice
+	{
+	public:
+		//! Reads @p source from its current position on each open()
+		Reader(QIODevice * source);
+
+		bool open(OpenMode mode) override;
+		void close() override;
+		bool isSequential() const override
+		{
+			return true;
+		}
+		qint64 bytesAvailable() const override;
+		bool atEnd() const override;
+
+	protected:
+		qint64 readData(char * data, qint64 maxSize) override;
+		qint64 writeData(const char *, qint64) override
+		{
+			return -1;
+		}
+
+	private:
+		bool readBlock();
+
+		QIODevice * m_source;
+		QByteArray m_block;
+		int m_position;
+		bool m_finished;
+	} ;
+} ;
+
+
+#endif
@@ -29,10 +29,31 @@
 #include "lmms_export.h"
 #include "lmms_basics.h"
 
+class PlanarBuffer;
+
+//! Buffers preallocated for audio ports, effects and other play handles
+//! than notes, see Mixer for the ones of the notes
+const int DEFAULT_BUFFER_POOL_SIZE = 256;
+
+/**
+	Period buffers come from a pool of buffers of the same size, aligned for
+	SIMD, which is preallocated by init(). Each thread keeps a few buffers
+	of its own and exchanges them with a lock-free free list in batches.
+
+	The pool only grows outside of the audio threads. If it runs empty
+	while rendering, the buffer is allocated by the MemoryManager as an
+	overflow, and the pool grows the next time a buffer is acquired or
+	reserve() is called from another thread.
+*/
 class LMMS_EXPORT BufferManager
 {
 public:
+	//! Sets the size of the buffers and preallocates the pool, buffers
+	//! hold @p framesPerPeriod frames
 	static void init( fpp_t framesPerPeriod );
+	//! Grows the pool to hold at least @p buffers buffers, and by another
+	//! chunk if an audio thread found it running low. Not realtime safe.
+	static void reserve( int buffers );
 	static sampleFrame * acquire();
 	// audio-buffer-mgm
 	static void clear( sampleFrame * ab, const f_cnt_t frames,
@@ -42,6 +63,24 @@ public:
 						const f_cnt_t offset = 0 );
 #endif
 	static void release( sampleFrame * buf );
+
+	//! Planar buffer holding one period
+	static PlanarBuffer * acquirePlanar();
+	static void release( PlanarBuffer * buf );
+
+	//! Number of buffers in the pool
+	static int capacity();
+	//! Number of buffers currently acquired, including overflows
+	static int inUse();
+	//! Largest number of buffers that were acquired at the same time
+	static int highWaterMark();
+	//! How often the pool was found empty, audio threads allocate an
+	//! overflow then
+	static int overflows();
+
+	//! Prints the buffers that were never released and the high water mark
+	//! in debug builds, once everything holding buffers is destroyed
+	static void reportUsage();
 };
 
 #endif
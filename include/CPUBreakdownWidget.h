@@ -0,0 +1,108 @@
+/*
+ * CPUBreakdownWidget.h - widget showing where the CPU time is spent
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CPUBREAKDOWN_WIDGET_H
+#define CPUBREAKDOWN_WIDGET_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QWidget>
+
+#include "MixerProfiler.h"
+
+class QCheckBox;
+class QTreeWidget;
+class QTreeWidgetItem;
+class Effect;
+class RemotePlugin;
+
+
+class CPUBreakdownWidget : public QWidget
+{
+	Q_OBJECT
+public:
+	CPUBreakdownWidget( QWidget * _parent );
+	virtual ~CPUBreakdownWidget();
+
+
+protected:
+	void showEvent( QShowEvent * _se ) override;
+	void hideEvent( QHideEvent * _he ) override;
+
+
+protected slots:
+	void updateBreakdown();
+	void setDenormalCheckEnabled( bool enabled );
+
+
+private:
+	// add a row showing the share of @p counter since the last update
+	// with @p denormals, also show the samples in denormal range since the
+	// last update
+	QTreeWidgetItem * addItem( QTreeWidgetItem * parent, const QString & name,
+				const MixerProfiler::TimeCounter & counter,
+				const MixerProfiler::DenormalCounter * denormals = nullptr );
+	QTreeWidgetItem * addItem( QTreeWidgetItem * parent, const QString & name,
+				int load );
+	void addEffectItem( QTreeWidgetItem * parent, const Effect * effect );
+	// rows telling how a plugin running in its own process is doing
+	void addRemoteItem( QTreeWidgetItem * parent, const RemotePlugin * plugin );
+	// the memory of each subsystem, with the tracks and FX channels
+	// holding it
+	void updateMemory();
+
+	void rememberExpanded( const QTreeWidgetItem * item );
+	void restoreExpanded( QTreeWidgetItem * item );
+
+	QTreeWidget * m_tree;
+	QCheckBox * m_denormalCheck;
+	QTreeWidgetItem * m_stagesItem;
+	QTreeWidgetItem * m_tracksItem;
+	QTreeWidgetItem * m_fxChannelsItem;
+	QTreeWidgetItem * m_notePoolItem;
+	QTreeWidgetItem * m_bufferPoolItem;
+	QTreeWidgetItem * m_locklessItem;
+	QTreeWidgetItem * m_lockedMemoryItem;
+	QTreeWidgetItem * m_sampleMemoryItem;
+	QTreeWidgetItem * m_memoryItem;
+
+	// totals of the counters at the last update
+	QHash<const MixerProfiler::TimeCounter *, quint64> m_lastTotals;
+	QHash<const MixerProfiler::TimeCounter *, quint64> m_totals;
+	QHash<const MixerProfiler::DenormalCounter *, quint64> m_lastDenormals;
+	QHash<const MixerProfiler::DenormalCounter *, quint64> m_denormals;
+	// counters of the items which were expanded
+	QSet<quintptr> m_expanded;
+	QElapsedTimer m_elapsed;
+	qint64 m_elapsedNs;
+
+	QTimer m_updateTimer;
+
+} ;
+
+
+#endif
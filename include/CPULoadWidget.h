@@ -33,6 +33,7 @@
 
 #include "lmms_basics.h"
 
+class CPUBreakdownWidget;
 
 class CPULoadWidget : public QWidget
 {
@@ -44,6 +45,7 @@ public:
 
 protected:
 	void paintEvent( QPaintEvent * _ev ) override;
+	void mousePressEvent( QMouseEvent * _me ) override;
 
 
 protected slots:
@@ -61,6 +63,8 @@ private:
 
 	QTimer m_updateTimer;
 
+	CPUBreakdownWidget * m_breakdown;
+
 } ;
 
 
@@ -0,0 +1,185 @@
+/*
+ * CompressedFrames.h - losslessly compressed sample frames
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef COMPRESSED_FRAMES_H
+#define COMPRESSED_FRAMES_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "lmms_basics.h"
+
+
+/*! \brief The frames of a sample, compressed losslessly in small blocks
+ *  which can be decompressed independently.
+ *
+ *  Only a few blocks are kept decompressed at a time: the ones notes start
+ *  with, see setHead(), and the ones which have been read last. A loader
+ *  thread shared by all instances decompresses the blocks which are read
+ *  next, most of them ahead of reading them, so reading needn't wait for
+ *  them. Frames which aren't decompressed (yet) are read as silence,
+ *  unless the reader waits for them, e.g. when rendering offline.
+ *
+ *  Each block is stored as the differences of the bit patterns of
+ *  successive samples of a channel, split into byte planes and deflated.
+ */
+class CompressedFrames
+{
+public:
+	//! The frames of one block, and how many blocks are kept decompressed
+	static const f_cnt_t BlockFrames = 4096;
+	static const int CacheBlocks = 12;
+
+	//! The memory used by the compressed frames of all buffers
+	struct Usage
+	{
+		// what the frames would take uncompressed
+		qint64 frameBytes;
+		qint64 compressedBytes;
+		// the decompressed blocks
+		qint64 cacheBytes;
+		int samples;
+	} ;
+
+	//! Compresses @p frames frames of @p data, or returns nullptr if that
+	//! wouldn't save memory. The blocks from @p head on are decompressed
+	//! right away.
+	static CompressedFrames * compress(const sampleFrame * data,
+		f_cnt_t frames, f_cnt_t head);
+	//! Another instance sharing the compressed blocks, with a cache of its
+	//! own
+	CompressedFrames * clone() const;
+	~CompressedFrames();
+
+	f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+	//! Copies the frames [first, first + count) to @p dst. Frames outside
+	//! of the sample or not decompressed are silent, in the latter case
+	//! false is returned and they are decompressed for the next read.
+	//! Doesn't block, so it can be called from the audio thread, unless
+	//! @p wait is set (e.g. when rendering offline), which decompresses
+	//! missing blocks right away.
+	bool read(f_cnt_t first, f_cnt_t count, sampleFrame * dst, bool wait = false);
+
+	//! Decompresses the frames [first, first + count) to @p dst, e.g. for
+	//! drawing or saving them. Slower than read() and doesn't use the cache.
+	void decode(f_cnt_t first, f_cnt_t count, sampleFrame * dst) const;
+
+	//! Keeps the blocks from @p frame on decompressed, so notes starting
+	//! there don't have to wait for them
+	void setHead(f_cnt_t frame)
+	{
+		m_head.store(frame, std::memory_order_relaxed);
+	}
+
+	//! Decompresses the blocks from @p frame on before they are read
+	void prefetch(f_cnt_t frame);
+
+	static Usage usage();
+	//! The memory used by this instance: its share of the compressed
+	//! blocks and its decompressed ones
+	qint64 memoryUsage() const;
+
+
+private:
+	struct Blocks
+	{
+		Blocks(f_cnt_t frames);
+		~Blocks();
+
+		std::vector<QByteArray> data;
+		f_cnt_t frames;
+		qint64 bytes;
+	} ;
+
+	struct Slot
+	{
+		// the block the data belongs to, or -1 while the data is being
+		// replaced
+		std::atomic<f_cnt_t> index;
+		// when the block was read last
+		std::atomic<unsigned int> lastUse;
+		std::unique_ptr<sampleFrame[]> data;
+	} ;
+
+	// requests of blocks to decompress, by the block index modulo its size
+	static const int NumRequests = 8;
+	static const int HeadBlocks = 2;
+
+	CompressedFrames(const std::shared_ptr<const Blocks> & blocks, f_cnt_t head);
+
+	static QByteArray compressBlock(const sampleFrame * data, f_cnt_t frames);
+	static void decompressBlock(const QByteArray & block, f_cnt_t frames,
+		sampleFrame * dst);
+
+	f_cnt_t numBlocks() const
+	{
+		return static_cast<f_cnt_t>(m_blocks->data.size());
+	}
+
+	void request(f_cnt_t index)
+	{
+		m_requests[index % NumRequests].store(index, std::memory_order_relaxed);
+	}
+
+	bool isCached(f_cnt_t index) const;
+	//! Copies @p count frames from @p inBlock on of block @p index to
+	//! @p dst if it's decompressed
+	bool readCached(f_cnt_t index, f_cnt_t inBlock, f_cnt_t count,
+		sampleFrame * dst, unsigned int now);
+	//! Decompresses block @p index into the slot read longest ago, other
+	//! than the ones of the blocks from @p head on. Needs m_mutex.
+	bool load(f_cnt_t index, f_cnt_t head);
+	//! Decompresses the blocks notes start with and the requested ones,
+	//! called by the loader, returns whether there were any
+	bool fill();
+	void loadSlot(Slot & slot, f_cnt_t index);
+
+	std::shared_ptr<const Blocks> m_blocks;
+	f_cnt_t m_frames;
+	std::unique_ptr<Slot[]> m_slots;
+	std::atomic<f_cnt_t> m_requests[NumRequests];
+	std::atomic<f_cnt_t> m_head;
+	std::atomic<unsigned int> m_clock;
+	// locked by the loader while it works on the instance
+	QMutex m_mutex;
+
+	static std::atomic<qint64> s_frameBytes;
+	static std::atomic<qint64> s_compressedBytes;
+	static std::atomic<qint64> s_cacheBytes;
+	static std::atomic<int> s_samples;
+
+	friend class CompressedFramesLoader;
+
+} ;
+
+
+#endif
@@ -36,6 +36,7 @@
 class ControllerDialog;
 class Controller;
 class ControllerConnection;
+class ControllerGraph;
 
 typedef QVector<Controller *> ControllerVector;
 
@@ -114,10 +115,8 @@ public:
 		return qBound<float>( 0.0f, _val, 1.0f );
 	}
 
-	static long runningPeriods()
-	{
-		return s_periods;
-	}
+	//! Periods the current EngineContext rendered
+	static long runningPeriods();
 	static unsigned int runningFrames();
 	static float runningTime();
 
@@ -160,9 +159,9 @@ protected:
 	QString m_name;
 	ControllerTypes m_type;
 
-	static ControllerVector s_controllers;
-
-	static long s_periods;
+	// the controllers of the context this one was created in, if it's
+	// listed there
+	ControllerGraph * m_graph;
 
 
 signals:
@@ -170,6 +169,7 @@ signals:
 	void valueChanged();
 
 	friend class ControllerDialog;
+	friend class ControllerGraph;
 
 } ;
 
@@ -0,0 +1,123 @@
+/*
+ * ControllerGraph.h - evaluates all controllers once per period
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CONTROLLER_GRAPH_H
+#define CONTROLLER_GRAPH_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QVector>
+
+class Controller;
+
+
+/*! \brief The controllers of an EngineContext, and updates their value
+ *  buffers in dependency order
+ *
+ *  A controller depends on the controllers connected to its own models,
+ *  e.g. an LFO whose amount is modulated by another LFO. The graph sorts
+ *  the controllers into levels, each level only depending on the ones
+ *  before, and update() calculates the buffers level by level before the
+ *  play handles are rendered. Worker threads then only read buffers which
+ *  are up to date, instead of calculating them on first use.
+ *
+ *  Controllers of one level are independent, so large levels are spread
+ *  over the worker threads.
+ *
+ *  It also counts the periods and frames the context rendered, which the
+ *  controllers follow.
+ */
+class ControllerGraph
+{
+public:
+	ControllerGraph();
+	~ControllerGraph();
+
+	//! Marks the graph as outdated; called when controllers or connections
+	//! are added or removed
+	void invalidate()
+	{
+		++m_revision;
+	}
+
+	//! Calculates the buffers of all controllers for the current period,
+	//! must be called on the mixer thread
+	void update();
+
+	//! The controllers besides dummy and MIDI controllers
+	const QVector<Controller *> & controllers() const
+	{
+		return m_controllers;
+	}
+
+	void addController( Controller * controller );
+	void removeController( Controller * controller );
+
+	long periods() const
+	{
+		return m_periods;
+	}
+
+	unsigned int frames() const
+	{
+		return m_frames;
+	}
+
+	//! Counts a period of @p frames frames
+	void advance( int frames )
+	{
+		++m_periods;
+		m_frames += frames;
+	}
+
+	void resetCounters()
+	{
+		m_periods = 0;
+		m_frames = 0;
+	}
+
+private:
+	class Job;
+
+	void build();
+
+	// levels with fewer controllers are updated on the mixer thread
+	static const size_t ParallelLevelSize = 8;
+
+	QVector<Controller *> m_controllers;
+	long m_periods;
+	// frames rendered, counted per period as the period may change
+	unsigned int m_frames;
+
+	std::atomic<unsigned> m_revision;
+	unsigned m_builtRevision;
+	std::vector<std::vector<std::unique_ptr<Job>>> m_levels;
+
+} ;
+
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * ConvolutionEngine.h - convolution with long impulse responses
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CONVOLUTION_ENGINE_H
+#define CONVOLUTION_ENGINE_H
+
+#include <QtCore/QSemaphore>
+
+#include <atomic>
+#include <vector>
+
+#include "FftConvolver.h"
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+class QThread;
+
+/*! \brief Convolves stereo audio with an impulse response of any length,
+ *  without latency
+ *
+ *  The impulse response is split into partitions of two sizes. The first
+ *  2 * TailBlockSize frames use short partitions of HeadBlockSize frames,
+ *  which are convolved on the calling thread as the audio comes in. The
+ *  rest uses long partitions of TailBlockSize frames, which are much
+ *  cheaper per frame but need a whole long block of input first. They are
+ *  convolved on a background thread while the next long block is coming
+ *  in, and their output is due exactly when that block is complete, as the
+ *  short partitions cover the time in between.
+ *
+ *  process() only waits for the background thread if it falls behind by a
+ *  whole long block, e.g. while rendering faster than realtime.
+ */
+class LMMS_EXPORT ConvolutionEngine
+{
+public:
+	static const fpp_t HeadBlockSize = 128;
+	static const fpp_t TailBlockSize = 4096;
+
+	//! Partitions @p frames frames of @p ir, starts the background thread
+	//! if the response is long enough to need it
+	ConvolutionEngine(const sampleFrame * ir, f_cnt_t frames);
+	~ConvolutionEngine();
+
+	//! Writes @p frames frames of @p in convolved to @p out, realtime safe
+	void process(const sampleFrame * in, sampleFrame * out, fpp_t frames);
+
+	//! Forgets the input, e.g. when the effect goes to sleep
+	void reset();
+
+	f_cnt_t length() const
+	{
+		return m_length;
+	}
+
+	//! The memory used by the partitions and buffers of both channels
+	qint64 memoryUsage() const;
+
+private:
+	class TailThread;
+
+	struct Channel
+	{
+		FftConvolver head;
+		// the partitions from TailBlockSize up to 2 * TailBlockSize, still
+		// short ones, but worked off one short block at a time
+		FftConvolver tail0;
+		std::vector<float> tail0Output;
+		std::vector<float> tail0Precalculated;
+		// everything from 2 * TailBlockSize on, on the background thread
+		FftConvolver tail;
+		std::vector<float> tailOutput;
+		std::vector<float> tailPrecalculated;
+		std::vector<float> tailInput;
+		std::vector<float> backgroundInput;
+	} ;
+
+	void processTail();
+	void startTail();
+	void waitForTail();
+
+	f_cnt_t m_length;
+	Channel m_channels[DEFAULT_CHANNELS];
+	bool m_hasTail0;
+	bool m_hasTail;
+	// frames of the current long block, which is where the precalculated
+	// tail output is read as well
+	fpp_t m_tailInputFill;
+
+	TailThread * m_thread;
+	QSemaphore m_tailStart;
+	QSemaphore m_tailDone;
+	bool m_tailRunning;
+	std::atomic<bool> m_quit;
+} ;
+
+
+#endif
@@ -28,12 +28,16 @@
 #define DATA_FILE_H
 
 #include <map>
+#include <memory>
+#include <vector>
 #include <QDomDocument>
+#include <QStringList>
 
 #include "lmms_export.h"
 #include "MemoryManager.h"
 #include "ProjectVersion.h"
 
+class QFile;
 class QTextStream;
 
 class LMMS_EXPORT DataFile : public QDomDocument
@@ -61,6 +65,8 @@ public:
 	DataFile( const QString& fileName );
 	DataFile( const QByteArray& data );
 	DataFile( Type type );
+	DataFile( const DataFile& other );
+	DataFile& operator=( const DataFile& other ) = default;
 
 	virtual ~DataFile();
 
@@ -76,6 +82,32 @@ public:
 	bool writeFile(const QString& fn, bool withResources = false);
 	bool copyResources(const QString& resourcesDir); //!< Copies resources to the resourcesDir and changes the DataFile to use local paths to them
 	bool hasLocalPlugins(QDomElement parent = QDomElement(), bool firstCall = true) const;
+	//! The files referenced by the elements named @p tagName, as stored
+	QStringList resourceFiles(const QString& tagName) const;
+
+	//! Whether binary data, like embedded samples, is stored next to the
+	//! XML instead of inside it, as in projects saved as .mmpb
+	bool storesBinary() const
+	{
+		return m_storesBinary;
+	}
+
+	void setStoresBinary(bool on)
+	{
+		m_storesBinary = on;
+	}
+
+	//! Stores @p data to be written next to the XML, returns its ID
+	int addBinary(const QByteArray& data);
+	//! The data with the given ID or an empty array. Data loaded from a
+	//! file refers to the mapped file, so it's only valid while this
+	//! DataFile exists.
+	QByteArray binary(int id) const;
+
+	//! The DataFile @p node belongs to, if it's still there
+	static DataFile* owner(const QDomNode& node);
+	//! Whether @p fileName is written with the binary data next to the XML
+	static bool isBinaryProject(const QString& fileName);
 
 	QDomElement& content()
 	{
@@ -95,6 +127,11 @@ public:
 	unsigned int legacyFileVersion();
 
 private:
+	friend class ProjectStream;
+
+	//! Takes over @p document, as read from @p sourceFile by ProjectStream
+	DataFile( const QDomDocument& document, const QString& sourceFile );
+
 	static Type type( const QString& typeName );
 	static QString typeName( Type type );
 
@@ -134,6 +171,11 @@ private:
 	void upgrade();
 
 	void loadData( const QByteArray & _data, const QString & _sourceFile );
+	//! Sets up the DataFile once its document is loaded
+	void loadDocument( const QString & sourceFile );
+	bool writeBinaryProject(QFile& outfile, const QByteArray& document) const;
+	//! Reads a .mmpb, returns false if @p file isn't one
+	bool loadBinaryProject(const std::shared_ptr<QFile>& file);
 
 
 	struct LMMS_EXPORT typeDescStruct
@@ -149,6 +191,11 @@ private:
 	Type m_type;
 	unsigned int m_fileVersion;
 
+	bool m_storesBinary;
+	std::vector<QByteArray> m_binary;
+	// the .mmpb the binary data is mapped from
+	std::shared_ptr<QFile> m_binaryFile;
+
 } ;
 
 
@@ -0,0 +1,145 @@
+/*
+ * DelayLine.h - stereo delay line with fractional delays
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef DELAY_LINE_H
+#define DELAY_LINE_H
+
+#include <QtCore/QtGlobal>
+
+#include "DelayLinePool.h"
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+/*! \brief A stereo delay line, read with linear interpolation
+ *
+ *  The memory comes from the DelayLinePool. The line is empty until
+ *  reserve(), which the effect calls with its longest delay of a period
+ *  before using it, so it only grows to what the delay is actually set to.
+ *
+ *  A delay of d frames reads what was written d frames before the frame
+ *  written next, so the shortest delay is one frame. Delays are clamped to
+ *  what the line holds.
+ *
+ *  readBlock() reads a whole period at once, which can only be done if no
+ *  delay of the period reaches a frame written in the same period, e.g.
+ *  with feedback. The loops of a block are vectorized by the compiler.
+ */
+class LMMS_EXPORT DelayLine
+{
+public:
+	DelayLine();
+	~DelayLine();
+
+	//! Makes room for delays of up to @p frames frames, keeping the audio.
+	//! Only allocates if the line has to grow.
+	void reserve(float frames);
+
+	//! Forgets the audio and gives the memory back, e.g. when the sample
+	//! rate changes
+	void clear();
+
+	//! The effect went to sleep. If it sleeps long enough, the pool takes
+	//! the memory back.
+	void sleep();
+
+	//! Has to be called before the line is used again after sleep(). The
+	//! audio is kept unless the memory was taken back meanwhile.
+	void wake();
+
+	f_cnt_t capacity() const
+	{
+		return m_buffer.frames;
+	}
+
+	//! Reads both channels at @p delay frames
+	inline void read(float delay, sampleFrame & out) const
+	{
+		f_cnt_t newer;
+		f_cnt_t older;
+		float fraction;
+		locate(m_position, delay, newer, older, fraction);
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			const sample_t a = m_buffer.data[newer][ch];
+			out[ch] = a + fraction * (m_buffer.data[older][ch] - a);
+		}
+	}
+
+	//! Reads each channel at its own delay
+	inline void read(float delayLeft, float delayRight, sampleFrame & out) const
+	{
+		out[0] = tap(m_position, delayLeft, 0);
+		out[1] = tap(m_position, delayRight, 1);
+	}
+
+	inline void write(const sampleFrame & in)
+	{
+		m_buffer.data[m_position] = in;
+		if (++m_position == m_buffer.frames)
+		{
+			m_position = 0;
+		}
+	}
+
+	//! Reads @p frames frames, the f-th one at the delays @p delayLeft[f]
+	//! and @p delayRight[f] before the f-th frame of the next write. No
+	//! delay may be shorter than f + 1 frames.
+	void readBlock(const float * delayLeft, const float * delayRight,
+		sampleFrame * out, fpp_t frames) const;
+
+	void writeBlock(const sampleFrame * in, fpp_t frames);
+
+private:
+	// the frames around @p delay frames before @p position
+	inline void locate(f_cnt_t position, float delay,
+		f_cnt_t & newer, f_cnt_t & older, float & fraction) const
+	{
+		const f_cnt_t frames = m_buffer.frames;
+		delay = qBound(1.0f, delay, static_cast<float>(frames - 1));
+		const f_cnt_t whole = static_cast<f_cnt_t>(delay);
+		fraction = delay - whole;
+		newer = position - whole;
+		newer += newer < 0 ? frames : 0;
+		newer -= newer >= frames ? frames : 0;
+		older = newer > 0 ? newer - 1 : frames - 1;
+	}
+
+	inline sample_t tap(f_cnt_t position, float delay, ch_cnt_t ch) const
+	{
+		f_cnt_t newer;
+		f_cnt_t older;
+		float fraction;
+		locate(position, delay, newer, older, fraction);
+		const sample_t a = m_buffer.data[newer][ch];
+		return a + fraction * (m_buffer.data[older][ch] - a);
+	}
+
+	DelayLinePool::Buffer m_buffer;
+	// where the next frame is written
+	f_cnt_t m_position;
+} ;
+
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * DelayLinePool.h - memory shared by the delay lines of all effects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef DELAY_LINE_POOL_H
+#define DELAY_LINE_POOL_H
+
+#include <atomic>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+/*! \brief Hands out the memory of delay lines and takes it back from lines
+ *  of effects which sleep
+ *
+ *  Lines grow in whole chunks as their delay grows, rather than being
+ *  sized for the longest delay possible. Memory given back is kept for
+ *  reuse up to MaxSpareFrames, so a line growing on the audio thread
+ *  usually doesn't have to go to the memory manager.
+ *
+ *  A line whose effect goes to sleep is parked. Once it has been parked
+ *  for ReleaseSeconds, collect() takes its memory back, and the line
+ *  starts from silence when its effect wakes up.
+ */
+class LMMS_EXPORT DelayLinePool
+{
+public:
+	static const f_cnt_t ChunkFrames = 4096;
+	static const int ReleaseSeconds = 10;
+	static const f_cnt_t MaxSpareFrames = 1 << 20;
+
+	//! The memory of one line. Only the line uses it, except while it is
+	//! parked, when the pool may take it back.
+	struct Buffer
+	{
+		Buffer() :
+			data(nullptr),
+			frames(0),
+			idleFrames(0),
+			parked(false),
+			prev(nullptr),
+			next(nullptr)
+		{
+		}
+
+		sampleFrame * data;
+		f_cnt_t frames;
+
+		f_cnt_t idleFrames;
+		bool parked;
+		Buffer * prev;
+		Buffer * next;
+	} ;
+
+	//! Zeroed memory of at least @p frames frames, which is set to the
+	//! frames handed out, a whole number of chunks
+	static sampleFrame * allocate(f_cnt_t & frames);
+
+	//! Gives back memory from allocate()
+	static void release(sampleFrame * data, f_cnt_t frames);
+
+	//! Unparks @p buffer and gives its memory back, leaving it empty
+	static void release(Buffer & buffer);
+
+	//! The effect of @p buffer went to sleep, does nothing if it's parked
+	//! already
+	static void park(Buffer & buffer);
+
+	//! The effect of @p buffer woke up. Returns false if its memory was
+	//! taken back meanwhile, which leaves it empty.
+	static bool unpark(Buffer & buffer);
+
+	//! Takes back the memory of lines parked for long enough. Called by
+	//! the mixer once per period, while no effect is processed.
+	static void collect(fpp_t frames, sample_rate_t sampleRate);
+
+	//! The frames kept for reuse
+	static f_cnt_t spareFrames();
+
+private:
+	// put at the start of a spare block of memory
+	struct Spare
+	{
+		Spare * next;
+		f_cnt_t frames;
+	} ;
+
+	class Lock;
+
+	// both expect the lock to be held
+	static void keepSpare(sampleFrame * data, f_cnt_t frames);
+	static void unlink(Buffer & buffer);
+
+	static std::atomic_flag s_lock;
+	static Spare * s_spares;
+	static f_cnt_t s_spareFrames;
+	static Buffer * s_parked;
+
+} ;
+
+
+#endif
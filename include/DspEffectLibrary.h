@@ -40,11 +40,14 @@ namespace DspEffectLibrary
 	public:
 		typedef class MonoBypass bypassType;
 
-		static void process( sample_t * * _buf, const f_cnt_t _frames )
+		//! Processes the first channel of a block, a loop the compiler
+		//! can vectorize for effects without state between samples
+		void process( sampleFrame * _buf, const f_cnt_t _frames )
 		{
+			T * fx = static_cast<T *>( this );
 			for( f_cnt_t f = 0; f < _frames; ++f )
 			{
-				_buf[f][0] = T::nextSample( _buf[f][0] );
+				_buf[f][0] = fx->nextSample( _buf[f][0] );
 			}
 		}
 	} ;
@@ -55,11 +58,12 @@ namespace DspEffectLibrary
 	public:
 		typedef class StereoBypass bypassType;
 
-		static void process( sample_t * * _buf, const f_cnt_t _frames )
+		void process( sampleFrame * _buf, const f_cnt_t _frames )
 		{
+			T * fx = static_cast<T *>( this );
 			for( f_cnt_t f = 0; f < _frames; ++f )
 			{
-				T::nextSample( _buf[f][0], _buf[f][1] );
+				fx->nextSample( _buf[f][0], _buf[f][1] );
 			}
 		}
 	} ;
@@ -301,14 +305,17 @@ namespace DspEffectLibrary
 	class StereoEnhancer : public StereoBase<StereoEnhancer>
 	{
 	public:
-		StereoEnhancer( float wideCoeff ) :
-			m_wideCoeff( wideCoeff )
+		StereoEnhancer( float wideCoeff )
 		{
+			setWideCoeff( wideCoeff );
 		}
 
 		void setWideCoeff( float wideCoeff )
 		{
+			const float toRad = F_PI / 180;
 			m_wideCoeff = wideCoeff;
+			// only changes with the coefficient, not per sample
+			m_crossGain = sinf( m_wideCoeff * ( .5 * toRad ) );
 		}
 
 		float wideCoeff()
@@ -318,14 +325,14 @@ namespace DspEffectLibrary
 
 		void nextSample( sample_t& inLeft, sample_t& inRight )
 		{
-			const float toRad = F_PI / 180;
 			const sample_t tmp = inLeft;
-			inLeft += inRight * sinf( m_wideCoeff * ( .5 * toRad ) );
-			inRight -= tmp * sinf( m_wideCoeff * ( .5 * toRad ) );
+			inLeft += inRight * m_crossGain;
+			inRight -= tmp * m_crossGain;
 		}
 
 	private:
 		float m_wideCoeff;
+		float m_crossGain;
 
 	} ;
 
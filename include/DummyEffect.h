@@ -105,6 +105,11 @@ public:
 		return false;
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
 	const QDomElement& originalPluginData() const
 	{
 		return m_originalPluginData;
@@ -66,6 +66,11 @@ public:
 		return "dummyinstrument";
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
 	PluginView * instantiateView( QWidget * _parent ) override
 	{
 		return new InstrumentViewFixedSize( this, _parent );
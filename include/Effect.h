@@ -35,6 +35,8 @@
 
 class EffectChain;
 class EffectControls;
+class Oversampler;
+class PlanarBuffer;
 
 
 class LMMS_EXPORT Effect : public Plugin
@@ -59,6 +61,41 @@ public:
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 						const fpp_t _frames ) = 0;
 
+	//! Effects working on separate channels return true here and implement
+	//! processPlanarBuffer(), which is then called instead of
+	//! processAudioBuffer(). Consecutive planar effects of a chain share one
+	//! planar buffer, so the signal is only converted at layout changes.
+	virtual bool prefersPlanar() const
+	{
+		return false;
+	}
+
+	virtual bool processPlanarBuffer( PlanarBuffer & /*_buf*/,
+						const fpp_t /*_frames*/ )
+	{
+		return false;
+	}
+
+	//! The frames the output lags behind the input, e.g. due to lookahead.
+	//! Only counted while the effect is enabled; called by the mixer thread.
+	virtual f_cnt_t latency() const
+	{
+		return 0;
+	}
+
+	//! Returned by tailLength() if the tail isn't known
+	static const f_cnt_t UnknownTail = -1;
+
+	//! The frames the output keeps sounding after the input fell silent,
+	//! not counting latency(), e.g. the decay of the echoes of a delay.
+	//! Effects reporting it are stopped by the chain once their input has
+	//! been silent that long, instead of measuring their output against
+	//! the gate. Called by the mixer thread.
+	virtual f_cnt_t tailLength() const
+	{
+		return UnknownTail;
+	}
+
 	inline ch_cnt_t processorCount() const
 	{
 		return m_processors;
@@ -155,6 +192,18 @@ public:
 
 	virtual EffectControls * controls() = 0;
 
+	//! Time spent processing this effect
+	const MixerProfiler::TimeCounter & processingTime() const
+	{
+		return m_processingTime;
+	}
+
+	//! Samples in denormal range in the output of this effect
+	const MixerProfiler::DenormalCounter & denormals() const
+	{
+		return m_denormals;
+	}
+
 	static Effect * instantiate( const QString & _plugin_name,
 				Model * _parent,
 				Descriptor::SubPluginFeatures::Key * _key );
@@ -170,6 +219,14 @@ protected:
 	*/
 	void checkGate( double _out_sum );
 
+	//! Same as above, computing the mean square of the output itself
+	void checkGate( const sampleFrame * _buf, const fpp_t _frames );
+
+	//! The tail of echoes repeating every _period frames, each _feedback
+	//! times the one before, until they fall below -60 dBFS, or
+	//! UnknownTail if they hardly decay
+	static f_cnt_t feedbackTail( float _period, float _feedback );
+
 	PluginView * instantiateView( QWidget * ) override;
 
 	// some effects might not be capable of higher sample-rates so they can
@@ -195,6 +252,31 @@ protected:
 	}
 	void reinitSRC();
 
+	//! The factor to oversample by to run at _rate times the output sample
+	//! rate, as the mixer may already process at a multiple of it due to
+	//! its quality settings
+	int oversamplingFactor( int _rate ) const
+	{
+		return qMax( 1, _rate / Engine::mixer()->
+				currentQualitySettings().sampleRateMultiplier() );
+	}
+
+	//! Prepares an oversampler to run at _rate times the output sample
+	//! rate. It is rebuilt whenever the quality settings change, which
+	//! happens while the mixer is stopped, so the audio thread never
+	//! allocates it.
+	void setOversamplingRate( int _rate );
+
+	//! The oversampler prepared by setOversamplingRate(), or NULL
+	Oversampler * oversampler() const
+	{
+		return m_oversampler;
+	}
+
+
+private slots:
+	void updateOversampler();
+
 
 private:
 	EffectChain * m_parent;
@@ -209,6 +291,8 @@ private:
 	bool m_noRun;
 	bool m_running;
 	f_cnt_t m_bufferCount;
+	// frames the input has been silent for, while the tail is known
+	f_cnt_t m_silentFrames;
 
 	BoolModel m_enabledModel;
 	FloatModel m_wetDryModel;
@@ -220,6 +304,12 @@ private:
 	SRC_DATA m_srcData[2];
 	SRC_STATE * m_srcState[2];
 
+	int m_oversamplingRate;
+	Oversampler * m_oversampler;
+
+	MixerProfiler::TimeCounter m_processingTime;
+	MixerProfiler::DenormalCounter m_denormals;
+
 
 	friend class EffectView;
 	friend class EffectChain;
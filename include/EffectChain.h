@@ -29,14 +29,18 @@
 #include "Model.h"
 #include "SerializingObject.h"
 #include "AutomatableModel.h"
+#include "MixHelpers.h"
 
 class Effect;
+class PlanarBuffer;
 
 
 class LMMS_EXPORT EffectChain : public Model, public SerializingObject
 {
 	Q_OBJECT
 public:
+	typedef QVector<Effect *> EffectList;
+
 	EffectChain( Model * _parent );
 	virtual ~EffectChain();
 
@@ -52,16 +56,35 @@ public:
 	void removeEffect( Effect * _effect );
 	void moveDown( Effect * _effect );
 	void moveUp( Effect * _effect );
-	bool processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, bool hasInputNoise );
+	//! If analysis is given, it's set to the analysis of the output
+	bool processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, bool hasInputNoise,
+				MixHelpers::BufferAnalysis * analysis = nullptr );
 	void startRunning();
 
+	//! The sum of the latencies of the enabled effects
+	f_cnt_t latency() const;
+
+	//! Whether an effect drives a peak controller, so the chain has to
+	//! run even if its output isn't heard
+	bool drivesControllers() const;
+
 	void clear();
 
+	//! The effects in the order they're processed
+	const EffectList & effects() const
+	{
+		return m_effects;
+	}
+
 
 private:
-	typedef QVector<Effect *> EffectList;
+	void updatePlanarBuffer();
+
 	EffectList m_effects;
 
+	// shared by the planar effects, only allocated if there are any
+	PlanarBuffer * m_planarBuffer;
+
 	BoolModel m_enabledModel;
 
 
@@ -33,8 +33,10 @@
 #include "lmmsconfig.h"
 #include "lmms_export.h"
 #include "lmms_basics.h"
+#include "EngineContext.h"
 
 class BBTrackContainer;
+class ControllerGraph;
 class FxMixer;
 class ProjectJournal;
 class Mixer;
@@ -58,33 +60,44 @@ class LMMS_EXPORT LmmsCore : public QObject
 {
 	Q_OBJECT
 public:
+	//! Sets up what all sessions share and creates the main EngineContext
 	static void init( bool renderOnly );
 	static void destroy();
 
-	// core
+	// core, of the EngineContext current on the calling thread
+	static EngineContext * context()
+	{
+		return EngineContext::current();
+	}
+
 	static Mixer *mixer()
 	{
-		return s_mixer;
+		return context()->mixer();
 	}
 
 	static FxMixer * fxMixer()
 	{
-		return s_fxMixer;
+		return context()->fxMixer();
 	}
 
 	static Song * getSong()
 	{
-		return s_song;
+		return context()->song();
 	}
 
 	static BBTrackContainer * getBBTrackContainer()
 	{
-		return s_bbTrackContainer;
+		return context()->bbTrackContainer();
 	}
 
 	static ProjectJournal * projectJournal()
 	{
-		return s_projectJournal;
+		return context()->projectJournal();
+	}
+
+	static ControllerGraph * controllerGraph()
+	{
+		return context()->controllerGraph();
 	}
 
 	static bool ignorePluginBlacklist();
@@ -96,14 +109,13 @@ public:
 	}
 #endif
 
-	static Ladspa2LMMS * getLADSPAManager()
-	{
-		return s_ladspaManager;
-	}
+	//! Scans for LADSPA plugins on first use, so renders of projects
+	//! without LADSPA effects never do
+	static Ladspa2LMMS * getLADSPAManager();
 
 	static float framesPerTick()
 	{
-		return s_framesPerTick;
+		return context()->framesPerTick();
 	}
 
 	static float framesPerTick(sample_rate_t sample_rate);
@@ -137,14 +149,7 @@ private:
 		delete tmp;
 	}
 
-	static float s_framesPerTick;
-
-	// core
-	static Mixer *s_mixer;
-	static FxMixer * s_fxMixer;
-	static Song * s_song;
-	static BBTrackContainer * s_bbTrackContainer;
-	static ProjectJournal * s_projectJournal;
+	static EngineContext * s_mainContext;
 
 #ifdef LMMS_HAVE_LV2
 	static class Lv2Manager* s_lv2Manager;
@@ -0,0 +1,182 @@
+/*
+ * EngineContext.h - the objects of one session of the engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef ENGINE_CONTEXT_H
+#define ENGINE_CONTEXT_H
+
+#include <atomic>
+#include <memory>
+
+#include "lmms_export.h"
+
+class BBTrackContainer;
+class ControllerGraph;
+class FxMixer;
+class LfoInstances;
+class Mixer;
+class ProjectJournal;
+class Song;
+
+
+/*! \brief The mixer, song, FX mixer, beat/bassline container and undo
+ *  history of one session, with the state which belongs to its timeline.
+ *
+ *  Engine::init() creates the main context, which the GUI works on. A
+ *  render job can create more contexts in the same process, each with a
+ *  render-only mixer, to render projects independently of the main one.
+ *  The Engine accessors, e.g. Engine::getSong(), return the objects of the
+ *  context current on the calling thread, which is the main context unless
+ *  a Scope selects another one. The mixer makes its context current on the
+ *  threads rendering for it.
+ *
+ *  What doesn't change with the project is shared by all contexts: the
+ *  wavetables, the sample cache, the plugin descriptors, loaded
+ *  soundfonts and the pools of note play handles, buffers and locked
+ *  memory. The worker threads only run the jobs of the main context, the
+ *  mixers of the others run their jobs on the thread rendering them. So
+ *  rendering a context never waits for another one, and the audio thread
+ *  of the main context never waits for an offline render.
+ *
+ *  The objects of a context have to be created and destroyed while it is
+ *  current. Contexts besides the main one should be render-only, they get
+ *  their devices when created and the main one has to outlive them.
+ */
+class LMMS_EXPORT EngineContext
+{
+public:
+	//! Creates the objects of a session, with the context current while
+	//! doing so
+	explicit EngineContext(bool renderOnly);
+	//! Stops the mixer and destroys the objects of the session
+	~EngineContext();
+
+	EngineContext(const EngineContext &) = delete;
+	EngineContext & operator=(const EngineContext &) = delete;
+
+	//! Makes @p context current on the calling thread while it exists
+	class LMMS_EXPORT Scope
+	{
+	public:
+		explicit Scope(EngineContext * context);
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope & operator=(const Scope &) = delete;
+
+	private:
+		EngineContext * m_previous;
+	} ;
+
+	//! The context of the calling thread, the main one if no Scope is
+	//! active. While there is no other context, that's a single load.
+	static EngineContext * current()
+	{
+		return s_others.load(std::memory_order_relaxed) == 0 ?
+			s_main : currentOfThread();
+	}
+
+	static EngineContext * mainContext()
+	{
+		return s_main;
+	}
+
+	Mixer * mixer() const
+	{
+		return m_mixer;
+	}
+
+	FxMixer * fxMixer() const
+	{
+		return m_fxMixer;
+	}
+
+	Song * song() const
+	{
+		return m_song;
+	}
+
+	BBTrackContainer * bbTrackContainer() const
+	{
+		return m_bbTrackContainer;
+	}
+
+	ProjectJournal * projectJournal() const
+	{
+		return m_projectJournal;
+	}
+
+	ControllerGraph * controllerGraph() const
+	{
+		return m_controllerGraph.get();
+	}
+
+	LfoInstances * lfoInstances() const
+	{
+		return m_lfoInstances.get();
+	}
+
+	float framesPerTick() const
+	{
+		return m_framesPerTick;
+	}
+
+	void setFramesPerTick(float framesPerTick)
+	{
+		m_framesPerTick = framesPerTick;
+	}
+
+	//! The number of periods the mixer has rendered, which tells the
+	//! models whether their buffers are from the current period
+	long period() const
+	{
+		return m_period.load(std::memory_order_relaxed);
+	}
+
+	void nextPeriod()
+	{
+		m_period.fetch_add(1, std::memory_order_relaxed);
+	}
+
+private:
+	static EngineContext * currentOfThread();
+
+	// the first context created is the main one
+	static EngineContext * s_main;
+	// the number of contexts besides the main one
+	static std::atomic_int s_others;
+
+	Mixer * m_mixer;
+	FxMixer * m_fxMixer;
+	Song * m_song;
+	BBTrackContainer * m_bbTrackContainer;
+	ProjectJournal * m_projectJournal;
+	std::unique_ptr<ControllerGraph> m_controllerGraph;
+	std::unique_ptr<LfoInstances> m_lfoInstances;
+	float m_framesPerTick;
+	std::atomic<long> m_period;
+
+} ;
+
+
+#endif
@@ -33,40 +33,36 @@
 #include "TempoSyncKnobModel.h"
 #include "lmms_basics.h"
 
+class EnvelopeAndLfoParameters;
 
-class LMMS_EXPORT EnvelopeAndLfoParameters : public Model, public JournallingObject
+
+// the LFOs of an EngineContext, which advance with its periods
+class LfoInstances
 {
-	Q_OBJECT
 public:
-	class LfoInstances
+	inline bool isEmpty() const
 	{
-	public:
-		LfoInstances()
-		{
-		}
-
-		~LfoInstances()
-		{
-		}
+		return m_lfos.isEmpty();
+	}
 
-		inline bool isEmpty() const
-		{
-			return m_lfos.isEmpty();
-		}
+	void trigger();
+	void reset();
 
-		void trigger();
-		void reset();
+	void add( EnvelopeAndLfoParameters * lfo );
+	void remove( EnvelopeAndLfoParameters * lfo );
 
-		void add( EnvelopeAndLfoParameters * lfo );
-		void remove( EnvelopeAndLfoParameters * lfo );
+private:
+	QMutex m_lfoListMutex;
+	typedef QList<EnvelopeAndLfoParameters *> LfoList;
+	LfoList m_lfos;
 
-	private:
-		QMutex m_lfoListMutex;
-		typedef QList<EnvelopeAndLfoParameters *> LfoList;
-		LfoList m_lfos;
+} ;
 
-	} ;
 
+class LMMS_EXPORT EnvelopeAndLfoParameters : public Model, public JournallingObject
+{
+	Q_OBJECT
+public:
 	EnvelopeAndLfoParameters( float _value_for_zero_amount,
 							Model * _parent );
 	virtual ~EnvelopeAndLfoParameters();
@@ -76,10 +72,8 @@ public:
 		return ( ( _val < 0 ) ? -_val : _val ) * _val;
 	}
 
-	static LfoInstances * instances()
-	{
-		return s_lfoInstances;
-	}
+	//! The LFOs of the current EngineContext
+	static LfoInstances * instances();
 
 	void fillLevel( float * _buf, f_cnt_t _frame,
 				const f_cnt_t _release_begin,
@@ -118,7 +112,8 @@ protected:
 
 
 private:
-	static LfoInstances * s_lfoInstances;
+	// the list this LFO was added to
+	LfoInstances * m_lfoInstances;
 	bool m_used;
 
 	QMutex m_paramMutex;
@@ -162,6 +157,9 @@ private:
 	sample_t * m_lfoShapeData;
 	sample_t m_random;
 	bool m_bad_lfoShapeData;
+	// level of notes in their sustain phase for the current period
+	sample_t * m_sustainData;
+	bool m_bad_sustainData;
 	SampleBuffer m_userWave;
 
 	enum LfoShapes
@@ -177,9 +175,11 @@ private:
 
 	sample_t lfoShapeSample( fpp_t _frame_offset );
 	void updateLfoShapeData();
+	void updateSustainData();
 
 
 	friend class EnvelopeAndLfoView;
+	friend class LfoInstances;
 
 } ;
 
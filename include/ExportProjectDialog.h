@@ -48,6 +48,7 @@ protected:
 private slots:
 	void startBtnClicked( void );
 	void updateTitleBar( int );
+	void updateProgressDetails( int );
 	void accept() override;
 	void startExport();
 
@@ -0,0 +1,138 @@
+/*
+ * FftAnalysis.h - FFT plans, windows and threads shared by all analyzers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FFT_ANALYSIS_H
+#define FFT_ANALYSIS_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "fft_helpers.h"
+#include "lmms_export.h"
+
+
+class QThread;
+
+/*! \brief The analysis side of spectrum displays, shared by all plugins
+ *
+ *  FFTW plans are made once per size and kept for the whole session, and
+ *  the planner's wisdom is stored in the cache directory, so FFTW_MEASURE
+ *  only measures a size the first time it's ever used. Window tables are
+ *  computed once per type and length. FftConvolver takes its plans from
+ *  here as well.
+ *
+ *  Analyzers don't run their own threads. They register a Client, write
+ *  their input to a LocklessRingBuffer on the audio thread and call
+ *  Client::notify(). A small pool of threads runs the analysis of every
+ *  notified client up to FramesPerSecond times a second, so the work of
+ *  one display frame is done in one go and clients that aren't notified,
+ *  e.g. because their view is hidden, cost nothing.
+ */
+class LMMS_EXPORT FftAnalysis
+{
+public:
+	//! How often a client's analysis runs at most
+	static const int FramesPerSecond = 60;
+
+	class LMMS_EXPORT Client
+	{
+	public:
+		Client() : m_pending(false), m_running(false) {}
+		virtual ~Client() = default;
+
+		//! Tells the analysis threads new input is waiting, realtime safe
+		void notify()
+		{
+			m_pending.store(true, std::memory_order_release);
+		}
+
+	protected:
+		//! Processes the waiting input. Runs on an analysis thread, but
+		//! never on two at once for the same client.
+		virtual void analyze() = 0;
+
+	private:
+		std::atomic<bool> m_pending;
+		bool m_running; // guarded by s_clientMutex
+
+		friend class FftAnalysis;
+	} ;
+
+	//! Starts running @p client whenever it's notified
+	static void addClient(Client * client);
+	//! Stops running @p client, waits for its analysis if it's running
+	static void removeClient(Client * client);
+
+	//! A real to complex transform of @p size points, to be run with
+	//! fftwf_execute_dft_r2c() on buffers allocated by fftwf_malloc(), see
+	//! execute() for others. The plan is owned by FftAnalysis.
+	static fftwf_plan plan(unsigned int size);
+
+	//! Transforms @p size real points of @p in into size / 2 + 1 bins
+	static void execute(unsigned int size, float * in, fftwf_complex * out);
+
+	//! The complex to real transform matching plan(), to be run with
+	//! fftwf_execute_dft_c2r() on buffers allocated by fftwf_malloc().
+	//! It overwrites its input, like every c2r transform of FFTW.
+	static fftwf_plan inversePlan(unsigned int size);
+
+	//! A window of @p type, computed by precomputeWindow() the first time
+	//! it's asked for. It stays valid for the whole session.
+	static const float * window(FFT_WINDOWS type, unsigned int length,
+		bool normalized = true);
+
+private:
+	class Worker;
+
+	static void loadWisdom();
+	static void saveWisdom();
+	static fftwf_plan makePlan(unsigned int size, bool aligned);
+	static fftwf_plan makeInversePlan(unsigned int size);
+	static void workerLoop(int generation);
+
+	// FFTW's planner isn't thread safe, so it's only used under this lock
+	static QMutex s_planMutex;
+	static std::map<std::pair<unsigned int, bool>, fftwf_plan> s_plans;
+	static std::map<unsigned int, fftwf_plan> s_inversePlans;
+	static bool s_wisdomLoaded;
+
+	static QMutex s_windowMutex;
+	static std::map<std::pair<std::pair<int, unsigned int>, bool>, std::vector<float>> s_windows;
+
+	static QMutex s_clientMutex;
+	static QWaitCondition s_clientDone;
+	static QWaitCondition s_wake;
+	static std::vector<Client *> s_clients;
+	static std::vector<QThread *> s_workers;
+	// bumped to stop the current workers
+	static int s_generation;
+} ;
+
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * FftConvolver.h - uniformly partitioned FFT convolution
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FFT_CONVOLVER_H
+#define FFT_CONVOLVER_H
+
+#include <QtCore/QtGlobal>
+
+#include "fft_helpers.h"
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+/*! \brief Convolves a signal with an impulse response, without latency
+ *
+ *  The impulse response is split into partitions of blockSize frames, each
+ *  transformed once by init(). Every block of input is transformed once as
+ *  well and kept in a frequency domain delay line, so a block of output
+ *  costs one forward and one inverse FFT of 2 * blockSize points plus one
+ *  complex multiply-add per partition.
+ *
+ *  A block that is only partly filled is transformed as it is, which is
+ *  what makes the output available right away. The products of the older
+ *  input blocks are only summed up once per block, so the extra cost of
+ *  partial blocks is the two FFTs.
+ *
+ *  process() is realtime safe. Everything else allocates.
+ */
+class LMMS_EXPORT FftConvolver
+{
+public:
+	FftConvolver();
+	~FftConvolver();
+
+	//! Partitions @p length frames of @p ir into blocks of @p blockSize
+	//! frames, rounded up to a power of two
+	void init(fpp_t blockSize, const float * ir, f_cnt_t length);
+
+	//! Prepares for an impulse response of @p partitions blocks of
+	//! @p blockSize frames, a power of two. It's silent until
+	//! setSpectrum().
+	void initSpectrum(fpp_t blockSize, int partitions);
+
+	//! The spectra of the partitions of @p ir, as setSpectrum() takes
+	//! them: partitions * (blockSize + 1) bins, each block of bins being
+	//! the FFT of one partition padded to 2 * blockSize points. Realtime
+	//! safe, so responses can be mixed in the frequency domain.
+	void transform(const float * ir, f_cnt_t length, fftwf_complex * spectra);
+
+	//! Replaces the impulse response by the one given by @p spectra,
+	//! keeps the input. Realtime safe.
+	void setSpectrum(const fftwf_complex * spectra);
+
+	//! Forgets the input, the impulse response is kept
+	void reset();
+
+	//! Writes @p frames frames of @p in convolved to @p out, which may be
+	//! the same buffer
+	void process(const float * in, float * out, f_cnt_t frames);
+
+	bool isEmpty() const
+	{
+		return m_segmentCount == 0;
+	}
+
+	fpp_t blockSize() const
+	{
+		return m_blockSize;
+	}
+
+	//! The memory used by the spectra and buffers
+	qint64 memoryUsage() const;
+
+private:
+	void allocate(fpp_t blockSize, int segmentCount);
+	void release();
+
+	fpp_t m_blockSize;
+	int m_bins;
+	// bins of a segment, padded so every segment stays aligned for FFTW
+	int m_stride;
+	int m_segmentCount;
+
+	fftwf_plan m_forward;
+	fftwf_plan m_inverse;
+
+	// transformed input blocks, m_current being the newest
+	fftwf_complex * m_segments;
+	// transformed partitions of the impulse response
+	fftwf_complex * m_segmentsIr;
+	int m_current;
+
+	// sum of the products of all but the newest input block
+	fftwf_complex * m_preMultiplied;
+	fftwf_complex * m_conv;
+	float * m_fftBuffer;
+	float * m_overlap;
+	float * m_inputBuffer;
+	fpp_t m_inputFill;
+	bool m_responseChanged;
+} ;
+
+
+#endif
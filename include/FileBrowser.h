@@ -37,6 +37,7 @@
 
 class QLineEdit;
 
+class FileIndex;
 class FileItem;
 class InstrumentTrack;
 class FileBrowserTreeWidget;
@@ -55,7 +56,8 @@ public:
 			If a directory of factory files should be in the list it
 			must be the last one (for the factory files delimiter to work)
 		@param filter Filter as used in QDir::match
-		@param recurse *to be documented*
+		@param recurse Index all files below the directories, so a
+			search finds them without listing them in the tree
 	*/
 	FileBrowser( const QString & directories, const QString & filter,
 			const QString & title, const QPixmap & pm,
@@ -70,14 +72,27 @@ private slots:
 	void expandItems( QTreeWidgetItem * item=nullptr, QList<QString> expandedDirs = QList<QString>() );
 	// call with item=NULL to filter the entire tree
 	bool filterItems( const QString & filter, QTreeWidgetItem * item=nullptr );
+	//! Searches the index if there is one, else filters the tree
+	void filterChanged( const QString & filter );
+	void showSearchResults();
+	//! Reloads the tree and scans the directories of the index again
+	void reload();
 	void giveFocusToFilter();
 
 private:
+	//! Most files shown for a search
+	static const int MaxSearchResults = 1000;
+
 	void keyPressEvent( QKeyEvent * ke ) override;
 
 	void addItems( const QString & path );
+	//! The directories whose content is shown
+	QStringList shownDirectories() const;
 
 	FileBrowserTreeWidget * m_fileBrowserTreeWidget;
+	//! Files the index found, shown instead of the tree while searching
+	FileBrowserTreeWidget * m_searchResults = nullptr;
+	FileIndex * m_index = nullptr;
 
 	QLineEdit * m_filterEdit;
 
@@ -123,6 +138,8 @@ protected:
 private:
 	//! Start a preview of a file item
 	void previewFileItem(FileItem* file);
+	//! Preload the samples around a previewed one, to preview them at once
+	void preloadNeighbours(FileItem* file);
 	//! If a preview is playing, stop it.
 	void stopPreview();
 
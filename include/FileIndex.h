@@ -0,0 +1,170 @@
+/*
+ * FileIndex.h - index of the files below the directories of a browser
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include <atomic>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+
+/**
+	Index of the files below some directories, for searching them without
+	listing directories on the GUI thread
+
+	The directories are scanned on a thread of their own, and the index
+	grows while the scan goes on. The index is kept in the cache, so it can
+	be searched right after the next start. A directory is only listed
+	again if its modification time changed, which is the case whenever
+	files are added to it or removed from it.
+
+	Directories are watched while they are in the index, up to
+	MaxWatchedDirs of them, and scanned again when they change.
+*/
+class FileIndex : public QObject
+{
+	Q_OBJECT
+public:
+	static const int MaxWatchedDirs = 4096;
+
+	struct Directory
+	{
+		QString path;
+		qint64 modified;
+		QStringList subDirs;
+		//! Names of the files which pass the filter
+		QStringList files;
+		//! The same in lower case, for searching
+		QStringList lowerFiles;
+		//! The path below its root in lower case, for searching
+		QString lowerPath;
+	} ;
+
+	struct Match
+	{
+		//! The directory of the file
+		QString path;
+		QString name;
+	} ;
+
+	//! Indexes the files below @p roots which match @p filter as used
+	//! in QDir::match(), and starts scanning
+	FileIndex(const QStringList& roots, const QString& filter,
+		QObject* parent = nullptr);
+	~FileIndex() override;
+
+	//! The files below @p roots whose name, or the name of a directory
+	//! leading to them, contains @p text, ignoring case. At most @p limit
+	//! files are returned, sorted by name.
+	QVector<Match> find(const QString& text, const QStringList& roots,
+		int limit) const;
+
+	bool isScanning() const { return m_scanner.isRunning(); }
+
+public slots:
+	//! Lists all directories again
+	void rescan();
+
+signals:
+	//! More directories were scanned
+	void updated();
+
+private slots:
+	void takeScanned();
+	void scanDirectory(const QString& path);
+
+private:
+	class Scanner : public QThread
+	{
+	public:
+		Scanner(FileIndex* index);
+
+		//! Must only be called while not running. Directories in
+		//! @p known are only listed again if they were modified. If
+		//! @p all is true, @p paths are the roots and the index is
+		//! written to the cache after, if @p loadCache is true too it
+		//! is loaded from there first.
+		void prepare(const QStringList& paths,
+			const QHash<QString, Directory>& known, bool all,
+			bool loadCache);
+		//! Scans @p path after the paths being scanned, must be called
+		//! with m_index->m_mutex held
+		void request(const QString& path);
+		void stop();
+
+	protected:
+		void run() override;
+
+	private:
+		void scan(const QString& path, QSet<QString>& seen);
+		void publish(const Directory& dir);
+
+		FileIndex* m_index;
+		QHash<QString, Directory> m_known;
+		bool m_all;
+		bool m_loadCache;
+		//! all directories found, for the cache
+		QVector<Directory> m_found;
+		std::atomic<bool> m_stop;
+
+		// guarded by m_index->m_mutex
+		QStringList m_paths;
+	} ;
+
+	QString cacheFile() const;
+	void startScanner(const QStringList& paths,
+		const QHash<QString, Directory>& known, bool all, bool loadCache);
+	void addDirectory(Directory dir);
+	void removeDirectory(const QString& path);
+	QString rootOf(const QString& path) const;
+
+	QStringList m_roots;
+	QString m_filter;
+	QHash<QString, Directory> m_dirs;
+
+	QFileSystemWatcher m_watcher;
+	QSet<QString> m_watched;
+
+	Scanner m_scanner;
+
+	// handed from the scanner to the GUI thread
+	QMutex m_mutex;
+	QVector<Directory> m_scanned;
+	//! the paths scanned completely, with all directories found below
+	QVector<QPair<QString, QSet<QString>>> m_finished;
+	//! set once the scanner takes no more requests
+	bool m_scanDone;
+
+	friend class Scanner;
+} ;
+
+
+#endif
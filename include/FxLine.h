@@ -61,6 +61,9 @@ public:
 	inline int channelIndex() { return m_channelIndex; }
 	void setChannelIndex(int index);
 
+	// show whether the channel is currently skipped by the FX mixer
+	void setSleeping( bool sleeping );
+
 	Knob * m_sendKnob;
 	SendButtonIndicator * m_sendBtn;
 
@@ -98,6 +101,7 @@ private:
 	static QPixmap * s_sendBgArrow;
 	static QPixmap * s_receiveBgArrow;
 	bool m_inRename;
+	bool m_sleeping;
 	QLineEdit * m_renameLineEdit;
 	QGraphicsView * m_view;
 
@@ -28,14 +28,62 @@
 #include "Model.h"
 #include "EffectChain.h"
 #include "JournallingObject.h"
+#include "MeterSnapshot.h"
+#include "MixerProfiler.h"
 #include "ThreadableJob.h"
 
 #include <atomic>
+#include <vector>
 
 #include <QColor>
 
 class FxRoute;
+class FxChannel;
 typedef QVector<FxRoute *> FxRouteVector;
+typedef QVector<FxChannel *> FxChannelVector;
+
+
+//! Delays a signal by a number of frames, to line it up with signals which
+//! went through effects of higher latency. Nothing is processed while the
+//! delay is 0. The ring is allocated up front by reserve(), so changing the
+//! delay on the mixer thread doesn't allocate.
+class FxDelay
+{
+public:
+	FxDelay();
+
+	f_cnt_t delay() const
+	{
+		return m_delay;
+	}
+
+	//! Makes room for delays of up to frames. Not realtime safe, call
+	//! it with the mixer locked.
+	void reserve( f_cnt_t frames );
+
+	//! Clears the delayed signal if the delay changes. Delays beyond
+	//! what was reserved are cut down to it.
+	void setDelay( f_cnt_t delay );
+
+	//! Whether delayed signal still has to come out
+	bool isPending() const
+	{
+		return m_pending > 0;
+	}
+
+	//! Writes the delayed frames of in to out, which may be the same
+	//! buffer. hasInput tells whether there's signal in in at all.
+	void process( const sampleFrame * in, sampleFrame * out,
+					bool hasInput, fpp_t frames );
+
+private:
+	f_cnt_t m_delay;
+	std::vector<sampleFrame> m_ring;
+	f_cnt_t m_position;
+	f_cnt_t m_pending;
+
+} ;
+
 
 class FxChannel : public ThreadableJob
 {
@@ -50,6 +98,8 @@ class FxChannel : public ThreadableJob
 		// set to true if any effect in the channel is enabled and running
 		bool m_stillRunning;
 
+		// peaks of the current period, published through
+		// FxMixer::meters()
 		float m_peakLeft;
 		float m_peakRight;
 		sampleFrame * m_buffer;
@@ -60,8 +110,10 @@ class FxChannel : public ThreadableJob
 		QString m_name;
 		QMutex m_lock;
 		int m_channelIndex; // what channel index are we
-		bool m_queued; // are we queued up for rendering yet?
 		bool m_muted; // are we muted? updated per period so we don't have to call m_muteModel.value() twice
+		// set to true when the channel has neither input nor a running
+		// effect tail, so it's left out of the period (its buffer stays clear)
+		bool m_sleeping;
 
 		// pointers to other channels that this one sends to
 		FxRouteVector m_sends;
@@ -69,6 +121,16 @@ class FxChannel : public ThreadableJob
 		// pointers to other channels that send to this one
 		FxRouteVector m_receives;
 
+		// latency of the output of this channel, i.e. of its effects
+		// and of the latest of its inputs
+		f_cnt_t m_latency;
+		// lines up the input mixed in by tracks with the latency of
+		// the sends this channel receives
+		FxDelay m_inputDelay;
+
+		// time spent processing this channel including its effects
+		MixerProfiler::TimeCounter m_processingTime;
+
 		bool requiresProcessing() const override { return true; }
 		void unmuteForSolo();
 
@@ -83,11 +145,6 @@ class FxChannel : public ThreadableJob
 		QColor m_color;
 		bool m_hasColor;
 
-	
-		std::atomic_int m_dependenciesMet;
-		void incrementDeps();
-		void processed();
-		
 	private:
 		void doProcessing() override;
 };
@@ -124,6 +181,18 @@ class FxRoute : public QObject
 	{
 		return m_to;
 	}
+
+	//! Lines up the signal of this route with the latest input of the
+	//! receiver
+	FxDelay & delay()
+	{
+		return m_delay;
+	}
+
+	const FxDelay & delay() const
+	{
+		return m_delay;
+	}
 	
 	void updateName();
 		
@@ -131,6 +200,7 @@ class FxRoute : public QObject
 		FxChannel * m_from;
 		FxChannel * m_to;
 		FloatModel m_amount;
+		FxDelay m_delay;
 };
 
 
@@ -144,7 +214,7 @@ public:
 	void mixToChannel( const sampleFrame * _buf, fx_ch_t _ch );
 
 	void prepareMasterMix();
-	void masterMix( sampleFrame * _buf );
+	void masterMix( sampleFrame * _buf, bool useWorkerThreads = true );
 
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
 	void loadSettings( const QDomElement & _this ) override;
@@ -174,6 +244,11 @@ public:
 	bool isInfiniteLoop(fx_ch_t fromChannel, fx_ch_t toChannel);
 	bool checkInfiniteLoop( FxChannel * from, FxChannel * to );
 
+	// whether the output of a channel gets to the master on a path
+	// without muted channels, or drives a peak controller. Mute buttons
+	// which are automated or controlled count as unmuted.
+	bool isChannelAudible( fx_ch_t channel ) const;
+
 	// return the FloatModel of fromChannel sending its output to the input of
 	// toChannel. NULL if there is no send.
 	FloatModel * channelSendModel(fx_ch_t fromChannel, fx_ch_t toChannel);
@@ -207,15 +282,66 @@ public:
 		return m_fxChannels.size();
 	}
 
+	//! The frames the master output lags behind the tracks due to the
+	//! latency of effects in the FX mixer
+	f_cnt_t latency() const
+	{
+		return m_fxChannels[0]->m_latency;
+	}
+
+	//! The peaks of all channels, published once per period. The peaks
+	//! of the master channel include the master gain.
+	MeterSnapshot & meters()
+	{
+		return m_meters;
+	}
+
 	FxRouteVector m_fxRoutes;
 
+public slots:
+	//! Allocates the delay lines for the latencies of the current routes
+	//! and effects, so the mixer thread doesn't have to
+	void reserveDelays();
+
 private:
 	// the fx channels in the mixer. index 0 is always master.
 	QVector<FxChannel *> m_fxChannels;
 
+	MeterSnapshot m_meters;
+
 	// make sure we have at least num channels
 	void allocateChannelsTo(int num);
 
+	// the routing graph changed, rebuild the schedule before next mix
+	void invalidateSchedule()
+	{
+		m_scheduleDirty = true;
+	}
+
+	// sort all unmuted channels into levels, where every channel only
+	// receives from channels of previous levels
+	void buildSchedule();
+
+	// sort all channels, muted or not, so that every channel comes after
+	// the channels it receives from
+	FxChannelVector sortByRoutes() const;
+
+	// sum up the latencies along the routes and delay the inputs of each
+	// channel to the latest of them. Muted channels count as well, so
+	// muting doesn't shift the other routes.
+	void updateLatencies();
+
+	// whether a channel has to be processed this period, i.e. it has input,
+	// its effects are still running or any of its senders is awake
+	static bool isAwake( const FxChannel * ch );
+
+	QVector<FxChannelVector> m_schedule;
+	// all channels including muted ones, in the order of the routes
+	FxChannelVector m_routeOrder;
+	bool m_scheduleDirty;
+	// the channels of the current level which aren't sleeping
+	FxChannelVector m_awakeChannels;
+
 	int m_lastSoloed;
 
 } ;
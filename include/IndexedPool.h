@@ -0,0 +1,476 @@
+/*
+ * IndexedPool.h - lock-free pool of elements named by their index
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INDEXED_POOL_H
+#define INDEXED_POOL_H
+
+#include <QMutex>
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "MemoryManager.h"
+
+
+/**
+	Lock-free stack of indices. The head holds index + 1 of the top in the
+	low word (0 = empty) and a tag against ABA in the high word. The links
+	live wherever the owner keeps them: @p nextOf( index ) has to return
+	the std::atomic<uint32_t> holding index + 1 of the element below.
+
+	A thread losing a race in pop() may still read the link of an element
+	another thread just took, so links must not be part of what the owner
+	hands out.
+*/
+class IndexStack
+{
+public:
+	static const uint32_t Empty = 0xFFFFFFFF;
+
+	IndexStack() :
+		m_head( 0 )
+	{
+	}
+
+	//! Pushes the elements from @p first to @p last, which are linked
+	//! already, with a single CAS
+	template<class NextOf>
+	void pushLinked( uint32_t first, uint32_t last, NextOf nextOf )
+	{
+		uint64_t head = m_head.load( std::memory_order_relaxed );
+		uint64_t newHead;
+		do
+		{
+			nextOf( last ).store( uint32_t( head ), std::memory_order_relaxed );
+			newHead = tagged( head, first + 1 );
+		} while( !m_head.compare_exchange_weak( head, newHead,
+					std::memory_order_release, std::memory_order_relaxed ) );
+	}
+
+	//! Links @p count indices and pushes them with a single CAS
+	template<class NextOf>
+	void push( const uint32_t * indices, int count, NextOf nextOf )
+	{
+		for( int i = 0; i < count - 1; ++i )
+		{
+			nextOf( indices[i] ).store( indices[i + 1] + 1, std::memory_order_relaxed );
+		}
+		pushLinked( indices[0], indices[count - 1], nextOf );
+	}
+
+	//! The top index, Empty if there is none
+	template<class NextOf>
+	uint32_t pop( NextOf nextOf )
+	{
+		uint64_t head = m_head.load( std::memory_order_acquire );
+		uint64_t newHead;
+		do
+		{
+			if( uint32_t( head ) == 0 )
+			{
+				return Empty;
+			}
+			// if another thread takes this element first, the link may
+			// be outdated, but then the tag changed and the exchange fails
+			const uint32_t link = nextOf( uint32_t( head ) - 1 ).load(
+							std::memory_order_relaxed );
+			newHead = tagged( head, link );
+		} while( !m_head.compare_exchange_weak( head, newHead,
+					std::memory_order_acquire, std::memory_order_acquire ) );
+		return uint32_t( head ) - 1;
+	}
+
+	//! Pops up to @p max indices, returns how many it got
+	template<class NextOf>
+	int pop( uint32_t * indices, int max, NextOf nextOf )
+	{
+		int count = 0;
+		while( count < max )
+		{
+			const uint32_t index = pop( nextOf );
+			if( index == Empty )
+			{
+				break;
+			}
+			indices[count++] = index;
+		}
+		return count;
+	}
+
+	//! Forgets all elements, only while no other thread uses the stack
+	void clear()
+	{
+		m_head = 0;
+	}
+
+private:
+	static uint64_t tagged( uint64_t oldHead, uint32_t link )
+	{
+		return ( ( ( oldHead >> 32 ) + 1 ) << 32 ) | link;
+	}
+
+	std::atomic<uint64_t> m_head;
+
+} ;
+
+
+
+
+//! Chunks of IndexedPool from the MemoryManager
+struct IndexedPoolMemory
+{
+	static void * allocate( std::size_t bytes )
+	{
+		return MemoryManager::alloc( bytes );
+	}
+
+	static void release( void * ptr, std::size_t )
+	{
+		MemoryManager::free( ptr );
+	}
+
+	//! Whether blocks are aligned to @p alignment already
+	static bool aligns( std::size_t )
+	{
+		return false;
+	}
+} ;
+
+
+
+
+/**
+	Elements of a fixed size in chunks of @p ChunkSize, which are only
+	freed by free(), so every element can be named by an index. The index
+	is stored in front of each element, and the free elements are linked
+	through a side table in an IndexStack.
+
+	Each thread keeps up to @p CacheSize elements in a ThreadCache of its
+	own and exchanges them with the free list in batches of half of it.
+	acquire() never allocates: when the free list runs low, it asks for
+	growIfRequested() to add a chunk, and when it's empty, the owner
+	either grows the pool itself or falls back on acquireOverflow().
+	Chunk memory comes from @p Memory, see IndexedPoolMemory.
+*/
+template<int ChunkSize, int CacheSize, class Memory = IndexedPoolMemory>
+class IndexedPool
+{
+public:
+	static const int MaxChunks = 1024;
+
+	//! Elements owned by one thread. Given back to the pool when the
+	//! thread exits, unless the pool was freed in the meantime.
+	struct ThreadCache
+	{
+		explicit ThreadCache( IndexedPool & owner ) :
+			pool( owner ),
+			count( 0 ),
+			generation( owner.m_generation.load() )
+		{
+		}
+
+		~ThreadCache()
+		{
+			pool.sync( *this );
+			if( count > 0 )
+			{
+				pool.pushFree( indices, count );
+			}
+		}
+
+		IndexedPool & pool;
+		uint32_t indices[CacheSize];
+		int count;
+		int generation;
+	} ;
+
+	//! @p name is used in error messages, @p elementBytes and
+	//! @p alignment describe the elements
+	IndexedPool( const char * name, std::size_t elementBytes,
+						std::size_t alignment ) :
+		m_name( name ),
+		m_alignment( qMax( alignment, alignof( Header ) ) ),
+		m_headerBytes( roundUp( sizeof( Header ), m_alignment ) ),
+		m_stride( m_headerBytes + roundUp( elementBytes, m_alignment ) ),
+		m_chunkCount( 0 ),
+		m_generation( 0 ),
+		m_inUse( 0 ),
+		m_highWaterMark( 0 ),
+		m_overflows( 0 ),
+		m_growRequested( false )
+	{
+		for( auto & chunk : m_chunks )
+		{
+			chunk = nullptr;
+		}
+	}
+
+	//! Changes the size of the elements, only while the pool is empty
+	void setElementBytes( std::size_t elementBytes )
+	{
+		Q_ASSERT( m_chunkCount == 0 );
+		m_stride = m_headerBytes + roundUp( elementBytes, m_alignment );
+	}
+
+	//! An element from @p cache, which is refilled from the free list if
+	//! it's empty. nullptr if the free list is empty too.
+	void * acquire( ThreadCache & cache )
+	{
+		sync( cache );
+		if( cache.count == 0 )
+		{
+			cache.count = m_free.pop( cache.indices, CacheSize / 2, nextOf() );
+			if( cache.count < CacheSize / 2 )
+			{
+				// running low, grow before the audio threads run out
+				m_growRequested = true;
+			}
+			if( cache.count == 0 )
+			{
+				++m_overflows;
+				return nullptr;
+			}
+		}
+		countAcquired();
+		return elementAt( cache.indices[--cache.count] );
+	}
+
+	//! An element of its own from the MemoryManager, for when the pool
+	//! is empty and must not grow
+	void * acquireOverflow()
+	{
+		char * memory = static_cast<char *>(
+				MemoryManager::alloc( m_stride + m_alignment ) );
+		char * element = align( memory ) + m_headerBytes;
+		new( header( element ) ) Header{ memory, Overflow };
+		countAcquired();
+		return element;
+	}
+
+	//! Gives back an element of acquire() or acquireOverflow()
+	void release( ThreadCache & cache, void * element )
+	{
+		--m_inUse;
+		const Header * h = header( element );
+		if( h->index == Overflow )
+		{
+			MemoryManager::free( h->overflow );
+			return;
+		}
+
+		sync( cache );
+		if( cache.count == CacheSize )
+		{
+			cache.count -= CacheSize / 2;
+			pushFree( cache.indices + cache.count, CacheSize / 2 );
+		}
+		cache.indices[cache.count++] = h->index;
+	}
+
+	//! Allocates another chunk and puts its elements onto the free list.
+	//! Not realtime safe.
+	void grow()
+	{
+		QMutexLocker lock( &m_growMutex );
+		m_growRequested = false;
+
+		const int c = m_chunkCount.load( std::memory_order_relaxed );
+		if( c >= MaxChunks )
+		{
+			qFatal( "%s: exceeded %d elements", m_name,
+							MaxChunks * ChunkSize );
+		}
+
+		Chunk * chunk = new Chunk;
+		chunk->bytes = ChunkSize * m_stride +
+				( Memory::aligns( m_alignment ) ? 0 : m_alignment );
+		chunk->memory = static_cast<char *>( Memory::allocate( chunk->bytes ) );
+		chunk->elements = align( chunk->memory ) + m_headerBytes;
+
+		uint32_t indices[ChunkSize];
+		for( int i = 0; i < ChunkSize; ++i )
+		{
+			indices[i] = c * ChunkSize + i;
+			new( header( chunk->elements + i * m_stride ) )
+						Header{ nullptr, indices[i] };
+		}
+		m_chunks[c].store( chunk, std::memory_order_release );
+		m_chunkCount.store( c + 1, std::memory_order_release );
+		pushFree( indices, ChunkSize );
+	}
+
+	//! Grows the pool if acquire() found it running low
+	void growIfRequested()
+	{
+		if( m_growRequested )
+		{
+			grow();
+		}
+	}
+
+	//! Frees all chunks, the elements in the caches of the threads are
+	//! dropped. Only while no element is in use.
+	void free()
+	{
+		++m_generation;
+		const int chunks = m_chunkCount.exchange( 0 );
+		for( int c = 0; c < chunks; ++c )
+		{
+			Chunk * chunk = m_chunks[c].exchange( nullptr );
+			Memory::release( chunk->memory, chunk->bytes );
+			delete chunk;
+		}
+		m_free.clear();
+		m_inUse = 0;
+		m_highWaterMark = 0;
+		m_overflows = 0;
+		m_growRequested = false;
+	}
+
+	int capacity() const
+	{
+		return m_chunkCount.load( std::memory_order_relaxed ) * ChunkSize;
+	}
+
+	//! Elements currently acquired, including overflows
+	int inUse() const
+	{
+		return m_inUse.load( std::memory_order_relaxed );
+	}
+
+	//! Largest number of elements that were acquired at the same time
+	int highWaterMark() const
+	{
+		return m_highWaterMark.load( std::memory_order_relaxed );
+	}
+
+	//! How often acquire() found the free list empty
+	int overflows() const
+	{
+		return m_overflows.load( std::memory_order_relaxed );
+	}
+
+private:
+	static const uint32_t Overflow = 0xFFFFFFFF;
+
+	//! Precedes every element
+	struct Header
+	{
+		//! the memory of an overflow, nullptr for elements of the pool
+		void * overflow;
+		uint32_t index;
+	} ;
+
+	struct Chunk
+	{
+		char * memory;
+		std::size_t bytes;
+		char * elements;
+		std::atomic<uint32_t> next[ChunkSize];
+	} ;
+
+	static std::size_t roundUp( std::size_t bytes, std::size_t alignment )
+	{
+		return ( bytes + alignment - 1 ) / alignment * alignment;
+	}
+
+	char * align( char * memory ) const
+	{
+		const std::uintptr_t address = reinterpret_cast<std::uintptr_t>( memory );
+		return memory + ( m_alignment - address % m_alignment ) % m_alignment;
+	}
+
+	Header * header( void * element ) const
+	{
+		return reinterpret_cast<Header *>(
+				static_cast<char *>( element ) - m_headerBytes );
+	}
+
+	Chunk * chunkOf( uint32_t index ) const
+	{
+		return m_chunks[index / ChunkSize].load( std::memory_order_acquire );
+	}
+
+	void * elementAt( uint32_t index ) const
+	{
+		return chunkOf( index )->elements + index % ChunkSize * m_stride;
+	}
+
+	auto nextOf()
+	{
+		return [this]( uint32_t index ) -> std::atomic<uint32_t> &
+		{
+			return chunkOf( index )->next[index % ChunkSize];
+		};
+	}
+
+	void pushFree( const uint32_t * indices, int count )
+	{
+		m_free.push( indices, count, nextOf() );
+	}
+
+	//! Drops the elements of @p cache if the pool was freed since
+	void sync( ThreadCache & cache )
+	{
+		const int generation = m_generation.load( std::memory_order_relaxed );
+		if( cache.generation != generation )
+		{
+			cache.count = 0;
+			cache.generation = generation;
+		}
+	}
+
+	void countAcquired()
+	{
+		const int used = ++m_inUse;
+		int peak = m_highWaterMark.load( std::memory_order_relaxed );
+		while( used > peak && !m_highWaterMark.compare_exchange_weak(
+					peak, used, std::memory_order_relaxed ) )
+		{
+		}
+	}
+
+	const char * m_name;
+	const std::size_t m_alignment;
+	const std::size_t m_headerBytes;
+	std::size_t m_stride;
+
+	std::atomic<Chunk *> m_chunks[MaxChunks];
+	std::atomic_int m_chunkCount;
+	QMutex m_growMutex;
+	IndexStack m_free;
+	std::atomic_int m_generation;
+
+	std::atomic_int m_inUse;
+	std::atomic_int m_highWaterMark;
+	std::atomic_int m_overflows;
+	std::atomic_bool m_growRequested;
+
+} ;
+
+
+#endif
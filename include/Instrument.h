@@ -51,6 +51,7 @@ public:
 		IsSingleStreamed = 0x01,	/*! Instrument provides a single audio stream for all notes */
 		IsMidiBased = 0x02,			/*! Instrument is controlled by MIDI events rather than NotePlayHandles */
 		IsNotBendable = 0x04,		/*! Instrument can't react to pitch bend changes */
+		RendersVoices = 0x08,		/*! Instrument can play all notes of a period at once in playVoices() */
 	};
 
 	Q_DECLARE_FLAGS(Flags, Flag);
@@ -77,6 +78,17 @@ public:
 	{
 	}
 
+	// instruments with the RendersVoices flag play all notes of a period
+	// here instead of each one in playNote() if the track doesn't shape
+	// the notes with envelopes or filters - the notes are added to the
+	// buffer with their volume and panning applied, starting at their
+	// offsets; a note may still be played with playNote() in any period
+	virtual void playVoices( NotePlayHandle * const * /* _notes */,
+					int /* _count */,
+					sampleFrame * /* _buffer */ )
+	{
+	}
+
 	// needed for deleting plugin-specific-data of a note - plugin has to
 	// cast void-ptr so that the plugin-data is deleted properly
 	// (call of dtor if it's a class etc.)
@@ -140,6 +152,12 @@ protected:
 	// desiredReleaseFrames() frames are left
 	void applyRelease( sampleFrame * buf, const NotePlayHandle * _n );
 
+	// the frame applyRelease() starts fading out at in this period, or
+	// the end of the period if the note doesn't fade out yet, and the
+	// level of the fade at a frame from then on
+	fpp_t releaseBegin( const NotePlayHandle * _n ) const;
+	float releaseLevel( const NotePlayHandle * _n, fpp_t _frame ) const;
+
 
 private:
 	InstrumentTrack * m_instrumentTrack;
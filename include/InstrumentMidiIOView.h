@@ -31,6 +31,7 @@
 #include "ModelView.h"
 
 
+class ComboBox;
 class GroupBox;
 class LcdSpinBox;
 class QToolButton;
@@ -77,9 +78,21 @@ public:
 		return m_pitchGroupBox;
 	}
 
+	LcdSpinBox * maxPolyphonySpinBox()
+	{
+		return m_maxPolyphonySpinBox;
+	}
+
+	ComboBox * voiceStealingComboBox()
+	{
+		return m_voiceStealingComboBox;
+	}
+
 private:
 
 	GroupBox * m_pitchGroupBox;
+	LcdSpinBox * m_maxPolyphonySpinBox;
+	ComboBox * m_voiceStealingComboBox;
 
 };
 
@@ -40,30 +40,7 @@ public:
 	}
 
 
-	void play( sampleFrame * _working_buffer ) override
-	{
-		// ensure that all our nph's have been processed first
-		ConstNotePlayHandleList nphv = NotePlayHandle::nphsOfInstrumentTrack( m_instrument->instrumentTrack(), true );
-		
-		bool nphsLeft;
-		do
-		{
-			nphsLeft = false;
-			for( const NotePlayHandle * constNotePlayHandle : nphv )
-			{
-				NotePlayHandle * notePlayHandle = const_cast<NotePlayHandle *>( constNotePlayHandle );
-				if( notePlayHandle->state() != ThreadableJob::ProcessingState::Done &&
-					!notePlayHandle->isFinished())
-				{
-					nphsLeft = true;
-					notePlayHandle->process();
-				}
-			}
-		}
-		while( nphsLeft );
-		
-		m_instrument->play( _working_buffer );
-	}
+	void play( sampleFrame * _working_buffer ) override;
 
 	bool isFinished() const override
 	{
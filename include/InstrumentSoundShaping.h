@@ -43,6 +43,23 @@ public:
 	void processAudioBuffer( sampleFrame * _ab, const fpp_t _frames,
 							NotePlayHandle * _n );
 
+	//! Whether the envelopes or the filter change the sound of the notes,
+	//! otherwise instruments can render them together, see
+	//! Instrument::playVoices()
+	bool shapesNotes() const;
+
+	//! Whether the filter of the notes can run in a BasicFilterBatch, in
+	//! which case InstrumentTrack defers the sound shaping of its notes
+	//! with scheduleNote() until all of them were rendered
+	bool filterBatchable() const;
+
+	//! Remembers the envelope position of the frames at
+	//! [_offset, _offset + _frames) of the note's buffer for processNotes()
+	void scheduleNote( NotePlayHandle * _n, const f_cnt_t _offset,
+							const fpp_t _frames );
+	//! Processes the notes scheduled in this period, in place
+	void processNotes( NotePlayHandle * const * _notes, int _count );
+
 	enum Targets
 	{
 		Volume,
@@ -66,6 +83,12 @@ public:
 
 
 private:
+	void envelopeFrames( NotePlayHandle * _n, const fpp_t _frames,
+				f_cnt_t * _total, f_cnt_t * _release_begin ) const;
+	void filterNotes( NotePlayHandle * const * _notes, int _count );
+	void applyVolumeEnvelope( sampleFrame * _ab, const fpp_t _frames,
+			const f_cnt_t _env_total, const f_cnt_t _env_release_begin );
+
 	EnvelopeAndLfoParameters * m_envLfoParameters[NumTargets];
 	InstrumentTrack * m_instrumentTrack;
 
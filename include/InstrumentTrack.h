@@ -26,10 +26,14 @@
 #ifndef INSTRUMENT_TRACK_H
 #define INSTRUMENT_TRACK_H
 
+#include <atomic>
+#include <vector>
+
 #include "AudioPort.h"
 #include "GroupBox.h"
 #include "InstrumentFunctions.h"
 #include "InstrumentSoundShaping.h"
+#include "LocklessList.h"
 #include "Midi.h"
 #include "MidiCCRackView.h"
 #include "MidiEventProcessor.h"
@@ -61,6 +65,7 @@ class LeftRightNav;
 class midiPortMenu;
 class DataFile;
 class PluginView;
+class SampleBuffer;
 class TabWidget;
 class TrackLabelButton;
 class LedCheckBox;
@@ -73,6 +78,15 @@ class LMMS_EXPORT InstrumentTrack : public Track, public MidiEventProcessor
 	MM_OPERATORS
 	mapPropertyFromModel(int,getVolume,setVolume,m_volumeModel);
 public:
+	enum VoiceStealingModes
+	{
+		StealOldest,
+		StealQuietest,
+		StealSameKey,		// retrigger a key that's still sounding,
+					// otherwise steal the oldest voice
+		NumVoiceStealingModes
+	} ;
+
 	InstrumentTrack( TrackContainer* tc );
 	virtual ~InstrumentTrack();
 
@@ -87,6 +101,18 @@ public:
 	// silence all running notes played by this track
 	void silenceAllNotes( bool removeIPH = false );
 
+	//! The volume of each channel a note is played with, which the track
+	//! applies to the notes it shapes
+	static stereoVolumeVector noteVolume( const NotePlayHandle * n );
+
+	//! Whether the instrument plays the notes of the track together in
+	//! Instrument::playVoices() rather than each one in its own buffer
+	bool playsVoices() const;
+
+	//! Steals voices so that @p newNote doesn't exceed the polyphony limit
+	//! of the track, called by the mixer when it starts playing a note
+	void limitPolyphony( NotePlayHandle * newNote );
+
 	bool isSustainPedalPressed() const
 	{
 		return m_sustainPedalPressed;
@@ -226,6 +252,44 @@ public:
 		return &m_effectChannelModel;
 	}
 
+	IntModel * maxPolyphonyModel()
+	{
+		return &m_maxPolyphonyModel;
+	}
+
+	ComboBoxModel * voiceStealingModel()
+	{
+		return &m_voiceStealingModel;
+	}
+
+	//! Master notes of the track that weren't released at the start of
+	//! the current period, in the order of the mixer's play handles. Only
+	//! valid while the mixer renders the notes.
+	const std::vector<const NotePlayHandle *> & activeNotes() const;
+
+	//! Play back @p file, a rendering of the track including its effects,
+	//! instead of the notes when playing the song, until something the
+	//! rendering depends on is changed. Returns false if it can't be loaded.
+	bool freeze( const QString & file );
+	void unfreeze( bool removeFile = true );
+
+	bool isFrozen() const
+	{
+		return m_frozenBuffer != nullptr;
+	}
+
+	//! Whether the instrument is suspended as the song is playing the
+	//! rendering of the track
+	bool playsFrozen() const;
+
+	//! Add @p frames frames of the rendering, from frame @p frame of the
+	//! song on, to the port at @p offset if the track plays frozen
+	void playFrozen( f_cnt_t frame, fpp_t frames, f_cnt_t offset );
+
+	//! Path in the data directory of the project for a new rendering of
+	//! the track to freeze it with
+	QString newFreezeFile() const;
+
 	void setPreviewMode( const bool );
 
 	bool isPreviewMode() const
@@ -237,10 +301,29 @@ public:
 
 	void autoAssignMidiDevice( bool );
 
+	//! A note played from MIDI input, captured for recording
+	struct RecordedNote
+	{
+		bool pressed;
+		int key;
+		volume_t volume;
+		panning_t panning;
+		//! whether the song played, and at which position in its play
+		//! mode, when the note was pressed or released
+		bool playing;
+		TimePos position;
+		//! how long the note played, for released notes
+		TimePos length;
+	} ;
+
+	//! Captures the notes played from MIDI input until turned off, which
+	//! drops the ones not taken yet
+	void setRecordingNotes( bool recording );
+	//! Takes the notes captured since the last call, oldest first
+	QVector<RecordedNote> takeRecordedNotes();
+
 signals:
 	void instrumentChanged();
-	void midiNoteOn( const Note& );
-	void midiNoteOff( const Note& );
 	void nameChanged();
 	void newNote();
 	void endNote();
@@ -260,11 +343,36 @@ protected slots:
 	void updatePitch();
 	void updatePitchRange();
 	void updateEffectChannel();
+	void freezeSourceChanged();
+	void unfreezeIfTempoAutomated();
+	void restoreFreeze();
 
 
 private:
 	void processCCEvent(int controller);
 
+	static void applyNoteVolume( sampleFrame * buf, const fpp_t frames, const NotePlayHandle * n );
+	//! Finishes the notes scheduled by processAudioBuffer(), called by the
+	//! audio port before it mixes the notes
+	void processScheduledNotes( const PlayHandleList & handles );
+	//! Lets the instrument add the notes played as voices in this period
+	//! to @p buffer, returns whether there were any
+	bool renderVoices( const PlayHandleList & handles, sampleFrame * buffer );
+
+	//! Handles @p event right away, which processInEvent() leaves to the
+	//! audio thread for events from MIDI devices
+	void playInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset );
+	//! Plays the events queued since the last period at the offsets they
+	//! came in at, called by the mixer at the beginning of a period
+	void processQueuedInEvents();
+
+	//! Captures @p note as it is pressed or released, without locking or
+	//! allocating as this is usually done on the audio thread
+	void recordNote( bool pressed, const NotePlayHandle & note );
+
+	//! Unfreeze the track when a model of @p object is edited
+	void watchFreezeSource( QObject * object );
+
 	MidiPort m_midiPort;
 
 	NotePlayHandle* m_notes[NumKeys];
@@ -273,6 +381,25 @@ private:
 	int m_runningMidiNotes[NumKeys];
 	QMutex m_midiNotesMutex;
 
+	// events from MIDI devices, which are played one period after they
+	// came in so their distances are kept regardless of the period size
+	struct QueuedInEvent
+	{
+		MidiEvent event;
+		TimePos time;
+		f_cnt_t offset;
+		qint64 arrival;	// in nanoseconds of a steady clock
+	} ;
+	static const int MaxQueuedInEvents = 512;
+	LocklessList<QueuedInEvent> m_queuedInEvents;
+	std::atomic<bool> m_inEventsScheduled;
+	std::vector<QueuedInEvent> m_inEventsToPlay;
+
+	// notes played from MIDI input, taken by the piano roll in batches
+	static const int MaxRecordedNotes = 512;
+	std::atomic<bool> m_recordingNotes;
+	LocklessList<RecordedNote> m_recordedNotes;
+
 	bool m_sustainPedalPressed;
 
 	bool m_silentBuffersProcessed;
@@ -288,6 +415,11 @@ private:
 
 	NotePlayHandleList m_processHandles;
 
+	// collected by the mixer in Mixer::updateActiveNotes(), outdated if
+	// m_activeNotesPeriod isn't the mixer's current one
+	std::vector<const NotePlayHandle *> m_activeNotes;
+	unsigned int m_activeNotesPeriod;
+
 	FloatModel m_volumeModel;
 	FloatModel m_panningModel;
 
@@ -297,6 +429,8 @@ private:
 	IntModel m_pitchRangeModel;
 	IntModel m_effectChannelModel;
 	BoolModel m_useMasterPitchModel;
+	IntModel m_maxPolyphonyModel;		//!< Maximum number of voices, 0 = unlimited
+	ComboBoxModel m_voiceStealingModel;
 
 	Instrument * m_instrument;
 	InstrumentSoundShaping m_soundShaping;
@@ -308,11 +442,18 @@ private:
 	std::unique_ptr<BoolModel> m_midiCCEnable;
 	std::unique_ptr<FloatModel> m_midiCCModel[MidiControllerCount];
 
+	SampleBuffer * m_frozenBuffer;
+	QString m_frozenFile;
+	// file of a frozen track to load when the project is loaded
+	QString m_pendingFreezeFile;
+	QList<QMetaObject::Connection> m_freezeConnections;
+
 	friend class InstrumentTrackView;
 	friend class InstrumentTrackWindow;
 	friend class NotePlayHandle;
 	friend class InstrumentMiscView;
 	friend class MidiCCRackView;
+	friend class Mixer;
 
 } ;
 
@@ -367,6 +508,8 @@ private slots:
 	void assignFxLine( int channelIndex );
 	void createFxLine();
 
+	void toggleFreeze();
+
 	void handleConfigChange(QString cls, QString attr, QString value);
 
 
@@ -144,14 +144,11 @@ protected:
 
 private slots:
 	virtual void enterValue();
-	void friendlyUpdate();
 	void toggleScale();
 
 private:
 	virtual QString displayValue() const;
 
-	void doConnections() override;
-
 	QLineF calculateLine( const QPointF & _mid, float _radius,
 						float _innerRadius = 1) const;
 
@@ -70,7 +70,11 @@ typedef struct PortDescription
 	//! This is true iff ladspa suggests logscale
 	//! Note however that the model can still decide to use a linear scale
 	bool suggests_logscale;
+	//! What the port is connected to, which may change between periods
 	LADSPA_Data * buffer;
+	//! Whether buffer holds value, so it only has to be written again
+	//! when the value changes
+	bool holdsValue;
 	LadspaControl * control;
 } port_desc_t;
 
@@ -39,6 +39,8 @@
 #include "lmms_export.h"
 #include "lmms_basics.h"
 
+class QDataStream;
+
 
 const float NOHINT = -99342.2243f;
 
@@ -72,11 +74,16 @@ enum ladspaPluginType
 
 typedef struct ladspaManagerStorage
 {
+	// NULL until the library is loaded by getDescriptor()
 	LADSPA_Descriptor_Function descriptorFunction;
 	uint32_t index;
 	ladspaPluginType type;
 	uint16_t inputChannels;
 	uint16_t outputChannels;
+	// taken from the index of plug-ins, so the library needn't be loaded
+	QString library;
+	QString name;
+	LADSPA_Properties properties;
 } ladspaManagerDescription;
 
 
@@ -329,8 +336,19 @@ public:
 						LADSPA_Handle _instance );
 
 private:
-	void  addPlugins( LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file );
+	struct IndexedPlugin;
+	typedef QList<IndexedPlugin> IndexedPlugins;
+	friend QDataStream & operator<<( QDataStream & _stream,
+					const IndexedPlugin & _plugin );
+	friend QDataStream & operator>>( QDataStream & _stream,
+					IndexedPlugin & _plugin );
+
+	IndexedPlugins  describePlugins(
+				LADSPA_Descriptor_Function _descriptor_func );
+	void  addPlugins( const IndexedPlugins & _plugins,
+				const QString & _file, const QString & _library,
+				LADSPA_Descriptor_Function _descriptor_func );
+	bool  loadLibrary( const QString & _library );
 	uint16_t  getPluginInputs( const LADSPA_Descriptor * _descriptor );
 	uint16_t  getPluginOutputs( const LADSPA_Descriptor * _descriptor );
 
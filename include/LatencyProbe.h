@@ -0,0 +1,122 @@
+/*
+ * LatencyProbe.h - measures the round-trip latency of the audio device
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+#include <atomic>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+//! Measures the round-trip latency by sending an impulse to the output of
+//! the audio device and waiting for it to come back on the capture path,
+//! e.g. through a loopback cable.
+//!
+//! The latency is counted in captured frames, from the start of the period
+//! the impulse was rendered in. That is how much later a recorded take
+//! arrives than the song position it was played to, so the result is kept
+//! for SampleRecordHandle to compensate.
+//!
+//! process() runs on the mixer thread and only touches atomics; the
+//! result is picked up by a timer on the thread the probe lives in.
+class LMMS_EXPORT LatencyProbe : public QObject
+{
+	Q_OBJECT
+public:
+	enum States
+	{
+		Idle,
+		Listening,	// measuring the noise floor
+		Waiting,	// the impulse has been sent
+		Finished,
+		Failed
+	} ;
+
+	LatencyProbe();
+	virtual ~LatencyProbe();
+
+	//! Starts a measurement, the device has to support capturing
+	void start( sample_rate_t inputSampleRate );
+
+	bool isRunning() const
+	{
+		const int state = m_state.load( std::memory_order_relaxed );
+		return state == Listening || state == Waiting;
+	}
+
+	//! The round trip of the last successful measurement in captured
+	//! frames, or -1
+	f_cnt_t measuredFrames() const
+	{
+		return m_measuredFrames;
+	}
+
+	//! The round trip of the last successful measurement in ms, or -1
+	float measuredLatency() const;
+
+	//! The round trip recorded takes are compensated for, in ms
+	static float recordLatency();
+
+	//! Called by the mixer thread after the master mix
+	void process( surroundSampleFrame * output, fpp_t frames,
+				const sampleFrame * input, f_cnt_t inputFrames );
+
+	// the noise floor is measured for this long before sending the impulse
+	static const int ListenMs = 250;
+	// give up if the impulse doesn't come back within this time
+	static const int TimeoutMs = 2000;
+
+
+signals:
+	//! Emitted when a measurement finished or failed
+	void measured( bool success );
+
+
+private slots:
+	void checkState();
+
+
+private:
+	static const int ImpulseFrames = 4;
+
+	std::atomic<int> m_state;
+	sample_rate_t m_inputSampleRate;
+	// captured frames since the state was entered
+	f_cnt_t m_elapsed;
+	float m_noisePeak;
+	std::atomic<f_cnt_t> m_result;
+
+	f_cnt_t m_measuredFrames;
+	QTimer m_timer;
+
+} ;
+
+
+#endif
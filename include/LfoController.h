@@ -73,7 +73,7 @@ protected:
 	float m_phaseOffset;
 	float m_currentPhase;
 
-	sample_t (*m_sampleFunction)( const float );
+	Oscillator::WaveShapes m_waveShape;
 
 private:
 	SampleBuffer * m_userDefSampleBuffer;
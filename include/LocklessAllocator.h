@@ -27,26 +27,86 @@
 
 #include <atomic>
 #include <stddef.h>
+#include <stdint.h>
 
+#include "IndexedPool.h"
+
+/**
+	Allocates elements of a fixed size from segments of @p nmemb elements.
+
+	Free elements are kept in a lock-free list, so alloc() and free() are
+	O(1). When the list is empty, alloc() adds another segment. Segments
+	are only freed with the allocator, so elements never move. tryAlloc()
+	never adds a segment, for callers which must not allocate memory.
+*/
 class LocklessAllocator
 {
 public:
+	//! Elements of all allocators
+	struct Usage
+	{
+		int64_t capacity;
+		int64_t inUse;
+		//! segments added after construction
+		int segmentsAdded;
+		//! allocations that failed, because tryAlloc() found no free
+		//! element or the segments ran out
+		int failures;
+	} ;
+
+	//! How many segments an allocator can have
+	static const int MaxSegments = 64;
+
 	LocklessAllocator( size_t nmemb, size_t size );
 	virtual ~LocklessAllocator();
 	void * alloc();
+	void * tryAlloc();
 	void free( void * ptr );
 
+	size_t capacity() const;
+	size_t inUse() const;
+
+	static Usage usage();
+
 
 private:
-	char * m_pool;
-	size_t m_capacity;
+	//! Precedes every element
+	struct Header
+	{
+		uint32_t index;
+		//! index + 1 of the next free element, InUse while allocated
+		std::atomic<uint32_t> next;
+	} ;
+
+	static const uint32_t InUse = 0xFFFFFFFF;
+
+	Header * header( uint32_t index ) const;
+	//! The links of m_free
+	auto nextOf() const
+	{
+		return [this]( uint32_t index ) -> std::atomic<uint32_t> &
+		{
+			return header( index )->next;
+		};
+	}
+	//! Pushes the linked elements from @p first to @p last
+	void pushFree( uint32_t first, uint32_t last );
+	//! Pops a free element, returns InUse if there is none
+	uint32_t popFree();
+	//! Adds a segment unless another thread is adding one, returns false
+	//! if there can't be more
+	bool grow();
+
+	size_t m_segmentSize;
 	size_t m_elementSize;
 
-	std::atomic_int * m_freeState;
-	size_t m_freeStateSets;
+	std::atomic<char *> m_segments[MaxSegments];
+	std::atomic_int m_segmentCount;
+	std::atomic_flag m_growing;
 
-	std::atomic_int m_available;
-	std::atomic_int m_startIndex;
+	//! linked through Header::next
+	IndexStack m_free;
+	std::atomic<size_t> m_inUse;
 
 } ;
 
@@ -71,11 +131,19 @@ public:
 		return (T *)LocklessAllocator::alloc();
 	}
 
+	T * tryAlloc()
+	{
+		return (T *)LocklessAllocator::tryAlloc();
+	}
+
 	void free( T * ptr )
 	{
 		LocklessAllocator::free( ptr );
 	}
 
+	using LocklessAllocator::capacity;
+	using LocklessAllocator::inUse;
+
 } ;
 
 
@@ -0,0 +1,83 @@
+/*
+ * LocklessCommandQueue.h - queue of closures with lockless posting and
+ *                          processing
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LOCKLESS_COMMAND_QUEUE_H
+#define LOCKLESS_COMMAND_QUEUE_H
+
+#include <atomic>
+#include <functional>
+
+#include "lmms_export.h"
+
+//! Multi-producer, single-consumer queue of commands.
+//!
+//! Any thread may post commands, one thread at a time processes them in
+//! posting order without taking a lock or touching the heap. Every command
+//! may come with a cleanup function, which is run by the next call of
+//! reclaim() once the command has been processed - this way, objects a
+//! command removed from the consumer's data can be deleted outside the
+//! consumer thread.
+class LMMS_EXPORT LocklessCommandQueue
+{
+public:
+	typedef std::function<void()> Command;
+
+	LocklessCommandQueue();
+	~LocklessCommandQueue();
+
+	//! Post a command, also reclaims processed commands. Not realtime safe.
+	void post( Command command, Command cleanup = nullptr );
+
+	//! Run all pending commands. Realtime safe, as long as the commands are.
+	//! @return Number of commands run
+	int process();
+
+	//! Run the cleanup functions of processed commands and free them.
+	//! Must not be called from the consumer thread.
+	void reclaim();
+
+	bool hasPending() const
+	{
+		return m_pending.load( std::memory_order_relaxed ) != nullptr;
+	}
+
+
+private:
+	struct Node
+	{
+		Command command;
+		Command cleanup;
+		Node * next;
+	} ;
+
+	static void push( std::atomic<Node *> & list, Node * first, Node * last );
+
+	std::atomic<Node *> m_pending;
+	std::atomic<Node *> m_processed;
+
+} ;
+
+
+#endif
@@ -50,18 +50,23 @@ public:
 		delete m_allocator;
 	}
 
+	//! Grows the list if all elements are in use, which allocates memory
 	void push( T value )
 	{
-		Element * e = m_allocator->alloc();
-		e->value = value;
-		e->next = m_first.load(std::memory_order_relaxed);
+		link( m_allocator->alloc(), value );
+	}
 
-		while (!m_first.compare_exchange_weak(e->next, e,
-				std::memory_order_release,
-				std::memory_order_relaxed))
+	//! Like push(), but returns false instead of growing the list when all
+	//! elements are in use, so it never allocates memory
+	bool tryPush( T value )
+	{
+		Element * e = m_allocator->tryAlloc();
+		if( e == nullptr )
 		{
-			// Empty loop (compare_exchange_weak updates e->next)
+			return false;
 		}
+		link( e, value );
+		return true;
 	}
 
 	Element * popList()
@@ -84,8 +89,32 @@ public:
 		m_allocator->free( e );
 	}
 
+	size_t capacity() const
+	{
+		return m_allocator->capacity();
+	}
+
+	size_t size() const
+	{
+		return m_allocator->inUse();
+	}
+
 
 private:
+	void link( Element * e, T value )
+	{
+		e->value = value;
+		e->next = m_first.load(std::memory_order_relaxed);
+
+		while (!m_first.compare_exchange_weak(e->next, e,
+				std::memory_order_release,
+				std::memory_order_relaxed))
+		{
+			// Empty loop (compare_exchange_weak updates e->next)
+		}
+	}
+
+
 	std::atomic<Element*> m_first;
 	LocklessAllocatorT<Element> * m_allocator;
 
@@ -29,11 +29,16 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <array>
 #include <lilv/lilv.h>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
 
 #include "DataFile.h"
 #include "LinkedModelGroups.h"
 #include "lmms_export.h"
+#include "Note.h"
 #include "Plugin.h"
 
 class Lv2Proc;
@@ -80,6 +85,14 @@ public:
 	bool hasGui() const { return m_hasGUI; }
 	void setHasGui(bool val) { m_hasGUI = val; }
 
+	//! The highest latency any of the processors reports
+	f_cnt_t latency() const;
+
+	//! Upper bound for setVoices()
+	static constexpr std::size_t maxVoices() { return 16; }
+	//! Number of plugin instances notes are distributed across
+	std::size_t voices() const { return m_procs.size() / m_procsPerVoice; }
+
 protected:
 	/*
 		ctor/dtor
@@ -115,7 +128,8 @@ protected:
 	void copyBuffersFromLmms(const sampleFrame *buf, fpp_t frames);
 	//! Copy our ports into buffers passed by LMMS
 	void copyBuffersToLmms(sampleFrame *buf, fpp_t frames) const;
-	//! Run the Lv2 plugin instance for @param frames frames
+	//! Run the Lv2 plugin instance for @param frames frames. Processors
+	//! which take long enough are run in parallel on the worker threads.
 	void run(fpp_t frames);
 
 	/*
@@ -127,6 +141,16 @@ protected:
 	//! TODO: not implemented
 	void reloadPlugin();
 
+	/*
+		voices
+	*/
+	//! Instantiate the plugin @p voices times, each instance having the
+	//! processors of one stereo stream. Notes are distributed across the
+	//! instances, which are run in parallel and mixed, so monophonic plugins
+	//! become polyphonic and heavy ones use several cores. All instances
+	//! share the same control values. Must be called from the GUI thread.
+	void setVoices(std::size_t voices);
+
 	/*
 		more functions that must be called from virtuals
 	*/
@@ -137,6 +161,12 @@ protected:
 		const class TimePos &time, f_cnt_t offset);
 
 private:
+	//! A processor run by a worker thread
+	class ProcJob;
+	//! Run time of one processor, below which running them in parallel
+	//! costs more than it saves
+	static constexpr float parallelMicros() { return 50.f; }
+
 	//! Return the DataFile settings type
 	virtual DataFile::Types settingsType() = 0;
 	//! Inform the plugin about a file name change
@@ -146,6 +176,34 @@ private:
 	//! If this is a mono effect, the vector will have size 2 in order to
 	//! fulfill LMMS' requirement of having stereo input and output
 	std::vector<std::unique_ptr<Lv2Proc>> m_procs;
+	//! jobs for all processors but the first, which runs on the calling
+	//! thread
+	std::vector<std::unique_ptr<ProcJob>> m_procJobs;
+	//! how long one processor took to run recently, smoothed
+	float m_runMicros = 0.f;
+
+	//! Processors making one stereo stream, 1 or 2
+	std::size_t m_procsPerVoice = 1;
+	//! Voices except the first one render here before being mixed
+	mutable std::vector<sampleFrame> m_voiceBuffer;
+	//! The voice playing each key, or -1
+	std::array<int, NumKeys> m_keyVoice;
+	//! Number of keys each voice plays
+	std::vector<int> m_voiceNotes;
+	//! The voice the last note went to, next ones go round-robin
+	std::size_t m_lastVoice = 0;
+	//! Guards the voice allocation, as MIDI comes from several threads
+	QMutex m_voiceMutex;
+	Model* m_that;
+
+	//! The state a processor saved last, and its base64 encoding, which
+	//! is reused as long as the state does not change
+	struct SavedState
+	{
+		QByteArray state;
+		QString base64;
+	};
+	std::vector<SavedState> m_savedStates;
 
 	bool m_valid = true;
 	bool m_hasGUI = false;
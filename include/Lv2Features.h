@@ -42,7 +42,8 @@
 	The public member functions should be called in descending order:
 
 	1. initCommon: map plugin-common features
-	2. operator[]: map plugin-specific features
+	2. operator[]: map plugin-specific features, features left unmapped
+		are not passed to the plugin
 	3. createFeatureVectors: create the feature vectors required for
 		lilv_plugin_instantiate
 	4. access the latter
@@ -31,12 +31,15 @@
 
 #include <map>
 #include <set>
+#include <vector>
 #include <lilv/lilv.h>
+#include <QString>
 
 #include "Lv2Basics.h"
 #include "Lv2UridCache.h"
 #include "Lv2UridMap.h"
 #include "Plugin.h"
+#include "PluginIssue.h"
 
 
 /*
@@ -74,6 +77,10 @@
 
 
 //! Class to keep track of all LV2 plugins
+//!
+//! The result of checking all plugins is kept in an index file, which
+//! is used as long as no bundle has changed. Then, the bundle of a plugin
+//! is only loaded when the plugin is first used.
 class Lv2Manager
 {
 public:
@@ -92,25 +99,39 @@ public:
 		//! use only for std::map internals
 		Lv2Info() : m_plugin(nullptr) {}
 		//! ctor used inside Lv2Manager
-		Lv2Info(const LilvPlugin* plug, Plugin::PluginTypes type, bool valid) :
-			m_plugin(plug), m_type(type), m_valid(valid) {}
+		Lv2Info(const LilvPlugin* plug, Plugin::PluginTypes type,
+			std::vector<PluginIssue> issues, QString name,
+			std::string bundle) :
+			m_plugin(plug), m_type(type), m_issues(std::move(issues)),
+			m_name(std::move(name)), m_bundle(std::move(bundle)) {}
 		Lv2Info(Lv2Info&& other) = default;
 		Lv2Info& operator=(Lv2Info&& other) = default;
 
+		//! nullptr if the plugin's bundle has not been loaded yet
 		const LilvPlugin* plugin() const { return m_plugin; }
 		Plugin::PluginTypes type() const { return m_type; }
-		bool isValid() const { return m_valid; }
+		bool isValid() const { return m_issues.empty(); }
+		const std::vector<PluginIssue>& issues() const { return m_issues; }
+		const QString& name() const { return m_name; }
+		//! URI of the bundle the plugin is in
+		const std::string& bundle() const { return m_bundle; }
 
 	private:
+		friend class Lv2Manager;
+
 		const LilvPlugin* m_plugin;
 		Plugin::PluginTypes m_type;
-		bool m_valid = false;
+		std::vector<PluginIssue> m_issues;
+		QString m_name;
+		std::string m_bundle;
 	};
 
 	//! Return descriptor with URI @p uri or nullptr if none exists
 	const LilvPlugin *getPlugin(const std::string &uri);
 	//! Return descriptor with URI @p uri or nullptr if none exists
 	const LilvPlugin *getPlugin(const QString& uri);
+	//! Return name of plugin with URI @p uri, without loading its bundle
+	QString pluginName(const QString& uri) const;
 
 	using Lv2InfoMap = std::map<std::string, Lv2Info>;
 	using Iterator = Lv2InfoMap::iterator;
@@ -156,6 +177,16 @@ private:
 
 	// functions
 	bool isSubclassOf(const LilvPluginClass *clvss, const char *uriStr);
+	//! Load and check all plugins
+	void checkAllPlugins();
+	//! Fill m_lv2InfoMap from the index, if @p bundles are up to date
+	bool readIndex(const QByteArray& bundles);
+	void writeIndex(const QByteArray& bundles) const;
+	//! Load @p bundle and the plugins in it, if not done yet
+	void loadBundle(const std::string& bundle);
+
+	std::set<std::string> m_loadedBundles;
+	bool m_loadedAll = false;
 };
 
 #endif // LMMS_HAVE_LV2
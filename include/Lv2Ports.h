@@ -188,6 +188,15 @@ struct Audio : public VisitablePort<Audio, PortBase>
 	//! @param channel channel index into each sample frame
 	void copyBuffersToCore(sampleFrame *lmmsBuf,
 		unsigned channel, fpp_t frames) const;
+	//! Copy two channels passed by LMMS into two ports in one pass
+	//! @param firstChan channel index of @p left into each sample frame
+	static void copyStereoFromCore(const sampleFrame *lmmsBuf,
+		unsigned firstChan, Audio& left, Audio& right, fpp_t frames);
+	//! Copy two ports into two channels passed by LMMS in one pass
+	//! @param firstChan channel index of @p left into each sample frame
+	static void copyStereoToCore(sampleFrame *lmmsBuf,
+		unsigned firstChan, const Audio& left, const Audio& right,
+		fpp_t frames);
 
 	bool isSideChain() const { return m_sidechain; }
 	bool isOptional() const { return m_optional; }
@@ -30,12 +30,15 @@
 #ifdef LMMS_HAVE_LV2
 
 #include <lilv/lilv.h>
+#include <lv2/lv2plug.in/ns/ext/state/state.h>
 #include <memory>
+#include <QByteArray>
 #include <QObject>
 
 #include "Lv2Basics.h"
 #include "Lv2Features.h"
 #include "Lv2Options.h"
+#include "Lv2Worker.h"
 #include "LinkedModelGroups.h"
 #include "MidiEvent.h"
 #include "Plugin.h"
@@ -111,7 +114,8 @@ public:
 		utils for the run thread
 	*/
 	//! Copy values from the LMMS core (connected models, MIDI events, ...) into
-	//! the respective ports
+	//! the respective ports. Controls are only copied if their model changed
+	//! since the last call.
 	void copyModelsFromCore();
 	//! Bring values from all ports to the LMMS core
 	void copyModelsToCore();
@@ -141,18 +145,35 @@ public:
 	 */
 	void copyBuffersToCore(sampleFrame *buf, unsigned firstChan, unsigned num,
 								fpp_t frames) const;
-	//! Run the Lv2 plugin instance for @param frames frames
+	//! Run the Lv2 plugin instance for @param frames frames, delivering the
+	//! responses of work finished since the last run first
 	void run(fpp_t frames);
 
 	void handleMidiInputEvent(const class MidiEvent &event,
 		const TimePos &time, f_cnt_t offset);
 
+	/*
+		state
+	*/
+	//! Capture the plugin's internal state, if it implements the state
+	//! interface, or return an empty array. May be called while the plugin
+	//! runs.
+	QByteArray saveState();
+	//! Restore a state returned by saveState(). The plugin must not run
+	//! meanwhile.
+	void restoreState(const QByteArray& state);
+
 	/*
 		misc
 	 */
 	class AutomatableModel *modelAtPort(const QString &uri); // unused currently
 	std::size_t controlCount() const { return LinkedModelGroup::modelNum(); }
 	bool hasNoteInput() const;
+	//! The latency the plugin reports on its latency port, in frames
+	f_cnt_t latency() const
+	{
+		return m_latencyPort ? static_cast<f_cnt_t>(m_latencyPort->m_val) : 0;
+	}
 
 protected:
 	/*
@@ -170,12 +191,17 @@ private:
 	LilvInstance* m_instance;
 	Lv2Features m_features;
 	Lv2Options m_options;
+	//! only for plugins implementing the worker interface
+	std::unique_ptr<Lv2Worker> m_worker;
 
 	// full list of ports
 	std::vector<std::unique_ptr<Lv2Ports::PortBase>> m_ports;
 	// quick reference to specific, unique ports
 	StereoPortRef m_inPorts, m_outPorts;
 	Lv2Ports::AtomSeq *m_midiIn = nullptr, *m_midiOut = nullptr;
+	Lv2Ports::Control *m_latencyPort = nullptr;
+	//! whether copyModelsFromCore() has set all input ports once
+	bool m_portsInitialized = false;
 
 	// MIDI
 	// many things here may be moved into the `Instrument` class
@@ -194,6 +220,8 @@ private:
 	//! models for the controls, sorted by port symbols
 	std::map<std::string, AutomatableModel *> m_connectedModels;
 
+	const LV2_State_Interface* stateInterface() const;
+
 	void initMOptions(); //!< initialize m_options
 	void initPluginSpecificFeatures();
 
@@ -0,0 +1,124 @@
+/*
+ * Lv2Worker.h - Lv2 worker extension, run by threads shared by all plugins
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LV2WORKER_H
+#define LV2WORKER_H
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_HAVE_LV2
+
+#include <atomic>
+#include <cstdint>
+#include <lilv/lilv.h>
+#include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+#include <QMutex>
+#include <QWaitCondition>
+#include <vector>
+
+#include "../src/3rdparty/ringbuffer/include/ringbuffer/ringbuffer.h"
+
+class QThread;
+
+/**
+	Worker of one Lv2 processor
+
+	Implements the schedule feature of the Lv2 worker extension. Work
+	scheduled in run() is passed through a lock-free ring to a small pool of
+	threads shared by all processors, which call the plugin's work() function.
+	Its responses are passed back through a second ring and delivered to the
+	plugin at the start of the next run(), on the audio thread.
+
+	The work of one processor is done in the order it was scheduled, and
+	never on two threads at once.
+*/
+class Lv2Worker
+{
+public:
+	//! Size of each ring in bytes, which limits the size of a message
+	static constexpr std::size_t ringSize() { return 1 << 14; }
+
+	Lv2Worker();
+	//! Waits for running work, no work is started after
+	~Lv2Worker();
+
+	//! The schedule feature, to be passed on instantiation
+	LV2_Worker_Schedule* feature() { return &m_schedule; }
+
+	//! Starts doing the work @p instance schedules, once it is instantiated.
+	//! Does nothing if the plugin does not implement the worker interface.
+	void start(LilvInstance* instance);
+
+	//! Delivers the responses of finished work, realtime safe
+	void deliverResponses();
+	//! Tells the plugin that run() is done, realtime safe
+	void endRun();
+
+private:
+	class Thread;
+
+	static LV2_Worker_Status scheduleWork(LV2_Worker_Schedule_Handle handle,
+		uint32_t size, const void* data);
+	static LV2_Worker_Status respond(LV2_Worker_Respond_Handle handle,
+		uint32_t size, const void* data);
+
+	//! Does all work waiting, on a pool thread
+	void work();
+
+	static void addWorker(Lv2Worker* worker);
+	static void removeWorker(Lv2Worker* worker);
+	static void threadLoop(int generation);
+
+	LV2_Worker_Schedule m_schedule;
+	const LV2_Worker_Interface* m_interface = nullptr;
+	LV2_Handle m_handle = nullptr;
+
+	//! audio thread -> pool
+	ringbuffer_t<char> m_requests;
+	ringbuffer_reader_t<char> m_requestReader;
+	//! pool -> audio thread
+	ringbuffer_t<char> m_responses;
+	ringbuffer_reader_t<char> m_responseReader;
+	//! message bodies read from the rings, one for each side
+	std::vector<char> m_request;
+	std::vector<char> m_response;
+	//! messages written to the rings, one for each side
+	std::vector<char> m_scheduleBuffer;
+	std::vector<char> m_respondBuffer;
+
+	std::atomic<bool> m_pending;
+	bool m_running = false; // guarded by s_mutex
+
+	static QMutex s_mutex;
+	static QWaitCondition s_workDone;
+	static QWaitCondition s_wake;
+	static std::vector<Lv2Worker*> s_workers;
+	static std::vector<QThread*> s_threads;
+	//! bumped to stop the current threads
+	static int s_generation;
+};
+
+#endif // LMMS_HAVE_LV2
+
+#endif // LV2WORKER_H
@@ -167,6 +167,8 @@ public slots:
 
 private slots:
 	void onExportProjectMidi();
+	void updateSampleCompressionAction();
+	void setSampleCompression( bool enabled );
 
 protected:
 	void closeEvent( QCloseEvent * _ce ) override;
@@ -212,6 +214,7 @@ private:
 	QMenu * m_toolsMenu;
 	QAction * m_undoAction;
 	QAction * m_redoAction;
+	QAction * m_sampleCompressionAction;
 	QList<PluginView *> m_tools;
 
 	QBasicTimer m_updateTimer;
@@ -0,0 +1,119 @@
+/*
+ * MemoryUsage.h - where the memory of a project goes
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "lmms_export.h"
+
+
+/*! \brief The memory held by the tracks, FX channels and subsystems of the
+ *  project, for the memory statistics.
+ *
+ *  collect() asks the objects of the song for the memory they hold: the
+ *  frames of the sample buffers, what plugins report by
+ *  Plugin::memoryUsage() plus the resident memory of their processes, the
+ *  undo history and the caches the GUI registers. It's an estimate of the
+ *  big allocations rather than an exact count, frames shared by several
+ *  buffers are split among them.
+ *
+ *  collect() has to be called from the GUI thread, or the main thread when
+ *  there is no GUI, as it walks the tracks.
+ */
+class LMMS_EXPORT MemoryUsage
+{
+public:
+	enum Subsystems
+	{
+		Samples,
+		Instruments,
+		Effects,
+		Journal,
+		GuiCaches,
+		NumSubsystems
+	} ;
+
+	//! The memory of a track or FX channel by subsystem
+	struct Entry
+	{
+		Entry(const QString & name = QString());
+
+		qint64 total() const;
+
+		QString name;
+		qint64 bytes[NumSubsystems];
+	} ;
+
+	struct Report
+	{
+		//! The totals, including what doesn't belong to a track
+		Entry subsystems;
+		std::vector<Entry> tracks;
+		std::vector<Entry> fxChannels;
+		//! The caches registered by Cache
+		std::vector<std::pair<QString, qint64>> caches;
+
+		//! Bytes by subsystem name, and the tracks and FX channels which
+		//! hold any memory
+		QJsonObject toJson() const;
+	} ;
+
+	//! Registers a cache of the GUI, e.g. a pixmap of an editor, for as
+	//! long as it exists
+	class Cache
+	{
+	public:
+		Cache(const QString & name, const std::function<qint64()> & bytes);
+		~Cache();
+
+		Cache(const Cache &) = delete;
+		Cache & operator=(const Cache &) = delete;
+
+	private:
+		QString m_name;
+		std::function<qint64()> m_bytes;
+
+		friend class MemoryUsage;
+	} ;
+
+	static Report collect();
+
+	//! The name used in reports, e.g. "samples"
+	static QString subsystemName(Subsystems subsystem);
+
+	static QString megabytes(qint64 bytes)
+	{
+		return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+	}
+} ;
+
+
+#endif
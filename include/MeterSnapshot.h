@@ -0,0 +1,86 @@
+/*
+ * MeterSnapshot.h - hands the peaks of all mixer channels to the GUI
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef METER_SNAPSHOT_H
+#define METER_SNAPSHOT_H
+
+#include <atomic>
+#include <vector>
+
+#include "lmms_export.h"
+
+
+/*! \brief Passes the peaks of all meters from the audio thread to the GUI
+ *
+ *  The audio thread writes the peaks of each meter once per period and
+ *  publishes them all at once. Until the GUI has taken the last snapshot,
+ *  the peaks of further periods are raised in the next one instead, so no
+ *  peak gets lost between two GUI updates. The snapshots are triple
+ *  buffered like those of VisualizationTap, so neither side ever waits.
+ */
+class LMMS_EXPORT MeterSnapshot
+{
+public:
+	struct Meter
+	{
+		float peakLeft;
+		float peakRight;
+		bool sleeping;
+	} ;
+
+	typedef std::vector<Meter> Snapshot;
+
+	MeterSnapshot();
+
+	//! Changes the number of meters. Neither write nor read may run
+	//! meanwhile, i.e. the mixer has to be locked and it must be called
+	//! from the GUI thread.
+	void resize(int meters);
+
+	//! Starts writing the next snapshot, realtime safe
+	void beginWrite();
+	//! Raises the peaks of @p meter, realtime safe
+	void write(int meter, float peakLeft, float peakRight, bool sleeping);
+	//! Publishes the snapshot, unless the last one wasn't read yet
+	void publish();
+
+	//! The newest snapshot, or nullptr if nothing was published since the
+	//! last call. It stays valid until the next call.
+	const Snapshot * read();
+
+private:
+	static const int FreshBit = 4;
+
+	Snapshot m_slots[3];
+	int m_back;
+	// whether the back slot holds peaks not yet published
+	bool m_backFilled;
+	// index of the slot between writer and reader, plus FreshBit if the
+	// writer has put a snapshot there the reader hasn't taken yet
+	std::atomic<int> m_middle;
+	int m_front;
+} ;
+
+
+#endif
@@ -67,6 +67,7 @@ public:
 
 	virtual void processOutEvent( const MidiEvent & _me,
 						const TimePos & _time,
+						f_cnt_t _offset,
 						const MidiPort * _port ) override;
 
 	void applyPortMode( MidiPort * _port ) override;
@@ -61,6 +61,7 @@ public:
 	
 	virtual void processOutEvent( const MidiEvent & _me,
 								const TimePos & _time,
+								f_cnt_t _offset,
 								const MidiPort * _port );
 	
 	virtual void applyPortMode( MidiPort * _port );
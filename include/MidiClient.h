@@ -25,6 +25,7 @@
 #ifndef MIDI_CLIENT_H
 #define MIDI_CLIENT_H
 
+#include <atomic>
 #include <QtCore/QStringList>
 #include <QtCore/QVector>
 
@@ -44,11 +45,18 @@ public:
 	MidiClient();
 	virtual ~MidiClient();
 
-	// to be implemented by sub-classes
+	// to be implemented by sub-classes, _offset is the frame within the
+	// current period at which the event is due
 	virtual void processOutEvent( const MidiEvent & _me,
 						const TimePos & _time,
+						f_cnt_t _offset,
 						const MidiPort * _port ) = 0;
 
+	// sends a system message which doesn't belong to a port, e.g. MIDI
+	// clock, from the render thread. By default it goes out through every
+	// port with output enabled, clients with a single output send it once.
+	virtual void processOutSync( const MidiEvent & _me, f_cnt_t _offset );
+
 	// inheriting classes can re-implement this for being able to update
 	// their internal port-structures etc.
 	virtual void applyPortMode( MidiPort * _port );
@@ -107,8 +115,31 @@ public:
 	static MidiClient * openMidiClient();
 
 protected:
+	// calls _f for each port, without ever waiting for the ports being
+	// changed, so the threads of the backend can dispatch events with it
+	template<typename F>
+	void forEachPort( F _f ) const
+	{
+		++m_readers;
+		for( MidiPort * port : *m_portsSnapshot.load() )
+		{
+			_f( port );
+		}
+		--m_readers;
+	}
+
+	// only to be used by the thread adding and removing ports
 	QVector<MidiPort *> m_midiPorts;
 
+
+private:
+	// replaces the snapshot by a copy of m_midiPorts, and waits for the
+	// threads still reading the old one
+	void publishPorts();
+
+	std::atomic<const QVector<MidiPort *> *> m_portsSnapshot;
+	mutable std::atomic<int> m_readers;
+
 } ;
 
 
@@ -134,14 +165,28 @@ protected:
 	// generic raw-MIDI-parser which generates appropriate MIDI-events
 	void parseData( const unsigned char c );
 
+	//! Handles the complete message of @p size bytes at @p data at once,
+	//! for clients which receive whole messages. The message is played
+	//! @p offset frames later than one which just came in, so an offset
+	//! below zero plays it as far earlier.
+	void processMessage( const unsigned char * data, std::size_t size, f_cnt_t offset );
+
+	//! Writes the message of @p event to @p data, which has to hold three
+	//! bytes, and returns its size, or 0 for events which aren't handled
+	static std::size_t makeMessage( const MidiEvent& event, unsigned char * data );
+
 	// to be implemented by actual client-implementation
 	virtual void sendByte( const unsigned char c ) = 0;
 
 
 private:
 	// this does MIDI-event-process
-	void processParsedEvent();
-	void processOutEvent( const MidiEvent& event, const TimePos& time, const MidiPort* port ) override;
+	void processEvent( const MidiEvent& event, f_cnt_t offset );
+	//! Sets up @p event from the status byte @p status and the data bytes
+	//! following it, returns false for messages which aren't handled
+	static bool makeEvent( MidiEvent& event, int status, int data1, int data2 );
+	void processOutEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset, const MidiPort* port ) override;
+	void processOutSync( const MidiEvent& event, f_cnt_t offset ) override;
 
 	// small helper function returning length of a certain event - this
 	// is necessary for parsing raw-MIDI-data
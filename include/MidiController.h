@@ -26,9 +26,11 @@
 #define MIDI_CONTROLLER_H
 
 #include <QWidget>
+#include <vector>
 
 #include "AutomatableModel.h"
 #include "Controller.h"
+#include "LocklessList.h"
 #include "MidiEventProcessor.h"
 #include "MidiPort.h"
 
@@ -40,6 +42,16 @@ class MidiController : public Controller, public MidiEventProcessor
 {
 	Q_OBJECT
 public:
+	// how the value follows the values received
+	enum Smoothing
+	{
+		NoSmoothing,	// jumps to each value
+		LinearSmoothing,	// ramps to each value within SmoothingTime
+		OnePoleSmoothing,	// approaches each value, SmoothingTime being
+				// the time constant
+		NumSmoothings
+	} ;
+
 	MidiController( Model * _parent );
 	virtual ~MidiController();
 
@@ -73,8 +85,41 @@ protected:
 	MidiPort m_midiPort;
 
 
-	float m_lastValue;
-	float m_previousValue;
+private:
+	// in seconds
+	static constexpr float SmoothingTime = 0.01f;
+
+	// queues a value received, applied by the next period at the frame it
+	// came in
+	void queueValue( float _value, f_cnt_t _offset );
+
+	// values received, in the order they came in
+	struct QueuedValue
+	{
+		float value;
+		f_cnt_t offset;
+		qint64 arrival;	// in nanoseconds of a steady clock
+	} ;
+	static const int MaxQueuedValues = 512;
+	LocklessList<QueuedValue> m_queuedValues;
+	std::vector<QueuedValue> m_valuesToApply;
+
+	Smoothing m_smoothing;
+	// the NRPN followed instead of the control change of the port, or -1
+	int m_nrpn;
+
+	// parsing state, only used by the thread of the MIDI backend
+	int m_msb;
+	// whether the LSB of the controller or NRPN was received, which means
+	// it sends 14 bit values
+	bool m_fine;
+	int m_receivedNrpn;
+
+	// smoothing state, only used when updating the value buffer
+	float m_value;
+	float m_target;
+	float m_step;
+	f_cnt_t m_rampFrames;
 
 	friend class ControllerConnectionDialog;
 	friend class AutoDetectMidiController;
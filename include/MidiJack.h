@@ -35,6 +35,9 @@
 #include "weak_libjack.h"
 #endif
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
 #include <QtCore/QThread>
 #include <QMutex>
 #include <QtCore/QFile>
@@ -42,7 +45,9 @@
 #include "MidiClient.h"
 #include "AudioJack.h"
 
-#define	JACK_MIDI_BUFFER_MAX 64 /* events */
+#include "../src/3rdparty/ringbuffer/include/ringbuffer/ringbuffer.h"
+
+#define	JACK_MIDI_BUFFER_MAX 1024 /* events */
 
 class QLineEdit;
 
@@ -79,13 +84,45 @@ protected:
 
 
 private:
+	//! An event sent, with the period it was rendered in and its frame in
+	//! that period
+	struct OutEvent
+	{
+		long period; // -1 if it was not sent while rendering
+		f_cnt_t offset;
+		uint8_t size;
+		uint8_t data[3];
+	};
+
+	//! An event waiting to be written, at a frame of m_outClock
+	struct PendingOutEvent
+	{
+		int64_t due;
+		uint8_t size;
+		uint8_t data[3];
+	};
+
+	void processOutEvent( const MidiEvent& event, const TimePos& time,
+				f_cnt_t offset, const MidiPort* port ) override;
+
 	AudioJack *m_jackAudio;
 	jack_client_t *m_jackClient;
 	jack_port_t *m_input_port;
 	jack_port_t *m_output_port;
-	uint8_t m_jack_buffer[JACK_MIDI_BUFFER_MAX * 4];
 
-	void JackMidiOutEvent(uint8_t *buf, uint8_t len);
+	//! spinlock for the output ringbuffer, the tracks of a period are
+	//! rendered by several threads at once
+	std::atomic_flag m_outLock = ATOMIC_FLAG_INIT;
+	//! events sent -> jack callback
+	ringbuffer_t<OutEvent> m_outEvents;
+	ringbuffer_reader_t<OutEvent> m_outReader;
+
+	// only used by the jack callback
+	std::vector<PendingOutEvent> m_pendingOut; // sorted by due frame
+	int64_t m_outClock; // first frame of the current cycle
+	long m_outPeriod;
+	int64_t m_outPeriodStart;
+
 	void lock();
 	void unlock();
 
@@ -102,8 +102,10 @@ public:
 		return outputChannel() ? outputChannel() - 1 : 0;
 	}
 
-	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos() );
-	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos() );
+	//! @p offset is passed on to the MidiEventProcessor
+	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 );
+	//! @p offset is passed on to the MidiClient
+	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 );
 
 
 	void saveSettings( QDomDocument& doc, QDomElement& thisElement ) override;
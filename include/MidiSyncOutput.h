@@ -0,0 +1,88 @@
+/*
+ * MidiSyncOutput.h - MIDI clock and MIDI time code sent along with playback
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef MIDI_SYNC_OUTPUT_H
+#define MIDI_SYNC_OUTPUT_H
+
+#include <atomic>
+
+#include "lmms_basics.h"
+
+class MidiEvent;
+
+
+/**
+	Sends MIDI clock (24 pulses per quarter note) and MIDI time code
+	quarter frames to the outputs of the MIDI client
+
+	The song passes each part of a period it plays with the position it
+	starts at, so the messages are generated on the render thread, at the
+	frames they are due. The clients send them with these frame offsets
+	where they can.
+
+	When playback starts or jumps, the position is sent as song position
+	pointer followed by continue, and the clock goes on from the next
+	sixteenth note. The time code starts over with the next full frame.
+*/
+class MidiSyncOutput
+{
+public:
+	MidiSyncOutput();
+
+	//! Reads which messages are sent from the configuration, has to be
+	//! called again when it changes
+	void loadSettings();
+
+	//! Plays @p frames frames from @p offset in the period. The first is
+	//! @p ticks ticks and @p seconds seconds into the song, a tick lasts
+	//! @p framesPerTick frames.
+	void play(double ticks, double seconds, float framesPerTick,
+		fpp_t frames, f_cnt_t offset);
+
+	//! Playback stopped, sends stop if clock was sent
+	void stop();
+
+private:
+	void send(const MidiEvent& event, f_cnt_t offset);
+	void sendQuarterFrame(long quarterFrame, f_cnt_t offset);
+
+	std::atomic<bool> m_clockEnabled;
+	std::atomic<bool> m_timeCodeEnabled;
+	std::atomic<int> m_framesPerSecond;
+
+	// only used on the render thread
+	bool m_running;
+	bool m_clockRunning;
+	bool m_timeCodeRunning;
+	//! where the last part played ended, to find jumps
+	double m_endTicks;
+	//! the tick of the next clock pulse
+	double m_nextClock;
+	//! the number of the next quarter frame since the start of the song
+	long m_nextQuarterFrame;
+	int m_timeCodeRate;
+} ;
+
+
+#endif
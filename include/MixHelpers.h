@@ -26,19 +26,79 @@
 #define MIX_HELPERS_H
 
 #include "lmms_basics.h"
+#include "lmms_export.h"
 
+class PlanarBuffer;
 class ValueBuffer;
 namespace MixHelpers
 {
 
+/*! Instruction sets the mixing functions can run on. The best one supported
+ *  by the CPU is chosen at startup. */
+enum InstructionSets
+{
+	InstructionSetScalar,
+	InstructionSetSSE2,
+	InstructionSetAVX2,
+	InstructionSetAVX512,
+	InstructionSetNEON,
+	NumInstructionSets
+} ;
+
+InstructionSets instructionSet();
+
+/*! \brief Switch all mixing functions to the given instruction set
+ *
+ *  Returns false if the set isn't compiled in or not supported by the CPU.
+ *  Meant for comparing the results against the scalar implementation, so
+ *  don't call this while the mixer is running.
+ */
+bool setInstructionSet( InstructionSets set );
+
+bool isSupported( InstructionSets set );
+
+const char* instructionSetName( InstructionSets set );
+
 bool isSilent( const sampleFrame* src, int frames );
 
+/*! \brief Properties of a buffer, gathered in a single pass by analyze() */
+struct LMMS_EXPORT BufferAnalysis
+{
+	sample_t peakLeft;
+	sample_t peakRight;
+	//! Mean of left² + right² per frame, as passed to Effect::checkGate()
+	float meanSquare;
+	//! Whether all samples are below the threshold used by isSilent()
+	bool silent;
+	//! Whether there are infs or nans
+	bool bad;
+
+	sample_t peak() const
+	{
+		return peakLeft > peakRight ? peakLeft : peakRight;
+	}
+
+	//! RMS over both channels
+	float rms() const;
+} ;
+
+LMMS_EXPORT BufferAnalysis analyze( const sampleFrame* src, int frames );
+
+/*! \brief Analyze src and sanitize() it only if needed
+ *
+ *  Returns the analysis of the sanitized buffer, so writing a buffer that
+ *  usually is fine costs one pass instead of two.
+ */
+BufferAnalysis analyzeAndSanitize( sampleFrame* src, int frames );
+
 bool useNaNHandler();
 
 void setNaNHandler( bool use );
 
 bool sanitize( sampleFrame * src, int frames );
 
+bool sanitize( PlanarBuffer & src, int frames );
+
 /*! \brief Add samples from src to dst */
 void add( sampleFrame* dst, const sampleFrame* src, int frames );
 
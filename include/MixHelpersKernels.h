@@ -0,0 +1,470 @@
+/*
+ * MixHelpersKernels.h - vectorized implementations of the MixHelpers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef MIX_HELPERS_KERNELS_H
+#define MIX_HELPERS_KERNELS_H
+
+#include <cmath>
+
+#include "lmms_basics.h"
+#include "MixHelpers.h"
+
+namespace MixHelpers
+{
+
+/*! \brief One implementation of all mixing functions
+ *
+ * The functions in MixHelpers dispatch to the kernels of the best
+ * instruction set available at runtime. Coefficient buffers are passed as
+ * plain arrays with one value per frame.
+ */
+struct Kernels
+{
+	bool (*isSilent)( const sampleFrame* src, int frames );
+	BufferAnalysis (*analyze)( const sampleFrame* src, int frames );
+	void (*add)( sampleFrame* dst, const sampleFrame* src, int frames );
+	void (*addMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addSwappedMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addMultipliedByBuffer)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames );
+	void (*addMultipliedByBuffers)( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames );
+	void (*addSanitizedMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addSanitizedMultipliedByBuffer)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames );
+	void (*addSanitizedMultipliedByBuffers)( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames );
+	void (*addMultipliedStereo)( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames );
+	void (*multiplyAndAddMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames );
+	void (*multiplyAndAddMultipliedJoined)( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames );
+} ;
+
+//! Kernels of the different instruction sets, NULL if not compiled in
+const Kernels* scalarKernels();
+const Kernels* sse2Kernels();
+const Kernels* avx2Kernels();
+const Kernels* avx512Kernels();
+const Kernels* neonKernels();
+
+//! Common part of all analyze() kernels. Static like everything the kernels
+//! use, see SimdKernels.
+static inline BufferAnalysis finishAnalysis( sample_t peakLeft, sample_t peakRight,
+					double sumOfSquares, int frames, bool bad )
+{
+	const float silenceThreshold = 0.0000001f;
+	BufferAnalysis result;
+	result.peakLeft = peakLeft;
+	result.peakRight = peakRight;
+	result.meanSquare = frames > 0 ? sumOfSquares / frames : 0.0f;
+	result.silent = peakLeft < silenceThreshold && peakRight < silenceThreshold;
+	result.bad = bad;
+	return result;
+}
+
+
+/*! \brief Kernels built on top of a register type
+ *
+ * Each translation unit compiled for an instruction set instantiates this
+ * with a traits class V providing:
+ *
+ *  - Reg: the register type, holding Width floats (Width / 2 frames)
+ *  - load(), store(), set1(), set2() (l, r, l, r...), add(), sub(), mul(),
+ *    abs()
+ *  - max( x, y ): x > y ? x : y, so nans in x are skipped
+ *  - swapPairs(): swaps the two channels of each frame
+ *  - zip( a, b, lo, hi ): interleaves a and b into two registers
+ *  - finite( raw, value ): value where raw is finite, 0 otherwise
+ *  - anyLoud( x, threshold ): whether any |x| >= threshold
+ *
+ * The operations are done in the same order as in the scalar kernels, so
+ * the results are identical. The only exception is the sum of squares in
+ * analyze(), which is accumulated per lane.
+ *
+ * The translation units are compiled with the flags of their instruction
+ * set, e.g. -mavx2. Any inline function with external linkage they use,
+ * like std::isnan() or std::array::operator[], would be emitted there with
+ * these instructions, and the linker may pick that copy for callers on
+ * CPUs without them. So the kernels only call their own static functions
+ * and work on plain float pointers, and V lives in an anonymous namespace.
+ */
+template<class V>
+struct SimdKernels
+{
+	using Reg = typename V::Reg;
+
+	static inline float* floats( sampleFrame* buf )
+	{
+		return reinterpret_cast<float*>( buf );
+	}
+
+	static inline const float* floats( const sampleFrame* buf )
+	{
+		return reinterpret_cast<const float*>( buf );
+	}
+
+	// x - x is nan for infs and nans and 0 otherwise
+	static inline bool notFinite( float x )
+	{
+		return !( x - x == 0.0f );
+	}
+
+	static inline float sanitized( float raw, float value )
+	{
+		return notFinite( raw ) ? 0.0f : value;
+	}
+
+	static bool isSilent( const sampleFrame* src, int frames )
+	{
+		const float silenceThreshold = 0.0000001f;
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg threshold = V::set1( silenceThreshold );
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			if( V::anyLoud( V::load( s + i ), threshold ) )
+			{
+				return false;
+			}
+		}
+		for( ; i < n; ++i )
+		{
+			if( fabsf( s[i] ) >= silenceThreshold )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static BufferAnalysis analyze( const sampleFrame* src, int frames )
+	{
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg zero = V::set1( 0.0f );
+		Reg peaks = zero;
+		Reg squares = zero;
+		// x - x is nan for infs and nans and 0 otherwise
+		Reg bad = zero;
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			const Reg x = V::load( s + i );
+			peaks = V::max( V::abs( x ), peaks );
+			squares = V::add( squares, V::mul( x, x ) );
+			bad = V::add( bad, V::sub( x, x ) );
+		}
+
+		// the lanes alternate between left and right
+		float peakLanes[V::Width];
+		float squareLanes[V::Width];
+		float badLanes[V::Width];
+		V::store( peakLanes, peaks );
+		V::store( squareLanes, squares );
+		V::store( badLanes, bad );
+		sample_t peak[2] = { 0.0f, 0.0f };
+		double sumOfSquares = 0.0;
+		bool isBad = false;
+		for( int l = 0; l < V::Width; ++l )
+		{
+			if( peakLanes[l] > peak[l % 2] )
+			{
+				peak[l % 2] = peakLanes[l];
+			}
+			sumOfSquares += squareLanes[l];
+			isBad |= badLanes[l] != badLanes[l];
+		}
+		for( ; i < n; ++i )
+		{
+			const float a = fabsf( s[i] );
+			if( a > peak[i % 2] )
+			{
+				peak[i % 2] = a;
+			}
+			sumOfSquares += s[i] * s[i];
+			isBad |= notFinite( s[i] );
+		}
+		return finishAnalysis( peak[0], peak[1], sumOfSquares, frames, isBad );
+	}
+
+	static void add( sampleFrame* dst, const sampleFrame* src, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const int n = frames * 2;
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			V::store( d + i, V::add( V::load( d + i ), V::load( s + i ) ) );
+		}
+		for( ; i < n; ++i )
+		{
+			d[i] += s[i];
+		}
+	}
+
+	static void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg c = V::set1( coeffSrc );
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			V::store( d + i, V::add( V::load( d + i ),
+						V::mul( V::load( s + i ), c ) ) );
+		}
+		for( ; i < n; ++i )
+		{
+			d[i] += s[i] * coeffSrc;
+		}
+	}
+
+	static void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg c = V::set1( coeffSrc );
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			V::store( d + i, V::add( V::load( d + i ),
+				V::mul( V::swapPairs( V::load( s + i ) ), c ) ) );
+		}
+		for( ; i < n; i += 2 )
+		{
+			d[i] += s[i + 1] * coeffSrc;
+			d[i + 1] += s[i] * coeffSrc;
+		}
+	}
+
+	static void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const Reg c = V::set1( coeffSrc );
+		int f = 0;
+		// one register of coefficients covers two registers of frames
+		for( ; f + V::Width <= frames; f += V::Width )
+		{
+			Reg lo, hi;
+			const Reg b = V::load( coeffSrcBuf + f );
+			V::zip( b, b, lo, hi );
+			float* d0 = d + f * 2;
+			const float* s0 = s + f * 2;
+			V::store( d0, V::add( V::load( d0 ),
+				V::mul( V::mul( V::load( s0 ), c ), lo ) ) );
+			V::store( d0 + V::Width, V::add( V::load( d0 + V::Width ),
+				V::mul( V::mul( V::load( s0 + V::Width ), c ), hi ) ) );
+		}
+		for( ; f < frames; ++f )
+		{
+			d[f * 2] += s[f * 2] * coeffSrc * coeffSrcBuf[f];
+			d[f * 2 + 1] += s[f * 2 + 1] * coeffSrc * coeffSrcBuf[f];
+		}
+	}
+
+	static void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		int f = 0;
+		for( ; f + V::Width <= frames; f += V::Width )
+		{
+			Reg lo1, hi1, lo2, hi2;
+			const Reg b1 = V::load( coeffSrcBuf1 + f );
+			const Reg b2 = V::load( coeffSrcBuf2 + f );
+			V::zip( b1, b1, lo1, hi1 );
+			V::zip( b2, b2, lo2, hi2 );
+			float* d0 = d + f * 2;
+			const float* s0 = s + f * 2;
+			V::store( d0, V::add( V::load( d0 ),
+				V::mul( V::mul( V::load( s0 ), lo1 ), lo2 ) ) );
+			V::store( d0 + V::Width, V::add( V::load( d0 + V::Width ),
+				V::mul( V::mul( V::load( s0 + V::Width ), hi1 ), hi2 ) ) );
+		}
+		for( ; f < frames; ++f )
+		{
+			d[f * 2] += s[f * 2] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+			d[f * 2 + 1] += s[f * 2 + 1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		}
+	}
+
+	static void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg c = V::set1( coeffSrc );
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			const Reg x = V::load( s + i );
+			V::store( d + i, V::add( V::load( d + i ),
+						V::finite( x, V::mul( x, c ) ) ) );
+		}
+		for( ; i < n; ++i )
+		{
+			d[i] += sanitized( s[i], s[i] * coeffSrc );
+		}
+	}
+
+	static void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const Reg c = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + V::Width <= frames; f += V::Width )
+		{
+			Reg lo, hi;
+			const Reg b = V::load( coeffSrcBuf + f );
+			V::zip( b, b, lo, hi );
+			float* d0 = d + f * 2;
+			const float* s0 = s + f * 2;
+			const Reg x0 = V::load( s0 );
+			const Reg x1 = V::load( s0 + V::Width );
+			V::store( d0, V::add( V::load( d0 ),
+				V::finite( x0, V::mul( V::mul( x0, c ), lo ) ) ) );
+			V::store( d0 + V::Width, V::add( V::load( d0 + V::Width ),
+				V::finite( x1, V::mul( V::mul( x1, c ), hi ) ) ) );
+		}
+		for( ; f < frames; ++f )
+		{
+			d[f * 2] += sanitized( s[f * 2], s[f * 2] * coeffSrc * coeffSrcBuf[f] );
+			d[f * 2 + 1] += sanitized( s[f * 2 + 1], s[f * 2 + 1] * coeffSrc * coeffSrcBuf[f] );
+		}
+	}
+
+	static void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		int f = 0;
+		for( ; f + V::Width <= frames; f += V::Width )
+		{
+			Reg lo1, hi1, lo2, hi2;
+			const Reg b1 = V::load( coeffSrcBuf1 + f );
+			const Reg b2 = V::load( coeffSrcBuf2 + f );
+			V::zip( b1, b1, lo1, hi1 );
+			V::zip( b2, b2, lo2, hi2 );
+			float* d0 = d + f * 2;
+			const float* s0 = s + f * 2;
+			const Reg x0 = V::load( s0 );
+			const Reg x1 = V::load( s0 + V::Width );
+			V::store( d0, V::add( V::load( d0 ),
+				V::finite( x0, V::mul( V::mul( x0, lo1 ), lo2 ) ) ) );
+			V::store( d0 + V::Width, V::add( V::load( d0 + V::Width ),
+				V::finite( x1, V::mul( V::mul( x1, hi1 ), hi2 ) ) ) );
+		}
+		for( ; f < frames; ++f )
+		{
+			d[f * 2] += sanitized( s[f * 2], s[f * 2] * coeffSrcBuf1[f] * coeffSrcBuf2[f] );
+			d[f * 2 + 1] += sanitized( s[f * 2 + 1], s[f * 2 + 1] * coeffSrcBuf1[f] * coeffSrcBuf2[f] );
+		}
+	}
+
+	static void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg c = V::set2( coeffSrcLeft, coeffSrcRight );
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			V::store( d + i, V::add( V::load( d + i ),
+						V::mul( V::load( s + i ), c ) ) );
+		}
+		for( ; i < n; i += 2 )
+		{
+			d[i] += s[i] * coeffSrcLeft;
+			d[i + 1] += s[i + 1] * coeffSrcRight;
+		}
+	}
+
+	static void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
+	{
+		float* d = floats( dst );
+		const float* s = floats( src );
+		const int n = frames * 2;
+		const Reg cd = V::set1( coeffDst );
+		const Reg cs = V::set1( coeffSrc );
+		int i = 0;
+		for( ; i + V::Width <= n; i += V::Width )
+		{
+			V::store( d + i, V::add( V::mul( V::load( d + i ), cd ),
+						V::mul( V::load( s + i ), cs ) ) );
+		}
+		for( ; i < n; ++i )
+		{
+			d[i] = d[i] * coeffDst + s[i] * coeffSrc;
+		}
+	}
+
+	static void multiplyAndAddMultipliedJoined( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames )
+	{
+		float* d = floats( dst );
+		const Reg cd = V::set1( coeffDst );
+		const Reg cs = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + V::Width <= frames; f += V::Width )
+		{
+			Reg lo, hi;
+			V::zip( V::load( srcLeft + f ), V::load( srcRight + f ), lo, hi );
+			float* d0 = d + f * 2;
+			V::store( d0, V::add( V::mul( V::load( d0 ), cd ),
+							V::mul( lo, cs ) ) );
+			V::store( d0 + V::Width, V::add( V::mul( V::load( d0 + V::Width ), cd ),
+							V::mul( hi, cs ) ) );
+		}
+		for( ; f < frames; ++f )
+		{
+			d[f * 2] = d[f * 2] * coeffDst + srcLeft[f] * coeffSrc;
+			d[f * 2 + 1] = d[f * 2 + 1] * coeffDst + srcRight[f] * coeffSrc;
+		}
+	}
+
+	static const Kernels* kernels()
+	{
+		static const Kernels k = {
+			&isSilent,
+			&analyze,
+			&add,
+			&addMultiplied,
+			&addSwappedMultiplied,
+			&addMultipliedByBuffer,
+			&addMultipliedByBuffers,
+			&addSanitizedMultiplied,
+			&addSanitizedMultipliedByBuffer,
+			&addSanitizedMultipliedByBuffers,
+			&addMultipliedStereo,
+			&multiplyAndAddMultiplied,
+			&multiplyAndAddMultipliedJoined
+		};
+		return &k;
+	}
+} ;
+
+}
+
+#endif
@@ -31,17 +31,28 @@
 #include <QtCore/QWaitCondition>
 #include <samplerate.h>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 
 #include "lmms_basics.h"
+#include "LatencyProbe.h"
+#include "LocklessCommandQueue.h"
 #include "LocklessList.h"
 #include "Note.h"
-#include "FifoBuffer.h"
 #include "MixerProfiler.h"
+#include "MixerWorkerThread.h"
+#include "PeriodBufferFifo.h"
+#include "VisualizationTap.h"
 
 
 class AudioDevice;
+template<class T> class LocklessRingBuffer;
+template<class T> class LocklessRingBufferReader;
 class MidiClient;
 class AudioPort;
+class InstrumentTrack;
 
 
 const fpp_t MINIMUM_BUFFER_SIZE = 32;
@@ -63,7 +74,7 @@ const Octaves BaseOctave = DefaultOctave;
 #include "PlayHandle.h"
 
 
-class MixerWorkerThread;
+class EngineContext;
 
 
 class LMMS_EXPORT Mixer : public QObject
@@ -97,6 +108,9 @@ public:
 
 		Interpolation interpolation;
 		Oversampling oversampling;
+		// frames between two updates of filters modulated by envelopes
+		// or LFOs, 1 to update them on every frame
+		int controlInterval;
 
 		qualitySettings(Mode m)
 		{
@@ -105,22 +119,27 @@ public:
 				case Mode_Draft:
 					interpolation = Interpolation_Linear;
 					oversampling = Oversampling_None;
+					controlInterval = 32;
 					break;
 				case Mode_HighQuality:
 					interpolation =
 						Interpolation_SincFastest;
 					oversampling = Oversampling_2x;
+					controlInterval = 16;
 					break;
 				case Mode_FinalMix:
 					interpolation = Interpolation_SincBest;
 					oversampling = Oversampling_8x;
+					controlInterval = 1;
 					break;
 			}
 		}
 
-		qualitySettings(Interpolation i, Oversampling o) :
+		qualitySettings(Interpolation i, Oversampling o,
+						int control = 1) :
 			interpolation(i),
-			oversampling(o)
+			oversampling(o),
+			controlInterval(control)
 		{
 		}
 
@@ -188,9 +207,7 @@ public:
 	// audio-port-stuff
 	inline void addAudioPort(AudioPort * port)
 	{
-		requestChangeInModel();
-		m_audioPorts.push_back(port);
-		doneChangeInModel();
+		postChangeInModel([this, port]() { m_audioPorts.push_back(port); });
 	}
 
 	void removeAudioPort(AudioPort * port);
@@ -227,6 +244,13 @@ public:
 		return m_framesPerPeriod;
 	}
 
+	//! The longest period; buffers holding a period are allocated this
+	//! long, so the period can change without reallocating them
+	static inline fpp_t maxFramesPerPeriod()
+	{
+		return DEFAULT_BUFFER_SIZE;
+	}
+
 
 	MixerProfiler& profiler()
 	{
@@ -238,6 +262,22 @@ public:
 		return m_profiler.cpuLoad();
 	}
 
+	LatencyProbe & latencyProbe()
+	{
+		return m_latencyProbe;
+	}
+
+	//! A reduced copy of each master output period, for the oscilloscope.
+	//! It's only filled while a view is attached.
+	VisualizationTap & outputTap()
+	{
+		return m_outputTap;
+	}
+
+	//! The frames rendered ahead of the audio device, i.e. the periods
+	//! queued in the FIFO, not counting the buffers of the device
+	f_cnt_t nominalLatency() const;
+
 	const qualitySettings & currentQualitySettings() const
 	{
 		return m_qualitySettings;
@@ -293,23 +333,115 @@ public:
 
 	void pushInputFrames( sampleFrame * _ab, const f_cnt_t _frames );
 
+	//! The frames captured during the previous period
 	inline const sampleFrame * inputBuffer()
 	{
-		return m_inputBuffer[ m_inputBufferRead ];
+		return m_inputBuffer;
 	}
 
 	inline f_cnt_t inputBufferFrames() const
 	{
-		return m_inputBufferFrames[ m_inputBufferRead ];
+		return m_inputBufferFrames;
 	}
 
+	//! Returns the next period, which stays valid until nextBufferDone()
 	inline const surroundSampleFrame * nextBuffer()
 	{
 		return hasFifoWriter() ? m_fifo->read() : renderNextBuffer();
 	}
 
+	//! Gives a buffer returned by nextBuffer() back to the mixer
+	inline void nextBufferDone( const surroundSampleFrame * buffer )
+	{
+		if( hasFifoWriter() && buffer )
+		{
+			m_fifo->release();
+		}
+	}
+
+	//! The periods the FIFO writer may render ahead of the audio device
+	int fifoDepth() const
+	{
+		return m_fifo->depth();
+	}
+
 	void changeQuality(const struct qualitySettings & qs);
 
+	//! In pipelined mode, the FX mix of the previous period is done while
+	//! the play handles of the current period are rendered. This adds
+	//! pipelineLatency() periods of latency, so it's meant for offline
+	//! rendering. The song is still processed before the play handles, as
+	//! the models it changes are read while they render. Must not be
+	//! changed while processing.
+	void setPipelined( bool enabled );
+	inline bool isPipelined() const
+	{
+		return m_pipelined;
+	}
+
+	//! Number of periods the output lags behind when pipelined
+	inline int pipelineLatency() const
+	{
+		return m_pipelined ? 1 : 0;
+	}
+
+	//! Render all notes of a track in a few jobs rather than one job per
+	//! note. Must not be changed while processing.
+	void setNoteBatching( bool enabled )
+	{
+		m_batchNotes = enabled;
+	}
+
+	bool noteBatching() const
+	{
+		return m_batchNotes;
+	}
+
+	//! Let instruments which sound the same on every hit play what they
+	//! rendered before, see OneShotCache
+	void setOneShotCaching( bool enabled )
+	{
+		m_oneShotCaching = enabled;
+	}
+
+	bool oneShotCaching() const
+	{
+		return m_oneShotCaching;
+	}
+
+	//! While the CPU load is above @p load percent, the least audible voice
+	//! of the project is stolen every period. 0 disables it.
+	void setCpuBudget( int load )
+	{
+		m_cpuBudget = load;
+	}
+
+	int cpuBudget() const
+	{
+		return m_cpuBudget;
+	}
+
+	//! Incremented whenever the active notes of the instrument tracks are
+	//! collected, see InstrumentTrack::activeNotes()
+	unsigned int activeNotesPeriod() const
+	{
+		return m_activeNotesPeriod;
+	}
+
+	//! Let the audio thread play the MIDI events @p track queued at the
+	//! beginning of the next period, can be called from any thread
+	void scheduleQueuedInEvents( InstrumentTrack * track )
+	{
+		m_tracksWithInEvents.push( track );
+	}
+
+	//! Forget about the queued events of @p track before it is deleted,
+	//! requires a change in model
+	void unscheduleQueuedInEvents( const InstrumentTrack * track );
+
+	//! Whether the calling thread is rendering a period right now
+	static bool isRenderingThread();
+
 	inline bool isMetronomeActive() const { return m_metronomeActive; }
 	inline void setMetronomeActive(bool value = true) { m_metronomeActive = value; }
 
@@ -317,18 +449,37 @@ public:
 	void requestChangeInModel();
 	void doneChangeInModel();
 
+	//! Let the audio thread do a change in the model at the beginning of
+	//! the next period, without blocking. Changes are done in the order they
+	//! have been posted. @p cleanup is called outside the audio thread after
+	//! the change has been done, e.g. to delete objects the change removed.
+	void postChangeInModel( LocklessCommandQueue::Command change,
+				LocklessCommandQueue::Command cleanup = nullptr );
+
+	//! Run the cleanup of changes done by the audio thread. This is done
+	//! whenever a change is posted or requested, too.
+	void collectGarbage();
+
 	static bool isAudioDevNameValid(QString name);
 	static bool isMidiDevNameValid(QString name);
 
 
+public slots:
+	//! Changes the frames per audio buffer at a period boundary, keeping
+	//! the audio device; sizes above DEFAULT_BUFFER_SIZE are rendered as
+	//! several periods queued in the FIFO
+	void changeFramesPerAudioBuffer( int frames );
+
+
 signals:
 	void qualitySettingsChanged();
 	void sampleRateChanged();
-	void nextAudioBuffer( const surroundSampleFrame * buffer );
+	//! Emitted while not processing, after framesPerPeriod() changed
+	void framesPerPeriodChanged();
 
 
 private:
-	typedef FifoBuffer<surroundSampleFrame *> Fifo;
+	typedef PeriodBufferFifo Fifo;
 
 	class fifoWriter : public QThread
 	{
@@ -345,7 +496,60 @@ private:
 
 		void run() override;
 
-		void write( surroundSampleFrame * buffer );
+		//! Waits for a free buffer in the FIFO while allowing changes
+		//! in the model
+		surroundSampleFrame * acquire();
+
+	} ;
+
+	// the FX mix of the previous period, which runs alongside the play
+	// handles when pipelined
+	class PipelineStage : public ThreadableJob
+	{
+	public:
+		PipelineStage( std::function<void()> process ) :
+			m_process( process )
+		{
+		}
+
+		bool requiresProcessing() const override
+		{
+			return true;
+		}
+
+	private:
+		void doProcessing() override
+		{
+			m_process();
+		}
+
+		std::function<void()> m_process;
+
+	} ;
+
+	// notes of one audio port which are rendered by a single job, so
+	// hundreds of short notes don't cost hundreds of job dispatches
+	class NoteBatch : public ThreadableJob
+	{
+	public:
+		//! More notes of a port go into another batch, so heavy tracks
+		//! are still spread across the workers
+		static const int MaxNotes = 16;
+
+		NoteBatch()
+		{
+			m_handles.reserve( MaxNotes );
+		}
+
+		bool requiresProcessing() const override
+		{
+			return !m_handles.isEmpty();
+		}
+
+		QVector<PlayHandle *> m_handles;
+
+	private:
+		void doProcessing() override;
 
 	} ;
 
@@ -356,6 +560,11 @@ private:
 	void startProcessing(bool needsFifo = true);
 	void stopProcessing();
 
+	//! Splits frames per audio buffer into the frames per period and the
+	//! periods queued in the FIFO
+	void splitAudioBuffer( int frames, fpp_t & framesPerPeriod,
+							int & fifoSize ) const;
+
 
 	AudioDevice * tryAudioDevices();
 	MidiClient * tryMidiClients();
@@ -369,34 +578,86 @@ private:
 
 	void clearInternal();
 
+	void stealQuietestVoice();
+
+	//! Adds the play handles to the job queue, the notes grouped by audio
+	//! port if batching is enabled
+	void queuePlayHandles();
+
+	//! Lets the instrument tracks play the MIDI events which came in since
+	//! the last period
+	void processQueuedInEvents();
+
+	//! Collects the master notes of every instrument track that aren't
+	//! released, once per period instead of on every look-up
+	void updateActiveNotes();
+
+	// the play handles in m_playHandles know their index, so they can be
+	// removed by moving the last one into the gap
+	void registerPlayHandle( PlayHandle * handle );
+	void unregisterPlayHandle( PlayHandle * handle );
+	bool isRegistered( const PlayHandle * handle ) const
+	{
+		return handle->m_mixerIndex >= 0 &&
+			handle->m_mixerIndex < m_playHandles.size() &&
+			m_playHandles[handle->m_mixerIndex] == handle;
+	}
+	//! Remove all handles which have been requested to be removed and, if
+	//! @p finished, also all finished handles in one pass
+	void removePlayHandles( bool finished );
+	static void deletePlayHandle( PlayHandle * handle );
+
 	//! Called by the audio thread to give control to other threads,
 	//! such that they can do changes in the model (like e.g. removing effects)
 	void runChangesInModel();
 
+	//! Called by the audio thread or with a change in model requested to do
+	//! the posted changes
+	void runPostedChangesInModel();
+
 	bool m_renderOnly;
 
 	QVector<AudioPort *> m_audioPorts;
 
 	fpp_t m_framesPerPeriod;
 
-	sampleFrame * m_inputBuffer[2];
-	f_cnt_t m_inputBufferFrames[2];
-	f_cnt_t m_inputBufferSize[2];
-	int m_inputBufferRead;
-	int m_inputBufferWrite;
+	// the oscilloscope is far narrower than this
+	static const int OutputTapPoints = 512;
+
+	// the most frames captured during a period
+	static const f_cnt_t InputFrames = DEFAULT_BUFFER_SIZE * 100;
+
+	// frames captured by the audio device, taken over at each period
+	std::unique_ptr<LocklessRingBuffer<sampleFrame>> m_inputFrames;
+	std::unique_ptr<LocklessRingBufferReader<sampleFrame>> m_inputReader;
+	sampleFrame * m_inputBuffer;
+	f_cnt_t m_inputBufferFrames;
 
 	surroundSampleFrame * m_outputBufferRead;
 	surroundSampleFrame * m_outputBufferWrite;
+	// the buffers of the mixer; with a FIFO writer, the output buffers
+	// are the ones of the FIFO instead
+	surroundSampleFrame * m_outputBuffers[2];
+	// if not null, swapBuffers() writes the next period into this buffer
+	surroundSampleFrame * m_nextOutputBuffer;
 
-	// worker thread stuff
+	// the context this mixer renders for, current while it does
+	EngineContext * m_context;
+
+	// worker thread stuff, only the mixer of the main context starts
+	// workers, the others run their jobs in m_inlineJobs themselves
 	QVector<MixerWorkerThread *> m_workers;
 	int m_numWorkers;
+	std::unique_ptr<MixerWorkerThread::JobQueue> m_inlineJobs;
 
 	// playhandle stuff
 	PlayHandleList m_playHandles;
 	// place where new playhandles are added temporarily
 	LocklessList<PlayHandle *> m_newPlayHandles;
-	ConstPlayHandleList m_playHandlesToRemove;
+	// instrument tracks which have MIDI events queued by other threads
+	LocklessList<InstrumentTrack *> m_tracksWithInEvents;
+	// whether any handle has m_removalRequested set
+	bool m_playHandleRemovalRequested;
 
 
 	struct qualitySettings m_qualitySettings;
@@ -420,11 +681,24 @@ private:
 	fifoWriter * m_fifoWriter;
 
 	MixerProfiler m_profiler;
+	LatencyProbe m_latencyProbe;
+	VisualizationTap m_outputTap;
 
 	bool m_metronomeActive;
+	tick_t m_lastMetroTicks;
+
+	bool m_pipelined;
+	int m_cpuBudget;
+	bool m_batchNotes;
+	bool m_oneShotCaching;
+	unsigned int m_activeNotesPeriod;
+	std::vector<std::unique_ptr<NoteBatch>> m_noteBatches;
+	PipelineStage m_masterMixStage;
 
 	bool m_clearSignal;
 
+	LocklessCommandQueue m_postedChanges;
+
 	bool m_changesSignal;
 	unsigned int m_changes;
 	QMutex m_changesMutex;
@@ -0,0 +1,150 @@
+/*
+ * MixerFlightRecorder.h - keeps the timing of recent periods for post-mortem
+ *                         analysis of xruns
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef MIXER_FLIGHT_RECORDER_H
+#define MIXER_FLIGHT_RECORDER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+#include <atomic>
+#include <chrono>
+#include <typeinfo>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+class ThreadableJob;
+
+
+//! Records the timing of the last periods rendered by the mixer. When a
+//! period misses its deadline or the audio device reports an underrun, the
+//! recorded periods are dumped to a file, so one-off dropouts can be
+//! analyzed afterwards.
+//!
+//! Periods are only written by the mixer thread and jobs only by the worker
+//! thread processing them, so recording doesn't need any locks. Dumping is
+//! done later on the thread the recorder lives in.
+class LMMS_EXPORT MixerFlightRecorder : public QObject
+{
+	Q_OBJECT
+public:
+	// number of periods kept
+	static const int Capacity = 4096;
+	// the mixer thread and the first workers have their own statistics
+	static const int MaxWorkers = 16;
+	// number of longest jobs kept per period
+	static const int MaxLongestJobs = 4;
+	static const int MaxStages = 4;
+
+	struct JobRecord
+	{
+		const std::type_info * type;
+		const ThreadableJob * job;
+		quint32 duration;	// in ns
+	} ;
+
+	struct Period
+	{
+		qint64 start;		// ns since the recorder was created
+		qint32 elapsed;		// us
+		qint32 deadline;	// us
+		qint32 stageTime[MaxStages];	// us
+		qint32 playHandles;
+		quint16 jobsPerWorker[MaxWorkers];	// index 0 is the mixer thread
+		JobRecord longestJobs[MaxLongestJobs];
+	} ;
+
+	MixerFlightRecorder();
+	virtual ~MixerFlightRecorder();
+
+	void setEnabled( bool enabled );
+	bool isEnabled() const
+	{
+		return m_enabled.load( std::memory_order_relaxed );
+	}
+
+	//! Called by the mixer thread when a period starts
+	void startPeriod();
+
+	//! Called by the mixer thread when a period is done. Requests a dump if
+	//! the period took longer than @p deadline.
+	void finishPeriod( int elapsed, int deadline, const int * stageTime,
+							int stageCount, int playHandles );
+
+	//! Called by the thread which processed @p job. @p worker is the
+	//! index of the worker thread, -1 for the mixer thread.
+	void recordJob( int worker, const ThreadableJob * job, quint32 duration );
+
+	//! Dump the recorded periods as soon as possible. Can be called from
+	//! any thread, e.g. from the callback of an audio device.
+	void requestDump( const char * reason );
+
+	//! Pause between dumps, so a series of xruns doesn't flood the disk
+	static const int DumpInterval = 10000;
+
+
+private slots:
+	void dumpIfRequested();
+
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct WorkerStats
+	{
+		quint16 jobs;
+		JobRecord longestJobs[MaxLongestJobs];
+	} ;
+
+	static void insertJob( JobRecord * jobs, const JobRecord & record );
+	void dump( const char * reason );
+
+	std::atomic_bool m_enabled;
+	Clock::time_point m_begin;
+	Clock::time_point m_periodStart;
+
+	Period m_periods[Capacity];
+	// even when the period is consistent, odd while it's being written
+	std::atomic<quint32> m_sequence[Capacity];
+	std::atomic<quint64> m_written;
+
+	// padded, as every worker writes its own stats
+	struct alignas( 64 ) PaddedWorkerStats
+	{
+		WorkerStats stats;
+	} ;
+	PaddedWorkerStats m_workers[MaxWorkers];
+
+	std::atomic<const char *> m_dumpReason;
+	QTimer m_dumpTimer;
+	Clock::time_point m_lastDump;
+	bool m_dumped;
+
+} ;
+
+
+#endif
@@ -27,34 +27,201 @@
 
 #include <QFile>
 
+#include <atomic>
+#include <chrono>
+
 #include "lmms_basics.h"
+#include "lmms_export.h"
 #include "MicroTimer.h"
+#include "MixerFlightRecorder.h"
 
-class MixerProfiler
+class LMMS_EXPORT MixerProfiler
 {
 public:
+	enum Stages
+	{
+		StageSong,		// creating play handles for the period
+		StagePlayHandles,	// stage 1: rendering the play handles
+		StageAudioPorts,	// stage 2: effects of the tracks
+		StageMasterMix,		// stage 3: FX mixer
+		StageCount
+	} ;
+
+	//! Name of @p stage in reports, e.g. "play_handles"
+	static const char * stageName( Stages stage );
+
+	//! Processing time accumulated by an object (e.g. a track or an effect)
+	//! in nanoseconds. Several threads may add to it at the same time.
+	class TimeCounter
+	{
+	public:
+		TimeCounter() :
+			m_total( 0 )
+		{
+		}
+
+		void add( quint64 nanoseconds )
+		{
+			m_total.fetch_add( nanoseconds, std::memory_order_relaxed );
+		}
+
+		quint64 total() const
+		{
+			return m_total.load( std::memory_order_relaxed );
+		}
+
+	private:
+		std::atomic<quint64> m_total;
+	} ;
+
+	//! Samples in or close to the denormal range (non-zero with a magnitude
+	//! below DenormalThreshold) in the output of an object. These are
+	//! decaying tails which cost a lot of CPU time wherever flushing
+	//! denormals to zero isn't in effect, e.g. in remote plugins or on
+	//! CPUs without DAZ, and keep feedback paths busy computing nothing.
+	class DenormalCounter
+	{
+	public:
+		DenormalCounter() :
+			m_total( 0 )
+		{
+		}
+
+		void add( quint64 samples )
+		{
+			m_total.fetch_add( samples, std::memory_order_relaxed );
+		}
+
+		quint64 total() const
+		{
+			return m_total.load( std::memory_order_relaxed );
+		}
+
+	private:
+		std::atomic<quint64> m_total;
+	} ;
+
+	static constexpr float DenormalThreshold = 1e-30f;
+
+	//! Adds the samples in @p samples which are in denormal range to
+	//! @p counter, if denormal checking is enabled
+	static void countDenormals( DenormalCounter * counter,
+					const float * samples, int count )
+	{
+		if( denormalCheckEnabled() )
+		{
+			counter->add( denormalSamples( samples, count ) );
+		}
+	}
+
+	static int denormalSamples( const float * samples, int count );
+
+	//! Adds the time from its construction to its destruction to a counter.
+	//! Does nothing if @p counter is null or detailed profiling is off.
+	class Probe
+	{
+	public:
+		Probe( TimeCounter * counter, bool enabled = detailsEnabled() ) :
+			m_counter( enabled ? counter : nullptr )
+		{
+			if( m_counter )
+			{
+				m_begin = Clock::now();
+			}
+		}
+
+		~Probe()
+		{
+			if( m_counter )
+			{
+				m_counter->add( std::chrono::duration_cast<std::chrono::nanoseconds>(
+							Clock::now() - m_begin ).count() );
+			}
+		}
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		TimeCounter * m_counter;
+		Clock::time_point m_begin;
+	} ;
+
 	MixerProfiler();
 	~MixerProfiler();
 
 	void startPeriod()
 	{
 		m_periodTimer.reset();
+		m_flightRecorder.startPeriod();
 	}
 
-	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod );
+	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod,
+							int playHandles = 0 );
 
 	int cpuLoad() const
 	{
 		return m_cpuLoad;
 	}
 
+	//! The stages are always profiled
+	TimeCounter & stageTime( Stages stage )
+	{
+		return m_stageTime[stage];
+	}
+
+	//! Share of the period spent in @p stage, in percent
+	int stageLoad( Stages stage ) const
+	{
+		return m_stageLoad[stage];
+	}
+
+	//! Enable profiling of tracks, effects and FX channels. This adds two
+	//! clock reads per object and period, so it's only enabled while
+	//! someone is looking.
+	static void setDetailsEnabled( bool enabled )
+	{
+		s_detailsEnabled = enabled;
+	}
+
+	static bool detailsEnabled()
+	{
+		return s_detailsEnabled.load( std::memory_order_relaxed );
+	}
+
+	//! Enable counting samples in denormal range in the output of tracks
+	//! and effects, see DenormalCounter
+	static void setDenormalCheckEnabled( bool enabled )
+	{
+		s_denormalCheckEnabled = enabled;
+	}
+
+	static bool denormalCheckEnabled()
+	{
+		return s_denormalCheckEnabled.load( std::memory_order_relaxed );
+	}
+
 	void setOutputFile( const QString& outputFile );
 
+	//! The most memory the process has used so far, in KiB
+	static quint64 peakMemoryKiB();
+
+	MixerFlightRecorder & flightRecorder()
+	{
+		return m_flightRecorder;
+	}
+
 
 private:
 	MicroTimer m_periodTimer;
 	int m_cpuLoad;
+	TimeCounter m_stageTime[StageCount];
+	quint64 m_lastStageTime[StageCount];
+	int m_stageLoad[StageCount];
 	QFile m_outputFile;
+	MixerFlightRecorder m_flightRecorder;
+
+	static std::atomic_bool s_detailsEnabled;
+	static std::atomic_bool s_denormalCheckEnabled;
 
 };
 
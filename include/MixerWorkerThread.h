@@ -26,6 +26,7 @@
 #define MIXER_WORKER_THREAD_H
 
 #include <QtCore/QThread>
+#include <QtCore/QVector>
 
 #include <atomic>
 
@@ -72,22 +73,123 @@ public:
 
 	} ;
 
+	// per-worker job queues - every worker takes jobs from its own queue
+	// first and steals from the other workers' queues when it runs dry, so
+	// the workers don't fight over a single shared index
+	class WorkStealingQueue
+	{
+	public:
+		WorkStealingQueue();
+		~WorkStealingQueue();
+
+		void init( int numWorkers );
+
+		void reset( JobQueue::OperationMode _opMode );
+
+		void addJob( ThreadableJob * _job );
+
+		void run( int worker );
+		void wait();
+
+	private:
+#define JOB_QUEUE_CACHE_LINE 64
+		struct WorkerQueue
+		{
+			WorkerQueue();
+
+			bool push( ThreadableJob * _job );
+			ThreadableJob * pop();
+
+			std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
+			// head, tail and done counters grow monotonically and are
+			// kept on separate cache lines
+			std::atomic<unsigned int> m_head;
+			char m_pad0[JOB_QUEUE_CACHE_LINE - sizeof( std::atomic<unsigned int> )];
+			std::atomic<unsigned int> m_tail;
+			char m_pad1[JOB_QUEUE_CACHE_LINE - sizeof( std::atomic<unsigned int> )];
+			std::atomic<unsigned int> m_itemsDone;
+			char m_pad2[JOB_QUEUE_CACHE_LINE - sizeof( std::atomic<unsigned int> )];
+		} ;
+
+		bool allDone() const;
+
+		WorkerQueue * m_queues;
+		int m_numQueues;
+		int m_nextQueue;
+		JobQueue::OperationMode m_opMode;
+
+	} ;
+
+
+	enum SchedulingPolicies
+	{
+		SchedulingDefault,	// leave it to the OS (with high priority)
+		SchedulingFifo,		// realtime, SCHED_FIFO (MMCSS on Windows)
+		SchedulingRoundRobin	// realtime, SCHED_RR (MMCSS on Windows)
+	} ;
+
+	// how worker threads are placed and prioritized
+	struct ThreadSettings
+	{
+		ThreadSettings() :
+			numWorkers( 0 ),
+			policy( SchedulingDefault ),
+			priority( 0 )
+		{
+		}
+
+		//! Read the settings from section "mixer" of the configuration
+		static ThreadSettings fromConfig();
+
+		//! Parse CPU masks like "0;1;2-3,6" - one mask per worker,
+		//! separated by semicolons, each a list of CPUs or ranges of CPUs
+		static QVector<quint64> parseAffinity( const QString & text );
+
+		// number of worker threads to start, 0 for one less than CPUs
+		int numWorkers;
+		SchedulingPolicies policy;
+		// realtime priority, 0 for the middle of the policy's range
+		int priority;
+		// CPUs each worker may run on, workers without a mask aren't pinned
+		QVector<quint64> affinity;
+	} ;
 
 	MixerWorkerThread( Mixer* mixer );
 	virtual ~MixerWorkerThread();
 
 	virtual void quit();
 
-	static void resetJobQueue( JobQueue::OperationMode _opMode =
-													JobQueue::Static )
+	//! Select the job scheduler - must be called before any worker thread
+	//! is created
+	static void setWorkStealing( bool enabled, int numWorkers );
+
+	static bool workStealing()
 	{
-		globalJobQueue.reset( _opMode );
+		return s_workStealing;
 	}
 
-	static void addJob( ThreadableJob * _job )
+	//! Makes the calling thread queue its jobs in @p queue and run them
+	//! itself while it exists, instead of handing them to the worker
+	//! threads. The mixers of the engine contexts besides the main one
+	//! render this way, so they never wait for the workers or each other.
+	//! A null @p queue uses the worker threads.
+	class InlineJobs
 	{
-		globalJobQueue.addJob( _job );
-	}
+	public:
+		explicit InlineJobs( JobQueue * queue );
+		~InlineJobs();
+
+		InlineJobs( const InlineJobs & ) = delete;
+		InlineJobs & operator=( const InlineJobs & ) = delete;
+
+	private:
+		JobQueue * m_previous;
+	} ;
+
+	static void resetJobQueue( JobQueue::OperationMode _opMode =
+													JobQueue::Static );
+
+	static void addJob( ThreadableJob * _job );
 
 	// a convenient helper function allowing to pass a container with pointers
 	// to ThreadableJob objects
@@ -104,14 +206,44 @@ public:
 
 	static void startAndWaitForJobs();
 
+	//! Whether a job may add jobs it waits for itself. This is the case
+	//! within a job run by the work-stealing scheduler, which keeps
+	//! processing until every job added is done.
+	static bool canAddSubJobs();
+
+	//! Whether the calling thread is one of the worker threads
+	static bool isWorkerThread();
+
+	//! Set how worker threads started afterwards are placed and prioritized
+	static void setThreadSettings( const ThreadSettings & settings );
+
+	static const ThreadSettings & threadSettings()
+	{
+		return s_threadSettings;
+	}
+
+	//! Describe what the running worker threads actually got, as settings
+	//! fail gracefully if e.g. the permissions are missing
+	static QString appliedThreadSettings();
+
 
 private:
 	void run() override;
 
+	// pin and prioritize the calling worker thread
+	void applyThreadSettings();
+
 	static JobQueue globalJobQueue;
+	static WorkStealingQueue workStealingQueue;
+	static bool s_workStealing;
 	static QWaitCondition * queueReadyWaitCond;
 	static QList<MixerWorkerThread *> workerThreads;
+	static ThreadSettings s_threadSettings;
+	static std::atomic_int s_startedWorkers;
+	static std::atomic_int s_pinnedWorkers;
+	static std::atomic_int s_realtimeWorkers;
 
+	int m_index;
 	volatile bool m_quit;
 
 } ;
@@ -25,7 +25,10 @@
 #ifndef MODEL_VIEW_H
 #define MODEL_VIEW_H
 
+#include <atomic>
+
 #include <QtCore/QPointer>
+#include <QtCore/QSet>
 #include "Model.h"
 
 
@@ -60,6 +63,11 @@ public:
 		return dynamic_cast<const T*>( model() );
 	}
 
+	//! Refreshes the visible views whose model changed outside the GUI
+	//! thread, or while they were hidden, since the last call; called
+	//! periodically by the GUI
+	static void updateChangedViews();
+
 
 protected:
 	// sub-classes can re-implement this to track model-changes
@@ -67,6 +75,12 @@ protected:
 	{
 	}
 
+	//! Called on the GUI thread when the data of the model changed; changes
+	//! from other threads, like automation, are batched, so this is called
+	//! at most once per updateChangedViews(). Not called while the view is
+	//! hidden, e.g. in a closed or minimized window, but once it is shown.
+	virtual void modelDataChanged();
+
 	QWidget* widget()
 	{
 		return m_widget;
@@ -76,8 +90,19 @@ protected:
 
 
 private:
+	//! Connected to Model::dataChanged() on the thread emitting it
+	void markDataChanged();
+
 	QWidget* m_widget;
 	QPointer<Model> m_model;
+	std::atomic<bool> m_dataChanged;
+
+	// all views, only accessed from the GUI thread
+	static QSet<ModelView*> s_views;
+	//! set whenever a view is marked as changed
+	static std::atomic<bool> s_anyChanged;
+	//! a hidden view waits to be refreshed, only accessed from the GUI thread
+	static bool s_hiddenChanged;
 
 } ;
 
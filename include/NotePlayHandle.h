@@ -34,7 +34,6 @@
 #include "Track.h"
 #include "MemoryManager.h"
 
-class QReadWriteLock;
 class InstrumentTrack;
 class NotePlayHandle;
 
@@ -49,6 +48,22 @@ public:
 	void * m_pluginData;
 	std::unique_ptr<BasicFilters<>> m_filter;
 
+	// sound shaping deferred by InstrumentSoundShaping::scheduleNote()
+	struct ScheduledShaping
+	{
+		bool pending;
+		f_cnt_t offset;
+		fpp_t frames;
+		f_cnt_t envTotalFrames;
+		f_cnt_t envReleaseBegin;
+	} m_scheduledShaping;
+
+	// set for the periods the note is played by Instrument::playVoices()
+	// together with the other notes of the track instead of in a buffer
+	// of its own, and until it has been played in such a period
+	bool m_playsAsVoice;
+	bool m_voicePending;
+
 	// length of the declicking fade in
 	fpp_t m_fadeInLength;
 
@@ -107,6 +122,8 @@ public:
 		return m_unpitchedFrequency;
 	}
 
+	void doProcessing() override;
+
 	/*! Renders one chunk using the attached instrument into the buffer */
 	void play( sampleFrame* buffer ) override;
 
@@ -164,6 +181,23 @@ public:
 		return m_releaseStarted;
 	}
 
+	/*! Ends the note (and its sub-notes) with a short fade instead of the
+	    release, used when its voice is stolen */
+	void steal();
+
+	/*! Returns whether the voice of the note was stolen */
+	bool isStolen() const
+	{
+		return m_stolen;
+	}
+
+	/*! Fades out the frames of a stolen note rendered in this period */
+	void applyStealFade( sampleFrame * buf, const fpp_t frames ) const;
+
+	/*! Returns how loud the note currently is, from its volume and the
+	    volume envelope, used for picking voices to steal */
+	float audibility();
+
 	/*! Returns total numbers of frames played so far */
 	f_cnt_t totalFramesPlayed() const
 	{
@@ -306,6 +340,11 @@ private:
 	NotePlayHandleList m_subNotes;			// used for chords and arpeggios
 	volatile bool m_released;				// indicates whether note is released
 	bool m_releaseStarted;
+	bool m_stolen;							// indicates whether voice was stolen
+	f_cnt_t m_stealFramesLeft;				// frames left of the fade of a
+											// stolen note
+	f_cnt_t m_stealFadeFrom;				// m_stealFramesLeft at the
+											// beginning of the period
 	bool m_hasMidiNote;
 	bool m_hasParent;						// indicates whether note has parent
 	NotePlayHandle * m_parent;			// parent note
@@ -332,14 +371,24 @@ private:
 } ;
 
 
-const int INITIAL_NPH_CACHE = 256;
-const int NPH_CACHE_INCREMENT = 16;
+//! Number of handles the pool holds before the config is read
+const int DEFAULT_NPH_POOL_SIZE = 512;
 
+/*! Pool of NotePlayHandles.
+ *
+ * Handles are preallocated up to the polyphony budget and kept on a
+ * lock-free free list.  Every thread caches a few handles of its own, so
+ * acquire() and release() usually don't touch shared state at all.  If the
+ * budget is exhausted the pool grows by another chunk; that allocation is
+ * the only non-realtime-safe path and is counted in overflows().
+ */
 class NotePlayHandleManager
 {
 	MM_OPERATORS
 public:
 	static void init();
+	//! Grows the pool to hold at least @p handles handles
+	static void reserve( int handles );
 	static NotePlayHandle * acquire( InstrumentTrack* instrumentTrack,
 					const f_cnt_t offset,
 					const f_cnt_t frames,
@@ -348,14 +397,16 @@ public:
 					int midiEventChannel = -1,
 					NotePlayHandle::Origin origin = NotePlayHandle::OriginPattern );
 	static void release( NotePlayHandle * nph );
-	static void extend( int i );
 	static void free();
 
-private:
-	static NotePlayHandle ** s_available;
-	static QReadWriteLock s_mutex;
-	static std::atomic_int s_availableIndex;
-	static int s_size;
+	//! Number of handles allocated so far
+	static int capacity();
+	//! Number of handles currently playing
+	static int inUse();
+	//! Largest number of handles that were in use at the same time
+	static int highWaterMark();
+	//! How often the pool had to grow while acquiring a handle
+	static int overflows();
 };
 
 
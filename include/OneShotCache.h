@@ -0,0 +1,148 @@
+/*
+ * OneShotCache.h - keeps the one-shots of instruments which sound the same
+ *                  on every hit
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef ONE_SHOT_CACHE_H
+#define ONE_SHOT_CACHE_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+#include "MemoryManager.h"
+
+
+/*! \brief Keeps what the notes of a percussive instrument rendered, for
+ *  the next notes with the same parameters and pitch
+ *
+ *  A one-shot is recorded while the first note plays it, and only as far
+ *  as some note played it. The notes after that copy the frames rather
+ *  than render them again, and only render what no note played yet.
+ *
+ *  The instrument hashes whatever its sound depends on into the key, so
+ *  it has to be deterministic: random or automated parameters have to
+ *  bypass the cache with uncached(). The instrument clear()s it when its
+ *  parameters change. Notes which play already keep their one-shot.
+ *
+ *  Used by Kicker and sfxr if enabled in the settings, see
+ *  Mixer::oneShotCaching().
+ */
+class LMMS_EXPORT OneShotCache
+{
+public:
+	static const int MaxTakes = 16;
+	static const f_cnt_t ChunkFrames = 4096;
+
+	//! Renders a one-shot, the way the instrument would for a note
+	class Recorder
+	{
+	public:
+		virtual ~Recorder() = default;
+
+		//! Renders the next @p frames frames. Returns the index of the
+		//! frame after which the one-shot is over, @p frames if it goes
+		//! on.
+		virtual f_cnt_t render(sampleFrame * buf, f_cnt_t frames) = 0;
+	} ;
+
+	class Take;
+	typedef std::shared_ptr<Take> TakePtr;
+
+	//! A note playing a one-shot
+	class Player
+	{
+		MM_OPERATORS
+	public:
+		Player(const TakePtr & take) :
+			m_take(take),
+			m_position(0)
+		{
+		}
+
+		void play(sampleFrame * out, f_cnt_t frames);
+
+		//! Whether the one-shot was over in the frames played so far
+		bool isOver() const;
+
+	private:
+		TakePtr m_take;
+		f_cnt_t m_position;
+	} ;
+
+	OneShotCache() = default;
+	~OneShotCache();
+
+	//! The one-shot of @p key, or nullptr if it isn't recorded yet
+	TakePtr find(const QByteArray & key);
+
+	//! Records the one-shot of @p key with @p recorder, which it takes.
+	//! If another note got there first, that one-shot is returned.
+	TakePtr insert(const QByteArray & key, Recorder * recorder);
+
+	//! A one-shot rendered by @p recorder for a single note, which is
+	//! not kept
+	static TakePtr uncached(Recorder * recorder);
+
+	void clear();
+
+private:
+	QMutex m_mutex;
+	// the most recently used last
+	std::vector<std::pair<QByteArray, TakePtr> > m_takes;
+
+} ;
+
+
+
+
+class LMMS_EXPORT OneShotCache::Take
+{
+public:
+	Take(Recorder * recorder, bool keep);
+	~Take();
+
+	//! Copies the frames from @p position on, rendering what wasn't yet
+	void read(f_cnt_t position, sampleFrame * out, f_cnt_t frames);
+
+	//! The frames until the one-shot is over, -1 if that didn't happen
+	//! in what was rendered so far
+	f_cnt_t end();
+
+private:
+	QMutex m_mutex;
+	std::unique_ptr<Recorder> m_recorder;
+	const bool m_keep;
+	std::vector<sampleFrame *> m_chunks;
+	f_cnt_t m_frames;
+	f_cnt_t m_end;
+
+} ;
+
+
+#endif
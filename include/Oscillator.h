@@ -95,6 +95,13 @@ public:
 		return sinf( _sample * F_2PI );
 	}
 
+	//! Polynomial approximation of sinSample(), accurate to about 1e-6. It
+	//! has no branches or calls, so loops using it can be vectorized.
+	static inline sample_t fastSinSample( const float _sample )
+	{
+		return fastSin2Pi( _sample );
+	}
+
 	static inline sample_t triangleSample( const float _sample )
 	{
 		const float ph = absFraction( _sample );
@@ -148,6 +155,12 @@ public:
 		return 1.0f - fast_rand() * 2.0f / FAST_RAND_MAX;
 	}
 
+	//! Computes one of the built-in waves for all phases, specialized per
+	//! shape so the loops can be vectorized; for users without an
+	//! oscillator such as LFOs. Gives silence for UserDefinedWave.
+	static void waveBlock( const WaveShapes _shape, const float * _phases,
+						float * _out, const int _frames );
+
 	inline sample_t userWaveSample( const float _sample ) const
 	{
 		return m_userWave->userWaveSample( _sample );
@@ -206,6 +219,18 @@ private:
 	template<WaveShapes W>
 	inline sample_t getSample( const float _sample );
 
+	// the update functions work on blocks of this many frames: first all
+	// phases of a block are computed, then the waveform for all of them
+	static const int BlockSize = 64;
+
+	//! Fill phases with m_phase advanced by osc_coeff per frame
+	inline void phaseBlock( float * _phases, const float _osc_coeff,
+							const int _frames );
+	//! Compute the wave for all phases, specialized for vectorization
+	template<WaveShapes W>
+	inline void waveBlock( const float * _phases, float * _out,
+							const int _frames );
+
 	inline void recalcPhase();
 
 } ;
@@ -30,6 +30,7 @@
 #include <QPixmap>
 
 #include "lmms_basics.h"
+#include "VisualizationTap.h"
 
 
 class Oscilloscope : public QWidget
@@ -56,9 +57,6 @@ protected:
 	void mousePressEvent( QMouseEvent * _me ) override;
 
 
-protected slots:
-	void updateAudioBuffer( const surroundSampleFrame * buffer );
-
 private:
 	QColor const & determineLineColor(float level) const;
 
@@ -66,7 +64,8 @@ private:
 	QPixmap m_background;
 	QPointF * m_points;
 
-	sampleFrame * m_buffer;
+	// the latest period of the master output, owned by the mixer's tap
+	const VisualizationTap::Snapshot * m_snapshot;
 	bool m_active;
 
 	QColor m_normalColor;
@@ -27,6 +27,7 @@
 #define OUTPUT_SETTINGS_H
 
 #include "lmms_basics.h"
+#include "SampleConversion.h"
 
 class OutputSettings
 {
@@ -74,7 +75,8 @@ public:
 		m_bitRateSettings(bitRateSettings),
 		m_bitDepth(bitDepth),
 		m_stereoMode(stereoMode),
-		m_compressionLevel(0.5)
+		m_compressionLevel(0.5),
+		m_dithering(SampleConversion::DitherNone)
 	{
 	}
 
@@ -104,12 +106,17 @@ public:
 		m_compressionLevel = level;
 	}
 
+	//! Applied when writing integer samples
+	SampleConversion::Dithering getDithering() const { return m_dithering; }
+	void setDithering(SampleConversion::Dithering dithering) { m_dithering = dithering; }
+
 private:
 	sample_rate_t m_sampleRate;
 	BitRateSettings m_bitRateSettings;
 	BitDepth m_bitDepth;
 	StereoMode m_stereoMode;
 	double m_compressionLevel;
+	SampleConversion::Dithering m_dithering;
 };
 
 #endif
@@ -0,0 +1,109 @@
+/*
+ * Oversampler.h - low-latency half-band oversampling for effects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef OVERSAMPLER_H
+#define OVERSAMPLER_H
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+#include "MemoryManager.h"
+
+
+/*! \brief Runs stereo audio at 2, 4 or 8 times the sample rate
+ *
+ *  Each doubling of the rate is a half-band filter built from two chains of
+ *  first-order allpass sections (a polyphase IIR), which has very low
+ *  latency and costs a few multiplications per sample. The stages after
+ *  the first one only have to separate the original band from its images
+ *  and so use shorter filters. Both channels and both polyphase branches
+ *  are processed side by side, which lets the compiler vectorize the
+ *  sections four lanes wide.
+ *
+ *  The buffers are allocated up front for a maximum number of frames, so
+ *  processing doesn't allocate.
+ */
+class LMMS_EXPORT Oversampler
+{
+	MM_OPERATORS
+public:
+	static const int MaxFactor = 8;
+
+	//! \param factor 1, 2, 4 or 8
+	//! \param maxFrames The most frames passed to up() at once
+	Oversampler( int factor, fpp_t maxFrames );
+	~Oversampler();
+
+	int factor() const
+	{
+		return m_factor;
+	}
+
+	//! Clears the filter states, e.g. after the audio was interrupted
+	void reset();
+
+	/*! \brief Upsample frames frames
+	 *
+	 *  Returns an internal buffer holding frames * factor() frames, which
+	 *  can be processed in place and then handed to down().
+	 */
+	sampleFrame * up( const sampleFrame * in, fpp_t frames );
+
+	/*! \brief Downsample frames * factor() frames from buf to frames frames
+	 *
+	 *  buf is used as scratch space. out may be the same as buf.
+	 */
+	void down( sampleFrame * buf, sampleFrame * out, fpp_t frames );
+
+private:
+	// the sections of one half-band filter of the up- or the downsampler,
+	// lanes 0/1 are the left/right channel of the even branch, lanes 2/3
+	// those of the odd branch
+	struct Stage
+	{
+		static const int MaxSections = 4;
+
+		int sections;
+		alignas( 16 ) float coefs[MaxSections][4];
+		alignas( 16 ) float x[MaxSections][4];
+		alignas( 16 ) float y[MaxSections][4];
+
+		void init( int stage );
+		void reset();
+		inline void process( float * lanes );
+	} ;
+
+	static const int MaxStages = 3;
+
+	int m_factor;
+	int m_stages;
+	fpp_t m_maxFrames;
+	Stage m_up[MaxStages];
+	Stage m_down[MaxStages];
+	// scratch buffers, the stages alternate between them
+	sampleFrame * m_buffers[2];
+
+} ;
+
+
+#endif
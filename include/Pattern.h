@@ -56,6 +56,8 @@ public:
 
 	// note management
 	Note * addNote( const Note & _new_note, const bool _quant_pos = true );
+	// adds all of _notes at once, sorting and updating only once
+	void addNotes( const QVector<Note> & _notes );
 
 	void removeNote( Note * _note_to_del );
 
@@ -69,6 +71,17 @@ public:
 		return m_notes;
 	}
 
+	inline int steps() const
+	{
+		return m_steps;
+	}
+
+	//! First of the (sorted) notes starting at @p pos or later. Playing
+	//! forward continues from the note found by the last call, other
+	//! positions, e.g. after seeking, are found by binary search. Only
+	//! to be called by the track while it's locked.
+	NoteVector::ConstIterator firstNoteFrom( const TimePos & pos ) const;
+
 	Note * addStepNote( int step );
 	void setStep( int step, bool enabled );
 
@@ -136,6 +149,9 @@ private:
 	NoteVector m_notes;
 	int m_steps;
 
+	// index of the note found by the last call of firstNoteFrom()
+	mutable int m_playCursor;
+
 	Pattern * adjacentPatternByOffset(int offset) const;
 
 	friend class PatternView;
@@ -78,6 +78,31 @@ protected:
 
 
 private:
+	//! What the thumbnail of the notes depends on
+	struct ThumbnailKey
+	{
+		QSize size;
+		int baseWidth;
+		tick_t length;
+		int textBoxHeight;
+		int steps;
+		bool muted;
+		bool displayBB;
+		QRgb noteFillColor;
+		QRgb noteBorderColor;
+		uint notes;
+
+		bool operator==( const ThumbnailKey & other ) const
+		{
+			return size == other.size && baseWidth == other.baseWidth &&
+				length == other.length && textBoxHeight == other.textBoxHeight &&
+				steps == other.steps && muted == other.muted &&
+				displayBB == other.displayBB &&
+				noteFillColor == other.noteFillColor &&
+				noteBorderColor == other.noteBorderColor && notes == other.notes;
+		}
+	} ;
+
 	static QPixmap * s_stepBtnOn0;
 	static QPixmap * s_stepBtnOn200;
 	static QPixmap * s_stepBtnOff;
@@ -85,6 +110,9 @@ private:
 
 	Pattern* m_pat;
 	QPixmap m_paintPixmap;
+	//! The notes, drawn over the background of m_paintPixmap
+	QPixmap m_thumbnail;
+	ThumbnailKey m_thumbnailKey;
 
 	QColor m_noteFillColor;
 	QColor m_noteBorderColor;
@@ -25,9 +25,13 @@
 #ifndef PERFLOG_H
 #define PERFLOG_H
 
+#include <atomic>
 #include <ctime>
 #include <QtCore/QString>
 
+#include "lmms_export.h"
+#include "lmmsconfig.h"
+
 /// \brief CPU time point
 ///
 /// Represents a point in CPU time (not wall-clock time) intended for measuring
@@ -70,4 +74,176 @@ class PerfLogTimer
 	PerfTime begin_time;
 };
 
+/// \brief Trace events of rendering, loading and painting
+///
+/// Built with WANT_DEBUG_TRACE, and only recording while started, e.g. by
+/// the --trace option. Every thread records the events it finishes into a
+/// buffer of its own without locking; a thread whose buffer is full drops
+/// its further events. write() exports all of them in the Trace Event
+/// Format of chrome://tracing and Perfetto, with a track per thread.
+/// Without WANT_DEBUG_TRACE, scopes compile to nothing.
+class LMMS_EXPORT PerfTrace
+{
+public:
+	enum Category
+	{
+		Render,
+		Job,
+		Effect,
+		RemotePlugin,
+		Sample,
+		Load,
+		Gui,
+		NumCategories
+	};
+
+	/// Events per thread, 2 MiB once a thread records
+	static const int BufferSize = 1 << 16;
+
+#ifdef LMMS_DEBUG_TRACE
+	/// Records the time from construction to destruction or finish()
+	class Scope
+	{
+	public:
+		/// \p name must be kept until the trace is written, e.g. a literal.
+		/// Names of the Job category are mangled type names.
+		Scope(const char* name, Category category) :
+			m_name(enabled() ? name : nullptr),
+			m_category(category),
+			m_begin(m_name ? now() : 0)
+		{
+		}
+
+		~Scope()
+		{
+			finish();
+		}
+
+		void finish()
+		{
+			if (m_name) { record(m_name, m_category, m_begin, now()); }
+			m_name = nullptr;
+		}
+
+	private:
+		const char* m_name;
+		Category m_category;
+		qint64 m_begin;
+	};
+
+	static bool enabled()
+	{
+		return s_enabled.load(std::memory_order_relaxed);
+	}
+
+	/// Starts recording, the events recorded before are kept
+	static void start();
+	static void stop();
+
+	/// Writes the events recorded so far to \p file
+	static bool write(const QString& file);
+
+	/// Names the calling thread's track, e.g. "Mixer"
+	static void setThreadName(const QString& name);
+
+	/// Nanoseconds since the process started tracing
+	static qint64 now();
+	static void record(const char* name, Category category, qint64 begin, qint64 end);
+
+private:
+	static std::atomic<bool> s_enabled;
+#else
+	class Scope
+	{
+	public:
+		Scope(const char*, Category)
+		{
+		}
+
+		void finish()
+		{
+		}
+	};
+
+	static bool enabled()
+	{
+		return false;
+	}
+
+	static void start()
+	{
+	}
+
+	static void stop()
+	{
+	}
+
+	static bool write(const QString&)
+	{
+		return false;
+	}
+
+	static void setThreadName(const QString&)
+	{
+	}
+#endif
+};
+
+/// \brief Nested wall-clock timings of startup and project loading
+///
+/// Only records while enabled by the --timeline or --timeline-trace
+/// options. Phases nest per thread; report() prints the phases finished
+/// since the last report as a tree and rewrites the trace file, which uses
+/// the Trace Event Format of chrome://tracing and Perfetto. Phases are
+/// PerfTrace events as well.
+class LMMS_EXPORT PerfTimeline
+{
+public:
+	/// Records the time from construction to destruction or finish()
+	class Phase
+	{
+	public:
+		/// \p name must be a literal, it is kept until the end
+		Phase(const char* name, PerfTrace::Category category = PerfTrace::Load) :
+			m_active(enabled()),
+			m_trace(name, category)
+		{
+			if (m_active) { begin(name); }
+		}
+
+		~Phase()
+		{
+			finish();
+		}
+
+		void finish()
+		{
+			if (m_active) { end(); }
+			m_active = false;
+			m_trace.finish();
+		}
+
+	private:
+		bool m_active;
+		PerfTrace::Scope m_trace;
+	};
+
+	static void setEnabled(bool enabled);
+	static bool enabled()
+	{
+		return s_enabled.load(std::memory_order_relaxed);
+	}
+	static void setTraceFile(const QString& file);
+
+	static void begin(const char* name);
+	static void end();
+
+	/// Does nothing while a phase is open on this thread, so a project
+	/// loaded during startup is part of the startup report
+	static void report();
+
+private:
+	static std::atomic<bool> s_enabled;
+};
+
 #endif
@@ -0,0 +1,173 @@
+/*
+ * PeriodBufferFifo.h - preallocated FIFO of period buffers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef PERIOD_BUFFER_FIFO_H
+#define PERIOD_BUFFER_FIFO_H
+
+#include <atomic>
+#include <vector>
+
+#include <QtCore/QSemaphore>
+
+#include "BufferManager.h"
+#include "lmms_basics.h"
+#include "RealtimeMemory.h"
+
+
+/*! \brief Single-producer single-consumer FIFO of period buffers
+ *
+ *  All buffers are allocated up front and passed around in place: the
+ *  producer acquires a free buffer, renders into it and publishes it, the
+ *  consumer reads it where it is and releases it. No buffer is allocated or
+ *  copied per period, and the positions are atomic counters; the
+ *  semaphores only count free and published buffers, so a side enters the
+ *  kernel only if it actually has to wait for the other one.
+ *
+ *  The producer may hold several acquired buffers at once; they are
+ *  published in the order they were acquired in.
+ */
+class PeriodBufferFifo
+{
+public:
+	//! \param depth The number of published buffers the producer may be ahead
+	//! \param frames The frames of each buffer
+	PeriodBufferFifo( int depth, fpp_t frames ) :
+		// one more buffer each for being rendered and being read
+		m_size( depth + 2 ),
+		m_frames( frames ),
+		m_free( m_size ),
+		m_published( 0 ),
+		m_acquireCount( 0 ),
+		m_publishCount( 0 ),
+		m_readCount( 0 ),
+		m_endCount( -1 )
+	{
+		for( int i = 0; i < m_size; ++i )
+		{
+			m_buffers.push_back( static_cast<surroundSampleFrame *>(
+				RealtimeMemory::allocate( frames * sizeof( surroundSampleFrame ) ) ) );
+			BufferManager::clear( m_buffers.back(), frames );
+		}
+	}
+
+	~PeriodBufferFifo()
+	{
+		for( surroundSampleFrame * buffer : m_buffers )
+		{
+			RealtimeMemory::release( buffer, m_frames * sizeof( surroundSampleFrame ) );
+		}
+	}
+
+	int depth() const
+	{
+		return m_size - 2;
+	}
+
+	//! Waits for a free buffer and returns it, cleared
+	surroundSampleFrame * acquire()
+	{
+		m_free.acquire();
+		surroundSampleFrame * buffer = m_buffers[m_acquireCount++ % m_size];
+		BufferManager::clear( buffer, m_frames );
+		return buffer;
+	}
+
+	//! Passes the oldest acquired buffer to the consumer
+	void publish()
+	{
+		m_publishCount.fetch_add( 1, std::memory_order_release );
+		m_published.release();
+	}
+
+	//! Gives the buffers acquired but not published back
+	void discardAcquired()
+	{
+		const int count = m_acquireCount - m_publishCount.load();
+		m_acquireCount -= count;
+		m_free.release( count );
+	}
+
+	//! Lets read() return nullptr once all buffers published so far are read
+	void publishEnd()
+	{
+		m_endCount.store( m_publishCount.load(), std::memory_order_release );
+		m_published.release();
+	}
+
+	//! Waits for a published buffer and returns it, or nullptr at the end;
+	//! the buffer stays valid until release()
+	const surroundSampleFrame * read()
+	{
+		m_published.acquire();
+		const long count = m_readCount.load( std::memory_order_relaxed );
+		if( count == m_endCount.load( std::memory_order_acquire ) )
+		{
+			m_endCount.store( -1, std::memory_order_relaxed );
+			return nullptr;
+		}
+		return m_buffers[count % m_size];
+	}
+
+	//! Gives the buffer returned by the last read() back to the producer
+	void release()
+	{
+		m_readCount.fetch_add( 1, std::memory_order_release );
+		m_free.release();
+	}
+
+	//! Returns whether read() would not wait
+	bool available() const
+	{
+		return m_published.available() > 0;
+	}
+
+	//! Waits until the consumer released all buffers
+	void waitUntilRead()
+	{
+		m_free.acquire( m_size );
+		m_free.release( m_size );
+	}
+
+
+private:
+	const int m_size;
+	const fpp_t m_frames;
+	std::vector<surroundSampleFrame *> m_buffers;
+
+	QSemaphore m_free;
+	QSemaphore m_published;
+
+	// only touched by the producer
+	long m_acquireCount;
+	std::atomic<long> m_publishCount;
+	// only touched by the consumer
+	std::atomic<long> m_readCount;
+	// value of m_readCount at which read() returns nullptr, or -1
+	std::atomic<long> m_endCount;
+
+} ;
+
+
+#endif
@@ -30,12 +30,15 @@
 #include <QVector>
 #include <QWidget>
 #include <QInputDialog>
+#include <QPixmap>
+#include <utility>
 
 #include "Editor.h"
 #include "ComboBoxModel.h"
 #include "SerializingObject.h"
 #include "Note.h"
 #include "lmms_basics.h"
+#include "MemoryUsage.h"
 #include "Song.h"
 #include "ToolTip.h"
 #include "StepRecorder.h"
@@ -186,8 +189,9 @@ protected slots:
 	bool toggleStepRecording();
 	void stop();
 
-	void startRecordNote( const Note & n );
-	void finishRecordNote( const Note & n );
+	//! Adds the notes played on the track while recording, or passes them
+	//! to the step recorder
+	void recordNotes();
 
 	void horScrolled( int new_pos );
 	void verScrolled( int new_pos );
@@ -200,6 +204,7 @@ protected slots:
 	bool deleteSelectedNotes();
 
 	void updatePosition(const TimePos & t );
+	void updateKeys();
 	void updatePositionAccompany(const TimePos & t );
 	void updatePositionStepRecording(const TimePos & t );
 
@@ -404,6 +409,41 @@ private:
 	int m_whiteKeyBigHeight;
 	int m_blackKeyHeight;
 
+	// what the grid behind the notes depends on
+	struct GridCacheKey
+	{
+		QSize size;
+		qreal pixelRatio;
+		int position;
+		int ppb;
+		int topKey;
+		int keyLineHeight;
+		int keysVisible;
+		int notesEditHeight;
+		int quantization;
+		int timeSigNumerator;
+		int timeSigDenominator;
+		QList<int> markedSemiTones;
+		QVector<QRgb> colors;
+
+		bool operator==( const GridCacheKey & other ) const;
+	} ;
+	// the grid is only drawn again when scrolling, zooming or resizing
+	// changed it, playing only draws the keys and notes on top
+	QPixmap m_gridCache;
+	GridCacheKey m_gridCacheKey;
+	MemoryUsage::Cache m_gridCacheUsage;
+
+	// whether the pattern's notes are sorted by position, and the longest
+	// one, for finding the visible notes without looking at all others.
+	// Updated on full repaints, which every edit causes.
+	bool m_notesSorted;
+	int m_longestNote;
+	void updateNoteIndex();
+	//! The notes which may be visible from tick @p from to tick @p to
+	std::pair<NoteVector::ConstIterator, NoteVector::ConstIterator>
+		notesInRange( int from, int to ) const;
+
 	// remember these values to use them
 	// for the next note that is set
 	TimePos m_lenOfNewNotes;
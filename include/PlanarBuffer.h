@@ -0,0 +1,136 @@
+/*
+ * PlanarBuffer.h - audio buffer with one contiguous array per channel
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PLANAR_BUFFER_H
+#define PLANAR_BUFFER_H
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+#include "MemoryManager.h"
+
+
+/*! \brief Non-owning view on one channel of an audio buffer
+ *
+ *  Works on both interleaved (sampleFrame) and planar buffers without
+ *  copying, so per-channel code can be written once for both layouts.
+ */
+class ChannelView
+{
+public:
+	ChannelView( sample_t * data, int stride ) :
+		m_data( data ),
+		m_stride( stride )
+	{
+	}
+
+	//! View on one channel of an interleaved buffer
+	static ChannelView ofInterleaved( sampleFrame * buf, ch_cnt_t channel )
+	{
+		return ChannelView( buf[0].data() + channel, DEFAULT_CHANNELS );
+	}
+
+	sample_t & operator[]( f_cnt_t frame ) const
+	{
+		return m_data[frame * m_stride];
+	}
+
+	//! Whether the samples can be accessed as a plain array via data()
+	bool isContiguous() const
+	{
+		return m_stride == 1;
+	}
+
+	sample_t * data() const
+	{
+		return m_data;
+	}
+
+	int stride() const
+	{
+		return m_stride;
+	}
+
+private:
+	sample_t * m_data;
+	int m_stride;
+} ;
+
+
+/*! \brief Audio buffer storing each channel in its own aligned array
+ *
+ *  Planar-native code (most plugin APIs and some audio drivers) can work on
+ *  channel() directly. Each channel starts at an Alignment byte boundary.
+ */
+class LMMS_EXPORT PlanarBuffer
+{
+	MM_OPERATORS
+public:
+	//! Alignment of each channel in bytes, enough for any SIMD register
+	static const int Alignment = 64;
+
+	PlanarBuffer( f_cnt_t frames );
+	~PlanarBuffer();
+
+	PlanarBuffer( const PlanarBuffer & ) = delete;
+	PlanarBuffer & operator=( const PlanarBuffer & ) = delete;
+
+	f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+	ch_cnt_t channels() const
+	{
+		return DEFAULT_CHANNELS;
+	}
+
+	sample_t * channel( ch_cnt_t ch )
+	{
+		return m_channels[ch];
+	}
+
+	const sample_t * channel( ch_cnt_t ch ) const
+	{
+		return m_channels[ch];
+	}
+
+	ChannelView channelView( ch_cnt_t ch )
+	{
+		return ChannelView( m_channels[ch], 1 );
+	}
+
+	void clear( f_cnt_t frames );
+
+	//! Copy frames from an interleaved buffer into the channels
+	void fromInterleaved( const sampleFrame * src, f_cnt_t frames );
+	//! Copy the first frames of all channels into an interleaved buffer
+	void toInterleaved( sampleFrame * dst, f_cnt_t frames ) const;
+
+private:
+	f_cnt_t m_frames;
+	void * m_memory;
+	sample_t * m_channels[DEFAULT_CHANNELS];
+} ;
+
+#endif
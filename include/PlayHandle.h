@@ -138,6 +138,11 @@ public:
 	{
 		return m_audioPort;
 	}
+
+	const AudioPort * audioPort() const
+	{
+		return m_audioPort;
+	}
 	
 	void setAudioPort( AudioPort * port )
 	{
@@ -157,6 +162,17 @@ private:
 	bool m_bufferReleased;
 	bool m_usesBuffer;
 	AudioPort * m_audioPort;
+
+	// position in the play handle lists of the mixer and the audio port, so
+	// the handle can be removed from them in constant time (-1 if not in
+	// there)
+	int m_mixerIndex;
+	int m_portIndex;
+	// set if the mixer should remove the handle at the next opportunity
+	bool m_removalRequested;
+
+	friend class AudioPort;
+	friend class Mixer;
 } ;
 
 
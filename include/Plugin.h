@@ -39,6 +39,7 @@ class QWidget;
 class PixmapLoader;
 class PluginView;
 class AutomatableModel;
+class RemotePlugin;
 
 /**
 	Abstract representation of a plugin
@@ -273,6 +274,31 @@ public:
 	//! reference the class header.  Should return null if not key not found.
 	virtual AutomatableModel* childModel( const QString & modelName );
 
+	//! Return true if the output only depends on the settings and on the
+	//! notes or input of the last few bars, so a song can be rendered in
+	//! segments starting after a short pre-roll, see SegmentRenderer.
+	//! Plugins with longer state, e.g. long delay lines or free-running
+	//! LFOs, must not opt in.
+	virtual bool isResettable() const
+	{
+		return false;
+	}
+
+	//! The process the plugin runs in if it isn't loaded into LMMS, for
+	//! its statistics to be shown
+	virtual RemotePlugin * remotePlugin() const
+	{
+		return nullptr;
+	}
+
+	//! The memory the plugin holds in LMMS, e.g. its samples, delay lines
+	//! or FFT buffers, for the memory statistics. The memory of a remote
+	//! process is taken from remotePlugin().
+	virtual qint64 memoryUsage() const
+	{
+		return 0;
+	}
+
 	//! Overload if the argument passed to the plugin is a subPluginKey
 	//! If you can not pass the key and are aware that it's stored in
 	//! Engine::pickDndPluginKey(), use this function, too
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <QtCore/QFileInfo>
 #include <QtCore/QHash>
@@ -81,8 +82,9 @@ public:
 
 	/// Returns the PluginInfo object of the plugin with the given name.
 	/// If the plugin is not found, an empty PluginInfo is returned (use
-	/// PluginInfo::isNull() to check this).
-	const PluginInfo pluginInfo(const char* name) const;
+	/// PluginInfo::isNull() to check this). Libraries known from the index
+	/// of plugins aren't loaded by discoverPlugins(), but here.
+	const PluginInfo pluginInfo(const char* name);
 
 	/// When loading a library fails during discovery, the error string is saved.
 	/// It can be retrieved by calling this function.
@@ -92,6 +94,12 @@ public slots:
 	void discoverPlugins();
 
 private:
+	struct IndexedPlugin;
+
+	//! Loads @p library, and everything found if that fails, as libraries
+	//! like ZynAddSubFxCore are only found once loaded
+	bool loadLibrary(QLibrary& library);
+
 	DescriptorMap m_descriptors;
 	PluginInfoList m_pluginInfos;
 
@@ -100,6 +108,11 @@ private:
 
 	QHash<QString, QString> m_errors;
 
+	QList<QFileInfo> m_libraryFiles;
+	bool m_loadedAllLibraries = false;
+	//! The descriptors of plugins taken from the index
+	std::vector<std::unique_ptr<IndexedPlugin>> m_indexedPlugins;
+
 	static std::unique_ptr<PluginFactory> s_instance;
 };
 
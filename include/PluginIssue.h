@@ -72,6 +72,7 @@ public:
 	{
 	}
 	PluginIssueType type() const { return m_issueType; }
+	const std::string& info() const { return m_info; }
 	bool operator==(const PluginIssue& other) const;
 	bool operator<(const PluginIssue& other) const;
 	friend QDebug operator<<(QDebug stream, const PluginIssue& iss);
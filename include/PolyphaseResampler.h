@@ -0,0 +1,113 @@
+/*
+ * PolyphaseResampler.h - fixed-ratio resampler for streams
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+#include "SincResampler.h"
+
+
+/*! \brief Resampler for a stream at a fixed rational ratio
+ *
+ *  Converts by the ratio up / down of the two rates, reduced, with a
+ *  Kaiser-windowed sinc split into one set of taps per phase. Only the
+ *  outputs are computed, so decimating by an integer factor, e.g. from the
+ *  oversampled processing rate to the device rate, has a single phase and
+ *  costs one dot product per output frame.
+ *
+ *  The history is kept planar so the dot products run over contiguous
+ *  memory. Nothing is allocated while processing up to the number of
+ *  frames passed to setup().
+ */
+class LMMS_EXPORT PolyphaseResampler
+{
+public:
+	//! The most phases setup() accepts; rates with a larger reduced ratio
+	//! are left to a variable-ratio resampler
+	static const int MaxPhases = 1024;
+
+	PolyphaseResampler();
+
+	//! Prepare converting from inputRate to outputRate, clearing the
+	//! history; returns false if the ratio needs too many phases
+	bool setup( sample_rate_t inputRate, sample_rate_t outputRate,
+			SincResampler::Quality quality, fpp_t maxFrames );
+
+	//! Whether the resampler is set up for exactly these parameters
+	bool isSetUpFor( sample_rate_t inputRate, sample_rate_t outputRate,
+					SincResampler::Quality quality ) const
+	{
+		return m_up > 0 && m_inputRate == inputRate &&
+			m_outputRate == outputRate && m_quality == quality;
+	}
+
+	//! Forget the history, as after setup()
+	void reset();
+
+	/*! \brief Resample the next frames of the stream
+	 *
+	 *  Writes at most maxOut frames to out and returns how many. Input
+	 *  that doesn't fit is kept for the next call, up to the maxFrames
+	 *  given to setup().
+	 */
+	fpp_t process( const surroundSampleFrame * in, fpp_t frames,
+				surroundSampleFrame * out, fpp_t maxOut );
+
+	//! The delay of the filter, in input frames
+	double latency() const
+	{
+		return m_up > 0 ? ( m_taps * m_up - 1 ) / ( 2.0 * m_up ) : 0.0;
+	}
+
+private:
+	sample_rate_t m_inputRate;
+	sample_rate_t m_outputRate;
+	SincResampler::Quality m_quality;
+
+	// the reduced ratio, output frames per input frames
+	int m_up;
+	int m_down;
+	// taps per phase
+	int m_taps;
+	// the taps of each phase, reversed to run forward over the history
+	std::vector<float> m_coeffs;
+
+	// the last input frames, one buffer per channel
+	std::vector<float> m_history[SURROUND_CHANNELS];
+	f_cnt_t m_historyFrames;
+	f_cnt_t m_maxRetained;
+	// position of the next output, in 1 / m_up input frames from the
+	// start of the history
+	int64_t m_position;
+
+} ;
+
+
+#endif
@@ -25,7 +25,9 @@
 #ifndef PROJECT_JOURNAL_H
 #define PROJECT_JOURNAL_H
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtCore/QStack>
 
 #include "lmms_basics.h"
@@ -39,6 +41,8 @@ class ProjectJournal
 {
 public:
 	static const int MAX_UNDO_STATES;
+	//! The default of the memory limit of the undo history, in MiB
+	static const int DEFAULT_MAX_UNDO_MEMORY;
 
 	ProjectJournal();
 	virtual ~ProjectJournal();
@@ -49,6 +53,9 @@ public:
 	bool canUndo() const;
 	bool canRedo() const;
 
+	//! The memory taken by the undo and redo checkpoints
+	qint64 memoryUsage() const;
+
 	void addJournalCheckPoint( JournallingObject *jo );
 
 	bool isJournalling() const
@@ -82,6 +89,10 @@ public:
 	//! hack, not used when loading a savefile
 	static jo_id_t idFromSave( jo_id_t id );
 
+	//! The IDs of the objects changed through the journal since the last
+	//! call, including undo and redo, and of the models they belong to
+	QSet<jo_id_t> takeChangedIDs();
+
 	void clearJournal();
 	void stopAllJournalling();
 	JournallingObject * journallingObject( const jo_id_t _id )
@@ -99,20 +110,49 @@ private:
 
 	struct CheckPoint
 	{
-		CheckPoint( jo_id_t initID = 0, const DataFile& initData = DataFile( DataFile::JournalData ) ) :
+		CheckPoint( jo_id_t initID = 0, const QByteArray & initData = QByteArray(),
+							qint64 initTime = 0 ) :
 			joID( initID ),
-			data( initData )
+			data( initData ),
+			isDelta( false ),
+			prefix( 0 ),
+			suffix( 0 ),
+			time( initTime )
 		{
 		}
 		jo_id_t joID;
-		DataFile data;
+		//! The state, encoded by BinaryDocument. If isDelta is set, only the
+		//! bytes differing from the next newer checkpoint of the same
+		//! object, which share prefix bytes at the start and suffix at the end.
+		QByteArray data;
+		bool isDelta;
+		int prefix;
+		int suffix;
+		//! When it was added, in ms of m_clock
+		qint64 time;
 	} ;
 	typedef QStack<CheckPoint> CheckPointStack;
 
+	void markChanged( JournallingObject * jo );
+
+	static QByteArray saveState( JournallingObject * jo );
+	static void restoreState( JournallingObject * jo, const QByteArray & state );
+	//! Pushes a full checkpoint, the previous one of the object becomes a delta
+	void push( CheckPointStack & stack, jo_id_t id, const QByteArray & state );
+	//! Pops the top checkpoint, returns its full state
+	QByteArray pop( CheckPointStack & stack, jo_id_t & id );
+	//! Drops the oldest checkpoints over the limits
+	void trim();
+
 	JoIdMap m_joIDs;
 
 	CheckPointStack m_undoCheckPoints;
 	CheckPointStack m_redoCheckPoints;
+	// the most memory the checkpoints may take
+	int m_maxBytes;
+	QElapsedTimer m_clock;
+
+	QSet<jo_id_t> m_changedIDs;
 
 	bool m_journalling;
 
@@ -25,6 +25,11 @@
 #ifndef PROJECT_RENDERER_H
 #define PROJECT_RENDERER_H
 
+#include <QtCore/QJsonObject>
+
+#include <atomic>
+#include <chrono>
+
 #include "AudioFileDevice.h"
 #include "lmmsconfig.h"
 #include "Mixer.h"
@@ -55,6 +60,36 @@ public:
 		AudioFileDeviceInstantiaton m_getDevInst;
 	} ;
 
+	//! Throughput of an export, all times in seconds
+	struct Statistics
+	{
+		Statistics();
+
+		//! Song time rendered
+		double renderedTime;
+		//! Wall-clock time taken
+		double elapsedTime;
+		//! Estimated wall-clock time to finish, negative if unknown
+		double remainingTime;
+		//! Time the encoders took; they run in parallel to rendering
+		double encodingTime;
+		double stageTime[MixerProfiler::StageCount];
+		quint64 peakMemoryKiB;
+
+		//! Song time rendered per wall-clock time
+		double realtimeFactor() const
+		{
+			return elapsedTime > 0 ? renderedTime / elapsedTime : 0;
+		}
+
+		//! Add a later render pass, e.g. of another track
+		Statistics & operator+=( const Statistics & other );
+
+		QJsonObject toJson() const;
+		//! One line for progress displays, e.g. "12.3x realtime, 0:42 left"
+		QString summary() const;
+	} ;
+
 
 	ProjectRenderer( const Mixer::qualitySettings & _qs,
 				const OutputSettings & _os,
@@ -67,6 +102,20 @@ public:
 		return m_fileDev != NULL;
 	}
 
+	//! Also export to another file from the same render pass; call before
+	//! startProcessing(). Returns false if the file can't be opened.
+	bool addOutput( const OutputSettings & _os,
+				ExportFileFormats _file_format,
+				const QString & _out_file );
+
+	//! Export through @p device, the live audio device, which keeps
+	//! rendering with its audio server freewheeling, see
+	//! AudioDevice::startFreewheel(); call before startProcessing()
+	void setFreewheelDevice( AudioDevice * device )
+	{
+		m_freewheelDevice = device;
+	}
+
 	static ExportFileFormats getFileFormatFromExtension(
 							const QString & _ext );
 
@@ -74,6 +123,9 @@ public:
 
 	static const FileEncodeDevice fileEncodeDevices[];
 
+	//! Throughput so far; may be called while rendering
+	Statistics statistics() const;
+
 public slots:
 	void startProcessing();
 	void abortProcessing();
@@ -83,17 +135,37 @@ public slots:
 
 signals:
 	void progressChanged( int );
+	//! Emitted by startProcessing() once the mixer runs at the export
+	//! rate, before the first period is rendered
+	void processingPrepared();
 
 
 private:
+	//! Periods rendered ahead of the encoder
+	static const int EncoderQueueDepth = 32;
+
 	void run() override;
+	void runFreewheel();
+
+	Statistics currentStatistics() const;
 
 	AudioFileDevice * m_fileDev;
+	AudioDevice * m_freewheelDevice;
 	Mixer::qualitySettings m_qualitySettings;
 
 	volatile int m_progress;
 	volatile bool m_abort;
 
+	// set by startProcessing() before the thread runs
+	std::chrono::steady_clock::time_point m_startTime;
+	quint64 m_stageTimeAtStart[MixerProfiler::StageCount];
+	// updated by the thread each period
+	std::atomic<qint64> m_renderedFrames;
+	std::atomic<double> m_exportedFraction;
+	// taken at the end of run(), once m_finished is set
+	Statistics m_finalStatistics;
+	std::atomic_bool m_finished;
+
 } ;
 
 #endif
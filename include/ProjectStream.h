@@ -0,0 +1,128 @@
+/*
+ * ProjectStream.h - reads projects track by track
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef PROJECT_STREAM_H
+#define PROJECT_STREAM_H
+
+#include <map>
+#include <memory>
+#include <QDomDocument>
+#include <QFile>
+#include <QStringList>
+#include <QXmlStreamReader>
+
+#include "BlockCompression.h"
+#include "lmms_export.h"
+
+class DataFile;
+
+
+/*! \brief Loads a song project without holding all of its document.
+ *
+ *  The tracks of the song make up nearly all of a project, so they are
+ *  left out of dataFile() and parsed one at a time by nextTrack(), which
+ *  keeps only the current one. Everything else is read into dataFile()
+ *  first, as the FX mixer, which is saved after the tracks, has to be
+ *  loaded before them.
+ *
+ *  Only projects which need no upgrading can be read like this, as the
+ *  upgrade routines work on the whole document. Block compressed files
+ *  are uncompressed while they are read. Others, as well as files
+ *  written by qCompress() and .mmpb projects, are loaded as a DataFile, and
+ *  nextTrack() returns no tracks as they are in dataFile().
+ */
+class LMMS_EXPORT ProjectStream
+{
+public:
+	ProjectStream( const QString & fileName );
+	~ProjectStream();
+
+	//! Whether the tracks of the song are read by nextTrack()
+	bool isStreamed() const
+	{
+		return m_streamed;
+	}
+
+	//! The project, without the tracks of the song if it's streamed
+	DataFile & dataFile()
+	{
+		return *m_dataFile;
+	}
+
+	//! See DataFile::hasLocalPlugins()
+	bool hasLocalPlugins() const;
+	//! See DataFile::resourceFiles()
+	QStringList resourceFiles( const QString & tagName ) const;
+	//! The tracks in all track containers of the project
+	int trackCount() const;
+	//! Starts reading the files opened by the instruments, like
+	//! soundfonts and VST plugins, on all cores, so they are cached when
+	//! the tracks open them one after another
+	void readAheadPluginFiles() const;
+
+	//! The next track of the song, or a null element after the last one.
+	//! It's only valid until the next call.
+	QDomElement nextTrack();
+
+private:
+	//! Reads all but the tracks of the song into @p document, checking
+	//! the whole file on the way; returns false if it can't be streamed
+	bool readDataFile( QDomDocument & document );
+	//! Points the reader to the start of the file
+	bool rewind();
+	//! Checks the attributes of the element the reader is at
+	void scanElement( bool isRoot );
+
+	// the instruments opening files and the attributes naming them
+	static const std::map<QString, QStringList> PLUGIN_FILES;
+
+	bool m_streamed;
+	std::unique_ptr<DataFile> m_dataFile;
+
+	QFile m_file;
+	// uncompresses m_file for the reader if it's compressed
+	std::unique_ptr<BlockCompression::Reader> m_uncompressed;
+	QXmlStreamReader m_reader;
+	QString m_contentName;
+
+	bool m_hasLocalPlugins;
+	int m_trackCount;
+	std::map<QString, QStringList> m_resourceFiles;
+	QStringList m_pluginFiles;
+
+	// holds the current track inside copies of its parents, as some
+	// tracks look at them while loading
+	QDomDocument m_trackDocument;
+	QDomElement m_trackParent;
+	QDomElement m_track;
+	// the elements the reader is in while reading the tracks
+	QStringList m_path;
+	bool m_inTracks;
+	bool m_tracksDone;
+
+} ;
+
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * RealtimeCheck.h - reports calls which aren't realtime safe while rendering
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef REALTIME_CHECK_H
+#define REALTIME_CHECK_H
+
+#include "lmmsconfig.h"
+
+class Effect;
+class PlayHandle;
+
+
+/**
+	Realtime safety checks, built with WANT_DEBUG_RTCHECK
+
+	Threads are realtime while a Scope exists on them: the mixer thread and
+	the fifo writer while rendering a period, the worker threads while
+	running jobs and the threads of the audio devices while fetching a
+	period. The checked build interposes malloc() and friends, mutexes,
+	condition variables, semaphores, futex waits (which is where a
+	contended QMutex blocks), sleeping and file I/O. Calling them on a
+	realtime thread prints a stack trace, with the play handle or effect
+	being processed, once for each place it happens at.
+
+	With LMMS_RTCHECK=abort in the environment, the first report aborts,
+	for CI runs. Without WANT_DEBUG_RTCHECK, all of this compiles to
+	nothing.
+*/
+class RealtimeCheck
+{
+public:
+#ifdef LMMS_DEBUG_RTCHECK
+	//! The thread is realtime while it exists, scopes may nest
+	class Scope
+	{
+	public:
+		Scope();
+		~Scope();
+	} ;
+
+	//! Calls inside are expected, e.g. reporting
+	class Allow
+	{
+	public:
+		Allow();
+		~Allow();
+	} ;
+
+	//! Names what is processed in reports
+	class Context
+	{
+	public:
+		Context( const PlayHandle * playHandle );
+		Context( const Effect * effect );
+		~Context();
+
+	private:
+		const PlayHandle * m_playHandle;
+		const Effect * m_effect;
+	} ;
+
+	//! Reports @p call if the calling thread is realtime
+	static void check( const char * call );
+#else
+	class Scope
+	{
+	public:
+		Scope()
+		{
+		}
+	} ;
+
+	class Allow
+	{
+	public:
+		Allow()
+		{
+		}
+	} ;
+
+	class Context
+	{
+	public:
+		Context( const PlayHandle * )
+		{
+		}
+
+		Context( const Effect * )
+		{
+		}
+	} ;
+
+	static void check( const char * )
+	{
+	}
+#endif
+} ;
+
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * RealtimeMemory.h - locked, prefaulted memory for the buffers of the engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef REALTIME_MEMORY_H
+#define REALTIME_MEMORY_H
+
+#include <QtCore/QString>
+
+#include <cstddef>
+
+#include "lmms_export.h"
+
+
+/*! \brief Memory for the buffers the audio threads work on, which never
+ *  faults while rendering.
+ *
+ *  With the "mixer/lockmemory" setting, the memory comes from segments
+ *  which are backed by huge pages where the system has them, written to
+ *  once so every page exists, and locked into RAM while the limit of
+ *  locked memory allows it. Segments over the limit are still prefaulted
+ *  but may be paged out. Blocks are handed out in power of two sizes, at
+ *  least Alignment bytes, from free lists under a spin lock, so allocating
+ *  and releasing is realtime safe as long as there is spare memory.
+ *
+ *  One segment is kept spare. If an audio thread takes it, reserve() maps
+ *  the next one from the GUI thread, e.g. when the mixer is asked for a
+ *  change; an audio thread only maps a segment itself if it runs out.
+ *
+ *  Without the setting, or on systems without mmap() and mlock() or their
+ *  Windows counterparts, blocks come from the MemoryManager.
+ */
+class LMMS_EXPORT RealtimeMemory
+{
+public:
+	//! The size of a segment, blocks larger than that get one of their own
+	static const std::size_t SegmentBytes = 4 << 20;
+	static const std::size_t Alignment = 64;
+
+	struct Usage
+	{
+		bool enabled;
+		//! Bytes mapped and prefaulted for the pool
+		qint64 poolBytes;
+		//! The part of it locked into RAM, and backed by huge pages
+		qint64 lockedBytes;
+		qint64 hugePageBytes;
+		//! Bytes of the blocks handed out
+		qint64 inUse;
+		//! The limit of locked memory, -1 if there is none
+		qint64 lockLimit;
+		//! Segments an audio thread had to map itself
+		int overflows;
+	} ;
+
+	//! Reads the setting, raises the limit of locked memory as far as
+	//! allowed and maps the first segments. Called by the mixer before it
+	//! allocates any buffer, only the first call does anything.
+	static void init();
+
+	//! Maps segments until at least @p bytes are spare, and another one if
+	//! an audio thread took the spare one. Not realtime safe.
+	static void reserve(std::size_t bytes);
+
+	//! A block of at least @p bytes, aligned to Alignment with the
+	//! setting and like the MemoryManager's blocks otherwise. Its contents
+	//! are undefined.
+	static void * allocate(std::size_t bytes);
+	//! Gives back a block of allocate(), @p bytes being what was asked for
+	static void release(void * ptr, std::size_t bytes);
+
+	//! Whether blocks come from the locked pool, and so are aligned to
+	//! Alignment
+	static bool enabled();
+	static Usage usage();
+	//! How much was locked against the limit, for the console and the
+	//! statistics
+	static QString summary();
+} ;
+
+
+#endif
@@ -28,7 +28,9 @@
 #include "MidiEvent.h"
 #include "VstSyncData.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <vector>
 #include <cstdio>
 #include <cstdlib>
@@ -47,6 +49,12 @@
 
 #include <QtCore/QtGlobal>
 #include <QtCore/QSystemSemaphore>
+
+#ifdef LMMS_BUILD_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #endif
 
 
@@ -82,6 +90,8 @@ typedef int32_t key_t;
 #define LMMS_EXPORT
 #define COMPILE_REMOTE_PLUGIN_BASE
 
+#include "denormals.h"
+
 #ifndef SYNC_WITH_SHM_FIFO
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -89,8 +99,11 @@ typedef int32_t key_t;
 
 #else
 #include "lmms_export.h"
+#include "MixerProfiler.h"
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QMutex>
 #include <QtCore/QProcess>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QThread>
 
 #ifndef SYNC_WITH_SHM_FIFO
@@ -106,21 +119,143 @@ typedef int32_t key_t;
 const int SHM_FIFO_SIZE = 512*1024;
 
 
-// implements a FIFO inside a shared memory segment
-class shmFifo
+// a counting semaphore inside a shared memory segment, which only makes a
+// system call if a process has to be woken up or put to sleep
+class shmSemaphore
 {
-	// need this union to handle different sizes of sem_t on 32 bit
-	// and 64 bit platforms
-	union sem32_t
+public:
+	// the part in shared memory, of the same size for 32 bit and 64 bit
+	// processes
+	struct shmData
 	{
-		int semKey;
-		char fill[32];
+		std::atomic<int32_t> count;
+		std::atomic<int32_t> waiters;
+		int32_t semKey;	// of the system semaphore to sleep on
 	} ;
+
+	shmSemaphore() :
+		m_data( NULL ),
+#ifndef LMMS_BUILD_LINUX
+		m_sem( QString() ),
+#endif
+		m_spin( MinSpin )
+	{
+	}
+
+	// master-side, sets up the semaphore in _data
+	void create( shmData * _data, int _sem_key, int _count )
+	{
+		m_data = _data;
+		m_data->count.store( _count );
+		m_data->waiters.store( 0 );
+		m_data->semKey = _sem_key;
+#ifndef LMMS_BUILD_LINUX
+		m_sem.setKey( QString::number( _sem_key ), 0,
+						QSystemSemaphore::Create );
+#endif
+	}
+
+	// remote-side, uses the semaphore the master set up in _data
+	void attach( shmData * _data )
+	{
+		m_data = _data;
+#ifndef LMMS_BUILD_LINUX
+		m_sem.setKey( QString::number( m_data->semKey ) );
+#endif
+	}
+
+	inline bool tryAcquire()
+	{
+		int32_t count = m_data->count.load();
+		while( count > 0 )
+		{
+			if( m_data->count.compare_exchange_weak( count, count - 1,
+						std::memory_order_acquire ) )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void acquire()
+	{
+		// spin for about as long as the other process took to answer
+		// lately, as going to sleep and being woken up costs more than
+		// a few microseconds of spinning on a loaded system
+		for( int i = 0; i < m_spin; ++i )
+		{
+			if( tryAcquire() )
+			{
+				m_spin = std::min( m_spin * 2, MaxSpin );
+				return;
+			}
+			relax();
+		}
+		m_spin = std::max( m_spin / 2, MinSpin );
+
+		m_data->waiters.fetch_add( 1 );
+		while( !tryAcquire() )
+		{
+#ifdef LMMS_BUILD_LINUX
+			// returns right away if the count isn't 0 anymore
+			syscall( SYS_futex, &m_data->count, FUTEX_WAIT, 0,
+							NULL, NULL, 0 );
+#else
+			// tokens of wakeups that weren't needed anymore only
+			// cause another round
+			m_sem.acquire();
+#endif
+		}
+		m_data->waiters.fetch_sub( 1 );
+	}
+
+	void release()
+	{
+		m_data->count.fetch_add( 1 );
+		if( m_data->waiters.load() > 0 )
+		{
+#ifdef LMMS_BUILD_LINUX
+			syscall( SYS_futex, &m_data->count, FUTEX_WAKE, 1,
+							NULL, NULL, 0 );
+#else
+			m_sem.release();
+#endif
+		}
+	}
+
+private:
+	static const int MinSpin = 16;
+	static const int MaxSpin = 4096;
+
+	static inline void relax()
+	{
+#if defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+#endif
+	}
+
+	shmData * m_data;
+#ifndef LMMS_BUILD_LINUX
+	QSystemSemaphore m_sem;
+#endif
+	int m_spin;
+
+} ;
+
+
+// implements a FIFO inside a shared memory segment
+class shmFifo
+{
 	struct shmData
 	{
-		sem32_t dataSem;	// semaphore for locking this
-					// FIFO management data
-		sem32_t messageSem;	// semaphore for incoming messages
+		shmSemaphore::shmData dataSem;	// semaphore for locking this
+						// FIFO management data
+		shmSemaphore::shmData messageSem; // semaphore for incoming
+						// messages
+		shmSemaphore::shmData changeSem; // semaphore for waking up
+						// read() and write()
+		std::atomic<int32_t> changeWaiters;
 		volatile int32_t startPtr; // current start of FIFO in memory
 		volatile int32_t endPtr;   // current end of FIFO in memory
 		char data[SHM_FIFO_SIZE];  // actual data
@@ -138,8 +273,6 @@ public:
 		m_shmID( -1 ),
 #endif
 		m_data( NULL ),
-		m_dataSem( QString() ),
-		m_messageSem( QString() ),
 		m_lockDepth( 0 )
 	{
 #ifdef USE_QT_SHMEM
@@ -159,14 +292,13 @@ public:
 #endif
 		assert( m_data != NULL );
 		m_data->startPtr = m_data->endPtr = 0;
+		m_data->changeWaiters.store( 0 );
 		static int k = 0;
-		m_data->dataSem.semKey = ( getpid()<<10 ) + ++k;
-		m_data->messageSem.semKey = ( getpid()<<10 ) + ++k;
-		m_dataSem.setKey( QString::number( m_data->dataSem.semKey ),
-						1, QSystemSemaphore::Create );
-		m_messageSem.setKey( QString::number(
-						m_data->messageSem.semKey ),
-						0, QSystemSemaphore::Create );
+		m_dataSem.create( &m_data->dataSem, ( getpid()<<10 ) + ++k, 1 );
+		m_messageSem.create( &m_data->messageSem,
+						( getpid()<<10 ) + ++k, 0 );
+		m_changeSem.create( &m_data->changeSem,
+						( getpid()<<10 ) + ++k, 0 );
 	}
 
 	// constructor for remote-/client-side - use _shm_key for making up
@@ -181,8 +313,6 @@ public:
 		m_shmID( shmget( _shm_key, 0, 0 ) ),
 #endif
 		m_data( NULL ),
-		m_dataSem( QString() ),
-		m_messageSem( QString() ),
 		m_lockDepth( 0 )
 	{
 #ifdef USE_QT_SHMEM
@@ -197,9 +327,9 @@ public:
 		}
 #endif
 		assert( m_data != NULL );
-		m_dataSem.setKey( QString::number( m_data->dataSem.semKey ) );
-		m_messageSem.setKey( QString::number(
-						m_data->messageSem.semKey ) );
+		m_dataSem.attach( &m_data->dataSem );
+		m_messageSem.attach( &m_data->messageSem );
+		m_changeSem.attach( &m_data->changeSem );
 	}
 
 	~shmFifo()
@@ -224,6 +354,8 @@ public:
 	void invalidate()
 	{
 		m_invalid = true;
+		// wake up a read() waiting for data
+		m_changeSem.release();
 	}
 
 	// do we act as master (i.e. not as remote-process?)
@@ -286,7 +418,8 @@ public:
 			char * sc = new char[len + 1];
 			read( sc, len );
 			sc[len] = 0;
-			std::string s( sc );
+			// may be binary data
+			std::string s( sc, len );
 			delete[] sc;
 			return s;
 		}
@@ -347,11 +480,7 @@ private:
 		while( isInvalid() == false &&
 				_len > m_data->endPtr - m_data->startPtr )
 		{
-			unlock();
-#ifndef LMMS_BUILD_WIN32
-			usleep( 5 );
-#endif
-			lock();
+			waitForChange();
 		}
 		fastMemCpy( _buf, m_data->data + m_data->startPtr, _len );
 		m_data->startPtr += _len;
@@ -361,6 +490,7 @@ private:
 			// then reset to 0
 			m_data->startPtr = m_data->endPtr = 0;
 		}
+		changed();
 		unlock();
 	}
 
@@ -383,15 +513,30 @@ private:
 							m_data->startPtr;
 				m_data->startPtr = 0;
 			}
-			unlock();
-#ifndef LMMS_BUILD_WIN32
-			usleep( 5 );
-#endif
-			lock();
+			waitForChange();
 		}
 		fastMemCpy( m_data->data + m_data->endPtr, _buf, _len );
 		m_data->endPtr += _len;
+		changed();
+		unlock();
+	}
+
+	// waits for the other side to read or write, called with the lock held
+	void waitForChange()
+	{
+		m_data->changeWaiters.fetch_add( 1 );
 		unlock();
+		m_changeSem.acquire();
+		lock();
+	}
+
+	// wakes up whoever waits in waitForChange(), called with the lock held
+	inline void changed()
+	{
+		for( int32_t w = m_data->changeWaiters.exchange( 0 ); w > 0; --w )
+		{
+			m_changeSem.release();
+		}
 	}
 
 	volatile bool m_invalid;
@@ -403,8 +548,9 @@ private:
 	int m_shmID;
 #endif
 	shmData * m_data;
-	QSystemSemaphore m_dataSem;
-	QSystemSemaphore m_messageSem;
+	shmSemaphore m_dataSem;
+	shmSemaphore m_messageSem;
+	shmSemaphore m_changeSem;
 	std::atomic_int m_lockDepth;
 
 } ;
@@ -439,11 +585,49 @@ enum RemoteMessageIDs
 	IdSavePresetFile,
 	IdLoadPresetFile,
 	IdDebugMessage,
+	IdStartInstance,
+	IdParameterChange,
 	IdUserBase = 64
 } ;
 
 
 
+//! An event of a period, see RemoteEventBlock
+struct RemoteEvent
+{
+	enum Types
+	{
+		Midi,		// data: type, channel, param 0, param 1
+		Parameter	// data: index, value is the new value
+	} ;
+
+	int32_t type;
+	int32_t offset;
+	int32_t data[4];
+	float value;
+} ;
+
+//! The events of a period, handed to the plugin in the shared memory
+//! behind the buffers of the period, which saves a message per event. The
+//! offset of the block comes with IdStartProcessing.
+struct RemoteEventBlock
+{
+	static const int MaxEvents = 1024;
+
+	int32_t count;
+	RemoteEvent events[MaxEvents];
+} ;
+
+//! The audio in the shared memory is planar, inputs first, and each channel
+//! starts at a 64 byte boundary, so both sides can copy and process whole
+//! channels with aligned SIMD instructions
+inline int remoteChannelStride( int _frames )
+{
+	return ( _frames + 15 ) & ~15;
+}
+
+
+
 class LMMS_EXPORT RemotePluginBase
 {
 public:
@@ -557,6 +741,16 @@ public:
 	message waitForMessage( const message & _m,
 						bool _busy_waiting = false );
 
+	int messagesSent() const
+	{
+		return m_messagesSent;
+	}
+
+	int messagesReceived() const
+	{
+		return m_messagesReceived;
+	}
+
 	inline message fetchAndProcessNextMessage()
 	{
 		message m = receiveMessage();
@@ -585,7 +779,8 @@ public:
 			char * sc = new char[len + 1];
 			read( sc, len );
 			sc[len] = 0;
-			std::string s( sc );
+			// may be binary data
+			std::string s( sc, len );
 			delete[] sc;
 			return s;
 		}
@@ -619,6 +814,35 @@ public:
 #endif
 	}
 
+	//! Waits up to @p _timeoutUs microseconds for a message to arrive
+	inline bool waitForMessages( int _timeoutUs )
+	{
+#ifdef SYNC_WITH_SHM_FIFO
+		// the FIFO can't be waited on with a timeout
+		QElapsedTimer timer;
+		timer.start();
+		while( !messagesLeft() )
+		{
+			if( timer.nsecsElapsed() >= _timeoutUs * 1000LL )
+			{
+				return false;
+			}
+			QThread::usleep( 50 );
+		}
+		return true;
+#else
+		struct pollfd pollin;
+		pollin.fd = m_socket;
+		pollin.events = POLLIN;
+
+		if ( poll( &pollin, 1, ( _timeoutUs + 999 ) / 1000 ) == -1 )
+		{
+			qWarning( "Unexpected poll error." );
+		}
+		return pollin.revents & POLLIN;
+#endif
+	}
+
 	inline void fetchAndProcessAllMessages()
 	{
 		while( messagesLeft() )
@@ -738,6 +962,9 @@ private:
 	pthread_mutex_t m_sendMutex;
 #endif
 
+	std::atomic<int> m_messagesSent;
+	std::atomic<int> m_messagesReceived;
+
 } ;
 
 
@@ -745,6 +972,7 @@ private:
 #ifndef BUILD_REMOTE_PLUGIN_CLIENT
 
 
+class PlanarBuffer;
 class RemotePlugin;
 
 class ProcessWatcher : public QThread
@@ -786,10 +1014,27 @@ public:
 #ifdef DEBUG_REMOTE_PLUGIN
 		return true;
 #else
+		if( m_host )
+		{
+			return m_host->isRunning();
+		}
 		return m_process.state() != QProcess::NotRunning;
 #endif
 	}
 
+	//! Lets init() start the plugin inside the process of @p host, which
+	//! was started with "host" as its last argument, rather than in a
+	//! process of its own. The host is kept as long as the plugin.
+	void setHost( const QSharedPointer<RemotePlugin> & host )
+	{
+		m_host = host;
+	}
+
+	//! Starts the process without waiting for it to come up. A later
+	//! init() connects to it rather than starting another one, and
+	//! ignores its arguments.
+	bool launch( const QString & pluginExecutable, QStringList extraArgs = {} );
+
 	bool init( const QString &pluginExecutable, bool waitForInitDoneMsg, QStringList extraArgs = {} );
 
 	inline void waitForHostInfoGotten()
@@ -807,7 +1052,64 @@ public:
 
 	bool process( const sampleFrame * _in_buf, sampleFrame * _out_buf );
 
+	//! Like process(), but on planar buffers, whose channels are copied
+	//! to and from the shared memory as a whole. @p _in_buf and
+	//! @p _out_buf may be the same buffer.
+	bool processPlanar( const PlanarBuffer * _in_buf,
+						PlanarBuffer * _out_buf );
+
+	//! In asynchronous mode, process() hands the period to the plugin and
+	//! returns the output of the period before, so the plugin computes
+	//! while LMMS goes on rather than LMMS waiting for it. This delays the
+	//! output by one period, which latency() reports.
+	void setAsyncProcessing( bool _on );
+
+	//! The frames the output lags behind the input due to asynchronous
+	//! processing, not counting the latency of the plugin itself
+	fpp_t latency() const;
+
+	//! MIDI events and parameter changes are queued and handed to the
+	//! plugin together with the next period
 	void processMidiEvent( const MidiEvent&, const f_cnt_t _offset );
+	void processParameterChange( int _index, float _value,
+						const f_cnt_t _offset = 0 );
+
+	//! Sends the queued events right away, for when no period may be
+	//! processed soon
+	void flushEvents();
+
+	int periodsStarted() const
+	{
+		return m_periodsStarted;
+	}
+
+	//! Time the audio threads spent handing periods to the plugin and
+	//! waiting for it
+	const MixerProfiler::TimeCounter & waitTime() const
+	{
+		return m_waitTime;
+	}
+
+	//! Time the plugin spent computing periods, as it reports
+	const MixerProfiler::TimeCounter & pluginTime() const
+	{
+		return m_pluginTime;
+	}
+
+	//! Periods the watchdog didn't hand to the plugin
+	int skippedPeriods() const
+	{
+		return m_skippedPeriods;
+	}
+
+	size_t sharedMemorySize() const
+	{
+		return m_shmSize;
+	}
+
+	//! The memory of the process resident in RAM, or 0 if it runs in a
+	//! host shared with other plugins or the system doesn't tell
+	qint64 residentBytes() const;
 
 	void updateSampleRate( sample_rate_t _sr )
 	{
@@ -817,6 +1119,13 @@ public:
 		unlock();
 	}
 
+	void updateBufferSize( fpp_t _frames )
+	{
+		lock();
+		sendMessage( message( IdBufferSizeInformation ).addInt( _frames ) );
+		unlock();
+	}
+
 
 	virtual void toggleUI()
 	{
@@ -863,6 +1172,34 @@ protected:
 	bool m_failed;
 private:
 	void resizeSharedProcessingMemory();
+	// the input and output are in one of the layouts, the other one is
+	// null
+	bool processPeriod( const sampleFrame * _in_buf,
+				const PlanarBuffer * _planar_in,
+				sampleFrame * _out_buf, PlanarBuffer * _planar_out );
+	void writeInput( const sampleFrame * _in_buf,
+				const PlanarBuffer * _planar_in, float * _shm,
+							fpp_t _frames );
+	void readOutput( sampleFrame * _out_buf, PlanarBuffer * _planar_out,
+					const float * _shm, fpp_t _frames );
+	void clearOutput( sampleFrame * _out_buf, PlanarBuffer * _planar_out,
+							fpp_t _frames );
+	void queueEvent( const RemoteEvent & _e );
+	// moves the queued events to the event block behind the buffers at
+	// @p _offset and returns the offset of the block
+	int writeEvents( int _offset );
+	// whether the watchdog bypasses the plugin for this period
+	bool watchdogSkips();
+	// waits until no more than @p _pending periods are left to the plugin,
+	// for at most @p _timeoutUs if it's positive. Returns false if the
+	// plugin took longer.
+	bool waitForPeriods( int _pending, int _timeoutUs );
+	void missedDeadline();
+
+	// periods in a row the plugin may miss the deadline before the
+	// watchdog bypasses it, and for how many periods
+	static const int MaxMissedDeadlines = 8;
+	static const int BypassPeriods = 256;
 
 
 	QProcess m_process;
@@ -872,6 +1209,9 @@ private:
 	QStringList m_args;
 
 	QMutex m_commMutex;
+	QSharedPointer<RemotePlugin> m_host;
+	// launched, but not connected to yet
+	bool m_launched;
 	bool m_splitChannels;
 #ifdef USE_QT_SHMEM
 	QSharedMemory m_shmObj;
@@ -884,6 +1224,27 @@ private:
 	int m_inputCount;
 	int m_outputCount;
 
+	bool m_async;
+	// which half of the shared memory the next period goes to
+	int m_slot;
+	// the frames of the period the plugin computes in the other half, 0
+	// if its output isn't wanted anymore
+	fpp_t m_pendingFrames;
+	std::atomic<int> m_periodsStarted;
+	std::atomic<int> m_periodsDone;
+
+	QMutex m_eventsMutex;
+	std::vector<RemoteEvent> m_events;
+	// where the event block is behind the buffers of a period
+	int m_eventsOffset;
+
+	bool m_watchdog;
+	int m_missedDeadlines;
+	int m_bypassPeriods;
+	std::atomic<int> m_skippedPeriods;
+	MixerProfiler::TimeCounter m_waitTime;
+	MixerProfiler::TimeCounter m_pluginTime;
+
 #ifndef SYNC_WITH_SHM_FIFO
 	int m_server;
 	QString m_socketFile;
@@ -895,6 +1256,7 @@ private:
 private slots:
 	void processFinished( int exitCode, QProcess::ExitStatus exitStatus );
 	void processErrored(QProcess::ProcessError err );
+	void framesPerPeriodChanged();
 } ;
 
 #endif
@@ -923,6 +1285,11 @@ public:
 	{
 	}
 
+	virtual void processParameterChange( int /* _index */, float /* _value */,
+						const f_cnt_t /* _offset */ )
+	{
+	}
+
 	inline float * sharedMemory()
 	{
 		return m_shm;
@@ -985,7 +1352,7 @@ public:
 
 private:
 	void setShmKey( key_t _key, int _size );
-	void doProcessing();
+	void doProcessing( int _offset, int _eventOffset );
 
 #ifdef USE_QT_SHMEM
 	QSharedMemory m_shmObj;
@@ -1034,6 +1401,8 @@ RemotePluginBase::RemotePluginBase() :
 	pthread_mutex_init( &m_receiveMutex, NULL );
 	pthread_mutex_init( &m_sendMutex, NULL );
 #endif
+	m_messagesSent = 0;
+	m_messagesReceived = 0;
 }
 
 
@@ -1079,6 +1448,7 @@ int RemotePluginBase::sendMessage( const message & _m )
 	}
 	pthread_mutex_unlock( &m_sendMutex );
 #endif
+	++m_messagesSent;
 
 	return j;
 }
@@ -1110,6 +1480,7 @@ RemotePluginBase::message RemotePluginBase::receiveMessage()
 	}
 	pthread_mutex_unlock( &m_receiveMutex );
 #endif
+	++m_messagesReceived;
 	return m;
 }
 
@@ -1333,9 +1704,9 @@ bool RemotePluginClient::processMessage( const message & _m )
 			break;
 
 		case IdBufferSizeInformation:
-			// Should LMMS gain the ability to change buffer size
-			// without a restart, it must wait for this message to
-			// complete processing or else risk VST crashes
+			// sent while LMMS is not processing, and handled before
+			// the next IdStartProcessing as messages are processed
+			// in order
 			m_bufferSize = _m.getInt();
 			updateBufferSize();
 			break;
@@ -1353,11 +1724,27 @@ bool RemotePluginClient::processMessage( const message & _m )
 							_m.getInt( 4 ) );
 			break;
 
+		case IdParameterChange:
+			processParameterChange( _m.getInt( 0 ), _m.getFloat( 1 ),
+								0 );
+			break;
+
 		case IdStartProcessing:
-			doProcessing();
+		{
+			const auto begin = std::chrono::steady_clock::now();
+			// the host may say where in the shared memory the
+			// buffers and the events of this period are
+			doProcessing( _m.data.size() > 0 ? _m.getInt( 0 ) : 0,
+					_m.data.size() > 1 ? _m.getInt( 1 ) : -1 );
+			// tells the time in the plugin apart from the time
+			// of the round trip
+			reply_message.addInt( std::chrono::duration_cast<
+					std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - begin ).count() );
 			reply_message.id = IdProcessingDone;
 			reply = true;
 			break;
+		}
 
 		case IdChangeSharedMemoryKey:
 			setShmKey( _m.getInt( 0 ), _m.getInt( 1 ) );
@@ -1427,13 +1814,40 @@ void RemotePluginClient::setShmKey( key_t _key, int _size )
 
 
 
-void RemotePluginClient::doProcessing()
+void RemotePluginClient::doProcessing( int _offset, int _eventOffset )
 {
+	// the thread calling this depends on the plugin host
+	disable_denormals();
+
 	if( m_shm != NULL )
 	{
-		process( (sampleFrame *)( m_inputCount > 0 ? m_shm : NULL ),
-				(sampleFrame *)( m_shm +
-					( m_inputCount*m_bufferSize ) ) );
+		if( _eventOffset >= 0 )
+		{
+			const RemoteEventBlock * block =
+				(const RemoteEventBlock *)( m_shm + _eventOffset );
+			for( int i = 0; i < block->count; ++i )
+			{
+				const RemoteEvent & e = block->events[i];
+				if( e.type == RemoteEvent::Midi )
+				{
+					processMidiEvent( MidiEvent(
+						static_cast<MidiEventTypes>(
+								e.data[0] ),
+						e.data[1], e.data[2], e.data[3] ),
+								e.offset );
+				}
+				else
+				{
+					processParameterChange( e.data[0],
+							e.value, e.offset );
+				}
+			}
+		}
+
+		float * shm = m_shm + _offset;
+		process( (sampleFrame *)( m_inputCount > 0 ? shm : NULL ),
+				(sampleFrame *)( shm + m_inputCount *
+					remoteChannelStride( m_bufferSize ) ) );
 	}
 	else
 	{
@@ -0,0 +1,73 @@
+/*
+ * RenderCache.h - renderings of tracks kept between exports
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include <QString>
+
+#include "Mixer.h"
+
+class InstrumentTrack;
+
+
+/*! Renderings of instrument tracks from previous exports, which are played
+ *  instead of the tracks when exporting again with nothing changed that
+ *  they depend on. They are named after a hash of the track's settings and
+ *  patterns, the automation and controllers of its models and the song and
+ *  quality settings, and are frozen renderings otherwise. Tracks of beat
+ *  patterns are cached with the arrangement of the beat tracks in the song.
+ */
+namespace RenderCache
+{
+
+//! Whether exports use the cache, which is when it has a size
+bool isEnabled();
+
+//! Where the renderings are kept
+QString directory();
+
+//! The most bytes kept in the cache
+qint64 maxSize();
+
+/*! \brief The key of the rendering of @p track when exported at
+ *  @p sampleRate with @p qualitySettings
+ *
+ *  \param sampleRate The processing rate, i.e. including oversampling
+ *  \return An empty string if the track can't be played from the cache
+ */
+QString keyOf( InstrumentTrack * track,
+		const Mixer::qualitySettings & qualitySettings,
+		sample_rate_t sampleRate );
+
+//! The file the rendering with @p key is kept in
+QString fileOf( const QString & key );
+
+//! Remove the oldest renderings until the cache fits maxSize()
+void trim();
+
+}
+
+#endif
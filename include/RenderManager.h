@@ -27,10 +27,14 @@
 #define RENDER_MANAGER_H
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "ProjectRenderer.h"
 #include "OutputSettings.h"
 
+class InstrumentTrack;
+
 
 class RenderManager : public QObject
 {
@@ -44,27 +48,63 @@ public:
 
 	virtual ~RenderManager();
 
-	/// Export all unmuted tracks into a single file
+	/// Also write the project to @p outputPath in another format, from the
+	/// same render pass; only used by renderProject()
+	void addOutput( const OutputSettings & outputSettings,
+			ProjectRenderer::ExportFileFormats fmt, QString outputPath );
+
+	/// Export through the live audio device with its audio server
+	/// freewheeling, if it can, see AudioDevice::startFreewheel(); only
+	/// used by renderProject(), without the extra outputs
+	void setFreewheel( bool freewheel )
+	{
+		m_freewheel = freewheel;
+	}
+
+	/// Export all unmuted tracks into a single file. With the render
+	/// cache enabled, instrument tracks rendered before are played from
+	/// their renderings and the others are added to the cache.
 	void renderProject();
 
-	/// Export all unmuted tracks into individual file
-	void renderTracks();
+	/// Export all unmuted tracks into individual file. In a single pass,
+	/// the track outputs are taken before the FX mixer and the FX mixer
+	/// output is exported as an additional file, otherwise the song is
+	/// rendered once per track with all other tracks muted.
+	void renderTracks( bool singlePass = false );
+
+	/// Export the output of @p track after its effects with all other
+	/// tracks muted, e.g. to freeze it
+	void renderTrack( Track * track );
 
 	void abortProcessing();
 
+	/// Throughput of all render passes so far
+	ProjectRenderer::Statistics statistics() const;
+
+public slots:
+	void updateConsoleProgress();
+
 signals:
 	void progressChanged( int );
 	void finished();
 
 private slots:
 	void renderNextTrack();
-	void updateConsoleProgress();
+	void finishStems();
+	void playCachedTracks();
 
 private:
 	QString pathForTrack( const Track *track, int num );
 	void restoreMutedState();
 
-	void render( QString outputPath );
+	void render( QString outputPath, bool withExtraOutputs = false );
+	void renderStems();
+	void clearStems();
+	void removeDiscardedOutput();
+	void prepareRenderCache();
+	void finishRenderCache();
+	void releaseCachedTracks();
+	static AudioPort * audioPortOf( Track * track );
 
 	const Mixer::qualitySettings m_qualitySettings;
 	const Mixer::qualitySettings m_oldQualitySettings;
@@ -72,10 +112,36 @@ private:
 	ProjectRenderer::ExportFileFormats m_format;
 	QString m_outputPath;
 
+	struct ExtraOutput
+	{
+		OutputSettings outputSettings;
+		ProjectRenderer::ExportFileFormats format;
+		QString path;
+	} ;
+	std::vector<ExtraOutput> m_extraOutputs;
+	bool m_freewheel;
+
 	std::unique_ptr<ProjectRenderer> m_activeRenderer;
+	// of the finished render passes
+	ProjectRenderer::Statistics m_statistics;
 
 	QVector<Track*> m_tracksToRender;
 	QVector<Track*> m_unmuted;
+
+	// ports tapped and file devices the tracks are rendered to when
+	// rendering in a single pass
+	QVector<AudioPort*> m_stemPorts;
+	std::vector<std::unique_ptr<AudioFileDevice>> m_stemDevices;
+
+	// tracks played from the render cache with their renderings, and
+	// the renderings recorded for it, which are stems written to a
+	// temporary file until the export is finished
+	std::vector<std::pair<InstrumentTrack *, QString>> m_cachedTracks;
+	QStringList m_newCacheFiles;
+
+	// FX mixer output that is only rendered to drive a stem, removed
+	// when finished
+	QString m_discardedOutput;
 } ;
 
 #endif
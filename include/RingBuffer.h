@@ -28,6 +28,7 @@
 #define RINGBUFFER_H
 
 #include <QObject>
+#include "DelayLinePool.h"
 #include "lmms_basics.h"
 #include "lmms_math.h"
 #include "MemoryManager.h"
@@ -73,11 +74,36 @@ public:
  */
 	void changeSize( float size );
 
+/** \brief Grows the ringbuffer, keeping the data ahead of the position. Does nothing if it's large enough.
+ * 	\param size Size in frames
+ */
+	void reserve( f_cnt_t size );
+
+/** \brief Grows the ringbuffer, keeping the data ahead of the position. Does nothing if it's large enough.
+ * 	\param size Size in milliseconds
+ */
+	void reserve( float size );
+
+/** \brief Lets the DelayLinePool take the memory back if the ringbuffer isn't used for a while, e.g. while its effect sleeps
+ */
+	void sleep();
+
+/** \brief Has to be called before the ringbuffer is used again after sleep(), followed by reserve() in case the memory was taken back
+ */
+	void wake();
+
 /** \brief Sets whether the ringbuffer size is adjusted for samplerate when samplerate changes
  *	\param b True if samplerate should affect buffer size
  */
 	void setSamplerateAware( bool b );
 
+/** \brief Returns the frames of memory the ringbuffer holds, which is less than its size while it hasn't grown to it or sleeps
+ */
+	f_cnt_t capacity() const
+	{
+		return m_memory.frames;
+	}
+
 
 // position adjustment functions
 
@@ -209,10 +235,10 @@ private:
 		return static_cast<f_cnt_t>( ceilf( ms * (float)m_samplerate * 0.001f ) );
 	}
 
+	// padding for reading a period beyond the size, the longest period
 	const fpp_t m_fpp;
 	sample_rate_t m_samplerate;
-	size_t m_size;
-	sampleFrame * m_buffer;
+	DelayLinePool::Buffer m_memory;
 	volatile unsigned int m_position;
 
 };
@@ -28,6 +28,11 @@
 
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+#include <atomic>
+#include <functional>
+#include <memory>
 
 #include <samplerate.h>
 
@@ -39,14 +44,12 @@
 #include "MemoryManager.h"
 
 
+class QDomElement;
 class QPainter;
 class QRect;
-
-// values for buffer margins, used for various libsamplerate interpolation modes
-// the array positions correspond to the converter_type parameter values in libsamplerate
-// if there appears problems with playback on some interpolation mode, then the value for that mode
-// may need to be higher - conversely, to optimize, some may work with lower values
-const f_cnt_t MARGIN[] = { 64, 64, 64, 4, 4 };
+class CompressedFrames;
+class SampleOverview;
+class SampleStream;
 
 class LMMS_EXPORT SampleBuffer : public QObject, public sharedObject
 {
@@ -58,10 +61,19 @@ public:
 		LoopOn,
 		LoopPingPong
 	};
+	//! Files this long are streamed from disk if the buffer is streamable
+	static const int StreamingMinSeconds = 120;
+	//! Previews stream files this long, so they start playing at once
+	static const int PreviewStreamingSeconds = 10;
+	//! Compressible buffers this long are compressed if it's enabled
+	static const int CompressionMinSeconds = 4;
+
 	class LMMS_EXPORT handleState
 	{
 		MM_OPERATORS
 	public:
+		// interpolationMode is a libsamplerate converter type, which
+		// selects the SincResampler quality
 		handleState(bool varyingPitch = false, int interpolationMode = SRC_LINEAR);
 		virtual ~handleState();
 
@@ -73,6 +85,9 @@ public:
 		void setFrameIndex(f_cnt_t index)
 		{
 			m_frameIndex = index;
+			m_positionValid = false;
+			// the index is at the current rate of the buffer
+			m_sampleRate = 0;
 		}
 
 		bool isBackwards() const
@@ -83,6 +98,7 @@ public:
 		void setBackwards(bool backwards)
 		{
 			m_isBackwards = backwards;
+			m_positionValid = false;
 		}
 
 		int interpolationMode() const
@@ -95,9 +111,16 @@ public:
 		f_cnt_t m_frameIndex;
 		const bool m_varyingPitch;
 		bool m_isBackwards;
-		SRC_STATE * m_resamplingData;
 		int m_interpolationMode;
 
+		// exact position in the unrolled loop, see play()
+		double m_position;
+		bool m_positionValid;
+		LoopMode m_positionLoopMode;
+		// the rate of the frames last played, which is rescaled to if the
+		// frames have been converted meanwhile
+		sample_rate_t m_sampleRate;
+
 		friend class SampleBuffer;
 
 	} ;
@@ -189,6 +212,40 @@ public:
 		m_loopEndFrame = loopEnd;
 	}
 
+	//! Lets long audio files be played from disk rather than loaded to
+	//! memory, for buffers which are played without loops, e.g. by sample
+	//! tracks. data() is nullptr for streamed buffers.
+	void setStreamable(bool streamable, int minSeconds = StreamingMinSeconds)
+	{
+		m_streamable = streamable;
+		m_streamingMinSeconds = minSeconds;
+	}
+
+	bool isStreamed() const
+	{
+		return m_stream != nullptr;
+	}
+
+	//! Lets a streamed or compressed buffer load the frames from @p frame
+	//! on, before they are played
+	void prefetch(f_cnt_t frame);
+
+	//! Lets the frames be kept compressed in memory while compression is
+	//! enabled, for buffers which are only played and drawn, e.g. by
+	//! instruments. data() is nullptr for compressed buffers, so
+	//! userWaveSample() can't be used either.
+	void setCompressible(bool compressible);
+
+	bool isCompressed() const
+	{
+		return m_compressed != nullptr;
+	}
+
+	//! Compresses or decompresses the frames of all compressible buffers,
+	//! this is a setting of the project
+	static void setCompressionEnabled(bool enabled);
+	static bool compressionEnabled();
+
 	inline f_cnt_t frames() const
 	{
 		return m_frames;
@@ -226,7 +283,11 @@ public:
 
 	inline void setSampleRate(sample_rate_t rate)
 	{
-		m_sampleRate = rate;
+		// streams always play at the rate of their file
+		if (m_stream == nullptr)
+		{
+			m_sampleRate = rate;
+		}
 	}
 
 	inline const sampleFrame * data() const
@@ -234,12 +295,37 @@ public:
 		return m_data;
 	}
 
+	//! The memory used by the frames: the original ones, the resampled or
+	//! compressed ones and the window of a stream. Frames shared with
+	//! other buffers are split among them.
+	qint64 memoryUsage() const;
+	//! The memory used by the overview for drawing the buffer
+	qint64 overviewMemoryUsage() const;
+
+	//! Starts decoding @p files in the background, e.g. the samples of a
+	//! project while its tracks are created, so the buffers loading them
+	//! later on don't have to. Files @p streamable buffers would stream
+	//! are left out.
+	static void prefetchFiles(const QStringList & files, bool streamable);
+	//! Decodes @p files in the background and keeps their frames while
+	//! they fit in memory, e.g. the neighbours of a previewed file, so
+	//! previewing them doesn't wait for the decoder. Files requested
+	//! last, and earlier in @p files, are kept first. Files previews
+	//! stream are left out.
+	static void preloadFiles(const QStringList & files);
+
 	QString openAudioFile() const;
 	QString openAndSetAudioFile();
 	QString openAndSetWaveformFile();
 
 	QString & toBase64(QString & dst) const;
 
+	//! Saves the frames as @p attribute of @p element, or as binary data
+	//! next to the XML if the document stores it
+	void saveEmbedded(QDomElement & element, const QString & attribute) const;
+	//! Loads frames saved by saveEmbedded(), returns false if there are none
+	bool loadEmbedded(const QDomElement & element, const QString & attribute);
+
 
 	// protect calls from the GUI to this function with dataReadLock() and
 	// dataUnlock()
@@ -282,39 +368,86 @@ public slots:
 	void setReversed(bool on);
 	void sampleRateChanged();
 
+private slots:
+	//! Decodes the file again at the mixer rate in the background, once
+	//! the buffer is played after the rate has changed, see
+	//! startRequestedConversions()
+	void convertSampleRate();
+	//! Replaces the frames by the ones convertSampleRate() decoded
+	void applySampleRate();
+
 private:
+	struct RateConversion;
+	class RateConversionTask;
+
+	// whether the frames of a file are at the mixer rate
+	enum RateState
+	{
+		RateCurrent,
+		RateChanged,
+		// play() wants the frames converted
+		RateRequested,
+		RateConverting
+	} ;
+
 	static sample_rate_t mixerSampleRate();
 
-	void update(bool keepSettings = false);
+	//! Adds the buffer to the ones whose frames are at a previous rate,
+	//! or removes it
+	void registerStaleRate(bool stale);
+	//! Starts the conversions play() has requested, on the GUI thread
+	static void startRequestedConversions();
 
-	void convertIntToFloat(int_sample_t * & ibuf, f_cnt_t frames, int channels);
-	void directFloatWrite(sample_t * & fbuf, f_cnt_t frames, int channels);
+	//! Lets a running conversion be dropped once it's done
+	void cancelRateConversion();
 
-	f_cnt_t decodeSampleSF(
-		QString fileName,
-		sample_t * & buf,
-		ch_cnt_t & channels,
-		sample_rate_t & samplerate
-	);
+	void visualizeStream(QPainter & p, const QRect & dr, f_cnt_t fromFrame,
+							f_cnt_t toFrame);
+	//! Lets a stream redraw this buffer once its overview is complete
+	std::function<void()> overviewDone();
+
+	void update(bool keepSettings = false);
+	//! Frees m_data, or releases it if it's shared
+	void freeData();
+	//! Reverses m_data, on a copy of it if it's shared
+	void reverseData();
+	//! Replaces m_data by compressed frames if the buffer should be
+	//! compressed, or the other way round
+	void compressData();
+	void decompressData();
+	void updateCompression();
+
+	// the decoding functions don't use any members, so files can be
+	// decoded by any thread, see prefetchFiles()
+
+	//! Decodes @p file to frames at @p sampleRate, allocated with
+	//! MM_ALLOC, or returns nullptr. @p tooLarge is set if the file
+	//! exceeds the size limits.
+	static sampleFrame * decodeFile(const QString & file,
+		sample_rate_t sampleRate, f_cnt_t & frames, bool & tooLarge);
+	static sampleFrame * resampleFrames(const sampleFrame * data,
+		f_cnt_t frames, sample_rate_t srcSR, sample_rate_t dstSR,
+		f_cnt_t & dstFrames);
+
+	// The decoders return the frames of a file at sampleRate, converting
+	// them chunk by chunk while they're read
+	static f_cnt_t decodeSampleSF(QString fileName, sample_rate_t sampleRate,
+		sampleFrame * & data);
 #ifdef LMMS_HAVE_OGGVORBIS
-	f_cnt_t decodeSampleOGGVorbis(
-		QString fileName,
-		int_sample_t * & buf,
-		ch_cnt_t & channels,
-		sample_rate_t & samplerate
-	);
+	static f_cnt_t decodeSampleOGGVorbis(QString fileName,
+		sample_rate_t sampleRate, sampleFrame * & data);
 #endif
-	f_cnt_t decodeSampleDS(
-		QString fileName,
-		int_sample_t * & buf,
-		ch_cnt_t & channels,
-		sample_rate_t & samplerate
-	);
+	static f_cnt_t decodeSampleDS(QString fileName, sample_rate_t sampleRate,
+		sampleFrame * & data);
 
 	QString m_audioFile;
 	sampleFrame * m_origData;
 	f_cnt_t m_origFrames;
 	sampleFrame * m_data;
+	// set if m_data belongs to the SampleCache, which must not be changed
+	std::shared_ptr<sampleFrame> m_sharedData;
+	// built when the buffer is first drawn zoomed out
+	std::shared_ptr<const SampleOverview> m_overview;
 	mutable QReadWriteLock m_varLock;
 	f_cnt_t m_frames;
 	f_cnt_t m_startFrame;
@@ -325,20 +458,17 @@ private:
 	bool m_reversed;
 	float m_frequency;
 	sample_rate_t m_sampleRate;
+	std::unique_ptr<SampleStream> m_stream;
+	bool m_streamable;
+	int m_streamingMinSeconds;
+	// replaces m_data while the buffer is compressed. If m_origData is
+	// nullptr but m_origFrames isn't 0, these are the original frames.
+	std::unique_ptr<CompressedFrames> m_compressed;
+	bool m_compressible;
+	// until the frames are converted, play() resamples them to the new rate
+	std::atomic<int> m_rateState;
+	std::shared_ptr<RateConversion> m_rateConversion;
 
-	sampleFrame * getSampleFragment(
-		f_cnt_t index,
-		f_cnt_t frames,
-		LoopMode loopMode,
-		sampleFrame * * tmp,
-		bool * backwards,
-		f_cnt_t loopStart,
-		f_cnt_t loopEnd,
-		f_cnt_t end
-	) const;
-
-	f_cnt_t getLoopedIndex(f_cnt_t index, f_cnt_t startf, f_cnt_t endf) const;
-	f_cnt_t getPingPongIndex(f_cnt_t index, f_cnt_t startf, f_cnt_t endf) const;
 
 
 signals:
@@ -0,0 +1,122 @@
+/*
+ * SampleCache.h - decoded samples shared by all sample buffers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SAMPLE_CACHE_H
+#define SAMPLE_CACHE_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+
+#include <functional>
+#include <map>
+#include <memory>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+class QFileInfo;
+class SampleOverview;
+
+/*! \brief The decoded frames of audio files, shared by all SampleBuffers
+ *  loading the same file at the same sample rate.
+ *
+ *  The frames in the cache are never changed, buffers which modify their
+ *  frames, such as by reversing them, copy them first. A file is known by
+ *  its path, size and modification time, so an edited file is decoded
+ *  again. Files stay in the cache as long as a buffer uses them.
+ *
+ *  Files can also be decoded in advance on the global thread pool, e.g.
+ *  all samples of a project while its tracks are created.
+ */
+class LMMS_EXPORT SampleCache
+{
+public:
+	//! Decodes a file to frames allocated with MM_ALLOC, or returns nullptr
+	using Decoder = std::function<sampleFrame *(f_cnt_t & frames)>;
+
+	//! Returns the frames of @p file at @p sampleRate, or nullptr if no
+	//! buffer currently uses them. Waits for the file if it is prefetched.
+	static std::shared_ptr<sampleFrame> find(const QFileInfo & file,
+		sample_rate_t sampleRate, f_cnt_t & frames);
+
+	//! Adds frames decoded from @p file, which are owned by the cache from
+	//! now on and freed with MM_FREE once the last buffer releases them
+	static std::shared_ptr<sampleFrame> insert(const QFileInfo & file,
+		sample_rate_t sampleRate, sampleFrame * data, f_cnt_t frames);
+
+	//! Decodes @p file with @p decode in the background. The frames are
+	//! kept until releasePrefetched(), even if no buffer uses them yet.
+	static void prefetch(const QFileInfo & file, sample_rate_t sampleRate,
+		const Decoder & decode);
+
+	//! The overview of @p data, shared by all buffers using the same
+	//! frames of the cache. It's built on first use.
+	static std::shared_ptr<const SampleOverview> overview(
+		const std::shared_ptr<sampleFrame> & data, f_cnt_t frames);
+
+	//! The number of files still being prefetched
+	static int pendingFiles();
+
+	//! Drops the prefetched frames no buffer has used, including those
+	//! of the files still being decoded
+	static void releasePrefetched();
+
+private:
+	class PrefetchTask;
+
+	struct Key
+	{
+		QString path;
+		qint64 size;
+		qint64 modified;
+		sample_rate_t sampleRate;
+
+		bool operator<(const Key & other) const;
+	} ;
+
+	struct Entry
+	{
+		std::weak_ptr<sampleFrame> data;
+		f_cnt_t frames;
+		// set while the file is prefetched, then until a buffer uses it
+		std::shared_ptr<sampleFrame> prefetched;
+		bool pending;
+		bool keepPrefetched;
+		std::weak_ptr<const SampleOverview> overview;
+	} ;
+
+	static Key key(const QFileInfo & file, sample_rate_t sampleRate);
+	static std::shared_ptr<sampleFrame> share(sampleFrame * data);
+
+	static QMutex s_mutex;
+	// woken whenever a prefetched file is done
+	static QWaitCondition s_prefetched;
+	static std::map<Key, Entry> s_samples;
+
+} ;
+
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * SampleConversion.h - conversion of the mixer output to device formats
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef SAMPLE_CONVERSION_H
+#define SAMPLE_CONVERSION_H
+
+#include <cstdint>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+/*! Converters from the mixer's surround buffers to the interleaved or
+ *  planar formats the audio devices and encoders take. Each one applies the
+ *  gain, clips, quantizes and interleaves in a single pass. Without
+ *  dithering, the work is done in SIMD registers where available.
+ */
+namespace SampleConversion
+{
+
+enum Dithering
+{
+	DitherNone,
+	//! Triangular noise of +-1 LSB, which decorrelates the quantization
+	//! error from the signal
+	DitherTriangular,
+	//! Triangular noise with the error fed back, which moves the noise
+	//! towards high frequencies
+	DitherShaped,
+	NumDitherings
+} ;
+
+
+/*! \brief Dither state of one output stream
+ *
+ *  Keeps the random generator and the errors fed back, so give every
+ *  stream its own one.
+ */
+class LMMS_EXPORT Ditherer
+{
+public:
+	Ditherer( Dithering dithering = DitherNone );
+
+	Dithering dithering() const
+	{
+		return m_dithering;
+	}
+
+	void setDithering( Dithering dithering );
+
+	//! Quantize x, given in LSBs, and clamp it to +-limit
+	int32_t quantize( float x, ch_cnt_t channel, float limit );
+
+private:
+	//! Uniformly distributed in [0, 1)
+	inline float random()
+	{
+		m_seed ^= m_seed << 13;
+		m_seed ^= m_seed >> 17;
+		m_seed ^= m_seed << 5;
+		return ( m_seed >> 8 ) * ( 1.0f / 16777216.0f );
+	}
+
+	Dithering m_dithering;
+	uint32_t m_seed;
+	float m_error[SURROUND_CHANNELS];
+
+} ;
+
+
+//! Convert to interleaved signed 16-bit samples, optionally byte swapped
+LMMS_EXPORT void toS16( const surroundSampleFrame * src, fpp_t frames,
+			ch_cnt_t channels, float gain, int16_t * dst,
+			bool swapBytes = false, Ditherer * ditherer = nullptr );
+
+/*! \brief Convert to interleaved signed 32-bit samples
+ *
+ *  The samples are quantized to \p bits and aligned to the most significant
+ *  bit, so 24 gives the S24 in 32 bit layout libsndfile and most drivers
+ *  take.
+ */
+LMMS_EXPORT void toS32( const surroundSampleFrame * src, fpp_t frames,
+			ch_cnt_t channels, float gain, int32_t * dst,
+			int bits = 32, Ditherer * ditherer = nullptr );
+
+//! Apply the gain and interleave, without clipping
+LMMS_EXPORT void toFloat( const surroundSampleFrame * src, fpp_t frames,
+			ch_cnt_t channels, float gain, float * dst );
+
+//! Apply the gain and write each channel to its own buffer, without clipping
+LMMS_EXPORT void toPlanar( const surroundSampleFrame * src, fpp_t frames,
+			ch_cnt_t channels, float gain, float * const * dst );
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * SampleOverview.h - min, max and RMS of a sample at several resolutions
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SAMPLE_OVERVIEW_H
+#define SAMPLE_OVERVIEW_H
+
+#include <QtCore/QtGlobal>
+
+#include <vector>
+
+#include "lmms_basics.h"
+
+
+/*! \brief A pyramid of summaries of a sample, for drawing it at any zoom
+ *  without reading all of its frames.
+ *
+ *  Each point of the finest level summarizes BaseFrames frames, each point
+ *  of the next level LevelFactor points of the previous one. Building it
+ *  reads the frames once, drawing then reads at most a few points per
+ *  pixel.
+ */
+class SampleOverview
+{
+public:
+	struct Point
+	{
+		float min;
+		float max;
+		// of both channels
+		float meanSquare;
+	} ;
+
+	static const f_cnt_t BaseFrames = 32;
+	static const int LevelFactor = 4;
+
+	SampleOverview(const sampleFrame * data, f_cnt_t frames);
+
+	//! Summarizes the frames [first, last) from the coarsest level whose
+	//! points don't span more than @p resolution frames. The result may
+	//! include some frames around the range.
+	Point summarize(f_cnt_t first, f_cnt_t last, double resolution) const;
+
+	qint64 memoryUsage() const;
+
+private:
+	f_cnt_t m_frames;
+	std::vector<std::vector<Point>> m_levels;
+
+} ;
+
+
+#endif
@@ -26,14 +26,12 @@
 #ifndef SAMPLE_RECORD_HANDLE_H
 #define SAMPLE_RECORD_HANDLE_H
 
-#include <QtCore/QList>
-#include <QtCore/QPair>
+#include <memory>
 
 #include "PlayHandle.h"
 #include "TimePos.h"
 
 class BBTrack;
-class SampleBuffer;
 class SampleTCO;
 class Track;
 
@@ -50,16 +48,17 @@ public:
 	bool isFromTrack( const Track * _track ) const override;
 
 	f_cnt_t framesRecorded() const;
-	void createSampleBuffer( SampleBuffer * * _sample_buf );
 
 
 private:
-	virtual void writeBuffer( const sampleFrame * _ab,
-						const f_cnt_t _frames );
+	class DiskWriter;
 
-	typedef QList<QPair<sampleFrame *, f_cnt_t> > bufferList;
-	bufferList m_buffers;
+	// streams the recorded frames to the file the TCO plays afterwards
+	std::unique_ptr<DiskWriter> m_writer;
 	f_cnt_t m_framesRecorded;
+	// the round-trip latency measured by LatencyProbe, the take arrives
+	// this much later than what was played to it
+	f_cnt_t m_framesToSkip;
 	TimePos m_minLength;
 
 	Track * m_track;
@@ -0,0 +1,193 @@
+/*
+ * SampleStream.h - plays long audio files from disk
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SAMPLE_STREAM_H
+#define SAMPLE_STREAM_H
+
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <sndfile.h>
+
+#include "lmms_basics.h"
+
+
+/*! \brief A long audio file, of which only a window is in memory.
+ *
+ *  A reader thread shared by all streams loads the blocks of the file around
+ *  the position the stream is read at, most of them ahead of it, so reading
+ *  needn't wait for the disk. Frames which aren't loaded (yet) after a jump
+ *  are read as silence, unless the reader waits for them. The reader also computes an overview of the whole
+ *  file for drawing it, when no block has to be loaded.
+ */
+class SampleStream
+{
+public:
+	//! The frames of one block, and how many of them are kept in memory
+	static const f_cnt_t BlockFrames = 65536;
+	static const int NumBlocks = 16;
+	//! The frames summarized by one point of the overview
+	static const f_cnt_t OverviewFrames = 1024;
+
+	struct OverviewPoint
+	{
+		float min;
+		float max;
+		// of both channels
+		float meanSquare;
+	} ;
+
+	//! Opens @p file for streaming if it's at least @p minSeconds long and
+	//! seekable, so shorter files are loaded completely. @p overviewDone is
+	//! called from the reader thread once the overview is complete.
+	static SampleStream * open( const QString & file, int minSeconds,
+					const std::function<void()> & overviewDone );
+	//! Whether open() would stream @p file, without starting to read it
+	static bool canStream( const QString & file, int minSeconds );
+	//! Another stream of the same file, which shares the overview once it
+	//! is complete
+	SampleStream * clone( const std::function<void()> & overviewDone ) const;
+	~SampleStream();
+
+	f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+	sample_rate_t sampleRate() const
+	{
+		return m_sampleRate;
+	}
+
+	//! Copies the frames [first, first + count) to @p dst and lets the
+	//! window follow them. Frames outside of the file or not in memory are
+	//! silent, in the latter case false is returned. Doesn't block, so it
+	//! can be called from the audio thread, unless @p wait is set (e.g.
+	//! when rendering offline), which loads missing blocks right away.
+	bool read( f_cnt_t first, f_cnt_t count, sampleFrame * dst, bool wait = false );
+
+	//! Loads the frames from @p frame on before they are read, e.g. when
+	//! the song is about to reach them
+	void prefetch( f_cnt_t frame )
+	{
+		m_playFrame.store( frame, std::memory_order_relaxed );
+	}
+
+	//! Replaces the function called once the overview is complete, e.g.
+	//! when the stream is handed to another owner
+	void setOverviewDone( const std::function<void()> & overviewDone );
+
+	//! Plays the file backwards, requires the stream not to be read
+	void setReversed( bool reversed );
+
+	//! The number of overview points computed so far, in the order of the
+	//! file rather than the order the stream is played in
+	int overviewPoints() const
+	{
+		return m_overview->ready.load( std::memory_order_acquire );
+	}
+
+	int overviewSize() const
+	{
+		return static_cast<int>( m_overview->points.size() );
+	}
+
+	const OverviewPoint & overviewPoint( int i ) const
+	{
+		return m_overview->points[i];
+	}
+
+	//! The memory used by the window, the overview is shared by clones
+	qint64 memoryUsage() const
+	{
+		return static_cast<qint64>( NumBlocks ) * BlockFrames * sizeof( sampleFrame )
+			+ m_overview->points.size() * sizeof( OverviewPoint )
+				/ std::max<long>( m_overview.use_count(), 1 );
+	}
+
+
+private:
+	struct Block
+	{
+		// the block of the stream the data belongs to, or -1 while the
+		// data is being replaced
+		std::atomic<f_cnt_t> index;
+		std::unique_ptr<sampleFrame[]> data;
+	} ;
+
+	struct Overview
+	{
+		std::vector<OverviewPoint> points;
+		std::atomic<int> ready;
+	} ;
+
+	SampleStream( const QString & file, const std::function<void()> & overviewDone );
+
+	bool openFile();
+	//! Allocates the window and lets the reader fill it
+	void start();
+
+	//! Loads the first missing block of the window, called by the reader,
+	//! returns whether there was one
+	bool fill();
+	//! Computes the overview of the next part of the file, called by the
+	//! reader if nothing had to be filled, returns whether there was more
+	bool scanOverview();
+	void loadBlock( Block & block, f_cnt_t index );
+	//! Reads @p count frames from @p first on in the order of the file
+	void readFile( f_cnt_t first, f_cnt_t count );
+
+	QString m_file;
+	QFile m_qfile;
+	SNDFILE * m_sndFile;
+	int m_channels;
+	f_cnt_t m_frames;
+	sample_rate_t m_sampleRate;
+
+	std::unique_ptr<Block[]> m_blocks;
+	std::atomic<f_cnt_t> m_playFrame;
+	bool m_reversed;
+
+	std::shared_ptr<Overview> m_overview;
+	bool m_scansOverview;
+	std::function<void()> m_overviewDone;
+
+	// interleaved frames of the file, only used by the reader
+	std::vector<float> m_fileBuffer;
+	// locked by the reader while it works on the stream
+	QMutex m_mutex;
+
+	friend class SampleStreamReader;
+
+} ;
+
+
+#endif
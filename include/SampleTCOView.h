@@ -55,8 +55,27 @@ protected:
 
 
 private:
+	//! What the waveform depends on, besides the sample itself
+	struct WaveformKey
+	{
+		QSize size;
+		QRect rect;
+		QRgb color;
+		bool reversed;
+
+		bool operator==( const WaveformKey & other ) const
+		{
+			return size == other.size && rect == other.rect &&
+				color == other.color && reversed == other.reversed;
+		}
+	} ;
+
 	SampleTCO * m_tco;
 	QPixmap m_paintPixmap;
+	//! The waveform, drawn over the background of m_paintPixmap. Reset
+	//! when the sample changes.
+	QPixmap m_waveform;
+	WaveformKey m_waveformKey;
 	bool splitTCO( const TimePos pos ) override;
 } ;
 
@@ -0,0 +1,117 @@
+/*
+ * SegmentRenderer.h - renders a song in parallel segments
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef SEGMENT_RENDERER_H
+#define SEGMENT_RENDERER_H
+
+#include <memory>
+#include <vector>
+
+#include <QtCore/QObject>
+#include <QtCore/QProcess>
+#include <QtCore/QTemporaryDir>
+
+#include "Mixer.h"
+#include "OutputSettings.h"
+#include "ProjectRenderer.h"
+
+class RenderManager;
+
+
+/*! \brief Renders a song in segments running in parallel (experimental)
+ *
+ *  The song is split at bars where nothing started before the pre-roll
+ *  still plays, e.g. at silent breaks between DJ mix sections. Each
+ *  segment is rendered by a process of its own, starting the pre-roll
+ *  earlier so envelopes and filters have settled, and the segments are
+ *  joined with a short crossfade at the end of each pre-roll. There, the
+ *  overlapping renderings are compared first; if they differ, or the song
+ *  uses plugins which don't declare themselves resettable, a tempo
+ *  automation or loops, the song is rendered in one pass instead.
+ */
+class SegmentRenderer : public QObject
+{
+	Q_OBJECT
+public:
+	SegmentRenderer( const Mixer::qualitySettings & qualitySettings,
+			const OutputSettings & outputSettings,
+			ProjectRenderer::ExportFileFormats format,
+			const QString & projectFile, const QString & outputFile,
+			int segments, bar_t preRoll );
+	virtual ~SegmentRenderer();
+
+	//! Start rendering the song loaded from the project file; when
+	//! finished, the application is quit
+	void start();
+
+public slots:
+	void updateConsoleProgress();
+
+private slots:
+	void segmentFinished();
+
+private:
+	struct Segment
+	{
+		// the ticks of the song the segment is used for
+		tick_t begin;
+		tick_t end;
+		// where rendering starts, before the pre-roll
+		tick_t renderBegin;
+		QString file;
+		std::unique_ptr<QProcess> process;
+	} ;
+
+	//! Returns why the song can't be rendered in segments, or an empty
+	//! string
+	QString checkSong() const;
+
+	//! Bars the song can be split at, in ascending order
+	std::vector<bar_t> splitPoints() const;
+
+	void startSegment( Segment & segment );
+	//! Join the segment renderings into the output file; returns why
+	//! that failed, or an empty string
+	QString joinSegments();
+	void renderInOnePass( const QString & reason );
+
+	const Mixer::qualitySettings m_qualitySettings;
+	const OutputSettings m_outputSettings;
+	const ProjectRenderer::ExportFileFormats m_format;
+	const QString m_projectFile;
+	const QString m_outputFile;
+	const int m_segmentCount;
+	const bar_t m_preRoll;
+
+	QTemporaryDir m_tempDir;
+	std::vector<Segment> m_segments;
+	int m_finishedCount;
+
+	std::unique_ptr<RenderManager> m_onePassRenderer;
+
+} ;
+
+
+#endif
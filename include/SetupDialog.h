@@ -91,6 +91,8 @@ private slots:
 	void toggleSmoothScroll(bool enabled);
 	void toggleAnimateAFP(bool enabled);
 	void toggleSyncVSTPlugins(bool enabled);
+	void toggleVSTSharedHost(bool enabled);
+	void toggleVSTSpareHosts(bool enabled);
 	void vstEmbedMethodChanged();
 	void toggleVSTAlwaysOnTop(bool en);
 	void toggleDisableAutoQuit(bool enabled);
@@ -98,11 +100,28 @@ private slots:
 	// Audio settings widget.
 	void audioInterfaceChanged(const QString & driver);
 	void toggleHQAudioDev(bool enabled);
+	void toggleWorkStealing(bool enabled);
+	void toggleBatchNotes(bool enabled);
+	void toggleOneShotCache(bool enabled);
+	void toggleAsyncRemotePlugins(bool enabled);
+	void toggleRemoteWatchdog(bool enabled);
+	void toggleLockMemory(bool enabled);
+	void toggleFlightRecorder(bool enabled);
+	void setCpuBudget(int load);
+	void setRenderCacheSize(int size);
+	void setWorkerThreads(int value);
+	void setWorkerScheduling(int index);
+	void setWorkerPriority(int value);
+	void setWorkerAffinity(const QString & cpus);
 	void setBufferSize(int value);
 	void resetBufferSize();
+	void measureLatency();
+	void latencyMeasured(bool success);
 
 	// MIDI settings widget.
 	void midiInterfaceChanged(const QString & driver);
+	void toggleMidiClockOut(bool enabled);
+	void toggleMidiTimeCodeOut(bool enabled);
 
 	// Paths settings widget.
 	void openWorkingDir();
@@ -117,6 +136,8 @@ private slots:
 	void setSF2File(const QString & sf2File);
 	void openGIGDir();
 	void setGIGDir(const QString & gigDir);
+	void openRenderCacheDir();
+	void setRenderCacheDir(const QString & renderCacheDir);
 	void openThemeDir();
 	void setThemeDir(const QString & themeDir);
 	void openBackgroundPicFile();
@@ -160,6 +181,8 @@ private:
 	LedCheckBox * m_vstAlwaysOnTopCheckBox;
 	bool m_vstAlwaysOnTop;
 	bool m_syncVSTPlugins;
+	bool m_vstSharedHost;
+	bool m_vstSpareHosts;
 	bool m_disableAutoQuit;
 
 
@@ -173,21 +196,39 @@ private:
 	trMap m_audioIfaceNames;
 	bool m_NaNHandler;
 	bool m_hqAudioDev;
+	bool m_workStealing;
+	bool m_flightRecorder;
+	bool m_batchNotes;
+	bool m_oneShotCache;
+	bool m_asyncRemotePlugins;
+	bool m_remoteWatchdog;
+	bool m_lockMemory;
+	int m_cpuBudget;
+	int m_renderCacheSize;
+	int m_workerThreads;
+	int m_workerScheduling;
+	int m_workerPriority;
+	QString m_workerAffinity;
 	int m_bufferSize;
 	QSlider * m_bufferSizeSlider;
 	QLabel * m_bufferSizeLbl;
+	QLabel * m_latencyLbl;
 
 	// MIDI settings widgets.
 	QComboBox * m_midiInterfaces;
 	MswMap m_midiIfaceSetupWidgets;
 	trMap m_midiIfaceNames;
 	QComboBox * m_assignableMidiDevices;
+	bool m_midiClockOut;
+	bool m_midiTimeCodeOut;
+	QComboBox * m_midiTimeCodeFps;
 
 	// Paths settings widgets.
 	QString m_workingDir;
 	QString m_vstDir;
 	QString m_ladspaDir;
 	QString m_gigDir;
+	QString m_renderCacheDir;
 	QString m_sf2Dir;
 #ifdef LMMS_HAVE_FLUIDSYNTH
 	QString m_sf2File;
@@ -200,6 +241,7 @@ private:
 	QLineEdit * m_themeDirLineEdit;
 	QLineEdit * m_ladspaDirLineEdit;
 	QLineEdit * m_gigDirLineEdit;
+	QLineEdit * m_renderCacheDirLineEdit;
 	QLineEdit * m_sf2DirLineEdit;
 #ifdef LMMS_HAVE_FLUIDSYNTH
 	QLineEdit * m_sf2FileLineEdit;
@@ -0,0 +1,172 @@
+/*
+ * SincResampler.h - windowed-sinc resampler with shared filter tables
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SINC_RESAMPLER_H
+#define SINC_RESAMPLER_H
+
+#include <cmath>
+#include <vector>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+/*! \brief Band-limited resampler for reading sample data at a varying rate.
+ *
+ *  The filter is a Kaiser-windowed sinc, tabulated finely enough to be
+ *  evaluated at any fractional position, so one table per quality serves
+ *  all phases and ratios. The tables are built on first use and shared by
+ *  all voices. When reading faster than one input frame per output frame,
+ *  the filter is stretched so it also removes everything above the new
+ *  Nyquist frequency.
+ *
+ *  The input is read through a source, which maps frame indices to frames
+ *  and so can implement looping without copying:
+ *
+ *      const sampleFrame * direct( f_cnt_t first, f_cnt_t last ) const;
+ *      const sampleFrame & at( f_cnt_t index ) const;
+ *
+ *  direct() returns the frames first to last if they are contiguous in
+ *  memory, or nullptr; at() returns any single frame.
+ */
+class LMMS_EXPORT SincResampler
+{
+public:
+	enum Quality
+	{
+		Linear,
+		SincFastest,
+		SincMedium,
+		SincBest,
+		NumQualities
+	} ;
+
+	//! Returns the resampler for the given quality
+	static const SincResampler & get( Quality quality );
+
+	//! Maps a libsamplerate converter type, as used by
+	//! Mixer::qualitySettings::libsrcInterpolation(), to a quality
+	static Quality qualityOfConverter( int converter );
+
+	/*! \brief Render frames to out
+	 *
+	 *  \param position The input position of the first output frame
+	 *  \param step The number of input frames per output frame
+	 */
+	template<class Source>
+	void resample( const Source & source, double position, double step,
+					sampleFrame * out, fpp_t frames ) const;
+
+	//! The most frames resample() reads before or after a position
+	f_cnt_t reach( double step ) const
+	{
+		if( m_quality == Linear )
+		{
+			return 1;
+		}
+		const double scale = step > 1.0 ? 1.0 / step : 1.0;
+		return static_cast<f_cnt_t>( std::ceil( m_zeroCrossings / scale ) ) + 1;
+	}
+
+private:
+	// table entries per zero crossing of the sinc
+	static const int Resolution = 512;
+
+	SincResampler( Quality quality, int zeroCrossings, float rolloff,
+							float kaiserBeta );
+
+	//! Filter value at x, in table entries from the center
+	inline float weight( float x ) const
+	{
+		const int i = static_cast<int>( x );
+		if( i >= m_length )
+		{
+			return 0.0f;
+		}
+		return m_filter[i] + m_deltas[i] * ( x - i );
+	}
+
+	Quality m_quality;
+	// zero crossings on each side of the center
+	int m_zeroCrossings;
+	int m_length;
+	std::vector<float> m_filter;
+	// differences to the next entry, for interpolating the table
+	std::vector<float> m_deltas;
+
+} ;
+
+
+
+
+template<class Source>
+void SincResampler::resample( const Source & source, double position,
+			double step, sampleFrame * out, fpp_t frames ) const
+{
+	if( m_quality == Linear )
+	{
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			const double t = position + f * step;
+			const f_cnt_t i = static_cast<f_cnt_t>( std::floor( t ) );
+			const float frac = static_cast<float>( t - i );
+			const sampleFrame & a = source.at( i );
+			const sampleFrame & b = source.at( i + 1 );
+			out[f][0] = a[0] + ( b[0] - a[0] ) * frac;
+			out[f][1] = a[1] + ( b[1] - a[1] ) * frac;
+		}
+		return;
+	}
+
+	const float scale = step > 1.0 ? static_cast<float>( 1.0 / step ) : 1.0f;
+	const double reach = m_zeroCrossings / scale;
+	const float tableStep = scale * Resolution;
+
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		const double t = position + f * step;
+		const f_cnt_t first =
+			static_cast<f_cnt_t>( std::floor( t - reach ) ) + 1;
+		const f_cnt_t last = static_cast<f_cnt_t>( std::floor( t + reach ) );
+		const sampleFrame * direct = source.direct( first, last );
+
+		float left = 0.0f;
+		float right = 0.0f;
+		// table position of the current tap, passing the center at t
+		float x = static_cast<float>( ( t - first ) * tableStep );
+		for( f_cnt_t j = first; j <= last; ++j, x -= tableStep )
+		{
+			const float w = weight( std::fabs( x ) );
+			const sampleFrame & s = direct != nullptr ?
+						direct[j - first] : source.at( j );
+			left += s[0] * w;
+			right += s[1] * w;
+		}
+		out[f][0] = left * scale;
+		out[f][1] = right * scale;
+	}
+}
+
+
+#endif
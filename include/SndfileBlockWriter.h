@@ -0,0 +1,115 @@
+/*
+ * SndfileBlockWriter.h - writes to libsndfile in large blocks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef SNDFILE_BLOCK_WRITER_H
+#define SNDFILE_BLOCK_WRITER_H
+
+#include <sndfile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lmms_basics.h"
+
+
+/*! \brief Collects the converted samples of many periods and hands them to
+ *  libsndfile at once
+ *
+ *  libsndfile writes the samples of every call straight to the file, so
+ *  writing period by period makes a system call for every few kilobytes
+ *  and gives encoders like FLAC's only a few frames at a time. The block
+ *  holds a little more than a second of audio.
+ */
+template<typename T>
+class SndfileBlockWriter
+{
+public:
+	static const f_cnt_t BlockFrames = 65536;
+
+	SndfileBlockWriter() :
+		m_channels( 0 ),
+		m_frames( 0 )
+	{
+	}
+
+	void setChannels( ch_cnt_t channels )
+	{
+		m_channels = channels;
+		m_samples.resize( static_cast<size_t>( BlockFrames ) * channels );
+	}
+
+	/*! \brief Room for @p frames frames, which are added with commit()
+	 *
+	 *  Writes the block first if they don't fit into it anymore. @p frames
+	 *  must not be more than BlockFrames.
+	 */
+	T * reserve( SNDFILE * sf, f_cnt_t frames )
+	{
+		if( m_frames + frames > BlockFrames )
+		{
+			flush( sf );
+		}
+		return m_samples.data() + static_cast<size_t>( m_frames ) * m_channels;
+	}
+
+	void commit( f_cnt_t frames )
+	{
+		m_frames += frames;
+	}
+
+	//! Writes the frames collected
+	void flush( SNDFILE * sf )
+	{
+		if( m_frames > 0 )
+		{
+			write( sf, m_samples.data(), m_frames );
+			m_frames = 0;
+		}
+	}
+
+private:
+	static void write( SNDFILE * sf, const float * samples, f_cnt_t frames )
+	{
+		sf_writef_float( sf, samples, frames );
+	}
+
+	static void write( SNDFILE * sf, const int32_t * samples, f_cnt_t frames )
+	{
+		sf_writef_int( sf, samples, frames );
+	}
+
+	static void write( SNDFILE * sf, const int16_t * samples, f_cnt_t frames )
+	{
+		sf_writef_short( sf, samples, frames );
+	}
+
+	ch_cnt_t m_channels;
+	f_cnt_t m_frames;
+	std::vector<T> m_samples;
+
+} ;
+
+#endif
@@ -25,21 +25,27 @@
 #ifndef SONG_H
 #define SONG_H
 
+#include <memory>
 #include <utility>
 
+#include <QtCore/QMutex>
 #include <QtCore/QSharedMemory>
 #include <QtCore/QVector>
 #include <QHash>
 #include <QString>
 
+#include "AutomationSchedule.h"
 #include "TrackContainer.h"
 #include "Controller.h"
 #include "MeterModel.h"
 #include "Mixer.h"
+#include "MidiSyncOutput.h"
+#include "TempoMap.h"
 #include "VstSyncController.h"
 
 
 class AutomationTrack;
+class DataFile;
 class Pattern;
 class TimeLineWidget;
 
@@ -140,28 +146,36 @@ public:
 
 	inline void setToTime(TimePos const & pos)
 	{
-		m_elapsedMilliSeconds[m_playMode] = pos.getTimeInMilliseconds(getTempo());
+		m_elapsedMilliSeconds[m_playMode] = millisecondsAt(pos.getTicks(), m_playMode);
 		m_playPos[m_playMode].setTicks(pos.getTicks());
 	}
 
 	inline void setToTime(TimePos const & pos, PlayModes playMode)
 	{
-		m_elapsedMilliSeconds[playMode] = pos.getTimeInMilliseconds(getTempo());
+		m_elapsedMilliSeconds[playMode] = millisecondsAt(pos.getTicks(), playMode);
 		m_playPos[playMode].setTicks(pos.getTicks());
 	}
 
 	inline void setToTimeByTicks(tick_t ticks)
 	{
-		m_elapsedMilliSeconds[m_playMode] = TimePos::ticksToMilliseconds(ticks, getTempo());
+		m_elapsedMilliSeconds[m_playMode] = millisecondsAt(ticks, m_playMode);
 		m_playPos[m_playMode].setTicks(ticks);
 	}
 
 	inline void setToTimeByTicks(tick_t ticks, PlayModes playMode)
 	{
-		m_elapsedMilliSeconds[playMode] = TimePos::ticksToMilliseconds(ticks, getTempo());
+		m_elapsedMilliSeconds[playMode] = millisecondsAt(ticks, playMode);
 		m_playPos[playMode].setTicks(ticks);
 	}
 
+	//! Returns the milliseconds it takes to play up to ticks in playMode;
+	//! in the song, they follow the tempo automation
+	double millisecondsAt(double ticks, PlayModes playMode) const;
+
+	//! Returns the frames it takes to play the song from begin to end,
+	//! following the tempo automation
+	double framesBetween(const TimePos& begin, const TimePos& end) const;
+
 	inline int getBars() const
 	{
 		return currentBar();
@@ -215,6 +229,11 @@ public:
 		m_exportLoop = exportLoop;
 	}
 
+	inline bool isExportLoop() const
+	{
+		return m_exportLoop;
+	}
+
 	inline bool isRecording() const
 	{
 		return m_recording;
@@ -236,17 +255,42 @@ public:
 
 	bool isExportDone() const;
 	int getExportProgress() const;
+	//! Share of the export rendered so far, from 0 to 1
+	double exportedFraction() const;
 
 	inline void setRenderBetweenMarkers( bool renderBetweenMarkers )
 	{
 		m_renderBetweenMarkers = renderBetweenMarkers;
 	}
 
+	inline bool isRenderBetweenMarkers() const
+	{
+		return m_renderBetweenMarkers;
+	}
+
+	//! Only export the song from @p begin to @p end, e.g. one segment of
+	//! a parallel render; an empty range exports the whole song
+	inline void setExportRange( const TimePos & begin, const TimePos & end )
+	{
+		m_exportRangeBegin = begin;
+		m_exportRangeEnd = end;
+	}
+
+	inline bool hasExportRange() const
+	{
+		return m_exportRangeEnd > m_exportRangeBegin;
+	}
+
 	inline PlayModes playMode() const
 	{
 		return m_playMode;
 	}
 
+	MidiSyncOutput & midiSyncOutput()
+	{
+		return m_midiSyncOutput;
+	}
+
 	inline PlayPos & getPlayPos( PlayModes pm )
 	{
 		return m_playPos[pm];
@@ -289,6 +333,13 @@ public:
 	bool guiSaveProject();
 	bool guiSaveProjectAs(const QString & filename);
 	bool saveProjectFile(const QString & filename, bool withResources = false);
+	//! Saves the project to @p filename in the background. Only the tracks
+	//! changed through the journal since the last call are saved again,
+	//! the others are reused until the next full save. Returns false if
+	//! the previous file is still being written.
+	bool autoSaveProjectFile( const QString & filename );
+	//! Waits until the file of autoSaveProjectFile() is written
+	void waitForAutoSave();
 
 	const QString & projectFileName() const
 	{
@@ -316,6 +367,11 @@ public:
 		return m_modified;
 	}
 
+	//! Whether the samples of instruments are kept compressed in memory,
+	//! which is saved with the project
+	bool compressSamples() const;
+	void setCompressSamples(bool compress);
+
 	QString nodeName() const override
 	{
 		return "song";
@@ -336,6 +392,16 @@ public:
 	}
 
 
+	const IntModel & tempoModel() const
+	{
+		return m_tempoModel;
+	}
+
+	const IntModel & masterPitchModel() const
+	{
+		return m_masterPitchModel;
+	}
+
 	MeterModel & getTimeSigModel()
 	{
 		return m_timeSigModel;
@@ -386,8 +452,14 @@ private slots:
 	void updateFramesPerTick();
 
 
+protected:
+	void saveTrack( Track * track, QDomDocument & doc,
+						QDomElement & parent ) override;
+
 
 private:
+	struct AutoSave;
+
 	Song();
 	Song( const Song & );
 	virtual ~Song();
@@ -411,17 +483,27 @@ private:
 
 	void setPlayPos( tick_t ticks, PlayModes playMode );
 
+	void saveProject( DataFile & dataFile );
+	void resetAutoSave();
+
+	//! Bypass the tracks which can't be heard while exporting, or all
+	//! tracks from bypassing when not exporting anymore
+	void updateBypassedTracks();
+
 	void saveControllerStates( QDomDocument & doc, QDomElement & element );
 	void restoreControllerStates( const QDomElement & element );
 
 	void removeAllControllers();
 
-	void processAutomations(const TrackList& tracks, TimePos timeStart, fpp_t frames);
+	void processAutomations(const TrackList& tracks, TimePos timeStart, fpp_t frames, f_cnt_t offset);
 
 	void setModified(bool value);
 
 	void setProjectFileName(QString const & projectFileName);
 
+	//! Rebuilds m_tempoMap if it is outdated; m_tempoMapMutex has to be locked
+	void updateTempoMap() const;
+
 	AutomationTrack * m_globalAutomationTrack;
 
 	IntModel m_tempoModel;
@@ -447,6 +529,7 @@ private:
 	volatile bool m_paused;
 
 	bool m_savingProject;
+	std::unique_ptr<AutoSave> m_autoSave;
 	bool m_loadingProject;
 	bool m_isCancelled;
 
@@ -466,6 +549,7 @@ private:
 	bar_t m_elapsedBars;
 
 	VstSyncController m_vstSyncController;
+	MidiSyncOutput m_midiSyncOutput;
     
 	int m_loopRenderCount;
 	int m_loopRenderRemaining;
@@ -473,9 +557,16 @@ private:
 	TimePos m_exportLoopBegin;
 	TimePos m_exportLoopEnd;
 	TimePos m_exportSongEnd;
-	TimePos m_exportEffectiveLength;
+	TimePos m_exportRangeBegin;
+	TimePos m_exportRangeEnd;
+	//! frames of one pass through the loop and of the whole export
+	double m_exportLoopFrames;
+	double m_exportEffectiveFrames;
+
+	AutomationSchedule m_automationSchedule;
 
-	AutomatedValueMap m_oldAutomatedValues;
+	mutable TempoMap m_tempoMap;
+	mutable QMutex m_tempoMapMutex;
 
 	friend class LmmsCore;
 	friend class SongEditor;
@@ -0,0 +1,125 @@
+/*
+ * TempoMap.h - the tempo of a song over time
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef TEMPO_MAP_H
+#define TEMPO_MAP_H
+
+#include <vector>
+
+#include "TimePos.h"
+
+class AutomatableModel;
+class AutomationSchedule;
+
+
+/*! \brief Converts between ticks and frames under tempo automation
+ *
+ *  Holds the tempo of every tick, as runs of ticks with the same tempo, and
+ *  the frame at which each run starts. A conversion is then a binary search
+ *  and one multiplication, instead of adding up the length of every tick,
+ *  and stays exact however the tempo is automated.
+ *
+ *  The map is built from an AutomationSchedule, so it follows the patterns
+ *  the way playback does. Where nothing automates the tempo, it keeps the
+ *  last automated value, and before any automation it is the value the
+ *  tempo model had when the map was built.
+ */
+class TempoMap
+{
+public:
+	//! Creates a map of DefaultTempo at the given sample rate
+	TempoMap(sample_rate_t sampleRate = 44100);
+
+	/*! \brief Builds the map from the automation of a tempo model
+	 *
+	 *  \param schedule A schedule built for the tracks to follow; its
+	 *	cursors are moved
+	 *  \param tempoModel The model holding the tempo
+	 *  \param sampleRate The sample rate to count frames in
+	 */
+	void build(AutomationSchedule& schedule, const AutomatableModel* tempoModel,
+							sample_rate_t sampleRate);
+
+	//! Returns whether the map still shows the tempo of the automation it
+	//! was built from, at the given sample rate. Toggling the mute state of
+	//! tracks and TCOs is not noticed.
+	bool isCurrent(const AutomatableModel* tempoModel, sample_rate_t sampleRate) const;
+
+	//! Returns the frame at which ticks are reached, counted from tick 0
+	double framesAt(double ticks) const;
+	//! Returns the ticks reached at frames
+	double ticksAt(double frames) const;
+
+	//! Returns the milliseconds at which ticks are reached
+	double millisecondsAt(double ticks) const
+	{
+		return framesAt(ticks) * 1000.0 / m_sampleRate;
+	}
+
+	//! Returns the frames it takes to play from begin to end
+	double framesBetween(tick_t begin, tick_t end) const
+	{
+		return framesAt(end) - framesAt(begin);
+	}
+
+	//! Returns the tempo at ticks
+	bpm_t tempoAt(tick_t ticks) const;
+
+	//! Frames per tick at a tempo, as Engine::framesPerTick() computes them
+	static float framesPerTick(sample_rate_t sampleRate, bpm_t tempo)
+	{
+		return sampleRate * 60.0f * 4 / DefaultTicksPerBar / tempo;
+	}
+
+private:
+	//! Ticks from tick on up to the next segment, all at the same tempo
+	struct Segment
+	{
+		tick_t tick;
+		//! the frame at tick
+		double frame;
+		float framesPerTick;
+		bpm_t tempo;
+	} ;
+
+	//! Starts a segment at tick, unless the tempo stays the same
+	void append(tick_t tick, bpm_t tempo);
+
+	//! Returns the segment containing ticks
+	const Segment& segmentAt(double ticks) const;
+
+	//! sorted by tick, never empty; the first one starts at tick 0 and the
+	//! last one lasts forever
+	std::vector<Segment> m_segments;
+	sample_rate_t m_sampleRate;
+
+	bool m_automated;
+	unsigned m_scheduleRevision;
+	unsigned m_editRevision;
+
+} ;
+
+
+#endif
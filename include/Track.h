@@ -188,6 +188,19 @@ public:
 	}
 	
 	BoolModel* getMutedModel();
+	BoolModel* getSoloModel();
+
+	//! Whether the track isn't played at all, because it can't be heard
+	//! in the export running, see Song::startExport()
+	bool isBypassed() const
+	{
+		return m_bypassed;
+	}
+
+	void setBypassed( bool bypassed )
+	{
+		m_bypassed = bypassed;
+	}
 
 public slots:
 	virtual void setName( const QString & newName )
@@ -212,6 +225,7 @@ protected:
 private:
 	BoolModel m_soloModel;
 	bool m_mutedBeforeSolo;
+	bool m_bypassed;
 
 	bool m_simpleSerializingMode;
 
@@ -26,6 +26,8 @@
 #ifndef TRACK_CONTAINER_H
 #define TRACK_CONTAINER_H
 
+#include <functional>
+
 #include <QtCore/QReadWriteLock>
 
 #include "Track.h"
@@ -55,6 +57,10 @@ public:
 
 	void loadSettings( const QDomElement & _this ) override;
 
+	//! Creates the tracks returned by @p nextTrack until it returns a null
+	//! element, showing the progress if @p showProgress is set
+	void loadTracks( const std::function<QDomElement()> & nextTrack,
+						bool showProgress = true );
 
 	virtual AutomationPattern * tempoAutomationPattern()
 	{
@@ -78,6 +84,11 @@ public:
 
 	bool isEmpty() const;
 
+	//! Play the renderings of the frozen tracks from frame @p frame of the
+	//! song on. Unlike notes, they are played for every part of a period,
+	//! as a tick may span periods.
+	void playFrozen( f_cnt_t frame, fpp_t frames, f_cnt_t offset );
+
 	static const QString classNodeName()
 	{
 		return "trackcontainer";
@@ -101,6 +112,10 @@ signals:
 protected:
 	static AutomatedValueMap automatedValuesFromTracks(const TrackList &tracks, TimePos timeStart, int tcoNum = -1);
 
+	//! Saves one of the tracks for saveSettings()
+	virtual void saveTrack( Track * track, QDomDocument & doc,
+							QDomElement & parent );
+
 	mutable QReadWriteLock m_tracksMutex;
 
 private:
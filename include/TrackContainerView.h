@@ -26,6 +26,7 @@
 #ifndef TRACK_CONTAINER_VIEW_H
 #define TRACK_CONTAINER_VIEW_H
 
+#include <QtCore/QPointer>
 #include <QtCore/QVector>
 #include <QScrollArea>
 #include <QWidget>
@@ -130,6 +131,8 @@ public:
 
 public slots:
 	void realignTracks();
+	//! Creates the view of @p _t, after the views of the tracks added
+	//! before it which have none yet
 	TrackView * createTrackView( Track * _t );
 	void deleteTrackView( TrackView * _tv );
 
@@ -142,6 +145,13 @@ public slots:
 	void stopRubberBand();
 
 
+private slots:
+	//! Adds a view for @p track in the next slice
+	void queueTrackView( Track * track );
+	void createQueuedTrackViews();
+	void realignAddedTracks();
+
+
 protected:
 	static const int DEFAULT_PIXELS_PER_BAR = 16;
 
@@ -157,6 +167,12 @@ private:
 		RemoveTrack
 	} ;
 
+	//! How long views are created for before the GUI gets to do other
+	//! things, like painting the ones created
+	static const int TrackViewSliceMs = 20;
+
+	TrackView * createView( Track * track );
+
 	class scrollArea : public QScrollArea
 	{
 	public:
@@ -183,6 +199,9 @@ private:
 
 	RubberBand * m_rubberBand;
 
+	//! tracks added which have no view yet, in the order they were added
+	QList<QPointer<Track>> m_queuedTracks;
+	bool m_realignQueued;
 
 
 signals:
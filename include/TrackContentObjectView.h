@@ -98,6 +98,10 @@ public:
 	bool needsUpdate();
 	void setNeedsUpdate( bool b );
 
+	//! Makes @p pixmap as large as the view in device pixels, so drawing
+	//! it on a HiDPI screen needs no scaling
+	void fitPaintPixmap( QPixmap & pixmap ) const;
+
 	// Method to get a QVector of TCOs to be affected by a context menu action
 	QVector<TrackContentObjectView *> getClickedTCOs();
 
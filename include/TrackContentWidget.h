@@ -25,6 +25,7 @@
 #ifndef TRACK_CONTENT_WIDGET_H
 #define TRACK_CONTENT_WIDGET_H
 
+#include <QSet>
 #include <QWidget>
 
 #include "JournallingObject.h"
@@ -32,8 +33,10 @@
 
 
 class QMimeData;
+class QPainter;
 
 class Track;
+class TrackContentObject;
 class TrackContentObjectView;
 class TrackView;
 
@@ -65,6 +68,14 @@ public:
 		}
 	}
 
+	bool hasTCOView( TrackContentObject * tco ) const
+	{
+		return m_viewedTCOs.contains( tco );
+	}
+
+	//! Moves a single view to where its TCO is, e.g. after it was moved
+	void updateTCOViewPosition( TrackContentObjectView * tcov );
+
 	bool canPasteSelection( TimePos tcoPos, const QDropEvent *de );
 	bool canPasteSelection( TimePos tcoPos, const QMimeData *md, bool allowSameBar = false );
 	bool pasteSelection( TimePos tcoPos, QDropEvent * de );
@@ -124,10 +135,15 @@ private:
 	Track * getTrack();
 	TimePos getPosition( int mouseX );
 
+	void placeTCOView( TrackContentObjectView * tcov,
+				int begin, int end, float ppb );
+	void paintPlaceholders( QPainter & p );
+
 	TrackView * m_trackView;
 
 	typedef QVector<TrackContentObjectView *> tcoViewVector;
 	tcoViewVector m_tcoViews;
+	QSet<TrackContentObject *> m_viewedTCOs;
 
 	QPixmap m_background;
 
@@ -97,6 +97,16 @@ public:
 
 	virtual void update();
 
+	/*! \brief Creates the views of the track's TCOs, done once the track
+	 *  is shown first. Until then its content widget only paints
+	 *  placeholders, so projects with many tracks open quickly. */
+	void createTCOViews();
+
+	bool hasTCOViews() const
+	{
+		return m_tcoViewsCreated;
+	}
+
 	// Create a menu for assigning/creating channels for this track
 	// Currently instrument track and sample track supports it
 	virtual QMenu * createFxMenu(QString title, QString newFxLabel);
@@ -152,6 +162,8 @@ private:
 
 	Actions m_action;
 
+	bool m_tcoViewsCreated;
+
 	virtual FadeButton * getActivityIndicator()
 	{
 		return nullptr;
@@ -0,0 +1,101 @@
+/*
+ * VisualizationTap.h - hands a reduced picture of audio to a view
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef VISUALIZATION_TAP_H
+#define VISUALIZATION_TAP_H
+
+#include <atomic>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+/*! \brief Passes a fixed-size, decimated snapshot of audio from the audio
+ *  thread to a view
+ *
+ *  write() reduces the frames it's given to at most MaxPoints points and
+ *  publishes them. Each point holds the minimum and maximum of the frames
+ *  it covers, which is what a waveform needs, and the first of them, which
+ *  is what a display plotting single frames needs. The snapshots are
+ *  triple buffered, so neither side ever waits or allocates, and a view
+ *  reading once per frame always gets the latest one.
+ *
+ *  A tap does nothing until a view attaches to it, so audio nobody looks
+ *  at is never copied.
+ */
+class LMMS_EXPORT VisualizationTap
+{
+public:
+	static const int MaxPoints = 2048;
+
+	struct Snapshot
+	{
+		int points;
+		//! frames covered by the snapshot, and by each point
+		f_cnt_t frames;
+		int framesPerPoint;
+		sampleFrame first[MaxPoints];
+		sampleFrame min[MaxPoints];
+		sampleFrame max[MaxPoints];
+	} ;
+
+	//! @p points is the most points written per snapshot
+	VisualizationTap(int points);
+	~VisualizationTap();
+
+	//! A view starts or stops using the tap, several views may share it
+	void attach() { m_views.fetch_add(1, std::memory_order_acq_rel); }
+	void detach() { m_views.fetch_sub(1, std::memory_order_acq_rel); }
+	bool enabled() const { return m_views.load(std::memory_order_acquire) > 0; }
+
+	//! Changes the most points per snapshot, from the next write() on
+	void setPoints(int points);
+
+	//! Reduces @p frames and publishes them, realtime safe. If
+	//! @p accumulate is true, the frames are added to the snapshot not yet
+	//! read instead of replacing it, up to MaxPoints points.
+	void write(const sampleFrame * buf, f_cnt_t frames, bool accumulate = false);
+
+	//! The newest snapshot, or nullptr if nothing was written since the
+	//! last call. It stays valid until the next call.
+	const Snapshot * read();
+
+private:
+	static const int FreshBit = 4;
+
+	Snapshot * m_slots[3];
+	int m_back;
+	// whether the back slot holds accumulated points not yet published
+	bool m_backFilled;
+	// index of the slot between writer and reader, plus FreshBit if the
+	// writer has put a snapshot there the reader hasn't taken yet
+	std::atomic<int> m_middle;
+	int m_front;
+
+	std::atomic<int> m_points;
+	std::atomic<int> m_views;
+} ;
+
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * WaveMipMapCache.h - band-limited mipmaps of arbitrary waveforms
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef WAVE_MIP_MAP_CACHE_H
+#define WAVE_MIP_MAP_CACHE_H
+
+#include <memory>
+#include <vector>
+
+#include <QtCore/QMutex>
+
+#include "BandLimitedWave.h"
+#include "lmms_export.h"
+#include "Oscillator.h"
+
+
+/*! \brief Builds band-limited mipmaps of any waveform, and shares them
+ *  between everything playing the same waveform
+ *
+ *  The mipmaps have the layout of the ones of BandLimitedWave, so they are
+ *  played with BandLimitedWave::oscillate(). Each table of the mipmap only
+ *  keeps the harmonics below half its length, which is where
+ *  BandLimitedWave cuts its own waves off, so a table picked for the
+ *  wavelength of a note doesn't alias.
+ *
+ *  A mipmap is built when its waveform is first asked for, e.g. when the
+ *  user draws a new wave, which is done with a few FFTs. It stays cached
+ *  while anyone uses it.
+ */
+class LMMS_EXPORT WaveMipMapCache
+{
+public:
+	typedef std::shared_ptr<const WaveMipMap> MipMapPtr;
+
+	//! The mipmap of one cycle of @p length samples. The harmonics the
+	//! samples can't hold, from half of @p length on, are left out.
+	static MipMapPtr get(const float * wave, int length);
+
+	//! The mipmap of one of the built-in waves of Oscillator, nullptr for
+	//! the noise and the user defined wave
+	static MipMapPtr get(Oscillator::WaveShapes shape);
+
+private:
+	// the built-in waves are sampled this finely, so their harmonics are
+	// accurate up to the ones of the longest table
+	static const int ShapeLength = 1 << 16;
+
+	struct Entry
+	{
+		quint64 hash;
+		std::vector<float> wave;
+		std::weak_ptr<const WaveMipMap> mipMap;
+	} ;
+
+	static MipMapPtr build(const float * wave, int length);
+
+	static QMutex s_mutex;
+	static std::vector<Entry> s_entries;
+
+} ;
+
+
+#endif
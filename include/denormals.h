@@ -11,21 +11,44 @@
 #ifdef __SSE3__
 #include <pmmintrin.h>
 #endif
+#if defined(__aarch64__) || defined(__arm__)
+#include <stdint.h>
+#endif
 
 
 // Set denormal protection for this thread. 
-// To be on the safe side, don't set the DAZ flag for SSE2 builds, 
-// even if most SSE2 CPUs can handle it. 
+// SSE2 builds only set the DAZ flag if the CPU is checked to support it.
+// This is cheap enough to be called for every period, which also undoes
+// plugins changing the flags.
 void inline disable_denormals() {
 #ifdef __SSE3__
 	/* DAZ flag */
 	_MM_SET_DENORMALS_ZERO_MODE( _MM_DENORMALS_ZERO_ON );
+#elif defined(__SSE2__) && defined(__GNUC__)
+	/* DAZ flag, which all CPUs with SSE3 have */
+	static const bool hasDaz = ( __builtin_cpu_init(),
+					__builtin_cpu_supports( "sse3" ) );
+	if( hasDaz )
+	{
+		_mm_setcsr( _mm_getcsr() | 0x0040 );
+	}
 #endif
 
 #ifdef __SSE__
 	/* FTZ flag */
 	_MM_SET_FLUSH_ZERO_MODE( _MM_FLUSH_ZERO_ON );
 #endif
+
+#if defined(__aarch64__)
+	/* FZ flag, which covers both on ARM */
+	uint64_t fpcr;
+	__asm__ __volatile__( "mrs %0, fpcr" : "=r"( fpcr ) );
+	__asm__ __volatile__( "msr fpcr, %0" : : "r"( fpcr | ( UINT64_C( 1 ) << 24 ) ) );
+#elif defined(__arm__) && defined(__ARM_FP)
+	uint32_t fpscr;
+	__asm__ __volatile__( "vmrs %0, fpscr" : "=r"( fpscr ) );
+	__asm__ __volatile__( "vmsr fpscr, %0" : : "r"( fpscr | ( 1u << 24 ) ) );
+#endif
 }
 
 #endif
@@ -137,4 +137,32 @@ inline float lagrangeInterpolate( float v0, float v1, float v2, float v3, float
 
 
 
+//! Block version of the 4-point interpolations above, e.g.
+//! interpolateBlock<optimal4pInterpolate>( ... ): out[i] is the
+//! interpolation of v0[i] to v3[i] at x[i]. Gathering the points into arrays
+//! first lets the compiler vectorize the polynomials. out may be any of the
+//! input arrays.
+template<float F( float, float, float, float, float )>
+inline void interpolateBlock( const float * v0, const float * v1, const float * v2,
+				const float * v3, const float * x, float * out, int frames )
+{
+	for( int i = 0; i < frames; ++i )
+	{
+		out[i] = F( v0[i], v1[i], v2[i], v3[i], x[i] );
+	}
+}
+
+
+//! Block version of linearInterpolate()
+inline void linearInterpolateBlock( const float * v0, const float * v1,
+					const float * x, float * out, int frames )
+{
+	for( int i = 0; i < frames; ++i )
+	{
+		out[i] = linearInterpolate( v0[i], v1[i], x[i] );
+	}
+}
+
+
+
 #endif
@@ -32,6 +32,8 @@ const long double LD_PI_R = 1.0 / LD_PI;
 const long double LD_PI_SQR = LD_PI * LD_PI;
 const long double LD_E = 2.71828182845904523536028747135266249775724709369995;
 const long double LD_E_R = 1.0 / LD_E;
+const long double LD_LN_2 = 0.69314718055994530941723212145817656807550013436026;
+const long double LD_LOG2_E = 1.0 / LD_LN_2;
 
 const double D_PI = (double) LD_PI;
 const double D_2PI = (double) LD_2PI;
@@ -40,6 +42,8 @@ const double D_PI_R = (double) LD_PI_R;
 const double D_PI_SQR = (double) LD_PI_SQR;
 const double D_E = (double) LD_E;
 const double D_E_R = (double) LD_E_R;
+const double D_LN_2 = (double) LD_LN_2;
+const double D_LOG2_E = (double) LD_LOG2_E;
 
 const float F_PI = (float) LD_PI;
 const float F_2PI = (float) LD_2PI;
@@ -48,6 +52,8 @@ const float F_PI_R = (float) LD_PI_R;
 const float F_PI_SQR = (float) LD_PI_SQR;
 const float F_E = (float) LD_E;
 const float F_E_R = (float) LD_E_R;
+const float F_LN_2 = (float) LD_LN_2;
+const float F_LOG2_E = (float) LD_LOG2_E;
 
 // Frequency ranges (in Hz).
 // Arbitrary low limit for logarithmic frequency scale; >1 Hz.
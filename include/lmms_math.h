@@ -27,6 +27,7 @@
 #define LMMS_MATH_H
 
 #include <cstdint>
+#include <cstring>
 #include "lmms_constants.h"
 #include "lmmsconfig.h"
 #include <QtCore/QtGlobal>
@@ -64,8 +65,10 @@ static inline float fraction( const float _x )
  */
 static inline float absFraction( const float _x )
 {
-	return( _x - ( _x >= 0.0f ? static_cast<int>( _x ) :
-						static_cast<int>( _x ) - 1 ) );
+	// written as a select rather than a branch on the sign, so that loops
+	// using it can be vectorized
+	const float t = static_cast<float>( static_cast<int>( _x ) );
+	return( _x - t + ( _x < t ? 1.0f : 0.0f ) );
 }
 
 /*!
@@ -314,6 +317,140 @@ static inline float fastSqrt( float n )
 	return u.f;
 }
 
+//! @brief Limits the magnitude of x to limit (which must be positive) without
+//! a floating point comparison, as GCC doesn't vectorize those in loops
+//! where the result is used in further arithmetic. NaN is limited as well.
+static inline float clampAbs( const float x, const float limit )
+{
+	int32_t bits;
+	int32_t limitBits;
+	memcpy( &bits, &x, sizeof( bits ) );
+	memcpy( &limitBits, &limit, sizeof( limitBits ) );
+	const int32_t magnitude = bits & 0x7fffffff;
+	bits = ( bits ^ magnitude ) | ( magnitude < limitBits ? magnitude : limitBits );
+	float result;
+	memcpy( &result, &bits, sizeof( result ) );
+	return result;
+}
+
+
+//! @brief Fast approximation of 2^x with a relative error below 3e-7.
+//! x is limited to [-126, 126].
+static inline float fastExp2f( float x )
+{
+	x = clampAbs( x, 126.0f );
+	// split x into the nearest integer and a remainder in [-0.5, 0.5]
+	const int n = static_cast<int>( x + 127.5f ) - 127;
+	const float y = ( x - static_cast<float>( n ) ) * F_LN_2;
+	// Taylor series of e^y up to y^6
+	const float p = 1.0f + y * ( 1.0f + y * ( 1.0f / 2.0f + y * ( 1.0f / 6.0f +
+		y * ( 1.0f / 24.0f + y * ( 1.0f / 120.0f + y * ( 1.0f / 720.0f ) ) ) ) ) );
+	const int32_t bits = ( n + 127 ) << 23;
+	float scale;
+	memcpy( &scale, &bits, sizeof( scale ) );
+	return p * scale;
+}
+
+
+//! @brief Fast approximation of e^x with a relative error below
+//! 3e-7 + 5e-8 |x|, growing as x is rounded to a power of two.
+//! x is limited to about [-87, 87].
+static inline float fastExpf( const float x )
+{
+	return fastExp2f( x * F_LOG2_E );
+}
+
+
+//! @brief Fast approximation of log2(x), accurate to 1.5e-7 plus the
+//! rounding of the result. x must be a positive normal number.
+static inline float fastLog2f( const float x )
+{
+	int32_t bits;
+	memcpy( &bits, &x, sizeof( bits ) );
+	// split x into a power of two and a mantissa in [sqrt(1/2), sqrt(2)),
+	// 0x3f3504f3 being sqrt(1/2)
+	const int32_t offset = bits - 0x3f3504f3;
+	const float e = static_cast<float>( offset >> 23 );
+	bits = ( offset & 0x007fffff ) + 0x3f3504f3;
+	float m;
+	memcpy( &m, &bits, sizeof( m ) );
+	// ln(m) = 2 atanh(z), with |z| <= 0.172 the series converges quickly
+	const float z = ( m - 1.0f ) / ( m + 1.0f );
+	const float z2 = z * z;
+	const float ln = 2.0f * z * ( 1.0f + z2 * ( 1.0f / 3.0f + z2 * ( 1.0f / 5.0f +
+		z2 * ( 1.0f / 7.0f + z2 * ( 1.0f / 9.0f ) ) ) ) );
+	return e + ln * F_LOG2_E;
+}
+
+
+//! @brief Fast approximation of ln(x), see fastLog2f()
+static inline float fastLogf( const float x )
+{
+	return fastLog2f( x ) * F_LN_2;
+}
+
+
+//! @brief Fast approximation of tanh(x) with an absolute error below 2e-7
+static inline float fastTanhf( const float x )
+{
+	// tanh(9) is 1 in single precision
+	const float e = fastExp2f( clampAbs( x, 9.0f ) * ( 2.0f * F_LOG2_E ) );
+	return ( e - 1.0f ) / ( e + 1.0f );
+}
+
+
+//! @brief Fast approximation of sin(2 pi x), i.e. of a sine with a phase
+//! measured in periods, with an absolute error below 1.2e-6
+static inline float fastSin2Pi( const float x )
+{
+	// fold the phase into [-1/4, 1/4], i.e. [-pi/2, pi/2]
+	const float z = absFraction( x + 0.25f );
+	const float a = ( 0.25f - fabsf( z - 0.5f ) ) * F_2PI;
+	const float a2 = a * a;
+	// Taylor series up to a^11
+	return a * ( 1.0f + a2 * ( -1.0f / 6.0f + a2 * ( 1.0f / 120.0f +
+		a2 * ( -1.0f / 5040.0f + a2 * ( 1.0f / 362880.0f +
+		a2 * ( -1.0f / 39916800.0f ) ) ) ) ) );
+}
+
+
+//! @brief Fast approximation of sin(x), see fastSin2Pi(). The error grows
+//! with |x| though, as x is rounded when it's converted to a phase.
+static inline float fastSinf( const float x )
+{
+	return fastSin2Pi( x * ( 1.0f / F_2PI ) );
+}
+
+
+//! @brief Fast version of dbfsToAmp(), see fastExp2f()
+static inline float fastDbfsToAmp( const float dbfs )
+{
+	// 10^(dbfs / 20) = 2^(dbfs * log2(10) / 20)
+	return fastExp2f( dbfs * 0.166096404744368118f );
+}
+
+
+//! @brief Fast version of ampToDbfs(), see fastLog2f()
+static inline float fastAmpToDbfs( const float amp )
+{
+	// 20 * log10(amp) = 20 * log10(2) * log2(amp)
+	return fastLog2f( amp ) * 6.02059991327962390f;
+}
+
+
+//! @brief Applies a function like the approximations above to a block of
+//! values, which lets the compiler vectorize it, e.g.
+//! mathBlock<fastTanhf>( in, out, frames ). in and out may be the same.
+template<float F( float )>
+static inline void mathBlock( const float * in, float * out, const int frames )
+{
+	for( int i = 0; i < frames; ++i )
+	{
+		out[i] = F( in[i] );
+	}
+}
+
+
 //! returns value furthest from zero
 template<class T>
 static inline T absMax( T a, T b )
@@ -43,6 +43,16 @@ public:
 		return &m_ampControls;
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
+	f_cnt_t tailLength() const override
+	{
+		return 0;
+	}
+
 
 private:
 	AmplifierControls m_ampControls;
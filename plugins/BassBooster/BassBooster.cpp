@@ -69,6 +69,23 @@ BassBoosterEffect::~BassBoosterEffect()
 
 
 bool BassBoosterEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames )
+{
+	return process( ChannelView::ofInterleaved( buf, 0 ),
+			ChannelView::ofInterleaved( buf, 1 ), frames );
+}
+
+
+
+
+bool BassBoosterEffect::processPlanarBuffer( PlanarBuffer& buf, const fpp_t frames )
+{
+	return process( buf.channelView( 0 ), buf.channelView( 1 ), frames );
+}
+
+
+
+
+bool BassBoosterEffect::process( ChannelView left, ChannelView right, const fpp_t frames )
 {
 	if( !isEnabled() || !isRunning () )
 	{
@@ -83,6 +100,21 @@ bool BassBoosterEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames
 	if( m_bbControls.m_gainModel.isValueChanged() ) { changeGain(); }
 	if( m_bbControls.m_ratioModel.isValueChanged() ) { changeRatio(); }
 
+	// the channels are boosted independently, one after the other
+	const double outSum = processChannel( m_bbFX.leftFX(), left, frames ) +
+				processChannel( m_bbFX.rightFX(), right, frames );
+
+	checkGate( outSum / frames );
+
+	return isRunning();
+}
+
+
+
+
+double BassBoosterEffect::processChannel( DspEffectLibrary::FastBassBoost& fx,
+					ChannelView samples, const fpp_t frames )
+{
 	const float const_gain = m_bbControls.m_gainModel.value();
 	const ValueBuffer *gainBuffer = m_bbControls.m_gainModel.valueBuffer();
 
@@ -92,26 +124,14 @@ bool BassBoosterEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames
 
 	for( fpp_t f = 0; f < frames; ++f )
 	{
-		float gain = const_gain;
-		if (gainBuffer) {
-			//process period using sample exact data
-			gain = gainBuffer->value( f );
-		}
-		//float gain = gainBuffer ? gainBuffer[f] : gain;
-		m_bbFX.leftFX().setGain( gain );
-		m_bbFX.rightFX().setGain( gain);
-
-		sample_t s[2] = { buf[f][0], buf[f][1] };
-		m_bbFX.nextSample( s[0], s[1] );
-
-		buf[f][0] = d * buf[f][0] + w * s[0];
-		buf[f][1] = d * buf[f][1] + w * s[1];
-		outSum += buf[f][0] * buf[f][0] + buf[f][1] * buf[f][1];
-	}
-
-	checkGate( outSum / frames );
+		//process period using sample exact data
+		fx.setGain( gainBuffer ? gainBuffer->value( f ) : const_gain );
 
-	return isRunning();
+		const sample_t s = fx.nextSample( samples[f] );
+		samples[f] = d * samples[f] + w * s;
+		outSum += samples[f] * samples[f];
+	}
+	return outSum;
 }
 
 
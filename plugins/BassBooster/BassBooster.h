@@ -29,6 +29,7 @@
 #include "Effect.h"
 #include "DspEffectLibrary.h"
 #include "BassBoosterControls.h"
+#include "PlanarBuffer.h"
 
 
 class BassBoosterEffect : public Effect
@@ -38,13 +39,29 @@ public:
 	virtual ~BassBoosterEffect();
 	virtual bool processAudioBuffer( sampleFrame* buf, const fpp_t frames );
 
+	bool prefersPlanar() const override
+	{
+		return true;
+	}
+
+	bool processPlanarBuffer( PlanarBuffer& buf, const fpp_t frames ) override;
+
 	virtual EffectControls* controls()
 	{
 		return &m_bbControls;
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
 
 protected:
+	bool process( ChannelView left, ChannelView right, const fpp_t frames );
+	double processChannel( DspEffectLibrary::FastBassBoost& fx,
+				ChannelView samples, const fpp_t frames );
+
 	void changeFrequency();
 	void changeGain();
 	void changeRatio();
@@ -56,9 +56,6 @@ CompressorEffect::CompressorEffect(Model* parent, const Descriptor::SubPluginFea
 
 	m_yL[0] = m_yL[1] = COMP_NOISE_FLOOR;
 
-	m_maxLookaheadVal[0] = 0;
-	m_maxLookaheadVal[1] = 0;
-
 	// 200 ms
 	m_crestTimeConst = exp(-1.f / (0.2f * m_sampleRate));
 
@@ -238,6 +235,14 @@ void CompressorEffect::calcMix()
 
 
 
+f_cnt_t CompressorEffect::latency() const
+{
+	// the lookahead delays the signal by a fixed 20 ms
+	return m_compressorControls.m_lookaheadModel.value() ? m_lookaheadDelayLength : 0;
+}
+
+
+
 bool CompressorEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 {
 	if (!isEnabled() || !isRunning())
@@ -249,17 +254,7 @@ bool CompressorEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 			m_gainResult[0] = m_gainResult[1] = 1;
 			m_displayPeak[0] = m_displayPeak[1] = COMP_NOISE_FLOOR;
 			m_displayGain[0] = m_displayGain[1] = COMP_NOISE_FLOOR;
-			std::fill(std::begin(m_lookaheadBuf[0]), std::end(m_lookaheadBuf[0]), 0);
-			std::fill(std::begin(m_lookaheadBuf[1]), std::end(m_lookaheadBuf[1]), 0);
-			m_lookaheadBufLoc[0] = 0;
-			m_lookaheadBufLoc[1] = 0;
-			std::fill(std::begin(m_preLookaheadBuf[0]), std::end(m_preLookaheadBuf[0]), 0);
-			std::fill(std::begin(m_preLookaheadBuf[1]), std::end(m_preLookaheadBuf[1]), 0);
-			m_preLookaheadBufLoc[0] = 0;
-			m_preLookaheadBufLoc[1] = 0;
-			std::fill(std::begin(m_inputBuf[0]), std::end(m_inputBuf[0]), 0);
-			std::fill(std::begin(m_inputBuf[1]), std::end(m_inputBuf[1]), 0);
-			m_inputBufLoc = 0;
+			clearLookahead();
 			m_cleanedBuffers = true;
 		}
 		return false;
@@ -330,51 +325,35 @@ bool CompressorEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 			// Grab the peak or RMS value
 			inputValue = qMax(COMP_NOISE_FLOOR, peakmode ? abs(inputValue) : sqrt(m_rmsVal[i]));
 
-			// The following code uses math magic to semi-efficiently
-			// find the largest value in the lookahead buffer.
-			// This can probably be improved.
 			if (lookahead)
 			{
 				// Pre-lookahead delay, so the total delay always matches 20 ms
-				++m_preLookaheadBufLoc[i];
-				if (m_preLookaheadBufLoc[i] >= m_preLookaheadLength)
-				{
-					m_preLookaheadBufLoc[i] = 0;
-				}
-				const float tempInputValue = inputValue;
-				inputValue = m_preLookaheadBuf[i][m_preLookaheadBufLoc[i]];
-				m_preLookaheadBuf[i][m_preLookaheadBufLoc[i]] = tempInputValue;
-
-
-				// Increment ring buffer location
-				++m_lookaheadBufLoc[i];
-				if (m_lookaheadBufLoc[i] >= m_lookaheadLength)
-				{
-					m_lookaheadBufLoc[i] = 0;
-				}
-
-				m_lookaheadBuf[i][m_lookaheadBufLoc[i]] = inputValue;
-
-				// If the new input value is larger than the stored maximum,
-				// store that as the maximum
-				if (inputValue >= m_maxLookaheadVal[i])
+				std::vector<float> & preBuf = m_preLookaheadBuf[i];
+				preBuf[m_lookaheadPos] = inputValue;
+				inputValue = preBuf[(m_lookaheadPos - m_preLookaheadLength) & m_lookaheadMask];
+
+				// Keep the deque decreasing: a value can't be the maximum
+				// while a newer value at least as large is in the window
+				unsigned int & head = m_peakQueueHead[i];
+				unsigned int & tail = m_peakQueueTail[i];
+				std::vector<unsigned int> & queuePos = m_peakQueuePos[i];
+				std::vector<float> & queueVal = m_peakQueueVal[i];
+				while (tail != head && queueVal[(tail - 1) & m_lookaheadMask] <= inputValue)
 				{
-					m_maxLookaheadVal[i] = inputValue;
-					m_maxLookaheadTimer[i] = m_lookaheadLength;
+					--tail;
 				}
+				queuePos[tail & m_lookaheadMask] = m_lookaheadPos;
+				queueVal[tail & m_lookaheadMask] = inputValue;
+				++tail;
 
-				// Decrement timer.  When the timer reaches 0, that means the
-				// stored maximum value has left the buffer and a new
-				// maximum value must be found.
-				if (--m_maxLookaheadTimer[i] <= 0)
+				// Drop the front once it has left the window
+				while (((m_lookaheadPos - queuePos[head & m_lookaheadMask]) & m_lookaheadMask) >=
+					static_cast<unsigned int>(m_lookaheadLength))
 				{
-					m_maxLookaheadTimer[i] = std::distance(std::begin(m_lookaheadBuf[i]),
-						std::max_element(std::begin(m_lookaheadBuf[i]), std::begin(m_lookaheadBuf[i]) + m_lookaheadLength));
-					m_maxLookaheadVal[i] = m_lookaheadBuf[i][m_maxLookaheadTimer[i]];
-					m_maxLookaheadTimer[i] = realmod(m_maxLookaheadTimer[i] - m_lookaheadBufLoc[i], m_lookaheadLength);
+					++head;
 				}
 
-				inputValue = m_maxLookaheadVal[i];
+				inputValue = queueVal[head & m_lookaheadMask];
 			}
 
 			float t = inputValue;
@@ -507,18 +486,13 @@ bool CompressorEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 		// Delay the signal by 20 ms via ring buffer if lookahead is enabled
 		if (lookahead)
 		{
-			++m_inputBufLoc;
-			if (m_inputBufLoc >= m_lookaheadDelayLength)
-			{
-				m_inputBufLoc = 0;
-			}
+			const unsigned int delayed = (m_lookaheadPos - m_lookaheadDelayLength) & m_lookaheadMask;
+			m_inputBuf[0][m_lookaheadPos] = drySignal[0];
+			m_inputBuf[1][m_lookaheadPos] = drySignal[1];
+			s[0] = m_inputBuf[0][delayed];
+			s[1] = m_inputBuf[1][delayed];
 
-			const float temp[2] = {drySignal[0], drySignal[1]};
-			s[0] = m_inputBuf[0][m_inputBufLoc];
-			s[1] = m_inputBuf[1][m_inputBufLoc];
-
-			m_inputBuf[0][m_inputBufLoc] = temp[0];
-			m_inputBuf[1][m_inputBufLoc] = temp[1];
+			m_lookaheadPos = (m_lookaheadPos + 1) & m_lookaheadMask;
 		}
 		else
 		{
@@ -590,12 +564,6 @@ bool CompressorEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
 }
 
 
-// Regular modulo doesn't handle negative numbers correctly.  This does.
-inline int CompressorEffect::realmod(int k, int n)
-{
-	return (k %= n) < 0 ? k+n : k;
-}
-
 // Regular fmod doesn't handle negative numbers correctly.  This does.
 inline float CompressorEffect::realfmod(float k, float n)
 {
@@ -604,6 +572,20 @@ inline float CompressorEffect::realfmod(float k, float n)
 
 
 
+void CompressorEffect::clearLookahead()
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		std::fill(m_inputBuf[i].begin(), m_inputBuf[i].end(), 0);
+		std::fill(m_preLookaheadBuf[i].begin(), m_preLookaheadBuf[i].end(), 0);
+		m_peakQueueHead[i] = 0;
+		m_peakQueueTail[i] = 0;
+	}
+	m_lookaheadPos = 0;
+}
+
+
+
 inline void CompressorEffect::calcTiltFilter(sample_t inputSample, sample_t &outputSample, int filtNum)
 {
 	m_tiltOut[filtNum] = m_a0 * inputSample + m_b1 * m_tiltOut[filtNum];
@@ -621,16 +603,23 @@ void CompressorEffect::changeSampleRate()
 	// 200 ms
 	m_crestTimeConst = exp(-1.f / (0.2f * m_sampleRate));
 
-	// 20 ms
+	// 20 ms, the rings also hold the frame being written
 	m_lookaheadDelayLength = 0.02 * m_sampleRate;
-	m_inputBuf[0].resize(m_lookaheadDelayLength);
-	m_inputBuf[1].resize(m_lookaheadDelayLength);
-
-	m_lookaheadBuf[0].resize(m_lookaheadDelayLength);
-	m_lookaheadBuf[1].resize(m_lookaheadDelayLength);
+	unsigned int size = 1;
+	while (size <= static_cast<unsigned int>(m_lookaheadDelayLength))
+	{
+		size <<= 1;
+	}
+	m_lookaheadMask = size - 1;
 
-	m_preLookaheadBuf[0].resize(m_lookaheadDelayLength);
-	m_preLookaheadBuf[1].resize(m_lookaheadDelayLength);
+	for (int i = 0; i < 2; ++i)
+	{
+		m_inputBuf[i].resize(size);
+		m_preLookaheadBuf[i].resize(size);
+		m_peakQueuePos[i].resize(size);
+		m_peakQueueVal[i].resize(size);
+	}
+	clearLookahead();
 
 	calcThreshold();
 	calcKnee();
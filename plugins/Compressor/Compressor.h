@@ -42,6 +42,7 @@ public:
 	CompressorEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key);
 	~CompressorEffect() override;
 	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
+	f_cnt_t latency() const override;
 
 	EffectControls* controls() override
 	{
@@ -74,19 +75,27 @@ private:
 	float msToCoeff(float ms);
 
 	inline void calcTiltFilter(sample_t inputSample, sample_t &outputSample, int filtNum);
-	inline int realmod(int k, int n);
 	inline float realfmod(float k, float n);
 
 	enum StereoLinkModes { Unlinked, Maximum, Average, Minimum, Blend };
 
+	void clearLookahead();
+
+	// All lookahead rings are sized to a power of two no smaller than the
+	// 20 ms delay, so a position wraps with m_lookaheadMask.
+	unsigned int m_lookaheadMask = 0;
+	unsigned int m_lookaheadPos = 0;
+
 	std::vector<float> m_preLookaheadBuf[2];
-	int m_preLookaheadBufLoc[2] = {0};
 
-	std::vector<float> m_lookaheadBuf[2];
-	int m_lookaheadBufLoc[2] = {0};
+	// Sliding window maximum of the lookahead: a deque of the frames that
+	// can still become the maximum, with values decreasing from the front
+	std::vector<unsigned int> m_peakQueuePos[2];
+	std::vector<float> m_peakQueueVal[2];
+	unsigned int m_peakQueueHead[2] = {0, 0};
+	unsigned int m_peakQueueTail[2] = {0, 0};
 
 	std::vector<float> m_inputBuf[2];
-	int m_inputBufLoc = 0;
 
 	float m_attCoeff;
 	float m_relCoeff;
@@ -109,10 +118,6 @@ private:
 
 	float m_coeffPrecalc;
 
-	sampleFrame m_maxLookaheadVal;
-
-	int m_maxLookaheadTimer[2] = {1, 1};
-	
 	float m_rmsTimeConst;
 	float m_rmsVal[2] = {0, 0};
 
@@ -0,0 +1,183 @@
+/*
+ * ConvolutionReverb.cpp - reverb by convolution with an impulse response
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolutionReverb.h"
+
+#include <cmath>
+
+#include "embed.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "PathUtil.h"
+#include "plugin_export.h"
+
+
+extern "C"
+{
+
+Plugin::Descriptor PLUGIN_EXPORT convolutionreverb_plugin_descriptor =
+{
+	STRINGIFY(PLUGIN_NAME),
+	"Convolution Reverb",
+	QT_TRANSLATE_NOOP("PluginBrowser", "Reverb by convolution with an impulse response"),
+	"LMMS Developers",
+	0x0100,
+	Plugin::Effect,
+	new PluginPixmapLoader("logo"),
+	NULL,
+	NULL
+} ;
+
+}
+
+
+
+
+ConvolutionReverbEffect::ConvolutionReverbEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key) :
+	Effect(&convolutionreverb_plugin_descriptor, parent, key),
+	m_controls(this),
+	m_cleared(true)
+{
+}
+
+
+
+
+ConvolutionReverbEffect::~ConvolutionReverbEffect()
+{
+}
+
+
+
+
+bool ConvolutionReverbEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
+{
+	if (!isEnabled() || !isRunning() || m_engine == nullptr)
+	{
+		// don't let the old tail ring out when the effect wakes up
+		if (!m_cleared && m_engine != nullptr)
+		{
+			m_engine->reset();
+			m_cleared = true;
+		}
+		return false;
+	}
+	m_cleared = false;
+
+	double outSum = 0.0;
+	const float d = dryLevel();
+	const float w = wetLevel();
+	const float gain = std::pow(10.0f, m_controls.m_gainModel.value() / 20.0f);
+
+	sampleFrame wet[ConvolutionEngine::HeadBlockSize];
+	for (fpp_t offset = 0; offset < frames; offset += ConvolutionEngine::HeadBlockSize)
+	{
+		const fpp_t count = qMin<fpp_t>(frames - offset, ConvolutionEngine::HeadBlockSize);
+		sampleFrame * block = buf + offset;
+
+		m_engine->process(block, wet, count);
+
+		for (fpp_t f = 0; f < count; ++f)
+		{
+			block[f][0] = d * block[f][0] + w * gain * wet[f][0];
+			block[f][1] = d * block[f][1] + w * gain * wet[f][1];
+			outSum += block[f][0] * block[f][0] + block[f][1] * block[f][1];
+		}
+	}
+
+	checkGate(outSum / frames);
+
+	return isRunning();
+}
+
+
+
+
+void ConvolutionReverbEffect::loadImpulseResponse(const QString & file)
+{
+	std::unique_ptr<SampleBuffer> impulse;
+	std::unique_ptr<ConvolutionEngine> engine;
+
+	if (!file.isEmpty())
+	{
+		impulse.reset(new SampleBuffer(file));
+		const f_cnt_t frames = qMin<f_cnt_t>(impulse->frames(),
+			MaxSeconds * Engine::mixer()->processingSampleRate());
+
+		// a file that can't be decoded leaves a single silent frame
+		if (impulse->data() != nullptr && frames > 1)
+		{
+			// scale to unit energy, so responses of any length and level
+			// come out about as loud as the dry signal
+			const sampleFrame * data = impulse->data();
+			double energy[DEFAULT_CHANNELS] = {0, 0};
+			for (f_cnt_t f = 0; f < frames; ++f)
+			{
+				energy[0] += data[f][0] * data[f][0];
+				energy[1] += data[f][1] * data[f][1];
+			}
+			const double peak = qMax(energy[0], energy[1]);
+			const float scale = peak > 0 ? 1.0 / std::sqrt(peak) : 0.0f;
+
+			std::vector<sampleFrame> scaled(frames);
+			for (f_cnt_t f = 0; f < frames; ++f)
+			{
+				scaled[f][0] = data[f][0] * scale;
+				scaled[f][1] = data[f][1] * scale;
+			}
+			engine.reset(new ConvolutionEngine(scaled.data(), frames));
+		}
+	}
+
+	// the partitions are transformed by now, the audio thread only has to
+	// wait for the pointers to be swapped
+	Engine::mixer()->requestChangeInModel();
+	m_engine.swap(engine);
+	m_cleared = true;
+	Engine::mixer()->doneChangeInModel();
+
+	m_impulse.swap(impulse);
+}
+
+
+
+
+void ConvolutionReverbEffect::changeSampleRate()
+{
+	loadImpulseResponse(PathUtil::toAbsolute(m_controls.m_file));
+}
+
+
+
+
+extern "C"
+{
+
+// necessary for getting instance out of shared lib
+PLUGIN_EXPORT Plugin * lmms_plugin_main(Model* parent, void* data)
+{
+	return new ConvolutionReverbEffect(parent, static_cast<const Plugin::Descriptor::SubPluginFeatures::Key *>(data));
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+ * ConvolutionReverb.h - reverb by convolution with an impulse response
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CONVOLUTION_REVERB_H
+#define CONVOLUTION_REVERB_H
+
+#include <memory>
+
+#include "ConvolutionEngine.h"
+#include "ConvolutionReverbControls.h"
+#include "Effect.h"
+#include "SampleBuffer.h"
+
+
+class ConvolutionReverbEffect : public Effect
+{
+public:
+	ConvolutionReverbEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key);
+	~ConvolutionReverbEffect() override;
+	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
+
+	EffectControls* controls() override
+	{
+		return &m_controls;
+	}
+
+	f_cnt_t tailLength() const override
+	{
+		return m_engine ? m_engine->length() : 0;
+	}
+
+	qint64 memoryUsage() const override
+	{
+		return (m_impulse ? m_impulse->memoryUsage() : 0)
+			+ (m_engine ? m_engine->memoryUsage() : 0);
+	}
+
+	//! Loads the impulse response from @p file, or drops it if @p file is
+	//! empty. The audio thread keeps the old one until the new one is ready.
+	void loadImpulseResponse(const QString & file);
+
+	//! The buffer of the impulse response, nullptr if there is none
+	const SampleBuffer * impulseResponse() const
+	{
+		return m_impulse.get();
+	}
+
+	void changeSampleRate();
+
+private:
+	//! Longer impulse responses are cut off
+	static const int MaxSeconds = 30;
+
+	ConvolutionReverbControls m_controls;
+
+	// kept while it's used, so other instances loading the same file get
+	// the decoded frames from the sample cache
+	std::unique_ptr<SampleBuffer> m_impulse;
+	std::unique_ptr<ConvolutionEngine> m_engine;
+	bool m_cleared;
+
+	friend class ConvolutionReverbControls;
+} ;
+
+#endif
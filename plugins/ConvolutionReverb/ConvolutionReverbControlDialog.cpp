@@ -0,0 +1,100 @@
+/*
+ * ConvolutionReverbControlDialog.cpp - control dialog of the convolution reverb
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QFileInfo>
+#include <QLabel>
+
+#include "ConvolutionReverbControlDialog.h"
+#include "ConvolutionReverb.h"
+#include "ConvolutionReverbControls.h"
+#include "embed.h"
+#include "Engine.h"
+#include "gui_templates.h"
+#include "Knob.h"
+#include "PixmapButton.h"
+#include "SampleBuffer.h"
+#include "Song.h"
+#include "ToolTip.h"
+
+
+ConvolutionReverbControlDialog::ConvolutionReverbControlDialog(ConvolutionReverbControls* controls) :
+	EffectControlDialog(controls),
+	m_controls(controls)
+{
+	setAutoFillBackground(true);
+	QPalette pal;
+	pal.setBrush(backgroundRole(), PLUGIN_NAME::getIconPixmap("artwork"));
+	setPalette(pal);
+	setFixedSize(185, 55);
+
+	PixmapButton * openButton = new PixmapButton(this);
+	openButton->setCursor(QCursor(Qt::PointingHandCursor));
+	openButton->move(12, 18);
+	openButton->setActiveGraphic(PLUGIN_NAME::getIconPixmap("select_file"));
+	openButton->setInactiveGraphic(PLUGIN_NAME::getIconPixmap("select_file"));
+	connect(openButton, SIGNAL(clicked()), this, SLOT(openFile()));
+	ToolTip::add(openButton, tr("Open impulse response"));
+
+	m_fileLabel = new QLabel(this);
+	m_fileLabel->setFont(pointSize<8>(m_fileLabel->font()));
+	m_fileLabel->setGeometry(38, 18, 100, 18);
+
+	Knob * gainKnob = new Knob(knobBright_26, this);
+	gainKnob->move(145, 10);
+	gainKnob->setModel(&controls->m_gainModel);
+	gainKnob->setLabel(tr("Gain"));
+	gainKnob->setHintText(tr("Gain:"), "dB");
+
+	connect(controls, SIGNAL(fileChanged()), this, SLOT(updateFileName()));
+	updateFileName();
+}
+
+
+
+
+void ConvolutionReverbControlDialog::openFile()
+{
+	// start where the current response is, if there is one
+	const SampleBuffer * current = m_controls->m_effect->impulseResponse();
+	const QString file = current != nullptr
+		? current->openAudioFile()
+		: SampleBuffer().openAudioFile();
+	if (!file.isEmpty())
+	{
+		m_controls->setFile(file);
+		Engine::getSong()->setModified();
+	}
+}
+
+
+
+
+void ConvolutionReverbControlDialog::updateFileName()
+{
+	const QString name = m_controls->file().isEmpty()
+		? tr("No impulse response")
+		: QFileInfo(m_controls->file()).fileName();
+	m_fileLabel->setText(m_fileLabel->fontMetrics().elidedText(name, Qt::ElideMiddle, m_fileLabel->width()));
+	ToolTip::add(m_fileLabel, m_controls->file());
+}
@@ -1,7 +1,7 @@
 /*
- * DataprocLauncher.h - QThread::create workaround for older Qt version
+ * ConvolutionReverbControlDialog.h - control dialog of the convolution reverb
  *
- * Copyright (c) 2019 Martin Pavelek <he29/dot/HS/at/gmail/dot/com>
+ * Copyright (c) 2026 LMMS Developers
  *
  * This file is part of LMMS - https://lmms.io
  *
@@ -22,31 +22,32 @@
  *
  */
 
-#ifndef DATAPROCLAUNCHER_H
-#define DATAPROCLAUNCHER_H
+#ifndef CONVOLUTION_REVERB_CONTROL_DIALOG_H
+#define CONVOLUTION_REVERB_CONTROL_DIALOG_H
 
-#include <QThread>
+#include "EffectControlDialog.h"
 
-#include "SaProcessor.h"
-#include "LocklessRingBuffer.h"
 
-class DataprocLauncher : public QThread
+class QLabel;
+class ConvolutionReverbControls;
+
+
+class ConvolutionReverbControlDialog : public EffectControlDialog
 {
+	Q_OBJECT
 public:
-	explicit DataprocLauncher(SaProcessor &proc, LocklessRingBuffer<sampleFrame> &buffer)
-		: m_processor(&proc),
-		m_inputBuffer(&buffer)
+	ConvolutionReverbControlDialog(ConvolutionReverbControls* controls);
+	~ConvolutionReverbControlDialog() override
 	{
 	}
 
-private:
-	void run() override
-	{
-		m_processor->analyze(*m_inputBuffer);
-	}
+private slots:
+	void openFile();
+	void updateFileName();
 
-	SaProcessor *m_processor;
-	LocklessRingBuffer<sampleFrame> *m_inputBuffer;
-};
+private:
+	ConvolutionReverbControls* m_controls;
+	QLabel* m_fileLabel;
+} ;
 
-#endif // DATAPROCLAUNCHER_H
+#endif
@@ -0,0 +1,76 @@
+/*
+ * ConvolutionReverbControls.cpp - controls of the convolution reverb
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QDomElement>
+
+#include "ConvolutionReverbControls.h"
+#include "ConvolutionReverb.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "PathUtil.h"
+
+
+ConvolutionReverbControls::ConvolutionReverbControls(ConvolutionReverbEffect* effect) :
+	EffectControls(effect),
+	m_effect(effect),
+	m_gainModel(0.0f, -60.0f, 15.0f, 0.1f, this, tr("Gain"))
+{
+	connect(Engine::mixer(), SIGNAL(sampleRateChanged()), this, SLOT(changeSampleRate()));
+}
+
+
+
+
+void ConvolutionReverbControls::setFile(const QString & file)
+{
+	m_file = file;
+	m_effect->loadImpulseResponse(PathUtil::toAbsolute(file));
+	emit fileChanged();
+}
+
+
+
+
+void ConvolutionReverbControls::loadSettings(const QDomElement & _this)
+{
+	m_gainModel.loadSettings(_this, "gain");
+	setFile(_this.attribute("file"));
+}
+
+
+
+
+void ConvolutionReverbControls::saveSettings(QDomDocument & doc, QDomElement & _this)
+{
+	m_gainModel.saveSettings(doc, _this, "gain");
+	_this.setAttribute("file", PathUtil::toShortestRelative(m_file));
+}
+
+
+
+
+void ConvolutionReverbControls::changeSampleRate()
+{
+	m_effect->changeSampleRate();
+}
@@ -0,0 +1,83 @@
+/*
+ * ConvolutionReverbControls.h - controls of the convolution reverb
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CONVOLUTION_REVERB_CONTROLS_H
+#define CONVOLUTION_REVERB_CONTROLS_H
+
+#include "ConvolutionReverbControlDialog.h"
+#include "EffectControls.h"
+
+
+class ConvolutionReverbEffect;
+
+class ConvolutionReverbControls : public EffectControls
+{
+	Q_OBJECT
+public:
+	ConvolutionReverbControls(ConvolutionReverbEffect* effect);
+	~ConvolutionReverbControls() override
+	{
+	}
+
+	void saveSettings(QDomDocument & doc, QDomElement & parent) override;
+	void loadSettings(const QDomElement & _this) override;
+	inline QString nodeName() const override
+	{
+		return "ConvolutionReverbControls";
+	}
+
+	int controlCount() override
+	{
+		return 1;
+	}
+
+	EffectControlDialog* createView() override
+	{
+		return new ConvolutionReverbControlDialog(this);
+	}
+
+	const QString & file() const
+	{
+		return m_file;
+	}
+
+	//! Loads the impulse response in @p file
+	void setFile(const QString & file);
+
+signals:
+	void fileChanged();
+
+private slots:
+	void changeSampleRate();
+
+private:
+	ConvolutionReverbEffect* m_effect;
+	QString m_file;
+	FloatModel m_gainModel;
+
+	friend class ConvolutionReverbControlDialog;
+	friend class ConvolutionReverbEffect;
+} ;
+
+#endif
@@ -25,6 +25,10 @@
  */
  
 #include "CrossoverEQ.h"
+
+#include <algorithm>
+
+#include "FftAnalysis.h"
 #include "lmms_math.h"
 #include "embed.h"
 #include "plugin_export.h"
@@ -48,6 +52,9 @@ Plugin::Descriptor PLUGIN_EXPORT crossovereq_plugin_descriptor =
 }
 
 
+const fpp_t CrossoverEQEffect::LinearPhaseBlock;
+
+
 CrossoverEQEffect::CrossoverEQEffect( Model* parent, const Descriptor::SubPluginFeatures::Key* key ) :
 	Effect( &crossovereq_plugin_descriptor, parent, key ),
 	m_controls( this ),
@@ -58,11 +65,29 @@ CrossoverEQEffect::CrossoverEQEffect( Model* parent, const Descriptor::SubPlugin
 	m_hp2( m_sampleRate ),
 	m_hp3( m_sampleRate ),
 	m_hp4( m_sampleRate ),
-	m_needsUpdate( true )
+	m_needsUpdate( true ),
+	m_linearPhaseActive( false )
 {
-	m_tmp1 = MM_ALLOC( sampleFrame, Engine::mixer()->framesPerPeriod() );
-	m_tmp2 = MM_ALLOC( sampleFrame, Engine::mixer()->framesPerPeriod() );
-	m_work = MM_ALLOC( sampleFrame, Engine::mixer()->framesPerPeriod() );
+	m_tmp1 = MM_ALLOC( sampleFrame, Mixer::maxFramesPerPeriod() );
+	m_tmp2 = MM_ALLOC( sampleFrame, Mixer::maxFramesPerPeriod() );
+	m_work = MM_ALLOC( sampleFrame, Mixer::maxFramesPerPeriod() );
+
+	// everything the linear phase mode needs is set up front, so it can
+	// be switched on and redesigned on the audio thread
+	const int partitions = LinearPhaseLength / LinearPhaseBlock;
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		m_linearPhase[ch].initSpectrum( LinearPhaseBlock, partitions );
+	}
+	m_designPlan = FftAnalysis::inversePlan( LinearPhaseLength );
+	m_designBins = fftwf_alloc_complex( LinearPhaseLength / 2 + 1 );
+	m_designTaps = fftwf_alloc_real( LinearPhaseLength );
+	for( int b = 0; b < Bands; ++b )
+	{
+		m_bandSpectra[b] = fftwf_alloc_complex( partitions * ( LinearPhaseBlock + 1 ) );
+		m_mixedGains[b] = 0.0f;
+	}
+	m_mixedSpectrum = fftwf_alloc_complex( partitions * ( LinearPhaseBlock + 1 ) );
 }
 
 CrossoverEQEffect::~CrossoverEQEffect()
@@ -70,6 +95,20 @@ CrossoverEQEffect::~CrossoverEQEffect()
 	MM_FREE( m_tmp1 );
 	MM_FREE( m_tmp2 );
 	MM_FREE( m_work );
+
+	fftwf_free( m_designBins );
+	fftwf_free( m_designTaps );
+	for( int b = 0; b < Bands; ++b )
+	{
+		fftwf_free( m_bandSpectra[b] );
+	}
+	fftwf_free( m_mixedSpectrum );
+}
+
+f_cnt_t CrossoverEQEffect::latency() const
+{
+	// the taps are symmetric around the middle one
+	return m_controls.m_linearPhase.value() ? LinearPhaseLength / 2 : 0;
 }
 
 void CrossoverEQEffect::sampleRateChanged()
@@ -92,21 +131,34 @@ bool CrossoverEQEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames
 		return( false );
 	}
 	
+	// switching modes starts both from silence
+	const bool linearPhase = m_controls.m_linearPhase.value();
+	if( linearPhase != m_linearPhaseActive )
+	{
+		clearFilterHistories();
+		m_linearPhaseActive = linearPhase;
+		m_needsUpdate = true;
+	}
+
 	// filters update
+	bool xoverChanged = m_needsUpdate;
 	if( m_needsUpdate || m_controls.m_xover12.isValueChanged() )
 	{
 		m_lp1.setLowpass( m_controls.m_xover12.value() );
 		m_hp2.setHighpass( m_controls.m_xover12.value() );
+		xoverChanged = true;
 	}
 	if( m_needsUpdate || m_controls.m_xover23.isValueChanged() )
 	{
 		m_lp2.setLowpass( m_controls.m_xover23.value() );
 		m_hp3.setHighpass( m_controls.m_xover23.value() );
+		xoverChanged = true;
 	}
 	if( m_needsUpdate || m_controls.m_xover34.isValueChanged() )
 	{
 		m_lp3.setLowpass( m_controls.m_xover34.value() );
 		m_hp4.setHighpass( m_controls.m_xover34.value() );
+		xoverChanged = true;
 	}
 	
 	// gain values update
@@ -134,6 +186,21 @@ bool CrossoverEQEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames
 	const bool mute4 = m_controls.m_mute4.value();
 	
 	m_needsUpdate = false;
+
+	if( linearPhase )
+	{
+		if( xoverChanged )
+		{
+			designLinearPhase();
+		}
+		const float bandGains[Bands] = {
+			mute1 ? m_gain1 : 0.0f,
+			mute2 ? m_gain2 : 0.0f,
+			mute3 ? m_gain3 : 0.0f,
+			mute4 ? m_gain4 : 0.0f };
+		processLinearPhase( buf, frames, bandGains );
+		return isRunning();
+	}
 	
 	memset( m_work, 0, sizeof( sampleFrame ) * frames );
 	
@@ -209,6 +276,119 @@ void CrossoverEQEffect::clearFilterHistories()
 	m_hp2.clearHistory();
 	m_hp3.clearHistory();
 	m_hp4.clearHistory();
+	m_linearPhase[0].reset();
+	m_linearPhase[1].reset();
+}
+
+void CrossoverEQEffect::designLinearPhase()
+{
+	// The bands split the spectrum like the Linkwitz-Riley filters: the
+	// magnitudes of a 4th order lowpass and highpass add up to one, so do
+	// those of the bands. Each band gets a zero phase response with that
+	// magnitude, shifted by half the length and windowed.
+	const int n = LinearPhaseLength;
+	const float x12 = m_controls.m_xover12.value();
+	const float x23 = m_controls.m_xover23.value();
+	const float x34 = m_controls.m_xover34.value();
+
+	for( int b = 0; b < Bands; ++b )
+	{
+		for( int k = 0; k <= n / 2; ++k )
+		{
+			const float f = float( k ) * m_sampleRate / n;
+			const float l12 = 1.0f / ( 1.0f + powf( f / x12, 4 ) );
+			const float l23 = 1.0f / ( 1.0f + powf( f / x23, 4 ) );
+			const float l34 = 1.0f / ( 1.0f + powf( f / x34, 4 ) );
+			const float magnitude[Bands] = {
+				l23 * l12,
+				l23 * ( 1.0f - l12 ),
+				( 1.0f - l23 ) * l34,
+				( 1.0f - l23 ) * ( 1.0f - l34 ) };
+			m_designBins[k][0] = magnitude[b];
+			m_designBins[k][1] = 0.0f;
+		}
+		fftwf_execute_dft_c2r( m_designPlan, m_designBins, m_designTaps );
+
+		// rotate the symmetric response to the middle, in place
+		for( int i = 0; i < n / 2; ++i )
+		{
+			const float temp = m_designTaps[i];
+			m_designTaps[i] = m_designTaps[i + n / 2];
+			m_designTaps[i + n / 2] = temp;
+		}
+		// a Blackman window, symmetric around the middle tap as well
+		for( int i = 0; i < n; ++i )
+		{
+			const float w = 0.42f - 0.5f * cosf( F_2PI * i / n ) + 0.08f * cosf( 2 * F_2PI * i / n );
+			m_designTaps[i] *= w / n;
+		}
+
+		m_linearPhase[0].transform( m_designTaps, n, m_bandSpectra[b] );
+	}
+
+	// remix with the new band responses
+	for( int b = 0; b < Bands; ++b )
+	{
+		m_mixedGains[b] = -1.0f;
+	}
+}
+
+void CrossoverEQEffect::processLinearPhase( sampleFrame* buf, const fpp_t frames, const float* bandGains )
+{
+	const float d = dryLevel();
+	const float w = wetLevel();
+
+	// the band responses add up to a delta, so the dry signal is mixed in
+	// with the right delay by adding it to every band
+	bool changed = false;
+	float gains[Bands];
+	for( int b = 0; b < Bands; ++b )
+	{
+		gains[b] = d + w * bandGains[b];
+		changed = changed || gains[b] != m_mixedGains[b];
+	}
+
+	// gains are applied to the spectra, so the signal is transformed
+	// once and back once however many bands there are
+	if( changed )
+	{
+		const int bins = LinearPhaseLength / LinearPhaseBlock * ( LinearPhaseBlock + 1 );
+		float * mixed = reinterpret_cast<float *>( m_mixedSpectrum );
+		std::fill_n( mixed, 2 * bins, 0.0f );
+		for( int b = 0; b < Bands; ++b )
+		{
+			const float * band = reinterpret_cast<const float *>( m_bandSpectra[b] );
+			for( int i = 0; i < 2 * bins; ++i )
+			{
+				mixed[i] += gains[b] * band[i];
+			}
+			m_mixedGains[b] = gains[b];
+		}
+		m_linearPhase[0].setSpectrum( m_mixedSpectrum );
+		m_linearPhase[1].setSpectrum( m_mixedSpectrum );
+	}
+
+	float channel[LinearPhaseBlock];
+	double outSum = 0.0;
+	for( fpp_t offset = 0; offset < frames; offset += LinearPhaseBlock )
+	{
+		const fpp_t count = qMin<fpp_t>( frames - offset, LinearPhaseBlock );
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			for( fpp_t f = 0; f < count; ++f )
+			{
+				channel[f] = buf[offset + f][ch];
+			}
+			m_linearPhase[ch].process( channel, channel, count );
+			for( fpp_t f = 0; f < count; ++f )
+			{
+				buf[offset + f][ch] = channel[f];
+				outSum += channel[f] * channel[f];
+			}
+		}
+	}
+
+	checkGate( outSum / frames );
 }
 
 
@@ -32,6 +32,7 @@
 #include "ValueBuffer.h"
 #include "lmms_math.h"
 #include "BasicFilters.h"
+#include "FftConvolver.h"
 
 class CrossoverEQEffect : public Effect
 {
@@ -39,6 +40,7 @@ public:
 	CrossoverEQEffect( Model* parent, const Descriptor::SubPluginFeatures::Key* key );
 	virtual ~CrossoverEQEffect();
 	virtual bool processAudioBuffer( sampleFrame* buf, const fpp_t frames );
+	virtual f_cnt_t latency() const;
 
 	virtual EffectControls* controls()
 	{
@@ -48,9 +50,18 @@ public:
 	void clearFilterHistories();
 	
 private:
+	// taps of the linear phase filters, which delay the signal by half
+	// of them
+	static const int LinearPhaseLength = 2048;
+	// the filters are partitioned into blocks of this many frames
+	static const fpp_t LinearPhaseBlock = 256;
+	static const int Bands = 4;
+
 	CrossoverEQControls m_controls;
 
 	void sampleRateChanged();
+	void designLinearPhase();
+	void processLinearPhase( sampleFrame* buf, const fpp_t frames, const float* bandGains );
 
 	float m_sampleRate;
 	
@@ -72,7 +83,19 @@ private:
 	sampleFrame * m_work;
 	
 	bool m_needsUpdate;
-	
+
+	// linear phase mode, which filters one channel per convolver with
+	// the sum of the band responses, each weighted by its gain
+	FftConvolver m_linearPhase[DEFAULT_CHANNELS];
+	fftwf_plan m_designPlan;
+	fftwf_complex * m_designBins;
+	float * m_designTaps;
+	fftwf_complex * m_bandSpectra[Bands];
+	fftwf_complex * m_mixedSpectrum;
+	// the weight of each band in m_mixedSpectrum, dry and wet included
+	float m_mixedGains[Bands];
+	bool m_linearPhaseActive;
+
 	friend class CrossoverEQControls;
 };
 
@@ -112,4 +112,9 @@ CrossoverEQControlDialog::CrossoverEQControlDialog( CrossoverEQControls * contro
 	mute4->move( 135, 154 );
 	mute4->setModel( & controls->m_mute4 );
 	ToolTip::add( mute4, tr( "Mute band 4" ) );
+
+	LedCheckBox * linearPhase = new LedCheckBox( "", this, tr( "Linear phase" ), LedCheckBox::Yellow );
+	linearPhase->move( 145, 18 );
+	linearPhase->setModel( & controls->m_linearPhase );
+	ToolTip::add( linearPhase, tr( "Linear phase crossover, delays the signal by about 20 ms" ) );
 }
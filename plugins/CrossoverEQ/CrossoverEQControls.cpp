@@ -40,7 +40,8 @@ CrossoverEQControls::CrossoverEQControls( CrossoverEQEffect * eff ) :
 	m_mute1( true, this, "Mute Band 1" ),
 	m_mute2( true, this, "Mute Band 2" ),
 	m_mute3( true, this, "Mute Band 3" ),
-	m_mute4( true, this, "Mute Band 4" )
+	m_mute4( true, this, "Mute Band 4" ),
+	m_linearPhase( false, this, "Linear Phase" )
 {
 	connect( Engine::mixer(), SIGNAL( sampleRateChanged() ), this, SLOT( sampleRateChanged() ) );
 	connect( &m_xover12, SIGNAL( dataChanged() ), this, SLOT( xover12Changed() ) );
@@ -67,6 +68,8 @@ void CrossoverEQControls::saveSettings( QDomDocument & doc, QDomElement & elem )
 	m_mute2.saveSettings( doc, elem, "mute2" );
 	m_mute3.saveSettings( doc, elem, "mute3" );
 	m_mute4.saveSettings( doc, elem, "mute4" );
+
+	m_linearPhase.saveSettings( doc, elem, "linearphase" );
 }
 
 void CrossoverEQControls::loadSettings( const QDomElement & elem )
@@ -84,6 +87,8 @@ void CrossoverEQControls::loadSettings( const QDomElement & elem )
 	m_mute2.loadSettings( elem, "mute2" );
 	m_mute3.loadSettings( elem, "mute3" );
 	m_mute4.loadSettings( elem, "mute4" );
+
+	m_linearPhase.loadSettings( elem, "linearphase" );
 	
 	m_effect->m_needsUpdate = true;
 	m_effect->clearFilterHistories();
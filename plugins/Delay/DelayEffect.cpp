@@ -26,6 +26,7 @@
 #include "Engine.h"
 #include "embed.h"
 #include "interpolation.h"
+#include "MemoryManager.h"
 #include "plugin_export.h"
 
 extern "C"
@@ -51,10 +52,10 @@ DelayEffect::DelayEffect( Model* parent, const Plugin::Descriptor::SubPluginFeat
 	Effect( &delay_plugin_descriptor, parent, key ),
 	m_delayControls( this )
 {
-	m_delay = 0;
-	m_delay = new StereoDelay( 20, Engine::mixer()->processingSampleRate() );
 	m_lfo = new Lfo( Engine::mixer()->processingSampleRate() );
 	m_outGain = 1.0;
+	m_delays = MM_ALLOC( float, Mixer::maxFramesPerPeriod() );
+	m_wet = MM_ALLOC( sampleFrame, Mixer::maxFramesPerPeriod() );
 }
 
 
@@ -62,14 +63,12 @@ DelayEffect::DelayEffect( Model* parent, const Plugin::Descriptor::SubPluginFeat
 
 DelayEffect::~DelayEffect()
 {
-	if( m_delay )
-	{
-		delete m_delay;
-	}
 	if( m_lfo )
 	{
 		delete m_lfo;
 	}
+	MM_FREE( m_delays );
+	MM_FREE( m_wet );
 }
 
 
@@ -79,18 +78,20 @@ bool DelayEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames )
 {
 	if( !isEnabled() || !isRunning () )
 	{
+		m_delay.sleep();
 		return( false );
 	}
+	m_delay.wake();
+
 	double outSum = 0.0;
 	const float sr = Engine::mixer()->processingSampleRate();
 	const float d = dryLevel();
 	const float w = wetLevel();
-	sample_t dryS[2];
 	float lPeak = 0.0;
 	float rPeak = 0.0;
 	float length = m_delayControls.m_delayTimeModel.value();
-	float amplitude = m_delayControls.m_lfoAmountModel.value() * sr;
-	float lfoTime = 1.0 / m_delayControls.m_lfoTimeModel.value();
+	float amplitude = m_delayControls.m_lfoAmountModel.value();
+	float lfoTime = m_delayControls.m_lfoTimeModel.value();
 	float feedback =  m_delayControls.m_feedbackModel.value();
 	ValueBuffer *lengthBuffer = m_delayControls.m_delayTimeModel.valueBuffer();
 	ValueBuffer *feedbackBuffer = m_delayControls.m_feedbackModel.valueBuffer();
@@ -109,45 +110,101 @@ bool DelayEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames )
 	{
 		m_outGain = dbfsToAmp( m_delayControls.m_outGainModel.value() );
 	}
-	int sampleLength;
+
+	// the delays of the whole period first, so the line only has to be as
+	// long as the longest of them
+	float longest = 0.0f;
 	for( fpp_t f = 0; f < frames; ++f )
 	{
-		dryS[0] = buf[f][0];
-		dryS[1] = buf[f][1];
+		m_lfo->setFrequency( 1.0 / *lfoTimePtr );
+		m_delays[f] = ( *lengthPtr + *amplitudePtr * ( float )m_lfo->tick() ) * sr;
+		longest = qMax( longest, m_delays[f] );
 
-		m_delay->setFeedback( *feedbackPtr );
-		m_lfo->setFrequency( *lfoTimePtr );
-		sampleLength = *lengthPtr * Engine::mixer()->processingSampleRate();
-		m_currentLength = sampleLength;
-		m_delay->setLength( m_currentLength + ( *amplitudePtr * ( float )m_lfo->tick() ) );
-		m_delay->tick( buf[f] );
-
-		buf[f][0] *= m_outGain;
-		buf[f][1] *= m_outGain;
+		lengthPtr += lengthInc;
+		amplitudePtr += amplitudeInc;
+		lfoTimePtr += lfoTimeInc;
+	}
+	m_delay.reserve( longest );
 
-		lPeak = buf[f][0] > lPeak ? buf[f][0] : lPeak;
-		rPeak = buf[f][1] > rPeak ? buf[f][1] : rPeak;
+	// unless the feedback of this period is heard in this period already,
+	// all of it is read at once
+	bool wholePeriod = true;
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		wholePeriod &= m_delays[f] >= f + 1;
+	}
 
-		buf[f][0] = ( d * dryS[0] ) + ( w * buf[f][0] );
-		buf[f][1] = ( d * dryS[1] ) + ( w * buf[f][1] );
+	if( wholePeriod )
+	{
+		m_delay.readBlock( m_delays, m_delays, m_wet, frames );
+	}
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		sampleFrame wet;
+		if( wholePeriod )
+		{
+			wet = m_wet[f];
+		}
+		else
+		{
+			m_delay.read( m_delays[f], wet );
+		}
+
+		sampleFrame in;
+		in[0] = buf[f][0] + wet[0] * *feedbackPtr;
+		in[1] = buf[f][1] + wet[1] * *feedbackPtr;
+		if( wholePeriod )
+		{
+			m_wet[f] = in;
+		}
+		else
+		{
+			m_delay.write( in );
+		}
+
+		wet[0] *= m_outGain;
+		wet[1] *= m_outGain;
+
+		lPeak = wet[0] > lPeak ? wet[0] : lPeak;
+		rPeak = wet[1] > rPeak ? wet[1] : rPeak;
+
+		buf[f][0] = ( d * buf[f][0] ) + ( w * wet[0] );
+		buf[f][1] = ( d * buf[f][1] ) + ( w * wet[1] );
 		outSum += buf[f][0]*buf[f][0] + buf[f][1]*buf[f][1];
 
-		lengthPtr += lengthInc;
-		amplitudePtr += amplitudeInc;
-		lfoTimePtr += lfoTimeInc;
 		feedbackPtr += feedbackInc;
 	}
+	if( wholePeriod )
+	{
+		m_delay.writeBlock( m_wet, frames );
+	}
+
 	checkGate( outSum / frames );
 	m_delayControls.m_outPeakL = lPeak;
 	m_delayControls.m_outPeakR = rPeak;
 
+	if( !isRunning() )
+	{
+		m_delay.sleep();
+	}
 	return isRunning();
 }
 
+f_cnt_t DelayEffect::tailLength() const
+{
+	const float longest = m_delayControls.m_delayTimeModel.value() +
+				m_delayControls.m_lfoAmountModel.value();
+	return feedbackTail( longest * Engine::mixer()->processingSampleRate(),
+				m_delayControls.m_feedbackModel.value() );
+}
+
+
+
+
 void DelayEffect::changeSampleRate()
 {
 	m_lfo->setSampleRate( Engine::mixer()->processingSampleRate() );
-	m_delay->setSampleRate( Engine::mixer()->processingSampleRate() );
+	m_delay.clear();
 }
 
 
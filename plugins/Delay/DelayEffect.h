@@ -27,8 +27,8 @@
 
 #include "Effect.h"
 #include "DelayControls.h"
+#include "DelayLine.h"
 #include "Lfo.h"
-#include "StereoDelay.h"
 #include "ValueBuffer.h"
 
 class DelayEffect : public Effect
@@ -37,6 +37,11 @@ public:
 	DelayEffect(Model* parent , const Descriptor::SubPluginFeatures::Key* key );
 	virtual ~DelayEffect();
 	virtual bool processAudioBuffer( sampleFrame* buf, const fpp_t frames );
+	f_cnt_t tailLength() const override;
+	qint64 memoryUsage() const override
+	{
+		return m_delay.capacity() * BYTES_PER_FRAME;
+	}
 	virtual EffectControls* controls()
 	{
 		return &m_delayControls;
@@ -45,10 +50,12 @@ public:
 
 private:
 	DelayControls m_delayControls;
-	StereoDelay* m_delay;
+	DelayLine m_delay;
 	Lfo* m_lfo;
 	float m_outGain;
-	float m_currentLength;
+	// delay of each frame of the period, in frames
+	float* m_delays;
+	sampleFrame* m_wet;
 };
 
 #endif // DELAYEFFECT_H
@@ -0,0 +1,222 @@
+/*
+ * EqCascade.h - runs the bands of the Eq as one cascade of biquads
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef EQCASCADE_H
+#define EQCASCADE_H
+
+#include "EqFilter.h"
+#include "lmms_basics.h"
+
+
+///
+/// \brief The EqCascade class
+/// Processes up to MaxSections biquads in series, in transposed direct form II
+/// with both channels side by side. Instead of running every band twice and
+/// crossfading like EqFilter::update(), the coefficients of each section glide
+/// to their new values once every SubBlock frames.
+/// Sections that are off or flat cost nothing: a flat section glides to unity
+/// and is skipped from then on, a section that is turned off is dropped
+/// together with its state.
+///
+class EqCascade
+{
+public:
+	static const int MaxSections = 14;
+	static const fpp_t SubBlock = 16;
+
+	EqCascade()
+	{
+		for( int s = 0; s < MaxSections; ++s )
+		{
+			m_section[s].active = false;
+			setUnity( m_section[s].current );
+			setUnity( m_section[s].target );
+			clearState( m_section[s] );
+		}
+	}
+
+	/// Sets the target response of section s for the next period.
+	/// \param filter the band to take the coefficients from
+	/// \param active whether the band is switched on
+	void setSection( int s, const EqFilter & filter, bool active )
+	{
+		Section & sec = m_section[s];
+		if( !active )
+		{
+			sec.active = false;
+			return;
+		}
+		if( !sec.active )
+		{
+			// start from unity so a band fades in instead of clicking
+			sec.active = true;
+			setUnity( sec.current );
+			clearState( sec );
+		}
+		if( filter.isFlat() )
+		{
+			setUnity( sec.target );
+		}
+		else
+		{
+			for( int c = 0; c < 5; ++c )
+			{
+				sec.target[c] = filter.coeffs()[c];
+			}
+		}
+	}
+
+	/// Filters buf and mixes the result with the input by dry and wet
+	void process( sampleFrame * buf, const fpp_t frames, float dry, float wet )
+	{
+		int order[MaxSections];
+		float step[MaxSections][5];
+		int count = 0;
+		const int subBlocks = ( frames + SubBlock - 1 ) / SubBlock;
+
+		for( int s = 0; s < MaxSections; ++s )
+		{
+			Section & sec = m_section[s];
+			if( !sec.active )
+			{
+				continue;
+			}
+			if( isUnity( sec.current ) && isUnity( sec.target ) )
+			{
+				clearState( sec );
+				continue;
+			}
+			for( int c = 0; c < 5; ++c )
+			{
+				step[count][c] = ( sec.target[c] - sec.current[c] ) / subBlocks;
+			}
+			order[count++] = s;
+		}
+
+		for( fpp_t offset = 0; offset < frames; offset += SubBlock )
+		{
+			const fpp_t n = qMin<fpp_t>( frames - offset, SubBlock );
+			sampleFrame * block = buf + offset;
+			sampleFrame drySignal[SubBlock];
+
+			for( fpp_t f = 0; f < n; ++f )
+			{
+				drySignal[f][0] = block[f][0];
+				drySignal[f][1] = block[f][1];
+			}
+
+			for( int i = 0; i < count; ++i )
+			{
+				Section & sec = m_section[order[i]];
+				for( int c = 0; c < 5; ++c )
+				{
+					sec.current[c] += step[i][c];
+				}
+				processSection( sec, block, n );
+			}
+
+			for( fpp_t f = 0; f < n; ++f )
+			{
+				block[f][0] = dry * drySignal[f][0] + wet * block[f][0];
+				block[f][1] = dry * drySignal[f][1] + wet * block[f][1];
+			}
+		}
+
+		// land exactly on the target, rounding may have left it off by a bit
+		for( int i = 0; i < count; ++i )
+		{
+			Section & sec = m_section[order[i]];
+			for( int c = 0; c < 5; ++c )
+			{
+				sec.current[c] = sec.target[c];
+			}
+		}
+	}
+
+private:
+	enum Coefficients { A1, A2, B0, B1, B2 };
+
+	struct Section
+	{
+		bool active;
+		float current[5];
+		float target[5];
+		float z1[DEFAULT_CHANNELS];
+		float z2[DEFAULT_CHANNELS];
+	};
+
+	static void processSection( Section & sec, sampleFrame * buf, const fpp_t frames )
+	{
+		const float a1 = sec.current[A1];
+		const float a2 = sec.current[A2];
+		const float b0 = sec.current[B0];
+		const float b1 = sec.current[B1];
+		const float b2 = sec.current[B2];
+		float z1[DEFAULT_CHANNELS] = { sec.z1[0], sec.z1[1] };
+		float z2[DEFAULT_CHANNELS] = { sec.z2[0], sec.z2[1] };
+
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				const float in = buf[f][ch];
+				const float out = z1[ch] + b0 * in;
+				z1[ch] = b1 * in + z2[ch] - a1 * out;
+				z2[ch] = b2 * in - a2 * out;
+				buf[f][ch] = out;
+			}
+		}
+
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			sec.z1[ch] = z1[ch];
+			sec.z2[ch] = z2[ch];
+		}
+	}
+
+	static void setUnity( float * c )
+	{
+		c[A1] = 0.0f; c[A2] = 0.0f;
+		c[B0] = 1.0f; c[B1] = 0.0f; c[B2] = 0.0f;
+	}
+
+	static bool isUnity( const float * c )
+	{
+		return c[A1] == 0.0f && c[A2] == 0.0f &&
+			c[B0] == 1.0f && c[B1] == 0.0f && c[B2] == 0.0f;
+	}
+
+	static void clearState( Section & sec )
+	{
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			sec.z1[ch] = 0.0f;
+			sec.z2[ch] = 0.0f;
+		}
+	}
+
+	Section m_section[MaxSections];
+};
+
+#endif // EQCASCADE_H
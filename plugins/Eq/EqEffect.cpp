@@ -51,6 +51,9 @@ Plugin::Descriptor PLUGIN_EXPORT eq_plugin_descriptor =
 }
 
 
+const fpp_t EqCascade::SubBlock;
+
+
 EqEffect::EqEffect( Model *parent, const Plugin::Descriptor::SubPluginFeatures::Key *key) :
 	Effect( &eq_plugin_descriptor, parent, key ),
 	m_eqControls( this ),
@@ -76,7 +79,6 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	//wet/dry controls
 	const float dry = dryLevel();
 	const float wet = wetLevel();
-	sample_t dryS[2];
 	// setup sample exact controls
 	float hpRes = m_eqControls.m_hpResModel.value();
 	float lowShelfRes = m_eqControls.m_lowShelfResModel.value();
@@ -117,8 +119,8 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	float para4Gain = m_eqControls.m_para4GainModel.value();
 	float highShelfGain = m_eqControls.m_highShelfGainModel.value();
 
-	//set all filter parameters once per frame, EqFilter handles
-	//smooth xfading, reducing pops clicks and dc bias offsets
+	//set all filter parameters once per frame, EqCascade glides
+	//to the new coefficients, reducing pops clicks and dc bias offsets
 
 	m_hp12.setParameters( sampleRate, hpFreq, hpRes, 1 );
 	m_hp24.setParameters( sampleRate, hpFreq, hpRes, 1 );
@@ -166,7 +168,7 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 
 	if(m_eqControls.m_analyseInModel.value( true ) &&  outSum > 0 && m_eqControls.isViewVisible()  )
 	{
-		m_eqControls.m_inFftBands.analyze( buf, frames );
+		m_eqControls.m_inFftBands.write( buf, frames );
 	}
 	else
 	{
@@ -177,96 +179,26 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	m_eqControls.m_inPeakL = m_eqControls.m_inPeakL < m_inPeak[0] ? m_inPeak[0] : m_eqControls.m_inPeakL;
 	m_eqControls.m_inPeakR = m_eqControls.m_inPeakR < m_inPeak[1] ? m_inPeak[1] : m_eqControls.m_inPeakR;
 
-	float periodProgress = 0.0f; // percentage of period processed
-	for( fpp_t f = 0; f < frames; ++f)
-	{
-		periodProgress = (float)f / (float)(frames-1);
-		//wet dry buffer
-		dryS[0] = buf[f][0];
-		dryS[1] = buf[f][1];
-		if( hpActive )
-		{
-			buf[f][0] = m_hp12.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_hp12.update( buf[f][1], 1, periodProgress );
-
-			if( hp24Active || hp48Active )
-			{
-				buf[f][0] = m_hp24.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp24.update( buf[f][1], 1, periodProgress );
-			}
-
-			if( hp48Active )
-			{
-				buf[f][0] = m_hp480.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp480.update( buf[f][1], 1, periodProgress );
-
-				buf[f][0] = m_hp481.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp481.update( buf[f][1], 1, periodProgress );
-			}
-		}
-
-		if( lowShelfActive )
-		{
-			buf[f][0] = m_lowShelf.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_lowShelf.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para1Active )
-		{
-			buf[f][0] = m_para1.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para1.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para2Active )
-		{
-			buf[f][0] = m_para2.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para2.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para3Active )
-		{
-			buf[f][0] = m_para3.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para3.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para4Active )
-		{
-			buf[f][0] = m_para4.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para4.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( highShelfActive )
-		{
-			buf[f][0] = m_highShelf.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_highShelf.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( lpActive ){
-			buf[f][0] = m_lp12.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_lp12.update( buf[f][1], 1, periodProgress );
-
-			if( lp24Active || lp48Active )
-			{
-				buf[f][0] = m_lp24.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp24.update( buf[f][1], 1, periodProgress );
-			}
-
-			if( lp48Active )
-			{
-				buf[f][0] = m_lp480.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp480.update( buf[f][1], 1, periodProgress );
-
-				buf[f][0] = m_lp481.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp481.update( buf[f][1], 1, periodProgress );
-			}
-		}
-
-		//apply wet / dry levels
-		buf[f][1] = ( dry * dryS[1] ) + ( wet * buf[f][1] );
-		buf[f][0] = ( dry * dryS[0] ) + ( wet * buf[f][0] );
-
-
-	}
+	// the sections in signal order, the HP and LP stages are cascaded
+	// copies of the same filter
+	const bool hp24 = hpActive && ( hp24Active || hp48Active );
+	const bool lp24 = lpActive && ( lp24Active || lp48Active );
+	m_cascade.setSection( 0, m_hp12, hpActive );
+	m_cascade.setSection( 1, m_hp24, hp24 );
+	m_cascade.setSection( 2, m_hp480, hpActive && hp48Active );
+	m_cascade.setSection( 3, m_hp481, hpActive && hp48Active );
+	m_cascade.setSection( 4, m_lowShelf, lowShelfActive );
+	m_cascade.setSection( 5, m_para1, para1Active );
+	m_cascade.setSection( 6, m_para2, para2Active );
+	m_cascade.setSection( 7, m_para3, para3Active );
+	m_cascade.setSection( 8, m_para4, para4Active );
+	m_cascade.setSection( 9, m_highShelf, highShelfActive );
+	m_cascade.setSection( 10, m_lp12, lpActive );
+	m_cascade.setSection( 11, m_lp24, lp24 );
+	m_cascade.setSection( 12, m_lp480, lpActive && lp48Active );
+	m_cascade.setSection( 13, m_lp481, lpActive && lp48Active );
+
+	m_cascade.process( buf, frames, dry, wet );
 
 	sampleFrame outPeak = { 0, 0 };
 	gain( buf, frames, outGain, &outPeak );
@@ -277,7 +209,7 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 
 	if(m_eqControls.m_analyseOutModel.value( true ) && outSum > 0 && m_eqControls.isViewVisible() )
 	{
-		m_eqControls.m_outFftBands.analyze( buf, frames );
+		m_eqControls.m_outFftBands.write( buf, frames );
 		setBandPeaks( &m_eqControls.m_outFftBands , ( int )( sampleRate ) );
 	}
 	else
@@ -26,6 +26,7 @@
 
 #include "BasicFilters.h"
 #include "Effect.h"
+#include "EqCascade.h"
 #include "EqControls.h"
 #include "EqFilter.h"
 #include "lmms_math.h"
@@ -84,6 +85,8 @@ private:
 	EqLp12Filter m_lp480;
 	EqLp12Filter m_lp481;
 
+	EqCascade m_cascade;
+
 	float m_inGain;
 	float m_outGain;
 
@@ -45,6 +45,7 @@ public:
 		m_gain(0),
 		m_bw(0)
 	{
+		setCoeffs( 0, 0, 1, 0, 0 );
 
 	}
 
@@ -138,6 +139,30 @@ public:
 	}
 
 
+
+
+	///
+	/// \brief coeffs
+	/// \return the current coefficients a1, a2, b0, b1, b2
+	///
+	inline const float * coeffs() const
+	{
+		return m_coeffs;
+	}
+
+
+
+
+	///
+	/// \brief isFlat
+	/// \return whether the filter leaves the signal unchanged, so it can be skipped
+	///
+	virtual bool isFlat() const
+	{
+		return false;
+	}
+
+
 protected:
 	///
 	/// \brief calcCoefficents
@@ -151,6 +176,11 @@ protected:
 	inline void setCoeffs( float a1, float a2, float b0, float b1, float b2 )
 	{
 		m_biQuadFrameTarget.setCoeffs( a1, a2, b0, b1, b2 );
+		m_coeffs[0] = a1;
+		m_coeffs[1] = a2;
+		m_coeffs[2] = b0;
+		m_coeffs[3] = b1;
+		m_coeffs[4] = b2;
 	}
 
 
@@ -163,6 +193,7 @@ protected:
 	float m_res;
 	float m_gain;
 	float m_bw;
+	float m_coeffs[5];
 	StereoBiQuad m_biQuadFrameInitial;
 	StereoBiQuad m_biQuadFrameTarget;
 };
@@ -265,6 +296,12 @@ class EqPeakFilter : public EqFilter
 {
 public:
 
+	virtual bool isFlat() const
+	{
+		// a peak or shelf at 0 dB is unity
+		return m_gain == 0;
+	}
+
 
 	virtual void calcCoefficents()
 	{
@@ -330,6 +367,12 @@ public:
 class EqLowShelfFilter : public EqFilter
 {
 public :
+
+	virtual bool isFlat() const
+	{
+		// a peak or shelf at 0 dB is unity
+		return m_gain == 0;
+	}
 	virtual void calcCoefficents()
 	{
 
@@ -369,6 +412,12 @@ public :
 class EqHighShelfFilter : public EqFilter
 {
 public :
+
+	virtual bool isFlat() const
+	{
+		// a peak or shelf at 0 dB is unity
+		return m_gain == 0;
+	}
 	virtual void calcCoefficents()
 	{
 
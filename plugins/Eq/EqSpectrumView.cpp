@@ -29,29 +29,25 @@
 #include "Mixer.h"
 
 EqAnalyser::EqAnalyser() :
+	m_input( FFT_BUFFER_SIZE * 2 ),
+	m_inputReader( m_input ),
 	m_framesFilledUp ( 0 ),
 	m_energy ( 0 ),
 	m_sampleRate ( 1 ),
-	m_active ( true )
+	m_active ( true ),
+	m_clear ( false )
 {
 	m_inProgress=false;
 	m_specBuf = ( fftwf_complex * ) fftwf_malloc( ( FFT_BUFFER_SIZE + 1 ) * sizeof( fftwf_complex ) );
-	m_fftPlan = fftwf_plan_dft_r2c_1d( FFT_BUFFER_SIZE*2, m_buffer, m_specBuf, FFTW_MEASURE );
+	// the upper half is never filled, it zero pads the block
+	m_buffer = fftwf_alloc_real( FFT_BUFFER_SIZE * 2 );
+	memset( m_buffer, 0, FFT_BUFFER_SIZE * 2 * sizeof( float ) );
 
-	//initialize Blackman-Harris window, constants taken from
-	//https://en.wikipedia.org/wiki/Window_function#A_list_of_window_functions
-	const float a0 = 0.35875;
-	const float a1 = 0.48829;
-	const float a2 = 0.14128;
-	const float a3 = 0.01168;
-
-	for (int i = 0; i < FFT_BUFFER_SIZE; i++)
-	{
-		m_fftWindow[i] = (a0 - a1 * cos(2 * F_PI * i / ((float)FFT_BUFFER_SIZE - 1.0))
-								+ a2 * cos(4 * F_PI * i / ((float)FFT_BUFFER_SIZE - 1.0))
-								- a3 * cos(6 * F_PI * i / ((float)FFT_BUFFER_SIZE - 1.0)));
-	}
+	//Blackman-Harris window, without amplitude correction
+	m_fftWindow = FftAnalysis::window( BLACKMAN_HARRIS, FFT_BUFFER_SIZE, false );
 	clear();
+
+	FftAnalysis::addClient( this );
 }
 
 
@@ -59,38 +55,56 @@ EqAnalyser::EqAnalyser() :
 
 EqAnalyser::~EqAnalyser()
 {
-	fftwf_destroy_plan( m_fftPlan );
+	FftAnalysis::removeClient( this );
 	fftwf_free( m_specBuf );
+	fftwf_free( m_buffer );
 }
 
 
 
 
-void EqAnalyser::analyze( sampleFrame *buf, const fpp_t frames )
+void EqAnalyser::write( sampleFrame *buf, const fpp_t frames )
 {
 	//only analyse if the view is visible
 	if ( m_active )
 	{
-		m_inProgress=true;
-		const int FFT_BUFFER_SIZE = 2048;
-		fpp_t f = 0;
-		if( frames > FFT_BUFFER_SIZE )
+		m_input.write( buf, frames );
+		notify();
+	}
+}
+
+
+
+
+void EqAnalyser::analyze()
+{
+	m_inProgress = true;
+	if( m_clear )
+	{
+		m_framesFilledUp = 0;
+		m_clear = false;
+	}
+
+	while( !m_inputReader.empty() )
+	{
+		auto in = m_inputReader.read_max( FFT_BUFFER_SIZE - m_framesFilledUp );
+		if( !m_active )
 		{
-			m_framesFilledUp = 0;
-			f = frames - FFT_BUFFER_SIZE;
+			// the view has what it asked for, drop the rest
+			continue;
 		}
+
 		// meger channels
-		for( ; f < frames; ++f )
+		for( std::size_t f = 0; f < in.size(); ++f )
 		{
 			m_buffer[m_framesFilledUp] =
-					( buf[f][0] + buf[f][1] ) * 0.5;
+					( in[f][0] + in[f][1] ) * 0.5;
 			++m_framesFilledUp;
 		}
 
-		if( m_framesFilledUp < FFT_BUFFER_SIZE )
+		if( m_framesFilledUp < (int)FFT_BUFFER_SIZE )
 		{
-			m_inProgress = false;
-			return;
+			continue;
 		}
 
 		m_sampleRate = Engine::mixer()->processingSampleRate();
@@ -98,12 +112,12 @@ void EqAnalyser::analyze( sampleFrame *buf, const fpp_t frames )
 		const int HIGHEST_FREQ = m_sampleRate / 2;
 
 		//apply FFT window
-		for( int i = 0; i < FFT_BUFFER_SIZE; i++ )
+		for( unsigned int i = 0; i < FFT_BUFFER_SIZE; i++ )
 		{
 			m_buffer[i] = m_buffer[i] * m_fftWindow[i];
 		}
 
-		fftwf_execute( m_fftPlan );
+		FftAnalysis::execute( FFT_BUFFER_SIZE * 2, m_buffer, m_specBuf );
 		absspec( m_specBuf, m_absSpecBuf, FFT_BUFFER_SIZE+1 );
 
 		compressbands( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1,
@@ -113,9 +127,9 @@ void EqAnalyser::analyze( sampleFrame *buf, const fpp_t frames )
 		m_energy = maximum( m_bands, MAX_BANDS ) / maximum( m_buffer, FFT_BUFFER_SIZE );
 
 		m_framesFilledUp = 0;
-		m_inProgress = false;
 		m_active = false;
 	}
+	m_inProgress = false;
 }
 
 
@@ -163,9 +177,13 @@ bool EqAnalyser::getInProgress()
 
 void EqAnalyser::clear()
 {
-	m_framesFilledUp = 0;
+	// called every period while there's nothing to analyse
+	if( m_clear )
+	{
+		return;
+	}
+	m_clear = true;
 	m_energy = 0;
-	memset( m_buffer, 0, sizeof( m_buffer ) );
 	memset( m_bands, 0, sizeof( m_bands ) );
 }
 
@@ -27,13 +27,20 @@
 #include <QPainterPath>
 #include <QWidget>
 
+#include "FftAnalysis.h"
 #include "fft_helpers.h"
 #include "lmms_basics.h"
+#include "LocklessRingBuffer.h"
 #include "lmms_math.h"
 
 
 const int MAX_BANDS = 2048;
-class EqAnalyser
+///
+/// \brief The EqAnalyser class
+/// The audio thread only queues frames with write(), the FFT runs on an
+/// FftAnalysis thread, which also provides the plan and the window.
+///
+class EqAnalyser : public FftAnalysis::Client
 {
 public:
 	EqAnalyser();
@@ -43,7 +50,7 @@ public:
 	bool getInProgress();
 	void clear();
 
-	void analyze( sampleFrame *buf, const fpp_t frames );
+	void write( sampleFrame *buf, const fpp_t frames );
 
 	float getEnergy() const;
 	int getSampleRate() const;
@@ -51,17 +58,22 @@ public:
 
 	void setActive(bool active);
 
+protected:
+	void analyze() override;
+
 private:
-	fftwf_plan m_fftPlan;
+	LocklessRingBuffer<sampleFrame> m_input;
+	LocklessRingBufferReader<sampleFrame> m_inputReader;
 	fftwf_complex * m_specBuf;
 	float m_absSpecBuf[FFT_BUFFER_SIZE+1];
-	float m_buffer[FFT_BUFFER_SIZE*2];
+	float * m_buffer;
 	int m_framesFilledUp;
 	float m_energy;
 	int m_sampleRate;
 	bool m_active;
 	bool m_inProgress;
-	float m_fftWindow[FFT_BUFFER_SIZE];
+	bool m_clear;
+	const float * m_fftWindow;
 };
 
 
@@ -52,9 +52,10 @@ FlangerEffect::FlangerEffect( Model *parent, const Plugin::Descriptor::SubPlugin
 	m_flangerControls( this )
 {
 	m_lfo = new QuadratureLfo( Engine::mixer()->processingSampleRate() );
-	m_lDelay = new MonoDelay( 1, Engine::mixer()->processingSampleRate() );
-	m_rDelay = new MonoDelay( 1, Engine::mixer()->processingSampleRate() );
 	m_noise = new Noise;
+	m_leftDelays = MM_ALLOC( float, Mixer::maxFramesPerPeriod() );
+	m_rightDelays = MM_ALLOC( float, Mixer::maxFramesPerPeriod() );
+	m_wet = MM_ALLOC( sampleFrame, Mixer::maxFramesPerPeriod() );
 }
 
 
@@ -62,14 +63,6 @@ FlangerEffect::FlangerEffect( Model *parent, const Plugin::Descriptor::SubPlugin
 
 FlangerEffect::~FlangerEffect()
 {
-	if(m_lDelay )
-	{
-		delete m_lDelay;
-	}
-	if( m_rDelay )
-	{
-		delete m_rDelay;
-	}
 	if( m_lfo )
 	{
 		delete m_lfo;
@@ -78,6 +71,9 @@ FlangerEffect::~FlangerEffect()
 	{
 		delete m_noise;
 	}
+	MM_FREE( m_leftDelays );
+	MM_FREE( m_rightDelays );
+	MM_FREE( m_wet );
 }
 
 
@@ -87,8 +83,11 @@ bool FlangerEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 {
 	if( !isEnabled() || !isRunning () )
 	{
+		m_delay.sleep();
 		return( false );
 	}
+	m_delay.wake();
+
 	double outSum = 0.0;
 	const float d = dryLevel();
 	const float w = wetLevel();
@@ -96,48 +95,108 @@ bool FlangerEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	const float noise = m_flangerControls.m_whiteNoiseAmountModel.value();
 	float amplitude = m_flangerControls.m_lfoAmountModel.value() * Engine::mixer()->processingSampleRate();
 	bool invertFeedback = m_flangerControls.m_invertFeedbackModel.value();
+	const float feedback = m_flangerControls.m_feedbackModel.value();
 	m_lfo->setFrequency(  1.0/m_flangerControls.m_lfoFrequencyModel.value() );
 	m_lfo->setOffset( m_flangerControls.m_lfoPhaseModel.value() / 180 * D_PI );
-	m_lDelay->setFeedback( m_flangerControls.m_feedbackModel.value() );
-	m_rDelay->setFeedback( m_flangerControls.m_feedbackModel.value() );
-	sample_t dryS[2];
+
+	// the delays of the whole period first, so the line only has to be as
+	// long as the longest of them
 	float leftLfo;
 	float rightLfo;
+	float longest = 0.0f;
 	for( fpp_t f = 0; f < frames; ++f )
 	{
 		buf[f][0] += m_noise->tick() * noise;
 		buf[f][1] += m_noise->tick() * noise;
-		dryS[0] = buf[f][0];
-		dryS[1] = buf[f][1];
 		m_lfo->tick(&leftLfo, &rightLfo);
-		m_lDelay->setLength( ( float )length + amplitude * (leftLfo+1.0)  );
-		m_rDelay->setLength( ( float )length + amplitude * (rightLfo+1.0)  );
-		if(invertFeedback)
+		m_leftDelays[f] = length + amplitude * (leftLfo+1.0);
+		m_rightDelays[f] = length + amplitude * (rightLfo+1.0);
+		longest = qMax( longest, qMax( m_leftDelays[f], m_rightDelays[f] ) );
+	}
+	m_delay.reserve( longest );
+
+	// inverting the feedback crosses the channels over, the left LFO
+	// delays the right channel and vice versa
+	const float * delays0 = invertFeedback ? m_rightDelays : m_leftDelays;
+	const float * delays1 = invertFeedback ? m_leftDelays : m_rightDelays;
+
+	// unless the feedback of this period is heard in this period already,
+	// all of it is read at once
+	bool wholePeriod = true;
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		wholePeriod &= delays0[f] >= f + 1 && delays1[f] >= f + 1;
+	}
+
+	if( wholePeriod )
+	{
+		m_delay.readBlock( delays0, delays1, m_wet, frames );
+	}
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		sampleFrame wet;
+		if( wholePeriod )
 		{
-			m_lDelay->tick( &buf[f][1] );
-			m_rDelay->tick(&buf[f][0] );
-		} else
+			wet = m_wet[f];
+		}
+		else
 		{
-			m_lDelay->tick( &buf[f][0] );
-			m_rDelay->tick( &buf[f][1] );
+			m_delay.read( delays0[f], delays1[f], wet );
 		}
 
-		buf[f][0] = ( d * dryS[0] ) + ( w * buf[f][0] );
-		buf[f][1] = ( d * dryS[1] ) + ( w * buf[f][1] );
+		sampleFrame in;
+		in[0] = buf[f][0] + wet[0] * feedback;
+		in[1] = buf[f][1] + wet[1] * feedback;
+		if( wholePeriod )
+		{
+			m_wet[f] = in;
+		}
+		else
+		{
+			m_delay.write( in );
+		}
+
+		buf[f][0] = ( d * buf[f][0] ) + ( w * wet[0] );
+		buf[f][1] = ( d * buf[f][1] ) + ( w * wet[1] );
 		outSum += buf[f][0]*buf[f][0] + buf[f][1]*buf[f][1];
 	}
+	if( wholePeriod )
+	{
+		m_delay.writeBlock( m_wet, frames );
+	}
+
 	checkGate( outSum / frames );
+
+	if( !isRunning() )
+	{
+		m_delay.sleep();
+	}
 	return isRunning();
 }
 
 
 
 
+f_cnt_t FlangerEffect::tailLength() const
+{
+	// the noise is added to the input, so it never falls silent
+	if( m_flangerControls.m_whiteNoiseAmountModel.value() > 0.0f )
+	{
+		return UnknownTail;
+	}
+	const float longest = m_flangerControls.m_delayTimeModel.value() +
+				2 * m_flangerControls.m_lfoAmountModel.value();
+	return feedbackTail( longest * Engine::mixer()->processingSampleRate(),
+				m_flangerControls.m_feedbackModel.value() );
+}
+
+
+
+
 void FlangerEffect::changeSampleRate()
 {
 	m_lfo->setSampleRate( Engine::mixer()->processingSampleRate() );
-	m_lDelay->setSampleRate( Engine::mixer()->processingSampleRate() );
-	m_rDelay->setSampleRate( Engine::mixer()->processingSampleRate() );
+	m_delay.clear();
 }
 
 
@@ -26,10 +26,10 @@
 #ifndef FLANGEREFFECT_H
 #define FLANGEREFFECT_H
 
+#include "DelayLine.h"
 #include "Effect.h"
 #include "FlangerControls.h"
 #include "QuadratureLfo.h"
-#include "MonoDelay.h"
 #include "Noise.h"
 
 
@@ -39,6 +39,11 @@ public:
 	FlangerEffect( Model* parent , const Descriptor::SubPluginFeatures::Key* key );
 	virtual ~FlangerEffect();
 	virtual bool processAudioBuffer( sampleFrame *buf, const fpp_t frames );
+	f_cnt_t tailLength() const override;
+	qint64 memoryUsage() const override
+	{
+		return m_delay.capacity() * BYTES_PER_FRAME;
+	}
 	virtual EffectControls* controls()
 	{
 		return &m_flangerControls;
@@ -48,10 +53,13 @@ public:
 
 private:
 	FlangerControls m_flangerControls;
-	MonoDelay* m_lDelay;
-	MonoDelay* m_rDelay;
+	DelayLine m_delay;
 	QuadratureLfo* m_lfo;
 	Noise* m_noise;
+	// delay of each frame of the period for either LFO, in frames
+	float* m_leftDelays;
+	float* m_rightDelays;
+	sampleFrame* m_wet;
 
 };
 
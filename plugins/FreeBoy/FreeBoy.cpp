@@ -24,6 +24,7 @@
  */
 
 #include <cmath>
+#include <iterator>
 
 #include <QPainter>
 #include <QDomElement>
@@ -44,7 +45,6 @@
 
 #include "plugin_export.h"
 
-const blip_time_t FRAME_LENGTH = 70224;
 const long CLOCK_RATE = 4194304;
 
 extern "C"
@@ -117,15 +117,17 @@ FreeBoyInstrument::FreeBoyInstrument( InstrumentTrack * _instrument_track ) :
 	m_trebleModel( -20.0f, -100.0f, 200.0f, 1.0f, this, tr( "Treble" ) ),
 	m_bassModel( 461.0f, -1.0f, 600.0f, 1.0f, this, tr( "Bass" ) ),
 
-	m_graphModel( 0, 15, 32, this, false, 1 ),
-
-	m_time(0)
+	m_graphModel( 0, 15, 32, this, false, 1 )
 {
 }
 
 
 FreeBoyInstrument::~FreeBoyInstrument()
 {
+	for( Gb_Apu_Buffer * apu : m_idleApus )
+	{
+		delete apu;
+	}
 }
 
 
@@ -255,25 +257,24 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 
 	if ( tfp == 0 )
 	{
-		Gb_Apu_Buffer *papu = new Gb_Apu_Buffer();
-		papu->set_sample_rate( samplerate, CLOCK_RATE );
+		Gb_Apu_Buffer *papu = takeApu( samplerate );
 
 		// Master sound circuitry power control
-		papu->write_register( fakeClock(),  0xff26, 0x80 );
+		papu->write_register( papu->fake_clock(),  0xff26, 0x80 );
 
 		data = m_ch1VolumeModel.value();
 		data = data<<1;
 		data += m_ch1VolSweepDirModel.value();
 		data = data<<3;
 		data += m_ch1SweepStepLengthModel.value();
-		papu->write_register( fakeClock(),  0xff12, data );
+		papu->write_register( papu->fake_clock(),  0xff12, data );
 
 		data = m_ch2VolumeModel.value();
 		data = data<<1;
 		data += m_ch2VolSweepDirModel.value();
 		data = data<<3;
 		data += m_ch2SweepStepLengthModel.value();
-		papu->write_register( fakeClock(),  0xff17, data );
+		papu->write_register( papu->fake_clock(),  0xff17, data );
 
 		//channel 4 - noise
 		data = m_ch4VolumeModel.value();
@@ -281,7 +282,7 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 		data += m_ch4VolSweepDirModel.value();
 		data = data<<3;
 		data += m_ch4SweepStepLengthModel.value();
-		papu->write_register( fakeClock(),  0xff21, data );
+		papu->write_register( papu->fake_clock(),  0xff21, data );
 
 		_n->m_pluginData = papu;
 	}
@@ -297,35 +298,35 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 	data += m_ch1SweepDirModel.value();
 	data = data << 3;
 	data += m_ch1SweepRtShiftModel.value();
-	papu->write_register( fakeClock(),  0xff10, data );
+	papu->write_register( papu->fake_clock(),  0xff10, data );
 
 	data = m_ch1WavePatternDutyModel.value();
 	data = data<<6;
-	papu->write_register( fakeClock(),  0xff11, data );
+	papu->write_register( papu->fake_clock(),  0xff11, data );
 
 
 	//channel 2 - square
 	data = m_ch2WavePatternDutyModel.value();
 	data = data<<6;
-	papu->write_register( fakeClock(),  0xff16, data );
+	papu->write_register( papu->fake_clock(),  0xff16, data );
 
 
 	//channel 3 - wave
 	//data = m_ch3OnModel.value()?128:0;
 	data = 128;
-	papu->write_register( fakeClock(),  0xff1a, data );
+	papu->write_register( papu->fake_clock(),  0xff1a, data );
 
 	int ch3voldata[4] = { 0, 3, 2, 1 };
 	data = ch3voldata[(int)m_ch3VolumeModel.value()];
 	data = data<<5;
-	papu->write_register( fakeClock(),  0xff1c, data );
+	papu->write_register( papu->fake_clock(),  0xff1c, data );
 
 
 	//controls
 	data = m_so1VolumeModel.value();
 	data = data<<4;
 	data += m_so2VolumeModel.value();
-	papu->write_register( fakeClock(),  0xff24, data );
+	papu->write_register( papu->fake_clock(),  0xff24, data );
 
 	data = m_ch4So2Model.value()?128:0;
 	data += m_ch3So2Model.value()?64:0;
@@ -335,7 +336,7 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 	data += m_ch3So1Model.value()?4:0;
 	data += m_ch2So1Model.value()?2:0;
 	data += m_ch1So1Model.value()?1:0;
-	papu->write_register( fakeClock(),  0xff25, data );
+	papu->write_register( papu->fake_clock(),  0xff25, data );
 
 	const float * wpm = m_graphModel.samples();
 
@@ -343,7 +344,7 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 	{
 		data = (int)floor(wpm[i*2]) << 4;
 		data += (int)floor(wpm[i*2+1]);
-		papu->write_register( fakeClock(),  0xff30 + i, data );
+		papu->write_register( papu->fake_clock(),  0xff30 + i, data );
 	}
 
 	if( ( freq >= 65 ) && ( freq <=4000 ) )
@@ -353,13 +354,13 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 		data = 2048 - ( ( 4194304 / freq )>>5 );
 		if( tfp==0 )
 		{
-			papu->write_register( fakeClock(),  0xff13, data & 0xff );
-			papu->write_register( fakeClock(),  0xff14, (data>>8) | initflag );
+			papu->write_register( papu->fake_clock(),  0xff13, data & 0xff );
+			papu->write_register( papu->fake_clock(),  0xff14, (data>>8) | initflag );
 		}
-		papu->write_register( fakeClock(),  0xff18, data & 0xff );
-		papu->write_register( fakeClock(),  0xff19, (data>>8) | initflag );
-		papu->write_register( fakeClock(),  0xff1d, data & 0xff );
-		papu->write_register( fakeClock(),  0xff1e, (data>>8) | initflag );
+		papu->write_register( papu->fake_clock(),  0xff18, data & 0xff );
+		papu->write_register( papu->fake_clock(),  0xff19, (data>>8) | initflag );
+		papu->write_register( papu->fake_clock(),  0xff1d, data & 0xff );
+		papu->write_register( papu->fake_clock(),  0xff1e, (data>>8) | initflag );
 	}
 
 	if( tfp == 0 )
@@ -383,48 +384,79 @@ void FreeBoyInstrument::playNote( NotePlayHandle * _n,
 		data += m_ch4ShiftRegWidthModel.value();
 		data = data << 3;
 		data += ropt;
-		papu->write_register( fakeClock(),  0xff22, data );
+		papu->write_register( papu->fake_clock(),  0xff22, data );
 
 		//channel 4 init
-		papu->write_register( fakeClock(),  0xff23, 128 );
+		papu->write_register( papu->fake_clock(),  0xff23, 128 );
 	}
 
-	int const buf_size = 2048;
+	// clock the whole period at once, the registers written above take
+	// effect from its first frame on
 	int framesleft = frames;
-	int datalen = 0;
-	blip_sample_t buf [buf_size*2];
+	papu->run_frames( framesleft - papu->samples_avail() );
 	while( framesleft > 0 )
 	{
-		int avail = papu->samples_avail();
-		if( avail <= 0 )
+		long count = papu->read_frames( _working_buffer + frames - framesleft + offset,
+							framesleft );
+		if( count <= 0 )
 		{
-			m_time = 0;
-			papu->end_frame(FRAME_LENGTH);
-			avail = papu->samples_avail();
+			papu->run_frames( framesleft );
+			continue;
 		}
-		datalen = framesleft>avail?avail:framesleft;
-		datalen = datalen>buf_size?buf_size:datalen;
+		framesleft -= count;
+	}
+	instrumentTrack()->processAudioBuffer( _working_buffer, frames + offset, _n );
+}
+
+
+
+void FreeBoyInstrument::deleteNotePluginData( NotePlayHandle * _n )
+{
+	giveApu( static_cast<Gb_Apu_Buffer *>( _n->m_pluginData ) );
+}
+
 
-		long count = papu->read_samples( buf, datalen*2)/2;
 
-		for( fpp_t frame = 0; frame < count; ++frame )
+
+Gb_Apu_Buffer * FreeBoyInstrument::takeApu( int _sample_rate )
+{
+	{
+		QMutexLocker lock( &m_apuMutex );
+		for( auto it = m_idleApus.rbegin(); it != m_idleApus.rend(); ++it )
 		{
-			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			if( (*it)->sample_rate() == _sample_rate )
 			{
-				sample_t s = float(buf[frame*2+ch])/32768.0;
-				_working_buffer[frames-framesleft+frame+offset][ch] = s;
+				Gb_Apu_Buffer * apu = *it;
+				m_idleApus.erase( std::next( it ).base() );
+				return apu;
 			}
 		}
-		framesleft -= count;
 	}
-	instrumentTrack()->processAudioBuffer( _working_buffer, frames + offset, _n );
+
+	// setting the sample rate allocates the buffers of the APU
+	Gb_Apu_Buffer * apu = new Gb_Apu_Buffer();
+	apu->set_sample_rate( _sample_rate, CLOCK_RATE );
+	return apu;
 }
 
 
 
-void FreeBoyInstrument::deleteNotePluginData( NotePlayHandle * _n )
+
+void FreeBoyInstrument::giveApu( Gb_Apu_Buffer * _apu )
 {
-	delete static_cast<Gb_Apu_Buffer *>( _n->m_pluginData );
+	_apu->reset();
+
+	Gb_Apu_Buffer * dropped = NULL;
+	{
+		QMutexLocker lock( &m_apuMutex );
+		m_idleApus.push_back( _apu );
+		if( m_idleApus.size() > static_cast<size_t>( MaxIdleApus ) )
+		{
+			dropped = m_idleApus.front();
+			m_idleApus.erase( m_idleApus.begin() );
+		}
+	}
+	delete dropped;
 }
 
 
@@ -27,6 +27,8 @@
 #define FREEBOY_H
 
 #include <QObject>
+#include <QMutex>
+#include <vector>
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Knob.h"
@@ -34,6 +36,7 @@
 #include "Gb_Apu.h"
 
 class FreeBoyInstrumentView;
+class Gb_Apu_Buffer;
 class NotePlayHandle;
 class PixmapButton;
 
@@ -65,6 +68,12 @@ public:
 	void updateKnobToolTip();*/
 
 private:
+	// APUs of notes which ended, kept to be reset and reused
+	static const int MaxIdleApus = 16;
+
+	Gb_Apu_Buffer * takeApu( int _sample_rate );
+	void giveApu( Gb_Apu_Buffer * _apu );
+
 	FloatModel m_ch1SweepTimeModel;
 	BoolModel m_ch1SweepDirModel;
 	FloatModel m_ch1SweepRtShiftModel;
@@ -103,9 +112,8 @@ private:
 
 	graphModel  m_graphModel;
 
-	// Fake CPU timing
-	blip_time_t m_time;
-	blip_time_t fakeClock() { return m_time += 4; }
+	QMutex m_apuMutex;
+	std::vector<Gb_Apu_Buffer *> m_idleApus;
 
 	friend class FreeBoyInstrumentView;
 } ;
@@ -22,7 +22,9 @@
  */
 #include "Gb_Apu_Buffer.h"
 
-Gb_Apu_Buffer::Gb_Apu_Buffer() {}
+#include <algorithm>
+
+Gb_Apu_Buffer::Gb_Apu_Buffer() : m_time(0) {}
 Gb_Apu_Buffer::~Gb_Apu_Buffer() {}
 
 void Gb_Apu_Buffer::end_frame(blip_time_t end_time) {
@@ -30,6 +32,12 @@ void Gb_Apu_Buffer::end_frame(blip_time_t end_time) {
 	m_buf.end_frame(end_time);
 }
 
+void Gb_Apu_Buffer::run_frames(long count) {
+	const blip_time_t end_time = count > 0 ? m_buf.center()->count_clocks(count) : 0;
+	end_frame(std::max(end_time, m_time));
+	m_time = 0;
+}
+
 // Sets specified sample rate and clock rate in Multi_Buffer
 blargg_err_t Gb_Apu_Buffer::set_sample_rate(long sample_rate, long clock_rate) {
 	Gb_Apu_Buffer::output(m_buf.center(), m_buf.left(), m_buf.right());
@@ -37,6 +45,10 @@ blargg_err_t Gb_Apu_Buffer::set_sample_rate(long sample_rate, long clock_rate) {
 	return m_buf.set_sample_rate(sample_rate);
 }
 
+long Gb_Apu_Buffer::sample_rate() const {
+	return m_buf.sample_rate();
+}
+
 // Wrap Multi_Buffer::samples_avail()
 long Gb_Apu_Buffer::samples_avail() const {
 	return m_buf.samples_avail();
@@ -47,7 +59,23 @@ long Gb_Apu_Buffer::read_samples(sample_t* out, long count) {
 	return m_buf.read_samples(out, count);
 }
 
+long Gb_Apu_Buffer::read_frames(sampleFrame* out, long count) {
+	count = m_buf.read_samples(m_samples, std::min(count, max_read_frames) * 2) / 2;
+	const float scale = 1.0f / 32768.0f;
+	for (long frame = 0; frame < count; ++frame) {
+		out[frame][0] = m_samples[frame * 2] * scale;
+		out[frame][1] = m_samples[frame * 2 + 1] * scale;
+	}
+	return count;
+}
+
 void Gb_Apu_Buffer::bass_freq(int freq) {
 	m_buf.bass_freq(freq);
 }
 
+void Gb_Apu_Buffer::reset() {
+	Gb_Apu::reset();
+	m_buf.clear();
+	m_time = 0;
+}
+
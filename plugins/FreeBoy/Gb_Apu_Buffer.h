@@ -26,22 +26,42 @@
 #include "Gb_Apu.h"
 #include "Multi_Buffer.h"
 #include "MemoryManager.h"
+#include "lmms_basics.h"
 
 class Gb_Apu_Buffer : public Gb_Apu {
 	MM_OPERATORS
 public:
+	// frames converted by one read_frames() call at most
+	static const long max_read_frames = 2048;
+
 	Gb_Apu_Buffer();
 	~Gb_Apu_Buffer();
 
 	void end_frame(blip_time_t);
 
+	// Fake CPU timing, the time of the next register write
+	blip_time_t fake_clock() { return m_time += 4; }
+
+	// Runs the APU far enough for at least count more frames, and past all
+	// registers written since the last call
+	void run_frames(long count);
+
 	blargg_err_t set_sample_rate(long sample_rate, long clock_rate);
+	long sample_rate() const;
 	long samples_avail() const;
 	typedef blip_sample_t sample_t;
 	long read_samples(sample_t* out, long count);
+	// Reads up to count stereo frames, as floats
+	long read_frames(sampleFrame* out, long count);
 	void bass_freq(int freq);
+
+	// Powers the APU off and forgets the buffered output, to be used by
+	// another note
+	void reset();
 private:
 	Stereo_Buffer m_buf;
+	blip_time_t m_time;
+	sample_t m_samples[max_read_frames * 2];
 };
 
 #endif
@@ -77,6 +77,15 @@ Plugin::Descriptor PLUGIN_EXPORT gigplayer_plugin_descriptor =
 
 
 
+GigStreamer * GigInstrument::s_streamer = NULL;
+int GigInstrument::s_streamerUsers = 0;
+const int GigInstrument::PreloadMilliseconds;
+const int GigInstrument::StreamPeriods;
+const f_cnt_t GigInstrument::MinStreamFrames;
+
+
+
+
 GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &gigplayer_plugin_descriptor ),
 	m_instance( NULL ),
@@ -86,9 +95,16 @@ GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	m_patchNum( 0, 0, 127, this, tr( "Patch" ) ),
 	m_gain( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Gain" ) ),
 	m_interpolation( SRC_LINEAR ),
+	m_preloadedBytes( 0 ),
 	m_RandomSeed( 0 ),
 	m_currentKeyDimension( 0 )
 {
+	if( s_streamerUsers++ == 0 )
+	{
+		s_streamer = new GigStreamer;
+		s_streamer->start( QThread::HighPriority );
+	}
+
 	InstrumentPlayHandle * iph = new InstrumentPlayHandle( this, _instrument_track );
 	Engine::mixer()->addPlayHandle( iph );
 
@@ -108,6 +124,12 @@ GigInstrument::~GigInstrument()
 				PlayHandle::TypeNotePlayHandle
 				| PlayHandle::TypeInstrumentPlayHandle );
 	freeInstance();
+
+	if( --s_streamerUsers == 0 )
+	{
+		delete s_streamer;
+		s_streamer = NULL;
+	}
 }
 
 
@@ -186,6 +208,7 @@ void GigInstrument::freeInstance()
 
 	if( m_instance != NULL )
 	{
+		s_streamer->close( this );
 		delete m_instance;
 		m_instance = NULL;
 
@@ -194,6 +217,7 @@ void GigInstrument::freeInstance()
 		// that instrument again
 		m_instrument = NULL;
 		m_notes.clear();
+		m_preloadedBytes.store( 0, std::memory_order_relaxed );
 	}
 }
 
@@ -537,8 +561,7 @@ void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cn
 		}
 	}
 
-	unsigned long allocationsize = samples * sample.sample->FrameSize;
-	int8_t buffer[allocationsize];
+	int8_t buffer[samples * sample.sample->FrameSize];
 
 	// Load the sample in different ways depending on if we're looping or not
 	if( loop == true && ( sample.pos >= loopStart || sample.pos + samples > loopStart ) )
@@ -554,37 +577,33 @@ void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cn
 			// TODO: also implement loop_type_backward support
 		}
 
-		sample.sample->SetPos( sample.pos );
-
 		// Load the samples (based on gig::Sample::ReadAndLoop) even around the end
 		// of a loop boundary wrapping to the beginning of the loop region
-		long samplestoread = samples;
-		long samplestoloopend = 0;
-		long readsamples = 0;
-		long totalreadsamples = 0;
-		long loopEnd = loopStart + loopLength;
+		const f_cnt_t loopEnd = loopStart + loopLength;
+		f_cnt_t readPos = sample.pos;
+		f_cnt_t totalreadsamples = 0;
 
-		do
+		while( totalreadsamples < samples && readPos < loopEnd )
 		{
-			samplestoloopend = loopEnd - sample.sample->GetPos();
-			readsamples = sample.sample->Read( &buffer[totalreadsamples * sample.sample->FrameSize],
-					min( samplestoread, samplestoloopend ) );
-			samplestoread -= readsamples;
+			const f_cnt_t readsamples = qMin<f_cnt_t>(
+					samples - totalreadsamples, loopEnd - readPos );
+			readFrames( sample, readPos,
+				&buffer[totalreadsamples * sample.sample->FrameSize],
+							readsamples, samples );
 			totalreadsamples += readsamples;
+			readPos += readsamples;
 
-			if( readsamples >= samplestoloopend )
+			if( readPos >= loopEnd )
 			{
-				sample.sample->SetPos( loopStart );
+				readPos = loopStart;
 			}
 		}
-		while( samplestoread > 0 && readsamples > 0 );
+		std::memset( &buffer[totalreadsamples * sample.sample->FrameSize], 0,
+			( samples - totalreadsamples ) * sample.sample->FrameSize );
 	}
 	else
 	{
-		sample.sample->SetPos( sample.pos );
-
-		unsigned long size = sample.sample->Read( &buffer, samples ) * sample.sample->FrameSize;
-		std::memset( (int8_t*) &buffer + size, 0, allocationsize - size );
+		readFrames( sample, sample.pos, buffer, samples, samples );
 	}
 
 	// Convert from 16 or 24 bit into 32-bit float
@@ -645,6 +664,56 @@ void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cn
 
 
 
+void GigInstrument::readFrames( GigSample & sample, f_cnt_t pos, int8_t * buffer,
+					f_cnt_t frames, f_cnt_t perPeriod )
+{
+	const int frameSize = sample.sample->FrameSize;
+	const gig::buffer_t cache = sample.sample->GetCache();
+	const f_cnt_t cached = cache.Size / frameSize;
+	const f_cnt_t total = sample.sample->SamplesTotal;
+
+	f_cnt_t done = 0;
+	if( pos < cached )
+	{
+		done = qMin( frames, cached - pos );
+		std::memcpy( buffer, static_cast<int8_t *>( cache.pStart ) +
+					pos * frameSize, done * frameSize );
+	}
+
+	const f_cnt_t streamed = qMin( frames - done, total - ( pos + done ) );
+	if( streamed > 0 || ( !sample.stream && cached < total ) )
+	{
+		// open the stream on the first read, so it's read ahead by the
+		// time the voice gets past the preloaded start
+		if( !sample.stream )
+		{
+			sample.stream = s_streamer->open( this, sample.sample,
+				qMax( cached, pos + done ),
+				qMax( MinStreamFrames, perPeriod * StreamPeriods ) );
+		}
+		if( streamed > 0 )
+		{
+			f_cnt_t got = sample.stream->read( pos + done,
+					buffer + done * frameSize, streamed );
+			if( got < 0 )
+			{
+				// the voice went back, start over from there
+				sample.stream = s_streamer->open( this, sample.sample,
+					pos + done, qMax( MinStreamFrames,
+						perPeriod * StreamPeriods ) );
+				got = 0;
+			}
+			// if the disk doesn't keep up, the rest is silent
+			done += got;
+		}
+	}
+
+	std::memset( buffer + done * frameSize, 0, ( frames - done ) * frameSize );
+}
+
+
+
+
 // These two loop index functions taken from SampleBuffer.cpp
 f_cnt_t GigInstrument::getLoopedIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const
 {
@@ -891,7 +960,59 @@ void GigInstrument::getInstrument()
 		}
 
 		m_instrument = pInstrument;
+		if( m_instrument != NULL )
+		{
+			preloadSamples();
+		}
+	}
+}
+
+
+
+
+void GigInstrument::preloadSamples()
+{
+	QMutexLocker reading( s_streamer->readMutex() );
+
+	for( gig::Region * pRegion = m_instrument->GetFirstRegion();
+			pRegion != NULL; pRegion = m_instrument->GetNextRegion() )
+	{
+		for( uint32_t i = 0; i < pRegion->DimensionRegions; ++i )
+		{
+			gig::DimensionRegion * pDimRegion = pRegion->pDimensionRegions[i];
+			gig::Sample * pSample = pDimRegion->pSample;
+			if( pSample == NULL || pSample->SamplesTotal == 0 )
+			{
+				continue;
+			}
+
+			f_cnt_t frames = pSample->SamplesPerSecond *
+						PreloadMilliseconds / 1000;
+			// loops are played over and over, so they aren't streamed
+			if( pDimRegion->SampleLoops > 0 && pDimRegion->pSampleLoops != NULL )
+			{
+				frames = qMax<f_cnt_t>( frames,
+					pDimRegion->pSampleLoops[0].LoopStart +
+					pDimRegion->pSampleLoops[0].LoopLength );
+			}
+			frames = qMin<f_cnt_t>( frames, pSample->SamplesTotal );
+
+			// samples may be used by several regions
+			if( pSample->GetCache().Size / pSample->FrameSize <
+						static_cast<unsigned long>( frames ) )
+			{
+				pSample->LoadSampleData( frames );
+			}
+		}
+	}
+
+	qint64 bytes = 0;
+	for( gig::Sample * pSample = m_instance->gig.GetFirstSample();
+			pSample != NULL; pSample = m_instance->gig.GetNextSample() )
+	{
+		bytes += pSample->GetCache().Size;
 	}
+	m_preloadedBytes.store( bytes, std::memory_order_relaxed );
 }
 
 
@@ -1145,7 +1266,7 @@ GigSample::~GigSample()
 
 GigSample::GigSample( const GigSample& g )
 	: sample( g.sample ), region( g.region ), attenuation( g.attenuation ),
-	  adsr( g.adsr ), pos( g.pos ), interpolation( g.interpolation ),
+	  adsr( g.adsr ), pos( g.pos ), stream( g.stream ), interpolation( g.interpolation ),
 	  srcState( NULL ), sampleFreq( g.sampleFreq ), freqFactor( g.freqFactor )
 {
 	// On the copy, we want to create the object
@@ -1162,6 +1283,7 @@ GigSample& GigSample::operator=( const GigSample& g )
 	attenuation = g.attenuation;
 	adsr = g.adsr;
 	pos = g.pos;
+	stream = g.stream;
 	interpolation = g.interpolation;
 	srcState = NULL;
 	sampleFreq = g.sampleFreq;
@@ -1387,6 +1509,176 @@ void ADSR::inc( f_cnt_t num )
 
 
 
+GigStream::GigStream( const void * owner, gig::Sample * sample, f_cnt_t start,
+							f_cnt_t capacity ) :
+	m_owner( owner ),
+	m_sample( sample ),
+	m_frameSize( sample->FrameSize ),
+	m_capacity( capacity ),
+	m_buffer( capacity * sample->FrameSize ),
+	m_start( start ),
+	m_end( start )
+{
+}
+
+
+
+
+f_cnt_t GigStream::read( f_cnt_t pos, int8_t * buffer, f_cnt_t frames )
+{
+	if( pos < m_start.load( std::memory_order_relaxed ) )
+	{
+		return -1;
+	}
+	// the frames before pos may be overwritten from now on
+	m_start.store( pos, std::memory_order_release );
+
+	const f_cnt_t end = m_end.load( std::memory_order_acquire );
+	const f_cnt_t count = qBound<f_cnt_t>( 0, end - pos, frames );
+
+	const f_cnt_t index = pos % m_capacity;
+	const f_cnt_t first = qMin( count, m_capacity - index );
+	std::memcpy( buffer, &m_buffer[index * m_frameSize], first * m_frameSize );
+	std::memcpy( buffer + first * m_frameSize, &m_buffer[0],
+					( count - first ) * m_frameSize );
+	return count;
+}
+
+
+
+
+f_cnt_t GigStream::fill()
+{
+	const f_cnt_t start = m_start.load( std::memory_order_acquire );
+	// skip what the voice passed already
+	const f_cnt_t end = qMax( start, m_end.load( std::memory_order_relaxed ) );
+	const f_cnt_t left = m_sample->SamplesTotal - end;
+	const f_cnt_t count = qMin( m_capacity - ( end - start ), left );
+
+	// read in larger blocks, unless it's the end of the sample
+	if( count <= 0 || ( count < m_capacity / 4 && count < left ) )
+	{
+		return 0;
+	}
+
+	m_sample->SetPos( end );
+	f_cnt_t done = 0;
+	while( done < count )
+	{
+		const f_cnt_t index = ( end + done ) % m_capacity;
+		const f_cnt_t got = m_sample->Read( &m_buffer[index * m_frameSize],
+				qMin( count - done, m_capacity - index ) );
+		if( got <= 0 )
+		{
+			break;
+		}
+		done += got;
+	}
+	m_end.store( end + done, std::memory_order_release );
+	return done;
+}
+
+
+
+
+GigStreamer::GigStreamer() :
+	m_quit( false )
+{
+}
+
+
+
+
+GigStreamer::~GigStreamer()
+{
+	m_quit = true;
+	m_wakeMutex.lock();
+	m_wake.wakeOne();
+	m_wakeMutex.unlock();
+	wait();
+}
+
+
+
+
+std::shared_ptr<GigStream> GigStreamer::open( const void * owner,
+		gig::Sample * sample, f_cnt_t start, f_cnt_t capacity )
+{
+	std::shared_ptr<GigStream> stream = std::make_shared<GigStream>(
+					owner, sample, start, capacity );
+	m_streamsMutex.lock();
+	m_streams.append( stream );
+	m_streamsMutex.unlock();
+
+	m_wake.wakeOne();
+	return stream;
+}
+
+
+
+
+void GigStreamer::close( const void * owner )
+{
+	QMutexLocker reading( &m_readMutex );
+	QMutexLocker locker( &m_streamsMutex );
+
+	for( int i = m_streams.size() - 1; i >= 0; --i )
+	{
+		if( m_streams[i]->owner() == owner )
+		{
+			m_streams.removeAt( i );
+		}
+	}
+}
+
+
+
+
+void GigStreamer::run()
+{
+	while( !m_quit )
+	{
+		// taken first, so close() can't take streams away while they
+		// are filled
+		m_readMutex.lock();
+
+		QList<std::shared_ptr<GigStream> > streams;
+		m_streamsMutex.lock();
+		for( int i = m_streams.size() - 1; i >= 0; --i )
+		{
+			// the voice is gone
+			if( m_streams[i].use_count() == 1 )
+			{
+				m_streams.removeAt( i );
+			}
+		}
+		streams = m_streams;
+		m_streamsMutex.unlock();
+
+		bool busy = false;
+		for( const std::shared_ptr<GigStream> & stream : streams )
+		{
+			busy |= stream->fill() > 0;
+		}
+		m_readMutex.unlock();
+		streams.clear();
+
+		// go on right away while voices are starting up
+		if( !busy )
+		{
+			m_wakeMutex.lock();
+			if( !m_quit )
+			{
+				m_wake.wait( &m_wakeMutex, 5 );
+			}
+			m_wakeMutex.unlock();
+		}
+	}
+}
+
+
+
+
 extern "C"
 {
 
@@ -30,8 +30,14 @@
 #include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
 #include <samplerate.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "Instrument.h"
 #include "PixmapButton.h"
 #include "InstrumentView.h"
@@ -133,6 +139,84 @@ public:
 
 
 
+// The part of a sample a voice plays beyond what is preloaded, read ahead
+// from disk by the GigStreamer into a ring buffer. The voice only reads
+// forward, so it gives up the frames before where it reads.
+class GigStream
+{
+public:
+	GigStream( const void * owner, gig::Sample * sample, f_cnt_t start,
+							f_cnt_t capacity );
+
+	const void * owner() const
+	{
+		return m_owner;
+	}
+
+	// Called by the voice: copies up to frames raw frames from pos on,
+	// returns how many were read from disk already, or -1 if pos is behind
+	// the stream, which then has to start over
+	f_cnt_t read( f_cnt_t pos, int8_t * buffer, f_cnt_t frames );
+
+	// Called by the streamer: reads from disk what fits into the buffer,
+	// returns the frames read
+	f_cnt_t fill();
+
+private:
+	const void * m_owner;
+	gig::Sample * m_sample;
+	const int m_frameSize;
+	const f_cnt_t m_capacity;
+	std::vector<int8_t> m_buffer;
+
+	// the frames from m_start to m_end are in the buffer. The voice moves
+	// m_start, the streamer m_end. If the voice reads faster than the disk,
+	// m_start may pass m_end and the streamer skips ahead.
+	std::atomic<f_cnt_t> m_start;
+	std::atomic<f_cnt_t> m_end;
+} ;
+
+
+
+
+// The thread reading the streams of all GIG players from disk. There's only
+// one since libgig decompresses into a buffer shared by all samples.
+class GigStreamer : public QThread
+{
+public:
+	GigStreamer();
+	virtual ~GigStreamer();
+
+	// Called by the audio threads
+	std::shared_ptr<GigStream> open( const void * owner, gig::Sample * sample,
+					f_cnt_t start, f_cnt_t capacity );
+
+	// Stops filling the streams of owner, e.g. before its file is closed
+	void close( const void * owner );
+
+	// Held while reading from disk. Samples are preloaded under it, too,
+	// since libgig keeps one file position per sample.
+	QMutex * readMutex()
+	{
+		return &m_readMutex;
+	}
+
+protected:
+	void run() override;
+
+private:
+	QMutex m_readMutex;
+	QMutex m_streamsMutex;
+	QList<std::shared_ptr<GigStream> > m_streams;
+
+	QMutex m_wakeMutex;
+	QWaitCondition m_wake;
+	std::atomic<bool> m_quit;
+} ;
+
+
+
+
 // The sample from the GIG file with our current position in both the sample
 // and the envelope
 class GigSample
@@ -159,6 +243,9 @@ public:
 	// The position in sample
 	f_cnt_t pos;
 
+	// What isn't preloaded of the sample, opened on the first read
+	std::shared_ptr<GigStream> stream;
+
 	// Whether to change the pitch of the samples, e.g. if there's only one
 	// sample per octave and you want that sample pitch shifted for the rest of
 	// the notes in the octave, this will be true
@@ -256,6 +343,11 @@ public:
 		return 0;
 	}
 
+	qint64 memoryUsage() const override
+	{
+		return m_preloadedBytes.load( std::memory_order_relaxed );
+	}
+
 	virtual Flags flags() const
 	{
 		return IsSingleStreamed|IsNotBendable;
@@ -295,6 +387,10 @@ private:
 	// Used for resampling
 	int m_interpolation;
 
+	// The preloaded starts of the samples of the file, which stay in
+	// memory when the patch changes
+	std::atomic<qint64> m_preloadedBytes;
+
 	// List of all the currently playing notes
 	QList<GigNote> m_notes;
 
@@ -302,6 +398,17 @@ private:
 	uint32_t m_RandomSeed;
 	float m_currentKeyDimension;
 
+	// Preloaded from each sample, the rest is streamed from disk. Looped
+	// samples are preloaded up to the end of their loop.
+	static const int PreloadMilliseconds = 300;
+	// Periods a stream reads ahead, and its minimum size in frames
+	static const int StreamPeriods = 16;
+	static const f_cnt_t MinStreamFrames = 16384;
+
+	// Shared by all instances, started with the first one
+	static GigStreamer * s_streamer;
+	static int s_streamerUsers;
+
 private:
 	// Delete the current GIG instance if one is open
 	void freeInstance();
@@ -315,6 +422,14 @@ private:
 
 	// Load sample data from the Gig file, looping the sample where needed
 	void loadSample( GigSample& sample, sampleFrame* sampleData, f_cnt_t samples );
+	// Reads frames raw frames from pos on without looping, from the
+	// preloaded start or the stream of the sample. What isn't available
+	// yet is silent. perPeriod is how many frames the voice plays per
+	// period, which the read-ahead is sized from.
+	void readFrames( GigSample & sample, f_cnt_t pos, int8_t * buffer,
+					f_cnt_t frames, f_cnt_t perPeriod );
+	// Keep the start of the samples of the instrument in memory
+	void preloadSamples();
 	f_cnt_t getLoopedIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const;
 	f_cnt_t getPingPongIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const;
 
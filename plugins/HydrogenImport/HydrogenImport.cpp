@@ -18,6 +18,9 @@
 #include "BBTrack.h"
 #include "BBTrackContainer.h"
 #include "Instrument.h"
+#include "Mixer.h"
+#include "SampleBuffer.h"
+#include "SampleCache.h"
 
 #include "plugin_export.h"
 
@@ -128,6 +131,16 @@ public:
 	}
 
 };
+
+// an instrument of the song, read before any track is created
+struct DrumInstrument
+{
+	QString id;
+	float volume;
+	float panning;
+	QString sample;
+};
+
 HydrogenImport::HydrogenImport( const QString & _file ) :
 	ImportFilter( _file, &hydrogenimport_plugin_descriptor )
 {
@@ -140,9 +153,9 @@ HydrogenImport::HydrogenImport( const QString & _file ) :
 HydrogenImport::~HydrogenImport()
 {
 }
-Instrument * ins;
 bool HydrogenImport::readSong() 
 {
+	QVector<DrumInstrument> instruments;
 	QHash<QString, InstrumentTrack *> drum_track;
 	QHash<QString, int> pattern_length;
 	QHash<QString, int> pattern_id;
@@ -223,11 +236,7 @@ bool HydrogenImport::readSong()
 
 					if ( nLayer == 0 ) 
 					{
-						drum_track[sId] = ( InstrumentTrack * ) Track::create( Track::InstrumentTrack,Engine::getBBTrackContainer() );
-						drum_track[sId]->volumeModel()->setValue( fVolume * 100 );
-						drum_track[sId]->panningModel()->setValue( ( fPan_R - fPan_L ) * 100 );
-						ins = drum_track[sId]->loadInstrument( "audiofileprocessor" );
-						ins->loadFile( sFilename );
+						instruments.push_back( { sId, fVolume * 100, ( fPan_R - fPan_L ) * 100, sFilename } );
 					}
 					nLayer++;
 					layerNode = ( QDomNode ) layerNode.nextSiblingElement( "layer" );
@@ -245,6 +254,30 @@ bool HydrogenImport::readSong()
 	{
 		return false;
 	}
+
+	// decode the samples of the drumkit on the other cores while the
+	// tracks are created, loading them only waits for the rest
+	QStringList samples;
+	for ( const DrumInstrument & instrument : instruments )
+	{
+		samples << instrument.sample;
+	}
+	SampleBuffer::prefetchFiles( samples, false );
+
+	// pause the engine once for the whole song, not for every track
+	Engine::mixer()->requestChangeInModel();
+
+	for ( const DrumInstrument & instrument : instruments )
+	{
+		InstrumentTrack * t = ( InstrumentTrack * ) Track::create( Track::InstrumentTrack,Engine::getBBTrackContainer() );
+		t->volumeModel()->setValue( instrument.volume );
+		t->panningModel()->setValue( instrument.panning );
+		Instrument * ins = t->loadInstrument( "audiofileprocessor" );
+		ins->loadFile( instrument.sample );
+		drum_track[instrument.id] = t;
+	}
+	SampleCache::releasePrefetched();
+
 	QDomNode patterns = songNode.firstChildElement( "patternList" );
 	int pattern_count = 0;
 	int nbb = Engine::getBBTrackContainer()->numOfBBs();
@@ -266,6 +299,9 @@ bool HydrogenImport::readSong()
 		int nSize = -1;
 		nSize = LocalFileMng::readXmlInt( patternNode, "size", nSize, false, false );
 		pattern_length[sName] = nSize;
+		// the notes of each pattern are added at once, sorting them and
+		// updating its view only once
+		QHash<Pattern *, QVector<Note>> pattern_notes;
 		QDomNode pNoteListNode = patternNode.firstChildElement( "noteList" );
 		if ( ! pNoteListNode.isNull() ) {
 			QDomNode noteNode = pNoteListNode.firstChildElement( "note" );
@@ -294,11 +330,15 @@ bool HydrogenImport::readSong()
 				n.setVolume( fVelocity * 100 );
 				n.setPanning( ( fPan_R - fPan_L ) * 100 );
 				n.setKey( NoteKey::stringToNoteKey( sKey ) );
-				p->addNote( n,false );
+				pattern_notes[p].push_back( n );
 				pn = pn + 1;
 				noteNode = ( QDomNode ) noteNode.nextSiblingElement( "note" );
 			}        
 		}
+		for ( auto it = pattern_notes.begin(); it != pattern_notes.end(); ++it )
+		{
+			it.key()->addNotes( it.value() );
+		}
 		patternNode = ( QDomNode ) patternNode.nextSiblingElement( "pattern" );
 	}
 	// Pattern sequence
@@ -327,6 +367,8 @@ bool HydrogenImport::readSong()
 		groupNode = groupNode.nextSiblingElement( "group" );
 	}
 
+	Engine::mixer()->doneChangeInModel();
+
 	if ( pattern_count == 0 ) 
 	{
 		return false;
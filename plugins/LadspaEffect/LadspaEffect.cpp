@@ -24,6 +24,8 @@
  */
 
 
+#include <algorithm>
+
 #include <QtCore/QVarLengthArray>
 #include <QMessageBox>
 
@@ -39,6 +41,7 @@
 #include "AutomationPattern.h"
 #include "ControllerConnection.h"
 #include "MemoryManager.h"
+#include "PlanarBuffer.h"
 #include "ValueBuffer.h"
 #include "Song.h"
 
@@ -72,6 +75,8 @@ LadspaEffect::LadspaEffect( Model * _parent,
 	Effect( &ladspaeffect_plugin_descriptor, _parent, _key ),
 	m_controls( NULL ),
 	m_maxSampleRate( 0 ),
+	m_latencyPort( NULL ),
+	m_discardBuffer( NULL ),
 	m_key( LadspaSubPluginFeatures::subPluginKeyToLadspaKey( _key ) )
 {
 	Ladspa2LMMS * manager = Engine::getLADSPAManager();
@@ -128,6 +133,19 @@ void LadspaEffect::changeSampleRate()
 
 
 
+inline void LadspaEffect::connectPort( port_desc_t * _port, LADSPA_Data * _data )
+{
+	if( _port->buffer != _data )
+	{
+		_port->buffer = _data;
+		( m_descriptor->connect_port )( m_handles[_port->proc],
+						_port->port_id, _data );
+	}
+}
+
+
+
+
 bool LadspaEffect::processAudioBuffer( sampleFrame * _buf, 
 							const fpp_t _frames )
 {
@@ -151,115 +169,150 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 				Engine::mixer()->processingSampleRate();
 	}
 
-	// Copy the LMMS audio buffer to the LADSPA input buffer and initialize
-	// the control ports.  
-	ch_cnt_t channel = 0;
+	updateControls( frames );
+
+	// The processors take turns with the shared buffers: each one gets its
+	// channels of the LMMS buffer, runs and mixes its output back.
+	double out_sum = 0.0;
+	const float d = dryLevel();
+	const float w = wetLevel();
+	ch_cnt_t inChannel = 0;
+	ch_cnt_t outChannel = 0;
 	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
 	{
+		int input = 0;
+		int output = 0;
 		for( int port = 0; port < m_portCount; ++port )
 		{
 			port_desc_t * pp = m_ports.at( proc ).at( port );
-			switch( pp->rate )
-			{
-				case CHANNEL_IN:
-					for( fpp_t frame = 0; 
-						frame < frames; ++frame )
-					{
-						pp->buffer[frame] = 
-							_buf[frame][channel];
-					}
-					++channel;
-					break;
-				case AUDIO_RATE_INPUT:
+			if( pp->rate == CHANNEL_IN )
+			{
+				LADSPA_Data * buffer = m_inputBuffers[input++];
+				for( fpp_t frame = 0; frame < frames; ++frame )
 				{
-					ValueBuffer * vb = pp->control->valueBuffer();
-					if( vb )
-					{
-						memcpy( pp->buffer, vb->values(), frames * sizeof(float) );
-					}
-					else
-					{
-						pp->value = static_cast<LADSPA_Data>( 
-											pp->control->value() / pp->scale );
-						// This only supports control rate ports, so the audio rates are
-						// treated as though they were control rate by setting the
-						// port buffer to all the same value.
-						for( fpp_t frame = 0; 
-							frame < frames; ++frame )
-						{
-							pp->buffer[frame] = 
-								pp->value;
-						}
-					}
-					break;
+					buffer[frame] = _buf[frame][inChannel];
 				}
-				case CONTROL_RATE_INPUT:
-					if( pp->control == NULL )
-					{
-						break;
-					}
-					pp->value = static_cast<LADSPA_Data>( 
-										pp->control->value() / pp->scale );
-					pp->buffer[0] = 
-						pp->value;
-					break;
-				case CHANNEL_OUT:
-				case AUDIO_RATE_OUTPUT:
-				case CONTROL_RATE_OUTPUT:
-					break;
-				default:
-					break;
+				connectPort( pp, buffer );
+				++inChannel;
+			}
+			else if( pp->rate == CHANNEL_OUT )
+			{
+				connectPort( pp, m_inPlaceBroken ?
+						m_outputBuffers[output] :
+						m_inputBuffers[output] );
+				++output;
+			}
+		}
+
+		(m_descriptor->run)( m_handles[proc], frames );
+
+		for( int port = 0; port < m_portCount; ++port )
+		{
+			port_desc_t * pp = m_ports.at( proc ).at( port );
+			if( pp->rate == CHANNEL_OUT )
+			{
+				for( fpp_t frame = 0; frame < frames; ++frame )
+				{
+					_buf[frame][outChannel] = d * _buf[frame][outChannel] + w * pp->buffer[frame];
+					out_sum += _buf[frame][outChannel] * _buf[frame][outChannel];
+				}
+				++outChannel;
 			}
 		}
 	}
 
+	if( o_buf != NULL )
+	{
+		sampleBack( _buf, o_buf, m_maxSampleRate );
+	}
 
-	// Process the buffers.
-	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
+	checkGate( out_sum / frames );
+
+
+	bool is_running = isRunning();
+	m_pluginMutex.unlock();
+	return( is_running );
+}
+
+
+
+
+bool LadspaEffect::prefersPlanar() const
+{
+	return !( m_maxSampleRate < Engine::mixer()->processingSampleRate() );
+}
+
+
+
+
+bool LadspaEffect::processPlanarBuffer( PlanarBuffer & _buf,
+							const fpp_t _frames )
+{
+	m_pluginMutex.lock();
+	if( !isOkay() || dontRun() || !isRunning() || !isEnabled() )
 	{
-		(m_descriptor->run)( m_handles[proc], frames );
+		m_pluginMutex.unlock();
+		return( false );
 	}
 
-	// Copy the LADSPA output buffers to the LMMS buffer.
+	updateControls( _frames );
+
 	double out_sum = 0.0;
-	channel = 0;
 	const float d = dryLevel();
 	const float w = wetLevel();
+	// with nothing of the dry signal to keep, the plugin reads from and
+	// writes to the channels of the chain itself
+	const bool inPlace = !m_inPlaceBroken && d == 0.0f && w == 1.0f;
+	ch_cnt_t inChannel = 0;
+	ch_cnt_t outChannel = 0;
 	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
 	{
+		const ch_cnt_t firstOutChannel = outChannel;
+		int output = 0;
 		for( int port = 0; port < m_portCount; ++port )
 		{
 			port_desc_t * pp = m_ports.at( proc ).at( port );
-			switch( pp->rate )
-			{
-				case CHANNEL_IN:
-				case AUDIO_RATE_INPUT:
-				case CONTROL_RATE_INPUT:
-					break;
-				case CHANNEL_OUT:
-					for( fpp_t frame = 0; 
-						frame < frames; ++frame )
-					{
-						_buf[frame][channel] = d * _buf[frame][channel] + w * pp->buffer[frame];
-						out_sum += _buf[frame][channel] * _buf[frame][channel];
-					}
-					++channel;
-					break;
-				case AUDIO_RATE_OUTPUT:
-				case CONTROL_RATE_OUTPUT:
-					break;
-				default:
-					break;
+			if( pp->rate == CHANNEL_IN )
+			{
+				connectPort( pp, _buf.channel( inChannel ) );
+				++inChannel;
+			}
+			else if( pp->rate == CHANNEL_OUT )
+			{
+				connectPort( pp, inPlace ? _buf.channel( outChannel ) :
+							m_outputBuffers[output] );
+				++output;
+				++outChannel;
 			}
 		}
-	}
 
-	if( o_buf != NULL )
-	{
-		sampleBack( _buf, o_buf, m_maxSampleRate );
+		(m_descriptor->run)( m_handles[proc], _frames );
+
+		outChannel = firstOutChannel;
+		for( int port = 0; port < m_portCount; ++port )
+		{
+			port_desc_t * pp = m_ports.at( proc ).at( port );
+			if( pp->rate != CHANNEL_OUT )
+			{
+				continue;
+			}
+			sample_t * channel = _buf.channel( outChannel );
+			if( !inPlace )
+			{
+				for( fpp_t frame = 0; frame < _frames; ++frame )
+				{
+					channel[frame] = d * channel[frame] + w * pp->buffer[frame];
+				}
+			}
+			for( fpp_t frame = 0; frame < _frames; ++frame )
+			{
+				out_sum += channel[frame] * channel[frame];
+			}
+			++outChannel;
+		}
 	}
 
-	checkGate( out_sum / frames );
+	checkGate( out_sum / _frames );
 
 
 	bool is_running = isRunning();
@@ -270,6 +323,58 @@ bool LadspaEffect::processAudioBuffer( sampleFrame * _buf,
 
 
 
+void LadspaEffect::updateControls( const fpp_t _frames )
+{
+	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
+	{
+		for( int port = 0; port < m_portCount; ++port )
+		{
+			port_desc_t * pp = m_ports.at( proc ).at( port );
+			if( pp->control == NULL )
+			{
+				continue;
+			}
+			if( pp->rate == AUDIO_RATE_INPUT )
+			{
+				ValueBuffer * vb = pp->control->valueBuffer();
+				if( vb )
+				{
+					memcpy( pp->buffer, vb->values(), _frames * sizeof(float) );
+					pp->holdsValue = false;
+					continue;
+				}
+			}
+			else if( pp->rate != CONTROL_RATE_INPUT )
+			{
+				continue;
+			}
+
+			const LADSPA_Data value = static_cast<LADSPA_Data>(
+					pp->control->value() / pp->scale );
+			if( pp->holdsValue && value == pp->value )
+			{
+				continue;
+			}
+			pp->value = value;
+			pp->holdsValue = true;
+			if( pp->rate == AUDIO_RATE_INPUT )
+			{
+				// This only supports control rate ports, so the audio
+				// rates are treated as though they were control rate by
+				// setting the whole port buffer to the same value.
+				std::fill_n( pp->buffer, Mixer::maxFramesPerPeriod(), value );
+			}
+			else
+			{
+				pp->buffer[0] = value;
+			}
+		}
+	}
+}
+
+
+
+
 void LadspaEffect::setControl( int _control, LADSPA_Data _value )
 {
 	if( !isOkay() )
@@ -282,6 +387,21 @@ void LadspaEffect::setControl( int _control, LADSPA_Data _value )
 
 
 
+f_cnt_t LadspaEffect::latency() const
+{
+	if( m_latencyPort == NULL )
+	{
+		return 0;
+	}
+	// reported at the rate the plugin runs at
+	const f_cnt_t frames = static_cast<f_cnt_t>( m_latencyPort->buffer[0] );
+	const sample_rate_t sr = Engine::mixer()->processingSampleRate();
+	return m_maxSampleRate < sr ? frames * sr / m_maxSampleRate : frames;
+}
+
+
+
+
 void LadspaEffect::pluginInstantiation()
 {
 	m_maxSampleRate = maxSamplerate( displayName() );
@@ -299,11 +419,7 @@ void LadspaEffect::pluginInstantiation()
 	// Categorize the ports, and create the buffers.
 	m_portCount = manager->getPortCount( m_key );
 
-	int inputch = 0;
-	int outputch = 0;
-	LADSPA_Data * inbuf [2];
-	inbuf[0] = NULL;
-	inbuf[1] = NULL;
+	m_discardBuffer = MM_ALLOC( LADSPA_Data, Mixer::maxFramesPerPeriod() );
 	for( ch_cnt_t proc = 0; proc < processorCount(); proc++ )
 	{
 		multi_proc_t ports;
@@ -316,6 +432,7 @@ void LadspaEffect::pluginInstantiation()
 			p->port_id = port;
 			p->control = NULL;
 			p->buffer = NULL;
+			p->holdsValue = false;
 
 			// Determine the port's category.
 			if( manager->isPortAudio( m_key, port ) )
@@ -324,34 +441,21 @@ void LadspaEffect::pluginInstantiation()
 					manager->isPortInput( m_key, port ) )
 				{
 					p->rate = CHANNEL_IN;
-					p->buffer = MM_ALLOC( LADSPA_Data, Engine::mixer()->framesPerPeriod() );
-					inbuf[ inputch ] = p->buffer;
-					inputch++;
 				}
 				else if( p->name.toUpper().contains( "OUT" ) &&
 					manager->isPortOutput( m_key, port ) )
 				{
 					p->rate = CHANNEL_OUT;
-					if( ! m_inPlaceBroken && inbuf[ outputch ] )
-					{
-						p->buffer = inbuf[ outputch ];
-						outputch++;
-					}
-					else
-					{
-						p->buffer = MM_ALLOC( LADSPA_Data, Engine::mixer()->framesPerPeriod() );
-						m_inPlaceBroken = true;
-					}
 				}
 				else if( manager->isPortInput( m_key, port ) )
 				{
 					p->rate = AUDIO_RATE_INPUT;
-					p->buffer = MM_ALLOC( LADSPA_Data, Engine::mixer()->framesPerPeriod() );
+					p->buffer = MM_ALLOC( LADSPA_Data, Mixer::maxFramesPerPeriod() );
 				}
 				else
 				{
 					p->rate = AUDIO_RATE_OUTPUT;
-					p->buffer = MM_ALLOC( LADSPA_Data, Engine::mixer()->framesPerPeriod() );
+					p->buffer = m_discardBuffer;
 				}
 			}
 			else
@@ -461,6 +565,12 @@ void LadspaEffect::pluginInstantiation()
 
 			ports.append( p );
 
+			if( proc == 0 && p->rate == CONTROL_RATE_OUTPUT &&
+				p->name.compare( "latency", Qt::CaseInsensitive ) == 0 )
+			{
+				m_latencyPort = p;
+			}
+
 	// For convenience, keep a separate list of the ports that are used 
 	// to control the processors.
 			if( p->rate == AUDIO_RATE_INPUT || 
@@ -473,6 +583,42 @@ void LadspaEffect::pluginInstantiation()
 		m_ports.append( ports );
 	}
 
+	// The channel buffers of the first processor, which the others share.
+	// Outputs go to the inputs unless the plugin can't do that.
+	for( const port_desc_t * p : m_ports.value( 0 ) )
+	{
+		if( p->rate == CHANNEL_IN )
+		{
+			m_inputBuffers.append( MM_ALLOC( LADSPA_Data, Mixer::maxFramesPerPeriod() ) );
+		}
+		else if( p->rate == CHANNEL_OUT )
+		{
+			m_outputBuffers.append( MM_ALLOC( LADSPA_Data, Mixer::maxFramesPerPeriod() ) );
+		}
+	}
+	if( m_outputBuffers.size() > m_inputBuffers.size() )
+	{
+		m_inPlaceBroken = true;
+	}
+	for( const multi_proc_t & ports : m_ports )
+	{
+		int input = 0;
+		int output = 0;
+		for( port_desc_t * p : ports )
+		{
+			if( p->rate == CHANNEL_IN )
+			{
+				p->buffer = m_inputBuffers[input++];
+			}
+			else if( p->rate == CHANNEL_OUT )
+			{
+				p->buffer = m_inPlaceBroken ? m_outputBuffers[output] :
+							m_inputBuffers[output];
+				++output;
+			}
+		}
+	}
+
 	// Instantiate the processing units.
 	m_descriptor = manager->getDescriptor( m_key );
 	if( m_descriptor == NULL )
@@ -553,7 +699,10 @@ void LadspaEffect::pluginDestruction()
 		for( int port = 0; port < m_portCount; port++ )
 		{
 			port_desc_t * pp = m_ports.at( proc ).at( port );
-			if( m_inPlaceBroken || pp->rate != CHANNEL_OUT )
+			// the channel buffers are shared
+			if( pp->rate == AUDIO_RATE_INPUT ||
+				pp->rate == CONTROL_RATE_INPUT ||
+				pp->rate == CONTROL_RATE_OUTPUT )
 			{
 				if( pp->buffer) MM_FREE( pp->buffer );
 			}
@@ -562,6 +711,19 @@ void LadspaEffect::pluginDestruction()
 		m_ports[proc].clear();
 	}
 	m_ports.clear();
+	for( LADSPA_Data * buffer : m_inputBuffers )
+	{
+		MM_FREE( buffer );
+	}
+	for( LADSPA_Data * buffer : m_outputBuffers )
+	{
+		MM_FREE( buffer );
+	}
+	m_inputBuffers.clear();
+	m_outputBuffers.clear();
+	MM_FREE( m_discardBuffer );
+	m_discardBuffer = NULL;
+	m_latencyPort = NULL;
 	m_handles.clear();
 	m_portControls.clear();
 }
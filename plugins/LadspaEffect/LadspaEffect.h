@@ -45,9 +45,17 @@ public:
 
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 							const fpp_t _frames );
+
+	//! Unless the plugin has to be resampled, its audio ports are
+	//! connected to the channels of the chain directly
+	bool prefersPlanar() const override;
+	bool processPlanarBuffer( PlanarBuffer & _buf,
+						const fpp_t _frames ) override;
 	
 	void setControl( int _control, LADSPA_Data _data );
 
+	f_cnt_t latency() const override;
+
 	virtual EffectControls * controls()
 	{
 		return m_controls;
@@ -69,6 +77,10 @@ private:
 
 	static sample_rate_t maxSamplerate( const QString & _name );
 
+	// writes the control values to the input ports which changed
+	void updateControls( const fpp_t _frames );
+	inline void connectPort( port_desc_t * _port, LADSPA_Data * _data );
+
 
 	QMutex m_pluginMutex;
 	LadspaControls * m_controls;
@@ -83,6 +95,16 @@ private:
 
 	QVector<multi_proc_t> m_ports;
 	multi_proc_t m_portControls;
+	// the output control port named "latency" by convention, if any
+	port_desc_t * m_latencyPort;
+
+	// the audio channels of one processor, shared by all of them as they
+	// run one after another. Outputs are written to the inputs when the
+	// plugin allows it.
+	QVector<LADSPA_Data *> m_inputBuffers;
+	QVector<LADSPA_Data *> m_outputBuffers;
+	// where audio outputs nobody listens to go
+	LADSPA_Data * m_discardBuffer;
 
 } ;
 
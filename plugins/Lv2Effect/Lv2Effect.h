@@ -41,6 +41,7 @@ public:
 	bool isValid() const { return m_controls.isValid(); }
 
 	bool processAudioBuffer( sampleFrame* buf, const fpp_t frames ) override;
+	f_cnt_t latency() const override { return m_controls.latency(); }
 	EffectControls* controls() override { return &m_controls; }
 
 	Lv2FxControls* lv2Controls() { return &m_controls; }
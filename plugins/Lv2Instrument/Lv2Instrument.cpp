@@ -26,10 +26,12 @@
 
 #include <QDebug>
 #include <QDragEnterEvent>
+#include <QGridLayout>
 
 #include "Engine.h"
 #include "InstrumentPlayHandle.h"
 #include "InstrumentTrack.h"
+#include "LcdSpinBox.h"
 #include "Lv2SubPluginFeatures.h"
 #include "Mixer.h"
 #include "StringPairDrag.h"
@@ -71,7 +73,9 @@ Plugin::Descriptor PLUGIN_EXPORT lv2instrument_plugin_descriptor =
 Lv2Instrument::Lv2Instrument(InstrumentTrack *instrumentTrackArg,
 	Descriptor::SubPluginFeatures::Key *key) :
 	Instrument(instrumentTrackArg, &lv2instrument_plugin_descriptor, key),
-	Lv2ControlBase(this, key->attributes["uri"])
+	Lv2ControlBase(this, key->attributes["uri"]),
+	m_voicesModel(1, 1, static_cast<int>(Lv2ControlBase::maxVoices()), this,
+		tr("Instances"))
 {
 	if (Lv2ControlBase::isValid())
 	{
@@ -80,6 +84,8 @@ Lv2Instrument::Lv2Instrument(InstrumentTrack *instrumentTrackArg,
 #endif
 		connect(instrumentTrack()->pitchRangeModel(), SIGNAL(dataChanged()),
 			this, SLOT(updatePitchRange()), Qt::DirectConnection);
+		connect(&m_voicesModel, SIGNAL(dataChanged()),
+			this, SLOT(updateVoices()), Qt::DirectConnection);
 		connect(Engine::mixer(), &Mixer::sampleRateChanged,
 			this, [this](){Lv2ControlBase::reloadPlugin();});
 
@@ -110,6 +116,7 @@ bool Lv2Instrument::isValid() const { return Lv2ControlBase::isValid(); }
 
 void Lv2Instrument::saveSettings(QDomDocument &doc, QDomElement &that)
 {
+	m_voicesModel.saveSettings(doc, that, "voices");
 	Lv2ControlBase::saveSettings(doc, that);
 }
 
@@ -118,6 +125,8 @@ void Lv2Instrument::saveSettings(QDomDocument &doc, QDomElement &that)
 
 void Lv2Instrument::loadSettings(const QDomElement &that)
 {
+	// the voices must exist before their states are restored
+	m_voicesModel.loadSettings(that, "voices");
 	Lv2ControlBase::loadSettings(that);
 }
 
@@ -190,6 +199,14 @@ void Lv2Instrument::updatePitchRange()
 
 
 
+void Lv2Instrument::updateVoices()
+{
+	setVoices(static_cast<std::size_t>(m_voicesModel.value()));
+}
+
+
+
+
 QString Lv2Instrument::nodeName() const
 {
 	return Lv2ControlBase::nodeName();
@@ -224,6 +241,15 @@ Lv2InsView::Lv2InsView(Lv2Instrument *_instrument, QWidget *_parent) :
 	Lv2ViewBase(this, _instrument)
 {
 	setAutoFillBackground(true);
+
+	// the grid was set up by Lv2ViewBase
+	QGridLayout* grid = static_cast<QGridLayout*>(layout());
+	m_voicesSpinBox = new LcdSpinBox(2, this, tr("Instances"));
+	m_voicesSpinBox->setLabel(tr("INSTANCES"));
+	m_voicesSpinBox->setToolTip(tr("Number of plugin instances the notes "
+		"are distributed across"));
+	grid->addWidget(m_voicesSpinBox, grid->rowCount(), 0);
+
 	if (m_reloadPluginButton) {
 		connect(m_reloadPluginButton, &QPushButton::clicked,
 			this, [this](){ this->castModel<Lv2Instrument>()->reloadPlugin();} );
@@ -281,7 +307,9 @@ void Lv2InsView::dropEvent(QDropEvent *_de)
 
 void Lv2InsView::modelChanged()
 {
-	Lv2ViewBase::modelChanged(castModel<Lv2Instrument>());
+	Lv2Instrument* ins = castModel<Lv2Instrument>();
+	m_voicesSpinBox->setModel(&ins->m_voicesModel);
+	Lv2ViewBase::modelChanged(ins);
 }
 
 
@@ -27,6 +27,7 @@
 
 #include <QString>
 
+#include "AutomatableModel.h"
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Note.h"
@@ -37,6 +38,7 @@
 // currently only MIDI works
 #define LV2_INSTRUMENT_USE_MIDI
 
+class LcdSpinBox;
 class QPushButton;
 
 
@@ -87,6 +89,7 @@ public:
 
 private slots:
 	void updatePitchRange();
+	void updateVoices();
 
 private:
 	QString nodeName() const override;
@@ -96,6 +99,8 @@ private:
 #ifdef LV2_INSTRUMENT_USE_MIDI
 	int m_runningNotes[NumKeys];
 #endif
+	//! number of plugin instances the notes are distributed across
+	IntModel m_voicesModel;
 
 	friend class Lv2InsView;
 };
@@ -113,6 +118,8 @@ protected:
 
 private:
 	void modelChanged() override;
+
+	LcdSpinBox* m_voicesSpinBox;
 };
 
 
@@ -24,7 +24,6 @@
  */
 
 
-#include <QDomDocument>
 #include <QDir>
 #include <QApplication>
 #include <QMessageBox>
@@ -33,11 +32,14 @@
 #include "MidiExport.h"
 
 #include "lmms_math.h"
+#include "AutomationPattern.h"
 #include "TrackContainer.h"
 #include "BBTrack.h"
-#include "DataFile.h"
+#include "ConfigManager.h"
+#include "Engine.h"
 #include "InstrumentTrack.h"
-#include "LocaleHelper.h"
+#include "Pattern.h"
+#include "Song.h"
 
 #include "plugin_export.h"
 
@@ -80,16 +82,17 @@ bool MidiExport::tryExport(const TrackContainer::TrackList &tracks,
 			int tempo, int masterPitch, const QString &filename)
 {
 	QFile f(filename);
-	f.open(QIODevice::WriteOnly);
+	if (!f.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
 	QDataStream midiout(&f);
 
-	InstrumentTrack* instTrack;
-	BBTrack* bbTrack;
-	QDomElement element;
-
+	// automation is only written if a resolution in ticks is set
+	const int resolution = ConfigManager::inst()->value("midiexport", "automationresolution").toInt();
 
 	int nTracks = 0;
-	uint8_t buffer[BUFFER_SIZE];
+	uint8_t buffer[64];
 	uint32_t size;
 
 	for (const Track* track : tracks) if (track->type() == Track::InstrumentTrack) nTracks++;
@@ -102,159 +105,119 @@ bool MidiExport::tryExport(const TrackContainer::TrackList &tracks,
 
 	std::vector<std::vector<std::pair<int,int>>> plists;
 
-	// midi tracks
+	// midi tracks, the notes are taken from the patterns, one track at a
+	// time, and the events written as they are sorted
 	for (Track* track : tracks)
 	{
-		DataFile dataFile(DataFile::SongProject);
-		MTrack mtrack;
-
 		if (track->type() == Track::InstrumentTrack)
 		{
+			InstrumentTrack* instTrack = dynamic_cast<InstrumentTrack *>(track);
 
-			mtrack.addName(track->name().toStdString(), 0);
-			//mtrack.addProgramChange(0, 0);
-			mtrack.addTempo(tempo, 0);
-
-			instTrack = dynamic_cast<InstrumentTrack *>(track);
-			element = instTrack->saveState(dataFile, dataFile.content());
+			// the base note already includes the master pitch if used
+			int base_pitch = 69 - instTrack->baseNote();
+			double base_volume = instTrack->getVolume() / 100.0;
 
-			int base_pitch = 0;
-			double base_volume = 1.0;
-			int base_time = 0;
-
-			MidiNoteVector pat;
-
-			for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+			MidiCCVector ccs;
+			if (resolution > 0)
 			{
-
-				if (n.nodeName() == "instrumenttrack")
+				writeAutomation(ccs, instTrack->volumeModel(), MidiControllerMainVolume, resolution);
+				if (!ccs.empty())
 				{
-					QDomElement it = n.toElement();
-					base_pitch = (69 - it.attribute("basenote", "69").toInt());
-					if (it.attribute("usemasterpitch", "1").toInt())
-					{
-						base_pitch += masterPitch;
-					}
-					base_volume = LocaleHelper::toDouble(it.attribute("volume", "100"))/100.0;
-				}
-
-				if (n.nodeName() == "pattern")
-				{
-					base_time = n.toElement().attribute("pos", "0").toInt();
-					writePattern(pat, n, base_pitch, base_volume, base_time);
+					// the volume is in the controller instead
+					base_volume = 1.0;
 				}
+				writeAutomation(ccs, instTrack->panningModel(), MidiControllerPan, resolution);
+			}
 
+			MidiNoteVector pat;
+			for (const TrackContentObject* tco : track->getTCOs())
+			{
+				writePattern(pat, dynamic_cast<const Pattern *>(tco),
+					base_pitch, base_volume, tco->startPosition());
 			}
 			ProcessBBNotes(pat, INT_MAX);
-			writePatternToTrack(mtrack, pat);
-			size = mtrack.writeToBuffer(buffer);
-			midiout.writeRawData((char *)buffer, size);
+			writeTrack(midiout, track->name(), tempo, pat, ccs);
 		}
 
 		if (track->type() == Track::BBTrack)
 		{
-			bbTrack = dynamic_cast<BBTrack *>(track);
-			element = bbTrack->saveState(dataFile, dataFile.content());
-
 			std::vector<std::pair<int,int>> plist;
-			for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+			for (const TrackContentObject* tco : track->getTCOs())
 			{
-
-				if (n.nodeName() == "bbtco")
-				{
-					QDomElement it = n.toElement();
-					int pos = it.attribute("pos", "0").toInt();
-					int len = it.attribute("len", "0").toInt();
-					plist.push_back(std::pair<int,int>(pos, pos+len));
-				}
+				int pos = tco->startPosition();
+				int len = tco->length();
+				plist.push_back(std::pair<int,int>(pos, pos+len));
 			}
 			std::sort(plist.begin(), plist.end());
 			plists.push_back(plist);
-
 		}
 	} // for each track
 
 	// midi tracks in BB tracks
 	for (Track* track : tracks_BB)
 	{
-		DataFile dataFile(DataFile::SongProject);
-		MTrack mtrack;
-
 		auto itr = plists.begin();
 		std::vector<std::pair<int,int>> st;
 
 		if (track->type() != Track::InstrumentTrack) continue;
 
-		mtrack.addName(track->name().toStdString(), 0);
-		//mtrack.addProgramChange(0, 0);
-		mtrack.addTempo(tempo, 0);
-
-		instTrack = dynamic_cast<InstrumentTrack *>(track);
-		element = instTrack->saveState(dataFile, dataFile.content());
+		InstrumentTrack* instTrack = dynamic_cast<InstrumentTrack *>(track);
+		int base_pitch = 69 - instTrack->baseNote();
+		double base_volume = instTrack->getVolume() / 100.0;
 
-		int base_pitch = 0;
-		double base_volume = 1.0;
-
-		for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+		MidiNoteVector track_notes;
+		for (const TrackContentObject* tco : track->getTCOs())
 		{
-			if (n.nodeName() == "instrumenttrack")
+			if (itr == plists.end())
 			{
-				QDomElement it = n.toElement();
-				base_pitch = (69 - it.attribute("basenote", "69").toInt());
-				if (it.attribute("usemasterpitch", "1").toInt())
-				{
-					base_pitch += masterPitch;
-				}
-				base_volume = LocaleHelper::toDouble(it.attribute("volume", "100")) / 100.0;
+				break;
 			}
+			std::vector<std::pair<int,int>> &plist = *itr;
+			const Pattern* pattern = dynamic_cast<const Pattern *>(tco);
 
-			if (n.nodeName() == "pattern")
-			{
-				std::vector<std::pair<int,int>> &plist = *itr;
+			MidiNoteVector nv, pat;
+			writePattern(pat, pattern, base_pitch, base_volume, 0);
 
-				MidiNoteVector nv, pat;
-				writePattern(pat, n, base_pitch, base_volume, 0);
+			// workaround for nested BBTCOs
+			int pos = 0;
+			int len = (pattern ? pattern->steps() : 1) * 12;
+			for (auto it = plist.begin(); it != plist.end(); ++it)
+			{
+				while (!st.empty() && st.back().second <= it->first)
+				{
+					writeBBPattern(pat, nv, len, st.back().first, pos, st.back().second);
+					pos = st.back().second;
+					st.pop_back();
+				}
 
-				// workaround for nested BBTCOs
-				int pos = 0;
-				int len = n.toElement().attribute("steps", "1").toInt() * 12;
-				for (auto it = plist.begin(); it != plist.end(); ++it)
+				if (!st.empty() && st.back().second <= it->second)
 				{
-					while (!st.empty() && st.back().second <= it->first)
+					writeBBPattern(pat, nv, len, st.back().first, pos, it->first);
+					pos = it->first;
+					while (!st.empty() && st.back().second <= it->second)
 					{
-						writeBBPattern(pat, nv, len, st.back().first, pos, st.back().second);
-						pos = st.back().second;
 						st.pop_back();
 					}
-
-					if (!st.empty() && st.back().second <= it->second)
-					{
-						writeBBPattern(pat, nv, len, st.back().first, pos, it->first);
-						pos = it->first;
-						while (!st.empty() && st.back().second <= it->second)
-						{
-							st.pop_back();
-						}
-					}
-
-					st.push_back(*it);
-					pos = it->first;
 				}
 
-				while (!st.empty())
-				{
-					writeBBPattern(pat, nv, len, st.back().first, pos, st.back().second);
-					pos = st.back().second;
-					st.pop_back();
-				}
+				st.push_back(*it);
+				pos = it->first;
+			}
 
-				ProcessBBNotes(nv, pos);
-				writePatternToTrack(mtrack, nv);
-				++itr;
+			while (!st.empty())
+			{
+				writeBBPattern(pat, nv, len, st.back().first, pos, st.back().second);
+				pos = st.back().second;
+				st.pop_back();
 			}
+
+			ProcessBBNotes(nv, pos);
+			track_notes.insert(track_notes.end(), nv.begin(), nv.end());
+			++itr;
 		}
-		size = mtrack.writeToBuffer(buffer);
-		midiout.writeRawData((char *)buffer, size);
+
+		MidiCCVector ccs;
+		writeTrack(midiout, track->name(), tempo, track_notes, ccs);
 	}
 
 	return true;
@@ -263,33 +226,94 @@ bool MidiExport::tryExport(const TrackContainer::TrackList &tracks,
 
 
 
-void MidiExport::writePattern(MidiNoteVector &pat, QDomNode n,
+void MidiExport::writePattern(MidiNoteVector &pat, const Pattern *pattern,
 				int base_pitch, double base_volume, int base_time)
 {
-	// TODO interpret steps="12" muted="0" type="1" name="Piano1"  len="2592"
-	for (QDomNode nn = n.firstChild(); !nn.isNull(); nn = nn.nextSibling())
+	if (!pattern)
 	{
-		QDomElement note = nn.toElement();
-		if (note.attribute("len", "0") == "0") continue;
-		// TODO interpret pan="0" fxch="0" pitchrange="1"
+		return;
+	}
+	for (const Note* note : pattern->notes())
+	{
+		if (note->length() == 0) continue;
+		// TODO interpret panning
 		MidiNote mnote;
-		mnote.pitch = qMax(0, qMin(127, note.attribute("key", "0").toInt() + base_pitch));
+		mnote.pitch = qMax(0, qMin(127, note->key() + base_pitch));
 		 // Map from LMMS volume to MIDI velocity
-		mnote.volume = qMin(qRound(base_volume * LocaleHelper::toDouble(note.attribute("vol", "100")) * (127.0 / 200.0)), 127);
-		mnote.time = base_time + note.attribute("pos", "0").toInt();
-		mnote.duration = note.attribute("len", "0").toInt();
+		mnote.volume = qMin(qRound(base_volume * note->getVolume() * (127.0 / 200.0)), 127);
+		mnote.time = base_time + note->pos();
+		mnote.duration = note->length();
 		pat.push_back(mnote);
 	}
 }
 
 
 
-void MidiExport::writePatternToTrack(MTrack &mtrack, MidiNoteVector &nv)
+void MidiExport::writeAutomation(MidiCCVector &ccs, const AutomatableModel *model,
+				uint8_t controller, int resolution)
 {
-	for (auto it = nv.begin(); it != nv.end(); ++it)
+	QVector<AutomationPattern *> patterns = AutomationPattern::patternsForModel(model);
+	std::sort(patterns.begin(), patterns.end(), TrackContentObject::comparePosition);
+
+	const float min = model->minValue<float>();
+	const float range = model->maxValue<float>() - min;
+	int last = -1;
+	for (const AutomationPattern* pattern : patterns)
 	{
-		mtrack.addNote(it->pitch, it->volume, it->time / 48.0, it->duration / 48.0);
+		// the automation of beat/bassline patterns isn't played at a fixed
+		// time of the song
+		if (pattern->getTrack()->trackContainer() != Engine::getSong())
+		{
+			continue;
+		}
+		for (int time = 0; time < pattern->length(); time += resolution)
+		{
+			const int value = qBound(0, qRound((pattern->valueAt(time) - min) / range * 127), 127);
+			if (value != last)
+			{
+				ccs.push_back({pattern->startPosition() + time, controller, static_cast<uint8_t>(value)});
+				last = value;
+			}
+		}
+	}
+}
+
+
+
+void MidiExport::writeTrack(QDataStream &midiout, const QString &name, int tempo,
+				MidiNoteVector &nv, MidiCCVector &ccs)
+{
+	// the ticks of LMMS to those of the file
+	auto midiTime = [](int time)
+	{
+		return static_cast<uint32_t>(time / 48.0 * MidiFile::TICKSPERBEAT);
+	};
+
+	std::stable_sort(nv.begin(), nv.end());
+	std::stable_sort(ccs.begin(), ccs.end());
+
+	MidiFile::TrackWriter mtrack;
+	mtrack.addName(name.toStdString());
+	//mtrack.addProgramChange(0, 0);
+	mtrack.addTempo(tempo);
+
+	auto cc = ccs.begin();
+	for (const MidiNote& note : nv)
+	{
+		for (; cc != ccs.end() && cc->time <= note.time; ++cc)
+		{
+			mtrack.addController(cc->controller, cc->value, midiTime(cc->time));
+		}
+		mtrack.addNote(note.pitch, note.volume, midiTime(note.time),
+			midiTime(note.time + note.duration));
+	}
+	for (; cc != ccs.end(); ++cc)
+	{
+		mtrack.addController(cc->controller, cc->value, midiTime(cc->time));
 	}
+
+	const std::vector<uint8_t> &chunk = mtrack.finish();
+	midiout.writeRawData(reinterpret_cast<const char *>(chunk.data()), chunk.size());
 }
 
 
@@ -32,8 +32,10 @@
 #include "MidiFile.hpp"
 
 
-const int BUFFER_SIZE = 50*1024;
-typedef MidiFile::MIDITrack<BUFFER_SIZE> MTrack;
+class AutomatableModel;
+class InstrumentTrack;
+class Pattern;
+class QDataStream;
 
 struct MidiNote
 {
@@ -51,6 +53,20 @@ struct MidiNote
 typedef std::vector<MidiNote> MidiNoteVector;
 typedef std::vector<MidiNote>::iterator MidiNoteIterator;
 
+struct MidiCC
+{
+	int time;
+	uint8_t controller;
+	uint8_t value;
+
+	inline bool operator<(const MidiCC &b) const
+	{
+		return this->time < b.time;
+	}
+} ;
+
+typedef std::vector<MidiCC> MidiCCVector;
+
 
 
 class MidiExport: public ExportFilter
@@ -70,9 +86,14 @@ public:
 				int tempo, int masterPitch, const QString &filename);
 	
 private:
-	void writePattern(MidiNoteVector &pat, QDomNode n,
+	void writePattern(MidiNoteVector &pat, const Pattern *pattern,
 				int base_pitch, double base_volume, int base_time);
-	void writePatternToTrack(MTrack &mtrack, MidiNoteVector &nv);
+	// samples the song automation of model every resolution ticks, as
+	// values of controller scaled from the range of the model
+	void writeAutomation(MidiCCVector &ccs, const AutomatableModel *model,
+				uint8_t controller, int resolution);
+	void writeTrack(QDataStream &midiout, const QString &name, int tempo,
+				MidiNoteVector &nv, MidiCCVector &ccs);
 	void writeBBPattern(MidiNoteVector &src, MidiNoteVector &dst,
 				int len, int base, int start, int end);
 	void ProcessBBNotes(MidiNoteVector &nv, int cutPos);
@@ -24,6 +24,7 @@
 #include <vector>
 #include <set>
 #include <algorithm>
+#include <queue>
 #include <assert.h>
 
 using std::string;
@@ -112,197 +113,115 @@ class MIDIHeader
 };
 
 
-struct Event
+class TrackWriter
 {
-	uint32_t time;
-	uint32_t tempo;
-	string trackName;
-	enum {NOTE_ON, NOTE_OFF, TEMPO, PROG_CHANGE, TRACK_NAME} type;
-	// TODO make a union to save up space
-	uint8_t pitch;
-	uint8_t programNumber;
-	uint8_t duration;
-	uint8_t volume;
-	uint8_t channel;
-	
-	Event() {time=tempo=pitch=programNumber=duration=volume=channel=0; trackName="";}
-	
-	inline int writeToBuffer(uint8_t *buffer) const 
+	// Writes the events of a track chunk as they are added, which has to
+	// be in time order. Note offs are held back until their time comes.
+	struct NoteOff
 	{
-		uint8_t code, fourbytes[4];
-		int size=0;
-		switch (type) 
+		uint32_t time;
+		uint8_t pitch;
+		uint8_t volume;
+
+		// the soonest comes first in the queue
+		inline bool operator < (const NoteOff& b) const
 		{
-			case NOTE_ON:
-				code = 0x9 << 4 | channel;
-				size += writeVarLength(time, buffer+size);
-				buffer[size++] = code;
-				buffer[size++] = pitch;
-				buffer[size++] = volume;
-				break;
-			case NOTE_OFF:
-				code = 0x8 << 4 | channel;
-				size += writeVarLength(time, buffer+size);
-				buffer[size++] = code;
-				buffer[size++] = pitch;
-				buffer[size++] = volume;
-				break;
-			case TEMPO:
-				code = 0xFF;
-				size += writeVarLength(time, buffer+size);
-				buffer[size++] = code;
-				buffer[size++] = 0x51;
-				buffer[size++] = 0x03;
-				writeBigEndian4(int(60000000.0 / tempo), fourbytes);
-				
-				//printf("tempo of %x translates to ", tempo);
-				/*
-				for (int i=0; i<3; i++) printf("%02x ", fourbytes[i+1]);
-				printf("\n");
-				*/
-				buffer[size++] = fourbytes[1];
-				buffer[size++] = fourbytes[2];
-				buffer[size++] = fourbytes[3];
-				break;
-			case PROG_CHANGE:
-				code = 0xC << 4 | channel;
-				size += writeVarLength(time, buffer+size);
-				buffer[size++] = code;
-				buffer[size++] = programNumber;
-				break;
-			case TRACK_NAME:
-				size += writeVarLength(time, buffer+size);
-				buffer[size++] = 0xFF;
-				buffer[size++] = 0x03;
-				size += writeVarLength(trackName.size(), buffer+size);
-				trackName.copy((char *)(&buffer[size]), trackName.size());
-				size += trackName.size();
-//				 buffer[size++] = '\0';
-//				 buffer[size++] = '\0';
-				
-				break;
+			return time > b.time;
 		}
-		return size;
-	} // writeEventsToBuffer
-	
-	
-	// events are sorted by their time
-	inline bool operator < (const Event& b) const {
-		return this->time < b.time ||
-			(this->time == b.time && this->type > b.type);
-	}
-};
+	};
+
+	vector<uint8_t> data;
+	uint32_t lastTime;
+	std::priority_queue<NoteOff> noteOffs;
 
-template<const int MAX_TRACK_SIZE>
-class MIDITrack
-{
-	// A class that encapsulates a MIDI track
-	// Nested class definitions.
-	vector<Event> events;
-	
 	public:
 	uint8_t channel;
-	
-	MIDITrack(): channel(0) {}
-		
-	inline void addEvent(const Event &e)
+
+	TrackWriter(): lastTime(0), channel(0)
 	{
-		Event E = e;
-		events.push_back(E);
+		// chunk ID, the size is filled in by finish()
+		const uint8_t id[8] = {'M', 'T', 'r', 'k', 0, 0, 0, 0};
+		data.insert(data.end(), id, id + 8);
 	}
-	
-	inline void addNote(uint8_t pitch, uint8_t volume, double time, double duration)
+
+	inline void addName(const string &name)
 	{
-		Event event; event.channel = channel;
-		event.volume = volume;
-		
-		event.type = Event::NOTE_ON; event.pitch = pitch; event.time= (uint32_t) (time * TICKSPERBEAT);
-		addEvent(event);
-		
-		event.type = Event::NOTE_OFF; event.pitch = pitch; event.time=(uint32_t) ((time+duration) * TICKSPERBEAT);
-		addEvent(event);
-		
-		//printf("note: %d-%d\n", (uint32_t) time * TICKSPERBEAT, (uint32_t)((time+duration) * TICKSPERBEAT));
+		writeTime(lastTime);
+		data.push_back(0xFF);
+		data.push_back(0x03);
+		writeVarLength(name.size());
+		data.insert(data.end(), name.begin(), name.end());
 	}
-	
-	inline void addName(const string &name, uint32_t time)
+
+	inline void addTempo(int tempo)
 	{
-		Event event; event.channel = channel;
-		event.type = Event::TRACK_NAME; event.time=time; event.trackName = name;
-		addEvent(event);
+		uint8_t fourbytes[4];
+		writeBigEndian4(int(60000000.0 / tempo), fourbytes);
+		writeTime(lastTime);
+		data.push_back(0xFF);
+		data.push_back(0x51);
+		data.push_back(0x03);
+		data.insert(data.end(), fourbytes + 1, fourbytes + 4);
 	}
-	
-	inline void addProgramChange(uint8_t prog, uint32_t time)
+
+	inline void addNote(uint8_t pitch, uint8_t volume, uint32_t time, uint32_t endTime)
 	{
-		Event event; event.channel = channel;
-		event.type = Event::PROG_CHANGE; event.time=time; event.programNumber = prog;
-		addEvent(event);
+		writeNoteOffs(time);
+		writeEvent(time, 0x9 << 4 | channel, pitch, volume);
+		noteOffs.push({endTime, pitch, volume});
 	}
-	
-	inline void addTempo(uint8_t tempo, uint32_t time)
+
+	inline void addController(uint8_t controller, uint8_t value, uint32_t time)
 	{
-		Event event; event.channel = channel;
-		event.type = Event::TEMPO; event.time=time; event.tempo = tempo;
-		addEvent(event);
+		writeNoteOffs(time);
+		writeEvent(time, 0xB << 4 | channel, controller, value);
 	}
-	
-	inline int writeMIDIToBuffer(uint8_t *buffer, int start=0) const
-	{
-		// Write the meta data and note data to the packed MIDI stream.
-		// Process the events in the eventList
 
-		start += writeEventsToBuffer(buffer, start);
+	// Ends the track, and returns the whole chunk
+	inline const vector<uint8_t> &finish()
+	{
+		writeNoteOffs(UINT32_MAX);
 
 		// Write MIDI close event.
-		buffer[start++] = 0x00;
-		buffer[start++] = 0xFF;
-		buffer[start++] = 0x2F;
-		buffer[start++] = 0x00;
-		
-		// return the entire length of the data and write to the header
-		
-		return start;
+		const uint8_t close[4] = {0x00, 0xFF, 0x2F, 0x00};
+		data.insert(data.end(), close, close + 4);
+
+		writeBigEndian4(data.size() - 8, data.data() + 4);
+		return data;
 	}
 
-	inline int writeEventsToBuffer(uint8_t *buffer, int start=0) const
+	private:
+	// note offs come before note ons at the same time
+	inline void writeNoteOffs(uint32_t time)
 	{
-		// Write the events in MIDIEvents to the MIDI stream.
-		vector<Event> _events = events;
-		std::sort(_events.begin(), _events.end());
-		vector<Event>::const_iterator it;
-		uint32_t time_last = 0, tmp;
-		for (it = _events.begin(); it!=_events.end(); ++it)
+		while (!noteOffs.empty() && noteOffs.top().time <= time)
 		{
-			Event e = *it;
-			if (e.time < time_last){
-				printf("error: e.time=%d  time_last=%d\n", e.time, time_last);
-				assert(false);
-			}
-			tmp = e.time;
-			e.time -= time_last;
-			time_last = tmp;
-			start += e.writeToBuffer(buffer+start);
-			if (start >= MAX_TRACK_SIZE) {
-				break;
-			}
+			const NoteOff off = noteOffs.top();
+			noteOffs.pop();
+			writeEvent(off.time, 0x8 << 4 | channel, off.pitch, off.volume);
 		}
-		return start;
 	}
-	
-	inline int writeToBuffer(uint8_t *buffer, int start=0) const
+
+	inline void writeEvent(uint32_t time, uint8_t code, uint8_t param1, uint8_t param2)
 	{
-		uint8_t eventsBuffer[MAX_TRACK_SIZE];
-		uint32_t events_size = writeMIDIToBuffer(eventsBuffer);
-		//printf(">> track %lu events took 0x%x bytes\n", events.size(), events_size);
-		
-		// chunk ID
-		buffer[start++] = 'M'; buffer[start++] = 'T'; buffer[start++] = 'r'; buffer[start++] = 'k';
-		// chunk size
-		start += writeBigEndian4(events_size, buffer+start);
-		// copy events data
-		memmove(buffer+start, eventsBuffer, events_size);
-		start += events_size;
-		return start;
+		writeTime(time);
+		data.push_back(code);
+		data.push_back(param1);
+		data.push_back(param2);
+	}
+
+	inline void writeTime(uint32_t time)
+	{
+		assert(time >= lastTime);
+		writeVarLength(time - lastTime);
+		lastTime = time;
+	}
+
+	inline void writeVarLength(uint32_t val)
+	{
+		uint8_t buffer[5];
+		const int size = MidiFile::writeVarLength(val, buffer);
+		data.insert(data.end(), buffer, buffer + size);
 	}
 };
 
@@ -30,6 +30,7 @@
 #include <QMessageBox>
 #include <QProgressDialog>
 
+#include <algorithm>
 #include <sstream>
 #include <unordered_map>
 
@@ -181,6 +182,7 @@ public:
 
 	void clear()
 	{
+		finishPattern();
 		at = NULL;
 		ap = NULL;
 		lastPos = 0;
@@ -191,6 +193,7 @@ public:
 	{
 		if( !ap || time > lastPos + DefaultTicksPerBar )
 		{
+			finishPattern();
 			TimePos pPos = TimePos( time.getBar(), 0 );
 			ap = dynamic_cast<AutomationPattern*>(
 				at->createTCO(pPos));
@@ -198,12 +201,24 @@ public:
 		}
 
 		lastPos = time;
-		time = time - ap->startPosition();
-		ap->putValue( time, value, false );
-		ap->changeLength( TimePos( time.getBar() + 1, 0 ) ); 
+		values[time - ap->startPosition()] = value;
 
 		return *this;
 	}
+
+private:
+	// the values of ap, which are put at once
+	QMap<int, float> values;
+
+	void finishPattern()
+	{
+		if( ap && !values.isEmpty() )
+		{
+			ap->putValues( values );
+			ap->changeLength( TimePos( TimePos( values.lastKey() ).getBar() + 1, 0 ) );
+		}
+		values.clear();
+	}
 };
 
 
@@ -267,38 +282,51 @@ public:
 
 	void addNote( Note & n )
 	{
-		if (!p)
-		{
-			p = dynamic_cast<Pattern*>(it->createTCO(0));
-		}
-		p->addNote(n, false);
+		notes.push_back(n);
 		hasNotes = true;
 	}
 
 	void splitPatterns()
 	{
 		Pattern * newPattern = nullptr;
+		QVector<Note> patternNotes;
 		TimePos lastEnd(0);
 
-		p->rearrangeAllNotes();
-		for (auto n : p->notes())
+		// the notes are sorted once, and each pattern gets its notes at once
+		std::stable_sort(notes.begin(), notes.end(),
+			[](const Note & a, const Note & b) { return Note::lessThan(&a, &b); });
+		for (const Note & n : notes)
 		{
-			if (!newPattern || n->pos() > lastEnd + DefaultTicksPerBar)
+			if (!newPattern || n.pos() > lastEnd + DefaultTicksPerBar)
 			{
-				TimePos pPos = TimePos(n->pos().getBar(), 0);
+				if (newPattern)
+				{
+					newPattern->addNotes(patternNotes);
+					patternNotes.clear();
+				}
+				TimePos pPos = TimePos(n.pos().getBar(), 0);
 				newPattern = dynamic_cast<Pattern*>(it->createTCO(pPos));
 			}
-			lastEnd = n->pos() + n->length();
+			lastEnd = n.pos() + n.length();
 
-			Note newNote(*n);
-			newNote.setPos(n->pos(newPattern->startPosition()));
-			newPattern->addNote(newNote, false);
+			Note newNote(n);
+			newNote.setPos(n.pos(newPattern->startPosition()));
+			patternNotes.push_back(newNote);
+		}
+		if (newPattern)
+		{
+			newPattern->addNotes(patternNotes);
 		}
+		notes.clear();
 
 		delete p;
 		p = nullptr;
 	}
 
+private:
+	// the notes of all of the channel, split into patterns at the end
+	QVector<Note> notes;
+
 };
 
 
@@ -351,12 +379,16 @@ bool MidiImport::readSMF( TrackContainer* tc )
 
 	// Time-sig changes
 	Alg_time_sigs * timeSigs = &seq->time_sig;
+	QMap<int, float> numerators;
+	QMap<int, float> denominators;
 	for( int s = 0; s < timeSigs->length(); ++s )
 	{
 		Alg_time_sig timeSig = (*timeSigs)[s];
-		timeSigNumeratorPat->putValue(timeSig.beat * ticksPerBeat, timeSig.num);
-		timeSigDenominatorPat->putValue(timeSig.beat * ticksPerBeat, timeSig.den);
+		numerators[TimePos(timeSig.beat * ticksPerBeat)] = timeSig.num;
+		denominators[TimePos(timeSig.beat * ticksPerBeat)] = timeSig.den;
 	}
+	timeSigNumeratorPat->putValues(numerators);
+	timeSigDenominatorPat->putValues(denominators);
 	// manually call otherwise the pattern shows being 1 bar
 	timeSigNumeratorPat->updateLength();
 	timeSigDenominatorPat->updateLength();
@@ -370,18 +402,20 @@ bool MidiImport::readSMF( TrackContainer* tc )
 		tap->clear();
 		Alg_time_map * timeMap = seq->get_time_map();
 		Alg_beats & beats = timeMap->beats;
+		QMap<int, float> tempos;
 		for( int i = 0; i < beats.len - 1; i++ )
 		{
 			Alg_beat_ptr b = &(beats[i]);
 			double tempo = ( beats[i + 1].beat - b->beat ) /
 						   ( beats[i + 1].time - beats[i].time );
-			tap->putValue( b->beat * ticksPerBeat, tempo * 60.0 );
+			tempos[TimePos( b->beat * ticksPerBeat )] = tempo * 60.0;
 		}
 		if( timeMap->last_tempo_flag )
 		{
 			Alg_beat_ptr b = &( beats[beats.len - 1] );
-			tap->putValue( b->beat * ticksPerBeat, timeMap->last_tempo * 60.0 );
+			tempos[TimePos( b->beat * ticksPerBeat )] = timeMap->last_tempo * 60.0;
 		}
+		tap->putValues( tempos );
 	}
 
 	// Update the tempo to avoid crash when playing a project imported
@@ -558,6 +592,11 @@ bool MidiImport::readSMF( TrackContainer* tc )
 		}
 	}
 
+	for( int c = 0; c < MIDI_CC_COUNT; c++ )
+	{
+		ccs[c].clear();
+	}
+
 	delete seq;
 	
 	
@@ -27,6 +27,15 @@
 #include "embed.h"
 #include "plugin_export.h"
 
+
+
+f_cnt_t MultitapEchoEffect::tailLength() const
+{
+	// there's no feedback, the last tap is the end
+	const float length = m_controls.m_steps.value() * m_controls.m_stepLength.value();
+	return static_cast<f_cnt_t>( length * Engine::mixer()->processingSampleRate() / 1000.0f );
+}
+
 extern "C"
 {
 
@@ -50,11 +59,11 @@ MultitapEchoEffect::MultitapEchoEffect( Model* parent, const Descriptor::SubPlug
 	Effect( &multitapecho_plugin_descriptor, parent, key ),
 	m_stages( 1 ),
 	m_controls( this ),
-	m_buffer( 16100.0f ),
+	m_buffer( 0.0f ),
 	m_sampleRate( Engine::mixer()->processingSampleRate() ),
 	m_sampleRatio( 1.0f / m_sampleRate )
 {
-	m_work = MM_ALLOC( sampleFrame, Engine::mixer()->framesPerPeriod() );
+	m_work = MM_ALLOC( sampleFrame, Mixer::maxFramesPerPeriod() );
 	m_buffer.reset();
 	m_stages = static_cast<int>( m_controls.m_stages.value() );
 	updateFilters( 0, 19 );
@@ -93,8 +102,10 @@ bool MultitapEchoEffect::processAudioBuffer( sampleFrame * buf, const fpp_t fram
 {
 	if( !isEnabled() || !isRunning () )
 	{
+		m_buffer.sleep();
 		return( false );
 	}
+	m_buffer.wake();
 	
 	double outSum = 0.0;
 	const float d = dryLevel();
@@ -105,6 +116,9 @@ bool MultitapEchoEffect::processAudioBuffer( sampleFrame * buf, const fpp_t fram
 	const float stepLength = m_controls.m_stepLength.value();
 	const float dryGain = dbfsToAmp( m_controls.m_dryGain.value() );
 	const bool swapInputs = m_controls.m_swapInputs.value();
+
+	// room up to the last step, the offsets are summed up so a little more
+	m_buffer.reserve( steps * stepLength + 1.0f );
 	
 	// check if number of stages has changed
 	if( m_controls.m_stages.isValueChanged() )
@@ -156,6 +170,10 @@ bool MultitapEchoEffect::processAudioBuffer( sampleFrame * buf, const fpp_t fram
 	
 	checkGate( outSum / frames );
 
+	if( !isRunning() )
+	{
+		m_buffer.sleep();
+	}
 	return isRunning();	
 }
 
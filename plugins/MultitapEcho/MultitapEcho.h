@@ -39,6 +39,11 @@ public:
 	MultitapEchoEffect( Model* parent, const Descriptor::SubPluginFeatures::Key* key );
 	virtual ~MultitapEchoEffect();
 	virtual bool processAudioBuffer( sampleFrame* buf, const fpp_t frames );
+	f_cnt_t tailLength() const override;
+	qint64 memoryUsage() const override
+	{
+		return m_buffer.capacity() * BYTES_PER_FRAME;
+	}
 
 	virtual EffectControls* controls()
 	{
@@ -46,6 +46,7 @@
 #include <QByteArray>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 
 #include "opl.h"
 #include "temuopl.h"
@@ -157,9 +158,9 @@ OpulenzInstrument::OpulenzInstrument( InstrumentTrack * _instrument_track ) :
 
 	updatePatch();
 
-	// Can the buffer size change suddenly? I bet that would break lots of stuff
+	// the period may change, so allocate for the longest
 	frameCount = Engine::mixer()->framesPerPeriod();
-	renderbuffer = new short[frameCount];
+	renderbuffer = new short[Mixer::maxFramesPerPeriod()];
 
 	// Some kind of sane defaults
 	pitchbend = 0;
@@ -228,8 +229,8 @@ OpulenzInstrument::~OpulenzInstrument() {
 
 // Samplerate changes when choosing oversampling, so this is more or less mandatory
 void OpulenzInstrument::reloadEmulator() {
-	delete theEmulator;
 	emulatorMutex.lock();
+	delete theEmulator;
 	theEmulator = new CTemuopl(Engine::mixer()->processingSampleRate(), true, false);
 	theEmulator->init();
 	theEmulator->write(0x01,0x20);
@@ -296,6 +297,8 @@ int OpulenzInstrument::pushVoice(int v) {
 bool OpulenzInstrument::handleMidiEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	emulatorMutex.lock();
+	// patch changes made before the event apply to it
+	flushWrites();
 	int key, vel, voice, tmp_pb;
 
 	switch(event.type()) {
@@ -400,6 +403,8 @@ PluginView * OpulenzInstrument::instantiateView( QWidget * _parent )
 void OpulenzInstrument::play( sampleFrame * _working_buffer )
 {
 	emulatorMutex.lock();
+	flushWrites();
+	frameCount = Engine::mixer()->framesPerPeriod();
 	theEmulator->update(renderbuffer, frameCount);
 
 	for( fpp_t frame = 0; frame < frameCount; ++frame )
@@ -489,21 +494,44 @@ void OpulenzInstrument::loadSettings( const QDomElement & _this )
 
 // Load a patch into the emulator
 void OpulenzInstrument::loadPatch(const unsigned char inst[14]) {
-	emulatorMutex.lock();
 	for(int v=0; v<OPL2_VOICES; ++v) {
-		theEmulator->write(0x20+adlib_opadd[v],inst[0]); // op1 AM/VIB/EG/KSR/Multiplier
-		theEmulator->write(0x23+adlib_opadd[v],inst[1]); // op2
-		// theEmulator->write(0x40+adlib_opadd[v],inst[2]); // op1 KSL/Output Level - these are handled by noteon/aftertouch code
-		// theEmulator->write(0x43+adlib_opadd[v],inst[3]); // op2
-		theEmulator->write(0x60+adlib_opadd[v],inst[4]); // op1 A/D
-		theEmulator->write(0x63+adlib_opadd[v],inst[5]); // op2
-		theEmulator->write(0x80+adlib_opadd[v],inst[6]); // op1 S/R
-		theEmulator->write(0x83+adlib_opadd[v],inst[7]); // op2
-		theEmulator->write(0xe0+adlib_opadd[v],inst[8]); // op1 waveform
-		theEmulator->write(0xe3+adlib_opadd[v],inst[9]); // op2
-		theEmulator->write(0xc0+v,inst[10]);             // feedback/algorithm
+		queueWrite(0x20+adlib_opadd[v],inst[0]); // op1 AM/VIB/EG/KSR/Multiplier
+		queueWrite(0x23+adlib_opadd[v],inst[1]); // op2
+		// queueWrite(0x40+adlib_opadd[v],inst[2]); // op1 KSL/Output Level - these are handled by noteon/aftertouch code
+		// queueWrite(0x43+adlib_opadd[v],inst[3]); // op2
+		queueWrite(0x60+adlib_opadd[v],inst[4]); // op1 A/D
+		queueWrite(0x63+adlib_opadd[v],inst[5]); // op2
+		queueWrite(0x80+adlib_opadd[v],inst[6]); // op1 S/R
+		queueWrite(0x83+adlib_opadd[v],inst[7]); // op2
+		queueWrite(0xe0+adlib_opadd[v],inst[8]); // op1 waveform
+		queueWrite(0xe3+adlib_opadd[v],inst[9]); // op2
+		queueWrite(0xc0+v,inst[10]);             // feedback/algorithm
+	}
+}
+
+void OpulenzInstrument::queueWrite(int reg, int val) {
+	QMutexLocker lock(&queueMutex);
+	queuedValues[reg & 0xff] = val;
+	queuedRegs.set(reg & 0xff);
+}
+
+void OpulenzInstrument::flushWrites() {
+	unsigned char values[256];
+	std::bitset<256> regs;
+	{
+		QMutexLocker lock(&queueMutex);
+		if( queuedRegs.none() ) {
+			return;
+		}
+		regs = queuedRegs;
+		queuedRegs.reset();
+		memcpy(values, queuedValues, sizeof(values));
+	}
+	for(int reg=0; reg<256; ++reg) {
+		if( regs.test(reg) ) {
+			theEmulator->write(reg, values[reg]);
+		}
 	}
-	emulatorMutex.unlock();
 }
 
 void OpulenzInstrument::tuneEqual(int center, float Hz) {
@@ -566,7 +594,7 @@ void OpulenzInstrument::updatePatch() {
 	inst[13] = 0;
 
 	// Not part of the per-voice patch info
-	theEmulator->write(0xBD, (trem_depth_mdl.value() ? 128 : 0 ) +
+	queueWrite(0xBD, (trem_depth_mdl.value() ? 128 : 0 ) +
 			   (vib_depth_mdl.value() ? 64 : 0 ));
 
 	// have to do this, as the level knobs might've changed
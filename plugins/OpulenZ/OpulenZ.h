@@ -25,6 +25,10 @@
 #ifndef OPULENZ_H
 #define OPULENZ_H
 
+#include <bitset>
+
+#include <QMutex>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "opl.h"
@@ -136,6 +140,16 @@ private:
 	static QMutex emulatorMutex;
 	void setVoiceVelocity(int voice, int vel);
 
+	// Patch changes are queued and written to the chip before the next
+	// MIDI event or period, so only the last value of each register is
+	// written, e.g. while a knob is turned.
+	void queueWrite(int reg, int val);
+	// This shall only be called from code protected by the holy Mutex!
+	void flushWrites();
+	QMutex queueMutex;
+	unsigned char queuedValues[256];
+	std::bitset<256> queuedRegs;
+
 	// Pitch bend range comes through RPNs.
 	int RPNcoarse, RPNfine;
 };
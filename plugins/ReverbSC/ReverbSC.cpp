@@ -26,7 +26,7 @@
 #include "embed.h"
 #include "plugin_export.h"
 
-#define DB2LIN(X) pow(10, X / 20.0f);
+#define DB2LIN(X) pow(10, (X) / 20.0f)
 
 extern "C"
 {
@@ -46,6 +46,8 @@ Plugin::Descriptor PLUGIN_EXPORT reverbsc_plugin_descriptor =
 
 }
 
+const fpp_t ReverbSCEffect::BlockSize;
+
 ReverbSCEffect::ReverbSCEffect( Model* parent, const Descriptor::SubPluginFeatures::Key* key ) :
 	Effect( &reverbsc_plugin_descriptor, parent, key ),
 	m_reverbSCControls( this )
@@ -82,43 +84,59 @@ bool ReverbSCEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames )
 	const float d = dryLevel();
 	const float w = wetLevel();
 
-	SPFLOAT tmpL, tmpR;
-	SPFLOAT dcblkL, dcblkR;
-	
 	ValueBuffer * inGainBuf = m_reverbSCControls.m_inputGainModel.valueBuffer();
 	ValueBuffer * sizeBuf = m_reverbSCControls.m_sizeModel.valueBuffer();
 	ValueBuffer * colorBuf = m_reverbSCControls.m_colorModel.valueBuffer();
 	ValueBuffer * outGainBuf = m_reverbSCControls.m_outputGainModel.valueBuffer();
 
-	for( fpp_t f = 0; f < frames; ++f )
-	{
-		sample_t s[2] = { buf[f][0], buf[f][1] };
-
-		const SPFLOAT inGain = (SPFLOAT)DB2LIN((inGainBuf ? 
-			inGainBuf->values()[f] 
-			: m_reverbSCControls.m_inputGainModel.value()));
-		const SPFLOAT outGain = (SPFLOAT)DB2LIN((outGainBuf ? 
-			outGainBuf->values()[f] 
-			: m_reverbSCControls.m_outputGainModel.value()));
+	// without sample-exact size and color the network runs a block at a time
+	const fpp_t step = sizeBuf || colorBuf ? 1 : BlockSize;
 
-		s[0] *= inGain;
-		s[1] *= inGain;
-		revsc->feedback = (SPFLOAT)(sizeBuf ? 
-			sizeBuf->values()[f] 
-			: m_reverbSCControls.m_sizeModel.value());
+	const SPFLOAT inGainValue = (SPFLOAT)DB2LIN(m_reverbSCControls.m_inputGainModel.value());
+	const SPFLOAT outGainValue = (SPFLOAT)DB2LIN(m_reverbSCControls.m_outputGainModel.value());
 
-		revsc->lpfreq = (SPFLOAT)(colorBuf ? 
-			colorBuf->values()[f] 
-			: m_reverbSCControls.m_colorModel.value());
+	SPFLOAT inL[BlockSize], inR[BlockSize];
+	SPFLOAT outL[BlockSize], outR[BlockSize];
+	SPFLOAT outGain[BlockSize];
 
-
-		sp_revsc_compute(sp, revsc, &s[0], &s[1], &tmpL, &tmpR);
-		sp_dcblock_compute(sp, dcblk[0], &tmpL, &dcblkL);
-		sp_dcblock_compute(sp, dcblk[1], &tmpR, &dcblkR);
-		buf[f][0] = d * buf[f][0] + w * dcblkL * outGain;
-		buf[f][1] = d * buf[f][1] + w * dcblkR * outGain;
-
-		outSum += buf[f][0]*buf[f][0] + buf[f][1]*buf[f][1];
+	for( fpp_t offset = 0; offset < frames; offset += BlockSize )
+	{
+		const fpp_t count = qMin<fpp_t>( BlockSize, frames - offset );
+		sampleFrame * block = buf + offset;
+
+		for( fpp_t f = 0; f < count; ++f )
+		{
+			const SPFLOAT inGain = inGainBuf ?
+				(SPFLOAT)DB2LIN(inGainBuf->values()[offset + f]) : inGainValue;
+			inL[f] = block[f][0] * inGain;
+			inR[f] = block[f][1] * inGain;
+			outGain[f] = outGainBuf ?
+				(SPFLOAT)DB2LIN(outGainBuf->values()[offset + f]) : outGainValue;
+		}
+
+		for( fpp_t f = 0; f < count; f += step )
+		{
+			revsc->feedback = (SPFLOAT)(sizeBuf ?
+				sizeBuf->values()[offset + f]
+				: m_reverbSCControls.m_sizeModel.value());
+			revsc->lpfreq = (SPFLOAT)(colorBuf ?
+				colorBuf->values()[offset + f]
+				: m_reverbSCControls.m_colorModel.value());
+
+			const int n = qMin<int>( step, count - f );
+			sp_revsc_compute_block(sp, revsc, inL + f, inR + f, outL + f, outR + f, n);
+		}
+
+		sp_dcblock_compute_block(sp, dcblk[0], outL, outL, count);
+		sp_dcblock_compute_block(sp, dcblk[1], outR, outR, count);
+
+		for( fpp_t f = 0; f < count; ++f )
+		{
+			block[f][0] = d * block[f][0] + w * outL[f] * outGain[f];
+			block[f][1] = d * block[f][1] + w * outR[f] * outGain[f];
+
+			outSum += block[f][0]*block[f][0] + block[f][1]*block[f][1];
+		}
 	}
 
 
@@ -51,6 +51,9 @@ public:
 	void changeSampleRate();
 
 private:
+	//! Frames the reverb network processes at once
+	static const fpp_t BlockSize = 64;
+
 	ReverbSCControls m_reverbSCControls;
 	sp_data *sp;
 	sp_revsc *revsc;
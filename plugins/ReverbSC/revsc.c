@@ -274,3 +274,154 @@ int sp_revsc_compute(sp_data *sp, sp_revsc *p, SPFLOAT *in1, SPFLOAT *in2, SPFLO
     *out2 = aoutR * outputGain;
     return SP_OK;
 }
+
+/* Block version of sp_revsc_compute(). The state of the 8 delay lines is
+ * copied into one array per field, so everything but the delay line reads
+ * and writes runs as a loop over the lines the compiler turns into SIMD
+ * code. The results match sp_revsc_compute() within rounding. */
+
+#define REVSC_LINES 8
+
+int sp_revsc_compute_block(sp_data *sp, sp_revsc *p, const SPFLOAT *in1,
+        const SPFLOAT *in2, SPFLOAT *out1, SPFLOAT *out2, int frames)
+{
+    int writePos[REVSC_LINES], readPos[REVSC_LINES], bufferSize[REVSC_LINES];
+    int readPosFrac[REVSC_LINES], readPosFrac_inc[REVSC_LINES];
+    int randLine_cnt[REVSC_LINES];
+    SPFLOAT filterState[REVSC_LINES], ain[REVSC_LINES];
+    SPFLOAT vm1[REVSC_LINES], v0[REVSC_LINES], v1[REVSC_LINES], v2[REVSC_LINES];
+    SPFLOAT *buf[REVSC_LINES];
+    SPFLOAT dampFact, feedback;
+    sp_revsc_dl *lp;
+    int n, f;
+
+    if (p->initDone <= 0) return SP_NOT_OK;
+
+    /* parameters are constant within the block */
+
+    if (p->lpfreq != p->prv_LPFreq) {
+        p->prv_LPFreq = p->lpfreq;
+        dampFact = 2.0 - cos(p->prv_LPFreq * (2 * M_PI) / p->sampleRate);
+        p->dampFact = dampFact - sqrt(dampFact * dampFact - 1.0);
+    }
+    dampFact = p->dampFact;
+    feedback = p->feedback;
+
+    for (n = 0; n < REVSC_LINES; n++) {
+        lp = &p->delayLines[n];
+        writePos[n] = lp->writePos;
+        readPos[n] = lp->readPos;
+        bufferSize[n] = lp->bufferSize;
+        readPosFrac[n] = lp->readPosFrac;
+        readPosFrac_inc[n] = lp->readPosFrac_inc;
+        randLine_cnt[n] = lp->randLine_cnt;
+        filterState[n] = lp->filterState;
+        buf[n] = lp->buf;
+    }
+
+    for (f = 0; f < frames; f++) {
+        SPFLOAT junction = 0.0, aoutL = 0.0, aoutR = 0.0;
+
+        /* calculate "resultant junction pressure" and mix to input signals */
+
+        for (n = 0; n < REVSC_LINES; n++) {
+            junction += filterState[n];
+        }
+        junction *= jpScale;
+        for (n = 0; n < REVSC_LINES; n++) {
+            ain[n] = junction + (n & 1 ? in2[f] : in1[f]) - filterState[n];
+        }
+
+        /* send input signal and feedback to delay lines */
+
+        for (n = 0; n < REVSC_LINES; n++) {
+            buf[n][writePos[n]] = ain[n];
+        }
+        for (n = 0; n < REVSC_LINES; n++) {
+            writePos[n] += 1;
+            writePos[n] -= writePos[n] >= bufferSize[n] ? bufferSize[n] : 0;
+            readPos[n] += readPosFrac[n] >> DELAYPOS_SHIFT;
+            readPosFrac[n] &= DELAYPOS_MASK;
+            readPos[n] -= readPos[n] >= bufferSize[n] ? bufferSize[n] : 0;
+        }
+
+        /* read four samples of each line for interpolation */
+
+        for (n = 0; n < REVSC_LINES; n++) {
+            const SPFLOAT *b = buf[n];
+            int r = readPos[n];
+            if (r > 0 && r < (bufferSize[n] - 2)) {
+                vm1[n] = b[r - 1];
+                v0[n] = b[r];
+                v1[n] = b[r + 1];
+                v2[n] = b[r + 2];
+            }
+            else {
+                /* at buffer wrap-around, need to check index */
+                if (--r < 0) r += bufferSize[n];
+                vm1[n] = b[r];
+                if (++r >= bufferSize[n]) r -= bufferSize[n];
+                v0[n] = b[r];
+                if (++r >= bufferSize[n]) r -= bufferSize[n];
+                v1[n] = b[r];
+                if (++r >= bufferSize[n]) r -= bufferSize[n];
+                v2[n] = b[r];
+            }
+        }
+
+        /* cubic interpolation, feedback gain and lowpass filter */
+
+        for (n = 0; n < REVSC_LINES; n++) {
+            SPFLOAT frac = (SPFLOAT) readPosFrac[n]
+                * (SPFLOAT) (1.0 / DELAYPOS_SCALE);
+            SPFLOAT a2 = (frac * frac - 1.0f) * (SPFLOAT) (1.0 / 6.0);
+            SPFLOAT a1 = (frac + 1.0f) * 0.5f;
+            SPFLOAT am1 = a1 - 1.0f;
+            SPFLOAT a0 = 3.0f * a2;
+            SPFLOAT v;
+            a1 -= a0; am1 -= a2; a0 -= frac;
+            v = (am1 * vm1[n] + a0 * v0[n] + a1 * v1[n] + a2 * v2[n])
+                * frac + v0[n];
+            readPosFrac[n] += readPosFrac_inc[n];
+            v *= feedback;
+            v = (filterState[n] - v) * dampFact + v;
+            filterState[n] = v;
+            randLine_cnt[n] -= 1;
+        }
+
+        /* mix to output */
+
+        for (n = 0; n < REVSC_LINES; n += 2) {
+            aoutL += filterState[n];
+            aoutR += filterState[n + 1];
+        }
+        out1[f] = aoutL * outputGain;
+        out2[f] = aoutR * outputGain;
+
+        /* start next random line segment if current one has reached endpoint */
+
+        for (n = 0; n < REVSC_LINES; n++) {
+            if (randLine_cnt[n] <= 0) {
+                lp = &p->delayLines[n];
+                lp->writePos = writePos[n];
+                lp->readPos = readPos[n];
+                lp->readPosFrac = readPosFrac[n];
+                next_random_lineseg(p, lp, n);
+                randLine_cnt[n] = lp->randLine_cnt;
+                readPosFrac_inc[n] = lp->readPosFrac_inc;
+            }
+        }
+    }
+
+    for (n = 0; n < REVSC_LINES; n++) {
+        lp = &p->delayLines[n];
+        lp->writePos = writePos[n];
+        lp->readPos = readPos[n];
+        lp->readPosFrac = readPosFrac[n];
+        lp->readPosFrac_inc = readPosFrac_inc[n];
+        lp->randLine_cnt = randLine_cnt[n];
+        lp->filterState = filterState[n];
+    }
+
+    return SP_OK;
+}
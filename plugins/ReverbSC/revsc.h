@@ -26,3 +26,4 @@ int sp_revsc_create(sp_revsc **p);
 int sp_revsc_destroy(sp_revsc **p);
 int sp_revsc_init(sp_data *sp, sp_revsc *p);
 int sp_revsc_compute(sp_data *sp, sp_revsc *p, SPFLOAT *in1, SPFLOAT *in2, SPFLOAT *out1, SPFLOAT *out2);
+int sp_revsc_compute_block(sp_data *sp, sp_revsc *p, const SPFLOAT *in1, const SPFLOAT *in2, SPFLOAT *out1, SPFLOAT *out2, int frames);
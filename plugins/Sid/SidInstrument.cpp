@@ -29,6 +29,7 @@
 
 #include <cmath>
 #include <cstdio>
+#include <iterator>
 
 #include "sid.h"
 
@@ -50,6 +51,18 @@
 #define SIDWRITEDELAY 9 // lda $xxxx,x 4 cycles, sta $d400,x 5 cycles
 #define SIDWAVEDELAY 4 // and $xxxx,x 4 cycles extra
 
+// the emulation of a note's chip, with the registers last written to it
+struct SidChip
+{
+	MM_OPERATORS
+	SID sid;
+	int sampleRate;
+	sampling_method sampling;
+	SidInstrument::ChipModel model;
+	unsigned char regs[NUMSIDREGS];
+	bool regsValid;
+} ;
+
 unsigned char sidorder[] =
   {0x15,0x16,0x18,0x17,
    0x05,0x06,0x02,0x03,0x00,0x01,0x04,
@@ -140,6 +153,10 @@ SidInstrument::SidInstrument( InstrumentTrack * _instrument_track ) :
 
 SidInstrument::~SidInstrument()
 {
+	for( SidChip * chip : m_idleChips )
+	{
+		delete chip;
+	}
 }
 
 
@@ -247,8 +264,11 @@ f_cnt_t SidInstrument::desiredReleaseFrames() const
 
 
 
-static int sid_fillbuffer(unsigned char* sidreg, SID *sid, int tdelta, short *ptr, int samples)
+// writes the registers which changed since the last period and clocks the
+// chip for the whole period, with one call if none did
+static int sid_fillbuffer(unsigned char* sidreg, SidChip *chip, int tdelta, short *ptr, int samples)
 {
+  SID *sid = &chip->sid;
   int tdelta2;
   int result;
   int total = 0;
@@ -262,6 +282,11 @@ static int sid_fillbuffer(unsigned char* sidreg, SID *sid, int tdelta, short *pt
   {
     unsigned char o = sidorder[c];
 
+    if (chip->regsValid && chip->regs[o] == sidreg[o])
+    {
+      continue;
+    }
+
   	// Extra delay for loading the waveform (and mt_chngate,x)
   	if ((o == 4) || (o == 11) || (o == 18))
   	{
@@ -285,6 +310,7 @@ static int sid_fillbuffer(unsigned char* sidreg, SID *sid, int tdelta, short *pt
     }
 
     sid->write(o, sidreg[o]);
+    chip->regs[o] = sidreg[o];
 
     tdelta2 = SIDWRITEDELAY;
     result = sid->clock(tdelta2, ptr, samples);
@@ -293,6 +319,7 @@ static int sid_fillbuffer(unsigned char* sidreg, SID *sid, int tdelta, short *pt
     samples -= result;
     tdelta -= SIDWRITEDELAY;
   }
+  chip->regsValid = true;
   result = sid->clock(tdelta, ptr, samples);
   total += result;
 
@@ -302,6 +329,79 @@ static int sid_fillbuffer(unsigned char* sidreg, SID *sid, int tdelta, short *pt
 
 
 
+SidChip * SidInstrument::takeChip( int _sample_rate )
+{
+	// reSID's exact resampling for the final mix, interpolation for
+	// playback and the fastest mode while working on drafts
+	sampling_method sampling = SAMPLE_FAST;
+	switch( Engine::mixer()->currentQualitySettings().interpolation )
+	{
+		case Mixer::qualitySettings::Interpolation_Linear:
+			sampling = SAMPLE_FAST;
+			break;
+		case Mixer::qualitySettings::Interpolation_SincFastest:
+			sampling = SAMPLE_INTERPOLATE;
+			break;
+		case Mixer::qualitySettings::Interpolation_SincMedium:
+		case Mixer::qualitySettings::Interpolation_SincBest:
+			sampling = SAMPLE_RESAMPLE;
+			break;
+	}
+
+	{
+		QMutexLocker lock( &m_chipMutex );
+		for( auto it = m_idleChips.rbegin(); it != m_idleChips.rend(); ++it )
+		{
+			if( (*it)->sampleRate == _sample_rate && (*it)->sampling == sampling )
+			{
+				SidChip * chip = *it;
+				m_idleChips.erase( std::next( it ).base() );
+				return chip;
+			}
+		}
+	}
+
+	SidChip * chip = new SidChip;
+	chip->sampleRate = _sample_rate;
+	if( !chip->sid.set_sampling_parameters( C64_PAL_CYCLES_PER_SEC, sampling, _sample_rate ) )
+	{
+		// the resampling filter can't be built for every sample rate
+		sampling = SAMPLE_INTERPOLATE;
+		chip->sid.set_sampling_parameters( C64_PAL_CYCLES_PER_SEC, sampling, _sample_rate );
+	}
+	chip->sampling = sampling;
+	chip->model = sidMOS8580;
+	chip->sid.set_chip_model( MOS8580 );
+	chip->sid.enable_filter( true );
+	chip->sid.reset();
+	chip->regsValid = false;
+	return chip;
+}
+
+
+
+
+void SidInstrument::giveChip( SidChip * _chip )
+{
+	_chip->sid.reset();
+	_chip->regsValid = false;
+
+	SidChip * dropped = NULL;
+	{
+		QMutexLocker lock( &m_chipMutex );
+		m_idleChips.push_back( _chip );
+		if( m_idleChips.size() > static_cast<size_t>( MaxIdleChips ) )
+		{
+			dropped = m_idleChips.front();
+			m_idleChips.erase( m_idleChips.begin() );
+		}
+	}
+	delete dropped;
+}
+
+
+
+
 void SidInstrument::playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
@@ -312,17 +412,12 @@ void SidInstrument::playNote( NotePlayHandle * _n,
 
 	if ( tfp == 0 )
 	{
-		SID *sid = new SID();
-		sid->set_sampling_parameters( clockrate, SAMPLE_FAST, samplerate );
-		sid->set_chip_model( MOS8580 );
-		sid->enable_filter( true );
-		sid->reset();
-		_n->m_pluginData = sid;
+		_n->m_pluginData = takeChip( samplerate );
 	}
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 	const f_cnt_t offset = _n->noteOffset();
 
-	SID *sid = static_cast<SID *>( _n->m_pluginData );
+	SidChip *chip = static_cast<SidChip *>( _n->m_pluginData );
 	int delta_t = clockrate * frames / samplerate + 4;
 	// avoid variable length array for msvc compat
 	short* buf = reinterpret_cast<short*>(_working_buffer + offset);
@@ -333,13 +428,11 @@ void SidInstrument::playNote( NotePlayHandle * _n,
 		sidreg[c] = 0x00;
 	}
 
-	if( (ChipModel)m_chipModel.value() == sidMOS6581 )
-	{
-		sid->set_chip_model( MOS6581 );
-	}
-	else
+	const ChipModel model = (ChipModel)m_chipModel.value();
+	if( model != chip->model )
 	{
-		sid->set_chip_model( MOS8580 );
+		chip->sid.set_chip_model( model == sidMOS6581 ? MOS6581 : MOS8580 );
+		chip->model = model;
 	}
 
 	// voices
@@ -426,7 +519,7 @@ void SidInstrument::playNote( NotePlayHandle * _n,
 
 	sidreg[24] = data8&0x00FF;
 		
-	int num = sid_fillbuffer(sidreg, sid,delta_t,buf, frames);
+	int num = sid_fillbuffer(sidreg, chip,delta_t,buf, frames);
 	if(num!=frames)
 		printf("!!!Not enough samples\n");
 
@@ -448,7 +541,7 @@ void SidInstrument::playNote( NotePlayHandle * _n,
 
 void SidInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<SID *>( _n->m_pluginData );
+	giveChip( static_cast<SidChip *>( _n->m_pluginData ) );
 }
 
 
@@ -28,6 +28,8 @@
 #define _SID_H
 
 #include <QObject>
+#include <QMutex>
+#include <vector>
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Knob.h"
@@ -35,6 +37,7 @@
 
 class SidInstrumentView;
 class NotePlayHandle;
+struct SidChip;
 class automatableButtonGroup;
 class PixmapButton;
 
@@ -112,6 +115,12 @@ public:
 	void updateKnobToolTip();*/
 
 private:
+	// chips of notes which ended, kept to be reset and reused
+	static const int MaxIdleChips = 16;
+
+	SidChip * takeChip( int _sample_rate );
+	void giveChip( SidChip * _chip );
+
 	// voices
 	voiceObject * m_voice[3];
 
@@ -126,6 +135,9 @@ private:
 
 	IntModel m_chipModel;
 
+	QMutex m_chipMutex;
+	std::vector<SidChip *> m_idleChips;
+
 	friend class SidInstrumentView;
 
 } ;
@@ -57,20 +57,18 @@ Analyzer::Analyzer(Model *parent, const Plugin::Descriptor::SubPluginFeatures::K
 	Effect(&analyzer_plugin_descriptor, parent, key),
 	m_processor(&m_controls),
 	m_controls(this),
-	m_processorThread(m_processor, m_inputBuffer),
 	// Buffer is sized to cover 4* the current maximum LMMS audio buffer size,
 	// so that it has some reserve space in case data processor is busy.
-	m_inputBuffer(4 * m_maxBufferSize)
+	m_inputBuffer(4 * m_maxBufferSize),
+	m_inputReader(m_inputBuffer)
 {
-	m_processorThread.start();
+	FftAnalysis::addClient(this);
 }
 
 
 Analyzer::~Analyzer()
 {
-	m_processor.terminate();
-	m_inputBuffer.wakeAll();
-	m_processorThread.wait();
+	FftAnalysis::removeClient(this);
 }
 
 // Take audio data and pass them to the spectrum processor.
@@ -94,8 +92,9 @@ bool Analyzer::processAudioBuffer(sampleFrame *buffer, const fpp_t frame_count)
 	if (m_controls.isViewVisible())
 	{
 		// To avoid processing spikes on audio thread, data are stored in
-		// a lockless ringbuffer and processed in a separate thread.
-		m_inputBuffer.write(buffer, frame_count, true);
+		// a lockless ringbuffer and processed on an FftAnalysis thread.
+		m_inputBuffer.write(buffer, frame_count);
+		notify();
 	}
 	#ifdef SA_DEBUG
 		audio_time = std::chrono::high_resolution_clock::now().time_since_epoch().count() - audio_time;
@@ -27,17 +27,15 @@
 #ifndef ANALYZER_H
 #define ANALYZER_H
 
-#include <QWaitCondition>
-
-#include "DataprocLauncher.h"
 #include "Effect.h"
+#include "FftAnalysis.h"
 #include "LocklessRingBuffer.h"
 #include "SaControls.h"
 #include "SaProcessor.h"
 
 
 //! Top level class; handles LMMS interface and feeds data to the data processor.
-class Analyzer : public Effect
+class Analyzer : public Effect, public FftAnalysis::Client
 {
 public:
 	Analyzer(Model *parent, const Descriptor::SubPluginFeatures::Key *key);
@@ -48,6 +46,9 @@ public:
 
 	SaProcessor *getProcessor() {return &m_processor;}
 
+protected:
+	void analyze() override {m_processor.analyze(m_inputBuffer, m_inputReader);}
+
 private:
 	SaProcessor m_processor;
 	SaControls m_controls;
@@ -55,13 +56,8 @@ private:
 	// Maximum LMMS buffer size (hard coded, the actual constant is hard to get)
 	const unsigned int m_maxBufferSize = 4096;
 
-	// QThread::create() workaround
-	// Replace DataprocLauncher by QThread and replace initializer in constructor
-	// with the following commented line when LMMS CI starts using Qt > 5.9
-	//m_processorThread = QThread::create([=]{m_processor.analyze(m_inputBuffer);});
-	DataprocLauncher m_processorThread;
-
 	LocklessRingBuffer<sampleFrame> m_inputBuffer;
+	LocklessRingBufferReader<sampleFrame> m_inputReader;
 
 	#ifdef SA_DEBUG
 		int m_last_dump_time;
@@ -36,13 +36,13 @@
 #endif
 #include <QMutexLocker>
 
+#include "FftAnalysis.h"
 #include "lmms_math.h"
 #include "LocklessRingBuffer.h"
 
 
 SaProcessor::SaProcessor(const SaControls *controls) :
 	m_controls(controls),
-	m_terminate(false),
 	m_inBlockSize(FFT_BLOCK_SIZES[0]),
 	m_fftBlockSize(FFT_BLOCK_SIZES[0]),
 	m_sampleRate(Engine::mixer()->processingSampleRate()),
@@ -52,8 +52,7 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 	m_waterfallNotEmpty(0),
 	m_reallocating(false)
 {
-	m_fftWindow.resize(m_inBlockSize, 1.0);
-	precomputeWindow(m_fftWindow.data(), m_inBlockSize, BLACKMAN_HARRIS);
+	m_fftWindow = FftAnalysis::window(BLACKMAN_HARRIS, m_inBlockSize);
 
 	m_bufferL.resize(m_inBlockSize, 0);
 	m_bufferR.resize(m_inBlockSize, 0);
@@ -61,8 +60,6 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 	m_filteredBufferR.resize(m_fftBlockSize, 0);
 	m_spectrumL = (fftwf_complex *) fftwf_malloc(binCount() * sizeof (fftwf_complex));
 	m_spectrumR = (fftwf_complex *) fftwf_malloc(binCount() * sizeof (fftwf_complex));
-	m_fftPlanL = fftwf_plan_dft_r2c_1d(m_fftBlockSize, m_filteredBufferL.data(), m_spectrumL, FFTW_MEASURE);
-	m_fftPlanR = fftwf_plan_dft_r2c_1d(m_fftBlockSize, m_filteredBufferR.data(), m_spectrumR, FFTW_MEASURE);
 
 	m_absSpectrumL.resize(binCount(), 0);
 	m_absSpectrumR.resize(binCount(), 0);
@@ -77,29 +74,20 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 
 SaProcessor::~SaProcessor()
 {
-	if (m_fftPlanL != NULL) {fftwf_destroy_plan(m_fftPlanL);}
-	if (m_fftPlanR != NULL) {fftwf_destroy_plan(m_fftPlanR);}
 	if (m_spectrumL != NULL) {fftwf_free(m_spectrumL);}
 	if (m_spectrumR != NULL) {fftwf_free(m_spectrumR);}
 
-	m_fftPlanL = NULL;
-	m_fftPlanR = NULL;
 	m_spectrumL = NULL;
 	m_spectrumR = NULL;
 }
 
 
 // Load data from audio thread ringbuffer and run FFT analysis if buffer is full enough.
-void SaProcessor::analyze(LocklessRingBuffer<sampleFrame> &ring_buffer)
+// Returns once the ringbuffer is empty, FftAnalysis calls again on new data.
+void SaProcessor::analyze(LocklessRingBuffer<sampleFrame> &ring_buffer, LocklessRingBufferReader<sampleFrame> &reader)
 {
-	LocklessRingBufferReader<sampleFrame> reader(ring_buffer);
-
-	// Processing thread loop
-	while (!m_terminate)
+	while (!reader.empty())
 	{
-		// If there is nothing to read, wait for notification from the writing side.
-		if (reader.empty()) {reader.waitForData();}
-
 		// skip waterfall render if processing can't keep up with input
 		bool overload = ring_buffer.free() < ring_buffer.capacity() / 2;
 
@@ -169,14 +157,14 @@ void SaProcessor::analyze(LocklessRingBuffer<sampleFrame> &ring_buffer)
 
 				// Run FFT on left channel, convert the result to absolute magnitude
 				// spectrum and normalize it.
-				fftwf_execute(m_fftPlanL);
+				FftAnalysis::execute(m_fftBlockSize, m_filteredBufferL.data(), m_spectrumL);
 				absspec(m_spectrumL, m_absSpectrumL.data(), binCount());
 				normalize(m_absSpectrumL, m_normSpectrumL, m_inBlockSize);
 
 				// repeat analysis for right channel if stereo processing is enabled
 				if (stereo)
 				{
-					fftwf_execute(m_fftPlanR);
+					FftAnalysis::execute(m_fftBlockSize, m_filteredBufferR.data(), m_spectrumR);
 					absspec(m_spectrumR, m_absSpectrumR.data(), binCount());
 					normalize(m_absSpectrumR, m_normSpectrumR, m_inBlockSize);
 				}
@@ -311,7 +299,7 @@ void SaProcessor::analyze(LocklessRingBuffer<sampleFrame> &ring_buffer)
 				#endif
 			}	// frame filler and processing
 		}	// process if active
-	}	// thread loop end
+	}	// ringbuffer loop end
 }
 
 
@@ -395,30 +383,18 @@ void SaProcessor::reallocateBuffers()
 	QMutexLocker reloc_lock(&m_reallocationAccess);
 	QMutexLocker data_lock(&m_dataAccess);
 
-	// destroy old FFT plan and free the result buffer
-	if (m_fftPlanL != NULL) {fftwf_destroy_plan(m_fftPlanL);}
-	if (m_fftPlanR != NULL) {fftwf_destroy_plan(m_fftPlanR);}
+	// free the result buffer, FFT plans are shared and kept by FftAnalysis
 	if (m_spectrumL != NULL) {fftwf_free(m_spectrumL);}
 	if (m_spectrumR != NULL) {fftwf_free(m_spectrumR);}
 
-	// allocate new space, create new plan and resize containers
-	m_fftWindow.resize(new_in_size, 1.0);
-	precomputeWindow(m_fftWindow.data(), new_in_size, (FFT_WINDOWS) m_controls->m_windowModel.value());
+	// allocate new space and resize containers
+	m_fftWindow = FftAnalysis::window((FFT_WINDOWS) m_controls->m_windowModel.value(), new_in_size);
 	m_bufferL.resize(new_in_size, 0);
 	m_bufferR.resize(new_in_size, 0);
 	m_filteredBufferL.resize(new_fft_size, 0);
 	m_filteredBufferR.resize(new_fft_size, 0);
 	m_spectrumL = (fftwf_complex *) fftwf_malloc(new_bins * sizeof (fftwf_complex));
 	m_spectrumR = (fftwf_complex *) fftwf_malloc(new_bins * sizeof (fftwf_complex));
-	m_fftPlanL = fftwf_plan_dft_r2c_1d(new_fft_size, m_filteredBufferL.data(), m_spectrumL, FFTW_MEASURE);
-	m_fftPlanR = fftwf_plan_dft_r2c_1d(new_fft_size, m_filteredBufferR.data(), m_spectrumR, FFTW_MEASURE);
-
-	if (m_fftPlanL == NULL || m_fftPlanR == NULL)
-	{
-		#ifdef SA_DEBUG
-			std::cerr << "Analyzer: failed to create new FFT plan!" << std::endl;
-		#endif
-	}
 	m_absSpectrumL.resize(new_bins, 0);
 	m_absSpectrumR.resize(new_bins, 0);
 	m_normSpectrumL.resize(new_bins, 0);
@@ -447,9 +423,9 @@ void SaProcessor::reallocateBuffers()
 // Precompute a new FFT window based on currently selected type.
 void SaProcessor::rebuildWindow()
 {
-	// computation is done in fft_helpers
+	// computation is done in fft_helpers, the table is shared by FftAnalysis
 	QMutexLocker lock(&m_dataAccess);
-	precomputeWindow(m_fftWindow.data(), m_inBlockSize, (FFT_WINDOWS) m_controls->m_windowModel.value());
+	m_fftWindow = FftAnalysis::window((FFT_WINDOWS) m_controls->m_windowModel.value(), m_inBlockSize);
 }
 
 
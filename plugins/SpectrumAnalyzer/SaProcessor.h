@@ -37,6 +37,8 @@
 
 template<class T>
 class LocklessRingBuffer;
+template<class T>
+class LocklessRingBufferReader;
 
 //! Receives audio data, runs FFT analysis and stores the result.
 class SaProcessor
@@ -45,9 +47,8 @@ public:
 	explicit SaProcessor(const SaControls *controls);
 	virtual ~SaProcessor();
 
-	// analysis thread and a method to terminate it
-	void analyze(LocklessRingBuffer<sampleFrame> &ring_buffer);
-	void terminate() {m_terminate = true;}
+	// analyze everything waiting in the ringbuffer; runs on an FftAnalysis thread
+	void analyze(LocklessRingBuffer<sampleFrame> &ring_buffer, LocklessRingBufferReader<sampleFrame> &reader);
 
 	// inform processor if any processing is actually required
 	void setSpectrumActive(bool active);
@@ -107,9 +108,6 @@ public:
 private:
 	const SaControls *m_controls;
 
-	// thread communication and control
-	bool m_terminate;
-
 	// currently valid configuration
 	unsigned int m_zeroPadFactor = 2;		//!< use n-steps bigger FFT for given block size
 	std::atomic<unsigned int> m_inBlockSize;//!< size of input (time domain) data block
@@ -120,11 +118,9 @@ private:
 	unsigned int m_framesFilledUp;
 	std::vector<float> m_bufferL;			//!< time domain samples (left)
 	std::vector<float> m_bufferR;			//!< time domain samples (right)
-	std::vector<float> m_fftWindow;			//!< precomputed window function coefficients
+	const float *m_fftWindow;				//!< precomputed window function coefficients (shared)
 	std::vector<float> m_filteredBufferL;	//!< time domain samples with window function applied (left)
 	std::vector<float> m_filteredBufferR;	//!< time domain samples with window function applied (right)
-	fftwf_plan m_fftPlanL;
-	fftwf_plan m_fftPlanR;
 	fftwf_complex *m_spectrumL;				//!< frequency domain samples (complex) (left)
 	fftwf_complex *m_spectrumR;				//!< frequency domain samples (complex) (right)
 	std::vector<float> m_absSpectrumL;		//!< frequency domain samples (absolute) (left)
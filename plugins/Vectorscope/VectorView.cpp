@@ -33,12 +33,12 @@
 #include "MainWindow.h"
 
 
-VectorView::VectorView(VecControls *controls, LocklessRingBuffer<sampleFrame> *inputBuffer, unsigned short displaySize, QWidget *parent) :
+VectorView::VectorView(VecControls *controls, VisualizationTap *tap, unsigned short displaySize, QWidget *parent) :
 	QWidget(parent),
 	m_controls(controls),
-	m_inputBuffer(inputBuffer),
-	m_bufferReader(*inputBuffer),
+	m_tap(tap),
 	m_displaySize(displaySize),
+	m_visible(false),
 	m_zoom(1.f),
 	m_persistTimestamp(0),
 	m_zoomTimestamp(0),
@@ -59,6 +59,12 @@ VectorView::VectorView(VecControls *controls, LocklessRingBuffer<sampleFrame> *i
 }
 
 
+VectorView::~VectorView()
+{
+	if (m_visible) {m_tap->detach();}
+}
+
+
 // Compose and draw all the content; called by Qt.
 void VectorView::paintEvent(QPaintEvent *event)
 {
@@ -129,9 +135,10 @@ void VectorView::paintEvent(QPaintEvent *event)
 		}
 	}
 
-	// Get new samples from the lockless input FIFO buffer
-	auto inBuffer = m_bufferReader.read_max(m_inputBuffer->capacity());
-	std::size_t frameCount = inBuffer.size();
+	// Get the points collected since the last frame from the tap
+	const VisualizationTap::Snapshot *snapshot = m_tap->read();
+	const sampleFrame *inBuffer = snapshot ? snapshot->first : nullptr;
+	std::size_t frameCount = snapshot ? snapshot->points : 0;
 
 	// Draw new points on top
 	float left, right;
@@ -291,10 +298,17 @@ void VectorView::paintEvent(QPaintEvent *event)
 }
 
 
-// Periodically trigger repaint and check if the widget is visible
+// Periodically trigger repaint and check if the widget is visible.
+// The tap only collects data while the widget is attached to it.
 void VectorView::periodicUpdate()
 {
-	m_visible = isVisible();
+	const bool visible = isVisible();
+	if (visible != m_visible)
+	{
+		if (visible) {m_tap->attach();}
+		else {m_tap->detach();}
+		m_visible = visible;
+	}
 	if (m_visible) {update();}
 }
 
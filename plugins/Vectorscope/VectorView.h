@@ -29,8 +29,8 @@
 
 #include "Knob.h"
 #include "LedCheckbox.h"
-#include "LocklessRingBuffer.h"
 #include "VecControls.h"
+#include "VisualizationTap.h"
 
 //#define VEC_DEBUG
 
@@ -40,8 +40,8 @@ class VectorView : public QWidget
 {
 	Q_OBJECT
 public:
-	explicit VectorView(VecControls *controls, LocklessRingBuffer<sampleFrame> *inputBuffer, unsigned short displaySize, QWidget *parent = 0);
-	virtual ~VectorView() {}
+	explicit VectorView(VecControls *controls, VisualizationTap *tap, unsigned short displaySize, QWidget *parent = 0);
+	virtual ~VectorView();
 
 	QSize sizeHint() const override {return QSize(300, 300);}
 
@@ -56,8 +56,7 @@ private slots:
 private:
 	VecControls *m_controls;
 
-	LocklessRingBuffer<sampleFrame> *m_inputBuffer;
-	LocklessRingBufferReader<sampleFrame> m_bufferReader;
+	VisualizationTap *m_tap;
 
 	std::vector<uchar> m_displayBuffer;
 	const unsigned short m_displaySize;
@@ -24,7 +24,11 @@
 
 #include "Vectorscope.h"
 
+#include <algorithm>
+
 #include "embed.h"
+#include "Engine.h"
+#include "Mixer.h"
 #include "plugin_export.h"
 
 
@@ -47,9 +51,7 @@ extern "C" {
 Vectorscope::Vectorscope(Model *parent, const Plugin::Descriptor::SubPluginFeatures::Key *key) :
 	Effect(&vectorscope_plugin_descriptor, parent, key),
 	m_controls(this),
-	// Buffer is sized to cover 4* the current maximum LMMS audio buffer size,
-	// so that it has some reserve space in case GUI thresd is busy.
-	m_inputBuffer(4 * m_maxBufferSize)
+	m_tap(VisualizationTap::MaxPoints)
 {
 }
 
@@ -59,13 +61,12 @@ bool Vectorscope::processAudioBuffer(sampleFrame *buffer, const fpp_t frame_coun
 {
 	if (!isEnabled() || !isRunning ()) {return false;}
 
-	// Skip processing if the controls dialog isn't visible, it would only waste CPU cycles.
-	if (m_controls.isViewVisible())
-	{
-		// To avoid processing spikes on audio thread, data are stored in
-		// a lockless ringbuffer and processed in a separate thread.
-		m_inputBuffer.write(buffer, frame_count);
-	}
+	// The tap skips everything while no view is attached, otherwise it collects
+	// points until the GUI thread takes them. Above 48 kHz only every n-th frame
+	// is plotted; the picture barely changes and it saves a lot of drawing.
+	const unsigned int stride = std::max(1u, Engine::mixer()->processingSampleRate() / m_maxPointRate);
+	m_tap.setPoints((frame_count + stride - 1) / stride);
+	m_tap.write(buffer, frame_count, true);
 	return isRunning();
 }
 
@@ -25,8 +25,8 @@
 #define VECTORSCOPE_H
 
 #include "Effect.h"
-#include "LocklessRingBuffer.h"
 #include "VecControls.h"
+#include "VisualizationTap.h"
 
 
 //! Top level class; handles LMMS interface and accumulates data for processing.
@@ -38,14 +38,14 @@ public:
 
 	bool processAudioBuffer(sampleFrame *buffer, const fpp_t frame_count) override;
 	EffectControls *controls() override {return &m_controls;}
-	LocklessRingBuffer<sampleFrame> *getBuffer() {return &m_inputBuffer;}
+	VisualizationTap *getTap() {return &m_tap;}
 
 private:
 	VecControls m_controls;
 
-	// Maximum LMMS buffer size (hard coded, the actual constant is hard to get)
-	const unsigned int m_maxBufferSize = 4096;
-	LocklessRingBuffer<sampleFrame> m_inputBuffer;
+	// Points plotted per second at most; higher sample rates are decimated.
+	const unsigned int m_maxPointRate = 48000;
+	VisualizationTap m_tap;
 };
 
 #endif // VECTORSCOPE_H
@@ -26,7 +26,10 @@
 
 #include "VstEffect.h"
 
+#include "BufferManager.h"
+#include "ConfigManager.h"
 #include "GuiApplication.h"
+#include "PlanarBuffer.h"
 #include "Song.h"
 #include "TextFloat.h"
 #include "VstSubPluginFeatures.h"
@@ -59,6 +62,7 @@ VstEffect::VstEffect( Model * _parent,
 	Effect( &vsteffect_plugin_descriptor, _parent, _key ),
 	m_pluginMutex(),
 	m_key( *_key ),
+	m_wetBuffer( BufferManager::acquirePlanar() ),
 	m_vstControls( this )
 {
 	if( !m_key.attributes["file"].isEmpty() )
@@ -74,6 +78,7 @@ VstEffect::VstEffect( Model * _parent,
 
 VstEffect::~VstEffect()
 {
+	BufferManager::release( m_wetBuffer );
 }
 
 
@@ -101,22 +106,17 @@ bool VstEffect::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames )
 			m_pluginMutex.unlock();
 		}
 
-		double out_sum = 0.0;
 		const float w = wetLevel();
 		for( fpp_t f = 0; f < _frames; ++f )
 		{
 			_buf[f][0] = w*buf[f][0] + d*_buf[f][0];
 			_buf[f][1] = w*buf[f][1] + d*_buf[f][1];
 		}
-		for( fpp_t f = 0; f < _frames; ++f )
-		{
-			out_sum += _buf[f][0]*_buf[f][0] + _buf[f][1]*_buf[f][1];
-		}
 #ifndef __GNUC__
 		delete[] buf;
 #endif
 
-		checkGate( out_sum / _frames );
+		checkGate( _buf, _frames );
 	}
 	return isRunning();
 }
@@ -124,6 +124,69 @@ bool VstEffect::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames )
 
 
 
+bool VstEffect::processPlanarBuffer( PlanarBuffer & _buf, const fpp_t _frames )
+{
+	if( !isEnabled() || !isRunning () )
+	{
+		return false;
+	}
+
+	if( m_plugin )
+	{
+		const float d = dryLevel();
+		const float w = wetLevel();
+		// with nothing of the dry signal to keep, the output of the
+		// plugin goes right into the channels of the chain
+		const bool inPlace = d == 0.0f && w == 1.0f;
+		if( !m_pluginMutex.tryLock(
+				Engine::getSong()->isExporting() ? -1 : 0 ) )
+		{
+			return isRunning();
+		}
+		m_plugin->processPlanar( &_buf, inPlace ? &_buf : m_wetBuffer );
+		m_pluginMutex.unlock();
+
+		double outSum = 0.0;
+		for( ch_cnt_t ch = 0; ch < _buf.channels(); ++ch )
+		{
+			sample_t * channel = _buf.channel( ch );
+			if( !inPlace )
+			{
+				const sample_t * wet = m_wetBuffer->channel( ch );
+				for( fpp_t f = 0; f < _frames; ++f )
+				{
+					channel[f] = w * wet[f] + d * channel[f];
+				}
+			}
+			for( fpp_t f = 0; f < _frames; ++f )
+			{
+				outSum += channel[f] * channel[f];
+			}
+		}
+		checkGate( outSum / _frames );
+	}
+	return isRunning();
+}
+
+
+
+
+f_cnt_t VstEffect::latency() const
+{
+	return m_plugin ? m_plugin->initialDelay() + m_plugin->latency() : 0;
+}
+
+
+
+
+RemotePlugin * VstEffect::remotePlugin() const
+{
+	return m_plugin.data();
+}
+
+
+
+
 void VstEffect::openPlugin( const QString & _plugin )
 {
 	TextFloat * tf = NULL;
@@ -144,6 +207,8 @@ void VstEffect::openPlugin( const QString & _plugin )
 		collectErrorForUI( VstPlugin::tr( "The VST plugin %1 could not be loaded." ).arg( _plugin ) );
 		return;
 	}
+	m_plugin->setAsyncProcessing( ConfigManager::inst()->value(
+					"mixer", "asyncremoteplugins" ).toInt() );
 
 	delete tf;
 
@@ -44,6 +44,18 @@ public:
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 							const fpp_t _frames );
 
+	// the plugin works on separate channels, which are copied to and from
+	// the shared memory as a whole
+	bool prefersPlanar() const override
+	{
+		return true;
+	}
+
+	bool processPlanarBuffer( PlanarBuffer & _buf,
+					const fpp_t _frames ) override;
+
+	f_cnt_t latency() const override;
+
 	virtual EffectControls * controls()
 	{
 		return &m_vstControls;
@@ -54,6 +66,8 @@ public:
 		return m_plugin->name();
 	}
 
+	RemotePlugin * remotePlugin() const override;
+
 
 private:
 	void openPlugin( const QString & _plugin );
@@ -62,6 +76,8 @@ private:
 	QSharedPointer<VstPlugin> m_plugin;
 	QMutex m_pluginMutex;
 	EffectKey m_key;
+	// the output of the plugin, unless it replaces the signal completely
+	PlanarBuffer * m_wetBuffer;
 
 	VstEffectControls m_vstControls;
 
@@ -25,6 +25,7 @@
 
 #include "ExprSynth.h"
 
+#include <iterator>
 #include <string>
 #include <vector>
 #include <math.h>
@@ -113,6 +114,13 @@ struct IntegrateFunction : public exprtk::ifunction<T>
 		m_cc = (m_cc + 1) % m_nCountersCalls;
 		return res / m_sample_rate;
 	}
+	void reset()
+	{
+		clearArray(m_counters,m_max_counters);
+		m_nCounters = 0;
+		m_nCountersCalls = 0;
+		m_cc = 0;
+	}
 
 	const unsigned int* const m_frame;
 	const unsigned int m_sample_rate;
@@ -168,6 +176,11 @@ struct LastSampleFunction : public exprtk::ifunction<T>
 			--m_pivot_last;
 		}
 	}
+	void reset()
+	{
+		clearArray(m_samples, m_history_size);
+		m_pivot_last = m_history_size - 1;
+	}
 	unsigned int m_history_size;
 	unsigned int m_pivot_last;
 	T *m_samples;
@@ -348,7 +361,7 @@ struct RandomVectorFunction : public exprtk::ifunction<float>
 		return RandomVectorSeedFunction::randv(index,m_rseed);
 	}
 
-	const unsigned int m_rseed;
+	unsigned int m_rseed;
 };
 
 namespace SimpleRandom {
@@ -370,6 +383,7 @@ class ExprFrontData
 public:
 	ExprFrontData(int last_func_samples):
 	m_rand_vec(SimpleRandom::generator()),
+	m_seed(0),
 	m_integ_func(NULL),
 	m_last_func(last_func_samples)
 	{}
@@ -395,6 +409,7 @@ public:
 	std::vector<WaveValueFunction<float>* > m_cyclics;
 	std::vector<WaveValueFunctionInterpolate<float>* > m_cyclics_interp;
 	RandomVectorFunction m_rand_vec;
+	float m_seed;
 	IntegrateFunction<float> *m_integ_func;
 	LastSampleFunction<float> m_last_func;
 
@@ -530,7 +545,9 @@ ExprFront::ExprFront(const char * expr, int last_func_samples)
 	
 		m_data->m_symbol_table.add_constant("e", F_E);
 
-		m_data->m_symbol_table.add_constant("seed", SimpleRandom::generator() & max_float_integer_mask);
+		// a variable, so compiled expressions can get a new seed per note
+		m_data->m_seed = SimpleRandom::generator() & max_float_integer_mask;
+		m_data->m_symbol_table.add_variable("seed", m_data->m_seed);
 	
 		m_data->m_symbol_table.add_function("sinew", sin_wave_func);
 		m_data->m_symbol_table.add_function("squarew", square_wave_func);
@@ -668,6 +685,17 @@ size_t find_occurances(const std::string& haystack, const char* const needle)
 	return count;
 }
 
+void ExprFront::reset()
+{
+	m_data->m_rand_vec.m_rseed = SimpleRandom::generator();
+	m_data->m_seed = SimpleRandom::generator() & max_float_integer_mask;
+	m_data->m_last_func.reset();
+	if (m_data->m_integ_func)
+	{
+		m_data->m_integ_func->reset();
+	}
+}
+
 void ExprFront::setIntegrate(const unsigned int* const frameCounter, const unsigned int sample_rate)
 {
 	if (m_data->m_integ_func == NULL)
@@ -688,63 +716,134 @@ void ExprFront::setIntegrate(const unsigned int* const frameCounter, const unsig
 	}
 }
 
-ExprSynth::ExprSynth(const WaveSample *gW1, const WaveSample *gW2, const WaveSample *gW3,
-	ExprFront *exprO1, ExprFront *exprO2,
-	NotePlayHandle *nph, const sample_rate_t sample_rate,
-	const FloatModel* pan1, const FloatModel* pan2, float rel_trans):
-	m_exprO1(exprO1),
-	m_exprO2(exprO2),
-	m_W1(gW1),
-	m_W2(gW2),
-	m_W3(gW3),
-	m_nph(nph),
-	m_sample_rate(sample_rate),
-	m_pan1(pan1),
-	m_pan2(pan2),
-	m_rel_transition(rel_trans)
+bool ExprVoiceKey::operator==(const ExprVoiceKey & other) const
 {
-	m_note_sample = 0;
-	m_note_rel_sample = 0;
-	m_note_rel_sec = 0;
-	m_note_sample_sec = 0;
-	m_released = 0;
-	m_frequency = m_nph->frequency();
-	m_rel_inc = 1000.0 / (m_sample_rate * m_rel_transition);//rel_transition in ms. compute how much increment in each frame
+	return key == other.key && bnote == other.bnote && srate == other.srate &&
+		v == other.v && tempo == other.tempo &&
+		interpolate[0] == other.interpolate[0] &&
+		interpolate[1] == other.interpolate[1] &&
+		interpolate[2] == other.interpolate[2] &&
+		o1 == other.o1 && o2 == other.o2;
+}
 
-	auto init_expression_step2 = [this](ExprFront * e) {
-		e->add_cyclic_vector("W1", m_W1->m_samples,m_W1->m_length, m_W1->m_interpolate);
-		e->add_cyclic_vector("W2", m_W2->m_samples,m_W2->m_length, m_W2->m_interpolate);
-		e->add_cyclic_vector("W3", m_W3->m_samples,m_W3->m_length, m_W3->m_interpolate);
+ExprVoice::ExprVoice(const ExprVoiceKey & key, ExprFront *exprO1, ExprFront *exprO2,
+	const WaveSample *gW1, const WaveSample *gW2, const WaveSample *gW3,
+	const sample_rate_t sample_rate):
+	m_key(key),
+	m_exprO1(exprO1),
+	m_exprO2(exprO2),
+	m_note_sample(0),
+	m_note_sample_sec(0),
+	m_note_rel_sec(0),
+	m_frequency(0),
+	m_released(0)
+{
+	auto init_expression_step2 = [&](ExprFront * e) {
+		e->add_cyclic_vector("W1", gW1->m_samples,gW1->m_length, key.interpolate[0]);
+		e->add_cyclic_vector("W2", gW2->m_samples,gW2->m_length, key.interpolate[1]);
+		e->add_cyclic_vector("W3", gW3->m_samples,gW3->m_length, key.interpolate[2]);
 		e->add_variable("t", m_note_sample_sec);
 		e->add_variable("f", m_frequency);
 		e->add_variable("rel",m_released);
 		e->add_variable("trel",m_note_rel_sec);
-		e->setIntegrate(&m_note_sample,m_sample_rate);
+		e->setIntegrate(&m_note_sample,sample_rate);
 		e->compile();
 	};
 	init_expression_step2(m_exprO1);
 	init_expression_step2(m_exprO2);
+}
 
+ExprVoice::~ExprVoice()
+{
+	delete m_exprO1;
+	delete m_exprO2;
 }
 
-ExprSynth::~ExprSynth()
+void ExprVoice::reset()
 {
-	if (m_exprO1)
+	m_exprO1->reset();
+	m_exprO2->reset();
+	m_note_sample = 0;
+	m_note_sample_sec = 0;
+	m_note_rel_sec = 0;
+	m_frequency = 0;
+	m_released = 0;
+}
+
+const int ExprVoiceCache::MaxIdleVoices;
+
+ExprVoiceCache::ExprVoiceCache()
+{
+	m_idle.reserve(MaxIdleVoices + 1);
+}
+
+ExprVoiceCache::~ExprVoiceCache()
+{
+	for (ExprVoice * voice : m_idle)
 	{
-		delete m_exprO1;
+		delete voice;
 	}
-	if (m_exprO2)
+}
+
+ExprVoice* ExprVoiceCache::take(const ExprVoiceKey & key)
+{
+	QMutexLocker lock(&m_mutex);
+	for (auto it = m_idle.rbegin(); it != m_idle.rend(); ++it)
 	{
-		delete m_exprO2;
+		if ((*it)->m_key == key)
+		{
+			ExprVoice * voice = *it;
+			m_idle.erase(std::next(it).base());
+			return voice;
+		}
+	}
+	return NULL;
+}
+
+void ExprVoiceCache::give(ExprVoice* voice)
+{
+	voice->reset();
+	ExprVoice * dropped = NULL;
+	{
+		QMutexLocker lock(&m_mutex);
+		m_idle.push_back(voice);
+		if (m_idle.size() > static_cast<size_t>(MaxIdleVoices))
+		{
+			dropped = m_idle.front();
+			m_idle.erase(m_idle.begin());
+		}
 	}
+	// freeing the expressions takes a while, not while the lock is held
+	delete dropped;
+}
+
+ExprSynth::ExprSynth(ExprVoice *voice, ExprVoiceCache *cache,
+	NotePlayHandle *nph, const sample_rate_t sample_rate,
+	const FloatModel* pan1, const FloatModel* pan2, float rel_trans):
+	m_voice(voice),
+	m_cache(cache),
+	m_nph(nph),
+	m_sample_rate(sample_rate),
+	m_pan1(pan1),
+	m_pan2(pan2),
+	m_rel_transition(rel_trans)
+{
+	m_note_rel_sample = 0;
+	m_voice->m_frequency = m_nph->frequency();
+	m_rel_inc = 1000.0 / (m_sample_rate * m_rel_transition);//rel_transition in ms. compute how much increment in each frame
+}
+
+ExprSynth::~ExprSynth()
+{
+	m_cache->give(m_voice);
 }
 
 void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 {
 	try
 	{
-		bool o1_valid = m_exprO1->isValid();
-		bool o2_valid = m_exprO2->isValid();
+		bool o1_valid = m_voice->m_exprO1->isValid();
+		bool o2_valid = m_voice->m_exprO2->isValid();
 		if (!o1_valid && !o2_valid)
 		{
 			return;
@@ -753,24 +852,24 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 		float pn1 = m_pan1->value() * 0.5;
 		float pn2 = m_pan2->value() * 0.5;
 		const float new_freq = m_nph->frequency();
-		const float freq_inc = (new_freq - m_frequency) / frames;
+		const float freq_inc = (new_freq - m_voice->m_frequency) / frames;
 		const bool is_released = m_nph->isReleased();
 	
-		expression_t *o1_rawExpr = &(m_exprO1->getData()->m_expression);
-		expression_t *o2_rawExpr = &(m_exprO2->getData()->m_expression);
-		LastSampleFunction<float> * last_func1 = &m_exprO1->getData()->m_last_func;
-		LastSampleFunction<float> * last_func2 = &m_exprO2->getData()->m_last_func;
+		expression_t *o1_rawExpr = &(m_voice->m_exprO1->getData()->m_expression);
+		expression_t *o2_rawExpr = &(m_voice->m_exprO2->getData()->m_expression);
+		LastSampleFunction<float> * last_func1 = &m_voice->m_exprO1->getData()->m_last_func;
+		LastSampleFunction<float> * last_func2 = &m_voice->m_exprO2->getData()->m_last_func;
 		if (is_released && m_note_rel_sample == 0)
 		{
-			m_note_rel_sample = m_note_sample;
+			m_note_rel_sample = m_voice->m_note_sample;
 		}
 		if (o1_valid && o2_valid)
 		{
 			for (fpp_t frame = 0; frame < frames ; ++frame)
 			{
-				if (is_released && m_released < 1)
+				if (is_released && m_voice->m_released < 1)
 				{
-					m_released = fmin(m_released+m_rel_inc, 1);
+					m_voice->m_released = fmin(m_voice->m_released+m_rel_inc, 1);
 				}
 				o1 = o1_rawExpr->value();
 				o2 = o2_rawExpr->value();
@@ -778,13 +877,13 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 				last_func2->setLastSample(o2);
 				buf[frame][0] = (-pn1 + 0.5) * o1 + (-pn2 + 0.5) * o2;
 				buf[frame][1] = ( pn1 + 0.5) * o1 + ( pn2 + 0.5) * o2;
-				m_note_sample++;
-				m_note_sample_sec = m_note_sample / (float)m_sample_rate;
+				m_voice->m_note_sample++;
+				m_voice->m_note_sample_sec = m_voice->m_note_sample / (float)m_sample_rate;
 				if (is_released)
 				{
-					m_note_rel_sec = (m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
+					m_voice->m_note_rel_sec = (m_voice->m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
 				}
-				m_frequency += freq_inc;
+				m_voice->m_frequency += freq_inc;
 			}
 		}
 		else
@@ -798,24 +897,24 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 			}
 			for (fpp_t frame = 0; frame < frames ; ++frame)
 			{
-				if (is_released && m_released < 1)
+				if (is_released && m_voice->m_released < 1)
 				{
-					m_released = fmin(m_released+m_rel_inc, 1);
+					m_voice->m_released = fmin(m_voice->m_released+m_rel_inc, 1);
 				}
 				o1 = o1_rawExpr->value();
 				last_func1->setLastSample(o1);
 				buf[frame][0] = (-pn1 + 0.5) * o1;
 				buf[frame][1] = ( pn1 + 0.5) * o1;
-				m_note_sample++;
-				m_note_sample_sec = m_note_sample / (float)m_sample_rate;
+				m_voice->m_note_sample++;
+				m_voice->m_note_sample_sec = m_voice->m_note_sample / (float)m_sample_rate;
 				if (is_released)
 				{
-					m_note_rel_sec = (m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
+					m_voice->m_note_rel_sec = (m_voice->m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
 				}
-				m_frequency += freq_inc;
+				m_voice->m_frequency += freq_inc;
 			}
 		}
-		m_frequency = new_freq;
+		m_voice->m_frequency = new_freq;
 	}
 	catch(...)
 	{
@@ -28,6 +28,9 @@
 #include <cmath>
 #include <cstddef>
 #include <limits>
+#include <vector>
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
 #include "AutomatableModel.h"
 #include "Graph.h"
 #include "Instrument.h"
@@ -49,6 +52,9 @@ public:
 	bool add_constant(const char* name, float  ref);
 	bool add_cyclic_vector(const char* name, const float* data, size_t length, bool interp = false);
 	void setIntegrate(const unsigned int* frameCounter, unsigned int sample_rate);
+	//! Forgets the history of the last note, so the compiled expression
+	//! can play another one. Also picks a new random seed.
+	void reset();
 	ExprFrontData* getData() { return m_data; }
 private:
 	ExprFrontData *m_data;
@@ -88,11 +94,81 @@ public:
 	bool m_interpolate;
 };
 
+//! What the output expressions of a note are compiled with. The note
+//! constants are compiled into the expressions, so exprtk folds everything
+//! which only depends on them.
+struct ExprVoiceKey
+{
+	QByteArray o1;
+	QByteArray o2;
+	float key;
+	float bnote;
+	float srate;
+	float v;
+	float tempo;
+	bool interpolate[3];
+
+	bool operator==(const ExprVoiceKey & other) const;
+};
+
+//! The compiled output expressions of a note, with the variables they're
+//! bound to
+class ExprVoice
+{
+	MM_OPERATORS
+public:
+	ExprVoice(const ExprVoiceKey & key, ExprFront* exprO1, ExprFront* exprO2,
+			const WaveSample* gW1, const WaveSample* gW2, const WaveSample* gW3,
+			const sample_rate_t sample_rate);
+	~ExprVoice();
+
+	//! Prepares the voice for the next note
+	void reset();
+
+	const ExprVoiceKey m_key;
+	ExprFront *m_exprO1, *m_exprO2;
+	unsigned int m_note_sample;
+	float m_note_sample_sec;
+	float m_note_rel_sec;
+	float m_frequency;
+	float m_released;
+} ;
+
+/*! \brief The voices of an instrument whose notes ended, for notes played
+ *  with the same expressions and constants
+ *
+ *  Compiling the expressions takes much longer than playing a note of a
+ *  drum pattern, so they're only compiled for a note if no voice was
+ *  compiled for the same key, volume and expressions before. A changed
+ *  expression doesn't match the voices kept, which are pushed out by new
+ *  ones over time.
+ */
+class ExprVoiceCache
+{
+public:
+	static const int MaxIdleVoices = 32;
+
+	ExprVoiceCache();
+	~ExprVoiceCache();
+
+	//! A voice compiled for @p key, or nullptr if there's none
+	ExprVoice* take(const ExprVoiceKey & key);
+
+	//! Keeps the voice of a note which ended
+	void give(ExprVoice* voice);
+
+private:
+	QMutex m_mutex;
+	// the most recently used last
+	std::vector<ExprVoice*> m_idle;
+
+} ;
+
 class ExprSynth
 {
 	MM_OPERATORS
 public:
-	ExprSynth(const WaveSample* gW1, const WaveSample* gW2, const WaveSample* gW3, ExprFront* exprO1, ExprFront* exprO2, NotePlayHandle* nph,
+	ExprSynth(ExprVoice* voice, ExprVoiceCache* cache, NotePlayHandle* nph,
 			const sample_rate_t sample_rate, const FloatModel* pan1, const FloatModel* pan2, float rel_trans);
 	virtual ~ExprSynth();
 
@@ -100,14 +176,9 @@ public:
 
 
 private:
-	ExprFront *m_exprO1, *m_exprO2;
-	const WaveSample *m_W1, *m_W2, *m_W3;
-	unsigned int m_note_sample;
+	ExprVoice *m_voice;
+	ExprVoiceCache *m_cache;
 	unsigned int m_note_rel_sample;
-	float m_note_sample_sec;
-	float m_note_rel_sec;
-	float m_frequency;
-	float m_released;
 	NotePlayHandle* m_nph;
 	const sample_rate_t m_sample_rate;
 	const FloatModel *m_pan1,*m_pan2;
@@ -204,27 +204,43 @@ void Xpressive::playNote(NotePlayHandle* nph, sampleFrame* working_buffer) {
 
 	if (nph->totalFramesPlayed() == 0 || nph->m_pluginData == NULL) {
 
-		ExprFront *exprO1 = new ExprFront(m_outputExpression[0].constData(),Engine::mixer()->processingSampleRate());//give the "last" function a whole second
-		ExprFront *exprO2 = new ExprFront(m_outputExpression[1].constData(),Engine::mixer()->processingSampleRate());
-
-		auto init_expression_step1 = [this, nph](ExprFront* e) { //lambda function to init exprO1 and exprO2
-			//add the constants and the variables to the expression.
-			e->add_constant("key", nph->key());//the key that was pressed.
-			e->add_constant("bnote", nph->instrumentTrack()->baseNote()); // the base note
-			e->add_constant("srate", Engine::mixer()->processingSampleRate());// sample rate of the mixer
-			e->add_constant("v", nph->getVolume() / 255.0); //volume of the note.
-			e->add_constant("tempo", Engine::getSong()->getTempo());//tempo of the song.
-			e->add_variable("A1", m_A1);//A1,A2,A3: general purpose input controls.
-			e->add_variable("A2", m_A2);
-			e->add_variable("A3", m_A3);
-		};
-		init_expression_step1(exprO1);
-		init_expression_step1(exprO2);
-
-		m_W1.setInterpolate(m_interpolateW1.value());//set interpolation according to the user selection.
-		m_W2.setInterpolate(m_interpolateW2.value());
-		m_W3.setInterpolate(m_interpolateW3.value());
-		nph->m_pluginData = new ExprSynth(&m_W1, &m_W2, &m_W3, exprO1, exprO2, nph,
+		ExprVoiceKey key;
+		key.o1 = m_outputExpression[0];
+		key.o2 = m_outputExpression[1];
+		key.key = nph->key();//the key that was pressed.
+		key.bnote = nph->instrumentTrack()->baseNote(); // the base note
+		key.srate = Engine::mixer()->processingSampleRate();// sample rate of the mixer
+		key.v = nph->getVolume() / 255.0; //volume of the note.
+		key.tempo = Engine::getSong()->getTempo();//tempo of the song.
+		key.interpolate[0] = m_interpolateW1.value();//set interpolation according to the user selection.
+		key.interpolate[1] = m_interpolateW2.value();
+		key.interpolate[2] = m_interpolateW3.value();
+
+		// the expressions are only compiled if no note was played with
+		// the same constants before
+		ExprVoice *voice = m_voiceCache.take(key);
+		if (voice == NULL) {
+			ExprFront *exprO1 = new ExprFront(key.o1.constData(),key.srate);//give the "last" function a whole second
+			ExprFront *exprO2 = new ExprFront(key.o2.constData(),key.srate);
+
+			auto init_expression_step1 = [this, &key](ExprFront* e) { //lambda function to init exprO1 and exprO2
+				//add the constants and the variables to the expression.
+				e->add_constant("key", key.key);
+				e->add_constant("bnote", key.bnote);
+				e->add_constant("srate", key.srate);
+				e->add_constant("v", key.v);
+				e->add_constant("tempo", key.tempo);
+				e->add_variable("A1", m_A1);//A1,A2,A3: general purpose input controls.
+				e->add_variable("A2", m_A2);
+				e->add_variable("A3", m_A3);
+			};
+			init_expression_step1(exprO1);
+			init_expression_step1(exprO2);
+
+			voice = new ExprVoice(key, exprO1, exprO2, &m_W1, &m_W2, &m_W3,
+					Engine::mixer()->processingSampleRate());
+		}
+		nph->m_pluginData = new ExprSynth(voice, &m_voiceCache, nph,
 				Engine::mixer()->processingSampleRate(), &m_panning1, &m_panning2, m_relTransition.value());
 	}
 
@@ -133,6 +133,7 @@ private:
 	FloatModel m_relTransition;
 	float m_A1,m_A2,m_A3;
 	WaveSample m_W1, m_W2, m_W3;
+	ExprVoiceCache m_voiceCache;
 
 	BoolModel m_exprValid;
 	
@@ -106,6 +106,9 @@ audioFileProcessor::audioFileProcessor( InstrumentTrack * _instrument_track ) :
 	m_interpolationModel.addItem( tr( "Sinc" ) );
 	m_interpolationModel.setValue( 1 );
 
+	// the sample is only played and drawn, so it can be kept compressed
+	m_sampleBuffer.setCompressible( true );
+
 	pointChanged();
 }
 
@@ -215,9 +218,7 @@ void audioFileProcessor::saveSettings( QDomDocument & _doc,
 	_this.setAttribute( "src", m_sampleBuffer.audioFile() );
 	if( m_sampleBuffer.audioFile() == "" )
 	{
-		QString s;
-		_this.setAttribute( "sampledata",
-						m_sampleBuffer.toBase64( s ) );
+		m_sampleBuffer.saveEmbedded( _this, "sampledata" );
 	}
 	m_reverseModel.saveSettings( _doc, _this, "reversed" );
 	m_loopModel.saveSettings( _doc, _this, "looped" );
@@ -247,9 +248,9 @@ void audioFileProcessor::loadSettings( const QDomElement & _this )
 			Engine::getSong()->collectError( message );
 		}
 	}
-	else if( _this.attribute( "sampledata" ) != "" )
+	else
 	{
-		m_sampleBuffer.loadFromBase64( _this.attribute( "srcdata" ) );
+		m_sampleBuffer.loadEmbedded( _this, "sampledata" );
 	}
 
 	m_loopModel.loadSettings( _this, "looped" );
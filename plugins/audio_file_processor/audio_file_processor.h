@@ -59,6 +59,11 @@ public:
 
 	virtual int getBeatLen( NotePlayHandle * _n ) const;
 
+	qint64 memoryUsage() const override
+	{
+		return m_sampleBuffer.memoryUsage();
+	}
+
 	virtual f_cnt_t desiredReleaseFrames() const
 	{
 		return 128;
@@ -275,8 +275,7 @@ QString bitInvader::nodeName() const
 
 
 
-void bitInvader::playNote( NotePlayHandle * _n,
-						sampleFrame * _working_buffer )
+bSynth * bitInvader::synth( NotePlayHandle * _n )
 {
 	if ( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
@@ -297,11 +296,19 @@ void bitInvader::playNote( NotePlayHandle * _n,
 					m_interpolation.value(), factor,
 				Engine::mixer()->processingSampleRate() );
 	}
+	return static_cast<bSynth *>( _n->m_pluginData );
+}
+
+
 
+
+void bitInvader::playNote( NotePlayHandle * _n,
+						sampleFrame * _working_buffer )
+{
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 	const f_cnt_t offset = _n->noteOffset();
 
-	bSynth * ps = static_cast<bSynth *>( _n->m_pluginData );
+	bSynth * ps = synth( _n );
 	for( fpp_t frame = offset; frame < frames + offset; ++frame )
 	{
 		const sample_t cur = ps->nextStringSample( m_graph.length() );
@@ -319,6 +326,37 @@ void bitInvader::playNote( NotePlayHandle * _n,
 
 
 
+void bitInvader::playVoices( NotePlayHandle * const * _notes, int _count,
+						sampleFrame * _buffer )
+{
+	const float length = m_graph.length();
+	for( int i = 0; i < _count; ++i )
+	{
+		NotePlayHandle * n = _notes[i];
+		const fpp_t frames = n->framesLeftForCurrentPeriod();
+		const f_cnt_t offset = n->noteOffset();
+		// the fade out of applyRelease(), which ends with the frames
+		// of the period the note plays regardless of its offset
+		const fpp_t release = releaseBegin( n );
+		const stereoVolumeVector vv = InstrumentTrack::noteVolume( n );
+
+		bSynth * ps = synth( n );
+		for( fpp_t frame = offset; frame < frames + offset; ++frame )
+		{
+			sample_t cur = ps->nextStringSample( length );
+			if( frame >= release && frame < frames )
+			{
+				cur *= releaseLevel( n, frame );
+			}
+			_buffer[frame][0] += cur * vv.vol[0];
+			_buffer[frame][1] += cur * vv.vol[1];
+		}
+	}
+}
+
+
+
+
 void bitInvader::deleteNotePluginData( NotePlayHandle * _n )
 {
 	delete static_cast<bSynth *>( _n->m_pluginData );
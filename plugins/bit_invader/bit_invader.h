@@ -70,6 +70,8 @@ public:
 
 	virtual void playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer );
+	virtual void playVoices( NotePlayHandle * const * _notes, int _count,
+						sampleFrame * _buffer );
 	virtual void deleteNotePluginData( NotePlayHandle * _n );
 
 
@@ -84,6 +86,11 @@ public:
 		return( 64 );
 	}
 
+	virtual Flags flags() const
+	{
+		return RendersVoices;
+	}
+
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 protected slots:
@@ -94,6 +101,8 @@ protected slots:
 
 
 private:
+	bSynth * synth( NotePlayHandle * _n );
+
 	FloatModel  m_sampleLength;
 	graphModel  m_graph;
 	
@@ -31,6 +31,7 @@
 #include "InstrumentTrack.h"
 #include "MidiEventToByteSeq.h"
 #include "Mixer.h"
+#include "PlanarBuffer.h"
 
 #include <QApplication>
 #include <QFileDialog>
@@ -135,7 +136,8 @@ CarlaInstrument::CarlaInstrument(InstrumentTrack* const instrumentTrack, const D
       kIsPatchbay(isPatchbay),
       fHandle(NULL),
       fDescriptor(isPatchbay ? carla_get_native_patchbay_plugin() : carla_get_native_rack_plugin()),
-      fMidiEventCount(0)
+      fMidiEventCount(0),
+      fBuffer(new PlanarBuffer(Mixer::maxFramesPerPeriod()))
 {
     fHost.handle      = this;
     fHost.uiName      = NULL;
@@ -178,6 +180,7 @@ CarlaInstrument::CarlaInstrument(InstrumentTrack* const instrumentTrack, const D
     Engine::mixer()->addPlayHandle( iph );
 
     connect(Engine::mixer(), SIGNAL(sampleRateChanged()), this, SLOT(sampleRateChanged()));
+    connect(Engine::mixer(), SIGNAL(framesPerPeriodChanged()), this, SLOT(bufferSizeChanged()));
 }
 
 CarlaInstrument::~CarlaInstrument()
@@ -196,6 +199,8 @@ CarlaInstrument::~CarlaInstrument()
         fHost.uiName = NULL;
     }
 
+    delete fBuffer;
+
     if (fHandle == NULL)
         return;
 
@@ -306,10 +311,9 @@ void CarlaInstrument::play(sampleFrame* workingBuffer)
 {
     const uint bufsize = Engine::mixer()->framesPerPeriod();
 
-    std::memset(workingBuffer, 0, sizeof(sample_t)*bufsize*DEFAULT_CHANNELS);
-
     if (fHandle == NULL)
     {
+        std::memset(workingBuffer, 0, sizeof(sample_t)*bufsize*DEFAULT_CHANNELS);
         instrumentTrack()->processAudioBuffer(workingBuffer, bufsize, NULL);
         return;
     }
@@ -328,17 +332,9 @@ void CarlaInstrument::play(sampleFrame* workingBuffer)
     fTimeInfo.bbt.ticksPerBeat   = ticksPerBeat;
     fTimeInfo.bbt.beatsPerMinute = s->getTempo();
 
-#ifndef _MSC_VER
-    float buf1[bufsize];
-    float buf2[bufsize];
-#else
-    float *buf1 = static_cast<float *>(_alloca(bufsize * sizeof(float)));
-    float *buf2 = static_cast<float *>(_alloca(bufsize * sizeof(float)));
-#endif
-
-    float* rBuf[] = { buf1, buf2 };
-    std::memset(buf1, 0, sizeof(float)*bufsize);
-    std::memset(buf2, 0, sizeof(float)*bufsize);
+    // the inputs are silent, Carla replaces them with its output
+    fBuffer->clear(bufsize);
+    float* rBuf[] = { fBuffer->channel(0), fBuffer->channel(1) };
 
     {
         const QMutexLocker ml(&fMutex);
@@ -346,11 +342,7 @@ void CarlaInstrument::play(sampleFrame* workingBuffer)
         fMidiEventCount = 0;
     }
 
-    for (uint i=0; i < bufsize; ++i)
-    {
-        workingBuffer[i][0] = buf1[i];
-        workingBuffer[i][1] = buf2[i];
-    }
+    fBuffer->toInterleaved(workingBuffer, bufsize);
 
     instrumentTrack()->processAudioBuffer(workingBuffer, bufsize, NULL);
 }
@@ -399,6 +391,11 @@ void CarlaInstrument::sampleRateChanged()
     fDescriptor->dispatcher(fHandle, NATIVE_PLUGIN_OPCODE_SAMPLE_RATE_CHANGED, 0, 0, nullptr, handleGetSampleRate());
 }
 
+void CarlaInstrument::bufferSizeChanged()
+{
+    fDescriptor->dispatcher(fHandle, NATIVE_PLUGIN_OPCODE_BUFFER_SIZE_CHANGED, 0, handleGetBufferSize(), nullptr, 0.0f);
+}
+
 // -------------------------------------------------------------------
 
 CarlaInstrumentView::CarlaInstrumentView(CarlaInstrument* const instrument, QWidget* const parent)
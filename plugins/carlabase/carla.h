@@ -45,6 +45,8 @@
 #include "Instrument.h"
 #include "InstrumentView.h"
 
+class PlanarBuffer;
+
 class QPushButton;
 
 class CARLABASE_EXPORT CarlaInstrument : public Instrument
@@ -80,6 +82,7 @@ signals:
 
 private slots:
     void sampleRateChanged();
+    void bufferSizeChanged();
 
 private:
     const bool kIsPatchbay;
@@ -92,6 +95,9 @@ private:
     NativeMidiEvent fMidiEvents[kMaxMidiEvents];
     NativeTimeInfo  fTimeInfo;
 
+    // Carla renders into separate aligned channels, sized for the longest period
+    PlanarBuffer* fBuffer;
+
     // this is only needed because note-offs are being sent during play
     QMutex fMutex;
 
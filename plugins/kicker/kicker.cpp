@@ -74,6 +74,15 @@ kickerInstrument::kickerInstrument( InstrumentTrack * _instrument_track ) :
 	m_endNoteModel( false, this, tr( "End to note" ) ),
 	m_versionModel( KICKER_PRESET_VERSION, 0, KICKER_PRESET_VERSION, this, "" )
 {
+	m_soundModels << &m_startFreqModel << &m_endFreqModel << &m_decayModel
+		<< &m_distModel << &m_distEndModel << &m_gainModel << &m_envModel
+		<< &m_noiseModel << &m_clickModel << &m_slopeModel
+		<< &m_startNoteModel << &m_endNoteModel;
+	for( const AutomatableModel * model : m_soundModels )
+	{
+		connect( model, SIGNAL( dataChanged() ),
+				this, SLOT( clearOneShots() ) );
+	}
 }
 
 
@@ -161,37 +170,115 @@ typedef DspEffectLibrary::Distortion DistFX;
 typedef KickerOsc<DspEffectLibrary::MonoToStereoAdaptor<DistFX> > SweepOsc;
 
 
+class KickerRecorder : public OneShotCache::Recorder
+{
+	MM_OPERATORS
+public:
+	KickerRecorder( const SweepOsc & osc ) :
+		m_osc( osc )
+	{
+	}
+
+	f_cnt_t render( sampleFrame * buf, f_cnt_t frames ) override
+	{
+		m_osc.update( buf, frames, Engine::mixer()->processingSampleRate() );
+		return frames;
+	}
+
+private:
+	SweepOsc m_osc;
+} ;
+
+
+
+
+bool kickerInstrument::isAutomated() const
+{
+	for( const AutomatableModel * model : m_soundModels )
+	{
+		if( model->isAutomatedOrControlled() )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+void kickerInstrument::clearOneShots()
+{
+	m_oneShots.clear();
+}
+
+
+
+
 void kickerInstrument::playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 	const f_cnt_t offset = _n->noteOffset();
-	const float decfr = m_decayModel.value() *
-		Engine::mixer()->processingSampleRate() / 1000.0f;
+	const float sampleRate = Engine::mixer()->processingSampleRate();
+	const float decfr = m_decayModel.value() * sampleRate / 1000.0f;
 	const f_cnt_t tfp = _n->totalFramesPlayed();
 
 	if ( tfp == 0 )
 	{
-		_n->m_pluginData = new SweepOsc(
+		const float startFreq = m_startNoteModel.value() ?
+				_n->frequency() : m_startFreqModel.value();
+		const float endFreq = m_endNoteModel.value() ?
+				_n->frequency() : m_endFreqModel.value();
+		auto record = [&]()
+		{
+			return new KickerRecorder( SweepOsc(
 					DistFX( m_distModel.value(),
 							m_gainModel.value() ),
-					m_startNoteModel.value() ? _n->frequency() : m_startFreqModel.value(),
-					m_endNoteModel.value() ? _n->frequency() : m_endFreqModel.value(),
+					startFreq,
+					endFreq,
 					m_noiseModel.value() * m_noiseModel.value(),
 					m_clickModel.value() * 0.25f,
 					m_slopeModel.value(),
 					m_envModel.value(),
 					m_distModel.value(),
 					m_distEndModel.value(),
-					decfr );
+					decfr ) );
+		};
+
+		// velocity is applied by the track, so a hit only depends on
+		// the parameters and the pitch, unless there's noise
+		OneShotCache::TakePtr take;
+		if( Engine::mixer()->oneShotCaching() &&
+				m_noiseModel.value() == 0 && !isAutomated() )
+		{
+			const float sound[] = { startFreq, endFreq,
+					m_distModel.value(), m_gainModel.value(),
+					m_clickModel.value(), m_slopeModel.value(),
+					m_envModel.value(), m_distEndModel.value(),
+					decfr, sampleRate };
+			const QByteArray key( reinterpret_cast<const char *>( sound ),
+							sizeof( sound ) );
+			take = m_oneShots.find( key );
+			if( !take )
+			{
+				take = m_oneShots.insert( key, record() );
+			}
+		}
+		else
+		{
+			take = OneShotCache::uncached( record() );
+		}
+		_n->m_pluginData = new OneShotCache::Player( take );
 	}
 	else if( tfp > decfr && !_n->isReleased() )
 	{
 		_n->noteOff();
 	}
 
-	SweepOsc * so = static_cast<SweepOsc *>( _n->m_pluginData );
-	so->update( _working_buffer + offset, frames, Engine::mixer()->processingSampleRate() );
+	OneShotCache::Player * player =
+			static_cast<OneShotCache::Player *>( _n->m_pluginData );
+	player->play( _working_buffer + offset, frames );
 
 	if( _n->isReleased() )
 	{
@@ -213,7 +300,7 @@ void kickerInstrument::playNote( NotePlayHandle * _n,
 
 void kickerInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<SweepOsc *>( _n->m_pluginData );
+	delete static_cast<OneShotCache::Player *>( _n->m_pluginData );
 }
 
 
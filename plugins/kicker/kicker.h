@@ -32,6 +32,7 @@
 #include "InstrumentView.h"
 #include "Knob.h"
 #include "LedCheckbox.h"
+#include "OneShotCache.h"
 #include "TempoSyncKnob.h"
 
 
@@ -68,10 +69,22 @@ public:
 		return( 512 );
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 
+private slots:
+	void clearOneShots();
+
+
 private:
+	// whether the models of the sound are automated or controlled
+	bool isAutomated() const;
+
 	FloatModel m_startFreqModel;
 	FloatModel m_endFreqModel;
 	TempoSyncKnobModel m_decayModel;
@@ -88,6 +101,9 @@ private:
 
 	IntModel m_versionModel;
 
+	AutomatableModel::AutoModelVector m_soundModels;
+	OneShotCache m_oneShots;
+
 	friend class kickerInstrumentView;
 
 } ;
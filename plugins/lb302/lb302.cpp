@@ -180,6 +180,26 @@ void lb302FilterIIR2::envRecalc()
 }
 
 
+void lb302FilterIIR2::process(float* samples, const int frames)
+{
+	float d1 = vcf_d1;
+	float d2 = vcf_d2;
+	for (int i = 0; i < frames; ++i) {
+		const float ret = vcf_a*d1 + vcf_b*d2 + vcf_c*samples[i];
+		d2 = d1;
+		d1 = ret;
+		samples[i] = ret;
+	}
+	vcf_d1 = d1;
+	vcf_d2 = d2;
+
+	// the distortion has no state, so it's done on the whole block
+	if(fs->dist > 0)
+		for (int i = 0; i < frames; ++i)
+			samples[i] = m_dist->nextSample(samples[i]);
+}
+
+
 float lb302FilterIIR2::process(const float& samp)
 {
 	float ret = vcf_a*vcf_d1 + vcf_b*vcf_d2 + vcf_c*samp;
@@ -256,6 +276,27 @@ void lb302Filter3Pole::envRecalc()
 }
 
 
+void lb302Filter3Pole::process(float* samples, const int frames)
+{
+	// only the ladder has feedback, the saturation of the output is
+	// done on the whole block
+	for (int i = 0; i < frames; ++i) {
+		const float ax1  = lastin;
+		const float ay11 = ay1;
+		const float ay31 = ay2;
+		lastin  = (samples[i]) - tanh(kres*aout);
+		ay1     = kp1h * (lastin+ax1) - kp*ay1;
+		ay2     = kp1h * (ay1 + ay11) - kp*ay2;
+		aout    = kp1h * (ay2 + ay31) - kp*aout;
+		samples[i] = aout;
+	}
+
+	for (int i = 0; i < frames; ++i) {
+		samples[i] = tanh(samples[i]*value)*LB_24_VOL_ADJUST/(1.0+fs->dist);
+	}
+}
+
+
 float lb302Filter3Pole::process(const float& samp)
 {
 	float ax1  = lastin;
@@ -461,8 +502,6 @@ inline float GET_INC(float freq) {
 int lb302Synth::process(sampleFrame *outbuf, const int size)
 {
 	const float sampleRatio = 44100.f / Engine::mixer()->processingSampleRate();
-	float w;
-	float samp;
 
 	// Hold on to the current VCF, and use it throughout this period
 	lb302Filter *filter = vcf.loadAcquire();
@@ -488,14 +527,30 @@ int lb302Synth::process(sampleFrame *outbuf, const int size)
 	// TODO: NORMAL RELEASE
 	// vca_mode = 1;
 
-	for( int i=0; i<size; i++ ) 
-	{
-		// start decay if we're past release
-		if( i >= release_frame )
-		{
-			vca_mode = decay;
-		}
+	switch(int(rint(wave_shape.value()))) {
+		case 0: vco_shape = SAWTOOTH; break;
+		case 1: vco_shape = TRIANGLE; break;
+		case 2: vco_shape = SQUARE; break;
+		case 3: vco_shape = ROUND_SQUARE; break;
+		case 4: vco_shape = MOOG; break;
+		case 5: vco_shape = SINE; break;
+		case 6: vco_shape = EXPONENTIAL; break;
+		case 7: vco_shape = WHITE_NOISE; break;
+		case 8: vco_shape = BL_SAWTOOTH; break;
+		case 9: vco_shape = BL_SQUARE; break;
+		case 10: vco_shape = BL_TRIANGLE; break;
+		case 11: vco_shape = BL_MOOG; break;
+		default:  vco_shape = SAWTOOTH; break;
+	}
+
+	const float attackFrames = 0.5*Engine::mixer()->processingSampleRate();
 
+	// The filter coefficients and the slide only change every ENVINC
+	// samples, so everything between two updates is rendered as a block:
+	// first the VCO, then the filter, then the VCA.
+	float block[ENVINC];
+	for( int i=0; i<size; )
+	{
 		// update vcf
 		if(vcf_envpos >= ENVINC) {
 			filter->envRecalc();
@@ -510,146 +565,149 @@ int lb302Synth::process(sampleFrame *outbuf, const int size)
 			}
 		}
 
+		const int frames = qMin( size - i, ENVINC - vcf_envpos );
+		vcf_envpos += frames;
 
-		sample_cnt++;
-		vcf_envpos++;
-
-		//int  decay_frames = 128;
-
-		// update vco
-		vco_c += vco_inc;
-		
-		if(vco_c > 0.5)
-			vco_c -= 1.0;
+		renderVco( block, frames );
+#ifdef LB_FILTERED
+		filter->process( block, frames );
+#endif
 
-		switch(int(rint(wave_shape.value()))) {
-			case 0: vco_shape = SAWTOOTH; break;
-			case 1: vco_shape = TRIANGLE; break;
-			case 2: vco_shape = SQUARE; break;
-			case 3: vco_shape = ROUND_SQUARE; break;
-			case 4: vco_shape = MOOG; break;
-			case 5: vco_shape = SINE; break;
-			case 6: vco_shape = EXPONENTIAL; break;
-			case 7: vco_shape = WHITE_NOISE; break;
-			case 8: vco_shape = BL_SAWTOOTH; break;
-			case 9: vco_shape = BL_SQUARE; break;
-			case 10: vco_shape = BL_TRIANGLE; break;
-			case 11: vco_shape = BL_MOOG; break;
-			default:  vco_shape = SAWTOOTH; break;
-		}
+		for( int f = 0; f < frames; ++f, ++i )
+		{
+			// start decay if we're past release
+			if( i >= release_frame )
+			{
+				vca_mode = decay;
+			}
 
-		// add vco_shape_param the changes the shape of each curve.
-		// merge sawtooths with triangle and square with round square?
-		switch (vco_shape) {
-			case SAWTOOTH: // p0: curviness of line
-				vco_k = vco_c;  // Is this sawtooth backwards?
-				break;
-
-			case TRIANGLE:  // p0: duty rev.saw<->triangle<->saw p1: curviness
-				vco_k = (vco_c*2.0)+0.5;
-				if (vco_k>0.5)
-					vco_k = 1.0- vco_k;
-				break;
-
-			case SQUARE: // p0: slope of top
-				vco_k = (vco_c<0)?0.5:-0.5;
-				break;
-
-			case ROUND_SQUARE: // p0: width of round
-				vco_k = (vco_c<0)?(sqrtf(1-(vco_c*vco_c*4))-0.5):-0.5;
-				break;
-
-			case MOOG: // Maybe the fall should be exponential/sinsoidal instead of quadric.
-				// [-0.5, 0]: Rise, [0,0.25]: Slope down, [0.25,0.5]: Low
-				vco_k = (vco_c*2.0)+0.5;
-				if (vco_k>1.0) {
-					vco_k = -0.5 ;
-				}
-				else if (vco_k>0.5) {
-					w = 2.0*(vco_k-0.5)-1.0;
-					vco_k = 0.5 - sqrtf(1.0-(w*w));
-				}
-				vco_k *= 2.0;  // MOOG wave gets filtered away
-				break;
+			sample_cnt++;
 
-			case SINE:
-				// [-0.5, 0.5]  : [-pi, pi]
-				vco_k = 0.5f * Oscillator::sinSample( vco_c );
-				break;
+			const float samp = block[f] * vca_a;
+			for( int c = 0; c < DEFAULT_CHANNELS; c++ ) 
+			{
+				outbuf[i][c] = samp;
+			}
 
-			case EXPONENTIAL:
-				vco_k = 0.5 * Oscillator::expSample( vco_c );
-				break;
+			// Handle Envelope
+			if(vca_mode==attack) {
+				vca_a+=(vca_a0-vca_a)*vca_attack;
+				if(sample_cnt>=attackFrames)
+					vca_mode = idle;
+			}
+			else if(vca_mode == decay) {
+				vca_a *= vca_decay;
 
-			case WHITE_NOISE:
-				vco_k = 0.5 * Oscillator::noiseSample( vco_c );
-				break;
+				// the following line actually speeds up processing
+				if(vca_a < (1/65536.0)) {
+					vca_a = 0;
+					vca_mode = never_played;
+				}
+			}
+		}
+	}
+	return 1;
+}
 
-			case BL_SAWTOOTH:
-				vco_k = BandLimitedWave::oscillate( vco_c + 0.5f, BandLimitedWave::pdToLen( vco_inc ), BandLimitedWave::BLSaw ) * 0.5f;
-				break;
 
-			case BL_SQUARE:
-				vco_k = BandLimitedWave::oscillate( vco_c + 0.5f, BandLimitedWave::pdToLen( vco_inc ), BandLimitedWave::BLSquare ) * 0.5f;
-				break;
+// The VCO of a block, in which vco_inc doesn't change
+void lb302Synth::renderVco( float * out, const int frames )
+{
+	for( int i=0; i<frames; i++ )
+	{
+		vco_c += vco_inc;
+		
+		if(vco_c > 0.5)
+			vco_c -= 1.0;
 
-			case BL_TRIANGLE:
-				vco_k = BandLimitedWave::oscillate( vco_c + 0.5f, BandLimitedWave::pdToLen( vco_inc ), BandLimitedWave::BLTriangle ) * 0.5f;
-				break;
+		out[i] = vco_c;
+	}
 
-			case BL_MOOG:
-				vco_k = BandLimitedWave::oscillate( vco_c + 0.5f, BandLimitedWave::pdToLen( vco_inc ), BandLimitedWave::BLMoog );
-				break;
-		}
+	// add vco_shape_param the changes the shape of each curve.
+	// merge sawtooths with triangle and square with round square?
+	switch (vco_shape) {
+		case SAWTOOTH: // p0: curviness of line
+			// Is this sawtooth backwards?
+			break;
+
+		case TRIANGLE:  // p0: duty rev.saw<->triangle<->saw p1: curviness
+			for( int i=0; i<frames; i++ ) {
+				const float k = (out[i]*2.0)+0.5;
+				out[i] = k>0.5 ? 1.0-k : k;
+			}
+			break;
 
-		//vca_a = 0.5;
-		// Write out samples.
-#ifdef LB_FILTERED
-		//samp = vcf->process(vco_k)*2.0*vca_a;
-		//samp = vcf->process(vco_k)*2.0;
-		samp = filter->process(vco_k) * vca_a;
-		//printf("%f %d\n", vco_c, sample_cnt);
+		case SQUARE: // p0: slope of top
+			for( int i=0; i<frames; i++ ) {
+				out[i] = (out[i]<0)?0.5:-0.5;
+			}
+			break;
 
+		case ROUND_SQUARE: // p0: width of round
+			for( int i=0; i<frames; i++ ) {
+				const float c = out[i];
+				out[i] = (c<0)?(sqrtf(1-(c*c*4))-0.5):-0.5;
+			}
+			break;
+
+		case MOOG: // Maybe the fall should be exponential/sinsoidal instead of quadric.
+			// [-0.5, 0]: Rise, [0,0.25]: Slope down, [0.25,0.5]: Low
+			for( int i=0; i<frames; i++ ) {
+				float k = (out[i]*2.0)+0.5;
+				if (k>1.0) {
+					k = -0.5 ;
+				}
+				else if (k>0.5) {
+					const float w = 2.0*(k-0.5)-1.0;
+					k = 0.5 - sqrtf(1.0-(w*w));
+				}
+				out[i] = k * 2.0;  // MOOG wave gets filtered away
+			}
+			break;
 
-		//samp = vco_k * vca_a;
+		case SINE:
+			// [-0.5, 0.5]  : [-pi, pi]
+			for( int i=0; i<frames; i++ ) {
+				out[i] = 0.5f * Oscillator::sinSample( out[i] );
+			}
+			break;
 
-		if( sample_cnt <= 4 )
-		{
-	//			vca_a = 0;
-		}
+		case EXPONENTIAL:
+			for( int i=0; i<frames; i++ ) {
+				out[i] = 0.5 * Oscillator::expSample( out[i] );
+			}
+			break;
 
-#else
-		//samp = vco_k*vca_a;
-#endif
-		/*
-		float releaseFrames = desiredReleaseFrames();
-		samp *= (releaseFrames - catch_decay)/releaseFrames;
-		*/
-		//LB302 samp *= (float)(decay_frames - catch_decay)/(float)decay_frames;
+		case WHITE_NOISE:
+			for( int i=0; i<frames; i++ ) {
+				out[i] = 0.5 * Oscillator::noiseSample( out[i] );
+			}
+			break;
 
-		for( int c = 0; c < DEFAULT_CHANNELS; c++ ) 
+		case BL_SAWTOOTH:
+		case BL_SQUARE:
+		case BL_TRIANGLE:
+		case BL_MOOG:
 		{
-			outbuf[i][c] = samp;
-		}
-
-		// Handle Envelope
-		if(vca_mode==attack) {
-			vca_a+=(vca_a0-vca_a)*vca_attack;
-			if(sample_cnt>=0.5*Engine::mixer()->processingSampleRate())
-				vca_mode = idle;
-		}
-		else if(vca_mode == decay) {
-			vca_a *= vca_decay;
-
-			// the following line actually speeds up processing
-			if(vca_a < (1/65536.0)) {
-				vca_a = 0;
-				vca_mode = never_played;
+			const BandLimitedWave::Waveforms waves[] = { BandLimitedWave::BLSaw,
+				BandLimitedWave::BLSquare, BandLimitedWave::BLTriangle, BandLimitedWave::BLMoog };
+			for( int i=0; i<frames; i++ ) {
+				out[i] += 0.5f;
 			}
+			BandLimitedWave::oscillate( out, out, frames, BandLimitedWave::pdToLen( vco_inc ),
+				waves[vco_shape - BL_SAWTOOTH] );
+			if( vco_shape != BL_MOOG ) {
+				for( int i=0; i<frames; i++ ) {
+					out[i] *= 0.5f;
+				}
+			}
+			break;
 		}
+	}
 
+	if( frames > 0 ) {
+		vco_k = out[frames-1];
 	}
-	return 1;
 }
 
 
@@ -65,6 +65,8 @@ class lb302Filter
 	virtual void recalc();
 	virtual void envRecalc();
 	virtual float process(const float& samp)=0;
+	// filters a block in place, with the coefficients of the last envRecalc()
+	virtual void process(float* samples, const int frames)=0;
 	virtual void playNote();
 
 	protected:
@@ -86,6 +88,7 @@ class lb302FilterIIR2 : public lb302Filter
 	virtual void recalc();
 	virtual void envRecalc();
 	virtual float process(const float& samp);
+	virtual void process(float* samples, const int frames);
 
 	protected:
 	float vcf_d1,           //   d1 and d2 are added back into the sample with
@@ -110,6 +113,7 @@ class lb302Filter3Pole : public lb302Filter
 	virtual void envRecalc();
 	virtual void recalc();
 	virtual float process(const float& samp);
+	virtual void process(float* samples, const int frames);
 
 	protected:
 	float kfcn,
@@ -247,6 +251,7 @@ private:
 	void recalcFilter();
 
 	int process(sampleFrame *outbuf, const int size);
+	void renderVco(float *out, const int frames);
 
 	friend class lb302SynthView;
 
@@ -28,6 +28,7 @@
 #include "Monstro.h"
 #include "Engine.h"
 #include "InstrumentTrack.h"
+#include "Mixer.h"
 #include "gui_templates.h"
 #include "ToolTip.h"
 #include "Song.h"
@@ -104,6 +105,9 @@ MonstroSynth::MonstroSynth( MonstroInstrument * _i, NotePlayHandle * _nph ) :
 	m_lfo[1].resize( m_parent->m_fpp );
 	m_env[0].resize( m_parent->m_fpp );
 	m_env[1].resize( m_parent->m_fpp );
+	m_pitch[0].resize( m_parent->m_fpp );
+	m_pitch[1].resize( m_parent->m_fpp );
+	m_pitch[2].resize( m_parent->m_fpp );
 }
 
 
@@ -114,15 +118,9 @@ MonstroSynth::~MonstroSynth()
 
 void MonstroSynth::renderOutput( fpp_t _frames, sampleFrame * _buf  )
 {
-	float modtmp; // temp variable for freq modulation
 // macros for modulating with env/lfos
-#define modulatefreq( car, mod ) \
-		modtmp = 0.0f; \
-		if( mod##_e1 != 0.0f ) modtmp += m_env[0][f] * mod##_e1; \
-		if( mod##_e2 != 0.0f ) modtmp += m_env[1][f] * mod##_e2; \
-		if( mod##_l1 != 0.0f ) modtmp += m_lfo[0][f] * mod##_l1; \
-		if( mod##_l2 != 0.0f ) modtmp += m_lfo[1][f] * mod##_l2; \
-		car = qBound( MIN_FREQ, car * powf( 2.0f, modtmp ), MAX_FREQ );
+#define modulatefreq( car, factors ) \
+		car = qBound( MIN_FREQ, car * factors[f], MAX_FREQ );
 
 #define modulateabs( car, mod ) \
 		if( mod##_e1 != 0.0f ) car += m_env[0][f] * mod##_e1; \
@@ -347,6 +345,16 @@ void MonstroSynth::renderOutput( fpp_t _frames, sampleFrame * _buf  )
 	// render modulators: envelopes, lfos
 	updateModulators( m_env[0].data(), m_env[1].data(), m_lfo[0].data(), m_lfo[1].data(), _frames );
 
+	// the pitch modulation needs a powf() per frame and oscillator, so
+	// it's only calculated every few frames unless rendering the final mix
+	const int interval = Engine::mixer()->currentQualitySettings().controlInterval;
+	const float * o1f_factors = m_pitch[0].data();
+	const float * o2f_factors = m_pitch[1].data();
+	const float * o3f_factors = m_pitch[2].data();
+	if( o1f_mod ) { updatePitchFactors( m_pitch[0].data(), o1f_e1, o1f_e2, o1f_l1, o1f_l2, _frames, interval ); }
+	if( o2f_mod ) { updatePitchFactors( m_pitch[1].data(), o2f_e1, o2f_e2, o2f_l1, o2f_l2, _frames, interval ); }
+	if( o3f_mod ) { updatePitchFactors( m_pitch[2].data(), o3f_e1, o3f_e2, o3f_l1, o3f_l2, _frames, interval ); }
+
 	// begin for loop
 	for( f_cnt_t f = 0; f < _frames; ++f )
 	{
@@ -369,8 +377,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, sampleFrame * _buf  )
 		o1r_f = o1rfb;
 		if( o1f_mod )
 		{
-			modulatefreq( o1l_f, o1f )
-			modulatefreq( o1r_f, o1f )
+			modulatefreq( o1l_f, o1f_factors )
+			modulatefreq( o1r_f, o1f_factors )
 		}
 		// calc and modulate pulse
 		o1_pw = pw;
@@ -482,8 +490,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, sampleFrame * _buf  )
 		o2r_f = o2rfb;
 		if( o2f_mod )
 		{
-			modulatefreq( o2l_f, o2f )
-			modulatefreq( o2r_f, o2f )
+			modulatefreq( o2l_f, o2f_factors )
+			modulatefreq( o2r_f, o2f_factors )
 		}
 
 		// calc and modulate phase
@@ -541,8 +549,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, sampleFrame * _buf  )
 		o3r_f = o3fb;
 		if( o3f_mod )
 		{
-			modulatefreq( o3l_f, o3f )
-			modulatefreq( o3r_f, o3f )
+			modulatefreq( o3l_f, o3f_factors )
+			modulatefreq( o3r_f, o3f_factors )
 		}
 		// calc and modulate phase
 		leftph = o3l_p;
@@ -818,6 +826,45 @@ inline void MonstroSynth::updateModulators( float * env1, float * env2, float *
 }
 
 
+inline void MonstroSynth::updatePitchFactors( float * _factors, float _e1, float _e2, float _l1, float _l2,
+						int _frames, int _interval )
+{
+	auto factor = [&]( f_cnt_t f )
+	{
+		float modtmp = 0.0f;
+		if( _e1 != 0.0f ) modtmp += m_env[0][f] * _e1;
+		if( _e2 != 0.0f ) modtmp += m_env[1][f] * _e2;
+		if( _l1 != 0.0f ) modtmp += m_lfo[0][f] * _l1;
+		if( _l2 != 0.0f ) modtmp += m_lfo[1][f] * _l2;
+		return powf( 2.0f, modtmp );
+	};
+
+	if( _interval <= 1 )
+	{
+		for( f_cnt_t f = 0; f < _frames; ++f )
+		{
+			_factors[f] = factor( f );
+		}
+		return;
+	}
+
+	float start = factor( 0 );
+	for( f_cnt_t f = 0; f < _frames; f += _interval )
+	{
+		// the last sub-block ends at the last frame
+		const f_cnt_t next = qMin<f_cnt_t>( f + _interval, _frames - 1 );
+		const float end = next > f ? factor( next ) : start;
+		const float step = next > f ? ( end - start ) / ( next - f ) : 0.0f;
+		const f_cnt_t last = qMin<f_cnt_t>( f + _interval, _frames );
+		for( f_cnt_t i = f; i < last; ++i )
+		{
+			_factors[i] = start + step * ( i - f );
+		}
+		start = end;
+	}
+}
+
+
 inline sample_t MonstroSynth::calcSlope( int slope, sample_t s )
 {
 	if( m_parent->m_slope[slope] == 1.0f ) return s;
@@ -1008,7 +1055,7 @@ MonstroInstrument::MonstroInstrument( InstrumentTrack * _instrument_track ) :
 
 	connect( Engine::mixer(), SIGNAL( sampleRateChanged() ), this, SLOT( updateSamplerate() ) );
 
-	m_fpp = Engine::mixer()->framesPerPeriod();
+	m_fpp = Mixer::maxFramesPerPeriod();
 
 	updateSamplerate();
 	updateVolume1();
@@ -173,6 +173,11 @@ private:
 
 	inline void updateModulators( float * env1, float * env2, float * lfo1, float * lfo2, int frames );
 
+	// fills _factors with the pitch factors of an oscillator, calculated every
+	// _interval frames and interpolated linearly in between
+	inline void updatePitchFactors( float * _factors, float _e1, float _e2, float _l1, float _l2,
+					int _frames, int _interval );
+
 	// linear interpolation
 /*	inline sample_t interpolate( sample_t s1, sample_t s2, float x )
 	{
@@ -302,6 +307,7 @@ private:
 
 	std::vector<float> m_lfo[2];
 	std::vector<float> m_env[2];
+	std::vector<float> m_pitch[3];
 };
 
 class MonstroInstrument : public Instrument
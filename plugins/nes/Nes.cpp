@@ -24,11 +24,14 @@
 
 #include <QDomElement>
 
+#include <algorithm>
+
 #include "Nes.h"
 #include "Engine.h"
 #include "InstrumentTrack.h"
 #include "ToolTip.h"
 #include "Song.h"
+#include "lmms_constants.h"
 #include "lmms_math.h"
 #include "interpolation.h"
 #include "Mixer.h"
@@ -57,6 +60,66 @@ Plugin::Descriptor PLUGIN_EXPORT nes_plugin_descriptor =
 }
 
 
+float NesSteps::s_kernel[NesSteps::PHASES + 1][NesSteps::TAPS];
+bool NesSteps::s_kernelReady = NesSteps::initKernel();
+
+
+NesSteps::NesSteps() :
+	m_sum( 0.0f )
+{
+	std::fill_n( m_impulses, BLOCK_FRAMES + TAPS, 0.0f );
+}
+
+
+bool NesSteps::initKernel()
+{
+	// a Blackman windowed sinc, with its cutoff a bit below nyquist. Tap i
+	// of phase p is LAG + p / PHASES frames before the center of the
+	// impulse, so all taps are within the window.
+	const double cutoff = 0.9;
+	for( int p = 0; p <= PHASES; ++p )
+	{
+		double taps[TAPS];
+		double sum = 0.0;
+		for( int i = 0; i < TAPS; ++i )
+		{
+			const double x = i - LAG - static_cast<double>( p ) / PHASES;
+			const double sinc = x == 0.0
+				? cutoff
+				: sin( D_PI * cutoff * x ) / ( D_PI * x );
+			const double window = 0.42 + 0.5 * cos( D_PI * x / ( TAPS / 2 ) )
+					+ 0.08 * cos( 2.0 * D_PI * x / ( TAPS / 2 ) );
+			taps[i] = sinc * window;
+			sum += taps[i];
+		}
+		// each step adds exactly its size
+		for( int i = 0; i < TAPS; ++i )
+		{
+			s_kernel[p][i] = static_cast<float>( taps[i] / sum );
+		}
+	}
+	return true;
+}
+
+
+void NesSteps::read( float * out, int frames )
+{
+	float sum = m_sum;
+	for( int f = 0; f < frames; ++f )
+	{
+		sum += m_impulses[f];
+		out[f] = sum;
+	}
+	m_sum = sum;
+
+	// the impulses reaching into the next block
+	std::copy( m_impulses + frames, m_impulses + frames + TAPS, m_impulses );
+	std::fill( m_impulses + TAPS, m_impulses + frames + TAPS, 0.0f );
+}
+
+
+
+
 NesObject::NesObject( NesInstrument * nes, const sample_rate_t samplerate, NotePlayHandle * nph ) :
 	m_parent( nes ),
 	m_samplerate( samplerate ),
@@ -67,10 +130,17 @@ NesObject::NesObject( NesInstrument * nes, const sample_rate_t samplerate, NoteP
 	
 	m_LFSR = LFSR_INIT;
 	
-	m_ch1Counter = 0;
-	m_ch2Counter = 0;
-	m_ch3Counter = 0;
+	m_ch1Phase = 0.0f;
+	m_ch2Phase = 0.0f;
+	m_ch3Phase = 0.0f;
 	m_ch4Counter = 0;
+
+	m_ch1Output = 0;
+	m_ch2Output = 0;
+	m_ch3Output = 0;
+	m_ch4Output = 0;
+	std::fill_n( m_levels12, NesSteps::LAG, 0.0f );
+	std::fill_n( m_levels34, NesSteps::LAG, 0.0f );
 	
 	m_ch1EnvCounter = 0;
 	m_ch2EnvCounter = 0;
@@ -106,6 +176,22 @@ NesObject::~NesObject()
 
 
 void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
+{
+	float block[NesSteps::BLOCK_FRAMES];
+	for( fpp_t done = 0; done < frames; done += NesSteps::BLOCK_FRAMES )
+	{
+		const int count = qMin<int>( frames - done, NesSteps::BLOCK_FRAMES );
+		renderBlock( block, count );
+		for( int f = 0; f < count; ++f )
+		{
+			buf[done + f][0] = block[f];
+			buf[done + f][1] = block[f];
+		}
+	}
+}
+
+
+void NesObject::renderBlock( float * out, int frames )
 {
 	////////////////////////////////
 	//	                          //
@@ -121,19 +207,26 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 	float ch1DutyCycle = DUTY_CYCLE[ m_parent->m_ch1DutyCycle.value() ];
 	int ch1EnvLen = wavelength( floorf( 240.0 / ( m_parent->m_ch1EnvLen.value() + 1 ) ) );
 	bool ch1EnvLoop = m_parent->m_ch1EnvLooped.value();
+	bool ch1EnvEnabled = m_parent->m_ch1EnvEnabled.value();
+	float ch1Volume = m_parent->m_ch1Volume.value();
+	bool ch1SweepEnabled = m_parent->m_ch1SweepEnabled.value();
 	
 	float ch2DutyCycle = DUTY_CYCLE[ m_parent->m_ch2DutyCycle.value() ];
 	int ch2EnvLen = wavelength( floorf( 240.0 / ( m_parent->m_ch2EnvLen.value() + 1 ) ) );
 	bool ch2EnvLoop = m_parent->m_ch2EnvLooped.value();
+	bool ch2EnvEnabled = m_parent->m_ch2EnvEnabled.value();
+	float ch2Volume = m_parent->m_ch2Volume.value();
+	bool ch2SweepEnabled = m_parent->m_ch2SweepEnabled.value();
+
+	int ch3Volume = static_cast<int>( m_parent->m_ch3Volume.value() );
 	
 	int ch4EnvLen = wavelength( floorf( 240.0 / ( m_parent->m_ch4EnvLen.value() + 1 ) ) );
 	bool ch4EnvLoop = m_parent->m_ch4EnvLooped.value();
-	
-	// processing variables for operators
-	int ch1;
-	int ch2;
-	int ch3;
-	int ch4;
+	bool ch4EnvEnabled = m_parent->m_ch4EnvEnabled.value();
+	int ch4Volume = static_cast<int>( m_parent->m_ch4Volume.value() );
+	bool ch4NoiseMode = m_parent->m_ch4NoiseMode.value();
+
+	float masterVol = m_parent->m_masterVol.value();
 	
 	// levels for generators (used for dc offset compensation)
 	int ch1Level;
@@ -174,11 +267,15 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 	{
 		ch2Sweep = -8 - ch2Sweep;
 	}
+
+	// the levels of this block, after those of the last LAG frames
+	float * levels12 = m_levels12 + NesSteps::LAG;
+	float * levels34 = m_levels34 + NesSteps::LAG;
 	
 		
-	// start framebuffer loop
+	// start framebuffer loop, which only adds the steps of the channels
 		
-	for( f_cnt_t f = 0; f < frames; f++ )
+	for( int f = 0; f < frames; f++ )
 	{
 		////////////////////////////////
 		//	                          //
@@ -203,39 +300,39 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		// render pulse wave
 		if( m_wlen1 <= m_maxWlen && m_wlen1 >= MIN_WLEN && ch1Enabled )
 		{
-			ch1Level = m_parent->m_ch1EnvEnabled.value()
-				? static_cast<int>( ( m_parent->m_ch1Volume.value() * m_ch1EnvValue ) / 15.0 )
-				: static_cast<int>( m_parent->m_ch1Volume.value() );
-			ch1 = m_ch1Counter > m_wlen1 * ch1DutyCycle 
-				? 0
-				: ch1Level;
+			ch1Level = ch1EnvEnabled
+				? static_cast<int>( ( ch1Volume * m_ch1EnvValue ) / 15.0 )
+				: static_cast<int>( ch1Volume );
+			renderPulse( m_steps12, m_ch1Output, m_ch1Phase, m_wlen1, ch1DutyCycle, ch1Level, f );
+		}
+		else
+		{
+			ch1Level = 0;
+			setOutput( m_steps12, m_ch1Output, 0, f );
+			m_ch1Phase = m_wlen1 >= 1.0f ? fmodf( m_ch1Phase + 1.0f, m_wlen1 ) : 0.0f;
 		}
-		else ch1 = ch1Level = 0;
 		
 		// update sweep
 		m_ch1SweepCounter++;
 		if( m_ch1SweepCounter >= ch1SweepRate )
 		{
 			m_ch1SweepCounter = 0;
-			if( m_parent->m_ch1SweepEnabled.value() && m_wlen1 <= m_maxWlen && m_wlen1 >= MIN_WLEN )
+			if( ch1SweepEnabled && m_wlen1 <= m_maxWlen && m_wlen1 >= MIN_WLEN )
 			{
 				// check if the sweep goes up or down
 				if( ch1Sweep > 0 )
 				{
-					m_wlen1 += m_wlen1 >> qAbs( ch1Sweep );
+					m_wlen1 += floorf( m_wlen1 / ( 1 << qAbs( ch1Sweep ) ) );
 				}
 				if( ch1Sweep < 0 )
 				{
-					m_wlen1 -= m_wlen1 >> qAbs( ch1Sweep );
+					m_wlen1 -= floorf( m_wlen1 / ( 1 << qAbs( ch1Sweep ) ) );
 					m_wlen1--;  // additional minus 1 for ch1 only
 				}
 			}
 		}
 					
 		// update framecounters
-		m_ch1Counter++;
-		m_ch1Counter = m_wlen1 ? m_ch1Counter % m_wlen1 : 0;
-
 		m_ch1EnvCounter++;
 		if( m_ch1EnvCounter >= ch1EnvLen )
 		{
@@ -257,38 +354,38 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		// render pulse wave
 		if( m_wlen2 <= m_maxWlen && m_wlen2 >= MIN_WLEN && ch2Enabled )
 		{
-			ch2Level = m_parent->m_ch2EnvEnabled.value()
-				? static_cast<int>( ( m_parent->m_ch2Volume.value() * m_ch2EnvValue ) / 15.0 )
-				: static_cast<int>( m_parent->m_ch2Volume.value() );
-			ch2 = m_ch2Counter > m_wlen2 * ch2DutyCycle 
-				? 0
-				: ch2Level;
+			ch2Level = ch2EnvEnabled
+				? static_cast<int>( ( ch2Volume * m_ch2EnvValue ) / 15.0 )
+				: static_cast<int>( ch2Volume );
+			renderPulse( m_steps12, m_ch2Output, m_ch2Phase, m_wlen2, ch2DutyCycle, ch2Level, f );
+		}
+		else
+		{
+			ch2Level = 0;
+			setOutput( m_steps12, m_ch2Output, 0, f );
+			m_ch2Phase = m_wlen2 >= 1.0f ? fmodf( m_ch2Phase + 1.0f, m_wlen2 ) : 0.0f;
 		}
-		else ch2 = ch2Level = 0;
 		
 		// update sweep
 		m_ch2SweepCounter++;
 		if( m_ch2SweepCounter >= ch2SweepRate )
 		{
 			m_ch2SweepCounter = 0;
-			if( m_parent->m_ch2SweepEnabled.value() && m_wlen2 <= m_maxWlen && m_wlen2 >= MIN_WLEN )
+			if( ch2SweepEnabled && m_wlen2 <= m_maxWlen && m_wlen2 >= MIN_WLEN )
 			{				
 				// check if the sweep goes up or down
 				if( ch2Sweep > 0 )
 				{
-					m_wlen2 += m_wlen2 >> qAbs( ch2Sweep );
+					m_wlen2 += floorf( m_wlen2 / ( 1 << qAbs( ch2Sweep ) ) );
 				}
 				if( ch2Sweep < 0 )
 				{
-					m_wlen2 -= m_wlen2 >> qAbs( ch2Sweep );
+					m_wlen2 -= floorf( m_wlen2 / ( 1 << qAbs( ch2Sweep ) ) );
 				}
 			}
 		}
 					
 		// update framecounters
-		m_ch2Counter++;
-		m_ch2Counter = m_wlen2 ? m_ch2Counter % m_wlen2 : 0;
-		
 		m_ch2EnvCounter++;
 		if( m_ch2EnvCounter >= ch2EnvLen )
 		{
@@ -309,19 +406,18 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		//                            //
 		////////////////////////////////		
 		
-		// make sure we don't overflow
-		m_ch3Counter = m_wlen3 ? m_ch3Counter % m_wlen3 : 0;
-		
 		// render triangle wave
-		if( m_wlen3 <= m_maxWlen && ch3Enabled )
+		if( m_wlen3 <= m_maxWlen && m_wlen3 >= 1.0f && ch3Enabled )
 		{
-			ch3Level = static_cast<int>( m_parent->m_ch3Volume.value() );
-			ch3 = m_wlen3 ? TRIANGLE_WAVETABLE[ ( m_ch3Counter * 32 ) / m_wlen3 ] : 0;
-			ch3 = ( ch3 * ch3Level ) / 15;
+			ch3Level = ch3Volume;
+			renderTriangle( m_steps34, m_ch3Output, m_ch3Phase, m_wlen3, ch3Level, f );
+		}
+		else
+		{
+			ch3Level = 0;
+			setOutput( m_steps34, m_ch3Output, 0, f );
+			m_ch3Phase = m_wlen3 >= 1.0f ? fmodf( m_ch3Phase + 1.0f, m_wlen3 ) : 0.0f;
 		}
-		else ch3 = ch3Level = 0;
-		
-		m_ch3Counter++;
 		
 		
 		////////////////////////////////
@@ -333,21 +429,23 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		// render pseudo noise 
 		if( ch4Enabled )
 		{
-			ch4Level = m_parent->m_ch4EnvEnabled.value()
-				? ( static_cast<int>( m_parent->m_ch4Volume.value() ) * m_ch4EnvValue ) / 15
-				: static_cast<int>( m_parent->m_ch4Volume.value() );
-			ch4 = LFSR()
-				? ch4Level
-				: 0;
+			ch4Level = ch4EnvEnabled
+				? ( ch4Volume * m_ch4EnvValue ) / 15
+				: ch4Volume;
+			setOutput( m_steps34, m_ch4Output, LFSR() ? ch4Level : 0, f );
+		}
+		else
+		{
+			ch4Level = 0;
+			setOutput( m_steps34, m_ch4Output, 0, f );
 		}
-		else ch4 = ch4Level = 0;
 		
 		// update framecounters
 		m_ch4Counter++;
 		if( m_ch4Counter >= m_wlen4 )
 		{
 			m_ch4Counter = 0;
-			updateLFSR( m_parent->m_ch4NoiseMode.value() );
+			updateLFSR( ch4NoiseMode );
 		}
 		m_ch4EnvCounter++;
 		if( m_ch4EnvCounter >= ch4EnvLen )
@@ -383,13 +481,25 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		}
 		
 
-		////////////////////////////////
-		//	                          //
-		//  final stage - mixing      //
-		//                            //
-		////////////////////////////////			
-		
-		float pin1 = static_cast<float>( ch1 + ch2 ); 
+		levels12[f] = static_cast<float>( ch1Level + ch2Level );
+		levels34[f] = static_cast<float>( ch3Level + ch4Level );
+	} // end framebuffer loop
+
+
+	////////////////////////////////
+	//	                          //
+	//  final stage - mixing      //
+	//                            //
+	////////////////////////////////
+
+	float pins12[NesSteps::BLOCK_FRAMES];
+	float pins34[NesSteps::BLOCK_FRAMES];
+	m_steps12.read( pins12, frames );
+	m_steps34.read( pins34, frames );
+
+	for( int f = 0; f < frames; f++ )
+	{
+		float pin1 = pins12[f];
 		// add dithering noise
 		pin1 *= 1.0 + ( Oscillator::noiseSample( 0.0f ) * DITHER_AMP );		
 		pin1 = pin1 / 30.0f;
@@ -402,13 +512,13 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		pin1 = linearInterpolate( pin1, m_12Last, m_nsf );
 		m_12Last = pin1;
 
-		// compensate DC offset
-		pin1 += 1.0f - signedPow( static_cast<float>( ch1Level + ch2Level ) / 30.0f, NES_DIST );
+		// compensate DC offset, with the levels of the frame whose steps are output now
+		pin1 += 1.0f - signedPow( m_levels12[f] / 30.0f, NES_DIST );
 		
 		pin1 *= NES_MIXING_12;
 
 		
-		float pin2 = static_cast<float>( ch3 + ch4 ); 
+		float pin2 = pins34[f];
 		// add dithering noise
 		pin2 *= 1.0 + ( Oscillator::noiseSample( 0.0f ) * DITHER_AMP );		
 		pin2 = pin2 / 30.0f;
@@ -422,17 +532,66 @@ void NesObject::renderOutput( sampleFrame * buf, fpp_t frames )
 		m_34Last = pin2;
 		
 		// compensate DC offset
-		pin2 += 1.0f - signedPow( static_cast<float>( ch3Level + ch4Level ) / 30.0f, NES_DIST );
+		pin2 += 1.0f - signedPow( m_levels34[f] / 30.0f, NES_DIST );
 		
 		pin2 *= NES_MIXING_34;
 		
-		const float mixdown = ( pin1 + pin2 ) * NES_MIXING_ALL * m_parent->m_masterVol.value();
+		out[f] = ( pin1 + pin2 ) * NES_MIXING_ALL * masterVol;
+	}
+
+	std::copy( m_levels12 + frames, m_levels12 + frames + NesSteps::LAG, m_levels12 );
+	std::copy( m_levels34 + frames, m_levels34 + frames + NesSteps::LAG, m_levels34 );
+}
+
+
+// one frame of a pulse channel, which is high from the start of each
+// period up to the duty cycle
+void NesObject::renderPulse( NesSteps & steps, int & output, float & phase,
+				float wlen, float duty, int level, int frame )
+{
+	if( phase >= wlen )
+	{
+		phase = fmodf( phase, wlen );
+	}
+	const float high = wlen * duty;
+	setOutput( steps, output, phase > high ? 0 : level, frame );
+
+	const float next = phase + 1.0f;
+	if( phase <= high && next > high )
+	{
+		setOutput( steps, output, 0, frame + ( high - phase ) );
+	}
+	if( next > wlen )
+	{
+		setOutput( steps, output, level, frame + ( wlen - phase ) );
+		phase = next - wlen;
+	}
+	else
+	{
+		phase = next;
+	}
+}
 
-		buf[f][0] = mixdown;
-		buf[f][1] = mixdown;
-		
-	} // end framebuffer loop
 
+// one frame of the triangle channel, a staircase of 32 steps per period
+void NesObject::renderTriangle( NesSteps & steps, int & output, float & phase,
+				float wlen, int level, int frame )
+{
+	if( phase >= wlen )
+	{
+		phase = fmodf( phase, wlen );
+	}
+	const float stepLen = wlen / 32.0f;
+	int step = qMin( static_cast<int>( phase / stepLen ), 31 );
+	setOutput( steps, output, ( TRIANGLE_WAVETABLE[step] * level ) / 15, frame );
+
+	const float next = phase + 1.0f;
+	for( int edge = step + 1; edge * stepLen < next; ++edge )
+	{
+		setOutput( steps, output, ( TRIANGLE_WAVETABLE[edge % 32] * level ) / 15,
+					frame + ( edge * stepLen - phase ) );
+	}
+	phase = next >= wlen ? next - wlen : next;
 }
 
 
@@ -457,9 +616,9 @@ void NesObject::updatePitch()
 	// check if frequency has changed, if so, update wavelengths of ch1-3
 	if( freq != m_lastNoteFreq )
 	{
-		m_wlen1 = wavelength( freq * m_parent->m_freq1 );
-		m_wlen2 = wavelength( freq * m_parent->m_freq2 );
-		m_wlen3 = wavelength( freq * m_parent->m_freq3 );
+		m_wlen1 = exactWavelength( freq * m_parent->m_freq1 );
+		m_wlen2 = exactWavelength( freq * m_parent->m_freq2 );
+		m_wlen3 = exactWavelength( freq * m_parent->m_freq3 );
 	}
 	// noise channel can use either note freq or preset freqs
 	if( m_parent->m_ch4NoiseFreqMode.value() && freq != m_lastNoteFreq ) 
@@ -81,6 +81,52 @@ const int MIN_WLEN = 4;
 
 class NesInstrument;
 
+
+// Turns the steps of a channel's output into band-limited steps, like
+// Blip_Buffer does: a step adds a windowed sinc impulse at its exact time,
+// and the output is the running sum of the impulses. The output lags the
+// steps by LAG frames.
+class NesSteps
+{
+public:
+	static const int TAPS = 16;
+	static const int LAG = TAPS / 2 - 1;
+	static const int PHASES = 32;
+	// steps are added block by block
+	static const int BLOCK_FRAMES = 64;
+
+	NesSteps();
+
+	// a step by delta at time frames after the start of the block, which
+	// may be up to one frame past the frames read for the block
+	inline void addStep( float time, float delta )
+	{
+		const int frame = static_cast<int>( time );
+		const int phase = static_cast<int>( ( time - frame ) * PHASES + 0.5f );
+		const float * kernel = s_kernel[phase];
+		float * impulses = m_impulses + frame;
+		for( int i = 0; i < TAPS; ++i )
+		{
+			impulses[i] += delta * kernel[i];
+		}
+	}
+
+	// the band-limited signal of the first frames of the block, the
+	// impulses reaching past them are kept for the next block
+	void read( float * out, int frames );
+
+private:
+	float m_impulses[BLOCK_FRAMES + TAPS];
+	float m_sum;
+
+	// one set of taps per phase, the last one is the first of the next
+	// frame
+	static bool initKernel();
+	static float s_kernel[PHASES + 1][TAPS];
+	static bool s_kernelReady;
+};
+
+
 class NesObject
 {
 	MM_OPERATORS
@@ -128,6 +174,12 @@ public:
 	{
 		return static_cast<int>( m_samplerate / freq );
 	}
+
+	// the exact wavelength, for the band-limited channels
+	inline float exactWavelength( float freq )
+	{
+		return m_samplerate / freq;
+	}
 	
 	inline float signedPow( float f, float e )
 	{
@@ -150,6 +202,22 @@ public:
 	}
 	
 private:
+	// sets the output of a channel at time, adding the step to steps
+	inline void setOutput( NesSteps & steps, int & output, int value, float time )
+	{
+		if( value != output )
+		{
+			steps.addStep( time, static_cast<float>( value - output ) );
+			output = value;
+		}
+	}
+
+	void renderBlock( float * out, int frames );
+	void renderPulse( NesSteps & steps, int & output, float & phase,
+				float wlen, float duty, int level, int frame );
+	void renderTriangle( NesSteps & steps, int & output, float & phase,
+				float wlen, int level, int frame );
+
 	NesInstrument * m_parent;
 	const sample_rate_t m_samplerate;
 	NotePlayHandle * m_nph;
@@ -157,10 +225,23 @@ private:
 	int m_pitchUpdateCounter;
 	int m_pitchUpdateFreq;
 	
-	int m_ch1Counter;
-	int m_ch2Counter;
-	int m_ch3Counter;
+	// the phases of channels 1-3 in frames, channel 4 is clocked on
+	// whole frames
+	float m_ch1Phase;
+	float m_ch2Phase;
+	float m_ch3Phase;
 	int m_ch4Counter;
+
+	// what the channels output, and the mixed levels of the channel
+	// pairs delayed like the band-limited steps
+	int m_ch1Output;
+	int m_ch2Output;
+	int m_ch3Output;
+	int m_ch4Output;
+	NesSteps m_steps12;
+	NesSteps m_steps34;
+	float m_levels12[NesSteps::LAG + NesSteps::BLOCK_FRAMES];
+	float m_levels34[NesSteps::LAG + NesSteps::BLOCK_FRAMES];
 	
 	int m_ch1EnvCounter;
 	int m_ch2EnvCounter;
@@ -187,9 +268,9 @@ private:
 	float m_nsf;
 
 // wavelengths	
-	int m_wlen1;
-	int m_wlen2;
-	int m_wlen3;
+	float m_wlen1;
+	float m_wlen2;
+	float m_wlen3;
 	int m_wlen4;
 	
 // vibrato
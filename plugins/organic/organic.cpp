@@ -30,6 +30,7 @@
 #include <QPainter>
 
 
+#include "BufferManager.h"
 #include "Engine.h"
 #include "InstrumentTrack.h"
 #include "Knob.h"
@@ -77,7 +78,6 @@ float * organicInstrument::s_harmonics = NULL;
 
 organicInstrument::organicInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &organic_plugin_descriptor ),
-	m_modulationAlgo( Oscillator::SignalMix, Oscillator::SignalMix, Oscillator::SignalMix),
 	m_fx1Model( 0.0f, 0.0f, 0.99f, 0.01f , this, tr( "Distortion" ) ),
 	m_volModel( 100.0f, 0.0f, 200.0f, 1.0f, this, tr( "Volume" ) )
 {
@@ -143,6 +143,12 @@ organicInstrument::organicInstrument( InstrumentTrack * _instrument_track ) :
 	}
 	
 
+	for( int i = 0; i < Oscillator::NumWaveShapes; ++i )
+	{
+		m_waveTables[i] = WaveMipMapCache::get(
+				static_cast<Oscillator::WaveShapes>( i ) );
+	}
+
 	connect( Engine::mixer(), SIGNAL( sampleRateChanged() ),
 					this, SLOT( updateAllDetuning() ) );	
 }
@@ -232,74 +238,59 @@ void organicInstrument::playNote( NotePlayHandle * _n,
 	
 	if( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		Oscillator * oscs_l[NUM_OSCILLATORS];
-		Oscillator * oscs_r[NUM_OSCILLATORS];
-
-		_n->m_pluginData = new oscPtr;
-
+		oscPtr * data = new oscPtr;
 		for( int i = m_numOscillators - 1; i >= 0; --i )
 		{
-			static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i] 
-				= rand() / ( RAND_MAX + 1.0f );
-			static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i] 
-				= rand() / ( RAND_MAX + 1.0f );
-			
-			// initialise ocillators
-			
-			if( i == m_numOscillators - 1 )
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
-						m_osc[i]->m_volumeLeft );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i],
-						m_osc[i]->m_volumeRight );
-			}
-			else
+			data->phaseLeft[i] = rand() / ( RAND_MAX + 1.0f );
+			data->phaseRight[i] = rand() / ( RAND_MAX + 1.0f );
+		}
+		_n->m_pluginData = data;
+	}
+
+	oscPtr * data = static_cast<oscPtr *>( _n->m_pluginData );
+	sampleFrame * buf = _working_buffer + offset;
+	BufferManager::clear( buf, frames );
+
+	// every oscillator plays its wave from the table for its own pitch,
+	// a block of phases at a time
+	const float freq = _n->frequency();
+	const int BlockSize = 64;
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( int i = 0; freq < Engine::mixer()->processingSampleRate() / 2 &&
+						i < m_numOscillators; ++i )
+	{
+		const WaveMipMap * table =
+				m_waveTables[m_osc[i]->m_waveShape.value()].get();
+		if( table == NULL )
+		{
+			continue;
+		}
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			float & phase = ch == 0 ? data->phaseLeft[i] : data->phaseRight[i];
+			const float coeff = freq * ( ch == 0 ? m_osc[i]->m_detuningLeft
+						: m_osc[i]->m_detuningRight );
+			const float volume = ch == 0 ? m_osc[i]->m_volumeLeft
+						: m_osc[i]->m_volumeRight;
+			const float wavelen = BandLimitedWave::pdToLen( coeff );
+			for( fpp_t start = 0; start < frames; start += BlockSize )
 			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
-						m_osc[i]->m_volumeLeft,
-						oscs_l[i + 1] );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i],
-						m_osc[i]->m_volumeRight,
-						oscs_r[i + 1] );
+				const int count = qMin<int>( BlockSize, frames - start );
+				for( int f = 0; f < count; ++f )
+				{
+					phases[f] = phase + f * coeff;
+				}
+				phase = absFraction( phase + count * coeff );
+				BandLimitedWave::oscillate( phases, wave, count, wavelen, *table );
+				for( int f = 0; f < count; ++f )
+				{
+					buf[start + f][ch] += wave[f] * volume;
+				}
 			}
-			
-				
 		}
-
-		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
-		static_cast<oscPtr *>( _n->m_pluginData )->oscRight = oscs_r[0];
 	}
 
-	Oscillator * osc_l = static_cast<oscPtr *>( _n->m_pluginData )->oscLeft;
-	Oscillator * osc_r = static_cast<oscPtr *>( _n->m_pluginData)->oscRight;
-
-	osc_l->update( _working_buffer + offset, frames, 0 );
-	osc_r->update( _working_buffer + offset, frames, 1 );
-
 
 	// -- fx section --
 	
@@ -324,11 +315,6 @@ void organicInstrument::playNote( NotePlayHandle * _n,
 
 void organicInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-	
 	delete static_cast<oscPtr *>( _n->m_pluginData );
 }
 
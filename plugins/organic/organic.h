@@ -32,6 +32,7 @@
 #include "InstrumentView.h"
 #include "Oscillator.h"
 #include "AutomatableModel.h"
+#include "WaveMipMapCache.h"
 
 class QPixmap;
 
@@ -152,13 +153,12 @@ private:
 	struct oscPtr
 	{
 		MM_OPERATORS
-		Oscillator * oscLeft;
-		Oscillator * oscRight;
-		float phaseOffsetLeft[NUM_OSCILLATORS];
-		float phaseOffsetRight[NUM_OSCILLATORS];		
+		float phaseLeft[NUM_OSCILLATORS];
+		float phaseRight[NUM_OSCILLATORS];
 	} ;
 
-	const IntModel m_modulationAlgo;
+	// band-limited tables of the waves, shared by all instances
+	WaveMipMapCache::MipMapPtr m_waveTables[Oscillator::NumWaveShapes];
 
 	FloatModel  m_fx1Model;
 	FloatModel  m_volModel;
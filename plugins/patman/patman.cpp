@@ -28,6 +28,14 @@
 #include <QDragEnterEvent>
 #include <QPainter>
 #include <QDomElement>
+#include <QFileInfo>
+#include <QMutex>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <tuple>
 
 #include "ConfigManager.h"
 #include "endian_handling.h"
@@ -131,6 +139,27 @@ QString patmanInstrument::nodeName( void ) const
 
 
 
+qint64 patmanInstrument::memoryUsage() const
+{
+	// patches are shared by the instruments which loaded the same file
+	const std::shared_ptr<const PatchSamples> patch =
+						std::atomic_load( &m_patch );
+	if( !patch )
+	{
+		return 0;
+	}
+	qint64 bytes = 0;
+	for( const SampleBuffer * sample : patch->samples )
+	{
+		bytes += sample->memoryUsage();
+	}
+	// not counting the reference held here
+	return bytes / std::max<long>( patch.use_count() - 1, 1 );
+}
+
+
+
+
 void patmanInstrument::playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
@@ -211,11 +240,57 @@ void patmanInstrument::setFile( const QString & _patch_file, bool _rename )
 
 
 
+// patches decoded by any instrument, by path, size and modification time
+typedef std::tuple<QString, qint64, qint64> PatchKey;
+static QMutex s_patchMutex;
+static std::map<PatchKey, std::weak_ptr<const PatchSamples> > s_patches;
+
+
+
+
 patmanInstrument::LoadErrors patmanInstrument::loadPatch(
 						const QString & _filename )
 {
 	unloadCurrentPatch();
 
+	const QFileInfo info( _filename );
+	const PatchKey key( info.absoluteFilePath(), info.size(),
+			info.lastModified().toMSecsSinceEpoch() );
+
+	// decoding under the lock lets all tracks loading the same patch,
+	// e.g. while a project is opened, wait for the first one
+	QMutexLocker lock( &s_patchMutex );
+	for( auto it = s_patches.begin(); it != s_patches.end(); )
+	{
+		it = it->second.expired() ? s_patches.erase( it ) : std::next( it );
+	}
+
+	auto cached = s_patches.find( key );
+	if( cached != s_patches.end() )
+	{
+		std::atomic_store( &m_patch, cached->second.lock() );
+		return( LoadOK );
+	}
+
+	std::shared_ptr<PatchSamples> patch = std::make_shared<PatchSamples>();
+	const LoadErrors error = decodePatch( _filename, patch->samples );
+	patch->prepareSelection();
+	if( error == LoadOK )
+	{
+		s_patches[key] = patch;
+	}
+	// the samples decoded before an error are played anyway
+	std::atomic_store( &m_patch,
+			std::shared_ptr<const PatchSamples>( patch ) );
+	return( error );
+}
+
+
+
+
+patmanInstrument::LoadErrors patmanInstrument::decodePatch(
+		const QString & _filename, QVector<SampleBuffer *> & _samples )
+{
 	FILE * fd = fopen( _filename.toUtf8().constData() , "rb" );
 	if( !fd )
 	{
@@ -365,8 +440,10 @@ patmanInstrument::LoadErrors patmanInstrument::loadPatch(
 			psample->setLoopStartFrame( loop_start );
 			psample->setLoopEndFrame( loop_end );
 		}
+		// the samples are only played, so they can be kept compressed
+		psample->setCompressible( true );
 
-		m_patchSamples.push_back( psample );
+		_samples.push_back( psample );
 
 		delete[] wave_samples;
 		delete[] data;
@@ -380,11 +457,7 @@ patmanInstrument::LoadErrors patmanInstrument::loadPatch(
 
 void patmanInstrument::unloadCurrentPatch( void )
 {
-	while( !m_patchSamples.empty() )
-	{
-		sharedObject::unref( m_patchSamples.back() );
-		m_patchSamples.pop_back();
-	}
+	std::atomic_store( &m_patch, std::shared_ptr<const PatchSamples>() );
 }
 
 
@@ -392,23 +465,9 @@ void patmanInstrument::unloadCurrentPatch( void )
 
 void patmanInstrument::selectSample( NotePlayHandle * _n )
 {
-	const float freq = _n->frequency();
-
-	float min_dist = HUGE_VALF;
-	SampleBuffer* sample = NULL;
-
-	for( QVector<SampleBuffer *>::iterator it = m_patchSamples.begin(); it != m_patchSamples.end(); ++it )
-	{
-		float patch_freq = ( *it )->frequency();
-		float dist = freq >= patch_freq ? freq / patch_freq :
-							patch_freq / freq;
-
-		if( dist < min_dist )
-		{
-			min_dist = dist;
-			sample = *it;
-		}
-	}
+	const std::shared_ptr<const PatchSamples> patch =
+						std::atomic_load( &m_patch );
+	SampleBuffer * sample = patch ? patch->select( _n->frequency() ) : NULL;
 
 	handle_data * hdata = new handle_data;
 	hdata->tuned = m_tunedModel.value();
@@ -428,6 +487,67 @@ void patmanInstrument::selectSample( NotePlayHandle * _n )
 
 
 
+PatchSamples::~PatchSamples()
+{
+	for( SampleBuffer * sample : samples )
+	{
+		sharedObject::unref( sample );
+	}
+}
+
+
+
+
+void PatchSamples::prepareSelection()
+{
+	m_byFrequency.clear();
+	m_bounds.clear();
+
+	// samples without a root frequency are never the nearest one
+	for( SampleBuffer * sample : samples )
+	{
+		if( sample->frequency() > 0.0f )
+		{
+			m_byFrequency.push_back( sample );
+		}
+	}
+	std::stable_sort( m_byFrequency.begin(), m_byFrequency.end(),
+		[]( const SampleBuffer * a, const SampleBuffer * b )
+		{
+			return a->frequency() < b->frequency();
+		} );
+	m_byFrequency.erase( std::unique( m_byFrequency.begin(), m_byFrequency.end(),
+		[]( const SampleBuffer * a, const SampleBuffer * b )
+		{
+			return a->frequency() == b->frequency();
+		} ), m_byFrequency.end() );
+
+	// the nearest sample is the one with the smallest frequency ratio,
+	// so the selection changes at the geometric mean of two neighbours
+	for( size_t i = 1; i < m_byFrequency.size(); ++i )
+	{
+		m_bounds.push_back( sqrtf( m_byFrequency[i - 1]->frequency() *
+						m_byFrequency[i]->frequency() ) );
+	}
+}
+
+
+
+
+SampleBuffer * PatchSamples::select( float _freq ) const
+{
+	if( m_byFrequency.empty() )
+	{
+		return( NULL );
+	}
+	const size_t i = std::upper_bound( m_bounds.begin(), m_bounds.end(),
+						_freq ) - m_bounds.begin();
+	return( m_byFrequency[i] );
+}
+
+
+
+
 PluginView * patmanInstrument::instantiateView( QWidget * _parent )
 {
 	return( new PatmanView( this, _parent ) );
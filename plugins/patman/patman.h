@@ -26,6 +26,9 @@
 #ifndef PATMAN_H_
 #define PATMAN_H_
 
+#include <memory>
+#include <vector>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "SampleBuffer.h"
@@ -45,6 +48,33 @@ class PixmapButton;
 #define MODES_CLAMPED	( 1 << 7 )
 
 
+// the decoded samples of a patch file, shared by all instruments loading
+// the same file
+class PatchSamples
+{
+public:
+	~PatchSamples();
+
+	// sorts the samples by root frequency for select()
+	void prepareSelection();
+
+	// the sample with the root frequency nearest to _freq, or NULL
+	SampleBuffer * select( float _freq ) const;
+
+	// in the order of the file
+	QVector<SampleBuffer *> samples;
+
+private:
+	// one sample per root frequency, the first of the file, and the
+	// frequencies halfway between neighbours where the selection changes
+	std::vector<SampleBuffer *> m_byFrequency;
+	std::vector<float> m_bounds;
+
+} ;
+
+
+
+
 class patmanInstrument : public Instrument
 {
 	Q_OBJECT
@@ -64,6 +94,8 @@ public:
 
 	virtual QString nodeName( void ) const;
 
+	qint64 memoryUsage() const override;
+
 	virtual f_cnt_t desiredReleaseFrames( void ) const
 	{
 		return( 128 );
@@ -86,7 +118,7 @@ private:
 	} handle_data;
 
 	QString m_patchFile;
-	QVector<SampleBuffer *> m_patchSamples;
+	std::shared_ptr<const PatchSamples> m_patch;
 	BoolModel m_loopedModel;
 	BoolModel m_tunedModel;
 
@@ -102,6 +134,8 @@ private:
 	} ;
 
 	LoadErrors loadPatch( const QString & _filename );
+	static LoadErrors decodePatch( const QString & _filename,
+					QVector<SampleBuffer *> & _samples );
 	void unloadCurrentPatch( void );
 
 	void selectSample( NotePlayHandle * _n );
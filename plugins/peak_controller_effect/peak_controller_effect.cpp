@@ -30,6 +30,7 @@
 #include "PeakController.h"
 #include "peak_controller_effect.h"
 #include "lmms_math.h"
+#include "MixHelpers.h"
 
 #include "embed.h"
 #include "plugin_export.h"
@@ -107,11 +108,9 @@ bool PeakControllerEffect::processAudioBuffer( sampleFrame * _buf,
 
 	if( c.m_absModel.value() )
 	{
-		for( int i = 0; i < _frames; ++i )
-		{
-			// absolute value is achieved because the squares are > 0
-			sum += _buf[i][0]*_buf[i][0] + _buf[i][1]*_buf[i][1];
-		}
+		// absolute value is achieved because the squares are > 0, which
+		// is what the vectorized analysis kernel sums up
+		sum = MixHelpers::analyze( _buf, _frames ).meanSquare * _frames;
 	}
 	else
 	{
@@ -30,6 +30,7 @@
 #include <QLabel>
 #include <QDomDocument>
 
+#include "BufferManager.h"
 #include "ConfigManager.h"
 #include "FileDialog.h"
 #include "ConfigManager.h"
@@ -335,6 +336,16 @@ QString sf2Instrument::nodeName() const
 
 
 
+qint64 sf2Instrument::memoryUsage() const
+{
+	// fonts are shared by the instruments which loaded the same file
+	QMutexLocker locker( &s_fontsMutex );
+	return m_font ? m_font->fileSize / m_font->refCount : 0;
+}
+
+
+
+
 void sf2Instrument::freeFont()
 {
 	m_synthMutex.lock();
@@ -360,9 +371,9 @@ void sf2Instrument::freeFont()
 
 			fluid_synth_remove_sfont( m_synth, m_font->fluidFont );
 		}
-		s_fontsMutex.unlock();
-
+		// under the lock, for memoryUsage()
 		m_font = NULL;
+		s_fontsMutex.unlock();
 	}
 	m_synthMutex.unlock();
 }
@@ -406,7 +417,8 @@ void sf2Instrument::openFile( const QString & _sf2File, bool updateTrackName )
 			if( fluid_synth_sfcount( m_synth ) > 0 )
 			{
 				// Grab this sf from the top of the stack and add to list
-				m_font = new sf2Font( fluid_synth_get_sfont( m_synth, 0 ) );
+				m_font = new sf2Font( fluid_synth_get_sfont( m_synth, 0 ),
+					QFileInfo( PathUtil::toAbsolute( _sf2File ) ).size() );
 				s_fonts.insert( relativePath, m_font );
 				loaded = true;
 			}
@@ -603,6 +615,14 @@ void sf2Instrument::updateSampleRate()
 		}
 		m_synthMutex.unlock();
 	}
+	else if( m_srcState != NULL )
+	{
+		// fluidsynth runs at the rate of the engine again
+		m_synthMutex.lock();
+		src_delete( m_srcState );
+		m_srcState = NULL;
+		m_synthMutex.unlock();
+	}
 	updateReverb();
 	updateChorus();
 	updateReverbOn();
@@ -817,6 +837,16 @@ void sf2Instrument::play( sampleFrame * _working_buffer )
 void sf2Instrument::renderFrames( f_cnt_t frames, sampleFrame * buf )
 {
 	m_synthMutex.lock();
+	// without a voice sounding or an effect with a tail, fluidsynth would
+	// only render silence, which is the common case in projects with
+	// many SoundFont tracks of which only a few play at a time
+	if( !m_reverbOn.value() && !m_chorusOn.value() &&
+			fluid_synth_get_active_voice_count( m_synth ) == 0 )
+	{
+		m_synthMutex.unlock();
+		BufferManager::clear( buf, frames );
+		return;
+	}
 	if( m_internalSampleRate < Engine::mixer()->processingSampleRate() &&
 							m_srcState != NULL )
 	{
@@ -74,6 +74,8 @@ public:
 
 	virtual QString nodeName() const;
 
+	qint64 memoryUsage() const override;
+
 	virtual f_cnt_t desiredReleaseFrames() const
 	{
 		return 0;
@@ -176,13 +178,16 @@ class sf2Font
 {
 	MM_OPERATORS
 public:
-	sf2Font( fluid_sfont_t * f ) :
+	sf2Font( fluid_sfont_t * f, qint64 fileSize ) :
 		fluidFont( f ),
-		refCount( 1 )
+		refCount( 1 ),
+		fileSize( fileSize )
 	{};
 
 	fluid_sfont_t * fluidFont;
 	int refCount;
+	// FluidSynth keeps the samples of the whole file in memory
+	qint64 fileSize;
 };
 
 
@@ -355,6 +355,19 @@ sfxrInstrument::sfxrInstrument( InstrumentTrack * _instrument_track ) :
 	m_hpFilCutSweepModel(0.0f, this, "HP Filter Cutoff Sweep"),
 	m_waveFormModel( SQR_WAVE, 0, WAVES_NUM-1, this, tr( "Wave" ) )
 {
+	m_soundModels << &m_attModel << &m_holdModel << &m_susModel << &m_decModel
+		<< &m_startFreqModel << &m_minFreqModel << &m_slideModel
+		<< &m_dSlideModel << &m_vibDepthModel << &m_vibSpeedModel
+		<< &m_changeAmtModel << &m_changeSpeedModel << &m_sqrDutyModel
+		<< &m_sqrSweepModel << &m_repeatSpeedModel << &m_phaserOffsetModel
+		<< &m_phaserSweepModel << &m_lpFilCutModel << &m_lpFilCutSweepModel
+		<< &m_lpFilResoModel << &m_hpFilCutModel << &m_hpFilCutSweepModel
+		<< &m_waveFormModel;
+	for( const AutomatableModel * model : m_soundModels )
+	{
+		connect( model, SIGNAL( dataChanged() ),
+				this, SLOT( clearOneShots() ) );
+	}
 }
 
 
@@ -452,6 +465,61 @@ QString sfxrInstrument::nodeName() const
 
 
 
+// renders at 44.1 kHz whatever the pitch, frame by frame to tell at which
+// frame the synth stops playing
+class SfxrRecorder : public OneShotCache::Recorder
+{
+	MM_OPERATORS
+public:
+	SfxrRecorder( const sfxrInstrument * s ) :
+		m_synth( s )
+	{
+	}
+
+	f_cnt_t render( sampleFrame * buf, f_cnt_t frames ) override
+	{
+		f_cnt_t over = frames;
+		for( f_cnt_t f = 0; f < frames; ++f )
+		{
+			m_synth.update( buf + f, 1 );
+			if( over == frames && !m_synth.isPlaying() )
+			{
+				over = f;
+			}
+		}
+		return over;
+	}
+
+private:
+	SfxrSynth m_synth;
+} ;
+
+
+
+
+bool sfxrInstrument::isAutomated() const
+{
+	for( const AutomatableModel * model : m_soundModels )
+	{
+		if( model->isAutomatedOrControlled() )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+void sfxrInstrument::clearOneShots()
+{
+	m_oneShots.clear();
+}
+
+
+
+
 void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffer )
 {
 	float currentSampleRate = Engine::mixer()->processingSampleRate();
@@ -460,9 +528,34 @@ void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffe
     const f_cnt_t offset = _n->noteOffset();
 	if ( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		_n->m_pluginData = new SfxrSynth( this );
+		// the synth doesn't know the pitch, so all notes share a one-shot,
+		// unless the noise makes every hit a different one
+		OneShotCache::TakePtr take;
+		if( Engine::mixer()->oneShotCaching() &&
+			m_waveFormModel.value() != NOISE_WAVE && !isAutomated() )
+		{
+			QByteArray key;
+			key.reserve( m_soundModels.size() * sizeof( float ) );
+			for( const AutomatableModel * model : m_soundModels )
+			{
+				const float value = model->value<float>();
+				key.append( reinterpret_cast<const char *>( &value ),
+								sizeof( value ) );
+			}
+			take = m_oneShots.find( key );
+			if( !take )
+			{
+				take = m_oneShots.insert( key, new SfxrRecorder( this ) );
+			}
+		}
+		else
+		{
+			take = OneShotCache::uncached( new SfxrRecorder( this ) );
+		}
+		delete static_cast<OneShotCache::Player *>( _n->m_pluginData );
+		_n->m_pluginData = new OneShotCache::Player( take );
 	}
-	else if( static_cast<SfxrSynth*>(_n->m_pluginData)->isPlaying() == false )
+	else if( static_cast<OneShotCache::Player *>( _n->m_pluginData )->isOver() )
 	{
 		memset(_working_buffer + offset, 0, sizeof(sampleFrame) * frameNum);
 		_n->noteOff();
@@ -477,7 +570,7 @@ void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffe
 //	qDebug( "pFN %d", pitchedFrameNum );
 
 	sampleFrame * pitchedBuffer = new sampleFrame[pitchedFrameNum];
-	static_cast<SfxrSynth*>(_n->m_pluginData)->update( pitchedBuffer, pitchedFrameNum );
+	static_cast<OneShotCache::Player *>( _n->m_pluginData )->play( pitchedBuffer, pitchedFrameNum );
 	for( fpp_t i=0; i<frameNum; i++ )
 	{
 		for( ch_cnt_t j=0; j<DEFAULT_CHANNELS; j++ )
@@ -499,7 +592,7 @@ void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffe
 
 void sfxrInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<SfxrSynth *>( _n->m_pluginData );
+	delete static_cast<OneShotCache::Player *>( _n->m_pluginData );
 }
 
 
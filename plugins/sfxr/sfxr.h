@@ -35,6 +35,7 @@
 #include "PixmapButton.h"
 #include "LedCheckbox.h"
 #include "MemoryManager.h"
+#include "OneShotCache.h"
 
 
 enum SfxrWaves
@@ -185,7 +186,14 @@ public:
 	void resetModels();
 
 
+private slots:
+	void clearOneShots();
+
+
 private:
+	// whether the models of the sound are automated or controlled
+	bool isAutomated() const;
+
 	SfxrZeroToOneFloatModel m_attModel;
 	SfxrZeroToOneFloatModel m_holdModel;
 	SfxrZeroToOneFloatModel m_susModel;
@@ -217,6 +225,9 @@ private:
 
 	IntModel m_waveFormModel;
 
+	AutomatableModel::AutoModelVector m_soundModels;
+	OneShotCache m_oneShots;
+
 	friend class sfxrInstrumentView;
 	friend class SfxrSynth;
 };
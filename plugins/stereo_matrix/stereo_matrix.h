@@ -43,6 +43,11 @@ public:
 		return( &m_smControls );
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
 
 private:
 	stereoMatrixControls m_smControls;
@@ -29,6 +29,8 @@
 #include <QDir>
 #include <QMessageBox>
 
+#include <iterator>
+
 #include "BandedWG.h"
 #include "ModalBar.h"
 #include "TubeBell.h"
@@ -63,6 +65,12 @@ Plugin::Descriptor PLUGIN_EXPORT malletsstk_plugin_descriptor =
 }
 
 
+// STK is not thread-safe, and its sample rate is global
+static QMutex s_stkMutex;
+
+
+
+
 malletsInstrument::malletsInstrument( InstrumentTrack * _instrument_track ):
 	Instrument( _instrument_track, &malletsstk_plugin_descriptor ),
 	m_hardnessModel(64.0f, 0.0f, 128.0f, 0.1f, this, tr( "Hardness" )),
@@ -120,6 +128,12 @@ malletsInstrument::malletsInstrument( InstrumentTrack * _instrument_track ):
 	m_scalers.append( 16.0 );
 	m_presetsModel.addItem( tr( "Tibetan bowl" ) );
 	m_scalers.append( 7.0 );
+
+	connect( &m_presetsModel, SIGNAL( dataChanged() ),
+			this, SLOT( prefillVoices() ) );
+	connect( Engine::mixer(), SIGNAL( sampleRateChanged() ),
+			this, SLOT( prefillVoices() ) );
+	prefillVoices();
 }
 
 
@@ -127,6 +141,10 @@ malletsInstrument::malletsInstrument( InstrumentTrack * _instrument_track ):
 
 malletsInstrument::~malletsInstrument()
 {
+	for( malletsSynth * voice : m_idleVoices )
+	{
+		delete voice;
+	}
 }
 
 
@@ -295,12 +313,15 @@ void malletsInstrument::playNote( NotePlayHandle * _n,
 			m_isOldVersionModel.value() ? 100.0 : 200.0;
 		const float vel = _n->getVolume() / velocityAdjust;
 
+		malletsSynth * voice = takeVoice( voiceType( p ),
+				Engine::mixer()->processingSampleRate() );
+
 		// critical section as STK is not thread-safe
-		static QMutex m;
-		m.lock();
-		if( p < 9 )
+		QMutexLocker lock( &s_stkMutex );
+		switch( voice->type() )
 		{
-			_n->m_pluginData = new malletsSynth( freq,
+			case malletsSynth::ModalBarVoice:
+				voice->startModalBar( freq,
 						vel,
 						m_stickModel.value(),
 						m_hardnessModel.value(),
@@ -308,12 +329,10 @@ void malletsInstrument::playNote( NotePlayHandle * _n,
 						m_vibratoGainModel.value(),
 						m_vibratoFreqModel.value(),
 						p,
-						(uint8_t) m_spreadModel.value(),
-				Engine::mixer()->processingSampleRate() );
-		}
-		else if( p == 9 )
-		{
-			_n->m_pluginData = new malletsSynth( freq,
+						(uint8_t) m_spreadModel.value() );
+				break;
+			case malletsSynth::TubeBellVoice:
+				voice->startTubeBell( freq,
 						vel,
 						p,
 						m_lfoDepthModel.value(),
@@ -321,12 +340,10 @@ void malletsInstrument::playNote( NotePlayHandle * _n,
 						m_crossfadeModel.value(),
 						m_lfoSpeedModel.value(),
 						m_adsrModel.value(),
-						(uint8_t) m_spreadModel.value(),
-				Engine::mixer()->processingSampleRate() );
-		}
-		else
-		{
-			_n->m_pluginData = new malletsSynth( freq,
+						(uint8_t) m_spreadModel.value() );
+				break;
+			case malletsSynth::BandedWGVoice:
+				voice->startBandedWG( freq,
 						vel,
 						m_pressureModel.value(),
 						m_motionModel.value(),
@@ -334,11 +351,11 @@ void malletsInstrument::playNote( NotePlayHandle * _n,
 						p - 10,
 						m_strikeModel.value() * 128.0,
 						m_velocityModel.value(),
-						(uint8_t) m_spreadModel.value(),
-				Engine::mixer()->processingSampleRate() );
+						(uint8_t) m_spreadModel.value() );
+				break;
 		}
-		m.unlock();
-		static_cast<malletsSynth *>(_n->m_pluginData)->setPresetIndex(p);
+		voice->setPresetIndex( p );
+		_n->m_pluginData = voice;
 	}
 
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
@@ -370,7 +387,113 @@ void malletsInstrument::playNote( NotePlayHandle * _n,
 
 void malletsInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<malletsSynth *>( _n->m_pluginData );
+	giveVoice( static_cast<malletsSynth *>( _n->m_pluginData ) );
+}
+
+
+
+
+malletsSynth::VoiceTypes malletsInstrument::voiceType( int _preset )
+{
+	if( _preset < 9 )
+	{
+		return malletsSynth::ModalBarVoice;
+	}
+	return _preset == 9 ? malletsSynth::TubeBellVoice : malletsSynth::BandedWGVoice;
+}
+
+
+
+
+void malletsInstrument::prefillVoices()
+{
+	if( m_filesMissing )
+	{
+		return;
+	}
+
+	const malletsSynth::VoiceTypes type = voiceType( m_presetsModel.value() );
+	const sample_rate_t sampleRate = Engine::mixer()->processingSampleRate();
+
+	int missing = PrefillVoices;
+	{
+		QMutexLocker lock( &m_voiceMutex );
+		for( malletsSynth * voice : m_idleVoices )
+		{
+			if( voice->type() == type && voice->sampleRate() == sampleRate )
+			{
+				--missing;
+			}
+		}
+	}
+
+	for( ; missing > 0; --missing )
+	{
+		malletsSynth * voice;
+		{
+			QMutexLocker lock( &s_stkMutex );
+			voice = new malletsSynth( type, sampleRate );
+		}
+		if( !voice->isValid() )
+		{
+			delete voice;
+			return;
+		}
+		giveVoice( voice );
+	}
+}
+
+
+
+
+malletsSynth * malletsInstrument::takeVoice( malletsSynth::VoiceTypes _type,
+						sample_rate_t _sample_rate )
+{
+	{
+		QMutexLocker lock( &m_voiceMutex );
+		for( auto it = m_idleVoices.rbegin(); it != m_idleVoices.rend(); ++it )
+		{
+			if( (*it)->type() == _type && (*it)->sampleRate() == _sample_rate )
+			{
+				malletsSynth * voice = *it;
+				m_idleVoices.erase( std::next( it ).base() );
+				return voice;
+			}
+		}
+	}
+
+	// more notes at once than prefilled voices
+	QMutexLocker lock( &s_stkMutex );
+	return new malletsSynth( _type, _sample_rate );
+}
+
+
+
+
+void malletsInstrument::giveVoice( malletsSynth * _voice )
+{
+	if( !_voice->isValid() )
+	{
+		delete _voice;
+		return;
+	}
+
+	{
+		QMutexLocker lock( &s_stkMutex );
+		_voice->reset();
+	}
+
+	malletsSynth * dropped = NULL;
+	{
+		QMutexLocker lock( &m_voiceMutex );
+		m_idleVoices.push_back( _voice );
+		if( m_idleVoices.size() > static_cast<size_t>( MaxIdleVoices ) )
+		{
+			dropped = m_idleVoices.front();
+			m_idleVoices.erase( m_idleVoices.begin() );
+		}
+	}
+	delete dropped;
 }
 
 
@@ -605,18 +728,33 @@ void malletsInstrumentView::changePreset()
 
 
 
-// ModalBar
-malletsSynth::malletsSynth( const StkFloat _pitch,
-				const StkFloat _velocity,
-				const StkFloat _control1,
-				const StkFloat _control2,
-				const StkFloat _control4,
-				const StkFloat _control8,
-				const StkFloat _control11,
-				const int _control16,
-				const uint8_t _delay,
+// TubeBell doesn't clear its envelopes and oscillators by itself
+class ResettableTubeBell : public TubeBell
+{
+public:
+	void clear()
+	{
+		for( size_t i = 0; i < adsr_.size(); ++i )
+		{
+			adsr_[i]->setValue( 0.0 );
+		}
+		for( size_t i = 0; i < waves_.size(); ++i )
+		{
+			waves_[i]->reset();
+		}
+	}
+} ;
+
+
+
+
+malletsSynth::malletsSynth( const VoiceTypes _type,
 				const sample_rate_t _sample_rate ) :
-	m_presetIndex(0)
+	m_type( _type ),
+	m_sampleRate( _sample_rate ),
+	m_presetIndex(0),
+	m_delayRead( 0 ),
+	m_delayWrite( 0 )
 {
 	try
 	{
@@ -627,37 +765,63 @@ malletsSynth::malletsSynth( const StkFloat _pitch,
 		Stk::showWarnings( false );
 #endif
 
-		m_voice = new ModalBar();
-	
-		m_voice->controlChange( 16, _control16 );
-		m_voice->controlChange( 1, _control1 );
-		m_voice->controlChange( 2, _control2 );
-		m_voice->controlChange( 4, _control4 );
-		m_voice->controlChange( 8, _control8 );
-		m_voice->controlChange( 11, _control11 );
-		m_voice->controlChange( 128, 128.0f );
-		
-		m_voice->noteOn( _pitch, _velocity );
+		switch( _type )
+		{
+			case ModalBarVoice:
+				m_voice = new ModalBar();
+				break;
+			case TubeBellVoice:
+				m_voice = new ResettableTubeBell();
+				break;
+			case BandedWGVoice:
+				m_voice = new BandedWG();
+				break;
+		}
 	}
 	catch( ... )
 	{
 		m_voice = NULL;
 	}
-	
+
 	m_delay = new StkFloat[256];
-	m_delayRead = 0;
-	m_delayWrite = _delay;
-	for( int i = 0; i < 256; i++ )
+	startDelay( 0 );
+}
+
+
+
+
+void malletsSynth::startModalBar( const StkFloat _pitch,
+				const StkFloat _velocity,
+				const StkFloat _control1,
+				const StkFloat _control2,
+				const StkFloat _control4,
+				const StkFloat _control8,
+				const StkFloat _control11,
+				const int _control16,
+				const uint8_t _delay )
+{
+	startDelay( _delay );
+	if( m_voice == NULL )
 	{
-		m_delay[i] = 0.0;
+		return;
 	}
+	Stk::setSampleRate( m_sampleRate );
+
+	m_voice->controlChange( 16, _control16 );
+	m_voice->controlChange( 1, _control1 );
+	m_voice->controlChange( 2, _control2 );
+	m_voice->controlChange( 4, _control4 );
+	m_voice->controlChange( 8, _control8 );
+	m_voice->controlChange( 11, _control11 );
+	m_voice->controlChange( 128, 128.0f );
+	
+	m_voice->noteOn( _pitch, _velocity );
 }
 
 
 
 
-// TubeBell
-malletsSynth::malletsSynth( const StkFloat _pitch,
+void malletsSynth::startTubeBell( const StkFloat _pitch,
 				const StkFloat _velocity,
 				const int _preset,
 				const StkFloat _control1,
@@ -665,48 +829,28 @@ malletsSynth::malletsSynth( const StkFloat _pitch,
 				const StkFloat _control4,
 				const StkFloat _control11,
 				const StkFloat _control128,
-				const uint8_t _delay,
-				const sample_rate_t _sample_rate ) :
-	m_presetIndex(0)
+				const uint8_t _delay )
 {
-	try
-	{
-		Stk::setSampleRate( _sample_rate );
-		Stk::setRawwavePath( QDir( ConfigManager::inst()->stkDir() ).absolutePath()
-						.toLocal8Bit().constData() );
-#ifndef LMMS_DEBUG
-		Stk::showWarnings( false );
-#endif
-
-		m_voice = new TubeBell();
-	
-		m_voice->controlChange( 1, _control1 );
-		m_voice->controlChange( 2, _control2 );
-		m_voice->controlChange( 4, _control4 );
-		m_voice->controlChange( 11, _control11 );
-		m_voice->controlChange( 128, _control128 );
-	
-		m_voice->noteOn( _pitch, _velocity );
-	}
-	catch( ... )
-	{
-		m_voice = NULL;
-	}
-	
-	m_delay = new StkFloat[256];
-	m_delayRead = 0;
-	m_delayWrite = _delay;
-	for( int i = 0; i < 256; i++ )
+	startDelay( _delay );
+	if( m_voice == NULL )
 	{
-		m_delay[i] = 0.0;
+		return;
 	}
+	Stk::setSampleRate( m_sampleRate );
+
+	m_voice->controlChange( 1, _control1 );
+	m_voice->controlChange( 2, _control2 );
+	m_voice->controlChange( 4, _control4 );
+	m_voice->controlChange( 11, _control11 );
+	m_voice->controlChange( 128, _control128 );
+
+	m_voice->noteOn( _pitch, _velocity );
 }
 
 
 
 
-// BandedWG
-malletsSynth::malletsSynth( const StkFloat _pitch,
+void malletsSynth::startBandedWG( const StkFloat _pitch,
 				const StkFloat _velocity,
 				const StkFloat _control2,
 				const StkFloat _control4,
@@ -714,37 +858,55 @@ malletsSynth::malletsSynth( const StkFloat _pitch,
 				const int _control16,
 				const StkFloat _control64,
 				const StkFloat _control128,
-				const uint8_t _delay,
-				const sample_rate_t _sample_rate ) :
-	m_presetIndex(0)
+				const uint8_t _delay )
 {
-	try
+	startDelay( _delay );
+	if( m_voice == NULL )
 	{
-		Stk::setSampleRate( _sample_rate );
-		Stk::setRawwavePath( QDir( ConfigManager::inst()->stkDir() ).absolutePath()
-						.toLocal8Bit().constData() );
-#ifndef LMMS_DEBUG
-		Stk::showWarnings( false );
-#endif
+		return;
+	}
+	Stk::setSampleRate( m_sampleRate );
 
-		m_voice = new BandedWG();
-	
-		m_voice->controlChange( 1, 128.0 );
-		m_voice->controlChange( 2, _control2 );
-		m_voice->controlChange( 4, _control4 );
-		m_voice->controlChange( 11, _control11 );
-		m_voice->controlChange( 16, _control16 );
-		m_voice->controlChange( 64, _control64 );
-		m_voice->controlChange( 128, _control128 );
-	
-		m_voice->noteOn( _pitch, _velocity );
+	m_voice->controlChange( 1, 128.0 );
+	m_voice->controlChange( 2, _control2 );
+	m_voice->controlChange( 4, _control4 );
+	m_voice->controlChange( 11, _control11 );
+	m_voice->controlChange( 16, _control16 );
+	m_voice->controlChange( 64, _control64 );
+	m_voice->controlChange( 128, _control128 );
+
+	m_voice->noteOn( _pitch, _velocity );
+}
+
+
+
+
+void malletsSynth::reset()
+{
+	if( m_voice == NULL )
+	{
+		return;
 	}
-	catch( ... )
+	m_voice->noteOff( 0.0 );
+	switch( m_type )
 	{
-		m_voice = NULL;
+		case ModalBarVoice:
+			static_cast<ModalBar *>( m_voice )->clear();
+			break;
+		case TubeBellVoice:
+			static_cast<ResettableTubeBell *>( m_voice )->clear();
+			break;
+		case BandedWGVoice:
+			static_cast<BandedWG *>( m_voice )->clear();
+			break;
 	}
-	
-	m_delay = new StkFloat[256];
+}
+
+
+
+
+void malletsSynth::startDelay( const uint8_t _delay )
+{
 	m_delayRead = 0;
 	m_delayWrite = _delay;
 	for( int i = 0; i < 256; i++ )
@@ -27,6 +27,9 @@
 #ifndef _MALLET_H
 #define _MALLET_H
 
+#include <QMutex>
+#include <vector>
+
 #include "Instrmnt.h"
 
 #include "ComboBox.h"
@@ -44,11 +47,30 @@ using namespace stk;
 
 static const int MALLETS_PRESET_VERSION = 1;
 
+// One voice of the instrument, kept by the instrument's voice pool after
+// its note ended. The STK instrument is built once, which loads its rawwave
+// files, and is reset when the voice is started again.
 class malletsSynth
 {
 public:
-	// ModalBar
-	malletsSynth( const StkFloat _pitch,
+	enum VoiceTypes
+	{
+		ModalBarVoice,
+		TubeBellVoice,
+		BandedWGVoice
+	} ;
+
+	malletsSynth( const VoiceTypes _type,
+			const sample_rate_t _sample_rate );
+
+	inline ~malletsSynth()
+	{
+		if (m_voice) {m_voice->noteOff(0.0);}
+		delete[] m_delay;
+		delete m_voice;
+	}
+
+	void startModalBar( const StkFloat _pitch,
 			const StkFloat _velocity,
 			const StkFloat _control1,
 			const StkFloat _control2,
@@ -56,11 +78,9 @@ public:
 			const StkFloat _control8,
 			const StkFloat _control11,
 			const int _control16,
-			const uint8_t _delay,
-			const sample_rate_t _sample_rate );
+			const uint8_t _delay );
 
-	// TubeBell
-	malletsSynth( const StkFloat _pitch,
+	void startTubeBell( const StkFloat _pitch,
 			const StkFloat _velocity,
 			const int _preset,
 			const StkFloat _control1,
@@ -68,11 +88,9 @@ public:
 			const StkFloat _control4,
 			const StkFloat _control11,
 			const StkFloat _control128,
-			const uint8_t _delay,
-			const sample_rate_t _sample_rate );
+			const uint8_t _delay );
 
-	// BandedWG
-	malletsSynth( const StkFloat _pitch,
+	void startBandedWG( const StkFloat _pitch,
 			const StkFloat _velocity,
 			const StkFloat _control2,
 			const StkFloat _control4,
@@ -80,14 +98,25 @@ public:
 			const int _control16,
 			const StkFloat _control64,
 			const StkFloat _control128,
-			const uint8_t _delay,
-			const sample_rate_t _sample_rate );
+			const uint8_t _delay );
 
-	inline ~malletsSynth()
+	//! Stops the note and clears the state of the voice, so it can be
+	//! started again as if it was new
+	void reset();
+
+	inline bool isValid() const
 	{
-		if (m_voice) {m_voice->noteOff(0.0);}
-		delete[] m_delay;
-		delete m_voice;
+		return m_voice != NULL;
+	}
+
+	inline VoiceTypes type() const
+	{
+		return m_type;
+	}
+
+	inline sample_rate_t sampleRate() const
+	{
+		return m_sampleRate;
 	}
 
 	inline sample_t nextSampleLeft()
@@ -132,6 +161,10 @@ public:
 
 
 protected:
+	void startDelay( const uint8_t _delay );
+
+	VoiceTypes m_type;
+	sample_rate_t m_sampleRate;
 	int m_presetIndex;
 	Instrmnt * m_voice;
 
@@ -163,7 +196,22 @@ public:
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 
+public slots:
+	void prefillVoices();
+
+
 private:
+	// voices built ahead of the notes which need them, so notes don't
+	// build STK instruments and read rawwave files on the audio thread
+	static const int PrefillVoices = 8;
+	static const int MaxIdleVoices = 16;
+
+	static malletsSynth::VoiceTypes voiceType( int _preset );
+
+	malletsSynth * takeVoice( malletsSynth::VoiceTypes _type,
+					sample_rate_t _sample_rate );
+	void giveVoice( malletsSynth * _voice );
+
 	FloatModel m_hardnessModel;
 	FloatModel m_positionModel;
 	FloatModel m_vibratoGainModel;
@@ -192,6 +240,9 @@ private:
 
 	bool m_filesMissing;
 
+	QMutex m_voiceMutex;
+	std::vector<malletsSynth *> m_idleVoices;
+
 
 	friend class malletsInstrumentView;
 
@@ -112,6 +112,11 @@ public:
 		return( 128 );
 	}
 
+	bool isResettable() const override
+	{
+		return true;
+	}
+
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 
@@ -426,6 +426,14 @@ bool vestigeInstrument::handleMidiEvent( const MidiEvent& event, const TimePos&
 
 
 
+RemotePlugin * vestigeInstrument::remotePlugin() const
+{
+	return m_plugin;
+}
+
+
+
+
 void vestigeInstrument::closePlugin( void )
 {
 	// disconnect all signals
@@ -68,6 +68,8 @@ public:
 
 	virtual bool handleMidiEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset = 0 );
 
+	RemotePlugin * remotePlugin() const override;
+
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 protected slots:
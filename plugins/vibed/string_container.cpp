@@ -24,19 +24,39 @@
 
 #include "string_container.h"
 
+#include "DelayLinePool.h"
+
+
+const int stringContainer::MaxStrings;
+
 
 stringContainer::stringContainer(const float _pitch, 
 				const sample_rate_t _sample_rate,
-				const int _buffer_length,
-				const int _strings ) :
+				const int _buffer_length ) :
+	m_count( 0 ),
 	m_pitch( _pitch ),
 	m_sampleRate( _sample_rate ),
-	m_bufferLength( _buffer_length )
+	m_bufferLength( _buffer_length ),
+	m_memory( NULL ),
+	m_memoryFrames( 0 )
+{
+	for( int i = 0; i < MaxStrings; i++ )
+	{
+		m_strings[i] = NULL;
+		m_exists[i] = false;
+	}
+}
+
+
+
+
+stringContainer::~stringContainer()
 {
-	for( int i = 0; i < _strings; i++ )
+	for( int i = 0; i < m_count; i++ )
 	{
-		m_exists.append( false );
+		delete m_strings[i];
 	}
+	DelayLinePool::release( m_memory, m_memoryFrames );
 }
 
 
@@ -87,16 +107,65 @@ void stringContainer::addString(int _harm,
 			harm = 1.0f;
 	}
 
-	m_strings.append( new vibratingString(	m_pitch * harm,
-						_pick, 
-						_pickup,
-						const_cast<float*>(_impulse),
+	stringSetup & setup = m_setups[m_count];
+	setup.pitch = m_pitch * harm;
+	setup.pick = _pick;
+	setup.pickup = _pickup;
+	setup.impulse = _impulse;
+	setup.randomize = _randomize;
+	setup.stringLoss = _string_loss;
+	setup.detune = _detune;
+	setup.oversample = _oversample;
+	setup.state = _state;
+	setup.length = vibratingString::length( setup.pitch, m_sampleRate,
+						_oversample, _detune );
+	++m_count;
+	m_exists[_id] = true;
+}
+
+
+
+
+void stringContainer::renderString( int _string, sample_t * _out,
+							fpp_t _frames )
+{
+	if( m_strings[_string] == NULL )
+	{
+		start();
+	}
+	m_strings[_string]->render( _out, _frames );
+}
+
+
+
+
+void stringContainer::start()
+{
+	// two delay lines per string, two samples per frame
+	f_cnt_t samples = 0;
+	for( int i = 0; i < m_count; i++ )
+	{
+		samples += 2 * m_setups[i].length;
+	}
+	m_memoryFrames = ( samples + 1 ) / 2;
+	m_memory = DelayLinePool::allocate( m_memoryFrames );
+
+	sample_t * memory = reinterpret_cast<sample_t *>( m_memory );
+	for( int i = 0; i < m_count; i++ )
+	{
+		const stringSetup & setup = m_setups[i];
+		m_strings[i] = new vibratingString( setup.pitch,
+						setup.pick,
+						setup.pickup,
+						const_cast<float*>( setup.impulse ),
 						m_bufferLength,
 						m_sampleRate,
-						_oversample,
-						_randomize,
-						_string_loss,
-						_detune,
-						_state ) );
-	m_exists[_id] = true;
+						setup.oversample,
+						setup.randomize,
+						setup.stringLoss,
+						setup.detune,
+						setup.state,
+						memory );
+		memory += 2 * setup.length;
+	}
 }
@@ -24,20 +24,22 @@
 #ifndef _STRING_CONTAINER_H
 #define _STRING_CONTAINER_H
 
-#include <QVector>
-
 #include "vibrating_string.h"
 #include "MemoryManager.h"
 
 
+/* The delay lines of all strings of a note share one block of memory from
+ * the DelayLinePool, taken when the first frames are rendered. The block
+ * is given back when the note ends, for the strings of the next notes. */
 class stringContainer
 {
 	MM_OPERATORS
 public:
+	static const int MaxStrings = 9;
+
 	stringContainer(const float _pitch, 
 			const sample_rate_t _sample_rate,
-			const int _buffer_length,
-			const int _strings = 9 );
+			const int _buffer_length );
 	
 	void addString(	int _harm,
 			const float _pick,
@@ -55,26 +57,37 @@ public:
 		return m_exists[_id];
 	}
 	
-	~stringContainer()
-	{
-		int strings = m_strings.count();
-		for( int i = 0; i < strings; i++ )
-		{
-			delete m_strings[i];
-		}
-	}
-	
-	float getStringSample( int _string )
-	{
-		return m_strings[_string]->nextSample();
-	}
+	~stringContainer();
+
+	// renders the next _frames samples of the _string-th string added
+	void renderString( int _string, sample_t * _out, fpp_t _frames );
 	
 private:
-	QVector<vibratingString *> m_strings;
+	struct stringSetup
+	{
+		float pitch;
+		float pick;
+		float pickup;
+		const float * impulse;
+		float randomize;
+		float stringLoss;
+		float detune;
+		int oversample;
+		bool state;
+		int length;
+	} ;
+
+	void start();
+
+	stringSetup m_setups[MaxStrings];
+	vibratingString * m_strings[MaxStrings];
+	int m_count;
 	const float m_pitch;
 	const sample_rate_t m_sampleRate;
 	const int m_bufferLength;
-	QVector<bool> m_exists;
+	bool m_exists[MaxStrings];
+	sampleFrame * m_memory;
+	f_cnt_t m_memoryFrames;
 } ;
 
 #endif
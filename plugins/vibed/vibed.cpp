@@ -24,6 +24,7 @@
 
 #include <QDomDocument>
 #include <QMap>
+#include <QVarLengthArray>
 
 #include "vibed.h"
 #include "Engine.h"
@@ -305,22 +306,28 @@ void vibed::playNote( NotePlayHandle * _n, sampleFrame * _working_buffer )
 	stringContainer * ps = static_cast<stringContainer *>(
 							_n->m_pluginData );
 
-	for( fpp_t i = offset; i < frames + offset; ++i )
+	memset( _working_buffer + offset, 0, frames * sizeof( sampleFrame ) );
+
+	// one string after the other, so each stays in the cache while its
+	// frames are rendered
+	QVarLengthArray<sample_t, DEFAULT_BUFFER_SIZE> samples( frames );
+	int s = 0;
+	for( int string = 0; string < 9; ++string )
 	{
-		_working_buffer[i][0] = 0.0f;
-		_working_buffer[i][1] = 0.0f;
-		int s = 0;
-		for( int string = 0; string < 9; ++string )
+		if( ps->exists( string ) )
 		{
-			if( ps->exists( string ) )
+			ps->renderString( s, samples.data(), frames );
+			// pan: 0 -> left, 1 -> right
+			const float pan = ( m_panKnobs[string]->value() + 1 ) / 2.0f;
+			const float volume = m_volumeKnobs[string]->value() / 100.0f;
+			const float left = ( 1.0f - pan ) * volume;
+			const float right = pan * volume;
+			for( fpp_t i = 0; i < frames; ++i )
 			{
-				// pan: 0 -> left, 1 -> right
-				const float pan = ( m_panKnobs[string]->value() + 1 ) / 2.0f;
-				const sample_t sample = ps->getStringSample( s ) * m_volumeKnobs[string]->value() / 100.0f;
-				_working_buffer[i][0] += ( 1.0f - pan ) * sample;
-				_working_buffer[i][1] += pan * sample;
-				s++;
+				_working_buffer[offset + i][0] += left * samples[i];
+				_working_buffer[offset + i][1] += right * samples[i];
 			}
+			s++;
 		}
 	}
 
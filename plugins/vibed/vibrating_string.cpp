@@ -22,6 +22,7 @@
  *
  */
 #include <math.h>
+#include <vector>
 
 #include "vibrating_string.h"
 #include "interpolation.h"
@@ -29,6 +30,9 @@
 #include "Engine.h"
 
 
+const int vibratingString::MaxOversample;
+
+
 vibratingString::vibratingString(	float _pitch, 
 					float _pick,
 					float _pickup,
@@ -39,45 +43,48 @@ vibratingString::vibratingString(	float _pitch,
 					float _randomize,
 					float _string_loss,
 					float _detune,
-					bool _state ) :
-	m_oversample( 2 * _oversample / (int)( _sample_rate /
-				Engine::mixer()->baseSampleRate() ) ),
+					bool _state,
+					sample_t * _memory ) :
+	m_oversample( oversampling( _oversample, _sample_rate ) ),
 	m_randomize( _randomize ),
 	m_stringLoss( 1.0f - _string_loss ),
 	m_state( 0.1f )
 {
-	m_outsamp = new sample_t[m_oversample];
-	int string_length;
-	
-	string_length = static_cast<int>( m_oversample * _sample_rate /
-								_pitch ) + 1;
-	string_length += static_cast<int>( string_length * -_detune );
+	const int string_length = length( _pitch, _sample_rate, _oversample,
+								_detune );
 
 	int pick = static_cast<int>( ceil( string_length * _pick ) );
 	
+	// the impulse is only needed to set up the string, the buffer is
+	// kept for the next notes played on the same thread
+	thread_local std::vector<float> impulse;
+	const int impulse_length = _state ? _len : string_length;
+	if( static_cast<int>( impulse.size() ) < impulse_length )
+	{
+		impulse.resize( impulse_length );
+	}
 	if( ! _state )
 	{
-		m_impulse = new float[string_length];
-		resample( _impulse, _len, string_length );
+		resample( impulse.data(), _impulse, _len, string_length );
 	}
 	else
  	{
-		m_impulse = new float[_len];
 		for( int i = 0; i < _len; i++ )
 		{
-			m_impulse[i] = _impulse[i];
+			impulse[i] = _impulse[i];
 		}
 	}
 	
-	m_toBridge = vibratingString::initDelayLine( string_length, pick );
-	m_fromBridge = vibratingString::initDelayLine( string_length, pick );
+	vibratingString::initDelayLine( &m_toBridge, string_length, _memory );
+	vibratingString::initDelayLine( &m_fromBridge, string_length,
+						_memory + string_length );
 
 	
-	vibratingString::setDelayLine( m_toBridge, pick, 
-						m_impulse, _len, 0.5f, 
+	vibratingString::setDelayLine( &m_toBridge, pick, 
+						impulse.data(), _len, 0.5f, 
 						_state );
-	vibratingString::setDelayLine( m_fromBridge, pick, 
-						m_impulse, _len, 0.5f,
+	vibratingString::setDelayLine( &m_fromBridge, pick, 
+						impulse.data(), _len, 0.5f,
 						_state);
 	
 	m_choice = static_cast<int>( m_oversample * 
@@ -89,53 +96,72 @@ vibratingString::vibratingString(	float _pitch,
 
 
 
-vibratingString::delayLine * vibratingString::initDelayLine( int _len,
-								int _pick )
+int vibratingString::length( float _pitch, sample_rate_t _sample_rate,
+						int _oversample, float _detune )
+{
+	int string_length = static_cast<int>(
+		oversampling( _oversample, _sample_rate ) * _sample_rate /
+								_pitch ) + 1;
+	string_length += static_cast<int>( string_length * -_detune );
+	return qMax( string_length, 0 );
+}
+
+
+
+
+int vibratingString::oversampling( int _oversample,
+					sample_rate_t _sample_rate )
 {
-	delayLine * dl = new vibratingString::delayLine[_len];
-	dl->length = _len;
+	return qBound( 1, 2 * _oversample / (int)( _sample_rate /
+			Engine::mixer()->baseSampleRate() ), MaxOversample );
+}
+
+
+
+
+void vibratingString::initDelayLine( delayLine * _dl, int _len,
+							sample_t * _data )
+{
+	_dl->length = _len;
 	if( _len > 0 )
 	{
-		dl->data = new sample_t[_len];
+		_dl->data = _data;
 		float r;
 		float offset = 0.0f;
-		for( int i = 0; i < dl->length; i++ )
+		for( int i = 0; i < _dl->length; i++ )
 		{
 			r = static_cast<float>( rand() ) /
 					RAND_MAX;
 			offset =  ( m_randomize / 2.0f -
 					m_randomize ) * r;
-			dl->data[i] = offset;
+			_dl->data[i] = offset;
 		}
 	}
 	else
 	{
-		dl->data = NULL;
+		_dl->data = NULL;
 	}
 
-	dl->pointer = dl->data;
-	dl->end = dl->data + _len - 1;
-
-	return( dl );
+	_dl->pointer = _dl->data;
+	_dl->end = _dl->data + _len - 1;
 }
 
 
 
 
-void vibratingString::freeDelayLine( delayLine * _dl )
+void vibratingString::render( sample_t * _out, fpp_t _frames )
 {
-	if( _dl )
+	for( fpp_t f = 0; f < _frames; ++f )
 	{
-		delete[] _dl->data;
-		delete[] _dl;
+		_out[f] = nextSample();
 	}
 }
 
 
 
 
-void vibratingString::resample( float *_src, f_cnt_t _src_frames,
-							 f_cnt_t _dst_frames )
+void vibratingString::resample( float * _impulse, float *_src,
+				f_cnt_t _src_frames, f_cnt_t _dst_frames )
 {
 	for( f_cnt_t frame = 0; frame < _dst_frames; ++frame )
 	{
@@ -147,7 +173,7 @@ void vibratingString::resample( float *_src, f_cnt_t _src_frames,
 		const f_cnt_t src_frame = qBound<f_cnt_t>(
 				1, static_cast<f_cnt_t>( src_frame_float ),
 							_src_frames - 3 );
-		m_impulse[frame] = cubicInterpolate(
+		_impulse[frame] = cubicInterpolate(
 						_src[src_frame - 1],
 						_src[src_frame + 0],
 						_src[src_frame + 1],
@@ -28,11 +28,15 @@
 #include <stdlib.h>
 
 #include "lmms_basics.h"
+#include "MemoryManager.h"
 
 class vibratingString
 {
-
+	MM_OPERATORS
 public:
+	// the string length knob goes up to 16, which is oversampled twice
+	static const int MaxOversample = 32;
+
 	vibratingString(	float _pitch, 
 				float _pick, 
 				float _pickup,
@@ -43,15 +47,16 @@ public:
 				float _randomize,
 				float _string_loss,
 				float _detune,
-				bool _state );
-	
-	inline ~vibratingString()
-	{
-		delete[] m_outsamp;
-		delete[] m_impulse;
-		vibratingString::freeDelayLine( m_fromBridge );
-		vibratingString::freeDelayLine( m_toBridge );
-	}
+				bool _state,
+				sample_t * _memory );
+
+	//! The samples of each of the two delay lines of a string, its
+	//! constructor gets memory for twice as many
+	static int length( float _pitch, sample_rate_t _sample_rate,
+					int _oversample, float _detune );
+
+	//! Renders the next _frames samples of the string
+	void render( sample_t * _out, fpp_t _frames );
 
 	inline sample_t nextSample()
 	{	
@@ -60,24 +65,24 @@ public:
 		for( int i = 0; i < m_oversample; i++)
 		{
 			// Output at pickup position
-			m_outsamp[i] = fromBridgeAccess( m_fromBridge, 
+			m_outsamp[i] = fromBridgeAccess( &m_fromBridge, 
 								m_pickupLoc );
-			m_outsamp[i] += toBridgeAccess( m_toBridge, 
+			m_outsamp[i] += toBridgeAccess( &m_toBridge, 
 								m_pickupLoc );
 		
 			// Sample traveling into "bridge"
-			ym0 = toBridgeAccess( m_toBridge, 1 );
+			ym0 = toBridgeAccess( &m_toBridge, 1 );
 			// Sample to "nut"
-			ypM = fromBridgeAccess( m_fromBridge,
-						m_fromBridge->length - 2 );
+			ypM = fromBridgeAccess( &m_fromBridge,
+						m_fromBridge.length - 2 );
 
 			// String state update
 
 			// Decrement pointer and then update
-			fromBridgeUpdate( m_fromBridge, 
+			fromBridgeUpdate( &m_fromBridge, 
 						-bridgeReflection( ym0 ) );
 			// Update and then increment pointer
-			toBridgeUpdate( m_toBridge, -ypM );
+			toBridgeUpdate( &m_toBridge, -ypM );
 		}
 		return( m_outsamp[m_choice] );
 	}
@@ -91,22 +96,21 @@ private:
 		sample_t * end;
 	} ;
 
-	delayLine * m_fromBridge;
-	delayLine * m_toBridge;
+	delayLine m_fromBridge;
+	delayLine m_toBridge;
 	int m_pickupLoc;
 	int m_oversample;
 	float m_randomize;
 	float m_stringLoss;
 	
-	float * m_impulse;
 	int m_choice;
 	float m_state;
 	
-	sample_t * m_outsamp;
+	sample_t m_outsamp[MaxOversample];
 
-	delayLine * initDelayLine( int _len, int _pick );
-	static void freeDelayLine( delayLine * _dl );
-	void resample( float *_src, f_cnt_t _src_frames, f_cnt_t _dst_frames );
+	static int oversampling( int _oversample, sample_rate_t _sample_rate );
+	void initDelayLine( delayLine * _dl, int _len, sample_t * _data );
+	void resample( float * _impulse, float *_src, f_cnt_t _src_frames, f_cnt_t _dst_frames );
 	
 	/* setDelayLine initializes the string with an impulse at the pick
 	 * position unless the impulse is longer than the string, in which
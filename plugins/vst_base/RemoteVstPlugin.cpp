@@ -120,10 +120,13 @@ static bool HEADLESS = false;
 
 class RemoteVstPlugin;
 
+// the plugin loaded last, or being loaded
 RemoteVstPlugin * __plugin = NULL;
 
-HWND __MessageHwnd = NULL;
-DWORD __processingThreadId = 0;
+// while hosting several plugins, the window the requests to start another
+// one are posted to
+HWND __hostHwnd = NULL;
+int __pluginCount = 0;
 
 
 //Returns the last Win32 error, in string format. Returns an empty string if there is no error.
@@ -169,6 +172,14 @@ public:
 
 	virtual void processMidiEvent( const MidiEvent& event, const f_cnt_t offset );
 
+	// VST 2 has no sample accurate parameters, changes apply to the
+	// whole period
+	virtual void processParameterChange( int index, float value,
+							const f_cnt_t /* offset */ )
+	{
+		m_plugin->setParameter( m_plugin, index, value );
+	}
+
 	// set given sample-rate for plugin
 	virtual void updateSampleRate()
 	{
@@ -235,8 +246,11 @@ public:
 	// do a complete parameter-dump and post it
 	void getParameterDump();
 
-	// read parameter-dump and set it for plugin
-	void setParameterDump( const message & _m );
+	// post the parameters changed since the last dump
+	void getParameterChanges();
+
+	// set the parameter values sent by the host
+	void setParameterValues( const message & _m );
 
 	// save settings chunk of plugin into file
 	void saveChunkToFile( const std::string & _file );
@@ -321,6 +335,12 @@ public:
 		m_messageList.push( m );
 	}
 
+	inline void sendInitialDelay()
+	{
+		sendMessage( message( IdVstInitialDelay ).
+					addInt( m_plugin->initialDelay ) );
+	}
+
 	inline bool shouldGiveIdle() const
 	{
 		return m_shouldGiveIdle;
@@ -335,8 +355,12 @@ public:
 	void processUIThreadMessages();
 
 	static DWORD WINAPI processingThread( LPVOID _param );
-	static bool setupMessageWindow();
+	bool setupMessageWindow();
 	static DWORD WINAPI guiEventLoop();
+
+	// connects to LMMS with the arguments of the process, loads the plugin
+	// and starts processing, returns NULL if that fails
+	static RemoteVstPlugin * start( int _argc, char * * _argv );
 	static LRESULT CALLBACK wndProc( HWND hwnd, UINT uMsg,
 					WPARAM wParam, LPARAM lParam );
 
@@ -347,7 +371,8 @@ private:
 		None,
 		ProcessPluginMessage,
 		GiveIdle,
-		ClosePlugin
+		ClosePlugin,
+		StartPlugin
 	} ;
 
 	struct SuspendPlugin {
@@ -392,6 +417,8 @@ private:
 	HINSTANCE m_libInst;
 
 	AEffect * m_plugin;
+	HWND m_messageWindow;
+	DWORD m_processingThreadId;
 	HWND m_window;
 	intptr_t m_windowID;
 	int m_windowWidth;
@@ -419,6 +446,9 @@ private:
 	double m_currentSamplePos;
 	int m_currentProgram;
 
+	// the parameter values as the host knows them from the dumps
+	std::vector<float> m_dumpedValues;
+
 	// host to plugin synchronisation data structure
 	struct in
 	{
@@ -428,10 +458,13 @@ private:
 	} ;
 
 	in * m_in;
+	VstTimeInfo m_timeInfo;
 
 	int m_shmID;
 	VstSyncData* m_vstSyncData;
 
+	friend class RemoteVstHost;
+
 } ;
 
 
@@ -446,6 +479,8 @@ RemoteVstPlugin::RemoteVstPlugin( const char * socketPath ) :
 #endif
 	m_libInst( NULL ),
 	m_plugin( NULL ),
+	m_messageWindow( NULL ),
+	m_processingThreadId( 0 ),
 	m_window( NULL ),
 	m_windowID( 0 ),
 	m_windowWidth( 0 ),
@@ -467,6 +502,7 @@ RemoteVstPlugin::RemoteVstPlugin( const char * socketPath ) :
 	m_vstSyncData( NULL )
 {
 	__plugin = this;
+	memset( &m_timeInfo, 0, sizeof( m_timeInfo ) );
 
 #ifndef USE_QT_SHMEM
 	key_t key;
@@ -530,6 +566,11 @@ RemoteVstPlugin::RemoteVstPlugin( const char * socketPath ) :
 
 RemoteVstPlugin::~RemoteVstPlugin()
 {
+	if( m_messageWindow != NULL )
+	{
+		SetWindowLongPtr( m_messageWindow, GWLP_USERDATA, 0 );
+		DestroyWindow( m_messageWindow );
+	}
 	destroyEditor();
 	setResumed( false );
 	pluginDispatch( effClose );
@@ -537,7 +578,7 @@ RemoteVstPlugin::~RemoteVstPlugin()
 	// detach shared memory segment
 	if( shmdt( m_vstSyncData ) == -1)
 	{
-		if( __plugin->m_vstSyncData->hasSHM )
+		if( m_vstSyncData->hasSHM )
 		{
 			perror( "~RemoteVstPlugin::shmdt" );
 		}
@@ -619,8 +660,12 @@ bool RemoteVstPlugin::processMessage( const message & _m )
 			getParameterDump();
 			break;
 
-		case IdVstSetParameterDump:
-			setParameterDump( _m );
+		case IdVstGetParameterChanges:
+			getParameterChanges();
+			break;
+
+		case IdVstSetParameterValues:
+			setParameterValues( _m );
 			break;
 
 		case IdSaveSettingsToFile:
@@ -661,11 +706,6 @@ bool RemoteVstPlugin::processMessage( const message & _m )
 			sendMessage( IdSavePresetFile );
 			break;
 
-		case IdVstSetParameter:
-			m_plugin->setParameter( m_plugin, _m.getInt( 0 ), _m.getFloat( 1 ) );
-			//sendMessage( IdVstSetParameter );
-			break;
-
 		case IdVstParameterDisplays:
 			getParameterDisplays();
 			break;
@@ -737,6 +777,7 @@ void RemoteVstPlugin::init( const std::string & _plugin_file )
 					addString( pluginProductString() ) );
 	sendMessage( message( IdVstParameterCount ).
 					addInt( m_plugin->numParams ) );
+	sendInitialDelay();
 
 	sendMessage( IdInitDone );
 
@@ -789,6 +830,7 @@ void RemoteVstPlugin::initEditor()
 		debugMessage( "initEditor(): cannot create editor window\n" );
 		return;
 	}
+	SetWindowLongPtr( m_window, GWLP_USERDATA, (LONG_PTR) this );
 
 
 	pluginDispatch( effEditOpen, 0, 0, m_window );
@@ -894,6 +936,8 @@ bool RemoteVstPlugin::load( const std::string & _plugin_file )
 		debugMessage( "File is not a VST plugin\n" );
 		return false;
 	}
+	// for the host callback, which is shared by all plugins of the process
+	m_plugin->ptr1 = this;
 
 
 	char id[5];
@@ -961,14 +1005,15 @@ void RemoteVstPlugin::process( const sampleFrame * _in, sampleFrame * _out )
 		return;
 	}
 
+	const int stride = remoteChannelStride( bufferSize() );
 	for( int i = 0; i < inputCount(); ++i )
 	{
-		m_inputs[i] = &((float *) _in)[i * bufferSize()];
+		m_inputs[i] = &((float *) _in)[i * stride];
 	}
 
 	for( int i = 0; i < outputCount(); ++i )
 	{
-		m_outputs[i] = &((float *) _out)[i * bufferSize()];
+		m_outputs[i] = &((float *) _out)[i * stride];
 		memset( m_outputs[i], 0, bufferSize() * sizeof( float ) );
 	}
 
@@ -1139,6 +1184,7 @@ void RemoteVstPlugin::getParameterDump()
 {
 	message m( IdVstParameterDump );
 	m.addInt( m_plugin->numParams );
+	m_dumpedValues.resize( m_plugin->numParams );
 
 	for( int i = 0; i < m_plugin->numParams; ++i )
 	{
@@ -1147,9 +1193,10 @@ void RemoteVstPlugin::getParameterDump()
 		pluginDispatch( effGetParamName, i, 0, paramName );
 		paramName[sizeof(paramName)-1] = 0;
 
+		m_dumpedValues[i] = m_plugin->getParameter( m_plugin, i );
 		m.addInt( i );
 		m.addString( paramName );
-		m.addFloat( m_plugin->getParameter( m_plugin, i ) );
+		m.addFloat( m_dumpedValues[i] );
 	}
 
 	sendMessage( m );
@@ -1158,19 +1205,42 @@ void RemoteVstPlugin::getParameterDump()
 
 
 
-void RemoteVstPlugin::setParameterDump( const message & _m )
+void RemoteVstPlugin::getParameterChanges()
+{
+	if( (int) m_dumpedValues.size() != m_plugin->numParams )
+	{
+		// the host doesn't know the names of all parameters
+		getParameterDump();
+	}
+
+	std::vector<VstParameterValue> changes;
+	for( int i = 0; i < m_plugin->numParams; ++i )
+	{
+		const float value = m_plugin->getParameter( m_plugin, i );
+		if( value != m_dumpedValues[i] )
+		{
+			const VstParameterValue change = { i, value };
+			changes.push_back( change );
+			m_dumpedValues[i] = value;
+		}
+	}
+
+	sendMessage( message( IdVstParameterChanges ).
+				addString( packParameterValues( changes ) ) );
+}
+
+
+
+
+void RemoteVstPlugin::setParameterValues( const message & _m )
 {
-	const int n = _m.getInt( 0 );
-	const int params = ( n > m_plugin->numParams ) ?
-					m_plugin->numParams : n;
-	int p = 0;
-	for( int i = 0; i < params; ++i )
-	{
-		VstParameterDumpItem item;
-		item.index = _m.getInt( ++p );
-		item.shortLabel = _m.getString( ++p );
-		item.value = _m.getFloat( ++p );
-		m_plugin->setParameter( m_plugin, item.index, item.value );
+	for( const VstParameterValue & v :
+				unpackParameterValues( _m.getString( 0 ) ) )
+	{
+		if( v.index >= 0 && v.index < m_plugin->numParams )
+		{
+			m_plugin->setParameter( m_plugin, v.index, v.value );
+		}
 	}
 }
 
@@ -1550,7 +1620,7 @@ int RemoteVstPlugin::updateInOutCount()
 		return 1;
 	}
 	
-	if( GetCurrentThreadId() == __processingThreadId )
+	if( GetCurrentThreadId() == m_processingThreadId )
 	{
 		debugMessage( "Plugin requested I/O change from processing "
 			"thread. Request denied; stability may suffer.\n" );
@@ -1609,18 +1679,25 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 					int32_t _index, intptr_t _value,
 						void * _ptr, float _opt )
 {
-	static VstTimeInfo _timeInfo;
 #ifdef DEBUG_CALLBACKS
 	char buf[64];
 	sprintf( buf, "host-callback, opcode = %d\n", (int) _opcode );
 	SHOW_CALLBACK( buf );
 #endif
 
+	// plugins are told apart by their AEffect, except for early
+	// callbacks while they are being loaded
+	RemoteVstPlugin * plugin = __plugin;
+	if( _effect != NULL && _effect->ptr1 != NULL )
+	{
+		plugin = static_cast<RemoteVstPlugin *>( _effect->ptr1 );
+	}
 	// workaround for early callbacks by some plugins
-	if( __plugin && __plugin->m_plugin == NULL )
+	else if( plugin && plugin->m_plugin == NULL )
 	{
-		__plugin->m_plugin = _effect;
+		plugin->m_plugin = _effect;
 	}
+	VstTimeInfo & _timeInfo = plugin->m_timeInfo;
 
 	switch( _opcode )
 	{
@@ -1643,7 +1720,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			SHOW_CALLBACK ("amc: audioMasterIdle\n" );
 			// call application idle routine (this will
 			// call effEditIdle for all open editors too)
-			PostMessage( __MessageHwnd, WM_USER, GiveIdle, 0 );
+			PostMessage( plugin->m_messageWindow, WM_USER, GiveIdle, 0 );
 			return 0;
 
 		case audioMasterPinConnected:
@@ -1663,77 +1740,77 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			// items may require extensive conversions
 
 			// Shared memory was initialised? - see song.cpp
-			//assert( __plugin->m_vstSyncData != NULL );
+			//assert( plugin->m_vstSyncData != NULL );
 
 			memset( &_timeInfo, 0, sizeof( _timeInfo ) );
-			_timeInfo.samplePos = __plugin->m_currentSamplePos;
-			_timeInfo.sampleRate = __plugin->m_vstSyncData->hasSHM ?
-							__plugin->m_vstSyncData->m_sampleRate :
-							__plugin->sampleRate();
+			_timeInfo.samplePos = plugin->m_currentSamplePos;
+			_timeInfo.sampleRate = plugin->m_vstSyncData->hasSHM ?
+							plugin->m_vstSyncData->m_sampleRate :
+							plugin->sampleRate();
 			_timeInfo.flags = 0;
-			_timeInfo.tempo = __plugin->m_vstSyncData->hasSHM ?
-							__plugin->m_vstSyncData->m_bpm :
-							__plugin->m_bpm;
-			_timeInfo.timeSigNumerator = __plugin->m_vstSyncData->timeSigNumer;
-			_timeInfo.timeSigDenominator = __plugin->m_vstSyncData->timeSigDenom;
+			_timeInfo.tempo = plugin->m_vstSyncData->hasSHM ?
+							plugin->m_vstSyncData->m_bpm :
+							plugin->m_bpm;
+			_timeInfo.timeSigNumerator = plugin->m_vstSyncData->timeSigNumer;
+			_timeInfo.timeSigDenominator = plugin->m_vstSyncData->timeSigDenom;
 			_timeInfo.flags |= kVstTempoValid;
 			_timeInfo.flags |= kVstTimeSigValid;
 
-			if( __plugin->m_vstSyncData->isCycle )
+			if( plugin->m_vstSyncData->isCycle )
 			{
-				_timeInfo.cycleStartPos = __plugin->m_vstSyncData->cycleStart;
-				_timeInfo.cycleEndPos = __plugin->m_vstSyncData->cycleEnd;
+				_timeInfo.cycleStartPos = plugin->m_vstSyncData->cycleStart;
+				_timeInfo.cycleEndPos = plugin->m_vstSyncData->cycleEnd;
 				_timeInfo.flags |= kVstCyclePosValid;
 				_timeInfo.flags |= kVstTransportCycleActive;
 			}
 
-			if( __plugin->m_vstSyncData->ppqPos != 
-							__plugin->m_in->m_Timestamp )
+			if( plugin->m_vstSyncData->ppqPos != 
+							plugin->m_in->m_Timestamp )
 			{
-				_timeInfo.ppqPos = __plugin->m_vstSyncData->ppqPos;
-				__plugin->m_in->lastppqPos = __plugin->m_vstSyncData->ppqPos;
-				__plugin->m_in->m_Timestamp = __plugin->m_vstSyncData->ppqPos;
+				_timeInfo.ppqPos = plugin->m_vstSyncData->ppqPos;
+				plugin->m_in->lastppqPos = plugin->m_vstSyncData->ppqPos;
+				plugin->m_in->m_Timestamp = plugin->m_vstSyncData->ppqPos;
 			}
-			else if( __plugin->m_vstSyncData->isPlaying )
+			else if( plugin->m_vstSyncData->isPlaying )
 			{
-				if( __plugin->m_vstSyncData->hasSHM )
+				if( plugin->m_vstSyncData->hasSHM )
 				{
-					__plugin->m_in->lastppqPos +=
-						__plugin->m_vstSyncData->m_bpm / 60.0
-						* __plugin->m_vstSyncData->m_bufferSize
-						/ __plugin->m_vstSyncData->m_sampleRate;
+					plugin->m_in->lastppqPos +=
+						plugin->m_vstSyncData->m_bpm / 60.0
+						* plugin->m_vstSyncData->m_bufferSize
+						/ plugin->m_vstSyncData->m_sampleRate;
 				}
 				else
 				{
-					__plugin->m_in->lastppqPos +=
-						__plugin->m_bpm / 60.0
-						* __plugin->bufferSize()
-						/ __plugin->sampleRate();
+					plugin->m_in->lastppqPos +=
+						plugin->m_bpm / 60.0
+						* plugin->bufferSize()
+						/ plugin->sampleRate();
 				}
-				_timeInfo.ppqPos = __plugin->m_in->lastppqPos;
+				_timeInfo.ppqPos = plugin->m_in->lastppqPos;
 			}
-//			_timeInfo.ppqPos = __plugin->m_vstSyncData->ppqPos;
+//			_timeInfo.ppqPos = plugin->m_vstSyncData->ppqPos;
 			_timeInfo.flags |= kVstPpqPosValid;
 
-			if( __plugin->m_vstSyncData->isPlaying )
+			if( plugin->m_vstSyncData->isPlaying )
 			{
 				_timeInfo.flags |= kVstTransportPlaying;
 			}
 			_timeInfo.barStartPos = ( (int) ( _timeInfo.ppqPos / 
-				( 4 *__plugin->m_vstSyncData->timeSigNumer
-				/ (float) __plugin->m_vstSyncData->timeSigDenom ) ) ) *
-				( 4 * __plugin->m_vstSyncData->timeSigNumer
-				/ (float) __plugin->m_vstSyncData->timeSigDenom );
+				( 4 *plugin->m_vstSyncData->timeSigNumer
+				/ (float) plugin->m_vstSyncData->timeSigDenom ) ) ) *
+				( 4 * plugin->m_vstSyncData->timeSigNumer
+				/ (float) plugin->m_vstSyncData->timeSigDenom );
 
 			_timeInfo.flags |= kVstBarsValid;
 
 			if( ( _timeInfo.flags & ( kVstTransportPlaying | kVstTransportCycleActive ) ) !=
-				( __plugin->m_in->m_lastFlags & ( kVstTransportPlaying | kVstTransportCycleActive ) )
-				|| __plugin->m_vstSyncData->m_playbackJumped )
+				( plugin->m_in->m_lastFlags & ( kVstTransportPlaying | kVstTransportCycleActive ) )
+				|| plugin->m_vstSyncData->m_playbackJumped )
 			{
 				_timeInfo.flags |= kVstTransportChanged;
 			}
-			__plugin->m_in->m_lastFlags = _timeInfo.flags;
+			plugin->m_in->m_lastFlags = _timeInfo.flags;
 
 			return (intptr_t) &_timeInfo;
 
@@ -1745,7 +1822,8 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterIOChanged:
 			SHOW_CALLBACK( "amc: audioMasterIOChanged\n" );
 			// numInputs, numOutputs, and/or latency has changed
-			return __plugin->updateInOutCount();
+			plugin->sendInitialDelay();
+			return plugin->updateInOutCount();
 
 #ifdef OLD_VST_SDK
 		case audioMasterWantMidi:
@@ -1761,7 +1839,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 
 		case audioMasterTempoAt:
 			SHOW_CALLBACK( "amc: audioMasterTempoAt\n" );
-			return __plugin->m_bpm * 10000;
+			return plugin->m_bpm * 10000;
 
 		case audioMasterGetNumAutomatableParameters:
 			SHOW_CALLBACK( "amc: audioMasterGetNumAutomatable"
@@ -1834,13 +1912,13 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterSizeWindow:
 		{
 			SHOW_CALLBACK( "amc: audioMasterSizeWindow\n" );
-			if( __plugin->m_window == 0 )
+			if( plugin->m_window == 0 )
 			{
 				return 0;
 			}
-			__plugin->m_windowWidth = _index;
-			__plugin->m_windowHeight = _value;
-			HWND window = __plugin->m_window;
+			plugin->m_windowWidth = _index;
+			plugin->m_windowHeight = _value;
+			HWND window = plugin->m_window;
 			DWORD dwStyle = GetWindowLongPtr( window, GWL_STYLE );
 			RECT windowSize = { 0, 0, (int) _index, (int) _value };
 			AdjustWindowRect( &windowSize, dwStyle, false );
@@ -1849,29 +1927,29 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 					windowSize.bottom - windowSize.top,
 					SWP_NOACTIVATE | SWP_NOMOVE |
 					SWP_NOOWNERZORDER | SWP_NOZORDER );
-			__plugin->sendMessage(
+			plugin->sendMessage(
 				message( IdVstPluginEditorGeometry ).
-					addInt( __plugin->m_windowWidth ).
-					addInt( __plugin->m_windowHeight ) );
+					addInt( plugin->m_windowWidth ).
+					addInt( plugin->m_windowHeight ) );
 			return 1;
 		}
 
 		case audioMasterGetSampleRate:
 			SHOW_CALLBACK( "amc: audioMasterGetSampleRate\n" );
-			return __plugin->sampleRate();
+			return plugin->sampleRate();
 
 		case audioMasterGetBlockSize:
 			SHOW_CALLBACK( "amc: audioMasterGetBlockSize\n" );
 
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetInputLatency:
 			SHOW_CALLBACK( "amc: audioMasterGetInputLatency\n" );
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetOutputLatency:
 			SHOW_CALLBACK( "amc: audioMasterGetOutputLatency\n" );
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetCurrentProcessLevel:
 			SHOW_CALLBACK( "amc: audioMasterGetCurrentProcess"
@@ -1963,7 +2041,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterUpdateDisplay:
 			SHOW_CALLBACK( "amc: audioMasterUpdateDisplay\n" );
 			// something has changed, update 'multi-fx' display
-			PostMessage( __MessageHwnd, WM_USER, GiveIdle, 0 );
+			PostMessage( plugin->m_messageWindow, WM_USER, GiveIdle, 0 );
 			return 0;
 
 #if kVstVersion > 2
@@ -2035,16 +2113,15 @@ void RemoteVstPlugin::processUIThreadMessages()
 
 DWORD WINAPI RemoteVstPlugin::processingThread( LPVOID _param )
 {
-	__processingThreadId = GetCurrentThreadId();
-
 	RemoteVstPlugin * _this = static_cast<RemoteVstPlugin *>( _param );
+	_this->m_processingThreadId = GetCurrentThreadId();
 
 	RemotePluginClient::message m;
 	while( ( m = _this->receiveMessage() ).id != IdQuit )
         {
 		if( m.id == IdStartProcessing
 			|| m.id == IdMidiEvent
-			|| m.id == IdVstSetParameter
+			|| m.id == IdParameterChange
 			|| m.id == IdVstSetTempo )
 		{
 			_this->processMessage( m );
@@ -2056,7 +2133,7 @@ DWORD WINAPI RemoteVstPlugin::processingThread( LPVOID _param )
 		}
 		else
 		{
-			PostMessage( __MessageHwnd,
+			PostMessage( _this->m_messageWindow,
 					WM_USER,
 					ProcessPluginMessage,
 					(LPARAM) new message( m ) );
@@ -2064,7 +2141,7 @@ DWORD WINAPI RemoteVstPlugin::processingThread( LPVOID _param )
 	}
 
 	// notify GUI thread about shutdown
-	PostMessage( __MessageHwnd, WM_USER, ClosePlugin, 0 );
+	PostMessage( _this->m_messageWindow, WM_USER, ClosePlugin, 0 );
 
 	return 0;
 }
@@ -2077,16 +2154,21 @@ bool RemoteVstPlugin::setupMessageWindow()
 	HMODULE hInst = GetModuleHandle( NULL );
 	if( hInst == NULL )
 	{
-		__plugin->debugMessage( "setupMessageWindow(): can't get "
+		debugMessage( "setupMessageWindow(): can't get "
 							"module handle\n" );
 		return false;
 	}
 
-	__MessageHwnd = CreateWindowEx( 0, "LVSL", "dummy",
+	m_messageWindow = CreateWindowEx( 0, "LVSL", "dummy",
 						0, 0, 0, 0, 0, NULL, NULL,
 								hInst, NULL );
+	if( m_messageWindow == NULL )
+	{
+		return false;
+	}
+	SetWindowLongPtr( m_messageWindow, GWLP_USERDATA, (LONG_PTR) this );
 	// install GUI update timer
-	SetTimer( __MessageHwnd, 1000, 50, NULL );
+	SetTimer( m_messageWindow, 1000, 50, NULL );
 
 	return true;
 }
@@ -2094,6 +2176,44 @@ bool RemoteVstPlugin::setupMessageWindow()
 
 
 
+RemoteVstPlugin * RemoteVstPlugin::start( int _argc, char * * _argv )
+{
+	// constructor automatically will process messages until it receives
+	// a IdVstLoadPlugin message and processes it
+#ifdef SYNC_WITH_SHM_FIFO
+	if( _argc < 2 )
+	{
+		return NULL;
+	}
+	RemoteVstPlugin * plugin = new RemoteVstPlugin( atoi( _argv[0] ),
+							atoi( _argv[1] ) );
+#else
+	if( _argc < 1 )
+	{
+		return NULL;
+	}
+	RemoteVstPlugin * plugin = new RemoteVstPlugin( _argv[0] );
+#endif
+
+	if( !plugin->isInitialized() || !plugin->setupMessageWindow() )
+	{
+		delete plugin;
+		return NULL;
+	}
+	if( CreateThread( NULL, 0, RemoteVstPlugin::processingThread,
+						plugin, 0, NULL ) == NULL )
+	{
+		plugin->debugMessage( "could not create processingThread\n" );
+		delete plugin;
+		return NULL;
+	}
+	++__pluginCount;
+	return plugin;
+}
+
+
+
+
 DWORD WINAPI RemoteVstPlugin::guiEventLoop()
 {
 	MSG msg;
@@ -2112,10 +2232,45 @@ DWORD WINAPI RemoteVstPlugin::guiEventLoop()
 LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 						WPARAM wParam, LPARAM lParam )
 {
-	if( uMsg == WM_TIMER && __plugin->isInitialized() )
+	if( hwnd == __hostHwnd && uMsg == WM_USER )
+	{
+		message * m = (message *) lParam;
+		switch( wParam )
+		{
+			case StartPlugin:
+			{
+				// the arguments a process of its own would get
+				std::vector<char *> argv;
+				for( const std::string & arg : m->data )
+				{
+					argv.push_back( const_cast<char *>( arg.c_str() ) );
+				}
+				start( argv.size(), argv.data() );
+				delete m;
+				return 0;
+			}
+
+			case ClosePlugin:
+				PostQuitMessage(0);
+				return 0;
+
+			default:
+				break;
+		}
+	}
+
+	// the message window and the editor of each plugin know it
+	RemoteVstPlugin * plugin = (RemoteVstPlugin *)
+					GetWindowLongPtr( hwnd, GWLP_USERDATA );
+	if( plugin == NULL )
+	{
+		return DefWindowProc( hwnd, uMsg, wParam, lParam );
+	}
+
+	if( uMsg == WM_TIMER && plugin->isInitialized() )
 	{
 		// give plugin some idle-time for GUI-update
-		__plugin->idle();
+		plugin->idle();
 		return 0;
 	}
 	else if( uMsg == WM_USER )
@@ -2125,21 +2280,30 @@ LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 			case ProcessPluginMessage:
 			{
 				message * m = (message *) lParam;
-				__plugin->queueMessage( *m );
+				plugin->queueMessage( *m );
 				delete m;
-				if( !__plugin->isProcessing() )
+				if( !plugin->isProcessing() )
 				{
-					__plugin->processUIThreadMessages();
+					plugin->processUIThreadMessages();
 				}
 				return 0;
 			}
 
 			case GiveIdle:
-				__plugin->idle();
+				plugin->idle();
 				return 0;
 
 			case ClosePlugin:
-				PostQuitMessage(0);
+				// the processing thread has finished
+				if( __plugin == plugin )
+				{
+					__plugin = NULL;
+				}
+				delete plugin;
+				if( --__pluginCount == 0 && __hostHwnd == NULL )
+				{
+					PostQuitMessage(0);
+				}
 				return 0;
 
 			default:
@@ -2148,7 +2312,7 @@ LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 	}
 	else if( uMsg == WM_SYSCOMMAND && (wParam & 0xfff0) == SC_CLOSE )
 	{
-		__plugin->hideEditor();
+		plugin->hideEditor();
 		return 0;
 	}
 
@@ -2158,6 +2322,61 @@ LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 
 
 
+// the connection of a process hosting several plugins, over which LMMS
+// asks for each of them
+class RemoteVstHost : public RemotePluginClient
+{
+public:
+#ifdef SYNC_WITH_SHM_FIFO
+	RemoteVstHost( key_t _shm_in, key_t _shm_out ) :
+		RemotePluginClient( _shm_in, _shm_out )
+#else
+	RemoteVstHost( const char * socketPath ) :
+		RemotePluginClient( socketPath )
+#endif
+	{
+	}
+
+	virtual bool processMessage( const message & _m )
+	{
+		if( _m.id == IdStartInstance )
+		{
+			// plugins are started and run their editors on the GUI
+			// thread
+			PostMessage( __hostHwnd, WM_USER,
+					RemoteVstPlugin::StartPlugin,
+					(LPARAM) new message( _m ) );
+			return true;
+		}
+		return RemotePluginClient::processMessage( _m );
+	}
+
+	virtual void process( const sampleFrame *, sampleFrame * )
+	{
+	}
+
+	static DWORD WINAPI receiveThread( LPVOID _param )
+	{
+		RemoteVstHost * _this = static_cast<RemoteVstHost *>( _param );
+
+		RemotePluginClient::message m;
+		while( !_this->isInvalid() &&
+				( m = _this->receiveMessage() ).id != IdQuit )
+		{
+			_this->processMessage( m );
+		}
+
+		// the plugins have been closed by LMMS already
+		PostMessage( __hostHwnd, WM_USER,
+					RemoteVstPlugin::ClosePlugin, 0 );
+
+		return 0;
+	}
+} ;
+
+
+
+
 int main( int _argc, char * * _argv )
 {
 #ifdef SYNC_WITH_SHM_FIFO
@@ -2251,32 +2470,34 @@ int main( int _argc, char * * _argv )
 		}
 	}
 
-	// constructor automatically will process messages until it receives
-	// a IdVstLoadPlugin message and processes it
 #ifdef SYNC_WITH_SHM_FIFO
-	__plugin = new RemoteVstPlugin( atoi( _argv[1] ), atoi( _argv[2] ) );
+	const int hostIndex = 4;
 #else
-	__plugin = new RemoteVstPlugin( _argv[1] );
+	const int hostIndex = 3;
 #endif
-
-	if( __plugin->isInitialized() )
+	if( _argc > hostIndex && std::string( _argv[hostIndex] ) == "host" )
 	{
-		if( RemoteVstPlugin::setupMessageWindow() == false )
-		{
-			return -1;
-		}
-		if( CreateThread( NULL, 0, RemoteVstPlugin::processingThread,
-						__plugin, 0, NULL ) == NULL )
+		// LMMS asks for each plugin over this connection
+#ifdef SYNC_WITH_SHM_FIFO
+		RemoteVstHost host( atoi( _argv[1] ), atoi( _argv[2] ) );
+#else
+		RemoteVstHost host( _argv[1] );
+#endif
+		__hostHwnd = CreateWindowEx( 0, "LVSL", "dummy",
+						0, 0, 0, 0, 0, NULL, NULL,
+								hInst, NULL );
+		if( __hostHwnd == NULL || CreateThread( NULL, 0,
+				RemoteVstHost::receiveThread, &host, 0, NULL ) == NULL )
 		{
-			__plugin->debugMessage( "could not create "
-							"processingThread\n" );
+			host.debugMessage( "could not start hosting plugins\n" );
 			return -1;
 		}
 		RemoteVstPlugin::guiEventLoop();
 	}
-
-
-	delete __plugin;
+	else if( RemoteVstPlugin::start( _argc - 1, _argv + 1 ) != NULL )
+	{
+		RemoteVstPlugin::guiEventLoop();
+	}
 
 	OleUninitialize();
 	return 0;
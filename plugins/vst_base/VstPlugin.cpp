@@ -27,6 +27,7 @@
 #include "communication.h"
 
 #include <QtCore/QtEndian>
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
 #include <QDir>
 #include <QFileInfo>
@@ -117,6 +118,75 @@ private:
 }
 
 
+namespace
+{
+
+// the shared host processes by executable, they quit with their last plugin
+QMap<QString, QWeakPointer<RemotePlugin>> s_sharedHosts;
+
+// host processes launched ahead of time by executable, so loading a plugin
+// doesn't wait for a process (and Wine) to come up
+QMap<QString, QSharedPointer<RemotePlugin>> s_spareHosts;
+
+QSharedPointer<RemotePlugin> newHost( const QString & executable,
+				const QString & embedMethod, bool launchSpare )
+{
+	const QStringList args = { embedMethod, "host" };
+
+	QSharedPointer<RemotePlugin> host = s_spareHosts.take( executable );
+	if( !host )
+	{
+		host = QSharedPointer<RemotePlugin>( new RemotePlugin );
+		host->launch( executable, args );
+	}
+
+	if( launchSpare )
+	{
+		// the next one comes up while this one is in use
+		static bool cleanupConnected = false;
+		if( !cleanupConnected )
+		{
+			QObject::connect( qApp, &QCoreApplication::aboutToQuit,
+						[]() { s_spareHosts.clear(); } );
+			cleanupConnected = true;
+		}
+		QSharedPointer<RemotePlugin> spare( new RemotePlugin );
+		if( !spare->launch( executable, args ) )
+		{
+			s_spareHosts[executable] = spare;
+		}
+	}
+
+	host->init( executable, false );
+	host->waitForHostInfoGotten();
+	if( host->failed() )
+	{
+		return QSharedPointer<RemotePlugin>();
+	}
+	return host;
+}
+
+QSharedPointer<RemotePlugin> sharedHost( const QString & executable,
+						const QString & embedMethod )
+{
+	QSharedPointer<RemotePlugin> host =
+				s_sharedHosts.value( executable ).toStrongRef();
+	if( host && host->isRunning() )
+	{
+		return host;
+	}
+
+	host = newHost( executable, embedMethod, false );
+	if( host )
+	{
+		s_sharedHosts[executable] = host;
+	}
+	return host;
+}
+
+}
+
+
 VstPlugin::VstPlugin( const QString & _plugin ) :
 	m_plugin( PathUtil::toAbsolute(_plugin) ),
 	m_pluginWindowID( 0 ),
@@ -124,7 +194,9 @@ VstPlugin::VstPlugin( const QString & _plugin ) :
 			? ConfigManager::inst()->vstEmbedMethod()
 			: "headless" ),
 	m_version( 0 ),
-	m_currentProgram()
+	m_currentProgram(),
+	m_initialDelay( 0 ),
+	m_idlePeriods( 0 )
 {
 	setSplittedChannels( true );
 
@@ -176,6 +248,15 @@ VstPlugin::~VstPlugin()
 
 void VstPlugin::tryLoad( const QString &remoteVstPluginExecutable )
 {
+	// without a host, init() starts a process of its own
+	if( ConfigManager::inst()->value( "ui", "vstsharedhost" ).toInt() )
+	{
+		setHost( sharedHost( remoteVstPluginExecutable, m_embedMethod ) );
+	}
+	else if( ConfigManager::inst()->value( "ui", "vstsparehosts", "1" ).toInt() )
+	{
+		setHost( newHost( remoteVstPluginExecutable, m_embedMethod, true ) );
+	}
 	init( remoteVstPluginExecutable, false, {m_embedMethod} );
 
 	waitForHostInfoGotten();
@@ -258,6 +339,7 @@ void VstPlugin::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	}
 
 	// try to save all settings in a chunk
+	flushEvents();
 	QByteArray chunk = saveChunk();
 	if( !chunk.isEmpty() )
 	{
@@ -330,9 +412,19 @@ int VstPlugin::currentProgram()
 
 const QMap<QString, QString> & VstPlugin::parameterDump()
 {
+	flushEvents();
 	lock();
-	sendMessage( IdVstGetParameterDump );
-	waitForMessage( IdVstParameterDump, true );
+	if( m_parameterDump.isEmpty() )
+	{
+		sendMessage( IdVstGetParameterDump );
+		waitForMessage( IdVstParameterDump, true );
+	}
+	else
+	{
+		// the plugin only sends what changed since the last dump
+		sendMessage( IdVstGetParameterChanges );
+		waitForMessage( IdVstParameterChanges, true );
+	}
 	unlock();
 
 	return m_parameterDump;
@@ -343,23 +435,21 @@ const QMap<QString, QString> & VstPlugin::parameterDump()
 
 void VstPlugin::setParameterDump( const QMap<QString, QString> & _pdump )
 {
-	message m( IdVstSetParameterDump );
-	m.addInt( _pdump.size() );
+	std::vector<VstParameterValue> values;
+	values.reserve( _pdump.size() );
 	for( QMap<QString, QString>::ConstIterator it = _pdump.begin();
 						it != _pdump.end(); ++it )
 	{
-		const VstParameterDumpItem item =
+		const VstParameterValue value =
 		{
 			( *it ).section( ':', 0, 0 ).toInt(),
-			"",
 			LocaleHelper::toFloat((*it).section(':', 2, -1))
 		} ;
-		m.addInt( item.index );
-		m.addString( item.shortLabel );
-		m.addFloat( item.value );
+		values.push_back( value );
 	}
 	lock();
-	sendMessage( m );
+	sendMessage( message( IdVstSetParameterValues ).
+				addString( packParameterValues( values ) ) );
 	unlock();
 }
 
@@ -438,6 +528,10 @@ bool VstPlugin::processMessage( const message & _m )
 			m_allParameterDisplays = _m.getQString();
 			break;
 
+		case IdVstInitialDelay:
+			m_initialDelay = _m.getInt();
+			break;
+
 		case IdVstPluginUniqueID:
 			// TODO: display graphically in case of failure
 			printf("unique ID: %s\n", _m.getString().c_str() );
@@ -461,6 +555,18 @@ bool VstPlugin::processMessage( const message & _m )
 			}
 			break;
 		}
+
+		case IdVstParameterChanges:
+			for( const VstParameterValue & v :
+				unpackParameterValues( _m.getString() ) )
+			{
+				const QString key = "param" + QString::number( v.index );
+				// the value follows the index and the name
+				m_parameterDump[key] =
+					m_parameterDump[key].section( ':', 0, -2 ) +
+					":" + QString::number( v.value );
+			}
+			break;
 		default:
 			return RemotePlugin::processMessage( _m );
 	}
@@ -544,6 +650,7 @@ void VstPlugin::loadParameterLabels()
 
 void VstPlugin::loadParameterDisplays()
 {
+	flushEvents();
 	lock();
 	sendMessage( message( IdVstParameterDisplays ) );
 	waitForMessage( IdVstParameterDisplays, true );
@@ -593,16 +700,25 @@ void VstPlugin::savePreset( )
 
 void VstPlugin::setParam( int i, float f )
 {
-	lock();
-	sendMessage( message( IdVstSetParameter ).addInt( i ).addFloat( f ) );
-	//waitForMessage( IdVstSetParameter, true );
-	unlock();
+	processParameterChange( i, f );
+	// no period may come to deliver it
+	if( periodsStarted() == m_idlePeriods )
+	{
+		flushEvents();
+	}
 }
 
 
 
 void VstPlugin::idleUpdate()
 {
+	// deliver what was queued before the plugin stopped being processed
+	if( periodsStarted() == m_idlePeriods )
+	{
+		flushEvents();
+	}
+	m_idlePeriods = periodsStarted();
+
 	lock();
 	sendMessage( message( IdVstIdleUpdate ) );
 	unlock();
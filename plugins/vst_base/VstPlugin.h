@@ -25,6 +25,8 @@
 #ifndef _VST_PLUGIN_H
 #define _VST_PLUGIN_H
 
+#include <atomic>
+
 #include <QMap>
 #include <QMutex>
 #include <QPointer>
@@ -103,6 +105,12 @@ public:
 
 	int currentProgram();
 
+	//! The latency the plugin reports, in frames
+	inline int initialDelay() const
+	{
+		return m_initialDelay;
+	}
+
 	const QMap<QString, QString> & parameterDump();
 	void setParameterDump( const QMap<QString, QString> & _pdump );
 
@@ -168,6 +176,9 @@ private:
 	QMap<QString, QString> m_parameterDump;
 
 	int m_currentProgram;
+	std::atomic<int> m_initialDelay;
+	// the periods started by the last idle update
+	std::atomic<int> m_idlePeriods;
 
 	QTimer m_idleTimer;
 
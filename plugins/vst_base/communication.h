@@ -27,6 +27,10 @@
 #ifndef _COMMUNICATION_H
 #define _COMMUNICATION_H
 
+#include <cstring>
+#include <string>
+#include <vector>
+
 
 
 struct VstParameterDumpItem
@@ -38,6 +42,33 @@ struct VstParameterDumpItem
 
 
 
+//! Parameter values are sent as one binary string of these, rather than
+//! as three strings per parameter
+struct VstParameterValue
+{
+	int32_t index;
+	float value;
+} ;
+
+inline std::string packParameterValues(
+				const std::vector<VstParameterValue> & _values )
+{
+	return std::string( reinterpret_cast<const char *>( _values.data() ),
+				_values.size() * sizeof( VstParameterValue ) );
+}
+
+inline std::vector<VstParameterValue> unpackParameterValues(
+							const std::string & _s )
+{
+	std::vector<VstParameterValue> values(
+				_s.size() / sizeof( VstParameterValue ) );
+	memcpy( values.data(), _s.data(),
+				values.size() * sizeof( VstParameterValue ) );
+	return values;
+}
+
+
+
 enum VstHostLanguages
 {
 	LanguageEnglish = 1,
@@ -60,7 +91,6 @@ enum VstRemoteMessageIDs
 	IdVstSetLanguage,
 	IdVstGetParameterCount,
 	IdVstGetParameterDump,
-	IdVstSetParameterDump,
 	IdVstProgramNames,
 	IdVstCurrentProgram,
 	IdVstCurrentProgramName,
@@ -69,6 +99,8 @@ enum VstRemoteMessageIDs
 	IdVstIdleUpdate,
 	IdVstParameterDisplays,
 	IdVstParameterLabels,
+	IdVstGetParameterChanges,
+	IdVstSetParameterValues,
 
 	// remoteVstPlugin -> vstPlugin
 	IdVstFailedLoadingPlugin,
@@ -82,7 +114,9 @@ enum VstRemoteMessageIDs
 	IdVstPluginUniqueID,
 	IdVstSetParameter,
 	IdVstParameterCount,
-	IdVstParameterDump
+	IdVstParameterDump,
+	IdVstParameterChanges,
+	IdVstInitialDelay
 
 } ;
 
@@ -59,8 +59,7 @@ Plugin::Descriptor PLUGIN_EXPORT watsyn_plugin_descriptor =
 
 
 
-WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
+WatsynObject::WatsynObject( const WaveMipMapCache::MipMapPtr * _waves,
 					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
 					WatsynInstrument * _w ) :
 				m_amod( _amod ),
@@ -73,22 +72,15 @@ WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
 	m_abuf = new sampleFrame[_frames];
 	m_bbuf = new sampleFrame[_frames];
 
-	m_lphase[A1_OSC] = 0.0f;
-	m_lphase[A2_OSC] = 0.0f;
-	m_lphase[B1_OSC] = 0.0f;
-	m_lphase[B2_OSC] = 0.0f;
-
-	m_rphase[A1_OSC] = 0.0f;
-	m_rphase[A2_OSC] = 0.0f;
-	m_rphase[B1_OSC] = 0.0f;
-	m_rphase[B2_OSC] = 0.0f;
-
-	// copy wavegraphs to the synth object to prevent race conditions
+	for( int i = 0; i < NUM_OSCS; i++ )
+	{
+		m_lphase[i] = 0.0f;
+		m_rphase[i] = 0.0f;
 
-	memcpy( &m_A1wave, _A1wave, sizeof( m_A1wave ) );
-	memcpy( &m_A2wave, _A2wave, sizeof( m_A2wave ) );
-	memcpy( &m_B1wave, _B1wave, sizeof( m_B1wave ) );
-	memcpy( &m_B2wave, _B2wave, sizeof( m_B2wave ) );
+		// keep the wavetables of the note start, the graphs may change
+		// while the note plays
+		m_waves[i] = std::atomic_load( &_waves[i] );
+	}
 }
 
 
@@ -100,6 +92,34 @@ WatsynObject::~WatsynObject()
 }
 
 
+void WatsynObject::oscillate( int _osc, float & _phase, float _coeff, const float * _pm,
+						float _vol, float * _out, int _frames )
+{
+	float phases [RENDER_BLOCK];
+	for( int f = 0; f < _frames; f++ )
+	{
+		phases[f] = _phase + f * _coeff;
+	}
+	if( _pm != NULL )
+	{
+		for( int f = 0; f < _frames; f++ )
+		{
+			phases[f] += _pm[f] * PMOD_AMT;
+		}
+	}
+	_phase = absFraction( _phase + _frames * _coeff );
+
+	// the table of each wave is picked for the pitch of its oscillator,
+	// so high notes don't alias
+	BandLimitedWave::oscillate( phases, _out, _frames,
+				BandLimitedWave::pdToLen( _coeff ), *m_waves[_osc] );
+	for( int f = 0; f < _frames; f++ )
+	{
+		_out[f] *= _vol;
+	}
+}
+
+
 void WatsynObject::renderOutput( fpp_t _frames )
 {
 	if( m_abuf == NULL )
@@ -107,123 +127,110 @@ void WatsynObject::renderOutput( fpp_t _frames )
 	if( m_bbuf == NULL )
 		m_bbuf = new sampleFrame[m_fpp];
 
-	for( fpp_t frame = 0; frame < _frames; frame++ )
+	const float freq = m_nph->frequency() / m_samplerate;
+	const float xt = m_parent->m_xtalk.value() * 0.01f;
+
+	float A1 [RENDER_BLOCK];
+	float A2 [RENDER_BLOCK];
+	float B1 [RENDER_BLOCK];
+	float B2 [RENDER_BLOCK];
+
+	for( fpp_t start = 0; start < _frames; start += RENDER_BLOCK )
 	{
-		// put phases of 1-series oscs into variables because phase modulation might happen
-		float A1_lphase = m_lphase[A1_OSC];
-		float A1_rphase = m_rphase[A1_OSC];
-		float B1_lphase = m_lphase[B1_OSC];
-		float B1_rphase = m_rphase[B1_OSC];
-
-		/////////////   A-series   /////////////////
-
-		// A2
-		sample_t A2_L = linearInterpolate( m_A2wave[ static_cast<int>( m_lphase[A2_OSC] ) ],
-							m_A2wave[ static_cast<int>( m_lphase[A2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_lphase[A2_OSC] ) ) * m_parent->m_lvol[A2_OSC];
-		sample_t A2_R = linearInterpolate( m_A2wave[ static_cast<int>( m_rphase[A2_OSC] ) ],
-							m_A2wave[ static_cast<int>( m_rphase[A2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_rphase[A2_OSC] ) ) * m_parent->m_rvol[A2_OSC];
-
-		// if phase mod, add to phases
-		if( m_amod == MOD_PM )
-		{
-			A1_lphase = fmodf( A1_lphase + A2_L * PMOD_AMT, WAVELEN );
-			if( A1_lphase < 0 ) A1_lphase += WAVELEN;
-			A1_rphase = fmodf( A1_rphase + A2_R * PMOD_AMT, WAVELEN );
-			if( A1_rphase < 0 ) A1_rphase += WAVELEN;
-		}
-		// A1
-		sample_t A1_L = linearInterpolate( m_A1wave[ static_cast<int>( A1_lphase ) ],
-							m_A1wave[ static_cast<int>( A1_lphase + 1 ) % WAVELEN ],
-							fraction( A1_lphase ) ) * m_parent->m_lvol[A1_OSC];
-		sample_t A1_R = linearInterpolate( m_A1wave[ static_cast<int>( A1_rphase ) ],
-							m_A1wave[ static_cast<int>( A1_rphase + 1 ) % WAVELEN ],
-							fraction( A1_rphase ) ) * m_parent->m_rvol[A1_OSC];
-
-		/////////////   B-series   /////////////////
-
-		// B2
-		sample_t B2_L = linearInterpolate( m_B2wave[ static_cast<int>( m_lphase[B2_OSC] ) ],
-							m_B2wave[ static_cast<int>( m_lphase[B2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_lphase[B2_OSC] ) ) * m_parent->m_lvol[B2_OSC];
-		sample_t B2_R = linearInterpolate( m_B2wave[ static_cast<int>( m_rphase[B2_OSC] ) ],
-							m_B2wave[ static_cast<int>( m_rphase[B2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_rphase[B2_OSC] ) ) * m_parent->m_rvol[B2_OSC];
-
-		// if crosstalk active, add a1
-		const float xt = m_parent->m_xtalk.value();
-		if( xt > 0.0 )
-		{
-			B2_L += ( A1_L * xt ) * 0.01f;
-			B2_R += ( A1_R * xt ) * 0.01f;
-		}
+		const int frames = qMin<int>( RENDER_BLOCK, _frames - start );
 
-		// if phase mod, add to phases
-		if( m_bmod == MOD_PM )
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ch++ )
 		{
-			B1_lphase = fmodf( B1_lphase + B2_L * PMOD_AMT, WAVELEN );
-			if( B1_lphase < 0 ) B1_lphase += WAVELEN;
-			B1_rphase = fmodf( B1_rphase + B2_R * PMOD_AMT, WAVELEN );
-			if( B1_rphase < 0 ) B1_rphase += WAVELEN;
-		}
-		// B1
-		sample_t B1_L = linearInterpolate( m_B1wave[ static_cast<int>( B1_lphase ) % WAVELEN ],
-							m_B1wave[ static_cast<int>( B1_lphase + 1 ) % WAVELEN ],
-							fraction( B1_lphase ) ) * m_parent->m_lvol[B1_OSC];
-		sample_t B1_R = linearInterpolate( m_B1wave[ static_cast<int>( B1_rphase ) % WAVELEN ],
-							m_B1wave[ static_cast<int>( B1_rphase + 1 ) % WAVELEN ],
-							fraction( B1_rphase ) ) * m_parent->m_rvol[B1_OSC];
+			float * phase = ch == 0 ? m_lphase : m_rphase;
+			const float * mult = ch == 0 ? m_parent->m_lfreq : m_parent->m_rfreq;
+			const float * vol = ch == 0 ? m_parent->m_lvol : m_parent->m_rvol;
 
+			/////////////   A-series   /////////////////
 
-		// A-series modulation)
-		switch( m_amod )
-		{
-			case MOD_MIX:
-				A1_L = ( A1_L + A2_L ) / 2.0;
-				A1_R = ( A1_R + A2_R ) / 2.0;
-				break;
-			case MOD_AM:
-				A1_L *= qMax( 0.0f, A2_L + 1.0f );
-				A1_R *= qMax( 0.0f, A2_R + 1.0f );
-				break;
-			case MOD_RM:
-				A1_L *= A2_L;
-				A1_R *= A2_R;
-				break;
-		}
-		m_abuf[frame][0] = A1_L;
-		m_abuf[frame][1] = A1_R;
+			oscillate( A2_OSC, phase[A2_OSC], freq * mult[A2_OSC], NULL,
+						vol[A2_OSC], A2, frames );
+			// if phase mod, A2 moves the phases of A1
+			oscillate( A1_OSC, phase[A1_OSC], freq * mult[A1_OSC],
+						m_amod == MOD_PM ? A2 : NULL,
+						vol[A1_OSC], A1, frames );
 
-		// B-series modulation (other than phase mod)
-		switch( m_bmod )
-		{
-			case MOD_MIX:
-				B1_L = ( B1_L + B2_L ) / 2.0;
-				B1_R = ( B1_R + B2_R ) / 2.0;
-				break;
-			case MOD_AM:
-				B1_L *= qMax( 0.0f, B2_L + 1.0f );
-				B1_R *= qMax( 0.0f, B2_R + 1.0f );
-				break;
-			case MOD_RM:
-				B1_L *= B2_L;
-				B1_R *= B2_R;
-				break;
-		}
-		m_bbuf[frame][0] = B1_L;
-		m_bbuf[frame][1] = B1_R;
+			/////////////   B-series   /////////////////
 
-		// update phases
-		for( int i = 0; i < NUM_OSCS; i++ )
-		{
-			m_lphase[i] += ( static_cast<float>( WAVELEN ) / ( m_samplerate / ( m_nph->frequency() * m_parent->m_lfreq[i] ) ) );
-			m_lphase[i] = fmodf( m_lphase[i], WAVELEN );
-			m_rphase[i] += ( static_cast<float>( WAVELEN ) / ( m_samplerate / ( m_nph->frequency() * m_parent->m_rfreq[i] ) ) );
-			m_rphase[i] = fmodf( m_rphase[i], WAVELEN );
+			oscillate( B2_OSC, phase[B2_OSC], freq * mult[B2_OSC], NULL,
+						vol[B2_OSC], B2, frames );
+			// if crosstalk active, add a1
+			if( xt > 0.0f )
+			{
+				for( int f = 0; f < frames; f++ )
+				{
+					B2[f] += A1[f] * xt;
+				}
+			}
+			oscillate( B1_OSC, phase[B1_OSC], freq * mult[B1_OSC],
+						m_bmod == MOD_PM ? B2 : NULL,
+						vol[B1_OSC], B1, frames );
+
+			// A-series modulation (other than phase mod)
+			sampleFrame * abuf = m_abuf + start;
+			switch( m_amod )
+			{
+				case MOD_MIX:
+					for( int f = 0; f < frames; f++ )
+					{
+						abuf[f][ch] = ( A1[f] + A2[f] ) / 2.0f;
+					}
+					break;
+				case MOD_AM:
+					for( int f = 0; f < frames; f++ )
+					{
+						abuf[f][ch] = A1[f] * qMax( 0.0f, A2[f] + 1.0f );
+					}
+					break;
+				case MOD_RM:
+					for( int f = 0; f < frames; f++ )
+					{
+						abuf[f][ch] = A1[f] * A2[f];
+					}
+					break;
+				default:
+					for( int f = 0; f < frames; f++ )
+					{
+						abuf[f][ch] = A1[f];
+					}
+					break;
+			}
+
+			// B-series modulation (other than phase mod)
+			sampleFrame * bbuf = m_bbuf + start;
+			switch( m_bmod )
+			{
+				case MOD_MIX:
+					for( int f = 0; f < frames; f++ )
+					{
+						bbuf[f][ch] = ( B1[f] + B2[f] ) / 2.0f;
+					}
+					break;
+				case MOD_AM:
+					for( int f = 0; f < frames; f++ )
+					{
+						bbuf[f][ch] = B1[f] * qMax( 0.0f, B2[f] + 1.0f );
+					}
+					break;
+				case MOD_RM:
+					for( int f = 0; f < frames; f++ )
+					{
+						bbuf[f][ch] = B1[f] * B2[f];
+					}
+					break;
+				default:
+					for( int f = 0; f < frames; f++ )
+					{
+						bbuf[f][ch] = B1[f];
+					}
+					break;
+			}
 		}
 	}
-
 }
 
 
@@ -333,13 +340,10 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 	if ( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
 		WatsynObject * w = new WatsynObject(
-				&A1_wave[0],
-				&A2_wave[0],
-				&B1_wave[0],
-				&B2_wave[0],
+				m_waves,
 				m_amod.value(), m_bmod.value(),
 				Engine::mixer()->processingSampleRate(), _n,
-				Engine::mixer()->framesPerPeriod(), this );
+				Mixer::maxFramesPerPeriod(), this );
 
 		_n->m_pluginData = w;
 	}
@@ -636,29 +640,29 @@ void WatsynInstrument::updateFreqB2()
 
 void WatsynInstrument::updateWaveA1()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A1_wave[0], const_cast<float*>( a1_graph.samples() ) );
+	// band-limit the graph for all pitches
+	std::atomic_store( &m_waves[A1_OSC], WaveMipMapCache::get( a1_graph.samples(), GRAPHLEN ) );
 }
 
 
 void WatsynInstrument::updateWaveA2()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A2_wave[0], const_cast<float*>( a2_graph.samples() ) );
+	// band-limit the graph for all pitches
+	std::atomic_store( &m_waves[A2_OSC], WaveMipMapCache::get( a2_graph.samples(), GRAPHLEN ) );
 }
 
 
 void WatsynInstrument::updateWaveB1()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B1_wave[0], const_cast<float*>( b1_graph.samples() ) );
+	// band-limit the graph for all pitches
+	std::atomic_store( &m_waves[B1_OSC], WaveMipMapCache::get( b1_graph.samples(), GRAPHLEN ) );
 }
 
 
 void WatsynInstrument::updateWaveB2()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B2_wave[0], const_cast<float*>( b2_graph.samples() ) );
+	// band-limit the graph for all pitches
+	std::atomic_store( &m_waves[B2_OSC], WaveMipMapCache::get( b2_graph.samples(), GRAPHLEN ) );
 }
 
 
@@ -34,8 +34,8 @@
 #include "TempoSyncKnob.h"
 #include "NotePlayHandle.h"
 #include "PixmapButton.h"
-#include <samplerate.h>
 #include "MemoryManager.h"
+#include "WaveMipMapCache.h"
 
 
 #define makeknob( name, x, y, hint, unit, oname ) 		\
@@ -60,10 +60,9 @@
 
 const int GRAPHLEN = 220; // don't change - must be same as the size of the widget
 
-const int WAVERATIO = 32; // oversampling ratio
+const float PMOD_AMT = 0.5f; // in cycles at full modulation
 
-const int WAVELEN = GRAPHLEN * WAVERATIO;
-const int PMOD_AMT = WAVELEN / 2;
+const int RENDER_BLOCK = 64; // frames rendered at once by the oscillators
 
 const int	MOD_MIX = 0;
 const int	MOD_AM = 1;
@@ -83,8 +82,7 @@ class WatsynObject
 {
 	MM_OPERATORS
 public:
-	WatsynObject( 	float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
+	WatsynObject( 	const WaveMipMapCache::MipMapPtr * _waves,
 					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
 					WatsynInstrument * _w );
 	virtual ~WatsynObject();
@@ -105,6 +103,11 @@ public:
 	}
 
 private:
+	// renders _frames frames of oscillator _osc from _phase on, each phase
+	// moved by _pm times PMOD_AMT if _pm isn't NULL
+	void oscillate( int _osc, float & _phase, float _coeff, const float * _pm,
+						float _vol, float * _out, int _frames );
+
 	int m_amod;
 	int m_bmod;
 
@@ -121,10 +124,7 @@ private:
 	float m_lphase [NUM_OSCS];
 	float m_rphase [NUM_OSCS];
 
-	float m_A1wave [WAVELEN];
-	float m_A2wave [WAVELEN];
-	float m_B1wave [WAVELEN];
-	float m_B2wave [WAVELEN];
+	WaveMipMapCache::MipMapPtr m_waves [NUM_OSCS];
 };
 
 class WatsynInstrument : public Instrument
@@ -181,62 +181,6 @@ private:
 		return ( _pan >= 0 ? 1.0 : 1.0 + ( _pan / 100.0 ) ) * _vol / 100.0;
 	}
 
-	// memcpy utilizing libsamplerate (src) for sinc interpolation
-	inline void srccpy( float * _dst, float * _src )
-	{
-		int err;
-		const int margin = 64;
-		
-		// copy to temp array
-		float tmps [ GRAPHLEN + margin ]; // temp array in stack
-		float * tmp = &tmps[0];
-
-		memcpy( tmp, _src, sizeof( float ) * GRAPHLEN );
-		memcpy( tmp + GRAPHLEN, _src, sizeof( float ) * margin );
-		SRC_STATE * src_state = src_new( SRC_SINC_FASTEST, 1, &err );
-		SRC_DATA src_data;
-		src_data.data_in = tmp;
-		src_data.input_frames = GRAPHLEN + margin;
-		src_data.data_out = _dst;
-		src_data.output_frames = WAVELEN;
-		src_data.src_ratio = static_cast<double>( WAVERATIO );
-		src_data.end_of_input = 0;
-		err = src_process( src_state, &src_data ); 
-		if( err ) { qDebug( "Watsyn SRC error: %s", src_strerror( err ) ); }
-		src_delete( src_state );
-	}
-
-	// memcpy utilizing cubic interpolation
-/*	inline void cipcpy( float * _dst, float * _src )
-	{
-		// calculate cyclic tangents
-		float tang[GRAPHLEN];
-		tang[0] = ( _src[1] - _src[ GRAPHLEN - 1] ) / 2;
-		tang[ GRAPHLEN - 1 ] = ( _src[0] - _src[ GRAPHLEN - 2 ] ) / 2;
-		for( int i = 1; i < GRAPHLEN-1; i++ )
-		{
-			tang[i] = ( _src[i+1] - _src[i-1] ) / 2;
-		}
-		
-		// calculate cspline
-		for( int i=0; i < WAVELEN; i++ )
-		{
-			const float s1 = _src[ i / WAVERATIO ];
-			const float s2 = _src[ ( i / WAVERATIO + 1 ) % GRAPHLEN ];
-			const float m1 = tang[ i / WAVERATIO ];
-			const float m2 = tang[ ( i / WAVERATIO + 1 ) % GRAPHLEN ];
-			
-			const float x = static_cast<float>( i % WAVERATIO ) / WAVERATIO;
-			const float x2 = x * x;
-			const float x3 = x * x * x;
-			
-			_dst[i] = ( ( x3 * 2.0 - x2 * 3.0 + 1.0 ) * s1 ) +
-				( ( x3 * -2.0 + x2 * 3.0 ) * s2 ) +
-				( ( x3 - x2 * 2 + x ) * m1 ) +
-				( ( x3 - x2 ) * m2 );		
-		}
-	}*/
-
 
 	FloatModel a1_vol;
 	FloatModel a2_vol;
@@ -283,10 +227,9 @@ private:
 
 	IntModel m_selectedGraph;
 	
-	float A1_wave [WAVELEN];
-	float A2_wave [WAVELEN];
-	float B1_wave [WAVELEN];
-	float B2_wave [WAVELEN];
+	// band-limited tables of the graphs, replaced as a whole when a graph
+	// changes, so a note starting meanwhile gets either of them
+	WaveMipMapCache::MipMapPtr m_waves [NUM_OSCS];
 
 	friend class WatsynObject;
 	friend class WatsynView;
@@ -28,6 +28,7 @@
 #include "lmms_math.h"
 #include "embed.h"
 #include "interpolation.h"
+#include "Oversampler.h"
 
 #include "plugin_export.h"
 
@@ -57,6 +58,9 @@ waveShaperEffect::waveShaperEffect( Model * _parent,
 	Effect( &waveshaper_plugin_descriptor, _parent, _key ),
 	m_wsControls( this )
 {
+	// the shaping adds harmonics, so it runs at 4 times the output rate
+	// to keep them from aliasing back into the audible range
+	setOversamplingRate( 4 );
 }
 
 
@@ -97,13 +101,19 @@ bool waveShaperEffect::processAudioBuffer( sampleFrame * _buf,
 	const float *inputPtr = inputBuffer ? &( inputBuffer->values()[ 0 ] ) : &input;
 	const float *outputPtr = outputBufer ? &( outputBufer->values()[ 0 ] ) : &output;
 
-	for( fpp_t f = 0; f < _frames; ++f )
+	Oversampler * oversampler = Effect::oversampler();
+	const int factor = oversampler->factor();
+	sampleFrame * os = oversampler->up( _buf, _frames );
+	const f_cnt_t osFrames = static_cast<f_cnt_t>( _frames ) * factor;
+
+	for( f_cnt_t f = 0; f < osFrames; ++f )
 	{
-		float s[2] = { _buf[f][0], _buf[f][1] };
+		const f_cnt_t frame = f / factor;
+		float s[2] = { os[f][0], os[f][1] };
 
 // apply input gain
-		s[0] *= *inputPtr;
-		s[1] *= *inputPtr;
+		s[0] *= inputPtr[ frame * inputInc ];
+		s[1] *= inputPtr[ frame * inputInc ];
 
 // clip if clip enabled
 		if( clip )
@@ -136,17 +146,17 @@ bool waveShaperEffect::processAudioBuffer( sampleFrame * _buf,
 			}
 		}
 
-// apply output gain
-		s[0] *= *outputPtr;
-		s[1] *= *outputPtr;
+// apply output gain and mix wet/dry signals, while both are still
+// oversampled, so the downsampler shifts their phases alike
+		os[f][0] = d * os[f][0] + w * s[0] * outputPtr[ frame * outputInc ];
+		os[f][1] = d * os[f][1] + w * s[1] * outputPtr[ frame * outputInc ];
+	}
 
-// mix wet/dry signals
-		_buf[f][0] = d * _buf[f][0] + w * s[0];
-		_buf[f][1] = d * _buf[f][1] + w * s[1];
-		out_sum += _buf[f][0] * _buf[f][0] + _buf[f][1] * _buf[f][1];
+	oversampler->down( os, _buf, _frames );
 
-		outputPtr += outputInc;
-		inputPtr += inputInc;
+	for( fpp_t f = 0; f < _frames; ++f )
+	{
+		out_sum += _buf[f][0] * _buf[f][0] + _buf[f][1] * _buf[f][1];
 	}
 
 	checkGate( out_sum / _frames );
@@ -144,6 +144,9 @@ ZynAddSubFxInstrument::ZynAddSubFxInstrument(
 
 	connect( Engine::mixer(), SIGNAL( sampleRateChanged() ),
 			this, SLOT( reloadPlugin() ) );
+	// ZynAddSubFX allocates its buffers for one period
+	connect( Engine::mixer(), SIGNAL( framesPerPeriodChanged() ),
+			this, SLOT( reloadPlugin() ) );
 
 	connect( instrumentTrack()->pitchRangeModel(), SIGNAL( dataChanged() ),
 			this, SLOT( updatePitchRange() ), Qt::DirectConnection );
@@ -351,6 +354,14 @@ void ZynAddSubFxInstrument::play( sampleFrame * _buf )
 
 
 
+RemotePlugin * ZynAddSubFxInstrument::remotePlugin() const
+{
+	return m_remotePlugin;
+}
+
+
+
+
 bool ZynAddSubFxInstrument::handleMidiEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	// do not forward external MIDI Control Change events if the according
@@ -85,6 +85,8 @@ public:
 		return IsSingleStreamed | IsMidiBased;
 	}
 
+	RemotePlugin * remotePlugin() const override;
+
 	virtual PluginView * instantiateView( QWidget * _parent );
 
 
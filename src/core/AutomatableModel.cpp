@@ -24,16 +24,31 @@
 
 #include "AutomatableModel.h"
 
+#include <algorithm>
+
 #include "lmms_math.h"
 
 #include "AutomationPattern.h"
 #include "ControllerConnection.h"
+#include "EngineContext.h"
 #include "LocaleHelper.h"
 #include "Mixer.h"
 #include "ProjectJournal.h"
 #include "Song.h"
+#include "lmmsconfig.h"
+
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+#include <xmmintrin.h>
+#endif
+
+
+static inline void pauseCpu()
+{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+	_mm_pause();
+#endif
+}
 
-long AutomatableModel::s_periodCounter = 0;
 
 
 
@@ -53,12 +68,18 @@ AutomatableModel::AutomatableModel(
 	m_controllerConnection( NULL ),
 	m_valueBuffer( static_cast<int>( Engine::mixer()->framesPerPeriod() ) ),
 	m_lastUpdatedPeriod( -1 ),
+	m_claimedPeriod( -1 ),
+	m_automatedPeriod( -1 ),
+	m_automatedFrames( 0 ),
 	m_hasSampleExactData(false),
 	m_useControllerValue(true)
 
 {
 	m_value = fittedValue( val );
 	setInitValue( val );
+
+	// resized to the current period before updating, within this capacity
+	m_valueBuffer.reserve( Mixer::maxFramesPerPeriod() );
 }
 
 
@@ -378,9 +399,7 @@ void AutomatableModel::setAutomatedValue( const float value )
 	++m_setValueDepth;
 	const float oldValue = m_value;
 
-	const float scaled_value = scaledValue( value );
-
-	m_value = fittedValue( scaled_value );
+	m_value = automatedValueOf( value );
 
 	if( oldValue != m_value )
 	{
@@ -403,6 +422,60 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 
 
+float AutomatableModel::automatedValueOf( const float value ) const
+{
+	return fittedValue( scaledValue( value ) );
+}
+
+
+
+
+void AutomatableModel::setAutomatedValueBuffer( const float * values,
+						f_cnt_t offset, f_cnt_t frames )
+{
+	ValueBuffer & buffer = m_automatedBuffer;
+	const f_cnt_t length = Engine::mixer()->framesPerPeriod();
+	if( buffer.length() != length )
+	{
+		buffer.resize( length );
+	}
+	const long period = EngineContext::current()->period();
+	if( m_automatedPeriod != period )
+	{
+		m_automatedPeriod = period;
+		m_automatedFrames = 0;
+	}
+
+	float * out = buffer.values();
+	f_cnt_t & done = m_automatedFrames;
+	const f_cnt_t end = qMin( offset + frames, length );
+	if( done < offset )
+	{
+		// frames nobody rendered, e.g. before the first tick of the
+		// period, keep the last value
+		std::fill( out + done, out + offset,
+					done > 0 ? out[done - 1] : m_value );
+	}
+	for( f_cnt_t f = offset; f < end; ++f )
+	{
+		out[f] = fittedValue( scaledValue( values[f - offset] ) );
+	}
+	done = qMax( done, end );
+
+	++m_setValueDepth;
+	for( AutomatableModel * linked : m_linkedModels )
+	{
+		if( !linked->controllerConnection() && linked->m_setValueDepth < 1 )
+		{
+			linked->setAutomatedValueBuffer( values, offset, frames );
+		}
+	}
+	--m_setValueDepth;
+}
+
+
+
+
 void AutomatableModel::setRange( const float min, const float max,
 							const float step )
 {
@@ -598,17 +671,57 @@ float AutomatableModel::controllerValue( int frameOffset ) const
 
 ValueBuffer * AutomatableModel::valueBuffer()
 {
-	QMutexLocker m( &m_valueBufferMutex );
+	const long period = EngineContext::current()->period();
 	// if we've already calculated the valuebuffer this period, return the cached buffer
-	if( m_lastUpdatedPeriod == s_periodCounter )
+	if( m_lastUpdatedPeriod.load( std::memory_order_acquire ) != period )
 	{
-		return m_hasSampleExactData
-			? &m_valueBuffer
-			: NULL;
+		// the first thread asking in a period calculates the buffer, all
+		// others wait for it - which takes less than a context switch
+		long claimed = m_claimedPeriod.load( std::memory_order_relaxed );
+		if( claimed != period &&
+			m_claimedPeriod.compare_exchange_strong( claimed, period ) )
+		{
+			m_hasSampleExactData = updateValueBuffer();
+			m_lastUpdatedPeriod.store( period, std::memory_order_release );
+		}
+		else
+		{
+			while( m_lastUpdatedPeriod.load( std::memory_order_acquire ) != period )
+			{
+				pauseCpu();
+			}
+		}
 	}
 
+	return m_hasSampleExactData ? &m_valueBuffer : NULL;
+}
+
+
+
+
+bool AutomatableModel::updateValueBuffer()
+{
 	float val = m_value; // make sure our m_value doesn't change midway
 
+	const int frames = Engine::mixer()->framesPerPeriod();
+	if( m_valueBuffer.length() != frames )
+	{
+		m_valueBuffer.resize( frames );
+	}
+
+	// frames rendered by an automation pattern
+	if( m_automatedPeriod == EngineContext::current()->period() )
+	{
+		const ValueBuffer & buffer = m_automatedBuffer;
+		const f_cnt_t done = m_automatedFrames;
+		float * nvalues = m_valueBuffer.values();
+		std::copy( buffer.begin(), buffer.begin() + done, nvalues );
+		std::fill( nvalues + done, nvalues + m_valueBuffer.length(),
+					done > 0 ? nvalues[done - 1] : val );
+		m_oldValue = val;
+		return true;
+	}
+
 	ValueBuffer * vb;
 	if (m_controllerConnection && m_useControllerValue && m_controllerConnection->getController()->isSampleExact())
 	{
@@ -636,9 +749,7 @@ ValueBuffer * AutomatableModel::valueBuffer()
 					"lacks implementation for a scale type");
 				break;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
+			return true;
 		}
 	}
 
@@ -659,9 +770,7 @@ ValueBuffer * AutomatableModel::valueBuffer()
 			{
 				nvalues[i] = fittedValue(values[i]);
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
+			return true;
 		}
 	}
 
@@ -669,16 +778,12 @@ ValueBuffer * AutomatableModel::valueBuffer()
 	{
 		m_valueBuffer.interpolate( m_oldValue, val );
 		m_oldValue = val;
-		m_lastUpdatedPeriod = s_periodCounter;
-		m_hasSampleExactData = true;
-		return &m_valueBuffer;
+		return true;
 	}
 
-	// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
-	// in which case the recipient knows to use the static value() instead
-	m_lastUpdatedPeriod = s_periodCounter;
-	m_hasSampleExactData = false;
-	return NULL;
+	// if we have no sample-exact source for a ValueBuffer, valueBuffer() returns NULL to signify that no data is available
+	// at the moment in which case the recipient knows to use the static value() instead
+	return false;
 }
 
 
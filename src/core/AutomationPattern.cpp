@@ -27,6 +27,7 @@
 #include "AutomationPattern.h"
 
 #include "AutomationNode.h"
+#include "AutomationSchedule.h"
 #include "AutomationPatternView.h"
 #include "AutomationTrack.h"
 #include "BBTrackContainer.h"
@@ -34,9 +35,13 @@
 #include "ProjectJournal.h"
 #include "Song.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include <QTimer>
+
 int AutomationPattern::s_quantization = 1;
+std::atomic<unsigned> AutomationPattern::s_editRevision( 0 );
 const float AutomationPattern::DEFAULT_MIN_VALUE = 0;
 const float AutomationPattern::DEFAULT_MAX_VALUE = 1;
 
@@ -48,9 +53,12 @@ AutomationPattern::AutomationPattern( AutomationTrack * _auto_track ) :
 	m_objects(),
 	m_tension( 1.0 ),
 	m_progressionType( DiscreteProgression ),
+	m_segmentsValid( false ),
+	m_lastSegment( 0 ),
 	m_dragging( false ),
 	m_isRecording( false ),
-	m_lastRecordedValue( 0 )
+	m_lastRecordedValue( 0 ),
+	m_recordTimer( nullptr )
 {
 	changeLength( TimePos( 1, 0 ) );
 	if( getTrack() )
@@ -79,7 +87,12 @@ AutomationPattern::AutomationPattern( const AutomationPattern & _pat_to_copy ) :
 	m_autoTrack( _pat_to_copy.m_autoTrack ),
 	m_objects( _pat_to_copy.m_objects ),
 	m_tension( _pat_to_copy.m_tension ),
-	m_progressionType( _pat_to_copy.m_progressionType )
+	m_progressionType( _pat_to_copy.m_progressionType ),
+	m_segmentsValid( false ),
+	m_lastSegment( 0 ),
+	m_isRecording( false ),
+	m_lastRecordedValue( 0 ),
+	m_recordTimer( nullptr )
 {
 	// Locks the mutex of the copied AutomationPattern to make sure it
 	// doesn't change while it's being copied
@@ -125,6 +138,7 @@ bool AutomationPattern::addObject( AutomatableModel * _obj, bool _search_dup )
 	}
 
 	m_objects += _obj;
+	AutomationSchedule::arrangementChanged();
 
 	connect( _obj, SIGNAL( destroyed( jo_id_t ) ),
 			this, SLOT( objectDestroyed( jo_id_t ) ),
@@ -148,6 +162,7 @@ void AutomationPattern::setProgressionType(
 		_new_progression_type == CubicHermiteProgression )
 	{
 		m_progressionType = _new_progression_type;
+		invalidateSegments();
 		emit dataChanged();
 	}
 }
@@ -165,6 +180,7 @@ void AutomationPattern::setTension( QString _new_tension )
 	if( ok && nt > -0.01 && nt < 1.01 )
 	{
 		m_tension = nt;
+		invalidateSegments();
 	}
 }
 
@@ -331,6 +347,28 @@ TimePos AutomationPattern::putValues(
 
 
 
+void AutomationPattern::putValues(const QMap<int, float> & values)
+{
+	if (values.isEmpty()) { return; }
+
+	QMutexLocker m(&m_patternMutex);
+
+	cleanObjects();
+
+	for (auto it = values.begin(); it != values.end(); ++it)
+	{
+		m_timeMap[it.key()] = AutomationNode(this, it.value(), it.key());
+	}
+	generateTangents();
+
+	updateLength();
+
+	emit dataChanged();
+}
+
+
+
+
 void AutomationPattern::removeNode(const TimePos & time)
 {
 	QMutexLocker m(&m_patternMutex);
@@ -432,6 +470,102 @@ void AutomationPattern::recordValue(TimePos time, float value)
 
 
 
+void AutomationPattern::setRecording( const bool b )
+{
+	if( b == m_isRecording )
+	{
+		return;
+	}
+
+	if( b )
+	{
+		if( !m_recordedValues )
+		{
+			m_recordedValues.reset(
+				new LocklessList<RecordedValue>( RecordQueueSize ) );
+			m_recordTimer = new QTimer( this );
+			connect( m_recordTimer, SIGNAL( timeout() ),
+					this, SLOT( mergeRecordedValues() ) );
+		}
+		else
+		{
+			// drop what the song queued after the last take ended
+			for( auto e = m_recordedValues->popList(); e != nullptr; )
+			{
+				auto next = e->next;
+				m_recordedValues->free( e );
+				e = next;
+			}
+		}
+		// recorded on the thread changing the value, e.g. the one
+		// receiving MIDI events
+		m_recordConnection = connect( firstObject(), SIGNAL( dataChanged() ),
+				this, SLOT( recordObjectChange() ), Qt::DirectConnection );
+		m_recordTimer->start( RecordMergeInterval );
+		m_isRecording = true;
+	}
+	else
+	{
+		m_isRecording = false;
+		disconnect( m_recordConnection );
+		m_recordTimer->stop();
+		mergeRecordedValues();
+	}
+}
+
+
+
+
+void AutomationPattern::queueRecordedValue( const TimePos & time, float value )
+{
+	// if the GUI falls that much behind, drop values rather than block
+	m_recordedValues->tryPush( { time.getTicks(), value } );
+}
+
+
+
+
+void AutomationPattern::recordObjectChange()
+{
+	const Song * song = Engine::getSong();
+	if( !m_isRecording || !song->isPlaying() ||
+		song->playMode() != Song::Mode_PlaySong ||
+		!getTrack() || getTrack()->trackContainer() != song )
+	{
+		return;
+	}
+
+	const TimePos time = song->getPlayPos( Song::Mode_PlaySong ) - startPosition();
+	if( time >= 0 && time < length() )
+	{
+		queueRecordedValue( time, firstObject()->value<float>() );
+	}
+}
+
+
+
+
+void AutomationPattern::mergeRecordedValues()
+{
+	// the list is newest first
+	std::vector<RecordedValue> values;
+	for( auto e = m_recordedValues->popList(); e != nullptr; )
+	{
+		values.push_back( e->value );
+		auto next = e->next;
+		m_recordedValues->free( e );
+		e = next;
+	}
+
+	for( auto it = values.rbegin(); it != values.rend(); ++it )
+	{
+		recordValue( it->time, it->value );
+	}
+}
+
+
+
+
 /**
  * @brief Set the position of the point that is being dragged.
  *        Calling this function will also automatically set m_dragging to true.
@@ -509,34 +643,135 @@ float AutomationPattern::valueAt( const TimePos & _time ) const
 {
 	QMutexLocker m(&m_patternMutex);
 
-	if( m_timeMap.isEmpty() )
+	if( !m_segmentsValid )
+	{
+		compileSegments();
+	}
+
+	const int i = findSegment( _time );
+	if( i < 0 )
 	{
 		return 0;
 	}
 
-	// If we have a node at that time, just return its value
-	if (m_timeMap.contains(_time))
+	const Segment & segment = m_segments[i];
+	const int offset = _time - segment.pos;
+	if( offset == 0 )
 	{
 		// When the time is exactly the node's time, we want the inValue
-		return m_timeMap[_time].getInValue();
+		return segment.inValue;
 	}
+	const float t = offset * segment.scale;
+	return ( ( segment.a * t + segment.b ) * t + segment.c ) * t + segment.d;
+}
 
-	// lowerBound returns next value with equal or greater key. Since we already
-	// checked if the key contains a node, we know the returned node has a greater
-	// key than _time. Therefore we take the previous element to calculate the current value
-	timeMap::const_iterator v = m_timeMap.lowerBound(_time);
 
-	if( v == m_timeMap.begin() )
+
+
+void AutomationPattern::valuesAt( const TimePos & time, float offset,
+				float step, float * values, int frames ) const
+{
+	QMutexLocker m(&m_patternMutex);
+
+	if( !m_segmentsValid )
 	{
-		return 0;
+		compileSegments();
 	}
-	if( v == m_timeMap.end() )
+
+	// all frames are before the next node, so they share a segment
+	const int i = findSegment( time );
+	if( i < 0 )
 	{
-		// When the time is after the last node, we want the outValue of it
-		return OUTVAL(v - 1);
+		std::fill( values, values + frames, 0.0f );
+		return;
 	}
 
-	return valueAt(v - 1, _time - POS(v - 1));
+	const Segment & segment = m_segments[i];
+	const float start = time.getTicks() - segment.pos + offset;
+	for( int f = 0; f < frames; ++f )
+	{
+		const float x = start + f * step;
+		if( x == 0 )
+		{
+			values[f] = segment.inValue;
+			continue;
+		}
+		const float t = x * segment.scale;
+		values[f] = ( ( segment.a * t + segment.b ) * t + segment.c ) * t
+								+ segment.d;
+	}
+}
+
+
+
+
+void AutomationPattern::compileSegments() const
+{
+	m_segments.clear();
+	m_segments.reserve( m_timeMap.size() );
+	for( timeMap::const_iterator v = m_timeMap.begin(); v != m_timeMap.end(); ++v )
+	{
+		// after the last node and with discrete progression, the
+		// value is the outValue
+		Segment segment = { POS(v), INVAL(v), 0, 0, 0, OUTVAL(v), 0 };
+		if( v + 1 != m_timeMap.end() &&
+			m_progressionType != DiscreteProgression )
+		{
+			const int numValues = POS(v + 1) - POS(v);
+			segment.scale = 1.0f / numValues;
+			if( m_progressionType == LinearProgression )
+			{
+				segment.c = INVAL(v + 1) - OUTVAL(v);
+			}
+			else /* CubicHermiteProgression */
+			{
+				// the Cubic Hermite spline of valueAt( v, offset )
+				// with its basis functions expanded
+				const float y1 = OUTVAL(v);
+				const float y2 = INVAL(v + 1);
+				const float m1 = OUTTAN(v) * numValues * m_tension;
+				const float m2 = INTAN(v + 1) * numValues * m_tension;
+				segment.a = 2 * y1 + m1 - 2 * y2 + m2;
+				segment.b = -3 * y1 - 2 * m1 + 3 * y2 - m2;
+				segment.c = m1;
+			}
+		}
+		m_segments.push_back( segment );
+	}
+	m_lastSegment = 0;
+	m_segmentsValid = true;
+}
+
+
+
+
+int AutomationPattern::findSegment( int time ) const
+{
+	const int count = static_cast<int>( m_segments.size() );
+	auto contains = [this, count, time]( int i )
+	{
+		return m_segments[i].pos <= time &&
+			( i + 1 == count || time < m_segments[i + 1].pos );
+	};
+
+	// while playing, time is in the segment used last or in the next one
+	if( m_lastSegment < count && contains( m_lastSegment ) )
+	{
+		return m_lastSegment;
+	}
+	if( m_lastSegment + 1 < count && contains( m_lastSegment + 1 ) )
+	{
+		return ++m_lastSegment;
+	}
+
+	auto next = std::upper_bound( m_segments.begin(), m_segments.end(), time,
+		[]( int t, const Segment & segment ) { return t < segment.pos; } );
+	if( next == m_segments.begin() )
+	{
+		return -1;
+	}
+	m_lastSegment = static_cast<int>( next - m_segments.begin() ) - 1;
+	return m_lastSegment;
 }
 
 
@@ -604,10 +839,8 @@ float *AutomationPattern::valuesAfter( const TimePos & _time ) const
 	int numValues = POS(v + 1) - POS(v);
 	float *ret = new float[numValues];
 
-	for( int i = 0; i < numValues; i++ )
-	{
-		ret[i] = valueAt( v, i );
-	}
+	// evaluate the baked curve rather than the spline of every tick
+	valuesAt( POS(v), 0, 1, ret, numValues );
 
 	return ret;
 }
@@ -1055,6 +1288,7 @@ void AutomationPattern::clear()
 	QMutexLocker m(&m_patternMutex);
 
 	m_timeMap.clear();
+	invalidateSegments();
 
 	emit dataChanged();
 }
@@ -1080,6 +1314,7 @@ void AutomationPattern::objectDestroyed( jo_id_t _id )
 		{
 			//Assign to objIt so that this loop work even break; is removed.
 			objIt = m_objects.erase( objIt );
+			AutomationSchedule::arrangementChanged();
 			break;
 		}
 	}
@@ -1090,6 +1325,15 @@ void AutomationPattern::objectDestroyed( jo_id_t _id )
 
 
 
+void AutomationPattern::invalidateSegments()
+{
+	m_segmentsValid = false;
+	++s_editRevision;
+}
+
+
+
+
 void AutomationPattern::cleanObjects()
 {
 	QMutexLocker m(&m_patternMutex);
@@ -1103,6 +1347,7 @@ void AutomationPattern::cleanObjects()
 		else
 		{
 			it = m_objects.erase( it );
+			AutomationSchedule::arrangementChanged();
 		}
 	}
 }
@@ -1126,6 +1371,9 @@ void AutomationPattern::generateTangents(timeMap::iterator it, int numToGenerate
 {
 	QMutexLocker m(&m_patternMutex);
 
+	// all changes of the nodes end up here
+	invalidateSegments();
+
 	if( m_timeMap.size() < 2 && numToGenerate > 0 )
 	{
 		it.value().setInTangent(0);
@@ -0,0 +1,411 @@
+/*
+ * AutomationSchedule.cpp - automation of a track container, prepared for playback
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AutomationSchedule.h"
+
+#include <algorithm>
+
+#include <QtCore/QHash>
+
+#include "AutomationPattern.h"
+#include "BBTrack.h"
+#include "BBTrackContainer.h"
+#include "Engine.h"
+
+
+std::atomic<unsigned> AutomationSchedule::s_revision(0);
+
+
+
+
+AutomationSchedule::AutomationSchedule() :
+	m_revision(0),
+	m_container(nullptr),
+	m_tcoNum(-1),
+	m_bbLength(0)
+{
+}
+
+
+
+
+AutomationSchedule::~AutomationSchedule()
+{
+}
+
+
+
+
+bool AutomationSchedule::isCurrent(const TrackContainer* container, int tcoNum) const
+{
+	return m_container == container && m_tcoNum == tcoNum && m_revision == s_revision;
+}
+
+
+
+
+void AutomationSchedule::build(const TrackContainer* container, const TrackList& tracks, int tcoNum)
+{
+	std::vector<Slot> oldSlots;
+	oldSlots.swap(m_slots);
+	m_sources.clear();
+	m_bbSchedules.clear();
+
+	m_revision = s_revision;
+	m_container = container;
+	m_tcoNum = tcoNum;
+	m_bbLength = 0;
+
+	BBTrackContainer* bbContainer = Engine::getBBTrackContainer();
+	if (tcoNum >= 0)
+	{
+		Q_ASSERT(container == bbContainer);
+		m_bbLength = bbContainer->lengthOfBB(tcoNum) * TimePos::ticksPerBar();
+	}
+
+	for (Track* track : tracks)
+	{
+		switch (track->type())
+		{
+		case Track::AutomationTrack:
+		case Track::HiddenAutomationTrack:
+		case Track::BBTrack:
+			break;
+		default:
+			continue;
+		}
+
+		if (tcoNum < 0)
+		{
+			for (TrackContentObject* tco : track->getTCOs())
+			{
+				m_sources.push_back({tco, dynamic_cast<AutomationPattern*>(tco), nullptr});
+			}
+		}
+		else if (track->numOfTCOs() > tcoNum)
+		{
+			TrackContentObject* tco = track->getTCO(tcoNum);
+			m_sources.push_back({tco, dynamic_cast<AutomationPattern*>(tco), nullptr});
+		}
+	}
+
+	// The same order automatedValuesFromTracks() gets from
+	// getTCOsInRange(): by start, TCOs starting together by track
+	std::stable_sort(m_sources.begin(), m_sources.end(),
+		[](const Source& a, const Source& b)
+		{
+			return a.tco->startPosition() < b.tco->startPosition();
+		});
+
+	QHash<AutomatableModel*, int> slotOfModel;
+	auto slotOf = [this, &slotOfModel](AutomatableModel* model)
+	{
+		auto it = slotOfModel.find(model);
+		if (it == slotOfModel.end())
+		{
+			it = slotOfModel.insert(model, static_cast<int>(m_slots.size()));
+			m_slots.push_back({model, {}, {}, 0, false, {nullptr, 0, false}});
+		}
+		return *it;
+	};
+
+	QHash<int, AutomationSchedule*> bbSchedules;
+	for (size_t i = 0; i < m_sources.size(); ++i)
+	{
+		Source& source = m_sources[i];
+		if (source.pattern)
+		{
+			for (AutomatableModel* model : source.pattern->objects())
+			{
+				if (model)
+				{
+					Slot& slot = m_slots[slotOf(model)];
+					slot.sources.push_back(i);
+					slot.bbSlots.push_back(-1);
+				}
+			}
+		}
+		else if (auto bbTrack = dynamic_cast<BBTrack*>(source.tco->getTrack()))
+		{
+			const int bbIndex = bbTrack->index();
+			AutomationSchedule*& bb = bbSchedules[bbIndex];
+			if (!bb)
+			{
+				bb = new AutomationSchedule;
+				m_bbSchedules.emplace_back(bb);
+				bb->build(bbContainer, bbContainer->tracks(), bbIndex);
+			}
+			source.bb = bb;
+
+			for (size_t bbSlot = 0; bbSlot < bb->m_slots.size(); ++bbSlot)
+			{
+				Slot& slot = m_slots[slotOf(bb->m_slots[bbSlot].model)];
+				slot.sources.push_back(i);
+				slot.bbSlots.push_back(bbSlot);
+			}
+		}
+	}
+
+	// Models automated before keep their state, so apply() knows when to
+	// hand them back to their controllers
+	for (const Slot& oldSlot : oldSlots)
+	{
+		AutomatableModel* model = oldSlot.model;
+		if (!oldSlot.automated || !model)
+		{
+			continue;
+		}
+		auto it = slotOfModel.find(model);
+		if (it != slotOfModel.end())
+		{
+			m_slots[*it].automated = true;
+		}
+		else if (model->controllerConnection())
+		{
+			model->setUseControllerValue(true);
+		}
+	}
+}
+
+
+
+
+void AutomationSchedule::apply(TimePos time, const QSet<const AutomatableModel*>& skip)
+{
+	tick_t ticks = time.getTicks();
+	bool held = false;
+	if (m_tcoNum >= 0)
+	{
+		held = ticks >= m_bbLength;
+		ticks = std::min(ticks, m_bbLength) + TimePos::ticksPerBar() * m_tcoNum;
+	}
+
+	for (Slot& slot : m_slots)
+	{
+		AutomatableModel* model = slot.model;
+		Position& position = slot.position;
+		position.pattern = nullptr;
+		if (!find(slot, ticks, position))
+		{
+			// Move the control back to any connected controller
+			if (slot.automated && model && model->controllerConnection())
+			{
+				model->setUseControllerValue(true);
+			}
+			slot.automated = false;
+			position.pattern = nullptr;
+			continue;
+		}
+
+		slot.automated = true;
+		position.held = position.held || held;
+		if (!model)
+		{
+			position.pattern = nullptr;
+			continue;
+		}
+		if (!skip.contains(model))
+		{
+			model->setAutomatedValue(position.pattern->valueAt(position.time));
+		}
+		else
+		{
+			position.pattern = nullptr;
+			if (!model->useControllerValue())
+			{
+				model->setUseControllerValue(true);
+			}
+		}
+	}
+}
+
+
+
+
+void AutomationSchedule::render(float ticks, f_cnt_t offset, f_cnt_t frames)
+{
+	// After a change of the arrangement, the patterns may be gone
+	if (m_revision != s_revision)
+	{
+		return;
+	}
+
+	m_frames.resize(std::max<size_t>(m_frames.size(), frames));
+	const float step = 1.0f / Engine::framesPerTick();
+
+	for (Slot& slot : m_slots)
+	{
+		const Position& position = slot.position;
+		AutomatableModel* model = slot.model;
+		if (!position.pattern || !model)
+		{
+			continue;
+		}
+		if (position.held)
+		{
+			position.pattern->valuesAt(position.time, 0, 0, m_frames.data(), frames);
+		}
+		else
+		{
+			position.pattern->valuesAt(position.time, ticks, step, m_frames.data(), frames);
+		}
+		model->setAutomatedValueBuffer(m_frames.data(), offset, frames);
+	}
+}
+
+
+
+
+void AutomationSchedule::release()
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.automated && slot.model)
+		{
+			slot.model->setUseControllerValue(true);
+		}
+		slot.automated = false;
+		slot.position.pattern = nullptr;
+	}
+}
+
+
+
+
+void AutomationSchedule::clear()
+{
+	m_sources.clear();
+	m_slots.clear();
+	m_bbSchedules.clear();
+	m_container = nullptr;
+	m_tcoNum = -1;
+}
+
+
+
+
+int AutomationSchedule::slotOf(const AutomatableModel* model) const
+{
+	for (size_t i = 0; i < m_slots.size(); ++i)
+	{
+		if (m_slots[i].model.data() == model)
+		{
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+
+
+
+tick_t AutomationSchedule::endOf(int slot) const
+{
+	tick_t end = 0;
+	for (int source : m_slots[slot].sources)
+	{
+		end = std::max(end, m_sources[source].tco->endPosition().getTicks());
+	}
+	return end;
+}
+
+
+
+
+bool AutomationSchedule::valueAt(int slot, tick_t time, float& value)
+{
+	if (m_tcoNum >= 0)
+	{
+		time = std::min(time, m_bbLength) + TimePos::ticksPerBar() * m_tcoNum;
+	}
+
+	Position position;
+	if (!find(m_slots[slot], time, position))
+	{
+		return false;
+	}
+	value = position.pattern->valueAt(position.time);
+	return true;
+}
+
+
+
+
+bool AutomationSchedule::find(Slot& slot, tick_t time, Position& position)
+{
+	const size_t count = slot.sources.size();
+	auto start = [this, &slot](size_t i)
+	{
+		return m_sources[slot.sources[i]].tco->startPosition().getTicks();
+	};
+
+	// While playing, the cursor moves by at most one source per period
+	while (slot.cursor < count && start(slot.cursor) <= time)
+	{
+		++slot.cursor;
+	}
+	while (slot.cursor > 0 && start(slot.cursor - 1) > time)
+	{
+		--slot.cursor;
+	}
+
+	// The last source starting before time wins, unless it gives no value
+	for (size_t i = slot.cursor; i-- > 0;)
+	{
+		const Source& source = m_sources[slot.sources[i]];
+		if (source.tco->isMuted() || source.tco->getTrack()->isMuted())
+		{
+			continue;
+		}
+
+		const tick_t relTime = time - source.tco->startPosition().getTicks();
+		if (AutomationPattern* p = source.pattern)
+		{
+			if (!p->hasAutomation())
+			{
+				continue;
+			}
+			const tick_t length = p->length().getTicks();
+			const bool clamped = !p->getAutoResize() && relTime >= length;
+			position = {p, clamped ? length : relTime, clamped};
+			return true;
+		}
+		if (source.bb && source.bb->find(source.bb->m_slots[slot.bbSlots[i]],
+							bbTime(source, relTime), position))
+		{
+			position.held = position.held || relTime >= source.tco->length().getTicks();
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+tick_t AutomationSchedule::bbTime(const Source& source, tick_t time)
+{
+	time = std::min(time, source.tco->length().getTicks()) % source.bb->m_bbLength;
+	return time + TimePos::ticksPerBar() * source.bb->m_tcoNum;
+}
@@ -26,6 +26,7 @@
 #include "BBTrackContainer.h"
 #include "BBTrack.h"
 #include "Engine.h"
+#include "InstrumentTrack.h"
 #include "Song.h"
 
 
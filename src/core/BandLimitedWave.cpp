@@ -25,13 +25,151 @@
 
 #include "BandLimitedWave.h"
 
+#include <cstring>
 #include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 
-WaveMipMap BandLimitedWave::s_waveforms[4] = {  };
+const WaveMipMap * BandLimitedWave::s_waveforms = NULL;
 bool BandLimitedWave::s_wavesGenerated = false;
 QString BandLimitedWave::s_wavetableDir = "";
 
 
+namespace
+{
+
+// The table cache is a header followed by the raw WaveMipMaps of all
+// waveforms in native layout, so it can be mapped and used in place. Bump
+// the version whenever the generated tables or WaveMipMap change.
+const quint32 WaveCacheVersion = 1;
+const char WaveCacheMagic[8] = { 'L', 'M', 'M', 'S', 'B', 'L', 'W', 'T' };
+const quint32 WaveCacheByteOrder = 0x01020304;
+
+struct WaveCacheHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 byteOrder;
+	quint32 sampleSize;
+	quint32 waveCount;
+	quint32 mipMapSize;
+	quint32 reserved;
+	quint64 checksum;
+} ;
+
+// keeps the mipmaps aligned within the mapping
+const qint64 WaveCacheHeaderSize = 64;
+static_assert( sizeof( WaveCacheHeader ) <= WaveCacheHeaderSize,
+					"WaveCacheHeader doesn't fit its block" );
+const qint64 WaveCachePayloadSize =
+		sizeof( WaveMipMap ) * BandLimitedWave::NumBLWaveforms;
+const qint64 WaveCacheSize = WaveCacheHeaderSize + WaveCachePayloadSize;
+
+// keeps the mapping of the cache alive
+QFile * s_waveCacheFile = NULL;
+
+
+// 64 bit FNV-1a
+quint64 waveCacheChecksum( const uchar * data, qint64 size )
+{
+	quint64 hash = 14695981039346656037ULL;
+	for( qint64 i = 0; i < size; ++i )
+	{
+		hash = ( hash ^ data[i] ) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+WaveCacheHeader waveCacheHeader( quint64 checksum )
+{
+	WaveCacheHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, WaveCacheMagic, sizeof( WaveCacheMagic ) );
+	header.version = WaveCacheVersion;
+	header.byteOrder = WaveCacheByteOrder;
+	header.sampleSize = sizeof( sample_t );
+	header.waveCount = BandLimitedWave::NumBLWaveforms;
+	header.mipMapSize = sizeof( WaveMipMap );
+	header.checksum = checksum;
+	return header;
+}
+
+
+QString waveCachePath()
+{
+	// lets e.g. render farms point all jobs at one pre-generated file
+	const QByteArray path = qgetenv( "LMMS_WAVETABLE_CACHE" );
+	if( !path.isEmpty() )
+	{
+		return QString::fromLocal8Bit( path );
+	}
+	return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+		QString( "/wavetables-v%1.bin" ).arg( WaveCacheVersion );
+}
+
+
+bool mapWaveCache( const QString & path )
+{
+	QFile * file = new QFile( path );
+	const uchar * data = NULL;
+	if( file->open( QIODevice::ReadOnly ) && file->size() == WaveCacheSize )
+	{
+		// maps read-only, so the pages are shared with all other
+		// processes that map the file
+		data = file->map( 0, WaveCacheSize );
+	}
+	if( data != NULL )
+	{
+		const uchar * payload = data + WaveCacheHeaderSize;
+		const WaveCacheHeader expected = waveCacheHeader(
+				waveCacheChecksum( payload, WaveCachePayloadSize ) );
+		if( memcmp( data, &expected, sizeof( expected ) ) == 0 )
+		{
+			s_waveCacheFile = file;
+			BandLimitedWave::s_waveforms =
+				reinterpret_cast<const WaveMipMap *>( payload );
+			return true;
+		}
+	}
+	// also removes the mapping
+	delete file;
+	return false;
+}
+
+
+bool writeWaveCache( const QString & path, const WaveMipMap * waves )
+{
+	if( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+	{
+		return false;
+	}
+
+	const char * payload = reinterpret_cast<const char *>( waves );
+	const WaveCacheHeader header = waveCacheHeader( waveCacheChecksum(
+				reinterpret_cast<const uchar *>( payload ),
+				WaveCachePayloadSize ) );
+	char headerBlock[WaveCacheHeaderSize] = { };
+	memcpy( headerBlock, &header, sizeof( header ) );
+
+	// the file is only renamed into place once it is complete, so
+	// processes starting at the same time never map a partial table
+	QSaveFile file( path );
+	return file.open( QIODevice::WriteOnly ) &&
+		file.write( headerBlock, WaveCacheHeaderSize ) == WaveCacheHeaderSize &&
+		file.write( payload, WaveCachePayloadSize ) == WaveCachePayloadSize &&
+		file.commit();
+}
+
+
+void computeWaves( WaveMipMap * waves );
+
+} // namespace
+
+
 QDataStream& operator<< ( QDataStream &out, WaveMipMap &waveMipMap )
 {
 	for( int tbl = 0; tbl <= MAXTBL; tbl++ )
@@ -59,21 +197,88 @@ QDataStream& operator>> ( QDataStream &in, WaveMipMap &waveMipMap )
 }
 
 
+void BandLimitedWave::oscillate( const float * _ph, sample_t * _out, int _frames,
+						float _wavelen, const WaveMipMap & _waveform )
+{
+	// same as the single sample version, but the table lookups are done
+	// first, so that the interpolation of a whole block can be vectorized
+	int t = 0;
+	while( t < MAXTBL && _wavelen >= TLENS[t+1] ) { t++; }
+
+	const int tlen = TLENS[t];
+
+	const int BlockSize = 64;
+	float s0[BlockSize];
+	float s1[BlockSize];
+	float s2[BlockSize];
+	float s3[BlockSize];
+	float ip[BlockSize];
+	for( int done = 0; done < _frames; done += BlockSize )
+	{
+		const int frames = qMin( _frames - done, BlockSize );
+		for( int i = 0; i < frames; ++i )
+		{
+			const float lookupf = absFraction( _ph[done + i] ) * static_cast<float>( tlen );
+			const int lookup = static_cast<int>( lookupf );
+			ip[i] = fraction( lookupf );
+
+			s1[i] = _waveform.sampleAt( t, lookup );
+			s2[i] = _waveform.sampleAt( t, ( lookup + 1 ) % tlen );
+			s0[i] = _waveform.sampleAt( t, lookup == 0 ? tlen - 1 : lookup - 1 );
+			s3[i] = _waveform.sampleAt( t, ( lookup + 2 ) % tlen );
+		}
+		interpolateBlock<optimal4pInterpolate>( s0, s1, s2, s3, ip, _out + done, frames );
+	}
+}
+
+
+
+
 void BandLimitedWave::generateWaves()
 {
 // don't generate if they already exist
 	if( s_wavesGenerated ) return;
 
-	int i;
-
 // set wavetable directory
 	s_wavetableDir = "data:wavetables/";
 
+// use the tables cached by an earlier run, or create them and publish them
+// in the cache for the next ones
+	const QString cachePath = waveCachePath();
+	if( !mapWaveCache( cachePath ) )
+	{
+		WaveMipMap * waves = new WaveMipMap[NumBLWaveforms];
+		computeWaves( waves );
+		if( writeWaveCache( cachePath, waves ) && mapWaveCache( cachePath ) )
+		{
+			delete[] waves;
+		}
+		else
+		{
+			s_waveforms = waves;
+		}
+	}
+
+// set the generated flag so we don't load/generate them again needlessly
+	s_wavesGenerated = true;
+}
+
+
+
+
+namespace
+{
+
+void computeWaves( WaveMipMap * waves )
+{
+	const QString & wavetableDir = BandLimitedWave::s_wavetableDir;
+	int i;
+
 // set wavetable files
-	QFile saw_file( s_wavetableDir + "saw.bin" );
-	QFile sqr_file( s_wavetableDir + "sqr.bin" );
-	QFile tri_file( s_wavetableDir + "tri.bin" );
-	QFile moog_file( s_wavetableDir + "moog.bin" );
+	QFile saw_file( wavetableDir + "saw.bin" );
+	QFile sqr_file( wavetableDir + "sqr.bin" );
+	QFile tri_file( wavetableDir + "tri.bin" );
+	QFile moog_file( wavetableDir + "moog.bin" );
 
 // saw wave - BLSaw
 // check for file and use it if exists
@@ -81,7 +286,7 @@ void BandLimitedWave::generateWaves()
 	{
 		saw_file.open( QIODevice::ReadOnly );
 		QDataStream in( &saw_file );
-		in >> s_waveforms[ BandLimitedWave::BLSaw ];
+		in >> waves[ BandLimitedWave::BLSaw ];
 		saw_file.close();
 	}
 	else
@@ -105,14 +310,14 @@ void BandLimitedWave::generateWaves()
 					s += amp * /*a2 **/sin( static_cast<double>( ph * harm ) / static_cast<double>( len ) * F_2PI );
 					harm++;
 				} while( hlen > 2.0 );
-				s_waveforms[ BandLimitedWave::BLSaw ].setSampleAt( i, ph, s );
+				waves[ BandLimitedWave::BLSaw ].setSampleAt( i, ph, s );
 				max = qMax( max, qAbs( s ) );
 			}
 			// normalize
 			for( int ph = 0; ph < len; ph++ )
 			{
-				sample_t s = s_waveforms[ BandLimitedWave::BLSaw ].sampleAt( i, ph ) / max;
-				s_waveforms[ BandLimitedWave::BLSaw ].setSampleAt( i, ph, s );
+				sample_t s = waves[ BandLimitedWave::BLSaw ].sampleAt( i, ph ) / max;
+				waves[ BandLimitedWave::BLSaw ].setSampleAt( i, ph, s );
 			}
 		}
 	}
@@ -123,7 +328,7 @@ void BandLimitedWave::generateWaves()
 	{
 		sqr_file.open( QIODevice::ReadOnly );
 		QDataStream in( &sqr_file );
-		in >> s_waveforms[ BandLimitedWave::BLSquare ];
+		in >> waves[ BandLimitedWave::BLSquare ];
 		sqr_file.close();
 	}
 	else
@@ -147,14 +352,14 @@ void BandLimitedWave::generateWaves()
 					s += amp * /*a2 **/ sin( static_cast<double>( ph * harm ) / static_cast<double>( len ) * F_2PI );
 					harm += 2;
 				} while( hlen > 2.0 );
-				s_waveforms[ BandLimitedWave::BLSquare ].setSampleAt( i, ph, s );
+				waves[ BandLimitedWave::BLSquare ].setSampleAt( i, ph, s );
 				max = qMax( max, qAbs( s ) );
 			}
 			// normalize
 			for( int ph = 0; ph < len; ph++ )
 			{
-				sample_t s = s_waveforms[ BandLimitedWave::BLSquare ].sampleAt( i, ph ) / max;
-				s_waveforms[ BandLimitedWave::BLSquare ].setSampleAt( i, ph, s );
+				sample_t s = waves[ BandLimitedWave::BLSquare ].sampleAt( i, ph ) / max;
+				waves[ BandLimitedWave::BLSquare ].setSampleAt( i, ph, s );
 			}
 		}
 	}
@@ -164,7 +369,7 @@ void BandLimitedWave::generateWaves()
 	{
 		tri_file.open( QIODevice::ReadOnly );
 		QDataStream in( &tri_file );
-		in >> s_waveforms[ BandLimitedWave::BLTriangle ];
+		in >> waves[ BandLimitedWave::BLTriangle ];
 		tri_file.close();
 	}
 	else
@@ -189,14 +394,14 @@ void BandLimitedWave::generateWaves()
 							( ( harm + 1 ) % 4 == 0 ? 0.5 : 0.0 ) ) * F_2PI );
 					harm += 2;
 				} while( hlen > 2.0 );
-				s_waveforms[ BandLimitedWave::BLTriangle ].setSampleAt( i, ph, s );
+				waves[ BandLimitedWave::BLTriangle ].setSampleAt( i, ph, s );
 				max = qMax( max, qAbs( s ) );
 			}
 			// normalize
 			for( int ph = 0; ph < len; ph++ )
 			{
-				sample_t s = s_waveforms[ BandLimitedWave::BLTriangle ].sampleAt( i, ph ) / max;
-				s_waveforms[ BandLimitedWave::BLTriangle ].setSampleAt( i, ph, s );
+				sample_t s = waves[ BandLimitedWave::BLTriangle ].sampleAt( i, ph ) / max;
+				waves[ BandLimitedWave::BLTriangle ].setSampleAt( i, ph, s );
 			}
 		}
 	}
@@ -207,7 +412,7 @@ void BandLimitedWave::generateWaves()
 	{
 		moog_file.open( QIODevice::ReadOnly );
 		QDataStream in( &moog_file );
-		in >> s_waveforms[ BandLimitedWave::BLMoog ];
+		in >> waves[ BandLimitedWave::BLMoog ];
 		moog_file.close();
 	}
 	else
@@ -219,17 +424,13 @@ void BandLimitedWave::generateWaves()
 			for( int ph = 0; ph < len; ph++ )
 			{
 				const int sawph = ( ph + static_cast<int>( len * 0.75 ) ) % len;
-				const sample_t saw = s_waveforms[ BandLimitedWave::BLSaw ].sampleAt( i, sawph );
-				const sample_t tri = s_waveforms[ BandLimitedWave::BLTriangle ].sampleAt( i, ph );
-				s_waveforms[ BandLimitedWave::BLMoog ].setSampleAt( i, ph, ( saw + tri ) * 0.5f );
+				const sample_t saw = waves[ BandLimitedWave::BLSaw ].sampleAt( i, sawph );
+				const sample_t tri = waves[ BandLimitedWave::BLTriangle ].sampleAt( i, ph );
+				waves[ BandLimitedWave::BLMoog ].setSampleAt( i, ph, ( saw + tri ) * 0.5f );
 			}
 		}
 	}
 
-// set the generated flag so we don't load/generate them again needlessly
-	s_wavesGenerated = true;
-
-
 // generate files, serialize mipmaps as QDataStreams and save them on disk
 //
 // normally these are now provided with LMMS as pre-generated so we don't have to do this,
@@ -270,3 +471,5 @@ moogfile.close();
 */
 
 }
+
+} // namespace
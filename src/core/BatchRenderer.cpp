@@ -0,0 +1,225 @@
+/*
+ * BatchRenderer.cpp - renders many projects with one engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "BatchRenderer.h"
+
+#include <cstdio>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTimer>
+
+#include "Engine.h"
+#include "RenderManager.h"
+#include "Song.h"
+
+
+BatchRenderer::BatchRenderer( const Mixer::qualitySettings & qualitySettings,
+				const OutputSettings & outputSettings,
+				ProjectRenderer::ExportFileFormats defaultFormat,
+				bool renderLoop, const QString & jobFile ) :
+	m_qualitySettings( qualitySettings ),
+	m_outputSettings( outputSettings ),
+	m_defaultFormat( defaultFormat ),
+	m_renderLoop( renderLoop ),
+	m_jobCount( 0 ),
+	m_failedCount( 0 )
+{
+	if( jobFile == "-" )
+	{
+		m_jobFile.open( stdin, QIODevice::ReadOnly | QIODevice::Text );
+	}
+	else
+	{
+		m_jobFile.setFileName( jobFile );
+		m_jobFile.open( QIODevice::ReadOnly | QIODevice::Text );
+	}
+	m_jobs.setDevice( &m_jobFile );
+}
+
+
+
+
+BatchRenderer::~BatchRenderer()
+{
+}
+
+
+
+
+void BatchRenderer::start()
+{
+	nextJob();
+}
+
+
+
+
+void BatchRenderer::nextJob()
+{
+	// the finished job is destroyed here, outside of its signal
+	m_activeJob.reset();
+	if( m_jobCount > 0 )
+	{
+		// free the project's resources before reading the next job,
+		// which may take a while to arrive
+		Engine::getSong()->clearProject();
+	}
+
+	QString line;
+	while( m_jobs.readLineInto( &line ) )
+	{
+		if( line.trimmed().isEmpty() || line.startsWith( '#' ) )
+		{
+			continue;
+		}
+		++m_jobCount;
+		if( startJob( line ) )
+		{
+			return;
+		}
+		finishJob( false );
+	}
+
+	printf( "Rendered %d of %d jobs\n", m_jobCount - m_failedCount,
+								m_jobCount );
+	QCoreApplication::exit( m_failedCount > 0 ? EXIT_FAILURE :
+								EXIT_SUCCESS );
+}
+
+
+
+
+bool BatchRenderer::startJob( const QString & line )
+{
+	const QStringList fields = line.split( '\t' );
+	const QString project = fields[0].trimmed();
+	printf( "Job %d: %s\n", m_jobCount, project.toUtf8().constData() );
+
+	QVector<ProjectRenderer::ExportFileFormats> formats;
+	if( fields.size() > 2 && !fields[2].trimmed().isEmpty() )
+	{
+		for( const QString & name : fields[2].split( ',' ) )
+		{
+			const ProjectRenderer::ExportFileFormats format =
+				ProjectRenderer::getFileFormatFromExtension(
+						"." + name.trimmed() );
+			if( ProjectRenderer::getFileExtensionFromFormat( format ) !=
+					"." + name.trimmed() ||
+				!ProjectRenderer::fileEncodeDevices[format].isAvailable() )
+			{
+				printf( "Invalid output format %s\n",
+						name.toUtf8().constData() );
+				return false;
+			}
+			formats.push_back( format );
+		}
+	}
+	else
+	{
+		formats.push_back( m_defaultFormat );
+	}
+
+	if( !QFileInfo( project ).isFile() )
+	{
+		printf( "The project %s doesn't exist\n",
+					project.toUtf8().constData() );
+		return false;
+	}
+
+	m_jobTimer.start();
+	Engine::getSong()->loadProject( project );
+	if( Engine::getSong()->isEmpty() )
+	{
+		printf( "The project %s is empty\n",
+					project.toUtf8().constData() );
+		return false;
+	}
+	Engine::getSong()->setExportLoop( m_renderLoop );
+
+	const QString output = fields.size() > 1 && !fields[1].trimmed().isEmpty()
+				? fields[1].trimmed() : project;
+	const QFileInfo outputInfo( output );
+	const QString base = outputInfo.absolutePath() + "/" +
+					outputInfo.completeBaseName();
+
+	m_activeOutputs.clear();
+	for( ProjectRenderer::ExportFileFormats format : formats )
+	{
+		m_activeOutputs << base +
+			ProjectRenderer::getFileExtensionFromFormat( format );
+	}
+
+	m_activeJob.reset( new RenderManager( m_qualitySettings,
+			m_outputSettings, formats[0], m_activeOutputs[0] ) );
+	for( int i = 1; i < formats.size(); ++i )
+	{
+		m_activeJob->addOutput( m_outputSettings, formats[i],
+							m_activeOutputs[i] );
+	}
+	connect( m_activeJob.get(), SIGNAL( finished() ),
+			this, SLOT( jobFinished() ) );
+	m_activeJob->renderProject();
+	return true;
+}
+
+
+
+
+void BatchRenderer::jobFinished()
+{
+	// the renderer doesn't report failures, so check for the files
+	bool successful = true;
+	for( const QString & output : m_activeOutputs )
+	{
+		if( QFileInfo( output ).size() == 0 )
+		{
+			printf( "Could not write %s\n", output.toUtf8().constData() );
+			successful = false;
+		}
+	}
+	finishJob( successful );
+
+	// may be emitted from within renderProject(), so don't start the
+	// next job before returning
+	QTimer::singleShot( 0, this, SLOT( nextJob() ) );
+}
+
+
+
+
+void BatchRenderer::finishJob( bool successful )
+{
+	if( successful )
+	{
+		printf( "Done in %.1f s: %s\n", m_jobTimer.elapsed() / 1000.0,
+			m_activeOutputs.join( ", " ).toUtf8().constData() );
+	}
+	else
+	{
+		++m_failedCount;
+	}
+	fflush( stdout );
+}
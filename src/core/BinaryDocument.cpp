@@ -0,0 +1,642 @@
+/*
+ * BinaryDocument.cpp - compact binary encoding of XML documents
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "BinaryDocument.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <QDomDocument>
+#include <QHash>
+#include <QStringList>
+
+
+namespace
+{
+
+// The encoding starts with the version, the name of the document type and
+// the table of names, followed by the child nodes of the document. A list
+// of nodes is their number followed by the nodes, each starting with its
+// kind. Numbers are LEB128 varints, signed ones zigzag encoded, floats
+// are little endian.
+const quint64 Version = 1;
+
+enum NodeKind
+{
+	ElementNode,
+	TextNode,
+	CDataNode,
+	CommentNode,
+	ProcessingInstructionNode,
+	// sibling elements stored as columns of attribute values
+	ElementRun
+} ;
+
+enum ValueKind
+{
+	StringValue,
+	IntValue,
+	FloatValue
+} ;
+
+enum ColumnKind
+{
+	MixedColumn,
+	IntColumn,
+	FloatColumn
+} ;
+
+// shorter runs of elements are stored one by one
+const int MinRunLength = 4;
+
+
+//! The kind @p value can be stored as, with the number it stands for
+ValueKind classify(const QString & value, qint64 & integer, float & real)
+{
+	bool ok = false;
+	integer = value.toLongLong(&ok);
+	if (ok && QString::number(integer) == value)
+	{
+		return IntValue;
+	}
+	real = static_cast<float>(value.toDouble(&ok));
+	if (ok && QString::number(real) == value)
+	{
+		return FloatValue;
+	}
+	return StringValue;
+}
+
+
+
+
+class Writer
+{
+public:
+	void byte(quint8 b)
+	{
+		m_data.append(static_cast<char>(b));
+	}
+
+	void varint(quint64 v)
+	{
+		while (v >= 0x80)
+		{
+			byte(static_cast<quint8>(v) | 0x80);
+			v >>= 7;
+		}
+		byte(static_cast<quint8>(v));
+	}
+
+	void zigzag(qint64 v)
+	{
+		varint((static_cast<quint64>(v) << 1) ^ static_cast<quint64>(v >> 63));
+	}
+
+	void real(float f)
+	{
+		quint32 bits;
+		memcpy(&bits, &f, sizeof(bits));
+		for (int i = 0; i < 4; ++i, bits >>= 8)
+		{
+			byte(static_cast<quint8>(bits));
+		}
+	}
+
+	void string(const QString & s)
+	{
+		const QByteArray utf8 = s.toUtf8();
+		varint(utf8.size());
+		m_data.append(utf8);
+	}
+
+	//! Writes the index of @p name in the table
+	void name(const QString & name)
+	{
+		auto it = m_nameIndices.find(name);
+		if (it == m_nameIndices.end())
+		{
+			it = m_nameIndices.insert(name, m_names.size());
+			m_names << name;
+		}
+		varint(*it);
+	}
+
+	void value(const QString & value)
+	{
+		qint64 integer;
+		float f;
+		const ValueKind kind = classify(value, integer, f);
+		byte(kind);
+		switch (kind)
+		{
+		case IntValue: zigzag(integer); break;
+		case FloatValue: real(f); break;
+		default: string(value);
+		}
+	}
+
+	void nodes(const QDomNode & parent);
+
+	QByteArray result(const QString & docType) const
+	{
+		Writer header;
+		header.varint(Version);
+		header.string(docType);
+		header.varint(m_names.size());
+		for (const QString & name : m_names)
+		{
+			header.string(name);
+		}
+		return header.m_data + m_data;
+	}
+
+private:
+	//! The attribute names of @p element in a fixed order
+	static QStringList attributeNames(const QDomElement & element)
+	{
+		const QDomNamedNodeMap attributes = element.attributes();
+		QStringList names;
+		for (int i = 0; i < attributes.count(); ++i)
+		{
+			names << attributes.item(i).nodeName();
+		}
+		names.sort();
+		return names;
+	}
+
+	void element(const QDomElement & element, const QStringList & names)
+	{
+		byte(ElementNode);
+		name(element.tagName());
+		varint(names.size());
+		for (const QString & n : names)
+		{
+			name(n);
+			value(element.attribute(n));
+		}
+		nodes(element);
+	}
+
+	void run(const std::vector<QDomElement> & elements, const QStringList & names)
+	{
+		byte(ElementRun);
+		name(elements.front().tagName());
+		varint(names.size());
+		for (const QString & n : names)
+		{
+			name(n);
+		}
+		varint(elements.size());
+
+		std::vector<QString> values(elements.size());
+		std::vector<qint64> integers(elements.size());
+		std::vector<float> reals(elements.size());
+		for (const QString & n : names)
+		{
+			bool allIntegers = true;
+			bool allReals = true;
+			for (std::size_t i = 0; i < elements.size(); ++i)
+			{
+				values[i] = elements[i].attribute(n);
+				const ValueKind kind = classify(values[i], integers[i], reals[i]);
+				allIntegers = allIntegers && kind == IntValue;
+				// floats which happen to be whole numbers are written
+				// like integers
+				if (kind == IntValue)
+				{
+					reals[i] = static_cast<float>(integers[i]);
+				}
+				allReals = allReals && (kind == FloatValue ||
+					(kind == IntValue && QString::number(reals[i]) == values[i]));
+			}
+			if (allIntegers)
+			{
+				byte(IntColumn);
+				qint64 previous = 0;
+				for (const qint64 v : integers)
+				{
+					// wraps around instead of overflowing
+					zigzag(static_cast<qint64>(static_cast<quint64>(v) - static_cast<quint64>(previous)));
+					previous = v;
+				}
+			}
+			else if (allReals)
+			{
+				byte(FloatColumn);
+				for (const float v : reals) { real(v); }
+			}
+			else
+			{
+				byte(MixedColumn);
+				for (const QString & v : values) { value(v); }
+			}
+		}
+	}
+
+	QByteArray m_data;
+	QStringList m_names;
+	QHash<QString, int> m_nameIndices;
+} ;
+
+
+
+
+void Writer::nodes(const QDomNode & parent)
+{
+	std::vector<QDomNode> children;
+	for (QDomNode n = parent.firstChild(); !n.isNull(); n = n.nextSibling())
+	{
+		children.push_back(n);
+	}
+
+	// split the children into runs and single nodes first, as a run
+	// counts as one node
+	struct Entry
+	{
+		std::size_t first;
+		std::size_t count;
+		QStringList names;
+	} ;
+	std::vector<Entry> entries;
+	for (std::size_t i = 0; i < children.size();)
+	{
+		const QDomElement first = children[i].toElement();
+		Entry entry{i, 1, first.isNull() ? QStringList() : attributeNames(first)};
+		if (!first.isNull() && !first.hasChildNodes())
+		{
+			std::size_t j = i + 1;
+			for (; j < children.size(); ++j)
+			{
+				const QDomElement e = children[j].toElement();
+				if (e.isNull() || e.hasChildNodes() || e.tagName() != first.tagName() ||
+					attributeNames(e) != entry.names)
+				{
+					break;
+				}
+			}
+			if (static_cast<int>(j - i) >= MinRunLength) { entry.count = j - i; }
+		}
+		entries.push_back(entry);
+		i += entry.count;
+	}
+
+	varint(entries.size());
+	for (const Entry & entry : entries)
+	{
+		const QDomNode & node = children[entry.first];
+		if (entry.count > 1)
+		{
+			std::vector<QDomElement> elements;
+			for (std::size_t i = entry.first; i < entry.first + entry.count; ++i)
+			{
+				elements.push_back(children[i].toElement());
+			}
+			run(elements, entry.names);
+		}
+		else if (node.isElement())
+		{
+			element(node.toElement(), entry.names);
+		}
+		else if (node.isCDATASection())
+		{
+			byte(CDataNode);
+			string(node.toCDATASection().data());
+		}
+		else if (node.isText())
+		{
+			byte(TextNode);
+			string(node.toText().data());
+		}
+		else if (node.isComment())
+		{
+			byte(CommentNode);
+			string(node.toComment().data());
+		}
+		else if (node.isProcessingInstruction())
+		{
+			const QDomProcessingInstruction pi = node.toProcessingInstruction();
+			byte(ProcessingInstructionNode);
+			string(pi.target());
+			string(pi.data());
+		}
+		else
+		{
+			// LMMS writes no other nodes, like entity references, to XML.
+			// They're stored as empty comments, which are dropped again.
+			byte(CommentNode);
+			string(QString());
+		}
+	}
+}
+
+
+
+
+class Reader
+{
+public:
+	Reader(const QByteArray & data) :
+		m_pos(reinterpret_cast<const quint8 *>(data.constData())),
+		m_end(m_pos + data.size()),
+		m_failed(false)
+	{
+	}
+
+	bool failed() const
+	{
+		return m_failed;
+	}
+
+	quint8 byte()
+	{
+		if (m_pos == m_end)
+		{
+			m_failed = true;
+			return 0;
+		}
+		return *m_pos++;
+	}
+
+	quint64 varint()
+	{
+		quint64 v = 0;
+		for (int shift = 0; shift < 64 && !m_failed; shift += 7)
+		{
+			const quint8 b = byte();
+			v |= static_cast<quint64>(b & 0x7f) << shift;
+			if (!(b & 0x80))
+			{
+				return v;
+			}
+		}
+		m_failed = true;
+		return 0;
+	}
+
+	//! A count of things each taking at least one byte
+	int count()
+	{
+		const quint64 v = varint();
+		if (v > static_cast<quint64>(m_end - m_pos))
+		{
+			m_failed = true;
+			return 0;
+		}
+		return static_cast<int>(v);
+	}
+
+	qint64 zigzag()
+	{
+		const quint64 v = varint();
+		return static_cast<qint64>(v >> 1) ^ -static_cast<qint64>(v & 1);
+	}
+
+	float real()
+	{
+		quint32 bits = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			bits |= static_cast<quint32>(byte()) << (8 * i);
+		}
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	QString string()
+	{
+		const int size = count();
+		if (m_failed)
+		{
+			return QString();
+		}
+		const QString s = QString::fromUtf8(reinterpret_cast<const char *>(m_pos), size);
+		m_pos += size;
+		return s;
+	}
+
+	const QString & name()
+	{
+		const quint64 i = varint();
+		if (i >= static_cast<quint64>(m_names.size()))
+		{
+			m_failed = true;
+			return m_empty;
+		}
+		return m_names[i];
+	}
+
+	QString value()
+	{
+		switch (byte())
+		{
+		case IntValue: return QString::number(zigzag());
+		case FloatValue: return QString::number(real());
+		case StringValue: return string();
+		}
+		m_failed = true;
+		return QString();
+	}
+
+	bool header(QString & docType)
+	{
+		if (varint() != Version)
+		{
+			return false;
+		}
+		docType = string();
+		const int names = count();
+		for (int i = 0; i < names && !m_failed; ++i)
+		{
+			m_names << string();
+		}
+		return !m_failed;
+	}
+
+	void nodes(QDomDocument & document, QDomNode & parent, int depth);
+
+private:
+	void run(QDomDocument & document, QDomNode & parent);
+
+	const quint8 * m_pos;
+	const quint8 * m_end;
+	bool m_failed;
+	std::vector<QString> m_names;
+	const QString m_empty;
+} ;
+
+
+
+
+void Reader::nodes(QDomDocument & document, QDomNode & parent, int depth)
+{
+	// corrupt files can't make the recursion overflow the stack
+	if (depth > 256)
+	{
+		m_failed = true;
+		return;
+	}
+
+	const int count = this->count();
+	for (int i = 0; i < count && !m_failed; ++i)
+	{
+		switch (byte())
+		{
+		case ElementNode:
+		{
+			QDomElement element = document.createElement(name());
+			const int attributes = this->count();
+			for (int a = 0; a < attributes && !m_failed; ++a)
+			{
+				const QString & n = name();
+				element.setAttribute(n, value());
+			}
+			nodes(document, element, depth + 1);
+			parent.appendChild(element);
+			break;
+		}
+		case ElementRun:
+			run(document, parent);
+			break;
+		case TextNode:
+			parent.appendChild(document.createTextNode(string()));
+			break;
+		case CDataNode:
+			parent.appendChild(document.createCDATASection(string()));
+			break;
+		case CommentNode:
+		{
+			const QString data = string();
+			if (!data.isEmpty())
+			{
+				parent.appendChild(document.createComment(data));
+			}
+			break;
+		}
+		case ProcessingInstructionNode:
+		{
+			const QString target = string();
+			parent.appendChild(document.createProcessingInstruction(target, string()));
+			break;
+		}
+		default:
+			m_failed = true;
+		}
+	}
+}
+
+
+
+
+void Reader::run(QDomDocument & document, QDomNode & parent)
+{
+	const QString tagName = name();
+	const int attributes = count();
+	std::vector<QString> names;
+	for (int a = 0; a < attributes && !m_failed; ++a)
+	{
+		names.push_back(name());
+	}
+	const int elements = count();
+
+	std::vector<QDomElement> run;
+	run.reserve(elements);
+	for (int e = 0; e < elements && !m_failed; ++e)
+	{
+		run.push_back(document.createElement(tagName));
+	}
+
+	for (const QString & n : names)
+	{
+		const quint8 column = byte();
+		qint64 previous = 0;
+		for (int e = 0; e < elements && !m_failed; ++e)
+		{
+			switch (column)
+			{
+			case IntColumn:
+				previous = static_cast<qint64>(static_cast<quint64>(previous) + static_cast<quint64>(zigzag()));
+				run[e].setAttribute(n, QString::number(previous));
+				break;
+			case FloatColumn:
+				run[e].setAttribute(n, QString::number(real()));
+				break;
+			case MixedColumn:
+				run[e].setAttribute(n, value());
+				break;
+			default:
+				m_failed = true;
+			}
+		}
+	}
+
+	for (QDomElement & element : run)
+	{
+		parent.appendChild(element);
+	}
+}
+
+} // namespace
+
+
+
+
+QByteArray BinaryDocument::encode(const QDomDocument & document)
+{
+	Writer writer;
+	writer.nodes(document);
+	return writer.result(document.doctype().name());
+}
+
+
+
+
+bool BinaryDocument::decode(const QByteArray & data, QDomDocument & document)
+{
+	Reader reader(data);
+	QString docType;
+	if (!reader.header(docType))
+	{
+		return false;
+	}
+
+	// the document type can only be set by parsing it
+	document.clear();
+	if (!docType.isEmpty())
+	{
+		if (document.setContent("<!DOCTYPE " + docType + "><x/>"))
+		{
+			document.removeChild(document.documentElement());
+		}
+		else
+		{
+			document.clear();
+		}
+	}
+
+	reader.nodes(document, document, 0);
+	return !reader.failed();
+}
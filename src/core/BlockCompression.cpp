@@ -0,0 +1,292 @@
+/*
+ * BlockCompression.cpp - compression of project files in parallel blocks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtEndian>
+
+
+namespace
+{
+
+// The data starts with the magic and the version, followed by the blocks,
+// each the little endian size of its qCompress() output and the output.
+// A block of size zero ends the data.
+const char Magic[] = "LMMSZBLK";
+const int MagicSize = 8;
+const quint32 Version = 1;
+const int HeaderSize = MagicSize + 4;
+
+// large enough to compress well, small enough to have a block per core
+// for most projects
+const int BlockSize = 1 << 20;
+// a good deal faster than the default of qCompress() at nearly the size
+const int CompressionLevel = 3;
+
+
+class FunctionTask : public QRunnable
+{
+public:
+	FunctionTask(const std::function<void()> & function) :
+		m_function(function)
+	{
+	}
+
+	void run() override
+	{
+		m_function();
+	}
+
+private:
+	std::function<void()> m_function;
+} ;
+
+
+
+
+QThreadPool & compressionPool()
+{
+	// not the global pool, which may be busy reading or decoding files
+	static QThreadPool pool;
+	return pool;
+}
+
+
+
+
+//! Runs @p function for 0 to count - 1 on all cores and waits for it
+void forEachBlock(int count, const std::function<void(int)> & function)
+{
+	QSemaphore done;
+	for (int i = 0; i < count; ++i)
+	{
+		compressionPool().start(new FunctionTask([&function, &done, i]()
+		{
+			function(i);
+			done.release();
+		}));
+	}
+	done.acquire(count);
+}
+
+
+
+
+void appendSize(QByteArray & data, quint32 size)
+{
+	const quint32 le = qToLittleEndian(size);
+	data.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+
+
+
+quint32 readSize(const char * data)
+{
+	quint32 size;
+	memcpy(&size, data, sizeof(size));
+	return qFromLittleEndian(size);
+}
+
+} // namespace
+
+
+
+
+QByteArray BlockCompression::compress(const QByteArray & data)
+{
+	const int count = (data.size() + BlockSize - 1) / BlockSize;
+	std::vector<QByteArray> blocks(count);
+	forEachBlock(count, [&data, &blocks](int i)
+	{
+		const int size = std::min(BlockSize, data.size() - i * BlockSize);
+		blocks[i] = qCompress(reinterpret_cast<const uchar *>(data.constData()) +
+						i * BlockSize, size, CompressionLevel);
+	});
+
+	QByteArray compressed(Magic, MagicSize);
+	appendSize(compressed, Version);
+	for (const QByteArray & block : blocks)
+	{
+		appendSize(compressed, block.size());
+		compressed += block;
+	}
+	appendSize(compressed, 0);
+	return compressed;
+}
+
+
+
+
+QByteArray BlockCompression::uncompress(const QByteArray & data)
+{
+	if (!isCompressed(data))
+	{
+		return qUncompress(data);
+	}
+
+	// find the blocks first to uncompress them all at once
+	std::vector<QByteArray> blocks;
+	for (int offset = HeaderSize; ; )
+	{
+		if (offset + 4 > data.size()) { return QByteArray(); }
+		const quint32 size = readSize(data.constData() + offset);
+		offset += 4;
+		if (size == 0) { break; }
+		if (size > static_cast<quint32>(data.size() - offset)) { return QByteArray(); }
+		blocks.push_back(QByteArray::fromRawData(data.constData() + offset, size));
+		offset += size;
+	}
+
+	forEachBlock(blocks.size(), [&blocks](int i)
+	{
+		blocks[i] = qUncompress(blocks[i]);
+	});
+
+	QByteArray uncompressed;
+	for (const QByteArray & block : blocks)
+	{
+		if (block.isEmpty()) { return QByteArray(); }
+		uncompressed += block;
+	}
+	return uncompressed;
+}
+
+
+
+
+bool BlockCompression::isCompressed(const QByteArray & data)
+{
+	return data.size() >= HeaderSize && data.startsWith(QByteArray(Magic, MagicSize)) &&
+		readSize(data.constData() + MagicSize) == Version;
+}
+
+
+
+
+BlockCompression::Reader::Reader(QIODevice * source) :
+	m_source(source),
+	m_position(0),
+	m_finished(true)
+{
+}
+
+
+
+
+bool BlockCompression::Reader::open(OpenMode mode)
+{
+	if (mode != ReadOnly || !isCompressed(m_source->read(HeaderSize)))
+	{
+		setErrorString("Not a block compressed file");
+		return false;
+	}
+	m_block.clear();
+	m_position = 0;
+	m_finished = false;
+	return QIODevice::open(mode);
+}
+
+
+
+
+void BlockCompression::Reader::close()
+{
+	m_block.clear();
+	m_position = 0;
+	m_finished = true;
+	QIODevice::close();
+}
+
+
+
+
+qint64 BlockCompression::Reader::bytesAvailable() const
+{
+	return m_block.size() - m_position + QIODevice::bytesAvailable();
+}
+
+
+
+
+bool BlockCompression::Reader::atEnd() const
+{
+	return m_finished && m_position == m_block.size() &&
+					QIODevice::bytesAvailable() == 0;
+}
+
+
+
+
+qint64 BlockCompression::Reader::readData(char * data, qint64 maxSize)
+{
+	qint64 read = 0;
+	while (read < maxSize)
+	{
+		if (m_position == m_block.size() && (m_finished || !readBlock()))
+		{
+			break;
+		}
+		const qint64 count = std::min<qint64>(maxSize - read, m_block.size() - m_position);
+		memcpy(data + read, m_block.constData() + m_position, count);
+		m_position += count;
+		read += count;
+	}
+	return read > 0 || !m_finished ? read : -1;
+}
+
+
+
+
+bool BlockCompression::Reader::readBlock()
+{
+	// errors end the data, so the reader sees it as truncated
+	m_block.clear();
+	m_position = 0;
+	m_finished = true;
+
+	const QByteArray size = m_source->read(4);
+	if (size.size() != 4)
+	{
+		return false;
+	}
+	const quint32 blockSize = readSize(size.constData());
+	if (blockSize == 0)
+	{
+		return false;
+	}
+
+	m_block = qUncompress(m_source->read(blockSize));
+	m_finished = m_block.isEmpty();
+	return !m_finished;
+}
@@ -26,23 +26,115 @@
 
 #include "BufferManager.h"
 
-#include "Engine.h"
+#include <cstdio>
+#include <cstring>
+
+#include "IndexedPool.h"
 #include "Mixer.h"
-#include "MemoryManager.h"
+#include "MixerWorkerThread.h"
+#include "PlanarBuffer.h"
+#include "RealtimeMemory.h"
+
+
+namespace
+{
+
+//! enough for the widest vectors the mix helpers use
+const std::size_t BufferAlignment = 64;
+
+struct BufferMemory
+{
+	static void * allocate( std::size_t bytes )
+	{
+		return RealtimeMemory::allocate( bytes );
+	}
+
+	static void release( void * ptr, std::size_t bytes )
+	{
+		RealtimeMemory::release( ptr, bytes );
+	}
+
+	// blocks of the locked pool are aligned already, padding them would
+	// double the chunk as the pool rounds up to powers of two
+	static bool aligns( std::size_t alignment )
+	{
+		return RealtimeMemory::enabled() &&
+				alignment <= RealtimeMemory::Alignment;
+	}
+} ;
+
+typedef IndexedPool<128, 16, BufferMemory> BufferPool;
+
+fpp_t s_framesPerPeriod = 0;
+BufferPool s_pool( "BufferManager", 0, BufferAlignment );
+thread_local BufferPool::ThreadCache t_bufferCache( s_pool );
+
+
+//! Allocating would risk a dropout on these threads
+inline bool isAudioThread()
+{
+	return Mixer::isRenderingThread() || MixerWorkerThread::isWorkerThread();
+}
+
+} // namespace
+
+
 
-static fpp_t framesPerPeriod;
 
 void BufferManager::init( fpp_t framesPerPeriod )
 {
-	::framesPerPeriod = framesPerPeriod;
+	// the buffers of the pool can't change their size
+	Q_ASSERT( capacity() == 0 || framesPerPeriod == s_framesPerPeriod );
+
+	if( capacity() == 0 )
+	{
+		s_framesPerPeriod = framesPerPeriod;
+		s_pool.setElementBytes( framesPerPeriod * sizeof( sampleFrame ) );
+	}
+	reserve( DEFAULT_BUFFER_POOL_SIZE );
 }
 
 
+
+
+void BufferManager::reserve( int buffers )
+{
+	while( capacity() < buffers )
+	{
+		s_pool.grow();
+	}
+	s_pool.growIfRequested();
+}
+
+
+
+
 sampleFrame * BufferManager::acquire()
 {
-	return MM_ALLOC( sampleFrame, ::framesPerPeriod );
+	const bool audioThread = isAudioThread();
+	if( !audioThread )
+	{
+		s_pool.growIfRequested();
+	}
+	void * buf = s_pool.acquire( t_bufferCache );
+	if( buf == nullptr )
+	{
+		if( audioThread )
+		{
+			buf = s_pool.acquireOverflow();
+		}
+		else
+		{
+			s_pool.grow();
+			buf = s_pool.acquire( t_bufferCache );
+		}
+	}
+	return static_cast<sampleFrame *>( buf );
 }
 
+
+
+
 void BufferManager::clear( sampleFrame *ab, const f_cnt_t frames, const f_cnt_t offset )
 {
 	memset( ab + offset, 0, sizeof( *ab ) * frames );
@@ -57,8 +149,75 @@ void BufferManager::clear( surroundSampleFrame * ab, const f_cnt_t frames,
 #endif
 
 
+
+
 void BufferManager::release( sampleFrame * buf )
 {
-	MM_FREE( buf );
+	if( buf != nullptr )
+	{
+		s_pool.release( t_bufferCache, buf );
+	}
+}
+
+
+
+
+PlanarBuffer * BufferManager::acquirePlanar()
+{
+	return new PlanarBuffer( s_framesPerPeriod );
+}
+
+
+
+
+void BufferManager::release( PlanarBuffer * buf )
+{
+	delete buf;
+}
+
+
+
+
+int BufferManager::capacity()
+{
+	return s_pool.capacity();
+}
+
+
+
+
+int BufferManager::inUse()
+{
+	return s_pool.inUse();
 }
 
+
+
+
+int BufferManager::highWaterMark()
+{
+	return s_pool.highWaterMark();
+}
+
+
+
+
+int BufferManager::overflows()
+{
+	return s_pool.overflows();
+}
+
+
+
+
+void BufferManager::reportUsage()
+{
+#ifdef LMMS_DEBUG
+	if( inUse() > 0 )
+	{
+		fprintf( stderr, "BufferManager: %d buffers were not released\n", inUse() );
+	}
+	fprintf( stderr, "BufferManager: at most %d buffers in use, %d in the pool, "
+			"%d overflows\n", highWaterMark(), capacity(), overflows() );
+#endif
+}
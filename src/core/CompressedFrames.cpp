@@ -0,0 +1,534 @@
+/*
+ * CompressedFrames.cpp - losslessly compressed sample frames
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "CompressedFrames.h"
+
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+
+namespace
+{
+
+// deflating the byte planes further hardly saves more, but takes longer
+const int CompressionLevel = 3;
+// don't keep the compressed blocks if they save less than this
+const double MaxCompressedRatio = 0.9;
+
+} // namespace
+
+
+const f_cnt_t CompressedFrames::BlockFrames;
+const int CompressedFrames::CacheBlocks;
+
+std::atomic<qint64> CompressedFrames::s_frameBytes(0);
+std::atomic<qint64> CompressedFrames::s_compressedBytes(0);
+std::atomic<qint64> CompressedFrames::s_cacheBytes(0);
+std::atomic<int> CompressedFrames::s_samples(0);
+
+
+
+
+class CompressedFramesLoader : public QThread
+{
+public:
+	static CompressedFramesLoader & inst()
+	{
+		// never deleted, so the running thread isn't destroyed at exit
+		static CompressedFramesLoader * s_loader = new CompressedFramesLoader;
+		return *s_loader;
+	}
+
+	void add(CompressedFrames * frames)
+	{
+		QMutexLocker lock(&m_mutex);
+		m_frames.push_back(frames);
+		if (!isRunning())
+		{
+			start();
+		}
+	}
+
+	void remove(CompressedFrames * frames)
+	{
+		// once we have the lock, the instance isn't worked on
+		QMutexLocker lock(&m_mutex);
+		m_frames.erase(std::remove(m_frames.begin(), m_frames.end(), frames),
+			m_frames.end());
+	}
+
+
+private:
+	void run() override
+	{
+		while (true)
+		{
+			bool busy = false;
+			m_mutex.lock();
+			for (CompressedFrames * frames : m_frames)
+			{
+				busy = frames->fill() || busy;
+			}
+			m_mutex.unlock();
+
+			if (!busy)
+			{
+				msleep(5);
+			}
+		}
+	}
+
+	QMutex m_mutex;
+	std::vector<CompressedFrames *> m_frames;
+
+} ;
+
+
+
+
+CompressedFrames::Blocks::Blocks(f_cnt_t frames) :
+	frames(frames),
+	bytes(0)
+{
+}
+
+
+
+
+CompressedFrames::Blocks::~Blocks()
+{
+	s_frameBytes.fetch_sub(static_cast<qint64>(frames) * sizeof(sampleFrame));
+	s_compressedBytes.fetch_sub(bytes);
+	s_samples.fetch_sub(1);
+}
+
+
+
+
+CompressedFrames::CompressedFrames(const std::shared_ptr<const Blocks> & blocks,
+	f_cnt_t head) :
+	m_blocks(blocks),
+	m_frames(blocks->frames),
+	m_slots(new Slot[CacheBlocks]),
+	m_head(head),
+	m_clock(0)
+{
+	for (int i = 0; i < CacheBlocks; ++i)
+	{
+		m_slots[i].index.store(-1, std::memory_order_relaxed);
+		m_slots[i].lastUse.store(0, std::memory_order_relaxed);
+	}
+	for (int i = 0; i < NumRequests; ++i)
+	{
+		m_requests[i].store(-1, std::memory_order_relaxed);
+	}
+
+	// notes can start right away
+	fill();
+	CompressedFramesLoader::inst().add(this);
+}
+
+
+
+
+CompressedFrames * CompressedFrames::compress(const sampleFrame * data,
+	f_cnt_t frames, f_cnt_t head)
+{
+	if (data == nullptr || frames <= 0)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<Blocks> blocks = std::make_shared<Blocks>(frames);
+	blocks->data.reserve((frames + BlockFrames - 1) / BlockFrames);
+	for (f_cnt_t first = 0; first < frames; first += BlockFrames)
+	{
+		blocks->data.push_back(compressBlock(data + first,
+			std::min(BlockFrames, frames - first)));
+		blocks->bytes += blocks->data.back().size();
+	}
+
+	const qint64 frameBytes = static_cast<qint64>(frames) * sizeof(sampleFrame);
+	s_frameBytes.fetch_add(frameBytes);
+	s_compressedBytes.fetch_add(blocks->bytes);
+	s_samples.fetch_add(1);
+	// the decompressed blocks count as well
+	const qint64 cacheBytes = std::min<qint64>(blocks->data.size(), CacheBlocks) *
+		BlockFrames * sizeof(sampleFrame);
+	if (blocks->bytes + cacheBytes > frameBytes * MaxCompressedRatio)
+	{
+		return nullptr;
+	}
+
+	return new CompressedFrames(blocks, head);
+}
+
+
+
+
+CompressedFrames * CompressedFrames::clone() const
+{
+	return new CompressedFrames(m_blocks, m_head.load(std::memory_order_relaxed));
+}
+
+
+
+
+CompressedFrames::~CompressedFrames()
+{
+	CompressedFramesLoader::inst().remove(this);
+	for (int i = 0; i < CacheBlocks; ++i)
+	{
+		if (m_slots[i].data != nullptr)
+		{
+			s_cacheBytes.fetch_sub(BlockFrames * sizeof(sampleFrame));
+		}
+	}
+}
+
+
+
+
+bool CompressedFrames::read(f_cnt_t first, f_cnt_t count, sampleFrame * dst, bool wait)
+{
+	const unsigned int now = m_clock.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	bool complete = true;
+	f_cnt_t done = 0;
+	while (done < count)
+	{
+		const f_cnt_t frame = first + done;
+		if (frame < 0 || frame >= m_frames)
+		{
+			const f_cnt_t todo = frame < 0 ? std::min(count - done, -frame) : count - done;
+			memset(dst + done, 0, todo * sizeof(sampleFrame));
+			done += todo;
+			continue;
+		}
+
+		const f_cnt_t index = frame / BlockFrames;
+		const f_cnt_t inBlock = frame - index * BlockFrames;
+		const f_cnt_t todo = std::min(count - done,
+			std::min(BlockFrames - inBlock, m_frames - frame));
+		bool valid = readCached(index, inBlock, todo, dst + done, now);
+		if (!valid && wait)
+		{
+			// the loader can't replace the block while we hold the lock
+			QMutexLocker lock(&m_mutex);
+			const f_cnt_t head = std::max<f_cnt_t>(0, std::min(
+				m_head.load(std::memory_order_relaxed), m_frames - 1)) / BlockFrames;
+			if (isCached(index) || load(index, head))
+			{
+				valid = readCached(index, inBlock, todo, dst + done, now);
+			}
+		}
+		if (!valid)
+		{
+			memset(dst + done, 0, todo * sizeof(sampleFrame));
+			request(index);
+			complete = false;
+		}
+		done += todo;
+	}
+
+	// the next blocks are read soon
+	prefetch(first + count);
+	prefetch(first + count + BlockFrames);
+	return complete;
+}
+
+
+
+
+void CompressedFrames::decode(f_cnt_t first, f_cnt_t count, sampleFrame * dst) const
+{
+	std::unique_ptr<sampleFrame[]> block;
+	f_cnt_t done = 0;
+	while (done < count)
+	{
+		const f_cnt_t frame = first + done;
+		if (frame < 0 || frame >= m_frames)
+		{
+			const f_cnt_t todo = frame < 0 ? std::min(count - done, -frame) : count - done;
+			memset(dst + done, 0, todo * sizeof(sampleFrame));
+			done += todo;
+			continue;
+		}
+
+		const f_cnt_t index = frame / BlockFrames;
+		const f_cnt_t inBlock = frame - index * BlockFrames;
+		const f_cnt_t blockFrames = std::min(BlockFrames, m_frames - index * BlockFrames);
+		const f_cnt_t todo = std::min(count - done, blockFrames - inBlock);
+		if (inBlock == 0 && todo == blockFrames)
+		{
+			decompressBlock(m_blocks->data[index], blockFrames, dst + done);
+		}
+		else
+		{
+			if (block == nullptr)
+			{
+				block.reset(new sampleFrame[BlockFrames]);
+			}
+			decompressBlock(m_blocks->data[index], blockFrames, block.get());
+			memcpy(dst + done, block.get() + inBlock, todo * sizeof(sampleFrame));
+		}
+		done += todo;
+	}
+}
+
+
+
+
+void CompressedFrames::prefetch(f_cnt_t frame)
+{
+	if (frame >= 0 && frame < m_frames)
+	{
+		request(frame / BlockFrames);
+	}
+}
+
+
+
+
+CompressedFrames::Usage CompressedFrames::usage()
+{
+	Usage usage;
+	usage.frameBytes = s_frameBytes.load(std::memory_order_relaxed);
+	usage.compressedBytes = s_compressedBytes.load(std::memory_order_relaxed);
+	usage.cacheBytes = s_cacheBytes.load(std::memory_order_relaxed);
+	usage.samples = s_samples.load(std::memory_order_relaxed);
+	return usage;
+}
+
+
+
+
+qint64 CompressedFrames::memoryUsage() const
+{
+	qint64 bytes = m_blocks->bytes / std::max<long>(m_blocks.use_count(), 1);
+	for (int i = 0; i < CacheBlocks; ++i)
+	{
+		if (m_slots[i].index.load(std::memory_order_relaxed) >= 0)
+		{
+			bytes += BlockFrames * sizeof(sampleFrame);
+		}
+	}
+	return bytes;
+}
+
+
+
+
+QByteArray CompressedFrames::compressBlock(const sampleFrame * data, f_cnt_t frames)
+{
+	const int values = frames * DEFAULT_CHANNELS;
+	QByteArray planes(values * sizeof(uint32_t), Qt::Uninitialized);
+	uchar * out = reinterpret_cast<uchar *>(planes.data());
+
+	uint32_t previous[DEFAULT_CHANNELS] = { };
+	for (f_cnt_t f = 0; f < frames; ++f)
+	{
+		for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			uint32_t bits;
+			memcpy(&bits, &data[f][ch], sizeof(bits));
+			const uint32_t delta = bits - previous[ch];
+			previous[ch] = bits;
+
+			const int i = f * DEFAULT_CHANNELS + ch;
+			for (int b = 0; b < 4; ++b)
+			{
+				out[b * values + i] = static_cast<uchar>(delta >> (8 * b));
+			}
+		}
+	}
+	return qCompress(planes, CompressionLevel);
+}
+
+
+
+
+void CompressedFrames::decompressBlock(const QByteArray & block, f_cnt_t frames,
+	sampleFrame * dst)
+{
+	const int values = frames * DEFAULT_CHANNELS;
+	const QByteArray planes = qUncompress(block);
+	if (planes.size() != values * static_cast<int>(sizeof(uint32_t)))
+	{
+		memset(dst, 0, frames * sizeof(sampleFrame));
+		return;
+	}
+	const uchar * in = reinterpret_cast<const uchar *>(planes.constData());
+
+	uint32_t previous[DEFAULT_CHANNELS] = { };
+	for (f_cnt_t f = 0; f < frames; ++f)
+	{
+		for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			const int i = f * DEFAULT_CHANNELS + ch;
+			uint32_t delta = 0;
+			for (int b = 0; b < 4; ++b)
+			{
+				delta |= static_cast<uint32_t>(in[b * values + i]) << (8 * b);
+			}
+			previous[ch] += delta;
+			memcpy(&dst[f][ch], &previous[ch], sizeof(previous[ch]));
+		}
+	}
+}
+
+
+
+
+bool CompressedFrames::isCached(f_cnt_t index) const
+{
+	for (int i = 0; i < CacheBlocks; ++i)
+	{
+		if (m_slots[i].index.load(std::memory_order_relaxed) == index)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+bool CompressedFrames::readCached(f_cnt_t index, f_cnt_t inBlock, f_cnt_t count,
+	sampleFrame * dst, unsigned int now)
+{
+	for (int i = 0; i < CacheBlocks; ++i)
+	{
+		Slot & slot = m_slots[i];
+		if (slot.index.load(std::memory_order_acquire) != index)
+		{
+			continue;
+		}
+		memcpy(dst, slot.data.get() + inBlock, count * sizeof(sampleFrame));
+		// the loader may have started replacing the block meanwhile
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.index.load(std::memory_order_relaxed) == index)
+		{
+			slot.lastUse.store(now, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+bool CompressedFrames::fill()
+{
+	QMutexLocker lock(&m_mutex);
+	const f_cnt_t blocks = numBlocks();
+	const f_cnt_t head = std::max<f_cnt_t>(0, std::min(
+		m_head.load(std::memory_order_relaxed), m_frames - 1)) / BlockFrames;
+
+	std::vector<f_cnt_t> wanted;
+	for (f_cnt_t index = head; index < head + HeadBlocks && index < blocks; ++index)
+	{
+		wanted.push_back(index);
+	}
+	for (int i = 0; i < NumRequests; ++i)
+	{
+		const f_cnt_t index = m_requests[i].exchange(-1, std::memory_order_relaxed);
+		if (index >= 0 && index < blocks)
+		{
+			wanted.push_back(index);
+		}
+	}
+
+	bool busy = false;
+	for (const f_cnt_t index : wanted)
+	{
+		if (!isCached(index))
+		{
+			busy = load(index, head) || busy;
+		}
+	}
+	return busy;
+}
+
+
+
+
+bool CompressedFrames::load(f_cnt_t index, f_cnt_t head)
+{
+	// replace the block which was read longest ago, but not the ones notes
+	// start with
+	Slot * victim = nullptr;
+	for (int i = 0; i < CacheBlocks; ++i)
+	{
+		Slot & slot = m_slots[i];
+		const f_cnt_t cached = slot.index.load(std::memory_order_relaxed);
+		if (cached < 0)
+		{
+			victim = &slot;
+			break;
+		}
+		if (cached >= head && cached < head + HeadBlocks)
+		{
+			continue;
+		}
+		if (victim == nullptr || static_cast<int>(slot.lastUse.load(std::memory_order_relaxed) -
+				victim->lastUse.load(std::memory_order_relaxed)) < 0)
+		{
+			victim = &slot;
+		}
+	}
+	if (victim == nullptr)
+	{
+		return false;
+	}
+	loadSlot(*victim, index);
+	return true;
+}
+
+
+
+
+void CompressedFrames::loadSlot(Slot & slot, f_cnt_t index)
+{
+	slot.index.store(-1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (slot.data == nullptr)
+	{
+		slot.data.reset(new sampleFrame[BlockFrames]);
+		s_cacheBytes.fetch_add(BlockFrames * sizeof(sampleFrame));
+	}
+	const f_cnt_t first = index * BlockFrames;
+	decompressBlock(m_blocks->data[index], std::min(BlockFrames, m_frames - first),
+		slot.data.get());
+
+	// it's about to be read, so it isn't replaced right away
+	slot.lastUse.store(m_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	slot.index.store(index, std::memory_order_release);
+}
@@ -32,17 +32,13 @@
 #include "Song.h"
 #include "Mixer.h"
 #include "ControllerConnection.h"
+#include "ControllerGraph.h"
 #include "ControllerDialog.h"
 #include "LfoController.h"
 #include "MidiController.h"
 #include "PeakController.h"
 
 
-long Controller::s_periods = 0;
-QVector<Controller *> Controller::s_controllers;
-
-
-
 Controller::Controller( ControllerTypes _type, Model * _parent,
 					const QString & _display_name ) :
 	Model( _parent, _display_name ),
@@ -50,20 +46,25 @@ Controller::Controller( ControllerTypes _type, Model * _parent,
 	m_valueBuffer( Engine::mixer()->framesPerPeriod() ),
 	m_bufferLastUpdated( -1 ),
 	m_connectionCount( 0 ),
-	m_type( _type )
+	m_type( _type ),
+	m_graph( nullptr )
 {
+	// resized to the current period before updating, within this capacity
+	m_valueBuffer.reserve( Mixer::maxFramesPerPeriod() );
+
 	if( _type != DummyController && _type != MidiController )
 	{
-		s_controllers.append( this );
+		m_graph = Engine::controllerGraph();
+		m_graph->addController( this );
 		// Determine which name to use
-		for ( uint i=s_controllers.size(); ; i++ )
+		for ( uint i=m_graph->controllers().size(); ; i++ )
 		{
 			QString new_name = QString( tr( "Controller %1" ) )
 					.arg( i );
 
 			// Check if name is already in use
 			bool name_used = false;
-			for (Controller * controller : s_controllers)
+			for (Controller * controller : m_graph->controllers())
 			{
 				if ( controller->name() == new_name )
 				{
@@ -85,10 +86,9 @@ Controller::Controller( ControllerTypes _type, Model * _parent,
 
 Controller::~Controller()
 {
-	int idx = s_controllers.indexOf( this );
-	if( idx >= 0 )
+	if( m_graph )
 	{
-		s_controllers.remove( idx );
+		m_graph->removeController( this );
 	}
 
 	m_valueBuffer.clear();
@@ -112,8 +112,9 @@ float Controller::currentValue( int _offset )
 
 float Controller::value( int offset )
 {
-	if( m_bufferLastUpdated != s_periods )
+	if( m_bufferLastUpdated != runningPeriods() )
 	{
+		m_valueBuffer.resize( Engine::mixer()->framesPerPeriod() );
 		updateValueBuffer();
 	}
 	return m_valueBuffer.values()[ offset ];
@@ -122,8 +123,9 @@ float Controller::value( int offset )
 
 ValueBuffer * Controller::valueBuffer()
 {
-	if( m_bufferLastUpdated != s_periods )
+	if( m_bufferLastUpdated != runningPeriods() )
 	{
+		m_valueBuffer.resize( Engine::mixer()->framesPerPeriod() );
 		updateValueBuffer();
 	}
 	return &m_valueBuffer;
@@ -133,14 +135,21 @@ ValueBuffer * Controller::valueBuffer()
 void Controller::updateValueBuffer()
 {
 	m_valueBuffer.fill(0.5f);
-	m_bufferLastUpdated = s_periods;
+	m_bufferLastUpdated = runningPeriods();
 }
 
 
+long Controller::runningPeriods()
+{
+	return Engine::controllerGraph()->periods();
+}
+
+
+
 // Get position in frames
 unsigned int Controller::runningFrames()
 {
-	return s_periods * Engine::mixer()->framesPerPeriod();
+	return Engine::controllerGraph()->frames();
 }
 
 
@@ -155,7 +164,8 @@ float Controller::runningTime()
 
 void Controller::triggerFrameCounter()
 {
-	for (Controller * controller : s_controllers)
+	ControllerGraph * graph = Engine::controllerGraph();
+	for (Controller * controller : graph->controllers())
 	{
 		// This signal is for updating values for both stubborn knobs and for
 		// painting.  If we ever get all the widgets to use or at least check
@@ -164,7 +174,7 @@ void Controller::triggerFrameCounter()
 		emit controller->valueChanged();
 	}
 
-	s_periods ++;
+	graph->advance( Engine::mixer()->framesPerPeriod() );
 	//emit s_signaler.triggerValueChanged();
 }
 
@@ -172,11 +182,12 @@ void Controller::triggerFrameCounter()
 
 void Controller::resetFrameCounter()
 {
-	for (Controller * controller : s_controllers)
+	ControllerGraph * graph = Engine::controllerGraph();
+	for (Controller * controller : graph->controllers())
 	{
 		controller->m_bufferLastUpdated = 0;
 	}
-	s_periods = 0;
+	graph->resetCounters();
 }
 
 
@@ -306,6 +317,7 @@ ControllerDialog * Controller::createDialog( QWidget * _parent )
 void Controller::addConnection( ControllerConnection * )
 {
 	m_connectionCount++;
+	Engine::controllerGraph()->invalidate();
 }
 
 
@@ -315,6 +327,7 @@ void Controller::removeConnection( ControllerConnection * )
 {
 	m_connectionCount--;
 	Q_ASSERT( m_connectionCount >= 0 );
+	Engine::controllerGraph()->invalidate();
 }
 
 
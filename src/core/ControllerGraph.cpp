@@ -0,0 +1,183 @@
+/*
+ * ControllerGraph.cpp - evaluates all controllers once per period
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ControllerGraph.h"
+
+#include <functional>
+
+#include <QtCore/QHash>
+
+#include "AutomatableModel.h"
+#include "Controller.h"
+#include "ControllerConnection.h"
+#include "MixerWorkerThread.h"
+#include "ThreadableJob.h"
+
+
+class ControllerGraph::Job : public ThreadableJob
+{
+public:
+	Job( Controller * controller ) :
+		m_controller( controller )
+	{
+	}
+
+	bool requiresProcessing() const override
+	{
+		return true;
+	}
+
+	Controller * controller() const
+	{
+		return m_controller;
+	}
+
+protected:
+	void doProcessing() override
+	{
+		m_controller->valueBuffer();
+	}
+
+private:
+	Controller * m_controller;
+
+} ;
+
+
+ControllerGraph::ControllerGraph() :
+	m_periods( 0 ),
+	m_frames( 0 ),
+	m_revision( 1 ),
+	m_builtRevision( 0 )
+{
+}
+
+
+
+
+// the jobs are only complete here
+ControllerGraph::~ControllerGraph() = default;
+
+
+
+
+void ControllerGraph::addController( Controller * controller )
+{
+	m_controllers.append( controller );
+	invalidate();
+}
+
+
+
+
+void ControllerGraph::removeController( Controller * controller )
+{
+	const int index = m_controllers.indexOf( controller );
+	if( index >= 0 )
+	{
+		m_controllers.remove( index );
+		invalidate();
+	}
+}
+
+
+
+
+void ControllerGraph::update()
+{
+	if( m_builtRevision != m_revision )
+	{
+		build();
+	}
+
+	for( auto & level : m_levels )
+	{
+		if( level.size() < ParallelLevelSize )
+		{
+			for( auto & job : level )
+			{
+				job->controller()->valueBuffer();
+			}
+			continue;
+		}
+
+		MixerWorkerThread::resetJobQueue();
+		for( auto & job : level )
+		{
+			job->reset();
+			MixerWorkerThread::addJob( job.get() );
+		}
+		MixerWorkerThread::startAndWaitForJobs();
+	}
+}
+
+
+
+
+void ControllerGraph::build()
+{
+	m_builtRevision = m_revision;
+	m_levels.clear();
+
+	// the level of a controller is one more than the highest level of the
+	// controllers connected to its models
+	QHash<Controller *, int> levels;
+	std::function<int( Controller * )> levelOf;
+	levelOf = [this, &levels, &levelOf]( Controller * controller )
+	{
+		auto it = levels.find( controller );
+		if( it != levels.end() )
+		{
+			return *it;
+		}
+		// hasModel() prevents cycles, but stay safe while visiting
+		levels.insert( controller, 0 );
+
+		int level = 0;
+		for( QObject * child : controller->children() )
+		{
+			AutomatableModel * model = qobject_cast<AutomatableModel *>( child );
+			ControllerConnection * connection =
+				model ? model->controllerConnection() : nullptr;
+			if( connection && m_controllers.contains(
+						connection->getController() ) )
+			{
+				level = qMax( level,
+					levelOf( connection->getController() ) + 1 );
+			}
+		}
+		levels.insert( controller, level );
+		return level;
+	};
+
+	for( Controller * controller : m_controllers )
+	{
+		const size_t level = levelOf( controller );
+		if( m_levels.size() <= level )
+		{
+			m_levels.resize( level + 1 );
+		}
+		m_levels[level].emplace_back( new Job( controller ) );
+	}
+}
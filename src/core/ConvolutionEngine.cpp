@@ -0,0 +1,289 @@
+/*
+ * ConvolutionEngine.cpp - convolution with long impulse responses
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolutionEngine.h"
+
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <initializer_list>
+
+
+const fpp_t ConvolutionEngine::HeadBlockSize;
+const fpp_t ConvolutionEngine::TailBlockSize;
+
+
+
+
+class ConvolutionEngine::TailThread : public QThread
+{
+public:
+	TailThread(ConvolutionEngine * engine) :
+		m_engine(engine)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		while (true)
+		{
+			m_engine->m_tailStart.acquire();
+			if (m_engine->m_quit.load(std::memory_order_acquire))
+			{
+				break;
+			}
+			m_engine->processTail();
+			m_engine->m_tailDone.release();
+		}
+	}
+
+private:
+	ConvolutionEngine * m_engine;
+} ;
+
+
+
+
+ConvolutionEngine::ConvolutionEngine(const sampleFrame * ir, f_cnt_t frames) :
+	m_length(frames),
+	m_hasTail0(frames > TailBlockSize),
+	m_hasTail(frames > 2 * TailBlockSize),
+	m_tailInputFill(0),
+	m_thread(nullptr),
+	m_tailRunning(false),
+	m_quit(false)
+{
+	std::vector<float> channel(frames);
+	for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		for (f_cnt_t f = 0; f < frames; ++f)
+		{
+			channel[f] = ir[f][ch];
+		}
+
+		Channel & c = m_channels[ch];
+		c.head.init(HeadBlockSize, channel.data(), qMin<f_cnt_t>(frames, TailBlockSize));
+		if (m_hasTail0)
+		{
+			c.tail0.init(HeadBlockSize, channel.data() + TailBlockSize,
+				qMin<f_cnt_t>(frames - TailBlockSize, TailBlockSize));
+			c.tail0Output.assign(TailBlockSize, 0.0f);
+			c.tail0Precalculated.assign(TailBlockSize, 0.0f);
+			c.tailInput.assign(TailBlockSize, 0.0f);
+		}
+		if (m_hasTail)
+		{
+			c.tail.init(TailBlockSize, channel.data() + 2 * TailBlockSize,
+				frames - 2 * TailBlockSize);
+			c.tailOutput.assign(TailBlockSize, 0.0f);
+			c.tailPrecalculated.assign(TailBlockSize, 0.0f);
+			c.backgroundInput.assign(TailBlockSize, 0.0f);
+		}
+	}
+
+	if (m_hasTail)
+	{
+		m_thread = new TailThread(this);
+		// the tail has a whole long block of time, but mustn't starve
+		// behind the GUI
+		m_thread->start(QThread::HighPriority);
+	}
+}
+
+
+
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+	if (m_thread != nullptr)
+	{
+		waitForTail();
+		m_quit.store(true, std::memory_order_release);
+		m_tailStart.release();
+		m_thread->wait();
+		delete m_thread;
+	}
+}
+
+
+
+
+void ConvolutionEngine::process(const sampleFrame * in, sampleFrame * out, fpp_t frames)
+{
+	float input[HeadBlockSize];
+	float output[HeadBlockSize];
+
+	fpp_t offset = 0;
+	while (offset < frames)
+	{
+		// with a tail, a piece never crosses the end of a short block, so
+		// the tail is worked off one short block at a time
+		const fpp_t count = m_hasTail0
+			? qMin<fpp_t>(frames - offset, HeadBlockSize - m_tailInputFill % HeadBlockSize)
+			: qMin<fpp_t>(frames - offset, HeadBlockSize);
+		const fpp_t fill = m_tailInputFill;
+
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			Channel & c = m_channels[ch];
+			for (fpp_t f = 0; f < count; ++f)
+			{
+				input[f] = in[offset + f][ch];
+			}
+
+			c.head.process(input, output, count);
+
+			if (m_hasTail0)
+			{
+				for (fpp_t f = 0; f < count; ++f)
+				{
+					output[f] += c.tail0Precalculated[fill + f];
+				}
+				if (m_hasTail)
+				{
+					for (fpp_t f = 0; f < count; ++f)
+					{
+						output[f] += c.tailPrecalculated[fill + f];
+					}
+				}
+				std::copy(input, input + count, c.tailInput.begin() + fill);
+
+				if ((fill + count) % HeadBlockSize == 0)
+				{
+					const fpp_t block = fill + count - HeadBlockSize;
+					c.tail0.process(c.tailInput.data() + block,
+						c.tail0Output.data() + block, HeadBlockSize);
+				}
+			}
+
+			for (fpp_t f = 0; f < count; ++f)
+			{
+				out[offset + f][ch] = output[f];
+			}
+		}
+		offset += count;
+
+		if (!m_hasTail0)
+		{
+			continue;
+		}
+
+		// a long block is complete: its short partitions become due and
+		// the background thread takes it for the long ones
+		m_tailInputFill += count;
+		if (m_tailInputFill == TailBlockSize)
+		{
+			if (m_hasTail)
+			{
+				waitForTail();
+			}
+			for (Channel & c : m_channels)
+			{
+				c.tail0Output.swap(c.tail0Precalculated);
+				if (m_hasTail)
+				{
+					c.tailOutput.swap(c.tailPrecalculated);
+					c.backgroundInput.swap(c.tailInput);
+				}
+			}
+			if (m_hasTail)
+			{
+				startTail();
+			}
+			m_tailInputFill = 0;
+		}
+	}
+}
+
+
+
+
+void ConvolutionEngine::reset()
+{
+	waitForTail();
+	for (Channel & c : m_channels)
+	{
+		c.head.reset();
+		c.tail0.reset();
+		c.tail.reset();
+		std::fill(c.tail0Output.begin(), c.tail0Output.end(), 0.0f);
+		std::fill(c.tail0Precalculated.begin(), c.tail0Precalculated.end(), 0.0f);
+		std::fill(c.tailOutput.begin(), c.tailOutput.end(), 0.0f);
+		std::fill(c.tailPrecalculated.begin(), c.tailPrecalculated.end(), 0.0f);
+		std::fill(c.tailInput.begin(), c.tailInput.end(), 0.0f);
+		std::fill(c.backgroundInput.begin(), c.backgroundInput.end(), 0.0f);
+	}
+	m_tailInputFill = 0;
+}
+
+
+
+
+qint64 ConvolutionEngine::memoryUsage() const
+{
+	qint64 bytes = 0;
+	for (const Channel & c : m_channels)
+	{
+		bytes += c.head.memoryUsage() + c.tail0.memoryUsage() + c.tail.memoryUsage();
+		for (const std::vector<float> * v : {&c.tail0Output, &c.tail0Precalculated,
+			&c.tailOutput, &c.tailPrecalculated, &c.tailInput, &c.backgroundInput})
+		{
+			bytes += v->capacity() * sizeof(float);
+		}
+	}
+	return bytes;
+}
+
+
+
+
+void ConvolutionEngine::processTail()
+{
+	for (Channel & c : m_channels)
+	{
+		c.tail.process(c.backgroundInput.data(), c.tailOutput.data(), TailBlockSize);
+	}
+}
+
+
+
+
+void ConvolutionEngine::startTail()
+{
+	m_tailRunning = true;
+	m_tailStart.release();
+}
+
+
+
+
+void ConvolutionEngine::waitForTail()
+{
+	if (m_tailRunning)
+	{
+		m_tailDone.acquire();
+		m_tailRunning = false;
+	}
+}
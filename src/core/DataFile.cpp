@@ -27,20 +27,29 @@
 #include "DataFile.h"
 
 #include <math.h>
+#include <algorithm>
 #include <map>
 
+#include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QMessageBox>
+#include <QMutex>
+#include <QThread>
+#include <QtEndian>
 
 #include "base64.h"
+#include "BinaryDocument.h"
+#include "BlockCompression.h"
 #include "ConfigManager.h"
 #include "Effect.h"
 #include "embed.h"
 #include "GuiApplication.h"
 #include "LocaleHelper.h"
+#include "PerfLog.h"
 #include "PluginFactory.h"
 #include "ProjectVersion.h"
 #include "SongEditor.h"
@@ -52,6 +61,47 @@
 static void findIds(const QDomElement& elem, QList<jo_id_t>& idList);
 
 
+namespace
+{
+
+// the DataFiles that exist, for finding the one a node belongs to
+QMutex dataFilesMutex;
+std::vector<DataFile*> dataFiles;
+
+void registerDataFile(DataFile* dataFile, bool on)
+{
+	QMutexLocker lock(&dataFilesMutex);
+	if (on)
+	{
+		dataFiles.push_back(dataFile);
+	}
+	else
+	{
+		dataFiles.erase(std::remove(dataFiles.begin(), dataFiles.end(), dataFile), dataFiles.end());
+	}
+}
+
+// A .mmpb starts with the magic, the format version, the number of binary
+// chunks and the size of the document, followed by the offset and size of
+// each chunk. The document comes next and then the chunks, each aligned to
+// BinaryAlignment bytes so they can be used right from the mapped file.
+// All numbers are little endian, including the sample frames stored in
+// chunks. The document is XML in version 1 and encoded by BinaryDocument
+// since version 2.
+const char BinaryMagic[8] = { 'L', 'M', 'M', 'S', 'P', 'R', 'J', 'B' };
+const quint32 BinaryVersion = 2;
+const qint64 BinaryHeaderBytes = sizeof(BinaryMagic) + 4 + 4 + 8;
+const qint64 BinaryIndexBytes = 8 + 8;
+const qint64 BinaryAlignment = 16;
+
+qint64 alignBinary(qint64 offset)
+{
+	return (offset + BinaryAlignment - 1) / BinaryAlignment * BinaryAlignment;
+}
+
+} // namespace
+
+
 // QMap with the DOM elements that access file resources
 const DataFile::ResourcesMap DataFile::ELEMENTS_WITH_RESOURCES = {
 { "sampletco", {"src"} },
@@ -105,8 +155,10 @@ DataFile::DataFile( Type type ) :
 	m_content(),
 	m_head(),
 	m_type( type ),
-	m_fileVersion( UPGRADE_METHODS.size() )
+	m_fileVersion( UPGRADE_METHODS.size() ),
+	m_storesBinary( false )
 {
+	registerDataFile( this, true );
 	appendChild( createProcessingInstruction("xml", "version=\"1.0\""));
 	QDomElement root = createElement( "lmms-project" );
 	root.setAttribute( "version", m_fileVersion );
@@ -131,10 +183,12 @@ DataFile::DataFile( const QString & _fileName ) :
 	m_fileName(_fileName),
 	m_content(),
 	m_head(),
-	m_fileVersion( UPGRADE_METHODS.size() )
+	m_fileVersion( UPGRADE_METHODS.size() ),
+	m_storesBinary( false )
 {
-	QFile inFile( _fileName );
-	if( !inFile.open( QIODevice::ReadOnly ) )
+	registerDataFile( this, true );
+	auto inFile = std::make_shared<QFile>( _fileName );
+	if( !inFile->open( QIODevice::ReadOnly ) )
 	{
 		if( gui )
 		{
@@ -150,7 +204,10 @@ DataFile::DataFile( const QString & _fileName ) :
 		return;
 	}
 
-	loadData( inFile.readAll(), _fileName );
+	if( !loadBinaryProject( inFile ) )
+	{
+		loadData( inFile->readAll(), _fileName );
+	}
 }
 
 
@@ -161,16 +218,51 @@ DataFile::DataFile( const QByteArray & _data ) :
 	m_fileName(""),
 	m_content(),
 	m_head(),
-	m_fileVersion( UPGRADE_METHODS.size() )
+	m_fileVersion( UPGRADE_METHODS.size() ),
+	m_storesBinary( false )
 {
+	registerDataFile( this, true );
 	loadData( _data, "<internal data>" );
 }
 
 
 
 
+DataFile::DataFile( const QDomDocument & document, const QString & sourceFile ) :
+	QDomDocument( document ),
+	m_fileName( sourceFile ),
+	m_content(),
+	m_head(),
+	m_fileVersion( UPGRADE_METHODS.size() ),
+	m_storesBinary( false )
+{
+	registerDataFile( this, true );
+	loadDocument( sourceFile );
+}
+
+
+
+
+DataFile::DataFile( const DataFile & other ) :
+	QDomDocument( other ),
+	m_fileName( other.m_fileName ),
+	m_content( other.m_content ),
+	m_head( other.m_head ),
+	m_type( other.m_type ),
+	m_fileVersion( other.m_fileVersion ),
+	m_storesBinary( other.m_storesBinary ),
+	m_binary( other.m_binary ),
+	m_binaryFile( other.m_binaryFile )
+{
+	registerDataFile( this, true );
+}
+
+
+
+
 DataFile::~DataFile()
 {
+	registerDataFile( this, false );
 }
 
 
@@ -181,7 +273,7 @@ bool DataFile::validate( QString extension )
 	switch( m_type )
 	{
 	case Type::SongProject:
-		if( extension == "mmp" || extension == "mmpz" )
+		if( extension == "mmp" || extension == "mmpz" || extension == "mmpb" )
 		{
 			return true;
 		}
@@ -206,6 +298,7 @@ bool DataFile::validate( QString extension )
 		break;
 	case Type::UnknownType:
 		if (! ( extension == "mmp" || extension == "mpt" || extension == "mmpz" ||
+				extension == "mmpb" ||
 				extension == "xpf" || extension == "xml" ||
 				( extension == "xiz" && ! pluginFactory->pluginSupportingExtension(extension).isNull()) ||
 				extension == "sf2" || extension == "sf3" || extension == "pat" || extension == "mid" ||
@@ -241,7 +334,8 @@ QString DataFile::nameWithExtension( const QString & _fn ) const
 		case SongProject:
 			if( extension != "mmp" &&
 					extension != "mpt" &&
-					extension != "mmpz" )
+					extension != "mmpz" &&
+					extension != "mmpb" )
 			{
 				if( ConfigManager::inst()->value( "app",
 						"nommpz" ).toInt() == 0 )
@@ -279,7 +373,27 @@ void DataFile::write( QTextStream & _strm )
 		cleanMetaNodes( documentElement() );
 	}
 
+	// binary data is kept in the XML when it's not written next to it, so
+	// .mmpb projects can be converted to XML and back
+	QDomElement binaryData;
+	if( !m_binary.empty() )
+	{
+		binaryData = createElement( "binarydata" );
+		for( const QByteArray & data : m_binary )
+		{
+			QDomElement chunk = createElement( "chunk" );
+			chunk.setAttribute( "data", QString::fromLatin1( data.toBase64() ) );
+			binaryData.appendChild( chunk );
+		}
+		documentElement().appendChild( binaryData );
+	}
+
 	save(_strm, 2);
+
+	if( !binaryData.isNull() )
+	{
+		documentElement().removeChild( binaryData );
+	}
 }
 
 
@@ -289,7 +403,8 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 {
 	// Small lambda function for displaying errors
 	auto showError = [this](QString title, QString body){
-		if (gui)
+		// autosaves are written in the background
+		if (gui && QThread::currentThread() == QCoreApplication::instance()->thread())
 		{
 			QMessageBox mb;
 			mb.setWindowTitle(title);
@@ -373,12 +488,21 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 	}
 
 	const QString extension = fullName.section('.', -1);
-	if (extension == "mmpz" || extension == "xptz")
+	if (isBinaryProject(fullName))
+	{
+		cleanMetaNodes( documentElement() );
+		if (!writeBinaryProject(outfile, BinaryDocument::encode(*this)))
+		{
+			// leave the current file alone
+			outfile.resize(0);
+		}
+	}
+	else if (extension == "mmpz" || extension == "xptz")
 	{
 		QString xml;
 		QTextStream ts( &xml );
 		write( ts );
-		outfile.write( qCompress( xml.toUtf8() ) );
+		outfile.write( BlockCompression::compress( xml.toUtf8() ) );
 	}
 	else
 	{
@@ -415,6 +539,192 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 
 
 
+int DataFile::addBinary(const QByteArray& data)
+{
+	m_binary.push_back(data);
+	return static_cast<int>(m_binary.size()) - 1;
+}
+
+
+
+
+QByteArray DataFile::binary(int id) const
+{
+	if (id < 0 || id >= static_cast<int>(m_binary.size()))
+	{
+		return QByteArray();
+	}
+	return m_binary[id];
+}
+
+
+
+
+DataFile* DataFile::owner(const QDomNode& node)
+{
+	const QDomDocument document = node.ownerDocument();
+	QMutexLocker lock(&dataFilesMutex);
+	for (DataFile* dataFile : dataFiles)
+	{
+		if (*dataFile == document)
+		{
+			return dataFile;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+bool DataFile::isBinaryProject(const QString& fileName)
+{
+	return fileName.section('.', -1) == "mmpb";
+}
+
+
+
+
+bool DataFile::writeBinaryProject(QFile& outfile, const QByteArray& document) const
+{
+	QByteArray header;
+	QDataStream stream(&header, QIODevice::WriteOnly);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.writeRawData(BinaryMagic, sizeof(BinaryMagic));
+	stream << BinaryVersion << static_cast<quint32>(m_binary.size())
+		<< static_cast<quint64>(document.size());
+
+	qint64 offset = alignBinary(BinaryHeaderBytes
+		+ BinaryIndexBytes * static_cast<qint64>(m_binary.size()) + document.size());
+	for (const QByteArray& data : m_binary)
+	{
+		stream << static_cast<quint64>(offset) << static_cast<quint64>(data.size());
+		offset = alignBinary(offset + data.size());
+	}
+
+	if (outfile.write(header) != header.size() || outfile.write(document) != document.size())
+	{
+		return false;
+	}
+	for (const QByteArray& data : m_binary)
+	{
+		const QByteArray padding(alignBinary(outfile.pos()) - outfile.pos(), '\0');
+		if (outfile.write(padding) != padding.size()
+			|| outfile.write(data) != data.size())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+bool DataFile::loadBinaryProject(const std::shared_ptr<QFile>& file)
+{
+	if (file->peek(sizeof(BinaryMagic)) != QByteArray::fromRawData(BinaryMagic, sizeof(BinaryMagic)))
+	{
+		return false;
+	}
+
+	const qint64 size = file->size();
+	// the chunks are used right from the file if it can be mapped,
+	// otherwise it's read at once
+	QByteArray contents;
+	const char* base = reinterpret_cast<const char*>(file->map(0, size));
+	if (base == nullptr)
+	{
+		contents = file->readAll();
+		base = contents.constData();
+	}
+
+	const auto invalid = [this, file]()
+	{
+		qWarning() << "Invalid binary project" << file->fileName();
+		loadData(QByteArray(), file->fileName());
+		return true;
+	};
+
+	if (size < BinaryHeaderBytes)
+	{
+		return invalid();
+	}
+	const uchar* numbers = reinterpret_cast<const uchar*>(base);
+	const quint32 version = qFromLittleEndian<quint32>(numbers + 8);
+	const quint32 count = qFromLittleEndian<quint32>(numbers + 12);
+	const quint64 documentSize = qFromLittleEndian<quint64>(numbers + 16);
+	const qint64 documentOffset = BinaryHeaderBytes + BinaryIndexBytes * count;
+	if (version > BinaryVersion || documentOffset > size
+		|| documentSize > static_cast<quint64>(size - documentOffset))
+	{
+		return invalid();
+	}
+
+	std::vector<QByteArray> chunks;
+	chunks.reserve(count);
+	for (quint32 i = 0; i < count; ++i)
+	{
+		const uchar* entry = numbers + BinaryHeaderBytes + BinaryIndexBytes * i;
+		const quint64 offset = qFromLittleEndian<quint64>(entry);
+		const quint64 bytes = qFromLittleEndian<quint64>(entry + 8);
+		if (offset > static_cast<quint64>(size) || bytes > size - offset)
+		{
+			return invalid();
+		}
+		chunks.push_back(contents.isEmpty()
+			? QByteArray::fromRawData(base + offset, bytes)
+			: contents.mid(offset, bytes));
+	}
+
+	m_binary.swap(chunks);
+	m_binaryFile = file;
+	const QByteArray document = QByteArray::fromRawData(base + documentOffset, documentSize);
+	if (version < 2)
+	{
+		loadData(document, file->fileName());
+	}
+	else if (BinaryDocument::decode(document, *this))
+	{
+		loadDocument(file->fileName());
+	}
+	else
+	{
+		return invalid();
+	}
+	return true;
+}
+
+
+
+
+QStringList DataFile::resourceFiles(const QString& tagName) const
+{
+	QStringList files;
+	const auto it = ELEMENTS_WITH_RESOURCES.find(tagName);
+	if (it == ELEMENTS_WITH_RESOURCES.end())
+	{
+		return files;
+	}
+
+	QDomNodeList list = elementsByTagName(tagName);
+	for (int i = 0; !list.item(i).isNull(); ++i)
+	{
+		const QDomElement el = list.item(i).toElement();
+		for (const QString& attribute : it->second)
+		{
+			if (!el.attribute(attribute).isEmpty())
+			{
+				files << el.attribute(attribute);
+			}
+		}
+	}
+	return files;
+}
+
+
+
+
 bool DataFile::copyResources(const QString& resourcesDir)
 {
 	// List of filenames used so we can append a counter to any
@@ -1738,6 +2048,7 @@ void DataFile::upgrade_extendedNoteRange()
 
 void DataFile::upgrade()
 {
+	PerfTimeline::Phase phase( "Upgrade" );
 	// Runs all necessary upgrade methods
 	std::for_each( UPGRADE_METHODS.begin() + m_fileVersion, UPGRADE_METHODS.end(),
 		[this](UpgradeMethod um)
@@ -1781,7 +2092,7 @@ void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 	if( !setContent( _data, &errorMsg, &line, &col ) )
 	{
 		// parsing failed? then try to uncompress data
-		QByteArray uncompressed = qUncompress( _data );
+		QByteArray uncompressed = BlockCompression::uncompress( _data );
 		if( !uncompressed.isEmpty() )
 		{
 			if( setContent( uncompressed, &errorMsg, &line, &col ) )
@@ -1806,7 +2117,32 @@ void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 		}
 	}
 
+	loadDocument( _sourceFile );
+}
+
+
+
+
+void DataFile::loadDocument( const QString & sourceFile )
+{
 	QDomElement root = documentElement();
+
+	// binary data written into the XML, see write()
+	QDomElement binaryData = root.firstChildElement( "binarydata" );
+	if( !binaryData.isNull() )
+	{
+		if( m_binary.empty() )
+		{
+			for( QDomElement chunk = binaryData.firstChildElement( "chunk" );
+				!chunk.isNull(); chunk = chunk.nextSiblingElement( "chunk" ) )
+			{
+				m_binary.push_back( QByteArray::fromBase64(
+					chunk.attribute( "data" ).toLatin1() ) );
+			}
+		}
+		root.removeChild( binaryData );
+	}
+
 	m_type = type( root.attribute( "type" ) );
 	m_head = root.elementsByTagName( "head" ).item( 0 ).toElement();
 
@@ -1835,7 +2171,7 @@ void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 		 !=  openedWith.setCompareType(ProjectVersion::Minor)
 		 && gui != nullptr && root.attribute("type") == "song"
 		){
-			auto projectType = _sourceFile.endsWith(".mpt") ?
+			auto projectType = sourceFile.endsWith(".mpt") ?
 				SongEditor::tr("template") : SongEditor::tr("project");
 
 			TextFloat::displayMessage(
@@ -0,0 +1,124 @@
+/*
+ * DelayLine.cpp - stereo delay line with fractional delays
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "DelayLine.h"
+
+#include <algorithm>
+
+
+DelayLine::DelayLine() :
+	m_position(0)
+{
+}
+
+
+
+
+DelayLine::~DelayLine()
+{
+	DelayLinePool::release(m_buffer);
+}
+
+
+
+
+void DelayLine::reserve(float frames)
+{
+	// one frame more for the interpolation, and the frame written next
+	f_cnt_t needed = static_cast<f_cnt_t>(frames) + 2;
+	if (needed <= m_buffer.frames)
+	{
+		return;
+	}
+
+	sampleFrame * data = DelayLinePool::allocate(needed);
+	const f_cnt_t old = m_buffer.frames;
+	if (old > 0)
+	{
+		// oldest frame first, what is older than that is silent
+		std::copy(m_buffer.data + m_position, m_buffer.data + old, data);
+		std::copy(m_buffer.data, m_buffer.data + m_position, data + old - m_position);
+		DelayLinePool::release(m_buffer.data, old);
+	}
+	m_buffer.data = data;
+	m_buffer.frames = needed;
+	m_position = old;
+}
+
+
+
+
+void DelayLine::clear()
+{
+	DelayLinePool::release(m_buffer);
+	m_position = 0;
+}
+
+
+
+
+void DelayLine::sleep()
+{
+	DelayLinePool::park(m_buffer);
+}
+
+
+
+
+void DelayLine::wake()
+{
+	// if the memory was taken back, reserve() starts over
+	if (m_buffer.parked)
+	{
+		DelayLinePool::unpark(m_buffer);
+	}
+}
+
+
+
+
+void DelayLine::readBlock(const float * delayLeft, const float * delayRight,
+	sampleFrame * out, fpp_t frames) const
+{
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		out[f][0] = tap(m_position + f, delayLeft[f], 0);
+	}
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		out[f][1] = tap(m_position + f, delayRight[f], 1);
+	}
+}
+
+
+
+
+void DelayLine::writeBlock(const sampleFrame * in, fpp_t frames)
+{
+	const f_cnt_t first = qMin<f_cnt_t>(frames, m_buffer.frames - m_position);
+	std::copy(in, in + first, m_buffer.data + m_position);
+	std::copy(in + first, in + frames, m_buffer.data);
+	m_position += frames;
+	m_position -= m_position >= m_buffer.frames ? m_buffer.frames : 0;
+}
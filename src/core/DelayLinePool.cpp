@@ -0,0 +1,234 @@
+/*
+ * DelayLinePool.cpp - memory shared by the delay lines of all effects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "DelayLinePool.h"
+
+#include <cstring>
+
+#include "RealtimeMemory.h"
+
+
+const f_cnt_t DelayLinePool::ChunkFrames;
+const int DelayLinePool::ReleaseSeconds;
+const f_cnt_t DelayLinePool::MaxSpareFrames;
+
+std::atomic_flag DelayLinePool::s_lock = ATOMIC_FLAG_INIT;
+DelayLinePool::Spare * DelayLinePool::s_spares = nullptr;
+f_cnt_t DelayLinePool::s_spareFrames = 0;
+DelayLinePool::Buffer * DelayLinePool::s_parked = nullptr;
+
+
+
+
+// the lock is only held for a few pointer operations, and the audio threads
+// mustn't be put to sleep by it
+class DelayLinePool::Lock
+{
+public:
+	Lock()
+	{
+		while (s_lock.test_and_set(std::memory_order_acquire))
+		{
+		}
+	}
+
+	~Lock()
+	{
+		s_lock.clear(std::memory_order_release);
+	}
+} ;
+
+
+
+
+sampleFrame * DelayLinePool::allocate(f_cnt_t & frames)
+{
+	frames = (frames + ChunkFrames - 1) / ChunkFrames * ChunkFrames;
+
+	sampleFrame * data = nullptr;
+	{
+		Lock lock;
+		// the smallest spare block that fits, unless it's much too large
+		Spare ** best = nullptr;
+		for (Spare ** s = &s_spares; *s != nullptr; s = &(*s)->next)
+		{
+			if ((*s)->frames >= frames && (*s)->frames <= 2 * frames &&
+				(best == nullptr || (*s)->frames < (*best)->frames))
+			{
+				best = s;
+			}
+		}
+		if (best != nullptr)
+		{
+			Spare * spare = *best;
+			*best = spare->next;
+			s_spareFrames -= spare->frames;
+			frames = spare->frames;
+			data = reinterpret_cast<sampleFrame *>(spare);
+		}
+	}
+
+	if (data == nullptr)
+	{
+		data = static_cast<sampleFrame *>(RealtimeMemory::allocate(frames * sizeof(sampleFrame)));
+	}
+	memset(data, 0, frames * sizeof(sampleFrame));
+	return data;
+}
+
+
+
+
+void DelayLinePool::release(sampleFrame * data, f_cnt_t frames)
+{
+	if (data == nullptr)
+	{
+		return;
+	}
+	Lock lock;
+	keepSpare(data, frames);
+}
+
+
+
+
+void DelayLinePool::release(Buffer & buffer)
+{
+	Lock lock;
+	if (buffer.parked)
+	{
+		unlink(buffer);
+	}
+	if (buffer.data != nullptr)
+	{
+		keepSpare(buffer.data, buffer.frames);
+	}
+	buffer.data = nullptr;
+	buffer.frames = 0;
+}
+
+
+
+
+void DelayLinePool::park(Buffer & buffer)
+{
+	if (buffer.parked || buffer.data == nullptr)
+	{
+		return;
+	}
+	Lock lock;
+	buffer.parked = true;
+	buffer.idleFrames = 0;
+	buffer.prev = nullptr;
+	buffer.next = s_parked;
+	if (s_parked != nullptr)
+	{
+		s_parked->prev = &buffer;
+	}
+	s_parked = &buffer;
+}
+
+
+
+
+bool DelayLinePool::unpark(Buffer & buffer)
+{
+	Lock lock;
+	if (buffer.parked)
+	{
+		unlink(buffer);
+	}
+	return buffer.data != nullptr;
+}
+
+
+
+
+void DelayLinePool::collect(fpp_t frames, sample_rate_t sampleRate)
+{
+	const f_cnt_t limit = ReleaseSeconds * static_cast<f_cnt_t>(sampleRate);
+
+	Lock lock;
+	for (Buffer * buffer = s_parked; buffer != nullptr; )
+	{
+		Buffer * next = buffer->next;
+		buffer->idleFrames += frames;
+		if (buffer->idleFrames >= limit)
+		{
+			unlink(*buffer);
+			keepSpare(buffer->data, buffer->frames);
+			buffer->data = nullptr;
+			buffer->frames = 0;
+		}
+		buffer = next;
+	}
+}
+
+
+
+
+f_cnt_t DelayLinePool::spareFrames()
+{
+	Lock lock;
+	return s_spareFrames;
+}
+
+
+
+
+void DelayLinePool::keepSpare(sampleFrame * data, f_cnt_t frames)
+{
+	if (s_spareFrames + frames > MaxSpareFrames)
+	{
+		RealtimeMemory::release(data, frames * sizeof(sampleFrame));
+		return;
+	}
+	Spare * spare = reinterpret_cast<Spare *>(data);
+	spare->next = s_spares;
+	spare->frames = frames;
+	s_spares = spare;
+	s_spareFrames += frames;
+}
+
+
+
+
+void DelayLinePool::unlink(Buffer & buffer)
+{
+	if (buffer.prev != nullptr)
+	{
+		buffer.prev->next = buffer.next;
+	}
+	else
+	{
+		s_parked = buffer.next;
+	}
+	if (buffer.next != nullptr)
+	{
+		buffer.next->prev = buffer.prev;
+	}
+	buffer.prev = nullptr;
+	buffer.next = nullptr;
+	buffer.parked = false;
+}
@@ -25,12 +25,19 @@
 
 #include <QDomElement>
 
+#include <cmath>
+
 #include "Effect.h"
 #include "EffectChain.h"
 #include "EffectControls.h"
 #include "EffectView.h"
 
 #include "ConfigManager.h"
+#include "MixHelpers.h"
+#include "Oversampler.h"
+
+
+const f_cnt_t Effect::UnknownTail;
 
 
 Effect::Effect( const Plugin::Descriptor * _desc,
@@ -43,11 +50,14 @@ Effect::Effect( const Plugin::Descriptor * _desc,
 	m_noRun( false ),
 	m_running( false ),
 	m_bufferCount( 0 ),
+	m_silentFrames( 0 ),
 	m_enabledModel( true, this, tr( "Effect enabled" ) ),
 	m_wetDryModel( 1.0f, -1.0f, 1.0f, 0.01f, this, tr( "Wet/Dry mix" ) ),
 	m_gateModel( 0.0f, 0.0f, 1.0f, 0.01f, this, tr( "Gate" ) ),
 	m_autoQuitModel( 1.0f, 1.0f, 8000.0f, 100.0f, 1.0f, this, tr( "Decay" ) ),
-	m_autoQuitDisabled( false )
+	m_autoQuitDisabled( false ),
+	m_oversamplingRate( 0 ),
+	m_oversampler( NULL )
 {
 	m_srcState[0] = m_srcState[1] = NULL;
 	reinitSRC();
@@ -70,6 +80,7 @@ Effect::~Effect()
 			src_delete( m_srcState[i] );
 		}
 	}
+	delete m_oversampler;
 }
 
 
@@ -137,7 +148,8 @@ Effect * Effect::instantiate( const QString& pluginName,
 
 void Effect::checkGate( double _out_sum )
 {
-	if( m_autoQuitDisabled )
+	// with a known tail, the chain decides when to stop
+	if( m_autoQuitDisabled || tailLength() != UnknownTail )
 	{
 		return;
 	}
@@ -162,6 +174,38 @@ void Effect::checkGate( double _out_sum )
 
 
 
+void Effect::checkGate( const sampleFrame * _buf, const fpp_t _frames )
+{
+	if( m_autoQuitDisabled )
+	{
+		return;
+	}
+
+	checkGate( MixHelpers::analyze( _buf, _frames ).meanSquare );
+}
+
+
+
+
+f_cnt_t Effect::feedbackTail( float _period, float _feedback )
+{
+	const float decay = fabsf( _feedback );
+	if( decay > 0.999f )
+	{
+		return UnknownTail;
+	}
+	// the first echo, and those it takes to fall by 60 dB
+	int echoes = 1;
+	if( decay > 0.001f )
+	{
+		echoes += static_cast<int>( ceilf( logf( 0.001f ) / logf( decay ) ) );
+	}
+	return static_cast<f_cnt_t>( ceilf( _period ) ) * echoes;
+}
+
+
+
+
 PluginView * Effect::instantiateView( QWidget * _parent )
 {
 	return new EffectView( this, _parent );
@@ -192,6 +236,34 @@ void Effect::reinitSRC()
 
 
 
+void Effect::setOversamplingRate( int _rate )
+{
+	if( m_oversamplingRate == 0 )
+	{
+		connect( Engine::mixer(), SIGNAL( qualitySettingsChanged() ),
+				this, SLOT( updateOversampler() ) );
+	}
+	m_oversamplingRate = _rate;
+	updateOversampler();
+}
+
+
+
+
+void Effect::updateOversampler()
+{
+	const int factor = oversamplingFactor( m_oversamplingRate );
+	if( m_oversampler == NULL || m_oversampler->factor() != factor )
+	{
+		delete m_oversampler;
+		m_oversampler = new Oversampler( factor,
+					Mixer::maxFramesPerPeriod() );
+	}
+}
+
+
+
+
 void Effect::resample( int _i, const sampleFrame * _src_buf,
 							sample_rate_t _src_sr,
 				sampleFrame * _dst_buf, sample_rate_t _dst_sr,
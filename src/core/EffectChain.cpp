@@ -27,16 +27,21 @@
 #include <QDomElement>
 
 #include "EffectChain.h"
+#include "BufferManager.h"
 #include "Effect.h"
 #include "DummyEffect.h"
 #include "MixHelpers.h"
+#include "PerfLog.h"
+#include "PlanarBuffer.h"
+#include "RealtimeCheck.h"
 #include "Song.h"
 
 
 EffectChain::EffectChain( Model * _parent ) :
 	Model( _parent ),
 	SerializingObject(),
-	m_enabledModel( false, NULL, tr( "Effects enabled" ) )
+	m_enabledModel( false, NULL, tr( "Effects enabled" ) ),
+	m_planarBuffer( NULL )
 {
 }
 
@@ -46,6 +51,10 @@ EffectChain::EffectChain( Model * _parent ) :
 EffectChain::~EffectChain()
 {
 	clear();
+	if( m_planarBuffer )
+	{
+		BufferManager::release( m_planarBuffer );
+	}
 }
 
 
@@ -112,6 +121,7 @@ void EffectChain::loadSettings( const QDomElement & _this )
 		}
 		node = node.nextSibling();
 	}
+	updatePlanarBuffer();
 
 	emit dataChanged();
 }
@@ -123,6 +133,7 @@ void EffectChain::appendEffect( Effect * _effect )
 {
 	Engine::mixer()->requestChangeInModel();
 	m_effects.append( _effect );
+	updatePlanarBuffer();
 	Engine::mixer()->doneChangeInModel();
 
 	m_enabledModel.setValue( true );
@@ -182,31 +193,163 @@ void EffectChain::moveUp( Effect * _effect )
 
 
 
-bool EffectChain::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, bool hasInputNoise )
+bool EffectChain::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, bool hasInputNoise,
+					MixHelpers::BufferAnalysis * analysis )
 {
 	if( m_enabledModel.value() == false )
 	{
+		if( analysis )
+		{
+			*analysis = MixHelpers::analyze( _buf, _frames );
+		}
 		return false;
 	}
 
-	MixHelpers::sanitize( _buf, _frames );
+	PerfTrace::Scope trace( "Effect chain", PerfTrace::Effect );
+
+	// analyzing is required for sanitizing anyway, so keep the result of
+	// the last pass for the caller
+	MixHelpers::BufferAnalysis result = MixHelpers::analyzeAndSanitize( _buf, _frames );
 
 	bool moreEffects = false;
+	// whether the signal currently is in m_planarBuffer rather than _buf
+	bool planar = false;
+	// whether nothing reaches the current effect, neither input of the chain
+	// nor the tail of an effect before it
+	bool silentInput = result.silent;
 	for( EffectList::Iterator it = m_effects.begin(); it != m_effects.end(); ++it )
 	{
-		if( hasInputNoise || ( *it )->isRunning() )
+		const f_cnt_t tail = ( *it )->tailLength();
+		bool run = hasInputNoise || ( *it )->isRunning();
+		if( tail != Effect::UnknownTail && !( *it )->m_autoQuitDisabled )
+		{
+			if( !silentInput )
+			{
+				( *it )->m_silentFrames = 0;
+				( *it )->startRunning();
+			}
+			else if( ( *it )->isRunning() )
+			{
+				( *it )->m_silentFrames += _frames;
+				if( ( *it )->m_silentFrames > tail + ( *it )->latency() )
+				{
+					// called once more, stopped, so it can put its
+					// state to sleep like after checkGate()
+					( *it )->stopRunning();
+				}
+				run = true;
+			}
+			else
+			{
+				run = false;
+			}
+		}
+		silentInput &= !( ( *it )->isRunning() && ( *it )->isEnabled() );
+
+		if( run )
 		{
+			MixerProfiler::Probe probe( &( *it )->m_processingTime );
+			PerfTrace::Scope effectTrace( ( *it )->descriptor()->name,
+							PerfTrace::Effect );
+			RealtimeCheck::Context context( *it );
+			if( ( *it )->prefersPlanar() && m_planarBuffer )
+			{
+				if( !planar )
+				{
+					m_planarBuffer->fromInterleaved( _buf, _frames );
+					planar = true;
+				}
+				moreEffects |= ( *it )->processPlanarBuffer( *m_planarBuffer, _frames );
+				for( ch_cnt_t ch = 0; ch < m_planarBuffer->channels(); ++ch )
+				{
+					MixerProfiler::countDenormals( &( *it )->m_denormals,
+							m_planarBuffer->channel( ch ), _frames );
+				}
+				MixHelpers::sanitize( *m_planarBuffer, _frames );
+				continue;
+			}
+			if( planar )
+			{
+				m_planarBuffer->toInterleaved( _buf, _frames );
+				planar = false;
+			}
 			moreEffects |= ( *it )->processAudioBuffer( _buf, _frames );
-			MixHelpers::sanitize( _buf, _frames );
+			MixerProfiler::countDenormals( &( *it )->m_denormals,
+						_buf[0].data(), _frames * DEFAULT_CHANNELS );
+			result = MixHelpers::analyzeAndSanitize( _buf, _frames );
 		}
 	}
+	if( planar )
+	{
+		m_planarBuffer->toInterleaved( _buf, _frames );
+		result = MixHelpers::analyze( _buf, _frames );
+	}
 
+	if( analysis )
+	{
+		*analysis = result;
+	}
 	return moreEffects;
 }
 
 
 
 
+void EffectChain::updatePlanarBuffer()
+{
+	if( m_planarBuffer )
+	{
+		return;
+	}
+	for( const Effect * effect : m_effects )
+	{
+		if( effect->prefersPlanar() )
+		{
+			m_planarBuffer = BufferManager::acquirePlanar();
+			return;
+		}
+	}
+}
+
+
+
+
+f_cnt_t EffectChain::latency() const
+{
+	if( m_enabledModel.value() == false )
+	{
+		return 0;
+	}
+
+	f_cnt_t sum = 0;
+	for( const Effect * effect : m_effects )
+	{
+		if( effect->isEnabled() )
+		{
+			sum += effect->latency();
+		}
+	}
+	return sum;
+}
+
+
+
+
+bool EffectChain::drivesControllers() const
+{
+	for( const Effect * effect : m_effects )
+	{
+		if( qstrcmp( effect->descriptor()->name, "peakcontrollereffect" ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
 void EffectChain::startRunning()
 {
 	if( m_enabledModel.value() == false )
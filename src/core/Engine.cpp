@@ -30,18 +30,14 @@
 #include "Ladspa2LMMS.h"
 #include "Lv2Manager.h"
 #include "Mixer.h"
+#include "PerfLog.h"
 #include "Plugin.h"
 #include "PresetPreviewPlayHandle.h"
 #include "ProjectJournal.h"
 #include "Song.h"
 #include "BandLimitedWave.h"
 
-float LmmsCore::s_framesPerTick;
-Mixer* LmmsCore::s_mixer = NULL;
-FxMixer * LmmsCore::s_fxMixer = NULL;
-BBTrackContainer * LmmsCore::s_bbTrackContainer = NULL;
-Song * LmmsCore::s_song = NULL;
-ProjectJournal * LmmsCore::s_projectJournal = NULL;
+EngineContext * LmmsCore::s_mainContext = NULL;
 #ifdef LMMS_HAVE_LV2
 Lv2Manager * LmmsCore::s_lv2Manager = nullptr;
 #endif
@@ -54,33 +50,37 @@ void* LmmsCore::s_dndPluginKey = nullptr;
 void LmmsCore::init( bool renderOnly )
 {
 	LmmsCore *engine = inst();
+	PerfTimeline::Phase phase( "Engine" );
 
 	emit engine->initProgress(tr("Generating wavetables"));
 	// generate (load from file) bandlimited wavetables
+	PerfTimeline::Phase wavesPhase( "Wavetables" );
 	BandLimitedWave::generateWaves();
+	wavesPhase.finish();
 
 	emit engine->initProgress(tr("Initializing data structures"));
-	s_projectJournal = new ProjectJournal;
-	s_mixer = new Mixer( renderOnly );
-	s_song = new Song;
-	s_fxMixer = new FxMixer;
-	s_bbTrackContainer = new BBTrackContainer;
+	PerfTimeline::Phase structuresPhase( "Data structures" );
+	s_mainContext = new EngineContext( renderOnly );
+	structuresPhase.finish();
 
 #ifdef LMMS_HAVE_LV2
+	PerfTimeline::Phase lv2Phase( "LV2 plugins" );
 	s_lv2Manager = new Lv2Manager;
 	s_lv2Manager->initPlugins();
+	lv2Phase.finish();
 #endif
-	s_ladspaManager = new Ladspa2LMMS;
 
-	s_projectJournal->setJournalling( true );
+	projectJournal()->setJournalling( true );
 
 	emit engine->initProgress(tr("Opening audio and midi devices"));
-	s_mixer->initDevices();
+	PerfTimeline::Phase devicesPhase( "Audio and MIDI devices" );
+	mixer()->initDevices();
+	devicesPhase.finish();
 
 	PresetPreviewPlayHandle::init();
 
 	emit engine->initProgress(tr("Launching mixer threads"));
-	s_mixer->startProcessing();
+	mixer()->startProcessing();
 }
 
 
@@ -88,29 +88,33 @@ void LmmsCore::init( bool renderOnly )
 
 void LmmsCore::destroy()
 {
-	s_projectJournal->stopAllJournalling();
-	s_mixer->stopProcessing();
+	s_mainContext->mixer()->stopProcessing();
 
 	PresetPreviewPlayHandle::cleanup();
 
-	s_song->clearProject();
-
-	deleteHelper( &s_bbTrackContainer );
-
-	deleteHelper( &s_fxMixer );
-	deleteHelper( &s_mixer );
+	// other contexts have to be gone by now, they use the worker threads
+	// of the main one
+	deleteHelper( &s_mainContext );
 
 #ifdef LMMS_HAVE_LV2
 	deleteHelper( &s_lv2Manager );
 #endif
 	deleteHelper( &s_ladspaManager );
 
-	//delete ConfigManager::inst();
-	deleteHelper( &s_projectJournal );
+	delete ConfigManager::inst();
+}
+
 
-	deleteHelper( &s_song );
 
-	delete ConfigManager::inst();
+
+Ladspa2LMMS * LmmsCore::getLADSPAManager()
+{
+	if( s_ladspaManager == NULL )
+	{
+		PerfTimeline::Phase phase( "LADSPA plugins" );
+		s_ladspaManager = new Ladspa2LMMS;
+	}
+	return s_ladspaManager;
 }
 
 
@@ -128,7 +132,7 @@ bool LmmsCore::ignorePluginBlacklist()
 float LmmsCore::framesPerTick(sample_rate_t sampleRate)
 {
 	return sampleRate * 60.0f * 4 /
-			DefaultTicksPerBar / s_song->getTempo();
+			DefaultTicksPerBar / getSong()->getTempo();
 }
 
 
@@ -136,8 +140,8 @@ float LmmsCore::framesPerTick(sample_rate_t sampleRate)
 
 void LmmsCore::updateFramesPerTick()
 {
-	s_framesPerTick = s_mixer->processingSampleRate() * 60.0f * 4 /
-				DefaultTicksPerBar / s_song->getTempo();
+	context()->setFramesPerTick( mixer()->processingSampleRate() * 60.0f * 4 /
+				DefaultTicksPerBar / getSong()->getTempo() );
 }
 
 
@@ -0,0 +1,142 @@
+/*
+ * EngineContext.cpp - the objects of one session of the engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "EngineContext.h"
+
+#include "BBTrackContainer.h"
+#include "ControllerGraph.h"
+#include "EnvelopeAndLfoParameters.h"
+#include "FxMixer.h"
+#include "Mixer.h"
+#include "ProjectJournal.h"
+#include "Song.h"
+
+
+EngineContext * EngineContext::s_main = nullptr;
+std::atomic_int EngineContext::s_others(0);
+
+namespace
+{
+
+thread_local EngineContext * currentContext = nullptr;
+
+} // namespace
+
+
+
+
+EngineContext::EngineContext(bool renderOnly) :
+	m_mixer(nullptr),
+	m_fxMixer(nullptr),
+	m_song(nullptr),
+	m_bbTrackContainer(nullptr),
+	m_projectJournal(nullptr),
+	m_controllerGraph(new ControllerGraph),
+	m_lfoInstances(new LfoInstances),
+	m_framesPerTick(0),
+	m_period(0)
+{
+	if (s_main == nullptr)
+	{
+		s_main = this;
+	}
+	else
+	{
+		++s_others;
+	}
+
+	// the objects look each other up by the Engine accessors
+	Scope scope(this);
+	m_projectJournal = new ProjectJournal;
+	m_mixer = new Mixer(renderOnly);
+	m_song = new Song;
+	m_fxMixer = new FxMixer;
+	m_bbTrackContainer = new BBTrackContainer;
+
+	// Engine::init() opens the devices of the main context once the
+	// plugins are known, render-only contexts just get dummy devices
+	if (s_main != this)
+	{
+		m_mixer->initDevices();
+	}
+}
+
+
+
+
+EngineContext::~EngineContext()
+{
+	{
+		Scope scope(this);
+		m_projectJournal->stopAllJournalling();
+		m_mixer->stopProcessing();
+		m_song->clearProject();
+
+		delete m_bbTrackContainer;
+		m_bbTrackContainer = nullptr;
+		delete m_fxMixer;
+		m_fxMixer = nullptr;
+		delete m_mixer;
+		m_mixer = nullptr;
+		delete m_projectJournal;
+		m_projectJournal = nullptr;
+		delete m_song;
+		m_song = nullptr;
+	}
+
+	if (s_main == this)
+	{
+		s_main = nullptr;
+	}
+	else
+	{
+		--s_others;
+	}
+}
+
+
+
+
+EngineContext::Scope::Scope(EngineContext * context) :
+	m_previous(currentContext)
+{
+	currentContext = context;
+}
+
+
+
+
+EngineContext::Scope::~Scope()
+{
+	currentContext = m_previous;
+}
+
+
+
+
+EngineContext * EngineContext::currentOfThread()
+{
+	return currentContext != nullptr ? currentContext : s_main;
+}
@@ -22,10 +22,14 @@
  *
  */
 
+#include <cstring>
+
 #include <QDomElement>
+#include <QVarLengthArray>
 
 #include "EnvelopeAndLfoParameters.h"
 #include "Engine.h"
+#include "EngineContext.h"
 #include "Mixer.h"
 #include "Oscillator.h"
 
@@ -38,10 +42,7 @@ extern const float SECS_PER_LFO_OSCILLATION = 20.0f;
 const f_cnt_t minimumFrames = 1;
 
 
-EnvelopeAndLfoParameters::LfoInstances * EnvelopeAndLfoParameters::s_lfoInstances = NULL;
-
-
-void EnvelopeAndLfoParameters::LfoInstances::trigger()
+void LfoInstances::trigger()
 {
 	QMutexLocker m( &m_lfoListMutex );
 	for( LfoList::Iterator it = m_lfos.begin();
@@ -50,13 +51,14 @@ void EnvelopeAndLfoParameters::LfoInstances::trigger()
 		( *it )->m_lfoFrame +=
 				Engine::mixer()->framesPerPeriod();
 		( *it )->m_bad_lfoShapeData = true;
+		( *it )->m_bad_sustainData = true;
 	}
 }
 
 
 
 
-void EnvelopeAndLfoParameters::LfoInstances::reset()
+void LfoInstances::reset()
 {
 	QMutexLocker m( &m_lfoListMutex );
 	for( LfoList::Iterator it = m_lfos.begin();
@@ -64,13 +66,14 @@ void EnvelopeAndLfoParameters::LfoInstances::reset()
 	{
 		( *it )->m_lfoFrame = 0;
 		( *it )->m_bad_lfoShapeData = true;
+		( *it )->m_bad_sustainData = true;
 	}
 }
 
 
 
 
-void EnvelopeAndLfoParameters::LfoInstances::add( EnvelopeAndLfoParameters * lfo )
+void LfoInstances::add( EnvelopeAndLfoParameters * lfo )
 {
 	QMutexLocker m( &m_lfoListMutex );
 	m_lfos.append( lfo );
@@ -79,7 +82,7 @@ void EnvelopeAndLfoParameters::LfoInstances::add( EnvelopeAndLfoParameters * lfo
 
 
 
-void EnvelopeAndLfoParameters::LfoInstances::remove( EnvelopeAndLfoParameters * lfo )
+void LfoInstances::remove( EnvelopeAndLfoParameters * lfo )
 {
 	QMutexLocker m( &m_lfoListMutex );
 	m_lfos.removeAll( lfo );
@@ -88,10 +91,19 @@ void EnvelopeAndLfoParameters::LfoInstances::remove( EnvelopeAndLfoParameters *
 
 
 
+LfoInstances * EnvelopeAndLfoParameters::instances()
+{
+	return EngineContext::current()->lfoInstances();
+}
+
+
+
+
 EnvelopeAndLfoParameters::EnvelopeAndLfoParameters(
 					float _value_for_zero_amount,
 							Model * _parent ) :
 	Model( _parent ),
+	m_lfoInstances( instances() ),
 	m_used( false ),
 	m_predelayModel( 0.0, 0.0, 2.0, 0.001, this, tr( "Env pre-delay" ) ),
 	m_attackModel( 0.0, 0.0, 2.0, 0.001, this, tr( "Env attack" ) ),
@@ -118,17 +130,14 @@ EnvelopeAndLfoParameters::EnvelopeAndLfoParameters(
 	m_controlEnvAmountModel( false, this, tr( "Modulate env amount" ) ),
 	m_lfoFrame( 0 ),
 	m_lfoAmountIsZero( false ),
-	m_lfoShapeData( NULL )
+	m_lfoShapeData( NULL ),
+	m_sustainData( NULL ),
+	m_bad_sustainData( true )
 {
 	m_amountModel.setCenterValue( 0 );
 	m_lfoAmountModel.setCenterValue( 0 );
 
-	if( s_lfoInstances == NULL )
-	{
-		s_lfoInstances = new LfoInstances();
-	}
-
-	instances()->add( this );
+	m_lfoInstances->add( this );
 
 	connect( &m_predelayModel, SIGNAL( dataChanged() ),
 			this, SLOT( updateSampleVars() ), Qt::DirectConnection );
@@ -163,7 +172,9 @@ EnvelopeAndLfoParameters::EnvelopeAndLfoParameters(
 
 
 	m_lfoShapeData =
-		new sample_t[Engine::mixer()->framesPerPeriod()];
+		new sample_t[Mixer::maxFramesPerPeriod()];
+	m_sustainData =
+		new sample_t[Mixer::maxFramesPerPeriod()];
 
 	updateSampleVars();
 }
@@ -190,14 +201,9 @@ EnvelopeAndLfoParameters::~EnvelopeAndLfoParameters()
 	delete[] m_pahdEnv;
 	delete[] m_rEnv;
 	delete[] m_lfoShapeData;
+	delete[] m_sustainData;
 
-	instances()->remove( this );
-
-	if( instances()->isEmpty() )
-	{
-		delete instances();
-		s_lfoInstances = NULL;
-	}
+	m_lfoInstances->remove( this );
 }
 
 
@@ -254,6 +260,28 @@ void EnvelopeAndLfoParameters::updateLfoShapeData()
 
 
 
+void EnvelopeAndLfoParameters::updateSustainData()
+{
+	if( !m_lfoAmountIsZero && m_bad_lfoShapeData )
+	{
+		updateLfoShapeData();
+	}
+
+	const fpp_t frames = Engine::mixer()->framesPerPeriod();
+	const bool controlEnvAmount = m_controlEnvAmountModel.value();
+	for( fpp_t offset = 0; offset < frames; ++offset )
+	{
+		const float lfoLevel = m_lfoAmountIsZero ? 0.0f : m_lfoShapeData[offset];
+		m_sustainData[offset] = controlEnvAmount ?
+			m_sustainLevel * ( 0.5f + lfoLevel ) :
+			m_sustainLevel + lfoLevel;
+	}
+	m_bad_sustainData = false;
+}
+
+
+
+
 inline void EnvelopeAndLfoParameters::fillLfoLevel( float * _buf,
 							f_cnt_t _frame,
 							const fpp_t _frames )
@@ -300,37 +328,71 @@ void EnvelopeAndLfoParameters::fillLevel( float * _buf, f_cnt_t _frame,
 		return;
 	}
 
+	// all notes in their sustain with the LFO faded in get the same levels,
+	// which are computed only once per period
+	if( _frame >= m_pahdFrames && _frame + _frames <= _release_begin &&
+		( m_lfoAmountIsZero || ( _frame > m_lfoPredelayFrames &&
+			_frame - m_lfoPredelayFrames >= m_lfoAttackFrames ) ) &&
+		_frames <= Engine::mixer()->framesPerPeriod() )
+	{
+		if( m_bad_sustainData )
+		{
+			updateSustainData();
+		}
+		memcpy( _buf, m_sustainData, _frames * sizeof( float ) );
+		return;
+	}
+
 	fillLfoLevel( _buf, _frame, _frames );
 
-	for( fpp_t offset = 0; offset < _frames; ++offset, ++_buf, ++_frame )
+	// the envelope consists of spans (PAHD table, sustain, release table and
+	// silence) which are filled one after the other by branch-free loops
+	QVarLengthArray<float> env( _frames );
+	float * e = env.data();
+
+	const fpp_t beforeRelease = qBound<f_cnt_t>( 0, _release_begin - _frame, _frames );
+	const fpp_t pahd = qBound<f_cnt_t>( 0, m_pahdFrames - _frame, beforeRelease );
+	for( fpp_t offset = 0; offset < pahd; ++offset )
+	{
+		e[offset] = m_pahdEnv[_frame + offset];
+	}
+	for( fpp_t offset = pahd; offset < beforeRelease; ++offset )
 	{
-		float env_level;
-		if( _frame < _release_begin )
+		e[offset] = m_sustainLevel;
+	}
+
+	if( beforeRelease < _frames )
+	{
+		const f_cnt_t releaseFrame = _frame + beforeRelease - _release_begin;
+		const float releaseLevel = _release_begin < m_pahdFrames ?
+				m_pahdEnv[_release_begin] : m_sustainLevel;
+		const fpp_t release = qBound<f_cnt_t>( 0,
+				m_rFrames - releaseFrame, _frames - beforeRelease );
+		for( fpp_t offset = 0; offset < release; ++offset )
 		{
-			if( _frame < m_pahdFrames )
-			{
-				env_level = m_pahdEnv[_frame];
-			}
-			else
-			{
-				env_level = m_sustainLevel;
-			}
+			e[beforeRelease + offset] =
+				m_rEnv[releaseFrame + offset] * releaseLevel;
 		}
-		else if( ( _frame - _release_begin ) < m_rFrames )
+		for( fpp_t offset = beforeRelease + release; offset < _frames; ++offset )
+		{
+			e[offset] = 0.0f;
+		}
+	}
+
+	// at this point, _buf holds the LFO level
+	if( m_controlEnvAmountModel.value() )
+	{
+		for( fpp_t offset = 0; offset < _frames; ++offset )
 		{
-			env_level = m_rEnv[_frame - _release_begin] *
-				( ( _release_begin < m_pahdFrames ) ?
-				m_pahdEnv[_release_begin] : m_sustainLevel );
+			_buf[offset] = e[offset] * ( 0.5f + _buf[offset] );
 		}
-		else
+	}
+	else
+	{
+		for( fpp_t offset = 0; offset < _frames; ++offset )
 		{
-			env_level = 0.0f;
+			_buf[offset] = e[offset] + _buf[offset];
 		}
-
-		// at this point, *_buf is LFO level
-		*_buf = m_controlEnvAmountModel.value() ?
-			env_level * ( 0.5f + *_buf ) :
-			env_level + *_buf;
 	}
 }
 
@@ -530,6 +592,7 @@ void EnvelopeAndLfoParameters::updateSampleVars()
 	}
 
 	m_bad_lfoShapeData = true;
+	m_bad_sustainData = true;
 
 	emit dataChanged();
 
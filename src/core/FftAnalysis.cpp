@@ -0,0 +1,303 @@
+/*
+ * FftAnalysis.cpp - FFT plans, windows and threads shared by all analyzers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FftAnalysis.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+
+#include <algorithm>
+
+
+QMutex FftAnalysis::s_planMutex;
+std::map<std::pair<unsigned int, bool>, fftwf_plan> FftAnalysis::s_plans;
+std::map<unsigned int, fftwf_plan> FftAnalysis::s_inversePlans;
+bool FftAnalysis::s_wisdomLoaded = false;
+
+QMutex FftAnalysis::s_windowMutex;
+std::map<std::pair<std::pair<int, unsigned int>, bool>, std::vector<float>> FftAnalysis::s_windows;
+
+QMutex FftAnalysis::s_clientMutex;
+QWaitCondition FftAnalysis::s_clientDone;
+QWaitCondition FftAnalysis::s_wake;
+std::vector<FftAnalysis::Client *> FftAnalysis::s_clients;
+std::vector<QThread *> FftAnalysis::s_workers;
+int FftAnalysis::s_generation = 0;
+
+
+
+
+class FftAnalysis::Worker : public QThread
+{
+public:
+	Worker(int generation) :
+		m_generation(generation)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		workerLoop(m_generation);
+	}
+
+private:
+	const int m_generation;
+} ;
+
+
+
+
+namespace
+{
+
+QString wisdomPath()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/fftw-wisdom";
+}
+
+}
+
+
+
+
+void FftAnalysis::addClient(Client * client)
+{
+	QMutexLocker lock(&s_clientMutex);
+	s_clients.push_back(client);
+
+	if (s_workers.empty())
+	{
+		// analysis is light next to the mixer, a thread or two is plenty
+		const int count = qBound(1, QThread::idealThreadCount() - 1, 2);
+		for (int i = 0; i < count; ++i)
+		{
+			QThread * worker = new Worker(s_generation);
+			worker->start(QThread::LowPriority);
+			s_workers.push_back(worker);
+		}
+	}
+}
+
+
+
+
+void FftAnalysis::removeClient(Client * client)
+{
+	QMutexLocker lock(&s_clientMutex);
+	s_clients.erase(std::remove(s_clients.begin(), s_clients.end(), client),
+		s_clients.end());
+	while (client->m_running)
+	{
+		s_clientDone.wait(&s_clientMutex);
+	}
+
+	if (!s_clients.empty())
+	{
+		return;
+	}
+
+	// nothing left to analyze, don't keep idle threads around. Workers
+	// started by a client added meanwhile belong to the next generation.
+	std::vector<QThread *> workers;
+	workers.swap(s_workers);
+	++s_generation;
+	s_wake.wakeAll();
+	lock.unlock();
+
+	for (QThread * worker : workers)
+	{
+		worker->wait();
+		delete worker;
+	}
+}
+
+
+
+
+void FftAnalysis::workerLoop(int generation)
+{
+	QMutexLocker lock(&s_clientMutex);
+	while (generation == s_generation)
+	{
+		for (std::size_t i = 0; i < s_clients.size() && generation == s_generation; ++i)
+		{
+			Client * client = s_clients[i];
+			if (client->m_running ||
+				!client->m_pending.exchange(false, std::memory_order_acquire))
+			{
+				continue;
+			}
+
+			client->m_running = true;
+			lock.unlock();
+			client->analyze();
+			lock.relock();
+			client->m_running = false;
+			s_clientDone.wakeAll();
+		}
+
+		if (generation == s_generation)
+		{
+			s_wake.wait(&s_clientMutex, 1000 / FramesPerSecond);
+		}
+	}
+}
+
+
+
+
+void FftAnalysis::loadWisdom()
+{
+	if (!s_wisdomLoaded)
+	{
+		fftwf_import_wisdom_from_filename(QFile::encodeName(wisdomPath()).constData());
+		s_wisdomLoaded = true;
+	}
+}
+
+
+
+
+void FftAnalysis::saveWisdom()
+{
+	const QString path = wisdomPath();
+	if (QDir().mkpath(QFileInfo(path).absolutePath()))
+	{
+		fftwf_export_wisdom_to_filename(QFile::encodeName(path).constData());
+	}
+}
+
+
+
+
+fftwf_plan FftAnalysis::makePlan(unsigned int size, bool aligned)
+{
+	loadWisdom();
+
+	// FFTW_MEASURE overwrites the arrays, so plan on scratch buffers. Plans
+	// for unaligned data are made on deliberately misaligned ones.
+	float * in = fftwf_alloc_real(size + 1);
+	fftwf_complex * out = fftwf_alloc_complex(size / 2 + 2);
+	const unsigned flags = aligned ? FFTW_MEASURE : FFTW_MEASURE | FFTW_UNALIGNED;
+	fftwf_plan plan = fftwf_plan_dft_r2c_1d(size, aligned ? in : in + 1,
+		aligned ? out : reinterpret_cast<fftwf_complex *>(
+			reinterpret_cast<float *>(out) + 1), flags);
+	fftwf_free(in);
+	fftwf_free(out);
+
+	saveWisdom();
+	return plan;
+}
+
+
+
+
+fftwf_plan FftAnalysis::makeInversePlan(unsigned int size)
+{
+	loadWisdom();
+
+	float * out = fftwf_alloc_real(size);
+	fftwf_complex * in = fftwf_alloc_complex(size / 2 + 1);
+	fftwf_plan plan = fftwf_plan_dft_c2r_1d(size, in, out, FFTW_MEASURE);
+	fftwf_free(in);
+	fftwf_free(out);
+
+	saveWisdom();
+	return plan;
+}
+
+
+
+
+fftwf_plan FftAnalysis::plan(unsigned int size)
+{
+	QMutexLocker lock(&s_planMutex);
+	const auto key = std::make_pair(size, true);
+	auto it = s_plans.find(key);
+	if (it == s_plans.end())
+	{
+		it = s_plans.emplace(key, makePlan(size, true)).first;
+	}
+	return it->second;
+}
+
+
+
+
+fftwf_plan FftAnalysis::inversePlan(unsigned int size)
+{
+	QMutexLocker lock(&s_planMutex);
+	auto it = s_inversePlans.find(size);
+	if (it == s_inversePlans.end())
+	{
+		it = s_inversePlans.emplace(size, makeInversePlan(size)).first;
+	}
+	return it->second;
+}
+
+
+
+
+void FftAnalysis::execute(unsigned int size, float * in, fftwf_complex * out)
+{
+	const bool aligned = fftwf_alignment_of(in) == 0 &&
+		fftwf_alignment_of(reinterpret_cast<float *>(out)) == 0;
+
+	fftwf_plan p;
+	{
+		QMutexLocker lock(&s_planMutex);
+		const auto key = std::make_pair(size, aligned);
+		auto it = s_plans.find(key);
+		if (it == s_plans.end())
+		{
+			it = s_plans.emplace(key, makePlan(size, aligned)).first;
+		}
+		p = it->second;
+	}
+
+	// executing a plan is thread safe, only planning isn't
+	fftwf_execute_dft_r2c(p, in, out);
+}
+
+
+
+
+const float * FftAnalysis::window(FFT_WINDOWS type, unsigned int length, bool normalized)
+{
+	QMutexLocker lock(&s_windowMutex);
+	std::vector<float> & table =
+		s_windows[std::make_pair(std::make_pair(int(type), length), normalized)];
+	if (table.size() != length)
+	{
+		table.resize(length);
+		precomputeWindow(table.data(), length, type, normalized);
+	}
+	// the map never drops a table, so it stays where it is
+	return table.data();
+}
@@ -0,0 +1,301 @@
+/*
+ * FftConvolver.cpp - uniformly partitioned FFT convolution
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FftConvolver.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "FftAnalysis.h"
+
+
+namespace
+{
+
+// acc += a * b, on plain floats so the loop vectorizes
+inline void multiplyAdd(fftwf_complex * acc, const fftwf_complex * a,
+	const fftwf_complex * b, int bins)
+{
+	float * r = reinterpret_cast<float *>(acc);
+	const float * x = reinterpret_cast<const float *>(a);
+	const float * y = reinterpret_cast<const float *>(b);
+	for (int k = 0; k < 2 * bins; k += 2)
+	{
+		const float re = x[k] * y[k] - x[k + 1] * y[k + 1];
+		const float im = x[k] * y[k + 1] + x[k + 1] * y[k];
+		r[k] += re;
+		r[k + 1] += im;
+	}
+}
+
+}
+
+
+
+
+FftConvolver::FftConvolver() :
+	m_blockSize(0),
+	m_bins(0),
+	m_stride(0),
+	m_segmentCount(0),
+	m_forward(nullptr),
+	m_inverse(nullptr),
+	m_segments(nullptr),
+	m_segmentsIr(nullptr),
+	m_current(0),
+	m_preMultiplied(nullptr),
+	m_conv(nullptr),
+	m_fftBuffer(nullptr),
+	m_overlap(nullptr),
+	m_inputBuffer(nullptr),
+	m_inputFill(0),
+	m_responseChanged(false)
+{
+}
+
+
+
+
+FftConvolver::~FftConvolver()
+{
+	release();
+}
+
+
+
+
+void FftConvolver::init(fpp_t blockSize, const float * ir, f_cnt_t length)
+{
+	fpp_t size = 1;
+	while (size < blockSize)
+	{
+		size <<= 1;
+	}
+	allocate(size, length > 0 ? (length + size - 1) / size : 0);
+
+	const float scale = 1.0f / (2 * m_blockSize);
+	for (int s = 0; s < m_segmentCount; ++s)
+	{
+		const f_cnt_t offset = f_cnt_t(s) * m_blockSize;
+		const f_cnt_t count = qMin<f_cnt_t>(length - offset, m_blockSize);
+		for (f_cnt_t f = 0; f < count; ++f)
+		{
+			m_fftBuffer[f] = ir[offset + f] * scale;
+		}
+		std::fill(m_fftBuffer + count, m_fftBuffer + 2 * m_blockSize, 0.0f);
+		fftwf_execute_dft_r2c(m_forward, m_fftBuffer, m_segmentsIr + s * m_stride);
+	}
+	reset();
+}
+
+
+
+
+void FftConvolver::initSpectrum(fpp_t blockSize, int partitions)
+{
+	allocate(blockSize, partitions);
+	std::fill_n(reinterpret_cast<float *>(m_segmentsIr), 2 * m_stride * m_segmentCount, 0.0f);
+	reset();
+}
+
+
+
+
+void FftConvolver::transform(const float * ir, f_cnt_t length, fftwf_complex * spectra)
+{
+	for (int s = 0; s < m_segmentCount; ++s)
+	{
+		const f_cnt_t offset = f_cnt_t(s) * m_blockSize;
+		const f_cnt_t count = qBound<f_cnt_t>(0, length - offset, m_blockSize);
+		if (count > 0)
+		{
+			std::copy_n(ir + offset, count, m_fftBuffer);
+		}
+		std::fill(m_fftBuffer + count, m_fftBuffer + 2 * m_blockSize, 0.0f);
+		// m_conv is scratch between two calls of process()
+		fftwf_execute_dft_r2c(m_forward, m_fftBuffer, m_conv);
+		std::copy_n(reinterpret_cast<const float *>(m_conv), 2 * m_bins,
+			reinterpret_cast<float *>(spectra + s * m_bins));
+	}
+}
+
+
+
+
+void FftConvolver::setSpectrum(const fftwf_complex * spectra)
+{
+	const float scale = 1.0f / (2 * m_blockSize);
+	for (int s = 0; s < m_segmentCount; ++s)
+	{
+		const fftwf_complex * in = spectra + s * m_bins;
+		fftwf_complex * out = m_segmentsIr + s * m_stride;
+		for (int k = 0; k < m_bins; ++k)
+		{
+			out[k][0] = in[k][0] * scale;
+			out[k][1] = in[k][1] * scale;
+		}
+	}
+	// the products of the older blocks were made with the old response
+	m_responseChanged = true;
+}
+
+
+
+
+void FftConvolver::reset()
+{
+	if (m_segmentCount == 0)
+	{
+		return;
+	}
+	std::fill_n(reinterpret_cast<float *>(m_segments), 2 * m_stride * m_segmentCount, 0.0f);
+	std::fill_n(reinterpret_cast<float *>(m_preMultiplied), 2 * m_bins, 0.0f);
+	std::fill_n(m_overlap, m_blockSize, 0.0f);
+	std::fill_n(m_inputBuffer, m_blockSize, 0.0f);
+	m_current = 0;
+	m_inputFill = 0;
+}
+
+
+
+
+qint64 FftConvolver::memoryUsage() const
+{
+	if (m_segmentCount == 0)
+	{
+		return 0;
+	}
+	return (2 * static_cast<qint64>(m_stride) * m_segmentCount + 2 * m_bins) * sizeof(fftwf_complex)
+		+ 4 * static_cast<qint64>(m_blockSize) * sizeof(float);
+}
+
+
+
+
+void FftConvolver::process(const float * in, float * out, f_cnt_t frames)
+{
+	if (m_segmentCount == 0)
+	{
+		std::fill_n(out, frames, 0.0f);
+		return;
+	}
+
+	f_cnt_t processed = 0;
+	while (processed < frames)
+	{
+		const bool blockStarts = m_inputFill == 0;
+		const fpp_t pos = m_inputFill;
+		const fpp_t count = qMin<f_cnt_t>(frames - processed, m_blockSize - m_inputFill);
+
+		std::copy(in + processed, in + processed + count, m_inputBuffer + pos);
+
+		// transform the block as far as it's filled
+		std::copy(m_inputBuffer, m_inputBuffer + m_blockSize, m_fftBuffer);
+		std::fill(m_fftBuffer + m_blockSize, m_fftBuffer + 2 * m_blockSize, 0.0f);
+		fftwf_complex * segment = m_segments + m_current * m_stride;
+		fftwf_execute_dft_r2c(m_forward, m_fftBuffer, segment);
+
+		// the older blocks don't change until the next block starts
+		if (blockStarts || m_responseChanged)
+		{
+			m_responseChanged = false;
+			std::fill_n(reinterpret_cast<float *>(m_preMultiplied), 2 * m_bins, 0.0f);
+			for (int s = 1; s < m_segmentCount; ++s)
+			{
+				const int audio = (m_current + s) % m_segmentCount;
+				multiplyAdd(m_preMultiplied, m_segmentsIr + s * m_stride,
+					m_segments + audio * m_stride, m_bins);
+			}
+		}
+		std::copy_n(reinterpret_cast<const float *>(m_preMultiplied), 2 * m_bins,
+			reinterpret_cast<float *>(m_conv));
+		multiplyAdd(m_conv, segment, m_segmentsIr, m_bins);
+
+		fftwf_execute_dft_c2r(m_inverse, m_conv, m_fftBuffer);
+
+		for (fpp_t f = 0; f < count; ++f)
+		{
+			out[processed + f] = m_fftBuffer[pos + f] + m_overlap[pos + f];
+		}
+
+		m_inputFill += count;
+		if (m_inputFill == m_blockSize)
+		{
+			std::fill_n(m_inputBuffer, m_blockSize, 0.0f);
+			m_inputFill = 0;
+			std::copy(m_fftBuffer + m_blockSize, m_fftBuffer + 2 * m_blockSize, m_overlap);
+			m_current = m_current > 0 ? m_current - 1 : m_segmentCount - 1;
+		}
+		processed += count;
+	}
+}
+
+
+
+
+void FftConvolver::allocate(fpp_t blockSize, int segmentCount)
+{
+	release();
+	if (segmentCount == 0)
+	{
+		return;
+	}
+
+	m_blockSize = blockSize;
+	m_bins = blockSize + 1;
+	// 8 bins are 64 bytes, more than any SIMD FFTW uses needs
+	m_stride = (m_bins + 7) & ~7;
+	m_segmentCount = segmentCount;
+
+	m_forward = FftAnalysis::plan(2 * blockSize);
+	m_inverse = FftAnalysis::inversePlan(2 * blockSize);
+
+	m_segments = fftwf_alloc_complex(m_stride * segmentCount);
+	m_segmentsIr = fftwf_alloc_complex(m_stride * segmentCount);
+	m_preMultiplied = fftwf_alloc_complex(m_bins);
+	m_conv = fftwf_alloc_complex(m_bins);
+	m_fftBuffer = fftwf_alloc_real(2 * blockSize);
+	m_overlap = fftwf_alloc_real(blockSize);
+	m_inputBuffer = fftwf_alloc_real(blockSize);
+}
+
+
+
+
+void FftConvolver::release()
+{
+	if (m_segmentCount == 0)
+	{
+		return;
+	}
+	fftwf_free(m_segments);
+	fftwf_free(m_segmentsIr);
+	fftwf_free(m_preMultiplied);
+	fftwf_free(m_conv);
+	fftwf_free(m_fftBuffer);
+	fftwf_free(m_overlap);
+	fftwf_free(m_inputBuffer);
+	m_segmentCount = 0;
+	m_blockSize = 0;
+}
@@ -23,12 +23,14 @@
  */
 
 #include <QDomElement>
+#include <algorithm>
 
 #include "BufferManager.h"
 #include "FxMixer.h"
 #include "Mixer.h"
 #include "MixerWorkerThread.h"
 #include "MixHelpers.h"
+#include "RealtimeMemory.h"
 #include "Song.h"
 
 #include "InstrumentTrack.h"
@@ -36,6 +38,63 @@
 #include "BBTrackContainer.h"
 #include "TrackContainer.h" // For TrackContainer::TrackList typedef
 
+FxDelay::FxDelay() :
+	m_delay( 0 ),
+	m_position( 0 ),
+	m_pending( 0 )
+{
+}
+
+
+
+
+void FxDelay::reserve( f_cnt_t frames )
+{
+	if( frames > static_cast<f_cnt_t>( m_ring.size() ) )
+	{
+		// the delayed signal is moved along, the new frames are silent
+		m_ring.resize( frames );
+	}
+}
+
+
+
+
+void FxDelay::setDelay( f_cnt_t delay )
+{
+	delay = qMin( delay, static_cast<f_cnt_t>( m_ring.size() ) );
+	if( delay == m_delay )
+	{
+		return;
+	}
+	std::fill( m_ring.begin(), m_ring.begin() + delay, sampleFrame() );
+	m_delay = delay;
+	m_position = 0;
+	m_pending = 0;
+}
+
+
+
+
+void FxDelay::process( const sampleFrame * in, sampleFrame * out,
+					bool hasInput, fpp_t frames )
+{
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		const sampleFrame delayed = m_ring[m_position];
+		m_ring[m_position] = in[f];
+		out[f] = delayed;
+		if( ++m_position == m_delay )
+		{
+			m_position = 0;
+		}
+	}
+	m_pending = hasInput ? m_delay : qMax( 0, m_pending - frames );
+}
+
+
+
+
 FxRoute::FxRoute( FxChannel * from, FxChannel * to, float amount ) :
 	m_from( from ),
 	m_to( to ),
@@ -65,18 +124,24 @@ FxChannel::FxChannel( int idx, Model * _parent ) :
 	m_stillRunning( false ),
 	m_peakLeft( 0.0f ),
 	m_peakRight( 0.0f ),
-	m_buffer( new sampleFrame[Engine::mixer()->framesPerPeriod()] ),
+	m_buffer( static_cast<sampleFrame *>( RealtimeMemory::allocate(
+			Mixer::maxFramesPerPeriod() * sizeof( sampleFrame ) ) ) ),
 	m_muteModel( false, _parent ),
 	m_soloModel( false, _parent ),
 	m_volumeModel( 1.0, 0.0, 2.0, 0.001, _parent ),
 	m_name(),
 	m_lock(),
 	m_channelIndex( idx ),
-	m_queued( false ),
-	m_hasColor( false ),
-	m_dependenciesMet(0)
+	m_latency( 0 ),
+	m_muted( false ),
+	m_sleeping( true ),
+	m_hasColor( false )
 {
-	BufferManager::clear( m_buffer, Engine::mixer()->framesPerPeriod() );
+	BufferManager::clear( m_buffer, Mixer::maxFramesPerPeriod() );
+
+	// effects added or removed may change the latency of the channel
+	QObject::connect( &m_fxChain, SIGNAL( dataChanged() ),
+				_parent, SLOT( reserveDelays() ) );
 }
 
 
@@ -84,30 +149,10 @@ FxChannel::FxChannel( int idx, Model * _parent ) :
 
 FxChannel::~FxChannel()
 {
-	delete[] m_buffer;
-}
-
-
-inline void FxChannel::processed()
-{
-	for( const FxRoute * receiverRoute : m_sends )
-	{
-		if( receiverRoute->receiver()->m_muted == false )
-		{
-			receiverRoute->receiver()->incrementDeps();
-		}
-	}
+	RealtimeMemory::release( m_buffer,
+			Mixer::maxFramesPerPeriod() * sizeof( sampleFrame ) );
 }
 
-void FxChannel::incrementDeps()
-{
-	int i = m_dependenciesMet++ + 1;
-	if( i >= m_receives.size() && ! m_queued )
-	{
-		m_queued = true;
-		MixerWorkerThread::addJob( this );
-	}
-}
 
 void FxChannel::unmuteForSolo()
 {
@@ -119,24 +164,41 @@ void FxChannel::unmuteForSolo()
 
 void FxChannel::doProcessing()
 {
+	MixerProfiler::Probe probe( &m_processingTime );
 	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
 
 	if( m_muted == false )
 	{
+		if( m_inputDelay.delay() > 0 )
+		{
+			m_inputDelay.process( m_buffer, m_buffer, m_hasInput, fpp );
+			m_hasInput = m_inputDelay.isPending();
+		}
+
 		for( FxRoute * senderRoute : m_receives )
 		{
 			FxChannel * sender = senderRoute->sender();
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			const bool active = !sender->m_muted &&
+				( sender->m_hasInput || sender->m_stillRunning );
+			FxDelay & delay = senderRoute->delay();
+			sampleFrame * delayed = nullptr;
+			if( delay.delay() > 0 && ( active || delay.isPending() ) )
+			{
+				delayed = BufferManager::acquire();
+				delay.process( sender->m_buffer, delayed, active, fpp );
+			}
+
+			if( active || delayed )
 			{
 				// figure out if we're getting sample-exact input
 				ValueBuffer * sendBuf = sendModel->valueBuffer();
 				ValueBuffer * volBuf = sender->m_volumeModel.valueBuffer();
 
 				// mix it's output with this one's output
-				sampleFrame * ch_buf = sender->m_buffer;
+				sampleFrame * ch_buf = delayed ? delayed : sender->m_buffer;
 
 				// use sample-exact mixing if sample-exact values are available
 				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
@@ -160,6 +222,11 @@ void FxChannel::doProcessing()
 				}
 				m_hasInput = true;
 			}
+
+			if( delayed )
+			{
+				BufferManager::release( delayed );
+			}
 		}
 
 
@@ -171,19 +238,16 @@ void FxChannel::doProcessing()
 			m_fxChain.startRunning();
 		}
 
-		m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+		MixHelpers::BufferAnalysis analysis;
+		m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput, &analysis );
 
-		Mixer::StereoSample peakSamples = Engine::mixer()->getPeakValues(m_buffer, fpp);
-		m_peakLeft = qMax( m_peakLeft, peakSamples.left * v );
-		m_peakRight = qMax( m_peakRight, peakSamples.right * v );
+		m_peakLeft = qMax( m_peakLeft, analysis.peakLeft * v );
+		m_peakRight = qMax( m_peakRight, analysis.peakRight * v );
 	}
 	else
 	{
 		m_peakLeft = m_peakRight = 0.0f;
 	}
-
-	// increment dependency counter of all receivers
-	processed();
 }
 
 
@@ -191,11 +255,15 @@ void FxChannel::doProcessing()
 FxMixer::FxMixer() :
 	Model( NULL ),
 	JournallingObject(),
-	m_fxChannels()
+	m_fxChannels(),
+	m_scheduleDirty( true )
 {
 	// create master channel
 	createChannel();
 	m_lastSoloed = -1;
+
+	connect( Engine::mixer(), SIGNAL( sampleRateChanged() ),
+				this, SLOT( reserveDelays() ) );
 }
 
 
@@ -220,7 +288,11 @@ int FxMixer::createChannel()
 {
 	const int index = m_fxChannels.size();
 	// create new channel
+	Engine::mixer()->requestChangeInModel();
 	m_fxChannels.push_back( new FxChannel( index, this ) );
+	m_meters.resize( m_fxChannels.size() );
+	invalidateSchedule();
+	Engine::mixer()->doneChangeInModel();
 
 	// reset channel state
 	clearChannel( index );
@@ -346,6 +418,8 @@ void FxMixer::deleteChannel( int index )
 	// actually delete the channel
 	m_fxChannels.remove(index);
 	delete ch;
+	m_meters.resize( m_fxChannels.size() );
+	invalidateSchedule();
 
 	for( int i = index; i < m_fxChannels.size(); ++i )
 	{
@@ -480,6 +554,8 @@ FxRoute * FxMixer::createRoute( FxChannel * from, FxChannel * to, float amount )
 
 	// add us to fxmixer's list
 	Engine::fxMixer()->m_fxRoutes.append( route );
+	Engine::fxMixer()->invalidateSchedule();
+	Engine::fxMixer()->reserveDelays();
 	Engine::mixer()->doneChangeInModel();
 
 	return route;
@@ -514,6 +590,7 @@ void FxMixer::deleteChannelSend( FxRoute * route )
 	route->receiver()->m_receives.remove( route->receiver()->m_receives.indexOf( route ) );
 	// remove us from fxmixer's list
 	Engine::fxMixer()->m_fxRoutes.remove( Engine::fxMixer()->m_fxRoutes.indexOf( route ) );
+	Engine::fxMixer()->invalidateSchedule();
 	delete route;
 	Engine::mixer()->doneChangeInModel();
 }
@@ -529,6 +606,33 @@ bool FxMixer::isInfiniteLoop( fx_ch_t sendFrom, fx_ch_t sendTo )
 }
 
 
+bool FxMixer::isChannelAudible( fx_ch_t channel ) const
+{
+	if( channel < 0 || channel >= m_fxChannels.size() )
+	{
+		return false;
+	}
+	const FxChannel * ch = m_fxChannels[channel];
+	if( ch->m_muteModel.value() && !ch->m_muteModel.isAutomatedOrControlled() )
+	{
+		// muted channels don't even run their effects
+		return false;
+	}
+	if( channel == 0 || ch->m_fxChain.drivesControllers() )
+	{
+		return true;
+	}
+	for( const FxRoute * route : ch->m_sends )
+	{
+		if( isChannelAudible( route->receiverIndex() ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
 bool FxMixer::checkInfiniteLoop( FxChannel * from, FxChannel * to )
 {
 	// can't send master to anything
@@ -596,56 +700,80 @@ void FxMixer::mixToChannel( const sampleFrame * _buf, fx_ch_t _ch )
 
 void FxMixer::prepareMasterMix()
 {
+	if( m_fxChannels[0]->m_sleeping )
+	{
+		// still clear from the last period it was awake
+		return;
+	}
 	BufferManager::clear( m_fxChannels[0]->m_buffer,
 					Engine::mixer()->framesPerPeriod() );
 }
 
 
 
-void FxMixer::masterMix( sampleFrame * _buf )
+void FxMixer::masterMix( sampleFrame * _buf, bool useWorkerThreads )
 {
 	const int fpp = Engine::mixer()->framesPerPeriod();
 
-	// add the channels that have no dependencies (no incoming senders, ie.
-	// no receives) to the jobqueue. The channels that have receives get
-	// added when their senders get processed, which is detected by
-	// dependency counting.
-	// also instantly add all muted channels as they don't need to care
-	// about their senders, and can just increment the deps of their
-	// recipients right away.
-	MixerWorkerThread::resetJobQueue( MixerWorkerThread::JobQueue::Dynamic );
+	// pick up mute changes (this includes soloing). Muted channels are left
+	// out of the schedule altogether.
 	for( FxChannel * ch : m_fxChannels )
 	{
-		ch->m_muted = ch->m_muteModel.value();
-		if( ch->m_muted ) // instantly "process" muted channels
+		const bool muted = ch->m_muteModel.value();
+		if( muted != ch->m_muted )
 		{
-			ch->processed();
-			ch->done();
+			ch->m_muted = muted;
+			invalidateSchedule();
 		}
-		else if( ch->m_receives.size() == 0 )
+		if( muted )
 		{
-			ch->m_queued = true;
-			MixerWorkerThread::addJob( ch );
+			// nothing is mixed into muted channels, so they're sleeping
+			ch->m_peakLeft = ch->m_peakRight = 0.0f;
+			if( !ch->m_sleeping )
+			{
+				// there might be input from before it got muted
+				BufferManager::clear( ch->m_buffer, fpp );
+				ch->m_sleeping = true;
+			}
 		}
 	}
-	while (m_fxChannels[0]->state() != ThreadableJob::ProcessingState::Done)
+
+	if( m_scheduleDirty )
+	{
+		buildSchedule();
+	}
+	updateLatencies();
+
+	// process the channels level by level. All senders of a channel are
+	// in previous levels, so the channels of one level can be processed
+	// in parallel. Sleeping channels are skipped, which propagates along
+	// the routes as the senders have already been looked at.
+	for( const FxChannelVector & level : m_schedule )
 	{
-		bool found = false;
-		for( FxChannel * ch : m_fxChannels )
+		m_awakeChannels.clear();
+		for( FxChannel * ch : level )
 		{
-			const auto s = ch->state();
-			if (s == ThreadableJob::ProcessingState::Queued
-				|| s == ThreadableJob::ProcessingState::InProgress)
+			ch->m_sleeping = !isAwake( ch );
+			if( !ch->m_sleeping )
 			{
-				found = true;
-				break;
+				m_awakeChannels.push_back( ch );
 			}
 		}
-		if( !found )
+
+		if( m_awakeChannels.size() <= 1 || !useWorkerThreads )
 		{
-			break;
+			// not worth waking up the worker threads
+			for( FxChannel * ch : m_awakeChannels )
+			{
+				ch->queue();
+				ch->process();
+			}
+		}
+		else
+		{
+			MixerWorkerThread::fillJobQueue<FxChannelVector>( m_awakeChannels );
+			MixerWorkerThread::startAndWaitForJobs();
 		}
-		MixerWorkerThread::startAndWaitForJobs();
 	}
 
 	// handle sample-exact data in master volume fader
@@ -663,25 +791,206 @@ void FxMixer::masterMix( sampleFrame * _buf )
 	const float v = volBuf
 		? 1.0f
 		: m_fxChannels[0]->m_volumeModel.value();
-	MixHelpers::addSanitizedMultiplied( _buf, m_fxChannels[0]->m_buffer, v, fpp );
+	if( !m_fxChannels[0]->m_sleeping )
+	{
+		MixHelpers::addSanitizedMultiplied( _buf, m_fxChannels[0]->m_buffer, v, fpp );
+	}
+
+	// hand the peaks of this period to the GUI
+	m_meters.beginWrite();
+	for( int i = 0; i < numChannels(); ++i )
+	{
+		FxChannel * ch = m_fxChannels[i];
+		const float gain = i == 0 ? Engine::mixer()->masterGain() : 1.0f;
+		m_meters.write( i, ch->m_peakLeft * gain, ch->m_peakRight * gain,
+							ch->m_sleeping );
+		ch->m_peakLeft = ch->m_peakRight = 0.0f;
+	}
+	m_meters.publish();
 
 	// clear all channel buffers and
 	// reset channel process state
 	for( int i = 0; i < numChannels(); ++i)
 	{
-		BufferManager::clear( m_fxChannels[i]->m_buffer,
-				Engine::mixer()->framesPerPeriod() );
+		// buffers of sleeping channels have been cleared before
+		if( !m_fxChannels[i]->m_sleeping )
+		{
+			BufferManager::clear( m_fxChannels[i]->m_buffer,
+					Engine::mixer()->framesPerPeriod() );
+		}
 		m_fxChannels[i]->reset();
-		m_fxChannels[i]->m_queued = false;
 		// also reset hasInput
 		m_fxChannels[i]->m_hasInput = false;
-		m_fxChannels[i]->m_dependenciesMet = 0;
 	}
 }
 
 
 
 
+bool FxMixer::isAwake( const FxChannel * ch )
+{
+	if( ch->m_hasInput || ch->m_stillRunning || ch->m_inputDelay.isPending() )
+	{
+		return true;
+	}
+	for( const FxRoute * route : ch->m_receives )
+	{
+		if( !route->sender()->m_sleeping || route->delay().isPending() )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+void FxMixer::updateLatencies()
+{
+	// the senders of a channel come before it, so their latencies are
+	// known when it's looked at
+	for( FxChannel * ch : m_routeOrder )
+	{
+		f_cnt_t latest = 0;
+		for( const FxRoute * route : ch->m_receives )
+		{
+			latest = qMax( latest, route->sender()->m_latency );
+		}
+
+		// no costs unless there are effects with latency
+		for( FxRoute * route : ch->m_receives )
+		{
+			route->delay().setDelay( latest - route->sender()->m_latency );
+		}
+		ch->m_inputDelay.setDelay( latest );
+		ch->m_latency = latest + ch->m_fxChain.latency();
+	}
+}
+
+
+
+
+void FxMixer::reserveDelays()
+{
+	Engine::mixer()->requestChangeInModel();
+
+	// what updateLatencies() will come up with. Twice that leaves room
+	// for effects raising their latency while playing.
+	QVector<f_cnt_t> latencies( m_fxChannels.size(), 0 );
+	for( FxChannel * ch : sortByRoutes() )
+	{
+		f_cnt_t latest = 0;
+		for( const FxRoute * route : ch->m_receives )
+		{
+			latest = qMax( latest,
+				latencies[route->sender()->m_channelIndex] );
+		}
+		for( FxRoute * route : ch->m_receives )
+		{
+			route->delay().reserve( 2 * ( latest -
+				latencies[route->sender()->m_channelIndex] ) );
+		}
+		ch->m_inputDelay.reserve( 2 * latest );
+		latencies[ch->m_channelIndex] = latest + ch->m_fxChain.latency();
+	}
+
+	Engine::mixer()->doneChangeInModel();
+}
+
+
+
+
+FxChannelVector FxMixer::sortByRoutes() const
+{
+	FxChannelVector order;
+	order.reserve( m_fxChannels.size() );
+
+	// number of senders each channel still waits for
+	QVector<int> pendingSenders( m_fxChannels.size(), 0 );
+	for( FxChannel * ch : m_fxChannels )
+	{
+		pendingSenders[ch->m_channelIndex] = ch->m_receives.size();
+		if( ch->m_receives.isEmpty() )
+		{
+			order.push_back( ch );
+		}
+	}
+
+	// the routing graph is acyclic, so every channel gets in there
+	for( int i = 0; i < order.size(); ++i )
+	{
+		for( const FxRoute * route : order[i]->m_sends )
+		{
+			FxChannel * receiver = route->receiver();
+			if( --pendingSenders[receiver->m_channelIndex] == 0 )
+			{
+				order.push_back( receiver );
+			}
+		}
+	}
+
+	return order;
+}
+
+
+
+
+void FxMixer::buildSchedule()
+{
+	m_schedule.clear();
+
+	// number of unmuted senders each channel still waits for
+	QVector<int> pendingSenders( m_fxChannels.size(), 0 );
+	FxChannelVector level;
+
+	for( FxChannel * ch : m_fxChannels )
+	{
+		if( ch->m_muted )
+		{
+			continue;
+		}
+		for( const FxRoute * route : ch->m_receives )
+		{
+			if( route->sender()->m_muted == false )
+			{
+				++pendingSenders[ch->m_channelIndex];
+			}
+		}
+		if( pendingSenders[ch->m_channelIndex] == 0 )
+		{
+			level.push_back( ch );
+		}
+	}
+
+	// the routing graph is acyclic (see checkInfiniteLoop()), so this
+	// terminates with every unmuted channel scheduled exactly once
+	while( !level.isEmpty() )
+	{
+		FxChannelVector nextLevel;
+		for( const FxChannel * ch : level )
+		{
+			for( const FxRoute * route : ch->m_sends )
+			{
+				FxChannel * receiver = route->receiver();
+				if( receiver->m_muted == false &&
+					--pendingSenders[receiver->m_channelIndex] == 0 )
+				{
+					nextLevel.push_back( receiver );
+				}
+			}
+		}
+		m_schedule.push_back( level );
+		level = nextLevel;
+	}
+
+	m_routeOrder = sortByRoutes();
+	m_scheduleDirty = false;
+}
+
+
+
+
 void FxMixer::clear()
 {
 	while( m_fxChannels.size() > 1 )
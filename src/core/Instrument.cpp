@@ -176,22 +176,38 @@ void Instrument::applyFadeIn(sampleFrame * buf, NotePlayHandle * n)
 void Instrument::applyRelease( sampleFrame * buf, const NotePlayHandle * _n )
 {
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
+	for( fpp_t f = releaseBegin( _n ); f < frames; ++f )
+	{
+		const float fac = releaseLevel( _n, f );
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			buf[f][ch] *= fac;
+		}
+	}
+}
+
+
+
+
+fpp_t Instrument::releaseBegin( const NotePlayHandle * _n ) const
+{
 	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
 	const f_cnt_t fl = _n->framesLeft();
 	if( fl <= desiredReleaseFrames()+fpp )
 	{
-		for( fpp_t f = (fpp_t)( ( fl > desiredReleaseFrames() ) ?
+		return (fpp_t)( ( fl > desiredReleaseFrames() ) ?
 				( qMax( fpp - desiredReleaseFrames(), 0 ) +
-					fl % fpp ) : 0 ); f < frames; ++f )
-		{
-			const float fac = (float)( fl-f-1 ) /
-							desiredReleaseFrames();
-			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
-			{
-				buf[f][ch] *= fac;
-			}
-		}
+					fl % fpp ) : 0 );
 	}
+	return fpp;
+}
+
+
+
+
+float Instrument::releaseLevel( const NotePlayHandle * _n, fpp_t _frame ) const
+{
+	return (float)( _n->framesLeft()-_frame-1 ) / desiredReleaseFrames();
 }
 
 
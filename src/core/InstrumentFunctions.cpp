@@ -228,7 +228,6 @@ InstrumentFunctionNoteStacking::~InstrumentFunctionNoteStacking()
 void InstrumentFunctionNoteStacking::processNote( NotePlayHandle * _n )
 {
 	const int base_note_key = _n->key();
-	const ChordTable & chord_table = ChordTable::getInstance();
 	// we add chord-subnotes to note if either note is a base-note and
 	// arpeggio is not used or note is part of an arpeggio
 	// at the same time we only add sub-notes if nothing of the note was
@@ -239,17 +238,18 @@ void InstrumentFunctionNoteStacking::processNote( NotePlayHandle * _n )
 			m_chordsEnabledModel.value() == true && ! _n->isReleased() )
 	{
 		// then insert sub-notes for chord
-		const int selected_chord = m_chordsModel.value();
+		const Chord & chord = ChordTable::getInstance()[m_chordsModel.value()];
+		const int chord_size = chord.size();
 
 		for( int octave_cnt = 0; octave_cnt < m_chordRangeModel.value(); ++octave_cnt )
 		{
 			const int sub_note_key_base = base_note_key + octave_cnt * KeysPerOctave;
 
 			// process all notes in the chord
-			for( int i = 0; i < chord_table[selected_chord].size(); ++i )
+			for( int i = 0; i < chord_size; ++i )
 			{
 				// add interval to sub-note-key
-				const int sub_note_key = sub_note_key_base + (int) chord_table[selected_chord][i];
+				const int sub_note_key = sub_note_key_base + (int) chord[i];
 				// maybe we're out of range -> let's get outta
 				// here!
 				if( sub_note_key > NumKeys )
@@ -354,24 +354,25 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 
 	const int selected_arp = m_arpModel.value();
 
-	ConstNotePlayHandleList cnphv = NotePlayHandle::nphsOfInstrumentTrack( _n->instrumentTrack() );
+	// the notes of the track are collected by the mixer once per period,
+	// so there's no need to look through all play handles here
+	const std::vector<const NotePlayHandle *> & active_notes = _n->instrumentTrack()->activeNotes();
+	const NotePlayHandle * first_note = active_notes.empty() ? _n : active_notes.front();
+	int note_count = active_notes.size();
 
-	if( m_arpModeModel.value() != FreeMode && cnphv.size() == 0 )
+	if( m_arpModeModel.value() != FreeMode && note_count == 0 )
 	{
 		// maybe we're playing only a preset-preview-note?
-		cnphv = PresetPreviewPlayHandle::nphsOfInstrumentTrack( _n->instrumentTrack() );
-		if( cnphv.size() == 0 )
-		{
-			// still nothing found here, so lets return
-			//return;
-			cnphv.push_back( _n );
-		}
+		const ConstNotePlayHandleList preview_notes = PresetPreviewPlayHandle::nphsOfInstrumentTrack( _n->instrumentTrack() );
+		// if still nothing is found, the note is on its own
+		first_note = preview_notes.isEmpty() ? _n : preview_notes.first();
+		note_count = qMax( preview_notes.size(), 1 );
 	}
 
-	const InstrumentFunctionNoteStacking::ChordTable & chord_table = InstrumentFunctionNoteStacking::ChordTable::getInstance();
-	const int cur_chord_size = chord_table[selected_arp].size();
+	const InstrumentFunctionNoteStacking::Chord & chord = InstrumentFunctionNoteStacking::ChordTable::getInstance()[selected_arp];
+	const int cur_chord_size = chord.size();
 	const int range = static_cast<int>(cur_chord_size * m_arpRangeModel.value() * m_arpRepeatsModel.value());
-	const int total_range = range * cnphv.size();
+	const int total_range = range * note_count;
 
 	// number of frames that every note should be played
 	const f_cnt_t arp_frames = (f_cnt_t)( m_arpTimeModel.value() / 1000.0f * Engine::mixer()->processingSampleRate() );
@@ -381,10 +382,10 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 	// arp_frames-1, otherwise the first arp-note will not be setup
 	// correctly... -> arp_frames frames silence at the start of every note!
 	int cur_frame = ( ( m_arpModeModel.value() != FreeMode ) ?
-						cnphv.first()->totalFramesPlayed() :
+						first_note->totalFramesPlayed() :
 						_n->totalFramesPlayed() ) + arp_frames - 1;
 	// used for loop
-	f_cnt_t frames_processed = ( m_arpModeModel.value() != FreeMode ) ? cnphv.first()->noteOffset() : _n->noteOffset();
+	f_cnt_t frames_processed = ( m_arpModeModel.value() != FreeMode ) ? first_note->noteOffset() : _n->noteOffset();
 
 	while( frames_processed < Engine::mixer()->framesPerPeriod() )
 	{
@@ -492,7 +493,7 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 
 		// now calculate final key for our arp-note
 		const int sub_note_key = base_note_key + (cur_arp_idx / cur_chord_size ) *
-							KeysPerOctave + chord_table[selected_arp][cur_arp_idx % cur_chord_size];
+							KeysPerOctave + chord[cur_arp_idx % cur_chord_size];
 
 		// range-checking
 		if( sub_note_key >= NumKeys ||
@@ -32,3 +32,39 @@ InstrumentPlayHandle::InstrumentPlayHandle( Instrument * instrument, InstrumentT
 {
 	setAudioPort( instrumentTrack->audioPort() );
 }
+
+
+
+
+void InstrumentPlayHandle::play( sampleFrame * _working_buffer )
+{
+	// a frozen track plays its rendering instead, and one that can't be
+	// heard in an export doesn't run its instrument, or remote process
+	if( m_instrument->instrumentTrack()->playsFrozen() ||
+		m_instrument->instrumentTrack()->isBypassed() )
+	{
+		return;
+	}
+
+	// ensure that all our nph's have been processed first
+	ConstNotePlayHandleList nphv = NotePlayHandle::nphsOfInstrumentTrack( m_instrument->instrumentTrack(), true );
+	
+	bool nphsLeft;
+	do
+	{
+		nphsLeft = false;
+		for( const NotePlayHandle * constNotePlayHandle : nphv )
+		{
+			NotePlayHandle * notePlayHandle = const_cast<NotePlayHandle *>( constNotePlayHandle );
+			if( notePlayHandle->state() != ThreadableJob::ProcessingState::Done &&
+				!notePlayHandle->isFinished())
+			{
+				nphsLeft = true;
+				notePlayHandle->process();
+			}
+		}
+	}
+	while( nphsLeft );
+	
+	m_instrument->play( _working_buffer );
+}
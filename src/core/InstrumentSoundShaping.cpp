@@ -26,6 +26,7 @@
 #include <QDomElement>
 
 #include "InstrumentSoundShaping.h"
+#include "BasicFilterBatch.h"
 #include "BasicFilters.h"
 #include "embed.h"
 #include "Engine.h"
@@ -129,18 +130,29 @@ float InstrumentSoundShaping::volumeLevel( NotePlayHandle* n, const f_cnt_t fram
 
 
 
-void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
-							const fpp_t frames,
-							NotePlayHandle* n )
+void InstrumentSoundShaping::envelopeFrames( NotePlayHandle * n, const fpp_t frames,
+				f_cnt_t * total, f_cnt_t * releaseBegin ) const
 {
-	const f_cnt_t envTotalFrames = n->totalFramesPlayed();
-	f_cnt_t envReleaseBegin = envTotalFrames - n->releaseFramesDone() + n->framesBeforeRelease();
+	*total = n->totalFramesPlayed();
+	*releaseBegin = *total - n->releaseFramesDone() + n->framesBeforeRelease();
 
 	if( !n->isReleased() || ( n->instrumentTrack()->isSustainPedalPressed() &&
 		!n->isReleaseStarted() ) )
 	{
-		envReleaseBegin += frames;
+		*releaseBegin += frames;
 	}
+}
+
+
+
+
+void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
+							const fpp_t frames,
+							NotePlayHandle* n )
+{
+	f_cnt_t envTotalFrames;
+	f_cnt_t envReleaseBegin;
+	envelopeFrames( n, frames, &envTotalFrames, &envReleaseBegin );
 
 	// because of optimizations, there's special code for several cases:
 	// 	- cut- and res-lfo/envelope active
@@ -175,6 +187,10 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 
 		const float fcv = m_filterCutModel.value();
 		const float frv = m_filterResModel.value();
+		// setting the coefficients is the expensive part, so they
+		// are only updated every few frames unless rendering the
+		// final mix
+		const int interval = Engine::mixer()->currentQualitySettings().controlInterval;
 
 		if( m_envLfoParameters[Cut]->isUsed() &&
 			m_envLfoParameters[Resonance]->isUsed() )
@@ -186,8 +202,9 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 
 				const float new_res_val = frv + RES_MULTIPLIER * resBuffer[frame];
 
-				if( static_cast<int>( new_cut_val ) != old_filter_cut ||
-					static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
+				if( frame % interval == 0 &&
+					( static_cast<int>( new_cut_val ) != old_filter_cut ||
+					static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res ) )
 				{
 					n->m_filter->calcFilterCoeffs( new_cut_val, new_res_val );
 					old_filter_cut = static_cast<int>( new_cut_val );
@@ -205,7 +222,8 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 				float new_cut_val = EnvelopeAndLfoParameters::expKnobVal( cutBuffer[frame] ) *
 								CUT_FREQ_MULTIPLIER + fcv;
 
-				if( static_cast<int>( new_cut_val ) != old_filter_cut )
+				if( frame % interval == 0 &&
+					static_cast<int>( new_cut_val ) != old_filter_cut )
 				{
 					n->m_filter->calcFilterCoeffs( new_cut_val, frv );
 					old_filter_cut = static_cast<int>( new_cut_val );
@@ -221,7 +239,8 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 			{
 				float new_res_val = frv + RES_MULTIPLIER * resBuffer[frame];
 
-				if( static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
+				if( frame % interval == 0 &&
+					static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
 				{
 					n->m_filter->calcFilterCoeffs( fcv, new_res_val );
 					old_filter_res = static_cast<int>( new_res_val*RES_PRECISION );
@@ -243,6 +262,29 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 		}
 	}
 
+	applyVolumeEnvelope( buffer, frames, envTotalFrames, envReleaseBegin );
+
+/*	else if( m_envLfoParameters[Volume]->isUsed() == false && m_envLfoParameters[PANNING]->isUsed() )
+	{
+		// only use panning-envelope...
+		for( fpp_t frame = 0; frame < frames; ++frame )
+		{
+			float vol_level = pan_buf[frame];
+			vol_level = vol_level*vol_level;
+			for( ch_cnt_t chnl = 0; chnl < DEFAULT_CHANNELS; ++chnl )
+			{
+				buffer[frame][chnl] = vol_level * buffer[frame][chnl];
+			}
+		}
+	}*/
+}
+
+
+
+
+void InstrumentSoundShaping::applyVolumeEnvelope( sampleFrame * buffer, const fpp_t frames,
+			const f_cnt_t envTotalFrames, const f_cnt_t envReleaseBegin )
+{
 	if( m_envLfoParameters[Volume]->isUsed() )
 	{
 		QVarLengthArray<float> volBuffer(frames);
@@ -256,20 +298,163 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 			buffer[frame][1] = vol_level * buffer[frame][1];
 		}
 	}
+}
 
-/*	else if( m_envLfoParameters[Volume]->isUsed() == false && m_envLfoParameters[PANNING]->isUsed() )
+
+
+
+bool InstrumentSoundShaping::shapesNotes() const
+{
+	// the cut and resonance envelopes only take effect through the filter
+	return m_filterEnabledModel.value() ||
+		m_envLfoParameters[Volume]->isUsed();
+}
+
+
+
+
+bool InstrumentSoundShaping::filterBatchable() const
+{
+	return m_filterEnabledModel.value() &&
+		BasicFilterBatch::supports( m_filterModel.value() );
+}
+
+
+
+
+void InstrumentSoundShaping::scheduleNote( NotePlayHandle * n, const f_cnt_t offset,
+							const fpp_t frames )
+{
+	NotePlayHandle::ScheduledShaping & s = n->m_scheduledShaping;
+	s.pending = true;
+	s.offset = offset;
+	s.frames = frames;
+	envelopeFrames( n, frames, &s.envTotalFrames, &s.envReleaseBegin );
+}
+
+
+
+
+void InstrumentSoundShaping::processNotes( NotePlayHandle * const * notes, int count )
+{
+	for( int i = 0; i < count; i += BasicFilterBatch::MaxVoices )
 	{
-		// only use panning-envelope...
-		for( fpp_t frame = 0; frame < frames; ++frame )
+		const int voices = qMin( count - i, int( BasicFilterBatch::MaxVoices ) );
+		// the filter settings may have changed since the notes were
+		// scheduled, they are picked up in the next period then
+		if( filterBatchable() )
 		{
-			float vol_level = pan_buf[frame];
-			vol_level = vol_level*vol_level;
-			for( ch_cnt_t chnl = 0; chnl < DEFAULT_CHANNELS; ++chnl )
+			filterNotes( notes + i, voices );
+		}
+		for( int v = i; v < i + voices; ++v )
+		{
+			const NotePlayHandle::ScheduledShaping & s = notes[v]->m_scheduledShaping;
+			applyVolumeEnvelope( notes[v]->buffer() + s.offset, s.frames,
+						s.envTotalFrames, s.envReleaseBegin );
+		}
+	}
+}
+
+
+
+
+void InstrumentSoundShaping::filterNotes( NotePlayHandle * const * notes, int count )
+{
+	const bool cutUsed = m_envLfoParameters[Cut]->isUsed();
+	const bool resUsed = m_envLfoParameters[Resonance]->isUsed();
+	const float fcv = m_filterCutModel.value();
+	const float frv = m_filterResModel.value();
+	const int interval = Engine::mixer()->currentQualitySettings().controlInterval;
+
+	BasicFilters<> * filters[BasicFilterBatch::MaxVoices];
+	QVarLengthArray<float> cutBuffers[BasicFilterBatch::MaxVoices];
+	QVarLengthArray<float> resBuffers[BasicFilterBatch::MaxVoices];
+	int oldCut[BasicFilterBatch::MaxVoices];
+	int oldRes[BasicFilterBatch::MaxVoices];
+	f_cnt_t end = 0;
+
+	for( int v = 0; v < count; ++v )
+	{
+		NotePlayHandle * n = notes[v];
+		const NotePlayHandle::ScheduledShaping & s = n->m_scheduledShaping;
+		if( n->m_filter == nullptr )
+		{
+			n->m_filter = std::make_unique<BasicFilters<>>( Engine::mixer()->processingSampleRate() );
+		}
+		n->m_filter->setFilterType( m_filterModel.value() );
+		filters[v] = n->m_filter.get();
+
+		if( cutUsed )
+		{
+			cutBuffers[v].resize( s.frames );
+			m_envLfoParameters[Cut]->fillLevel( cutBuffers[v].data(), s.envTotalFrames, s.envReleaseBegin, s.frames );
+		}
+		if( resUsed )
+		{
+			resBuffers[v].resize( s.frames );
+			m_envLfoParameters[Resonance]->fillLevel( resBuffers[v].data(), s.envTotalFrames, s.envReleaseBegin, s.frames );
+		}
+		if( !cutUsed && !resUsed )
+		{
+			filters[v]->calcFilterCoeffs( fcv, frv );
+		}
+		oldCut[v] = 0;
+		oldRes[v] = 0;
+		end = qMax<f_cnt_t>( end, s.offset + s.frames );
+	}
+
+	// the notes' buffers are aligned to the period, frames outside of
+	// [offset, offset + frames) of a note are left alone
+	BasicFilterBatch batch( filters, count );
+	for( f_cnt_t f = 0; f < end; ++f )
+	{
+		float io[BasicFilterBatch::Lanes] = { };
+		for( int v = 0; v < count; ++v )
+		{
+			const NotePlayHandle::ScheduledShaping & s = notes[v]->m_scheduledShaping;
+			const f_cnt_t frame = f - s.offset;
+			const bool active = frame >= 0 && frame < s.frames;
+			batch.setActive( v, active );
+			if( !active )
 			{
-				buffer[frame][chnl] = vol_level * buffer[frame][chnl];
+				continue;
 			}
+			if( ( cutUsed || resUsed ) && frame % interval == 0 )
+			{
+				// same updates as in processAudioBuffer()
+				const float cut = cutUsed
+					? EnvelopeAndLfoParameters::expKnobVal( cutBuffers[v][frame] ) *
+								CUT_FREQ_MULTIPLIER + fcv
+					: fcv;
+				const float res = resUsed ? frv + RES_MULTIPLIER * resBuffers[v][frame] : frv;
+				if( ( cutUsed && static_cast<int>( cut ) != oldCut[v] ) ||
+					( resUsed && static_cast<int>( res*RES_PRECISION ) != oldRes[v] ) )
+				{
+					filters[v]->calcFilterCoeffs( cut, res );
+					batch.loadCoeffs( v );
+					oldCut[v] = static_cast<int>( cut );
+					oldRes[v] = static_cast<int>( res*RES_PRECISION );
+				}
+			}
+			const sampleFrame & in = notes[v]->buffer()[f];
+			io[v * DEFAULT_CHANNELS] = in[0];
+			io[v * DEFAULT_CHANNELS + 1] = in[1];
 		}
-	}*/
+
+		batch.process( io );
+
+		for( int v = 0; v < count; ++v )
+		{
+			const NotePlayHandle::ScheduledShaping & s = notes[v]->m_scheduledShaping;
+			if( f >= s.offset && f < s.offset + s.frames )
+			{
+				sampleFrame & out = notes[v]->buffer()[f];
+				out[0] = io[v * DEFAULT_CHANNELS];
+				out[1] = io[v * DEFAULT_CHANNELS + 1];
+			}
+		}
+	}
+	batch.store();
 }
 
 
@@ -25,15 +25,80 @@
  */
 
 #include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
+#include <QHash>
 #include <QLibrary>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 #include <math.h>
 
 #include "ConfigManager.h"
 #include "LadspaManager.h"
 #include "PluginFactory.h"
+#include "lmmsversion.h"
+
+
+
+
+struct LadspaManager::IndexedPlugin
+{
+	QString label;
+	quint32 index;
+	QString name;
+	qint32 properties;
+	quint16 inputChannels;
+	quint16 outputChannels;
+};
+
+
+QDataStream & operator<<( QDataStream & _stream,
+				const LadspaManager::IndexedPlugin & _plugin )
+{
+	return _stream << _plugin.label << _plugin.index << _plugin.name
+		<< _plugin.properties << _plugin.inputChannels
+		<< _plugin.outputChannels;
+}
+
+
+QDataStream & operator>>( QDataStream & _stream,
+				LadspaManager::IndexedPlugin & _plugin )
+{
+	return _stream >> _plugin.label >> _plugin.index >> _plugin.name
+		>> _plugin.properties >> _plugin.inputChannels
+		>> _plugin.outputChannels;
+}
+
+
+
+
+namespace
+{
+
+// The plug-ins of each library found, so unchanged libraries need not be
+// loaded at startup. Libraries that failed to load are not stored.
+const char IndexMagic[] = "LMMSLADI";
+const quint32 IndexVersion = 1;
+
+template<class Plugins>
+struct IndexedLibrary
+{
+	qint64 modified;
+	qint64 size;
+	Plugins plugins;
+};
+
+
+QString indexFile()
+{
+	return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+							"/ladspa.index";
+}
+
+} // namespace
+
 
 
 
@@ -56,6 +121,39 @@ LadspaManager::LadspaManager()
 	ladspaDirectories.push_back( "/Library/Audio/Plug-Ins/LADSPA" );
 #endif
 
+	typedef IndexedLibrary<IndexedPlugins> Library;
+	QHash<QString, Library> index;
+	QFile indexIn( indexFile() );
+	if( indexIn.open( QIODevice::ReadOnly ) )
+	{
+		QDataStream stream( &indexIn );
+		stream.setVersion( QDataStream::Qt_5_0 );
+		QByteArray magic;
+		quint32 version;
+		QString lmmsVersion;
+		quint32 count;
+		stream >> magic >> version >> lmmsVersion >> count;
+		if( magic == IndexMagic && version == IndexVersion &&
+						lmmsVersion == LMMS_VERSION )
+		{
+			for( quint32 i = 0; i < count &&
+				stream.status() == QDataStream::Ok; ++i )
+			{
+				QString path;
+				Library library;
+				stream >> path >> library.modified >>
+					library.size >> library.plugins;
+				index[path] = library;
+			}
+		}
+		if( stream.status() != QDataStream::Ok )
+		{
+			index.clear();
+		}
+	}
+	QHash<QString, Library> newIndex;
+	bool indexChanged = false;
+
 	for( QStringList::iterator it = ladspaDirectories.begin(); 
 			 		   it != ladspaDirectories.end(); ++it )
 	{
@@ -79,18 +177,39 @@ LadspaManager::LadspaManager()
 				continue;
 			}
 
-			QLibrary plugin_lib( f.absoluteFilePath() );
+			const QString path = f.absoluteFilePath();
+			const Library library = { f.lastModified().
+						toMSecsSinceEpoch(),
+						f.size(), IndexedPlugins() };
+			auto indexed = index.constFind( path );
+			if( indexed != index.constEnd() &&
+				indexed->modified == library.modified &&
+				indexed->size == library.size )
+			{
+				// loaded when a plug-in of it is used
+				newIndex[path] = *indexed;
+				addPlugins( indexed->plugins, f.fileName(), path,
+									NULL );
+				continue;
+			}
+
+			QLibrary plugin_lib( path );
 
 			if( plugin_lib.load() == true )
 			{
 				LADSPA_Descriptor_Function descriptorFunction =
 			( LADSPA_Descriptor_Function ) plugin_lib.resolve(
 							"ladspa_descriptor" );
+				newIndex[path] = library;
 				if( descriptorFunction != NULL )
 				{
-					addPlugins( descriptorFunction,
-							f.fileName() );
+					newIndex[path].plugins =
+						describePlugins( descriptorFunction );
+					addPlugins( newIndex[path].plugins,
+							f.fileName(), path,
+							descriptorFunction );
 				}
+				indexChanged = true;
 			}
 			else
 			{
@@ -98,6 +217,28 @@ LadspaManager::LadspaManager()
 			}
 		}
 	}
+
+	if( indexChanged || newIndex.size() != index.size() )
+	{
+		const QString fileName = indexFile();
+		QDir().mkpath( QFileInfo( fileName ).path() );
+		QSaveFile indexOut( fileName );
+		if( indexOut.open( QIODevice::WriteOnly ) )
+		{
+			QDataStream stream( &indexOut );
+			stream.setVersion( QDataStream::Qt_5_0 );
+			stream << QByteArray( IndexMagic ) << IndexVersion <<
+					QString( LMMS_VERSION ) <<
+					static_cast<quint32>( newIndex.size() );
+			for( auto lib = newIndex.constBegin();
+					lib != newIndex.constEnd(); ++lib )
+			{
+				stream << lib.key() << lib->modified <<
+						lib->size << lib->plugins;
+			}
+			indexOut.commit();
+		}
+	}
 	
 	l_ladspa_key_t keys = m_ladspaManagerMap.keys();
 	for( l_ladspa_key_t::iterator it = keys.begin();
@@ -139,17 +280,37 @@ ladspaManagerDescription * LadspaManager::getDescription(
 
 
 
-void LadspaManager::addPlugins(
-		LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file )
+LadspaManager::IndexedPlugins LadspaManager::describePlugins(
+		LADSPA_Descriptor_Function _descriptor_func )
 {
+	IndexedPlugins plugins;
 	const LADSPA_Descriptor * descriptor;
 
 	for( long pluginIndex = 0;
 		( descriptor = _descriptor_func( pluginIndex ) ) != NULL;
 								++pluginIndex )
 	{
-		ladspa_key_t key( _file, QString( descriptor->Label ) );
+		IndexedPlugin plugin = { QString( descriptor->Label ),
+					static_cast<quint32>( pluginIndex ),
+					QString( descriptor->Name ),
+					static_cast<qint32>( descriptor->Properties ),
+					getPluginInputs( descriptor ),
+					getPluginOutputs( descriptor ) };
+		plugins.append( plugin );
+	}
+	return plugins;
+}
+
+
+
+
+void LadspaManager::addPlugins( const IndexedPlugins & _plugins,
+				const QString & _file, const QString & _library,
+				LADSPA_Descriptor_Function _descriptor_func )
+{
+	for( const IndexedPlugin & plugin : _plugins )
+	{
+		ladspa_key_t key( _file, plugin.label );
 		if( m_ladspaManagerMap.contains( key ) )
 		{
 			continue;
@@ -158,9 +319,12 @@ void LadspaManager::addPlugins(
 		ladspaManagerDescription * plugIn = 
 				new ladspaManagerDescription;
 		plugIn->descriptorFunction = _descriptor_func;
-		plugIn->index = pluginIndex;
-		plugIn->inputChannels = getPluginInputs( descriptor );
-		plugIn->outputChannels = getPluginOutputs( descriptor );
+		plugIn->index = plugin.index;
+		plugIn->inputChannels = plugin.inputChannels;
+		plugIn->outputChannels = plugin.outputChannels;
+		plugIn->library = _library;
+		plugIn->name = plugin.name;
+		plugIn->properties = plugin.properties;
 
 		if( plugIn->inputChannels == 0 && plugIn->outputChannels > 0 )
 		{
@@ -188,6 +352,37 @@ void LadspaManager::addPlugins(
 
 
 
+bool LadspaManager::loadLibrary( const QString & _library )
+{
+	QLibrary plugin_lib( _library );
+	if( plugin_lib.load() == false )
+	{
+		qWarning() << plugin_lib.errorString();
+		return false;
+	}
+
+	LADSPA_Descriptor_Function descriptorFunction =
+		( LADSPA_Descriptor_Function ) plugin_lib.resolve(
+							"ladspa_descriptor" );
+	if( descriptorFunction == NULL )
+	{
+		return false;
+	}
+
+	for( ladspaManagerMapType::iterator it = m_ladspaManagerMap.begin();
+					it != m_ladspaManagerMap.end(); ++it )
+	{
+		if( it.value()->library == _library )
+		{
+			it.value()->descriptorFunction = descriptorFunction;
+		}
+	}
+	return true;
+}
+
+
+
+
 uint16_t LadspaManager::getPluginInputs(
 		const LADSPA_Descriptor * _descriptor )
 {
@@ -301,9 +496,10 @@ bool LadspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 bool LadspaManager::isRealTimeCapable(
 					const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_HARD_RT_CAPABLE( descriptor->Properties )
-					   : false );
+	const ladspaManagerDescription * description =
+						getDescription( _plugin );
+	return( description ?
+		LADSPA_IS_HARD_RT_CAPABLE( description->properties ) : false );
 }
 
 
@@ -311,8 +507,9 @@ bool LadspaManager::isRealTimeCapable(
 
 QString LadspaManager::getName( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Name : "" );
+	const ladspaManagerDescription * description =
+						getDescription( _plugin );
+	return( description ? description->name : "" );
 }
 
 
@@ -576,11 +773,16 @@ const LADSPA_Descriptor * LadspaManager::getDescriptor(
 {
 	if( m_ladspaManagerMap.contains( _plugin ) )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
+		ladspaManagerDescription * description =
+						m_ladspaManagerMap[_plugin];
+		if( description->descriptorFunction == NULL &&
+				!loadLibrary( description->library ) )
+		{
+			return( NULL );
+		}
 		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
+				description->descriptorFunction(
+					description->index );
 		return( descriptor );
 	}
 	else
@@ -0,0 +1,174 @@
+/*
+ * LatencyProbe.cpp - measures the round-trip latency of the audio device
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "LatencyProbe.h"
+
+#include <cmath>
+
+#include "ConfigManager.h"
+
+
+LatencyProbe::LatencyProbe() :
+	m_state( Idle ),
+	m_inputSampleRate( 0 ),
+	m_elapsed( 0 ),
+	m_noisePeak( 0.0f ),
+	m_result( -1 ),
+	m_measuredFrames( -1 )
+{
+	m_timer.setInterval( 50 );
+	connect( &m_timer, SIGNAL( timeout() ), this, SLOT( checkState() ) );
+}
+
+
+
+
+LatencyProbe::~LatencyProbe()
+{
+}
+
+
+
+
+void LatencyProbe::start( sample_rate_t inputSampleRate )
+{
+	if( isRunning() )
+	{
+		return;
+	}
+	m_inputSampleRate = inputSampleRate;
+	m_elapsed = 0;
+	m_noisePeak = 0.0f;
+	m_result = -1;
+	// publishes the members above to the mixer thread
+	m_state.store( Listening, std::memory_order_release );
+	m_timer.start();
+}
+
+
+
+
+float LatencyProbe::measuredLatency() const
+{
+	if( m_measuredFrames < 0 || m_inputSampleRate == 0 )
+	{
+		return -1.0f;
+	}
+	return 1000.0f * m_measuredFrames / m_inputSampleRate;
+}
+
+
+
+
+float LatencyProbe::recordLatency()
+{
+	return qMax( 0.0f, ConfigManager::inst()->value( "mixer",
+					"recordlatency" ).toFloat() );
+}
+
+
+
+
+void LatencyProbe::process( surroundSampleFrame * output, fpp_t frames,
+				const sampleFrame * input, f_cnt_t inputFrames )
+{
+	const int state = m_state.load( std::memory_order_acquire );
+	if( state == Listening )
+	{
+		for( f_cnt_t f = 0; f < inputFrames; ++f )
+		{
+			m_noisePeak = qMax( m_noisePeak, qMax(
+						std::fabs( input[f][0] ),
+						std::fabs( input[f][1] ) ) );
+		}
+		m_elapsed += inputFrames;
+		if( m_elapsed < static_cast<f_cnt_t>(
+					m_inputSampleRate * ListenMs / 1000 ) )
+		{
+			return;
+		}
+
+		for( fpp_t f = 0; f < qMin<fpp_t>( frames, ImpulseFrames ); ++f )
+		{
+			for( ch_cnt_t ch = 0; ch < SURROUND_CHANNELS; ++ch )
+			{
+				output[f][ch] = 0.9f;
+			}
+		}
+		// the frames captured for this period were recorded before the
+		// impulse was sent, but count towards the round trip
+		m_elapsed = inputFrames;
+		m_state.store( Waiting, std::memory_order_relaxed );
+		return;
+	}
+
+	if( state != Waiting )
+	{
+		return;
+	}
+
+	const float threshold = qMax( 0.05f, m_noisePeak * 4.0f );
+	for( f_cnt_t f = 0; f < inputFrames; ++f )
+	{
+		if( std::fabs( input[f][0] ) > threshold ||
+			std::fabs( input[f][1] ) > threshold )
+		{
+			m_result = m_elapsed + f;
+			m_state.store( Finished, std::memory_order_release );
+			return;
+		}
+	}
+	m_elapsed += inputFrames;
+	if( m_elapsed > static_cast<f_cnt_t>(
+				m_inputSampleRate * TimeoutMs / 1000 ) )
+	{
+		m_state.store( Failed, std::memory_order_release );
+	}
+}
+
+
+
+
+void LatencyProbe::checkState()
+{
+	const int state = m_state.load( std::memory_order_acquire );
+	if( state != Finished && state != Failed )
+	{
+		return;
+	}
+	m_timer.stop();
+	m_state = Idle;
+
+	if( state == Failed )
+	{
+		emit measured( false );
+		return;
+	}
+
+	m_measuredFrames = m_result;
+	ConfigManager::inst()->setValue( "mixer", "recordlatency",
+				QString::number( measuredLatency(), 'f', 2 ) );
+	emit measured( true );
+}
@@ -32,6 +32,10 @@
 #include "LfoController.h"
 
 
+// frames per block in updateValueBuffer()
+static const int BlockSize = 64;
+
+
 LfoController::LfoController( Model * _parent ) :
 	Controller( Controller::LfoController, _parent, tr( "LFO Controller" ) ),
 	m_baseModel( 0.5, 0.0, 1.0, 0.001, this, tr( "Base value" ) ),
@@ -44,7 +48,7 @@ LfoController::LfoController( Model * _parent ) :
 	m_duration( 1000 ),
 	m_phaseOffset( 0 ),
 	m_currentPhase( 0 ),
-	m_sampleFunction( &Oscillator::sinSample ),
+	m_waveShape( Oscillator::SineWave ),
 	m_userDefSampleBuffer( new SampleBuffer )
 {
 	setSampleExact( true );
@@ -88,38 +92,71 @@ void LfoController::updateValueBuffer()
 
 	// roll phase up until we're in sync with period counter
 	m_bufferLastUpdated++;
-	if( m_bufferLastUpdated < s_periods )
+	if( m_bufferLastUpdated < runningPeriods() )
 	{
-		int diff = s_periods - m_bufferLastUpdated;
+		int diff = runningPeriods() - m_bufferLastUpdated;
 		phase += static_cast<float>( Engine::mixer()->framesPerPeriod() * diff ) / m_duration;
 		m_bufferLastUpdated += diff;
 	}
 
-	float amount = m_amountModel.value();
-	ValueBuffer *amountBuffer = m_amountModel.valueBuffer();
-	int amountInc = amountBuffer ? 1 : 0;
-	float *amountPtr = amountBuffer ? &(amountBuffer->values()[ 0 ] ) : &amount;
-
-	for( float& f : m_valueBuffer )
+	// the wave is computed in blocks: first the phases, then the wave for
+	// all of them, then the scaling - each loop can be vectorized
+	const float base = m_baseModel.value();
+	const float amount = m_amountModel.value();
+	const ValueBuffer * amountBuffer = m_amountModel.valueBuffer();
+	const float step = 1.0f / m_duration;
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	float * values = m_valueBuffer.values();
+	const int frames = m_valueBuffer.length();
+	for( int start = 0; start < frames; start += BlockSize )
 	{
-		const float currentSample = m_sampleFunction != NULL
-			? m_sampleFunction( phase )
-			: m_userDefSampleBuffer->userWaveSample( phase );
-
-		f = qBound( 0.0f, m_baseModel.value() + ( *amountPtr * currentSample / 2.0f ), 1.0f );
-
-		phase += 1.0 / m_duration;
-		amountPtr += amountInc;
+		const int count = qMin( BlockSize, frames - start );
+		for( int i = 0; i < count; ++i )
+		{
+			phases[i] = phase + i * step;
+		}
+		phase = absFraction( phase + count * step );
+
+		if( m_waveShape == Oscillator::UserDefinedWave )
+		{
+			for( int i = 0; i < count; ++i )
+			{
+				wave[i] = m_userDefSampleBuffer->userWaveSample( phases[i] );
+			}
+		}
+		else
+		{
+			Oscillator::waveBlock( m_waveShape, phases, wave, count );
+		}
+
+		float * out = values + start;
+		if( amountBuffer )
+		{
+			const float * amounts = amountBuffer->values() + start;
+			for( int i = 0; i < count; ++i )
+			{
+				out[i] = qBound( 0.0f, base + amounts[i] * wave[i] * 0.5f, 1.0f );
+			}
+		}
+		else
+		{
+			for( int i = 0; i < count; ++i )
+			{
+				out[i] = qBound( 0.0f, base + amount * wave[i] * 0.5f, 1.0f );
+			}
+		}
 	}
 
 	m_currentPhase = absFraction( phase - m_phaseOffset );
-	m_bufferLastUpdated = s_periods;
+	m_bufferLastUpdated = runningPeriods();
 }
 
 void LfoController::updatePhase()
 {
 	m_currentPhase = ( Engine::getSong()->getFrames() ) / m_duration;
-	m_bufferLastUpdated = s_periods - 1;
+	m_bufferLastUpdated = runningPeriods() - 1;
 }
 
 
@@ -146,38 +183,7 @@ void LfoController::updateDuration()
 
 void LfoController::updateSampleFunction()
 {
-	switch( m_waveModel.value() )
-	{
-		case Oscillator::SineWave:
-			m_sampleFunction = &Oscillator::sinSample;
-			break;
-		case Oscillator::TriangleWave:
-			m_sampleFunction = &Oscillator::triangleSample;
-			break;
-		case Oscillator::SawWave:
-			m_sampleFunction = &Oscillator::sawSample;
-			break;
-		case Oscillator::SquareWave:
-			m_sampleFunction = &Oscillator::squareSample;
-			break;
-		case Oscillator::MoogSawWave:
-			m_sampleFunction = &Oscillator::moogSawSample;
-			break;
-		case Oscillator::ExponentialWave:
-			m_sampleFunction = &Oscillator::expSample;
-			break;
-		case Oscillator::WhiteNoise:
-			m_sampleFunction = &Oscillator::noiseSample;
-			break;
-		case Oscillator::UserDefinedWave:
-			m_sampleFunction = NULL;
-			/*TODO: If C++11 is allowed, should change the type of
-			 m_sampleFunction be std::function<sample_t(const float)>
-			 and use the line below:
-			*/
-			//m_sampleFunction = &(m_userDefSampleBuffer->userWaveSample)
-			break;
-	}
+	m_waveShape = static_cast<Oscillator::WaveShapes>( m_waveModel.value() );
 }
 
 
@@ -25,15 +25,14 @@
 #include "LocklessAllocator.h"
 
 #include <algorithm>
+#include <new>
 #include <stdio.h>
 
-#include "lmmsconfig.h"
 
-#ifndef LMMS_BUILD_WIN32
-#include <strings.h>
-#endif
-
-static const size_t SIZEOF_SET = sizeof( int ) * 8;
+static std::atomic<int64_t> s_capacity( 0 );
+static std::atomic<int64_t> s_inUse( 0 );
+static std::atomic_int s_segmentsAdded( 0 );
+static std::atomic_int s_failures( 0 );
 
 
 static size_t align( size_t size, size_t alignment )
@@ -49,18 +48,15 @@ static size_t align( size_t size, size_t alignment )
 
 
 
-LocklessAllocator::LocklessAllocator( size_t nmemb, size_t size )
+LocklessAllocator::LocklessAllocator( size_t nmemb, size_t size ) :
+	m_segmentSize( std::max<size_t>( nmemb, 1 ) ),
+	m_elementSize( align( sizeof( Header ) + size, sizeof( void * ) ) ),
+	m_segmentCount( 0 ),
+	m_inUse( 0 )
 {
-	m_capacity = align( nmemb, SIZEOF_SET );
-	m_elementSize = align( size, sizeof( void * ) );
-	m_pool = new char[m_capacity * m_elementSize];
-
-	m_freeStateSets = m_capacity / SIZEOF_SET;
-	m_freeState = new std::atomic_int[m_freeStateSets];
-	std::fill(m_freeState, m_freeState + m_freeStateSets, 0);
-
-	m_available = m_capacity;
-	m_startIndex = 0;
+	m_growing.clear();
+	std::fill( m_segments, m_segments + MaxSegments, nullptr );
+	grow();
 }
 
 
@@ -68,70 +64,54 @@ LocklessAllocator::LocklessAllocator( size_t nmemb, size_t size )
 
 LocklessAllocator::~LocklessAllocator()
 {
-	int available = m_available;
-	if( available != m_capacity )
+	if( m_inUse != 0 )
 	{
 		fprintf( stderr, "LocklessAllocator: "
 				"Destroying with elements still allocated\n" );
 	}
 
-	delete[] m_pool;
-	delete[] m_freeState;
-}
-
-
-
-
-#ifdef LMMS_BUILD_WIN32
-static int ffs( int i )
-{
-	if( !i )
-	{
-		return 0;
-	}
-	for( int j = 0;; )
+	for( int s = 0; s < m_segmentCount; ++s )
 	{
-		if( i & 1 << j++ )
-		{
-			return j;
-		}
+		delete[] m_segments[s].load();
 	}
+	s_capacity -= capacity();
+	s_inUse -= m_inUse;
 }
-#endif
 
 
 
 
 void * LocklessAllocator::alloc()
 {
-	// Some of these CAS loops could probably use relaxed atomics, as discussed
-	// in http://en.cppreference.com/w/cpp/atomic/atomic/compare_exchange.
-	// Let's use sequentially-consistent ops to be safe for now.
-	int available = m_available.load();
-	do
+	uint32_t index;
+	while( ( index = popFree() ) == InUse )
 	{
-		if( !available )
+		if( !grow() )
 		{
+			++s_failures;
 			fprintf( stderr, "LocklessAllocator: No free space\n" );
 			return NULL;
 		}
 	}
-	while (!m_available.compare_exchange_weak(available, available - 1));
+	++m_inUse;
+	++s_inUse;
+	return header( index ) + 1;
+}
+
 
-	const size_t startIndex = m_startIndex++ % m_freeStateSets;
-	for (size_t set = startIndex;; set = ( set + 1 ) % m_freeStateSets)
+
+
+void * LocklessAllocator::tryAlloc()
+{
+	const uint32_t index = popFree();
+	if( index == InUse )
 	{
-		for (int freeState = m_freeState[set]; freeState != -1;)
-		{
-			int bit = ffs( ~freeState ) - 1;
-			if (m_freeState[set].compare_exchange_weak(freeState,
-							freeState | 1 << bit ) )
-			{
-				return m_pool + ( SIZEOF_SET * set + bit )
-								* m_elementSize;
-			}
-		}
+		++s_failures;
+		return NULL;
 	}
+	++m_inUse;
+	++s_inUse;
+	return header( index ) + 1;
 }
 
 
@@ -139,26 +119,121 @@ void * LocklessAllocator::alloc()
 
 void LocklessAllocator::free( void * ptr )
 {
-	ptrdiff_t diff = (char *)ptr - m_pool;
-	if( diff < 0 || diff % m_elementSize )
+	Header * h = static_cast<Header *>( ptr ) - 1;
+	const uint32_t index = h->index;
+	if( index >= m_segmentCount * m_segmentSize || header( index ) != h )
 	{
-invalid:
 		fprintf( stderr, "LocklessAllocator: Invalid pointer\n" );
 		return;
 	}
-	size_t offset = diff / m_elementSize;
-	if( offset >= m_capacity )
-	{
-		goto invalid;
-	}
-	size_t set = offset / SIZEOF_SET;
-	int bit = offset % SIZEOF_SET;
-	int mask = 1 << bit;
-	int prevState = m_freeState[set].fetch_and(~mask);
-	if ( !( prevState & mask ) )
+	if( h->next.exchange( 0 ) != InUse )
 	{
 		fprintf( stderr, "LocklessAllocator: Block not in use\n" );
 		return;
 	}
-	++m_available;
+	pushFree( index, index );
+	--m_inUse;
+	--s_inUse;
+}
+
+
+
+
+size_t LocklessAllocator::capacity() const
+{
+	return m_segmentCount.load( std::memory_order_relaxed ) * m_segmentSize;
+}
+
+
+
+
+size_t LocklessAllocator::inUse() const
+{
+	return m_inUse.load( std::memory_order_relaxed );
+}
+
+
+
+
+LocklessAllocator::Usage LocklessAllocator::usage()
+{
+	Usage usage;
+	usage.capacity = s_capacity.load( std::memory_order_relaxed );
+	usage.inUse = s_inUse.load( std::memory_order_relaxed );
+	usage.segmentsAdded = s_segmentsAdded.load( std::memory_order_relaxed );
+	usage.failures = s_failures.load( std::memory_order_relaxed );
+	return usage;
+}
+
+
+
+
+LocklessAllocator::Header * LocklessAllocator::header( uint32_t index ) const
+{
+	char * segment = m_segments[index / m_segmentSize].load( std::memory_order_acquire );
+	return reinterpret_cast<Header *>( segment + index % m_segmentSize * m_elementSize );
+}
+
+
+
+
+void LocklessAllocator::pushFree( uint32_t first, uint32_t last )
+{
+	// the elements from first to last are linked already
+	m_free.pushLinked( first, last, nextOf() );
+}
+
+
+
+
+uint32_t LocklessAllocator::popFree()
+{
+	const uint32_t index = m_free.pop( nextOf() );
+	if( index == IndexStack::Empty )
+	{
+		return InUse;
+	}
+	header( index )->next.store( InUse, std::memory_order_relaxed );
+	return index;
+}
+
+
+
+
+bool LocklessAllocator::grow()
+{
+	if( m_growing.test_and_set( std::memory_order_acquire ) )
+	{
+		// another thread is adding a segment, try again once it's there
+		return true;
+	}
+
+	const int s = m_segmentCount.load( std::memory_order_relaxed );
+	if( s >= MaxSegments || ( s + 1 ) * m_segmentSize >= InUse )
+	{
+		m_growing.clear( std::memory_order_release );
+		return false;
+	}
+
+	char * segment = new char[m_segmentSize * m_elementSize];
+	m_segments[s].store( segment, std::memory_order_release );
+	m_segmentCount.store( s + 1, std::memory_order_release );
+
+	const uint32_t first = s * m_segmentSize;
+	const uint32_t last = first + m_segmentSize - 1;
+	for( uint32_t index = first; index <= last; ++index )
+	{
+		Header * h = new( header( index ) ) Header;
+		h->index = index;
+		h->next.store( index + 2, std::memory_order_relaxed );
+	}
+	pushFree( first, last );
+
+	s_capacity += m_segmentSize;
+	if( s > 0 )
+	{
+		++s_segmentsAdded;
+	}
+	m_growing.clear( std::memory_order_release );
+	return true;
 }
@@ -0,0 +1,121 @@
+/*
+ * LocklessCommandQueue.cpp - queue of closures with lockless posting and
+ *                            processing
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LocklessCommandQueue.h"
+
+
+LocklessCommandQueue::LocklessCommandQueue() :
+	m_pending( nullptr ),
+	m_processed( nullptr )
+{
+}
+
+
+
+
+LocklessCommandQueue::~LocklessCommandQueue()
+{
+	// nobody can post or process anymore, so run what's left
+	process();
+	reclaim();
+}
+
+
+
+
+void LocklessCommandQueue::push( std::atomic<Node *> & list, Node * first, Node * last )
+{
+	last->next = list.load( std::memory_order_relaxed );
+	while( !list.compare_exchange_weak( last->next, first,
+			std::memory_order_release,
+			std::memory_order_relaxed ) )
+	{
+		// Empty loop (compare_exchange_weak updates last->next)
+	}
+}
+
+
+
+
+void LocklessCommandQueue::post( Command command, Command cleanup )
+{
+	reclaim();
+
+	Node * node = new Node{ command, cleanup, nullptr };
+	push( m_pending, node, node );
+}
+
+
+
+
+int LocklessCommandQueue::process()
+{
+	Node * list = m_pending.exchange( nullptr, std::memory_order_acquire );
+	if( list == nullptr )
+	{
+		return 0;
+	}
+
+	// the list is in reverse posting order, so reverse it first
+	Node * reversed = nullptr;
+	Node * last = list;
+	while( list )
+	{
+		Node * next = list->next;
+		list->next = reversed;
+		reversed = list;
+		list = next;
+	}
+
+	int count = 0;
+	for( Node * node = reversed; node; node = node->next )
+	{
+		node->command();
+		++count;
+	}
+
+	// hand the nodes over to reclaim(), as freeing them isn't realtime safe
+	push( m_processed, reversed, last );
+
+	return count;
+}
+
+
+
+
+void LocklessCommandQueue::reclaim()
+{
+	Node * node = m_processed.exchange( nullptr, std::memory_order_acquire );
+	while( node )
+	{
+		Node * next = node->next;
+		if( node->cleanup )
+		{
+			node->cleanup();
+		}
+		delete node;
+		node = next;
+	}
+}
@@ -27,6 +27,7 @@
 
 #include <QtCore/QtGlobal>
 #include "rpmalloc.h"
+#include "RealtimeCheck.h"
 
 /// Global static object handling rpmalloc intializing and finalizing
 struct MemoryManagerGlobalGuard {
@@ -65,6 +66,7 @@ void* MemoryManager::alloc(size_t size)
 	// Compilers may optimize the instance away otherwise.
 	Q_UNUSED(&local_mm_thread_guard);
 	Q_ASSERT_X(rpmalloc_is_thread_initialized(), "MemoryManager::alloc", "Thread not initialized");
+	RealtimeCheck::check("MemoryManager::alloc()");
 	return rpmalloc(size);
 }
 
@@ -73,5 +75,6 @@ void MemoryManager::free(void * ptr)
 {
 	Q_UNUSED(&local_mm_thread_guard);
 	Q_ASSERT_X(rpmalloc_is_thread_initialized(), "MemoryManager::free", "Thread not initialized");
+	RealtimeCheck::check("MemoryManager::free()");
 	return rpfree(ptr);
 }
@@ -0,0 +1,237 @@
+/*
+ * MemoryUsage.cpp - where the memory of a project goes
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MemoryUsage.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QMutex>
+
+#include <algorithm>
+
+#include "AudioPort.h"
+#include "BBTrackContainer.h"
+#include "Effect.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "ProjectJournal.h"
+#include "RemotePlugin.h"
+#include "SampleTCO.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
+
+namespace
+{
+
+QMutex cachesMutex;
+std::vector<const MemoryUsage::Cache *> caches;
+
+
+qint64 pluginBytes(const Plugin * plugin)
+{
+	const RemotePlugin * remote = plugin->remotePlugin();
+	return plugin->memoryUsage() + (remote != nullptr ? remote->residentBytes() : 0);
+}
+
+
+void addEffects(MemoryUsage::Entry & entry, const EffectChain * chain)
+{
+	if (chain == nullptr)
+	{
+		return;
+	}
+	for (const Effect * effect : chain->effects())
+	{
+		entry.bytes[MemoryUsage::Effects] += pluginBytes(effect);
+	}
+}
+
+
+QJsonObject entryToJson(const MemoryUsage::Entry & entry)
+{
+	QJsonObject object;
+	for (int i = 0; i < MemoryUsage::NumSubsystems; ++i)
+	{
+		object[MemoryUsage::subsystemName(static_cast<MemoryUsage::Subsystems>(i))] =
+			static_cast<double>(entry.bytes[i]);
+	}
+	return object;
+}
+
+
+QJsonArray entriesToJson(const std::vector<MemoryUsage::Entry> & entries)
+{
+	QJsonArray array;
+	for (const MemoryUsage::Entry & entry : entries)
+	{
+		if (entry.total() > 0)
+		{
+			QJsonObject object = entryToJson(entry);
+			object["name"] = entry.name;
+			array.append(object);
+		}
+	}
+	return array;
+}
+
+} // namespace
+
+
+
+
+MemoryUsage::Entry::Entry(const QString & name) :
+	name(name)
+{
+	std::fill(bytes, bytes + NumSubsystems, 0);
+}
+
+
+
+
+qint64 MemoryUsage::Entry::total() const
+{
+	qint64 sum = 0;
+	for (int i = 0; i < NumSubsystems; ++i)
+	{
+		sum += bytes[i];
+	}
+	return sum;
+}
+
+
+
+
+QJsonObject MemoryUsage::Report::toJson() const
+{
+	QJsonObject object = entryToJson(subsystems);
+	object["tracks"] = entriesToJson(tracks);
+	object["fx_channels"] = entriesToJson(fxChannels);
+	return object;
+}
+
+
+
+
+MemoryUsage::Cache::Cache(const QString & name, const std::function<qint64()> & bytes) :
+	m_name(name),
+	m_bytes(bytes)
+{
+	QMutexLocker locker(&cachesMutex);
+	caches.push_back(this);
+}
+
+
+
+
+MemoryUsage::Cache::~Cache()
+{
+	QMutexLocker locker(&cachesMutex);
+	caches.erase(std::find(caches.begin(), caches.end(), this));
+}
+
+
+
+
+MemoryUsage::Report MemoryUsage::collect()
+{
+	Report report;
+
+	TrackContainer::TrackList tracks = Engine::getSong()->tracks();
+	tracks += Engine::getBBTrackContainer()->tracks();
+	for (Track * track : tracks)
+	{
+		Entry entry(track->name());
+		if (track->type() == Track::InstrumentTrack)
+		{
+			InstrumentTrack * instrumentTrack = static_cast<InstrumentTrack *>(track);
+			if (instrumentTrack->instrument() != nullptr)
+			{
+				entry.bytes[Instruments] += pluginBytes(instrumentTrack->instrument());
+			}
+			addEffects(entry, instrumentTrack->audioPort()->effects());
+		}
+		else if (track->type() == Track::SampleTrack)
+		{
+			for (TrackContentObject * tco : track->getTCOs())
+			{
+				const SampleBuffer * buffer = static_cast<SampleTCO *>(tco)->sampleBuffer();
+				entry.bytes[Samples] += buffer->memoryUsage();
+				entry.bytes[GuiCaches] += buffer->overviewMemoryUsage();
+			}
+			addEffects(entry, static_cast<SampleTrack *>(track)->audioPort()->effects());
+		}
+		report.tracks.push_back(entry);
+	}
+
+	FxMixer * fxMixer = Engine::fxMixer();
+	for (int i = 0; i < fxMixer->numChannels(); ++i)
+	{
+		FxChannel * channel = fxMixer->effectChannel(i);
+		Entry entry(channel->m_name);
+		addEffects(entry, &channel->m_fxChain);
+		report.fxChannels.push_back(entry);
+	}
+
+	for (const std::vector<Entry> * entries : {&report.tracks, &report.fxChannels})
+	{
+		for (const Entry & entry : *entries)
+		{
+			for (int i = 0; i < NumSubsystems; ++i)
+			{
+				report.subsystems.bytes[i] += entry.bytes[i];
+			}
+		}
+	}
+
+	report.subsystems.bytes[Journal] = Engine::projectJournal()->memoryUsage();
+
+	QMutexLocker locker(&cachesMutex);
+	for (const Cache * cache : caches)
+	{
+		const qint64 bytes = cache->m_bytes();
+		report.caches.emplace_back(cache->m_name, bytes);
+		report.subsystems.bytes[GuiCaches] += bytes;
+	}
+
+	return report;
+}
+
+
+
+
+QString MemoryUsage::subsystemName(Subsystems subsystem)
+{
+	switch (subsystem)
+	{
+		case Samples: return "samples";
+		case Instruments: return "instruments";
+		case Effects: return "effects";
+		case Journal: return "journal";
+		case GuiCaches: return "gui_caches";
+		default: return QString();
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * MeterSnapshot.cpp - hands the peaks of all mixer channels to the GUI
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MeterSnapshot.h"
+
+#include <algorithm>
+
+
+const int MeterSnapshot::FreshBit;
+
+
+MeterSnapshot::MeterSnapshot() :
+	m_back(0),
+	m_backFilled(false),
+	m_middle(1),
+	m_front(2)
+{
+}
+
+
+
+
+void MeterSnapshot::resize(int meters)
+{
+	for (Snapshot & slot : m_slots)
+	{
+		slot.resize(meters, Meter{0.0f, 0.0f, true});
+	}
+}
+
+
+
+
+void MeterSnapshot::beginWrite()
+{
+	if (m_backFilled)
+	{
+		return;
+	}
+	for (Meter & meter : m_slots[m_back])
+	{
+		meter.peakLeft = meter.peakRight = 0.0f;
+	}
+}
+
+
+
+
+void MeterSnapshot::write(int meter, float peakLeft, float peakRight, bool sleeping)
+{
+	Snapshot & s = m_slots[m_back];
+	if (meter < 0 || meter >= static_cast<int>(s.size()))
+	{
+		return;
+	}
+	Meter & m = s[meter];
+	m.peakLeft = std::max(m.peakLeft, peakLeft);
+	m.peakRight = std::max(m.peakRight, peakRight);
+	m.sleeping = sleeping;
+}
+
+
+
+
+void MeterSnapshot::publish()
+{
+	// keep raising the peaks until the reader has taken the last snapshot
+	if (m_middle.load(std::memory_order_acquire) & FreshBit)
+	{
+		m_backFilled = true;
+		return;
+	}
+	m_back = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel) & ~FreshBit;
+	m_backFilled = false;
+}
+
+
+
+
+const MeterSnapshot::Snapshot * MeterSnapshot::read()
+{
+	if (!(m_middle.load(std::memory_order_acquire) & FreshBit))
+	{
+		return nullptr;
+	}
+	m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~FreshBit;
+	return &m_slots[m_front];
+}
@@ -27,10 +27,10 @@
 #include <cstdio>
 
 #include "lmms_math.h"
+#include "MixHelpersKernels.h"
+#include "PlanarBuffer.h"
 #include "ValueBuffer.h"
 
-#include <cstdio>
-
 
 static bool s_NaNHandler;
 
@@ -61,7 +61,10 @@ static inline void run( sampleFrame* dst, const sample_t* srcLeft, const sample_
 
 
 
-bool isSilent( const sampleFrame* src, int frames )
+namespace Scalar
+{
+
+static bool isSilent( const sampleFrame* src, int frames )
 {
 	const float silenceThreshold = 0.0000001f;
 
@@ -76,52 +79,26 @@ bool isSilent( const sampleFrame* src, int frames )
 	return true;
 }
 
-bool useNaNHandler()
-{
-	return s_NaNHandler;
-}
-
-void setNaNHandler( bool use )
-{
-	s_NaNHandler = use;
-}
 
-/*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
-bool sanitize( sampleFrame * src, int frames )
+static BufferAnalysis analyze( const sampleFrame* src, int frames )
 {
-	if( !useNaNHandler() )
-	{
-		return false;
-	}
-
-	bool found = false;
+	sample_t peak[2] = { 0.0f, 0.0f };
+	double sumOfSquares = 0.0;
+	bool bad = false;
 	for( int f = 0; f < frames; ++f )
 	{
 		for( int c = 0; c < 2; ++c )
 		{
-			if( isinf( src[f][c] ) || isnan( src[f][c] ) )
+			const float a = fabsf( src[f][c] );
+			if( a > peak[c] )
 			{
-				#ifdef LMMS_DEBUG
-					printf("Bad data, clearing buffer. frame: ");
-					printf("%d: value %f\n", f, src[f][c]);
-				#endif
-				for( int f = 0; f < frames; ++f )
-				{
-					for( int c = 0; c < 2; ++c )
-					{
-						src[f][c] = 0.0f;
-					}
-				}
-				found = true;
-				return found;
-			}
-			else
-			{
-				src[f][c] = qBound( -1000.0f, src[f][c], 1000.0f );
+				peak[c] = a;
 			}
+			sumOfSquares += src[f][c] * src[f][c];
+			bad |= isinf( src[f][c] ) || isnan( src[f][c] );
 		}
 	}
-	return found;
+	return finishAnalysis( peak[0], peak[1], sumOfSquares, frames, bad );
 }
 
 
@@ -134,7 +111,7 @@ struct AddOp
 	}
 } ;
 
-void add( sampleFrame* dst, const sampleFrame* src, int frames )
+static void add( sampleFrame* dst, const sampleFrame* src, int frames )
 {
 	run<>( dst, src, frames, AddOp() );
 }
@@ -155,7 +132,7 @@ struct AddMultipliedOp
 } ;
 
 
-void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, AddMultipliedOp(coeffSrc) );
 }
@@ -174,64 +151,50 @@ struct AddSwappedMultipliedOp
 	const float m_coeff;
 };
 
-void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
 }
 
 
-void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+static void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf[f];
 	}
 }
 
-void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+static void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+		dst[f][0] += src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		dst[f][1] += src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
 	}
 
 }
 
-void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+static void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
 {
-	if ( !useNaNHandler() )
-	{
-		addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf,
-								frames );
-		return;
-	}
-
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += ( isinf( src[f][0] ) || isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += ( isinf( src[f][1] ) || isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		dst[f][0] += ( isinf( src[f][0] ) || isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += ( isinf( src[f][1] ) || isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf[f];
 	}
 }
 
-void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+static void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
 {
-	if ( !useNaNHandler() )
-	{
-		addMultipliedByBuffers( dst, src, coeffSrcBuf1, coeffSrcBuf2,
-								frames );
-		return;
-	}
-
 	for( int f = 0; f < frames; ++f )
 	{
 		dst[f][0] += ( isinf( src[f][0] ) || isnan( src[f][0] ) )
 			? 0.0f
-			: src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+			: src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
 		dst[f][1] += ( isinf( src[f][1] ) || isnan( src[f][1] ) )
 			? 0.0f
-			: src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+			: src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
 	}
 
 }
@@ -250,14 +213,8 @@ struct AddSanitizedMultipliedOp
 	const float m_coeff;
 };
 
-void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
-	if ( !useNaNHandler() )
-	{
-		addMultiplied( dst, src, coeffSrc, frames );
-		return;
-	}
-
 	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
 }
 
@@ -281,7 +238,7 @@ struct AddMultipliedStereoOp
 } ;
 
 
-void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
+static void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
 {
 
 	run<>( dst, src, frames, AddMultipliedStereoOp(coeffSrcLeft, coeffSrcRight) );
@@ -309,14 +266,14 @@ struct MultiplyAndAddMultipliedOp
 } ;
 
 
-void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
+static void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
 }
 
 
 
-void multiplyAndAddMultipliedJoined( sampleFrame* dst,
+static void multiplyAndAddMultipliedJoined( sampleFrame* dst,
 										const sample_t* srcLeft,
 										const sample_t* srcRight,
 										float coeffDst, float coeffSrc, int frames )
@@ -324,5 +281,317 @@ void multiplyAndAddMultipliedJoined( sampleFrame* dst,
 	run<>( dst, srcLeft, srcRight, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
 }
 
+} // namespace Scalar
+
+
+
+const Kernels* scalarKernels()
+{
+	static const Kernels k = {
+		&Scalar::isSilent,
+		&Scalar::analyze,
+		&Scalar::add,
+		&Scalar::addMultiplied,
+		&Scalar::addSwappedMultiplied,
+		&Scalar::addMultipliedByBuffer,
+		&Scalar::addMultipliedByBuffers,
+		&Scalar::addSanitizedMultiplied,
+		&Scalar::addSanitizedMultipliedByBuffer,
+		&Scalar::addSanitizedMultipliedByBuffers,
+		&Scalar::addMultipliedStereo,
+		&Scalar::multiplyAndAddMultiplied,
+		&Scalar::multiplyAndAddMultipliedJoined
+	};
+	return &k;
+}
+
+
+static const Kernels* kernelsOf( InstructionSets set )
+{
+	switch( set )
+	{
+		case InstructionSetScalar: return scalarKernels();
+		case InstructionSetSSE2: return sse2Kernels();
+		case InstructionSetAVX2: return avx2Kernels();
+		case InstructionSetAVX512: return avx512Kernels();
+		case InstructionSetNEON: return neonKernels();
+		default: break;
+	}
+	return NULL;
+}
+
+
+bool isSupported( InstructionSets set )
+{
+	if( kernelsOf( set ) == NULL )
+	{
+		return false;
+	}
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+	switch( set )
+	{
+		case InstructionSetSSE2: return __builtin_cpu_supports( "sse2" );
+		case InstructionSetAVX2: return __builtin_cpu_supports( "avx2" );
+		case InstructionSetAVX512: return __builtin_cpu_supports( "avx512f" );
+		default: break;
+	}
+#endif
+	// everything else is only compiled in if the target always has it
+	return true;
+}
+
+
+static InstructionSets detectInstructionSet()
+{
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+	// we run before the constructors of libgcc
+	__builtin_cpu_init();
+#endif
+	const InstructionSets preferred[] = {
+		InstructionSetAVX512,
+		InstructionSetAVX2,
+		InstructionSetSSE2,
+		InstructionSetNEON
+	};
+	for( InstructionSets set : preferred )
+	{
+		if( isSupported( set ) )
+		{
+			return set;
+		}
+	}
+	return InstructionSetScalar;
+}
+
+
+static InstructionSets s_instructionSet = detectInstructionSet();
+static const Kernels* s_kernels = kernelsOf( s_instructionSet );
+
+
+InstructionSets instructionSet()
+{
+	return s_instructionSet;
+}
+
+
+bool setInstructionSet( InstructionSets set )
+{
+	if( !isSupported( set ) )
+	{
+		return false;
+	}
+	s_instructionSet = set;
+	s_kernels = kernelsOf( set );
+	return true;
+}
+
+
+const char* instructionSetName( InstructionSets set )
+{
+	switch( set )
+	{
+		case InstructionSetScalar: return "scalar";
+		case InstructionSetSSE2: return "SSE2";
+		case InstructionSetAVX2: return "AVX2";
+		case InstructionSetAVX512: return "AVX-512";
+		case InstructionSetNEON: return "NEON";
+		default: break;
+	}
+	return "unknown";
+}
+
+
+
+bool isSilent( const sampleFrame* src, int frames )
+{
+	return s_kernels->isSilent( src, frames );
+}
+
+float BufferAnalysis::rms() const
+{
+	return sqrtf( meanSquare / 2.0f );
+}
+
+BufferAnalysis analyze( const sampleFrame* src, int frames )
+{
+	return s_kernels->analyze( src, frames );
+}
+
+BufferAnalysis analyzeAndSanitize( sampleFrame* src, int frames )
+{
+	const BufferAnalysis analysis = analyze( src, frames );
+	// sanitize() also clamps the samples
+	if( useNaNHandler() && ( analysis.bad || analysis.peak() > 1000.0f ) )
+	{
+		sanitize( src, frames );
+		return analyze( src, frames );
+	}
+	return analysis;
+}
+
+bool useNaNHandler()
+{
+	return s_NaNHandler;
+}
+
+void setNaNHandler( bool use )
+{
+	s_NaNHandler = use;
+}
+
+/*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
+bool sanitize( sampleFrame * src, int frames )
+{
+	if( !useNaNHandler() )
+	{
+		return false;
+	}
+
+	bool found = false;
+	for( int f = 0; f < frames; ++f )
+	{
+		for( int c = 0; c < 2; ++c )
+		{
+			if( isinf( src[f][c] ) || isnan( src[f][c] ) )
+			{
+				#ifdef LMMS_DEBUG
+					printf("Bad data, clearing buffer. frame: ");
+					printf("%d: value %f\n", f, src[f][c]);
+				#endif
+				for( int f = 0; f < frames; ++f )
+				{
+					for( int c = 0; c < 2; ++c )
+					{
+						src[f][c] = 0.0f;
+					}
+				}
+				found = true;
+				return found;
+			}
+			else
+			{
+				src[f][c] = qBound( -1000.0f, src[f][c], 1000.0f );
+			}
+		}
+	}
+	return found;
+}
+
+/*! \brief Same as above, for planar buffers */
+bool sanitize( PlanarBuffer & src, int frames )
+{
+	if( !useNaNHandler() )
+	{
+		return false;
+	}
+
+	for( ch_cnt_t c = 0; c < src.channels(); ++c )
+	{
+		sample_t * samples = src.channel( c );
+		for( int f = 0; f < frames; ++f )
+		{
+			if( isinf( samples[f] ) || isnan( samples[f] ) )
+			{
+				#ifdef LMMS_DEBUG
+					printf("Bad data, clearing buffer. frame: ");
+					printf("%d: value %f\n", f, samples[f]);
+				#endif
+				src.clear( frames );
+				return true;
+			}
+			samples[f] = qBound( -1000.0f, samples[f], 1000.0f );
+		}
+	}
+	return false;
+}
+
+
+
+
+void add( sampleFrame* dst, const sampleFrame* src, int frames )
+{
+	s_kernels->add( dst, src, frames );
+}
+
+
+void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	s_kernels->addMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	s_kernels->addSwappedMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	s_kernels->addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	s_kernels->addMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf,
+								frames );
+		return;
+	}
+
+	s_kernels->addSanitizedMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultipliedByBuffers( dst, src, coeffSrcBuf1, coeffSrcBuf2,
+								frames );
+		return;
+	}
+
+	s_kernels->addSanitizedMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+
+void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultiplied( dst, src, coeffSrc, frames );
+		return;
+	}
+
+	s_kernels->addSanitizedMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
+{
+	s_kernels->addMultipliedStereo( dst, src, coeffSrcLeft, coeffSrcRight, frames );
+}
+
+
+void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
+{
+	s_kernels->multiplyAndAddMultiplied( dst, src, coeffDst, coeffSrc, frames );
+}
+
+
+void multiplyAndAddMultipliedJoined( sampleFrame* dst,
+										const sample_t* srcLeft,
+										const sample_t* srcRight,
+										float coeffDst, float coeffSrc, int frames )
+{
+	s_kernels->multiplyAndAddMultipliedJoined( dst, srcLeft, srcRight, coeffDst, coeffSrc, frames );
+}
+
 }
 
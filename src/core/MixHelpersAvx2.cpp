@@ -0,0 +1,105 @@
+/*
+ * MixHelpersAvx2.cpp - AVX2 kernels for MixHelpers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+namespace MixHelpers
+{
+
+#ifdef __AVX2__
+
+namespace
+{
+
+struct Avx2
+{
+	using Reg = __m256;
+	static const int Width = 8;
+
+	static inline Reg load( const float* p ) { return _mm256_loadu_ps( p ); }
+	static inline void store( float* p, Reg x ) { _mm256_storeu_ps( p, x ); }
+	static inline Reg set1( float x ) { return _mm256_set1_ps( x ); }
+	static inline Reg set2( float l, float r ) { return _mm256_setr_ps( l, r, l, r, l, r, l, r ); }
+	static inline Reg add( Reg a, Reg b ) { return _mm256_add_ps( a, b ); }
+	static inline Reg sub( Reg a, Reg b ) { return _mm256_sub_ps( a, b ); }
+	static inline Reg mul( Reg a, Reg b ) { return _mm256_mul_ps( a, b ); }
+	static inline Reg max( Reg a, Reg b ) { return _mm256_max_ps( a, b ); }
+
+	static inline Reg abs( Reg x )
+	{
+		return _mm256_and_ps( x,
+			_mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) ) );
+	}
+
+	static inline Reg swapPairs( Reg x )
+	{
+		return _mm256_permute_ps( x, 0xb1 );
+	}
+
+	static inline void zip( Reg a, Reg b, Reg& lo, Reg& hi )
+	{
+		// unpack works within 128 bit lanes, so reorder the lanes after
+		const Reg l = _mm256_unpacklo_ps( a, b );
+		const Reg h = _mm256_unpackhi_ps( a, b );
+		lo = _mm256_permute2f128_ps( l, h, 0x20 );
+		hi = _mm256_permute2f128_ps( l, h, 0x31 );
+	}
+
+	static inline Reg finite( Reg raw, Reg value )
+	{
+		const __m256i exponent = _mm256_set1_epi32( 0x7f800000 );
+		const __m256i bad = _mm256_cmpeq_epi32( _mm256_and_si256(
+				_mm256_castps_si256( raw ), exponent ), exponent );
+		return _mm256_andnot_ps( _mm256_castsi256_ps( bad ), value );
+	}
+
+	static inline bool anyLoud( Reg x, Reg threshold )
+	{
+		return _mm256_movemask_ps(
+			_mm256_cmp_ps( abs( x ), threshold, _CMP_GE_OQ ) ) != 0;
+	}
+} ;
+
+}
+
+const Kernels* avx2Kernels()
+{
+	return SimdKernels<Avx2>::kernels();
+}
+
+#else
+
+const Kernels* avx2Kernels()
+{
+	return NULL;
+}
+
+#endif
+
+}
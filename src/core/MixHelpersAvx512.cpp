@@ -0,0 +1,114 @@
+/*
+ * MixHelpersAvx512.cpp - AVX-512 kernels for MixHelpers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+#ifdef __AVX512F__
+#include <immintrin.h>
+#endif
+
+
+namespace MixHelpers
+{
+
+#ifdef __AVX512F__
+
+namespace
+{
+
+struct Avx512
+{
+	using Reg = __m512;
+	static const int Width = 16;
+
+	static inline Reg load( const float* p ) { return _mm512_loadu_ps( p ); }
+	static inline void store( float* p, Reg x ) { _mm512_storeu_ps( p, x ); }
+	static inline Reg set1( float x ) { return _mm512_set1_ps( x ); }
+	static inline Reg set2( float l, float r )
+	{
+		return _mm512_set_ps( r, l, r, l, r, l, r, l,
+					r, l, r, l, r, l, r, l );
+	}
+	static inline Reg add( Reg a, Reg b ) { return _mm512_add_ps( a, b ); }
+	static inline Reg sub( Reg a, Reg b ) { return _mm512_sub_ps( a, b ); }
+	static inline Reg mul( Reg a, Reg b ) { return _mm512_mul_ps( a, b ); }
+	static inline Reg max( Reg a, Reg b )
+	{
+		return _mm512_mask_blend_ps(
+				_mm512_cmp_ps_mask( a, b, _CMP_GT_OQ ), b, a );
+	}
+
+	static inline Reg abs( Reg x )
+	{
+		return _mm512_castsi512_ps( _mm512_and_epi32(
+				_mm512_castps_si512( x ), _mm512_set1_epi32( 0x7fffffff ) ) );
+	}
+
+	static inline Reg swapPairs( Reg x )
+	{
+		return _mm512_shuffle_ps( x, x, 0xb1 );
+	}
+
+	static inline void zip( Reg a, Reg b, Reg& lo, Reg& hi )
+	{
+		// indices >= 16 select from b
+		alignas(64) static const int loIndices[16] =
+			{ 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23 };
+		alignas(64) static const int hiIndices[16] =
+			{ 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31 };
+		lo = _mm512_permutex2var_ps( a, _mm512_load_si512( loIndices ), b );
+		hi = _mm512_permutex2var_ps( a, _mm512_load_si512( hiIndices ), b );
+	}
+
+	static inline Reg finite( Reg raw, Reg value )
+	{
+		const __m512i exponent = _mm512_set1_epi32( 0x7f800000 );
+		const __mmask16 good = _mm512_cmpneq_epi32_mask( _mm512_and_epi32(
+				_mm512_castps_si512( raw ), exponent ), exponent );
+		return _mm512_maskz_mov_ps( good, value );
+	}
+
+	static inline bool anyLoud( Reg x, Reg threshold )
+	{
+		return _mm512_cmp_ps_mask( abs( x ), threshold, _CMP_GE_OQ ) != 0;
+	}
+} ;
+
+}
+
+const Kernels* avx512Kernels()
+{
+	return SimdKernels<Avx512>::kernels();
+}
+
+#else
+
+const Kernels* avx512Kernels()
+{
+	return NULL;
+}
+
+#endif
+
+}
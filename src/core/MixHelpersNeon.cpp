@@ -0,0 +1,110 @@
+/*
+ * MixHelpersNeon.cpp - NEON kernels for MixHelpers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+// NEON is always available on AArch64, so there is nothing to detect
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define LMMS_MIX_HELPERS_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace MixHelpers
+{
+
+#ifdef LMMS_MIX_HELPERS_NEON
+
+namespace
+{
+
+struct Neon
+{
+	using Reg = float32x4_t;
+	static const int Width = 4;
+
+	static inline Reg load( const float* p ) { return vld1q_f32( p ); }
+	static inline void store( float* p, Reg x ) { vst1q_f32( p, x ); }
+	static inline Reg set1( float x ) { return vdupq_n_f32( x ); }
+	static inline Reg set2( float l, float r )
+	{
+		const float pair[2] = { l, r };
+		const float32x2_t p = vld1_f32( pair );
+		return vcombine_f32( p, p );
+	}
+	static inline Reg add( Reg a, Reg b ) { return vaddq_f32( a, b ); }
+	static inline Reg sub( Reg a, Reg b ) { return vsubq_f32( a, b ); }
+	static inline Reg mul( Reg a, Reg b ) { return vmulq_f32( a, b ); }
+	static inline Reg abs( Reg x ) { return vabsq_f32( x ); }
+
+	static inline Reg max( Reg a, Reg b )
+	{
+		// vmaxq_f32 would propagate nans
+		return vbslq_f32( vcgtq_f32( a, b ), a, b );
+	}
+
+	static inline Reg swapPairs( Reg x )
+	{
+		return vrev64q_f32( x );
+	}
+
+	static inline void zip( Reg a, Reg b, Reg& lo, Reg& hi )
+	{
+		const float32x4x2_t z = vzipq_f32( a, b );
+		lo = z.val[0];
+		hi = z.val[1];
+	}
+
+	static inline Reg finite( Reg raw, Reg value )
+	{
+		const uint32x4_t exponent = vdupq_n_u32( 0x7f800000 );
+		const uint32x4_t bad = vceqq_u32( vandq_u32(
+				vreinterpretq_u32_f32( raw ), exponent ), exponent );
+		return vreinterpretq_f32_u32(
+				vbicq_u32( vreinterpretq_u32_f32( value ), bad ) );
+	}
+
+	static inline bool anyLoud( Reg x, Reg threshold )
+	{
+		return vmaxvq_u32( vcgeq_f32( abs( x ), threshold ) ) != 0;
+	}
+} ;
+
+}
+
+const Kernels* neonKernels()
+{
+	return SimdKernels<Neon>::kernels();
+}
+
+#else
+
+const Kernels* neonKernels()
+{
+	return NULL;
+}
+
+#endif
+
+}
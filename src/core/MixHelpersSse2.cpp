@@ -0,0 +1,102 @@
+/*
+ * MixHelpersSse2.cpp - SSE2 kernels for MixHelpers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LMMS_MIX_HELPERS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace MixHelpers
+{
+
+#ifdef LMMS_MIX_HELPERS_SSE2
+
+namespace
+{
+
+struct Sse2
+{
+	using Reg = __m128;
+	static const int Width = 4;
+
+	static inline Reg load( const float* p ) { return _mm_loadu_ps( p ); }
+	static inline void store( float* p, Reg x ) { _mm_storeu_ps( p, x ); }
+	static inline Reg set1( float x ) { return _mm_set1_ps( x ); }
+	static inline Reg set2( float l, float r ) { return _mm_setr_ps( l, r, l, r ); }
+	static inline Reg add( Reg a, Reg b ) { return _mm_add_ps( a, b ); }
+	static inline Reg sub( Reg a, Reg b ) { return _mm_sub_ps( a, b ); }
+	static inline Reg mul( Reg a, Reg b ) { return _mm_mul_ps( a, b ); }
+	static inline Reg max( Reg a, Reg b ) { return _mm_max_ps( a, b ); }
+
+	static inline Reg abs( Reg x )
+	{
+		return _mm_and_ps( x, _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) ) );
+	}
+
+	static inline Reg swapPairs( Reg x )
+	{
+		return _mm_shuffle_ps( x, x, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+	}
+
+	static inline void zip( Reg a, Reg b, Reg& lo, Reg& hi )
+	{
+		lo = _mm_unpacklo_ps( a, b );
+		hi = _mm_unpackhi_ps( a, b );
+	}
+
+	static inline Reg finite( Reg raw, Reg value )
+	{
+		// inf and nan have all exponent bits set
+		const __m128i exponent = _mm_set1_epi32( 0x7f800000 );
+		const __m128i bad = _mm_cmpeq_epi32( _mm_and_si128(
+				_mm_castps_si128( raw ), exponent ), exponent );
+		return _mm_andnot_ps( _mm_castsi128_ps( bad ), value );
+	}
+
+	static inline bool anyLoud( Reg x, Reg threshold )
+	{
+		return _mm_movemask_ps( _mm_cmpge_ps( abs( x ), threshold ) ) != 0;
+	}
+} ;
+
+}
+
+const Kernels* sse2Kernels()
+{
+	return SimdKernels<Sse2>::kernels();
+}
+
+#else
+
+const Kernels* sse2Kernels()
+{
+	return NULL;
+}
+
+#endif
+
+}
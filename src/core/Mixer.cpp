@@ -24,19 +24,29 @@
 
 #include "Mixer.h"
 
+#include <memory>
+
 #include "denormals.h"
 
 #include "lmmsconfig.h"
 
 #include "AudioPort.h"
+#include "ControllerGraph.h"
+#include "DelayLinePool.h"
+#include "EngineContext.h"
 #include "FxMixer.h"
+#include "InstrumentTrack.h"
 #include "MixerWorkerThread.h"
+#include "MixHelpers.h"
+#include "PerfLog.h"
+#include "RealtimeCheck.h"
+#include "RealtimeMemory.h"
 #include "Song.h"
 #include "EnvelopeAndLfoParameters.h"
 #include "NotePlayHandle.h"
 #include "ConfigManager.h"
 #include "SamplePlayHandle.h"
-#include "MemoryHelper.h"
+#include "SampleTrack.h"
 
 // platform-specific audio-interface-classes
 #include "AudioAlsa.h"
@@ -46,6 +56,7 @@
 #include "AudioPortAudio.h"
 #include "AudioSoundIo.h"
 #include "AudioPulseAudio.h"
+#include "AudioPipeWire.h"
 #include "AudioSdl.h"
 #include "AudioDummy.h"
 
@@ -60,6 +71,7 @@
 #include "MidiDummy.h"
 
 #include "BufferManager.h"
+#include "LocklessRingBuffer.h"
 
 typedef LocklessList<PlayHandle *>::Element LocklessListElement;
 
@@ -72,13 +84,19 @@ static thread_local bool s_renderingThread;
 Mixer::Mixer( bool renderOnly ) :
 	m_renderOnly( renderOnly ),
 	m_framesPerPeriod( DEFAULT_BUFFER_SIZE ),
-	m_inputBufferRead( 0 ),
-	m_inputBufferWrite( 1 ),
+	m_inputFrames( new LocklessRingBuffer<sampleFrame>( InputFrames ) ),
+	m_inputReader( new LocklessRingBufferReader<sampleFrame>( *m_inputFrames ) ),
+	m_inputBuffer( new sampleFrame[InputFrames] ),
+	m_inputBufferFrames( 0 ),
 	m_outputBufferRead(nullptr),
 	m_outputBufferWrite(nullptr),
+	m_nextOutputBuffer(nullptr),
+	m_context( EngineContext::current() ),
 	m_workers(),
 	m_numWorkers( QThread::idealThreadCount()-1 ),
 	m_newPlayHandles( PlayHandle::MaxNumber ),
+	m_tracksWithInEvents( PlayHandle::MaxNumber ),
+	m_playHandleRemovalRequested( false ),
 	m_qualitySettings( qualitySettings::Mode_Draft ),
 	m_masterGain( 1.0f ),
 	m_isProcessing( false ),
@@ -86,20 +104,31 @@ Mixer::Mixer( bool renderOnly ) :
 	m_oldAudioDev( NULL ),
 	m_audioDevStartFailed( false ),
 	m_profiler(),
+	m_latencyProbe(),
+	m_outputTap( OutputTapPoints ),
 	m_metronomeActive(false),
+	m_lastMetroTicks(-1),
+	m_pipelined( false ),
+	m_cpuBudget( 0 ),
+	m_batchNotes( true ),
+	m_oneShotCaching( false ),
+	m_activeNotesPeriod( 0 ),
+	m_masterMixStage( [this]()
+	{
+		MixerProfiler::Probe probe( &m_profiler.stageTime(
+					MixerProfiler::StageMasterMix ), true );
+		PerfTrace::Scope trace( MixerProfiler::stageName(
+					MixerProfiler::StageMasterMix ), PerfTrace::Render );
+		// we're already running as a job, so don't use the worker threads
+		Engine::fxMixer()->masterMix( m_outputBufferWrite, false );
+	} ),
 	m_clearSignal( false ),
 	m_changesSignal( false ),
 	m_changes( 0 ),
 	m_doChangesMutex( QMutex::Recursive ),
 	m_waitingForWrite( false )
 {
-	for( int i = 0; i < 2; ++i )
-	{
-		m_inputBufferFrames[i] = 0;
-		m_inputBufferSize[i] = DEFAULT_BUFFER_SIZE * 100;
-		m_inputBuffer[i] = new sampleFrame[ DEFAULT_BUFFER_SIZE * 100 ];
-		BufferManager::clear( m_inputBuffer[i], m_inputBufferSize[i] );
-	}
+	BufferManager::clear( m_inputBuffer, InputFrames );
 
 	// determine FIFO size and number of frames per period
 	int fifoSize = 1;
@@ -108,42 +137,81 @@ Mixer::Mixer( bool renderOnly ) :
 	// size from user configuration
 	if( renderOnly == false )
 	{
-		m_framesPerPeriod = 
-			( fpp_t ) ConfigManager::inst()->
+		int frames = ConfigManager::inst()->
 				value( "mixer", "framesperaudiobuffer" ).toInt();
 
 		// if the value read from user configuration is not set or
 		// lower than the minimum allowed, use the default value and
 		// save it to the configuration
-		if( m_framesPerPeriod < MINIMUM_BUFFER_SIZE )
+		if( frames < MINIMUM_BUFFER_SIZE )
 		{
 			ConfigManager::inst()->setValue( "mixer",
 						"framesperaudiobuffer",
 						QString::number( DEFAULT_BUFFER_SIZE ) );
 
-			m_framesPerPeriod = DEFAULT_BUFFER_SIZE;
-		}
-		else if( m_framesPerPeriod > DEFAULT_BUFFER_SIZE )
-		{
-			fifoSize = m_framesPerPeriod / DEFAULT_BUFFER_SIZE;
-			m_framesPerPeriod = DEFAULT_BUFFER_SIZE;
+			frames = DEFAULT_BUFFER_SIZE;
 		}
+		splitAudioBuffer( frames, m_framesPerPeriod, fifoSize );
 	}
 
+	// lock the memory of the buffers below, if enabled
+	RealtimeMemory::init();
+
 	// allocte the FIFO from the determined size
-	m_fifo = new Fifo( fifoSize );
+	m_fifo = new Fifo( fifoSize, maxFramesPerPeriod() );
 
-	// now that framesPerPeriod is fixed initialize global BufferManager
-	BufferManager::init( m_framesPerPeriod );
+	// buffers are allocated for the longest period, so the period can
+	// change later on
+	BufferManager::init( maxFramesPerPeriod() );
 
-	int outputBufferSize = m_framesPerPeriod * sizeof(surroundSampleFrame);
-	m_outputBufferRead = static_cast<surroundSampleFrame *>(MemoryHelper::alignedMalloc(outputBufferSize));
-	m_outputBufferWrite = static_cast<surroundSampleFrame *>(MemoryHelper::alignedMalloc(outputBufferSize));
+	int outputBufferSize = maxFramesPerPeriod() * sizeof(surroundSampleFrame);
+	for( surroundSampleFrame * & buffer : m_outputBuffers )
+	{
+		buffer = static_cast<surroundSampleFrame *>(RealtimeMemory::allocate(outputBufferSize));
+		BufferManager::clear(buffer, maxFramesPerPeriod());
+	}
+	m_outputBufferRead = m_outputBuffers[0];
+	m_outputBufferWrite = m_outputBuffers[1];
 
-	BufferManager::clear(m_outputBufferRead, m_framesPerPeriod);
-	BufferManager::clear(m_outputBufferWrite, m_framesPerPeriod);
+	// only the main context has worker threads, the others run their jobs
+	// on the thread rendering them
+	const bool startsWorkers = m_context == EngineContext::mainContext();
+	if( startsWorkers )
+	{
+		const MixerWorkerThread::ThreadSettings threadSettings =
+			MixerWorkerThread::ThreadSettings::fromConfig();
+		MixerWorkerThread::setThreadSettings( threadSettings );
+		if( threadSettings.numWorkers > 0 )
+		{
+			m_numWorkers = threadSettings.numWorkers;
+		}
+
+		MixerWorkerThread::setWorkStealing( ConfigManager::inst()->value(
+					"mixer", "workstealing" ).toInt(), m_numWorkers + 1 );
+	}
+	else
+	{
+		m_numWorkers = 0;
+		m_inlineJobs.reset( new MixerWorkerThread::JobQueue );
+	}
+
+	m_profiler.flightRecorder().setEnabled( ConfigManager::inst()->value(
+					"mixer", "flightrecorder" ).toInt() );
+
+	// preallocate note play handles so that acquiring one never allocates
+	// while rendering
+	const int polyphonyBudget = ConfigManager::inst()->value(
+					"mixer", "polyphonybudget" ).toInt();
+	const int notes = polyphonyBudget > 0 ? polyphonyBudget : DEFAULT_NPH_POOL_SIZE;
+	NotePlayHandleManager::reserve( notes );
+	// and a buffer for each of them
+	BufferManager::reserve( notes + DEFAULT_BUFFER_POOL_SIZE );
+
+	m_cpuBudget = ConfigManager::inst()->value( "mixer", "cpubudget" ).toInt();
+	m_batchNotes = ConfigManager::inst()->value( "mixer", "batchnotes", "1" ).toInt();
+	m_oneShotCaching = ConfigManager::inst()->value( "mixer", "oneshotcache" ).toInt();
 
-	for( int i = 0; i < m_numWorkers+1; ++i )
+	for( int i = 0; startsWorkers && i < m_numWorkers+1; ++i )
 	{
 		MixerWorkerThread * wt = new MixerWorkerThread( this );
 		if( i < m_numWorkers )
@@ -160,35 +228,36 @@ Mixer::Mixer( bool renderOnly ) :
 Mixer::~Mixer()
 {
 	runChangesInModel();
+	runPostedChangesInModel();
+	collectGarbage();
 
 	for( int w = 0; w < m_numWorkers; ++w )
 	{
 		m_workers[w]->quit();
 	}
 
-	MixerWorkerThread::startAndWaitForJobs();
+	if( !m_workers.isEmpty() )
+	{
+		MixerWorkerThread::startAndWaitForJobs();
+	}
 
 	for( int w = 0; w < m_numWorkers; ++w )
 	{
 		m_workers[w]->wait( 500 );
 	}
 
-	while( m_fifo->available() )
-	{
-		delete[] m_fifo->read();
-	}
 	delete m_fifo;
 
 	delete m_midiClient;
 	delete m_audioDev;
 
-	MemoryHelper::alignedFree(m_outputBufferRead);
-	MemoryHelper::alignedFree(m_outputBufferWrite);
-
-	for( int i = 0; i < 2; ++i )
+	for( surroundSampleFrame * buffer : m_outputBuffers )
 	{
-		delete[] m_inputBuffer[i];
+		RealtimeMemory::release( buffer,
+			maxFramesPerPeriod() * sizeof( surroundSampleFrame ) );
 	}
+
+	delete[] m_inputBuffer;
 }
 
 
@@ -213,7 +282,7 @@ void Mixer::initDevices()
 
 void Mixer::startProcessing(bool needsFifo)
 {
-	if (needsFifo)
+	if (needsFifo && m_audioDev->needsFifo())
 	{
 		m_fifoWriter = new fifoWriter( this, m_fifo );
 		m_fifoWriter->start( QThread::HighPriority );
@@ -300,31 +369,20 @@ bool Mixer::criticalXRuns() const
 
 
 
-void Mixer::pushInputFrames( sampleFrame * _ab, const f_cnt_t _frames )
+f_cnt_t Mixer::nominalLatency() const
 {
-	requestChangeInModel();
-
-	f_cnt_t frames = m_inputBufferFrames[ m_inputBufferWrite ];
-	int size = m_inputBufferSize[ m_inputBufferWrite ];
-	sampleFrame * buf = m_inputBuffer[ m_inputBufferWrite ];
-
-	if( frames + _frames > size )
-	{
-		size = qMax( size * 2, frames + _frames );
-		sampleFrame * ab = new sampleFrame[ size ];
-		memcpy( ab, buf, frames * sizeof( sampleFrame ) );
-		delete [] buf;
+	return m_framesPerPeriod * ( hasFifoWriter() ? m_fifo->depth() : 1 );
+}
 
-		m_inputBufferSize[ m_inputBufferWrite ] = size;
-		m_inputBuffer[ m_inputBufferWrite ] = ab;
 
-		buf = ab;
-	}
 
-	memcpy( &buf[ frames ], _ab, _frames * sizeof( sampleFrame ) );
-	m_inputBufferFrames[ m_inputBufferWrite ] += _frames;
 
-	doneChangeInModel();
+void Mixer::pushInputFrames( sampleFrame * _ab, const f_cnt_t _frames )
+{
+	// neither the capturing thread nor the audio thread waits for the
+	// other or allocates memory; if the audio thread doesn't keep up,
+	// better drop frames than stall the capture
+	m_inputFrames->write( _ab, _frames );
 }
 
 
@@ -332,111 +390,323 @@ void Mixer::pushInputFrames( sampleFrame * _ab, const f_cnt_t _frames )
 
 const surroundSampleFrame * Mixer::renderNextBuffer()
 {
+	EngineContext::Scope context( m_context );
+	// null for the main context, whose jobs go to the worker threads
+	MixerWorkerThread::InlineJobs inlineJobs( m_inlineJobs.get() );
+	RealtimeCheck::Scope realtime;
+	PerfTrace::Scope periodTrace( "period", PerfTrace::Render );
 	m_profiler.startPeriod();
 
+	// depending on the audio device, this may run on the thread of the
+	// device or of the renderer rather than on the fifo writer
+	disable_denormals();
+
 	s_renderingThread = true;
 
+	runPostedChangesInModel();
+
 	if( m_clearSignal )
 	{
 		m_clearSignal = false;
 		clearInternal();
 	}
 
-	// remove all play-handles that have to be deleted and delete
-	// them if they still exist...
-	// maybe this algorithm could be optimized...
-	ConstPlayHandleList::Iterator it_rem = m_playHandlesToRemove.begin();
-	while( it_rem != m_playHandlesToRemove.end() )
+	// remove all play-handles that have to be deleted
+	if( m_playHandleRemovalRequested )
 	{
-		PlayHandleList::Iterator it = std::find( m_playHandles.begin(), m_playHandles.end(), *it_rem );
-
-		if( it != m_playHandles.end() )
-		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			m_playHandles.erase( it );
-		}
-
-		it_rem = m_playHandlesToRemove.erase( it_rem );
+		removePlayHandles( false );
 	}
 
 	swapBuffers();
 
-	// prepare master mix (clear internal buffers etc.)
 	FxMixer * fxMixer = Engine::fxMixer();
-	fxMixer->prepareMasterMix();
+	if( !m_pipelined )
+	{
+		// prepare master mix (clear internal buffers etc.) - when
+		// pipelined, the master channel still holds the input of the
+		// previous period here
+		fxMixer->prepareMasterMix();
+	}
 
 	handleMetronome();
 
-	// create play-handles for new notes, samples etc.
-	Engine::getSong()->processNextBuffer();
+	{
+		MixerProfiler::Probe probe( &m_profiler.stageTime(
+					MixerProfiler::StageSong ), true );
+		PerfTrace::Scope trace( MixerProfiler::stageName(
+					MixerProfiler::StageSong ), PerfTrace::Render );
+		// create play-handles for new notes, samples etc.
+		Engine::getSong()->processNextBuffer();
+	}
+
+	// start the notes played on MIDI devices, which must be done before
+	// the new play handles are registered
+	processQueuedInEvents();
 
 	// add all play-handles that have to be added
 	for( LocklessListElement * e = m_newPlayHandles.popList(); e; )
 	{
-		m_playHandles += e->value;
+		registerPlayHandle( e->value );
+		if( e->value->type() == PlayHandle::TypeNotePlayHandle )
+		{
+			NotePlayHandle * n = static_cast<NotePlayHandle *>( e->value );
+			if( !n->hasParent() )
+			{
+				n->instrumentTrack()->limitPolyphony( n );
+			}
+		}
 		LocklessListElement * next = e->next;
 		m_newPlayHandles.free( e );
 		e = next;
 	}
 
+	// the load means nothing when rendering offline
+	if( m_cpuBudget > 0 && m_profiler.cpuLoad() > m_cpuBudget &&
+		!Engine::getSong()->isExporting() )
+	{
+		stealQuietestVoice();
+	}
+
+	// calculate the buffers of all controllers, so the play handles only
+	// have to read them
+	m_context->controllerGraph()->update();
+
 	// STAGE 1: run and render all play handles
-	MixerWorkerThread::fillJobQueue<PlayHandleList>( m_playHandles );
-	MixerWorkerThread::startAndWaitForJobs();
+	{
+		MixerProfiler::Probe probe( &m_profiler.stageTime(
+					MixerProfiler::StagePlayHandles ), true );
+		PerfTrace::Scope trace( MixerProfiler::stageName(
+					MixerProfiler::StagePlayHandles ), PerfTrace::Render );
+		updateActiveNotes();
+		queuePlayHandles();
+		if( m_pipelined )
+		{
+			// mix down the previous period at the same time
+			MixerWorkerThread::addJob( &m_masterMixStage );
+		}
+		MixerWorkerThread::startAndWaitForJobs();
+	}
+	m_masterMixStage.reset();
 
 	// removed all play handles which are done
-	for( PlayHandleList::Iterator it = m_playHandles.begin();
-						it != m_playHandles.end(); )
+	removePlayHandles( true );
+
+	// STAGE 2: process effects of all instrument- and sampletracks
+	{
+		MixerProfiler::Probe probe( &m_profiler.stageTime(
+					MixerProfiler::StageAudioPorts ), true );
+		PerfTrace::Scope trace( MixerProfiler::stageName(
+					MixerProfiler::StageAudioPorts ), PerfTrace::Render );
+		MixerWorkerThread::fillJobQueue<QVector<AudioPort *> >( m_audioPorts );
+		MixerWorkerThread::startAndWaitForJobs();
+	}
+
+
+	// STAGE 3: do master mix in FX mixer (already done in stage 1 when
+	// pipelined, the FX channels now hold the input for the next period)
+	if( !m_pipelined )
+	{
+		MixerProfiler::Probe probe( &m_profiler.stageTime(
+					MixerProfiler::StageMasterMix ), true );
+		PerfTrace::Scope trace( MixerProfiler::stageName(
+					MixerProfiler::StageMasterMix ), PerfTrace::Render );
+		fxMixer->masterMix(m_outputBufferWrite);
+	}
+
+	m_latencyProbe.process( m_outputBufferWrite, m_framesPerPeriod,
+					m_inputBuffer, m_inputBufferFrames );
+
+
+	if( !Engine::getSong()->isExporting() )
+	{
+		m_outputTap.write( m_outputBufferRead, m_framesPerPeriod );
+	}
+
+	runChangesInModel();
+
+	// no effect is processed now, so the delay lines of sleeping effects
+	// can be taken back
+	DelayLinePool::collect( m_framesPerPeriod, processingSampleRate() );
+
+	// and trigger LFOs
+	EnvelopeAndLfoParameters::instances()->trigger();
+	Controller::triggerFrameCounter();
+	m_context->nextPeriod();
+
+	s_renderingThread = false;
+
+	m_profiler.finishPeriod( processingSampleRate(), m_framesPerPeriod,
+							m_playHandles.size() );
+
+	return m_outputBufferRead;
+}
+
+
+
+
+void Mixer::queuePlayHandles()
+{
+	MixerWorkerThread::resetJobQueue();
+	if( !m_batchNotes )
+	{
+		for( PlayHandle * ph : m_playHandles )
+		{
+			MixerWorkerThread::addJob( ph );
+		}
+		return;
+	}
+
+	size_t batches = 0;
+	for( PlayHandle * ph : m_playHandles )
 	{
-		if( ( *it )->affinityMatters() &&
-			( *it )->affinity() != QThread::currentThread() )
+		AudioPort * port = ph->audioPort();
+		if( ph->type() != PlayHandle::TypeNotePlayHandle || port == nullptr )
 		{
-			++it;
+			MixerWorkerThread::addJob( ph );
 			continue;
 		}
-		if( ( *it )->isFinished() )
+		if( port->m_noteBatch < 0 ||
+			m_noteBatches[port->m_noteBatch]->m_handles.size() >= NoteBatch::MaxNotes )
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
+			if( batches == m_noteBatches.size() )
 			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
+				m_noteBatches.emplace_back( new NoteBatch );
 			}
-			else delete *it;
-			it = m_playHandles.erase( it );
+			m_noteBatches[batches]->m_handles.clear();
+			port->m_noteBatch = batches++;
 		}
-		else
+		m_noteBatches[port->m_noteBatch]->m_handles.append( ph );
+	}
+
+	for( size_t i = 0; i < batches; ++i )
+	{
+		NoteBatch * batch = m_noteBatches[i].get();
+		batch->m_handles.first()->audioPort()->m_noteBatch = -1;
+		MixerWorkerThread::addJob( batch );
+	}
+}
+
+
+
+
+void Mixer::processQueuedInEvents()
+{
+	for( auto * e = m_tracksWithInEvents.popList(); e; )
+	{
+		e->value->processQueuedInEvents();
+		auto * next = e->next;
+		m_tracksWithInEvents.free( e );
+		e = next;
+	}
+}
+
+
+
+
+void Mixer::unscheduleQueuedInEvents( const InstrumentTrack * track )
+{
+	// other tracks may be scheduled while we sort them out, which only
+	// changes the order the tracks are processed in
+	for( auto * e = m_tracksWithInEvents.popList(); e; )
+	{
+		InstrumentTrack * other = e->value;
+		auto * next = e->next;
+		m_tracksWithInEvents.free( e );
+		if( other != track )
 		{
-			++it;
+			m_tracksWithInEvents.push( other );
 		}
+		e = next;
 	}
+}
 
-	// STAGE 2: process effects of all instrument- and sampletracks
-	MixerWorkerThread::fillJobQueue<QVector<AudioPort *> >( m_audioPorts );
-	MixerWorkerThread::startAndWaitForJobs();
 
 
-	// STAGE 3: do master mix in FX mixer
-	fxMixer->masterMix(m_outputBufferWrite);
 
+bool Mixer::isRenderingThread()
+{
+	return s_renderingThread;
+}
 
-	emit nextAudioBuffer(m_outputBufferRead);
 
-	runChangesInModel();
 
-	// and trigger LFOs
-	EnvelopeAndLfoParameters::instances()->trigger();
-	Controller::triggerFrameCounter();
-	AutomatableModel::incrementPeriodCounter();
 
-	s_renderingThread = false;
+void Mixer::updateActiveNotes()
+{
+	// the lists of tracks without notes in this period are outdated, which
+	// InstrumentTrack::activeNotes() recognizes by the period
+	++m_activeNotesPeriod;
+	for( PlayHandle * ph : m_playHandles )
+	{
+		if( ph->type() != PlayHandle::TypeNotePlayHandle )
+		{
+			continue;
+		}
+		const NotePlayHandle * n = static_cast<const NotePlayHandle *>( ph );
+		if( n->hasParent() || n->isReleased() )
+		{
+			continue;
+		}
+		InstrumentTrack * track = n->instrumentTrack();
+		if( track->m_activeNotesPeriod != m_activeNotesPeriod )
+		{
+			// keeps the capacity, so this doesn't allocate once the
+			// track played its most notes at once
+			track->m_activeNotes.clear();
+			track->m_activeNotesPeriod = m_activeNotesPeriod;
+		}
+		track->m_activeNotes.push_back( n );
+	}
+}
 
-	m_profiler.finishPeriod( processingSampleRate(), m_framesPerPeriod );
 
-	return m_outputBufferRead;
+
+
+void Mixer::NoteBatch::doProcessing()
+{
+	for( PlayHandle * ph : m_handles )
+	{
+		if( ph->requiresProcessing() )
+		{
+			ph->queue();
+			ph->process();
+		}
+	}
+}
+
+
+
+
+void Mixer::stealQuietestVoice()
+{
+	NotePlayHandle * victim = nullptr;
+	float level = 0;
+	for( PlayHandle * ph : m_playHandles )
+	{
+		if( ph->type() != PlayHandle::TypeNotePlayHandle )
+		{
+			continue;
+		}
+		NotePlayHandle * n = static_cast<NotePlayHandle *>( ph );
+		// leave notes alone which didn't even start yet
+		if( n->hasParent() || n->isStolen() || n->totalFramesPlayed() == 0 )
+		{
+			continue;
+		}
+		const float l = n->audibility();
+		if( victim == nullptr || l < level )
+		{
+			victim = n;
+			level = l;
+		}
+	}
+
+	if( victim )
+	{
+		victim->lock();
+		victim->steal();
+		victim->unlock();
+	}
 }
 
 
@@ -444,9 +714,22 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 
 void Mixer::swapBuffers()
 {
-	m_inputBufferWrite = (m_inputBufferWrite + 1) % 2;
-	m_inputBufferRead = (m_inputBufferRead + 1) % 2;
-	m_inputBufferFrames[m_inputBufferWrite] = 0;
+	// take over the frames captured since the previous period
+	auto input = m_inputReader->read_max( InputFrames );
+	m_inputBufferFrames = input.size();
+	for( f_cnt_t f = 0; f < m_inputBufferFrames; ++f )
+	{
+		m_inputBuffer[f] = input[f];
+	}
+
+	if( m_nextOutputBuffer )
+	{
+		// the FIFO writer passes the buffer read last on to the device
+		m_outputBufferRead = m_outputBufferWrite;
+		m_outputBufferWrite = m_nextOutputBuffer;
+		m_nextOutputBuffer = nullptr;
+		return;
+	}
 
 	std::swap(m_outputBufferRead, m_outputBufferWrite);
 	BufferManager::clear(m_outputBufferWrite, m_framesPerPeriod);
@@ -455,10 +738,18 @@ void Mixer::swapBuffers()
 
 
 
-void Mixer::handleMetronome()
+void Mixer::setPipelined( bool enabled )
 {
-	static tick_t lastMetroTicks = -1;
+	requestChangeInModel();
+	m_pipelined = enabled;
+	doneChangeInModel();
+}
 
+
+
+
+void Mixer::handleMetronome()
+{
 	Song * song = Engine::getSong();
 	Song::PlayModes currentPlayMode = song->playMode();
 
@@ -482,7 +773,7 @@ void Mixer::handleMetronome()
 	tick_t ticksPerBar = TimePos::ticksPerBar();
 	int numerator = song->getTimeSigModel().getNumerator();
 
-	if (ticks == lastMetroTicks)
+	if (ticks == m_lastMetroTicks)
 	{
 		return;
 	}
@@ -496,7 +787,7 @@ void Mixer::handleMetronome()
 		addPlayHandle(new SamplePlayHandle("misc/metronome01.ogg"));
 	}
 
-	lastMetroTicks = ticks;
+	m_lastMetroTicks = ticks;
 }
 
 
@@ -532,7 +823,8 @@ void Mixer::clearInternal()
 	{
 		if (ph->type() != PlayHandle::TypeInstrumentPlayHandle)
 		{
-			m_playHandlesToRemove.push_back(ph);
+			ph->m_removalRequested = true;
+			m_playHandleRemovalRequested = true;
 		}
 
 	}
@@ -541,27 +833,81 @@ void Mixer::clearInternal()
 
 
 
-Mixer::StereoSample Mixer::getPeakValues(sampleFrame * ab, const f_cnt_t frames) const
+void Mixer::registerPlayHandle( PlayHandle * handle )
 {
-	sample_t peakLeft = 0.0f;
-	sample_t peakRight = 0.0f;
+	handle->m_mixerIndex = m_playHandles.size();
+	m_playHandles.append( handle );
+}
 
-	for (f_cnt_t f = 0; f < frames; ++f)
-	{
-		float const absLeft = qAbs(ab[f][0]);
-		float const absRight = qAbs(ab[f][1]);
-		if (absLeft > peakLeft)
+
+
+
+void Mixer::unregisterPlayHandle( PlayHandle * handle )
+{
+	const int index = handle->m_mixerIndex;
+	PlayHandle * last = m_playHandles.last();
+	m_playHandles[index] = last;
+	last->m_mixerIndex = index;
+	m_playHandles.removeLast();
+	handle->m_mixerIndex = -1;
+}
+
+
+
+
+void Mixer::removePlayHandles( bool finished )
+{
+	// compact the list in place, keeping the order of the handles
+	int kept = 0;
+	for( int i = 0; i < m_playHandles.size(); ++i )
+	{
+		PlayHandle * ph = m_playHandles[i];
+		const bool remove = ph->m_removalRequested ||
+			( finished && ph->isFinished() &&
+				!( ph->affinityMatters() &&
+					ph->affinity() != QThread::currentThread() ) );
+		if( remove )
 		{
-			peakLeft = absLeft;
+			ph->m_mixerIndex = -1;
+			deletePlayHandle( ph );
 		}
-
-		if (absRight > peakRight)
+		else
 		{
-			peakRight = absRight;
+			ph->m_mixerIndex = kept;
+			m_playHandles[kept++] = ph;
 		}
 	}
+	while( m_playHandles.size() > kept )
+	{
+		m_playHandles.removeLast();
+	}
+
+	m_playHandleRemovalRequested = false;
+}
+
 
-	return StereoSample(peakLeft, peakRight);
+
+
+void Mixer::deletePlayHandle( PlayHandle * handle )
+{
+	if( handle->audioPort() )
+	{
+		handle->audioPort()->removePlayHandle( handle );
+	}
+	if( handle->type() == PlayHandle::TypeNotePlayHandle )
+	{
+		NotePlayHandleManager::release( (NotePlayHandle*) handle );
+	}
+	else delete handle;
+}
+
+
+
+
+Mixer::StereoSample Mixer::getPeakValues(sampleFrame * ab, const f_cnt_t frames) const
+{
+	const MixHelpers::BufferAnalysis analysis = MixHelpers::analyze(ab, frames);
+	return StereoSample(analysis.peakLeft, analysis.peakRight);
 }
 
 
@@ -584,6 +930,70 @@ void Mixer::changeQuality(const struct qualitySettings & qs)
 
 
 
+void Mixer::changeFramesPerAudioBuffer( int frames )
+{
+	fpp_t framesPerPeriod;
+	int fifoSize;
+	splitAudioBuffer( qMax<int>( frames, MINIMUM_BUFFER_SIZE ),
+						framesPerPeriod, fifoSize );
+	if( framesPerPeriod == m_framesPerPeriod &&
+						fifoSize == m_fifo->depth() )
+	{
+		return;
+	}
+
+	// don't delete the audio-device
+	const bool wasProcessing = m_isProcessing;
+	const bool hadFifoWriter = m_fifoWriter != NULL;
+	if( wasProcessing )
+	{
+		stopProcessing();
+	}
+
+	m_framesPerPeriod = framesPerPeriod;
+	if( fifoSize != m_fifo->depth() )
+	{
+		delete m_fifo;
+		m_fifo = new Fifo( fifoSize, maxFramesPerPeriod() );
+	}
+	for( surroundSampleFrame * buffer : m_outputBuffers )
+	{
+		BufferManager::clear( buffer, maxFramesPerPeriod() );
+	}
+
+	emit framesPerPeriodChanged();
+
+	if( wasProcessing )
+	{
+		startProcessing( hadFifoWriter );
+	}
+}
+
+
+
+
+void Mixer::splitAudioBuffer( int frames, fpp_t & framesPerPeriod,
+							int & fifoSize ) const
+{
+	framesPerPeriod = frames;
+	fifoSize = 1;
+	if( frames > DEFAULT_BUFFER_SIZE )
+	{
+		fifoSize = frames / DEFAULT_BUFFER_SIZE;
+		framesPerPeriod = DEFAULT_BUFFER_SIZE;
+	}
+
+	// a deeper FIFO trades latency for robustness against xruns
+	const int fifoDepth = ConfigManager::inst()->value( "mixer", "fifodepth" ).toInt();
+	if( m_renderOnly == false && fifoDepth > 0 )
+	{
+		fifoSize = fifoDepth;
+	}
+}
+
+
+
+
 void Mixer::doSetAudioDevice( AudioDevice * _dev )
 {
 	// TODO: Use shared_ptr here in the future.
@@ -674,7 +1084,10 @@ bool Mixer::addPlayHandle( PlayHandle* handle )
 	if( criticalXRuns() == false )
 	{
 		m_newPlayHandles.push( handle );
-		handle->audioPort()->addPlayHandle( handle );
+		if( handle->audioPort() )
+		{
+			handle->audioPort()->addPlayHandle( handle );
+		}
 		return true;
 	}
 
@@ -695,7 +1108,10 @@ void Mixer::removePlayHandle(PlayHandle * ph)
 	// which were created in a thread different than mixer thread
 	if (ph->affinityMatters() && ph->affinity() == QThread::currentThread())
 	{
-		ph->audioPort()->removePlayHandle(ph);
+		if (ph->audioPort())
+		{
+			ph->audioPort()->removePlayHandle(ph);
+		}
 		bool removedFromList = false;
 		// Check m_newPlayHandles first because doing it the other way around
 		// creates a race condition
@@ -718,10 +1134,9 @@ void Mixer::removePlayHandle(PlayHandle * ph)
 			}
 		}
 		// Now check m_playHandles
-		PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), ph);
-		if (it != m_playHandles.end())
+		if (isRegistered(ph))
 		{
-			m_playHandles.erase(it);
+			unregisterPlayHandle(ph);
 			removedFromList = true;
 		}
 		// Only deleting PlayHandles that were actually found in the list
@@ -738,7 +1153,10 @@ void Mixer::removePlayHandle(PlayHandle * ph)
 	}
 	else
 	{
-		m_playHandlesToRemove.push_back(ph);
+		// removed by the mixer thread at the start of the next period or,
+		// if the handle is still queued, after it has been processed once
+		ph->m_removalRequested = true;
+		m_playHandleRemovalRequested = true;
 	}
 	doneChangeInModel();
 }
@@ -749,22 +1167,37 @@ void Mixer::removePlayHandle(PlayHandle * ph)
 void Mixer::removePlayHandlesOfTypes(Track * track, const quint8 types)
 {
 	requestChangeInModel();
-	PlayHandleList::Iterator it = m_playHandles.begin();
-	while( it != m_playHandles.end() )
+	// only look at the handles of the track's audio port rather than at
+	// all handles, if the track has one
+	AudioPort * port = nullptr;
+	if( track->type() == Track::InstrumentTrack )
 	{
-		if ((*it)->isFromTrack(track) && ((*it)->type() & types))
-		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			it = m_playHandles.erase( it );
-		}
-		else
+		port = static_cast<InstrumentTrack *>( track )->audioPort();
+	}
+	else if( track->type() == Track::SampleTrack )
+	{
+		port = static_cast<SampleTrack *>( track )->audioPort();
+	}
+
+	PlayHandleList candidates;
+	if( port )
+	{
+		port->m_playHandleLock.lock();
+		candidates = port->m_playHandles;
+		port->m_playHandleLock.unlock();
+	}
+	else
+	{
+		candidates = m_playHandles;
+	}
+
+	for( PlayHandle * ph : candidates )
+	{
+		if( isRegistered( ph ) && ph->isFromTrack( track ) &&
+							( ph->type() & types ) )
 		{
-			++it;
+			unregisterPlayHandle( ph );
+			deletePlayHandle( ph );
 		}
 	}
 	doneChangeInModel();
@@ -773,11 +1206,45 @@ void Mixer::removePlayHandlesOfTypes(Track * track, const quint8 types)
 
 
 
+void Mixer::postChangeInModel( LocklessCommandQueue::Command change,
+				LocklessCommandQueue::Command cleanup )
+{
+	m_postedChanges.post( change, cleanup );
+}
+
+
+
+
+void Mixer::collectGarbage()
+{
+	if( !s_renderingThread )
+	{
+		m_postedChanges.reclaim();
+		// grow the buffer pool if rendering found it running low
+		BufferManager::reserve( 0 );
+		// and the locked memory if rendering took the spare segment
+		RealtimeMemory::reserve( 0 );
+	}
+}
+
+
+
+
+void Mixer::runPostedChangesInModel()
+{
+	m_postedChanges.process();
+}
+
+
+
+
 void Mixer::requestChangeInModel()
 {
 	if( s_renderingThread )
 		return;
 
+	collectGarbage();
+
 	m_changesMutex.lock();
 	m_changes++;
 	m_changesMutex.unlock();
@@ -790,6 +1257,10 @@ void Mixer::requestChangeInModel()
 		m_changesRequestCondition.wait( &m_waitChangesMutex );
 	}
 	m_waitChangesMutex.unlock();
+
+	// changes posted before must be done before this one, e.g. an audio
+	// port has to be added before it can be removed
+	runPostedChangesInModel();
 }
 
 
@@ -854,6 +1325,14 @@ bool Mixer::isAudioDevNameValid(QString name)
 #endif
 
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	if (name == AudioPipeWire::name())
+	{
+		return true;
+	}
+#endif
+
+
 #ifdef LMMS_HAVE_OSS
 	if (name == AudioOss::name())
 	{
@@ -1005,6 +1484,20 @@ AudioDevice * Mixer::tryAudioDevices()
 #endif
 
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	if( dev_name == AudioPipeWire::name() || dev_name == "" )
+	{
+		dev = new AudioPipeWire( success_ful, this );
+		if( success_ful )
+		{
+			m_audioDevName = AudioPipeWire::name();
+			return dev;
+		}
+		delete dev;
+	}
+#endif
+
+
 #ifdef LMMS_HAVE_OSS
 	if( dev_name == AudioOss::name() || dev_name == "" )
 	{
@@ -1244,6 +1737,7 @@ void Mixer::fifoWriter::finish()
 void Mixer::fifoWriter::run()
 {
 	disable_denormals();
+	PerfTrace::setThreadName( "Mixer" );
 
 #if 0
 #if defined(LMMS_BUILD_LINUX) || defined(LMMS_BUILD_FREEBSD)
@@ -1256,33 +1750,48 @@ void Mixer::fifoWriter::run()
 #endif
 #endif
 
-	const fpp_t frames = m_mixer->framesPerPeriod();
+	// The mixer renders straight into the buffers of the FIFO. It returns
+	// the period rendered the call before, so the buffer acquired for a
+	// period is published after the next one.
+	bool rendered = false;
 	while( m_writing )
 	{
-		surroundSampleFrame * buffer = new surroundSampleFrame[frames];
-		const surroundSampleFrame * b = m_mixer->renderNextBuffer();
-		memcpy( buffer, b, frames * sizeof( surroundSampleFrame ) );
-		write( buffer );
+		m_mixer->m_nextOutputBuffer = acquire();
+		m_mixer->renderNextBuffer();
+		if( rendered )
+		{
+			m_fifo->publish();
+		}
+		rendered = true;
 	}
 
+	// Give the mixer its own buffers back for rendering without FIFO
+	m_fifo->discardAcquired();
+	m_mixer->m_outputBufferRead = m_mixer->m_outputBuffers[0];
+	m_mixer->m_outputBufferWrite = m_mixer->m_outputBuffers[1];
+	BufferManager::clear( m_mixer->m_outputBufferRead, m_mixer->m_framesPerPeriod );
+	BufferManager::clear( m_mixer->m_outputBufferWrite, m_mixer->m_framesPerPeriod );
+
 	// Let audio backend stop processing
-	write( NULL );
+	m_fifo->publishEnd();
 	m_fifo->waitUntilRead();
 }
 
 
 
 
-void Mixer::fifoWriter::write( surroundSampleFrame * buffer )
+surroundSampleFrame * Mixer::fifoWriter::acquire()
 {
 	m_mixer->m_waitChangesMutex.lock();
 	m_mixer->m_waitingForWrite = true;
 	m_mixer->m_waitChangesMutex.unlock();
 	m_mixer->runChangesInModel();
 
-	m_fifo->write( buffer );
+	surroundSampleFrame * buffer = m_fifo->acquire();
 
 	m_mixer->m_doChangesMutex.lock();
 	m_mixer->m_waitingForWrite = false;
 	m_mixer->m_doChangesMutex.unlock();
+
+	return buffer;
 }
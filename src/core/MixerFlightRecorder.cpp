@@ -0,0 +1,319 @@
+/*
+ * MixerFlightRecorder.cpp - keeps the timing of recent periods for
+ *                           post-mortem analysis of xruns
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixerFlightRecorder.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+#include <cstring>
+#include <vector>
+
+#include "ThreadableJob.h"
+
+
+static QString typeName( const std::type_info * type )
+{
+	if( type == nullptr )
+	{
+		return "?";
+	}
+#ifdef __GNUC__
+	int status = 0;
+	char * demangled = abi::__cxa_demangle( type->name(), nullptr, nullptr, &status );
+	if( demangled )
+	{
+		const QString name( demangled );
+		free( demangled );
+		return name;
+	}
+#endif
+	return type->name();
+}
+
+
+
+
+MixerFlightRecorder::MixerFlightRecorder() :
+	m_enabled( false ),
+	m_begin( Clock::now() ),
+	m_periodStart( m_begin ),
+	m_written( 0 ),
+	m_dumpReason( nullptr ),
+	m_dumpTimer(),
+	m_lastDump( m_begin ),
+	m_dumped( false )
+{
+	memset( m_periods, 0, sizeof( m_periods ) );
+	memset( m_workers, 0, sizeof( m_workers ) );
+	for( int i = 0; i < Capacity; ++i )
+	{
+		m_sequence[i] = 0;
+	}
+
+	connect( &m_dumpTimer, SIGNAL( timeout() ),
+				this, SLOT( dumpIfRequested() ) );
+}
+
+
+
+
+MixerFlightRecorder::~MixerFlightRecorder()
+{
+}
+
+
+
+
+void MixerFlightRecorder::setEnabled( bool enabled )
+{
+	m_enabled = enabled;
+	if( enabled )
+	{
+		m_dumpTimer.start( 500 );
+	}
+	else
+	{
+		m_dumpTimer.stop();
+	}
+}
+
+
+
+
+void MixerFlightRecorder::startPeriod()
+{
+	if( !isEnabled() )
+	{
+		return;
+	}
+
+	m_periodStart = Clock::now();
+	// the workers are idle between periods
+	memset( m_workers, 0, sizeof( m_workers ) );
+}
+
+
+
+
+void MixerFlightRecorder::finishPeriod( int elapsed, int deadline,
+		const int * stageTime, int stageCount, int playHandles )
+{
+	if( !isEnabled() )
+	{
+		return;
+	}
+
+	const quint64 index = m_written.load( std::memory_order_relaxed );
+	const int slot = index % Capacity;
+	m_sequence[slot].fetch_add( 1, std::memory_order_acq_rel );
+
+	Period & period = m_periods[slot];
+	period.start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					m_periodStart - m_begin ).count();
+	period.elapsed = elapsed;
+	period.deadline = deadline;
+	for( int i = 0; i < MaxStages; ++i )
+	{
+		period.stageTime[i] = i < stageCount ? stageTime[i] : 0;
+	}
+	period.playHandles = playHandles;
+	for( JobRecord & job : period.longestJobs )
+	{
+		job = JobRecord{ nullptr, nullptr, 0 };
+	}
+	for( int i = 0; i < MaxWorkers; ++i )
+	{
+		const WorkerStats & stats = m_workers[i].stats;
+		period.jobsPerWorker[i] = stats.jobs;
+		for( const JobRecord & job : stats.longestJobs )
+		{
+			if( job.job )
+			{
+				insertJob( period.longestJobs, job );
+			}
+		}
+	}
+
+	m_sequence[slot].fetch_add( 1, std::memory_order_release );
+	m_written.store( index + 1, std::memory_order_release );
+
+	if( elapsed > deadline )
+	{
+		requestDump( "period exceeded its deadline" );
+	}
+}
+
+
+
+
+void MixerFlightRecorder::recordJob( int worker, const ThreadableJob * job, quint32 duration )
+{
+	const int slot = worker + 1;
+	if( slot < 0 || slot >= MaxWorkers )
+	{
+		return;
+	}
+
+	WorkerStats & stats = m_workers[slot].stats;
+	++stats.jobs;
+	insertJob( stats.longestJobs, JobRecord{ &typeid( *job ), job, duration } );
+}
+
+
+
+
+void MixerFlightRecorder::requestDump( const char * reason )
+{
+	if( isEnabled() )
+	{
+		// keep the first reason if there are several
+		const char * expected = nullptr;
+		m_dumpReason.compare_exchange_strong( expected, reason );
+	}
+}
+
+
+
+
+void MixerFlightRecorder::insertJob( JobRecord * jobs, const JobRecord & record )
+{
+	// the jobs are sorted by duration, longest first
+	int i = MaxLongestJobs;
+	while( i > 0 && ( jobs[i - 1].job == nullptr || jobs[i - 1].duration < record.duration ) )
+	{
+		--i;
+	}
+	if( i == MaxLongestJobs )
+	{
+		return;
+	}
+	for( int j = MaxLongestJobs - 1; j > i; --j )
+	{
+		jobs[j] = jobs[j - 1];
+	}
+	jobs[i] = record;
+}
+
+
+
+
+void MixerFlightRecorder::dumpIfRequested()
+{
+	const int interval = DumpInterval;
+	if( m_dumpReason.load() == nullptr ||
+		( m_dumped && Clock::now() - m_lastDump <
+				std::chrono::milliseconds( interval ) ) )
+	{
+		return;
+	}
+
+	const char * reason = m_dumpReason.exchange( nullptr );
+	dump( reason );
+	m_lastDump = Clock::now();
+	m_dumped = true;
+}
+
+
+
+
+void MixerFlightRecorder::dump( const char * reason )
+{
+	// copy the periods first, the mixer keeps on writing
+	std::vector<Period> periods;
+	periods.reserve( Capacity );
+	const quint64 written = m_written.load( std::memory_order_acquire );
+	const quint64 first = written > Capacity ? written - Capacity : 0;
+	for( quint64 index = first; index < written; ++index )
+	{
+		const int slot = index % Capacity;
+		const quint32 before = m_sequence[slot].load( std::memory_order_acquire );
+		Period period = m_periods[slot];
+		std::atomic_thread_fence( std::memory_order_acquire );
+		if( before % 2 == 0 && m_sequence[slot].load( std::memory_order_relaxed ) == before )
+		{
+			periods.push_back( period );
+		}
+	}
+
+	const QString fileName = QDir::temp().filePath( QString( "lmms-xrun-%1.txt" ).arg(
+			QDateTime::currentDateTime().toString( "yyyyMMdd-hhmmss" ) ) );
+	QFile file( fileName );
+	if( !file.open( QFile::WriteOnly | QFile::Truncate | QFile::Text ) )
+	{
+		qWarning( "Xrun (%s), could not write flight recorder to %s",
+					reason, qUtf8Printable( fileName ) );
+		return;
+	}
+
+	QTextStream out( &file );
+	out << "# " << reason << "\n";
+	out << "# start [ms], elapsed/deadline [us], song, play handles, "
+		"tracks, FX mixer [us], play handles, jobs per thread "
+		"(mixer thread first), longest jobs [us]\n";
+	for( const Period & period : periods )
+	{
+		out << QString::number( period.start / 1000000.0, 'f', 3 ) << "\t"
+			<< period.elapsed << "/" << period.deadline
+			<< ( period.elapsed > period.deadline ? " !" : "" ) << "\t";
+		for( int i = 0; i < MaxStages; ++i )
+		{
+			out << period.stageTime[i] << ( i + 1 < MaxStages ? " " : "\t" );
+		}
+		out << period.playHandles << "\t";
+
+		int lastWorker = MaxWorkers - 1;
+		while( lastWorker > 0 && period.jobsPerWorker[lastWorker] == 0 )
+		{
+			--lastWorker;
+		}
+		for( int i = 0; i <= lastWorker; ++i )
+		{
+			out << period.jobsPerWorker[i] << ( i < lastWorker ? "/" : "\t" );
+		}
+
+		for( const JobRecord & job : period.longestJobs )
+		{
+			if( job.job )
+			{
+				out << typeName( job.type ) << "@"
+					<< QString::number( reinterpret_cast<quintptr>( job.job ), 16 )
+					<< ":" << job.duration / 1000 << " ";
+			}
+		}
+		out << "\n";
+	}
+
+	qWarning( "Xrun (%s), wrote last %d periods to %s", reason,
+				static_cast<int>( periods.size() ), qUtf8Printable( fileName ) );
+}
@@ -25,11 +25,31 @@
 #include "MixerProfiler.h"
 
 
+#include <cmath>
+
+#ifdef LMMS_BUILD_WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+std::atomic_bool MixerProfiler::s_detailsEnabled( false );
+std::atomic_bool MixerProfiler::s_denormalCheckEnabled( false );
+constexpr float MixerProfiler::DenormalThreshold;
+
+
 MixerProfiler::MixerProfiler() :
 	m_periodTimer(),
 	m_cpuLoad( 0 ),
 	m_outputFile()
 {
+	for( int i = 0; i < StageCount; ++i )
+	{
+		m_lastStageTime[i] = 0;
+		m_stageLoad[i] = 0;
+	}
 }
 
 
@@ -39,17 +59,61 @@ MixerProfiler::~MixerProfiler()
 }
 
 
-void MixerProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod )
+
+const char * MixerProfiler::stageName( Stages stage )
+{
+	static const char * const names[StageCount] = {
+		"song", "play_handles", "audio_ports", "master_mix"
+	};
+	return names[stage];
+}
+
+
+void MixerProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod,
+									int playHandles )
 {
 	int periodElapsed = m_periodTimer.elapsed();
 
 	const float newCpuLoad = periodElapsed / 10000.0f * sampleRate / framesPerPeriod;
     m_cpuLoad = qBound<int>( 0, ( newCpuLoad * 0.1f + m_cpuLoad * 0.9f ), 100 );
 
+	int stageElapsed[StageCount];
+	for( int i = 0; i < StageCount; ++i )
+	{
+		const quint64 total = m_stageTime[i].total();
+		stageElapsed[i] = ( total - m_lastStageTime[i] ) / 1000;
+		m_lastStageTime[i] = total;
+
+		const float newStageLoad = stageElapsed[i] / 10000.0f * sampleRate / framesPerPeriod;
+		m_stageLoad[i] = qBound<int>( 0, ( newStageLoad * 0.1f + m_stageLoad[i] * 0.9f ), 100 );
+	}
+
+	m_flightRecorder.finishPeriod( periodElapsed,
+			static_cast<int>( 1000000LL * framesPerPeriod / sampleRate ),
+			stageElapsed, StageCount, playHandles );
+
 	if( m_outputFile.isOpen() )
 	{
-		m_outputFile.write( QString( "%1\n" ).arg( periodElapsed ).toLatin1() );
+		// total, song, play handles, audio ports and master mix in us
+		m_outputFile.write( QString( "%1 %2 %3 %4 %5\n" ).arg( periodElapsed )
+				.arg( stageElapsed[StageSong] )
+				.arg( stageElapsed[StagePlayHandles] )
+				.arg( stageElapsed[StageAudioPorts] )
+				.arg( stageElapsed[StageMasterMix] ).toLatin1() );
+	}
+}
+
+
+
+int MixerProfiler::denormalSamples( const float * samples, int count )
+{
+	int denormals = 0;
+	for( int i = 0; i < count; ++i )
+	{
+		const float magnitude = std::fabs( samples[i] );
+		denormals += magnitude > 0.0f && magnitude < DenormalThreshold;
 	}
+	return denormals;
 }
 
 
@@ -61,3 +125,26 @@ void MixerProfiler::setOutputFile( const QString& outputFile )
 	m_outputFile.open( QFile::WriteOnly | QFile::Truncate );
 }
 
+
+
+quint64 MixerProfiler::peakMemoryKiB()
+{
+#ifdef LMMS_BUILD_WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+	{
+		return counters.PeakWorkingSetSize / 1024;
+	}
+	return 0;
+#else
+	rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+#ifdef LMMS_BUILD_APPLE
+	// in bytes there
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
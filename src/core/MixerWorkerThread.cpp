@@ -26,19 +26,86 @@
 
 #include <QDebug>
 #include <QMutex>
+#include <QStringList>
 #include <QWaitCondition>
 
+#include <typeinfo>
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_BUILD_WIN32
+#include <QLibrary>
+#include <windows.h>
+#endif
+
+#ifdef LMMS_HAVE_SCHED_H
+#include <sched.h>
+#endif
+
+#ifdef LMMS_HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "ConfigManager.h"
 #include "denormals.h"
+#include "Engine.h"
 #include "ThreadableJob.h"
 #include "Mixer.h"
+#include "PerfLog.h"
+#include "RealtimeCheck.h"
 
 #if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
 #include <xmmintrin.h>
 #endif
 
 MixerWorkerThread::JobQueue MixerWorkerThread::globalJobQueue;
+MixerWorkerThread::WorkStealingQueue MixerWorkerThread::workStealingQueue;
+bool MixerWorkerThread::s_workStealing = false;
 QWaitCondition * MixerWorkerThread::queueReadyWaitCond = NULL;
 QList<MixerWorkerThread *> MixerWorkerThread::workerThreads;
+MixerWorkerThread::ThreadSettings MixerWorkerThread::s_threadSettings;
+std::atomic_int MixerWorkerThread::s_startedWorkers( 0 );
+std::atomic_int MixerWorkerThread::s_pinnedWorkers( 0 );
+std::atomic_int MixerWorkerThread::s_realtimeWorkers( 0 );
+
+// index of the worker queue owned by the current thread, -1 for threads
+// which are not worker threads (e.g. the mixer thread)
+static thread_local int s_workerIndex = -1;
+
+// how many jobs the current thread is processing, jobs can run jobs
+static thread_local int s_jobDepth = 0;
+
+// the queue of the jobs the current thread runs itself, see InlineJobs
+static thread_local MixerWorkerThread::JobQueue * s_inlineQueue = nullptr;
+
+
+static inline void pauseCpu()
+{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+	_mm_pause();
+#endif
+}
+
+
+// process a job, timing it for the flight recorder if that's enabled
+static inline void processJob( ThreadableJob * job )
+{
+	PerfTrace::Scope trace( typeid( *job ).name(), PerfTrace::Job );
+	MixerFlightRecorder & recorder = Engine::mixer()->profiler().flightRecorder();
+	++s_jobDepth;
+	if( !recorder.isEnabled() )
+	{
+		job->process();
+		--s_jobDepth;
+		return;
+	}
+
+	const auto begin = std::chrono::steady_clock::now();
+	job->process();
+	recorder.recordJob( s_workerIndex, job, std::chrono::duration_cast<
+		std::chrono::nanoseconds>( std::chrono::steady_clock::now() - begin ).count() );
+	--s_jobDepth;
+}
 
 // implementation of internal JobQueue
 void MixerWorkerThread::JobQueue::reset( OperationMode _opMode )
@@ -81,7 +148,7 @@ void MixerWorkerThread::JobQueue::run()
 			ThreadableJob * job = m_items[i].exchange(nullptr);
 			if( job )
 			{
-				job->process();
+				processJob( job );
 				processedJob = true;
 				++m_itemsDone;
 			}
@@ -98,9 +165,227 @@ void MixerWorkerThread::JobQueue::wait()
 {
 	while (m_itemsDone < m_writeIndex)
 	{
-#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
-		_mm_pause();
-#endif
+		pauseCpu();
+	}
+}
+
+
+
+
+// implementation of internal WorkStealingQueue
+MixerWorkerThread::WorkStealingQueue::WorkerQueue::WorkerQueue() :
+	m_head( 0 ),
+	m_tail( 0 ),
+	m_itemsDone( 0 )
+{
+	std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
+}
+
+
+
+
+bool MixerWorkerThread::WorkStealingQueue::WorkerQueue::push( ThreadableJob * _job )
+{
+	unsigned int tail = m_tail.load();
+	do
+	{
+		if( tail - m_head.load() >= JOB_QUEUE_SIZE )
+		{
+			return false;
+		}
+	}
+	while( !m_tail.compare_exchange_weak( tail, tail + 1 ) );
+
+	// the slot may still be claimed by a consumer which did not fetch
+	// the job yet
+	std::atomic<ThreadableJob*> & slot = m_items[tail % JOB_QUEUE_SIZE];
+	ThreadableJob * expected = nullptr;
+	while( !slot.compare_exchange_weak( expected, _job ) )
+	{
+		expected = nullptr;
+		pauseCpu();
+	}
+	return true;
+}
+
+
+
+
+ThreadableJob * MixerWorkerThread::WorkStealingQueue::WorkerQueue::pop()
+{
+	unsigned int head = m_head.load();
+	do
+	{
+		if( head == m_tail.load() )
+		{
+			return nullptr;
+		}
+	}
+	while( !m_head.compare_exchange_weak( head, head + 1 ) );
+
+	// the producer may not have stored the job yet
+	std::atomic<ThreadableJob*> & slot = m_items[head % JOB_QUEUE_SIZE];
+	ThreadableJob * job;
+	while( ( job = slot.exchange( nullptr ) ) == nullptr )
+	{
+		pauseCpu();
+	}
+	return job;
+}
+
+
+
+
+MixerWorkerThread::WorkStealingQueue::WorkStealingQueue() :
+	m_queues( nullptr ),
+	m_numQueues( 0 ),
+	m_nextQueue( 0 ),
+	m_opMode( JobQueue::Static )
+{
+}
+
+
+
+
+MixerWorkerThread::WorkStealingQueue::~WorkStealingQueue()
+{
+	delete[] m_queues;
+}
+
+
+
+
+void MixerWorkerThread::WorkStealingQueue::init( int numWorkers )
+{
+	delete[] m_queues;
+	m_numQueues = qMax( numWorkers, 1 );
+	m_queues = new WorkerQueue[m_numQueues];
+	m_nextQueue = 0;
+}
+
+
+
+
+void MixerWorkerThread::WorkStealingQueue::reset( JobQueue::OperationMode _opMode )
+{
+	// counters are never reset, so workers still scanning the queues from
+	// the previous run can't observe inconsistent state
+	m_opMode = _opMode;
+}
+
+
+
+
+void MixerWorkerThread::WorkStealingQueue::addJob( ThreadableJob * _job )
+{
+	if( !_job->requiresProcessing() )
+	{
+		return;
+	}
+
+	_job->queue();
+
+	// workers push dependent jobs onto their own queue, everybody else
+	// distributes the jobs round-robin
+	int queue = s_workerIndex;
+	if( queue < 0 || queue >= m_numQueues )
+	{
+		queue = m_nextQueue;
+		m_nextQueue = ( m_nextQueue + 1 ) % m_numQueues;
+	}
+
+	for( int i = 0; i < m_numQueues; ++i )
+	{
+		if( m_queues[( queue + i ) % m_numQueues].push( _job ) )
+		{
+			return;
+		}
+	}
+
+	qWarning() << "Job queue is full!";
+	_job->process();
+}
+
+
+
+
+void MixerWorkerThread::WorkStealingQueue::run( int worker )
+{
+	if( m_numQueues == 0 )
+	{
+		return;
+	}
+	if( worker < 0 || worker >= m_numQueues )
+	{
+		worker = m_numQueues - 1;
+	}
+
+	while( true )
+	{
+		// own queue first, then try to steal from the others
+		WorkerQueue * queue = nullptr;
+		ThreadableJob * job = nullptr;
+		for( int i = 0; i < m_numQueues && job == nullptr; ++i )
+		{
+			queue = &m_queues[( worker + i ) % m_numQueues];
+			job = queue->pop();
+		}
+
+		if( job )
+		{
+			processJob( job );
+			queue->m_itemsDone.fetch_add( 1, std::memory_order_release );
+		}
+		// in dynamic mode, jobs being processed by other workers may still
+		// queue new ones, so keep looking until everything is done
+		else if( m_opMode == JobQueue::Static || allDone() )
+		{
+			break;
+		}
+		else
+		{
+			pauseCpu();
+		}
+	}
+}
+
+
+
+
+bool MixerWorkerThread::WorkStealingQueue::allDone() const
+{
+	// take a snapshot of all counters - if no job was added between the two
+	// passes over the tails and the sum of the done counters matches, every
+	// job queued so far has been processed. Jobs only get added either before
+	// waiting or from within jobs which are not done yet.
+	unsigned int added = 0;
+	unsigned int done = 0;
+	unsigned int addedAgain = 0;
+	for( int i = 0; i < m_numQueues; ++i )
+	{
+		added += m_queues[i].m_tail.load( std::memory_order_acquire );
+	}
+	for( int i = 0; i < m_numQueues; ++i )
+	{
+		done += m_queues[i].m_itemsDone.load( std::memory_order_acquire );
+	}
+	for( int i = 0; i < m_numQueues; ++i )
+	{
+		addedAgain += m_queues[i].m_tail.load( std::memory_order_acquire );
+	}
+	return added == done && added == addedAgain;
+}
+
+
+
+
+void MixerWorkerThread::WorkStealingQueue::wait()
+{
+	while( !allDone() )
+	{
+		// help out instead of just spinning
+		run( s_workerIndex );
+		pauseCpu();
 	}
 }
 
@@ -112,6 +397,7 @@ void MixerWorkerThread::JobQueue::wait()
 
 MixerWorkerThread::MixerWorkerThread( Mixer* mixer ) :
 	QThread( mixer ),
+	m_index( workerThreads.size() ),
 	m_quit( false )
 {
 	// initialize global static data
@@ -148,14 +434,193 @@ void MixerWorkerThread::quit()
 
 
 
+MixerWorkerThread::InlineJobs::InlineJobs( JobQueue * queue ) :
+	m_previous( s_inlineQueue )
+{
+	s_inlineQueue = queue;
+}
+
+
+
+
+MixerWorkerThread::InlineJobs::~InlineJobs()
+{
+	s_inlineQueue = m_previous;
+}
+
+
+
+
+void MixerWorkerThread::resetJobQueue( JobQueue::OperationMode _opMode )
+{
+	if( s_inlineQueue )
+	{
+		s_inlineQueue->reset( _opMode );
+	}
+	else if( s_workStealing )
+	{
+		workStealingQueue.reset( _opMode );
+	}
+	else
+	{
+		globalJobQueue.reset( _opMode );
+	}
+}
+
+
+
+
+void MixerWorkerThread::addJob( ThreadableJob * _job )
+{
+	if( s_inlineQueue )
+	{
+		s_inlineQueue->addJob( _job );
+	}
+	else if( s_workStealing )
+	{
+		workStealingQueue.addJob( _job );
+	}
+	else
+	{
+		globalJobQueue.addJob( _job );
+	}
+}
+
+
+
+
+void MixerWorkerThread::setWorkStealing( bool enabled, int numWorkers )
+{
+	s_workStealing = enabled;
+	if( enabled )
+	{
+		workStealingQueue.init( numWorkers );
+	}
+}
+
+
+
+
+MixerWorkerThread::ThreadSettings MixerWorkerThread::ThreadSettings::fromConfig()
+{
+	ConfigManager * config = ConfigManager::inst();
+
+	ThreadSettings settings;
+	settings.numWorkers = qMax( 0, config->value( "mixer", "workerthreads" ).toInt() );
+	settings.policy = static_cast<SchedulingPolicies>( qBound<int>( SchedulingDefault,
+				config->value( "mixer", "workerscheduling" ).toInt(),
+				SchedulingRoundRobin ) );
+	settings.priority = qMax( 0, config->value( "mixer", "workerpriority" ).toInt() );
+	settings.affinity = parseAffinity( config->value( "mixer", "workeraffinity" ) );
+	return settings;
+}
+
+
+
+
+QVector<quint64> MixerWorkerThread::ThreadSettings::parseAffinity( const QString & text )
+{
+	QVector<quint64> masks;
+	for( const QString & worker : text.split( ';' ) )
+	{
+		quint64 mask = 0;
+		for( const QString & cpus : worker.split( ',', QString::SkipEmptyParts ) )
+		{
+			const QStringList range = cpus.split( '-' );
+			bool firstOk = false, lastOk = false;
+			const int first = range.first().trimmed().toInt( &firstOk );
+			const int last = range.size() == 2 ?
+						range.last().trimmed().toInt( &lastOk ) : first;
+			if( !firstOk || ( range.size() == 2 && !lastOk ) || range.size() > 2 )
+			{
+				qWarning( "Ignoring invalid CPU list \"%s\" for worker thread %d",
+							qUtf8Printable( cpus ), masks.size() );
+				continue;
+			}
+			for( int cpu = qMax( 0, first ); cpu <= qMin( last, 63 ); ++cpu )
+			{
+				mask |= quint64( 1 ) << cpu;
+			}
+		}
+		masks.push_back( mask );
+	}
+
+	// drop trailing workers which aren't pinned
+	while( !masks.isEmpty() && masks.last() == 0 )
+	{
+		masks.pop_back();
+	}
+	return masks;
+}
+
+
+
+
+void MixerWorkerThread::setThreadSettings( const ThreadSettings & settings )
+{
+	s_threadSettings = settings;
+}
+
+
+
+
+QString MixerWorkerThread::appliedThreadSettings()
+{
+	const int started = s_startedWorkers;
+	QString state = tr( "%n worker thread(s)", "", started );
+	if( s_threadSettings.policy != SchedulingDefault )
+	{
+		state += ", " + tr( "%1 with realtime priority" ).arg( s_realtimeWorkers );
+	}
+	if( !s_threadSettings.affinity.isEmpty() )
+	{
+		state += ", " + tr( "%1 pinned to CPUs" ).arg( s_pinnedWorkers );
+	}
+	return state;
+}
+
+
+
+
+bool MixerWorkerThread::canAddSubJobs()
+{
+	return s_workStealing && s_jobDepth > 0 && s_inlineQueue == nullptr;
+}
+
+
+
+
+bool MixerWorkerThread::isWorkerThread()
+{
+	return s_workerIndex >= 0;
+}
+
+
+
+
 void MixerWorkerThread::startAndWaitForJobs()
 {
+	if( s_inlineQueue )
+	{
+		s_inlineQueue->run();
+		s_inlineQueue->wait();
+		return;
+	}
+
 	queueReadyWaitCond->wakeAll();
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global Mixer thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
-	globalJobQueue.run();
-	globalJobQueue.wait();
+	if( s_workStealing )
+	{
+		workStealingQueue.run( s_workerIndex );
+		workStealingQueue.wait();
+	}
+	else
+	{
+		globalJobQueue.run();
+		globalJobQueue.wait();
+	}
 }
 
 
@@ -166,14 +631,99 @@ void MixerWorkerThread::run()
 	MemoryManager::ThreadGuard mmThreadGuard; Q_UNUSED(mmThreadGuard);
 	disable_denormals();
 
+	s_workerIndex = m_index;
+	applyThreadSettings();
+	PerfTrace::setThreadName( QString( "Worker %1" ).arg( m_index ) );
+
 	QMutex m;
 	while( m_quit == false )
 	{
 		m.lock();
 		queueReadyWaitCond->wait( &m );
-		globalJobQueue.run();
+		RealtimeCheck::Scope realtime;
+		if( s_workStealing )
+		{
+			workStealingQueue.run( m_index );
+		}
+		else
+		{
+			globalJobQueue.run();
+		}
 		m.unlock();
 	}
 }
 
 
+
+
+
+
+void MixerWorkerThread::applyThreadSettings()
+{
+	++s_startedWorkers;
+
+	const quint64 mask = m_index < s_threadSettings.affinity.size() ?
+					s_threadSettings.affinity[m_index] : 0;
+	if( mask )
+	{
+		bool pinned = false;
+#if defined(LMMS_BUILD_LINUX) && defined(LMMS_HAVE_SCHED_H)
+		cpu_set_t set;
+		CPU_ZERO( &set );
+		for( int cpu = 0; cpu < 64; ++cpu )
+		{
+			if( mask & ( quint64( 1 ) << cpu ) )
+			{
+				CPU_SET( cpu, &set );
+			}
+		}
+		pinned = sched_setaffinity( 0, sizeof( set ), &set ) == 0;
+#elif defined(LMMS_BUILD_WIN32)
+		pinned = SetThreadAffinityMask( GetCurrentThread(),
+					static_cast<DWORD_PTR>( mask ) ) != 0;
+#endif
+		if( pinned )
+		{
+			++s_pinnedWorkers;
+		}
+		else
+		{
+			qWarning( "Notice: could not set CPU affinity of worker thread %d.", m_index );
+		}
+	}
+
+	if( s_threadSettings.policy != SchedulingDefault )
+	{
+		bool realtime = false;
+#if defined(LMMS_BUILD_WIN32)
+		// there's only one realtime class on Windows. MMCSS is loaded at
+		// runtime, so we don't depend on avrt.dll being there.
+		typedef HANDLE (WINAPI * AvSetMmThreadCharacteristicsFunc)( LPCWSTR, LPDWORD );
+		static AvSetMmThreadCharacteristicsFunc avSetMmThreadCharacteristics =
+			reinterpret_cast<AvSetMmThreadCharacteristicsFunc>(
+				QLibrary::resolve( "avrt", "AvSetMmThreadCharacteristicsW" ) );
+		DWORD taskIndex = 0;
+		realtime = avSetMmThreadCharacteristics &&
+			avSetMmThreadCharacteristics( L"Pro Audio", &taskIndex ) != NULL;
+#elif defined(LMMS_HAVE_PTHREAD_H) && defined(LMMS_HAVE_SCHED_H)
+		const int policy = s_threadSettings.policy == SchedulingFifo ?
+							SCHED_FIFO : SCHED_RR;
+		const int minPriority = sched_get_priority_min( policy );
+		const int maxPriority = sched_get_priority_max( policy );
+		struct sched_param param;
+		param.sched_priority = s_threadSettings.priority > 0 ?
+			qBound( minPriority, s_threadSettings.priority, maxPriority ) :
+			( minPriority + maxPriority ) / 2;
+		realtime = pthread_setschedparam( pthread_self(), policy, &param ) == 0;
+#endif
+		if( realtime )
+		{
+			++s_realtimeWorkers;
+		}
+		else
+		{
+			// the thread keeps running with the priority it was started with
+			qWarning( "Notice: could not set realtime priority of worker thread %d.", m_index );
+		}
+	}
+}
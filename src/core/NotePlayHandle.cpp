@@ -24,8 +24,12 @@
  */
 
 #include "NotePlayHandle.h"
+
+#include <algorithm>
+
 #include "BasicFilters.h"
 #include "DetuningHelper.h"
+#include "IndexedPool.h"
 #include "InstrumentSoundShaping.h"
 #include "InstrumentTrack.h"
 #include "Instrument.h"
@@ -33,6 +37,11 @@
 #include "Song.h"
 
 
+// length of the fade of a stolen voice in milliseconds, short enough to
+// free the voice quickly but long enough not to click
+static const int StealFadeLength = 5;
+
+
 NotePlayHandle::BaseDetuning::BaseDetuning( DetuningHelper *detuning ) :
 	m_value( detuning ? detuning->automationPattern()->valueAt( 0 ) : 0 )
 {
@@ -62,6 +71,9 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 	m_subNotes(),
 	m_released( false ),
 	m_releaseStarted( false ),
+	m_stolen( false ),
+	m_stealFramesLeft( 0 ),
+	m_stealFadeFrom( 0 ),
 	m_hasMidiNote( false ),
 	m_hasParent( parent != NULL  ),
 	m_parent( parent ),
@@ -78,6 +90,10 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 	m_origin( origin ),
 	m_frequencyNeedsUpdate( false )
 {
+	m_scheduledShaping.pending = false;
+	m_playsAsVoice = false;
+	m_voicePending = false;
+
 	lock();
 	if( hasParent() == false )
 	{
@@ -100,10 +116,16 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 
 	setFrames( _frames );
 
-	// inform attached components about new MIDI note (used for recording in Piano Roll)
+	// the arpeggio may still add notes to a stolen note
+	if( parent && parent->isStolen() )
+	{
+		steal();
+	}
+
+	// capture the new MIDI note for recording in Piano Roll
 	if( m_origin == OriginMidiInput )
 	{
-		m_instrumentTrack->midiNoteOn( *this );
+		m_instrumentTrack->recordNote( true, *this );
 	}
 
 	if(m_instrumentTrack->instrument() && m_instrumentTrack->instrument()->flags() & Instrument::IsSingleStreamed )
@@ -180,10 +202,24 @@ int NotePlayHandle::midiKey() const
 
 
 
+void NotePlayHandle::doProcessing()
+{
+	// notes played as voices are mixed by the instrument, so they don't
+	// need a buffer, while stolen notes are faded out by the track
+	m_playsAsVoice = !m_stolen && m_instrumentTrack->playsVoices();
+	setUsesBuffer( !m_playsAsVoice );
+	PlayHandle::doProcessing();
+}
+
+
+
+
 void NotePlayHandle::play( sampleFrame * _working_buffer )
 {
 	if (m_muted)
 	{
+		// nothing is heard of a muted note, so no need to fade
+		m_stealFramesLeft = 0;
 		return;
 	}
 
@@ -251,6 +287,8 @@ void NotePlayHandle::play( sampleFrame * _working_buffer )
 			: ( m_frames - m_totalFramesPlayed ) ); // otherwise, the offset is already negated and can be ignored
 	}
 
+	m_stealFadeFrom = m_stealFramesLeft;
+
 	// under some circumstances we're called even if there's nothing to play
 	// therefore do an additional check which fixes crash e.g. when
 	// decreasing release of an instrument-track while the note is active
@@ -315,6 +353,11 @@ void NotePlayHandle::play( sampleFrame * _working_buffer )
 		}
 	}
 
+	if( m_stolen )
+	{
+		m_stealFramesLeft = qMax<f_cnt_t>( 0, m_stealFramesLeft - framesThisPeriod );
+	}
+
 	// update internal data
 	m_totalFramesPlayed += framesThisPeriod;
 	unlock();
@@ -325,7 +368,13 @@ void NotePlayHandle::play( sampleFrame * _working_buffer )
 
 f_cnt_t NotePlayHandle::framesLeft() const
 {
-	if( instrumentTrack()->isSustainPedalPressed() )
+	if( m_stolen )
+	{
+		// keep the note alive until its sub-notes are finished
+		return m_subNotes.isEmpty() ? m_stealFramesLeft :
+					qMax<f_cnt_t>( 1, m_stealFramesLeft );
+	}
+	else if( instrumentTrack()->isSustainPedalPressed() )
 	{
 		return 4*Engine::mixer()->framesPerPeriod();
 	}
@@ -394,13 +443,13 @@ void NotePlayHandle::noteOff( const f_cnt_t _s )
 				_s );
 	}
 
-	// inform attached components about MIDI finished (used for recording in Piano Roll)
+	// capture the end of the MIDI note for recording in Piano Roll
 	if (!instrumentTrack()->isSustainPedalPressed())
 	{
 		if( m_origin == OriginMidiInput )
 		{
 			setLength( TimePos( static_cast<f_cnt_t>( totalFramesPlayed() / Engine::framesPerTick() ) ) );
-			m_instrumentTrack->midiNoteOff( *this );
+			m_instrumentTrack->recordNote( false, *this );
 		}
 	}
 }
@@ -408,6 +457,59 @@ void NotePlayHandle::noteOff( const f_cnt_t _s )
 
 
 
+void NotePlayHandle::steal()
+{
+	if( m_stolen )
+	{
+		return;
+	}
+	m_stolen = true;
+	m_stealFramesLeft = qMax<f_cnt_t>( 1, StealFadeLength *
+				Engine::mixer()->processingSampleRate() / 1000 );
+	m_stealFadeFrom = m_stealFramesLeft;
+
+	for( NotePlayHandle * n : m_subNotes )
+	{
+		n->lock();
+		n->steal();
+		n->unlock();
+	}
+
+	noteOff( 0 );
+
+	// a new note on the same key must not wait for the fade
+	if( m_instrumentTrack->m_notes[key()] == this )
+	{
+		m_instrumentTrack->m_notes[key()] = NULL;
+	}
+}
+
+
+
+
+void NotePlayHandle::applyStealFade( sampleFrame * buf, const fpp_t frames ) const
+{
+	const float step = 1.0f / ( StealFadeLength *
+				Engine::mixer()->processingSampleRate() / 1000 );
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		const float gain = qMax<f_cnt_t>( 0, m_stealFadeFrom - f ) * step;
+		buf[f][0] *= gain;
+		buf[f][1] *= gain;
+	}
+}
+
+
+
+
+float NotePlayHandle::audibility()
+{
+	return volumeLevel( m_totalFramesPlayed ) * getVolume();
+}
+
+
+
+
 f_cnt_t NotePlayHandle::actualReleaseFramesToDo() const
 {
 	return m_instrumentTrack->m_soundShaping.releaseFrames();
@@ -452,22 +554,9 @@ void NotePlayHandle::mute()
 
 int NotePlayHandle::index() const
 {
-	const PlayHandleList & playHandles = Engine::mixer()->playHandles();
-	int idx = 0;
-	for( PlayHandleList::ConstIterator it = playHandles.begin(); it != playHandles.end(); ++it )
-	{
-		const NotePlayHandle * nph = dynamic_cast<const NotePlayHandle *>( *it );
-		if( nph == NULL || nph->m_instrumentTrack != m_instrumentTrack || nph->isReleased() || nph->hasParent() )
-		{
-			continue;
-		}
-		if( nph == this )
-		{
-			return idx;
-		}
-		++idx;
-	}
-	return -1;
+	const std::vector<const NotePlayHandle *> & notes = m_instrumentTrack->activeNotes();
+	const auto it = std::find( notes.begin(), notes.end(), this );
+	return it != notes.end() ? static_cast<int>( it - notes.begin() ) : -1;
 }
 
 
@@ -574,28 +663,40 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 }
 
 
-NotePlayHandle ** NotePlayHandleManager::s_available;
-QReadWriteLock NotePlayHandleManager::s_mutex;
-std::atomic_int NotePlayHandleManager::s_availableIndex;
-int NotePlayHandleManager::s_size;
+namespace
+{
+
+typedef IndexedPool<256, 32> NphPool;
+
+NphPool s_nphPool( "NotePlayHandleManager", sizeof( NotePlayHandle ),
+						alignof( NotePlayHandle ) );
+thread_local NphPool::ThreadCache t_nphCache( s_nphPool );
+
+} // namespace
+
+
 
 
 void NotePlayHandleManager::init()
 {
-	s_available = MM_ALLOC( NotePlayHandle*, INITIAL_NPH_CACHE );
+	reserve( DEFAULT_NPH_POOL_SIZE );
+}
 
-	NotePlayHandle * n = MM_ALLOC( NotePlayHandle, INITIAL_NPH_CACHE );
 
-	for( int i=0; i < INITIAL_NPH_CACHE; ++i )
+
+
+void NotePlayHandleManager::reserve( int handles )
+{
+	while( capacity() < handles )
 	{
-		s_available[ i ] = n;
-		++n;
+		s_nphPool.grow();
 	}
-	s_availableIndex = INITIAL_NPH_CACHE - 1;
-	s_size = INITIAL_NPH_CACHE;
+	s_nphPool.growIfRequested();
 }
 
 
+
+
 NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrack,
 				const f_cnt_t offset,
 				const f_cnt_t frames,
@@ -604,43 +705,60 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 				int midiEventChannel,
 				NotePlayHandle::Origin origin )
 {
-	// TODO: use some lockless data structures
-	s_mutex.lockForWrite();
-	if (s_availableIndex < 0) { extend(NPH_CACHE_INCREMENT); }
-	NotePlayHandle * nph = s_available[s_availableIndex--];
-	s_mutex.unlock();
-
-	new( (void*)nph ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
-	return nph;
+	void * memory;
+	while( ( memory = s_nphPool.acquire( t_nphCache ) ) == nullptr )
+	{
+		// polyphony budget exhausted
+		s_nphPool.grow();
+	}
+	return new( memory ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
 }
 
 
+
+
 void NotePlayHandleManager::release( NotePlayHandle * nph )
 {
 	nph->NotePlayHandle::~NotePlayHandle();
-	s_mutex.lockForRead();
-	s_available[++s_availableIndex] = nph;
-	s_mutex.unlock();
+	s_nphPool.release( t_nphCache, nph );
 }
 
 
-void NotePlayHandleManager::extend( int c )
+
+
+void NotePlayHandleManager::free()
 {
-	s_size += c;
-	NotePlayHandle ** tmp = MM_ALLOC( NotePlayHandle*, s_size );
-	MM_FREE( s_available );
-	s_available = tmp;
+	s_nphPool.free();
+}
 
-	NotePlayHandle * n = MM_ALLOC( NotePlayHandle, c );
 
-	for( int i=0; i < c; ++i )
-	{
-		s_available[++s_availableIndex] = n;
-		++n;
-	}
+
+
+int NotePlayHandleManager::capacity()
+{
+	return s_nphPool.capacity();
 }
 
-void NotePlayHandleManager::free()
+
+
+
+int NotePlayHandleManager::inUse()
+{
+	return s_nphPool.inUse();
+}
+
+
+
+
+int NotePlayHandleManager::highWaterMark()
+{
+	return s_nphPool.highWaterMark();
+}
+
+
+
+
+int NotePlayHandleManager::overflows()
 {
-	MM_FREE(s_available);
+	return s_nphPool.overflows();
 }
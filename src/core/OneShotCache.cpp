@@ -0,0 +1,202 @@
+/*
+ * OneShotCache.cpp - keeps the one-shots of instruments which sound the same
+ *                    on every hit
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "OneShotCache.h"
+
+#include <algorithm>
+
+
+const int OneShotCache::MaxTakes;
+const f_cnt_t OneShotCache::ChunkFrames;
+
+
+
+
+void OneShotCache::Player::play(sampleFrame * out, f_cnt_t frames)
+{
+	m_take->read(m_position, out, frames);
+	m_position += frames;
+}
+
+
+
+
+bool OneShotCache::Player::isOver() const
+{
+	const f_cnt_t end = m_take->end();
+	return end >= 0 && end <= m_position;
+}
+
+
+
+
+OneShotCache::~OneShotCache()
+{
+	clear();
+}
+
+
+
+
+OneShotCache::TakePtr OneShotCache::find(const QByteArray & key)
+{
+	QMutexLocker lock(&m_mutex);
+	for (auto it = m_takes.rbegin(); it != m_takes.rend(); ++it)
+	{
+		if (it->first == key)
+		{
+			TakePtr take = it->second;
+			std::rotate(it.base() - 1, it.base(), m_takes.end());
+			return take;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+OneShotCache::TakePtr OneShotCache::insert(const QByteArray & key, Recorder * recorder)
+{
+	TakePtr take = find(key);
+	if (take)
+	{
+		delete recorder;
+		return take;
+	}
+
+	take = std::make_shared<Take>(recorder, true);
+	TakePtr dropped;
+	{
+		QMutexLocker lock(&m_mutex);
+		m_takes.emplace_back(key, take);
+		if (static_cast<int>(m_takes.size()) > MaxTakes)
+		{
+			// freed outside the lock, unless a note still plays it
+			dropped = std::move(m_takes.front().second);
+			m_takes.erase(m_takes.begin());
+		}
+	}
+	return take;
+}
+
+
+
+
+OneShotCache::TakePtr OneShotCache::uncached(Recorder * recorder)
+{
+	return std::make_shared<Take>(recorder, false);
+}
+
+
+
+
+void OneShotCache::clear()
+{
+	std::vector<std::pair<QByteArray, TakePtr> > takes;
+	{
+		QMutexLocker lock(&m_mutex);
+		takes.swap(m_takes);
+	}
+}
+
+
+
+
+OneShotCache::Take::Take(Recorder * recorder, bool keep) :
+	m_recorder(recorder),
+	m_keep(keep),
+	m_frames(0),
+	m_end(-1)
+{
+}
+
+
+
+
+OneShotCache::Take::~Take()
+{
+	for (sampleFrame * chunk : m_chunks)
+	{
+		MM_FREE(chunk);
+	}
+}
+
+
+
+
+void OneShotCache::Take::read(f_cnt_t position, sampleFrame * out, f_cnt_t frames)
+{
+	QMutexLocker lock(&m_mutex);
+
+	if (!m_keep)
+	{
+		// only one note plays it, in order
+		const f_cnt_t over = m_recorder->render(out, frames);
+		if (over < frames && m_end < 0)
+		{
+			m_end = m_frames + over + 1;
+		}
+		m_frames += frames;
+		return;
+	}
+
+	// render what no note played yet, in pieces of one chunk at most
+	while (m_frames < position + frames)
+	{
+		const f_cnt_t offset = m_frames % ChunkFrames;
+		if (offset == 0)
+		{
+			m_chunks.push_back(MM_ALLOC(sampleFrame, ChunkFrames));
+		}
+		const f_cnt_t count = qMin<f_cnt_t>(ChunkFrames - offset,
+			position + frames - m_frames);
+		const f_cnt_t over = m_recorder->render(m_chunks.back() + offset, count);
+		if (over < count && m_end < 0)
+		{
+			m_end = m_frames + over + 1;
+		}
+		m_frames += count;
+	}
+
+	for (f_cnt_t f = 0; f < frames; )
+	{
+		const f_cnt_t at = position + f;
+		const f_cnt_t offset = at % ChunkFrames;
+		const f_cnt_t count = qMin<f_cnt_t>(ChunkFrames - offset, frames - f);
+		const sampleFrame * chunk = m_chunks[at / ChunkFrames];
+		std::copy(chunk + offset, chunk + offset + count, out + f);
+		f += count;
+	}
+}
+
+
+
+
+f_cnt_t OneShotCache::Take::end()
+{
+	QMutexLocker lock(&m_mutex);
+	return m_end;
+}
@@ -24,6 +24,8 @@
 
 #include "Oscillator.h"
 
+#include <algorithm>
+
 #include "BufferManager.h"
 #include "Engine.h"
 #include "Mixer.h"
@@ -347,123 +349,121 @@ float Oscillator::syncInit( sampleFrame * _ab, const fpp_t _frames,
 
 
 
-// if we have no sub-osc, we can't do any modulation... just get our samples
-template<Oscillator::WaveShapes W>
-void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+template<>
+inline sample_t Oscillator::getSample<Oscillator::SineWave>(
+							const float _sample )
 {
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	return( sinSample( _sample ) );
+}
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
-	}
+
+
+
+template<>
+inline sample_t Oscillator::getSample<Oscillator::TriangleWave>(
+							const float _sample )
+{
+	return( triangleSample( _sample ) );
 }
 
 
 
 
-// do pm by using sub-osc as modulator
-template<Oscillator::WaveShapes W>
-void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+template<>
+inline sample_t Oscillator::getSample<Oscillator::SawWave>(
+							const float _sample )
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	return( sawSample( _sample ) );
+}
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] = getSample<W>( m_phase +
-					_ab[frame][_chnl] )
-							* m_volume;
-		m_phase += osc_coeff;
-	}
+
+
+
+template<>
+inline sample_t Oscillator::getSample<Oscillator::SquareWave>(
+							const float _sample )
+{
+	return( squareSample( _sample ) );
 }
 
 
 
 
-// do am by using sub-osc as modulator
-template<Oscillator::WaveShapes W>
-void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+template<>
+inline sample_t Oscillator::getSample<Oscillator::MoogSawWave>(
+							const float _sample )
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	return( moogSawSample( _sample ) );
+}
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] *= getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
-	}
+
+
+
+template<>
+inline sample_t Oscillator::getSample<Oscillator::ExponentialWave>(
+							const float _sample )
+{
+	return( expSample( _sample ) );
 }
 
 
 
 
-// do mix by using sub-osc as mix-sample
-template<Oscillator::WaveShapes W>
-void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+template<>
+inline sample_t Oscillator::getSample<Oscillator::WhiteNoise>(
+							const float _sample )
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
+	return( noiseSample( _sample ) );
+}
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
+
+
+
+template<>
+inline sample_t Oscillator::getSample<Oscillator::UserDefinedWave>(
+							const float _sample )
+{
+	return( userWaveSample( _sample ) );
+}
+
+
+
+
+inline void Oscillator::phaseBlock( float * _phases, const float _osc_coeff,
+							const int _frames )
+{
+	// computing each phase from the start of the block rather than adding
+	// up the increments has no dependency between the frames
+	for( int i = 0; i < _frames; ++i )
 	{
-		_ab[frame][_chnl] += getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_phases[i] = m_phase + i * _osc_coeff;
 	}
+	m_phase = absFraction( m_phase + _frames * _osc_coeff );
 }
 
 
 
 
-// sync with sub-osc (every time sub-osc starts new period, we also start new
-// period)
 template<Oscillator::WaveShapes W>
-void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+inline void Oscillator::waveBlock( const float * _phases, float * _out,
+							const int _frames )
 {
-	const float sub_osc_coeff = m_subOsc->syncInit( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
-
-	for( fpp_t frame = 0; frame < _frames ; ++frame )
+	for( int i = 0; i < _frames; ++i )
 	{
-		if( m_subOsc->syncOk( sub_osc_coeff ) )
-		{
-			m_phase = m_phaseOffset;
-		}
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_out[i] = getSample<W>( _phases[i] );
 	}
 }
 
 
 
 
-// do fm by using sub-osc as modulator
-template<Oscillator::WaveShapes W>
-void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
+template<>
+inline void Oscillator::waveBlock<Oscillator::SineWave>(
+		const float * _phases, float * _out, const int _frames )
 {
-	m_subOsc->update( _ab, _frames, _chnl );
-	recalcPhase();
-	const float osc_coeff = m_freq * m_detuning;
-	const float sampleRateCorrection = 44100.0f /
-				Engine::mixer()->processingSampleRate();
-
-	for( fpp_t frame = 0; frame < _frames; ++frame )
+	for( int i = 0; i < _frames; ++i )
 	{
-		m_phase += _ab[frame][_chnl] * sampleRateCorrection;
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		_out[i] = fastSinSample( _phases[i] );
 	}
 }
 
@@ -471,82 +471,242 @@ void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::SineWave>(
-							const float _sample )
+inline void Oscillator::waveBlock<Oscillator::TriangleWave>(
+		const float * _phases, float * _out, const int _frames )
 {
-	return( sinSample( _sample ) );
+	// same as triangleSample(), without the branches
+	for( int i = 0; i < _frames; ++i )
+	{
+		const float z = absFraction( _phases[i] + 0.25f );
+		_out[i] = 1.0f - 4.0f * fabsf( z - 0.5f );
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::TriangleWave>(
-							const float _sample )
+template<sample_t (*F)( const float )>
+static inline void sampleBlock( const float * _phases, float * _out,
+							const int _frames )
 {
-	return( triangleSample( _sample ) );
+	for( int i = 0; i < _frames; ++i )
+	{
+		_out[i] = F( _phases[i] );
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::SawWave>(
-							const float _sample )
+void Oscillator::waveBlock( const WaveShapes _shape, const float * _phases,
+						float * _out, const int _frames )
 {
-	return( sawSample( _sample ) );
+	switch( _shape )
+	{
+		case SineWave:
+			sampleBlock<&Oscillator::fastSinSample>( _phases, _out, _frames );
+			break;
+		case TriangleWave:
+			for( int i = 0; i < _frames; ++i )
+			{
+				const float z = absFraction( _phases[i] + 0.25f );
+				_out[i] = 1.0f - 4.0f * fabsf( z - 0.5f );
+			}
+			break;
+		case SawWave:
+			sampleBlock<&Oscillator::sawSample>( _phases, _out, _frames );
+			break;
+		case SquareWave:
+			sampleBlock<&Oscillator::squareSample>( _phases, _out, _frames );
+			break;
+		case MoogSawWave:
+			sampleBlock<&Oscillator::moogSawSample>( _phases, _out, _frames );
+			break;
+		case ExponentialWave:
+			sampleBlock<&Oscillator::expSample>( _phases, _out, _frames );
+			break;
+		case WhiteNoise:
+			sampleBlock<&Oscillator::noiseSample>( _phases, _out, _frames );
+			break;
+		default:
+			std::fill( _out, _out + _frames, 0.0f );
+			break;
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::SquareWave>(
-							const float _sample )
+// if we have no sub-osc, we can't do any modulation... just get our samples
+template<Oscillator::WaveShapes W>
+void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
+							const ch_cnt_t _chnl )
 {
-	return( squareSample( _sample ) );
+	recalcPhase();
+	const float osc_coeff = m_freq * m_detuning;
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( fpp_t start = 0; start < _frames; start += BlockSize )
+	{
+		const int frames = qMin<int>( BlockSize, _frames - start );
+		phaseBlock( phases, osc_coeff, frames );
+		waveBlock<W>( phases, wave, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			_ab[start + i][_chnl] = wave[i] * m_volume;
+		}
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::MoogSawWave>(
-							const float _sample )
+// do pm by using sub-osc as modulator
+template<Oscillator::WaveShapes W>
+void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
+							const ch_cnt_t _chnl )
 {
-	return( moogSawSample( _sample ) );
+	m_subOsc->update( _ab, _frames, _chnl );
+	recalcPhase();
+	const float osc_coeff = m_freq * m_detuning;
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( fpp_t start = 0; start < _frames; start += BlockSize )
+	{
+		const int frames = qMin<int>( BlockSize, _frames - start );
+		phaseBlock( phases, osc_coeff, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			phases[i] += _ab[start + i][_chnl];
+		}
+		waveBlock<W>( phases, wave, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			_ab[start + i][_chnl] = wave[i] * m_volume;
+		}
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::ExponentialWave>(
-							const float _sample )
+// do am by using sub-osc as modulator
+template<Oscillator::WaveShapes W>
+void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
+							const ch_cnt_t _chnl )
 {
-	return( expSample( _sample ) );
+	m_subOsc->update( _ab, _frames, _chnl );
+	recalcPhase();
+	const float osc_coeff = m_freq * m_detuning;
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( fpp_t start = 0; start < _frames; start += BlockSize )
+	{
+		const int frames = qMin<int>( BlockSize, _frames - start );
+		phaseBlock( phases, osc_coeff, frames );
+		waveBlock<W>( phases, wave, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			_ab[start + i][_chnl] *= wave[i] * m_volume;
+		}
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::WhiteNoise>(
-							const float _sample )
+// do mix by using sub-osc as mix-sample
+template<Oscillator::WaveShapes W>
+void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
+							const ch_cnt_t _chnl )
 {
-	return( noiseSample( _sample ) );
+	m_subOsc->update( _ab, _frames, _chnl );
+	recalcPhase();
+	const float osc_coeff = m_freq * m_detuning;
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( fpp_t start = 0; start < _frames; start += BlockSize )
+	{
+		const int frames = qMin<int>( BlockSize, _frames - start );
+		phaseBlock( phases, osc_coeff, frames );
+		waveBlock<W>( phases, wave, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			_ab[start + i][_chnl] += wave[i] * m_volume;
+		}
+	}
 }
 
 
 
 
-template<>
-inline sample_t Oscillator::getSample<Oscillator::UserDefinedWave>(
-							const float _sample )
+// sync with sub-osc (every time sub-osc starts new period, we also start new
+// period)
+template<Oscillator::WaveShapes W>
+void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
+							const ch_cnt_t _chnl )
 {
-	return( userWaveSample( _sample ) );
+	const float sub_osc_coeff = m_subOsc->syncInit( _ab, _frames, _chnl );
+	recalcPhase();
+	const float osc_coeff = m_freq * m_detuning;
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( fpp_t start = 0; start < _frames; start += BlockSize )
+	{
+		const int frames = qMin<int>( BlockSize, _frames - start );
+		// the resets make the phases depend on each other
+		for( int i = 0; i < frames; ++i )
+		{
+			if( m_subOsc->syncOk( sub_osc_coeff ) )
+			{
+				m_phase = m_phaseOffset;
+			}
+			phases[i] = m_phase;
+			m_phase += osc_coeff;
+		}
+		waveBlock<W>( phases, wave, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			_ab[start + i][_chnl] = wave[i] * m_volume;
+		}
+	}
 }
 
 
 
 
+// do fm by using sub-osc as modulator
+template<Oscillator::WaveShapes W>
+void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
+							const ch_cnt_t _chnl )
+{
+	m_subOsc->update( _ab, _frames, _chnl );
+	recalcPhase();
+	const float osc_coeff = m_freq * m_detuning;
+	const float sampleRateCorrection = 44100.0f /
+				Engine::mixer()->processingSampleRate();
+
+	float phases[BlockSize];
+	float wave[BlockSize];
+	for( fpp_t start = 0; start < _frames; start += BlockSize )
+	{
+		const int frames = qMin<int>( BlockSize, _frames - start );
+		// the modulation accumulates in the phase
+		for( int i = 0; i < frames; ++i )
+		{
+			m_phase += _ab[start + i][_chnl] * sampleRateCorrection;
+			phases[i] = m_phase;
+			m_phase += osc_coeff;
+		}
+		waveBlock<W>( phases, wave, frames );
+		for( int i = 0; i < frames; ++i )
+		{
+			_ab[start + i][_chnl] = wave[i] * m_volume;
+		}
+	}
+}
@@ -0,0 +1,250 @@
+/*
+ * Oversampler.cpp - low-latency half-band oversampling for effects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Oversampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "lmms_constants.h"
+
+
+namespace
+{
+
+// number of allpass coefficients and transition bandwidth (relative to the
+// output rate, ending at a quarter of it) of the half-band filter of each
+// stage; the first one keeps everything up to 0.44 of the original rate
+// and attenuates its images by about 90 dB, the following ones see the
+// original band at a fraction of their rate and can be much shorter
+struct StageDesign
+{
+	int coefs;
+	double transition;
+} ;
+
+const StageDesign StageDesigns[] = { { 8, 0.03 }, { 4, 0.135 }, { 4, 0.19 } };
+
+
+// Allpass coefficients of an elliptic half-band filter with the given number
+// of coefficients and transition bandwidth, as designed by Laurent de Soras'
+// HIIR library.
+void designHalfBand( double * coefs, int count, double transition )
+{
+	double k = std::tan( ( 1.0 - transition * 2.0 ) * D_PI / 4.0 );
+	k *= k;
+	const double kksqrt = std::pow( 1.0 - k * k, 0.25 );
+	const double e = 0.5 * ( 1.0 - kksqrt ) / ( 1.0 + kksqrt );
+	const double e4 = e * e * e * e;
+	const double q = e * ( 1.0 + e4 * ( 2.0 + e4 * ( 15.0 + 150.0 * e4 ) ) );
+	const int order = count * 2 + 1;
+
+	for( int c = 1; c <= count; ++c )
+	{
+		double num = 0.0;
+		double term;
+		int i = 0;
+		int sign = 1;
+		do
+		{
+			term = std::pow( q, i * ( i + 1 ) ) *
+				std::sin( ( i * 2 + 1 ) * c * D_PI / order ) * sign;
+			num += term;
+			sign = -sign;
+			++i;
+		} while( std::fabs( term ) > 1e-100 );
+
+		double den = 0.0;
+		i = 1;
+		sign = -1;
+		do
+		{
+			term = std::pow( q, i * i ) *
+				std::cos( i * 2 * c * D_PI / order ) * sign;
+			den += term;
+			sign = -sign;
+			++i;
+		} while( std::fabs( term ) > 1e-100 );
+
+		const double ww = num * std::pow( q, 0.25 ) / ( den + 0.5 );
+		const double wwsq = ww * ww;
+		const double x = std::sqrt( ( 1.0 - wwsq * k ) *
+					( 1.0 - wwsq / k ) ) / ( 1.0 + wwsq );
+		coefs[c - 1] = ( 1.0 - x ) / ( 1.0 + x );
+	}
+}
+
+} // namespace
+
+
+
+
+void Oversampler::Stage::init( int stage )
+{
+	const StageDesign & design = StageDesigns[stage];
+	double designed[2 * MaxSections];
+	designHalfBand( designed, design.coefs, design.transition );
+
+	// the even coefficients belong to the even branch, the odd ones to
+	// the odd branch
+	sections = design.coefs / 2;
+	for( int s = 0; s < sections; ++s )
+	{
+		coefs[s][0] = coefs[s][1] = static_cast<float>( designed[2 * s] );
+		coefs[s][2] = coefs[s][3] = static_cast<float>( designed[2 * s + 1] );
+	}
+	reset();
+}
+
+
+
+
+void Oversampler::Stage::reset()
+{
+	memset( x, 0, sizeof( x ) );
+	memset( y, 0, sizeof( y ) );
+}
+
+
+
+
+inline void Oversampler::Stage::process( float * lanes )
+{
+	for( int s = 0; s < sections; ++s )
+	{
+		for( int l = 0; l < 4; ++l )
+		{
+			const float out = ( lanes[l] - y[s][l] ) * coefs[s][l] + x[s][l];
+			x[s][l] = lanes[l];
+			y[s][l] = out;
+			lanes[l] = out;
+		}
+	}
+}
+
+
+
+
+Oversampler::Oversampler( int factor, fpp_t maxFrames ) :
+	m_factor( 1 ),
+	m_stages( 0 ),
+	m_maxFrames( maxFrames )
+{
+	while( m_factor < factor && m_stages < MaxStages )
+	{
+		m_up[m_stages].init( m_stages );
+		m_down[m_stages].init( m_stages );
+		m_factor *= 2;
+		++m_stages;
+	}
+	for( int i = 0; i < 2; ++i )
+	{
+		m_buffers[i] = MM_ALLOC( sampleFrame,
+				static_cast<f_cnt_t>( m_maxFrames ) * m_factor );
+	}
+}
+
+
+
+
+Oversampler::~Oversampler()
+{
+	MM_FREE( m_buffers[0] );
+	MM_FREE( m_buffers[1] );
+}
+
+
+
+
+void Oversampler::reset()
+{
+	for( int s = 0; s < m_stages; ++s )
+	{
+		m_up[s].reset();
+		m_down[s].reset();
+	}
+}
+
+
+
+
+sampleFrame * Oversampler::up( const sampleFrame * in, fpp_t frames )
+{
+	// oversampled frame counts may not fit fpp_t
+	f_cnt_t inFrames = std::min( frames, m_maxFrames );
+	if( m_stages == 0 )
+	{
+		memcpy( m_buffers[0], in, inFrames * sizeof( sampleFrame ) );
+		return m_buffers[0];
+	}
+
+	const sampleFrame * src = in;
+	sampleFrame * dst = NULL;
+	for( int s = 0; s < m_stages; ++s, inFrames *= 2 )
+	{
+		dst = m_buffers[s % 2];
+		Stage & stage = m_up[s];
+		for( f_cnt_t f = 0; f < inFrames; ++f )
+		{
+			alignas( 16 ) float lanes[4] =
+				{ src[f][0], src[f][1], src[f][0], src[f][1] };
+			stage.process( lanes );
+			dst[2 * f][0] = lanes[0];
+			dst[2 * f][1] = lanes[1];
+			dst[2 * f + 1][0] = lanes[2];
+			dst[2 * f + 1][1] = lanes[3];
+		}
+		src = dst;
+	}
+	return dst;
+}
+
+
+
+
+void Oversampler::down( sampleFrame * buf, sampleFrame * out, fpp_t frames )
+{
+	frames = std::min( frames, m_maxFrames );
+	f_cnt_t outFrames = static_cast<f_cnt_t>( frames ) * m_factor;
+	// each stage works in place, reading two frames for each one it writes
+	for( int s = m_stages - 1; s >= 0; --s )
+	{
+		outFrames /= 2;
+		Stage & stage = m_down[s];
+		for( f_cnt_t f = 0; f < outFrames; ++f )
+		{
+			alignas( 16 ) float lanes[4] =
+				{ buf[2 * f + 1][0], buf[2 * f + 1][1],
+					buf[2 * f][0], buf[2 * f][1] };
+			stage.process( lanes );
+			buf[f][0] = 0.5f * ( lanes[0] + lanes[2] );
+			buf[f][1] = 0.5f * ( lanes[1] + lanes[3] );
+		}
+	}
+	if( out != buf )
+	{
+		memcpy( out, buf, frames * sizeof( sampleFrame ) );
+	}
+}
@@ -90,19 +90,32 @@ void PeakController::updateValueBuffer()
 			const f_cnt_t frames = Engine::mixer()->framesPerPeriod();
 			float * values = m_valueBuffer.values();
 
-			for( f_cnt_t f = 0; f < frames; ++f )
+			// The follower approaches the target exponentially without
+			// crossing it, so within a period it is either going up or
+			// down, and after f + 1 frames it is at
+			//     target + ( current - target ) * ( 1 - coeff )^( f + 1 )
+			// which has no dependency between the frames.
+			const float coeff = m_currentSample < targetSample ?
+						m_attackCoeff : m_decayCoeff;
+			const int BlockSize = 64;
+			float powers[BlockSize];
+			powers[0] = 1.0f - coeff;
+			for( int i = 1; i < BlockSize; ++i )
 			{
-				const float diff = ( targetSample - m_currentSample );
-				if( m_currentSample < targetSample ) // going up...
-				{
-					m_currentSample += diff * m_attackCoeff;
-				}
-				else if( m_currentSample > targetSample ) // going down
+				powers[i] = powers[i - 1] * powers[0];
+			}
+
+			float distance = m_currentSample - targetSample;
+			for( f_cnt_t start = 0; start < frames; start += BlockSize )
+			{
+				const int count = qMin<int>( BlockSize, frames - start );
+				for( int i = 0; i < count; ++i )
 				{
-					m_currentSample += diff * m_decayCoeff;
+					values[start + i] = targetSample + distance * powers[i];
 				}
-				values[f] = m_currentSample;
+				distance *= powers[count - 1];
 			}
+			m_currentSample = values[frames - 1];
 		}
 		else
 		{
@@ -113,7 +126,7 @@ void PeakController::updateValueBuffer()
 	{
 		m_valueBuffer.fill( 0 );
 	}
-	m_bufferLastUpdated = s_periods;
+	m_bufferLastUpdated = runningPeriods();
 }
 
 
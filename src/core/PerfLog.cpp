@@ -24,7 +24,25 @@
 
 #include "PerfLog.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+
 #include "lmmsconfig.h"
+#include "RealtimeCheck.h"
+
+#ifdef __GNUC__
+#	include <cxxabi.h>
+#	include <cstdlib>
+#endif
 
 #if defined(LMMS_HAVE_SYS_TIMES_H) && defined(LMMS_HAVE_UNISTD_H)
 #	define USE_POSIX_TIME
@@ -129,3 +147,384 @@ void PerfLogTimer::end()
 	// Invalidate so destructor won't call print another log entry
 	begin_time = PerfTime();
 }
+
+
+
+
+namespace
+{
+
+struct TimelineRecord
+{
+	const char* name;
+	int thread;
+	int depth;
+	qint64 begin;
+	qint64 end;
+};
+
+struct OpenPhase
+{
+	const char* name;
+	qint64 begin;
+};
+
+QMutex timelineMutex;
+QElapsedTimer timelineClock;
+QString timelineTraceFile;
+std::vector<TimelineRecord> timelineRecords;
+std::size_t timelineReported = 0;
+std::atomic<int> timelineThreads(0);
+
+thread_local std::vector<OpenPhase> openPhases;
+thread_local int timelineThread = -1;
+
+
+void printTimeline(const std::vector<TimelineRecord>& records)
+{
+	struct Line
+	{
+		const char* name;
+		int depth;
+		int count;
+		qint64 total;
+	};
+
+	// phases of the thread which started the timeline, i.e. the main
+	// thread, as a tree; runs of siblings with the same name, like the
+	// tracks of a project, are merged into one line each
+	std::vector<Line> lines;
+	std::vector<int> lastAtDepth;
+	// the other threads by name
+	std::vector<Line> workers;
+	for (const TimelineRecord& record : records)
+	{
+		const qint64 duration = record.end - record.begin;
+		if (record.thread != 0)
+		{
+			auto line = std::find_if(workers.begin(), workers.end(),
+				[&record](const Line& l) { return qstrcmp(l.name, record.name) == 0; });
+			if (line == workers.end())
+			{
+				workers.push_back(Line{record.name, 1, 0, 0});
+				line = workers.end() - 1;
+			}
+			++line->count;
+			line->total += duration;
+			continue;
+		}
+
+		const int depth = record.depth;
+		if (lastAtDepth.size() <= static_cast<std::size_t>(depth))
+		{
+			lastAtDepth.resize(depth + 1, -1);
+		}
+		const int last = lastAtDepth[depth];
+		if (last >= 0 && qstrcmp(lines[last].name, record.name) == 0)
+		{
+			++lines[last].count;
+			lines[last].total += duration;
+			continue;
+		}
+		lastAtDepth[depth] = static_cast<int>(lines.size());
+		std::fill(lastAtDepth.begin() + depth + 1, lastAtDepth.end(), -1);
+		lines.push_back(Line{record.name, depth, 1, duration});
+	}
+
+	lines.insert(lines.end(), workers.begin(), workers.end());
+	if (!workers.empty())
+	{
+		lines.insert(lines.end() - workers.size(), Line{"Other threads", 0, 0, 0});
+	}
+	for (const Line& line : lines)
+	{
+		const QString name = QString(line.depth * 2, ' ') + line.name +
+			(line.count > 1 ? QString(" (%1x)").arg(line.count) : QString());
+		if (line.count == 0)
+		{
+			fprintf(stderr, "TIMELINE | %s\n", qPrintable(name));
+			continue;
+		}
+		fprintf(stderr, "TIMELINE | %-48s %10.1f ms\n", qPrintable(name),
+			line.total / 1e6);
+	}
+}
+
+
+void writeTrace(const QString& fileName, const std::vector<TimelineRecord>& records)
+{
+	QJsonArray events;
+	for (const TimelineRecord& record : records)
+	{
+		events.append(QJsonObject{
+			{"name", record.name},
+			{"ph", "X"},
+			{"ts", record.begin / 1e3},
+			{"dur", (record.end - record.begin) / 1e3},
+			{"pid", 1},
+			{"tid", record.thread}});
+	}
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("PerfTimeline: can't write %s", qPrintable(fileName));
+		return;
+	}
+	file.write(QJsonDocument(QJsonObject{{"traceEvents", events}}).toJson(
+		QJsonDocument::Compact));
+}
+
+} // namespace
+
+
+
+
+std::atomic<bool> PerfTimeline::s_enabled(false);
+
+
+void PerfTimeline::setEnabled(bool enabled)
+{
+	QMutexLocker lock(&timelineMutex);
+	if (enabled && !timelineClock.isValid()) { timelineClock.start(); }
+	s_enabled = enabled;
+}
+
+
+void PerfTimeline::setTraceFile(const QString& file)
+{
+	QMutexLocker lock(&timelineMutex);
+	timelineTraceFile = file;
+}
+
+
+void PerfTimeline::begin(const char* name)
+{
+	if (!enabled()) { return; }
+	if (timelineThread < 0) { timelineThread = timelineThreads++; }
+	openPhases.push_back({name, timelineClock.nsecsElapsed()});
+}
+
+
+void PerfTimeline::end()
+{
+	if (openPhases.empty()) { return; }
+
+	const OpenPhase phase = openPhases.back();
+	openPhases.pop_back();
+	const TimelineRecord record = { phase.name, timelineThread,
+		static_cast<int>(openPhases.size()), phase.begin,
+		timelineClock.nsecsElapsed() };
+
+	QMutexLocker lock(&timelineMutex);
+	timelineRecords.push_back(record);
+}
+
+
+void PerfTimeline::report()
+{
+	if (!enabled() || !openPhases.empty()) { return; }
+
+	QMutexLocker lock(&timelineMutex);
+	if (timelineReported == timelineRecords.size()) { return; }
+
+	// the records are added when the phases end, so parents follow their
+	// children
+	auto byBegin = [](const TimelineRecord& a, const TimelineRecord& b)
+	{
+		return a.begin < b.begin || (a.begin == b.begin && a.depth < b.depth);
+	};
+	std::vector<TimelineRecord> records(timelineRecords.begin() + timelineReported,
+		timelineRecords.end());
+	std::stable_sort(records.begin(), records.end(), byBegin);
+	printTimeline(records);
+	timelineReported = timelineRecords.size();
+
+	if (!timelineTraceFile.isEmpty())
+	{
+		records = timelineRecords;
+		std::stable_sort(records.begin(), records.end(), byBegin);
+		writeTrace(timelineTraceFile, records);
+	}
+}
+
+
+
+
+#ifdef LMMS_DEBUG_TRACE
+
+namespace
+{
+
+struct TraceEvent
+{
+	const char* name;
+	qint64 begin;
+	qint64 end;
+	PerfTrace::Category category;
+};
+
+//! The events of a thread, only written by that thread. Kept after the
+//! thread ended, so its events are written as well.
+struct TraceBuffer
+{
+	int thread;
+	QString name;
+	std::unique_ptr<TraceEvent[]> events;
+	//! events[0, count) are complete
+	std::atomic<int> count;
+	std::atomic<int> dropped;
+};
+
+const char* const CategoryNames[PerfTrace::NumCategories] = {
+	"render", "job", "effect", "remote_plugin", "sample", "load", "gui" };
+
+QMutex traceMutex;
+std::vector<std::unique_ptr<TraceBuffer>> traceBuffers;
+const std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+
+thread_local TraceBuffer* threadTraceBuffer = nullptr;
+
+
+TraceBuffer* traceBuffer()
+{
+	if (!threadTraceBuffer)
+	{
+		// once per thread
+		RealtimeCheck::Allow allow;
+		QMutexLocker lock(&traceMutex);
+		traceBuffers.emplace_back(new TraceBuffer);
+		threadTraceBuffer = traceBuffers.back().get();
+		threadTraceBuffer->thread = static_cast<int>(traceBuffers.size());
+		threadTraceBuffer->count = 0;
+		threadTraceBuffer->dropped = 0;
+	}
+	return threadTraceBuffer;
+}
+
+
+QByteArray jsonString(const QString& text)
+{
+	QString escaped = text;
+	escaped.replace('\\', "\\\\").replace('"', "\\\"");
+	return '"' + escaped.toUtf8() + '"';
+}
+
+
+QByteArray eventName(const TraceEvent& event)
+{
+#ifdef __GNUC__
+	if (event.category == PerfTrace::Job)
+	{
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(event.name, nullptr, nullptr, &status);
+		if (demangled)
+		{
+			const QByteArray name = jsonString(demangled);
+			free(demangled);
+			return name;
+		}
+	}
+#endif
+	return jsonString(event.name);
+}
+
+} // namespace
+
+
+
+
+std::atomic<bool> PerfTrace::s_enabled(false);
+
+
+void PerfTrace::start()
+{
+	s_enabled = true;
+}
+
+
+void PerfTrace::stop()
+{
+	s_enabled = false;
+}
+
+
+bool PerfTrace::write(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("PerfTrace: can't write %s", qPrintable(fileName));
+		return false;
+	}
+
+	// written by hand, as the traces get too large for QJsonDocument
+	QMutexLocker lock(&traceMutex);
+	file.write("{\"traceEvents\":[\n");
+	bool first = true;
+	for (const std::unique_ptr<TraceBuffer>& buffer : traceBuffers)
+	{
+		const QString name = buffer->name.isEmpty()
+			? QString("Thread %1").arg(buffer->thread) : buffer->name;
+		file.write(QString("%1{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+			"\"tid\":%2,\"args\":{\"name\":").arg(first ? "" : ",\n")
+			.arg(buffer->thread).toUtf8() + jsonString(name) + "}}");
+		first = false;
+
+		const int count = buffer->count.load(std::memory_order_acquire);
+		for (int i = 0; i < count; ++i)
+		{
+			const TraceEvent& event = buffer->events[i];
+			file.write(",\n{\"name\":" + eventName(event) +
+				QString(",\"cat\":\"%1\",\"ph\":\"X\",\"ts\":%2,\"dur\":%3,"
+				"\"pid\":1,\"tid\":%4}").arg(CategoryNames[event.category])
+				.arg(event.begin / 1e3, 0, 'f', 3)
+				.arg((event.end - event.begin) / 1e3, 0, 'f', 3)
+				.arg(buffer->thread).toUtf8());
+		}
+		if (buffer->dropped > 0)
+		{
+			qWarning("PerfTrace: %s dropped %d events", qPrintable(name),
+				buffer->dropped.load());
+		}
+	}
+	file.write("\n]}\n");
+	return true;
+}
+
+
+void PerfTrace::setThreadName(const QString& name)
+{
+	TraceBuffer* buffer = traceBuffer();
+	QMutexLocker lock(&traceMutex);
+	buffer->name = name;
+}
+
+
+qint64 PerfTrace::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - traceStart).count();
+}
+
+
+void PerfTrace::record(const char* name, Category category, qint64 begin, qint64 end)
+{
+	TraceBuffer* buffer = traceBuffer();
+	if (!buffer->events)
+	{
+		RealtimeCheck::Allow allow;
+		buffer->events.reset(new TraceEvent[BufferSize]);
+	}
+
+	const int count = buffer->count.load(std::memory_order_relaxed);
+	if (count == BufferSize)
+	{
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	buffer->events[count] = TraceEvent{name, begin, end, category};
+	buffer->count.store(count + 1, std::memory_order_release);
+}
+
+#endif
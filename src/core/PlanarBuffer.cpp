@@ -0,0 +1,97 @@
+/*
+ * PlanarBuffer.cpp - audio buffer with one contiguous array per channel
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PlanarBuffer.h"
+
+#include <cstdint>
+#include <cstring>
+
+
+PlanarBuffer::PlanarBuffer( f_cnt_t frames ) :
+	m_frames( frames )
+{
+	// pad each channel so the next one starts aligned, too
+	const int perAlignment = Alignment / sizeof( sample_t );
+	const f_cnt_t stride = ( frames + perAlignment - 1 ) /
+						perAlignment * perAlignment;
+
+	m_memory = MemoryManager::alloc(
+		sizeof( sample_t ) * stride * DEFAULT_CHANNELS + Alignment );
+	const uintptr_t aligned =
+		( reinterpret_cast<uintptr_t>( m_memory ) + Alignment - 1 ) &
+					~static_cast<uintptr_t>( Alignment - 1 );
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		m_channels[ch] = reinterpret_cast<sample_t *>( aligned ) +
+								ch * stride;
+	}
+	clear( frames );
+}
+
+
+
+
+PlanarBuffer::~PlanarBuffer()
+{
+	MemoryManager::free( m_memory );
+}
+
+
+
+
+void PlanarBuffer::clear( f_cnt_t frames )
+{
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		memset( m_channels[ch], 0, sizeof( sample_t ) * frames );
+	}
+}
+
+
+
+
+void PlanarBuffer::fromInterleaved( const sampleFrame * src, f_cnt_t frames )
+{
+	sample_t * left = m_channels[0];
+	sample_t * right = m_channels[1];
+	for( f_cnt_t f = 0; f < frames; ++f )
+	{
+		left[f] = src[f][0];
+		right[f] = src[f][1];
+	}
+}
+
+
+
+
+void PlanarBuffer::toInterleaved( sampleFrame * dst, f_cnt_t frames ) const
+{
+	const sample_t * left = m_channels[0];
+	const sample_t * right = m_channels[1];
+	for( f_cnt_t f = 0; f < frames; ++f )
+	{
+		dst[f][0] = left[f];
+		dst[f][1] = right[f];
+	}
+}
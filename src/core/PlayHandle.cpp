@@ -23,9 +23,11 @@
  */
  
 #include "PlayHandle.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Engine.h"
 #include "Mixer.h"
+#include "RealtimeCheck.h"
 
 #include <QtCore/QThread>
 #include <QDebug>
@@ -38,7 +40,11 @@ PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 		m_affinity(QThread::currentThread()),
 		m_playHandleBuffer(BufferManager::acquire()),
 		m_bufferReleased(true),
-		m_usesBuffer(true)
+		m_usesBuffer(true),
+		m_audioPort(nullptr),
+		m_mixerIndex(-1),
+		m_portIndex(-1),
+		m_removalRequested(false)
 {
 }
 
@@ -51,6 +57,9 @@ PlayHandle::~PlayHandle()
 
 void PlayHandle::doProcessing()
 {
+	// account the time to the track this play handle belongs to
+	MixerProfiler::Probe probe( m_audioPort ? &m_audioPort->processingTime() : nullptr );
+	RealtimeCheck::Context context( this );
 	if( m_usesBuffer )
 	{
 		m_bufferReleased = false;
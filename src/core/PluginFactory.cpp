@@ -24,13 +24,21 @@
 
 #include "PluginFactory.h"
 
+#include <QtCore/QBuffer>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
 #include <QtCore/QLibrary>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QGuiApplication>
+#include <QPixmap>
 #include "lmmsconfig.h"
+#include "lmmsversion.h"
 
 #include "ConfigManager.h"
+#include "PerfLog.h"
 #include "Plugin.h"
 #include "embed.h"
 
@@ -45,10 +53,258 @@ qint64 qHash(const QFileInfo& fi)
 	return qHash(fi.absoluteFilePath());
 }
 
+namespace
+{
+
+// The index of the plugin libraries found, so only new and changed ones are
+// loaded at startup. It holds the descriptors and the logos as PNG.
+const char IndexMagic[] = "LMMSPIDX";
+const quint32 IndexVersion = 1;
+
+struct IndexEntry
+{
+	qint64 modified = 0;
+	qint64 size = 0;
+	// libraries like ZynAddSubFxCore have no descriptor
+	bool isPlugin = false;
+	// these are always loaded, as their keys can change without them
+	bool hasSubPlugins = false;
+	QByteArray name;
+	QByteArray displayName;
+	QByteArray description;
+	QByteArray author;
+	QByteArray supportedFileTypes;
+	qint32 version = 0;
+	qint32 type = 0;
+	bool hasLogo = false;
+	QString logoName;
+	QByteArray logo;
+};
+
+typedef QHash<QString, IndexEntry> Index;
+
+
+QDataStream& operator<<(QDataStream& stream, const IndexEntry& entry)
+{
+	return stream << entry.modified << entry.size << entry.isPlugin
+		<< entry.hasSubPlugins << entry.name << entry.displayName
+		<< entry.description << entry.author << entry.supportedFileTypes
+		<< entry.version << entry.type << entry.hasLogo << entry.logoName
+		<< entry.logo;
+}
+
+
+QDataStream& operator>>(QDataStream& stream, IndexEntry& entry)
+{
+	return stream >> entry.modified >> entry.size >> entry.isPlugin
+		>> entry.hasSubPlugins >> entry.name >> entry.displayName
+		>> entry.description >> entry.author >> entry.supportedFileTypes
+		>> entry.version >> entry.type >> entry.hasLogo >> entry.logoName
+		>> entry.logo;
+}
+
+
+
+
+QString indexFile()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+							"/plugins.index";
+}
+
+
+
+
+Index readIndex()
+{
+	QFile file(indexFile());
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return Index();
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	QByteArray magic;
+	quint32 version;
+	QString lmmsVersion;
+	stream >> magic >> version >> lmmsVersion;
+	if (magic != IndexMagic || version != IndexVersion || lmmsVersion != LMMS_VERSION)
+	{
+		return Index();
+	}
+	Index index;
+	stream >> index;
+	return stream.status() == QDataStream::Ok ? index : Index();
+}
+
+
+
+
+void writeIndex(const Index& index)
+{
+	const QString fileName = indexFile();
+	QDir().mkpath(QFileInfo(fileName).path());
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << QByteArray(IndexMagic) << IndexVersion << QString(LMMS_VERSION) << index;
+	file.commit();
+}
+
+
+
+
+//! Whether @p entry describes the library as it is now
+bool isCurrent(const IndexEntry& entry, const QFileInfo& file, bool withLogo)
+{
+	return entry.modified == file.lastModified().toMSecsSinceEpoch() &&
+		entry.size == file.size() && !entry.hasSubPlugins &&
+		(!withLogo || !entry.hasLogo || !entry.logo.isEmpty());
+}
+
+
+
+
+IndexEntry indexEntry(const QFileInfo& file, const Plugin::Descriptor* descriptor, bool withLogo)
+{
+	IndexEntry entry;
+	entry.modified = file.lastModified().toMSecsSinceEpoch();
+	entry.size = file.size();
+	entry.isPlugin = descriptor != nullptr;
+	if (descriptor == nullptr)
+	{
+		return entry;
+	}
+
+	entry.hasSubPlugins = descriptor->subPluginFeatures != nullptr;
+	entry.name = descriptor->name;
+	entry.displayName = descriptor->displayName;
+	entry.description = descriptor->description;
+	entry.author = descriptor->author;
+	entry.supportedFileTypes = descriptor->supportedFileTypes;
+	entry.version = descriptor->version;
+	entry.type = descriptor->type;
+	entry.hasLogo = descriptor->logo != nullptr;
+	if (entry.hasLogo)
+	{
+		entry.logoName = descriptor->logo->pixmapName();
+		if (withLogo)
+		{
+			QBuffer buffer(&entry.logo);
+			buffer.open(QIODevice::WriteOnly);
+			descriptor->logo->pixmap().save(&buffer, "PNG");
+		}
+	}
+	return entry;
+}
+
+
+
+
+//! The descriptor of an LMMS plugin library, or nullptr
+Plugin::Descriptor* resolveDescriptor(QLibrary& library, const QFileInfo& file)
+{
+	if (!library.resolve("lmms_plugin_main"))
+	{
+		return nullptr;
+	}
+
+	QString descriptorName = file.baseName() + "_plugin_descriptor";
+	if( descriptorName.left(3) == "lib" )
+	{
+		descriptorName = descriptorName.mid(3);
+	}
+
+	auto pluginDescriptor = reinterpret_cast<Plugin::Descriptor*>(library.resolve(descriptorName.toUtf8().constData()));
+	if(pluginDescriptor == nullptr)
+	{
+		qWarning() << qApp->translate("PluginFactory", "LMMS plugin %1 does not have a plugin descriptor named %2!").
+					  arg(file.absoluteFilePath()).arg(descriptorName);
+	}
+	return pluginDescriptor;
+}
+
+
+
+
+//! The logo of a plugin taken from the index, loading the library if the
+//! index has no image of it
+class IndexedPixmapLoader : public PixmapLoader
+{
+public:
+	IndexedPixmapLoader(const IndexEntry& entry) :
+		PixmapLoader(entry.logoName),
+		m_plugin(entry.name),
+		m_png(entry.logo)
+	{
+	}
+
+	QPixmap pixmap() const override
+	{
+		QPixmap pixmap;
+		if (!m_png.isEmpty() && pixmap.loadFromData(m_png, "PNG"))
+		{
+			return pixmap;
+		}
+
+		const PluginFactory::PluginInfo info = pluginFactory->pluginInfo(m_plugin.constData());
+		const Plugin::Descriptor* descriptor = info.isNull() ? nullptr :
+					resolveDescriptor(*info.library, info.file);
+		return descriptor != nullptr && descriptor->logo != nullptr ?
+					descriptor->logo->pixmap() : QPixmap();
+	}
+
+private:
+	QByteArray m_plugin;
+	QByteArray m_png;
+} ;
+
+} // namespace
+
+
+
+
+struct PluginFactory::IndexedPlugin
+{
+	IndexedPlugin(const IndexEntry& indexEntry) :
+		entry(indexEntry),
+		descriptor()
+	{
+		auto string = [](const QByteArray& s) { return s.isNull() ? nullptr : s.constData(); };
+		descriptor.name = string(entry.name);
+		descriptor.displayName = string(entry.displayName);
+		descriptor.description = string(entry.description);
+		descriptor.author = string(entry.author);
+		descriptor.version = entry.version;
+		descriptor.type = static_cast<Plugin::PluginTypes>(entry.type);
+		descriptor.supportedFileTypes = string(entry.supportedFileTypes);
+		descriptor.subPluginFeatures = nullptr;
+		if (entry.hasLogo)
+		{
+			logo.reset(new IndexedPixmapLoader(entry));
+			descriptor.logo = logo.get();
+		}
+	}
+
+	const IndexEntry entry;
+	Plugin::Descriptor descriptor;
+	std::unique_ptr<PixmapLoader> logo;
+};
+
+
+
+
 std::unique_ptr<PluginFactory> PluginFactory::s_instance;
 
 PluginFactory::PluginFactory()
 {
+	PerfTimeline::Phase phase("Plugin discovery");
 	setupSearchPaths();
 	discoverPlugins();
 }
@@ -119,12 +375,20 @@ const PluginFactory::PluginInfoAndKey PluginFactory::pluginSupportingExtension(c
 	return m_pluginByExt.value(ext, PluginInfoAndKey());
 }
 
-const PluginFactory::PluginInfo PluginFactory::pluginInfo(const char* name) const
+const PluginFactory::PluginInfo PluginFactory::pluginInfo(const char* name)
 {
 	for (const PluginInfo& info : m_pluginInfos)
 	{
 		if (qstrcmp(info.descriptor->name, name) == 0)
+		{
+			if (!info.library->isLoaded() && !loadLibrary(*info.library))
+			{
+				m_errors[name] = info.library->errorString();
+				qWarning("%s", info.library->errorString().toLocal8Bit().data());
+				return PluginInfo();
+			}
 			return info;
+		}
 	}
 	return PluginInfo();
 }
@@ -152,38 +416,44 @@ void PluginFactory::discoverPlugins()
 #endif
 	}
 
-	// Cheap dependency handling: zynaddsubfx needs ZynAddSubFxCore. By loading
-	// all libraries twice we ensure that libZynAddSubFxCore is found.
-	for (const QFileInfo& file : files)
-	{
-		QLibrary(file.absoluteFilePath()).load();
-	}
+	m_libraryFiles = files.values();
+	m_loadedAllLibraries = false;
+
+	const Index index = readIndex();
+	Index newIndex;
+	bool indexChanged = false;
+	// the plugin browser shows the logos, so they're stored when there's a GUI
+	const bool withLogos = qobject_cast<QGuiApplication*>(qApp) != nullptr;
+	m_indexedPlugins.clear();
 
 	for (const QFileInfo& file : files)
 	{
-		auto library = std::make_shared<QLibrary>(file.absoluteFilePath());
-		if (! library->load()) {
-			m_errors[file.baseName()] = library->errorString();
-			qWarning("%s", library->errorString().toLocal8Bit().data());
-			continue;
-		}
-
+		const QString path = file.absoluteFilePath();
+		auto library = std::make_shared<QLibrary>(path);
 		Plugin::Descriptor* pluginDescriptor = nullptr;
-		if (library->resolve("lmms_plugin_main"))
+
+		const auto indexed = index.constFind(path);
+		if (indexed != index.constEnd() && isCurrent(*indexed, file, withLogos))
 		{
-			QString descriptorName = file.baseName() + "_plugin_descriptor";
-			if( descriptorName.left(3) == "lib" )
+			// loaded when it's first used
+			newIndex.insert(path, *indexed);
+			if (!indexed->isPlugin)
 			{
-				descriptorName = descriptorName.mid(3);
+				continue;
 			}
-
-			pluginDescriptor = reinterpret_cast<Plugin::Descriptor*>(library->resolve(descriptorName.toUtf8().constData()));
-			if(pluginDescriptor == nullptr)
-			{
-				qWarning() << qApp->translate("PluginFactory", "LMMS plugin %1 does not have a plugin descriptor named %2!").
-							  arg(file.absoluteFilePath()).arg(descriptorName);
+			m_indexedPlugins.emplace_back(new IndexedPlugin(*indexed));
+			pluginDescriptor = &m_indexedPlugins.back()->descriptor;
+		}
+		else
+		{
+			if (!loadLibrary(*library)) {
+				m_errors[file.baseName()] = library->errorString();
+				qWarning("%s", library->errorString().toLocal8Bit().data());
 				continue;
 			}
+			pluginDescriptor = resolveDescriptor(*library, file);
+			newIndex.insert(path, indexEntry(file, pluginDescriptor, withLogos));
+			indexChanged = true;
 		}
 
 		if(pluginDescriptor)
@@ -238,6 +508,35 @@ void PluginFactory::discoverPlugins()
 
 	m_pluginInfos = pluginInfos;
 	m_descriptors = descriptors;
+
+	if (indexChanged || newIndex.size() != index.size())
+	{
+		writeIndex(newIndex);
+	}
+}
+
+
+
+
+bool PluginFactory::loadLibrary(QLibrary& library)
+{
+	if (library.load())
+	{
+		return true;
+	}
+	if (m_loadedAllLibraries)
+	{
+		return false;
+	}
+
+	// Cheap dependency handling: zynaddsubfx needs ZynAddSubFxCore. By loading
+	// all libraries once we ensure that libZynAddSubFxCore is found.
+	m_loadedAllLibraries = true;
+	for (const QFileInfo& file : m_libraryFiles)
+	{
+		QLibrary(file.absoluteFilePath()).load();
+	}
+	return library.load();
 }
 
 
@@ -22,11 +22,15 @@
  *
  */
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "ProjectJournal.h"
+#include "BinaryDocument.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "JournallingObject.h"
+#include "Model.h"
 #include "Song.h"
 
 //! Avoid clashes between loaded IDs (have the bit cleared)
@@ -34,13 +38,26 @@
 static const int EO_ID_MSB = 1 << 23;
 
 const int ProjectJournal::MAX_UNDO_STATES = 100; // TODO: make this configurable in settings
+const int ProjectJournal::DEFAULT_MAX_UNDO_MEMORY = 64;
+
+//! Checkpoints of the same object this close together are merged into the
+//! first one, so dragging a knob is undone at once
+static const qint64 COALESCE_TIME = 500;
+
 
 ProjectJournal::ProjectJournal() :
 	m_joIDs(),
 	m_undoCheckPoints(),
 	m_redoCheckPoints(),
+	m_maxBytes( DEFAULT_MAX_UNDO_MEMORY << 20 ),
 	m_journalling( false )
 {
+	const int maxMemory = ConfigManager::inst()->value( "app", "undomemory" ).toInt();
+	if( maxMemory > 0 )
+	{
+		m_maxBytes = std::min( maxMemory, 2047 ) << 20;
+	}
+	m_clock.start();
 }
 
 
@@ -57,19 +74,19 @@ void ProjectJournal::undo()
 {
 	while( !m_undoCheckPoints.isEmpty() )
 	{
-		CheckPoint c = m_undoCheckPoints.pop();
-		JournallingObject *jo = m_joIDs[c.joID];
+		jo_id_t id;
+		const QByteArray state = pop( m_undoCheckPoints, id );
+		JournallingObject *jo = m_joIDs[id];
 
 		if( jo )
 		{
-			DataFile curState( DataFile::JournalData );
-			jo->saveState( curState, curState.content() );
-			m_redoCheckPoints.push( CheckPoint( c.joID, curState ) );
+			push( m_redoCheckPoints, id, saveState( jo ) );
 
 			bool prev = isJournalling();
 			setJournalling( false );
-			jo->restoreState( c.data.content().firstChildElement() );
+			restoreState( jo, state );
 			setJournalling( prev );
+			markChanged( jo );
 			Engine::getSong()->setModified();
 			break;
 		}
@@ -82,19 +99,19 @@ void ProjectJournal::redo()
 {
 	while( !m_redoCheckPoints.isEmpty() )
 	{
-		CheckPoint c = m_redoCheckPoints.pop();
-		JournallingObject *jo = m_joIDs[c.joID];
+		jo_id_t id;
+		const QByteArray state = pop( m_redoCheckPoints, id );
+		JournallingObject *jo = m_joIDs[id];
 
 		if( jo )
 		{
-			DataFile curState( DataFile::JournalData );
-			jo->saveState( curState, curState.content() );
-			m_undoCheckPoints.push( CheckPoint( c.joID, curState ) );
+			push( m_undoCheckPoints, id, saveState( jo ) );
 
 			bool prev = isJournalling();
 			setJournalling( false );
-			jo->restoreState( c.data.content().firstChildElement() );
+			restoreState( jo, state );
 			setJournalling( prev );
+			markChanged( jo );
 			Engine::getSong()->setModified();
 			break;
 		}
@@ -111,6 +128,20 @@ bool ProjectJournal::canRedo() const
 	return !m_redoCheckPoints.isEmpty();
 }
 
+qint64 ProjectJournal::memoryUsage() const
+{
+	qint64 bytes = 0;
+	for( const CheckPoint & c : m_undoCheckPoints )
+	{
+		bytes += c.data.size();
+	}
+	for( const CheckPoint & c : m_redoCheckPoints )
+	{
+		bytes += c.data.size();
+	}
+	return bytes;
+}
+
 
 
 void ProjectJournal::addJournalCheckPoint( JournallingObject *jo )
@@ -118,14 +149,158 @@ void ProjectJournal::addJournalCheckPoint( JournallingObject *jo )
 	if( isJournalling() )
 	{
 		m_redoCheckPoints.clear();
+		markChanged( jo );
+
+		// the state before the first of rapid edits is the one to undo to
+		const qint64 now = m_clock.elapsed();
+		if( !m_undoCheckPoints.isEmpty() &&
+			m_undoCheckPoints.top().joID == jo->id() &&
+			now - m_undoCheckPoints.top().time < COALESCE_TIME )
+		{
+			m_undoCheckPoints.top().time = now;
+			return;
+		}
+
+		push( m_undoCheckPoints, jo->id(), saveState( jo ) );
+		trim();
+	}
+}
+
+
+
+
+QByteArray ProjectJournal::saveState( JournallingObject * jo )
+{
+	DataFile dataFile( DataFile::JournalData );
+	jo->saveState( dataFile, dataFile.content() );
+	return BinaryDocument::encode( dataFile );
+}
+
+
+
+
+void ProjectJournal::restoreState( JournallingObject * jo, const QByteArray & state )
+{
+	QDomDocument document;
+	if( BinaryDocument::decode( state, document ) )
+	{
+		// the state is in the content element, as saved by saveState()
+		jo->restoreState( document.documentElement().
+			firstChildElement( "journaldata" ).firstChildElement() );
+	}
+}
+
 
-		DataFile dataFile( DataFile::JournalData );
-		jo->saveState( dataFile, dataFile.content() );
 
-		m_undoCheckPoints.push( CheckPoint( jo->id(), dataFile ) );
-		if( m_undoCheckPoints.size() > MAX_UNDO_STATES )
+
+void ProjectJournal::push( CheckPointStack & stack, jo_id_t id, const QByteArray & state )
+{
+	for( int i = stack.size() - 1; i >= 0; --i )
+	{
+		CheckPoint & previous = stack[i];
+		if( previous.joID != id )
+		{
+			continue;
+		}
+
+		// only keep what differs from the new state
+		const QByteArray & old = previous.data;
+		const int length = std::min( old.size(), state.size() );
+		int prefix = 0;
+		while( prefix < length && old[prefix] == state[prefix] )
+		{
+			++prefix;
+		}
+		int suffix = 0;
+		while( suffix < length - prefix &&
+			old[old.size() - 1 - suffix] == state[state.size() - 1 - suffix] )
+		{
+			++suffix;
+		}
+		previous.data = old.mid( prefix, old.size() - prefix - suffix );
+		previous.isDelta = true;
+		previous.prefix = prefix;
+		previous.suffix = suffix;
+		break;
+	}
+
+	stack.push( CheckPoint( id, state, m_clock.elapsed() ) );
+}
+
+
+
+
+QByteArray ProjectJournal::pop( CheckPointStack & stack, jo_id_t & id )
+{
+	const CheckPoint top = stack.pop();
+	id = top.joID;
+
+	// the next older checkpoint of the object is a delta to this one
+	for( int i = stack.size() - 1; i >= 0; --i )
+	{
+		CheckPoint & previous = stack[i];
+		if( previous.joID != id )
+		{
+			continue;
+		}
+
+		if( previous.isDelta )
+		{
+			previous.data = top.data.left( previous.prefix ) + previous.data +
+							top.data.right( previous.suffix );
+			previous.isDelta = false;
+		}
+		break;
+	}
+
+	return top.data;
+}
+
+
+
+
+void ProjectJournal::trim()
+{
+	qint64 bytes = memoryUsage();
+
+	// the oldest checkpoint of an object is dropped, so no delta loses
+	// the state it refers to
+	int drop = std::max( 0, m_undoCheckPoints.size() - MAX_UNDO_STATES );
+	while( drop < m_undoCheckPoints.size() - 1 && bytes > m_maxBytes )
+	{
+		bytes -= m_undoCheckPoints[drop].data.size();
+		++drop;
+	}
+	if( drop > 0 )
+	{
+		m_undoCheckPoints.remove( 0, drop );
+	}
+}
+
+
+
+
+QSet<jo_id_t> ProjectJournal::takeChangedIDs()
+{
+	QSet<jo_id_t> changed;
+	changed.swap( m_changedIDs );
+	return changed;
+}
+
+
+
+
+void ProjectJournal::markChanged( JournallingObject * jo )
+{
+	m_changedIDs.insert( jo->id() );
+	// e.g. the track a pattern is on, so it's saved again as a whole
+	for( Model * model = dynamic_cast<Model *>( jo ); model != NULL;
+						model = model->parentModel() )
+	{
+		JournallingObject * owner = dynamic_cast<JournallingObject *>( model );
+		if( owner != NULL )
 		{
-			m_undoCheckPoints.remove( 0, m_undoCheckPoints.size() - MAX_UNDO_STATES );
+			m_changedIDs.insert( owner->id() );
 		}
 	}
 }
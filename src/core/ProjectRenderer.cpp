@@ -25,6 +25,8 @@
 
 #include <QFile>
 
+#include <algorithm>
+
 #include "ProjectRenderer.h"
 #include "Song.h"
 #include "PerfLog.h"
@@ -77,31 +79,144 @@ const ProjectRenderer::FileEncodeDevice ProjectRenderer::fileEncodeDevices[] =
 
 
 
+namespace
+{
+
+AudioFileDevice * createFileDevice( const OutputSettings & outputSettings,
+			ProjectRenderer::ExportFileFormats exportFileFormat,
+			const QString & outputFilename )
+{
+	AudioFileDeviceInstantiaton audioEncoderFactory =
+		ProjectRenderer::fileEncodeDevices[exportFileFormat].m_getDevInst;
+	if( !audioEncoderFactory )
+	{
+		return NULL;
+	}
+
+	bool successful = false;
+	AudioFileDevice * dev = audioEncoderFactory( outputFilename,
+			outputSettings, DEFAULT_CHANNELS, Engine::mixer(),
+								successful );
+	if( !successful )
+	{
+		delete dev;
+		return NULL;
+	}
+	return dev;
+}
+
+} // namespace
+
+
+
+
+ProjectRenderer::Statistics::Statistics() :
+	renderedTime( 0 ),
+	elapsedTime( 0 ),
+	remainingTime( -1 ),
+	encodingTime( 0 ),
+	peakMemoryKiB( 0 )
+{
+	std::fill( stageTime, stageTime + MixerProfiler::StageCount, 0.0 );
+}
+
+
+
+
+ProjectRenderer::Statistics & ProjectRenderer::Statistics::operator+=(
+						const Statistics & other )
+{
+	renderedTime += other.renderedTime;
+	elapsedTime += other.elapsedTime;
+	remainingTime = other.remainingTime;
+	encodingTime += other.encodingTime;
+	for( int i = 0; i < MixerProfiler::StageCount; ++i )
+	{
+		stageTime[i] += other.stageTime[i];
+	}
+	peakMemoryKiB = qMax( peakMemoryKiB, other.peakMemoryKiB );
+	return *this;
+}
+
+
+
+
+QJsonObject ProjectRenderer::Statistics::toJson() const
+{
+	// same names as in the results of the render benchmarks
+	QJsonObject object;
+	object["audio_seconds"] = renderedTime;
+	object["render_seconds"] = elapsedTime;
+	object["realtime_factor"] = realtimeFactor();
+	object["encoding_seconds"] = encodingTime;
+	QJsonObject stages;
+	for( int i = 0; i < MixerProfiler::StageCount; ++i )
+	{
+		stages[MixerProfiler::stageName(
+			static_cast<MixerProfiler::Stages>( i ) )] = stageTime[i];
+	}
+	object["stage_seconds"] = stages;
+	object["peak_memory_kib"] = static_cast<double>( peakMemoryKiB );
+	return object;
+}
+
+
+
+
+QString ProjectRenderer::Statistics::summary() const
+{
+	QString text = QString( "%1x realtime" ).arg( realtimeFactor(), 0, 'f', 1 );
+	if( remainingTime >= 0 )
+	{
+		const int seconds = static_cast<int>( remainingTime + 0.5 );
+		text += QString( ", %1:%2 left" ).arg( seconds / 60 )
+					.arg( seconds % 60, 2, 10, QChar( '0' ) );
+	}
+	return text;
+}
+
+
+
+
 ProjectRenderer::ProjectRenderer( const Mixer::qualitySettings & qualitySettings,
 					const OutputSettings & outputSettings,
 					ExportFileFormats exportFileFormat,
 					const QString & outputFilename ) :
 	QThread( Engine::mixer() ),
 	m_fileDev( NULL ),
+	m_freewheelDevice( NULL ),
 	m_qualitySettings( qualitySettings ),
 	m_progress( 0 ),
-	m_abort( false )
+	m_abort( false ),
+	m_renderedFrames( 0 ),
+	m_exportedFraction( 0 ),
+	m_finished( false )
 {
-	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[exportFileFormat].m_getDevInst;
+	std::fill( m_stageTimeAtStart,
+			m_stageTimeAtStart + MixerProfiler::StageCount, 0 );
+	m_fileDev = createFileDevice( outputSettings, exportFileFormat,
+							outputFilename );
+}
 
-	if (audioEncoderFactory)
-	{
-		bool successful = false;
 
-		m_fileDev = audioEncoderFactory(
-					outputFilename, outputSettings, DEFAULT_CHANNELS,
-					Engine::mixer(), successful );
-		if( !successful )
-		{
-			delete m_fileDev;
-			m_fileDev = NULL;
-		}
+
+
+bool ProjectRenderer::addOutput( const OutputSettings & outputSettings,
+					ExportFileFormats exportFileFormat,
+					const QString & outputFilename )
+{
+	if( !isReady() )
+	{
+		return false;
+	}
+	AudioFileDevice * dev = createFileDevice( outputSettings,
+					exportFileFormat, outputFilename );
+	if( dev == NULL )
+	{
+		return false;
 	}
+	m_fileDev->addMirror( dev );
+	return true;
 }
 
 
@@ -109,6 +224,11 @@ ProjectRenderer::ProjectRenderer( const Mixer::qualitySettings & qualitySettings
 
 ProjectRenderer::~ProjectRenderer()
 {
+	// otherwise the mixer owns it
+	if( m_freewheelDevice )
+	{
+		delete m_fileDev;
+	}
 }
 
 
@@ -151,8 +271,24 @@ void ProjectRenderer::startProcessing()
 	{
 		// Have to do mixer stuff with GUI-thread affinity in order to
 		// make slots connected to sampleRateChanged()-signals being called immediately.
-		Engine::mixer()->setAudioDevice( m_fileDev,
+		if( m_freewheelDevice )
+		{
+			Engine::mixer()->changeQuality( m_qualitySettings );
+		}
+		else
+		{
+			Engine::mixer()->setAudioDevice( m_fileDev,
 						m_qualitySettings, false, false );
+		}
+		emit processingPrepared();
+
+		MixerProfiler & profiler = Engine::mixer()->profiler();
+		for( int i = 0; i < MixerProfiler::StageCount; ++i )
+		{
+			m_stageTimeAtStart[i] = profiler.stageTime(
+				static_cast<MixerProfiler::Stages>( i ) ).total();
+		}
+		m_startTime = std::chrono::steady_clock::now();
 
 		start(
 #ifndef LMMS_BUILD_WIN32
@@ -180,20 +316,38 @@ void ProjectRenderer::run()
 
 	PerfLogTimer perfLog("Project Render");
 
+	if( m_freewheelDevice )
+	{
+		runFreewheel();
+		perfLog.end();
+		return;
+	}
+
+	// Exporting doesn't care about latency, so trade it for throughput
+	Engine::mixer()->setPipelined(true);
+	const int latency = Engine::mixer()->pipelineLatency();
+
 	Engine::getSong()->startExport();
-	// Skip first empty buffer.
-	Engine::mixer()->nextBuffer();
+	// Skip first empty buffer and the ones still in the pipeline.
+	for (int i = 0; i < 1 + latency; ++i)
+	{
+		Engine::mixer()->nextBufferDone(Engine::mixer()->nextBuffer());
+	}
 
 	m_progress = 0;
 
-	// Now start processing
+	// Now start processing, encoding on a thread of its own so the
+	// encoder's time doesn't add to the rendering time
 	Engine::mixer()->startProcessing(false);
+	m_fileDev->startEncoderThread(EncoderQueueDepth);
 
 	// Continually track and emit progress percentage to listeners.
 	while (!Engine::getSong()->isExportDone() && !m_abort)
 	{
 		m_fileDev->processNextBuffer();
-		const int nprog = Engine::getSong()->getExportProgress();
+		m_renderedFrames += Engine::mixer()->framesPerPeriod();
+		m_exportedFraction = Engine::getSong()->exportedFraction();
+		const int nprog = m_exportedFraction * 100;
 		if (m_progress != nprog)
 		{
 			m_progress = nprog;
@@ -201,19 +355,121 @@ void ProjectRenderer::run()
 		}
 	}
 
+	// Flush the buffers still in the pipeline
+	for (int i = 0; i < latency && !m_abort; ++i)
+	{
+		m_fileDev->processNextBuffer();
+	}
+
+	m_fileDev->stopEncoderThread();
+
+	m_finalStatistics = currentStatistics();
+	m_finalStatistics.remainingTime = 0;
+	m_finished = true;
+
 	// Notify mixer of the end of processing.
 	Engine::mixer()->stopProcessing();
+	Engine::mixer()->setPipelined(false);
 
 	Engine::getSong()->stopExport();
 
 	perfLog.end();
 
-	// If the user aborted export-process, the file has to be deleted.
-	const QString f = m_fileDev->outputFile();
+	// If the user aborted export-process, the files have to be deleted.
+	if( m_abort )
+	{
+		for( const QString & f : m_fileDev->outputFiles() )
+		{
+			QFile( f ).remove();
+		}
+	}
+}
+
+
+
+
+// The live device keeps rendering, as fast as its audio server and the
+// clients in it allow, and writes the output to m_fileDev itself
+void ProjectRenderer::runFreewheel()
+{
+	Engine::getSong()->startExport();
+	m_progress = 0;
+	const int startTime = Engine::getSong()->getMilliseconds();
+
+	if( !m_freewheelDevice->startFreewheel( m_fileDev ) )
+	{
+		qWarning( "The audio server can't freewheel, export aborted" );
+		m_abort = true;
+	}
+
+	while( !Engine::getSong()->isExportDone() && !m_abort )
+	{
+		m_exportedFraction = Engine::getSong()->exportedFraction();
+		m_renderedFrames = ( Engine::getSong()->getMilliseconds() -
+				startTime ) / 1000.0 *
+				Engine::mixer()->processingSampleRate();
+		const int nprog = m_exportedFraction * 100;
+		if( m_progress != nprog )
+		{
+			m_progress = nprog;
+			emit progressChanged( m_progress );
+		}
+		msleep( 20 );
+	}
+
+	m_freewheelDevice->stopFreewheel();
+
+	m_finalStatistics = currentStatistics();
+	m_finalStatistics.remainingTime = 0;
+	m_finished = true;
+
+	Engine::getSong()->stopExport();
+
 	if( m_abort )
 	{
-		QFile( f ).remove();
+		QFile( m_fileDev->outputFile() ).remove();
+	}
+}
+
+
+
+
+ProjectRenderer::Statistics ProjectRenderer::statistics() const
+{
+	return m_finished ? m_finalStatistics : currentStatistics();
+}
+
+
+
+
+ProjectRenderer::Statistics ProjectRenderer::currentStatistics() const
+{
+	Statistics stats;
+	if( !isReady() || m_startTime == std::chrono::steady_clock::time_point() )
+	{
+		return stats;
+	}
+
+	stats.renderedTime = static_cast<double>( m_renderedFrames ) /
+				Engine::mixer()->processingSampleRate();
+	stats.elapsedTime = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - m_startTime ).count();
+	const double fraction = m_exportedFraction;
+	if( fraction > 0 )
+	{
+		stats.remainingTime = stats.elapsedTime * ( 1 - fraction ) / fraction;
+	}
+	stats.encodingTime = m_fileDev->encodingTime() * 1e-9;
+
+	MixerProfiler & profiler = Engine::mixer()->profiler();
+	for( int i = 0; i < MixerProfiler::StageCount; ++i )
+	{
+		stats.stageTime[i] = ( profiler.stageTime(
+			static_cast<MixerProfiler::Stages>( i ) ).total() -
+						m_stageTimeAtStart[i] ) * 1e-9;
 	}
+	stats.peakMemoryKiB = MixerProfiler::peakMemoryKiB();
+	return stats;
 }
 
 
@@ -229,9 +485,9 @@ void ProjectRenderer::abortProcessing()
 
 void ProjectRenderer::updateConsoleProgress()
 {
-	const int cols = 50;
+	const int cols = 30;
 	static int rot = 0;
-	char buf[80];
+	char buf[120];
 	char prog[cols+1];
 
 	for( int i = 0; i < cols; ++i )
@@ -242,8 +498,8 @@ void ProjectRenderer::updateConsoleProgress()
 
 	const char * activity = (const char *) "|/-\\";
 	memset( buf, 0, sizeof( buf ) );
-	sprintf( buf, "\r|%s|    %3d%%   %c  ", prog, m_progress,
-							activity[rot] );
+	snprintf( buf, sizeof( buf ), "\r|%s| %3d%% %c  %s  ", prog, m_progress,
+			activity[rot], qPrintable( statistics().summary() ) );
 	rot = ( rot+1 ) % 4;
 
 	fprintf( stderr, "%s", buf );
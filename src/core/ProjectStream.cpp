@@ -0,0 +1,524 @@
+/*
+ * ProjectStream.cpp - reads projects track by track
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "ProjectStream.h"
+
+#include <QDebug>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+#include "DataFile.h"
+#include "PathUtil.h"
+#include "ProjectVersion.h"
+
+#include "lmmsversion.h"
+
+
+namespace
+{
+
+QDomElement createElement( QDomDocument & document, const QXmlStreamReader & reader )
+{
+	QDomElement element = document.createElement( reader.name().toString() );
+	for( const QXmlStreamAttribute & attribute : reader.attributes() )
+	{
+		element.setAttribute( attribute.qualifiedName().toString(),
+						attribute.value().toString() );
+	}
+	return element;
+}
+
+
+
+
+//! Appends the text or comment the reader is at; whitespace between
+//! elements is dropped, like QDomDocument::setContent() does
+void appendText( QDomDocument & document, const QXmlStreamReader & reader,
+							QDomNode & parent )
+{
+	if( reader.isComment() )
+	{
+		parent.appendChild( document.createComment( reader.text().toString() ) );
+	}
+	else if( reader.isCDATA() )
+	{
+		parent.appendChild( document.createCDATASection( reader.text().toString() ) );
+	}
+	else if( !reader.isWhitespace() )
+	{
+		parent.appendChild( document.createTextNode( reader.text().toString() ) );
+	}
+}
+
+
+
+
+//! Reads the contents of the element the reader is at into @p element
+void readContent( QDomDocument & document, QXmlStreamReader & reader,
+							QDomElement element )
+{
+	QDomNode current = element;
+	for( int depth = 1; depth > 0 && !reader.atEnd(); )
+	{
+		switch( reader.readNext() )
+		{
+			case QXmlStreamReader::StartElement:
+				current = current.appendChild( createElement( document, reader ) );
+				++depth;
+				break;
+			case QXmlStreamReader::EndElement:
+				current = current.parentNode();
+				--depth;
+				break;
+			case QXmlStreamReader::Characters:
+			case QXmlStreamReader::Comment:
+				appendText( document, reader, current );
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+
+
+
+//! Reads a file to have it in the cache of the system
+class ReadAheadTask : public QRunnable
+{
+public:
+	ReadAheadTask( const QString & fileName ) :
+		m_fileName( fileName )
+	{
+	}
+
+	void run() override
+	{
+		QFile file( m_fileName );
+		if( !file.open( QIODevice::ReadOnly ) )
+		{
+			return;
+		}
+		QByteArray buffer( 1 << 20, Qt::Uninitialized );
+		while( file.read( buffer.data(), buffer.size() ) > 0 )
+		{
+		}
+	}
+
+private:
+	QString m_fileName;
+} ;
+
+} // namespace
+
+
+
+
+const std::map<QString, QStringList> ProjectStream::PLUGIN_FILES = {
+	{ "sf2player", { "src" } },
+	{ "gigplayer", { "src" } },
+	{ "patman", { "src" } },
+	{ "vestige", { "plugin" } },
+};
+
+
+
+
+ProjectStream::ProjectStream( const QString & fileName ) :
+	m_streamed( false ),
+	m_file( fileName ),
+	m_hasLocalPlugins( false ),
+	m_trackCount( 0 ),
+	m_inTracks( false ),
+	m_tracksDone( false )
+{
+	if( !DataFile::isBinaryProject( fileName ) &&
+				m_file.open( QIODevice::ReadOnly ) )
+	{
+		if( BlockCompression::isCompressed( m_file.peek( 16 ) ) )
+		{
+			m_uncompressed.reset( new BlockCompression::Reader( &m_file ) );
+		}
+		QDomDocument document;
+		if( rewind() && readDataFile( document ) && rewind() )
+		{
+			m_dataFile.reset( new DataFile( document, fileName ) );
+
+			// the tracks are read into copies of their parents
+			const QDomElement content = m_dataFile->content();
+			const QDomElement container = content.firstChildElement( "trackcontainer" );
+			if( !container.isNull() )
+			{
+				QDomNode parent = m_trackDocument;
+				for( const QDomElement & element :
+					{ m_dataFile->documentElement(), content, container } )
+				{
+					parent = parent.appendChild(
+						m_trackDocument.importNode( element, false ) );
+				}
+				m_trackParent = parent.toElement();
+			}
+
+			m_streamed = true;
+			return;
+		}
+		m_file.close();
+	}
+
+	// needs the whole document, shows the errors too
+	m_dataFile.reset( new DataFile( fileName ) );
+}
+
+
+
+
+ProjectStream::~ProjectStream()
+{
+}
+
+
+
+
+bool ProjectStream::hasLocalPlugins() const
+{
+	return m_streamed ? m_hasLocalPlugins : m_dataFile->hasLocalPlugins();
+}
+
+
+
+
+QStringList ProjectStream::resourceFiles( const QString & tagName ) const
+{
+	if( !m_streamed )
+	{
+		return m_dataFile->resourceFiles( tagName );
+	}
+	const auto it = m_resourceFiles.find( tagName );
+	return it != m_resourceFiles.end() ? it->second : QStringList();
+}
+
+
+
+
+int ProjectStream::trackCount() const
+{
+	if( m_streamed )
+	{
+		return m_trackCount;
+	}
+
+	int count = 0;
+	const QDomNodeList containers = m_dataFile->elementsByTagName( "trackcontainer" );
+	for( int i = 0; i < containers.count(); ++i )
+	{
+		for( QDomElement track = containers.item( i ).firstChildElement( "track" );
+			!track.isNull(); track = track.nextSiblingElement( "track" ) )
+		{
+			++count;
+		}
+	}
+	return count;
+}
+
+
+
+
+void ProjectStream::readAheadPluginFiles() const
+{
+	QStringList files = m_pluginFiles;
+	if( !m_streamed )
+	{
+		for( const auto & plugin : PLUGIN_FILES )
+		{
+			const QDomNodeList list = m_dataFile->elementsByTagName( plugin.first );
+			for( int i = 0; i < list.count(); ++i )
+			{
+				for( const QString & attribute : plugin.second )
+				{
+					files << list.item( i ).toElement().attribute( attribute );
+				}
+			}
+		}
+	}
+
+	QSet<QString> started;
+	for( const QString & file : files )
+	{
+		const QString fileName = PathUtil::toAbsolute( file );
+		if( !file.isEmpty() && !started.contains( fileName ) )
+		{
+			started.insert( fileName );
+			QThreadPool::globalInstance()->start( new ReadAheadTask( fileName ) );
+		}
+	}
+}
+
+
+
+
+QDomElement ProjectStream::nextTrack()
+{
+	if( !m_track.isNull() )
+	{
+		m_trackParent.removeChild( m_track );
+		m_track = QDomElement();
+	}
+	if( !m_streamed || m_trackParent.isNull() )
+	{
+		return QDomElement();
+	}
+
+	while( !m_tracksDone && !m_reader.atEnd() )
+	{
+		switch( m_reader.readNext() )
+		{
+			case QXmlStreamReader::StartElement:
+				if( !m_inTracks )
+				{
+					m_inTracks = m_path.size() == 2 &&
+						m_path[1] == m_contentName &&
+						m_reader.name() == QLatin1String( "trackcontainer" );
+					m_path << m_reader.name().toString();
+				}
+				else if( m_reader.name() == QLatin1String( "track" ) )
+				{
+					m_track = createElement( m_trackDocument, m_reader );
+					m_trackParent.appendChild( m_track );
+					readContent( m_trackDocument, m_reader, m_track );
+					if( m_reader.hasError() )
+					{
+						break;
+					}
+					return m_track;
+				}
+				else
+				{
+					// metadata of the container, already loaded
+					m_reader.skipCurrentElement();
+				}
+				break;
+			case QXmlStreamReader::EndElement:
+				m_path.removeLast();
+				m_tracksDone = m_inTracks;
+				break;
+			default:
+				break;
+		}
+	}
+
+	if( m_reader.hasError() )
+	{
+		qWarning() << "Could not read the tracks of" << m_file.fileName()
+					<< ":" << m_reader.errorString();
+		m_tracksDone = true;
+		if( !m_track.isNull() )
+		{
+			m_trackParent.removeChild( m_track );
+			m_track = QDomElement();
+		}
+	}
+	return QDomElement();
+}
+
+
+
+
+bool ProjectStream::rewind()
+{
+	if( !m_file.seek( 0 ) )
+	{
+		return false;
+	}
+	if( m_uncompressed )
+	{
+		m_uncompressed->close();
+		if( !m_uncompressed->open( QIODevice::ReadOnly ) )
+		{
+			return false;
+		}
+		m_reader.setDevice( m_uncompressed.get() );
+	}
+	else
+	{
+		m_reader.setDevice( &m_file );
+	}
+	return true;
+}
+
+
+
+
+bool ProjectStream::readDataFile( QDomDocument & document )
+{
+	if( !m_reader.readNextStartElement() ||
+			m_reader.name() != QLatin1String( "lmms-project" ) )
+	{
+		return false;
+	}
+
+	// anything DataFile::loadDocument() would upgrade needs the DOM
+	const QXmlStreamAttributes root = m_reader.attributes();
+	bool success = false;
+	const unsigned int version = root.value( "version" ).toString().toUInt( &success );
+	if( !success || version < DataFile::UPGRADE_METHODS.size() ||
+		!root.hasAttribute( "creatorversion" ) ||
+		ProjectVersion( root.value( "creatorversion" ).toString() ) <
+						ProjectVersion( LMMS_VERSION ) )
+	{
+		return false;
+	}
+
+	const DataFile::Type type = DataFile::type( root.value( "type" ).toString() );
+	if( type != DataFile::SongProject && type != DataFile::SongProjectTemplate )
+	{
+		return false;
+	}
+	m_contentName = DataFile::typeName( type );
+
+	QDomNode current = document;
+	QStringList path;
+	bool inTracks = false;
+	bool seenTracks = false;
+	// the depth inside a track of the song, which is left out
+	int skipped = 0;
+
+	// starts at the root element read above
+	for( ; !m_reader.atEnd(); m_reader.readNext() )
+	{
+		switch( m_reader.tokenType() )
+		{
+			case QXmlStreamReader::StartElement:
+			{
+				const QString name = m_reader.name().toString();
+				scanElement( path.isEmpty() );
+				if( name == "track" && !path.isEmpty() &&
+						path.last() == "trackcontainer" )
+				{
+					++m_trackCount;
+				}
+				// the chunks it holds are only resolved by DataFile
+				if( path.size() == 1 && name == "binarydata" )
+				{
+					return false;
+				}
+
+				if( skipped > 0 )
+				{
+					++skipped;
+				}
+				else if( inTracks && path.size() == 3 && name == "track" )
+				{
+					skipped = 1;
+				}
+				else
+				{
+					if( !seenTracks && path.size() == 2 &&
+						path[1] == m_contentName &&
+						name == "trackcontainer" )
+					{
+						inTracks = seenTracks = true;
+					}
+					current = current.appendChild(
+						createElement( document, m_reader ) );
+				}
+				path << name;
+				break;
+			}
+			case QXmlStreamReader::EndElement:
+				path.removeLast();
+				if( skipped > 0 )
+				{
+					--skipped;
+				}
+				else
+				{
+					current = current.parentNode();
+					if( path.size() == 2 )
+					{
+						inTracks = false;
+					}
+				}
+				break;
+			case QXmlStreamReader::Characters:
+			case QXmlStreamReader::Comment:
+				if( skipped == 0 )
+				{
+					appendText( document, m_reader, current );
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	return !m_reader.hasError();
+}
+
+
+
+
+void ProjectStream::scanElement( bool isRoot )
+{
+	const QString name = m_reader.name().toString();
+	const QXmlStreamAttributes attributes = m_reader.attributes();
+
+	const auto plugin = PLUGIN_FILES.find( name );
+	if( plugin != PLUGIN_FILES.end() )
+	{
+		for( const QString & attribute : plugin->second )
+		{
+			m_pluginFiles << attributes.value( attribute ).toString();
+		}
+	}
+
+	// the same checks as DataFile::hasLocalPlugins() and resourceFiles()
+	const auto it = DataFile::ELEMENTS_WITH_RESOURCES.find( name );
+	if( it != DataFile::ELEMENTS_WITH_RESOURCES.end() )
+	{
+		for( const QString & attribute : it->second )
+		{
+			const QString file = attributes.value( attribute ).toString();
+			if( !file.isEmpty() )
+			{
+				m_resourceFiles[name] << file;
+			}
+		}
+		return;
+	}
+
+	if( isRoot )
+	{
+		return;
+	}
+	const QString localPrefix = PathUtil::basePrefix( PathUtil::Base::LocalDir );
+	for( const QXmlStreamAttribute & attribute : attributes )
+	{
+		if( attribute.value().startsWith( localPrefix, Qt::CaseInsensitive ) )
+		{
+			m_hasLocalPlugins = true;
+		}
+	}
+}
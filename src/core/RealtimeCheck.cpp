@@ -0,0 +1,529 @@
+/*
+ * RealtimeCheck.cpp - reports calls which aren't realtime safe while rendering
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// the checked functions are defined here, not their fortified wrappers
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeCheck.h"
+
+#ifdef LMMS_DEBUG_RTCHECK
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "AudioPort.h"
+#include "Effect.h"
+#include "PlayHandle.h"
+
+
+namespace
+{
+
+const int MaxFrames = 32;
+//! stack traces reported so far, by their hash
+const int MaxReports = 4096;
+
+thread_local int t_scopes = 0;
+thread_local int t_allowed = 0;
+thread_local const PlayHandle * t_playHandle = nullptr;
+thread_local const Effect * t_effect = nullptr;
+
+std::atomic<uint64_t> s_reported[MaxReports];
+bool s_abort = false;
+
+
+//! Whether the stack trace with @p hash wasn't reported before
+bool firstReport( uint64_t hash )
+{
+	hash |= 1; // 0 marks empty slots
+	for( int i = 0; i < MaxReports; ++i )
+	{
+		std::atomic<uint64_t> & slot = s_reported[( hash + i ) % MaxReports];
+		uint64_t reported = slot.load( std::memory_order_relaxed );
+		if( reported == 0 && slot.compare_exchange_strong( reported, hash ) )
+		{
+			return true;
+		}
+		if( reported == hash )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+const char * playHandleType( const PlayHandle * playHandle )
+{
+	switch( playHandle->type() )
+	{
+		case PlayHandle::TypeNotePlayHandle: return "note";
+		case PlayHandle::TypeInstrumentPlayHandle: return "instrument";
+		case PlayHandle::TypeSamplePlayHandle: return "sample";
+		case PlayHandle::TypePresetPreviewHandle: return "preset preview";
+	}
+	return "play handle";
+}
+
+
+void report( const char * call )
+{
+	void * frames[MaxFrames];
+	const int count = backtrace( frames, MaxFrames );
+
+	uint64_t hash = 14695981039346656037ULL;
+	for( int i = 0; i < count; ++i )
+	{
+		hash = ( hash ^ reinterpret_cast<uintptr_t>( frames[i] ) ) * 1099511628211ULL;
+	}
+	if( !firstReport( hash ) )
+	{
+		return;
+	}
+
+	fprintf( stderr, "RealtimeCheck: %s on a realtime thread", call );
+	if( t_effect )
+	{
+		fprintf( stderr, " in effect \"%s\"",
+				t_effect->displayName().toUtf8().constData() );
+	}
+	if( t_playHandle )
+	{
+		fprintf( stderr, " playing %s", playHandleType( t_playHandle ) );
+		if( t_playHandle->audioPort() )
+		{
+			fprintf( stderr, " of \"%s\"",
+				t_playHandle->audioPort()->name().toUtf8().constData() );
+		}
+	}
+	fprintf( stderr, "\n" );
+	backtrace_symbols_fd( frames, count, STDERR_FILENO );
+
+	if( s_abort )
+	{
+		abort();
+	}
+}
+
+
+template<typename F>
+F next( const char * name, const char * version = nullptr )
+{
+	void * f = version ? dlvsym( RTLD_NEXT, name, version ) : nullptr;
+	return reinterpret_cast<F>( f ? f : dlsym( RTLD_NEXT, name ) );
+}
+
+
+typedef int (*MutexLock)( pthread_mutex_t * );
+typedef int (*CondWait)( pthread_cond_t *, pthread_mutex_t * );
+typedef int (*CondTimedWait)( pthread_cond_t *, pthread_mutex_t *, const timespec * );
+typedef int (*SemWait)( sem_t * );
+typedef int (*SemTimedWait)( sem_t *, const timespec * );
+typedef int (*NanoSleep)( const timespec *, timespec * );
+typedef int (*ClockNanoSleep)( clockid_t, int, const timespec *, timespec * );
+typedef int (*USleep)( useconds_t );
+typedef unsigned int (*Sleep)( unsigned int );
+typedef int (*Open)( const char *, int, ... );
+typedef ssize_t (*Read)( int, void *, size_t );
+typedef ssize_t (*Write)( int, const void *, size_t );
+typedef int (*Poll)( pollfd *, nfds_t, int );
+typedef int (*Select)( int, fd_set *, fd_set *, fd_set *, timeval * );
+typedef long (*Syscall)( long, ... );
+
+//! The functions interposed, looked up by lookUpNext()
+struct Next
+{
+	CondWait condWait;
+	CondTimedWait condTimedWait;
+	MutexLock mutexLock;
+	SemWait semWait;
+	SemTimedWait semTimedWait;
+	NanoSleep nanoSleep;
+	ClockNanoSleep clockNanoSleep;
+	USleep uSleep;
+	Sleep sleep;
+	Open open;
+	Read read;
+	Write write;
+	Poll poll;
+	Select select;
+	Syscall syscall;
+} ;
+
+Next s_next;
+std::atomic_bool s_nextFound( false );
+
+
+void findNext()
+{
+	// the condition variables of glibc exist in two versions
+	s_next.condWait = next<CondWait>( "pthread_cond_wait", "GLIBC_2.3.2" );
+	s_next.condTimedWait = next<CondTimedWait>( "pthread_cond_timedwait", "GLIBC_2.3.2" );
+	s_next.mutexLock = next<MutexLock>( "pthread_mutex_lock" );
+	s_next.semWait = next<SemWait>( "sem_wait" );
+	s_next.semTimedWait = next<SemTimedWait>( "sem_timedwait" );
+	s_next.nanoSleep = next<NanoSleep>( "nanosleep" );
+	s_next.clockNanoSleep = next<ClockNanoSleep>( "clock_nanosleep" );
+	s_next.uSleep = next<USleep>( "usleep" );
+	s_next.sleep = next<Sleep>( "sleep" );
+	s_next.open = next<Open>( "open" );
+	s_next.read = next<Read>( "read" );
+	s_next.write = next<Write>( "write" );
+	s_next.poll = next<Poll>( "poll" );
+	s_next.select = next<Select>( "select" );
+	s_next.syscall = next<Syscall>( "syscall" );
+	s_nextFound.store( true, std::memory_order_release );
+}
+
+
+//! Functions may be called before lookUpNext(), by the constructors of
+//! other libraries
+inline const Next & real()
+{
+	if( !s_nextFound.load( std::memory_order_acquire ) )
+	{
+		findNext();
+	}
+	return s_next;
+}
+
+
+//! Looks up the functions and loads what stack traces need while the
+//! process is single-threaded, as both allocate
+__attribute__(( constructor )) void lookUpNext()
+{
+	real();
+
+	void * frame;
+	backtrace( &frame, 1 );
+
+	const char * mode = getenv( "LMMS_RTCHECK" );
+	s_abort = mode && strcmp( mode, "abort" ) == 0;
+}
+
+} // namespace
+
+
+
+
+RealtimeCheck::Scope::Scope()
+{
+	++t_scopes;
+}
+
+
+
+
+RealtimeCheck::Scope::~Scope()
+{
+	--t_scopes;
+}
+
+
+
+
+RealtimeCheck::Allow::Allow()
+{
+	++t_allowed;
+}
+
+
+
+
+RealtimeCheck::Allow::~Allow()
+{
+	--t_allowed;
+}
+
+
+
+
+RealtimeCheck::Context::Context( const PlayHandle * playHandle ) :
+	m_playHandle( t_playHandle ),
+	m_effect( t_effect )
+{
+	t_playHandle = playHandle;
+}
+
+
+
+
+RealtimeCheck::Context::Context( const Effect * effect ) :
+	m_playHandle( t_playHandle ),
+	m_effect( t_effect )
+{
+	t_effect = effect;
+}
+
+
+
+
+RealtimeCheck::Context::~Context()
+{
+	t_playHandle = m_playHandle;
+	t_effect = m_effect;
+}
+
+
+
+
+void RealtimeCheck::check( const char * call )
+{
+	if( t_scopes > 0 && t_allowed == 0 )
+	{
+		Allow allow;
+		report( call );
+	}
+}
+
+
+
+
+// The interposed functions, which take precedence over those of the C
+// library as they are defined in the executable.
+extern "C"
+{
+
+void * __libc_malloc( size_t size );
+void * __libc_calloc( size_t count, size_t size );
+void * __libc_realloc( void * ptr, size_t size );
+void __libc_free( void * ptr );
+void * __libc_memalign( size_t alignment, size_t size );
+
+
+void * malloc( size_t size ) noexcept
+{
+	RealtimeCheck::check( "malloc()" );
+	return __libc_malloc( size );
+}
+
+
+void * calloc( size_t count, size_t size ) noexcept
+{
+	RealtimeCheck::check( "calloc()" );
+	return __libc_calloc( count, size );
+}
+
+
+void * realloc( void * ptr, size_t size ) noexcept
+{
+	RealtimeCheck::check( "realloc()" );
+	return __libc_realloc( ptr, size );
+}
+
+
+void free( void * ptr ) noexcept
+{
+	if( ptr )
+	{
+		RealtimeCheck::check( "free()" );
+	}
+	__libc_free( ptr );
+}
+
+
+int posix_memalign( void ** ptr, size_t alignment, size_t size ) noexcept
+{
+	RealtimeCheck::check( "posix_memalign()" );
+	if( alignment % sizeof( void * ) || ( alignment & ( alignment - 1 ) ) )
+	{
+		return EINVAL;
+	}
+	void * memory = __libc_memalign( alignment, size );
+	if( memory == nullptr && size > 0 )
+	{
+		return ENOMEM;
+	}
+	*ptr = memory;
+	return 0;
+}
+
+
+void * aligned_alloc( size_t alignment, size_t size ) noexcept
+{
+	RealtimeCheck::check( "aligned_alloc()" );
+	return __libc_memalign( alignment, size );
+}
+
+
+void * memalign( size_t alignment, size_t size ) noexcept
+{
+	RealtimeCheck::check( "memalign()" );
+	return __libc_memalign( alignment, size );
+}
+
+
+int pthread_mutex_lock( pthread_mutex_t * mutex ) noexcept
+{
+	RealtimeCheck::check( "pthread_mutex_lock()" );
+	return real().mutexLock( mutex );
+}
+
+
+int pthread_cond_wait( pthread_cond_t * cond, pthread_mutex_t * mutex )
+{
+	RealtimeCheck::check( "pthread_cond_wait()" );
+	return real().condWait( cond, mutex );
+}
+
+
+int pthread_cond_timedwait( pthread_cond_t * cond, pthread_mutex_t * mutex,
+				const timespec * time )
+{
+	RealtimeCheck::check( "pthread_cond_timedwait()" );
+	return real().condTimedWait( cond, mutex, time );
+}
+
+
+int sem_wait( sem_t * sem )
+{
+	RealtimeCheck::check( "sem_wait()" );
+	return real().semWait( sem );
+}
+
+
+int sem_timedwait( sem_t * sem, const timespec * time )
+{
+	RealtimeCheck::check( "sem_timedwait()" );
+	return real().semTimedWait( sem, time );
+}
+
+
+int nanosleep( const timespec * time, timespec * remaining )
+{
+	RealtimeCheck::check( "nanosleep()" );
+	return real().nanoSleep( time, remaining );
+}
+
+
+int clock_nanosleep( clockid_t clock, int flags, const timespec * time,
+			timespec * remaining )
+{
+	RealtimeCheck::check( "clock_nanosleep()" );
+	return real().clockNanoSleep( clock, flags, time, remaining );
+}
+
+
+int usleep( useconds_t microseconds )
+{
+	RealtimeCheck::check( "usleep()" );
+	return real().uSleep( microseconds );
+}
+
+
+unsigned int sleep( unsigned int seconds )
+{
+	RealtimeCheck::check( "sleep()" );
+	return real().sleep( seconds );
+}
+
+
+int open( const char * path, int flags, ... )
+{
+	RealtimeCheck::check( "open()" );
+	mode_t mode = 0;
+	if( flags & ( O_CREAT | O_TMPFILE ) )
+	{
+		va_list args;
+		va_start( args, flags );
+		mode = va_arg( args, mode_t );
+		va_end( args );
+	}
+	return real().open( path, flags, mode );
+}
+
+
+ssize_t read( int fd, void * buffer, size_t count )
+{
+	RealtimeCheck::check( "read()" );
+	return real().read( fd, buffer, count );
+}
+
+
+ssize_t write( int fd, const void * buffer, size_t count )
+{
+	RealtimeCheck::check( "write()" );
+	return real().write( fd, buffer, count );
+}
+
+
+int poll( pollfd * fds, nfds_t count, int timeout )
+{
+	RealtimeCheck::check( "poll()" );
+	return real().poll( fds, count, timeout );
+}
+
+
+int select( int count, fd_set * readFds, fd_set * writeFds, fd_set * exceptFds,
+		timeval * timeout )
+{
+	RealtimeCheck::check( "select()" );
+	return real().select( count, readFds, writeFds, exceptFds, timeout );
+}
+
+
+long syscall( long number, ... ) noexcept
+{
+	// the arguments are passed in registers, six of them at most
+	va_list args;
+	va_start( args, number );
+	long a[6];
+	for( long & arg : a )
+	{
+		arg = va_arg( args, long );
+	}
+	va_end( args );
+
+	if( number == SYS_futex )
+	{
+		// a QMutex blocks here when it's locked already
+		const int op = a[1] & FUTEX_CMD_MASK;
+		if( op == FUTEX_WAIT || op == FUTEX_WAIT_BITSET || op == FUTEX_LOCK_PI )
+		{
+			RealtimeCheck::check( "futex wait" );
+		}
+	}
+	return real().syscall( number, a[0], a[1], a[2], a[3], a[4], a[5] );
+}
+
+} // extern "C"
+
+
+#endif // LMMS_DEBUG_RTCHECK
@@ -0,0 +1,527 @@
+/*
+ * RealtimeMemory.cpp - locked, prefaulted memory for the buffers of the engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RealtimeMemory.h"
+
+#include <QtCore/QMutex>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "lmmsconfig.h"
+
+#if defined(LMMS_BUILD_WIN32)
+#include <windows.h>
+#define REALTIME_MEMORY_SUPPORTED
+#elif !defined(LMMS_BUILD_HAIKU)
+#include <sys/mman.h>
+#include <sys/resource.h>
+#define REALTIME_MEMORY_SUPPORTED
+#endif
+
+#include "ConfigManager.h"
+#include "MemoryManager.h"
+#include "Mixer.h"
+#include "MixerWorkerThread.h"
+
+
+namespace
+{
+
+// blocks of 64 bytes up to a whole segment
+const int MinClassBits = 6;
+const int NumClasses = 17;
+static_assert((std::size_t(1) << (MinClassBits + NumClasses - 1)) == RealtimeMemory::SegmentBytes,
+	"the largest class must be a segment");
+
+const std::size_t PageBytes = 4096;
+const std::size_t HugePageBytes = 2 << 20;
+// mapped by init(), the mixer's own buffers and those of a small project
+const std::size_t InitialBytes = 4 * RealtimeMemory::SegmentBytes;
+const int MaxSpareSegments = 16;
+
+struct FreeBlock
+{
+	FreeBlock * next;
+} ;
+
+// put in front of blocks larger than a segment
+struct LargeHeader
+{
+	std::size_t bytes;
+	bool locked;
+	bool huge;
+} ;
+
+bool s_enabled = false;
+
+std::atomic_flag s_lock = ATOMIC_FLAG_INIT;
+FreeBlock * s_free[NumClasses] = {};
+char * s_current = nullptr;
+char * s_end = nullptr;
+char * s_spare[MaxSpareSegments] = {};
+int s_spareCount = 0;
+
+// serializes mapping segments outside of the audio threads
+QMutex s_mapMutex;
+std::atomic<bool> s_growRequested(false);
+
+std::atomic<qint64> s_poolBytes(0);
+std::atomic<qint64> s_lockedBytes(0);
+std::atomic<qint64> s_hugePageBytes(0);
+std::atomic<qint64> s_inUse(0);
+std::atomic<int> s_overflows(0);
+qint64 s_lockLimit = -1;
+
+
+class SpinLock
+{
+public:
+	SpinLock()
+	{
+		while (s_lock.test_and_set(std::memory_order_acquire))
+		{
+		}
+	}
+
+	~SpinLock()
+	{
+		s_lock.clear(std::memory_order_release);
+	}
+} ;
+
+
+int classOf(std::size_t bytes)
+{
+	int c = 0;
+	while ((std::size_t(1) << (MinClassBits + c)) < bytes)
+	{
+		++c;
+	}
+	return c;
+}
+
+
+std::size_t classBytes(int c)
+{
+	return std::size_t(1) << (MinClassBits + c);
+}
+
+
+//! Maps @p bytes, a multiple of the page size, writes to every page and
+//! locks them if the limit allows it. Returns nullptr if that fails.
+char * mapMemory(std::size_t bytes, bool & locked, bool & huge)
+{
+	char * memory = nullptr;
+	locked = false;
+	huge = false;
+#if defined(LMMS_BUILD_WIN32)
+	memory = static_cast<char *>(VirtualAlloc(nullptr, bytes,
+		MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#elif defined(REALTIME_MEMORY_SUPPORTED)
+#ifdef MAP_HUGETLB
+	if (bytes % HugePageBytes == 0)
+	{
+		void * mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mapped != MAP_FAILED)
+		{
+			memory = static_cast<char *>(mapped);
+			huge = true;
+		}
+	}
+#endif
+	if (memory == nullptr)
+	{
+		void * mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapped == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		memory = static_cast<char *>(mapped);
+#ifdef MADV_HUGEPAGE
+		// transparent huge pages, if the system has them enabled
+		madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+	}
+#endif
+	if (memory == nullptr)
+	{
+		return nullptr;
+	}
+
+	// the first write to a page is what faults it in
+	std::memset(memory, 0, bytes);
+
+	if (s_lockLimit < 0 || s_lockedBytes.load() + static_cast<qint64>(bytes) <= s_lockLimit)
+	{
+#if defined(LMMS_BUILD_WIN32)
+		locked = VirtualLock(memory, bytes) != 0;
+#elif defined(REALTIME_MEMORY_SUPPORTED)
+		locked = mlock(memory, bytes) == 0;
+#endif
+	}
+
+	s_poolBytes += bytes;
+	s_lockedBytes += locked ? bytes : 0;
+	s_hugePageBytes += huge ? bytes : 0;
+	return memory;
+}
+
+
+void unmapMemory(char * memory, std::size_t bytes, bool locked, bool huge)
+{
+	s_poolBytes -= bytes;
+	s_lockedBytes -= locked ? bytes : 0;
+	s_hugePageBytes -= huge ? bytes : 0;
+#if defined(LMMS_BUILD_WIN32)
+	VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(REALTIME_MEMORY_SUPPORTED)
+	munmap(memory, bytes);
+#endif
+}
+
+
+char * mapSegment()
+{
+	bool locked;
+	bool huge;
+	return mapMemory(RealtimeMemory::SegmentBytes, locked, huge);
+}
+
+
+//! Puts the rest of the current segment onto the free lists, largest
+//! blocks first so they stay aligned. Expects the lock to be held.
+void retireCurrent()
+{
+	for (int c = NumClasses - 1; c >= 0 && s_current < s_end; --c)
+	{
+		while (static_cast<std::size_t>(s_end - s_current) >= classBytes(c) &&
+			reinterpret_cast<std::uintptr_t>(s_current) % std::min(classBytes(c), PageBytes) == 0)
+		{
+			FreeBlock * block = reinterpret_cast<FreeBlock *>(s_current);
+			block->next = s_free[c];
+			s_free[c] = block;
+			s_current += classBytes(c);
+		}
+	}
+	s_current = s_end = nullptr;
+}
+
+
+//! A block of class @p c from the free list or the current segment, or
+//! nullptr if both are exhausted. Expects the lock to be held.
+char * takeBlock(int c)
+{
+	if (s_free[c] != nullptr)
+	{
+		FreeBlock * block = s_free[c];
+		s_free[c] = block->next;
+		return reinterpret_cast<char *>(block);
+	}
+
+	if (s_current == nullptr)
+	{
+		return nullptr;
+	}
+	// aligned to the block size, up to a page
+	const std::size_t align = std::min(classBytes(c), PageBytes);
+	const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(s_current);
+	char * block = s_current + (align - address % align) % align;
+	if (block + classBytes(c) > s_end)
+	{
+		return nullptr;
+	}
+	// the gap in front is at most a page and is skipped
+	s_current = block + classBytes(c);
+	return block;
+}
+
+
+//! Starts the next spare segment, returns false if there is none.
+//! Expects the lock to be held.
+bool startSpare()
+{
+	if (s_spareCount == 0)
+	{
+		return false;
+	}
+	retireCurrent();
+	s_current = s_spare[--s_spareCount];
+	s_end = s_current + RealtimeMemory::SegmentBytes;
+	return true;
+}
+
+
+bool isAudioThread()
+{
+	return Mixer::isRenderingThread() || MixerWorkerThread::isWorkerThread();
+}
+
+} // namespace
+
+
+
+
+void RealtimeMemory::init()
+{
+	// the pool is shared by the mixers of all engine contexts
+	static bool initialized = false;
+	if (initialized)
+	{
+		return;
+	}
+	initialized = true;
+
+#ifdef REALTIME_MEMORY_SUPPORTED
+	s_enabled = ConfigManager::inst()->value("mixer", "lockmemory").toInt();
+#endif
+	if (!s_enabled)
+	{
+		return;
+	}
+
+#if defined(REALTIME_MEMORY_SUPPORTED) && !defined(LMMS_BUILD_WIN32)
+	// an unprivileged process may raise its soft limit up to the hard one
+	rlimit limit;
+	if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0)
+	{
+		if (limit.rlim_cur != limit.rlim_max)
+		{
+			limit.rlim_cur = limit.rlim_max;
+			setrlimit(RLIMIT_MEMLOCK, &limit);
+			getrlimit(RLIMIT_MEMLOCK, &limit);
+		}
+		s_lockLimit = limit.rlim_cur == RLIM_INFINITY ? -1 : static_cast<qint64>(limit.rlim_cur);
+	}
+#elif defined(LMMS_BUILD_WIN32)
+	// VirtualLock() is limited by the minimum working set
+	SIZE_T minimum;
+	SIZE_T maximum;
+	if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimum, &maximum))
+	{
+		const SIZE_T extra = 64 * SegmentBytes;
+		SetProcessWorkingSetSize(GetCurrentProcess(), minimum + extra, maximum + extra);
+		s_lockLimit = static_cast<qint64>(extra);
+	}
+#endif
+
+	reserve(InitialBytes);
+
+	if (s_lockedBytes.load() < s_poolBytes.load())
+	{
+		fprintf(stderr, "RealtimeMemory: the limit of locked memory is too low, "
+			"the buffers of the engine are prefaulted but may be paged out. "
+			"Raise the memlock limit, e.g. in /etc/security/limits.conf.\n");
+	}
+	fprintf(stderr, "RealtimeMemory: %s\n", summary().toUtf8().constData());
+}
+
+
+
+
+void RealtimeMemory::reserve(std::size_t bytes)
+{
+	if (!s_enabled)
+	{
+		return;
+	}
+
+	// segments are only added to the pool here, the audio threads only
+	// take spare ones
+	QMutexLocker mapLock(&s_mapMutex);
+	int spareSegments;
+	std::size_t spare;
+	{
+		SpinLock lock;
+		spareSegments = s_spareCount;
+		spare = spareSegments * SegmentBytes + (s_end - s_current);
+	}
+	int segments = static_cast<int>((bytes > spare ? bytes - spare + SegmentBytes - 1 : 0) / SegmentBytes);
+	if (s_growRequested.exchange(false) || (segments == 0 && spareSegments == 0))
+	{
+		++segments;
+	}
+	segments = std::min(segments, MaxSpareSegments - spareSegments);
+
+	for (int i = 0; i < segments; ++i)
+	{
+		char * segment = mapSegment();
+		if (segment == nullptr)
+		{
+			break;
+		}
+		SpinLock lock;
+		if (s_current == nullptr)
+		{
+			s_current = segment;
+			s_end = segment + SegmentBytes;
+		}
+		else
+		{
+			s_spare[s_spareCount++] = segment;
+		}
+	}
+}
+
+
+
+
+void * RealtimeMemory::allocate(std::size_t bytes)
+{
+	if (!s_enabled)
+	{
+		return MemoryManager::alloc(bytes);
+	}
+
+	if (bytes > SegmentBytes)
+	{
+		// a mapping of its own, with the header in front
+		const std::size_t mapped = (bytes + Alignment + PageBytes - 1) / PageBytes * PageBytes;
+		bool locked;
+		bool huge;
+		char * memory = mapMemory(mapped, locked, huge);
+		if (memory == nullptr)
+		{
+			return nullptr;
+		}
+		*reinterpret_cast<LargeHeader *>(memory) = LargeHeader{mapped, locked, huge};
+		s_inUse += mapped;
+		return memory + Alignment;
+	}
+
+	const int c = classOf(std::max(bytes, Alignment));
+	char * block = nullptr;
+	{
+		SpinLock lock;
+		block = takeBlock(c);
+		if (block == nullptr && startSpare())
+		{
+			block = takeBlock(c);
+			s_growRequested = true;
+		}
+	}
+
+	if (block == nullptr)
+	{
+		// out of spare segments, which stalls an audio thread
+		if (isAudioThread())
+		{
+			++s_overflows;
+		}
+		char * segment = mapSegment();
+		if (segment == nullptr)
+		{
+			return nullptr;
+		}
+		SpinLock lock;
+		retireCurrent();
+		s_current = segment;
+		s_end = segment + SegmentBytes;
+		block = takeBlock(c);
+	}
+
+	s_inUse += classBytes(c);
+	return block;
+}
+
+
+
+
+void RealtimeMemory::release(void * ptr, std::size_t bytes)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	if (!s_enabled)
+	{
+		MemoryManager::free(ptr);
+		return;
+	}
+
+	if (bytes > SegmentBytes)
+	{
+		char * memory = static_cast<char *>(ptr) - Alignment;
+		const LargeHeader header = *reinterpret_cast<LargeHeader *>(memory);
+		s_inUse -= header.bytes;
+		unmapMemory(memory, header.bytes, header.locked, header.huge);
+		return;
+	}
+
+	const int c = classOf(std::max(bytes, Alignment));
+	s_inUse -= classBytes(c);
+	SpinLock lock;
+	FreeBlock * block = static_cast<FreeBlock *>(ptr);
+	block->next = s_free[c];
+	s_free[c] = block;
+}
+
+
+
+
+bool RealtimeMemory::enabled()
+{
+	return s_enabled;
+}
+
+
+
+
+RealtimeMemory::Usage RealtimeMemory::usage()
+{
+	Usage usage;
+	usage.enabled = s_enabled;
+	usage.poolBytes = s_poolBytes.load();
+	usage.lockedBytes = s_lockedBytes.load();
+	usage.hugePageBytes = s_hugePageBytes.load();
+	usage.inUse = s_inUse.load();
+	usage.lockLimit = s_lockLimit;
+	usage.overflows = s_overflows.load();
+	return usage;
+}
+
+
+
+
+QString RealtimeMemory::summary()
+{
+	const Usage u = usage();
+	if (!u.enabled)
+	{
+		return "not locked";
+	}
+	const auto megabytes = [](qint64 bytes)
+	{
+		return QString::number(bytes / (1024.0 * 1024.0), 'f', 1);
+	};
+	return QString("%1 of %2 MiB locked, limit %3, %4 MiB in huge pages")
+		.arg(megabytes(u.lockedBytes), megabytes(u.poolBytes),
+			u.lockLimit < 0 ? QString("none") : megabytes(u.lockLimit) + " MiB",
+			megabytes(u.hugePageBytes));
+}
@@ -29,12 +29,16 @@
 #endif
 
 #include "BufferManager.h"
+#include "ConfigManager.h"
+#include "PerfLog.h"
+#include "PlanarBuffer.h"
 #include "RemotePlugin.h"
 #include "Mixer.h"
 #include "Engine.h"
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
 
 #ifndef SYNC_WITH_SHM_FIFO
 #include <QtCore/QUuid>
@@ -43,6 +47,11 @@
 #endif
 
 
+const int RemoteEventBlock::MaxEvents;
+const int RemotePlugin::MaxMissedDeadlines;
+const int RemotePlugin::BypassPeriods;
+
+
 // simple helper thread monitoring our RemotePlugin - if process terminates
 // unexpectedly invalidate plugin so LMMS doesn't lock up
 ProcessWatcher::ProcessWatcher( RemotePlugin * _p ) :
@@ -85,6 +94,7 @@ RemotePlugin::RemotePlugin() :
 	m_failed( true ),
 	m_watcher( this ),
 	m_commMutex( QMutex::Recursive ),
+	m_launched( false ),
 	m_splitChannels( false ),
 #ifdef USE_QT_SHMEM
 	m_shmObj(),
@@ -94,8 +104,22 @@ RemotePlugin::RemotePlugin() :
 	m_shmSize( 0 ),
 	m_shm( NULL ),
 	m_inputCount( DEFAULT_CHANNELS ),
-	m_outputCount( DEFAULT_CHANNELS )
+	m_outputCount( DEFAULT_CHANNELS ),
+	m_async( false ),
+	m_slot( 0 ),
+	m_pendingFrames( 0 ),
+	m_periodsStarted( 0 ),
+	m_periodsDone( 0 ),
+	m_eventsOffset( 0 ),
+	m_watchdog( ConfigManager::inst()->value(
+				"mixer", "remotewatchdog" ).toInt() ),
+	m_missedDeadlines( 0 ),
+	m_bypassPeriods( 0 ),
+	m_skippedPeriods( 0 )
 {
+	// events are queued on the audio threads
+	m_events.reserve( RemoteEventBlock::MaxEvents );
+
 #ifndef SYNC_WITH_SHM_FIFO
 	struct sockaddr_un sa;
 	sa.sun_family = AF_LOCAL;
@@ -133,6 +157,8 @@ RemotePlugin::RemotePlugin() :
 		Qt::DirectConnection );
 	connect( &m_process, SIGNAL( finished( int, QProcess::ExitStatus ) ),
 		&m_watcher, SLOT( quit() ), Qt::DirectConnection );
+	connect( Engine::mixer(), SIGNAL( framesPerPeriodChanged() ),
+		this, SLOT( framesPerPeriodChanged() ), Qt::DirectConnection );
 }
 
 
@@ -148,13 +174,21 @@ RemotePlugin::~RemotePlugin()
 		if( isRunning() )
 		{
 			lock();
-			sendMessage( IdQuit );
+			// a process never connected to can't be asked to quit
+			if( !m_launched )
+			{
+				sendMessage( IdQuit );
+			}
 
-			m_process.waitForFinished( 1000 );
-			if( m_process.state() != QProcess::NotRunning )
+			// a host process goes on with its other plugins
+			if( !m_host )
 			{
-				m_process.terminate();
-				m_process.kill();
+				m_process.waitForFinished( 1000 );
+				if( m_process.state() != QProcess::NotRunning )
+				{
+					m_process.terminate();
+					m_process.kill();
+				}
 			}
 			unlock();
 		}
@@ -177,8 +211,8 @@ RemotePlugin::~RemotePlugin()
 
 
 
-bool RemotePlugin::init(const QString &pluginExecutable,
-							bool waitForInitDoneMsg , QStringList extraArgs)
+bool RemotePlugin::launch( const QString & pluginExecutable,
+							QStringList extraArgs )
 {
 	lock();
 	if( m_failed )
@@ -228,17 +262,52 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 	args << m_socketFile;
 #endif
 	args << extraArgs;
+	if( m_host )
+	{
+		// the host starts the plugin as if it were started with args
+		message m( IdStartInstance );
+		for( const QString & arg : args )
+		{
+			m.addString( QSTR_TO_STDSTR( arg ) );
+		}
+		m_host->lock();
+		m_host->sendMessage( m );
+		m_host->unlock();
+	}
+	else
+	{
 #ifndef DEBUG_REMOTE_PLUGIN
-	m_process.setProcessChannelMode( QProcess::ForwardedChannels );
-	m_process.setWorkingDirectory( QCoreApplication::applicationDirPath() );
-	m_exec = exec;
-	m_args = args;
-	// we start the process on the watcher thread to work around QTBUG-8819
-	m_process.moveToThread( &m_watcher );
-	m_watcher.start( QThread::LowestPriority );
+		m_process.setProcessChannelMode( QProcess::ForwardedChannels );
+		m_process.setWorkingDirectory( QCoreApplication::applicationDirPath() );
+		m_exec = exec;
+		m_args = args;
+		// we start the process on the watcher thread to work around QTBUG-8819
+		m_process.moveToThread( &m_watcher );
+		m_watcher.start( QThread::LowestPriority );
 #else
-	qDebug() << exec << args;
+		qDebug() << exec << args;
 #endif
+	}
+	m_launched = true;
+	unlock();
+
+	return failed();
+}
+
+
+
+
+bool RemotePlugin::init(const QString &pluginExecutable,
+							bool waitForInitDoneMsg , QStringList extraArgs)
+{
+	if( !m_launched && launch( pluginExecutable, extraArgs ) )
+	{
+		return failed();
+	}
+
+	lock();
+	// the process may have started up while nobody waited for it
+	m_launched = false;
 
 #ifndef SYNC_WITH_SHM_FIFO
 	struct pollfd pollin;
@@ -264,6 +333,10 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 	}
 #endif
 
+	// a new process knows nothing of the periods of the old one
+	m_periodsStarted = 0;
+	m_periodsDone = 0;
+	m_slot = 0;
 	resizeSharedProcessingMemory();
 
 	if( waitForInitDoneMsg )
@@ -281,14 +354,33 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 bool RemotePlugin::process( const sampleFrame * _in_buf,
 						sampleFrame * _out_buf )
 {
+	return processPeriod( _in_buf, NULL, _out_buf, NULL );
+}
+
+
+
+
+bool RemotePlugin::processPlanar( const PlanarBuffer * _in_buf,
+						PlanarBuffer * _out_buf )
+{
+	return processPeriod( NULL, _in_buf, NULL, _out_buf );
+}
+
+
+
+
+bool RemotePlugin::processPeriod( const sampleFrame * _in_buf,
+					const PlanarBuffer * _planar_in,
+					sampleFrame * _out_buf,
+					PlanarBuffer * _planar_out )
+{
+	PerfTrace::Scope trace( "Remote plugin period", PerfTrace::RemotePlugin );
 	const fpp_t frames = Engine::mixer()->framesPerPeriod();
+	const bool wantsOutput = _out_buf != NULL || _planar_out != NULL;
 
 	if( m_failed || !isRunning() )
 	{
-		if( _out_buf != NULL )
-		{
-			BufferManager::clear( _out_buf, frames );
-		}
+		clearOutput( _out_buf, _planar_out, frames );
 		return false;
 	}
 
@@ -304,95 +396,386 @@ bool RemotePlugin::process( const sampleFrame * _in_buf,
 			fetchAndProcessAllMessages();
 			unlock();
 		}
-		if( _out_buf != NULL )
+		clearOutput( _out_buf, _planar_out, frames );
+		return false;
+	}
+
+	if( m_watchdog && watchdogSkips() )
+	{
+		clearOutput( _out_buf, _planar_out, frames );
+		return false;
+	}
+	// a period later than this is an xrun anyway
+	const int deadline = m_watchdog ? frames * 1000000LL /
+				Engine::mixer()->processingSampleRate() : 0;
+
+	if( m_async )
+	{
+		// the output of the period before is read from the other half
+		// while the plugin computes this one
+		const size_t slotSize = m_shmSize / 2;
+		const int offset = m_slot * slotSize / sizeof( float );
+		memset( m_shm + offset, 0, m_eventsOffset * sizeof( float ) );
+		writeInput( _in_buf, _planar_in, m_shm + offset, frames );
+
+		lock();
+		MixerProfiler::Probe probe( &m_waitTime, true );
+		sendMessage( message( IdStartProcessing ).addInt( offset ).
+					addInt( writeEvents( offset ) ) );
+		++m_periodsStarted;
+		// the plugin answers in order, so the period before is done
+		// by the time it starts this one
+		const bool inTime = waitForPeriods( 1, deadline );
+		unlock();
+
+		const fpp_t pendingFrames = m_pendingFrames;
+		m_pendingFrames = frames;
+		m_slot = 1 - m_slot;
+
+		if( !inTime )
+		{
+			missedDeadline();
+		}
+		else
+		{
+			m_missedDeadlines = 0;
+		}
+
+		if( !wantsOutput )
 		{
-			BufferManager::clear( _out_buf, frames );
+			return false;
+		}
+		if( m_failed || m_outputCount == 0 || pendingFrames != frames ||
+								!inTime )
+		{
+			clearOutput( _out_buf, _planar_out, frames );
+			return false;
 		}
+		readOutput( _out_buf, _planar_out,
+				m_shm + m_slot * slotSize / sizeof( float ), frames );
+		return true;
+	}
+
+	memset( m_shm, 0, m_eventsOffset * sizeof( float ) );
+	writeInput( _in_buf, _planar_in, m_shm, frames );
+
+	lock();
+	MixerProfiler::Probe probe( &m_waitTime, true );
+	sendMessage( message( IdStartProcessing ).addInt( 0 ).
+						addInt( writeEvents( 0 ) ) );
+	++m_periodsStarted;
+
+	// the watchdog has to know whether the plugin is done in time
+	if( m_failed || ( !m_watchdog &&
+				( !wantsOutput || m_outputCount == 0 ) ) )
+	{
+		unlock();
 		return false;
 	}
 
-	memset( m_shm, 0, m_shmSize );
+	if( !waitForPeriods( 0, deadline ) )
+	{
+		unlock();
+		missedDeadline();
+		clearOutput( _out_buf, _planar_out, frames );
+		return false;
+	}
+	unlock();
+	m_missedDeadlines = 0;
+
+	if( !wantsOutput || m_outputCount == 0 )
+	{
+		return false;
+	}
+	readOutput( _out_buf, _planar_out, m_shm, frames );
+
+	return true;
+}
+
+
+
+
+bool RemotePlugin::watchdogSkips()
+{
+	if( m_bypassPeriods > 0 )
+	{
+		--m_bypassPeriods;
+		++m_skippedPeriods;
+		return true;
+	}
+
+	lock();
+	fetchAndProcessAllMessages();
+	const bool busy = m_periodsStarted - m_periodsDone > ( m_async ? 1 : 0 );
+	unlock();
+	if( busy )
+	{
+		// still computing a period which missed its deadline, whose
+		// memory mustn't be touched
+		++m_skippedPeriods;
+		m_pendingFrames = 0;
+		return true;
+	}
+	return false;
+}
+
+
+
+
+bool RemotePlugin::waitForPeriods( int _pending, int _timeoutUs )
+{
+	PerfTrace::Scope trace( "Wait for remote plugin", PerfTrace::RemotePlugin );
+	QElapsedTimer timer;
+	timer.start();
+	while( !m_failed && !isInvalid() &&
+			m_periodsStarted - m_periodsDone > _pending )
+	{
+		if( _timeoutUs <= 0 )
+		{
+			waitForMessage( IdProcessingDone );
+			continue;
+		}
+		const int left = _timeoutUs - timer.nsecsElapsed() / 1000;
+		if( left <= 0 || !waitForMessages( left ) )
+		{
+			return false;
+		}
+		fetchAndProcessNextMessage();
+	}
+	return true;
+}
+
+
+
+
+void RemotePlugin::missedDeadline()
+{
+	if( ++m_missedDeadlines >= MaxMissedDeadlines )
+	{
+		qWarning( "Remote plugin keeps missing its deadline, "
+						"bypassing it for a while." );
+		m_missedDeadlines = 0;
+		m_bypassPeriods = BypassPeriods;
+	}
+}
+
+
+
+
+void RemotePlugin::setAsyncProcessing( bool _on )
+{
+	lock();
+	if( _on != m_async )
+	{
+		// the plugin mustn't be working in the memory given back
+		while( !m_failed && !isInvalid() &&
+				m_periodsDone < m_periodsStarted )
+		{
+			waitForMessage( IdProcessingDone );
+		}
+		m_async = _on;
+		m_slot = 0;
+		m_pendingFrames = 0;
+		if( !m_failed && m_shm != NULL )
+		{
+			resizeSharedProcessingMemory();
+		}
+	}
+	unlock();
+}
+
+
+
+
+fpp_t RemotePlugin::latency() const
+{
+	return m_async ? Engine::mixer()->framesPerPeriod() : 0;
+}
+
+
+
+
+qint64 RemotePlugin::residentBytes() const
+{
+#ifdef LMMS_BUILD_LINUX
+	if( m_host || m_process.state() != QProcess::Running )
+	{
+		return 0;
+	}
+	// the second field is the resident set in pages
+	QFile statm( QString( "/proc/%1/statm" ).arg( m_process.processId() ) );
+	if( !statm.open( QIODevice::ReadOnly ) )
+	{
+		return 0;
+	}
+	const QList<QByteArray> fields = statm.readLine().split( ' ' );
+	return fields.size() > 1
+		? fields[1].toLongLong() * sysconf( _SC_PAGESIZE ) : 0;
+#else
+	return 0;
+#endif
+}
+
 
-	ch_cnt_t inputs = qMin<ch_cnt_t>( m_inputCount, DEFAULT_CHANNELS );
 
-	if( _in_buf != NULL && inputs > 0 )
+
+void RemotePlugin::writeInput( const sampleFrame * _in_buf,
+				const PlanarBuffer * _planar_in, float * _shm,
+							fpp_t _frames )
+{
+	const ch_cnt_t inputs = qMin<ch_cnt_t>( m_inputCount, DEFAULT_CHANNELS );
+	const int stride = remoteChannelStride( _frames );
+
+	if( _planar_in != NULL && inputs > 0 )
 	{
 		if( m_splitChannels )
 		{
 			for( ch_cnt_t ch = 0; ch < inputs; ++ch )
 			{
-				for( fpp_t frame = 0; frame < frames; ++frame )
+				memcpy( _shm + ch * stride, _planar_in->channel( ch ),
+						_frames * sizeof( sample_t ) );
+			}
+			return;
+		}
+		sampleFrame * o = (sampleFrame *) _shm;
+		for( ch_cnt_t ch = 0; ch < inputs; ++ch )
+		{
+			const sample_t * in = _planar_in->channel( ch );
+			for( fpp_t frame = 0; frame < _frames; ++frame )
+			{
+				o[frame][ch] = in[frame];
+			}
+		}
+	}
+	else if( _in_buf != NULL && inputs > 0 )
+	{
+		if( m_splitChannels && inputs == DEFAULT_CHANNELS )
+		{
+			// both channels in one pass
+			float * left = _shm;
+			float * right = _shm + stride;
+			for( fpp_t frame = 0; frame < _frames; ++frame )
+			{
+				left[frame] = _in_buf[frame][0];
+				right[frame] = _in_buf[frame][1];
+			}
+		}
+		else if( m_splitChannels )
+		{
+			for( ch_cnt_t ch = 0; ch < inputs; ++ch )
+			{
+				for( fpp_t frame = 0; frame < _frames; ++frame )
 				{
-					m_shm[ch * frames + frame] =
+					_shm[ch * stride + frame] =
 							_in_buf[frame][ch];
 				}
 			}
 		}
 		else if( inputs == DEFAULT_CHANNELS )
 		{
-			memcpy( m_shm, _in_buf, frames * BYTES_PER_FRAME );
+			memcpy( _shm, _in_buf, _frames * BYTES_PER_FRAME );
 		}
 		else
 		{
-			sampleFrame * o = (sampleFrame *) m_shm;
+			sampleFrame * o = (sampleFrame *) _shm;
 			for( ch_cnt_t ch = 0; ch < inputs; ++ch )
 			{
-				for( fpp_t frame = 0; frame < frames; ++frame )
+				for( fpp_t frame = 0; frame < _frames; ++frame )
 				{
 					o[frame][ch] = _in_buf[frame][ch];
 				}
 			}
 		}
 	}
+}
 
-	lock();
-	sendMessage( IdStartProcessing );
 
-	if( m_failed || _out_buf == NULL || m_outputCount == 0 )
-	{
-		unlock();
-		return false;
-	}
 
-	waitForMessage( IdProcessingDone );
-	unlock();
 
+void RemotePlugin::readOutput( sampleFrame * _out_buf,
+				PlanarBuffer * _planar_out, const float * _shm,
+							fpp_t _frames )
+{
 	const ch_cnt_t outputs = qMin<ch_cnt_t>( m_outputCount,
 							DEFAULT_CHANNELS );
-	if( m_splitChannels )
+	const int stride = remoteChannelStride( _frames );
+	const float * out = _shm + m_inputCount * stride;
+
+	if( outputs < DEFAULT_CHANNELS )
+	{
+		// clear buffer, if plugin didn't fill up both channels
+		clearOutput( _out_buf, _planar_out, _frames );
+	}
+
+	if( _planar_out != NULL )
 	{
 		for( ch_cnt_t ch = 0; ch < outputs; ++ch )
 		{
-			for( fpp_t frame = 0; frame < frames; ++frame )
+			sample_t * o = _planar_out->channel( ch );
+			if( m_splitChannels )
 			{
-				_out_buf[frame][ch] = m_shm[( m_inputCount+ch )*
-								frames + frame];
+				memcpy( o, out + ch * stride,
+						_frames * sizeof( sample_t ) );
+				continue;
+			}
+			const sampleFrame * in = (const sampleFrame *) out;
+			for( fpp_t frame = 0; frame < _frames; ++frame )
+			{
+				o[frame] = in[frame][ch];
+			}
+		}
+	}
+	else if( m_splitChannels && outputs == DEFAULT_CHANNELS )
+	{
+		const float * left = out;
+		const float * right = out + stride;
+		for( fpp_t frame = 0; frame < _frames; ++frame )
+		{
+			_out_buf[frame][0] = left[frame];
+			_out_buf[frame][1] = right[frame];
+		}
+	}
+	else if( m_splitChannels )
+	{
+		for( ch_cnt_t ch = 0; ch < outputs; ++ch )
+		{
+			for( fpp_t frame = 0; frame < _frames; ++frame )
+			{
+				_out_buf[frame][ch] = out[ch * stride + frame];
 			}
 		}
 	}
 	else if( outputs == DEFAULT_CHANNELS )
 	{
-		memcpy( _out_buf, m_shm + m_inputCount * frames,
-						frames * BYTES_PER_FRAME );
+		memcpy( _out_buf, out, _frames * BYTES_PER_FRAME );
 	}
 	else
 	{
-		sampleFrame * o = (sampleFrame *) ( m_shm +
-							m_inputCount*frames );
-		// clear buffer, if plugin didn't fill up both channels
-		BufferManager::clear( _out_buf, frames );
-
-		for( ch_cnt_t ch = 0; ch <
-				qMin<int>( DEFAULT_CHANNELS, outputs ); ++ch )
+		const sampleFrame * o = (const sampleFrame *) out;
+		for( ch_cnt_t ch = 0; ch < outputs; ++ch )
 		{
-			for( fpp_t frame = 0; frame < frames; ++frame )
+			for( fpp_t frame = 0; frame < _frames; ++frame )
 			{
 				_out_buf[frame][ch] = o[frame][ch];
 			}
 		}
 	}
+}
 
-	return true;
+
+
+
+void RemotePlugin::clearOutput( sampleFrame * _out_buf,
+				PlanarBuffer * _planar_out, fpp_t _frames )
+{
+	if( _out_buf != NULL )
+	{
+		BufferManager::clear( _out_buf, _frames );
+	}
+	if( _planar_out != NULL )
+	{
+		_planar_out->clear( _frames );
+	}
 }
 
 
@@ -401,17 +784,101 @@ bool RemotePlugin::process( const sampleFrame * _in_buf,
 void RemotePlugin::processMidiEvent( const MidiEvent & _e,
 							const f_cnt_t _offset )
 {
-	message m( IdMidiEvent );
-	m.addInt( _e.type() );
-	m.addInt( _e.channel() );
-	m.addInt( _e.param( 0 ) );
-	m.addInt( _e.param( 1 ) );
-	m.addInt( _offset );
+	const RemoteEvent e = { RemoteEvent::Midi, _offset,
+			{ _e.type(), _e.channel(), _e.param( 0 ), _e.param( 1 ) },
+			0.0f };
+	queueEvent( e );
+}
+
+
+
+
+void RemotePlugin::processParameterChange( int _index, float _value,
+							const f_cnt_t _offset )
+{
+	const RemoteEvent e = { RemoteEvent::Parameter, _offset,
+						{ _index, 0, 0, 0 }, _value };
+	queueEvent( e );
+}
+
+
+
+
+void RemotePlugin::flushEvents()
+{
 	lock();
-	sendMessage( m );
+	m_eventsMutex.lock();
+	for( const RemoteEvent & e : m_events )
+	{
+		if( e.type == RemoteEvent::Midi )
+		{
+			sendMessage( message( IdMidiEvent ).
+					addInt( e.data[0] ).addInt( e.data[1] ).
+					addInt( e.data[2] ).addInt( e.data[3] ).
+					addInt( e.offset ) );
+		}
+		else
+		{
+			sendMessage( message( IdParameterChange ).
+				addInt( e.data[0] ).addFloat( e.value ) );
+		}
+	}
+	m_events.clear();
+	m_eventsMutex.unlock();
 	unlock();
 }
 
+
+
+
+void RemotePlugin::queueEvent( const RemoteEvent & _e )
+{
+	if( m_failed )
+	{
+		return;
+	}
+
+	QMutexLocker locker( &m_eventsMutex );
+	if( _e.type == RemoteEvent::Parameter )
+	{
+		// only the last value of a parameter at a frame counts
+		for( RemoteEvent & e : m_events )
+		{
+			if( e.type == RemoteEvent::Parameter &&
+				e.data[0] == _e.data[0] && e.offset == _e.offset )
+			{
+				e.value = _e.value;
+				return;
+			}
+		}
+	}
+	m_events.push_back( _e );
+}
+
+
+
+
+int RemotePlugin::writeEvents( int _offset )
+{
+	const int blockOffset = _offset + m_eventsOffset;
+	RemoteEventBlock * block = (RemoteEventBlock *)( m_shm + blockOffset );
+
+	QMutexLocker locker( &m_eventsMutex );
+	const int count = qMin<int>( m_events.size(),
+						RemoteEventBlock::MaxEvents );
+	std::copy( m_events.begin(), m_events.begin() + count, block->events );
+	block->count = count;
+
+	// what doesn't fit goes with the start of the next period
+	m_events.erase( m_events.begin(), m_events.begin() + count );
+	for( RemoteEvent & e : m_events )
+	{
+		e.offset = 0;
+	}
+
+	return blockOffset;
+}
+
 void RemotePlugin::showUI()
 {
 	lock();
@@ -431,9 +898,16 @@ void RemotePlugin::hideUI()
 
 void RemotePlugin::resizeSharedProcessingMemory()
 {
-	const size_t s = ( m_inputCount+m_outputCount ) *
-				Engine::mixer()->framesPerPeriod() *
-							sizeof( float );
+	// sized for the longest period, so the period may change, and twice
+	// for asynchronous processing
+	m_eventsOffset = ( m_inputCount+m_outputCount ) *
+			remoteChannelStride( Mixer::maxFramesPerPeriod() );
+	// both halves start at a 64 byte boundary
+	const size_t slotSize = ( m_eventsOffset * sizeof( float ) +
+				sizeof( RemoteEventBlock ) + 63 ) & ~size_t( 63 );
+	const size_t s = slotSize * ( m_async ? 2 : 1 );
+	// the plugin may still be working in the old memory
+	m_pendingFrames = 0;
 	if( m_shm != NULL )
 	{
 #ifdef USE_QT_SHMEM
@@ -493,6 +967,17 @@ void RemotePlugin::processErrored( QProcess::ProcessError err )
 
 
 
+void RemotePlugin::framesPerPeriodChanged()
+{
+	if( !m_failed && isRunning() )
+	{
+		updateBufferSize( Engine::mixer()->framesPerPeriod() );
+	}
+}
+
+
+
+
 bool RemotePlugin::processMessage( const message & _m )
 {
 	lock();
@@ -540,6 +1025,13 @@ bool RemotePlugin::processMessage( const message & _m )
 			break;
 
 		case IdProcessingDone:
+			if( !_m.data.empty() )
+			{
+				m_pluginTime.add( _m.getInt( 0 ) * 1000ULL );
+			}
+			++m_periodsDone;
+			break;
+
 		case IdQuit:
 		default:
 			break;
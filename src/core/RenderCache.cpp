@@ -0,0 +1,200 @@
+/*
+ * RenderCache.cpp - renderings of tracks kept between exports
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "RenderCache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDomDocument>
+#include <QSet>
+#include <QStandardPaths>
+
+#include "AutomationPattern.h"
+#include "BBTrackContainer.h"
+#include "ConfigManager.h"
+#include "Controller.h"
+#include "ControllerConnection.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "Song.h"
+
+
+namespace RenderCache
+{
+
+// bump when the rendering of tracks changes, so older renderings are
+// not played anymore
+static const int Version = 1;
+
+
+bool isEnabled()
+{
+	return maxSize() > 0;
+}
+
+
+
+
+QString directory()
+{
+	const QString dir = ConfigManager::inst()->value( "mixer", "rendercachedir" );
+	return dir.isEmpty() ? QStandardPaths::writableLocation(
+				QStandardPaths::CacheLocation ) + "/render" : dir;
+}
+
+
+
+
+qint64 maxSize()
+{
+	// in MiB
+	return ConfigManager::inst()->value( "mixer", "rendercachesize" ).toLongLong()
+								* 1024 * 1024;
+}
+
+
+
+
+QString keyOf( InstrumentTrack * track,
+		const Mixer::qualitySettings & qualitySettings,
+		sample_rate_t sampleRate )
+{
+	Song * song = Engine::getSong();
+	// frozen renderings are played by song position, which only works
+	// for a constant tempo
+	if( AutomationPattern::isAutomated( &song->tempoModel() ) )
+	{
+		return QString();
+	}
+
+	QDomDocument doc;
+	QDomElement root = doc.createElement( "rendercache" );
+	doc.appendChild( root );
+	root.setAttribute( "version", Version );
+	root.setAttribute( "samplerate", sampleRate );
+	root.setAttribute( "interpolation", qualitySettings.interpolation );
+	root.setAttribute( "oversampling", qualitySettings.oversampling );
+	root.setAttribute( "controlinterval", qualitySettings.controlInterval );
+	root.setAttribute( "fpp", Engine::mixer()->framesPerPeriod() );
+	root.setAttribute( "tempo", song->getTempo() );
+	root.setAttribute( "timesig_numerator",
+				song->getTimeSigModel().getNumerator() );
+	root.setAttribute( "timesig_denominator",
+				song->getTimeSigModel().getDenominator() );
+	root.setAttribute( "masterpitch", song->masterPitch() );
+
+	// the track with its instrument, effects and patterns
+	track->saveState( doc, root );
+
+	// tracks of beat patterns play where the song places their patterns
+	if( track->trackContainer() == Engine::getBBTrackContainer() )
+	{
+		for( Track * tk : song->tracks() )
+		{
+			if( tk->type() == Track::BBTrack )
+			{
+				tk->saveState( doc, root );
+			}
+		}
+	}
+
+	// and whatever changes their models while playing, which are the
+	// same sources a frozen track is invalidated by
+	QList<QObject *> sources;
+	sources << track;
+	if( track->instrument() )
+	{
+		sources << track->instrument();
+	}
+	for( Effect * effect : track->audioPort()->effects()->effects() )
+	{
+		sources << effect;
+	}
+	QSet<JournallingObject *> saved;
+	const auto save = [&]( JournallingObject * object )
+	{
+		if( !saved.contains( object ) )
+		{
+			saved.insert( object );
+			object->saveState( doc, root );
+		}
+	};
+	for( QObject * source : sources )
+	{
+		for( AutomatableModel * model : source->findChildren<AutomatableModel *>() )
+		{
+			for( AutomationPattern * pattern :
+					AutomationPattern::patternsForModel( model ) )
+			{
+				save( pattern );
+			}
+			if( model->controllerConnection() &&
+				model->controllerConnection()->getController() )
+			{
+				save( model->controllerConnection()->getController() );
+			}
+		}
+	}
+	for( AutomationPattern * pattern :
+			AutomationPattern::patternsForModel( &song->masterPitchModel() ) )
+	{
+		save( pattern );
+	}
+
+	return QString::fromLatin1( QCryptographicHash::hash( doc.toByteArray( -1 ),
+					QCryptographicHash::Sha1 ).toHex() );
+}
+
+
+
+
+QString fileOf( const QString & key )
+{
+	return QDir( directory() ).filePath( key + ".wav" );
+}
+
+
+
+
+void trim()
+{
+	const QFileInfoList files = QDir( directory() ).entryInfoList(
+			QStringList( "*.wav" ), QDir::Files, QDir::Time );
+	const qint64 limit = maxSize();
+	qint64 size = 0;
+	// newest first
+	for( const QFileInfo & file : files )
+	{
+		size += file.size();
+		if( size > limit )
+		{
+			QFile::remove( file.absoluteFilePath() );
+		}
+	}
+}
+
+}
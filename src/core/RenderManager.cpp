@@ -24,11 +24,17 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 
 #include "RenderManager.h"
+#include "AudioPort.h"
+#include "RenderCache.h"
 #include "Song.h"
 #include "BBTrackContainer.h"
 #include "BBTrack.h"
+#include "InstrumentTrack.h"
+#include "SampleTrack.h"
 
 
 RenderManager::RenderManager(
@@ -40,13 +46,16 @@ RenderManager::RenderManager(
 	m_oldQualitySettings( Engine::mixer()->currentQualitySettings() ),
 	m_outputSettings(outputSettings),
 	m_format(fmt),
-	m_outputPath(outputPath)
+	m_outputPath(outputPath),
+	m_freewheel( false )
 {
 	Engine::mixer()->storeAudioDevice();
 }
 
 RenderManager::~RenderManager()
 {
+	clearStems();
+	releaseCachedTracks();
 	Engine::mixer()->restoreAudioDevice();  // Also deletes audio dev.
 	Engine::mixer()->changeQuality( m_oldQualitySettings );
 }
@@ -56,19 +65,41 @@ void RenderManager::abortProcessing()
 	if ( m_activeRenderer ) {
 		disconnect( m_activeRenderer.get(), SIGNAL( finished() ),
 				this, SLOT( renderNextTrack() ) );
+		disconnect( m_activeRenderer.get(), SIGNAL( finished() ),
+				this, SLOT( finishStems() ) );
 		m_activeRenderer->abortProcessing();
 	}
+	// remove the incomplete stems
+	QStringList stemFiles;
+	for( const auto & dev : m_stemDevices )
+	{
+		stemFiles << dev->outputFile();
+	}
+	clearStems();
+	for( const QString & file : stemFiles )
+	{
+		QFile( file ).remove();
+	}
+	m_newCacheFiles.clear();
+	releaseCachedTracks();
+	removeDiscardedOutput();
 	restoreMutedState();
 }
 
 // Called to render each new track when rendering tracks individually.
 void RenderManager::renderNextTrack()
 {
+	if( m_activeRenderer )
+	{
+		m_statistics += m_activeRenderer->statistics();
+	}
 	m_activeRenderer.reset();
 
 	if( m_tracksToRender.isEmpty() )
 	{
 		// nothing left to render
+		clearStems();
+		finishRenderCache();
 		restoreMutedState();
 		emit finished();
 	}
@@ -92,7 +123,7 @@ void RenderManager::renderNextTrack()
 }
 
 // Render the song into individual tracks
-void RenderManager::renderTracks()
+void RenderManager::renderTracks( bool singlePass )
 {
 	const TrackContainer::TrackList & tl = Engine::getSong()->tracks();
 
@@ -124,6 +155,12 @@ void RenderManager::renderTracks()
 		}
 	}
 
+	if( singlePass )
+	{
+		renderStems();
+		return;
+	}
+
 	// copy the list of unmuted tracks into our rendering queue.
 	// we need to remember which tracks were unmuted to restore state at the end.
 	m_tracksToRender = m_unmuted;
@@ -131,22 +168,306 @@ void RenderManager::renderTracks()
 	renderNextTrack();
 }
 
+// Render a single track by tapping its audio port while everything else is
+// muted
+void RenderManager::renderTrack( Track * track )
+{
+	const TrackContainer * containers[] = { Engine::getSong(),
+						Engine::getBBTrackContainer() };
+	for( const TrackContainer * container : containers )
+	{
+		for( Track * tk : container->tracks() )
+		{
+			const Track::TrackTypes type = tk->type();
+			// automation tracks keep running, and beat/bassline
+			// tracks are muted through the tracks they contain
+			if( tk != track && !tk->isMuted() &&
+				( type == Track::InstrumentTrack || type == Track::SampleTrack ) )
+			{
+				m_unmuted.push_back( tk );
+				tk->setMuted( true );
+			}
+		}
+	}
+
+	AudioFileDeviceInstantiaton instantiate =
+		ProjectRenderer::fileEncodeDevices[m_format].m_getDevInst;
+	bool successful = false;
+	AudioFileDevice * dev = instantiate ? instantiate( m_outputPath,
+				m_outputSettings, DEFAULT_CHANNELS, Engine::mixer(),
+				successful ) : nullptr;
+	if( !successful )
+	{
+		qDebug( "Renderer failed to acquire a file device for track %s!",
+				qUtf8Printable( track->name() ) );
+		delete dev;
+		restoreMutedState();
+		emit finished();
+		return;
+	}
+
+	AudioPort * port = audioPortOf( track );
+	port->setStemOutput( dev );
+	m_stemPorts.push_back( port );
+	m_stemDevices.emplace_back( dev );
+
+	m_discardedOutput = m_outputPath + ".master"
+		+ ProjectRenderer::getFileExtensionFromFormat( m_format );
+	render( m_discardedOutput );
+
+	if( m_activeRenderer )
+	{
+		disconnect( m_activeRenderer.get(), SIGNAL( finished() ),
+				this, SLOT( renderNextTrack() ) );
+		connect( m_activeRenderer.get(), SIGNAL( finished() ),
+				this, SLOT( finishStems() ) );
+	}
+}
+
+// Render all tracks at once by tapping their audio ports, so the song is
+// only rendered once and the stems are encoded in parallel by the worker
+// threads
+void RenderManager::renderStems()
+{
+	AudioFileDeviceInstantiaton instantiate =
+		ProjectRenderer::fileEncodeDevices[m_format].m_getDevInst;
+
+	for( int i = 0; i < m_unmuted.size() && instantiate; ++i )
+	{
+		Track * track = m_unmuted[i];
+		bool successful = false;
+		AudioFileDevice * dev = instantiate(
+					pathForTrack( track, i + 1 ), m_outputSettings,
+					DEFAULT_CHANNELS, Engine::mixer(), successful );
+		if( !successful )
+		{
+			qDebug( "Renderer failed to acquire a file device for track %s!",
+					qUtf8Printable( track->name() ) );
+			delete dev;
+			continue;
+		}
+
+		AudioPort * port = audioPortOf( track );
+		port->setStemOutput( dev );
+		m_stemPorts.push_back( port );
+		m_stemDevices.emplace_back( dev );
+	}
+
+	// the FX mixer output goes to an extra file
+	const QString extension = ProjectRenderer::getFileExtensionFromFormat( m_format );
+	render( QDir( m_outputPath ).filePath(
+				QString( "0_%1%2" ).arg( tr( "Master" ) ).arg( extension ) ) );
+
+	if( m_activeRenderer )
+	{
+		disconnect( m_activeRenderer.get(), SIGNAL( finished() ),
+				this, SLOT( renderNextTrack() ) );
+		connect( m_activeRenderer.get(), SIGNAL( finished() ),
+				this, SLOT( finishStems() ) );
+	}
+}
+
+// Called when all tracks were rendered in a single pass
+void RenderManager::finishStems()
+{
+	m_statistics += m_activeRenderer->statistics();
+	m_activeRenderer.reset();
+	clearStems();
+	removeDiscardedOutput();
+
+	// only unmutes the tracks muted by renderTrack(), the others are
+	// unmuted already
+	restoreMutedState();
+	emit finished();
+}
+
+void RenderManager::removeDiscardedOutput()
+{
+	if( !m_discardedOutput.isEmpty() )
+	{
+		QFile( m_discardedOutput ).remove();
+		m_discardedOutput.clear();
+	}
+}
+
+// Detach the stem outputs and close their files
+void RenderManager::clearStems()
+{
+	for( AudioPort * port : m_stemPorts )
+	{
+		port->setStemOutput( nullptr );
+	}
+	m_stemPorts.clear();
+	m_stemDevices.clear();
+}
+
+AudioPort * RenderManager::audioPortOf( Track * track )
+{
+	return track->type() == Track::InstrumentTrack
+		? static_cast<InstrumentTrack *>( track )->audioPort()
+		: static_cast<SampleTrack *>( track )->audioPort();
+}
+
+void RenderManager::addOutput( const OutputSettings & outputSettings,
+		ProjectRenderer::ExportFileFormats fmt, QString outputPath )
+{
+	m_extraOutputs.push_back( ExtraOutput{ outputSettings, fmt, outputPath } );
+}
+
 // Render the song into a single track
 void RenderManager::renderProject()
 {
-	render( m_outputPath );
+	if( RenderCache::isEnabled() )
+	{
+		prepareRenderCache();
+	}
+	render( m_outputPath, true );
+}
+
+// Find the instrument tracks with a rendering in the cache, and record
+// the others for it
+void RenderManager::prepareRenderCache()
+{
+	const Song * song = Engine::getSong();
+	// the renderings have to start at the beginning of the song and
+	// include the tails of the last notes, like frozen ones
+	const bool record = !song->isRenderBetweenMarkers() &&
+			!song->hasExportRange() &&
+			!song->isExportLoop() && song->getLoopRenderCount() == 1 &&
+			QDir().mkpath( RenderCache::directory() );
+	const sample_rate_t sampleRate = m_outputSettings.getSampleRate() *
+				m_qualitySettings.sampleRateMultiplier();
+
+	AudioFileDeviceInstantiaton instantiate =
+		ProjectRenderer::fileEncodeDevices[ProjectRenderer::WaveFile].m_getDevInst;
+	// floats keep what goes above 0 dBFS before the FX mixer
+	const OutputSettings os( sampleRate,
+				OutputSettings::BitRateSettings( 160, false ),
+				OutputSettings::Depth_32Bit );
+
+	// including the tracks of the beat patterns, which repeat the same
+	// notes over and over
+	const TrackContainer::TrackList tracks = song->tracks() +
+				Engine::getBBTrackContainer()->tracks();
+	for( Track * tk : tracks )
+	{
+		if( tk->type() != Track::InstrumentTrack || tk->isMuted() )
+		{
+			continue;
+		}
+		InstrumentTrack * track = static_cast<InstrumentTrack *>( tk );
+		if( track->isFrozen() )
+		{
+			continue;
+		}
+		const QString key = RenderCache::keyOf( track, m_qualitySettings,
+								sampleRate );
+		if( key.isEmpty() )
+		{
+			continue;
+		}
+
+		const QString file = RenderCache::fileOf( key );
+		if( QFileInfo::exists( file ) )
+		{
+			// frozen once the mixer runs at the export rate, so the
+			// rendering isn't resampled when it is loaded
+			m_cachedTracks.emplace_back( track, file );
+			continue;
+		}
+		if( !record || !instantiate )
+		{
+			continue;
+		}
+
+		bool successful = false;
+		AudioFileDevice * dev = instantiate( file + ".part", os,
+				DEFAULT_CHANNELS, Engine::mixer(), successful );
+		if( !successful )
+		{
+			delete dev;
+			continue;
+		}
+		track->audioPort()->setStemOutput( dev );
+		m_stemPorts.push_back( track->audioPort() );
+		m_stemDevices.emplace_back( dev );
+		m_newCacheFiles << file;
+	}
+}
+
+void RenderManager::playCachedTracks()
+{
+	for( auto it = m_cachedTracks.begin(); it != m_cachedTracks.end(); )
+	{
+		if( it->first->freeze( it->second ) )
+		{
+			++it;
+			continue;
+		}
+		// unreadable, so it is rendered again next time
+		QFile( it->second ).remove();
+		it = m_cachedTracks.erase( it );
+	}
+}
+
+// Keep the renderings recorded, after their files were closed
+void RenderManager::finishRenderCache()
+{
+	releaseCachedTracks();
+	if( m_newCacheFiles.isEmpty() )
+	{
+		return;
+	}
+	for( const QString & file : m_newCacheFiles )
+	{
+		QFile::remove( file );
+		QFile::rename( file + ".part", file );
+	}
+	m_newCacheFiles.clear();
+	RenderCache::trim();
 }
 
-void RenderManager::render(QString outputPath)
+void RenderManager::releaseCachedTracks()
 {
+	for( const auto & cached : m_cachedTracks )
+	{
+		cached.first->unfreeze( false );
+	}
+	m_cachedTracks.clear();
+}
+
+void RenderManager::render(QString outputPath, bool withExtraOutputs)
+{
+	// freewheeling, the live device renders at its own sample rate
+	AudioDevice * liveDevice = Engine::mixer()->audioDev();
+	AudioDevice * freewheelDevice = m_freewheel && withExtraOutputs &&
+			liveDevice->supportsFreewheel() ? liveDevice : nullptr;
+	OutputSettings outputSettings = m_outputSettings;
+	if( freewheelDevice )
+	{
+		outputSettings.setSampleRate( freewheelDevice->sampleRate() );
+	}
+
 	m_activeRenderer = std::make_unique<ProjectRenderer>(
 			m_qualitySettings,
-			m_outputSettings,
+			outputSettings,
 			m_format,
 			outputPath);
 
 	if( m_activeRenderer->isReady() )
 	{
+		m_activeRenderer->setFreewheelDevice( freewheelDevice );
+		// the live device only writes to one file
+		for( const ExtraOutput & output : m_extraOutputs )
+		{
+			if( withExtraOutputs && !freewheelDevice && !m_activeRenderer->addOutput(
+					output.outputSettings, output.format, output.path ) )
+			{
+				qDebug( "Renderer failed to acquire a file device for %s!",
+						qUtf8Printable( output.path ) );
+			}
+		}
+
 		// pass progress signals through
 		connect( m_activeRenderer.get(), SIGNAL( progressChanged( int ) ),
 				this, SIGNAL( progressChanged( int ) ) );
@@ -156,6 +477,12 @@ void RenderManager::render(QString outputPath)
 		connect( m_activeRenderer.get(), SIGNAL( finished() ),
 				this, SLOT( renderNextTrack() ) );
 
+		if( !m_cachedTracks.empty() )
+		{
+			connect( m_activeRenderer.get(), SIGNAL( processingPrepared() ),
+					this, SLOT( playCachedTracks() ) );
+		}
+
 		m_activeRenderer->startProcessing();
 	}
 	else
@@ -186,6 +513,16 @@ QString RenderManager::pathForTrack(const Track *track, int num)
 	return QDir(m_outputPath).filePath(name);
 }
 
+ProjectRenderer::Statistics RenderManager::statistics() const
+{
+	ProjectRenderer::Statistics stats = m_statistics;
+	if( m_activeRenderer )
+	{
+		stats += m_activeRenderer->statistics();
+	}
+	return stats;
+}
+
 void RenderManager::updateConsoleProgress()
 {
 	if ( m_activeRenderer )
@@ -24,57 +24,106 @@
  */
 
 #include "RingBuffer.h"
+#include "DelayLinePool.h"
 #include "Engine.h"
 #include "Mixer.h"
 #include "MixHelpers.h"
 
  
+// the period may change, so it's looked up on every access, while the buffer
+// is padded by the longest period
+static inline fpp_t framesPerPeriod()
+{
+	return Engine::mixer()->framesPerPeriod();
+}
+
+
 RingBuffer::RingBuffer( f_cnt_t size ) : 
-	m_fpp( Engine::mixer()->framesPerPeriod() ),
+	m_fpp( Mixer::maxFramesPerPeriod() ),
 	m_samplerate( Engine::mixer()->processingSampleRate() ),
-	m_size( size + m_fpp )
+	m_position( 0 )
 {
-	m_buffer = new sampleFrame[ m_size ];
-	memset( m_buffer, 0, m_size * sizeof( sampleFrame ) );
-	m_position = 0;
+	m_memory.frames = size + m_fpp;
+	m_memory.data = DelayLinePool::allocate( m_memory.frames );
 }
 
 
 RingBuffer::RingBuffer( float size ) : 
-	m_fpp( Engine::mixer()->framesPerPeriod() ),
+	m_fpp( Mixer::maxFramesPerPeriod() ),
 	m_samplerate( Engine::mixer()->processingSampleRate() )
 {
-	m_size = msToFrames( size ) + m_fpp;
-	m_buffer = new sampleFrame[ m_size ];
-	memset( m_buffer, 0, m_size * sizeof( sampleFrame ) );
+	m_memory.frames = msToFrames( size ) + m_fpp;
+	m_memory.data = DelayLinePool::allocate( m_memory.frames );
 	m_position = 0;
 	setSamplerateAware( true );
-	//qDebug( "m_size %d, m_position %d", m_size, m_position );
+	//qDebug( "m_memory.frames %d, m_position %d", m_memory.frames, m_position );
 }
 
 
 RingBuffer::~RingBuffer()
 {
-	delete[] m_buffer;
+	DelayLinePool::release( m_memory );
 }
 
 
 void RingBuffer::reset()
 {
-	memset( m_buffer, 0, m_size * sizeof( sampleFrame ) );
+	memset( m_memory.data, 0, m_memory.frames * sizeof( sampleFrame ) );
 	m_position = 0;
 }
 
 
 void RingBuffer::changeSize( f_cnt_t size )
 {
-	size += m_fpp;
-	sampleFrame * tmp = m_buffer;
-	m_size = size;
-	m_buffer = new sampleFrame[ m_size ];
-	memset( m_buffer, 0, m_size * sizeof( sampleFrame ) );
+	DelayLinePool::release( m_memory );
+	m_memory.frames = size + m_fpp;
+	m_memory.data = DelayLinePool::allocate( m_memory.frames );
+	m_position = 0;
+}
+
+
+void RingBuffer::reserve( f_cnt_t size )
+{
+	f_cnt_t needed = size + m_fpp;
+	if( needed <= m_memory.frames )
+	{
+		return;
+	}
+
+	sampleFrame * data = DelayLinePool::allocate( needed );
+	const f_cnt_t old = m_memory.frames;
+	if( old > 0 )
+	{
+		// what's ahead of the position is what's still to be popped
+		memcpy( data, & m_memory.data[m_position], ( old - m_position ) * sizeof( sampleFrame ) );
+		memcpy( & data[old - m_position], m_memory.data, m_position * sizeof( sampleFrame ) );
+		DelayLinePool::release( m_memory.data, old );
+	}
+	m_memory.data = data;
+	m_memory.frames = needed;
 	m_position = 0;
-	delete[] tmp;
+}
+
+
+void RingBuffer::reserve( float size )
+{
+	reserve( msToFrames( size ) );
+}
+
+
+void RingBuffer::sleep()
+{
+	DelayLinePool::park( m_memory );
+}
+
+
+void RingBuffer::wake()
+{
+	// if the memory was taken back, reserve() starts over
+	if( m_memory.parked )
+	{
+		DelayLinePool::unpark( m_memory );
+	}
 }
 
 
@@ -99,13 +148,13 @@ void RingBuffer::setSamplerateAware( bool b )
 
 void RingBuffer::advance()
 {
-	m_position = ( m_position + m_fpp ) % m_size;
+	m_position = ( m_position + framesPerPeriod() ) % m_memory.frames;
 }
 
 
 void RingBuffer::movePosition( f_cnt_t amount )
 {
-	m_position = ( m_position + amount ) % m_size;
+	m_position = ( m_position + amount ) % m_memory.frames;
 }
 
 
@@ -117,44 +166,46 @@ void RingBuffer::movePosition( float amount )
 
 void RingBuffer::pop( sampleFrame * dst )
 {
-	if( m_position + m_fpp <= m_size ) // we won't go over the edge so we can just memcpy here
+	const fpp_t fpp = framesPerPeriod();
+	if( m_position + fpp <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [ m_position ], m_fpp * sizeof( sampleFrame ) );
-		memset( & m_buffer[m_position], 0, m_fpp * sizeof( sampleFrame ) );
+		memcpy( dst, & m_memory.data [ m_position ], fpp * sizeof( sampleFrame ) );
+		memset( & m_memory.data[m_position], 0, fpp * sizeof( sampleFrame ) );
 	}
 	else
 	{
-		f_cnt_t first = m_size - m_position;
-		f_cnt_t second = m_fpp - first;
+		f_cnt_t first = m_memory.frames - m_position;
+		f_cnt_t second = fpp - first;
 		
-		memcpy( dst, & m_buffer [ m_position ], first * sizeof( sampleFrame ) );
-		memset( & m_buffer [m_position], 0, first * sizeof( sampleFrame ) );
+		memcpy( dst, & m_memory.data [ m_position ], first * sizeof( sampleFrame ) );
+		memset( & m_memory.data [m_position], 0, first * sizeof( sampleFrame ) );
 		
-		memcpy( & dst [first], m_buffer, second * sizeof( sampleFrame ) );
-		memset( m_buffer, 0, second * sizeof( sampleFrame ) );
+		memcpy( & dst [first], m_memory.data, second * sizeof( sampleFrame ) );
+		memset( m_memory.data, 0, second * sizeof( sampleFrame ) );
 	}
 	
-	m_position = ( m_position + m_fpp ) % m_size;
+	m_position = ( m_position + fpp ) % m_memory.frames;
 }
 
 
 void RingBuffer::read( sampleFrame * dst, f_cnt_t offset )
 {
-	f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( pos < 0 ) { pos += m_size; }
+	const fpp_t fpp = framesPerPeriod();
+	f_cnt_t pos = ( m_position + offset ) % m_memory.frames;
+	if( pos < 0 ) { pos += m_memory.frames; }
 	
-	if( pos + m_fpp <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + fpp <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [pos], m_fpp * sizeof( sampleFrame ) );
+		memcpy( dst, & m_memory.data [pos], fpp * sizeof( sampleFrame ) );
 	}
 	else
 	{
-		f_cnt_t first = m_size - pos;
-		f_cnt_t second = m_fpp - first;
+		f_cnt_t first = m_memory.frames - pos;
+		f_cnt_t second = fpp - first;
 		
-		memcpy( dst, & m_buffer [pos], first * sizeof( sampleFrame ) );
+		memcpy( dst, & m_memory.data [pos], first * sizeof( sampleFrame ) );
 		
-		memcpy( & dst [first], m_buffer, second * sizeof( sampleFrame ) );
+		memcpy( & dst [first], m_memory.data, second * sizeof( sampleFrame ) );
 	}
 }
 
@@ -167,21 +218,21 @@ void RingBuffer::read( sampleFrame * dst, float offset )
 
 void RingBuffer::read( sampleFrame * dst, f_cnt_t offset, f_cnt_t length )
 {
-	f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( pos < 0 ) { pos += m_size; }
+	f_cnt_t pos = ( m_position + offset ) % m_memory.frames;
+	if( pos < 0 ) { pos += m_memory.frames; }
 	
-	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + length <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [pos], length * sizeof( sampleFrame ) );
+		memcpy( dst, & m_memory.data [pos], length * sizeof( sampleFrame ) );
 	}
 	else
 	{
-		f_cnt_t first = m_size - pos;
+		f_cnt_t first = m_memory.frames - pos;
 		f_cnt_t second = length - first;
 		
-		memcpy( dst, & m_buffer [pos], first * sizeof( sampleFrame ) );
+		memcpy( dst, & m_memory.data [pos], first * sizeof( sampleFrame ) );
 		
-		memcpy( & dst [first], m_buffer, second * sizeof( sampleFrame ) );
+		memcpy( & dst [first], m_memory.data, second * sizeof( sampleFrame ) );
 	}
 }
 
@@ -194,21 +245,21 @@ void RingBuffer::read( sampleFrame * dst, float offset, f_cnt_t length )
 
 void RingBuffer::write( sampleFrame * src, f_cnt_t offset, f_cnt_t length )
 {
-	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	const f_cnt_t pos = ( m_position + offset ) % m_memory.frames;
+	if( length == 0 ) { length = framesPerPeriod(); }
 	
-	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + length <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( & m_buffer [pos], src, length * sizeof( sampleFrame ) );
+		memcpy( & m_memory.data [pos], src, length * sizeof( sampleFrame ) );
 	}
 	else
 	{
-		f_cnt_t first = m_size - pos;
+		f_cnt_t first = m_memory.frames - pos;
 		f_cnt_t second = length - first;
 
-		memcpy( & m_buffer [pos], src, first * sizeof( sampleFrame ) );
+		memcpy( & m_memory.data [pos], src, first * sizeof( sampleFrame ) );
 		
-		memcpy( m_buffer, & src [first], second * sizeof( sampleFrame ) );
+		memcpy( m_memory.data, & src [first], second * sizeof( sampleFrame ) );
 	}
 }
 
@@ -221,21 +272,21 @@ void RingBuffer::write( sampleFrame * src, float offset, f_cnt_t length )
 
 void RingBuffer::writeAdding( sampleFrame * src, f_cnt_t offset, f_cnt_t length )
 {
-	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	const f_cnt_t pos = ( m_position + offset ) % m_memory.frames;
+	if( length == 0 ) { length = framesPerPeriod(); }
 	
-	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + length <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		MixHelpers::add( & m_buffer [pos], src, length );
+		MixHelpers::add( & m_memory.data [pos], src, length );
 	}
 	else
 	{
-		f_cnt_t first = m_size - pos;
+		f_cnt_t first = m_memory.frames - pos;
 		f_cnt_t second = length - first;
 
-		MixHelpers::add( & m_buffer[pos], src, first );
+		MixHelpers::add( & m_memory.data[pos], src, first );
 		
-		MixHelpers::add( m_buffer, & src[first], second );
+		MixHelpers::add( m_memory.data, & src[first], second );
 	}
 }
 
@@ -248,22 +299,22 @@ void RingBuffer::writeAdding( sampleFrame * src, float offset, f_cnt_t length )
 
 void RingBuffer::writeAddingMultiplied( sampleFrame * src, f_cnt_t offset, f_cnt_t length, float level )
 {
-	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	//qDebug( "pos %d m_pos %d ofs %d siz %d", pos, m_position, offset, m_size );
-	if( length == 0 ) { length = m_fpp; }
+	const f_cnt_t pos = ( m_position + offset ) % m_memory.frames;
+	//qDebug( "pos %d m_pos %d ofs %d siz %d", pos, m_position, offset, m_memory.frames );
+	if( length == 0 ) { length = framesPerPeriod(); }
 	
-	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + length <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		MixHelpers::addMultiplied( & m_buffer[pos], src, level, length );
+		MixHelpers::addMultiplied( & m_memory.data[pos], src, level, length );
 	}
 	else
 	{
-		f_cnt_t first = m_size - pos;
+		f_cnt_t first = m_memory.frames - pos;
 		f_cnt_t second = length - first;
 
-		MixHelpers::addMultiplied( & m_buffer[pos], src, level, first );
+		MixHelpers::addMultiplied( & m_memory.data[pos], src, level, first );
 		
-		MixHelpers::addMultiplied( m_buffer, & src [first], level, second );
+		MixHelpers::addMultiplied( m_memory.data, & src [first], level, second );
 	}
 }
 
@@ -277,21 +328,21 @@ void RingBuffer::writeAddingMultiplied( sampleFrame * src, float offset, f_cnt_t
 
 void RingBuffer::writeSwappedAddingMultiplied( sampleFrame * src, f_cnt_t offset, f_cnt_t length, float level )
 {
-	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	const f_cnt_t pos = ( m_position + offset ) % m_memory.frames;
+	if( length == 0 ) { length = framesPerPeriod(); }
 	
-	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + length <= m_memory.frames ) // we won't go over the edge so we can just memcpy here
 	{
-		MixHelpers::addSwappedMultiplied( & m_buffer [pos], src, level, length );
+		MixHelpers::addSwappedMultiplied( & m_memory.data [pos], src, level, length );
 	}
 	else
 	{
-		f_cnt_t first = m_size - pos;
+		f_cnt_t first = m_memory.frames - pos;
 		f_cnt_t second = length - first;
 
-		MixHelpers::addSwappedMultiplied( & m_buffer [pos], src, level, first );
+		MixHelpers::addSwappedMultiplied( & m_memory.data [pos], src, level, first );
 		
-		MixHelpers::addSwappedMultiplied( m_buffer, & src [first], level, second );
+		MixHelpers::addSwappedMultiplied( m_memory.data, & src [first], level, second );
 	}
 }
 
@@ -304,12 +355,11 @@ void RingBuffer::writeSwappedAddingMultiplied( sampleFrame * src, float offset,
 
 void RingBuffer::updateSamplerate()
 {
-	float newsize = static_cast<float>( ( m_size - m_fpp ) * Engine::mixer()->processingSampleRate() ) / m_samplerate;
-	m_size = static_cast<f_cnt_t>( ceilf( newsize ) ) + m_fpp;
+	float newsize = static_cast<float>( ( m_memory.frames - m_fpp ) * Engine::mixer()->processingSampleRate() ) / m_samplerate;
 	m_samplerate = Engine::mixer()->processingSampleRate();
-	delete[] m_buffer;
-	m_buffer = new sampleFrame[ m_size ];
-	memset( m_buffer, 0, m_size * sizeof( sampleFrame ) );
+	DelayLinePool::release( m_memory );
+	m_memory.frames = static_cast<f_cnt_t>( ceilf( newsize ) ) + m_fpp;
+	m_memory.data = DelayLinePool::allocate( m_memory.frames );
 	m_position = 0;
 }
 
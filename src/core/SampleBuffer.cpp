@@ -25,12 +25,19 @@
 #include "SampleBuffer.h"
 
 #include <algorithm>
+#include <atomic>
+#include <set>
 
 #include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QMutex>
 #include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtEndian>
 
 
 #include <sndfile.h>
@@ -50,17 +57,214 @@
 
 
 #include "base64.h"
+#include "CompressedFrames.h"
 #include "ConfigManager.h"
+#include "DataFile.h"
 #include "DrumSynth.h"
-#include "endian_handling.h"
 #include "Engine.h"
 #include "GuiApplication.h"
 #include "Mixer.h"
 #include "PathUtil.h"
+#include "PerfLog.h"
+#include "SampleCache.h"
+#include "SampleOverview.h"
+#include "SampleStream.h"
+#include "SincResampler.h"
+#include "Song.h"
 
 #include "FileDialog.h"
 
 
+namespace
+{
+
+// the buffers setCompressionEnabled() (de)compresses
+QMutex compressibleMutex;
+std::set<SampleBuffer *> compressibleBuffers;
+std::atomic<bool> compressionOn(false);
+
+void registerCompressible(SampleBuffer * buffer, bool compressible)
+{
+	QMutexLocker lock(&compressibleMutex);
+	if (compressible)
+	{
+		compressibleBuffers.insert(buffer);
+	}
+	else
+	{
+		compressibleBuffers.erase(buffer);
+	}
+}
+
+// the buffers whose frames are still at a previous sample rate. The audio
+// thread mustn't post events, so play() only marks the ones it needs, and
+// the GUI thread polls them to start their conversions.
+QMutex staleRateMutex;
+std::set<SampleBuffer *> staleRateBuffers;
+// created by the first change of the rate, before any buffer is stale
+QTimer * staleRateTimer = nullptr;
+const int StaleRatePollInterval = 50;
+
+} // namespace
+
+
+
+
+struct SampleBuffer::RateConversion
+{
+	QMutex mutex;
+	// the buffer waiting for the frames, nullptr once it doesn't anymore
+	SampleBuffer * buffer;
+	QString file;
+	sample_rate_t sampleRate;
+	std::shared_ptr<sampleFrame> data;
+	f_cnt_t frames;
+} ;
+
+
+
+
+class SampleBuffer::RateConversionTask : public QRunnable
+{
+public:
+	RateConversionTask(const std::shared_ptr<RateConversion> & conversion) :
+		m_conversion(conversion)
+	{
+	}
+
+	void run() override
+	{
+		RateConversion & c = *m_conversion;
+		const QFileInfo fileInfo(c.file);
+		f_cnt_t frames = 0;
+		// decoding the file again is better than resampling the frames
+		std::shared_ptr<sampleFrame> data = SampleCache::find(fileInfo, c.sampleRate, frames);
+		if (data == nullptr)
+		{
+			bool tooLarge = false;
+			if (sampleFrame * decoded = decodeFile(c.file, c.sampleRate, frames, tooLarge))
+			{
+				data = SampleCache::insert(fileInfo, c.sampleRate, decoded, frames);
+			}
+		}
+
+		QMutexLocker lock(&c.mutex);
+		c.data = data;
+		c.frames = frames;
+		if (c.buffer != nullptr)
+		{
+			QMetaObject::invokeMethod(c.buffer, "applySampleRate", Qt::QueuedConnection);
+		}
+	}
+
+private:
+	std::shared_ptr<RateConversion> m_conversion;
+} ;
+
+
+namespace
+{
+
+// conversions may wait for the files prefetched on the global pool
+QThreadPool & rateConversionPool()
+{
+	static QThreadPool pool;
+	return pool;
+}
+
+
+class FunctionTask : public QRunnable
+{
+public:
+	FunctionTask(const std::function<void()> & function) :
+		m_function(function)
+	{
+	}
+
+	void run() override
+	{
+		m_function();
+	}
+
+private:
+	std::function<void()> m_function;
+} ;
+
+
+// the frames kept by preloadFiles()
+const std::size_t PreloadBytes = 128 << 20;
+
+struct PreloadedFile
+{
+	QString path;
+	sample_rate_t sampleRate;
+	std::shared_ptr<sampleFrame> data;
+	std::size_t bytes;
+} ;
+
+QMutex preloadMutex;
+// the files of the last request come first, in the order requested
+std::vector<PreloadedFile> preloadedFiles;
+QStringList preloadRequest;
+sample_rate_t preloadSampleRate = 0;
+// when it changes, the files of earlier requests aren't decoded anymore
+std::atomic<int> preloadGeneration(0);
+
+// the user browses one file at a time, so decoding them one at a time is
+// enough, and leaves the global pool to projects
+QThreadPool & preloadPool()
+{
+	static QThreadPool pool;
+	pool.setMaxThreadCount(1);
+	return pool;
+}
+
+bool isPreloaded(const QString & path, sample_rate_t sampleRate)
+{
+	return std::any_of(preloadedFiles.begin(), preloadedFiles.end(),
+		[&](const PreloadedFile & f) { return f.path == path && f.sampleRate == sampleRate; });
+}
+
+//! Orders the files by the last request and drops those which don't fit
+void trimPreloaded()
+{
+	const auto rank = [](const PreloadedFile & f)
+	{
+		const int i = f.sampleRate == preloadSampleRate ? preloadRequest.indexOf(f.path) : -1;
+		return i < 0 ? preloadRequest.size() : i;
+	};
+	std::stable_sort(preloadedFiles.begin(), preloadedFiles.end(),
+		[&](const PreloadedFile & a, const PreloadedFile & b) { return rank(a) < rank(b); });
+
+	std::size_t bytes = 0;
+	auto it = preloadedFiles.begin();
+	while (it != preloadedFiles.end() && bytes + it->bytes <= PreloadBytes)
+	{
+		bytes += it->bytes;
+		++it;
+	}
+	preloadedFiles.erase(it, preloadedFiles.end());
+}
+
+//! Converts frames between native and little endian, in which binary
+//! projects store all numbers
+void swapLittleEndian(void * frames, f_cnt_t count)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+	quint32 * words = static_cast<quint32 *>(frames);
+	for (f_cnt_t i = 0; i < count * DEFAULT_CHANNELS; ++i)
+	{
+		words[i] = qbswap(words[i]);
+	}
+#else
+	Q_UNUSED(frames)
+	Q_UNUSED(count)
+#endif
+}
+
+} // namespace
+
+
 SampleBuffer::SampleBuffer() :
 	m_audioFile(""),
 	m_origData(nullptr),
@@ -74,7 +278,11 @@ SampleBuffer::SampleBuffer() :
 	m_amplification(1.0f),
 	m_reversed(false),
 	m_frequency(BaseFreq),
-	m_sampleRate(mixerSampleRate())
+	m_sampleRate(mixerSampleRate()),
+	m_streamable(false),
+	m_streamingMinSeconds(StreamingMinSeconds),
+	m_compressible(false),
+	m_rateState(RateCurrent)
 {
 
 	connect(Engine::mixer(), SIGNAL(sampleRateChanged()), this, SLOT(sampleRateChanged()));
@@ -136,9 +344,16 @@ SampleBuffer::SampleBuffer(const SampleBuffer& orig)
 
 	m_audioFile = orig.m_audioFile;
 	m_origFrames = orig.m_origFrames;
-	m_origData = (m_origFrames > 0) ? MM_ALLOC(sampleFrame, m_origFrames) : nullptr;
+	m_origData = (orig.m_origData != nullptr && m_origFrames > 0)
+		? MM_ALLOC(sampleFrame, m_origFrames)
+		: nullptr;
 	m_frames = orig.m_frames;
-	m_data = (m_frames > 0) ? MM_ALLOC(sampleFrame, m_frames) : nullptr;
+	// frames from the cache are shared rather than copied
+	m_sharedData = orig.m_sharedData;
+	m_overview = orig.m_overview;
+	m_data = m_sharedData != nullptr
+		? m_sharedData.get()
+		: (orig.m_data != nullptr && m_frames > 0) ? MM_ALLOC(sampleFrame, m_frames) : nullptr;
 	m_startFrame = orig.m_startFrame;
 	m_endFrame = orig.m_endFrame;
 	m_loopStartFrame = orig.m_loopStartFrame;
@@ -147,13 +362,40 @@ SampleBuffer::SampleBuffer(const SampleBuffer& orig)
 	m_reversed = orig.m_reversed;
 	m_frequency = orig.m_frequency;
 	m_sampleRate = orig.m_sampleRate;
+	m_streamable = orig.m_streamable;
+	m_streamingMinSeconds = orig.m_streamingMinSeconds;
+	m_compressible = orig.m_compressible;
+	registerCompressible(this, m_compressible);
+	// a conversion of the original doesn't replace the frames of the copy
+	m_rateState.store(orig.m_rateState.load() == RateCurrent ? RateCurrent : RateChanged);
+	if (m_rateState.load() != RateCurrent) { registerStaleRate(true); }
+
+	if (orig.m_compressed != nullptr)
+	{
+		// the compressed blocks are shared as well
+		m_compressed.reset(orig.m_compressed->clone());
+	}
+
+	if (orig.m_stream != nullptr)
+	{
+		m_stream.reset(orig.m_stream->clone(overviewDone()));
+		if (m_stream == nullptr)
+		{
+			// the file can't be read anymore
+			m_data = MM_ALLOC(sampleFrame, 1);
+			memset(m_data, 0, sizeof(*m_data));
+			m_frames = 1;
+			m_loopStartFrame = m_startFrame = 0;
+			m_loopEndFrame = m_endFrame = 1;
+		}
+	}
 
 	//Deep copy m_origData and m_data from original
 	const auto origFrameBytes = m_origFrames * BYTES_PER_FRAME;
 	const auto frameBytes = m_frames * BYTES_PER_FRAME;
 	if (orig.m_origData != nullptr && origFrameBytes > 0)
 		{ memcpy(m_origData, orig.m_origData, origFrameBytes); }
-	if (orig.m_data != nullptr && frameBytes > 0)
+	if (orig.m_data != nullptr && m_data != nullptr && m_sharedData == nullptr && frameBytes > 0)
 		{ memcpy(m_data, orig.m_data, frameBytes); }
 
 	orig.m_varLock.unlock();
@@ -182,6 +424,8 @@ void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 	first.m_audioFile.swap(second.m_audioFile);
 	swap(first.m_origData, second.m_origData);
 	swap(first.m_data, second.m_data);
+	swap(first.m_sharedData, second.m_sharedData);
+	swap(first.m_overview, second.m_overview);
 	swap(first.m_origFrames, second.m_origFrames);
 	swap(first.m_frames, second.m_frames);
 	swap(first.m_startFrame, second.m_startFrame);
@@ -192,6 +436,25 @@ void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 	swap(first.m_frequency, second.m_frequency);
 	swap(first.m_reversed, second.m_reversed);
 	swap(first.m_sampleRate, second.m_sampleRate);
+	swap(first.m_stream, second.m_stream);
+	swap(first.m_streamable, second.m_streamable);
+	swap(first.m_streamingMinSeconds, second.m_streamingMinSeconds);
+	swap(first.m_compressed, second.m_compressed);
+	swap(first.m_compressible, second.m_compressible);
+	registerCompressible(&first, first.m_compressible);
+	registerCompressible(&second, second.m_compressible);
+	// running conversions belong to the frames they would replace
+	first.cancelRateConversion();
+	second.cancelRateConversion();
+	const int rateState = first.m_rateState.load();
+	first.m_rateState.store(second.m_rateState.load());
+	second.m_rateState.store(rateState);
+	if (first.m_rateState.load() != RateCurrent) { first.registerStaleRate(true); }
+	if (second.m_rateState.load() != RateCurrent) { second.registerStaleRate(true); }
+
+	// the streams redraw the buffer they belong to now
+	if (first.m_stream != nullptr) { first.m_stream->setOverviewDone(first.overviewDone()); }
+	if (second.m_stream != nullptr) { second.m_stream->setOverviewDone(second.overviewDone()); }
 
 	// Unlock again
 	first.m_varLock.unlock();
@@ -212,14 +475,36 @@ SampleBuffer& SampleBuffer::operator=(SampleBuffer that)
 
 SampleBuffer::~SampleBuffer()
 {
+	registerCompressible(this, false);
+	registerStaleRate(false);
+	cancelRateConversion();
 	MM_FREE(m_origData);
-	MM_FREE(m_data);
+	freeData();
 }
 
 
 
 void SampleBuffer::sampleRateChanged()
 {
+	// decoded files keep their frames for now, play() resamples them
+	// until they're converted, which is only done for buffers being played
+	if (!m_audioFile.isEmpty() && m_stream == nullptr &&
+		(m_data != nullptr || m_compressed != nullptr))
+	{
+		m_rateState.store(m_sampleRate == mixerSampleRate() ? RateCurrent : RateChanged);
+		if (m_rateState.load() != RateCurrent)
+		{
+			if (staleRateTimer == nullptr)
+			{
+				staleRateTimer = new QTimer;
+				staleRateTimer->setInterval(StaleRatePollInterval);
+				QObject::connect(staleRateTimer, &QTimer::timeout,
+					&SampleBuffer::startRequestedConversions);
+			}
+			registerStaleRate(true);
+		}
+		return;
+	}
 	update(true);
 }
 
@@ -229,19 +514,348 @@ sample_rate_t SampleBuffer::mixerSampleRate()
 }
 
 
+void SampleBuffer::registerStaleRate(bool stale)
+{
+	QMutexLocker lock(&staleRateMutex);
+	if (!stale)
+	{
+		staleRateBuffers.erase(this);
+		return;
+	}
+	staleRateBuffers.insert(this);
+	if (staleRateTimer != nullptr)
+	{
+		// buffers may be copied on other threads
+		QMetaObject::invokeMethod(staleRateTimer, "start", Qt::QueuedConnection);
+	}
+}
+
+
+void SampleBuffer::startRequestedConversions()
+{
+	// buffers can't be destroyed while this holds the lock
+	QMutexLocker lock(&staleRateMutex);
+	for (auto it = staleRateBuffers.begin(); it != staleRateBuffers.end();)
+	{
+		SampleBuffer * buffer = *it;
+		const int state = buffer->m_rateState.load();
+		if (state == RateCurrent)
+		{
+			it = staleRateBuffers.erase(it);
+			continue;
+		}
+		if (state == RateRequested)
+		{
+			buffer->convertSampleRate();
+		}
+		++it;
+	}
+	if (staleRateBuffers.empty())
+	{
+		staleRateTimer->stop();
+	}
+}
+
+
+void SampleBuffer::convertSampleRate()
+{
+	int requested = RateRequested;
+	if (m_rateConversion != nullptr ||
+		!m_rateState.compare_exchange_strong(requested, RateConverting))
+	{
+		return;
+	}
+
+	m_rateConversion = std::make_shared<RateConversion>();
+	m_rateConversion->buffer = this;
+	m_rateConversion->file = PathUtil::toAbsolute(m_audioFile);
+	m_rateConversion->sampleRate = mixerSampleRate();
+	m_rateConversion->frames = 0;
+	rateConversionPool().start(new RateConversionTask(m_rateConversion));
+}
+
+
+void SampleBuffer::applySampleRate()
+{
+	const std::shared_ptr<RateConversion> conversion = m_rateConversion;
+	if (conversion == nullptr)
+	{
+		return;
+	}
+	cancelRateConversion();
+
+	if (conversion->sampleRate != mixerSampleRate())
+	{
+		// the rate has changed again meanwhile
+		m_rateState.store(m_sampleRate == mixerSampleRate() ? RateCurrent : RateChanged);
+		return;
+	}
+	if (conversion->data == nullptr)
+	{
+		// the file can't be read anymore, so the frames stay resampled
+		m_rateState.store(RateCurrent);
+		return;
+	}
+
+	Engine::mixer()->requestChangeInModel();
+	m_varLock.lockForWrite();
+	freeData();
+	m_sharedData = conversion->data;
+	m_data = m_sharedData.get();
+	m_frames = conversion->frames;
+	// this only converts the frame-variables
+	normalizeSampleRate(mixerSampleRate(), true);
+	if (m_reversed) { reverseData(); }
+	compressData();
+	m_rateState.store(RateCurrent);
+	m_varLock.unlock();
+	Engine::mixer()->doneChangeInModel();
+
+	emit sampleUpdated();
+}
+
+
+void SampleBuffer::cancelRateConversion()
+{
+	if (m_rateConversion != nullptr)
+	{
+		QMutexLocker lock(&m_rateConversion->mutex);
+		m_rateConversion->buffer = nullptr;
+	}
+	m_rateConversion.reset();
+	int converting = RateConverting;
+	m_rateState.compare_exchange_strong(converting, RateChanged);
+}
+
+
+std::function<void()> SampleBuffer::overviewDone()
+{
+	// called from the reader thread of the stream
+	return [this]() { QMetaObject::invokeMethod(this, "sampleUpdated", Qt::QueuedConnection); };
+}
+
+
+void SampleBuffer::prefetch(f_cnt_t frame)
+{
+	if (m_stream != nullptr)
+	{
+		m_stream->prefetch(frame);
+	}
+	else if (m_compressed != nullptr)
+	{
+		m_compressed->prefetch(frame);
+	}
+}
+
+
+void SampleBuffer::setCompressible(bool compressible)
+{
+	registerCompressible(this, compressible);
+	m_compressible = compressible;
+	updateCompression();
+}
+
+
+void SampleBuffer::setCompressionEnabled(bool enabled)
+{
+	QMutexLocker lock(&compressibleMutex);
+	if (enabled == compressionOn)
+	{
+		return;
+	}
+	compressionOn = enabled;
+	for (SampleBuffer * buffer : compressibleBuffers)
+	{
+		buffer->updateCompression();
+	}
+}
+
+
+bool SampleBuffer::compressionEnabled()
+{
+	return compressionOn;
+}
+
+
+namespace
+{
+
+// File size and sample length limits
+const int fileSizeMax = 300; // MB
+const int sampleLengthMax = 90; // Minutes
+
+// DrumSynth keeps its state in globals
+QMutex drumSynthMutex;
+
+
+// Collects the frames of a file while a decoder produces them and stores
+// them in their final layout at the target rate. Decoders write up to as
+// many frames as chunk() allows and hand them over with commit(). If no
+// conversion is needed, chunk() points into the output itself.
+class DecodedFrames
+{
+public:
+	static const f_cnt_t ChunkFrames = 4096;
+
+	DecodedFrames(f_cnt_t expectedFrames, sample_rate_t srcSR, sample_rate_t dstSR) :
+		m_ratio(static_cast<double>(dstSR) / srcSR),
+		m_state(nullptr),
+		m_data(nullptr),
+		m_frames(0),
+		m_capacity(0)
+	{
+		if (srcSR != dstSR)
+		{
+			int error;
+			if ((m_state = src_new(SRC_SINC_MEDIUM_QUALITY, DEFAULT_CHANNELS, &error)) == nullptr)
+			{
+				printf("Error: src_new() failed in sample_buffer.cpp!\n");
+			}
+			else
+			{
+				m_chunk.resize(ChunkFrames);
+			}
+		}
+		reserve(static_cast<f_cnt_t>(std::ceil(std::max<f_cnt_t>(expectedFrames, 0) * m_ratio)) + 1);
+	}
+
+	~DecodedFrames()
+	{
+		if (m_state != nullptr)
+		{
+			src_delete(m_state);
+		}
+		MM_FREE(m_data);
+	}
+
+	sampleFrame * chunk(f_cnt_t & frames)
+	{
+		if (m_state != nullptr)
+		{
+			frames = ChunkFrames;
+			return m_chunk.data();
+		}
+		if (m_frames == m_capacity)
+		{
+			reserve(m_frames + ChunkFrames);
+		}
+		frames = m_capacity - m_frames;
+		if (frames > ChunkFrames)
+		{
+			frames = ChunkFrames;
+		}
+		return m_data + m_frames;
+	}
+
+	void commit(f_cnt_t frames)
+	{
+		if (m_state == nullptr)
+		{
+			m_frames += frames;
+			return;
+		}
+		convert(m_chunk.data(), frames, false);
+	}
+
+	//! Hands the frames over to the caller, who frees them with MM_FREE
+	sampleFrame * finish(f_cnt_t & frames)
+	{
+		if (m_state != nullptr)
+		{
+			convert(m_chunk.data(), 0, true);
+		}
+		frames = m_frames;
+		if (m_frames == 0)
+		{
+			return nullptr;
+		}
+		sampleFrame * data = m_data;
+		m_data = nullptr;
+		return data;
+	}
+
+private:
+	void reserve(f_cnt_t frames)
+	{
+		if (frames <= m_capacity)
+		{
+			return;
+		}
+		// the expected length is only an estimate for some formats
+		const f_cnt_t capacity = std::max(frames, m_capacity + m_capacity / 2);
+		sampleFrame * data = MM_ALLOC(sampleFrame, capacity);
+		if (m_data != nullptr)
+		{
+			memcpy(data, m_data, m_frames * BYTES_PER_FRAME);
+			MM_FREE(m_data);
+		}
+		m_data = data;
+		m_capacity = capacity;
+	}
+
+	void convert(const sampleFrame * in, f_cnt_t frames, bool last)
+	{
+		SRC_DATA srcData;
+		srcData.src_ratio = m_ratio;
+		srcData.end_of_input = last ? 1 : 0;
+		srcData.data_in = in->data();
+		srcData.input_frames = frames;
+		while (true)
+		{
+			if (m_frames == m_capacity)
+			{
+				reserve(m_frames + ChunkFrames);
+			}
+			srcData.data_out = m_data[m_frames].data();
+			srcData.output_frames = m_capacity - m_frames;
+			int error;
+			if ((error = src_process(m_state, &srcData)))
+			{
+				printf("SampleBuffer: error while resampling: %s\n", src_strerror(error));
+				return;
+			}
+			m_frames += srcData.output_frames_gen;
+			srcData.data_in += srcData.input_frames_used * DEFAULT_CHANNELS;
+			srcData.input_frames -= srcData.input_frames_used;
+			// at the end, keep going until the converter is drained
+			if ((srcData.output_frames_gen == 0 && srcData.input_frames_used == 0)
+				|| (!last && srcData.input_frames == 0))
+			{
+				return;
+			}
+		}
+	}
+
+	const double m_ratio;
+	SRC_STATE * m_state;
+	std::vector<sampleFrame> m_chunk;
+	sampleFrame * m_data;
+	f_cnt_t m_frames;
+	f_cnt_t m_capacity;
+} ;
+
+} // namespace
+
+
 void SampleBuffer::update(bool keepSettings)
 {
-	const bool lock = (m_data != nullptr);
+	const bool lock = (m_data != nullptr || m_stream != nullptr || m_compressed != nullptr);
 	if (lock)
 	{
 		Engine::mixer()->requestChangeInModel();
 		m_varLock.lockForWrite();
-		MM_FREE(m_data);
+		if (m_compressed != nullptr && m_origData == nullptr && m_origFrames > 0)
+		{
+			// the original frames are needed to copy them again
+			m_origData = MM_ALLOC(sampleFrame, m_origFrames);
+			m_compressed->decode(0, m_origFrames, m_origData);
+		}
+		freeData();
+		m_stream.reset();
 	}
-
-	// File size and sample length limits
-	const int fileSizeMax = 300; // MB
-	const int sampleLengthMax = 90; // Minutes
+	// the frames are loaded at the mixer rate
+	cancelRateConversion();
+	m_rateState.store(RateCurrent);
 
 	bool fileLoadError = false;
 	if (m_audioFile.isEmpty() && m_origData != nullptr && m_origFrames > 0)
@@ -260,65 +874,39 @@ void SampleBuffer::update(bool keepSettings)
 	else if (!m_audioFile.isEmpty())
 	{
 		QString file = PathUtil::toAbsolute(m_audioFile);
-		int_sample_t * buf = nullptr;
-		sample_t * fbuf = nullptr;
-		ch_cnt_t channels = DEFAULT_CHANNELS;
-		sample_rate_t samplerate = mixerSampleRate();
 		m_frames = 0;
 
-		const QFileInfo fileInfo(file);
-		if (fileInfo.size() > fileSizeMax * 1024 * 1024)
+		if (m_streamable)
 		{
-			fileLoadError = true;
+			m_stream.reset(SampleStream::open(file, m_streamingMinSeconds, overviewDone()));
 		}
-		else
+
+		const QFileInfo fileInfo(file);
+		if (m_stream != nullptr)
 		{
-			// Use QFile to handle unicode file names on Windows
-			QFile f(file);
-			SNDFILE * sndFile;
-			SF_INFO sfInfo;
-			sfInfo.format = 0;
-			if (f.open(QIODevice::ReadOnly) && (sndFile = sf_open_fd(f.handle(), SFM_READ, &sfInfo, false)))
+			// streamed files are played at their own sample rate and
+			// aren't limited, as they aren't loaded to memory
+			m_frames = m_stream->frames();
+			m_sampleRate = m_stream->sampleRate();
+			m_stream->setReversed(m_reversed);
+			if (keepSettings == false)
 			{
-				f_cnt_t frames = sfInfo.frames;
-				int rate = sfInfo.samplerate;
-				if (frames / rate > sampleLengthMax * 60)
-				{
-					fileLoadError = true;
-				}
-				sf_close(sndFile);
+				m_loopStartFrame = m_startFrame = 0;
+				m_loopEndFrame = m_endFrame = m_frames;
 			}
-			f.close();
 		}
-
-		if (!fileLoadError)
+		else if ((m_sharedData = SampleCache::find(fileInfo, mixerSampleRate(), m_frames)) != nullptr)
 		{
-#ifdef LMMS_HAVE_OGGVORBIS
-			// workaround for a bug in libsndfile or our libsndfile decoder
-			// causing some OGG files to be distorted -> try with OGG Vorbis
-			// decoder first if filename extension matches "ogg"
-			if (m_frames == 0 && fileInfo.suffix() == "ogg")
-			{
-				m_frames = decodeSampleOGGVorbis(file, buf, channels, samplerate);
-			}
-#endif
-			if (m_frames == 0)
-			{
-				m_frames = decodeSampleSF(file, fbuf, channels, samplerate);
-			}
-#ifdef LMMS_HAVE_OGGVORBIS
-			if (m_frames == 0)
-			{
-				m_frames = decodeSampleOGGVorbis(file, buf, channels, samplerate);
-			}
-#endif
-			if (m_frames == 0)
-			{
-				m_frames = decodeSampleDS(file, buf, channels, samplerate);
-			}
+			// another buffer has decoded the file already
+			m_data = m_sharedData.get();
+		}
+		else if ((m_data = decodeFile(file, mixerSampleRate(), m_frames, fileLoadError)) != nullptr)
+		{
+			// let other buffers of the file use the decoded frames
+			m_sharedData = SampleCache::insert(fileInfo, mixerSampleRate(), m_data, m_frames);
 		}
 
-		if (m_frames == 0 || fileLoadError)  // if still no frames, bail
+		if (m_data == nullptr && m_stream == nullptr)  // if still no frames, bail
 		{
 			// sample couldn't be decoded, create buffer containing
 			// one sample-frame
@@ -328,9 +916,13 @@ void SampleBuffer::update(bool keepSettings)
 			m_loopStartFrame = m_startFrame = 0;
 			m_loopEndFrame = m_endFrame = 1;
 		}
-		else // otherwise normalize sample rate
+		else if (m_stream == nullptr)
 		{
-			normalizeSampleRate(samplerate, keepSettings);
+			// the frames are at the mixer rate already, this only
+			// updates the frame-variables
+			normalizeSampleRate(mixerSampleRate(), keepSettings);
+			// the cache keeps the frames in the order of the file
+			if (m_reversed) { reverseData(); }
 		}
 	}
 	else
@@ -344,6 +936,8 @@ void SampleBuffer::update(bool keepSettings)
 		m_loopEndFrame = m_endFrame = 1;
 	}
 
+	compressData();
+
 	if (lock)
 	{
 		m_varLock.unlock();
@@ -371,51 +965,273 @@ void SampleBuffer::update(bool keepSettings)
 }
 
 
-void SampleBuffer::convertIntToFloat(
-	int_sample_t * & ibuf,
-	f_cnt_t frames,
-	int channels
-)
+void SampleBuffer::freeData()
 {
-	// following code transforms int-samples into float-samples and does amplifying & reversing
-	const float fac = 1 / OUTPUT_SAMPLE_MULTIPLIER;
-	m_data = MM_ALLOC(sampleFrame, frames);
-	const int ch = (channels > 1) ? 1 : 0;
+	if (m_sharedData == nullptr)
+	{
+		MM_FREE(m_data);
+	}
+	m_sharedData.reset();
+	m_overview.reset();
+	m_compressed.reset();
+	m_data = nullptr;
+}
 
-	// if reversing is on, we also reverse when scaling
-	bool isReversed = m_reversed;
-	int idx = isReversed ? (frames - 1) * channels : 0;
-	for (f_cnt_t frame = 0; frame < frames; ++frame)
+
+void SampleBuffer::reverseData()
+{
+	if (m_sharedData == nullptr)
 	{
-		m_data[frame][0] = ibuf[idx+0] * fac;
-		m_data[frame][1] = ibuf[idx+ch] * fac;
-		idx += isReversed ? -channels : channels;
+		std::reverse(m_data, m_data + m_frames);
+		m_overview.reset();
+		return;
 	}
 
-	delete[] ibuf;
+	// leave the frames of the cache as they are
+	sampleFrame * data = MM_ALLOC(sampleFrame, m_frames);
+	for (f_cnt_t frame = 0; frame < m_frames; ++frame)
+	{
+		data[frame][0] = m_data[m_frames - 1 - frame][0];
+		data[frame][1] = m_data[m_frames - 1 - frame][1];
+	}
+	m_sharedData.reset();
+	m_data = data;
+	// the overview isn't mirrored
+	m_overview.reset();
 }
 
-void SampleBuffer::directFloatWrite(
-	sample_t * & fbuf,
-	f_cnt_t frames,
-	int channels
+
+void SampleBuffer::compressData()
+{
+	if (!m_compressible || !compressionOn || m_data == nullptr ||
+		m_compressed != nullptr ||
+		m_frames < CompressionMinSeconds * static_cast<f_cnt_t>(m_sampleRate))
+	{
+		return;
+	}
+
+	std::unique_ptr<CompressedFrames> compressed(
+		CompressedFrames::compress(m_data, m_frames, m_startFrame));
+	if (compressed == nullptr)
+	{
+		return;
+	}
+
+	// drawing the buffer zoomed out doesn't need the frames then
+	std::shared_ptr<const SampleOverview> overview = m_overview;
+	if (overview == nullptr)
+	{
+		overview = m_sharedData != nullptr
+			? SampleCache::overview(m_sharedData, m_frames)
+			: std::make_shared<SampleOverview>(m_data, m_frames);
+	}
+
+	// the original frames are a copy of m_data unless they have been
+	// reversed, they are decompressed again when they are needed
+	if (m_audioFile.isEmpty() && m_origData != nullptr &&
+		m_origFrames == m_frames && !m_reversed)
+	{
+		MM_FREE(m_origData);
+		m_origData = nullptr;
+	}
+
+	freeData();
+	m_compressed = std::move(compressed);
+	m_overview = overview;
+}
+
+
+void SampleBuffer::decompressData()
+{
+	if (m_compressed == nullptr)
+	{
+		return;
+	}
+
+	sampleFrame * data = MM_ALLOC(sampleFrame, m_frames);
+	m_compressed->decode(0, m_frames, data);
+	if (m_origData == nullptr && m_origFrames > 0)
+	{
+		m_origData = MM_ALLOC(sampleFrame, m_origFrames);
+		memcpy(m_origData, data, m_origFrames * BYTES_PER_FRAME);
+	}
+
+	std::shared_ptr<const SampleOverview> overview = m_overview;
+	freeData();
+	m_data = data;
+	m_overview = overview;
+}
+
+
+void SampleBuffer::updateCompression()
+{
+	const bool compress = m_compressible && compressionOn;
+	if (compress == (m_compressed != nullptr) || (compress && m_data == nullptr))
+	{
+		return;
+	}
+
+	Engine::mixer()->requestChangeInModel();
+	m_varLock.lockForWrite();
+	if (compress)
+	{
+		compressData();
+	}
+	else
+	{
+		decompressData();
+	}
+	m_varLock.unlock();
+	Engine::mixer()->doneChangeInModel();
+}
+
+
+sampleFrame * SampleBuffer::decodeFile(
+	const QString & file,
+	sample_rate_t sampleRate,
+	f_cnt_t & frames,
+	bool & tooLarge
 )
 {
+	PerfTimeline::Phase phase("Decode sample", PerfTrace::Sample);
+	sampleFrame * data = nullptr;
+	frames = 0;
+
+	const QFileInfo fileInfo(file);
+	if (fileInfo.size() > fileSizeMax * 1024 * 1024)
+	{
+		tooLarge = true;
+		return nullptr;
+	}
+
+	// Use QFile to handle unicode file names on Windows
+	QFile f(file);
+	SNDFILE * sndFile;
+	SF_INFO sfInfo;
+	sfInfo.format = 0;
+	if (f.open(QIODevice::ReadOnly) && (sndFile = sf_open_fd(f.handle(), SFM_READ, &sfInfo, false)))
+	{
+		const sf_count_t fileFrames = sfInfo.frames;
+		int rate = sfInfo.samplerate;
+		if (fileFrames / rate > sampleLengthMax * 60)
+		{
+			tooLarge = true;
+		}
+		sf_close(sndFile);
+	}
+	f.close();
+	if (tooLarge)
+	{
+		return nullptr;
+	}
+
+#ifdef LMMS_HAVE_OGGVORBIS
+	// workaround for a bug in libsndfile or our libsndfile decoder
+	// causing some OGG files to be distorted -> try with OGG Vorbis
+	// decoder first if filename extension matches "ogg"
+	if (frames == 0 && fileInfo.suffix() == "ogg")
+	{
+		frames = decodeSampleOGGVorbis(file, sampleRate, data);
+	}
+#endif
+	if (frames == 0)
+	{
+		frames = decodeSampleSF(file, sampleRate, data);
+	}
+#ifdef LMMS_HAVE_OGGVORBIS
+	if (frames == 0)
+	{
+		frames = decodeSampleOGGVorbis(file, sampleRate, data);
+	}
+#endif
+	if (frames == 0)
+	{
+		QMutexLocker lock(&drumSynthMutex);
+		frames = decodeSampleDS(file, sampleRate, data);
+	}
+
+	if (frames == 0 || data == nullptr)
+	{
+		MM_FREE(data);
+		frames = 0;
+		return nullptr;
+	}
+	return data;
+}
+
+
+void SampleBuffer::prefetchFiles(const QStringList & files, bool streamable)
+{
+	const sample_rate_t sampleRate = mixerSampleRate();
+	for (const QString & file : files)
+	{
+		const QString absolute = PathUtil::toAbsolute(file);
+		if (streamable && SampleStream::canStream(absolute, StreamingMinSeconds))
+		{
+			continue;
+		}
+		SampleCache::prefetch(QFileInfo(absolute), sampleRate,
+			[absolute, sampleRate](f_cnt_t & frames)
+			{
+				bool tooLarge = false;
+				return decodeFile(absolute, sampleRate, frames, tooLarge);
+			});
+	}
+}
 
-	m_data = MM_ALLOC(sampleFrame, frames);
-	const int ch = (channels > 1) ? 1 : 0;
 
-	// if reversing is on, we also reverse when scaling
-	bool isReversed = m_reversed;
-	int idx = isReversed ? (frames - 1) * channels : 0;
-	for (f_cnt_t frame = 0; frame < frames; ++frame)
+void SampleBuffer::preloadFiles(const QStringList & files)
+{
+	const sample_rate_t sampleRate = mixerSampleRate();
+	const int generation = ++preloadGeneration;
+
+	QStringList absolute;
+	for (const QString & file : files)
 	{
-		m_data[frame][0] = fbuf[idx+0];
-		m_data[frame][1] = fbuf[idx+ch];
-		idx += isReversed ? -channels : channels;
+		absolute << PathUtil::toAbsolute(file);
 	}
+	{
+		QMutexLocker lock(&preloadMutex);
+		preloadRequest = absolute;
+		preloadSampleRate = sampleRate;
+		trimPreloaded();
+	}
+
+	for (const QString & file : absolute)
+	{
+		preloadPool().start(new FunctionTask([file, sampleRate, generation]()
+		{
+			{
+				QMutexLocker lock(&preloadMutex);
+				if (preloadGeneration.load() != generation || isPreloaded(file, sampleRate))
+				{
+					return;
+				}
+			}
+			if (SampleStream::canStream(file, PreviewStreamingSeconds))
+			{
+				return;
+			}
+
+			const QFileInfo fileInfo(file);
+			f_cnt_t frames = 0;
+			std::shared_ptr<sampleFrame> data = SampleCache::find(fileInfo, sampleRate, frames);
+			if (data == nullptr)
+			{
+				bool tooLarge = false;
+				if (sampleFrame * decoded = decodeFile(file, sampleRate, frames, tooLarge))
+				{
+					data = SampleCache::insert(fileInfo, sampleRate, decoded, frames);
+				}
+			}
+			if (data == nullptr) { return; }
 
-	delete[] fbuf;
+			QMutexLocker lock(&preloadMutex);
+			preloadedFiles.push_back(PreloadedFile{file, sampleRate, data,
+				static_cast<std::size_t>(frames) * BYTES_PER_FRAME});
+			trimPreloaded();
+		}));
+	}
 }
 
 
@@ -425,18 +1241,21 @@ void SampleBuffer::normalizeSampleRate(const sample_rate_t srcSR, bool keepSetti
 	// do samplerate-conversion to our default-samplerate
 	if (srcSR != mixerSampleRate())
 	{
-		SampleBuffer * resampled = resample(srcSR, mixerSampleRate());
+		f_cnt_t frames = 0;
+		sampleFrame * resampled = resampleFrames(m_data, m_frames, srcSR,
+			mixerSampleRate(), frames);
 
 		m_sampleRate = mixerSampleRate();
-		MM_FREE(m_data);
-		m_frames = resampled->frames();
-		m_data = MM_ALLOC(sampleFrame, m_frames);
-		memcpy(m_data, resampled->data(), m_frames * sizeof(sampleFrame));
-		delete resampled;
+		freeData();
+		m_data = resampled;
+		m_frames = frames;
 	}
 
 	if (keepSettings == false)
 	{
+		// the data is played at the mixer rate now, which may not
+		// have been the rate of the previous sample
+		m_sampleRate = mixerSampleRate();
 		// update frame-variables
 		m_loopStartFrame = m_startFrame = 0;
 		m_loopEndFrame = m_endFrame = m_frames;
@@ -458,38 +1277,50 @@ void SampleBuffer::normalizeSampleRate(const sample_rate_t srcSR, bool keepSetti
 
 f_cnt_t SampleBuffer::decodeSampleSF(
 	QString fileName,
-	sample_t * & buf,
-	ch_cnt_t & channels,
-	sample_rate_t & samplerate
+	sample_rate_t sampleRate,
+	sampleFrame * & data
 )
 {
 	SNDFILE * sndFile;
 	SF_INFO sfInfo;
 	sfInfo.format = 0;
 	f_cnt_t frames = 0;
-	sf_count_t sfFramesRead;
-
 
 	// Use QFile to handle unicode file names on Windows
 	QFile f(fileName);
 	if (f.open(QIODevice::ReadOnly) && (sndFile = sf_open_fd(f.handle(), SFM_READ, &sfInfo, false)))
 	{
-		frames = sfInfo.frames;
+		DecodedFrames decoded(sfInfo.frames, sfInfo.samplerate, sampleRate);
+		const int channels = sfInfo.channels;
+		const int ch = (channels > 1) ? 1 : 0;
+		std::vector<sample_t> buf(DecodedFrames::ChunkFrames * channels);
 
-		buf = new sample_t[sfInfo.channels * frames];
-		sfFramesRead = sf_read_float(sndFile, buf, sfInfo.channels * frames);
+		f_cnt_t chunkFrames;
+		sampleFrame * chunk;
+		sf_count_t sfFramesRead;
+		while ((chunk = decoded.chunk(chunkFrames)),
+			(sfFramesRead = sf_readf_float(sndFile, buf.data(), chunkFrames)) > 0)
+		{
+			int idx = 0;
+			for (sf_count_t frame = 0; frame < sfFramesRead; ++frame)
+			{
+				chunk[frame][0] = buf[idx+0];
+				chunk[frame][1] = buf[idx+ch];
+				idx += channels;
+			}
+			decoded.commit(sfFramesRead);
+		}
 
-		if (sfFramesRead < sfInfo.channels * frames)
+		if (sf_error(sndFile) != SF_ERR_NO_ERROR)
 		{
 #ifdef DEBUG_LMMS
 			qDebug("SampleBuffer::decodeSampleSF(): could not read"
-				" sample %s: %s", fileName, sf_strerror(nullptr));
+				" sample %s: %s", fileName, sf_strerror(sndFile));
 #endif
 		}
-		channels = sfInfo.channels;
-		samplerate = sfInfo.samplerate;
-
 		sf_close(sndFile);
+
+		data = decoded.finish(frames);
 	}
 	else
 	{
@@ -500,13 +1331,6 @@ f_cnt_t SampleBuffer::decodeSampleSF(
 	}
 	f.close();
 
-	//write down either directly or convert i->f depending on file type
-
-	if (frames > 0 && buf != nullptr)
-	{
-		directFloatWrite(buf, frames, channels);
-	}
-
 	return frames;
 }
 
@@ -568,7 +1392,8 @@ f_cnt_t SampleBuffer::decodeSampleOGGVorbis(
 	QString fileName,
 	int_sample_t * & buf,
 	ch_cnt_t & channels,
-	sample_rate_t & samplerate
+	sample_rate_t & samplerate,
+	sampleFrame * & data
 )
 {
 	static ov_callbacks callbacks =
@@ -621,70 +1446,346 @@ f_cnt_t SampleBuffer::decodeSampleOGGVorbis(
 		return 0;
 	}
 
-	ov_pcm_seek(&vf, 0);
+	ov_pcm_seek(&vf, 0);
+
+	const int channels = ov_info(&vf, -1)->channels;
+	DecodedFrames decoded(ov_pcm_total(&vf, -1), ov_info(&vf, -1)->rate, sampleRate);
+
+	int bitstream = 0;
+	long framesRead = 0;
+
+	do
+	{
+		f_cnt_t chunkFrames;
+		sampleFrame * chunk = decoded.chunk(chunkFrames);
+		float ** pcm;
+		framesRead = ov_read_float(&vf, &pcm, chunkFrames, &bitstream);
+
+		if (framesRead < 0)
+		{
+			break;
+		}
+
+		const float * left = pcm[0];
+		const float * right = pcm[(channels > 1) ? 1 : 0];
+		for (long frame = 0; frame < framesRead; ++frame)
+		{
+			chunk[frame][0] = left[frame];
+			chunk[frame][1] = right[frame];
+		}
+		decoded.commit(framesRead);
+	}
+	while (framesRead != 0 && bitstream == 0);
+
+	ov_clear(&vf);
+
+	data = decoded.finish(frames);
+	return frames;
+}
+#endif
+
+
+
+
+f_cnt_t SampleBuffer::decodeSampleDS(
+	QString fileName,
+	sample_rate_t sampleRate,
+	sampleFrame * & data
+)
+{
+	DrumSynth ds;
+	int_sample_t * buf = nullptr;
+	ch_cnt_t channels = DEFAULT_CHANNELS;
+	sample_rate_t samplerate = sampleRate;
+	f_cnt_t frames = ds.GetDSFileSamples(fileName, buf, channels, samplerate);
+
+	if (frames > 0 && buf != nullptr)
+	{
+		// DrumSynth renders 16 bit samples at the requested rate
+		const float fac = 1 / OUTPUT_SAMPLE_MULTIPLIER;
+		const int ch = (channels > 1) ? 1 : 0;
+		DecodedFrames decoded(frames, samplerate, sampleRate);
+
+		int idx = 0;
+		for (f_cnt_t first = 0; first < frames;)
+		{
+			f_cnt_t count;
+			sampleFrame * chunk = decoded.chunk(count);
+			count = std::min(frames - first, count);
+			for (f_cnt_t frame = 0; frame < count; ++frame)
+			{
+				chunk[frame][0] = buf[idx+0] * fac;
+				chunk[frame][1] = buf[idx+ch] * fac;
+				idx += channels;
+			}
+			decoded.commit(count);
+			first += count;
+		}
+		data = decoded.finish(frames);
+	}
+	delete[] buf;
+
+	return frames;
+}
+
+
+
+
+namespace
+{
+
+// The frames of a sample as SampleBuffer::play() reads them, with the loop
+// unrolled: indices past the loop end continue at the loop start, or run
+// back and forth through the loop for ping-pong. This lets the resampler
+// read across loop boundaries without copying.
+class PlaybackSource
+{
+public:
+	PlaybackSource(const sampleFrame * data, f_cnt_t frames,
+		SampleBuffer::LoopMode loopMode, f_cnt_t loopStart, f_cnt_t loopEnd,
+		f_cnt_t end) :
+		m_data(data),
+		m_loopMode(loopMode),
+		m_loopStart(loopStart),
+		m_loopEnd(loopEnd),
+		m_loopLength(loopEnd - loopStart)
+	{
+		if (m_loopMode != SampleBuffer::LoopOff &&
+			(m_loopLength <= 0 || loopStart < 0 || loopEnd > frames))
+		{
+			m_loopMode = SampleBuffer::LoopOff;
+		}
+		m_end = qMin(m_loopMode == SampleBuffer::LoopOff ? end : loopEnd, frames);
+	}
+
+	//! The data index of an unrolled index, and whether ping-pong plays it
+	//! backwards
+	f_cnt_t resolve(f_cnt_t index, bool * backwards = nullptr) const
+	{
+		if (index < m_loopEnd || m_loopMode == SampleBuffer::LoopOff)
+		{
+			return index;
+		}
+		if (m_loopMode == SampleBuffer::LoopOn)
+		{
+			return m_loopStart + (index - m_loopEnd) % m_loopLength;
+		}
+		const f_cnt_t pos = (index - m_loopEnd) % (2 * m_loopLength);
+		if (pos < m_loopLength)
+		{
+			if (backwards) { *backwards = true; }
+			return m_loopEnd - 1 - pos;
+		}
+		return m_loopStart + pos - m_loopLength;
+	}
+
+	//! The unrolled index of a data index
+	f_cnt_t unroll(f_cnt_t index, bool backwards) const
+	{
+		if (m_loopMode == SampleBuffer::LoopPingPong && backwards &&
+			index >= m_loopStart && index < m_loopEnd)
+		{
+			return 2 * m_loopEnd - 1 - index;
+		}
+		return index;
+	}
+
+	//! Moves an unrolled position back into the first pass of the loop,
+	//! keeping the frames before it the same
+	double fold(double position) const
+	{
+		if (m_loopMode == SampleBuffer::LoopOff)
+		{
+			return position;
+		}
+		const double period = m_loopMode == SampleBuffer::LoopOn
+			? m_loopLength
+			: 2.0 * m_loopLength;
+		if (position < m_loopEnd + period)
+		{
+			return position;
+		}
+		return position - std::floor((position - m_loopEnd) / period) * period;
+	}
+
+	f_cnt_t loopStart() const
+	{
+		return m_loopStart;
+	}
+
+	//! The end of the frames which are played, the loop end if looped
+	f_cnt_t end() const
+	{
+		return m_end;
+	}
+
+	const sampleFrame * direct(f_cnt_t first, f_cnt_t last) const
+	{
+		return first >= 0 && last < m_end ? m_data + first : nullptr;
+	}
+
+	const sampleFrame & at(f_cnt_t index) const
+	{
+		static const sampleFrame silence = { 0.0f, 0.0f };
+		if (index < 0)
+		{
+			return silence;
+		}
+		const f_cnt_t i = resolve(index);
+		return i < m_end ? m_data[i] : silence;
+	}
+
+private:
+	const sampleFrame * m_data;
+	SampleBuffer::LoopMode m_loopMode;
+	f_cnt_t m_loopStart;
+	f_cnt_t m_loopEnd;
+	f_cnt_t m_loopLength;
+	f_cnt_t m_end;
+} ;
+
+
+
+
+// The frames a streamed or compressed sample has been read to for (a part
+// of) one call of SampleBuffer::play(), starting at first. The sample is
+// silent from end on.
+class FrameWindow
+{
+public:
+	FrameWindow(const sampleFrame * data, f_cnt_t first, f_cnt_t frames,
+		f_cnt_t end) :
+		m_data(data),
+		m_first(first),
+		m_end(qMin(first + frames, end))
+	{
+	}
+
+	const sampleFrame * direct(f_cnt_t first, f_cnt_t last) const
+	{
+		return first >= m_first && last < m_end ? m_data + first - m_first : nullptr;
+	}
+
+	const sampleFrame & at(f_cnt_t index) const
+	{
+		static const sampleFrame silence = { 0.0f, 0.0f };
+		return index >= m_first && index < m_end ? m_data[index - m_first] : silence;
+	}
 
-	channels = ov_info(&vf, -1)->channels;
-	samplerate = ov_info(&vf, -1)->rate;
+private:
+	const sampleFrame * m_data;
+	f_cnt_t m_first;
+	f_cnt_t m_end;
+} ;
 
-	ogg_int64_t total = ov_pcm_total(&vf, -1);
 
-	buf = new int_sample_t[total * channels];
-	int bitstream = 0;
-	long bytesRead = 0;
 
-	do
-	{
-		bytesRead = ov_read(&vf,
-				(char *) &buf[frames * channels],
-				(total - frames) * channels * BYTES_PER_INT_SAMPLE,
-				isLittleEndian() ? 0 : 1,
-				BYTES_PER_INT_SAMPLE,
-				1,
-				&bitstream
-		);
 
-		if (bytesRead < 0)
-		{
-			break;
-		}
-		frames += bytesRead / (channels * BYTES_PER_INT_SAMPLE);
-	}
-	while (bytesRead != 0 && bitstream == 0);
+// the frames play() reads from a stream or compressed frames at once, enough
+// for the largest period a few octaves up
+const f_cnt_t WindowFrames = 8 * DEFAULT_BUFFER_SIZE;
 
-	ov_clear(&vf);
 
-	// if buffer isn't empty, convert it to float and write it down
-	if (frames > 0 && buf != nullptr)
+
+
+// Copies the frames [first, first + count) of the unrolled loop of source to
+// dst, reading them from compressed, which waits for its blocks if wait is set
+void readUnrolled(const PlaybackSource & source, CompressedFrames & compressed,
+	f_cnt_t first, f_cnt_t count, sampleFrame * dst, bool wait)
+{
+	f_cnt_t done = 0;
+	while (done < count)
 	{
-		convertIntToFloat(buf, frames, channels);
+		const f_cnt_t index = first + done;
+		bool backwards = false;
+		const f_cnt_t frame = index < 0 ? -1 : source.resolve(index, &backwards);
+		if (frame < 0 || frame >= source.end())
+		{
+			// before the sample, or after its end if it isn't looped
+			const f_cnt_t todo = index < 0 ? std::min(count - done, -index) : count - done;
+			memset(dst + done, 0, todo * BYTES_PER_FRAME);
+			done += todo;
+		}
+		else if (backwards)
+		{
+			// ping-pong plays the frames down to the loop start
+			const f_cnt_t todo = std::min(count - done, frame - source.loopStart() + 1);
+			compressed.read(frame - todo + 1, todo, dst + done, wait);
+			std::reverse(dst + done, dst + done + todo);
+			done += todo;
+		}
+		else
+		{
+			const f_cnt_t todo = std::min(count - done, source.end() - frame);
+			compressed.read(frame, todo, dst + done, wait);
+			done += todo;
+		}
 	}
 
-	return frames;
+	// looped samples continue at their loop start
+	compressed.prefetch(source.resolve(first + count + CompressedFrames::BlockFrames));
 }
-#endif
 
 
 
 
-f_cnt_t SampleBuffer::decodeSampleDS(
-	QString fileName,
-	int_sample_t * & buf,
-	ch_cnt_t & channels,
-	sample_rate_t & samplerate
-)
+// multiplies the frames by gain, unless it's 1
+inline void amplify(sampleFrame * ab, fpp_t frames, float gain)
 {
-	DrumSynth ds;
-	f_cnt_t frames = ds.GetDSFileSamples(fileName, buf, channels, samplerate);
-
-	if (frames > 0 && buf != nullptr)
+	if (gain == 1.0f)
 	{
-		convertIntToFloat(buf, frames, channels);
+		return;
 	}
+	for (fpp_t i = 0; i < frames; ++i)
+	{
+		ab[i][0] *= gain;
+		ab[i][1] *= gain;
+	}
+}
+
 
-	return frames;
 
+
+template<class Source>
+void render(const Source & source, double position, double freqFactor,
+	const SincResampler * resampler, float gain, sampleFrame * ab, fpp_t frames)
+{
+	if (resampler == nullptr)
+	{
+		// we don't have to pitch, so we just copy the sample data, which
+		// is amplified on the way
+		const f_cnt_t first = static_cast<f_cnt_t>(position);
+		const sampleFrame * direct = source.direct(first, first + frames - 1);
+		if (direct != nullptr && gain == 1.0f)
+		{
+			memcpy(ab, direct, frames * BYTES_PER_FRAME);
+		}
+		else if (direct != nullptr)
+		{
+			for (fpp_t i = 0; i < frames; ++i)
+			{
+				ab[i][0] = direct[i][0] * gain;
+				ab[i][1] = direct[i][1] * gain;
+			}
+		}
+		else
+		{
+			for (fpp_t i = 0; i < frames; ++i)
+			{
+				ab[i][0] = source.at(first + i)[0] * gain;
+				ab[i][1] = source.at(first + i)[1] * gain;
+			}
+		}
+	}
+	else
+	{
+		resampler->resample(source, position, freqFactor, ab, frames);
+		amplify(ab, frames, gain);
+	}
 }
 
+} // namespace
+
 
 
 
@@ -706,9 +1807,6 @@ bool SampleBuffer::play(
 		return false;
 	}
 
-	// variable for determining if we should currently be playing backwards in a ping-pong loop
-	bool isBackwards = state->isBackwards();
-
 	const double freqFactor = (double) freq / (double) m_frequency *
 		m_sampleRate / Engine::mixer()->processingSampleRate();
 
@@ -722,279 +1820,120 @@ bool SampleBuffer::play(
 		return false;
 	}
 
-
-	// this holds the index of the first frame to play
-	f_cnt_t playFrame = qMax(state->m_frameIndex, startFrame);
-
-	if (loopMode == LoopOff)
+	// after a change of the sample rate, the frames are resampled on the
+	// fly until they're converted
+	int rateChanged = RateChanged;
+	if (m_rateState.load(std::memory_order_relaxed) == RateChanged)
 	{
-		if (playFrame >= endFrame || (endFrame - playFrame) / freqFactor == 0)
-		{
-			// the sample is done being played
-			return false;
-		}
-	}
-	else if (loopMode == LoopOn)
-	{
-		playFrame = getLoopedIndex(playFrame, loopStartFrame, loopEndFrame);
+		m_rateState.compare_exchange_strong(rateChanged, RateRequested);
 	}
-	else
-	{
-		playFrame = getPingPongIndex(playFrame, loopStartFrame, loopEndFrame);
-	}
-
-	f_cnt_t fragmentSize = (f_cnt_t)(frames * freqFactor) + MARGIN[state->interpolationMode()];
 
-	sampleFrame * tmp = nullptr;
+	// streams are only played without loops, the window can't follow them
+	const LoopMode playLoopMode = m_stream != nullptr ? LoopOff : loopMode;
+	const PlaybackSource source(m_data, m_frames, playLoopMode, loopStartFrame,
+		loopEndFrame, endFrame);
 
-	// check whether we have to change pitch...
-	if (freqFactor != 1.0 || state->m_varyingPitch)
-	{
-		SRC_DATA srcData;
-		// Generate output
-		srcData.data_in =
-			getSampleFragment(playFrame, fragmentSize, loopMode, &tmp, &isBackwards,
-			loopStartFrame, loopEndFrame, endFrame )->data();
-		srcData.data_out = ab->data();
-		srcData.input_frames = fragmentSize;
-		srcData.output_frames = frames;
-		srcData.src_ratio = 1.0 / freqFactor;
-		srcData.end_of_input = 0;
-		int error = src_process(state->m_resamplingData, &srcData);
-		if (error)
-		{
-			printf("SampleBuffer: error while resampling: %s\n",
-							src_strerror(error));
-		}
-		if (srcData.output_frames_gen > frames)
-		{
-			printf("SampleBuffer: not enough frames: %ld / %d\n",
-					srcData.output_frames_gen, frames);
-		}
-		// Advance
-		switch (loopMode)
-		{
-			case LoopOff:
-				playFrame += srcData.input_frames_used;
-				break;
-			case LoopOn:
-				playFrame += srcData.input_frames_used;
-				playFrame = getLoopedIndex(playFrame, loopStartFrame, loopEndFrame);
-				break;
-			case LoopPingPong:
-			{
-				f_cnt_t left = srcData.input_frames_used;
-				if (state->isBackwards())
-				{
-					playFrame -= srcData.input_frames_used;
-					if (playFrame < loopStartFrame)
-					{
-						left -= (loopStartFrame - playFrame);
-						playFrame = loopStartFrame;
-					}
-					else left = 0;
-				}
-				playFrame += left;
-				playFrame = getPingPongIndex(playFrame, loopStartFrame, loopEndFrame);
-				break;
-			}
-		}
-	}
-	else
+	// the frames may have been converted to another rate since the last
+	// call, which moves the position of the handle along with them
+	if (state->m_sampleRate != m_sampleRate)
 	{
-		// we don't have to pitch, so we just copy the sample-data
-		// as is into pitched-copy-buffer
-
-		// Generate output
-		memcpy(ab,
-			getSampleFragment(playFrame, frames, loopMode, &tmp, &isBackwards,
-				loopStartFrame, loopEndFrame, endFrame),
-			frames * BYTES_PER_FRAME);
-		// Advance
-		switch (loopMode)
+		if (state->m_sampleRate != 0)
 		{
-			case LoopOff:
-				playFrame += frames;
-				break;
-			case LoopOn:
-				playFrame += frames;
-				playFrame = getLoopedIndex(playFrame, loopStartFrame, loopEndFrame);
-				break;
-			case LoopPingPong:
-			{
-				f_cnt_t left = frames;
-				if (state->isBackwards())
-				{
-					playFrame -= frames;
-					if (playFrame < loopStartFrame)
-					{
-						left -= (loopStartFrame - playFrame);
-						playFrame = loopStartFrame;
-					}
-					else left = 0;
-				}
-				playFrame += left;
-				playFrame = getPingPongIndex(playFrame, loopStartFrame, loopEndFrame);
-				break;
-			}
+			state->m_frameIndex = static_cast<f_cnt_t>(static_cast<double>(
+				state->m_frameIndex) * m_sampleRate / state->m_sampleRate);
+			state->m_positionValid = false;
 		}
+		state->m_sampleRate = m_sampleRate;
 	}
 
-	if (tmp != nullptr)
+	// the exact position is kept between calls, so the resampler sees the
+	// loop as one continuous signal - it is only derived from the frame
+	// index again if that has been changed from outside
+	if (!state->m_positionValid || state->m_positionLoopMode != playLoopMode)
 	{
-		MM_FREE(tmp);
+		state->m_position = source.unroll(
+			qMax(state->m_frameIndex, startFrame), state->m_isBackwards);
 	}
+	double position = state->m_position;
 
-	state->setBackwards(isBackwards);
-	state->setFrameIndex(playFrame);
-
-	for (fpp_t i = 0; i < frames; ++i)
+	if (playLoopMode == LoopOff && position >= endFrame)
 	{
-		ab[i][0] *= m_amplification;
-		ab[i][1] *= m_amplification;
+		// the sample is done being played
+		return false;
 	}
 
-	return true;
-}
-
-
-
-
-sampleFrame * SampleBuffer::getSampleFragment(
-	f_cnt_t index,
-	f_cnt_t frames,
-	LoopMode loopMode,
-	sampleFrame * * tmp,
-	bool * backwards,
-	f_cnt_t loopStart,
-	f_cnt_t loopEnd,
-	f_cnt_t end
-) const
-{
-	if (loopMode == LoopOff)
-	{
-		if (index + frames <= end)
-		{
-			return m_data + index;
-		}
-	}
-	else if (loopMode == LoopOn)
-	{
-		if (index + frames <= loopEnd)
-		{
-			return m_data + index;
-		}
-	}
-	else
+	// check whether we have to change pitch...
+	const SincResampler * resampler = nullptr;
+	if (freqFactor != 1.0 || state->m_varyingPitch ||
+		position != std::floor(position))
 	{
-		if (!*backwards && index + frames < loopEnd)
-		{
-			return m_data + index;
-		}
+		resampler = &SincResampler::get(SincResampler::qualityOfConverter(
+			state->interpolationMode()));
 	}
 
-	*tmp = MM_ALLOC(sampleFrame, frames);
-
-	if (loopMode == LoopOff)
-	{
-		f_cnt_t available = end - index;
-		memcpy(*tmp, m_data + index, available * BYTES_PER_FRAME);
-		memset(*tmp + available, 0, (frames - available) * BYTES_PER_FRAME);
-	}
-	else if (loopMode == LoopOn)
+	if (m_stream != nullptr || m_compressed != nullptr)
 	{
-		f_cnt_t copied = qMin(frames, loopEnd - index);
-		memcpy(*tmp, m_data + index, copied * BYTES_PER_FRAME);
-		f_cnt_t loopFrames = loopEnd - loopStart;
-		while (copied < frames)
+		// the frames are read into a window on the stack, in parts of the
+		// period if it can't hold the frames the whole period needs
+		sampleFrame window[WindowFrames];
+		const f_cnt_t reach = resampler != nullptr ? resampler->reach(freqFactor) : 0;
+		const fpp_t part = static_cast<fpp_t>(qBound(1.0,
+			(WindowFrames - 2 * reach - 2) / qMax(freqFactor, 1.0), double(frames)));
+		// an export can't skip the frames which aren't loaded yet
+		const bool wait = Engine::getSong()->isExporting();
+		if (m_compressed != nullptr)
 		{
-			f_cnt_t todo = qMin(frames - copied, loopFrames);
-			memcpy(*tmp + copied, m_data + loopStart, todo * BYTES_PER_FRAME);
-			copied += todo;
+			// notes mostly start at the start frame, so it's kept
+			// decompressed
+			m_compressed->setHead(startFrame);
 		}
-	}
-	else
-	{
-		f_cnt_t pos = index;
-		bool currentBackwards = pos < loopStart
-			? false
-			: *backwards;
-		f_cnt_t copied = 0;
 
-
-		if (currentBackwards)
+		for (fpp_t done = 0; done < frames; done += part)
 		{
-			copied = qMin(frames, pos - loopStart);
-			for (int i = 0; i < copied; i++)
+			const fpp_t todo = qMin<fpp_t>(part, frames - done);
+			const double partPosition = position + done * freqFactor;
+			// read the frames the resampler needs around the played ones
+			const f_cnt_t first = static_cast<f_cnt_t>(std::floor(partPosition)) - reach;
+			const f_cnt_t last = static_cast<f_cnt_t>(
+				std::floor(partPosition + todo * freqFactor)) + reach;
+			const f_cnt_t count = last - first + 1;
+			if (count > WindowFrames)
 			{
-				(*tmp)[i][0] = m_data[pos - i][0];
-				(*tmp)[i][1] = m_data[pos - i][1];
+				// pitched up by more than the window can follow
+				memset(ab + done, 0, todo * BYTES_PER_FRAME);
+				continue;
 			}
-			pos -= copied;
-			if (pos == loopStart) { currentBackwards = false; }
-		}
-		else
-		{
-			copied = qMin(frames, loopEnd - pos);
-			memcpy(*tmp, m_data + pos, copied * BYTES_PER_FRAME);
-			pos += copied;
-			if (pos == loopEnd) { currentBackwards = true; }
-		}
-
-		while (copied < frames)
-		{
-			if (currentBackwards)
+			if (m_stream != nullptr)
 			{
-				f_cnt_t todo = qMin(frames - copied, pos - loopStart);
-				for (int i = 0; i < todo; i++)
-				{
-					(*tmp)[copied + i][0] = m_data[pos - i][0];
-					(*tmp)[copied + i][1] = m_data[pos - i][1];
-				}
-				pos -= todo;
-				copied += todo;
-				if (pos <= loopStart) { currentBackwards = false; }
+				m_stream->read(first, count, window, wait);
+				render(FrameWindow(window, first, count, endFrame), partPosition,
+					freqFactor, resampler, m_amplification, ab + done, todo);
 			}
 			else
 			{
-				f_cnt_t todo = qMin(frames - copied, loopEnd - pos);
-				memcpy(*tmp + copied, m_data + pos, todo * BYTES_PER_FRAME);
-				pos += todo;
-				copied += todo;
-				if (pos >= loopEnd) { currentBackwards = true; }
+				readUnrolled(source, *m_compressed, first, count, window, wait);
+				render(FrameWindow(window, first, count, first + count), partPosition,
+					freqFactor, resampler, m_amplification, ab + done, todo);
 			}
 		}
-		*backwards = currentBackwards;
 	}
-
-	return *tmp;
-}
-
-
-
-
-f_cnt_t SampleBuffer::getLoopedIndex(f_cnt_t index, f_cnt_t startf, f_cnt_t endf) const
-{
-	if (index < endf)
+	else
 	{
-		return index;
+		render(source, position, freqFactor, resampler, m_amplification, ab, frames);
 	}
-	return startf + (index - startf) % (endf - startf);
-}
 
+	// Advance
+	position = source.fold(position + frames * freqFactor);
 
-f_cnt_t SampleBuffer::getPingPongIndex(f_cnt_t index, f_cnt_t startf, f_cnt_t endf) const
-{
-	if (index < endf)
-	{
-		return index;
-	}
-	const f_cnt_t loopLen = endf - startf;
-	const f_cnt_t loopPos = (index - endf) % (loopLen * 2);
+	bool isBackwards = false;
+	state->m_frameIndex = source.resolve(
+		static_cast<f_cnt_t>(position), &isBackwards);
+	state->m_isBackwards = isBackwards;
+	state->m_position = position;
+	state->m_positionValid = true;
+	state->m_positionLoopMode = playLoopMode;
 
-	return (loopPos < loopLen)
-		? endf - loopPos
-		: startf + (loopPos - loopLen);
+	return true;
 }
 
 
@@ -1015,6 +1954,12 @@ void SampleBuffer::visualize(
 {
 	if (m_frames == 0) { return; }
 
+	if (m_stream != nullptr)
+	{
+		visualizeStream(p, dr, fromFrame, toFrame);
+		return;
+	}
+
 	const bool focusOnRange = toFrame <= m_frames && 0 <= fromFrame && fromFrame < toFrame;
 	//TODO: If the clip QRect is not being used we should remove it
 	//p.setClipRect(clip);
@@ -1050,6 +1995,28 @@ void SampleBuffer::visualize(
 		? fromFrame + visibleFrames - 1
 		: visibleFrames - 1;
 
+	// when zoomed out, the frames of a pixel are summarized by the
+	// overview rather than read
+	const bool useOverview = fpp >= SampleOverview::BaseFrames;
+	if (useOverview && m_overview == nullptr)
+	{
+		m_overview = m_sharedData != nullptr
+			? SampleCache::overview(m_sharedData, m_frames)
+			: std::make_shared<SampleOverview>(m_data, m_frames);
+	}
+
+	// compressed frames are only decompressed for the drawn range
+	const sampleFrame * data = m_data;
+	std::vector<sampleFrame> decoded;
+	int offset = 0;
+	if (!useOverview && m_compressed != nullptr)
+	{
+		decoded.resize(last - first + 1);
+		m_compressed->decode(first, last - first + 1, decoded.data());
+		data = decoded.data();
+		offset = first;
+	}
+
 	for (double frame = first; frame <= last && frame <= lastVisibleFrame; frame += fpp)
 	{
 		float maxData = -1;
@@ -1057,17 +2024,29 @@ void SampleBuffer::visualize(
 
 		float rmsData[2] = {0, 0};
 
-		// Find maximum and minimum samples within range
-		for (int i = 0; i < fpp && frame + i <= last; ++i)
+		if (useOverview)
+		{
+			const SampleOverview::Point point = m_overview->summarize(
+				static_cast<f_cnt_t>(frame),
+				std::min<f_cnt_t>(static_cast<f_cnt_t>(frame + fpp), last + 1), fpp);
+			maxData = point.max;
+			minData = point.min;
+			rmsData[0] = rmsData[1] = point.meanSquare * fpp;
+		}
+		else
 		{
-			for (int j = 0; j < 2; ++j)
+			// Find maximum and minimum samples within range
+			for (int i = 0; i < fpp && frame + i <= last; ++i)
 			{
-				auto curData = m_data[static_cast<int>(frame) + i][j];
+				for (int j = 0; j < 2; ++j)
+				{
+					auto curData = data[static_cast<int>(frame) + i - offset][j];
 
-				if (curData > maxData) { maxData = curData; }
-				if (curData < minData) { minData = curData; }
+					if (curData > maxData) { maxData = curData; }
+					if (curData < minData) { minData = curData; }
 
-				rmsData[j] += curData * curData;
+					rmsData[j] += curData * curData;
+				}
 			}
 		}
 
@@ -1107,6 +2086,115 @@ void SampleBuffer::visualize(
 
 
 
+// Draws a streamed buffer like visualize(), from the overview of its file
+void SampleBuffer::visualizeStream(
+	QPainter & p,
+	const QRect & dr,
+	f_cnt_t fromFrame,
+	f_cnt_t toFrame
+)
+{
+	const bool focusOnRange = toFrame <= m_frames && 0 <= fromFrame && fromFrame < toFrame;
+	const int w = dr.width();
+	if (w <= 0) { return; }
+
+	const int yb = dr.height() / 2 + dr.y();
+	const float py = dr.height() * 0.5f * m_amplification;
+	const f_cnt_t first = focusOnRange ? fromFrame : 0;
+	const f_cnt_t nbFrames = focusOnRange ? toFrame - fromFrame : m_frames;
+	const double fpp = static_cast<double>(nbFrames) / w;
+	// what isn't scanned yet stays empty
+	const int ready = m_stream->overviewPoints();
+
+	std::vector<QLineF> edges;
+	std::vector<QLineF> rms;
+	edges.reserve(w);
+	rms.reserve(w);
+	for (int x = 0; x < w; ++x)
+	{
+		f_cnt_t begin = first + static_cast<f_cnt_t>(x * fpp);
+		f_cnt_t end = qMax(begin + 1, first + static_cast<f_cnt_t>((x + 1) * fpp));
+		if (m_reversed)
+		{
+			// the overview is in the order of the file
+			const f_cnt_t b = begin;
+			begin = m_frames - end;
+			end = m_frames - b;
+		}
+		const int firstPoint = begin / SampleStream::OverviewFrames;
+		const int lastPoint = qMin<int>(ready - 1, (end - 1) / SampleStream::OverviewFrames);
+		if (lastPoint < firstPoint) { continue; }
+
+		float maxData = -1;
+		float minData = 1;
+		float meanSquare = 0;
+		for (int i = firstPoint; i <= lastPoint; ++i)
+		{
+			const SampleStream::OverviewPoint & point = m_stream->overviewPoint(i);
+			maxData = qMax(maxData, point.max);
+			minData = qMin(minData, point.min);
+			meanSquare += point.meanSquare;
+		}
+		const float sqrtRmsData = sqrt(meanSquare / (lastPoint - firstPoint + 1));
+		const float maxRmsData = qBound(minData, sqrtRmsData, maxData);
+		const float minRmsData = qBound(minData, -sqrtRmsData, maxData);
+
+		const qreal px = dr.x() + x;
+		edges.emplace_back(px, yb - maxData * py, px, yb - minData * py);
+		rms.emplace_back(px, yb - maxRmsData * py, px, yb - minRmsData * py);
+	}
+
+	p.drawLines(edges.data(), static_cast<int>(edges.size()));
+	p.setPen(p.pen().color().lighter(123));
+	p.drawLines(rms.data(), static_cast<int>(rms.size()));
+}
+
+
+
+
+qint64 SampleBuffer::memoryUsage() const
+{
+	QReadLocker locker(&m_varLock);
+	qint64 bytes = 0;
+	if (m_origData != nullptr)
+	{
+		bytes += static_cast<qint64>(m_origFrames) * BYTES_PER_FRAME;
+	}
+	if (m_sharedData != nullptr)
+	{
+		bytes += static_cast<qint64>(m_frames) * BYTES_PER_FRAME
+			/ std::max<long>(m_sharedData.use_count(), 1);
+	}
+	else if (m_data != nullptr && m_data != m_origData)
+	{
+		// streams and failed loads keep a single silent frame
+		bytes += static_cast<qint64>(m_stream != nullptr ? 1 : m_frames) * BYTES_PER_FRAME;
+	}
+	if (m_compressed != nullptr)
+	{
+		bytes += m_compressed->memoryUsage();
+	}
+	if (m_stream != nullptr)
+	{
+		bytes += m_stream->memoryUsage();
+	}
+	return bytes;
+}
+
+
+
+
+qint64 SampleBuffer::overviewMemoryUsage() const
+{
+	QReadLocker locker(&m_varLock);
+	return m_overview != nullptr
+		? m_overview->memoryUsage() / std::max<long>(m_overview.use_count(), 1)
+		: 0;
+}
+
+
+
+
 QString SampleBuffer::openAudioFile() const
 {
 	FileDialog ofd(nullptr, tr("Open audio file"));
@@ -1250,6 +2338,19 @@ void flacStreamEncoderMetadataCallback(
 
 QString & SampleBuffer::toBase64(QString & dst) const
 {
+	// compressed buffers are decompressed for saving
+	const sampleFrame * data = m_data;
+	std::vector<sampleFrame> decoded;
+	if (m_compressed != nullptr)
+	{
+		decoded.resize(m_frames);
+		m_compressed->decode(0, m_frames, decoded.data());
+		data = decoded.data();
+	}
+
+	// streamed buffers are always saved as their file
+	if (data == nullptr) { return dst; }
+
 #ifdef LMMS_HAVE_FLAC_STREAM_ENCODER_H
 	const f_cnt_t FRAMES_PER_BUF = 1152;
 
@@ -1286,7 +2387,7 @@ QString & SampleBuffer::toBase64(QString & dst) const
 			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
 			{
 				buf[f*DEFAULT_CHANNELS+ch] = (FLAC__int32)(
-					Mixer::clip(m_data[f+frameCnt][ch]) *
+					Mixer::clip(data[f+frameCnt][ch]) *
 						OUTPUT_SAMPLE_MULTIPLIER);
 			}
 		}
@@ -1302,7 +2403,7 @@ QString & SampleBuffer::toBase64(QString & dst) const
 
 #else	/* LMMS_HAVE_FLAC_STREAM_ENCODER_H */
 
-	base64::encode((const char *) m_data,
+	base64::encode((const char *) data,
 		m_frames * sizeof(sampleFrame), dst);
 
 #endif	/* LMMS_HAVE_FLAC_STREAM_ENCODER_H */
@@ -1313,13 +2414,86 @@ QString & SampleBuffer::toBase64(QString & dst) const
 
 
 
+void SampleBuffer::saveEmbedded(QDomElement & element, const QString & attribute) const
+{
+	DataFile * dataFile = DataFile::owner(element);
+	if (dataFile == nullptr || !dataFile->storesBinary())
+	{
+		QString s;
+		element.setAttribute(attribute, toBase64(s));
+		return;
+	}
+
+	// the frames are stored as little endian floats, so loading them is a
+	// single copy on most machines
+	QByteArray frames(m_frames * BYTES_PER_FRAME, Qt::Uninitialized);
+	if (m_compressed != nullptr)
+	{
+		m_compressed->decode(0, m_frames, reinterpret_cast<sampleFrame *>(frames.data()));
+	}
+	else if (m_data != nullptr)
+	{
+		memcpy(frames.data(), m_data, frames.size());
+	}
+	else
+	{
+		// streamed buffers are always saved as their file
+		return;
+	}
+	swapLittleEndian(frames.data(), m_frames);
+	element.setAttribute(attribute + "chunk", dataFile->addBinary(frames));
+}
+
+
+
+
+bool SampleBuffer::loadEmbedded(const QDomElement & element, const QString & attribute)
+{
+	const QString chunkAttribute = attribute + "chunk";
+	const DataFile * dataFile = DataFile::owner(element);
+	if (element.hasAttribute(chunkAttribute) && dataFile != nullptr)
+	{
+		const QByteArray frames = dataFile->binary(element.attribute(chunkAttribute).toInt());
+		if (frames.size() < BYTES_PER_FRAME) { return false; }
+
+		m_origFrames = frames.size() / BYTES_PER_FRAME;
+		MM_FREE(m_origData);
+		m_origData = MM_ALLOC(sampleFrame, m_origFrames);
+		memcpy(m_origData, frames.constData(), m_origFrames * BYTES_PER_FRAME);
+		swapLittleEndian(m_origData, m_origFrames);
+		m_audioFile = QString();
+		update();
+		return true;
+	}
+	if (!element.attribute(attribute).isEmpty())
+	{
+		loadFromBase64(element.attribute(attribute));
+		return true;
+	}
+	return false;
+}
+
+
+
+
 SampleBuffer * SampleBuffer::resample(const sample_rate_t srcSR, const sample_rate_t dstSR )
 {
-	sampleFrame * data = m_data;
-	const f_cnt_t frames = m_frames;
-	const f_cnt_t dstFrames = static_cast<f_cnt_t>((frames / (float) srcSR) * (float) dstSR);
-	SampleBuffer * dstSB = new SampleBuffer(dstFrames);
-	sampleFrame * dstBuf = dstSB->m_origData;
+	f_cnt_t dstFrames = 0;
+	sampleFrame * dstBuf = resampleFrames(m_data, m_frames, srcSR, dstSR, dstFrames);
+	SampleBuffer * dstSB = new SampleBuffer(dstBuf, dstFrames);
+	MM_FREE(dstBuf);
+	return dstSB;
+}
+
+
+
+
+sampleFrame * SampleBuffer::resampleFrames(const sampleFrame * data,
+	f_cnt_t frames, sample_rate_t srcSR, sample_rate_t dstSR, f_cnt_t & dstFrames)
+{
+	dstFrames = static_cast<f_cnt_t>((frames / (float) srcSR) * (float) dstSR);
+	sampleFrame * dstBuf = MM_ALLOC(sampleFrame, dstFrames);
+	memset(dstBuf, 0, dstFrames * BYTES_PER_FRAME);
 
 	// yeah, libsamplerate, let's rock with sinc-interpolation!
 	int error;
@@ -1343,8 +2517,7 @@ SampleBuffer * SampleBuffer::resample(const sample_rate_t srcSR, const sample_ra
 	{
 		printf("Error: src_new() failed in sample_buffer.cpp!\n");
 	}
-	dstSB->update();
-	return dstSB;
+	return dstBuf;
 }
 
 
@@ -1543,8 +2716,14 @@ void SampleBuffer::setReversed(bool on)
 {
 	Engine::mixer()->requestChangeInModel();
 	m_varLock.lockForWrite();
-	if (m_reversed != on) { std::reverse(m_data, m_data + m_frames); }
+	if (m_stream != nullptr) { m_stream->setReversed(on); }
+	else if (m_reversed != on)
+	{
+		decompressData();
+		reverseData();
+	}
 	m_reversed = on;
+	compressData();
 	m_varLock.unlock();
 	Engine::mixer()->doneChangeInModel();
 	emit sampleUpdated();
@@ -1557,15 +2736,13 @@ void SampleBuffer::setReversed(bool on)
 SampleBuffer::handleState::handleState(bool varyingPitch, int interpolationMode) :
 	m_frameIndex(0),
 	m_varyingPitch(varyingPitch),
-	m_isBackwards(false)
+	m_isBackwards(false),
+	m_interpolationMode(interpolationMode),
+	m_position(0.0),
+	m_positionValid(false),
+	m_positionLoopMode(LoopOff),
+	m_sampleRate(0)
 {
-	int error;
-	m_interpolationMode = interpolationMode;
-
-	if ((m_resamplingData = src_new(interpolationMode, DEFAULT_CHANNELS, &error)) == nullptr)
-	{
-		qDebug("Error: src_new() failed in sample_buffer.cpp!\n");
-	}
 }
 
 
@@ -1573,5 +2750,4 @@ SampleBuffer::handleState::handleState(bool varyingPitch, int interpolationMode)
 
 SampleBuffer::handleState::~handleState()
 {
-	src_delete(m_resamplingData);
 }
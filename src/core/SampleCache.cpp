@@ -0,0 +1,249 @@
+/*
+ * SampleCache.cpp - decoded samples shared by all sample buffers
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleCache.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include <algorithm>
+#include <tuple>
+
+#include "MemoryManager.h"
+#include "SampleOverview.h"
+
+
+QMutex SampleCache::s_mutex;
+QWaitCondition SampleCache::s_prefetched;
+std::map<SampleCache::Key, SampleCache::Entry> SampleCache::s_samples;
+
+
+
+
+class SampleCache::PrefetchTask : public QRunnable
+{
+public:
+	PrefetchTask(const Key & key, const Decoder & decode) :
+		m_key(key),
+		m_decode(decode)
+	{
+	}
+
+	void run() override
+	{
+		f_cnt_t frames = 0;
+		sampleFrame * data = m_decode(frames);
+
+		QMutexLocker lock(&s_mutex);
+		const auto it = s_samples.find(m_key);
+		if (it != s_samples.end() && it->second.pending)
+		{
+			if (data != nullptr && it->second.keepPrefetched)
+			{
+				it->second.prefetched = share(data);
+				it->second.data = it->second.prefetched;
+				it->second.frames = frames;
+				it->second.pending = false;
+				data = nullptr;
+			}
+			else
+			{
+				// the buffers decode the file themselves, and report
+				// why that failed
+				s_samples.erase(it);
+			}
+		}
+		MM_FREE(data);
+		s_prefetched.wakeAll();
+	}
+
+private:
+	Key m_key;
+	Decoder m_decode;
+} ;
+
+
+
+
+bool SampleCache::Key::operator<(const Key & other) const
+{
+	return std::tie(path, size, modified, sampleRate) <
+		std::tie(other.path, other.size, other.modified, other.sampleRate);
+}
+
+
+
+
+SampleCache::Key SampleCache::key(const QFileInfo & file, sample_rate_t sampleRate)
+{
+	// resolve links and relative parts, so all paths of a file match
+	const QString canonical = file.canonicalFilePath();
+	return Key{canonical.isEmpty() ? file.absoluteFilePath() : canonical,
+		file.size(), file.lastModified().toMSecsSinceEpoch(), sampleRate};
+}
+
+
+
+
+std::shared_ptr<sampleFrame> SampleCache::share(sampleFrame * data)
+{
+	return std::shared_ptr<sampleFrame>(data, [](sampleFrame * d) { MM_FREE(d); });
+}
+
+
+
+
+std::shared_ptr<sampleFrame> SampleCache::find(const QFileInfo & file,
+	sample_rate_t sampleRate, f_cnt_t & frames)
+{
+	QMutexLocker lock(&s_mutex);
+	const Key k = key(file, sampleRate);
+	auto it = s_samples.find(k);
+	while (it != s_samples.end() && it->second.pending)
+	{
+		s_prefetched.wait(&s_mutex);
+		it = s_samples.find(k);
+	}
+	if (it == s_samples.end())
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<sampleFrame> data = it->second.data.lock();
+	if (data == nullptr)
+	{
+		// the last buffer using the frames is gone
+		s_samples.erase(it);
+		return nullptr;
+	}
+	// the buffer keeps the frames now
+	it->second.prefetched.reset();
+	frames = it->second.frames;
+	return data;
+}
+
+
+
+
+std::shared_ptr<sampleFrame> SampleCache::insert(const QFileInfo & file,
+	sample_rate_t sampleRate, sampleFrame * data, f_cnt_t frames)
+{
+	std::shared_ptr<sampleFrame> shared = share(data);
+
+	QMutexLocker lock(&s_mutex);
+	// drop the files no buffer uses anymore
+	for (auto it = s_samples.begin(); it != s_samples.end();)
+	{
+		it = !it->second.pending && it->second.data.expired()
+			? s_samples.erase(it)
+			: std::next(it);
+	}
+	s_samples[key(file, sampleRate)] = Entry{shared, frames, nullptr, false, false, {}};
+	return shared;
+}
+
+
+
+
+void SampleCache::prefetch(const QFileInfo & file, sample_rate_t sampleRate,
+	const Decoder & decode)
+{
+	QMutexLocker lock(&s_mutex);
+	const Key k = key(file, sampleRate);
+	const auto it = s_samples.find(k);
+	if (it != s_samples.end() && (it->second.pending || !it->second.data.expired()))
+	{
+		return;
+	}
+	s_samples[k] = Entry{std::weak_ptr<sampleFrame>(), 0, nullptr, true, true, {}};
+	QThreadPool::globalInstance()->start(new PrefetchTask(k, decode));
+}
+
+
+
+
+std::shared_ptr<const SampleOverview> SampleCache::overview(
+	const std::shared_ptr<sampleFrame> & data, f_cnt_t frames)
+{
+	const auto findEntry = [&data]()
+	{
+		return std::find_if(s_samples.begin(), s_samples.end(),
+			[&data](const std::pair<const Key, Entry> & e)
+			{
+				return !e.second.data.owner_before(data) && !data.owner_before(e.second.data);
+			});
+	};
+
+	{
+		QMutexLocker lock(&s_mutex);
+		const auto it = findEntry();
+		if (it != s_samples.end())
+		{
+			if (std::shared_ptr<const SampleOverview> overview = it->second.overview.lock())
+			{
+				return overview;
+			}
+		}
+	}
+
+	// built without the lock, so finding other files doesn't wait for it
+	std::shared_ptr<const SampleOverview> overview =
+		std::make_shared<SampleOverview>(data.get(), frames);
+
+	QMutexLocker lock(&s_mutex);
+	const auto it = findEntry();
+	if (it != s_samples.end())
+	{
+		it->second.overview = overview;
+	}
+	return overview;
+}
+
+
+
+
+int SampleCache::pendingFiles()
+{
+	QMutexLocker lock(&s_mutex);
+	return std::count_if(s_samples.begin(), s_samples.end(),
+		[](const std::pair<const Key, Entry> & e) { return e.second.pending; });
+}
+
+
+
+
+void SampleCache::releasePrefetched()
+{
+	QMutexLocker lock(&s_mutex);
+	for (auto it = s_samples.begin(); it != s_samples.end();)
+	{
+		it->second.keepPrefetched = false;
+		it->second.prefetched.reset();
+		it = !it->second.pending && it->second.data.expired()
+			? s_samples.erase(it)
+			: std::next(it);
+	}
+}
@@ -0,0 +1,124 @@
+/*
+ * SampleOverview.cpp - min, max and RMS of a sample at several resolutions
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleOverview.h"
+
+#include <algorithm>
+
+
+SampleOverview::SampleOverview(const sampleFrame * data, f_cnt_t frames) :
+	m_frames(frames)
+{
+	std::vector<Point> base((frames + BaseFrames - 1) / BaseFrames);
+	for (std::size_t p = 0; p < base.size(); ++p)
+	{
+		const f_cnt_t begin = p * BaseFrames;
+		const f_cnt_t end = std::min(begin + BaseFrames, frames);
+		Point & point = base[p];
+		point.min = 1.0f;
+		point.max = -1.0f;
+		float sum = 0.0f;
+		for (f_cnt_t f = begin; f < end; ++f)
+		{
+			for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				const float v = data[f][ch];
+				point.min = std::min(point.min, v);
+				point.max = std::max(point.max, v);
+				sum += v * v;
+			}
+		}
+		point.meanSquare = sum / (DEFAULT_CHANNELS * (end - begin));
+	}
+	m_levels.push_back(std::move(base));
+
+	// stop once a level has only a few points
+	while (m_levels.back().size() > static_cast<std::size_t>(LevelFactor))
+	{
+		const std::vector<Point> & finer = m_levels.back();
+		std::vector<Point> level((finer.size() + LevelFactor - 1) / LevelFactor);
+		for (std::size_t p = 0; p < level.size(); ++p)
+		{
+			const std::size_t begin = p * LevelFactor;
+			const std::size_t end = std::min(begin + LevelFactor, finer.size());
+			Point & point = level[p];
+			point = finer[begin];
+			for (std::size_t i = begin + 1; i < end; ++i)
+			{
+				point.min = std::min(point.min, finer[i].min);
+				point.max = std::max(point.max, finer[i].max);
+				point.meanSquare += finer[i].meanSquare;
+			}
+			point.meanSquare /= end - begin;
+		}
+		m_levels.push_back(std::move(level));
+	}
+}
+
+
+
+
+qint64 SampleOverview::memoryUsage() const
+{
+	qint64 bytes = 0;
+	for (const std::vector<Point> & level : m_levels)
+	{
+		bytes += level.capacity() * sizeof(Point);
+	}
+	return bytes;
+}
+
+
+
+
+SampleOverview::Point SampleOverview::summarize(f_cnt_t first, f_cnt_t last,
+	double resolution) const
+{
+	std::size_t level = 0;
+	f_cnt_t pointFrames = BaseFrames;
+	while (level + 1 < m_levels.size() && pointFrames * LevelFactor <= resolution)
+	{
+		++level;
+		pointFrames *= LevelFactor;
+	}
+
+	const std::vector<Point> & points = m_levels[level];
+	const f_cnt_t begin = std::max<f_cnt_t>(first, 0) / pointFrames;
+	const f_cnt_t end = std::min<f_cnt_t>((std::min(last, m_frames) + pointFrames - 1) / pointFrames,
+		points.size());
+	if (begin >= end)
+	{
+		return Point{0.0f, 0.0f, 0.0f};
+	}
+
+	Point result = points[begin];
+	for (f_cnt_t p = begin + 1; p < end; ++p)
+	{
+		result.min = std::min(result.min, points[p].min);
+		result.max = std::max(result.max, points[p].max);
+		result.meanSquare += points[p].meanSquare;
+	}
+	result.meanSquare /= end - begin;
+	return result;
+}
@@ -24,23 +24,192 @@
 
 
 #include "SampleRecordHandle.h"
+
+#include <atomic>
+#include <vector>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+
+#include <sndfile.h>
+
 #include "BBTrack.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "InstrumentTrack.h"
+#include "LatencyProbe.h"
+#include "LocklessRingBuffer.h"
 #include "Mixer.h"
-#include "SampleBuffer.h"
 #include "SampleTrack.h"
 #include "debug.h"
 
 
+//! Writes the frames the audio thread records to a WAV file, so recording
+//! neither allocates memory on the audio thread nor keeps the take in memory
+class SampleRecordHandle::DiskWriter : public QThread
+{
+public:
+	// the writer wakes up this often, the ring holds a multiple of it
+	static const int IntervalMs = 20;
+	static const int RingSeconds = 2;
+
+	DiskWriter( const QString & fileName, sample_rate_t sampleRate ) :
+		m_file( fileName ),
+		m_sndFile( nullptr ),
+		m_opened( false ),
+		m_ring( sampleRate * RingSeconds ),
+		m_reader( m_ring ),
+		m_stop( false ),
+		m_dropped( 0 )
+	{
+		SF_INFO info;
+		info.samplerate = sampleRate;
+		info.channels = DEFAULT_CHANNELS;
+		info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+		// use QFile to handle unicode file names on Windows
+		if( m_file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+		{
+			m_sndFile = sf_open_fd( m_file.handle(), SFM_WRITE, &info, false );
+		}
+		if( m_sndFile != nullptr )
+		{
+			m_opened = true;
+			start();
+		}
+	}
+
+	~DiskWriter() override
+	{
+		finish();
+	}
+
+	//! Whether the file could be created
+	bool isOpen() const
+	{
+		return m_opened;
+	}
+
+	QString fileName() const
+	{
+		return m_file.fileName();
+	}
+
+	//! Called by the audio thread
+	void write( const sampleFrame * frames, f_cnt_t count )
+	{
+		if( m_sndFile == nullptr )
+		{
+			return;
+		}
+		const f_cnt_t written = m_ring.write( frames, count );
+		if( written < count )
+		{
+			m_dropped.fetch_add( count - written, std::memory_order_relaxed );
+		}
+	}
+
+	//! Writes the remaining frames and closes the file
+	void finish()
+	{
+		m_stop = true;
+		wait();
+		if( m_sndFile != nullptr )
+		{
+			sf_close( m_sndFile );
+			m_sndFile = nullptr;
+		}
+		m_file.close();
+		const f_cnt_t dropped = m_dropped.exchange( 0 );
+		if( dropped > 0 )
+		{
+			qWarning( "Recording dropped %d frames, the disk was too slow",
+							static_cast<int>( dropped ) );
+		}
+	}
+
+private:
+	void run() override
+	{
+		std::vector<sampleFrame> chunk;
+		chunk.reserve( m_ring.capacity() );
+		while( true )
+		{
+			const bool stop = m_stop;
+			auto frames = m_reader.read_max( m_ring.capacity() );
+			chunk.resize( frames.size() );
+			for( std::size_t f = 0; f < frames.size(); ++f )
+			{
+				chunk[f] = frames[f];
+			}
+			if( !chunk.empty() )
+			{
+				sf_writef_float( m_sndFile, chunk[0].data(), chunk.size() );
+			}
+			// anything written before the stop has been read now
+			if( stop )
+			{
+				break;
+			}
+			msleep( IntervalMs );
+		}
+	}
+
+	QFile m_file;
+	SNDFILE * m_sndFile;
+	bool m_opened;
+	LocklessRingBuffer<sampleFrame> m_ring;
+	LocklessRingBufferReader<sampleFrame> m_reader;
+	std::atomic<bool> m_stop;
+	std::atomic<f_cnt_t> m_dropped;
+
+} ;
+
+
+
+
+namespace
+{
+
+//! A new file in the recordings directory, or in the temporary one if it
+//! can't be created
+QString recordingFileName()
+{
+	const QString name = "recording-" +
+		QDateTime::currentDateTime().toString( "yyyyMMdd-hhmmss-zzz" ) + ".wav";
+	const QString dir = ConfigManager::inst()->userSamplesDir() + "recordings";
+	if( QDir().mkpath( dir ) )
+	{
+		return dir + "/" + name;
+	}
+	return QDir::tempPath() + "/" + name;
+}
+
+} // namespace
+
+
+
+
 SampleRecordHandle::SampleRecordHandle( SampleTCO* tco ) :
 	PlayHandle( TypeSamplePlayHandle ),
+	m_writer( new DiskWriter( recordingFileName(),
+					Engine::mixer()->inputSampleRate() ) ),
 	m_framesRecorded( 0 ),
+	m_framesToSkip( static_cast<f_cnt_t>( LatencyProbe::recordLatency() *
+				Engine::mixer()->inputSampleRate() / 1000 ) ),
 	m_minLength( tco->length() ),
 	m_track( tco->getTrack() ),
 	m_bbTrack( NULL ),
 	m_tco( tco )
 {
+	// the handle doesn't output anything, but belongs to the track
+	setAudioPort( static_cast<SampleTrack *>( m_track )->audioPort() );
+	if( !m_writer->isOpen() )
+	{
+		qWarning( "Could not create %s for recording",
+				qPrintable( m_writer->fileName() ) );
+	}
 }
 
 
@@ -48,17 +217,15 @@ SampleRecordHandle::SampleRecordHandle( SampleTCO* tco ) :
 
 SampleRecordHandle::~SampleRecordHandle()
 {
-	if( !m_buffers.empty() )
+	m_writer->finish();
+	if( m_framesRecorded > 0 && m_writer->isOpen() )
 	{
-		SampleBuffer* sb;
-		createSampleBuffer( &sb );
-		m_tco->setSampleBuffer( sb );
+		// long takes are streamed from the file, like any other
+		m_tco->setSampleFile( m_writer->fileName() );
 	}
-	
-	while( !m_buffers.empty() )
+	else
 	{
-		delete[] m_buffers.front().first;
-		m_buffers.erase( m_buffers.begin() );
+		QFile::remove( m_writer->fileName() );
 	}
 	m_tco->setRecord( false );
 }
@@ -69,8 +236,15 @@ SampleRecordHandle::~SampleRecordHandle()
 void SampleRecordHandle::play( sampleFrame * /*_working_buffer*/ )
 {
 	const sampleFrame * recbuf = Engine::mixer()->inputBuffer();
-	const f_cnt_t frames = Engine::mixer()->inputBufferFrames();
-	writeBuffer( recbuf, frames );
+	f_cnt_t frames = Engine::mixer()->inputBufferFrames();
+	if( m_framesToSkip > 0 )
+	{
+		const f_cnt_t skip = qMin( m_framesToSkip, frames );
+		recbuf += skip;
+		frames -= skip;
+		m_framesToSkip -= skip;
+	}
+	m_writer->write( recbuf, frames );
 	m_framesRecorded += frames;
 
 	TimePos len = (tick_t)( m_framesRecorded / Engine::framesPerTick() );
@@ -104,51 +278,3 @@ f_cnt_t SampleRecordHandle::framesRecorded() const
 {
 	return( m_framesRecorded );
 }
-
-
-
-
-void SampleRecordHandle::createSampleBuffer( SampleBuffer** sampleBuf )
-{
-	const f_cnt_t frames = framesRecorded();
-	// create buffer to store all recorded buffers in
-	sampleFrame * data = new sampleFrame[frames];
-	// make sure buffer is cleaned up properly at the end...
-	sampleFrame * data_ptr = data;
-
-
-	assert( data != NULL );
-
-	// now copy all buffers into big buffer
-	for( bufferList::const_iterator it = m_buffers.begin();
-						it != m_buffers.end(); ++it )
-	{
-		memcpy( data_ptr, ( *it ).first, ( *it ).second *
-							sizeof( sampleFrame ) );
-		data_ptr += ( *it ).second;
-	}
-	// create according sample-buffer out of big buffer
-	*sampleBuf = new SampleBuffer( data, frames );
-	( *sampleBuf)->setSampleRate( Engine::mixer()->inputSampleRate() );
-	delete[] data;
-}
-
-
-
-
-void SampleRecordHandle::writeBuffer( const sampleFrame * _ab,
-					const f_cnt_t _frames )
-{
-	sampleFrame * buf = new sampleFrame[_frames];
-	for( f_cnt_t frame = 0; frame < _frames; ++frame )
-	{
-		for( ch_cnt_t chnl = 0; chnl < DEFAULT_CHANNELS; ++chnl )
-		{
-			buf[frame][chnl] = _ab[frame][chnl];
-		}
-	}
-	m_buffers.push_back( qMakePair( buf, _frames ) );
-}
-
-
-
@@ -0,0 +1,440 @@
+/*
+ * SampleStream.cpp - plays long audio files from disk
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleStream.h"
+
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+const f_cnt_t SampleStream::BlockFrames;
+const int SampleStream::NumBlocks;
+const f_cnt_t SampleStream::OverviewFrames;
+
+
+
+
+class SampleStreamReader : public QThread
+{
+public:
+	static SampleStreamReader & inst()
+	{
+		// never deleted, so the running thread isn't destroyed at exit
+		static SampleStreamReader * s_reader = new SampleStreamReader;
+		return *s_reader;
+	}
+
+	void add( SampleStream * stream )
+	{
+		QMutexLocker lock( &m_mutex );
+		m_streams.push_back( stream );
+		if( !isRunning() )
+		{
+			start();
+		}
+	}
+
+	void remove( SampleStream * stream )
+	{
+		// once we have the lock, the stream isn't worked on
+		QMutexLocker lock( &m_mutex );
+		m_streams.erase( std::remove( m_streams.begin(), m_streams.end(), stream ),
+							m_streams.end() );
+	}
+
+
+private:
+	void run() override
+	{
+		while( true )
+		{
+			bool busy = false;
+			m_mutex.lock();
+			// one block per stream at a time, so no stream has to wait
+			// for the window of another one
+			for( SampleStream * stream : m_streams )
+			{
+				busy = stream->fill() || busy;
+			}
+			if( !busy )
+			{
+				for( SampleStream * stream : m_streams )
+				{
+					busy = stream->scanOverview() || busy;
+				}
+			}
+			m_mutex.unlock();
+
+			if( !busy )
+			{
+				msleep( 10 );
+			}
+		}
+	}
+
+	QMutex m_mutex;
+	std::vector<SampleStream *> m_streams;
+
+} ;
+
+
+
+
+SampleStream::SampleStream( const QString & file,
+				const std::function<void()> & overviewDone ) :
+	m_file( file ),
+	m_qfile( file ),
+	m_sndFile( nullptr ),
+	m_channels( 0 ),
+	m_frames( 0 ),
+	m_sampleRate( 0 ),
+	m_blocks( new Block[NumBlocks] ),
+	m_playFrame( 0 ),
+	m_reversed( false ),
+	m_scansOverview( false ),
+	m_overviewDone( overviewDone )
+{
+	for( int i = 0; i < NumBlocks; ++i )
+	{
+		m_blocks[i].index.store( -1, std::memory_order_relaxed );
+	}
+}
+
+
+
+
+SampleStream * SampleStream::open( const QString & file, int minSeconds,
+					const std::function<void()> & overviewDone )
+{
+	std::unique_ptr<SampleStream> stream( new SampleStream( file, overviewDone ) );
+	if( !stream->openFile() ||
+		stream->m_frames < minSeconds * static_cast<f_cnt_t>( stream->m_sampleRate ) )
+	{
+		return nullptr;
+	}
+
+	stream->m_overview = std::make_shared<Overview>();
+	stream->m_overview->points.resize(
+		( stream->m_frames + OverviewFrames - 1 ) / OverviewFrames );
+	stream->m_overview->ready.store( 0, std::memory_order_relaxed );
+	stream->m_scansOverview = true;
+	stream->start();
+	return stream.release();
+}
+
+
+
+
+bool SampleStream::canStream( const QString & file, int minSeconds )
+{
+	SampleStream stream( file, std::function<void()>() );
+	return stream.openFile() &&
+		stream.m_frames >= minSeconds * static_cast<f_cnt_t>( stream.m_sampleRate );
+}
+
+
+
+
+SampleStream * SampleStream::clone( const std::function<void()> & overviewDone ) const
+{
+	std::unique_ptr<SampleStream> stream( new SampleStream( m_file, overviewDone ) );
+	if( !stream->openFile() )
+	{
+		return nullptr;
+	}
+
+	if( overviewPoints() == overviewSize() )
+	{
+		stream->m_overview = m_overview;
+	}
+	else
+	{
+		stream->m_overview = std::make_shared<Overview>();
+		stream->m_overview->points.resize( overviewSize() );
+		stream->m_overview->ready.store( 0, std::memory_order_relaxed );
+		stream->m_scansOverview = true;
+	}
+	stream->m_reversed = m_reversed;
+	stream->start();
+	return stream.release();
+}
+
+
+
+
+SampleStream::~SampleStream()
+{
+	SampleStreamReader::inst().remove( this );
+	if( m_sndFile )
+	{
+		sf_close( m_sndFile );
+	}
+}
+
+
+
+
+bool SampleStream::openFile()
+{
+	// use QFile to handle unicode file names on Windows
+	SF_INFO info;
+	info.format = 0;
+	if( !m_qfile.open( QIODevice::ReadOnly ) ||
+		!( m_sndFile = sf_open_fd( m_qfile.handle(), SFM_READ, &info, false ) ) )
+	{
+		return false;
+	}
+	if( !info.seekable || info.channels <= 0 || info.samplerate <= 0 ||
+		info.frames <= 0 || info.frames > std::numeric_limits<f_cnt_t>::max() )
+	{
+		return false;
+	}
+	m_channels = info.channels;
+	m_frames = static_cast<f_cnt_t>( info.frames );
+	m_sampleRate = info.samplerate;
+	return true;
+}
+
+
+
+
+void SampleStream::start()
+{
+	for( int i = 0; i < NumBlocks; ++i )
+	{
+		m_blocks[i].data.reset( new sampleFrame[BlockFrames] );
+	}
+	m_fileBuffer.resize( BlockFrames * m_channels );
+	// the start is there right away, so playing from it isn't silent
+	// until the reader gets to the stream
+	fill();
+	SampleStreamReader::inst().add( this );
+}
+
+
+
+
+bool SampleStream::read( f_cnt_t first, f_cnt_t count, sampleFrame * dst, bool wait )
+{
+	m_playFrame.store( qMax<f_cnt_t>( first, 0 ), std::memory_order_relaxed );
+
+	bool complete = true;
+	f_cnt_t done = 0;
+	while( done < count )
+	{
+		const f_cnt_t frame = first + done;
+		if( frame < 0 || frame >= m_frames )
+		{
+			const f_cnt_t todo = frame < 0 ? qMin( count - done, -frame ) : count - done;
+			memset( dst + done, 0, todo * sizeof( sampleFrame ) );
+			done += todo;
+			continue;
+		}
+
+		const f_cnt_t index = frame / BlockFrames;
+		const f_cnt_t inBlock = frame - index * BlockFrames;
+		const f_cnt_t todo = qMin( count - done,
+				qMin( BlockFrames - inBlock, m_frames - frame ) );
+		Block & block = m_blocks[index % NumBlocks];
+		bool valid = block.index.load( std::memory_order_acquire ) == index;
+		if( wait && !valid )
+		{
+			// the reader can't replace the block while we hold the lock
+			QMutexLocker lock( &m_mutex );
+			if( block.index.load( std::memory_order_relaxed ) != index )
+			{
+				loadBlock( block, index );
+			}
+			memcpy( dst + done, block.data.get() + inBlock,
+						todo * sizeof( sampleFrame ) );
+			done += todo;
+			continue;
+		}
+		if( valid )
+		{
+			memcpy( dst + done, block.data.get() + inBlock,
+						todo * sizeof( sampleFrame ) );
+			// the reader may have started replacing the block meanwhile
+			std::atomic_thread_fence( std::memory_order_acquire );
+			valid = block.index.load( std::memory_order_relaxed ) == index;
+		}
+		if( !valid )
+		{
+			memset( dst + done, 0, todo * sizeof( sampleFrame ) );
+			complete = false;
+		}
+		done += todo;
+	}
+	return complete;
+}
+
+
+
+
+void SampleStream::setOverviewDone( const std::function<void()> & overviewDone )
+{
+	QMutexLocker lock( &m_mutex );
+	m_overviewDone = overviewDone;
+}
+
+
+
+
+void SampleStream::setReversed( bool reversed )
+{
+	QMutexLocker lock( &m_mutex );
+	if( reversed == m_reversed )
+	{
+		return;
+	}
+	m_reversed = reversed;
+	for( int i = 0; i < NumBlocks; ++i )
+	{
+		m_blocks[i].index.store( -1, std::memory_order_relaxed );
+	}
+}
+
+
+
+
+bool SampleStream::fill()
+{
+	QMutexLocker lock( &m_mutex );
+	const f_cnt_t blocks = ( m_frames + BlockFrames - 1 ) / BlockFrames;
+	const f_cnt_t current = qBound<f_cnt_t>( 0,
+			m_playFrame.load( std::memory_order_relaxed ), m_frames - 1 ) / BlockFrames;
+
+	// the block before the current one stays for reading across their
+	// boundary, the others are loaded in the order they are read
+	for( int i = 0; i < NumBlocks; ++i )
+	{
+		const f_cnt_t index = i < NumBlocks - 1 ? current + i : current - 1;
+		if( index < 0 || index >= blocks )
+		{
+			continue;
+		}
+		Block & block = m_blocks[index % NumBlocks];
+		if( block.index.load( std::memory_order_relaxed ) != index )
+		{
+			loadBlock( block, index );
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+bool SampleStream::scanOverview()
+{
+	QMutexLocker lock( &m_mutex );
+	if( !m_scansOverview )
+	{
+		return false;
+	}
+
+	Overview & overview = *m_overview;
+	const int point = overview.ready.load( std::memory_order_relaxed );
+	const f_cnt_t first = point * OverviewFrames;
+	const f_cnt_t count = qMin( BlockFrames, m_frames - first );
+	readFile( first, count );
+
+	const int right = m_channels > 1 ? 1 : 0;
+	const int points = ( count + OverviewFrames - 1 ) / OverviewFrames;
+	for( int p = 0; p < points; ++p )
+	{
+		const f_cnt_t begin = p * OverviewFrames;
+		const f_cnt_t end = qMin( begin + OverviewFrames, count );
+		OverviewPoint & op = overview.points[point + p];
+		op.min = 1.0f;
+		op.max = -1.0f;
+		float sum = 0.0f;
+		for( f_cnt_t f = begin; f < end; ++f )
+		{
+			const float * in = m_fileBuffer.data() + f * m_channels;
+			for( const float v : { in[0], in[right] } )
+			{
+				op.min = qMin( op.min, v );
+				op.max = qMax( op.max, v );
+				sum += v * v;
+			}
+		}
+		op.meanSquare = sum / ( 2 * ( end - begin ) );
+	}
+	overview.ready.store( point + points, std::memory_order_release );
+
+	if( point + points == overviewSize() )
+	{
+		m_scansOverview = false;
+		if( m_overviewDone )
+		{
+			m_overviewDone();
+		}
+	}
+	return true;
+}
+
+
+
+
+void SampleStream::loadBlock( Block & block, f_cnt_t index )
+{
+	block.index.store( -1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+
+	const f_cnt_t first = index * BlockFrames;
+	const f_cnt_t count = qMin( BlockFrames, m_frames - first );
+	// a reversed stream starts with the end of the file
+	readFile( m_reversed ? m_frames - first - count : first, count );
+
+	const int right = m_channels > 1 ? 1 : 0;
+	for( f_cnt_t f = 0; f < count; ++f )
+	{
+		const float * in = m_fileBuffer.data() +
+				( m_reversed ? count - 1 - f : f ) * m_channels;
+		block.data[f][0] = in[0];
+		block.data[f][1] = in[right];
+	}
+
+	block.index.store( index, std::memory_order_release );
+}
+
+
+
+
+void SampleStream::readFile( f_cnt_t first, f_cnt_t count )
+{
+	sf_count_t read = 0;
+	if( sf_seek( m_sndFile, first, SEEK_SET ) >= 0 )
+	{
+		read = qMax<sf_count_t>( 0, sf_readf_float( m_sndFile, m_fileBuffer.data(), count ) );
+	}
+	// what couldn't be read stays silent
+	std::fill( m_fileBuffer.begin() + read * m_channels,
+			m_fileBuffer.begin() + count * m_channels, 0.0f );
+}
@@ -34,6 +34,11 @@ SampleTCO::SampleTCO( Track * _track ) :
 	m_sampleBuffer( new SampleBuffer ),
 	m_isPlaying( false )
 {
+	// long samples are played from disk
+	m_sampleBuffer->setStreamable( true );
+	connect( m_sampleBuffer, SIGNAL( sampleUpdated() ),
+					this, SIGNAL( sampleChanged() ) );
+
 	saveJournallingState( false );
 	setSampleFile( "" );
 	restoreJournallingState();
@@ -129,6 +134,8 @@ void SampleTCO::setSampleBuffer( SampleBuffer* sb )
 	sharedObject::unref( m_sampleBuffer );
 	Engine::mixer()->doneChangeInModel();
 	m_sampleBuffer = sb;
+	connect( m_sampleBuffer, SIGNAL( sampleUpdated() ),
+					this, SIGNAL( sampleChanged() ) );
 	updateLength();
 
 	emit sampleChanged();
@@ -175,6 +182,12 @@ void SampleTCO::playbackPositionChanged()
 	Engine::mixer()->removePlayHandlesOfTypes( getTrack(), PlayHandle::TypeSamplePlayHandle );
 	SampleTrack * st = dynamic_cast<SampleTrack*>( getTrack() );
 	st->setPlayingTcos( false );
+
+	// let a streamed sample load the frames the song continues at
+	const int tick = Engine::getSong()->getPlayPos( Song::Mode_PlaySong ).getTicks()
+					- startPosition() - startTimeOffset();
+	m_sampleBuffer->prefetch( qMax( tick, 0 ) *
+			Engine::framesPerTick( m_sampleBuffer->sampleRate() ) );
 }
 
 
@@ -218,7 +231,8 @@ void SampleTCO::updateLength()
 
 TimePos SampleTCO::sampleLength() const
 {
-	return (int)( m_sampleBuffer->frames() / Engine::framesPerTick() );
+	return (int)( m_sampleBuffer->frames() /
+			Engine::framesPerTick( m_sampleBuffer->sampleRate() ) );
 }
 
 
@@ -256,8 +270,7 @@ void SampleTCO::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	_this.setAttribute( "off", startTimeOffset() );
 	if( sampleFile() == "" )
 	{
-		QString s;
-		_this.setAttribute( "data", m_sampleBuffer->toBase64( s ) );
+		m_sampleBuffer->saveEmbedded( _this, "data" );
 	}
 
 	_this.setAttribute( "sample_rate", m_sampleBuffer->sampleRate());
@@ -282,9 +295,9 @@ void SampleTCO::loadSettings( const QDomElement & _this )
 		movePosition( _this.attribute( "pos" ).toInt() );
 	}
 	setSampleFile( _this.attribute( "src" ) );
-	if( sampleFile().isEmpty() && _this.hasAttribute( "data" ) )
+	if( sampleFile().isEmpty() )
 	{
-		m_sampleBuffer->loadFromBase64( _this.attribute( "data" ) );
+		m_sampleBuffer->loadEmbedded( _this, "data" );
 	}
 	changeLength( _this.attribute( "len" ).toInt() );
 	setMuted( _this.attribute( "muted" ).toInt() );
@@ -0,0 +1,520 @@
+/*
+ * SegmentRenderer.cpp - renders a song in parallel segments
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "SegmentRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+
+#include <sndfile.h>
+
+#include "AutomationPattern.h"
+#include "BBTrackContainer.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "InstrumentTrack.h"
+#include "Pattern.h"
+#include "RenderManager.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
+
+namespace
+{
+
+// names of Mixer::qualitySettings::Interpolation on the command line
+const char * const InterpolationNames[] = {
+	"linear", "sincfastest", "sincmedium", "sincbest"
+};
+
+// the length of the crossfade between segments, in seconds
+const double CrossfadeTime = 0.01;
+
+// how much the renderings of the crossfade may differ, as power relative
+// to theirs (-40 dB) and absolute, for silence
+const double MaxRelativeDifference = 1e-4;
+const double MaxDifferencePerSample = 1e-10;
+
+
+QString checkEffects( EffectChain * chain, const QString & where )
+{
+	for( const Effect * effect : chain->effects() )
+	{
+		if( !effect->isResettable() )
+		{
+			return QString( "%1 on %2 isn't resettable" )
+					.arg( effect->displayName() ).arg( where );
+		}
+	}
+	return QString();
+}
+
+} // namespace
+
+
+
+
+SegmentRenderer::SegmentRenderer( const Mixer::qualitySettings & qualitySettings,
+				const OutputSettings & outputSettings,
+				ProjectRenderer::ExportFileFormats format,
+				const QString & projectFile,
+				const QString & outputFile,
+				int segments, bar_t preRoll ) :
+	m_qualitySettings( qualitySettings ),
+	m_outputSettings( outputSettings ),
+	m_format( format ),
+	m_projectFile( projectFile ),
+	m_outputFile( outputFile ),
+	m_segmentCount( segments ),
+	m_preRoll( preRoll ),
+	m_finishedCount( 0 )
+{
+}
+
+
+
+
+SegmentRenderer::~SegmentRenderer()
+{
+	for( Segment & segment : m_segments )
+	{
+		if( segment.process )
+		{
+			segment.process->disconnect( this );
+			segment.process->kill();
+			segment.process->waitForFinished();
+		}
+	}
+}
+
+
+
+
+void SegmentRenderer::start()
+{
+	QString reason = checkSong();
+	const std::vector<bar_t> candidates = reason.isEmpty() ?
+					splitPoints() : std::vector<bar_t>();
+	if( reason.isEmpty() && candidates.empty() )
+	{
+		reason = "there are no breaks to split it at";
+	}
+	if( reason.isEmpty() && !m_tempDir.isValid() )
+	{
+		reason = "no temporary directory could be created";
+	}
+	if( !reason.isEmpty() )
+	{
+		renderInOnePass( reason );
+		return;
+	}
+
+	// pick the split points closest to equally long segments
+	const bar_t length = Engine::getSong()->length();
+	std::vector<bar_t> splits;
+	auto next = candidates.begin();
+	for( int i = 1; i < m_segmentCount && next != candidates.end(); ++i )
+	{
+		const double target = static_cast<double>( length ) * i / m_segmentCount;
+		auto best = next;
+		for( auto it = next; it != candidates.end(); ++it )
+		{
+			if( std::fabs( *it - target ) < std::fabs( *best - target ) )
+			{
+				best = it;
+			}
+		}
+		splits.push_back( *best );
+		next = best + 1;
+	}
+
+	const tick_t ticksPerBar = TimePos::ticksPerBar();
+	m_segments.resize( splits.size() + 1 );
+	for( size_t i = 0; i < m_segments.size(); ++i )
+	{
+		Segment & segment = m_segments[i];
+		segment.begin = i == 0 ? 0 : splits[i - 1] * ticksPerBar;
+		// the last segment has the tails of the last notes, like a
+		// render of the whole song
+		segment.end = i < splits.size() ? splits[i] * ticksPerBar :
+						( length + 1 ) * ticksPerBar;
+		segment.renderBegin = i == 0 ? 0 :
+					segment.begin - m_preRoll * ticksPerBar;
+		segment.file = m_tempDir.filePath(
+					QString( "segment-%1.wav" ).arg( i ) );
+	}
+
+	for( Segment & segment : m_segments )
+	{
+		startSegment( segment );
+		if( !segment.process->waitForStarted() )
+		{
+			renderInOnePass( "the renderer process couldn't be started" );
+			return;
+		}
+	}
+}
+
+
+
+
+void SegmentRenderer::updateConsoleProgress()
+{
+	if( m_onePassRenderer )
+	{
+		m_onePassRenderer->updateConsoleProgress();
+		return;
+	}
+	fprintf( stderr, "\rRendering %d segments in parallel, %d done  ",
+			static_cast<int>( m_segments.size() ), m_finishedCount );
+	fflush( stderr );
+}
+
+
+
+
+void SegmentRenderer::segmentFinished()
+{
+	if( ++m_finishedCount < static_cast<int>( m_segments.size() ) )
+	{
+		return;
+	}
+
+	for( size_t i = 0; i < m_segments.size(); ++i )
+	{
+		const QProcess * process = m_segments[i].process.get();
+		if( process->exitStatus() != QProcess::NormalExit ||
+						process->exitCode() != EXIT_SUCCESS )
+		{
+			renderInOnePass( QString( "segment %1 couldn't be rendered" )
+								.arg( i + 1 ) );
+			return;
+		}
+	}
+
+	const QString error = joinSegments();
+	if( !error.isEmpty() )
+	{
+		renderInOnePass( error );
+		return;
+	}
+	QCoreApplication::exit( EXIT_SUCCESS );
+}
+
+
+
+
+QString SegmentRenderer::checkSong() const
+{
+	Song * song = Engine::getSong();
+	if( song->isExportLoop() || song->getLoopRenderCount() > 1 ||
+						song->isRenderBetweenMarkers() )
+	{
+		return "it's rendered as a loop or between the loop points";
+	}
+	if( AutomationPattern::isAutomated( &song->tempoModel() ) )
+	{
+		return "its tempo is automated";
+	}
+
+	TrackContainer::TrackList tracks = song->tracks();
+	tracks += Engine::getBBTrackContainer()->tracks();
+	for( Track * track : tracks )
+	{
+		const QString where = QString( "track %1" ).arg( track->name() );
+		QString reason;
+		if( track->type() == Track::InstrumentTrack )
+		{
+			InstrumentTrack * it = static_cast<InstrumentTrack *>( track );
+			if( it->instrument() && !it->instrument()->isResettable() )
+			{
+				return QString( "%1 on %2 isn't resettable" )
+					.arg( it->instrument()->displayName() ).arg( where );
+			}
+			reason = checkEffects( it->audioPort()->effects(), where );
+		}
+		else if( track->type() == Track::SampleTrack )
+		{
+			reason = checkEffects( static_cast<SampleTrack *>( track )->
+						audioPort()->effects(), where );
+		}
+		if( !reason.isEmpty() )
+		{
+			return reason;
+		}
+	}
+
+	FxMixer * mixer = Engine::fxMixer();
+	for( fx_ch_t ch = 0; ch < mixer->numChannels(); ++ch )
+	{
+		const QString reason = checkEffects(
+				&mixer->effectChannel( ch )->m_fxChain,
+				QString( "FX channel %1" ).arg( ch ) );
+		if( !reason.isEmpty() )
+		{
+			return reason;
+		}
+	}
+	return QString();
+}
+
+
+
+
+std::vector<bar_t> SegmentRenderer::splitPoints() const
+{
+	const Song * song = Engine::getSong();
+	const tick_t ticksPerBar = TimePos::ticksPerBar();
+	const bar_t length = song->length();
+
+	// A segment may start at bar b if nothing sounds across the start of
+	// its pre-roll, so everything it plays is started in the pre-roll
+	std::vector<bool> blocked( length + 1, false );
+	auto block = [&]( tick_t start, tick_t end )
+	{
+		// the bars strictly inside the sound
+		for( bar_t bar = start / ticksPerBar + 1;
+				bar * ticksPerBar < end && bar + m_preRoll <= length; ++bar )
+		{
+			blocked[bar + m_preRoll] = true;
+		}
+	};
+
+	for( const Track * track : song->tracks() )
+	{
+		for( const TrackContentObject * tco : track->getTCOs() )
+		{
+			switch( track->type() )
+			{
+				case Track::InstrumentTrack:
+					for( const Note * note : static_cast<const Pattern *>(
+								tco )->notes() )
+					{
+						const tick_t start = tco->startPosition() + note->pos();
+						block( start, start + std::max<tick_t>(
+								note->length(), 0 ) );
+					}
+					break;
+				case Track::SampleTrack:
+				case Track::BBTrack:
+					block( tco->startPosition(), tco->endPosition() );
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	std::vector<bar_t> points;
+	for( bar_t bar = m_preRoll + 1; bar < length; ++bar )
+	{
+		if( !blocked[bar] )
+		{
+			points.push_back( bar );
+		}
+	}
+	return points;
+}
+
+
+
+
+void SegmentRenderer::startSegment( Segment & segment )
+{
+	QStringList arguments;
+	arguments << "render" << m_projectFile
+		<< "--segment" << QString( "%1:%2" ).arg( segment.renderBegin )
+							.arg( segment.end )
+		<< "--format" << "wav" << "--float"
+		<< "--samplerate" << QString::number(
+					m_outputSettings.getSampleRate() )
+		<< "--interpolation"
+		<< InterpolationNames[m_qualitySettings.interpolation]
+		<< "--oversampling" << QString::number(
+				m_qualitySettings.sampleRateMultiplier() )
+		<< "--output" << segment.file
+		// this process passed the check already
+		<< "--allowroot";
+
+	segment.process.reset( new QProcess );
+	segment.process->setStandardOutputFile( QProcess::nullDevice() );
+	segment.process->setStandardErrorFile( QProcess::nullDevice() );
+	connect( segment.process.get(),
+			SIGNAL( finished( int, QProcess::ExitStatus ) ),
+			this, SLOT( segmentFinished() ) );
+	segment.process->start( QCoreApplication::applicationFilePath(),
+								arguments );
+}
+
+
+
+
+QString SegmentRenderer::joinSegments()
+{
+	AudioFileDeviceInstantiaton instantiate =
+		ProjectRenderer::fileEncodeDevices[m_format].m_getDevInst;
+	bool successful = false;
+	std::unique_ptr<AudioFileDevice> output( instantiate ?
+		instantiate( m_outputFile, m_outputSettings, DEFAULT_CHANNELS,
+					Engine::mixer(), successful ) : nullptr );
+	if( !successful )
+	{
+		return "the output file couldn't be opened";
+	}
+
+	const sample_rate_t sampleRate = m_outputSettings.getSampleRate();
+	const double framesPerTick = Engine::framesPerTick( sampleRate );
+	auto frameAt = [framesPerTick]( tick_t tick )
+	{
+		return static_cast<sf_count_t>( std::llround( tick * framesPerTick ) );
+	};
+	const sf_count_t fadeFrames = std::min<sf_count_t>(
+			std::llround( sampleRate * CrossfadeTime ),
+			frameAt( m_preRoll * TimePos::ticksPerBar() ) );
+
+	const fpp_t chunk = Engine::mixer()->framesPerPeriod();
+	std::vector<surroundSampleFrame> buffer( chunk );
+	std::vector<surroundSampleFrame> head( fadeFrames );
+	// the end of the previous segment, crossfaded with the pre-roll
+	std::vector<surroundSampleFrame> tail( fadeFrames );
+
+	for( size_t i = 0; i < m_segments.size(); ++i )
+	{
+		const Segment & segment = m_segments[i];
+		const bool last = i + 1 == m_segments.size();
+
+		QFile file( segment.file );
+		SF_INFO info;
+		info.format = 0;
+		SNDFILE * sf = nullptr;
+		if( !file.open( QIODevice::ReadOnly ) ||
+			!( sf = sf_open_fd( file.handle(), SFM_READ, &info, false ) ) )
+		{
+			return QString( "segment %1 couldn't be read" ).arg( i + 1 );
+		}
+		std::unique_ptr<SNDFILE, int (*)( SNDFILE * )> closer( sf, sf_close );
+		if( info.channels != DEFAULT_CHANNELS ||
+				info.samplerate != static_cast<int>( sampleRate ) )
+		{
+			return QString( "segment %1 has the wrong format" ).arg( i + 1 );
+		}
+
+		if( i > 0 )
+		{
+			const sf_count_t skip = frameAt( segment.begin ) -
+				frameAt( segment.renderBegin ) - fadeFrames;
+			if( sf_seek( sf, skip, SEEK_SET ) != skip ||
+				sf_readf_float( sf, head[0].data(), fadeFrames ) != fadeFrames )
+			{
+				return QString( "segment %1 is too short" ).arg( i + 1 );
+			}
+
+			double difference = 0;
+			double level = 0;
+			for( sf_count_t f = 0; f < fadeFrames; ++f )
+			{
+				for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+				{
+					const double d = head[f][ch] - tail[f][ch];
+					difference += d * d;
+					level += head[f][ch] * head[f][ch] +
+							tail[f][ch] * tail[f][ch];
+				}
+			}
+			if( difference > MaxRelativeDifference * level &&
+				difference > MaxDifferencePerSample * fadeFrames )
+			{
+				return QString( "segment %1 doesn't match the one before "
+					"after its pre-roll" ).arg( i + 1 );
+			}
+
+			for( sf_count_t f = 0; f < fadeFrames; ++f )
+			{
+				const float t = ( f + 0.5f ) / fadeFrames;
+				for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+				{
+					head[f][ch] = tail[f][ch] +
+						( head[f][ch] - tail[f][ch] ) * t;
+				}
+			}
+			for( sf_count_t f = 0; f < fadeFrames; f += chunk )
+			{
+				output->writeFrames( head.data() + f,
+					std::min<sf_count_t>( chunk, fadeFrames - f ) );
+			}
+		}
+
+		// up to the crossfade with the next segment, or to the end
+		sf_count_t remaining = last ? info.frames :
+			frameAt( segment.end ) - frameAt( segment.begin ) - fadeFrames;
+		while( remaining > 0 )
+		{
+			const sf_count_t read = sf_readf_float( sf, buffer[0].data(),
+					std::min<sf_count_t>( chunk, remaining ) );
+			if( read <= 0 )
+			{
+				break;
+			}
+			output->writeFrames( buffer.data(), read );
+			remaining -= read;
+		}
+		if( !last && ( remaining > 0 ||
+			sf_readf_float( sf, tail[0].data(), fadeFrames ) != fadeFrames ) )
+		{
+			return QString( "segment %1 is too short" ).arg( i + 1 );
+		}
+	}
+	return QString();
+}
+
+
+
+
+void SegmentRenderer::renderInOnePass( const QString & reason )
+{
+	for( Segment & segment : m_segments )
+	{
+		if( segment.process )
+		{
+			segment.process->disconnect( this );
+			segment.process->kill();
+			segment.process->waitForFinished();
+		}
+	}
+	m_segments.clear();
+
+	printf( "Rendering the song in one pass: %s\n",
+			reason.toUtf8().constData() );
+	m_onePassRenderer.reset( new RenderManager( m_qualitySettings,
+				m_outputSettings, m_format, m_outputFile ) );
+	connect( m_onePassRenderer.get(), SIGNAL( finished() ),
+			QCoreApplication::instance(), SLOT( quit() ) );
+	m_onePassRenderer->renderProject();
+}
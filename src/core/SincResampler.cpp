@@ -0,0 +1,118 @@
+/*
+ * SincResampler.cpp - windowed-sinc resampler with shared filter tables
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SincResampler.h"
+
+#include <samplerate.h>
+
+#include "lmms_constants.h"
+
+
+namespace
+{
+
+// zeroth order modified Bessel function of the first kind
+double besselI0( double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for( int k = 1; k < 50 && term > sum * 1e-12; ++k )
+	{
+		term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+		sum += term;
+	}
+	return sum;
+}
+
+} // namespace
+
+
+
+
+SincResampler::SincResampler( Quality quality, int zeroCrossings,
+					float rolloff, float kaiserBeta ) :
+	m_quality( quality ),
+	m_zeroCrossings( zeroCrossings ),
+	m_length( zeroCrossings * Resolution ),
+	m_filter( m_length + 1, 0.0f ),
+	m_deltas( m_length + 1, 0.0f )
+{
+	if( m_length == 0 )
+	{
+		return;
+	}
+
+	const double norm = besselI0( kaiserBeta );
+	for( int i = 0; i < m_length; ++i )
+	{
+		const double x = static_cast<double>( i ) / Resolution;
+		const double r = x / zeroCrossings;
+		const double window =
+			besselI0( kaiserBeta * std::sqrt( 1.0 - r * r ) ) / norm;
+		const double y = D_PI * rolloff * x;
+		const double sinc = i == 0 ? 1.0 : std::sin( y ) / y;
+		m_filter[i] = static_cast<float>( rolloff * sinc * window );
+	}
+	// the window ends in zero at m_length
+	for( int i = 0; i < m_length; ++i )
+	{
+		m_deltas[i] = m_filter[i + 1] - m_filter[i];
+	}
+}
+
+
+
+
+const SincResampler & SincResampler::get( Quality quality )
+{
+	// built on first use, which C++11 makes thread-safe
+	static const SincResampler resamplers[NumQualities] =
+	{
+		SincResampler( Linear, 0, 1.0f, 0.0f ),
+		SincResampler( SincFastest, 8, 0.90f, 7.0f ),
+		SincResampler( SincMedium, 16, 0.94f, 8.5f ),
+		SincResampler( SincBest, 32, 0.96f, 10.0f )
+	};
+	return resamplers[quality < NumQualities ? quality : SincBest];
+}
+
+
+
+
+SincResampler::Quality SincResampler::qualityOfConverter( int converter )
+{
+	switch( converter )
+	{
+		case SRC_SINC_BEST_QUALITY:
+			return SincBest;
+		case SRC_SINC_MEDIUM_QUALITY:
+			return SincMedium;
+		case SRC_SINC_FASTEST:
+			return SincFastest;
+		case SRC_ZERO_ORDER_HOLD:
+		case SRC_LINEAR:
+		default:
+			return Linear;
+	}
+}
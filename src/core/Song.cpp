@@ -28,9 +28,14 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QElapsedTimer>
 #include <QMessageBox>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <functional>
 
@@ -42,6 +47,7 @@
 #include "ConfigManager.h"
 #include "ControllerRackView.h"
 #include "ControllerConnection.h"
+#include "EffectChain.h"
 #include "embed.h"
 #include "EnvelopeAndLfoParameters.h"
 #include "FxMixer.h"
@@ -51,18 +57,140 @@
 #include "InstrumentTrack.h"
 #include "NotePlayHandle.h"
 #include "Pattern.h"
+#include "PerfLog.h"
 #include "PianoRoll.h"
 #include "ProjectJournal.h"
 #include "ProjectNotes.h"
+#include "ProjectStream.h"
+#include "SampleBuffer.h"
+#include "SampleCache.h"
 #include "SongEditor.h"
 #include "TimeLineWidget.h"
 #include "PeakController.h"
+#include "SampleTrack.h"
 
 
 tick_t TimePos::s_ticksPerBar = DefaultTicksPerBar;
 
 
 
+namespace
+{
+
+// the autosaved file is rebuilt without reusing any tracks this often, so
+// changes that bypass the journal, like those in plugin windows, get in
+const qint64 FullAutoSaveInterval = 5 * 60 * 1000;
+
+
+void clearElement( QDomElement element )
+{
+	while( !element.firstChild().isNull() )
+	{
+		element.removeChild( element.firstChild() );
+	}
+	while( element.attributes().count() > 0 )
+	{
+		element.removeAttribute( element.attributes().item( 0 ).nodeName() );
+	}
+}
+
+
+
+
+class RecoveryFileWriter : public QRunnable
+{
+public:
+	RecoveryFileWriter( const std::shared_ptr<DataFile> & dataFile,
+				const QString & fileName, std::atomic<bool> & writing ) :
+		m_dataFile( dataFile ),
+		m_fileName( fileName ),
+		m_writing( writing )
+	{
+	}
+
+	void run() override
+	{
+		if( !m_dataFile->writeFile( m_fileName ) )
+		{
+			qWarning() << "Could not write" << m_fileName;
+		}
+		m_writing = false;
+	}
+
+private:
+	std::shared_ptr<DataFile> m_dataFile;
+	QString m_fileName;
+	std::atomic<bool> & m_writing;
+} ;
+
+
+// Whether the output of a track can be heard while exporting, or drives a
+// peak controller, as far as the mute buttons and the FX mixer tell
+bool isAudible( Track * track )
+{
+	AudioPort * port = nullptr;
+	IntModel * fxChannel = nullptr;
+	switch( track->type() )
+	{
+		case Track::InstrumentTrack:
+			port = static_cast<InstrumentTrack *>( track )->audioPort();
+			fxChannel = static_cast<InstrumentTrack *>( track )->effectChannelModel();
+			break;
+		case Track::SampleTrack:
+			port = static_cast<SampleTrack *>( track )->audioPort();
+			fxChannel = static_cast<SampleTrack *>( track )->effectChannelModel();
+			break;
+		default:
+			// automations and beat/basslines are played for the
+			// tracks they control
+			return true;
+	}
+
+	const BoolModel * muted = track->getMutedModel();
+	if( muted->value() )
+	{
+		return muted->isAutomatedOrControlled();
+	}
+	// stems are taken before the FX mixer
+	return port->stemOutput() || port->effects()->drivesControllers() ||
+		fxChannel->isAutomatedOrControlled() ||
+		Engine::fxMixer()->isChannelAudible( port->nextFxChannel() );
+}
+
+} // namespace
+
+
+
+
+struct Song::AutoSave
+{
+	AutoSave() :
+		saving( false ),
+		writing( false )
+	{
+		writer.setMaxThreadCount( 1 );
+	}
+
+	// the last file written, which the next one reuses tracks from
+	std::shared_ptr<DataFile> dataFile;
+	// the elements of the tracks in dataFile by their IDs
+	QHash<jo_id_t, QDomElement> tracks;
+	QElapsedTimer sinceFullSave;
+
+	// while saving, the objects changed since the last time and the
+	// tracks saved
+	bool saving;
+	QSet<jo_id_t> changed;
+	QSet<jo_id_t> saved;
+
+	// only touched by the writer while it's set
+	std::atomic<bool> writing;
+	QThreadPool writer;
+} ;
+
+
+
+
 Song::Song() :
 	TrackContainer(),
 	m_globalAutomationTrack( dynamic_cast<AutomationTrack *>(
@@ -85,6 +213,7 @@ Song::Song() :
 	m_playing( false ),
 	m_paused( false ),
 	m_savingProject( false ),
+	m_autoSave( new AutoSave ),
 	m_loadingProject( false ),
 	m_isCancelled( false ),
 	m_playMode( Mode_None ),
@@ -95,7 +224,10 @@ Song::Song() :
 	m_elapsedBars( 0 ),
 	m_loopRenderCount(1),
 	m_loopRenderRemaining(1),
-	m_oldAutomatedValues()
+	m_exportLoopFrames(0),
+	m_exportEffectiveFrames(0),
+	m_automationSchedule(),
+	m_tempoMap()
 {
 	for(int i = 0; i < Mode_Count; ++i) m_elapsedMilliSeconds[i] = 0;
 	connect( &m_tempoModel, SIGNAL( dataChanged() ),
@@ -124,6 +256,7 @@ Song::Song() :
 Song::~Song()
 {
 	m_playing = false;
+	waitForAutoSave();
 	delete m_globalAutomationTrack;
 }
 
@@ -199,7 +332,11 @@ void Song::processNextBuffer()
 	m_vstSyncController.setPlaybackJumped(false);
 
 	// If nothing is playing, there is nothing to do
-	if (!m_playing) { return; }
+	if (!m_playing)
+	{
+		m_midiSyncOutput.stop();
+		return;
+	}
 
 	// At the beginning of the song, we have to reset the LFOs
 	if (m_playMode == Mode_PlaySong && getPlayPos() == 0)
@@ -322,6 +459,13 @@ void Song::processNextBuffer()
 		// We want to proceed to the next buffer or tick, whichever is closer
 		const auto framesToPlay = std::min(framesUntilNextPeriod, framesUntilNextTick);
 
+		if (!m_exporting)
+		{
+			m_midiSyncOutput.play(getPlayPos().getTicks() + frameOffsetInTick / framesPerTick,
+				m_elapsedMilliSeconds[m_playMode] / 1000, framesPerTick,
+				framesToPlay, frameOffsetInPeriod);
+		}
+
 		if (frameOffsetInPeriod == 0)
 		{
 			// First frame of buffer: update VST sync position.
@@ -335,12 +479,28 @@ void Song::processNextBuffer()
 		if (static_cast<f_cnt_t>(frameOffsetInTick) == 0)
 		{
 			// First frame of tick: process automation and play tracks
-			processAutomations(trackList, getPlayPos(), framesToPlay);
+			processAutomations(trackList, getPlayPos(), framesToPlay, frameOffsetInPeriod);
 			for (const auto track : trackList)
 			{
 				track->play(getPlayPos(), framesToPlay, frameOffsetInPeriod, clipNum);
 			}
 		}
+		else if (frameOffsetInPeriod == 0 && m_playMode != Mode_PlayPattern)
+		{
+			// The tick began in the last period, continue its automation
+			m_automationSchedule.render(frameOffsetInTick / framesPerTick, 0, framesToPlay);
+		}
+
+		if (m_playMode == Mode_PlaySong)
+		{
+			// The renderings of frozen tracks are read continuously, also where
+			// a tick began in the last period. Those of the beat tracks cover
+			// all of them, including the tails after their patterns end.
+			const auto frame = static_cast<f_cnt_t>(getPlayPos().getTicks()
+				* static_cast<double>(framesPerTick) + frameOffsetInTick);
+			playFrozen(frame, framesToPlay, frameOffsetInPeriod);
+			Engine::getBBTrackContainer()->playFrozen(frame, framesToPlay, frameOffsetInPeriod);
+		}
 
 		// Update frame counters
 		frameOffsetInPeriod += framesToPlay;
@@ -353,10 +513,8 @@ void Song::processNextBuffer()
 }
 
 
-void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp_t)
+void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp_t frames, f_cnt_t offset)
 {
-	AutomatedValueMap values;
-
 	QSet<const AutomatableModel*> recordedModels;
 
 	TrackContainer* container = this;
@@ -380,9 +538,14 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 		return;
 	}
 
-	values = container->automatedValuesAt(timeStart, tcoNum);
 	TrackList tracks = container->tracks();
 
+	if (!m_automationSchedule.isCurrent(container, tcoNum))
+	{
+		m_automationSchedule.build(container, container == this ?
+			TrackList{m_globalAutomationTrack} << tracks : tracks, tcoNum);
+	}
+
 	Track::tcoVector tcos;
 	for (Track* track : tracks)
 	{
@@ -391,7 +554,8 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 		}
 	}
 
-	// Process recording
+	// Process recording; the values are added to the patterns on the GUI
+	// thread, along with every change made there or by MIDI in between
 	for (TrackContentObject* tco : tcos)
 	{
 		auto p = dynamic_cast<AutomationPattern *>(tco);
@@ -399,36 +563,16 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 		if (p->isRecording() && relTime >= 0 && relTime < p->length())
 		{
 			const AutomatableModel* recordedModel = p->firstObject();
-			p->recordValue(relTime, recordedModel->value<float>());
+			p->queueRecordedValue(relTime, recordedModel->value<float>());
 
 			recordedModels << recordedModel;
 		}
 	}
 
-	// Checks if an automated model stopped being automated by automation patterns
-	// so we can move the control back to any connected controller again
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
-	{
-		AutomatableModel * am = it.key();
-		if (am->controllerConnection() && !values.contains(am))
-		{
-			am->setUseControllerValue(true);
-		}
-	}
-	m_oldAutomatedValues = values;
-
-	// Apply values
-	for (auto it = values.begin(); it != values.end(); it++)
-	{
-		if (! recordedModels.contains(it.key()))
-		{
-			it.key()->setAutomatedValue(it.value());
-		}
-		else if (!it.key()->useControllerValue())
-		{
-			it.key()->setUseControllerValue(true);
-		}
-	}
+	// Apply values; models that stopped being automated by automation
+	// patterns go back to any connected controller
+	m_automationSchedule.apply(timeStart, recordedModels);
+	m_automationSchedule.render(0, offset, frames);
 }
 
 void Song::setModified(bool value)
@@ -446,33 +590,84 @@ bool Song::isExportDone() const
 }
 
 int Song::getExportProgress() const
+{
+	return exportedFraction() * 100.0;
+}
+
+
+
+
+double Song::exportedFraction() const
 {
 	TimePos pos = m_playPos[m_playMode];
-    
+	double frames;
+
 	if (pos >= m_exportSongEnd)
 	{
-		return 100;
+		return 1.0;
 	}
 	else if (pos <= m_exportSongBegin)
 	{
-		return 0;
+		return 0.0;
 	}
 	else if (pos >= m_exportLoopEnd)
 	{
-		pos = (m_exportLoopBegin-m_exportSongBegin) + (m_exportLoopEnd - m_exportLoopBegin) *
-			m_loopRenderCount + (pos - m_exportLoopEnd);
+		frames = framesBetween(m_exportSongBegin, m_exportLoopBegin) + m_exportLoopFrames *
+			m_loopRenderCount + framesBetween(m_exportLoopEnd, pos);
 	}
 	else if ( pos >= m_exportLoopBegin )
 	{
-		pos = (m_exportLoopBegin-m_exportSongBegin) + ((m_exportLoopEnd - m_exportLoopBegin) *
-			(m_loopRenderCount - m_loopRenderRemaining)) + (pos - m_exportLoopBegin);
+		frames = framesBetween(m_exportSongBegin, m_exportLoopBegin) + m_exportLoopFrames *
+			(m_loopRenderCount - m_loopRenderRemaining) + framesBetween(m_exportLoopBegin, pos);
 	}
 	else
 	{
-		pos = (pos - m_exportSongBegin);
+		frames = framesBetween(m_exportSongBegin, pos);
 	}
 
-	return (float)pos/(float)m_exportEffectiveLength*100.0f;
+	return frames / m_exportEffectiveFrames;
+}
+
+
+
+
+double Song::millisecondsAt(double ticks, PlayModes playMode) const
+{
+	// Only the song editor plays the tempo automation of the song
+	if (playMode != Mode_PlaySong)
+	{
+		return TimePos::ticksToMilliseconds(ticks, m_tempoModel.value<bpm_t>());
+	}
+
+	QMutexLocker lock(&m_tempoMapMutex);
+	updateTempoMap();
+	return m_tempoMap.millisecondsAt(ticks);
+}
+
+
+
+
+double Song::framesBetween(const TimePos& begin, const TimePos& end) const
+{
+	QMutexLocker lock(&m_tempoMapMutex);
+	updateTempoMap();
+	return m_tempoMap.framesBetween(begin.getTicks(), end.getTicks());
+}
+
+
+
+
+void Song::updateTempoMap() const
+{
+	const sample_rate_t sampleRate = Engine::mixer()->processingSampleRate();
+	if (m_tempoMap.isCurrent(&m_tempoModel, sampleRate))
+	{
+		return;
+	}
+
+	AutomationSchedule schedule;
+	schedule.build(this, TrackList{m_globalAutomationTrack} << tracks());
+	m_tempoMap.build(schedule, &m_tempoModel, sampleRate);
 }
 
 void Song::playSong()
@@ -568,7 +763,7 @@ void Song::updateLength()
 	m_tracksMutex.lockForRead();
 	for (auto track : tracks())
 	{
-		if (m_exporting && track->isMuted())
+		if (m_exporting && (track->isMuted() || track->isBypassed()))
 		{
 			continue;
 		}
@@ -591,7 +786,7 @@ void Song::setPlayPos( tick_t ticks, PlayModes playMode )
 {
 	tick_t ticksFromPlayMode = m_playPos[playMode].getTicks();
 	m_elapsedTicks += ticksFromPlayMode - ticks;
-	m_elapsedMilliSeconds[playMode] += TimePos::ticksToMilliseconds( ticks - ticksFromPlayMode, getTempo() );
+	m_elapsedMilliSeconds[playMode] = millisecondsAt( ticks, playMode );
 	m_playPos[playMode].setTicks( ticks );
 	m_playPos[playMode].setCurrentFrame( 0.0f );
 	m_playPos[playMode].setJumped( true );
@@ -689,12 +884,7 @@ void Song::stop()
 
 	// Moves the control of the models that were processed on the last frame
 	// back to their controllers.
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
-	{
-		AutomatableModel * am = it.key();
-		am->setUseControllerValue(true);
-	}
-	m_oldAutomatedValues.clear();
+	m_automationSchedule.release();
 
 	m_playMode = Mode_None;
 
@@ -712,9 +902,17 @@ void Song::startExport()
 	stop();
 
 	m_exporting = true;
+	updateBypassedTracks();
 	updateLength();
 
-	if (m_renderBetweenMarkers)
+	if (hasExportRange())
+	{
+		m_exportSongBegin = m_exportLoopBegin = m_exportLoopEnd = m_exportRangeBegin;
+		m_exportSongEnd = m_exportRangeEnd;
+
+		m_playPos[Mode_PlaySong].setTicks( m_exportRangeBegin.getTicks() );
+	}
+	else if (m_renderBetweenMarkers)
 	{
 		m_exportSongBegin = m_exportLoopBegin = m_playPos[Mode_PlaySong].m_timeLine->loopBegin();
 		m_exportSongEnd = m_exportLoopEnd = m_playPos[Mode_PlaySong].m_timeLine->loopEnd();
@@ -749,8 +947,9 @@ void Song::startExport()
 		m_playPos[Mode_PlaySong].setTicks( 0 );
 	}
 
-	m_exportEffectiveLength = (m_exportLoopBegin - m_exportSongBegin) + (m_exportLoopEnd - m_exportLoopBegin) 
-		* m_loopRenderCount + (m_exportSongEnd - m_exportLoopEnd);
+	m_exportLoopFrames = framesBetween(m_exportLoopBegin, m_exportLoopEnd);
+	m_exportEffectiveFrames = framesBetween(m_exportSongBegin, m_exportLoopBegin) + m_exportLoopFrames
+		* m_loopRenderCount + framesBetween(m_exportLoopEnd, m_exportSongEnd);
 	m_loopRenderRemaining = m_loopRenderCount;
 
 	playSong();
@@ -765,6 +964,7 @@ void Song::stopExport()
 {
 	stop();
 	m_exporting = false;
+	updateBypassedTracks();
 
 	m_vstSyncController.setPlaybackState( m_playing );
 }
@@ -772,6 +972,21 @@ void Song::stopExport()
 
 
 
+void Song::updateBypassedTracks()
+{
+	const TrackContainer * containers[] = { this, Engine::getBBTrackContainer() };
+	for( const TrackContainer * container : containers )
+	{
+		for( Track * track : container->tracks() )
+		{
+			track->setBypassed( m_exporting && !isAudible( track ) );
+		}
+	}
+}
+
+
+
+
 void Song::insertBar()
 {
 	m_tracksMutex.lockForRead();
@@ -851,6 +1066,8 @@ void Song::clearProject()
 {
 	Engine::projectJournal()->setJournalling( false );
 
+	resetAutoSave();
+
 	if( m_playing )
 	{
 		stop();
@@ -897,8 +1114,8 @@ void Song::clearProject()
 	m_masterPitchModel.reset();
 	m_timeSigModel.reset();
 
-	// Clear the m_oldAutomatedValues AutomatedValueMap
-	m_oldAutomatedValues.clear();
+	// Forget the automation of the old project
+	m_automationSchedule.clear();
 
 	AutomationPattern::globalAutomationPattern( &m_tempoModel )->clear();
 	AutomationPattern::globalAutomationPattern( &m_masterVolumeModel )->
@@ -972,6 +1189,7 @@ void Song::createNewProject()
 	m_timeSigModel.reset();
 	m_masterVolumeModel.setInitValue( 100 );
 	m_masterPitchModel.setInitValue( 0 );
+	SampleBuffer::setCompressionEnabled( false );
 
 	QCoreApplication::instance()->processEvents();
 
@@ -1009,6 +1227,8 @@ void Song::loadProject( const QString & fileName )
 {
 	QDomNode node;
 
+	PerfTimeline::Phase loadPhase( "Load project" );
+
 	m_loadingProject = true;
 
 	Engine::projectJournal()->setJournalling( false );
@@ -1016,7 +1236,11 @@ void Song::loadProject( const QString & fileName )
 	m_oldFileName = m_fileName;
 	setProjectFileName(fileName);
 
-	DataFile dataFile( m_fileName );
+	// projects which need no upgrading are read track by track
+	PerfTimeline::Phase parsePhase( "Parse" );
+	ProjectStream project( m_fileName );
+	DataFile & dataFile = project.dataFile();
+	parsePhase.finish();
 
 	bool cantLoadProject = false;
 	// if file could not be opened, head-node is null and we create
@@ -1029,7 +1253,7 @@ void Song::loadProject( const QString & fileName )
 	{
 		// We check if plugins contain local paths to prevent malicious code being
 		// added to project bundles and loaded with "local:" paths
-		if (dataFile.hasLocalPlugins())
+		if (project.hasLocalPlugins())
 		{
 			cantLoadProject = true;
 
@@ -1059,10 +1283,17 @@ void Song::loadProject( const QString & fileName )
 
 	m_oldFileName = m_fileName;
 
+	PerfTimeline::Phase clearPhase( "Clear project" );
 	clearProject();
+	clearPhase.finish();
 
 	clearErrors();
 
+	// decode the samples on the other cores while the tracks are created
+	SampleBuffer::prefetchFiles(project.resourceFiles("sampletco"), true);
+	SampleBuffer::prefetchFiles(project.resourceFiles("audiofileprocessor"), false);
+	project.readAheadPluginFiles();
+
 	Engine::mixer()->requestChangeInModel();
 
 	// get the header information from the DOM
@@ -1070,6 +1301,9 @@ void Song::loadProject( const QString & fileName )
 	m_timeSigModel.loadSettings( dataFile.head(), "timesig" );
 	m_masterVolumeModel.loadSettings( dataFile.head(), "mastervol" );
 	m_masterPitchModel.loadSettings( dataFile.head(), "masterpitch" );
+	// before the instruments load their samples
+	SampleBuffer::setCompressionEnabled(
+		dataFile.head().attribute( "compresssamples" ).toInt() );
 
 	if( m_playPos[Mode_PlaySong].m_timeLine )
 	{
@@ -1100,25 +1334,7 @@ void Song::loadProject( const QString & fileName )
 
 	node = dataFile.content().firstChild();
 
-	QDomNodeList tclist=dataFile.content().elementsByTagName("trackcontainer");
-	m_nLoadingTrack=0;
-	for( int i=0,n=tclist.count(); i<n; ++i )
-	{
-		QDomNode nd=tclist.at(i).firstChild();
-		while(!nd.isNull())
-		{
-			if( nd.isElement() && nd.nodeName() == "track" )
-			{
-				++m_nLoadingTrack;
-				if( nd.toElement().attribute("type").toInt() == Track::BBTrack )
-				{
-					n += nd.toElement().elementsByTagName("bbtrack").at(0)
-						.toElement().firstChildElement().childNodes().count();
-				}
-				nd=nd.nextSibling();
-			}
-		}
-	}
+	m_nLoadingTrack = project.trackCount();
 
 	while( !node.isNull() && !isCancelled() )
 	{
@@ -1127,6 +1343,8 @@ void Song::loadProject( const QString & fileName )
 			if( node.nodeName() == "trackcontainer" )
 			{
 				( (JournallingObject *)( this ) )->restoreState( node.toElement() );
+				// the tracks left out of the DOM
+				loadTracks( [&project]() { return project.nextTrack(); } );
 			}
 			else if( node.nodeName() == "controllers" )
 			{
@@ -1175,6 +1393,8 @@ void Song::loadProject( const QString & fileName )
 	// resolve all IDs so that autoModels are automated
 	AutomationPattern::resolveAllIDs();
 
+	// the samples no track has loaded aren't needed anymore
+	SampleCache::releasePrefetched();
 
 	Engine::mixer()->doneChangeInModel();
 
@@ -1184,6 +1404,10 @@ void Song::loadProject( const QString & fileName )
 
 	emit projectLoaded();
 
+	// not the time the error report is shown
+	loadPhase.finish();
+	PerfTimeline::report();
+
 	if( isCancelled() )
 	{
 		m_isCancelled = false;
@@ -1218,12 +1442,144 @@ void Song::loadProject( const QString & fileName )
 bool Song::saveProjectFile(const QString & filename, bool withResources)
 {
 	DataFile dataFile( DataFile::SongProject );
+	// embedded samples are stored next to the XML
+	dataFile.setStoresBinary( DataFile::isBinaryProject(
+					dataFile.nameWithExtension( filename ) ) );
+
+	saveProject( dataFile );
+
+	return dataFile.writeFile(filename, withResources);
+}
+
+
+
+
+bool Song::autoSaveProjectFile( const QString & filename )
+{
+	AutoSave & autoSave = *m_autoSave;
+	if( autoSave.writing )
+	{
+		return false;
+	}
+
+	autoSave.changed = Engine::projectJournal()->takeChangedIDs();
+	const bool full = autoSave.dataFile == nullptr ||
+			autoSave.sinceFullSave.hasExpired( FullAutoSaveInterval );
+	if( !full && autoSave.changed.isEmpty() )
+	{
+		// the file is up to date
+		return true;
+	}
+
+	if( full )
+	{
+		autoSave.dataFile = std::make_shared<DataFile>( DataFile::SongProject );
+		autoSave.tracks.clear();
+		autoSave.sinceFullSave.start();
+	}
+	else
+	{
+		// the tracks that are kept are moved into the new content
+		clearElement( autoSave.dataFile->head() );
+		clearElement( autoSave.dataFile->content() );
+	}
+
+	autoSave.saving = true;
+	saveProject( *autoSave.dataFile );
+	autoSave.saving = false;
+
+	// forget the tracks which are gone
+	for( auto it = autoSave.tracks.begin(); it != autoSave.tracks.end(); )
+	{
+		if( autoSave.saved.contains( it.key() ) )
+		{
+			++it;
+		}
+		else
+		{
+			it = autoSave.tracks.erase( it );
+		}
+	}
+	autoSave.saved.clear();
+	autoSave.changed.clear();
+
+	autoSave.writing = true;
+	autoSave.writer.start( new RecoveryFileWriter( autoSave.dataFile,
+						filename, autoSave.writing ) );
+	return true;
+}
+
+
+
+
+void Song::waitForAutoSave()
+{
+	m_autoSave->writer.waitForDone();
+}
+
+
+
+
+void Song::resetAutoSave()
+{
+	waitForAutoSave();
+	m_autoSave->dataFile.reset();
+	m_autoSave->tracks.clear();
+	// changes to the project before don't matter anymore
+	Engine::projectJournal()->takeChangedIDs();
+}
+
+
+
+
+void Song::saveTrack( Track * track, QDomDocument & doc, QDomElement & parent )
+{
+	AutoSave & autoSave = *m_autoSave;
+	if( !autoSave.saving )
+	{
+		TrackContainer::saveTrack( track, doc, parent );
+		return;
+	}
+
+	const jo_id_t id = track->id();
+	autoSave.saved.insert( id );
+
+	// BB tracks are always saved, as the first one holds the BB editor
+	const auto it = autoSave.tracks.find( id );
+	if( it != autoSave.tracks.end() && !autoSave.changed.contains( id ) &&
+					track->type() != Track::BBTrack )
+	{
+		parent.appendChild( *it );
+		return;
+	}
+
+	const QDomElement previous = parent.lastChildElement();
+	track->saveState( doc, parent );
+	if( parent.lastChildElement() != previous )
+	{
+		autoSave.tracks[id] = parent.lastChildElement();
+	}
+	else
+	{
+		autoSave.tracks.remove( id );
+	}
+}
+
+
+
+
+void Song::saveProject( DataFile & dataFile )
+{
 	m_savingProject = true;
 
 	m_tempoModel.saveSettings( dataFile, dataFile.head(), "bpm" );
 	m_timeSigModel.saveSettings( dataFile, dataFile.head(), "timesig" );
 	m_masterVolumeModel.saveSettings( dataFile, dataFile.head(), "mastervol" );
 	m_masterPitchModel.saveSettings( dataFile, dataFile.head(), "masterpitch" );
+	if( SampleBuffer::compressionEnabled() )
+	{
+		dataFile.head().setAttribute( "compresssamples", 1 );
+	}
 
 	saveState( dataFile, dataFile.content() );
 
@@ -1241,8 +1597,6 @@ bool Song::saveProjectFile(const QString & filename, bool withResources)
 	saveControllerStates( dataFile, dataFile.content() );
 
 	m_savingProject = false;
-
-	return dataFile.writeFile(filename, withResources);
 }
 
 
@@ -1362,6 +1716,26 @@ void Song::setModified()
 	setModified(true);
 }
 
+
+
+
+bool Song::compressSamples() const
+{
+	return SampleBuffer::compressionEnabled();
+}
+
+
+
+
+void Song::setCompressSamples(bool compress)
+{
+	if (compress != compressSamples())
+	{
+		SampleBuffer::setCompressionEnabled(compress);
+		setModified();
+	}
+}
+
 void Song::setProjectFileName(QString const & projectFileName)
 {
 	if (m_fileName != projectFileName)
@@ -228,10 +228,12 @@ void StepRecorder::applyStep()
 {
 	m_pattern->addJournalCheckPoint();
 
+	QVector<Note> notes;
 	for (const StepNote* stepNote : m_curStepNotes)
 	{
-		m_pattern->addNote(stepNote->m_note, false);
+		notes.push_back(stepNote->m_note);
 	}
+	m_pattern->addNotes(notes);
 
 	m_pattern->rearrangeAllNotes();
 	m_pattern->updateLength();
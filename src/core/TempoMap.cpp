@@ -0,0 +1,167 @@
+/*
+ * TempoMap.cpp - the tempo of a song over time
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "TempoMap.h"
+
+#include <algorithm>
+
+#include "AutomatableModel.h"
+#include "AutomationPattern.h"
+#include "AutomationSchedule.h"
+#include "Song.h"
+
+
+TempoMap::TempoMap(sample_rate_t sampleRate) :
+	m_sampleRate(sampleRate),
+	m_automated(false),
+	m_scheduleRevision(0),
+	m_editRevision(0)
+{
+	append(0, DefaultTempo);
+}
+
+
+
+
+void TempoMap::build(AutomationSchedule& schedule, const AutomatableModel* tempoModel,
+							sample_rate_t sampleRate)
+{
+	m_segments.clear();
+	m_sampleRate = sampleRate;
+	m_scheduleRevision = AutomationSchedule::revision();
+	m_editRevision = AutomationPattern::editRevision();
+
+	bpm_t tempo = tempoModel->value<bpm_t>();
+	append(0, tempo);
+
+	const int slot = schedule.slotOf(tempoModel);
+	m_automated = slot >= 0;
+	if (!m_automated)
+	{
+		return;
+	}
+
+	// After the end of the last TCO, the tempo stays as it is there
+	const tick_t end = schedule.endOf(slot);
+	for (tick_t tick = 0; tick <= end; ++tick)
+	{
+		float value;
+		if (schedule.valueAt(slot, tick, value))
+		{
+			tempo = static_cast<bpm_t>(tempoModel->automatedValueOf(value));
+		}
+		append(tick, tempo);
+	}
+}
+
+
+
+
+bool TempoMap::isCurrent(const AutomatableModel* tempoModel, sample_rate_t sampleRate) const
+{
+	if (sampleRate != m_sampleRate
+		|| AutomationSchedule::revision() != m_scheduleRevision)
+	{
+		return false;
+	}
+	if (m_automated)
+	{
+		return AutomationPattern::editRevision() == m_editRevision;
+	}
+	// The tempo model changes while playing the automation, so it only
+	// matters if nothing automates it
+	return tempoModel->value<bpm_t>() == m_segments.front().tempo;
+}
+
+
+
+
+double TempoMap::framesAt(double ticks) const
+{
+	const Segment& segment = segmentAt(ticks);
+	return segment.frame + (ticks - segment.tick) * segment.framesPerTick;
+}
+
+
+
+
+double TempoMap::ticksAt(double frames) const
+{
+	auto it = std::upper_bound(m_segments.begin() + 1, m_segments.end(), frames,
+		[](double frames, const Segment& segment)
+		{
+			return frames < segment.frame;
+		});
+	const Segment& segment = *(it - 1);
+	return segment.tick + (frames - segment.frame) / segment.framesPerTick;
+}
+
+
+
+
+bpm_t TempoMap::tempoAt(tick_t ticks) const
+{
+	return segmentAt(ticks).tempo;
+}
+
+
+
+
+void TempoMap::append(tick_t tick, bpm_t tempo)
+{
+	if (m_segments.empty())
+	{
+		m_segments.push_back({tick, 0.0, framesPerTick(m_sampleRate, tempo), tempo});
+		return;
+	}
+
+	const Segment& last = m_segments.back();
+	if (last.tempo == tempo)
+	{
+		return;
+	}
+	const double frame = last.frame
+		+ static_cast<double>(tick - last.tick) * last.framesPerTick;
+	if (last.tick == tick)
+	{
+		m_segments.back() = {tick, frame, framesPerTick(m_sampleRate, tempo), tempo};
+		return;
+	}
+	m_segments.push_back({tick, frame, framesPerTick(m_sampleRate, tempo), tempo});
+}
+
+
+
+
+const TempoMap::Segment& TempoMap::segmentAt(double ticks) const
+{
+	// Ticks before 0 are counted at the first tempo
+	auto it = std::upper_bound(m_segments.begin() + 1, m_segments.end(), ticks,
+		[](double ticks, const Segment& segment)
+		{
+			return ticks < segment.tick;
+		});
+	return *(it - 1);
+}
@@ -31,6 +31,7 @@
 
 #include <QVariant>
 
+#include "AutomationSchedule.h"
 #include "AutomationPattern.h"
 #include "AutomationTrack.h"
 #include "BBTrack.h"
@@ -59,6 +60,7 @@ Track::Track( TrackTypes type, TrackContainer * tc ) :
 	m_name(),                       /*!< The track's name */
 	m_mutedModel( false, this, tr( "Mute" ) ), /*!< For controlling track muting */
 	m_soloModel( false, this, tr( "Solo" ) ), /*!< For controlling track soloing */
+	m_bypassed( false ),
 	m_simpleSerializingMode( false ),
 	m_trackContentObjects(),        /*!< The track content objects (segments) */
 	m_color( 0, 0, 0 ),
@@ -334,6 +336,7 @@ void Track::loadSettings( const QDomElement & element )
 TrackContentObject * Track::addTCO( TrackContentObject * tco )
 {
 	m_trackContentObjects.push_back( tco );
+	AutomationSchedule::arrangementChanged();
 
 	emit trackContentObjectAdded( tco );
 
@@ -355,6 +358,7 @@ void Track::removeTCO( TrackContentObject * tco )
 	if( it != m_trackContentObjects.end() )
 	{
 		m_trackContentObjects.erase( it );
+		AutomationSchedule::arrangementChanged();
 		if( Engine::getSong() )
 		{
 			Engine::getSong()->updateLength();
@@ -672,3 +676,8 @@ BoolModel *Track::getMutedModel()
 	return &m_mutedModel;
 }
 
+BoolModel *Track::getSoloModel()
+{
+	return &m_soloModel;
+}
+
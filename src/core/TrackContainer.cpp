@@ -30,12 +30,15 @@
 #include <QWriteLocker>
 
 #include "AutomationPattern.h"
+#include "AutomationSchedule.h"
 #include "AutomationTrack.h"
 #include "BBTrack.h"
 #include "BBTrackContainer.h"
 #include "embed.h"
 #include "TrackContainer.h"
 #include "InstrumentTrack.h"
+#include "PerfLog.h"
+#include "SampleCache.h"
 #include "Song.h"
 
 #include "GuiApplication.h"
@@ -70,7 +73,7 @@ void TrackContainer::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	m_tracksMutex.lockForRead();
 	for( int i = 0; i < m_tracks.size(); ++i )
 	{
-		m_tracks[i]->saveState( _doc, _this );
+		saveTrack( m_tracks[i], _doc, _this );
 	}
 	m_tracksMutex.unlock();
 }
@@ -78,6 +81,15 @@ void TrackContainer::saveSettings( QDomDocument & _doc, QDomElement & _this )
 
 
 
+void TrackContainer::saveTrack( Track * track, QDomDocument & doc,
+							QDomElement & parent )
+{
+	track->saveState( doc, parent );
+}
+
+
+
+
 void TrackContainer::loadSettings( const QDomElement & _this )
 {
 	bool journalRestore = _this.parentNode().nodeName() == "journaldata";
@@ -86,11 +98,34 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 		clearAllTracks();
 	}
 
+	QDomNode node = _this.firstChild();
+	loadTracks( [&node]()
+		{
+			while( !node.isNull() && !node.isElement() )
+			{
+				node = node.nextSibling();
+			}
+			const QDomElement track = node.toElement();
+			node = node.nextSibling();
+			return track;
+		}, !journalRestore );
+}
+
+
+
+
+void TrackContainer::loadTracks( const std::function<QDomElement()> & nextTrack,
+							bool showProgress )
+{
 	static QProgressDialog * pd = NULL;
 	bool was_null = ( pd == NULL );
-	if( !journalRestore && gui != nullptr )
+
+	for( QDomElement track = nextTrack(); !track.isNull();
+							track = nextTrack() )
 	{
-		if( pd == NULL )
+		// created with the first track, so containers without any
+		// don't flash it
+		if( showProgress && gui != nullptr && pd == NULL )
 		{
 			pd = new QProgressDialog( tr( "Loading project..." ),
 						tr( "Cancel" ), 0,
@@ -100,11 +135,7 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 			pd->setWindowTitle( tr( "Please wait..." ) );
 			pd->show();
 		}
-	}
 
-	QDomNode node = _this.firstChild();
-	while( !node.isNull() )
-	{
 		if( pd != NULL )
 		{
 			pd->setValue( pd->value() + 1 );
@@ -124,20 +155,25 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 			}
 		}
 
-		if( node.isElement() &&
-			!node.toElement().attribute( "metadata" ).toInt() )
+		if( !track.attribute( "metadata" ).toInt() )
 		{
-			QString trackName = node.toElement().hasAttribute( "name" ) ?
-						node.toElement().attribute( "name" ) :
-						node.firstChild().toElement().attribute( "name" );
+			QString trackName = track.hasAttribute( "name" ) ?
+						track.attribute( "name" ) :
+						track.firstChild().toElement().attribute( "name" );
 			if( pd != NULL )
 			{
-				pd->setLabelText( tr("Loading Track %1 (%2/Total %3)").arg( trackName ).
-						  arg( pd->value() + 1 ).arg( Engine::getSong()->getLoadingTrackCount() ) );
+				QString label = tr("Loading Track %1 (%2/Total %3)").arg( trackName ).
+						  arg( pd->value() + 1 ).arg( Engine::getSong()->getLoadingTrackCount() );
+				const int decoding = SampleCache::pendingFiles();
+				if( decoding > 0 )
+				{
+					label += "\n" + tr( "Decoding %1 samples" ).arg( decoding );
+				}
+				pd->setLabelText( label );
 			}
-			Track::create( node.toElement(), this );
+			PerfTimeline::Phase phase( "Track" );
+			Track::create( track, this );
 		}
-		node = node.nextSibling();
 	}
 
 	if( pd != NULL )
@@ -179,6 +215,7 @@ void TrackContainer::addTrack( Track * _track )
 		m_tracksMutex.lockForWrite();
 		m_tracks.push_back( _track );
 		m_tracksMutex.unlock();
+		AutomationSchedule::arrangementChanged();
 		_track->unlock();
 		emit trackAdded( _track );
 	}
@@ -202,6 +239,7 @@ void TrackContainer::removeTrack( Track * _track )
 		}
 		m_tracks.remove( index );
 		lockTracksAccess.unlock();
+		AutomationSchedule::arrangementChanged();
 
 		if( Engine::getSong() )
 		{
@@ -248,6 +286,20 @@ bool TrackContainer::isEmpty() const
 
 
 
+void TrackContainer::playFrozen( f_cnt_t frame, fpp_t frames, f_cnt_t offset )
+{
+	for( Track * track : m_tracks )
+	{
+		if( track->type() == Track::InstrumentTrack )
+		{
+			static_cast<InstrumentTrack *>( track )->playFrozen(
+							frame, frames, offset );
+		}
+	}
+}
+
+
+
 AutomatedValueMap TrackContainer::automatedValuesAt(TimePos time, int tcoNum) const
 {
 	return automatedValuesFromTracks(tracks(), time, tcoNum);
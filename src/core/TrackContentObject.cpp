@@ -28,6 +28,7 @@
 
 #include "AutomationEditor.h"
 #include "AutomationPattern.h"
+#include "AutomationSchedule.h"
 #include "Engine.h"
 #include "GuiApplication.h"
 #include "Song.h"
@@ -94,6 +95,7 @@ void TrackContentObject::movePosition( const TimePos & pos )
 	{
 		Engine::mixer()->requestChangeInModel();
 		m_startPosition = newPos;
+		AutomationSchedule::arrangementChanged();
 		Engine::mixer()->doneChangeInModel();
 		Engine::getSong()->updateLength();
 		emit positionChanged();
@@ -113,6 +115,7 @@ void TrackContentObject::movePosition( const TimePos & pos )
 void TrackContentObject::changeLength( const TimePos & length )
 {
 	m_length = length;
+	AutomationSchedule::arrangementChanged();
 	Engine::getSong()->updateLength();
 	emit lengthChanged();
 }
@@ -0,0 +1,133 @@
+/*
+ * VisualizationTap.cpp - hands a reduced picture of audio to a view
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "VisualizationTap.h"
+
+#include <algorithm>
+
+
+const int VisualizationTap::MaxPoints;
+const int VisualizationTap::FreshBit;
+
+
+VisualizationTap::VisualizationTap(int points) :
+	m_back(0),
+	m_backFilled(false),
+	m_middle(1),
+	m_front(2),
+	m_points(std::min(std::max(points, 1), MaxPoints)),
+	m_views(0)
+{
+	for (Snapshot *& slot : m_slots)
+	{
+		slot = new Snapshot;
+		slot->points = 0;
+		slot->frames = 0;
+		slot->framesPerPoint = 1;
+	}
+}
+
+
+
+
+VisualizationTap::~VisualizationTap()
+{
+	for (Snapshot * slot : m_slots)
+	{
+		delete slot;
+	}
+}
+
+
+
+
+void VisualizationTap::setPoints(int points)
+{
+	m_points.store(std::min(std::max(points, 1), MaxPoints), std::memory_order_relaxed);
+}
+
+
+
+
+void VisualizationTap::write(const sampleFrame * buf, f_cnt_t frames, bool accumulate)
+{
+	if (!enabled() || frames <= 0)
+	{
+		return;
+	}
+
+	Snapshot * s = m_slots[m_back];
+	if (!accumulate || !m_backFilled)
+	{
+		s->points = 0;
+		s->frames = 0;
+	}
+
+	const int points = m_points.load(std::memory_order_relaxed);
+	const f_cnt_t stride = (frames + points - 1) / points;
+	for (f_cnt_t f = 0; f < frames && s->points < MaxPoints; f += stride)
+	{
+		const f_cnt_t end = std::min(f + stride, frames);
+		sampleFrame & lo = s->min[s->points];
+		sampleFrame & hi = s->max[s->points];
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			s->first[s->points][ch] = lo[ch] = hi[ch] = buf[f][ch];
+		}
+		for (f_cnt_t g = f + 1; g < end; ++g)
+		{
+			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				lo[ch] = std::min(lo[ch], buf[g][ch]);
+				hi[ch] = std::max(hi[ch], buf[g][ch]);
+			}
+		}
+		++s->points;
+	}
+	s->frames += frames;
+	s->framesPerPoint = stride;
+
+	// when accumulating, keep adding to the snapshot until the reader has
+	// taken the previous one
+	if (accumulate && (m_middle.load(std::memory_order_acquire) & FreshBit))
+	{
+		m_backFilled = true;
+		return;
+	}
+	m_back = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel) & ~FreshBit;
+	m_backFilled = false;
+}
+
+
+
+
+const VisualizationTap::Snapshot * VisualizationTap::read()
+{
+	if (!(m_middle.load(std::memory_order_acquire) & FreshBit))
+	{
+		return nullptr;
+	}
+	m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~FreshBit;
+	return m_slots[m_front];
+}
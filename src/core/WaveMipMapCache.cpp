@@ -0,0 +1,146 @@
+/*
+ * WaveMipMapCache.cpp - band-limited mipmaps of arbitrary waveforms
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "WaveMipMapCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "FftAnalysis.h"
+
+
+const int WaveMipMapCache::ShapeLength;
+
+QMutex WaveMipMapCache::s_mutex;
+std::vector<WaveMipMapCache::Entry> WaveMipMapCache::s_entries;
+
+
+namespace
+{
+
+// 64 bit FNV-1a
+quint64 waveHash(const float * wave, int length)
+{
+	const unsigned char * data = reinterpret_cast<const unsigned char *>(wave);
+	quint64 hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length * sizeof(float); ++i)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+}
+
+
+
+
+WaveMipMapCache::MipMapPtr WaveMipMapCache::get(const float * wave, int length)
+{
+	const quint64 hash = waveHash(wave, length);
+
+	QMutexLocker lock(&s_mutex);
+	s_entries.erase(std::remove_if(s_entries.begin(), s_entries.end(),
+		[](const Entry & entry) { return entry.mipMap.expired(); }),
+		s_entries.end());
+	for (const Entry & entry : s_entries)
+	{
+		if (entry.hash == hash && entry.wave.size() == static_cast<size_t>(length) &&
+			std::equal(entry.wave.begin(), entry.wave.end(), wave))
+		{
+			MipMapPtr mipMap = entry.mipMap.lock();
+			if (mipMap)
+			{
+				return mipMap;
+			}
+		}
+	}
+
+	// built under the lock, so a waveform is never built twice
+	MipMapPtr mipMap = build(wave, length);
+	s_entries.push_back(Entry{hash, std::vector<float>(wave, wave + length), mipMap});
+	return mipMap;
+}
+
+
+
+
+WaveMipMapCache::MipMapPtr WaveMipMapCache::get(Oscillator::WaveShapes shape)
+{
+	if (shape == Oscillator::WhiteNoise || shape >= Oscillator::UserDefinedWave)
+	{
+		return nullptr;
+	}
+
+	std::vector<float> wave(ShapeLength);
+	for (int i = 0; i < ShapeLength; ++i)
+	{
+		wave[i] = static_cast<float>(i) / ShapeLength;
+	}
+	Oscillator::waveBlock(shape, wave.data(), wave.data(), ShapeLength);
+	return get(wave.data(), ShapeLength);
+}
+
+
+
+
+WaveMipMapCache::MipMapPtr WaveMipMapCache::build(const float * wave, int length)
+{
+	const int bins = length / 2 + 1;
+	float * in = fftwf_alloc_real(qMax(length, MAXTLEN));
+	fftwf_complex * spectrum = fftwf_alloc_complex(bins);
+	fftwf_complex * harmonics = fftwf_alloc_complex((MAXTLEN) / 2 + 1);
+
+	std::copy(wave, wave + length, in);
+	FftAnalysis::execute(length, in, spectrum);
+
+	WaveMipMap * mipMap = new WaveMipMap;
+	for (int t = 0; t <= MAXTBL; ++t)
+	{
+		// the harmonics below half the table length, and below what the
+		// wave holds; the DC is kept as it is
+		const int tlen = TLENS[t];
+		const int kept = qMin((tlen + 1) / 2, (length + 1) / 2);
+		memset(harmonics, 0, (tlen / 2 + 1) * sizeof(fftwf_complex));
+		for (int h = 0; h < kept; ++h)
+		{
+			harmonics[h][0] = spectrum[h][0] / length;
+			harmonics[h][1] = spectrum[h][1] / length;
+		}
+
+		// the inverse transform isn't normalized, which cancels with the
+		// division by the length of the wave
+		fftwf_execute_dft_c2r(FftAnalysis::inversePlan(tlen), harmonics, in);
+		for (int i = 0; i < tlen; ++i)
+		{
+			mipMap->setSampleAt(t, i, in[i]);
+		}
+	}
+
+	fftwf_free(in);
+	fftwf_free(spectrum);
+	fftwf_free(harmonics);
+	return MipMapPtr(mipMap);
+}
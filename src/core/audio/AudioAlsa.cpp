@@ -44,7 +44,10 @@ AudioAlsa::AudioAlsa( bool & _success_ful, Mixer*  _mixer ) :
 	m_handle( NULL ),
 	m_hwParams( NULL ),
 	m_swParams( NULL ),
-	m_convertEndian( false )
+	m_convertEndian( false ),
+	m_mmap( ConfigManager::inst()->value( "audioalsa", "mmap" ).toInt() ),
+	m_format( FormatS16 ),
+	m_delay( -1 )
 {
 	_success_ful = false;
 
@@ -68,17 +71,8 @@ AudioAlsa::AudioAlsa( bool & _success_ful, Mixer*  _mixer ) :
 	snd_pcm_hw_params_malloc( &m_hwParams );
 	snd_pcm_sw_params_malloc( &m_swParams );
 
-	if( ( err = setHWParams( channels(),
-					SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 )
+	if( setParams() < 0 )
 	{
-		printf( "Setting of hwparams failed: %s\n",
-							snd_strerror( err ) );
-		return;
-	}
-	if( ( err = setSWParams() ) < 0 )
-	{
-		printf( "Setting of swparams failed: %s\n",
-							snd_strerror( err ) );
 		return;
 	}
 
@@ -201,6 +195,7 @@ int AudioAlsa::handleError( int _err )
 	if( _err == -EPIPE )
 	{
 		// under-run
+		reportUnderrun();
 		_err = snd_pcm_prepare( m_handle );
 		if( _err < 0 )
 			printf( "Can't recover from underrun, prepare "
@@ -273,17 +268,8 @@ void AudioAlsa::applyQualitySettings()
 			return;
 		}
 
-		if( ( err = setHWParams( channels(),
-					SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 )
+		if( setParams() < 0 )
 		{
-			printf( "Setting of hwparams failed: %s\n",
-							snd_strerror( err ) );
-			return;
-		}
-		if( ( err = setSWParams() ) < 0 )
-		{
-			printf( "Setting of swparams failed: %s\n",
-							snd_strerror( err ) );
 			return;
 		}
 	}
@@ -296,6 +282,12 @@ void AudioAlsa::applyQualitySettings()
 
 void AudioAlsa::run()
 {
+	if( m_mmap )
+	{
+		runMmap();
+		return;
+	}
+
 	surroundSampleFrame * temp =
 		new surroundSampleFrame[mixer()->framesPerPeriod()];
 	int_sample_t * outbuf =
@@ -365,6 +357,7 @@ void AudioAlsa::run()
 			ptr += err * channels();
 			frames -= err;
 		}
+		updateDelay();
 	}
 
 	delete[] temp;
@@ -375,6 +368,209 @@ void AudioAlsa::run()
 
 
 
+void AudioAlsa::runMmap()
+{
+	surroundSampleFrame * temp =
+		new surroundSampleFrame[mixer()->framesPerPeriod()];
+	const int frameBytes = snd_pcm_format_physical_width(
+		m_format == FormatFloat ? SND_PCM_FORMAT_FLOAT :
+		m_format == FormatS32 ? SND_PCM_FORMAT_S32 :
+					SND_PCM_FORMAT_S16 ) / 8 * channels();
+
+	// frames of temp not written yet
+	fpp_t tempFrames = 0;
+	fpp_t tempPos = 0;
+
+	bool quit = false;
+	while( quit == false )
+	{
+		snd_pcm_sframes_t avail = snd_pcm_avail_update( m_handle );
+		if( avail < 0 )
+		{
+			if( handleError( avail ) < 0 )
+			{
+				printf( "Avail update error: %s\n",
+						snd_strerror( avail ) );
+				break;
+			}
+			continue;
+		}
+
+		if( static_cast<snd_pcm_uframes_t>( avail ) < m_periodSize )
+		{
+			if( snd_pcm_state( m_handle ) != SND_PCM_STATE_RUNNING )
+			{
+				// the ring is full, but the transfer did not
+				// start on its own
+				const int err = snd_pcm_start( m_handle );
+				if( err < 0 && handleError( err ) < 0 )
+				{
+					printf( "Start error: %s\n",
+							snd_strerror( err ) );
+					break;
+				}
+				continue;
+			}
+			// sleep until a period is free
+			const int err = snd_pcm_wait( m_handle, 1000 );
+			if( err < 0 && handleError( err ) < 0 )
+			{
+				printf( "Wait error: %s\n", snd_strerror( err ) );
+				break;
+			}
+			continue;
+		}
+
+		const snd_pcm_channel_area_t * areas;
+		snd_pcm_uframes_t offset;
+		snd_pcm_uframes_t frames = m_periodSize;
+		int err = snd_pcm_mmap_begin( m_handle, &areas, &offset, &frames );
+		if( err < 0 )
+		{
+			if( handleError( err ) < 0 )
+			{
+				printf( "Mmap begin error: %s\n",
+							snd_strerror( err ) );
+				break;
+			}
+			continue;
+		}
+
+		// all channels are interleaved in the first area
+		char * dst = static_cast<char *>( areas[0].addr ) +
+				( areas[0].first + offset * areas[0].step ) / 8;
+		snd_pcm_uframes_t done = 0;
+		while( done < frames )
+		{
+			if( tempPos == tempFrames )
+			{
+				// frames depend on the sample rate
+				tempFrames = getNextBuffer( temp );
+				tempPos = 0;
+				if( !tempFrames )
+				{
+					quit = true;
+					memset( dst + done * frameBytes, 0,
+						( frames - done ) * frameBytes );
+					break;
+				}
+			}
+			const fpp_t todo = qMin<snd_pcm_uframes_t>(
+					frames - done, tempFrames - tempPos );
+			convertFrames( temp + tempPos, todo,
+						dst + done * frameBytes );
+			tempPos += todo;
+			done += todo;
+		}
+
+		const snd_pcm_sframes_t committed =
+			snd_pcm_mmap_commit( m_handle, offset, frames );
+		if( committed < 0 ||
+			static_cast<snd_pcm_uframes_t>( committed ) != frames )
+		{
+			if( handleError( committed < 0 ? committed : -EPIPE ) < 0 )
+			{
+				printf( "Mmap commit error: %s\n",
+						snd_strerror( committed ) );
+				break;
+			}
+		}
+		updateDelay();
+	}
+
+	delete[] temp;
+}
+
+
+
+
+void AudioAlsa::updateDelay()
+{
+	snd_pcm_sframes_t delay;
+	if( snd_pcm_delay( m_handle, &delay ) == 0 )
+	{
+		m_delay.store( delay, std::memory_order_relaxed );
+	}
+}
+
+
+
+
+void AudioAlsa::convertFrames( const surroundSampleFrame * src,
+						fpp_t frames, void * dst )
+{
+	const float gain = mixer()->masterGain();
+	const ch_cnt_t chs = channels();
+
+	switch( m_format )
+	{
+		case FormatFloat:
+		{
+			float * out = static_cast<float *>( dst );
+			for( fpp_t f = 0; f < frames; ++f )
+			{
+				for( ch_cnt_t c = 0; c < chs; ++c )
+				{
+					out[f * chs + c] = src[f][c] * gain;
+				}
+			}
+			break;
+		}
+		case FormatS32:
+		{
+			int32_t * out = static_cast<int32_t *>( dst );
+			for( fpp_t f = 0; f < frames; ++f )
+			{
+				for( ch_cnt_t c = 0; c < chs; ++c )
+				{
+					const float v = qBound( -1.0f,
+							src[f][c] * gain, 1.0f );
+					out[f * chs + c] = static_cast<int32_t>(
+							v * 2147483647.0 );
+				}
+			}
+			break;
+		}
+		case FormatS16:
+			convertToS16( src, frames, gain,
+					static_cast<int_sample_t *>( dst ),
+							m_convertEndian );
+			break;
+	}
+}
+
+
+
+
+int AudioAlsa::setParams()
+{
+	int err;
+	if( m_mmap && ( err = setHWParams( channels(),
+				SND_PCM_ACCESS_MMAP_INTERLEAVED ) ) < 0 )
+	{
+		printf( "Mmap access not available, using read/write access: "
+						"%s\n", snd_strerror( err ) );
+		m_mmap = false;
+	}
+	if( !m_mmap && ( err = setHWParams( channels(),
+				SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 )
+	{
+		printf( "Setting of hwparams failed: %s\n",
+							snd_strerror( err ) );
+		return err;
+	}
+	if( ( err = setSWParams() ) < 0 )
+	{
+		printf( "Setting of swparams failed: %s\n",
+							snd_strerror( err ) );
+		return err;
+	}
+	return 0;
+}
+
+
+
+
 int AudioAlsa::setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access )
 {
 	int err, dir;
@@ -396,8 +592,23 @@ int AudioAlsa::setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access )
 		return err;
 	}
 
-	// set the sample format
-	if( ( snd_pcm_hw_params_set_format( m_handle, m_hwParams,
+	// set the sample format; with mmap access, the frames are converted
+	// right into the ring of the device, so prefer formats needing no
+	// conversion to 16 bits
+	m_format = FormatS16;
+	if( _access == SND_PCM_ACCESS_MMAP_INTERLEAVED &&
+		snd_pcm_hw_params_set_format( m_handle, m_hwParams,
+						SND_PCM_FORMAT_FLOAT ) == 0 )
+	{
+		m_format = FormatFloat;
+	}
+	else if( _access == SND_PCM_ACCESS_MMAP_INTERLEAVED &&
+		snd_pcm_hw_params_set_format( m_handle, m_hwParams,
+						SND_PCM_FORMAT_S32 ) == 0 )
+	{
+		m_format = FormatS32;
+	}
+	else if( ( snd_pcm_hw_params_set_format( m_handle, m_hwParams,
 						SND_PCM_FORMAT_S16_LE ) ) < 0 )
 	{
 		if( ( snd_pcm_hw_params_set_format( m_handle, m_hwParams,
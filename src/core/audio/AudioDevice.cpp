@@ -27,7 +27,9 @@
 #include "AudioDevice.h"
 #include "ConfigManager.h"
 #include "debug.h"
+#include "denormals.h"
 #include "Mixer.h"
+#include "RealtimeCheck.h"
 
 
 
@@ -36,7 +38,7 @@ AudioDevice::AudioDevice( const ch_cnt_t _channels, Mixer*  _mixer ) :
 	m_sampleRate( _mixer->processingSampleRate() ),
 	m_channels( _channels ),
 	m_mixer( _mixer ),
-	m_buffer( new surroundSampleFrame[mixer()->framesPerPeriod()] )
+	m_buffer( new surroundSampleFrame[Mixer::maxFramesPerPeriod()] )
 {
 	int error;
 	if( ( m_srcState = src_new(
@@ -78,8 +80,36 @@ void AudioDevice::processNextBuffer()
 
 
 
+void AudioDevice::processExternalBuffer( const surroundSampleFrame * _ab )
+{
+	fpp_t frames = mixer()->framesPerPeriod();
+
+	lock();
+	if( mixer()->processingSampleRate() != m_sampleRate )
+	{
+		frames = resample( _ab, frames, m_buffer, mixer()->processingSampleRate(),
+						m_sampleRate );
+	}
+	else
+	{
+		memcpy( m_buffer, _ab, frames * sizeof( surroundSampleFrame ) );
+	}
+	unlock();
+
+	writeBuffer( m_buffer, frames, mixer()->masterGain() );
+}
+
+
+
+
 fpp_t AudioDevice::getNextBuffer( surroundSampleFrame * _ab )
 {
+	// usually called by the callback of the device
+	RealtimeCheck::Scope realtime;
+
+	// resampling and writing the buffer happen on the device's thread
+	disable_denormals();
+
 	fpp_t frames = mixer()->framesPerPeriod();
 	const surroundSampleFrame * b = mixer()->nextBuffer();
 	if( !b )
@@ -87,10 +117,9 @@ fpp_t AudioDevice::getNextBuffer( surroundSampleFrame * _ab )
 		return 0;
 	}
 
-	// make sure, no other thread is accessing device
-	lock();
-
-	// resample if necessary
+	// resample if necessary; the resampler is only used by this thread
+	// and only set up anew while the mixer is stopped, so this doesn't
+	// need the device lock
 	if( mixer()->processingSampleRate() != m_sampleRate )
 	{
 		frames = resample( b, frames, _ab, mixer()->processingSampleRate(),
@@ -101,13 +130,9 @@ fpp_t AudioDevice::getNextBuffer( surroundSampleFrame * _ab )
 		memcpy( _ab, b, frames * sizeof( surroundSampleFrame ) );
 	}
 
-	// release lock
-	unlock();
+	bufferFetched( b );
 
-	if( mixer()->hasFifoWriter() )
-	{
-		delete[] b;
-	}
+	mixer()->nextBufferDone( b );
 
 	return frames;
 }
@@ -188,6 +213,19 @@ fpp_t AudioDevice::resample( const surroundSampleFrame * _src,
 						const sample_rate_t _src_sr,
 						const sample_rate_t _dst_sr )
 {
+	const SincResampler::Quality quality = SincResampler::qualityOfConverter(
+			mixer()->currentQualitySettings().libsrcInterpolation() );
+	if( !m_resampler.isSetUpFor( _src_sr, _dst_sr, quality ) )
+	{
+		m_resampler.setup( _src_sr, _dst_sr, quality,
+						Mixer::maxFramesPerPeriod() );
+	}
+	if( m_resampler.isSetUpFor( _src_sr, _dst_sr, quality ) )
+	{
+		return m_resampler.process( _src, _frames, _dst, _frames );
+	}
+
+	// ratios needing too many phases are left to libsamplerate
 	if( m_srcState == NULL )
 	{
 		return _frames;
@@ -215,35 +253,8 @@ int AudioDevice::convertToS16( const surroundSampleFrame * _ab,
 								int_sample_t * _output_buffer,
 								const bool _convert_endian )
 {
-	if( _convert_endian )
-	{
-		int_sample_t temp;
-		for( fpp_t frame = 0; frame < _frames; ++frame )
-		{
-			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
-			{
-				temp = static_cast<int_sample_t>( Mixer::clip( _ab[frame][chnl] * _master_gain ) * OUTPUT_SAMPLE_MULTIPLIER );
-				
-				( _output_buffer + frame * channels() )[chnl] =
-						( temp & 0x00ff ) << 8 |
-						( temp & 0xff00 ) >> 8;
-			}
-		}
-	}
-	else
-	{
-		for( fpp_t frame = 0; frame < _frames; ++frame )
-		{
-			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
-			{
-				( _output_buffer + frame * channels() )[chnl] =
-						static_cast<int_sample_t>(
-						Mixer::clip( _ab[frame][chnl] *
-						_master_gain ) *
-						OUTPUT_SAMPLE_MULTIPLIER );
-			}
-		}
-	}
+	SampleConversion::toS16( _ab, _frames, channels(), _master_gain,
+				_output_buffer, _convert_endian, &m_ditherer );
 
 	return _frames * channels() * BYTES_PER_INT_SAMPLE;
 }
@@ -268,3 +279,12 @@ bool AudioDevice::hqAudio() const
 }
 
 
+
+
+void AudioDevice::reportUnderrun()
+{
+	mixer()->profiler().flightRecorder().requestDump(
+				"audio device reported an underrun" );
+}
+
+
@@ -24,10 +24,35 @@
  */
 
 #include <QMessageBox>
+#include <QThread>
+
+#include <cstring>
 
 #include "AudioFileDevice.h"
 #include "ExportProjectDialog.h"
 #include "GuiApplication.h"
+#include "Mixer.h"
+#include "PeriodBufferFifo.h"
+
+
+class AudioFileDevice::EncoderThread : public QThread
+{
+public:
+	EncoderThread( AudioFileDevice * device ) :
+		m_device( device )
+	{
+	}
+
+private:
+	void run() override
+	{
+		m_device->encodeQueuedPeriods();
+	}
+
+	AudioFileDevice * m_device;
+
+} ;
+
 
 
 AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
@@ -36,9 +61,12 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 					Mixer*  _mixer ) :
 	AudioDevice( _channels, _mixer ),
 	m_outputFile( _file ),
-	m_outputSettings(outputSettings)
+	m_outputSettings(outputSettings),
+	m_queuedCount( 0 ),
+	m_encodedCount( 0 )
 {
 	setSampleRate( outputSettings.getSampleRate() );
+	ditherer().setDithering( outputSettings.getDithering() );
 
 	if( m_outputFile.open( QFile::WriteOnly | QFile::Truncate ) == false )
 	{
@@ -77,6 +105,175 @@ AudioFileDevice::~AudioFileDevice()
 
 
 
+void AudioFileDevice::addMirror( AudioFileDevice * mirror )
+{
+	m_mirrors.emplace_back( mirror );
+}
+
+
+
+
+QStringList AudioFileDevice::outputFiles() const
+{
+	QStringList files( outputFile() );
+	for( const auto & mirror : m_mirrors )
+	{
+		files << mirror->outputFiles();
+	}
+	return files;
+}
+
+
+
+
+void AudioFileDevice::startEncoderThread( int queueDepth )
+{
+	for( const auto & mirror : m_mirrors )
+	{
+		mirror->startEncoderThread( queueDepth );
+	}
+
+	if( m_encoderThread )
+	{
+		return;
+	}
+
+	m_encoderQueue.reset( new PeriodBufferFifo( queueDepth,
+						mixer()->framesPerPeriod() ) );
+	// the FIFO holds two buffers more than its depth
+	m_queuedPeriods.assign( queueDepth + 2, QueuedPeriod() );
+	m_queuedCount = 0;
+	m_encodedCount = 0;
+
+	m_encoderThread.reset( new EncoderThread( this ) );
+	m_encoderThread->start();
+}
+
+
+
+
+void AudioFileDevice::stopEncoderThread()
+{
+	for( const auto & mirror : m_mirrors )
+	{
+		mirror->stopEncoderThread();
+	}
+
+	if( !m_encoderThread )
+	{
+		return;
+	}
+
+	m_encoderQueue->publishEnd();
+	m_encoderThread->wait();
+	m_encoderThread.reset();
+	m_encoderQueue.reset();
+}
+
+
+
+
+quint64 AudioFileDevice::encodingTime() const
+{
+	quint64 time = m_encodingTime.total();
+	for( const auto & mirror : m_mirrors )
+	{
+		time += mirror->encodingTime();
+	}
+	return time;
+}
+
+
+
+
+void AudioFileDevice::processNextBuffer()
+{
+	if( !m_encoderThread )
+	{
+		AudioDevice::processNextBuffer();
+		return;
+	}
+
+	surroundSampleFrame * buffer = m_encoderQueue->acquire();
+	const fpp_t frames = getNextBuffer( buffer );
+	if( frames == 0 )
+	{
+		m_encoderQueue->discardAcquired();
+		return;
+	}
+	queuePeriod( frames );
+}
+
+
+
+
+void AudioFileDevice::bufferFetched( const surroundSampleFrame * _ab )
+{
+	for( const auto & mirror : m_mirrors )
+	{
+		mirror->processMirroredBuffer( _ab );
+	}
+}
+
+
+
+
+void AudioFileDevice::processMirroredBuffer( const surroundSampleFrame * _ab )
+{
+	if( !m_encoderThread )
+	{
+		processExternalBuffer( _ab );
+		return;
+	}
+
+	surroundSampleFrame * buffer = m_encoderQueue->acquire();
+	fpp_t frames = mixer()->framesPerPeriod();
+	if( mixer()->processingSampleRate() != sampleRate() )
+	{
+		frames = resample( _ab, frames, buffer,
+				mixer()->processingSampleRate(), sampleRate() );
+	}
+	else
+	{
+		memcpy( buffer, _ab, frames * sizeof( surroundSampleFrame ) );
+	}
+	queuePeriod( frames );
+}
+
+
+
+
+void AudioFileDevice::queuePeriod( fpp_t frames )
+{
+	// published by the FIFO's semaphore along with the buffer
+	QueuedPeriod & period =
+		m_queuedPeriods[m_queuedCount++ % m_queuedPeriods.size()];
+	period.frames = frames;
+	period.masterGain = mixer()->masterGain();
+	m_encoderQueue->publish();
+}
+
+
+
+
+void AudioFileDevice::encodeQueuedPeriods()
+{
+	const surroundSampleFrame * buffer;
+	while( ( buffer = m_encoderQueue->read() ) != nullptr )
+	{
+		const QueuedPeriod & period =
+			m_queuedPeriods[m_encodedCount++ % m_queuedPeriods.size()];
+		{
+			MixerProfiler::Probe probe( &m_encodingTime, true );
+			writeBuffer( buffer, period.frames, period.masterGain );
+		}
+		m_encoderQueue->release();
+	}
+}
+
+
+
+
 int AudioFileDevice::writeData( const void* data, int len )
 {
 	if( m_outputFile.isOpen() )
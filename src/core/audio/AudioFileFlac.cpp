@@ -22,13 +22,7 @@
  *
  */
 
-#include <QtGlobal>
-
-#include <cmath>
-#include <memory>
-
 #include "AudioFileFlac.h"
-#include "endian_handling.h"
 #include "Mixer.h"
 
 AudioFileFlac::AudioFileFlac(OutputSettings const& outputSettings, ch_cnt_t const channels, bool& successful, QString const& file, Mixer* mixer):
@@ -59,16 +53,13 @@ bool AudioFileFlac::startEncoding()
 		case OutputSettings::Depth_32Bit:
 			// FLAC does not support 32bit sampling, so take it as 24.
 			m_sfinfo.format |= SF_FORMAT_PCM_24;
+			m_intBlock.setChannels(channels());
 			break;
 		default:
 			m_sfinfo.format |= SF_FORMAT_PCM_16;
+			m_shortBlock.setChannels(channels());
 	}
 
-#ifdef LMMS_HAVE_SF_COMPLEVEL
-	double compression = getOutputSettings().getCompressionLevel();
-	sf_command(m_sf, SFC_SET_COMPRESSION_LEVEL, &compression, sizeof(double));
-#endif
-
 	m_sf = sf_open(
 #ifdef LMMS_BUILD_WIN32
 		outputFile().toLocal8Bit().constData(),
@@ -79,6 +70,18 @@ bool AudioFileFlac::startEncoding()
 		&m_sfinfo
 	);
 
+	if (!m_sf)
+	{
+		qWarning("Error: AudioFileFlac::startEncoding: %s", sf_strerror(nullptr));
+		return false;
+	}
+
+#ifdef LMMS_HAVE_SF_COMPLEVEL
+	// only applies to an open file
+	double compression = getOutputSettings().getCompressionLevel();
+	sf_command(m_sf, SFC_SET_COMPRESSION_LEVEL, &compression, sizeof(double));
+#endif
+
 	sf_command(m_sf, SFC_SET_CLIPPING, nullptr, SF_TRUE);
 
 	sf_set_string(m_sf, SF_STR_SOFTWARE, "LMMS");
@@ -88,31 +91,19 @@ bool AudioFileFlac::startEncoding()
 
 void AudioFileFlac::writeBuffer(surroundSampleFrame const* _ab, fpp_t const frames, float master_gain)
 {
-	OutputSettings::BitDepth depth = getOutputSettings().getBitDepth();
-	float clipvalue = std::nextafterf( -1.0f, 0.0f );
-
-	if (depth == OutputSettings::Depth_24Bit || depth == OutputSettings::Depth_32Bit) // Float encoding
+	// the encoder gets many periods at once, which it splits into FLAC
+	// frames itself
+	if (getOutputSettings().getBitDepth() == OutputSettings::Depth_16Bit)
 	{
-		std::unique_ptr<sample_t[]> buf{ new sample_t[frames*channels()] };
-		for(fpp_t frame = 0; frame < frames; ++frame)
-		{
-			for(ch_cnt_t channel=0; channel<channels(); ++channel)
-			{
-				// Clip the negative side to just above -1.0 in order to prevent it from changing sign
-				// Upstream issue: https://github.com/erikd/libsndfile/issues/309
-				// When this commit is reverted libsndfile-1.0.29 must be made a requirement for FLAC
-				buf[frame*channels() + channel] = qMax( clipvalue, _ab[frame][channel] * master_gain );
-			}
-		}
-		sf_writef_float(m_sf,static_cast<float*>(buf.get()),frames);
+		// libsndfile takes the samples in native byte order
+		SampleConversion::toS16(_ab, frames, channels(), master_gain, m_shortBlock.reserve(m_sf, frames), false, &ditherer());
+		m_shortBlock.commit(frames);
 	}
-	else // integer PCM encoding
+	else // 24 bit, as FLAC has no float samples
 	{
-		std::unique_ptr<int_sample_t[]> buf{ new int_sample_t[frames*channels()] };
-		convertToS16(_ab, frames, master_gain, buf.get(), !isLittleEndian());
-		sf_writef_short(m_sf, static_cast<short*>(buf.get()), frames);
+		SampleConversion::toS32(_ab, frames, channels(), master_gain, m_intBlock.reserve(m_sf, frames), 24, &ditherer());
+		m_intBlock.commit(frames);
 	}
-
 }
 
 
@@ -120,6 +111,8 @@ void AudioFileFlac::finishEncoding()
 {
 	if (m_sf)
 	{
+		m_intBlock.flush(m_sf);
+		m_shortBlock.flush(m_sf);
 		sf_write_sync(m_sf);
 		sf_close(m_sf);
 	}
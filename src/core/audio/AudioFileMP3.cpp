@@ -62,17 +62,13 @@ void AudioFileMP3::writeBuffer( const surroundSampleFrame * _buf,
 	}
 
 	// TODO Why isn't the gain applied by the driver but inside the device?
-	std::vector<float> interleavedDataBuffer(_frames * 2);
-	for (fpp_t i = 0; i < _frames; ++i)
-	{
-		interleavedDataBuffer[2*i] = _buf[i][0] * _master_gain;
-		interleavedDataBuffer[2*i + 1] = _buf[i][1] * _master_gain;
-	}
+	m_interleavedBuffer.resize(_frames * channels());
+	SampleConversion::toFloat(_buf, _frames, channels(), _master_gain, m_interleavedBuffer.data());
 
 	size_t minimumBufferSize = 1.25 * _frames + 7200;
 	std::vector<unsigned char> encodingBuffer(minimumBufferSize);
 
-	int bytesWritten = lame_encode_buffer_interleaved_ieee_float(m_lame, &interleavedDataBuffer[0], _frames, &encodingBuffer[0], static_cast<int>(encodingBuffer.size()));
+	int bytesWritten = lame_encode_buffer_interleaved_ieee_float(m_lame, m_interleavedBuffer.data(), _frames, &encodingBuffer[0], static_cast<int>(encodingBuffer.size()));
 	assert (bytesWritten >= 0);
 
 	writeData(&encodingBuffer[0], bytesWritten);
@@ -24,7 +24,6 @@
  */
 
 #include "AudioFileWave.h"
-#include "endian_handling.h"
 #include "Mixer.h"
 
 #include <QFile>
@@ -66,13 +65,16 @@ bool AudioFileWave::startEncoding()
 	{
 	case OutputSettings::Depth_32Bit:
 		m_si.format |= SF_FORMAT_FLOAT;
+		m_floatBlock.setChannels( channels() );
 		break;
 	case OutputSettings::Depth_24Bit:
 		m_si.format |= SF_FORMAT_PCM_24;
+		m_intBlock.setChannels( channels() );
 		break;
 	case OutputSettings::Depth_16Bit:
 	default:
 		m_si.format |= SF_FORMAT_PCM_16;
+		m_shortBlock.setChannels( channels() );
 		break;
 	}
 
@@ -100,30 +102,27 @@ void AudioFileWave::writeBuffer( const surroundSampleFrame * _ab,
 						const fpp_t _frames,
 						const float _master_gain )
 {
-	OutputSettings::BitDepth bitDepth = getOutputSettings().getBitDepth();
-
-	if( bitDepth == OutputSettings::Depth_32Bit || bitDepth == OutputSettings::Depth_24Bit )
-	{
-		float *  buf = new float[_frames*channels()];
-		for( fpp_t frame = 0; frame < _frames; ++frame )
-		{
-			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
-			{
-				buf[frame*channels()+chnl] = _ab[frame][chnl] *
-								_master_gain;
-			}
-		}
-		sf_writef_float( m_sf, buf, _frames );
-		delete[] buf;
-	}
-	else
+	switch( getOutputSettings().getBitDepth() )
 	{
-		int_sample_t * buf = new int_sample_t[_frames * channels()];
-		convertToS16( _ab, _frames, _master_gain, buf,
-							!isLittleEndian() );
-
-		sf_writef_short( m_sf, buf, _frames );
-		delete[] buf;
+	case OutputSettings::Depth_32Bit:
+		SampleConversion::toFloat( _ab, _frames, channels(), _master_gain,
+					m_floatBlock.reserve( m_sf, _frames ) );
+		m_floatBlock.commit( _frames );
+		break;
+	case OutputSettings::Depth_24Bit:
+		SampleConversion::toS32( _ab, _frames, channels(), _master_gain,
+					m_intBlock.reserve( m_sf, _frames ), 24,
+					&ditherer() );
+		m_intBlock.commit( _frames );
+		break;
+	case OutputSettings::Depth_16Bit:
+	default:
+		// libsndfile takes the samples in native byte order
+		SampleConversion::toS16( _ab, _frames, channels(), _master_gain,
+					m_shortBlock.reserve( m_sf, _frames ), false,
+					&ditherer() );
+		m_shortBlock.commit( _frames );
+		break;
 	}
 }
 
@@ -134,6 +133,9 @@ void AudioFileWave::finishEncoding()
 {
 	if( m_sf )
 	{
+		m_floatBlock.flush( m_sf );
+		m_intBlock.flush( m_sf );
+		m_shortBlock.flush( m_sf );
 		sf_close( m_sf );
 	}
 }
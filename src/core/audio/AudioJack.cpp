@@ -34,7 +34,10 @@
 #include "GuiApplication.h"
 #include "gui_templates.h"
 #include "ConfigManager.h"
+#include "denormals.h"
 #include "LcdSpinBox.h"
+#include "LedCheckbox.h"
+#include "AudioFileDevice.h"
 #include "AudioPort.h"
 #include "MainWindow.h"
 #include "Mixer.h"
@@ -49,13 +52,24 @@ AudioJack::AudioJack( bool & _success_ful, Mixer*  _mixer ) :
 		SURROUND_CHANNELS ), _mixer ),
 	m_client( NULL ),
 	m_active( false ),
+	m_native( ConfigManager::inst()->value( "audiojack", "native" ).toInt() ),
+	m_portOutputs( m_native &&
+		ConfigManager::inst()->value( "audiojack", "portoutputs" ).toInt() ),
 	m_midiClient( NULL ),
 	m_tempOutBufs( new jack_default_audio_sample_t *[channels()] ),
-	m_outBuf( new surroundSampleFrame[mixer()->framesPerPeriod()] ),
+	m_outBuf( new surroundSampleFrame[Mixer::maxFramesPerPeriod()] ),
 	m_framesDoneInCurBuf( 0 ),
-	m_framesToDoInCurBuf( 0 )
+	m_framesToDoInCurBuf( 0 ),
+	m_freewheelOutput( nullptr ),
+	m_freewheelFromExportPorts( false ),
+	m_freewheelSkip( 0 ),
+	m_freewheelTail( -1 )
 {
 	m_stopped = true;
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		m_exportPorts[ch] = NULL;
+	}
 
 	_success_ful = initJackClient();
 	if( _success_ful )
@@ -72,13 +86,12 @@ AudioJack::AudioJack( bool & _success_ful, Mixer*  _mixer ) :
 
 AudioJack::~AudioJack()
 {
+	stopFreewheel();
 	stopProcessing();
-#ifdef AUDIO_PORT_SUPPORT
 	while( m_portMap.size() )
 	{
 		unregisterPort( m_portMap.begin().key() );
 	}
-#endif
 
 	if( m_client != NULL )
 	{
@@ -171,6 +184,12 @@ bool AudioJack::initJackClient()
 	// set shutdown-callback
 	jack_on_shutdown( m_client, shutdownCallback, this );
 
+	// let the flight recorder know about xruns
+	jack_set_xrun_callback( m_client, xrunCallback, this );
+
+	// in native mode, periods follow the buffer size of JACK
+	jack_set_buffer_size_callback( m_client, bufferSizeCallback, this );
+
 
 
 	if( jack_get_sample_rate( m_client ) != sampleRate() )
@@ -194,6 +213,14 @@ bool AudioJack::initJackClient()
 		}
 	}
 
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		m_exportPorts[ch] = jack_port_register( m_client,
+					ch == 0 ? "export in L" : "export in R",
+					JACK_DEFAULT_AUDIO_TYPE,
+					JackPortIsInput, 0 );
+	}
+
 	return true;
 }
 
@@ -280,20 +307,27 @@ void AudioJack::applyQualitySettings()
 
 void AudioJack::registerPort( AudioPort * _port )
 {
-#ifdef AUDIO_PORT_SUPPORT
+	if( !m_portOutputs || m_client == NULL )
+	{
+		return;
+	}
+
 	// make sure, port is not already registered
 	unregisterPort( _port );
 	const QString name[2] = { _port->name() + " L",
 					_port->name() + " R" } ;
 
+	StereoPort ports;
 	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
 	{
-		m_portMap[_port].ports[ch] = jack_port_register( m_client,
+		ports.ports[ch] = jack_port_register( m_client,
 						name[ch].toLatin1().constData(),
 						JACK_DEFAULT_AUDIO_TYPE,
 							JackPortIsOutput, 0 );
 	}
-#endif
+
+	QMutexLocker lock( &m_portMapMutex );
+	m_portMap[_port] = ports;
 }
 
 
@@ -301,20 +335,24 @@ void AudioJack::registerPort( AudioPort * _port )
 
 void AudioJack::unregisterPort( AudioPort * _port )
 {
-#ifdef AUDIO_PORT_SUPPORT
-	if( m_portMap.contains( _port ) )
+	m_portMapMutex.lock();
+	JackPortMap::iterator it = m_portMap.find( _port );
+	if( it == m_portMap.end() )
 	{
-		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		m_portMapMutex.unlock();
+		return;
+	}
+	const StereoPort ports = it.value();
+	m_portMap.erase( it );
+	m_portMapMutex.unlock();
+
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		if( ports.ports[ch] != NULL && m_client != NULL )
 		{
-			if( m_portMap[_port].ports[ch] != NULL )
-			{
-				jack_port_unregister( m_client,
-						m_portMap[_port].ports[ch] );
-			}
+			jack_port_unregister( m_client, ports.ports[ch] );
 		}
-		m_portMap.erase( m_portMap.find( _port ) );
 	}
-#endif
 }
 
 
@@ -322,7 +360,7 @@ void AudioJack::unregisterPort( AudioPort * _port )
 
 void AudioJack::renamePort( AudioPort * _port )
 {
-#ifdef AUDIO_PORT_SUPPORT
+	QMutexLocker lock( &m_portMapMutex );
 	if( m_portMap.contains( _port ) )
 	{
 		const QString name[2] = { _port->name() + " L",
@@ -338,7 +376,6 @@ void AudioJack::renamePort( AudioPort * _port )
 #endif
 		}
 	}
-#endif
 }
 
 
@@ -362,30 +399,19 @@ int AudioJack::processCallback( jack_nframes_t _nframes, void * _udata )
 												m_outputPorts[c], _nframes );
 	}
 
-#ifdef AUDIO_PORT_SUPPORT
-	const int frames = qMin<int>( _nframes, mixer()->framesPerPeriod() );
-	for( JackPortMap::iterator it = m_portMap.begin();
-						it != m_portMap.end(); ++it )
+	jack_nframes_t done = 0;
+	if( m_native && m_framesDoneInCurBuf == m_framesToDoInCurBuf &&
+			_nframes % mixer()->framesPerPeriod() == 0 &&
+			mixer()->processingSampleRate() == sampleRate() )
 	{
-		for( ch_cnt_t ch = 0; ch < channels(); ++ch )
-		{
-			if( it.value().ports[ch] == NULL )
-			{
-				continue;
-			}
-			jack_default_audio_sample_t * buf =
-			(jack_default_audio_sample_t *) jack_port_get_buffer(
-							it.value().ports[ch],
-								_nframes );
-			for( int frame = 0; frame < frames; ++frame )
-			{
-				buf[frame] = it.key()->buffer()[frame][ch];
-			}
-		}
+		done = renderNative( _nframes );
+	}
+	else if( m_portOutputs )
+	{
+		// the periods do not line up with the callback
+		clearPortOutputs( _nframes, 0 );
 	}
-#endif
 
-	jack_nframes_t done = 0;
 	while( done < _nframes && m_stopped == false )
 	{
 		jack_nframes_t todo = qMin<jack_nframes_t>(
@@ -424,12 +450,246 @@ int AudioJack::processCallback( jack_nframes_t _nframes, void * _udata )
 		}
 	}
 
+	AudioFileDevice * freewheelOutput = m_freewheelOutput;
+	if( freewheelOutput )
+	{
+		writeFreewheelOutput( freewheelOutput, _nframes );
+	}
+
 	return 0;
 }
 
 
 
 
+jack_nframes_t AudioJack::renderNative( jack_nframes_t nframes )
+{
+	disable_denormals();
+
+	const fpp_t frames = mixer()->framesPerPeriod();
+	jack_nframes_t done = 0;
+	while( done < nframes && m_stopped == false )
+	{
+		const surroundSampleFrame * b = mixer()->nextBuffer();
+		if( !b )
+		{
+			m_stopped = true;
+			break;
+		}
+
+		const float gain = mixer()->masterGain();
+		for( int c = 0; c < channels(); ++c )
+		{
+			jack_default_audio_sample_t * o = m_tempOutBufs[c] + done;
+			for( fpp_t frame = 0; frame < frames; ++frame )
+			{
+				o[frame] = b[frame][c] * gain;
+			}
+		}
+		mixer()->nextBufferDone( b );
+
+		if( m_portOutputs )
+		{
+			writePortOutputs( nframes, done, frames );
+		}
+		done += frames;
+	}
+
+	if( m_portOutputs && done < nframes )
+	{
+		clearPortOutputs( nframes, done );
+	}
+	return done;
+}
+
+
+
+
+void AudioJack::writePortOutputs( jack_nframes_t nframes, jack_nframes_t offset,
+								fpp_t frames )
+{
+	// The ports carry the period just rendered, which the master output,
+	// returned a period late by the mixer, only plays in the next one.
+	// While ports are being registered, skip them rather than waiting.
+	if( !m_portMapMutex.tryLock() )
+	{
+		return;
+	}
+
+	for( JackPortMap::iterator it = m_portMap.begin();
+						it != m_portMap.end(); ++it )
+	{
+		const sampleFrame * buffer = it.key()->buffer();
+		const bool muted = it.key()->isMuted();
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			if( it.value().ports[ch] == NULL )
+			{
+				continue;
+			}
+			jack_default_audio_sample_t * buf =
+			(jack_default_audio_sample_t *) jack_port_get_buffer(
+							it.value().ports[ch],
+								nframes ) + offset;
+			if( muted )
+			{
+				memset( buf, 0, sizeof( *buf ) * frames );
+				continue;
+			}
+			for( fpp_t frame = 0; frame < frames; ++frame )
+			{
+				buf[frame] = buffer[frame][ch];
+			}
+		}
+	}
+
+	m_portMapMutex.unlock();
+}
+
+
+
+
+void AudioJack::clearPortOutputs( jack_nframes_t nframes, jack_nframes_t offset )
+{
+	if( !m_portMapMutex.tryLock() )
+	{
+		return;
+	}
+
+	for( JackPortMap::iterator it = m_portMap.begin();
+						it != m_portMap.end(); ++it )
+	{
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			if( it.value().ports[ch] != NULL )
+			{
+				jack_default_audio_sample_t * buf =
+				(jack_default_audio_sample_t *) jack_port_get_buffer(
+								it.value().ports[ch],
+									nframes ) + offset;
+				memset( buf, 0, sizeof( *buf ) * ( nframes - offset ) );
+			}
+		}
+	}
+
+	m_portMapMutex.unlock();
+}
+
+
+
+
+bool AudioJack::startFreewheel( AudioFileDevice * output )
+{
+	if( m_client == NULL || !m_active || output->sampleRate() != sampleRate() )
+	{
+		return false;
+	}
+
+	// Record the export ports if the output is routed back through other
+	// clients to them. LMMS is on both ends then, so JACK has to break
+	// the cycle and the audio comes back a cycle late, plus the latency
+	// of the clients.
+	m_freewheelFromExportPorts = m_exportPorts[0] != NULL &&
+				jack_port_connected( m_exportPorts[0] ) > 0;
+	m_freewheelSkip = 0;
+	if( m_freewheelFromExportPorts )
+	{
+		jack_latency_range_t range;
+		jack_port_get_latency_range( m_exportPorts[0],
+						JackCaptureLatency, &range );
+		m_freewheelSkip = jack_get_buffer_size( m_client ) + range.max;
+	}
+	m_freewheelTail = -1;
+	m_freewheelOutput = output;
+
+	if( jack_set_freewheel( m_client, 1 ) )
+	{
+		m_freewheelOutput = nullptr;
+		return false;
+	}
+	return true;
+}
+
+
+
+
+void AudioJack::stopFreewheel()
+{
+	if( !m_freewheelOutput )
+	{
+		return;
+	}
+
+	// the periods still in the FIFO and on their way through the other
+	// clients belong to the export
+	const int queued = mixer()->hasFifoWriter() ? mixer()->fifoDepth() : 0;
+	m_freewheelTail = mixer()->framesPerPeriod() * ( queued + 2 ) +
+						m_freewheelSkip;
+	// don't hang if the server went away
+	m_freewheelDone.tryAcquire( 1, 10000 );
+	m_freewheelOutput = nullptr;
+
+	if( m_client != NULL )
+	{
+		jack_set_freewheel( m_client, 0 );
+	}
+}
+
+
+
+
+void AudioJack::writeFreewheelOutput( AudioFileDevice * output,
+							jack_nframes_t nframes )
+{
+	const jack_default_audio_sample_t * in[DEFAULT_CHANNELS];
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		in[ch] = m_freewheelFromExportPorts ?
+			(jack_default_audio_sample_t *) jack_port_get_buffer(
+						m_exportPorts[ch], nframes ) :
+			m_tempOutBufs[ch % channels()];
+	}
+
+	// freewheeling isn't realtime, so this may allocate and wait for the
+	// encoder
+	const f_cnt_t offset = qMin<f_cnt_t>( m_freewheelSkip, nframes );
+	m_freewheelSkip -= offset;
+	f_cnt_t frames = nframes - offset;
+	const f_cnt_t tail = m_freewheelTail;
+	if( tail >= 0 )
+	{
+		frames = qMin( frames, tail );
+	}
+
+	m_freewheelBuffer.resize( nframes );
+	for( f_cnt_t f = 0; f < frames; ++f )
+	{
+		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+		{
+			m_freewheelBuffer[f][ch] = in[ch][offset + f];
+		}
+	}
+	const fpp_t chunk = mixer()->framesPerPeriod();
+	for( f_cnt_t f = 0; f < frames; f += chunk )
+	{
+		output->writeFrames( m_freewheelBuffer.data() + f,
+						qMin<f_cnt_t>( chunk, frames - f ) );
+	}
+
+	if( tail >= 0 )
+	{
+		m_freewheelTail = tail - frames;
+		if( tail == frames )
+		{
+			m_freewheelOutput = nullptr;
+			m_freewheelDone.release();
+		}
+	}
+}
+
+
+
+
 int AudioJack::staticProcessCallback( jack_nframes_t _nframes, void * _udata )
 {
 	return static_cast<AudioJack *>( _udata )->
@@ -449,6 +709,49 @@ void AudioJack::shutdownCallback( void * _udata )
 
 
 
+f_cnt_t AudioJack::outputLatency() const
+{
+	if( m_outputPorts.isEmpty() )
+	{
+		return -1;
+	}
+	// the playback latency of our port includes everything downstream
+	jack_latency_range_t range;
+	jack_port_get_latency_range( m_outputPorts[0], JackPlaybackLatency,
+								&range );
+	return range.max;
+}
+
+
+
+
+int AudioJack::xrunCallback( void * _udata )
+{
+	static_cast<AudioJack *>( _udata )->reportUnderrun();
+	return 0;
+}
+
+
+
+
+int AudioJack::bufferSizeCallback( jack_nframes_t _nframes, void * _udata )
+{
+	AudioJack * jack = static_cast<AudioJack *>( _udata );
+	if( jack->m_native )
+	{
+		// the mixer stops processing to change the period, which
+		// can't be done from a JACK thread
+		QMetaObject::invokeMethod( jack->mixer(),
+					"changeFramesPerAudioBuffer",
+					Qt::QueuedConnection,
+					Q_ARG( int, _nframes ) );
+	}
+	return 0;
+}
+
+
+
+
 
 AudioJack::setupWidget::setupWidget( QWidget * _parent ) :
 	AudioDeviceSetupWidget( AudioJack::name(), _parent )
@@ -476,6 +779,16 @@ AudioJack::setupWidget::setupWidget( QWidget * _parent ) :
 	m_channels->setLabel( tr( "Channels" ) );
 	m_channels->move( 180, 20 );
 
+	m_native = new LedCheckBox( tr( "Render in the JACK process callback" ), this );
+	m_native->move( 10, 60 );
+	m_native->setChecked( ConfigManager::inst()->value( "audiojack",
+							"native" ).toInt() );
+
+	m_portOutputs = new LedCheckBox( tr( "Output each track on its own ports" ), this );
+	m_portOutputs->move( 10, 80 );
+	m_portOutputs->setChecked( ConfigManager::inst()->value( "audiojack",
+							"portoutputs" ).toInt() );
+
 }
 
 
@@ -495,6 +808,10 @@ void AudioJack::setupWidget::saveSettings()
 							m_clientName->text() );
 	ConfigManager::inst()->setValue( "audiojack", "channels",
 				QString::number( m_channels->value<int>() ) );
+	ConfigManager::inst()->setValue( "audiojack", "native",
+				QString::number( m_native->model()->value() ) );
+	ConfigManager::inst()->setValue( "audiojack", "portoutputs",
+				QString::number( m_portOutputs->model()->value() ) );
 }
 
 
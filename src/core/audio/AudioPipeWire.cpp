@@ -0,0 +1,436 @@
+/*
+ * AudioPipeWire.cpp - device-class that renders in the PipeWire process callback
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "AudioPipeWire.h"
+
+#ifdef LMMS_HAVE_PIPEWIRE
+
+#include <QLabel>
+#include <QLineEdit>
+
+#include <spa/param/audio/format-utils.h>
+
+#include "ConfigManager.h"
+#include "denormals.h"
+#include "Engine.h"
+#include "LcdSpinBox.h"
+#include "Mixer.h"
+#include "gui_templates.h"
+
+
+AudioPipeWire::AudioPipeWire( bool & _success_ful, Mixer * _mixer ) :
+	AudioDevice( qBound<ch_cnt_t>(
+		DEFAULT_CHANNELS,
+		ConfigManager::inst()->value( "audiopipewire", "channels" ).toInt(),
+		SURROUND_CHANNELS ), _mixer ),
+	m_loop( nullptr ),
+	m_stream( nullptr ),
+	m_streamEvents(),
+	m_state( PW_STREAM_STATE_UNCONNECTED ),
+	m_stopped( true ),
+	m_period( nullptr ),
+	m_periodDone( 0 )
+{
+	_success_ful = false;
+
+	// the graph resamples if it runs at another rate
+	setSampleRate( mixer()->processingSampleRate() );
+
+	pw_init( nullptr, nullptr );
+
+	m_loop = pw_thread_loop_new( "lmms-pipewire", nullptr );
+	if( m_loop == nullptr )
+	{
+		printf( "PipeWire: failed creating the thread loop\n" );
+		return;
+	}
+
+	// ask for a quantum of one period
+	const QByteArray latency = QString( "%1/%2" ).
+					arg( mixer()->framesPerPeriod() ).
+					arg( sampleRate() ).toLatin1();
+	pw_properties * props = pw_properties_new(
+				PW_KEY_MEDIA_TYPE, "Audio",
+				PW_KEY_MEDIA_CATEGORY, "Playback",
+				PW_KEY_MEDIA_ROLE, "Production",
+				PW_KEY_APP_NAME, "LMMS",
+				PW_KEY_NODE_NAME, "lmms",
+				PW_KEY_NODE_LATENCY, latency.constData(),
+				nullptr );
+	const QString target = ConfigManager::inst()->value( "audiopipewire",
+								"target" );
+	if( !target.isEmpty() )
+	{
+#ifdef PW_KEY_TARGET_OBJECT
+		pw_properties_set( props, PW_KEY_TARGET_OBJECT,
+					target.toUtf8().constData() );
+#else
+		pw_properties_set( props, PW_KEY_NODE_TARGET,
+					target.toUtf8().constData() );
+#endif
+	}
+
+	m_streamEvents.version = PW_VERSION_STREAM_EVENTS;
+	m_streamEvents.process = staticProcessCallback;
+	m_streamEvents.state_changed = staticStateChanged;
+	m_stream = pw_stream_new_simple( pw_thread_loop_get_loop( m_loop ),
+					"LMMS", props, &m_streamEvents, this );
+	if( m_stream == nullptr )
+	{
+		printf( "PipeWire: failed creating the stream\n" );
+		return;
+	}
+
+	if( pw_thread_loop_start( m_loop ) < 0 )
+	{
+		printf( "PipeWire: failed starting the thread loop\n" );
+		return;
+	}
+
+	pw_thread_loop_lock( m_loop );
+	updateFormat( true );
+
+	// wait for the connection to be set up or fail
+	while( m_state == PW_STREAM_STATE_CONNECTING )
+	{
+		pw_thread_loop_wait( m_loop );
+	}
+	const bool connected = m_state == PW_STREAM_STATE_PAUSED ||
+				m_state == PW_STREAM_STATE_STREAMING;
+	pw_thread_loop_unlock( m_loop );
+
+	if( !connected )
+	{
+		printf( "PipeWire: failed connecting the stream\n" );
+		return;
+	}
+
+	_success_ful = true;
+}
+
+
+
+
+AudioPipeWire::~AudioPipeWire()
+{
+	stopProcessing();
+
+	if( m_loop != nullptr )
+	{
+		pw_thread_loop_stop( m_loop );
+	}
+	if( m_stream != nullptr )
+	{
+		pw_stream_destroy( m_stream );
+	}
+	if( m_loop != nullptr )
+	{
+		pw_thread_loop_destroy( m_loop );
+	}
+
+	pw_deinit();
+}
+
+
+
+
+void AudioPipeWire::startProcessing()
+{
+	if( m_stream == nullptr )
+	{
+		return;
+	}
+
+	m_stopped = false;
+	pw_thread_loop_lock( m_loop );
+	pw_stream_set_active( m_stream, true );
+	pw_thread_loop_unlock( m_loop );
+}
+
+
+
+
+void AudioPipeWire::stopProcessing()
+{
+	if( m_stream == nullptr )
+	{
+		return;
+	}
+
+	m_stopped = true;
+	pw_thread_loop_lock( m_loop );
+	pw_stream_set_active( m_stream, false );
+	pw_thread_loop_unlock( m_loop );
+
+	// the process callback runs on the data thread of the stream, wait
+	// for a running one to finish before handing back the period
+	m_processMutex.lock();
+	if( m_period != nullptr )
+	{
+		mixer()->nextBufferDone( m_period );
+		m_period = nullptr;
+	}
+	m_processMutex.unlock();
+}
+
+
+
+
+void AudioPipeWire::applyQualitySettings()
+{
+	if( sampleRate() != mixer()->processingSampleRate() )
+	{
+		setSampleRate( mixer()->processingSampleRate() );
+		if( m_stream != nullptr )
+		{
+			pw_thread_loop_lock( m_loop );
+			updateFormat( false );
+			pw_thread_loop_unlock( m_loop );
+		}
+	}
+
+	AudioDevice::applyQualitySettings();
+}
+
+
+
+
+void AudioPipeWire::updateFormat( bool connect )
+{
+	static const spa_audio_channel positions[] =
+	{
+		SPA_AUDIO_CHANNEL_FL,
+		SPA_AUDIO_CHANNEL_FR,
+		SPA_AUDIO_CHANNEL_RL,
+		SPA_AUDIO_CHANNEL_RR
+	} ;
+
+	spa_audio_info_raw info = {};
+	info.format = SPA_AUDIO_FORMAT_F32P;
+	info.rate = sampleRate();
+	info.channels = channels();
+	for( ch_cnt_t c = 0; c < channels(); ++c )
+	{
+		info.position[c] = positions[c];
+	}
+
+	uint8_t buffer[1024];
+	spa_pod_builder builder;
+	spa_pod_builder_init( &builder, buffer, sizeof( buffer ) );
+	const spa_pod * params[1] =
+	{
+		spa_format_audio_raw_build( &builder, SPA_PARAM_EnumFormat,
+									&info )
+	} ;
+
+	if( connect )
+	{
+		// start inactive, startProcessing() activates the stream
+		m_state = PW_STREAM_STATE_CONNECTING;
+		if( pw_stream_connect( m_stream, PW_DIRECTION_OUTPUT, PW_ID_ANY,
+			static_cast<pw_stream_flags>(
+					PW_STREAM_FLAG_AUTOCONNECT |
+					PW_STREAM_FLAG_MAP_BUFFERS |
+					PW_STREAM_FLAG_RT_PROCESS |
+					PW_STREAM_FLAG_INACTIVE ),
+							params, 1 ) < 0 )
+		{
+			m_state = PW_STREAM_STATE_ERROR;
+		}
+	}
+	else
+	{
+		pw_stream_update_params( m_stream, params, 1 );
+	}
+}
+
+
+
+
+void AudioPipeWire::processCallback()
+{
+	pw_buffer * b = pw_stream_dequeue_buffer( m_stream );
+	if( b == nullptr )
+	{
+		return;
+	}
+
+	spa_buffer * buf = b->buffer;
+	if( buf->n_datas < static_cast<uint32_t>( channels() ) )
+	{
+		pw_stream_queue_buffer( m_stream, b );
+		return;
+	}
+
+	// the quantum may change at any time, so take it from every buffer
+	uint32_t frames = buf->datas[0].maxsize / sizeof( float );
+#if PW_CHECK_VERSION(0, 3, 49)
+	if( b->requested )
+	{
+		frames = qMin<uint32_t>( frames, b->requested );
+	}
+#endif
+
+	float * out[SURROUND_CHANNELS];
+	for( ch_cnt_t c = 0; c < channels(); ++c )
+	{
+		out[c] = static_cast<float *>( buf->datas[c].data );
+	}
+
+	disable_denormals();
+
+	m_processMutex.lock();
+
+	const fpp_t framesPerPeriod = mixer()->framesPerPeriod();
+	uint32_t done = 0;
+	while( done < frames && m_stopped == false )
+	{
+		if( m_period == nullptr )
+		{
+			m_period = mixer()->nextBuffer();
+			m_periodDone = 0;
+			if( m_period == nullptr )
+			{
+				m_stopped = true;
+				break;
+			}
+		}
+
+		const fpp_t todo = qMin<uint32_t>( frames - done,
+					framesPerPeriod - m_periodDone );
+		const float gain = mixer()->masterGain();
+		for( ch_cnt_t c = 0; c < channels(); ++c )
+		{
+			float * o = out[c] + done;
+			for( fpp_t frame = 0; frame < todo; ++frame )
+			{
+				o[frame] = m_period[m_periodDone + frame][c] * gain;
+			}
+		}
+		done += todo;
+		m_periodDone += todo;
+
+		if( m_periodDone == framesPerPeriod )
+		{
+			mixer()->nextBufferDone( m_period );
+			m_period = nullptr;
+		}
+	}
+
+	m_processMutex.unlock();
+
+	for( ch_cnt_t c = 0; c < channels(); ++c )
+	{
+		if( done < frames )
+		{
+			memset( out[c] + done, 0,
+					sizeof( float ) * ( frames - done ) );
+		}
+		buf->datas[c].chunk->offset = 0;
+		buf->datas[c].chunk->stride = sizeof( float );
+		buf->datas[c].chunk->size = frames * sizeof( float );
+	}
+
+	pw_stream_queue_buffer( m_stream, b );
+}
+
+
+
+
+void AudioPipeWire::stateChanged( pw_stream_state state, const char * error )
+{
+	if( state == PW_STREAM_STATE_ERROR )
+	{
+		printf( "PipeWire: stream error: %s\n",
+					error != nullptr ? error : "" );
+	}
+	m_state = state;
+	pw_thread_loop_signal( m_loop, false );
+}
+
+
+
+
+void AudioPipeWire::staticProcessCallback( void * _udata )
+{
+	static_cast<AudioPipeWire *>( _udata )->processCallback();
+}
+
+
+
+
+void AudioPipeWire::staticStateChanged( void * _udata, pw_stream_state,
+				pw_stream_state state, const char * error )
+{
+	static_cast<AudioPipeWire *>( _udata )->stateChanged( state, error );
+}
+
+
+
+
+AudioPipeWire::setupWidget::setupWidget( QWidget * _parent ) :
+	AudioDeviceSetupWidget( AudioPipeWire::name(), _parent )
+{
+	m_target = new QLineEdit( ConfigManager::inst()->value(
+					"audiopipewire", "target" ), this );
+	m_target->setGeometry( 10, 20, 160, 20 );
+
+	QLabel * target_lbl = new QLabel( tr( "Target node" ), this );
+	target_lbl->setFont( pointSize<7>( target_lbl->font() ) );
+	target_lbl->setGeometry( 10, 40, 160, 10 );
+
+	LcdSpinBoxModel * m = new LcdSpinBoxModel( /* this */ );
+	m->setRange( DEFAULT_CHANNELS, SURROUND_CHANNELS );
+	m->setStep( 2 );
+	m->setValue( ConfigManager::inst()->value( "audiopipewire",
+							"channels" ).toInt() );
+
+	m_channels = new LcdSpinBox( 1, this );
+	m_channels->setModel( m );
+	m_channels->setLabel( tr( "Channels" ) );
+	m_channels->move( 180, 20 );
+}
+
+
+
+
+AudioPipeWire::setupWidget::~setupWidget()
+{
+	delete m_channels->model();
+}
+
+
+
+
+void AudioPipeWire::setupWidget::saveSettings()
+{
+	ConfigManager::inst()->setValue( "audiopipewire", "target",
+							m_target->text() );
+	ConfigManager::inst()->setValue( "audiopipewire", "channels",
+				QString::number( m_channels->value<int>() ) );
+}
+
+
+#endif	/* LMMS_HAVE_PIPEWIRE */
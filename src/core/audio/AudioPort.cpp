@@ -22,6 +22,8 @@
  *
  */
 
+#include <cstring>
+
 #include "AudioPort.h"
 #include "AudioDevice.h"
 #include "EffectChain.h"
@@ -43,7 +45,12 @@ AudioPort::AudioPort( const QString & _name, bool _has_effect_chain,
 	m_effects( _has_effect_chain ? new EffectChain( NULL ) : NULL ),
 	m_volumeModel( volumeModel ),
 	m_panningModel( panningModel ),
-	m_mutedModel( mutedModel )
+	m_mutedModel( mutedModel ),
+	m_stemOutput( nullptr ),
+	m_frozenBuffer( nullptr ),
+	m_hasFrozenFrames( false ),
+	m_sleeping( false ),
+	m_noteBatch( -1 )
 {
 	Engine::mixer()->addAudioPort( this );
 	setExtOutputEnabled( true );
@@ -57,6 +64,39 @@ AudioPort::~AudioPort()
 	setExtOutputEnabled( false );
 	Engine::mixer()->removeAudioPort( this );
 	BufferManager::release( m_portBuffer );
+	setFrozen( false );
+}
+
+
+
+
+void AudioPort::setFrozen( bool frozen )
+{
+	if( frozen && !m_frozenBuffer )
+	{
+		m_frozenBuffer = BufferManager::acquire();
+		BufferManager::clear( m_frozenBuffer,
+					Engine::mixer()->framesPerPeriod() );
+	}
+	else if( !frozen && m_frozenBuffer )
+	{
+		BufferManager::release( m_frozenBuffer );
+		m_frozenBuffer = nullptr;
+	}
+	m_hasFrozenFrames = false;
+}
+
+
+
+
+void AudioPort::addFrozenFrames( const sampleFrame * src, f_cnt_t frames,
+								f_cnt_t offset )
+{
+	if( m_frozenBuffer && frames > 0 )
+	{
+		memcpy( m_frozenBuffer + offset, src, frames * BYTES_PER_FRAME );
+		m_hasFrozenFrames = true;
+	}
 }
 
 
@@ -81,6 +121,14 @@ void AudioPort::setExtOutputEnabled( bool _enabled )
 
 
 
+bool AudioPort::isMuted() const
+{
+	return m_mutedModel && m_mutedModel->value();
+}
+
+
+
+
 void AudioPort::setName( const QString & _name )
 {
 	m_name = _name;
@@ -90,28 +138,85 @@ void AudioPort::setName( const QString & _name )
 
 
 
-bool AudioPort::processEffects()
+bool AudioPort::processEffects( MixHelpers::BufferAnalysis * analysis )
 {
 	if( m_effects )
 	{
-		bool more = m_effects->processAudioBuffer( m_portBuffer, Engine::mixer()->framesPerPeriod(), m_bufferUsage );
+		bool more = m_effects->processAudioBuffer( m_portBuffer, Engine::mixer()->framesPerPeriod(), m_bufferUsage, analysis );
 		return more;
 	}
+	*analysis = MixHelpers::analyze( m_portBuffer, Engine::mixer()->framesPerPeriod() );
 	return false;
 }
 
 
+
+
+void AudioPort::writeStem()
+{
+	if( m_stemOutput )
+	{
+		m_stemOutput->processExternalBuffer( m_portBuffer );
+	}
+}
+
+
+
+
 void AudioPort::doProcessing()
 {
+	MixerProfiler::Probe probe( &m_processingTime );
+	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
+
 	if( m_mutedModel && m_mutedModel->value() )
 	{
+		if( m_stemOutput )
+		{
+			// keep the stem in sync
+			BufferManager::clear( m_portBuffer, fpp );
+			writeStem();
+		}
+		if( m_hasFrozenFrames )
+		{
+			BufferManager::clear( m_frozenBuffer, fpp );
+			m_hasFrozenFrames = false;
+		}
+		// the buffer isn't cleared anymore
+		m_sleeping = false;
 		return;
 	}
 
-	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
+	if( m_hasFrozenFrames )
+	{
+		// the rendering of a frozen track already went through the
+		// volume, panning and effects, so it goes straight to the mixer
+		for( PlayHandle * ph : m_playHandles )
+		{
+			if( ph->buffer() )
+			{
+				ph->releaseBuffer();
+			}
+		}
+		memcpy( m_portBuffer, m_frozenBuffer, fpp * BYTES_PER_FRAME );
+		BufferManager::clear( m_frozenBuffer, fpp );
+		m_hasFrozenFrames = false;
+		writeStem();
+		Engine::fxMixer()->mixToChannel( m_portBuffer, m_nextFxChannel );
+		m_bufferUsage = false;
+		m_sleeping = false;
+		return;
+	}
+
+	// clear the buffer, unless it's still clear from the last period
+	if( !m_sleeping )
+	{
+		BufferManager::clear( m_portBuffer, fpp );
+	}
 
-	// clear the buffer
-	BufferManager::clear( m_portBuffer, fpp );
+	if( m_preMixHandler && m_preMixHandler( m_playHandles, m_portBuffer ) )
+	{
+		m_bufferUsage = true;
+	}
 
 	//qDebug( "Playhandles: %d", m_playHandles.size() );
 	for( PlayHandle * ph : m_playHandles ) // now we mix all playhandle buffers into the audioport buffer
@@ -132,6 +237,9 @@ void AudioPort::doProcessing()
 
 	if( m_bufferUsage )
 	{
+		MixerProfiler::countDenormals( &m_denormals, m_portBuffer[0].data(),
+						fpp * DEFAULT_CHANNELS );
+
 		// handle volume and panning
 		// has both vol and pan models
 		if( m_volumeModel && m_panningModel )
@@ -218,13 +326,32 @@ void AudioPort::doProcessing()
 	// as of now there's no situation where we only have panning model but no volume model
 	// if we have neither, we don't have to do anything here - just pass the audio as is
 
+	if( !m_bufferUsage && m_sleeping )
+	{
+		// no input and the effects are done, so there's nothing to do
+		writeStem();
+		return;
+	}
+
 	// handle effects
-	const bool me = processEffects();
-	if( me || m_bufferUsage )
+	MixHelpers::BufferAnalysis analysis;
+	const bool me = processEffects( &analysis );
+	writeStem();
+	// skip mixing silent output, e.g. of released notes that faded out
+	if( me || ( m_bufferUsage && !analysis.silent ) )
 	{
 		Engine::fxMixer()->mixToChannel( m_portBuffer, m_nextFxChannel ); 	// send output to fx mixer
 																			// TODO: improve the flow here - convert to pull model
 		m_bufferUsage = false;
+		m_sleeping = false;
+	}
+	else
+	{
+		// neither input nor running effects, so the port falls asleep
+		// until a play handle provides a buffer again
+		BufferManager::clear( m_portBuffer, fpp );
+		m_bufferUsage = false;
+		m_sleeping = true;
 	}
 }
 
@@ -232,6 +359,7 @@ void AudioPort::doProcessing()
 void AudioPort::addPlayHandle( PlayHandle * handle )
 {
 	m_playHandleLock.lock();
+		handle->m_portIndex = m_playHandles.size();
 		m_playHandles.append( handle );
 	m_playHandleLock.unlock();
 }
@@ -240,10 +368,16 @@ void AudioPort::addPlayHandle( PlayHandle * handle )
 void AudioPort::removePlayHandle( PlayHandle * handle )
 {
 	m_playHandleLock.lock();
-		PlayHandleList::Iterator it =	std::find( m_playHandles.begin(), m_playHandles.end(), handle );
-		if( it != m_playHandles.end() )
+		const int index = handle->m_portIndex;
+		if( index >= 0 && index < m_playHandles.size() &&
+						m_playHandles[index] == handle )
 		{
-			m_playHandles.erase( it );
+			// move the last handle into the gap
+			PlayHandle * last = m_playHandles.last();
+			m_playHandles[index] = last;
+			last->m_portIndex = index;
+			m_playHandles.removeLast();
+			handle->m_portIndex = -1;
 		}
 	m_playHandleLock.unlock();
 }
@@ -49,6 +49,8 @@ void AudioPortAudioSetupUtil::updateChannels()
 #include "ConfigManager.h"
 #include "gui_templates.h"
 #include "ComboBox.h"
+#include "denormals.h"
+#include "LedCheckbox.h"
 #include "Mixer.h"
 
 
@@ -59,8 +61,10 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, Mixer * _mixer ) :
 		SURROUND_CHANNELS ), _mixer ),
 	m_paStream( NULL ),
 	m_wasPAInitError( false ),
-	m_outBuf( new surroundSampleFrame[mixer()->framesPerPeriod()] ),
-	m_outBufPos( 0 )
+	m_outBuf( new surroundSampleFrame[Mixer::maxFramesPerPeriod()] ),
+	m_outBufPos( 0 ),
+	m_native( ConfigManager::inst()->value( "audioportaudio", "native" ).toInt() ),
+	m_requestedFrames( 0 )
 {
 	_success_ful = false;
 
@@ -116,7 +120,6 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, Mixer * _mixer ) :
 
 	//inLatency = Pa_GetDeviceInfo( inDevIdx )->defaultLowInputLatency;
 	//outLatency = Pa_GetDeviceInfo( outDevIdx )->defaultLowOutputLatency;
-	const int samples = mixer()->framesPerPeriod();
 	
 	// Configure output parameters.
 	m_outputParameters.device = outDevIdx;
@@ -133,15 +136,7 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, Mixer * _mixer ) :
 	m_inputParameters.hostApiSpecificStreamInfo = NULL;
 	
 	// Open an audio I/O stream. 
-	err = Pa_OpenStream(
-			&m_paStream,
-			supportsCapture() ? &m_inputParameters : NULL,	// The input parameter
-			&m_outputParameters,	// The outputparameter
-			sampleRate(),
-			samples,
-			paNoFlag,		// Don't use any flags
-			_process_callback, 	// our callback function
-			this );
+	err = openStream();
 
 	if( err == paInvalidDevice && sampleRate() < 48000 )
 	{
@@ -149,15 +144,7 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, Mixer * _mixer ) :
 		// some backends or drivers do not allow 32 bit floating point data
 		// with a samplerate of 44100 Hz
 		setSampleRate( 48000 );
-		err = Pa_OpenStream(
-				&m_paStream,
-				supportsCapture() ? &m_inputParameters : NULL,	// The input parameter
-				&m_outputParameters,	// The outputparameter
-				sampleRate(),
-				samples,
-				paNoFlag,		// Don't use any flags
-				_process_callback, 	// our callback function
-				this );
+		err = openStream();
 	}
 
 	if( err != paNoError )
@@ -195,6 +182,7 @@ AudioPortAudio::~AudioPortAudio()
 void AudioPortAudio::startProcessing()
 {
 	m_stopped = false;
+	m_outBufPos = 0;
 	PaError err = Pa_StartStream( m_paStream );
 	
 	if( err != paNoError )
@@ -230,17 +218,8 @@ void AudioPortAudio::applyQualitySettings()
 	{
 
 		setSampleRate( Engine::mixer()->processingSampleRate() );
-		int samples = mixer()->framesPerPeriod();
 
-		PaError err = Pa_OpenStream(
-			&m_paStream,
-			supportsCapture() ? &m_inputParameters : NULL,	// The input parameter
-			&m_outputParameters,	// The outputparameter
-			sampleRate(),
-			samples,
-			paNoFlag,		// Don't use any flags
-			_process_callback, 	// our callback function
-			this );
+		PaError err = openStream();
 	
 		if( err != paNoError )
 		{
@@ -254,6 +233,41 @@ void AudioPortAudio::applyQualitySettings()
 
 
 
+
+f_cnt_t AudioPortAudio::outputLatency() const
+{
+#ifdef PORTAUDIO_V19
+	const PaStreamInfo * info = m_paStream ? Pa_GetStreamInfo( m_paStream ) : NULL;
+	if( info )
+	{
+		return static_cast<f_cnt_t>( info->outputLatency * sampleRate() );
+	}
+#endif
+	return -1;
+}
+
+
+
+
+PaError AudioPortAudio::openStream()
+{
+	// in native mode the host picks the block size and the periods follow
+	const unsigned long samples = m_native ? paFramesPerBufferUnspecified :
+						mixer()->framesPerPeriod();
+
+	return Pa_OpenStream(
+			&m_paStream,
+			supportsCapture() ? &m_inputParameters : NULL,	// The input parameter
+			&m_outputParameters,	// The outputparameter
+			sampleRate(),
+			samples,
+			paNoFlag,		// Don't use any flags
+			_process_callback, 	// our callback function
+			this );
+}
+
+
+
 int AudioPortAudio::process_callback(
 	const float *_inputBuffer,
 	float * _outputBuffer,
@@ -272,6 +286,30 @@ int AudioPortAudio::process_callback(
 		return paComplete;
 	}
 
+	if( m_native )
+	{
+		// the mixer stops processing to change the period, which can't
+		// be done from the callback
+		if( _framesPerBuffer != mixer()->framesPerPeriod() &&
+			_framesPerBuffer != m_requestedFrames &&
+			_framesPerBuffer <= Mixer::maxFramesPerPeriod() )
+		{
+			m_requestedFrames = _framesPerBuffer;
+			QMetaObject::invokeMethod( mixer(),
+					"changeFramesPerAudioBuffer",
+					Qt::QueuedConnection,
+					Q_ARG( int, _framesPerBuffer ) );
+		}
+
+		if( m_outBufPos == 0 &&
+			_framesPerBuffer % mixer()->framesPerPeriod() == 0 &&
+			mixer()->processingSampleRate() == sampleRate() )
+		{
+			renderNative( _outputBuffer, _framesPerBuffer );
+			return m_stopped ? paComplete : paContinue;
+		}
+	}
+
 	while( _framesPerBuffer )
 	{
 		if( m_outBufPos == 0 )
@@ -313,6 +351,40 @@ int AudioPortAudio::process_callback(
 
 
 
+
+void AudioPortAudio::renderNative( float * _outputBuffer,
+						unsigned long _framesPerBuffer )
+{
+	disable_denormals();
+
+	const fpp_t frames = mixer()->framesPerPeriod();
+	for( unsigned long done = 0; done < _framesPerBuffer; done += frames )
+	{
+		const surroundSampleFrame * b = mixer()->nextBuffer();
+		if( !b )
+		{
+			m_stopped = true;
+			memset( _outputBuffer, 0, ( _framesPerBuffer - done ) *
+				channels() * sizeof(float) );
+			return;
+		}
+
+		const float master_gain = mixer()->masterGain();
+		for( fpp_t frame = 0; frame < frames; ++frame )
+		{
+			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
+			{
+				_outputBuffer[chnl] = Mixer::clip( b[frame][chnl] *
+								master_gain );
+			}
+			_outputBuffer += channels();
+		}
+		mixer()->nextBufferDone( b );
+	}
+}
+
+
+
 int AudioPortAudio::_process_callback(
 	const void *_inputBuffer,
 	void * _outputBuffer,
@@ -422,6 +494,11 @@ AudioPortAudio::setupWidget::setupWidget( QWidget * _parent ) :
 	QLabel * dev_lbl = new QLabel( tr( "Device" ), this );
 	dev_lbl->setFont( pointSize<7>( dev_lbl->font() ) );
 	dev_lbl->move( 8, 38 );
+
+	m_native = new LedCheckBox( tr( "Render in the stream callback" ), this );
+	m_native->move( 10, 60 );
+	m_native->setChecked( ConfigManager::inst()->value( "audioportaudio",
+							"native" ).toInt() );
 	
 /*	LcdSpinBoxModel * m = new LcdSpinBoxModel(  );
 	m->setRange( DEFAULT_CHANNELS, SURROUND_CHANNELS );
@@ -466,6 +543,8 @@ void AudioPortAudio::setupWidget::saveSettings()
 							m_setupUtil.m_backendModel.currentText() );
 	ConfigManager::inst()->setValue( "audioportaudio", "device",
 							m_setupUtil.m_deviceModel.currentText() );
+	ConfigManager::inst()->setValue( "audioportaudio", "native",
+				QString::number( m_native->model()->value() ) );
 /*	ConfigManager::inst()->setValue( "audioportaudio", "channels",
 				QString::number( m_channels->value<int>() ) );*/
 
@@ -36,7 +36,7 @@
 
 AudioSdl::AudioSdl( bool & _success_ful, Mixer*  _mixer ) :
 	AudioDevice( DEFAULT_CHANNELS, _mixer ),
-	m_outBuf( new surroundSampleFrame[mixer()->framesPerPeriod()] )
+	m_outBuf( new surroundSampleFrame[Mixer::maxFramesPerPeriod()] )
 {
 	_success_ful = false;
 
@@ -44,7 +44,7 @@ AudioSdl::AudioSdl( bool & _success_ful, Mixer*  _mixer ) :
 	m_currentBufferFramesCount = 0;
 	m_currentBufferFramePos = 0;
 #else
-	m_convertedBufSize = mixer()->framesPerPeriod() * channels()
+	m_convertedBufSize = Mixer::maxFramesPerPeriod() * channels()
 						* sizeof( int_sample_t );
 	m_convertedBufPos = 0;
 	m_convertedBuf = new Uint8[m_convertedBufSize];
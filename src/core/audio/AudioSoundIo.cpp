@@ -34,6 +34,7 @@
 #include "ConfigManager.h"
 #include "gui_templates.h"
 #include "ComboBox.h"
+#include "LedCheckbox.h"
 #include "Mixer.h"
 
 AudioSoundIo::AudioSoundIo( bool & outSuccessful, Mixer * _mixer ) :
@@ -51,6 +52,7 @@ AudioSoundIo::AudioSoundIo( bool & outSuccessful, Mixer * _mixer ) :
 	m_outBufFramesTotal = 0;
 	m_stopped = true;
 	m_outstreamStarted = false;
+	m_native = ConfigManager::inst()->value( "audiosoundio", "native" ).toInt();
 
 	m_soundio = soundio_create();
 	if (!m_soundio)
@@ -186,6 +188,17 @@ AudioSoundIo::AudioSoundIo( bool & outSuccessful, Mixer * _mixer ) :
 	fprintf(stderr, "Output device: '%s' backend: '%s'\n",
 			device->name, soundio_backend_name(m_soundio->current_backend));
 
+	// the backend may not grant the latency we asked for, so in native mode
+	// the periods follow what it picked; the mixer can't change the period
+	// while it is creating this device, so the request is queued
+	const int hostFrames = qRound(m_outstream->software_latency * currentSampleRate);
+	if (m_native && hostFrames != mixer()->framesPerPeriod() &&
+		hostFrames <= Mixer::maxFramesPerPeriod())
+	{
+		QMetaObject::invokeMethod(mixer(), "changeFramesPerAudioBuffer",
+					Qt::QueuedConnection, Q_ARG(int, hostFrames));
+	}
+
 	outSuccessful = true;
 }
 
@@ -216,7 +229,7 @@ void AudioSoundIo::startProcessing()
 	
 	m_outBufFrameIndex = 0;
 	m_outBufFramesTotal = 0;
-	m_outBufSize = mixer()->framesPerPeriod();
+	m_outBufSize = Mixer::maxFramesPerPeriod();
 
 	m_outBuf = new surroundSampleFrame[m_outBufSize];
 
@@ -286,6 +299,20 @@ void AudioSoundIo::writeCallback(int frameCountMin, int frameCountMax)
 	const float gain = mixer()->masterGain();
 
 	int framesLeft = frameCountMax;
+	const int period = mixer()->framesPerPeriod();
+	if (m_native && mixer()->processingSampleRate() == sampleRate())
+	{
+		// write whole periods, so each callback renders them back to back
+		const int leftover = m_outBufFramesTotal - m_outBufFrameIndex;
+		if (frameCountMax - leftover >= period)
+		{
+			const int aligned = leftover + (frameCountMax - leftover) / period * period;
+			if (aligned >= frameCountMin)
+			{
+				framesLeft = aligned;
+			}
+		}
+	}
 
 	while (framesLeft > 0)
 	{
@@ -466,6 +493,11 @@ AudioSoundIo::setupWidget::setupWidget( QWidget * _parent ) :
 	dev_lbl->setFont( pointSize<7>( dev_lbl->font() ) );
 	dev_lbl->move( 8, 38 );
 
+	m_native = new LedCheckBox( tr( "Render in the write callback" ), this );
+	m_native->move( 10, 60 );
+	m_native->setChecked( ConfigManager::inst()->value( "audiosoundio",
+							"native" ).toInt() );
+
 	// Setup models
 	m_soundio = soundio_create();
 	if (!m_soundio)
@@ -517,6 +549,8 @@ void AudioSoundIo::setupWidget::saveSettings()
 	ConfigManager::inst()->setValue( "audiosoundio", "backend", m_backendModel.currentText());
 	ConfigManager::inst()->setValue( "audiosoundio", "out_device_id", deviceId->id);
 	ConfigManager::inst()->setValue( "audiosoundio", "out_device_raw", configDeviceRaw);
+	ConfigManager::inst()->setValue( "audiosoundio", "native",
+				QString::number( m_native->model()->value() ) );
 }
 
 #endif
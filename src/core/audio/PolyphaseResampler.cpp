@@ -0,0 +1,266 @@
+/*
+ * PolyphaseResampler.cpp - fixed-ratio resampler for streams
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "lmms_constants.h"
+
+
+namespace
+{
+
+struct FilterParameters
+{
+	int zeroCrossings;
+	double rolloff;
+	double kaiserBeta;
+} ;
+
+// the same filters as SincResampler, with a short one standing in for linear
+// interpolation, which would alias badly when decimating
+const FilterParameters filterParameters[SincResampler::NumQualities] =
+{
+	{ 4, 0.80, 5.0 },
+	{ 8, 0.90, 7.0 },
+	{ 16, 0.94, 8.5 },
+	{ 32, 0.96, 10.0 }
+};
+
+// zeroth order modified Bessel function of the first kind
+double besselI0( double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for( int k = 1; k < 50 && term > sum * 1e-12; ++k )
+	{
+		term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+		sum += term;
+	}
+	return sum;
+}
+
+inline float dot( const float * a, const float * b, int n )
+{
+	// independent sums, so the additions don't wait for each other
+	float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 )
+	{
+		s0 += a[i] * b[i];
+		s1 += a[i + 1] * b[i + 1];
+		s2 += a[i + 2] * b[i + 2];
+		s3 += a[i + 3] * b[i + 3];
+	}
+	for( ; i < n; ++i )
+	{
+		s0 += a[i] * b[i];
+	}
+	return ( s0 + s1 ) + ( s2 + s3 );
+}
+
+int gcd( int a, int b )
+{
+	while( b != 0 )
+	{
+		const int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+} // namespace
+
+
+
+
+PolyphaseResampler::PolyphaseResampler() :
+	m_inputRate( 0 ),
+	m_outputRate( 0 ),
+	m_quality( SincResampler::SincFastest ),
+	m_up( 0 ),
+	m_down( 0 ),
+	m_taps( 0 ),
+	m_historyFrames( 0 ),
+	m_maxRetained( 0 ),
+	m_position( 0 )
+{
+}
+
+
+
+
+bool PolyphaseResampler::setup( sample_rate_t inputRate,
+			sample_rate_t outputRate, SincResampler::Quality quality,
+			fpp_t maxFrames )
+{
+	m_up = 0;
+	if( inputRate == 0 || outputRate == 0 )
+	{
+		return false;
+	}
+	const int divisor = gcd( inputRate, outputRate );
+	const int up = outputRate / divisor;
+	const int down = inputRate / divisor;
+	if( up > MaxPhases )
+	{
+		return false;
+	}
+
+	const FilterParameters & params = filterParameters[
+			quality < SincResampler::NumQualities ? quality :
+							SincResampler::SincBest];
+	// the prototype filter runs at up times the input rate; its zero
+	// crossings are spaced by the larger of the two factors, which puts
+	// the cutoff below the lower of the two Nyquist frequencies
+	const int spacing = std::max( up, down );
+	const int taps = static_cast<int>( std::ceil(
+		2.0 * params.zeroCrossings * spacing / up ) );
+	const int length = taps * up;
+	const double center = ( length - 1 ) / 2.0;
+	const double half = length / 2.0;
+	const double norm = besselI0( params.kaiserBeta );
+
+	m_coeffs.assign( length, 0.0f );
+	for( int k = 0; k < length; ++k )
+	{
+		const double x = ( k - center ) / spacing;
+		const double r = ( k - center ) / half;
+		const double window = besselI0( params.kaiserBeta *
+				std::sqrt( std::max( 0.0, 1.0 - r * r ) ) ) / norm;
+		const double y = D_PI * params.rolloff * x;
+		const double sinc = y == 0.0 ? 1.0 : std::sin( y ) / y;
+		// up taps of the prototype feed each output, so scale by up
+		// to keep the gain, and by spacing to normalize the sinc
+		const float value = static_cast<float>( sinc * window *
+				params.rolloff * up / spacing );
+
+		// output phase p uses taps p, p + up, p + 2 up..., applied to the
+		// current input frame, the one before and so on
+		const int phase = k % up;
+		const int tap = k / up;
+		m_coeffs[phase * taps + ( taps - 1 - tap )] = value;
+	}
+
+	m_inputRate = inputRate;
+	m_outputRate = outputRate;
+	m_quality = quality;
+	m_up = up;
+	m_down = down;
+	m_taps = taps;
+	m_maxRetained = maxFrames;
+	for( auto & history : m_history )
+	{
+		history.reserve( taps - 1 + maxFrames * 2 );
+	}
+	reset();
+	return true;
+}
+
+
+
+
+void PolyphaseResampler::reset()
+{
+	m_historyFrames = std::max( m_taps - 1, 0 );
+	for( auto & history : m_history )
+	{
+		history.assign( m_historyFrames, 0.0f );
+	}
+	m_position = static_cast<int64_t>( m_historyFrames ) * m_up;
+}
+
+
+
+
+fpp_t PolyphaseResampler::process( const surroundSampleFrame * in,
+		fpp_t frames, surroundSampleFrame * out, fpp_t maxOut )
+{
+	if( m_up == 0 )
+	{
+		return 0;
+	}
+
+	for( ch_cnt_t ch = 0; ch < SURROUND_CHANNELS; ++ch )
+	{
+		std::vector<float> & history = m_history[ch];
+		history.resize( m_historyFrames + frames );
+		float * dst = history.data() + m_historyFrames;
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			dst[f] = in[f][ch];
+		}
+	}
+	m_historyFrames += frames;
+
+	fpp_t produced = 0;
+	while( produced < maxOut )
+	{
+		const f_cnt_t current = static_cast<f_cnt_t>( m_position / m_up );
+		if( current >= m_historyFrames )
+		{
+			break;
+		}
+		const float * coeffs =
+			m_coeffs.data() + ( m_position % m_up ) * m_taps;
+		const f_cnt_t first = current - m_taps + 1;
+		for( ch_cnt_t ch = 0; ch < SURROUND_CHANNELS; ++ch )
+		{
+			out[produced][ch] = dot( coeffs,
+					m_history[ch].data() + first, m_taps );
+		}
+		++produced;
+		m_position += m_down;
+	}
+
+	// keep the frames the next outputs need, but not more than the
+	// stream can catch up with
+	const f_cnt_t next = static_cast<f_cnt_t>( std::min<int64_t>(
+				m_position / m_up, m_historyFrames ) );
+	f_cnt_t drop = next - ( m_taps - 1 );
+	if( m_historyFrames - drop > m_taps - 1 + m_maxRetained )
+	{
+		const f_cnt_t newDrop = m_historyFrames - ( m_taps - 1 ) -
+								m_maxRetained;
+		m_position += static_cast<int64_t>( newDrop - drop ) * m_up;
+		drop = newDrop;
+	}
+	if( drop > 0 )
+	{
+		for( auto & history : m_history )
+		{
+			std::copy( history.begin() + drop, history.end(),
+							history.begin() );
+			history.resize( m_historyFrames - drop );
+		}
+		m_historyFrames -= drop;
+		m_position -= static_cast<int64_t>( drop ) * m_up;
+	}
+
+	return produced;
+}
@@ -0,0 +1,283 @@
+/*
+ * SampleConversion.cpp - conversion of the mixer output to device formats
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "SampleConversion.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LMMS_SAMPLE_CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace SampleConversion
+{
+
+namespace
+{
+
+//! The largest magnitude of a sample with the given number of bits, as a
+//! float the conversion to int32_t can't overflow on
+inline float sampleLimit( int bits )
+{
+	return bits < 32 ? static_cast<float>( ( 1 << ( bits - 1 ) ) - 1 )
+							: 2147483520.0f;
+}
+
+//! Clamp x to +-limit, mapping nans to -limit like the SIMD code does
+inline float clamp( float x, float limit )
+{
+	x = x > -limit ? x : -limit;
+	return x < limit ? x : limit;
+}
+
+inline int16_t swapped( int16_t x )
+{
+	const uint16_t u = static_cast<uint16_t>( x );
+	return static_cast<int16_t>( ( u << 8 ) | ( u >> 8 ) );
+}
+
+} // namespace
+
+
+
+
+Ditherer::Ditherer( Dithering dithering ) :
+	m_dithering( dithering ),
+	m_seed( 0x9e3779b9 )
+{
+	setDithering( dithering );
+}
+
+
+
+
+void Ditherer::setDithering( Dithering dithering )
+{
+	m_dithering = dithering;
+	for( ch_cnt_t ch = 0; ch < SURROUND_CHANNELS; ++ch )
+	{
+		m_error[ch] = 0.0f;
+	}
+}
+
+
+
+
+int32_t Ditherer::quantize( float x, ch_cnt_t channel, float limit )
+{
+	if( m_dithering == DitherShaped )
+	{
+		x -= m_error[channel];
+	}
+	const float noise = random() - random();
+	const int32_t q = static_cast<int32_t>(
+				std::lrint( clamp( x + noise, limit ) ) );
+	if( m_dithering == DitherShaped )
+	{
+		// don't let clipping pile up error that would be fed back
+		m_error[channel] = clamp( q - x, 2.0f );
+	}
+	return q;
+}
+
+
+
+
+void toS16( const surroundSampleFrame * src, fpp_t frames, ch_cnt_t channels,
+		float gain, int16_t * dst, bool swapBytes, Ditherer * ditherer )
+{
+	const float limit = sampleLimit( 16 );
+	const float scale = gain * limit;
+
+	if( ditherer != nullptr && ditherer->dithering() != DitherNone )
+	{
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			for( ch_cnt_t ch = 0; ch < channels; ++ch )
+			{
+				const int16_t s = static_cast<int16_t>(
+					ditherer->quantize( src[f][ch] * scale,
+								ch, limit ) );
+				*dst++ = swapBytes ? swapped( s ) : s;
+			}
+		}
+		return;
+	}
+
+	if( channels != SURROUND_CHANNELS )
+	{
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			for( ch_cnt_t ch = 0; ch < channels; ++ch )
+			{
+				const int16_t s = static_cast<int16_t>( std::lrint(
+					clamp( src[f][ch] * scale, limit ) ) );
+				*dst++ = swapBytes ? swapped( s ) : s;
+			}
+		}
+		return;
+	}
+
+	// the frames are contiguous, so treat them as one array of samples
+	const float * in = src[0].data();
+	const int samples = frames * channels;
+	int i = 0;
+#ifdef LMMS_SAMPLE_CONVERSION_SSE2
+	const __m128 s = _mm_set1_ps( scale );
+	const __m128 hi = _mm_set1_ps( limit );
+	const __m128 lo = _mm_set1_ps( -limit );
+	for( ; i + 8 <= samples; i += 8 )
+	{
+		const __m128 a = _mm_min_ps( _mm_max_ps(
+			_mm_mul_ps( _mm_loadu_ps( in + i ), s ), lo ), hi );
+		const __m128 b = _mm_min_ps( _mm_max_ps(
+			_mm_mul_ps( _mm_loadu_ps( in + i + 4 ), s ), lo ), hi );
+		__m128i packed = _mm_packs_epi32( _mm_cvtps_epi32( a ),
+							_mm_cvtps_epi32( b ) );
+		if( swapBytes )
+		{
+			packed = _mm_or_si128( _mm_slli_epi16( packed, 8 ),
+						_mm_srli_epi16( packed, 8 ) );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i ),
+								packed );
+	}
+#endif
+	for( ; i < samples; ++i )
+	{
+		const int16_t v = static_cast<int16_t>(
+				std::lrint( clamp( in[i] * scale, limit ) ) );
+		dst[i] = swapBytes ? swapped( v ) : v;
+	}
+}
+
+
+
+
+void toS32( const surroundSampleFrame * src, fpp_t frames, ch_cnt_t channels,
+		float gain, int32_t * dst, int bits, Ditherer * ditherer )
+{
+	const float limit = sampleLimit( bits );
+	const float scale = gain * limit;
+	const int shift = 32 - bits;
+	// multiplying instead of shifting keeps negative samples well defined
+	const int32_t align = 1 << shift;
+
+	if( ditherer != nullptr && ditherer->dithering() != DitherNone )
+	{
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			for( ch_cnt_t ch = 0; ch < channels; ++ch )
+			{
+				*dst++ = ditherer->quantize( src[f][ch] * scale,
+							ch, limit ) * align;
+			}
+		}
+		return;
+	}
+
+	if( channels != SURROUND_CHANNELS )
+	{
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			for( ch_cnt_t ch = 0; ch < channels; ++ch )
+			{
+				*dst++ = static_cast<int32_t>( std::lrint(
+					clamp( src[f][ch] * scale, limit ) ) ) *
+									align;
+			}
+		}
+		return;
+	}
+
+	const float * in = src[0].data();
+	const int samples = frames * channels;
+	int i = 0;
+#ifdef LMMS_SAMPLE_CONVERSION_SSE2
+	const __m128 s = _mm_set1_ps( scale );
+	const __m128 hi = _mm_set1_ps( limit );
+	const __m128 lo = _mm_set1_ps( -limit );
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	for( ; i + 4 <= samples; i += 4 )
+	{
+		const __m128 x = _mm_min_ps( _mm_max_ps(
+			_mm_mul_ps( _mm_loadu_ps( in + i ), s ), lo ), hi );
+		_mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i ),
+				_mm_sll_epi32( _mm_cvtps_epi32( x ), count ) );
+	}
+#endif
+	for( ; i < samples; ++i )
+	{
+		dst[i] = static_cast<int32_t>(
+			std::lrint( clamp( in[i] * scale, limit ) ) ) * align;
+	}
+}
+
+
+
+
+void toFloat( const surroundSampleFrame * src, fpp_t frames,
+				ch_cnt_t channels, float gain, float * dst )
+{
+	if( channels == SURROUND_CHANNELS )
+	{
+		// a plain loop over contiguous samples, which compilers vectorize
+		const float * in = src[0].data();
+		const int samples = frames * channels;
+		for( int i = 0; i < samples; ++i )
+		{
+			dst[i] = in[i] * gain;
+		}
+		return;
+	}
+
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		for( ch_cnt_t ch = 0; ch < channels; ++ch )
+		{
+			*dst++ = src[f][ch] * gain;
+		}
+	}
+}
+
+
+
+
+void toPlanar( const surroundSampleFrame * src, fpp_t frames,
+			ch_cnt_t channels, float gain, float * const * dst )
+{
+	for( ch_cnt_t ch = 0; ch < channels; ++ch )
+	{
+		float * out = dst[ch];
+		for( fpp_t f = 0; f < frames; ++f )
+		{
+			out[f] = src[f][ch] * gain;
+		}
+	}
+}
+
+}
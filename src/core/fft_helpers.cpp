@@ -147,8 +147,11 @@ int precomputeWindow(float *window, unsigned int length, FFT_WINDOWS type, bool
 	}
 
 	// apply amplitude correction
-	gain /= (float) length;
-	for (unsigned int i = 0; i < length; i++) {window[i] /= gain;}
+	if (normalized)
+	{
+		gain /= (float) length;
+		for (unsigned int i = 0; i < length; i++) {window[i] /= gain;}
+	}
 
 	return 0;
 }
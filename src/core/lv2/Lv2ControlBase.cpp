@@ -27,11 +27,49 @@
 #ifdef LMMS_HAVE_LV2
 
 #include <algorithm>
+#include <chrono>
 #include <QtGlobal>
+#include <thread>
 
 #include "Engine.h"
 #include "Lv2Manager.h"
 #include "Lv2Proc.h"
+#include "MidiEvent.h"
+#include "Mixer.h"
+#include "MixerWorkerThread.h"
+#include "ThreadableJob.h"
+
+
+
+
+class Lv2ControlBase::ProcJob : public ThreadableJob
+{
+public:
+	ProcJob(Lv2Proc* proc) : m_proc(proc) {}
+
+	//! Must be called before the job is added
+	void setFrames(fpp_t frames) { m_frames = frames; }
+
+	//! Runs the processor here unless a worker thread started it already,
+	//! and waits for it to be done
+	void finish()
+	{
+		process();
+		while (state() != ProcessingState::Done)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	bool requiresProcessing() const override { return true; }
+
+protected:
+	void doProcessing() override { m_proc->run(m_frames); }
+
+private:
+	Lv2Proc* m_proc;
+	fpp_t m_frames = 0;
+};
 
 
 
@@ -47,8 +85,10 @@ Plugin::PluginTypes Lv2ControlBase::check(const LilvPlugin *plugin,
 
 
 Lv2ControlBase::Lv2ControlBase(Model* that, const QString &uri) :
+	m_that(that),
 	m_plugin(Engine::getLv2Manager()->getPlugin(uri))
 {
+	m_keyVoice.fill(-1);
 	if (m_plugin)
 	{
 		int channelsLeft = DEFAULT_CHANNELS; // LMMS plugins are stereo
@@ -73,6 +113,12 @@ Lv2ControlBase::Lv2ControlBase(Model* that, const QString &uri) :
 		if (m_valid)
 		{
 			m_channelsPerProc = DEFAULT_CHANNELS / m_procs.size();
+			m_procsPerVoice = m_procs.size();
+			m_voiceNotes.assign(1, 0);
+			for (std::size_t i = 1; i < m_procs.size(); ++i)
+			{
+				m_procJobs.emplace_back(new ProcJob(m_procs[i].get()));
+			}
 			linkAllModels();
 		}
 	}
@@ -123,10 +169,11 @@ void Lv2ControlBase::copyModelsToLmms() const
 
 
 void Lv2ControlBase::copyBuffersFromLmms(const sampleFrame *buf, fpp_t frames) {
-	unsigned firstChan = 0; // tell the procs which channels they shall read from
-	for (auto& c : m_procs) {
-		c->copyBuffersFromCore(buf, firstChan, m_channelsPerProc, frames);
-		firstChan += m_channelsPerProc;
+	// each voice reads the whole stream
+	for (std::size_t i = 0; i < m_procs.size(); ++i) {
+		// tell the procs which channels they shall read from
+		const unsigned firstChan = (i % m_procsPerVoice) * m_channelsPerProc;
+		m_procs[i]->copyBuffersFromCore(buf, firstChan, m_channelsPerProc, frames);
 	}
 }
 
@@ -134,10 +181,21 @@ void Lv2ControlBase::copyBuffersFromLmms(const sampleFrame *buf, fpp_t frames) {
 
 
 void Lv2ControlBase::copyBuffersToLmms(sampleFrame *buf, fpp_t frames) const {
-	unsigned firstChan = 0; // tell the procs which channels they shall write to
-	for (const auto& c : m_procs) {
-		c->copyBuffersToCore(buf, firstChan, m_channelsPerProc, frames);
-		firstChan += m_channelsPerProc;
+	for (std::size_t i = 0; i < m_procs.size(); ++i) {
+		// tell the procs which channels they shall write to
+		const unsigned firstChan = (i % m_procsPerVoice) * m_channelsPerProc;
+		// the first voice writes directly, the others are mixed in
+		sampleFrame* dest = i < m_procsPerVoice ? buf : m_voiceBuffer.data();
+		m_procs[i]->copyBuffersToCore(dest, firstChan, m_channelsPerProc, frames);
+
+		if (i >= m_procsPerVoice && (i + 1) % m_procsPerVoice == 0)
+		{
+			for (fpp_t f = 0; f < frames; ++f)
+			{
+				buf[f][0] += m_voiceBuffer[f][0];
+				buf[f][1] += m_voiceBuffer[f][1];
+			}
+		}
 	}
 }
 
@@ -145,7 +203,32 @@ void Lv2ControlBase::copyBuffersToLmms(sampleFrame *buf, fpp_t frames) const {
 
 
 void Lv2ControlBase::run(fpp_t frames) {
-	for (auto& c : m_procs) { c->run(frames); }
+	using namespace std::chrono;
+	const auto begin = steady_clock::now();
+
+	const bool parallel = !m_procJobs.empty() &&
+		m_runMicros >= parallelMicros() &&
+		MixerWorkerThread::canAddSubJobs();
+	if (parallel)
+	{
+		for (auto& job : m_procJobs)
+		{
+			job->setFrames(frames);
+			MixerWorkerThread::addJob(job.get());
+		}
+		m_procs[0]->run(frames);
+		for (auto& job : m_procJobs) { job->finish(); }
+	}
+	else
+	{
+		for (auto& c : m_procs) { c->run(frames); }
+	}
+
+	// in parallel, the first processor took about as long as the whole run
+	const float micros = duration_cast<microseconds>(
+		steady_clock::now() - begin).count() /
+		(parallel ? 1.f : static_cast<float>(m_procs.size()));
+	m_runMicros += (micros - m_runMicros) * 0.1f;
 }
 
 
@@ -154,8 +237,36 @@ void Lv2ControlBase::run(fpp_t frames) {
 void Lv2ControlBase::saveSettings(QDomDocument &doc, QDomElement &that)
 {
 	LinkedModelGroups::saveSettings(doc, that);
-	
-	// TODO: save state if supported by plugin
+
+	// The state has to be captured here, but encoding and writing it can
+	// wait: binary projects keep it as a chunk, which the file writer
+	// writes (for autosaves, on its own thread)
+	DataFile* dataFile = DataFile::owner(that);
+	const bool binary = dataFile && dataFile->storesBinary();
+	m_savedStates.resize(m_procs.size());
+	for (std::size_t i = 0; i < m_procs.size(); ++i)
+	{
+		const QByteArray state = m_procs[i]->saveState();
+		if (state.isEmpty()) { continue; }
+
+		QDomElement elem = doc.createElement("state");
+		elem.setAttribute("proc", static_cast<uint>(i));
+		if (binary)
+		{
+			elem.setAttribute("chunk", dataFile->addBinary(state));
+		}
+		else
+		{
+			SavedState& saved = m_savedStates[i];
+			if (saved.base64.isEmpty() || state != saved.state)
+			{
+				saved.state = state;
+				saved.base64 = QString::fromLatin1(state.toBase64());
+			}
+			elem.appendChild(doc.createTextNode(saved.base64));
+		}
+		that.appendChild(elem);
+	}
 }
 
 
@@ -164,8 +275,25 @@ void Lv2ControlBase::saveSettings(QDomDocument &doc, QDomElement &that)
 void Lv2ControlBase::loadSettings(const QDomElement &that)
 {
 	LinkedModelGroups::loadSettings(that);
-	
-	// TODO: load state if supported by plugin
+
+	const DataFile* dataFile = DataFile::owner(that);
+	for (QDomElement elem = that.firstChildElement("state"); !elem.isNull();
+		elem = elem.nextSiblingElement("state"))
+	{
+		const std::size_t proc = elem.attribute("proc").toUInt();
+		if (proc >= m_procs.size()) { continue; }
+
+		const QByteArray state = elem.hasAttribute("chunk")
+			? (dataFile
+				? dataFile->binary(elem.attribute("chunk").toInt())
+				: QByteArray())
+			: QByteArray::fromBase64(elem.text().toLatin1());
+
+		// the plugin must not run while its state is restored
+		Engine::mixer()->requestChangeInModel();
+		m_procs[proc]->restoreState(state);
+		Engine::mixer()->doneChangeInModel();
+	}
 }
 
 
@@ -187,9 +315,70 @@ void Lv2ControlBase::reloadPlugin()
 
 
 
+void Lv2ControlBase::setVoices(std::size_t voices)
+{
+	voices = qBound<std::size_t>(1, voices, maxVoices());
+	if (!m_valid || voices == this->voices()) { return; }
+	const std::size_t procCount = voices * m_procsPerVoice;
+
+	// instantiate before locking, which would stall the audio meanwhile
+	std::vector<std::unique_ptr<Lv2Proc>> added;
+	for (std::size_t i = m_procs.size(); i < procCount; ++i)
+	{
+		std::unique_ptr<Lv2Proc> newOne = std::make_unique<Lv2Proc>(m_plugin, m_that);
+		if (!newOne->isValid())
+		{
+			qCritical() << "Failed instantiating LV2 voice";
+			return;
+		}
+		// take the values of the existing voices
+		newOne->linkControls(m_procs[0].get());
+		added.push_back(std::move(newOne));
+	}
+	if (m_voiceBuffer.empty() && voices > 1)
+	{
+		// big enough for any period, so it never grows while rendering
+		m_voiceBuffer.resize(Mixer::maxFramesPerPeriod());
+	}
+
+	std::vector<std::unique_ptr<Lv2Proc>> removed;
+	Engine::mixer()->requestChangeInModel();
+	{
+		QMutexLocker lock(&m_voiceMutex);
+		while (m_procs.size() > procCount)
+		{
+			removed.push_back(std::move(m_procs.back()));
+			m_procs.pop_back();
+		}
+		for (auto& c : added) { m_procs.push_back(std::move(c)); }
+
+		m_procJobs.clear();
+		for (std::size_t i = 1; i < m_procs.size(); ++i)
+		{
+			m_procJobs.emplace_back(new ProcJob(m_procs[i].get()));
+		}
+
+		// notes of removed voices are gone with them
+		for (int& voice : m_keyVoice)
+		{
+			if (voice >= static_cast<int>(voices)) { voice = -1; }
+		}
+		m_voiceNotes.resize(voices, 0);
+		m_lastVoice = 0;
+	}
+	Engine::mixer()->doneChangeInModel();
+	// the removed voices are destroyed here, outside of the lock
+}
+
+
+
+
 std::size_t Lv2ControlBase::controlCount() const {
+	// all voices have the same controls
 	std::size_t res = 0;
-	for (const auto& c : m_procs) { res += c->controlCount(); }
+	for (std::size_t i = 0; i < m_procsPerVoice && i < m_procs.size(); ++i) {
+		res += m_procs[i]->controlCount();
+	}
 	return res;
 }
 
@@ -205,10 +394,61 @@ bool Lv2ControlBase::hasNoteInput() const
 
 
 
+f_cnt_t Lv2ControlBase::latency() const
+{
+	f_cnt_t result = 0;
+	for (const auto& c : m_procs) { result = std::max(result, c->latency()); }
+	return result;
+}
+
+
+
+
 void Lv2ControlBase::handleMidiInputEvent(const MidiEvent &event,
 	const TimePos &time, f_cnt_t offset)
 {
-	for (auto& c : m_procs) { c->handleMidiInputEvent(event, time, offset); }
+	const bool noteOn = event.type() == MidiNoteOn && event.velocity() > 0;
+	const bool noteOff = event.type() == MidiNoteOff ||
+		(event.type() == MidiNoteOn && event.velocity() == 0);
+	const int key = event.key();
+	const bool validKey = key >= 0 && key < NumKeys;
+
+	QMutexLocker lock(&m_voiceMutex);
+	if (m_voiceNotes.size() <= 1 || !validKey || !(noteOn || noteOff))
+	{
+		// everything but notes goes to all voices
+		for (auto& c : m_procs) { c->handleMidiInputEvent(event, time, offset); }
+		return;
+	}
+
+	int voice = m_keyVoice[key];
+	if (noteOn && voice < 0)
+	{
+		// the voice with the fewest notes, starting after the last one used
+		const std::size_t count = m_voiceNotes.size();
+		std::size_t best = (m_lastVoice + 1) % count;
+		for (std::size_t i = 1; i < count; ++i)
+		{
+			const std::size_t cur = (m_lastVoice + 1 + i) % count;
+			if (m_voiceNotes[cur] < m_voiceNotes[best]) { best = cur; }
+		}
+		m_lastVoice = best;
+		voice = static_cast<int>(best);
+		m_keyVoice[key] = voice;
+		++m_voiceNotes[best];
+	}
+	else if (noteOff && voice >= 0)
+	{
+		m_keyVoice[key] = -1;
+		--m_voiceNotes[voice];
+	}
+	if (voice < 0) { return; }
+
+	for (std::size_t i = 0; i < m_procsPerVoice; ++i)
+	{
+		m_procs[voice * m_procsPerVoice + i]->handleMidiInputEvent(
+			event, time, offset);
+	}
 }
 
 
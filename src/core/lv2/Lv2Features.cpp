@@ -69,8 +69,11 @@ void Lv2Features::createFeatureVectors()
 	// create vector of features
 	for(std::pair<const char* const, void*>& pr : m_featureByUri)
 	{
-		Q_ASSERT(pr.second != nullptr);
-		m_features.push_back(LV2_Feature { pr.first, pr.second });
+		// plugin-specific features are only set for plugins using them
+		if (pr.second != nullptr)
+		{
+			m_features.push_back(LV2_Feature { pr.first, pr.second });
+		}
 	}
 
 	// create pointer vector (for lilv_plugin_instantiate)
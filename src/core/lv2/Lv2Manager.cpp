@@ -32,10 +32,15 @@
 #include <lilv/lilv.h>
 #include <lv2.h>
 #include <lv2/lv2plug.in/ns/ext/options/options.h>
+#include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
 #include <QLibrary>
 #include <QElapsedTimer>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 #include "ConfigManager.h"
 #include "Engine.h"
@@ -44,6 +49,7 @@
 #include "Lv2ControlBase.h"
 #include "Lv2Options.h"
 #include "PluginIssue.h"
+#include "lmmsversion.h"
 
 
 
@@ -73,11 +79,11 @@ Lv2Manager::Lv2Manager() :
 	m_debug = (dbgStr && *dbgStr);
 
 	m_world = lilv_world_new();
-	lilv_world_load_all(m_world);
 
 	m_supportedFeatureURIs.insert(LV2_URID__map);
 	m_supportedFeatureURIs.insert(LV2_URID__unmap);
 	m_supportedFeatureURIs.insert(LV2_OPTIONS__options);
+	m_supportedFeatureURIs.insert(LV2_WORKER__schedule);
 
 	auto supportOpt = [this](Lv2UridCache::Id id)
 	{
@@ -93,6 +99,84 @@ Lv2Manager::Lv2Manager() :
 
 
 
+namespace
+{
+
+const char IndexMagic[] = "LMMSLV2I";
+const quint32 IndexVersion = 1;
+
+
+QString indexFile()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/lv2.index";
+}
+
+
+
+
+//! The directories lilv_world_load_all() searches for bundles
+QStringList lv2Path()
+{
+	const QByteArray env = qgetenv("LV2_PATH");
+	if (!env.isEmpty())
+	{
+		return QString::fromLocal8Bit(env).split(QDir::listSeparator(),
+			QString::SkipEmptyParts);
+	}
+
+	// the defaults of lilv
+#if defined(LMMS_BUILD_WIN32)
+	return { QString::fromLocal8Bit(qgetenv("APPDATA")) + "/LV2",
+		QString::fromLocal8Bit(qgetenv("COMMONPROGRAMFILES")) + "/LV2" };
+#elif defined(LMMS_BUILD_APPLE)
+	return { QDir::homePath() + "/Library/Audio/Plug-Ins/LV2",
+		QDir::homePath() + "/.lv2", "/usr/local/lib/lv2", "/usr/lib/lv2",
+		"/Library/Audio/Plug-Ins/LV2" };
+#else
+	return { QDir::homePath() + "/.lv2", "/usr/local/lib/lv2",
+		"/usr/lib/lv2", "/usr/local/lib64/lv2", "/usr/lib64/lv2" };
+#endif
+}
+
+
+
+
+//! Hash over all bundles and the modification times of their files, which
+//! changes whenever a bundle is added, removed or updated
+QByteArray bundleHash()
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	for (const QString& path : lv2Path())
+	{
+		const QFileInfoList bundles = QDir(path).entryInfoList(
+			QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+		for (const QFileInfo& bundle : bundles)
+		{
+			hash.addData(bundle.absoluteFilePath().toUtf8());
+			const QFileInfoList files = QDir(bundle.absoluteFilePath()).
+				entryInfoList(QDir::Files, QDir::Name);
+			for (const QFileInfo& file : files)
+			{
+				hash.addData(file.fileName().toUtf8());
+				const qint64 stamp[2] = {
+					file.lastModified().toMSecsSinceEpoch(), file.size() };
+				hash.addData(reinterpret_cast<const char*>(stamp),
+					sizeof(stamp));
+			}
+		}
+	}
+	// the checks depend on these, too
+	hash.addData(LMMS_VERSION);
+	hash.addData(Engine::ignorePluginBlacklist() ? "1" : "0");
+	return hash.result();
+}
+
+} // namespace
+
+
+
+
 Lv2Manager::~Lv2Manager()
 {
 	lilv_world_free(m_world);
@@ -112,7 +196,9 @@ AutoLilvNode Lv2Manager::uri(const char *uriStr)
 const LilvPlugin *Lv2Manager::getPlugin(const std::string &uri)
 {
 	auto itr = m_lv2InfoMap.find(uri);
-	return itr == m_lv2InfoMap.end() ? nullptr : itr->second.plugin();
+	if (itr == m_lv2InfoMap.end()) { return nullptr; }
+	if (!itr->second.plugin()) { loadBundle(itr->second.bundle()); }
+	return itr->second.plugin();
 }
 
 
@@ -126,37 +212,42 @@ const LilvPlugin *Lv2Manager::getPlugin(const QString &uri)
 
 
 
+QString Lv2Manager::pluginName(const QString &uri) const
+{
+	auto itr = m_lv2InfoMap.find(uri.toStdString());
+	return itr == m_lv2InfoMap.end() ? QString() : itr->second.name();
+}
+
+
+
+
 void Lv2Manager::initPlugins()
 {
-	const LilvPlugins* plugins = lilv_world_get_all_plugins(m_world);
-	std::size_t pluginCount = 0, pluginsLoaded = 0;
 	QElapsedTimer timer;
 	timer.start();
 
-	unsigned blacklisted = 0;
-	LILV_FOREACH(plugins, itr, plugins)
+	const QByteArray bundles = bundleHash();
+	const bool fromIndex = readIndex(bundles);
+	if (!fromIndex)
 	{
-		const LilvPlugin* curPlug = lilv_plugins_get(plugins, itr);
+		checkAllPlugins();
+		writeIndex(bundles);
+	}
 
-		std::vector<PluginIssue> issues;
-		Plugin::PluginTypes type = Lv2ControlBase::check(curPlug, issues);
-		std::sort(issues.begin(), issues.end());
-		auto last = std::unique(issues.begin(), issues.end());
-		issues.erase(last, issues.end());
+	std::size_t pluginCount = 0, pluginsLoaded = 0;
+	unsigned blacklisted = 0;
+	for (const auto& uriInfoPair : m_lv2InfoMap)
+	{
+		const Lv2Info& info = uriInfoPair.second;
+		const std::vector<PluginIssue>& issues = info.issues();
 		if (m_debug && issues.size())
 		{
-			qDebug() << "Lv2 plugin"
-				<< qStringFromPluginNode(curPlug, lilv_plugin_get_name)
-				<< "(URI:"
-				<< lilv_node_as_uri(lilv_plugin_get_uri(curPlug))
+			qDebug() << "Lv2 plugin" << info.name()
+				<< "(URI:" << uriInfoPair.first.c_str()
 				<< ") can not be loaded:";
 			for (const PluginIssue& iss : issues) { qDebug() << "  - " << iss; }
 		}
 
-		Lv2Info info(curPlug, type, issues.empty());
-
-		m_lv2InfoMap[lilv_node_as_uri(lilv_plugin_get_uri(curPlug))]
-			= std::move(info);
 		if(issues.empty()) { ++pluginsLoaded; }
 		else
 		{
@@ -172,7 +263,8 @@ void Lv2Manager::initPlugins()
 
 	qDebug() << "Lv2 plugin SUMMARY:"
 		<< pluginsLoaded << "of" << pluginCount << " loaded in"
-		<< timer.elapsed() << "msecs.";
+		<< timer.elapsed() << "msecs"
+		<< (fromIndex ? "(from index)." : ".");
 	if(pluginsLoaded != pluginCount)
 	{
 		if (m_debug)
@@ -210,6 +302,134 @@ void Lv2Manager::initPlugins()
 
 
 
+void Lv2Manager::checkAllPlugins()
+{
+	lilv_world_load_all(m_world);
+	m_loadedAll = true;
+	m_lv2InfoMap.clear();
+
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(m_world);
+	LILV_FOREACH(plugins, itr, plugins)
+	{
+		const LilvPlugin* curPlug = lilv_plugins_get(plugins, itr);
+
+		std::vector<PluginIssue> issues;
+		Plugin::PluginTypes type = Lv2ControlBase::check(curPlug, issues);
+		std::sort(issues.begin(), issues.end());
+		auto last = std::unique(issues.begin(), issues.end());
+		issues.erase(last, issues.end());
+
+		Lv2Info info(curPlug, type, std::move(issues),
+			qStringFromPluginNode(curPlug, lilv_plugin_get_name),
+			lilv_node_as_uri(lilv_plugin_get_bundle_uri(curPlug)));
+
+		m_lv2InfoMap[lilv_node_as_uri(lilv_plugin_get_uri(curPlug))]
+			= std::move(info);
+	}
+}
+
+
+
+
+bool Lv2Manager::readIndex(const QByteArray& bundles)
+{
+	QFile file(indexFile());
+	if (!file.open(QIODevice::ReadOnly)) { return false; }
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	QByteArray magic, hash;
+	quint32 version, count;
+	stream >> magic >> version >> hash >> count;
+	if (magic != IndexMagic || version != IndexVersion || hash != bundles)
+	{
+		return false;
+	}
+
+	Lv2InfoMap infoMap;
+	for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+	{
+		QByteArray uri, bundle;
+		QString name;
+		qint32 type;
+		quint32 issueCount;
+		stream >> uri >> bundle >> name >> type >> issueCount;
+		std::vector<PluginIssue> issues;
+		for (quint32 j = 0; j < issueCount &&
+			stream.status() == QDataStream::Ok; ++j)
+		{
+			qint32 issueType;
+			QByteArray issueInfo;
+			stream >> issueType >> issueInfo;
+			issues.emplace_back(static_cast<PluginIssueType>(issueType),
+				issueInfo.toStdString());
+		}
+		infoMap[uri.toStdString()] = Lv2Info(nullptr,
+			static_cast<Plugin::PluginTypes>(type), std::move(issues),
+			name, bundle.toStdString());
+	}
+	if (stream.status() != QDataStream::Ok) { return false; }
+
+	m_lv2InfoMap = std::move(infoMap);
+	return true;
+}
+
+
+
+
+void Lv2Manager::writeIndex(const QByteArray& bundles) const
+{
+	const QString fileName = indexFile();
+	QDir().mkpath(QFileInfo(fileName).path());
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << QByteArray(IndexMagic) << IndexVersion << bundles
+		<< static_cast<quint32>(m_lv2InfoMap.size());
+	for (const auto& uriInfoPair : m_lv2InfoMap)
+	{
+		const Lv2Info& info = uriInfoPair.second;
+		stream << QByteArray(uriInfoPair.first.c_str())
+			<< QByteArray(info.bundle().c_str()) << info.name()
+			<< static_cast<qint32>(info.type())
+			<< static_cast<quint32>(info.issues().size());
+		for (const PluginIssue& iss : info.issues())
+		{
+			stream << static_cast<qint32>(iss.type())
+				<< QByteArray(iss.info().c_str());
+		}
+	}
+	file.commit();
+}
+
+
+
+
+void Lv2Manager::loadBundle(const std::string& bundle)
+{
+	if (m_loadedAll || !m_loadedBundles.insert(bundle).second) { return; }
+
+	AutoLilvNode bundleUri = uri(bundle.c_str());
+	lilv_world_load_bundle(m_world, bundleUri.get());
+
+	// the plugins of a bundle are all known once it is loaded
+	const LilvPlugins* plugins = lilv_world_get_all_plugins(m_world);
+	for (auto& uriInfoPair : m_lv2InfoMap)
+	{
+		Lv2Info& info = uriInfoPair.second;
+		if (!info.m_plugin && info.m_bundle == bundle)
+		{
+			info.m_plugin = lilv_plugins_get_by_uri(plugins,
+				uri(uriInfoPair.first.c_str()).get());
+		}
+	}
+}
+
+
+
+
 bool Lv2Manager::CmpStr::operator()(const char *a, const char *b) const
 {
 	return std::strcmp(a, b) < 0;
@@ -345,6 +345,36 @@ void Audio::copyBuffersToCore(sampleFrame *lmmsBuf,
 
 
 
+void Audio::copyStereoFromCore(const sampleFrame *lmmsBuf,
+	unsigned firstChan, Audio& left, Audio& right, fpp_t frames)
+{
+	float* l = left.m_buffer.data();
+	float* r = right.m_buffer.data();
+	for (std::size_t f = 0; f < static_cast<unsigned>(frames); ++f)
+	{
+		l[f] = lmmsBuf[f][firstChan];
+		r[f] = lmmsBuf[f][firstChan + 1];
+	}
+}
+
+
+
+
+void Audio::copyStereoToCore(sampleFrame *lmmsBuf,
+	unsigned firstChan, const Audio& left, const Audio& right, fpp_t frames)
+{
+	const float* l = left.m_buffer.data();
+	const float* r = right.m_buffer.data();
+	for (std::size_t f = 0; f < static_cast<unsigned>(frames); ++f)
+	{
+		lmmsBuf[f][firstChan] = l[f];
+		lmmsBuf[f][firstChan + 1] = r[f];
+	}
+}
+
+
+
+
 void AtomSeq::Lv2EvbufDeleter::operator()(LV2_Evbuf *n) { lv2_evbuf_free(n); }
 
 
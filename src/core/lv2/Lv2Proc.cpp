@@ -26,10 +26,14 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <algorithm>
 #include <cmath>
 #include <lv2/lv2plug.in/ns/ext/midi/midi.h>
 #include <lv2/lv2plug.in/ns/ext/atom/atom.h>
 #include <lv2/lv2plug.in/ns/ext/resize-port/resize-port.h>
+#include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+#include <map>
+#include <QDataStream>
 #include <QDebug>
 #include <QtGlobal>
 
@@ -57,6 +61,51 @@ struct MidiInputEvent
 
 
 
+namespace
+{
+
+//! A property of a state being restored
+struct StateProperty
+{
+	LV2_URID type;
+	uint32_t flags;
+	QByteArray value;
+};
+
+using StateProperties = std::map<LV2_URID, StateProperty>;
+
+LV2_State_Status storeStateProperty(LV2_State_Handle handle, uint32_t key,
+	const void* value, size_t size, uint32_t type, uint32_t flags)
+{
+	// only plain data can go into a project
+	if (!(flags & LV2_STATE_IS_POD)) { return LV2_STATE_ERR_BAD_FLAGS; }
+
+	// URIDs are only valid for this session, so the URIs are stored
+	UridMap& map = Engine::getLv2Manager()->uridMap();
+	QDataStream& out = *static_cast<QDataStream*>(handle);
+	out << QByteArray(map.unmap(key)) << QByteArray(map.unmap(type))
+		<< static_cast<quint32>(flags)
+		<< QByteArray(static_cast<const char*>(value), static_cast<int>(size));
+	return LV2_STATE_SUCCESS;
+}
+
+const void* retrieveStateProperty(LV2_State_Handle handle, uint32_t key,
+	size_t* size, uint32_t* type, uint32_t* flags)
+{
+	const StateProperties& props = *static_cast<StateProperties*>(handle);
+	auto itr = props.find(key);
+	if (itr == props.end()) { return nullptr; }
+	*size = static_cast<size_t>(itr->second.value.size());
+	*type = itr->second.type;
+	*flags = itr->second.flags;
+	return itr->second.value.constData();
+}
+
+}
+
+
+
+
 Plugin::PluginTypes Lv2Proc::check(const LilvPlugin *plugin,
 	std::vector<PluginIssue>& issues)
 {
@@ -202,8 +251,12 @@ void Lv2Proc::copyModelsFromCore()
 
 	struct Copy : public Lv2Ports::Visitor
 	{
+		// plugins don't write to input ports, so they keep their value
+		// until the model changes
+		bool m_all;
 		void visit(Lv2Ports::Control& ctrl) override
 		{
+			if (!ctrl.m_connectedModel->isValueChanged() && !m_all) { return; }
 			FloatFromModelVisitor ffm;
 			ffm.m_scalePointMap = &ctrl.m_scalePointMap;
 			ctrl.m_connectedModel->accept(ffm);
@@ -211,17 +264,33 @@ void Lv2Proc::copyModelsFromCore()
 		}
 		void visit(Lv2Ports::Cv& cv) override
 		{
+			if (!cv.m_connectedModel->isValueChanged() && !m_all) { return; }
+			const ValueBuffer* values = cv.m_connectedModel->valueBuffer();
+			if (values && cv.m_scalePointMap.empty())
+			{
+				// sample exact
+				std::copy_n(values->values(),
+					std::min(cv.m_buffer.size(), values->size()),
+					cv.m_buffer.begin());
+				return;
+			}
 			FloatFromModelVisitor ffm;
 			ffm.m_scalePointMap = &cv.m_scalePointMap;
 			cv.m_connectedModel->accept(ffm);
-			// dirty fix, needs better interpolation
 			std::fill(cv.m_buffer.begin(), cv.m_buffer.end(), ffm.m_res);
 		}
 		void visit(Lv2Ports::AtomSeq& atomPort) override
 		{
-			lv2_evbuf_reset(atomPort.m_buf.get(), true);
+			// the sequence is only written by us, it's empty unless
+			// events were sent in the last run
+			if (lv2_evbuf_get_size(atomPort.m_buf.get()) > 0 || m_all)
+			{
+				lv2_evbuf_reset(atomPort.m_buf.get(), true);
+			}
 		}
 	} copy;
+	copy.m_all = !m_portsInitialized;
+	m_portsInitialized = true;
 
 	// feed each input port with the respective data from the LMMS core
 	for (const std::unique_ptr<Lv2Ports::PortBase>& port : m_ports)
@@ -236,14 +305,14 @@ void Lv2Proc::copyModelsFromCore()
 	if(m_midiIn)
 	{
 		LV2_Evbuf_Iterator iter = lv2_evbuf_begin(m_midiIn->m_buf.get());
+		const uint32_t type = Engine::getLv2Manager()->
+			uridCache()[Lv2UridCache::Id::midi_MidiEvent];
 		// MIDI events waiting to go to the plugin?
 		while(m_midiInputReader.read_space() > 0)
 		{
 			const MidiInputEvent ev = m_midiInputReader.read(1)[0];
 			uint32_t atomStamp =
 				ev.time.frames(Engine::framesPerTick()) + ev.offset;
-			uint32_t type = Engine::getLv2Manager()->
-				uridCache()[Lv2UridCache::Id::midi_MidiEvent];
 			uint8_t buf[4];
 			std::size_t bufsize = writeToByteSeq(ev.ev, buf, sizeof(buf));
 			if(bufsize)
@@ -286,6 +355,13 @@ void Lv2Proc::copyBuffersFromCore(const sampleFrame *buf,
 									unsigned firstChan, unsigned num,
 									fpp_t frames)
 {
+	if (num > 1 && inPorts().m_right)
+	{
+		Lv2Ports::Audio::copyStereoFromCore(buf, firstChan,
+			*inPorts().m_left, *inPorts().m_right, frames);
+		return;
+	}
+
 	inPorts().m_left->copyBuffersFromCore(buf, firstChan, frames);
 	if (num > 1)
 	{
@@ -293,14 +369,7 @@ void Lv2Proc::copyBuffersFromCore(const sampleFrame *buf,
 		// have one input channel... take medium of left and right for
 		// mono input
 		// (this happens if we have two outputs and only one input)
-		if (inPorts().m_right)
-		{
-			inPorts().m_right->copyBuffersFromCore(buf, firstChan + 1, frames);
-		}
-		else
-		{
-			inPorts().m_left->averageWithBuffersFromCore(buf, firstChan + 1, frames);
-		}
+		inPorts().m_left->averageWithBuffersFromCore(buf, firstChan + 1, frames);
 	}
 }
 
@@ -311,15 +380,20 @@ void Lv2Proc::copyBuffersToCore(sampleFrame* buf,
 								unsigned firstChan, unsigned num,
 								fpp_t frames) const
 {
+	if (num > 1 && outPorts().m_right)
+	{
+		Lv2Ports::Audio::copyStereoToCore(buf, firstChan,
+			*outPorts().m_left, *outPorts().m_right, frames);
+		return;
+	}
+
 	outPorts().m_left->copyBuffersToCore(buf, firstChan + 0, frames);
 	if (num > 1)
 	{
 		// if the caller requests to copy into two channels, but we only have
 		// one output channel, duplicate our output
 		// (this happens if we have two inputs and only one output)
-		Lv2Ports::Audio* ap = outPorts().m_right
-			? outPorts().m_right : outPorts().m_left;
-		ap->copyBuffersToCore(buf, firstChan + 1, frames);
+		outPorts().m_left->copyBuffersToCore(buf, firstChan + 1, frames);
 	}
 }
 
@@ -328,7 +402,9 @@ void Lv2Proc::copyBuffersToCore(sampleFrame* buf,
 
 void Lv2Proc::run(fpp_t frames)
 {
+	if (m_worker) { m_worker->deliverResponses(); }
 	lilv_instance_run(m_instance, static_cast<uint32_t>(frames));
+	if (m_worker) { m_worker->endRun(); }
 }
 
 
@@ -398,6 +474,7 @@ void Lv2Proc::initPlugin()
 	{
 		for (std::size_t portNum = 0; portNum < m_ports.size(); ++portNum)
 			connectPort(portNum);
+		if (m_worker) { m_worker->start(m_instance); }
 		lilv_instance_activate(m_instance);
 	}
 	else
@@ -416,6 +493,8 @@ void Lv2Proc::initPlugin()
 
 void Lv2Proc::shutdownPlugin()
 {
+	// the worker must not call into the instance anymore
+	m_worker.reset();
 	if (m_valid)
 	{
 		lilv_instance_deactivate(m_instance);
@@ -427,6 +506,60 @@ void Lv2Proc::shutdownPlugin()
 
 
 
+QByteArray Lv2Proc::saveState()
+{
+	const LV2_State_Interface* iface = stateInterface();
+	if (!iface) { return QByteArray(); }
+
+	QByteArray state;
+	QDataStream out(&state, QIODevice::WriteOnly);
+	iface->save(lilv_instance_get_handle(m_instance), &storeStateProperty,
+		&out, LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE,
+		m_features.featurePointers());
+	return state;
+}
+
+
+
+
+void Lv2Proc::restoreState(const QByteArray& state)
+{
+	const LV2_State_Interface* iface = stateInterface();
+	if (!iface || state.isEmpty()) { return; }
+
+	UridMap& map = Engine::getLv2Manager()->uridMap();
+	StateProperties props;
+	QDataStream in(state);
+	while (!in.atEnd())
+	{
+		QByteArray key, type, value;
+		quint32 flags;
+		in >> key >> type >> flags >> value;
+		if (in.status() != QDataStream::Ok) { break; }
+		props[map.map(key.constData())] =
+			StateProperty { map.map(type.constData()), flags, value };
+	}
+
+	iface->restore(lilv_instance_get_handle(m_instance),
+		&retrieveStateProperty, &props,
+		LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE,
+		m_features.featurePointers());
+}
+
+
+
+
+const LV2_State_Interface* Lv2Proc::stateInterface() const
+{
+	return m_valid
+		? static_cast<const LV2_State_Interface*>(
+			lilv_instance_get_extension_data(m_instance, LV2_STATE__interface))
+		: nullptr;
+}
+
+
+
+
 bool Lv2Proc::hasNoteInput() const
 {
 	return m_midiIn;
@@ -452,13 +585,16 @@ void Lv2Proc::initMOptions()
 		executed again, creating a new option vector.
 	*/
 	float sampleRate = Engine::mixer()->processingSampleRate();
+	// the period can change while the plugin runs
 	int32_t blockLength = Engine::mixer()->framesPerPeriod();
+	int32_t minBlockLength = MINIMUM_BUFFER_SIZE;
+	int32_t maxBlockLength = Mixer::maxFramesPerPeriod();
 	int32_t sequenceSize = defaultEvbufSize();
 
 	using Id = Lv2UridCache::Id;
 	m_options.initOption<float>(Id::param_sampleRate, sampleRate);
-	m_options.initOption<int32_t>(Id::bufsz_maxBlockLength, blockLength);
-	m_options.initOption<int32_t>(Id::bufsz_minBlockLength, blockLength);
+	m_options.initOption<int32_t>(Id::bufsz_maxBlockLength, maxBlockLength);
+	m_options.initOption<int32_t>(Id::bufsz_minBlockLength, minBlockLength);
 	m_options.initOption<int32_t>(Id::bufsz_nominalBlockLength, blockLength);
 	m_options.initOption<int32_t>(Id::bufsz_sequenceSize, sequenceSize);
 	m_options.createOptionVectors();
@@ -471,6 +607,12 @@ void Lv2Proc::initPluginSpecificFeatures()
 {
 	initMOptions();
 	m_features[LV2_OPTIONS__options] = const_cast<LV2_Options_Option*>(m_options.feature());
+
+	if (lilv_plugin_has_extension_data(m_plugin, uri(LV2_WORKER__interface).get()))
+	{
+		m_worker.reset(new Lv2Worker);
+		m_features[LV2_WORKER__schedule] = m_worker->feature();
+	}
 }
 
 
@@ -578,7 +720,7 @@ void Lv2Proc::createPort(std::size_t portNum)
 			Lv2Ports::Audio* audio =
 				new Lv2Ports::Audio(
 						static_cast<std::size_t>(
-							Engine::mixer()->framesPerPeriod()),
+							Mixer::maxFramesPerPeriod()),
 						portIsSideChain(m_plugin, lilvPort)
 					);
 			port = audio;
@@ -724,7 +866,14 @@ void Lv2Proc::createPorts()
 		m_ports[portNum]->accept(registerPort);
 	}
 
+	if (lilv_plugin_has_latency(m_plugin))
+	{
+		m_latencyPort = Lv2Ports::dcast<Lv2Ports::Control>(
+			m_ports[lilv_plugin_get_latency_port_index(m_plugin)].get());
+	}
+
 	// initially assign model values to port values
+	m_portsInitialized = false;
 	copyModelsFromCore();
 
 	// debugging:
@@ -133,7 +133,8 @@ QString Lv2SubPluginFeatures::additionalFileExtensions(
 QString Lv2SubPluginFeatures::displayName(
 	const Plugin::Descriptor::SubPluginFeatures::Key &k) const
 {
-	return pluginName(getPlugin(k));
+	// the name is indexed, so the browser doesn't load all bundles
+	return Engine::getLv2Manager()->pluginName(k.attributes["uri"]);
 }
 
 
@@ -171,9 +172,7 @@ void Lv2SubPluginFeatures::listSubPluginKeys(const Plugin::Descriptor *desc,
 				Plugin::Descriptor::SubPluginFeatures::Key;
 			KeyType::AttributeMap atm;
 			atm["uri"] = QString::fromUtf8(uriInfoPair.first.c_str());
-			const LilvPlugin* plug = uriInfoPair.second.plugin();
-
-			kl.push_back(KeyType(desc, pluginName(plug), atm));
+			kl.push_back(KeyType(desc, uriInfoPair.second.name(), atm));
 			//qDebug() << "Found LV2 sub plugin key of type" <<
 			//	m_type << ":" << pr.first.c_str();
 		}
@@ -0,0 +1,317 @@
+/*
+ * Lv2Worker.cpp - Lv2Worker implementation
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Lv2Worker.h"
+
+#ifdef LMMS_HAVE_LV2
+
+#include <algorithm>
+#include <cstring>
+#include <QThread>
+#include <QtGlobal>
+
+
+QMutex Lv2Worker::s_mutex;
+QWaitCondition Lv2Worker::s_workDone;
+QWaitCondition Lv2Worker::s_wake;
+std::vector<Lv2Worker*> Lv2Worker::s_workers;
+std::vector<QThread*> Lv2Worker::s_threads;
+int Lv2Worker::s_generation = 0;
+
+
+
+
+class Lv2Worker::Thread : public QThread
+{
+public:
+	Thread(int generation) :
+		m_generation(generation)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		threadLoop(m_generation);
+	}
+
+private:
+	const int m_generation;
+};
+
+
+
+
+namespace
+{
+
+//! How often the pool threads look for new work. Scheduling work does not
+//! wake them, as waking a thread is not realtime safe.
+const unsigned long pollInterval = 5; // ms
+
+//! Writes a message of @p size bytes from @p data, using @p buffer to write
+//! it at once, so the reader never sees half of it
+bool writeMessage(ringbuffer_t<char>& ring, std::vector<char>& buffer,
+	uint32_t size, const void* data)
+{
+	const std::size_t total = sizeof(size) + size;
+	if (total > buffer.size() || ring.write_space() < total)
+	{
+		return false;
+	}
+	std::memcpy(buffer.data(), &size, sizeof(size));
+	std::memcpy(buffer.data() + sizeof(size), data, size);
+	return ring.write(buffer.data(), total) == total;
+}
+
+//! Reads the next message into @p body, returns false if there is none
+bool readMessage(ringbuffer_reader_t<char>& reader, std::vector<char>& body,
+	uint32_t& size)
+{
+	if (reader.read_space() < sizeof(size))
+	{
+		return false;
+	}
+	char header[sizeof(size)];
+	{
+		auto seq = reader.read(sizeof(size));
+		for (std::size_t i = 0; i < sizeof(size); ++i) { header[i] = seq[i]; }
+	}
+	std::memcpy(&size, header, sizeof(size));
+	{
+		auto seq = reader.read(size);
+		for (uint32_t i = 0; i < size; ++i) { body[i] = seq[i]; }
+	}
+	return true;
+}
+
+}
+
+
+
+
+Lv2Worker::Lv2Worker() :
+	m_requests(ringSize()),
+	m_requestReader(m_requests),
+	m_responses(ringSize()),
+	m_responseReader(m_responses),
+	m_request(ringSize()),
+	m_response(ringSize()),
+	m_scheduleBuffer(ringSize()),
+	m_respondBuffer(ringSize()),
+	m_pending(false)
+{
+	// reserve storage space before realtime operation starts
+	m_requests.touch();
+	m_responses.touch();
+
+	m_schedule.handle = this;
+	m_schedule.schedule_work = &Lv2Worker::scheduleWork;
+}
+
+
+
+
+Lv2Worker::~Lv2Worker()
+{
+	if (m_interface)
+	{
+		removeWorker(this);
+	}
+}
+
+
+
+
+void Lv2Worker::start(LilvInstance* instance)
+{
+	m_interface = static_cast<const LV2_Worker_Interface*>(
+		lilv_instance_get_extension_data(instance, LV2_WORKER__interface));
+	if (m_interface)
+	{
+		m_handle = lilv_instance_get_handle(instance);
+		addWorker(this);
+	}
+}
+
+
+
+
+void Lv2Worker::deliverResponses()
+{
+	if (!m_interface)
+	{
+		return;
+	}
+	uint32_t size;
+	while (readMessage(m_responseReader, m_response, size))
+	{
+		m_interface->work_response(m_handle, size, m_response.data());
+	}
+}
+
+
+
+
+void Lv2Worker::endRun()
+{
+	if (m_interface && m_interface->end_run)
+	{
+		m_interface->end_run(m_handle);
+	}
+}
+
+
+
+
+LV2_Worker_Status Lv2Worker::scheduleWork(LV2_Worker_Schedule_Handle handle,
+	uint32_t size, const void* data)
+{
+	Lv2Worker* worker = static_cast<Lv2Worker*>(handle);
+	if (!worker->m_interface)
+	{
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+	if (!writeMessage(worker->m_requests, worker->m_scheduleBuffer, size, data))
+	{
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
+	worker->m_pending.store(true, std::memory_order_release);
+	return LV2_WORKER_SUCCESS;
+}
+
+
+
+
+LV2_Worker_Status Lv2Worker::respond(LV2_Worker_Respond_Handle handle,
+	uint32_t size, const void* data)
+{
+	Lv2Worker* worker = static_cast<Lv2Worker*>(handle);
+	return writeMessage(worker->m_responses, worker->m_respondBuffer, size, data)
+		? LV2_WORKER_SUCCESS
+		: LV2_WORKER_ERR_NO_SPACE;
+}
+
+
+
+
+void Lv2Worker::work()
+{
+	uint32_t size;
+	while (readMessage(m_requestReader, m_request, size))
+	{
+		m_interface->work(m_handle, &Lv2Worker::respond, this, size,
+			m_request.data());
+	}
+}
+
+
+
+
+void Lv2Worker::addWorker(Lv2Worker* worker)
+{
+	QMutexLocker lock(&s_mutex);
+	s_workers.push_back(worker);
+
+	if (s_threads.empty())
+	{
+		// work is mostly loading files, more threads would only compete
+		// for the disk
+		const int count = qBound(1, QThread::idealThreadCount() - 1, 2);
+		for (int i = 0; i < count; ++i)
+		{
+			QThread* thread = new Thread(s_generation);
+			thread->start();
+			s_threads.push_back(thread);
+		}
+	}
+}
+
+
+
+
+void Lv2Worker::removeWorker(Lv2Worker* worker)
+{
+	QMutexLocker lock(&s_mutex);
+	s_workers.erase(std::remove(s_workers.begin(), s_workers.end(), worker),
+		s_workers.end());
+	while (worker->m_running)
+	{
+		s_workDone.wait(&s_mutex);
+	}
+
+	if (!s_workers.empty())
+	{
+		return;
+	}
+
+	// no plugin left to work for, don't keep idle threads around. Threads
+	// started by a worker added meanwhile belong to the next generation.
+	std::vector<QThread*> threads;
+	threads.swap(s_threads);
+	++s_generation;
+	s_wake.wakeAll();
+	lock.unlock();
+
+	for (QThread* thread : threads)
+	{
+		thread->wait();
+		delete thread;
+	}
+}
+
+
+
+
+void Lv2Worker::threadLoop(int generation)
+{
+	QMutexLocker lock(&s_mutex);
+	while (generation == s_generation)
+	{
+		for (std::size_t i = 0; i < s_workers.size() && generation == s_generation; ++i)
+		{
+			Lv2Worker* worker = s_workers[i];
+			if (worker->m_running ||
+				!worker->m_pending.exchange(false, std::memory_order_acquire))
+			{
+				continue;
+			}
+
+			worker->m_running = true;
+			lock.unlock();
+			worker->work();
+			lock.relock();
+			worker->m_running = false;
+			s_workDone.wakeAll();
+		}
+
+		if (generation == s_generation)
+		{
+			s_wake.wait(&s_mutex, pollInterval);
+		}
+	}
+}
+
+
+#endif // LMMS_HAVE_LV2
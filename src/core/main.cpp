@@ -31,6 +31,7 @@
 
 #include <QDebug>
 #include <QFileInfo>
+#include <QJsonDocument>
 #include <QLocale>
 #include <QTimer>
 #include <QTranslator>
@@ -58,6 +59,9 @@
 #include <signal.h>
 
 #include "MainApplication.h"
+#include "BatchRenderer.h"
+#include "BlockCompression.h"
+#include "BufferManager.h"
 #include "ConfigManager.h"
 #include "DataFile.h"
 #include "NotePlayHandle.h"
@@ -66,10 +70,13 @@
 #include "GuiApplication.h"
 #include "ImportFilter.h"
 #include "MainWindow.h"
+#include "MemoryUsage.h"
 #include "MixHelpers.h"
 #include "OutputSettings.h"
+#include "PerfLog.h"
 #include "ProjectRenderer.h"
 #include "RenderManager.h"
+#include "SegmentRenderer.h"
 #include "Song.h"
 #include "SetupDialog.h"
 
@@ -162,13 +169,18 @@ void printHelp()
 		"Usage: lmms [global options...] [<action> [action parameters...]]\n\n"
 		"Actions:\n"
 		"  <no action> [options...] [<project>]  Start LMMS in normal GUI mode\n"
-		"  dump <in>                             Dump XML of compressed file <in>\n"
+		"  dump <in>                             Dump XML of compressed or binary file <in>\n"
 		"  compress <in>                         Compress file <in>\n"
 		"  render <project> [options...]         Render given project file\n"
 		"  rendertracks <project> [options...]   Render each track to a different file\n"
+		"  renderbatch <jobs> [options...]       Render the projects listed in <jobs>,\n"
+		"                                        or read from stdin if <jobs> is -,\n"
+		"                                        with one engine. Each line is\n"
+		"                                        project[<tab>output[<tab>formats]]\n"
 		"  upgrade <in> [out]                    Upgrade file <in> and save as <out>\n"
 		"                                        Standard out is used if no output file\n"
-		"                                        is specified\n"
+		"                                        is specified, <out> may be a binary\n"
+		"                                        .mmpb project\n"
 		"  makebundle <in> [out]                 Make a project bundle from the project\n"
 		"                                        file <in> saving the resulting bundle\n"
 		"                                        as <out>\n"
@@ -177,6 +189,15 @@ void printHelp()
 		"          caution).\n"
 		"  -c, --config <configfile>      Get the configuration from <configfile>\n"
 		"  -h, --help                     Show this usage information and exit.\n"
+		"      --timeline                 Print the time taken by each phase of\n"
+		"          startup and of loading projects to stderr\n"
+		"      --timeline-trace <out>     Like --timeline, and also write the\n"
+		"          phases to <out> in the Trace Event Format of\n"
+		"          chrome://tracing and Perfetto\n"
+		"      --trace <out>              Record the rendering, worker jobs,\n"
+		"          effects, remote plugins, decoding, loading and painting\n"
+		"          and write them to <out> on exit, in the same format.\n"
+		"          Needs a build with WANT_DEBUG_TRACE.\n"
 		"  -v, --version                  Show version information and exit.\n"
 		"\nOptions if no action is given:\n"
 		"      --geometry <geometry>      Specify the size and position of\n"
@@ -184,12 +205,17 @@ void printHelp()
 		"          geometry is <xsizexysize+xoffset+yoffsety>.\n"
 		"      --import <in> [-e]         Import MIDI or Hydrogen file <in>.\n"
 		"          If -e is specified lmms exits after importing the file.\n"
-		"\nOptions for \"render\" and \"rendertracks\":\n"
+		"\nOptions for \"render\", \"rendertracks\" and \"renderbatch\":\n"
 		"  -a, --float                    Use 32bit float bit depth\n"
 		"  -b, --bitrate <bitrate>        Specify output bitrate in KBit/s\n"
 		"          Default: 160.\n"
+		"      --dither <method>          Dithering of integer samples\n"
+		"          Possible values: none (default), triangular, shaped\n"
 		"  -f, --format <format>         Specify format of render-output where\n"
 		"          Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
+		"          Several formats separated by commas are rendered in\n"
+		"          one pass, e.g. wav,flac,mp3:44100; all but the first\n"
+		"          can have their own sample rate after a colon.\n"
 		"  -i, --interpolation <method>   Specify interpolation method\n"
 		"          Possible values:\n"
 		"            - linear\n"
@@ -209,8 +235,21 @@ void printHelp()
 		"          If not specified, render will overwrite the input file\n"
 		"          For \"rendertracks\", this might be required\n"
 		"  -p, --profile <out>            Dump profiling information to file <out>\n"
+		"          One line per period with the total time and the time of\n"
+		"          song, play handles, tracks and FX mixer in microseconds\n"
+		"      --report <out>             For \"render\" and \"rendertracks\", write\n"
+		"          the throughput of the render as JSON to file <out>\n"
+		"          or to stdout if <out> is -\n"
 		"  -s, --samplerate <samplerate>  Specify output samplerate in Hz\n"
 		"          Range: 44100 (default) to 192000\n"
+		"      --segments <count>         For \"render\", experimental: render up to\n"
+		"          <count> segments of the song in parallel, split at breaks,\n"
+		"          if all plugins in it are resettable\n"
+		"      --preroll <bars>           Bars rendered before each segment\n"
+		"          Default: 2\n"
+		"      --single-pass              For \"rendertracks\", render all tracks at\n"
+		"          once, taking the track outputs before the FX mixer\n"
+		"          The FX mixer output is rendered into an extra file\n"
 		"  -x, --oversampling <value>     Specify oversampling\n"
 		"          Possible values: 1, 2, 4, 8\n"
 		"          Default: 2\n\n",
@@ -307,7 +346,15 @@ int main( int argc, char * * argv )
 	bool allowRoot = false;
 	bool renderLoop = false;
 	bool renderTracks = false;
+	bool singlePass = false;
+	int segmentCount = 1;
+	bar_t segmentPreRoll = 2;
+	// ticks a segment renderer process renders
+	tick_t segmentBegin = 0, segmentEnd = 0;
 	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, configFile;
+	QString renderReportFile;
+	QString batchJobs;
+	QString traceFile;
 
 	// first of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -325,10 +372,34 @@ int main( int argc, char * * argv )
 			coreOnly = true;
 			renderTracks = true;
 		}
+		else if( arg == "renderbatch" || arg == "--renderbatch" )
+		{
+			coreOnly = true;
+		}
 		else if( arg == "--allowroot" )
 		{
 			allowRoot = true;
 		}
+		else if( arg == "--timeline" )
+		{
+			PerfTimeline::setEnabled( true );
+		}
+		else if( arg == "--timeline-trace" && i + 1 < argc )
+		{
+			PerfTimeline::setEnabled( true );
+			PerfTimeline::setTraceFile( QString::fromLocal8Bit( argv[++i] ) );
+		}
+		else if( arg == "--trace" && i + 1 < argc )
+		{
+			traceFile = QString::fromLocal8Bit( argv[++i] );
+#ifdef LMMS_DEBUG_TRACE
+			PerfTrace::setThreadName( "Main" );
+			PerfTrace::start();
+#else
+			printf( "Tracing isn't available, LMMS was built without "
+						"WANT_DEBUG_TRACE.\n" );
+#endif
+		}
 		else if( arg == "--geometry" || arg == "-geometry")
 		{
 			if( arg == "--geometry" )
@@ -358,13 +429,21 @@ int main( int argc, char * * argv )
 #if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
 	QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 #endif
+	PerfTimeline::begin( "Startup" );
+	PerfTimeline::Phase applicationPhase( "Application" );
 	QCoreApplication * app = coreOnly ?
 			new QCoreApplication( argc, argv ) :
 					new MainApplication( argc, argv );
+	applicationPhase.finish();
 
 	Mixer::qualitySettings qs( Mixer::qualitySettings::Mode_HighQuality );
+	// exports update modulated filters on every frame, like in the GUI
+	qs.controlInterval = 1;
 	OutputSettings os( 44100, OutputSettings::BitRateSettings(160, false), OutputSettings::Depth_16Bit, OutputSettings::StereoMode_JointStereo );
 	ProjectRenderer::ExportFileFormats eff = ProjectRenderer::WaveFile;
+	// further formats rendered in the same pass, with their sample rate
+	// or 0 for the one of the first format
+	QVector<QPair<ProjectRenderer::ExportFileFormats, sample_rate_t>> extraFormats;
 
 	// second of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -428,6 +507,28 @@ int main( int argc, char * * argv )
 				return usageError("No project bundle name given");
 			}
 		}
+		else if( arg == "--timeline" )
+		{
+			// Ignore, processed earlier
+		}
+		else if( arg == "--timeline-trace" )
+		{
+			// Ignore, processed earlier
+			++i;
+			if( i == argc )
+			{
+				return usageError( "No trace file specified" );
+			}
+		}
+		else if( arg == "--trace" )
+		{
+			// Ignore, processed earlier
+			++i;
+			if( i == argc )
+			{
+				return usageError( "No trace file specified" );
+			}
+		}
 		else if( arg == "--allowroot" )
 		{
 			// Ignore, processed earlier
@@ -449,9 +550,20 @@ int main( int argc, char * * argv )
 			}
 
 
-			QFile f( QString::fromLocal8Bit( argv[i] ) );
+			const QString fileName = QString::fromLocal8Bit( argv[i] );
+			if( DataFile::isBinaryProject( fileName ) )
+			{
+				// binary projects have no XML to dump, so it's written
+				DataFile dataFile( fileName );
+				QTextStream ts( stdout );
+				dataFile.write( ts );
+				fflush( stdout );
+				return EXIT_SUCCESS;
+			}
+
+			QFile f( fileName );
 			f.open( QIODevice::ReadOnly );
-			QString d = qUncompress( f.readAll() );
+			QString d = BlockCompression::uncompress( f.readAll() );
 			printf( "%s\n", d.toUtf8().constData() );
 
 			return EXIT_SUCCESS;
@@ -467,7 +579,7 @@ int main( int argc, char * * argv )
 
 			QFile f( QString::fromLocal8Bit( argv[i] ) );
 			f.open( QIODevice::ReadOnly );
-			QByteArray d = qCompress( f.readAll() ) ;
+			QByteArray d = BlockCompression::compress( f.readAll() );
 			fwrite( d.constData(), sizeof(char), d.size(), stdout );
 
 			return EXIT_SUCCESS;
@@ -486,10 +598,67 @@ int main( int argc, char * * argv )
 			fileToLoad = QString::fromLocal8Bit( argv[i] );
 			renderOut = fileToLoad;
 		}
+		else if( arg == "renderbatch" || arg == "--renderbatch" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No job list specified" );
+			}
+
+			batchJobs = QString::fromLocal8Bit( argv[i] );
+		}
 		else if( arg == "--loop" || arg == "-l" )
 		{
 			renderLoop = true;
 		}
+		else if( arg == "--single-pass" )
+		{
+			singlePass = true;
+		}
+		else if( arg == "--segments" || arg == "--preroll" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( QString( "No value for %1 specified" ).arg( arg ) );
+			}
+
+			bool ok = false;
+			const int value = QString( argv[i] ).toInt( &ok );
+			if( !ok || value < 1 )
+			{
+				return usageError( QString( "Invalid value %1 for %2" ).arg( argv[i] ).arg( arg ) );
+			}
+			if( arg == "--segments" )
+			{
+				segmentCount = value;
+			}
+			else
+			{
+				segmentPreRoll = value;
+			}
+		}
+		// the part of the song a process started by SegmentRenderer renders
+		else if( arg == "--segment" )
+		{
+			++i;
+
+			const QStringList range = i < argc ?
+				QString( argv[i] ).split( ':' ) : QStringList();
+			bool beginOk = false, endOk = false;
+			if( range.size() == 2 )
+			{
+				segmentBegin = range[0].toInt( &beginOk );
+				segmentEnd = range[1].toInt( &endOk );
+			}
+			if( !beginOk || !endOk || segmentBegin < 0 || segmentEnd <= segmentBegin )
+			{
+				return usageError( "Invalid segment, expected <begin>:<end> in ticks" );
+			}
+		}
 		else if( arg == "--output" || arg == "-o" )
 		{
 			++i;
@@ -512,31 +681,58 @@ int main( int argc, char * * argv )
 			}
 
 
-			const QString ext = QString( argv[i] );
-
-			if( ext == "wav" )
+			extraFormats.clear();
+			const QStringList formats = QString( argv[i] ).split( ',' );
+			for( int f = 0; f < formats.size(); ++f )
 			{
-				eff = ProjectRenderer::WaveFile;
-			}
+				// each but the first can have its own sample rate,
+				// e.g. mp3:44100
+				const QStringList parts = formats[f].split( ':' );
+				const QString ext = parts[0];
+				sample_rate_t sr = 0;
+				if( parts.size() > 1 )
+				{
+					sr = parts[1].toUInt();
+					if( f == 0 || sr < 44100 || sr > 192000 )
+					{
+						return usageError( QString( "Invalid samplerate for format %1" ).arg( formats[f] ) );
+					}
+				}
+
+				ProjectRenderer::ExportFileFormats format;
+				if( ext == "wav" )
+				{
+					format = ProjectRenderer::WaveFile;
+				}
 #ifdef LMMS_HAVE_OGGVORBIS
-			else if( ext == "ogg" )
-			{
-				eff = ProjectRenderer::OggFile;
-			}
+				else if( ext == "ogg" )
+				{
+					format = ProjectRenderer::OggFile;
+				}
 #endif
 #ifdef LMMS_HAVE_MP3LAME
-			else if( ext == "mp3" )
-			{
-				eff = ProjectRenderer::MP3File;
-			}
+				else if( ext == "mp3" )
+				{
+					format = ProjectRenderer::MP3File;
+				}
 #endif
-			else if (ext == "flac")
-			{
-				eff = ProjectRenderer::FlacFile;
-			}
-			else
-			{
-				return usageError( QString( "Invalid output format %1" ).arg( argv[i] ) );
+				else if (ext == "flac")
+				{
+					format = ProjectRenderer::FlacFile;
+				}
+				else
+				{
+					return usageError( QString( "Invalid output format %1" ).arg( formats[f] ) );
+				}
+
+				if( f == 0 )
+				{
+					eff = format;
+				}
+				else
+				{
+					extraFormats.push_back( qMakePair( format, sr ) );
+				}
 			}
 		}
 		else if( arg == "--samplerate" || arg == "-s" )
@@ -614,6 +810,34 @@ int main( int argc, char * * argv )
 		{
 			os.setBitDepth(OutputSettings::Depth_32Bit);
 		}
+		else if( arg == "--dither" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No dithering specified" );
+			}
+
+			QString const dither( argv[i] );
+
+			if( dither == "none" )
+			{
+				os.setDithering(SampleConversion::DitherNone);
+			}
+			else if( dither == "triangular" )
+			{
+				os.setDithering(SampleConversion::DitherTriangular);
+			}
+			else if( dither == "shaped" )
+			{
+				os.setDithering(SampleConversion::DitherShaped);
+			}
+			else
+			{
+				return usageError( QString( "Invalid dithering %1" ).arg( argv[i] ) );
+			}
+		}
 		else if( arg == "--interpolation" || arg == "-i" )
 		{
 			++i;
@@ -707,6 +931,17 @@ int main( int argc, char * * argv )
 
 			profilerOutputFile = QString::fromLocal8Bit( argv[i] );
 		}
+		else if( arg == "--report" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No report file specified" );
+			}
+
+			renderReportFile = QString::fromLocal8Bit( argv[i] );
+		}
 		else if( arg == "--config" || arg == "-c" )
 		{
 			++i;
@@ -738,6 +973,7 @@ int main( int argc, char * * argv )
 		fileCheck( fileToImport );
 	}
 
+	PerfTimeline::Phase configPhase( "Configuration" );
 	ConfigManager::inst()->loadConfigFile(configFile);
 
 	// Hidden settings
@@ -761,6 +997,7 @@ int main( int argc, char * * argv )
 #endif
 	// override it with bundled/custom one, if exists
 	loadTranslation(QString("qt_") + pos, ConfigManager::inst()->localeDir());
+	configPhase.finish();
 
 
 	// try to set realtime priority
@@ -800,6 +1037,7 @@ int main( int argc, char * * argv )
 #endif
 
 	bool destroyEngine = false;
+	RenderManager * renderManager = nullptr;
 
 	// if we have an output file for rendering, just render the song
 	// without starting the GUI
@@ -818,40 +1056,97 @@ int main( int argc, char * * argv )
 		printf( "Done\n" );
 
 		Engine::getSong()->setExportLoop( renderLoop );
+		Engine::getSong()->setExportRange( segmentBegin, segmentEnd );
 
 		// when rendering multiple tracks, renderOut is a directory
 		// otherwise, it is a file, so we need to append the file extension
+		const QString renderBase = baseName( renderOut );
 		if ( !renderTracks )
 		{
-			renderOut = baseName( renderOut ) +
+			renderOut = renderBase +
 				ProjectRenderer::getFileExtensionFromFormat(eff);
 		}
 
-		// create renderer
-		RenderManager * r = new RenderManager( qs, os, eff, renderOut );
-		QCoreApplication::instance()->connect( r,
-				SIGNAL( finished() ), SLOT( quit() ) );
+		if( segmentCount > 1 && !renderTracks )
+		{
+			if( !extraFormats.isEmpty() )
+			{
+				printf( "Only the first format is used when rendering in segments\n" );
+			}
+			SegmentRenderer * s = new SegmentRenderer( qs, os, eff,
+					fileToLoad, renderOut, segmentCount, segmentPreRoll );
+			QTimer * t = new QTimer( s );
+			s->connect( t, SIGNAL( timeout() ),
+					SLOT( updateConsoleProgress() ) );
+			t->start( 200 );
+			s->start();
+		}
+		else
+		{
+			// create renderer
+			RenderManager * r = new RenderManager( qs, os, eff, renderOut );
+			renderManager = r;
+			for( const auto & format : extraFormats )
+			{
+				if( renderTracks )
+				{
+					printf( "Only the first format is used when rendering tracks\n" );
+					break;
+				}
+				OutputSettings extraSettings = os;
+				if( format.second != 0 )
+				{
+					extraSettings.setSampleRate( format.second );
+				}
+				r->addOutput( extraSettings, format.first, renderBase +
+					ProjectRenderer::getFileExtensionFromFormat( format.first ) );
+			}
+			QCoreApplication::instance()->connect( r,
+					SIGNAL( finished() ), SLOT( quit() ) );
 
-		// timer for progress-updates
-		QTimer * t = new QTimer( r );
-		r->connect( t, SIGNAL( timeout() ),
-				SLOT( updateConsoleProgress() ) );
-		t->start( 200 );
+			// timer for progress-updates
+			QTimer * t = new QTimer( r );
+			r->connect( t, SIGNAL( timeout() ),
+					SLOT( updateConsoleProgress() ) );
+			t->start( 200 );
 
-		if( profilerOutputFile.isEmpty() == false )
-		{
-			Engine::mixer()->profiler().setOutputFile( profilerOutputFile );
+			if( profilerOutputFile.isEmpty() == false )
+			{
+				Engine::mixer()->profiler().setOutputFile( profilerOutputFile );
+			}
+
+			// start now!
+			if ( renderTracks )
+			{
+				r->renderTracks( singlePass );
+			}
+			else
+			{
+				r->renderProject();
+			}
 		}
+	}
+	// render a list of projects, keeping the engine between them
+	else if( !batchJobs.isEmpty() )
+	{
+		Engine::init( true );
+		destroyEngine = true;
 
-		// start now!
-		if ( renderTracks )
+		BatchRenderer * b = new BatchRenderer( qs, os, eff, renderLoop,
+								batchJobs );
+		if( !b->isReady() )
 		{
-			r->renderTracks();
+			printf( "Could not open the job list %s\n",
+					batchJobs.toUtf8().constData() );
+			exit( EXIT_FAILURE );
 		}
-		else
+
+		if( profilerOutputFile.isEmpty() == false )
 		{
-			r->renderProject();
+			Engine::mixer()->profiler().setOutputFile( profilerOutputFile );
 		}
+
+		b->start();
 	}
 	else // otherwise, start the GUI
 	{
@@ -1012,12 +1307,63 @@ int main( int argc, char * * argv )
 		}
 	}
 
+	PerfTimeline::end();
+	PerfTimeline::report();
+
 	const int ret = app->exec();
 	delete app;
 
+	if( !traceFile.isEmpty() )
+	{
+		PerfTrace::stop();
+		PerfTrace::write( traceFile );
+	}
+
+	if( renderManager )
+	{
+		const ProjectRenderer::Statistics stats = renderManager->statistics();
+		fprintf( stderr, "\nRendered %.1f s in %.1f s (%.1fx realtime), "
+				"encoding took %.1f s, peak memory %llu MiB",
+				stats.renderedTime, stats.elapsedTime,
+				stats.realtimeFactor(), stats.encodingTime,
+				static_cast<unsigned long long>( stats.peakMemoryKiB / 1024 ) );
+
+		// what the memory was taken by, the project is still loaded
+		const MemoryUsage::Report memory = MemoryUsage::collect();
+		fprintf( stderr, "\nMemory:" );
+		for( int i = 0; i < MemoryUsage::NumSubsystems; ++i )
+		{
+			const auto subsystem = static_cast<MemoryUsage::Subsystems>( i );
+			fprintf( stderr, "%s %s %s", i > 0 ? "," : "",
+				MemoryUsage::subsystemName( subsystem ).toUtf8().constData(),
+				MemoryUsage::megabytes( memory.subsystems.bytes[i] )
+							.toUtf8().constData() );
+		}
+
+		if( !renderReportFile.isEmpty() )
+		{
+			QFile report( renderReportFile );
+			const bool opened = renderReportFile == "-" ?
+				report.open( stdout, QFile::WriteOnly ) :
+				report.open( QFile::WriteOnly | QFile::Truncate );
+			if( opened )
+			{
+				QJsonObject object = stats.toJson();
+				object["memory"] = memory.toJson();
+				report.write( QJsonDocument( object ).toJson() );
+			}
+			else
+			{
+				printf( "Could not write the report to %s\n",
+					renderReportFile.toUtf8().constData() );
+			}
+		}
+	}
+
 	if( destroyEngine )
 	{
 		Engine::destroy();
+		BufferManager::reportUsage();
 	}
 
 	// ProjectRenderer::updateConsoleProgress() doesn't return line after render
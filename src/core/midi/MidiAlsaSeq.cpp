@@ -25,6 +25,7 @@
 #include "MidiAlsaSeq.h"
 #include "ConfigManager.h"
 #include "Engine.h"
+#include "Mixer.h"
 #include "gui_templates.h"
 #include "Song.h"
 #include "MidiPort.h"
@@ -157,7 +158,7 @@ QString MidiAlsaSeq::probeDevice()
 
 
 
-void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos& time, const MidiPort* port )
+void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos& time, f_cnt_t, const MidiPort* port )
 {
 	// HACK!!! - need a better solution which isn't that easy since we
 	// cannot store const-ptrs in our map because we need to call non-const
@@ -219,6 +220,32 @@ void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos& time,
 						event.param( 0 ) - 8192 );
 			break;
 
+		case MidiTimeCode:
+			ev.type = SND_SEQ_EVENT_QFRAME;
+			ev.data.control.value = event.param( 0 );
+			break;
+
+		case MidiSongPosition:
+			ev.type = SND_SEQ_EVENT_SONGPOS;
+			ev.data.control.value = event.param( 0 ) | ( event.param( 1 ) << 7 );
+			break;
+
+		case MidiSync:
+			ev.type = SND_SEQ_EVENT_CLOCK;
+			break;
+
+		case MidiStart:
+			ev.type = SND_SEQ_EVENT_START;
+			break;
+
+		case MidiContinue:
+			ev.type = SND_SEQ_EVENT_CONTINUE;
+			break;
+
+		case MidiStop:
+			ev.type = SND_SEQ_EVENT_STOP;
+			break;
+
 		default:
 			qWarning( "MidiAlsaSeq: unhandled output event %d\n", (int) event.type() );
 			return;
@@ -389,6 +416,11 @@ void MidiAlsaSeq::subscribeReadablePort( MidiPort * _port,
 	snd_seq_port_subscribe_malloc( &subs );
 	snd_seq_port_subscribe_set_sender( subs, &sender );
 	snd_seq_port_subscribe_set_dest( subs, dest );
+	// stamp the events with the real time of our queue when they come in,
+	// see run()
+	snd_seq_port_subscribe_set_queue( subs, m_queueID );
+	snd_seq_port_subscribe_set_time_update( subs, 1 );
+	snd_seq_port_subscribe_set_time_real( subs, 1 );
 	if( _subscribe )
 	{
 		snd_seq_subscribe_port( m_seqHandle, subs );
@@ -467,6 +499,9 @@ void MidiAlsaSeq::run()
 	pollfd_set[0].events = POLLIN;
 	++pollfd_count;
 
+	snd_seq_queue_status_t * queueStatus;
+	snd_seq_queue_status_malloc( &queueStatus );
+
 	while( m_quit == false )
 	{
 		int pollRet = poll( pollfd_set, pollfd_count, EventPollTimeOut );
@@ -503,6 +538,27 @@ void MidiAlsaSeq::run()
 				qCritical( "error while fetching MIDI event from sequencer" );
 				break;
 			}
+
+			// the tracks time the event by when they get it, which is
+			// later than it came in if this thread was held up, or read
+			// several events at once
+			f_cnt_t offset = 0;
+			const bool stamped = ( ev->flags & SND_SEQ_TIME_STAMP_MASK ) ==
+							SND_SEQ_TIME_STAMP_REAL;
+			if( stamped && snd_seq_get_queue_status( m_seqHandle, m_queueID,
+								queueStatus ) == 0 )
+			{
+				const snd_seq_real_time_t * now =
+					snd_seq_queue_status_get_real_time( queueStatus );
+				const qint64 age =
+					( now->tv_sec - ev->time.time.tv_sec ) * 1000000000LL +
+					now->tv_nsec - ev->time.time.tv_nsec;
+				offset = -static_cast<f_cnt_t>( qMax<qint64>( age, 0 ) *
+					Engine::mixer()->processingSampleRate() / 1000000000LL );
+			}
+			// the tick isn't set for events stamped in real time
+			const TimePos time = stamped ? TimePos() : TimePos( ev->time.tick );
+
 			m_seqMutex.unlock();
 
 			snd_seq_addr_t * source = NULL;
@@ -535,7 +591,7 @@ void MidiAlsaSeq::run()
 								ev->data.note.velocity,
 								source
 								),
-							TimePos( ev->time.tick ) );
+							time, offset );
 					break;
 
 				case SND_SEQ_EVENT_NOTEOFF:
@@ -545,7 +601,7 @@ void MidiAlsaSeq::run()
 								ev->data.note.velocity,
 								source
 								),
-							TimePos( ev->time.tick) );
+							time, offset );
 					break;
 
 				case SND_SEQ_EVENT_KEYPRESS:
@@ -555,7 +611,7 @@ void MidiAlsaSeq::run()
 								ev->data.note.note,
 								ev->data.note.velocity,
 								source
-								), TimePos() );
+								), TimePos(), offset );
 					break;
 
 				case SND_SEQ_EVENT_CONTROLLER:
@@ -564,7 +620,7 @@ void MidiAlsaSeq::run()
 							ev->data.control.channel,
 							ev->data.control.param,
 							ev->data.control.value, source ),
-									TimePos() );
+									TimePos(), offset );
 					break;
 
 				case SND_SEQ_EVENT_PGMCHANGE:
@@ -573,7 +629,7 @@ void MidiAlsaSeq::run()
 							ev->data.control.channel,
 							ev->data.control.value,	0,
 							source ),
-								TimePos() );
+								TimePos(), offset );
 					break;
 
 				case SND_SEQ_EVENT_CHANPRESS:
@@ -582,14 +638,14 @@ void MidiAlsaSeq::run()
 							ev->data.control.channel,
 							ev->data.control.param,
 							ev->data.control.value, source ),
-									TimePos() );
+									TimePos(), offset );
 					break;
 
 				case SND_SEQ_EVENT_PITCHBEND:
 					dest->processInEvent( MidiEvent( MidiPitchBend,
 							ev->data.control.channel,
 							ev->data.control.value + 8192, 0, source ),
-									TimePos() );
+									TimePos(), offset );
 					break;
 
 				case SND_SEQ_EVENT_SENSING:
@@ -611,6 +667,7 @@ void MidiAlsaSeq::run()
 
 	}
 
+	snd_seq_queue_status_free( queueStatus );
 	delete[] pollfd_set;
 }
 
@@ -24,11 +24,16 @@
  */
 
 #include "MidiClient.h"
+
+#include <QThread>
+
 #include "MidiPort.h"
 #include "Note.h"
 
 
-MidiClient::MidiClient()
+MidiClient::MidiClient() :
+	m_portsSnapshot( new QVector<MidiPort *> ),
+	m_readers( 0 )
 {
 }
 
@@ -42,6 +47,20 @@ MidiClient::~MidiClient()
 	{
 		port->invalidateCilent();
 	}
+	delete m_portsSnapshot.load();
+}
+
+
+
+
+void MidiClient::processOutSync( const MidiEvent& event, f_cnt_t offset )
+{
+	forEachPort( [&]( MidiPort * port ) {
+		if( port->isOutputEnabled() )
+		{
+			processOutEvent( event, TimePos(), offset, port );
+		}
+	} );
 }
 
 
@@ -64,6 +83,7 @@ void MidiClient::applyPortName( MidiPort* )
 void MidiClient::addPort( MidiPort* port )
 {
 	m_midiPorts.push_back( port );
+	publishPorts();
 }
 
 
@@ -81,7 +101,23 @@ void MidiClient::removePort( MidiPort* port )
 	if( it != m_midiPorts.end() )
 	{
 		m_midiPorts.erase( it );
+		// the port may be deleted once no thread dispatches to it anymore
+		publishPorts();
+	}
+}
+
+
+
+
+void MidiClient::publishPorts()
+{
+	const QVector<MidiPort *> * old =
+		m_portsSnapshot.exchange( new QVector<MidiPort *>( m_midiPorts ) );
+	while( m_readers.load() > 0 )
+	{
+		QThread::yieldCurrentThread();
 	}
+	delete old;
 }
 
 
@@ -134,7 +170,7 @@ void MidiClientRaw::parseData( const unsigned char c )
 		{
 			m_midiParseData.m_midiEvent.setType( MidiSystemReset );
 			m_midiParseData.m_status = 0;
-			processParsedEvent();
+			processEvent( m_midiParseData.m_midiEvent, 0 );
 		}
 		return;
 	}
@@ -214,71 +250,175 @@ void MidiClientRaw::parseData( const unsigned char c )
 	 * We simply keep the status as it is, just reset the parameter counter.
 	 * If another status byte comes in, it will overwrite the status. 
 	 */
-	m_midiParseData.m_midiEvent.setType(static_cast<MidiEventTypes>(m_midiParseData.m_status));
-	m_midiParseData.m_midiEvent.setChannel(m_midiParseData.m_channel);
 	m_midiParseData.m_bytes = 0; /* Related to running status! */
-	switch (m_midiParseData.m_midiEvent.type())
+	if( makeEvent( m_midiParseData.m_midiEvent,
+			m_midiParseData.m_status | m_midiParseData.m_channel,
+			m_midiParseData.m_buffer[0], m_midiParseData.m_buffer[1] ) )
+	{
+		processEvent( m_midiParseData.m_midiEvent, 0 );
+	}
+}
+
+
+
+
+void MidiClientRaw::processMessage( const unsigned char * data, std::size_t size,
+								f_cnt_t offset )
+{
+	if( size == 0 )
+	{
+		return;
+	}
+
+	if( data[0] == MidiSystemReset )
+	{
+		processEvent( MidiEvent( MidiSystemReset ), offset );
+		return;
+	}
+
+	// like parseData(), only voice messages are handled
+	const int status = data[0];
+	if( status < 0x80 || status >= 0xF0 ||
+		static_cast<int>( size ) < eventLength( status & 0xF0 ) )
+	{
+		return;
+	}
+
+	MidiEvent event;
+	if( makeEvent( event, status, size > 1 ? data[1] : 0, size > 2 ? data[2] : 0 ) )
+	{
+		processEvent( event, offset );
+	}
+}
+
+
+
+
+bool MidiClientRaw::makeEvent( MidiEvent& event, int status, int data1, int data2 )
+{
+	event.setType( static_cast<MidiEventTypes>( status & 0xF0 ) );
+	event.setChannel( status & 0x0F );
+	switch( event.type() )
 	{
 		case MidiNoteOff:
 		case MidiNoteOn:
 		case MidiKeyPressure:
 		case MidiChannelPressure:
 		case MidiProgramChange:
-			m_midiParseData.m_midiEvent.setKey(m_midiParseData.m_buffer[0]);
-			m_midiParseData.m_midiEvent.setVelocity(m_midiParseData.m_buffer[1]);
+			event.setKey( data1 );
+			event.setVelocity( data2 );
 			break;
 
 		case MidiControlChange:
-			m_midiParseData.m_midiEvent.setControllerNumber(m_midiParseData.m_buffer[0]);
-			m_midiParseData.m_midiEvent.setControllerValue( m_midiParseData.m_buffer[1]);
+			event.setControllerNumber( data1 );
+			event.setControllerValue( data2 );
 			break;
 
 		case MidiPitchBend:
 			// Pitch-bend is transmitted with 14-bit precision.
 			// Note: '|' does here the same as '+' (no common bits),
 			// but might be faster
-			m_midiParseData.m_midiEvent.setPitchBend((m_midiParseData.m_buffer[1] * 128) | m_midiParseData.m_buffer[0]);
+			event.setPitchBend( ( data2 * 128 ) | data1 );
 			break;
 
-		default: 
+		default:
 			// Unlikely
-			return;
+			return false;
 	}
-
-	processParsedEvent();
+	return true;
 }
 
 
 
 
-void MidiClientRaw::processParsedEvent()
+std::size_t MidiClientRaw::makeMessage( const MidiEvent& event, unsigned char * data )
 {
-	for( int i = 0; i < m_midiPorts.size(); ++i )
+	// system messages have no channel
+	data[0] = event.type() < MidiSysEx ? event.type() | ( event.channel() & 0x0F ) : event.type();
+	switch( event.type() )
 	{
-		m_midiPorts[i]->processInEvent( m_midiParseData.m_midiEvent );
+		case MidiNoteOff:
+		case MidiNoteOn:
+		case MidiKeyPressure:
+			data[1] = event.key() & 0x7F;
+			data[2] = event.velocity() & 0x7F;
+			break;
+
+		case MidiControlChange:
+			data[1] = event.controllerNumber() & 0x7F;
+			data[2] = event.controllerValue() & 0x7F;
+			break;
+
+		case MidiProgramChange:
+			data[1] = event.program() & 0x7F;
+			break;
+
+		case MidiChannelPressure:
+			data[1] = event.channelPressure() & 0x7F;
+			break;
+
+		case MidiPitchBend:
+			data[1] = event.pitchBend() & 0x7F;
+			data[2] = ( event.pitchBend() >> 7 ) & 0x7F;
+			break;
+
+		case MidiTimeCode:
+			data[1] = event.param( 0 ) & 0x7F;
+			break;
+
+		case MidiSongPosition:
+			data[1] = event.param( 0 ) & 0x7F;
+			data[2] = event.param( 1 ) & 0x7F;
+			break;
+
+		case MidiSync:
+		case MidiStart:
+		case MidiContinue:
+		case MidiStop:
+			break;
+
+		default:
+			return 0;
 	}
+	return eventLength( data[0] );
+}
+
+
+
+
+void MidiClientRaw::processEvent( const MidiEvent& event, f_cnt_t offset )
+{
+	forEachPort( [&]( MidiPort * port ) {
+		port->processInEvent( event, TimePos(), offset );
+	} );
 }
 
 
 
 
-void MidiClientRaw::processOutEvent(const MidiEvent& event, const TimePos&, const MidiPort* port)
+void MidiClientRaw::processOutEvent(const MidiEvent& event, const TimePos&, f_cnt_t, const MidiPort*)
 {
 	// TODO: also evaluate _time and queue event if necessary
-	switch (event.type())
+	unsigned char data[3];
+	const std::size_t size = makeMessage(event, data);
+	if (size == 0)
 	{
-		case MidiNoteOn:
-		case MidiNoteOff:
-		case MidiKeyPressure:
-			sendByte(event.type() | event.channel());
-			sendByte(event.key());
-			sendByte(event.velocity());
-			break;
-
-		default:
-			qWarning("MidiClientRaw: unhandled MIDI-event %d\n", (int)event.type());
-			break;
+		qWarning("MidiClientRaw: unhandled MIDI-event %d\n", (int)event.type());
+		return;
 	}
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		sendByte(data[i]);
+	}
+}
+
+
+
+
+void MidiClientRaw::processOutSync(const MidiEvent& event, f_cnt_t offset)
+{
+	// there is only one output, whatever the ports
+	processOutEvent(event, TimePos(), offset, nullptr);
 }
 
 
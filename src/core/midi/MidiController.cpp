@@ -26,6 +26,10 @@
 #include <QDomElement>
 #include <QObject>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 #include "Song.h"
 #include "Mixer.h"
 #include "MidiClient.h"
@@ -37,9 +41,18 @@ MidiController::MidiController( Model * _parent ) :
 	MidiEventProcessor(),
 	m_midiPort( tr( "unnamed_midi_controller" ),
 			Engine::mixer()->midiClient(), this, this, MidiPort::Input ),
-	m_lastValue( 0.0f ),
-	m_previousValue( 0.0f )
+	m_queuedValues( MaxQueuedValues ),
+	m_smoothing( LinearSmoothing ),
+	m_nrpn( -1 ),
+	m_msb( 0 ),
+	m_fine( false ),
+	m_receivedNrpn( -1 ),
+	m_value( 0.0f ),
+	m_target( 0.0f ),
+	m_step( 0.0f ),
+	m_rampFrames( 0 )
 {
+	m_valuesToApply.reserve( MaxQueuedValues );
 	setSampleExact( true );
 	connect( &m_midiPort, SIGNAL( modeChanged() ),
 			this, SLOT( updateName() ) );
@@ -55,18 +68,79 @@ MidiController::~MidiController()
 
 
 
+static qint64 steadyNanoseconds()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+}
+
+
+
+
 void MidiController::updateValueBuffer()
 {
-	if( m_previousValue != m_lastValue )
+	for( auto * e = m_queuedValues.popList(); e; )
 	{
-		m_valueBuffer.interpolate( m_previousValue, m_lastValue );
-		m_previousValue = m_lastValue;
+		m_valuesToApply.push_back( e->value );
+		auto * next = e->next;
+		m_queuedValues.free( e );
+		e = next;
 	}
-	else
+	// the newest value comes first
+	std::reverse( m_valuesToApply.begin(), m_valuesToApply.end() );
+
+	// like the events of instrument tracks, a value which came in right now
+	// is applied at the end of this period and one which is a period old
+	// at its beginning
+	const f_cnt_t frames = m_valueBuffer.length();
+	const qint64 now = steadyNanoseconds();
+	const float sampleRate = Engine::mixer()->processingSampleRate();
+	const double framesPerNanosecond = sampleRate / 1e9;
+	const f_cnt_t smoothingFrames = qMax<f_cnt_t>( 1, SmoothingTime * sampleRate );
+	const float coefficient = 1.0f - std::exp( -1.0f / smoothingFrames );
+
+	f_cnt_t frame = 0;
+	for( QueuedValue & v : m_valuesToApply )
 	{
-		m_valueBuffer.fill( m_lastValue );
+		const f_cnt_t age = static_cast<f_cnt_t>( ( now - v.arrival ) * framesPerNanosecond );
+		// values pushed in a slightly different order than they came in
+		// are applied one after the other
+		frame = qMax( frame, qBound<f_cnt_t>( 0, frames - 1 - age + v.offset, frames - 1 ) );
+		v.offset = frame;
 	}
-	m_bufferLastUpdated = s_periods;
+
+	float * values = m_valueBuffer.values();
+	auto next = m_valuesToApply.cbegin();
+	for( f_cnt_t f = 0; f < frames; ++f )
+	{
+		for( ; next != m_valuesToApply.cend() && next->offset == f; ++next )
+		{
+			m_target = next->value;
+			m_rampFrames = smoothingFrames;
+			m_step = ( m_target - m_value ) / smoothingFrames;
+		}
+
+		switch( m_smoothing )
+		{
+			case LinearSmoothing:
+				if( m_rampFrames > 0 )
+				{
+					m_value = --m_rampFrames > 0 ? m_value + m_step : m_target;
+				}
+				break;
+
+			case OnePoleSmoothing:
+				m_value += coefficient * ( m_target - m_value );
+				break;
+
+			default:
+				m_value = m_target;
+				break;
+		}
+		values[f] = m_value;
+	}
+	m_valuesToApply.clear();
+	m_bufferLastUpdated = runningPeriods();
 }
 
 
@@ -82,26 +156,74 @@ void MidiController::updateName()
 
 void MidiController::processInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
-	unsigned char controllerNum;
-	switch( event.type() )
+	if( event.type() != MidiControlChange ||
+		( m_midiPort.inputChannel() != event.channel() + 1 &&
+		  m_midiPort.inputChannel() != 0 ) )
+	{
+		// Don't care - maybe add special cases for pitch and mod later
+		return;
+	}
+
+	const int number = event.controllerNumber();
+	const int value = event.controllerValue();
+
+	// an NRPN is selected by controls 99 (MSB) and 98 (LSB), its value is
+	// sent by data entry
+	if( m_nrpn >= 0 )
+	{
+		switch( number )
+		{
+			case 99:
+				m_receivedNrpn = value << 7;
+				break;
+
+			case 98:
+				m_receivedNrpn = ( m_receivedNrpn & ~0x7F ) | value;
+				break;
+
+			case MidiControllerDataEntry:
+				if( m_receivedNrpn == m_nrpn )
+				{
+					m_msb = value;
+					queueValue( m_fine ? m_msb * 128 / 16383.0f : m_msb / 127.0f, offset );
+				}
+				break;
+
+			case MidiControllerDataEntry + 32:
+				if( m_receivedNrpn == m_nrpn )
+				{
+					m_fine = true;
+					queueValue( ( m_msb * 128 + value ) / 16383.0f, offset );
+				}
+				break;
+		}
+		return;
+	}
+
+	// the MSB of a controller is sent on controls 0 to 31, the LSB of
+	// 14 bit values following on controls 32 to 63. Controllers sending
+	// only the MSB still reach the whole range.
+	const int controller = m_midiPort.inputController() - 1;
+	if( number == controller )
+	{
+		m_msb = value;
+		queueValue( m_fine ? m_msb * 128 / 16383.0f : m_msb / 127.0f, offset );
+	}
+	else if( controller < 32 && number == controller + 32 )
+	{
+		m_fine = true;
+		queueValue( ( m_msb * 128 + value ) / 16383.0f, offset );
+	}
+}
+
+
+
+
+void MidiController::queueValue( float _value, f_cnt_t _offset )
+{
+	if( m_queuedValues.tryPush( { _value, _offset, steadyNanoseconds() } ) )
 	{
-		case MidiControlChange:
-			controllerNum = event.controllerNumber();
-
-			if( m_midiPort.inputController() == controllerNum + 1 &&
-					( m_midiPort.inputChannel() == event.channel() + 1 ||
-					  m_midiPort.inputChannel() == 0 ) )
-			{
-				unsigned char val = event.controllerValue();
-				m_previousValue = m_lastValue;
-				m_lastValue = (float)( val ) / 127.0f;
-				emit valueChanged();
-			}
-			break;
-
-		default:
-			// Don't care - maybe add special cases for pitch and mod later
-			break;
+		emit valueChanged();
 	}
 }
 
@@ -124,6 +246,8 @@ void MidiController::saveSettings( QDomDocument & _doc, QDomElement & _this )
 {
 	Controller::saveSettings( _doc, _this );
 	m_midiPort.saveSettings( _doc, _this );
+	_this.setAttribute( "smoothing", m_smoothing );
+	_this.setAttribute( "nrpn", m_nrpn );
 
 }
 
@@ -135,6 +259,10 @@ void MidiController::loadSettings( const QDomElement & _this )
 	Controller::loadSettings( _this );
 
 	m_midiPort.loadSettings( _this );
+	m_smoothing = static_cast<Smoothing>( qBound<int>( NoSmoothing,
+			_this.attribute( "smoothing", QString::number( LinearSmoothing ) ).toInt(),
+			NumSmoothings - 1 ) );
+	m_nrpn = _this.attribute( "nrpn", "-1" ).toInt();
 
 	updateName();
 }
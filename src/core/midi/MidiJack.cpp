@@ -26,10 +26,12 @@
 
 #ifdef LMMS_HAVE_JACK
 
+#include <algorithm>
 #include <QCompleter>
 #include <QMessageBox>
 
 #include "ConfigManager.h"
+#include "Controller.h"
 #include "gui_templates.h"
 #include "GuiApplication.h"
 #include "Engine.h"
@@ -64,8 +66,17 @@ MidiJack::MidiJack() :
 	m_jackClient( nullptr ),
 	m_input_port( NULL ),
 	m_output_port( NULL ),
+	m_outEvents( JACK_MIDI_BUFFER_MAX ),
+	m_outReader( m_outEvents ),
+	m_outClock( 0 ),
+	m_outPeriod( -1 ),
+	m_outPeriodStart( 0 ),
 	m_quit( false )
 {
+	// reserve storage space before realtime operation starts
+	m_outEvents.touch();
+	m_pendingOut.reserve( JACK_MIDI_BUFFER_MAX );
+
 	// if jack is currently used for audio then we share the connection
 	// AudioJack creates and maintains the jack connection
 	// and also handles the callback, we pass it our address
@@ -92,15 +103,9 @@ MidiJack::MidiJack() :
 
 	if(jackClient())
 	{
-		/* jack midi out not implemented
-		   JackMidiWrite and sendByte needs to be functional
-		   before enabling this
-		   If you enable this, also enable the
-		   corresponding jack_port_unregister line below
 		m_output_port = jack_port_register(
 				jackClient(), "MIDI out", JACK_DEFAULT_MIDI_TYPE,
 				JackPortIsOutput, 0);
-		*/
 
 		m_input_port = jack_port_register(
 				jackClient(), "MIDI in", JACK_DEFAULT_MIDI_TYPE,
@@ -127,11 +132,10 @@ MidiJack::~MidiJack()
 			printf("Failed to unregister jack midi input\n");
 		}
 
-		/* Unused yet, see the corresponding jack_port_register call
-		if( jack_port_unregister( jackClient(), m_output_port) != 0){
+		if( m_output_port &&
+			jack_port_unregister( jackClient(), m_output_port) != 0){
 			printf("Failed to unregister jack midi output\n");
 		}
-		*/
 
 		if(m_jackClient)
 		{
@@ -177,46 +181,120 @@ QString MidiJack::probeDevice()
 // we read data from jack
 void MidiJack::JackMidiRead(jack_nframes_t nframes)
 {
-	unsigned int i,b;
 	void* port_buf = jack_port_get_buffer(m_input_port, nframes);
-	jack_midi_event_t in_event;
-	jack_nframes_t event_index = 0;
-	jack_nframes_t event_count = jack_midi_get_event_count(port_buf);
+	const jack_nframes_t event_count = jack_midi_get_event_count(port_buf);
+
+	// the events came in during the last cycle, each at its frame in it,
+	// which is kept by playing the earlier ones as far earlier
+	const double ratio = Engine::mixer()->processingSampleRate() /
+		static_cast<double>(jack_get_sample_rate(jackClient()));
 
-	int rval = jack_midi_event_get(&in_event, port_buf, 0);
-	if (rval == 0 /* 0 = success */)
+	jack_midi_event_t in_event;
+	for (jack_nframes_t i = 0; i < event_count; ++i)
 	{
-		for(i=0; i<nframes; i++)
+		if (jack_midi_event_get(&in_event, port_buf, i) != 0)
 		{
-			while((in_event.time == i) && (event_index < event_count))
-			{
-				// lmms is setup to parse bytes coming from a device
-				// parse it byte by byte as it expects
-				for(b=0;b<in_event.size;b++)
-					parseData( *(in_event.buffer + b) );
-
-				event_index++;
-				if(event_index < event_count)
-					jack_midi_event_get(&in_event, port_buf, event_index);
-			}
+			continue;
 		}
+		// jack hands over whole messages, there is no need to parse
+		// them byte by byte
+		const f_cnt_t offset = -static_cast<f_cnt_t>(
+			(nframes - 1 - in_event.time) * ratio);
+		processMessage(in_event.buffer, in_event.size, offset);
 	}
 }
 
-/* jack midi out is not implemented
-   sending plain bytes to jack midi outputs doesn't work
-   once working the output port needs to be enabled in the constructor
- */
-
+// jack takes whole messages, they are sent by processOutEvent()
 void MidiJack::sendByte( const unsigned char c )
 {
-	//m_midiDev.putChar( c );
+}
+
+void MidiJack::processOutEvent(const MidiEvent& event, const TimePos&,
+				f_cnt_t offset, const MidiPort*)
+{
+	if (!m_output_port)
+	{
+		return;
+	}
+
+	OutEvent out;
+	out.size = makeMessage(event, out.data);
+	if (out.size == 0)
+	{
+		return;
+	}
+	// events not sent while rendering, e.g. program changes from the GUI,
+	// go out with the next cycle
+	const bool rendering = Mixer::isRenderingThread();
+	out.period = rendering ? Controller::runningPeriods() : -1;
+	out.offset = rendering ? qMax<f_cnt_t>(offset, 0) : 0;
+
+	while (m_outLock.test_and_set(std::memory_order_acquire))
+	{
+	}
+	if (m_outEvents.write(&out, 1) != 1)
+	{
+		qWarning("MidiJack: output ringbuffer is full, discarding event");
+	}
+	m_outLock.clear(std::memory_order_release);
 }
 
 // we write data to jack
 void MidiJack::JackMidiWrite(jack_nframes_t nframes)
 {
-	// TODO: write midi data to jack port
+	if (!m_output_port)
+	{
+		return;
+	}
+	void* port_buf = jack_port_get_buffer(m_output_port, nframes);
+	jack_midi_clear_buffer(port_buf);
+
+	const double ratio = jack_get_sample_rate(jackClient()) /
+		static_cast<double>(Engine::mixer()->processingSampleRate());
+	const int64_t periodFrames = static_cast<int64_t>(
+		Engine::mixer()->framesPerPeriod() * ratio);
+
+	while (m_outReader.read_space() > 0 &&
+		m_pendingOut.size() < m_pendingOut.capacity())
+	{
+		const OutEvent out = m_outReader.read(1)[0];
+		PendingOutEvent pending;
+		pending.due = m_outClock;
+		if (out.period >= 0)
+		{
+			if (out.period != m_outPeriod)
+			{
+				// periods keep their distance to the one before, but
+				// none starts before the current cycle
+				const int64_t start = m_outPeriod < 0
+					? m_outClock
+					: m_outPeriodStart + (out.period - m_outPeriod) * periodFrames;
+				m_outPeriodStart = std::max(start, m_outClock);
+				m_outPeriod = out.period;
+			}
+			pending.due = m_outPeriodStart + static_cast<int64_t>(out.offset * ratio);
+		}
+		pending.size = out.size;
+		std::copy(out.data, out.data + out.size, pending.data);
+
+		// jack wants the events of a cycle in order, the capacity was
+		// reserved, so this doesn't allocate
+		m_pendingOut.insert(std::upper_bound(m_pendingOut.begin(), m_pendingOut.end(),
+			pending, [](const PendingOutEvent& a, const PendingOutEvent& b)
+				{ return a.due < b.due; }), pending);
+	}
+
+	// events due later stay for the next cycles
+	const int64_t end = m_outClock + nframes;
+	auto it = m_pendingOut.begin();
+	for (; it != m_pendingOut.end() && it->due < end; ++it)
+	{
+		const int64_t frame = std::max<int64_t>(it->due - m_outClock, 0);
+		jack_midi_event_write(port_buf, static_cast<jack_nframes_t>(frame),
+			it->data, it->size);
+	}
+	m_pendingOut.erase(m_pendingOut.begin(), it);
+	m_outClock = end;
 }
 
 void MidiJack::run()
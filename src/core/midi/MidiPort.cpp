@@ -120,7 +120,7 @@ void MidiPort::setMode( Mode mode )
 
 
 
-void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time )
+void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	// mask event
 	if( isInputEnabled() &&
@@ -142,14 +142,14 @@ void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time )
 			}
 		}
 
-		m_midiEventProcessor->processInEvent( inEvent, time );
+		m_midiEventProcessor->processInEvent( inEvent, time, offset );
 	}
 }
 
 
 
 
-void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time )
+void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	// When output is enabled, route midi events if the selected channel matches
 	// the event channel or if there's no selected channel (value 0, represented by "--")
@@ -163,7 +163,7 @@ void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time )
 			outEvent.setVelocity( fixedOutputVelocity() );
 		}
 
-		m_midiClient->processOutEvent( outEvent, time, this );
+		m_midiClient->processOutEvent( outEvent, time, offset, this );
 	}
 }
 
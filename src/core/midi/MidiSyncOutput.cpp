@@ -0,0 +1,187 @@
+/*
+ * MidiSyncOutput.cpp - MIDI clock and MIDI time code sent along with playback
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MidiSyncOutput.h"
+
+#include <cmath>
+#include <QtGlobal>
+
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "MidiClient.h"
+#include "MidiEvent.h"
+#include "Mixer.h"
+#include "TimePos.h"
+
+
+namespace
+{
+
+const double TicksPerClock = DefaultTicksPerBar / 4.0 / 24;
+//! the unit of the song position pointer
+const double TicksPerSixteenth = DefaultTicksPerBar / 16.0;
+//! how far the position may be off where the last part ended without
+//! counting as jump, the frames of a tick are rounded
+const double JumpTolerance = 0.01;
+
+f_cnt_t frameAt(double frame, fpp_t frames)
+{
+	return qBound<f_cnt_t>(0, static_cast<f_cnt_t>(frame), frames - 1);
+}
+
+}
+
+
+
+
+MidiSyncOutput::MidiSyncOutput() :
+	m_clockEnabled(false),
+	m_timeCodeEnabled(false),
+	m_framesPerSecond(25),
+	m_running(false),
+	m_clockRunning(false),
+	m_timeCodeRunning(false),
+	m_endTicks(0),
+	m_nextClock(0),
+	m_nextQuarterFrame(0),
+	m_timeCodeRate(25)
+{
+	loadSettings();
+}
+
+
+
+
+void MidiSyncOutput::loadSettings()
+{
+	m_clockEnabled = ConfigManager::inst()->value("midi", "clockout").toInt();
+	m_timeCodeEnabled = ConfigManager::inst()->value("midi", "timecodeout").toInt();
+
+	const int fps = ConfigManager::inst()->value("midi", "timecodefps", "25").toInt();
+	m_framesPerSecond = fps == 24 || fps == 30 ? fps : 25;
+}
+
+
+
+
+void MidiSyncOutput::play(double ticks, double seconds, float framesPerTick,
+	fpp_t frames, f_cnt_t offset)
+{
+	const bool clock = m_clockEnabled.load(std::memory_order_relaxed);
+	const bool timeCode = m_timeCodeEnabled.load(std::memory_order_relaxed);
+	const int fps = m_framesPerSecond.load(std::memory_order_relaxed);
+
+	const bool jumped = m_running && std::abs(ticks - m_endTicks) > JumpTolerance;
+	if (m_clockRunning && (jumped || !clock))
+	{
+		send(MidiEvent(MidiStop), offset);
+		m_clockRunning = false;
+	}
+	if (clock && !m_clockRunning)
+	{
+		const int position = static_cast<int>(std::ceil(ticks / TicksPerSixteenth - JumpTolerance));
+		send(MidiEvent(MidiSongPosition, 0, position & 0x7F, (position >> 7) & 0x7F), offset);
+		send(MidiEvent(MidiContinue), offset);
+		m_nextClock = position * TicksPerSixteenth;
+		m_clockRunning = true;
+	}
+	if (timeCode && (!m_timeCodeRunning || jumped || fps != m_timeCodeRate))
+	{
+		// a time is sent with eight quarter frames, over two frames
+		const double eights = seconds * fps * 4 / 8;
+		m_nextQuarterFrame = static_cast<long>(std::ceil(eights - JumpTolerance)) * 8;
+		m_timeCodeRate = fps;
+	}
+	m_timeCodeRunning = timeCode;
+	m_running = true;
+
+	const double endTicks = ticks + frames / framesPerTick;
+	if (m_clockRunning)
+	{
+		for (; m_nextClock < endTicks; m_nextClock += TicksPerClock)
+		{
+			send(MidiEvent(MidiSync), offset + frameAt((m_nextClock - ticks) * framesPerTick, frames));
+		}
+	}
+	if (timeCode)
+	{
+		const double sampleRate = Engine::mixer()->processingSampleRate();
+		const double quarterFrames = m_timeCodeRate * 4.0;
+		const double endSeconds = seconds + frames / sampleRate;
+		for (; m_nextQuarterFrame / quarterFrames < endSeconds; ++m_nextQuarterFrame)
+		{
+			const double due = m_nextQuarterFrame / quarterFrames - seconds;
+			sendQuarterFrame(m_nextQuarterFrame, offset + frameAt(due * sampleRate, frames));
+		}
+	}
+	m_endTicks = endTicks;
+}
+
+
+
+
+void MidiSyncOutput::stop()
+{
+	if (m_clockRunning)
+	{
+		send(MidiEvent(MidiStop), 0);
+		m_clockRunning = false;
+	}
+	m_timeCodeRunning = false;
+	m_running = false;
+}
+
+
+
+
+void MidiSyncOutput::send(const MidiEvent& event, f_cnt_t offset)
+{
+	Engine::mixer()->midiClient()->processOutSync(event, offset);
+}
+
+
+
+
+void MidiSyncOutput::sendQuarterFrame(long quarterFrame, f_cnt_t offset)
+{
+	// the pieces send the time of the frame the first one is due at
+	const int piece = quarterFrame % 8;
+	const long frame = (quarterFrame - piece) / 4;
+	const long second = frame / m_timeCodeRate;
+	const int fields[] = {
+		static_cast<int>(frame % m_timeCodeRate),
+		static_cast<int>(second % 60),
+		static_cast<int>(second / 60 % 60),
+		static_cast<int>(second / 3600 % 24)
+	};
+
+	int value = (fields[piece / 2] >> (piece % 2 * 4)) & 0x0F;
+	if (piece == 7)
+	{
+		// the top bit of the hours and the frame rate
+		const int rate = m_timeCodeRate == 24 ? 0 : m_timeCodeRate == 25 ? 1 : 3;
+		value = (fields[3] >> 4) | (rate << 1);
+	}
+	send(MidiEvent(MidiTimeCode, 0, (piece << 4) | value), offset);
+}
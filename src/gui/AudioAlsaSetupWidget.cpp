@@ -31,6 +31,7 @@
 
 #include "ConfigManager.h"
 #include "LcdSpinBox.h"
+#include "LedCheckbox.h"
 #include "gui_templates.h"
 
 
@@ -80,6 +81,10 @@ AudioAlsaSetupWidget::AudioAlsaSetupWidget( QWidget * _parent ) :
 	m_channels->setLabel( tr( "CHANNELS" ) );
 	m_channels->move( 180, 20 );
 
+	m_mmap = new LedCheckBox( tr( "Write to the device buffer directly (mmap)" ), this );
+	m_mmap->move( 10, 60 );
+	m_mmap->setChecked( ConfigManager::inst()->value( "audioalsa",
+							"mmap" ).toInt() );
 }
 
 
@@ -106,6 +111,8 @@ void AudioAlsaSetupWidget::saveSettings()
 	ConfigManager::inst()->setValue( "audioalsa", "device", deviceText );
 	ConfigManager::inst()->setValue( "audioalsa", "channels",
 				QString::number( m_channels->value<int>() ) );
+	ConfigManager::inst()->setValue( "audioalsa", "mmap",
+				QString::number( m_mmap->model()->value() ) );
 }
 
 
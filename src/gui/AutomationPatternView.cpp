@@ -32,6 +32,7 @@
 #include "embed.h"
 #include "GuiApplication.h"
 #include "gui_templates.h"
+#include "PerfLog.h"
 #include "ProjectJournal.h"
 #include "RenameDialog.h"
 #include "StringPairDrag.h"
@@ -236,6 +237,7 @@ void AutomationPatternView::mouseDoubleClickEvent( QMouseEvent * me )
 
 void AutomationPatternView::paintEvent( QPaintEvent * )
 {
+	PerfTrace::Scope trace( "AutomationPatternView::paintEvent", PerfTrace::Gui );
 	QPainter painter( this );
 
 	if( !needsUpdate() )
@@ -246,10 +248,7 @@ void AutomationPatternView::paintEvent( QPaintEvent * )
 
 	setNeedsUpdate( false );
 
-	if (m_paintPixmap.isNull() || m_paintPixmap.size() != size())
-	{
-		m_paintPixmap = QPixmap(size());
-	}
+	fitPaintPixmap( m_paintPixmap );
 
 	QPainter p( &m_paintPixmap );
 
@@ -87,10 +87,7 @@ void BBTCOView::paintEvent( QPaintEvent * )
 
 	setNeedsUpdate( false );
 
-	if (m_paintPixmap.isNull() || m_paintPixmap.size() != size())
-	{
-		m_paintPixmap = QPixmap(size());
-	}
+	fitPaintPixmap( m_paintPixmap );
 
 	QPainter p( &m_paintPixmap );
 
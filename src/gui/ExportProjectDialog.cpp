@@ -98,6 +98,10 @@ ExportProjectDialog::ExportProjectDialog( const QString & _file_name,
 	compressionWidget->setVisible(false);
 #endif
 
+	singlePassCB->setVisible( m_multiExport );
+	freewheelCB->setVisible( !m_multiExport &&
+				Engine::mixer()->audioDev()->supportsFreewheel() );
+
 	connect( startButton, SIGNAL( clicked() ),
 			this, SLOT( startBtnClicked() ) );
 }
@@ -171,6 +175,9 @@ void ExportProjectDialog::startExport()
 			static_cast<OutputSettings::BitDepth>( depthCB->currentIndex() ),
 			mapToStereoMode(stereoModeComboBox->currentIndex()) );
 
+	// the combo box lists the ditherings in the order of the enum
+	os.setDithering(static_cast<SampleConversion::Dithering>(ditherCB->currentIndex()));
+
 	if (compressionWidget->isVisible())
 	{
 		double level = compLevelCB->itemData(compLevelCB->currentIndex()).toDouble();
@@ -185,6 +192,7 @@ void ExportProjectDialog::startExport()
 		output_name+=m_fileExtension;
 	}
 	m_renderManager.reset(new RenderManager( qs, os, m_ft, output_name ));
+	m_renderManager->setFreewheel( freewheelCB->isVisible() && freewheelCB->isChecked() );
 
 	Engine::getSong()->setExportLoop( exportLoopCB->isChecked() );
 	Engine::getSong()->setRenderBetweenMarkers( renderMarkersCB->isChecked() );
@@ -194,6 +202,8 @@ void ExportProjectDialog::startExport()
 			progressBar, SLOT( setValue( int ) ) );
 	connect( m_renderManager.get(), SIGNAL( progressChanged( int ) ),
 			this, SLOT( updateTitleBar( int ) ));
+	connect( m_renderManager.get(), SIGNAL( progressChanged( int ) ),
+			this, SLOT( updateProgressDetails( int ) ) );
 	connect( m_renderManager.get(), SIGNAL( finished() ),
 			this, SLOT( accept() ) ) ;
 	connect( m_renderManager.get(), SIGNAL( finished() ),
@@ -201,7 +211,7 @@ void ExportProjectDialog::startExport()
 
 	if ( m_multiExport )
 	{
-		m_renderManager->renderTracks();
+		m_renderManager->renderTracks( singlePassCB->isChecked() );
 	}
 	else
 	{
@@ -247,6 +257,7 @@ void ExportProjectDialog::onFileFormatChanged(int index)
 	checkBoxVariableBitRate->setVisible(variableBitrateVisible);
 
 	depthWidget->setVisible(bitDepthControlEnabled);
+	ditherWidget->setVisible(bitDepthControlEnabled);
 }
 
 void ExportProjectDialog::startBtnClicked()
@@ -296,3 +307,13 @@ void ExportProjectDialog::updateTitleBar( int _prog )
 	gui->mainWindow()->setWindowTitle(
 					tr( "Rendering: %1%" ).arg( _prog ) );
 }
+
+
+
+
+void ExportProjectDialog::updateProgressDetails( int )
+{
+	// the realtime factor and time left, next to the percentage
+	progressBar->setFormat( QString( "%p% - %1" ).arg(
+				m_renderManager->statistics().summary() ) );
+}
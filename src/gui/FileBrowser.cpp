@@ -42,6 +42,7 @@
 #include "DataFile.h"
 #include "embed.h"
 #include "Engine.h"
+#include "FileIndex.h"
 #include "GuiApplication.h"
 #include "gui_templates.h"
 #include "ImportFilter.h"
@@ -55,7 +56,6 @@
 #include "SampleTrack.h"
 #include "Song.h"
 #include "StringPairDrag.h"
-#include "TextFloat.h"
 
 enum TreeWidgetItemTypes
 {
@@ -65,6 +65,10 @@ enum TreeWidgetItemTypes
 
 
 
+const int FileBrowser::MaxSearchResults;
+
+
+
 void FileBrowser::addContentCheckBox()
 {
 	auto filterWidget = new QWidget(contentParent());
@@ -120,13 +124,13 @@ FileBrowser::FileBrowser(const QString & directories, const QString & filter,
 	m_filterEdit->setPlaceholderText( tr("Search") );
 	m_filterEdit->setClearButtonEnabled( true );
 	connect( m_filterEdit, SIGNAL( textEdited( const QString & ) ),
-			this, SLOT( filterItems( const QString & ) ) );
+			this, SLOT( filterChanged( const QString & ) ) );
 
 	QPushButton * reload_btn = new QPushButton(
 				embed::getIconPixmap( "reload" ),
 						QString(), searchWidget );
 	reload_btn->setToolTip( tr( "Refresh list" ) );
-	connect( reload_btn, SIGNAL( clicked() ), this, SLOT( reloadTree() ) );
+	connect( reload_btn, SIGNAL( clicked() ), this, SLOT( reload() ) );
 
 	searchWidgetLayout->addWidget( m_filterEdit );
 	searchWidgetLayout->addSpacing( 5 );
@@ -137,6 +141,18 @@ FileBrowser::FileBrowser(const QString & directories, const QString & filter,
 	m_fileBrowserTreeWidget = new FileBrowserTreeWidget( contentParent() );
 	addContentWidget( m_fileBrowserTreeWidget );
 
+	if( m_recurse )
+	{
+		// searching these would list every directory below them
+		m_index = new FileIndex( m_directories.split( '*' ), m_filter, this );
+		connect( m_index, SIGNAL( updated() ),
+				this, SLOT( showSearchResults() ) );
+
+		m_searchResults = new FileBrowserTreeWidget( contentParent() );
+		m_searchResults->hide();
+		addContentWidget( m_searchResults );
+	}
+
 	// Whenever the FileBrowser has focus, Ctrl+F should direct focus to its filter box.
 	QShortcut *filterFocusShortcut = new QShortcut( QKeySequence( QKeySequence::Find ), this, SLOT(giveFocusToFilter()) );
 	filterFocusShortcut->setContext(Qt::WidgetWithChildrenShortcut);
@@ -195,12 +211,77 @@ bool FileBrowser::filterItems( const QString & filter, QTreeWidgetItem * item )
 }
 
 
-void FileBrowser::reloadTree( void )
+
+
+void FileBrowser::filterChanged( const QString & filter )
+{
+	if( m_index == nullptr || filter.isEmpty() )
+	{
+		if( m_searchResults )
+		{
+			m_searchResults->hide();
+			m_searchResults->clear();
+		}
+		m_fileBrowserTreeWidget->show();
+		filterItems( filter );
+		return;
+	}
+	showSearchResults();
+}
+
+
+
+
+void FileBrowser::showSearchResults()
 {
-	QList<QString> expandedDirs = m_fileBrowserTreeWidget->expandedDirs();
 	const QString text = m_filterEdit->text();
-	m_filterEdit->clear();
-	m_fileBrowserTreeWidget->clear();
+	if( text.isEmpty() )
+	{
+		return;
+	}
+
+	const QVector<FileIndex::Match> matches =
+		m_index->find( text, shownDirectories(), MaxSearchResults + 1 );
+
+	m_searchResults->clear();
+	for( int i = 0; i < qMin( matches.size(), MaxSearchResults ); ++i )
+	{
+		FileItem * item = new FileItem( m_searchResults,
+					matches[i].name, matches[i].path );
+		item->setToolTip( 0, item->fullName() );
+	}
+	if( matches.size() > MaxSearchResults )
+	{
+		new QTreeWidgetItem( m_searchResults,
+			QStringList( tr( "More files match, refine the search" ) ) );
+	}
+	else if( m_index->isScanning() )
+	{
+		new QTreeWidgetItem( m_searchResults,
+			QStringList( tr( "Searching..." ) ) );
+	}
+
+	m_fileBrowserTreeWidget->hide();
+	m_searchResults->show();
+}
+
+
+
+
+void FileBrowser::reload()
+{
+	if( m_index )
+	{
+		m_index->rescan();
+	}
+	reloadTree();
+}
+
+
+
+
+QStringList FileBrowser::shownDirectories() const
+{
 	QStringList paths = m_directories.split('*');
 	if (m_showUserContent && !m_showUserContent->isChecked())
 	{
@@ -210,17 +291,28 @@ void FileBrowser::reloadTree( void )
 	{
 		paths.removeAll(m_factoryDir);
 	}
+	return paths;
+}
+
+
+void FileBrowser::reloadTree( void )
+{
+	QList<QString> expandedDirs = m_fileBrowserTreeWidget->expandedDirs();
+	const QString text = m_filterEdit->text();
+	m_filterEdit->clear();
+	m_fileBrowserTreeWidget->clear();
+	const QStringList paths = shownDirectories();
 
 	if (!paths.isEmpty())
 	{
-		for (QStringList::iterator it = paths.begin(); it != paths.end(); ++it)
+		for (QStringList::const_iterator it = paths.begin(); it != paths.end(); ++it)
 		{
 			addItems(*it);
 		}
 	}
 	expandItems(nullptr, expandedDirs);
 	m_filterEdit->setText( text );
-	filterItems( text );
+	filterChanged( text );
 }
 
 
@@ -231,10 +323,6 @@ void FileBrowser::expandItems( QTreeWidgetItem * item, QList<QString> expandedDi
 	for (int i = 0; i < numChildren; ++i)
 	{
 		QTreeWidgetItem * it = item ? item->child( i ) : m_fileBrowserTreeWidget->topLevelItem(i);
-		if ( m_recurse )
-		{
-			it->setExpanded( true );
-		}
 		Directory *d = dynamic_cast<Directory *> ( it );
 		if (d)
 		{
@@ -242,7 +330,8 @@ void FileBrowser::expandItems( QTreeWidgetItem * item, QList<QString> expandedDi
 			bool expand = expandedDirs.contains( d->fullName() );
 			d->setExpanded( expand );
 		}
-		if (m_recurse && it->childCount())
+		// only what is expanded is listed, searching uses the index
+		if (m_recurse && it->isExpanded() && it->childCount())
 		{
 			expandItems(it, expandedDirs);
 		}
@@ -348,7 +437,7 @@ void FileBrowser::keyPressEvent(QKeyEvent * ke )
 {
 	switch( ke->key() ){
 		case Qt::Key_F5:
-			reloadTree();
+			reload();
 			break;
 		default:
 			ke->ignore();
@@ -598,7 +687,7 @@ void FileBrowserTreeWidget::mousePressEvent(QMouseEvent * me )
 
 
 void FileBrowserTreeWidget::previewFileItem(FileItem* file)
-{	// TODO: We should do this work outside the event thread
+{
 	// Lock the preview mutex
 	QMutexLocker previewLocker(&m_pphMutex);
 	// If something is already playing, stop it before we continue
@@ -612,16 +701,16 @@ void FileBrowserTreeWidget::previewFileItem(FileItem* file)
 	// handling() rather than directly creating a SamplePlayHandle
 	if (file->type() == FileItem::SampleFile)
 	{
-		TextFloat * tf = TextFloat::displayMessage(
-			tr("Loading sample"),
-			tr("Please wait, loading sample for preview..."),
-			embed::getIconPixmap("sample_file", 24, 24), 0);
-		// TODO: this can be removed once we do this outside the event thread
-		qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-		SamplePlayHandle* s = new SamplePlayHandle(fileName);
+		// Short samples are usually preloaded, longer ones are streamed
+		// so they don't have to be decoded before they play
+		SampleBuffer* buffer = new SampleBuffer;
+		buffer->setStreamable(true, SampleBuffer::PreviewStreamingSeconds);
+		buffer->setAudioFile(fileName);
+		SamplePlayHandle* s = new SamplePlayHandle(buffer, true);
+		sharedObject::unref(buffer);
 		s->setDoneMayReturnTrue(false);
 		newPPH = s;
-		delete tf;
+		preloadNeighbours(file);
 	}
 	else if (
 		(ext == "xiz" || ext == "sf2" || ext == "sf3" ||
@@ -661,6 +750,31 @@ void FileBrowserTreeWidget::previewFileItem(FileItem* file)
 
 
 
+void FileBrowserTreeWidget::preloadNeighbours(FileItem* file)
+{
+	QTreeWidgetItem* parent = file->parent();
+	const int index = parent ? parent->indexOfChild(file) : indexOfTopLevelItem(file);
+	const int count = parent ? parent->childCount() : topLevelItemCount();
+
+	// The previewed sample stays, then the ones below it come first, as
+	// browsing usually goes down the list
+	QStringList files(file->fullName());
+	for (int offset : {1, -1, 2, 3, -2, 4, 5, -3, 6, 7, 8})
+	{
+		const int i = index + offset;
+		if (i < 0 || i >= count) { continue; }
+		auto neighbour = dynamic_cast<FileItem*>(parent ? parent->child(i) : topLevelItem(i));
+		if (neighbour != nullptr && neighbour->type() == FileItem::SampleFile)
+		{
+			files << neighbour->fullName();
+		}
+	}
+	SampleBuffer::preloadFiles(files);
+}
+
+
+
+
 void FileBrowserTreeWidget::stopPreview()
 {
 	QMutexLocker previewLocker(&m_pphMutex);
@@ -1218,7 +1332,7 @@ void FileItem::determineFileType( void )
 	m_handling = NotSupported;
 
 	const QString ext = extension();
-	if( ext == "mmp" || ext == "mpt" || ext == "mmpz" )
+	if( ext == "mmp" || ext == "mpt" || ext == "mmpz" || ext == "mmpb" )
 	{
 		m_type = ProjectFile;
 		m_handling = LoadAsProject;
@@ -0,0 +1,480 @@
+/*
+ * FileIndex.cpp - index of the files below the directories of a browser
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FileIndex.h"
+
+#include <algorithm>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+
+const int FileIndex::MaxWatchedDirs;
+
+
+// outside of the anonymous namespace, so QDataStream finds them for a QVector
+static QDataStream& operator<<(QDataStream& stream, const FileIndex::Directory& dir)
+{
+	return stream << dir.path << dir.modified << dir.subDirs << dir.files;
+}
+
+
+static QDataStream& operator>>(QDataStream& stream, FileIndex::Directory& dir)
+{
+	stream >> dir.path >> dir.modified >> dir.subDirs >> dir.files;
+	dir.lowerFiles.clear();
+	for (const QString& file : dir.files)
+	{
+		dir.lowerFiles << file.toLower();
+	}
+	return stream;
+}
+
+
+
+
+namespace
+{
+
+const char IndexMagic[] = "LMMSFIDX";
+const quint32 IndexVersion = 1;
+
+
+QString childPath(const QString& path, const QString& name)
+{
+	return path.endsWith('/') ? path + name : path + '/' + name;
+}
+
+
+bool isBelow(const QString& path, const QString& root)
+{
+	return path == root || path.startsWith(root.endsWith('/') ? root : root + '/');
+}
+
+}
+
+
+
+
+FileIndex::FileIndex(const QStringList& roots, const QString& filter,
+		QObject* parent) :
+	QObject(parent),
+	m_filter(filter),
+	m_scanner(this),
+	m_scanDone(true)
+{
+	for (const QString& root : roots)
+	{
+		m_roots << QDir::cleanPath(root);
+	}
+
+	connect(&m_watcher, SIGNAL(directoryChanged(QString)),
+		this, SLOT(scanDirectory(QString)));
+
+	startScanner(m_roots, m_dirs, true, true);
+}
+
+
+
+
+FileIndex::~FileIndex()
+{
+	m_scanner.stop();
+	m_scanner.wait();
+}
+
+
+
+
+QVector<FileIndex::Match> FileIndex::find(const QString& text,
+	const QStringList& roots, int limit) const
+{
+	QStringList cleanRoots;
+	for (const QString& root : roots)
+	{
+		cleanRoots << QDir::cleanPath(root);
+	}
+	const QString lower = text.toLower();
+
+	QVector<Match> matches;
+	for (auto it = m_dirs.constBegin();
+		it != m_dirs.constEnd() && matches.size() < limit; ++it)
+	{
+		const Directory& dir = *it;
+		if (!cleanRoots.contains(rootOf(dir.path)))
+		{
+			continue;
+		}
+		// like in the tree, all files below a matching directory match
+		const bool dirMatches = dir.lowerPath.contains(lower);
+		for (int i = 0; i < dir.files.size() && matches.size() < limit; ++i)
+		{
+			if (dirMatches || dir.lowerFiles[i].contains(lower))
+			{
+				matches.push_back(Match{dir.path, dir.files[i]});
+			}
+		}
+	}
+
+	std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b)
+	{
+		return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
+	});
+	return matches;
+}
+
+
+
+
+void FileIndex::rescan()
+{
+	m_scanner.stop();
+	m_scanner.wait();
+	takeScanned();
+
+	// list everything again, not only what was modified. The index is
+	// kept until then, what's gone is removed once a root is done.
+	startScanner(m_roots, QHash<QString, Directory>(), true, false);
+}
+
+
+
+
+void FileIndex::takeScanned()
+{
+	QVector<Directory> scanned;
+	QVector<QPair<QString, QSet<QString>>> finished;
+	{
+		QMutexLocker lock(&m_mutex);
+		scanned.swap(m_scanned);
+		finished.swap(m_finished);
+	}
+	if (scanned.isEmpty() && finished.isEmpty())
+	{
+		return;
+	}
+
+	for (const Directory& dir : scanned)
+	{
+		addDirectory(dir);
+	}
+
+	// directories below a path scanned completely which weren't found
+	// don't exist anymore
+	for (const auto& paths : finished)
+	{
+		QStringList removed;
+		for (auto it = m_dirs.constBegin(); it != m_dirs.constEnd(); ++it)
+		{
+			if (isBelow(it.key(), paths.first) && !paths.second.contains(it.key()))
+			{
+				removed << it.key();
+			}
+		}
+		for (const QString& path : removed)
+		{
+			removeDirectory(path);
+		}
+	}
+
+	emit updated();
+}
+
+
+
+
+void FileIndex::scanDirectory(const QString& path)
+{
+	{
+		QMutexLocker lock(&m_mutex);
+		if (!m_scanDone)
+		{
+			m_scanner.request(path);
+			return;
+		}
+	}
+	m_scanner.wait();
+	startScanner(QStringList(path), m_dirs, false, false);
+}
+
+
+
+
+QString FileIndex::cacheFile() const
+{
+	const QByteArray key = (m_roots.join('*') + '|' + m_filter).toUtf8();
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/files/" + QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() +
+		".index";
+}
+
+
+
+
+void FileIndex::startScanner(const QStringList& paths,
+	const QHash<QString, Directory>& known, bool all, bool loadCache)
+{
+	m_scanDone = false;
+	m_scanner.prepare(paths, known, all, loadCache);
+	m_scanner.start(QThread::LowPriority);
+}
+
+
+
+
+void FileIndex::addDirectory(Directory dir)
+{
+	const QString root = rootOf(dir.path);
+	dir.lowerPath = dir.path.mid(root.length()).toLower();
+	m_dirs.insert(dir.path, dir);
+
+	if (!m_watched.contains(dir.path) && m_watched.size() < MaxWatchedDirs &&
+		m_watcher.addPath(dir.path))
+	{
+		m_watched.insert(dir.path);
+	}
+}
+
+
+
+
+void FileIndex::removeDirectory(const QString& path)
+{
+	m_dirs.remove(path);
+	if (m_watched.remove(path))
+	{
+		m_watcher.removePath(path);
+	}
+}
+
+
+
+
+QString FileIndex::rootOf(const QString& path) const
+{
+	for (const QString& root : m_roots)
+	{
+		if (isBelow(path, root))
+		{
+			return root;
+		}
+	}
+	return QString();
+}
+
+
+
+
+FileIndex::Scanner::Scanner(FileIndex* index) :
+	m_index(index),
+	m_all(false),
+	m_loadCache(false),
+	m_stop(false)
+{
+}
+
+
+
+
+void FileIndex::Scanner::prepare(const QStringList& paths,
+	const QHash<QString, Directory>& known, bool all, bool loadCache)
+{
+	m_paths = paths;
+	m_known = known;
+	m_all = all;
+	m_loadCache = loadCache;
+	m_found.clear();
+	m_stop = false;
+}
+
+
+
+
+void FileIndex::Scanner::request(const QString& path)
+{
+	if (!m_paths.contains(path))
+	{
+		m_paths << path;
+	}
+}
+
+
+
+
+void FileIndex::Scanner::stop()
+{
+	m_stop = true;
+}
+
+
+
+
+void FileIndex::Scanner::run()
+{
+	if (m_loadCache)
+	{
+		// search the index of the last scan until this one is done
+		QFile file(m_index->cacheFile());
+		if (file.open(QIODevice::ReadOnly))
+		{
+			QDataStream stream(&file);
+			stream.setVersion(QDataStream::Qt_5_0);
+			QByteArray magic;
+			quint32 version;
+			QVector<Directory> dirs;
+			stream >> magic >> version;
+			if (magic == IndexMagic && version == IndexVersion)
+			{
+				stream >> dirs;
+			}
+			if (stream.status() == QDataStream::Ok)
+			{
+				for (const Directory& dir : dirs)
+				{
+					m_known.insert(dir.path, dir);
+					publish(dir);
+				}
+			}
+		}
+	}
+
+	while (!m_stop)
+	{
+		QString path;
+		{
+			QMutexLocker lock(&m_index->m_mutex);
+			if (m_paths.isEmpty())
+			{
+				m_index->m_scanDone = true;
+				break;
+			}
+			path = m_paths.takeFirst();
+		}
+
+		QSet<QString> seen;
+		scan(path, seen);
+		if (!m_stop)
+		{
+			QMutexLocker lock(&m_index->m_mutex);
+			m_index->m_finished.push_back(qMakePair(path, seen));
+		}
+		QMetaObject::invokeMethod(m_index, "takeScanned", Qt::QueuedConnection);
+	}
+
+	if (m_all && !m_stop)
+	{
+		const QString fileName = m_index->cacheFile();
+		QDir().mkpath(QFileInfo(fileName).path());
+		QSaveFile file(fileName);
+		if (file.open(QIODevice::WriteOnly))
+		{
+			QDataStream stream(&file);
+			stream.setVersion(QDataStream::Qt_5_0);
+			stream << QByteArray(IndexMagic) << IndexVersion << m_found;
+			file.commit();
+		}
+	}
+
+	QMutexLocker lock(&m_index->m_mutex);
+	m_index->m_scanDone = true;
+}
+
+
+
+
+void FileIndex::Scanner::scan(const QString& path, QSet<QString>& seen)
+{
+	const QFileInfo info(path);
+	if (m_stop || !info.isDir() || !info.isReadable())
+	{
+		return;
+	}
+
+	const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+	const auto known = m_known.constFind(path);
+	Directory dir;
+	if (known != m_known.constEnd() && known->modified == modified)
+	{
+		// nothing was added or removed since
+		dir = *known;
+	}
+	else
+	{
+		dir.path = path;
+		dir.modified = modified;
+		const QDir qdir(path);
+		for (const QString& name : qdir.entryList(
+			QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDir::Name))
+		{
+			if (!name.startsWith('.'))
+			{
+				dir.subDirs << name;
+			}
+		}
+		for (const QString& name : qdir.entryList(QDir::Files, QDir::Name))
+		{
+			const QString lower = name.toLower();
+			if (!name.startsWith('.') && QDir::match(m_index->m_filter, lower))
+			{
+				dir.files << name;
+				dir.lowerFiles << lower;
+			}
+		}
+		publish(dir);
+	}
+
+	seen.insert(path);
+	if (m_all)
+	{
+		m_found.push_back(dir);
+	}
+
+	for (const QString& subDir : dir.subDirs)
+	{
+		scan(childPath(path, subDir), seen);
+	}
+}
+
+
+
+
+void FileIndex::Scanner::publish(const Directory& dir)
+{
+	bool first;
+	{
+		QMutexLocker lock(&m_index->m_mutex);
+		first = m_index->m_scanned.isEmpty();
+		m_index->m_scanned.push_back(dir);
+	}
+	// the GUI takes everything published until it gets to it at once
+	if (first)
+	{
+		QMetaObject::invokeMethod(m_index, "takeScanned", Qt::QueuedConnection);
+	}
+}
@@ -592,35 +592,23 @@ void FxMixerView::updateFaders()
 {
 	FxMixer * m = Engine::fxMixer();
 
-	// apply master gain
-	m->effectChannel(0)->m_peakLeft *= Engine::mixer()->masterGain();
-	m->effectChannel(0)->m_peakRight *= Engine::mixer()->masterGain();
+	// take the snapshot even while hidden, so the next one shown is fresh
+	const MeterSnapshot::Snapshot * meters = m->meters().read();
+	if( meters == nullptr || !isVisible() )
+	{
+		return;
+	}
 
-	for( int i = 0; i < m_fxChannelViews.size(); ++i )
+	const int channels = qMin<int>( m_fxChannelViews.size(), meters->size() );
+	for( int i = 0; i < channels; ++i )
 	{
-		const float opl = m_fxChannelViews[i]->m_fader->getPeak_L();
-		const float opr = m_fxChannelViews[i]->m_fader->getPeak_R();
+		const MeterSnapshot::Meter & meter = ( *meters )[i];
+		Fader * fader = m_fxChannelViews[i]->m_fader;
 		const float fallOff = 1.25;
-		if( m->effectChannel(i)->m_peakLeft >= opl/fallOff )
-		{
-			m_fxChannelViews[i]->m_fader->setPeak_L( m->effectChannel(i)->m_peakLeft );
-			// Set to -1 so later we'll know if this value has been refreshed yet.
-			m->effectChannel(i)->m_peakLeft = -1;
-		}
-		else if( m->effectChannel(i)->m_peakLeft != -1 )
-		{
-			m_fxChannelViews[i]->m_fader->setPeak_L( opl/fallOff );
-		}
+		// faders only repaint if their peaks change
+		fader->setPeak_L( qMax( meter.peakLeft, fader->getPeak_L() / fallOff ) );
+		fader->setPeak_R( qMax( meter.peakRight, fader->getPeak_R() / fallOff ) );
 
-		if( m->effectChannel(i)->m_peakRight >= opr/fallOff )
-		{
-			m_fxChannelViews[i]->m_fader->setPeak_R( m->effectChannel(i)->m_peakRight );
-			// Set to -1 so later we'll know if this value has been refreshed yet.
-			m->effectChannel(i)->m_peakRight = -1;
-		}
-		else if( m->effectChannel(i)->m_peakRight != -1 )
-		{
-			m_fxChannelViews[i]->m_fader->setPeak_R( opr/fallOff );
-		}
+		m_fxChannelViews[i]->m_fxLine->setSleeping( meter.sleeping );
 	}
 }
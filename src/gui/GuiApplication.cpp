@@ -36,6 +36,7 @@
 #include "FxMixerView.h"
 #include "InstrumentTrack.h"
 #include "MainWindow.h"
+#include "PerfLog.h"
 #include "PianoRoll.h"
 #include "ProjectNotes.h"
 #include "SongEditor.h"
@@ -122,6 +123,7 @@ GuiApplication::GuiApplication()
 	s_instance = this;
 
 	displayInitProgress(tr("Preparing UI"));
+	PerfTimeline::Phase windowsPhase("Windows");
 
 	m_mainWindow = new MainWindow;
 	connect(m_mainWindow, SIGNAL(destroyed(QObject*)), this, SLOT(childDestroyed(QObject*)));
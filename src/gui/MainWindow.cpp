@@ -52,6 +52,7 @@
 #include "GuiApplication.h"
 #include "ImportFilter.h"
 #include "InstrumentTrack.h"
+#include "ModelView.h"
 #include "PianoRoll.h"
 #include "PluginBrowser.h"
 #include "PluginFactory.h"
@@ -128,7 +129,7 @@ MainWindow::MainWindow() :
 	sideBar->appendTab( new FileBrowser(
 				confMgr->userProjectsDir() + "*" +
 				confMgr->factoryProjectsDir(),
-					"*.mmp *.mmpz *.xml *.mid",
+					"*.mmp *.mmpz *.mmpb *.xml *.mid",
 							tr( "My Projects" ),
 					embed::getIconPixmap( "project_file" ).transformed( QTransform().rotate( 90 ) ),
 							splitter, false, true,
@@ -374,11 +375,23 @@ void MainWindow::finalize()
 		new QShortcut( QKeySequence( Qt::CTRL + Qt::SHIFT + Qt::Key_Z ), this, SLOT(redo()) );
 	}
 
+	edit_menu->addSeparator();
+	m_sampleCompressionAction = edit_menu->addAction(
+					tr( "Compress samples in memory" ) );
+	m_sampleCompressionAction->setCheckable( true );
+	m_sampleCompressionAction->setToolTip(
+		tr( "Keep long samples of instruments compressed while the "
+			"project is open, which saves memory on large sample "
+			"libraries" ) );
+	connect( m_sampleCompressionAction, SIGNAL( triggered( bool ) ),
+				this, SLOT( setSampleCompression( bool ) ) );
 	edit_menu->addSeparator();
 	edit_menu->addAction( embed::getIconPixmap( "setup_general" ),
 					tr( "Settings" ),
 					this, SLOT( showSettingsDialog() ) );
 	connect( edit_menu, SIGNAL(aboutToShow()), this, SLOT(updateUndoRedoButtons()) );
+	connect( edit_menu, SIGNAL( aboutToShow() ),
+				this, SLOT( updateSampleCompressionAction() ) );
 
 	m_viewMenu = new QMenu( this );
 	menuBar()->addMenu( m_viewMenu )->setText( tr( "&View" ) );
@@ -823,7 +836,7 @@ void MainWindow::openProject()
 {
 	if( mayChangeProject(false) )
 	{
-		FileDialog ofd( this, tr( "Open Project" ), "", tr( "LMMS (*.mmp *.mmpz)" ) );
+		FileDialog ofd( this, tr( "Open Project" ), "", tr( "LMMS (*.mmp *.mmpz *.mmpb)" ) );
 
 		ofd.setDirectory( ConfigManager::inst()->userProjectsDir() );
 		ofd.setFileMode( FileDialog::ExistingFiles );
@@ -868,6 +881,7 @@ bool MainWindow::saveProjectAs()
 	auto optionsWidget = new SaveOptionsWidget(Engine::getSong()->getSaveOptions());
 	VersionedSaveDialog sfd( this, optionsWidget, tr( "Save Project" ), "",
 			tr( "LMMS Project" ) + " (*.mmpz *.mmp);;" +
+				tr( "LMMS Project with binary samples" ) + " (*.mmpb);;" +
 				tr( "LMMS Project Template" ) + " (*.mpt)" );
 	QString f = Engine::getSong()->projectFileName();
 	if( f != "" )
@@ -904,6 +918,20 @@ bool MainWindow::saveProjectAs()
 				}
 			}
 		}
+		else if( sfd.selectedNameFilter().contains( "(*.mmpb)" ) )
+		{
+			fname.remove( "." + suffix );
+			if( !fname.endsWith( ".mmpb" ) )
+			{
+				fname += ".mmpb";
+				if( QFile::exists( fname ) &&
+					!VersionedSaveDialog::fileExistsQuery( fname,
+							tr( "Save project" ) ) )
+				{
+					return false;
+				}
+			}
+		}
 		if( this->guiSaveProjectAs( fname ) )
 		{
 			if( getSession() == Recover )
@@ -1296,6 +1324,22 @@ void MainWindow::updateUndoRedoButtons()
 
 
 
+void MainWindow::updateSampleCompressionAction()
+{
+	// the setting belongs to the project, which may have been changed
+	m_sampleCompressionAction->setChecked( Engine::getSong()->compressSamples() );
+}
+
+
+
+
+void MainWindow::setSampleCompression( bool enabled )
+{
+	Engine::getSong()->setCompressSamples( enabled );
+}
+
+
+
 void MainWindow::undo()
 {
 	Engine::projectJournal()->undo();
@@ -1336,6 +1380,7 @@ void MainWindow::closeEvent( QCloseEvent * _ce )
 void MainWindow::sessionCleanup()
 {
 	// delete recover session files
+	Engine::getSong()->waitForAutoSave();
 	QFile::remove( ConfigManager::inst()->recoveryFile() );
 	setSession( Normal );
 }
@@ -1406,6 +1451,7 @@ void MainWindow::keyReleaseEvent( QKeyEvent * _ke )
 
 void MainWindow::timerEvent( QTimerEvent * _te)
 {
+	ModelView::updateChangedViews();
 	emit periodicUpdate();
 }
 
@@ -1445,17 +1491,19 @@ void MainWindow::autoSave()
 				"enablerunningautosave" ).toInt() ||
 			! Engine::getSong()->isPlaying() ) )
 	{
-		Engine::getSong()->saveProjectFile(ConfigManager::inst()->recoveryFile());
-		autoSaveTimerReset();  // Reset timer
-	}
-	else
-	{
-		// try again in 10 seconds
-		if( getAutoSaveTimerInterval() != m_autoSaveShortTime )
+		if( Engine::getSong()->autoSaveProjectFile(
+					ConfigManager::inst()->recoveryFile() ) )
 		{
-			autoSaveTimerReset( m_autoSaveShortTime );
+			autoSaveTimerReset();  // Reset timer
+			return;
 		}
 	}
+
+	// try again in 10 seconds
+	if( getAutoSaveTimerInterval() != m_autoSaveShortTime )
+	{
+		autoSaveTimerReset( m_autoSaveShortTime );
+	}
 }
 
 void MainWindow::onExportProjectMidi()
@@ -22,16 +22,24 @@
  *
  */
 
+#include <QtCore/QThread>
 #include <QWidget>
 
 #include "ModelView.h"
 
 
+QSet<ModelView*> ModelView::s_views;
+std::atomic<bool> ModelView::s_anyChanged( false );
+bool ModelView::s_hiddenChanged = false;
+
+
 
 ModelView::ModelView( Model* model, QWidget* widget ) :
 	m_widget( widget ),
-	m_model( model )
+	m_model( model ),
+	m_dataChanged( false )
 {
+	s_views.insert( this );
 }
 
 
@@ -39,10 +47,15 @@ ModelView::ModelView( Model* model, QWidget* widget ) :
 
 ModelView::~ModelView()
 {
+	s_views.remove( this );
 	if( m_model != NULL && m_model->isDefaultConstructed() )
 	{
 		delete m_model;
 	}
+	else if( m_model != NULL )
+	{
+		m_model->disconnect( widget() );
+	}
 }
 
 
@@ -88,9 +101,71 @@ void ModelView::doConnections()
 {
 	if( m_model != NULL )
 	{
-		QObject::connect( m_model, SIGNAL( dataChanged() ), widget(), SLOT( update() ) );
+		// Automation changes models up to once per tick, so queueing
+		// an update of the view for every change would flood the GUI
+		QObject::connect( m_model, &Model::dataChanged, widget(),
+				[this]() { markDataChanged(); }, Qt::DirectConnection );
 		QObject::connect( m_model, SIGNAL( propertiesChanged() ), widget(), SLOT( update() ) );
 	}
 }
 
 
+
+
+void ModelView::modelDataChanged()
+{
+	// through the meta object, so views re-implementing the update() slot,
+	// like spin boxes and TCO views, get their own
+	QMetaObject::invokeMethod( widget(), "update" );
+}
+
+
+
+
+void ModelView::updateChangedViews()
+{
+	if( !s_anyChanged.exchange( false, std::memory_order_acquire ) &&
+		!s_hiddenChanged )
+	{
+		return;
+	}
+
+	s_hiddenChanged = false;
+	for( ModelView* view : s_views )
+	{
+		if( !view->m_dataChanged.load( std::memory_order_relaxed ) )
+		{
+			continue;
+		}
+		// Hidden views keep the change until they are shown
+		if( !view->widget()->isVisible() )
+		{
+			s_hiddenChanged = true;
+		}
+		else if( view->m_dataChanged.exchange( false, std::memory_order_acquire ) )
+		{
+			view->modelDataChanged();
+		}
+	}
+}
+
+
+
+
+void ModelView::markDataChanged()
+{
+	// A minimized SubWindow hides its widget too, so this also holds
+	// back views of minimized windows
+	if( QThread::currentThread() == widget()->thread() &&
+		widget()->isVisible() )
+	{
+		modelDataChanged();
+	}
+	else
+	{
+		m_dataChanged.store( true, std::memory_order_release );
+		s_anyChanged.store( true, std::memory_order_release );
+	}
+}
+
+
@@ -32,6 +32,7 @@
 #include "DeprecationHelper.h"
 #include "GuiApplication.h"
 #include "InstrumentTrack.h"
+#include "PerfLog.h"
 #include "PianoRoll.h"
 #include "RenameDialog.h"
 
@@ -310,8 +311,23 @@ static int computeNoteRange(int minKey, int maxKey)
 	return (maxKey - minKey) + 1;
 }
 
+// changes whenever a note is added, removed or changed in a way the thumbnail shows
+static uint notesSignature(NoteVector const & notes)
+{
+	uint signature = notes.size();
+	for (Note const * note : notes)
+	{
+		signature = qHash(note->pos().getTicks(), signature);
+		signature = qHash(note->length().getTicks(), signature);
+		signature = qHash(note->key(), signature);
+		signature = qHash(note->getVolume(), signature);
+	}
+	return signature;
+}
+
 void PatternView::paintEvent( QPaintEvent * )
 {
+	PerfTrace::Scope trace( "PatternView::paintEvent", PerfTrace::Gui );
 	QPainter painter( this );
 
 	if( !needsUpdate() )
@@ -322,10 +338,7 @@ void PatternView::paintEvent( QPaintEvent * )
 
 	setNeedsUpdate( false );
 
-	if (m_paintPixmap.isNull() || m_paintPixmap.size() != size())
-	{
-		m_paintPixmap = QPixmap(size());
-	}
+	fitPaintPixmap( m_paintPixmap );
 
 	QPainter p( &m_paintPixmap );
 
@@ -390,185 +403,197 @@ void PatternView::paintEvent( QPaintEvent * )
 	const int x_base = TCO_BORDER_WIDTH;
 
 	bool displayBB = fixedTCOs() || (pixelsPerBar >= 96 && m_legacySEBB);
-	// melody pattern paint event
+
+	// set colour based on mute status
+	QColor noteFillColor = muted ? getMutedNoteFillColor() : getNoteFillColor();
+	QColor noteBorderColor = muted ? getMutedNoteBorderColor()
+								   : ( m_pat->hasColor() ? c.lighter( 200 ) : getNoteBorderColor() );
+
+	// the notes are only drawn again if they or the size changed, not
+	// for every repaint of the song editor
 	NoteVector const & noteCollection = m_pat->m_notes;
-	if( m_pat->m_patternType == Pattern::MelodyPattern && !noteCollection.empty() )
+	const ThumbnailKey thumbnailKey = { size(), baseWidth, m_pat->length().getTicks(),
+		textBoxHeight, m_pat->m_steps, muted, displayBB,
+		noteFillColor.rgba(), noteBorderColor.rgba(), notesSignature( noteCollection ) };
+	if( m_thumbnail.isNull() || m_thumbnail.devicePixelRatioF() != devicePixelRatioF() ||
+		!( thumbnailKey == m_thumbnailKey ) )
 	{
-		// Compute the minimum and maximum key in the pattern
-		// so that we know how much there is to draw.
-		int maxKey = std::numeric_limits<int>::min();
-		int minKey = std::numeric_limits<int>::max();
+		m_thumbnailKey = thumbnailKey;
+		fitPaintPixmap( m_thumbnail );
+		m_thumbnail.fill( Qt::transparent );
+		QPainter p( &m_thumbnail );
 
-		for (Note const * note : noteCollection)
+		// melody pattern paint event
+		if( m_pat->m_patternType == Pattern::MelodyPattern && !noteCollection.empty() )
 		{
-			int const key = note->key();
-			maxKey = qMax( maxKey, key );
-			minKey = qMin( minKey, key );
-		}
-
-		// If needed adjust the note range so that we always have paint a certain interval
-		int const minimalNoteRange = 12; // Always paint at least one octave
-		int const actualNoteRange = computeNoteRange(minKey, maxKey);
+			// Compute the minimum and maximum key in the pattern
+			// so that we know how much there is to draw.
+			int maxKey = std::numeric_limits<int>::min();
+			int minKey = std::numeric_limits<int>::max();
 
-		if (actualNoteRange < minimalNoteRange)
-		{
-			int missingNumberOfNotes = minimalNoteRange - actualNoteRange;
-			minKey = std::max(0, minKey - missingNumberOfNotes / 2);
-			maxKey = maxKey + missingNumberOfNotes / 2;
-			if (missingNumberOfNotes % 2 == 1)
+			for (Note const * note : noteCollection)
 			{
-				// Put more range at the top to bias drawing towards the bottom
-				++maxKey;
+				int const key = note->key();
+				maxKey = qMax( maxKey, key );
+				minKey = qMin( minKey, key );
 			}
-		}
-
-		int const adjustedNoteRange = computeNoteRange(minKey, maxKey);
 
-		// Transform such that [0, 1] x [0, 1] paints in the correct area
-		float distanceToTop = textBoxHeight;
+			// If needed adjust the note range so that we always have paint a certain interval
+			int const minimalNoteRange = 12; // Always paint at least one octave
+			int const actualNoteRange = computeNoteRange(minKey, maxKey);
 
-		// This moves the notes smoothly under the text
-		int widgetHeight = height();
-		int fullyAtTopAtLimit = MINIMAL_TRACK_HEIGHT;
-		int fullyBelowAtLimit = 4 * fullyAtTopAtLimit;
-		if (widgetHeight <= fullyBelowAtLimit)
-		{
-			if (widgetHeight <= fullyAtTopAtLimit)
-			{
-				distanceToTop = 0;
-			}
-			else
+			if (actualNoteRange < minimalNoteRange)
 			{
-				float const a = 1. / (fullyAtTopAtLimit - fullyBelowAtLimit);
-				float const b = - float(fullyBelowAtLimit) / (fullyAtTopAtLimit - fullyBelowAtLimit);
-				float const scale = a * widgetHeight + b;
-				distanceToTop = (1. - scale) * textBoxHeight;
+				int missingNumberOfNotes = minimalNoteRange - actualNoteRange;
+				minKey = std::max(0, minKey - missingNumberOfNotes / 2);
+				maxKey = maxKey + missingNumberOfNotes / 2;
+				if (missingNumberOfNotes % 2 == 1)
+				{
+					// Put more range at the top to bias drawing towards the bottom
+					++maxKey;
+				}
 			}
-		}
-
-		int const notesBorder = 4; // Border for the notes towards the top and bottom in pixels
-
-		// The relavant painting code starts here
-		p.save();
 
-		p.translate(0., distanceToTop + notesBorder);
-		p.scale(width(), height() - distanceToTop - 2 * notesBorder);
+			int const adjustedNoteRange = computeNoteRange(minKey, maxKey);
 
-		// set colour based on mute status
-		QColor noteFillColor = muted ? getMutedNoteFillColor() : getNoteFillColor();
-		QColor noteBorderColor = muted ? getMutedNoteBorderColor()
-									   : ( m_pat->hasColor() ? c.lighter( 200 ) : getNoteBorderColor() );
+			// Transform such that [0, 1] x [0, 1] paints in the correct area
+			float distanceToTop = textBoxHeight;
 
-		bool const drawAsLines = height() < 64;
-		if (drawAsLines)
-		{
-			p.setPen(noteFillColor);
-		}
-		else
-		{
-			p.setPen(noteBorderColor);
-			p.setRenderHint(QPainter::Antialiasing);
-		}
-
-		// Needed for Qt5 although the documentation for QPainter::setPen(QColor) as it's used above
-		// states that it should already set a width of 0.
-		QPen pen = p.pen();
-		pen.setWidth(0);
-		p.setPen(pen);
-
-		float const noteHeight = 1. / adjustedNoteRange;
-
-		// scan through all the notes and draw them on the pattern
-		for (Note const * currentNote : noteCollection)
-		{
-			// Map to 0, 1, 2, ...
-			int mappedNoteKey = currentNote->key() - minKey;
-			int invertedMappedNoteKey = adjustedNoteRange - mappedNoteKey - 1;
+			// This moves the notes smoothly under the text
+			int widgetHeight = height();
+			int fullyAtTopAtLimit = MINIMAL_TRACK_HEIGHT;
+			int fullyBelowAtLimit = 4 * fullyAtTopAtLimit;
+			if (widgetHeight <= fullyBelowAtLimit)
+			{
+				if (widgetHeight <= fullyAtTopAtLimit)
+				{
+					distanceToTop = 0;
+				}
+				else
+				{
+					float const a = 1. / (fullyAtTopAtLimit - fullyBelowAtLimit);
+					float const b = - float(fullyBelowAtLimit) / (fullyAtTopAtLimit - fullyBelowAtLimit);
+					float const scale = a * widgetHeight + b;
+					distanceToTop = (1. - scale) * textBoxHeight;
+				}
+			}
 
-			float const noteStartX = currentNote->pos() * tickLength;
-			float const noteLength = currentNote->length() * tickLength;
+			int const notesBorder = 4; // Border for the notes towards the top and bottom in pixels
 
-			float const noteStartY = invertedMappedNoteKey * noteHeight;
+			// The relavant painting code starts here
+			p.translate(0., distanceToTop + notesBorder);
+			p.scale(width(), height() - distanceToTop - 2 * notesBorder);
 
-			QRectF noteRectF( noteStartX, noteStartY, noteLength, noteHeight);
+			bool const drawAsLines = height() < 64;
 			if (drawAsLines)
 			{
-				p.drawLine(QPointF(noteStartX, noteStartY + 0.5 * noteHeight),
-					   QPointF(noteStartX + noteLength, noteStartY + 0.5 * noteHeight));
+				p.setPen(noteFillColor);
 			}
 			else
 			{
-				p.fillRect( noteRectF, noteFillColor );
-				p.drawRect( noteRectF );
+				p.setPen(noteBorderColor);
+				p.setRenderHint(QPainter::Antialiasing);
 			}
-		}
 
-		p.restore();
-	}
-	// beat pattern paint event
-	else if( beatPattern &&	displayBB )
-	{
-		QPixmap stepon0;
-		QPixmap stepon200;
-		QPixmap stepoff;
-		QPixmap stepoffl;
-		const int steps = qMax( 1,
-					m_pat->m_steps );
-		const int w = width() - 2 * TCO_BORDER_WIDTH;
-
-		// scale step graphics to fit the beat pattern length
-		stepon0 = s_stepBtnOn0->scaled( w / steps,
-					      s_stepBtnOn0->height(),
-					      Qt::IgnoreAspectRatio,
-					      Qt::SmoothTransformation );
-		stepon200 = s_stepBtnOn200->scaled( w / steps,
-					      s_stepBtnOn200->height(),
-					      Qt::IgnoreAspectRatio,
-					      Qt::SmoothTransformation );
-		stepoff = s_stepBtnOff->scaled( w / steps,
-						s_stepBtnOff->height(),
-						Qt::IgnoreAspectRatio,
-						Qt::SmoothTransformation );
-		stepoffl = s_stepBtnOffLight->scaled( w / steps,
-						s_stepBtnOffLight->height(),
-						Qt::IgnoreAspectRatio,
-						Qt::SmoothTransformation );
-
-		for( int it = 0; it < steps; it++ )	// go through all the steps in the beat pattern
-		{
-			Note * n = m_pat->noteAtStep( it );
+			// Needed for Qt5 although the documentation for QPainter::setPen(QColor) as it's used above
+			// states that it should already set a width of 0.
+			QPen pen = p.pen();
+			pen.setWidth(0);
+			p.setPen(pen);
 
-			// figure out x and y coordinates for step graphic
-			const int x = TCO_BORDER_WIDTH + static_cast<int>( it * w / steps );
-			const int y = height() - s_stepBtnOff->height() - 1;
+			float const noteHeight = 1. / adjustedNoteRange;
 
-			if( n )
+			// scan through all the notes and draw them on the pattern
+			for (Note const * currentNote : noteCollection)
 			{
-				const int vol = n->getVolume();
-				p.drawPixmap( x, y, stepoffl );
-				p.drawPixmap( x, y, stepon0 );
-				p.setOpacity( sqrt( vol / 200.0 ) );
-				p.drawPixmap( x, y, stepon200 );
-				p.setOpacity( 1 );
+				// Map to 0, 1, 2, ...
+				int mappedNoteKey = currentNote->key() - minKey;
+				int invertedMappedNoteKey = adjustedNoteRange - mappedNoteKey - 1;
+
+				float const noteStartX = currentNote->pos() * tickLength;
+				float const noteLength = currentNote->length() * tickLength;
+
+				float const noteStartY = invertedMappedNoteKey * noteHeight;
+
+				QRectF noteRectF( noteStartX, noteStartY, noteLength, noteHeight);
+				if (drawAsLines)
+				{
+					p.drawLine(QPointF(noteStartX, noteStartY + 0.5 * noteHeight),
+						   QPointF(noteStartX + noteLength, noteStartY + 0.5 * noteHeight));
+				}
+				else
+				{
+					p.fillRect( noteRectF, noteFillColor );
+					p.drawRect( noteRectF );
+				}
 			}
-			else if( ( it / 4 ) % 2 )
+		}
+		// beat pattern paint event
+		else if( beatPattern &&	displayBB )
+		{
+			QPixmap stepon0;
+			QPixmap stepon200;
+			QPixmap stepoff;
+			QPixmap stepoffl;
+			const int steps = qMax( 1,
+						m_pat->m_steps );
+			const int w = width() - 2 * TCO_BORDER_WIDTH;
+
+			// scale step graphics to fit the beat pattern length
+			stepon0 = s_stepBtnOn0->scaled( w / steps,
+						      s_stepBtnOn0->height(),
+						      Qt::IgnoreAspectRatio,
+						      Qt::SmoothTransformation );
+			stepon200 = s_stepBtnOn200->scaled( w / steps,
+						      s_stepBtnOn200->height(),
+						      Qt::IgnoreAspectRatio,
+						      Qt::SmoothTransformation );
+			stepoff = s_stepBtnOff->scaled( w / steps,
+							s_stepBtnOff->height(),
+							Qt::IgnoreAspectRatio,
+							Qt::SmoothTransformation );
+			stepoffl = s_stepBtnOffLight->scaled( w / steps,
+							s_stepBtnOffLight->height(),
+							Qt::IgnoreAspectRatio,
+							Qt::SmoothTransformation );
+
+			for( int it = 0; it < steps; it++ )	// go through all the steps in the beat pattern
 			{
-				p.drawPixmap( x, y, stepoffl );
-			}
-			else
+				Note * n = m_pat->noteAtStep( it );
+
+				// figure out x and y coordinates for step graphic
+				const int x = TCO_BORDER_WIDTH + static_cast<int>( it * w / steps );
+				const int y = height() - s_stepBtnOff->height() - 1;
+
+				if( n )
+				{
+					const int vol = n->getVolume();
+					p.drawPixmap( x, y, stepoffl );
+					p.drawPixmap( x, y, stepon0 );
+					p.setOpacity( sqrt( vol / 200.0 ) );
+					p.drawPixmap( x, y, stepon200 );
+					p.setOpacity( 1 );
+				}
+				else if( ( it / 4 ) % 2 )
+				{
+					p.drawPixmap( x, y, stepoffl );
+				}
+				else
+				{
+					p.drawPixmap( x, y, stepoff );
+				}
+			} // end for loop
+
+			// draw a transparent rectangle over muted patterns
+			if ( muted )
 			{
-				p.drawPixmap( x, y, stepoff );
+				p.setBrush( mutedBackgroundColor() );
+				p.setOpacity( 0.5 );
+				p.drawRect( 0, 0, width(), height() );
 			}
-		} // end for loop
-
-		// draw a transparent rectangle over muted patterns
-		if ( muted )
-		{
-			p.setBrush( mutedBackgroundColor() );
-			p.setOpacity( 0.5 );
-			p.drawRect( 0, 0, width(), height() );
 		}
 	}
+	p.drawPixmap( 0, 0, m_thumbnail );
 
 	// bar lines
 	const int lineSize = 3;
@@ -30,6 +30,7 @@
 #include "embed.h"
 #include "gui_templates.h"
 #include "PathUtil.h"
+#include "PerfLog.h"
 #include "Song.h"
 #include "StringPairDrag.h"
 #include "ToolTip.h"
@@ -52,6 +53,7 @@ SampleTCOView::SampleTCOView( SampleTCO * _tco, TrackView * _tv ) :
 
 void SampleTCOView::updateSample()
 {
+	m_waveform = QPixmap();
 	update();
 	// set tooltip to filename so that user can see what sample this
 	// sample-tco contains
@@ -229,7 +231,7 @@ void SampleTCOView::mouseDoubleClickEvent( QMouseEvent * )
 	if ( af.isEmpty() ) {} //Don't do anything if no file is loaded
 	else if ( af == m_tco->m_sampleBuffer->audioFile() )
 	{	//Instead of reloading the existing file, just reset the size
-		int length = (int) ( m_tco->m_sampleBuffer->frames() / Engine::framesPerTick() );
+		int length = m_tco->sampleLength();
 		m_tco->changeLength(length);
 	}
 	else
@@ -242,8 +244,9 @@ void SampleTCOView::mouseDoubleClickEvent( QMouseEvent * )
 
 
 
-void SampleTCOView::paintEvent( QPaintEvent * pe )
+void SampleTCOView::paintEvent( QPaintEvent * )
 {
+	PerfTrace::Scope trace( "SampleTCOView::paintEvent", PerfTrace::Gui );
 	QPainter painter( this );
 
 	if( !needsUpdate() )
@@ -254,10 +257,7 @@ void SampleTCOView::paintEvent( QPaintEvent * pe )
 
 	setNeedsUpdate( false );
 
-	if (m_paintPixmap.isNull() || m_paintPixmap.size() != size())
-	{
-		m_paintPixmap = QPixmap(size());
-	}
+	fitPaintPixmap( m_paintPixmap );
 
 	QPainter p( &m_paintPixmap );
 
@@ -316,7 +316,34 @@ void SampleTCOView::paintEvent( QPaintEvent * pe )
 	float offset =  m_tco->startTimeOffset() / ticksPerBar * pixelsPerBar();
 	QRect r = QRect( TCO_BORDER_WIDTH + offset, spacing,
 			qMax( static_cast<int>( m_tco->sampleLength() * ppb / ticksPerBar ), 1 ), rect().bottom() - 2 * spacing );
-	m_tco->m_sampleBuffer->visualize( p, r, pe->rect() );
+
+	// the waveform is only drawn again if the sample, the zoom or the size
+	// changed, not for every repaint of the song editor
+	SampleBuffer * buffer = m_tco->m_sampleBuffer;
+	const WaveformKey waveformKey = { size(), r, p.pen().color().rgba(),
+						buffer->reversed() };
+	if( m_waveform.isNull() || m_waveform.devicePixelRatioF() != devicePixelRatioF() ||
+		!( waveformKey == m_waveformKey ) )
+	{
+		m_waveformKey = waveformKey;
+		fitPaintPixmap( m_waveform );
+		m_waveform.fill( Qt::transparent );
+		QPainter wp( &m_waveform );
+		wp.setPen( p.pen() );
+
+		// only the frames within the clip are summarized
+		const QRect visible = r & rect();
+		const f_cnt_t frames = buffer->frames();
+		const f_cnt_t from = static_cast<f_cnt_t>(
+			static_cast<double>( visible.left() - r.left() ) * frames / r.width() );
+		const f_cnt_t to = qMin( frames, static_cast<f_cnt_t>(
+			static_cast<double>( visible.right() + 1 - r.left() ) * frames / r.width() ) );
+		if( !visible.isEmpty() && from < to )
+		{
+			buffer->visualize( wp, visible, from, to );
+		}
+	}
+	p.drawPixmap( 0, 0, m_waveform );
 
 	QString name = PathUtil::cleanName(m_tco->m_sampleBuffer->audioFile());
 	paintTextLabel(name, p);
@@ -30,6 +30,7 @@
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QScrollArea>
+#include <QSpinBox>
 
 #include "AudioDeviceSetupWidget.h"
 #include "debug.h"
@@ -40,8 +41,11 @@
 #include "MainWindow.h"
 #include "MidiSetupWidget.h"
 #include "Mixer.h"
+#include "MixerWorkerThread.h"
 #include "ProjectJournal.h"
+#include "RenderCache.h"
 #include "SetupDialog.h"
+#include "Song.h"
 #include "TabBar.h"
 #include "TabButton.h"
 #include "ToolTip.h"
@@ -55,6 +59,7 @@
 #include "AudioOss.h"
 #include "AudioPortAudio.h"
 #include "AudioPulseAudio.h"
+#include "AudioPipeWire.h"
 #include "AudioSdl.h"
 #include "AudioSndio.h"
 #include "AudioSoundIo.h"
@@ -136,18 +141,53 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 			"ui", "vstalwaysontop").toInt()),
 	m_syncVSTPlugins(ConfigManager::inst()->value(
 			"ui", "syncvstplugins", "1").toInt()),
+	m_vstSharedHost(ConfigManager::inst()->value(
+			"ui", "vstsharedhost").toInt()),
+	m_vstSpareHosts(ConfigManager::inst()->value(
+			"ui", "vstsparehosts", "1").toInt()),
 	m_disableAutoQuit(ConfigManager::inst()->value(
 			"ui", "disableautoquit", "1").toInt()),
 	m_NaNHandler(ConfigManager::inst()->value(
 			"app", "nanhandler", "1").toInt()),
 	m_hqAudioDev(ConfigManager::inst()->value(
 			"mixer", "hqaudio").toInt()),
+	m_workStealing(ConfigManager::inst()->value(
+			"mixer", "workstealing").toInt()),
+	m_flightRecorder(ConfigManager::inst()->value(
+			"mixer", "flightrecorder").toInt()),
+	m_batchNotes(ConfigManager::inst()->value(
+			"mixer", "batchnotes", "1").toInt()),
+	m_oneShotCache(ConfigManager::inst()->value(
+			"mixer", "oneshotcache").toInt()),
+	m_asyncRemotePlugins(ConfigManager::inst()->value(
+			"mixer", "asyncremoteplugins").toInt()),
+	m_remoteWatchdog(ConfigManager::inst()->value(
+			"mixer", "remotewatchdog").toInt()),
+	m_lockMemory(ConfigManager::inst()->value(
+			"mixer", "lockmemory").toInt()),
+	m_cpuBudget(ConfigManager::inst()->value(
+			"mixer", "cpubudget").toInt()),
+	m_renderCacheSize(ConfigManager::inst()->value(
+			"mixer", "rendercachesize").toInt()),
+	m_workerThreads(ConfigManager::inst()->value(
+			"mixer", "workerthreads").toInt()),
+	m_workerScheduling(ConfigManager::inst()->value(
+			"mixer", "workerscheduling").toInt()),
+	m_workerPriority(ConfigManager::inst()->value(
+			"mixer", "workerpriority").toInt()),
+	m_workerAffinity(ConfigManager::inst()->value(
+			"mixer", "workeraffinity")),
 	m_bufferSize(ConfigManager::inst()->value(
 			"mixer", "framesperaudiobuffer").toInt()),
+	m_midiClockOut(ConfigManager::inst()->value(
+			"midi", "clockout").toInt()),
+	m_midiTimeCodeOut(ConfigManager::inst()->value(
+			"midi", "timecodeout").toInt()),
 	m_workingDir(QDir::toNativeSeparators(ConfigManager::inst()->workingDir())),
 	m_vstDir(QDir::toNativeSeparators(ConfigManager::inst()->vstDir())),
 	m_ladspaDir(QDir::toNativeSeparators(ConfigManager::inst()->ladspaDir())),
 	m_gigDir(QDir::toNativeSeparators(ConfigManager::inst()->gigDir())),
+	m_renderCacheDir(QDir::toNativeSeparators(RenderCache::directory())),
 	m_sf2Dir(QDir::toNativeSeparators(ConfigManager::inst()->sf2Dir())),
 #ifdef LMMS_HAVE_FLUIDSYNTH
 	m_sf2File(QDir::toNativeSeparators(ConfigManager::inst()->sf2File())),
@@ -434,6 +474,12 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 	addLedCheckBox(tr("Sync VST plugins to host playback"), plugins_tw, counter,
 		m_syncVSTPlugins, SLOT(toggleSyncVSTPlugins(bool)), false);
 
+	addLedCheckBox(tr("Share one process between VST plugins"), plugins_tw, counter,
+		m_vstSharedHost, SLOT(toggleVSTSharedHost(bool)), false);
+
+	addLedCheckBox(tr("Start VST plugin processes ahead of time"), plugins_tw, counter,
+		m_vstSpareHosts, SLOT(toggleVSTSpareHosts(bool)), false);
+
 	addLedCheckBox(tr("Keep effects running even without input"), plugins_tw, counter,
 		m_disableAutoQuit, SLOT(toggleDisableAutoQuit(bool)), false);
 
@@ -488,6 +534,11 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 			new AudioPulseAudio::setupWidget(as_w);
 #endif
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	m_audioIfaceSetupWidgets[AudioPipeWire::name()] =
+			new AudioPipeWire::setupWidget(as_w);
+#endif
+
 #ifdef LMMS_HAVE_PORTAUDIO
 	m_audioIfaceSetupWidgets[AudioPortAudio::name()] =
 			new AudioPortAudio::setupWidget(as_w);
@@ -562,6 +613,208 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 	connect(hqaudio, SIGNAL(toggled(bool)),
 			this, SLOT(toggleHQAudioDev(bool)));
 
+	// Work-stealing scheduler LED.
+	LedCheckBox * workStealing = new LedCheckBox(
+			tr("Use work-stealing scheduler for worker threads"), audio_w);
+	workStealing->setChecked(m_workStealing);
+	connect(workStealing, SIGNAL(toggled(bool)),
+			this, SLOT(toggleWorkStealing(bool)));
+	connect(workStealing, SIGNAL(toggled(bool)),
+			this, SLOT(showRestartWarning()));
+
+	// Note batching LED.
+	LedCheckBox * batchNotes = new LedCheckBox(
+			tr("Render the notes of a track together"), audio_w);
+	batchNotes->setChecked(m_batchNotes);
+	ToolTip::add(batchNotes, tr("Renders up to 16 notes of a track in "
+			"one job, which saves overhead on projects with many "
+			"short notes."));
+	connect(batchNotes, SIGNAL(toggled(bool)),
+			this, SLOT(toggleBatchNotes(bool)));
+	connect(batchNotes, SIGNAL(toggled(bool)),
+			this, SLOT(showRestartWarning()));
+
+	// One-shot cache LED.
+	LedCheckBox * oneShotCache = new LedCheckBox(
+			tr("Reuse the hits of drum synthesizers"), audio_w);
+	oneShotCache->setChecked(m_oneShotCache);
+	ToolTip::add(oneShotCache, tr("Kicker and sfxr play back what they "
+			"rendered for an earlier note with the same settings and "
+			"pitch. Not used while their parameters are automated or "
+			"random."));
+	connect(oneShotCache, SIGNAL(toggled(bool)),
+			this, SLOT(toggleOneShotCache(bool)));
+
+	// Asynchronous remote plugins LED.
+	LedCheckBox * asyncRemotePlugins = new LedCheckBox(
+			tr("Run VST effects one period ahead"), audio_w);
+	asyncRemotePlugins->setChecked(m_asyncRemotePlugins);
+	ToolTip::add(asyncRemotePlugins, tr("VST effects compute while LMMS "
+			"goes on with other tracks, rather than LMMS waiting for "
+			"them. This delays their output by one buffer, which is "
+			"compensated on the FX mixer."));
+	connect(asyncRemotePlugins, SIGNAL(toggled(bool)),
+			this, SLOT(toggleAsyncRemotePlugins(bool)));
+	connect(asyncRemotePlugins, SIGNAL(toggled(bool)),
+			this, SLOT(showRestartWarning()));
+
+	// Remote plugin watchdog LED.
+	LedCheckBox * remoteWatchdog = new LedCheckBox(
+			tr("Bypass plugins which keep missing the deadline"), audio_w);
+	remoteWatchdog->setChecked(m_remoteWatchdog);
+	ToolTip::add(remoteWatchdog, tr("VST plugins and ZynAddSubFX are "
+			"waited for no longer than one buffer. If one keeps "
+			"taking longer, it is muted for a while instead of "
+			"stalling the whole song."));
+	connect(remoteWatchdog, SIGNAL(toggled(bool)),
+			this, SLOT(toggleRemoteWatchdog(bool)));
+	connect(remoteWatchdog, SIGNAL(toggled(bool)),
+			this, SLOT(showRestartWarning()));
+
+	// Lock memory LED.
+	LedCheckBox * lockMemory = new LedCheckBox(
+			tr("Lock the buffers of the engine in memory"), audio_w);
+	lockMemory->setChecked(m_lockMemory);
+	ToolTip::add(lockMemory, tr("The buffers LMMS renders into are "
+			"prefaulted and locked into RAM, using huge pages where "
+			"available, so they are never paged out while playing. "
+			"How much can be locked depends on the memlock limit of "
+			"the system."));
+	connect(lockMemory, SIGNAL(toggled(bool)),
+			this, SLOT(toggleLockMemory(bool)));
+	connect(lockMemory, SIGNAL(toggled(bool)),
+			this, SLOT(showRestartWarning()));
+
+	// Flight recorder LED.
+	LedCheckBox * flightRecorder = new LedCheckBox(
+			tr("Write timings of recent periods to a file on xruns"), audio_w);
+	flightRecorder->setChecked(m_flightRecorder);
+	ToolTip::add(flightRecorder, tr("The file is written to the "
+			"temporary directory and can help finding the cause of "
+			"dropouts."));
+	connect(flightRecorder, SIGNAL(toggled(bool)),
+			this, SLOT(toggleFlightRecorder(bool)));
+
+
+	// Worker threads tab.
+	TabWidget * workerThreads_tw = new TabWidget(
+			tr("Worker threads"), audio_w);
+	workerThreads_tw->setFixedHeight(176);
+
+	QLabel * workerThreadsLbl = new QLabel(
+			tr("Number of threads:"), workerThreads_tw);
+	workerThreadsLbl->setGeometry(10, 20, 160, 24);
+
+	QSpinBox * workerThreadsSpinBox = new QSpinBox(workerThreads_tw);
+	workerThreadsSpinBox->setGeometry(180, 20, 80, 24);
+	workerThreadsSpinBox->setRange(0, 64);
+	workerThreadsSpinBox->setSpecialValueText(tr("Auto"));
+	workerThreadsSpinBox->setValue(m_workerThreads);
+	connect(workerThreadsSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(setWorkerThreads(int)));
+	connect(workerThreadsSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(showRestartWarning()));
+
+	QLabel * workerSchedulingLbl = new QLabel(
+			tr("Scheduling:"), workerThreads_tw);
+	workerSchedulingLbl->setGeometry(10, 48, 160, 24);
+
+	QComboBox * workerSchedulingComboBox = new QComboBox(workerThreads_tw);
+	workerSchedulingComboBox->setGeometry(180, 48, 170, 24);
+	workerSchedulingComboBox->addItem(tr("Default"),
+			MixerWorkerThread::SchedulingDefault);
+	workerSchedulingComboBox->addItem(tr("Realtime (FIFO)"),
+			MixerWorkerThread::SchedulingFifo);
+	workerSchedulingComboBox->addItem(tr("Realtime (round-robin)"),
+			MixerWorkerThread::SchedulingRoundRobin);
+	workerSchedulingComboBox->setCurrentIndex(
+			workerSchedulingComboBox->findData(m_workerScheduling));
+	connect(workerSchedulingComboBox, SIGNAL(currentIndexChanged(int)),
+			this, SLOT(setWorkerScheduling(int)));
+	connect(workerSchedulingComboBox, SIGNAL(currentIndexChanged(int)),
+			this, SLOT(showRestartWarning()));
+
+	QLabel * workerPriorityLbl = new QLabel(
+			tr("Realtime priority:"), workerThreads_tw);
+	workerPriorityLbl->setGeometry(10, 76, 160, 24);
+
+	QSpinBox * workerPrioritySpinBox = new QSpinBox(workerThreads_tw);
+	workerPrioritySpinBox->setGeometry(180, 76, 80, 24);
+	workerPrioritySpinBox->setRange(0, 99);
+	workerPrioritySpinBox->setSpecialValueText(tr("Auto"));
+	workerPrioritySpinBox->setValue(m_workerPriority);
+	connect(workerPrioritySpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(setWorkerPriority(int)));
+	connect(workerPrioritySpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(showRestartWarning()));
+
+	QLabel * workerAffinityLbl = new QLabel(
+			tr("CPUs per thread:"), workerThreads_tw);
+	workerAffinityLbl->setGeometry(10, 104, 160, 24);
+
+	QLineEdit * workerAffinityLineEdit = new QLineEdit(
+			m_workerAffinity, workerThreads_tw);
+	workerAffinityLineEdit->setGeometry(180, 104, 170, 24);
+	workerAffinityLineEdit->setPlaceholderText(tr("e.g. 1;2;3-4"));
+	ToolTip::add(workerAffinityLineEdit,
+			tr("CPUs each worker thread may run on, separated by "
+				"semicolons. Threads without an entry aren't pinned."));
+	connect(workerAffinityLineEdit, SIGNAL(textChanged(const QString &)),
+			this, SLOT(setWorkerAffinity(const QString &)));
+	connect(workerAffinityLineEdit, SIGNAL(textChanged(const QString &)),
+			this, SLOT(showRestartWarning()));
+
+	QLabel * workerStateLbl = new QLabel(tr("Running: %1").arg(
+			MixerWorkerThread::appliedThreadSettings()), workerThreads_tw);
+	workerStateLbl->setGeometry(10, 132, 340, 36);
+	workerStateLbl->setWordWrap(true);
+
+
+	// CPU budget tab.
+	TabWidget * cpuBudget_tw = new TabWidget(
+			tr("CPU budget"), audio_w);
+	cpuBudget_tw->setFixedHeight(56);
+
+	QLabel * cpuBudgetLbl = new QLabel(
+			tr("Steal quiet voices above:"), cpuBudget_tw);
+	cpuBudgetLbl->setGeometry(10, 20, 160, 24);
+
+	QSpinBox * cpuBudgetSpinBox = new QSpinBox(cpuBudget_tw);
+	cpuBudgetSpinBox->setGeometry(180, 20, 80, 24);
+	cpuBudgetSpinBox->setRange(0, 100);
+	cpuBudgetSpinBox->setSuffix("%");
+	cpuBudgetSpinBox->setSpecialValueText(tr("Off"));
+	cpuBudgetSpinBox->setValue(m_cpuBudget);
+	ToolTip::add(cpuBudgetSpinBox,
+			tr("While the CPU load is higher, the least audible "
+				"notes of the project are faded out."));
+	connect(cpuBudgetSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(setCpuBudget(int)));
+
+
+	// Render cache tab.
+	TabWidget * renderCache_tw = new TabWidget(
+			tr("Render cache"), audio_w);
+	renderCache_tw->setFixedHeight(56);
+
+	QLabel * renderCacheLbl = new QLabel(
+			tr("Keep renderings up to:"), renderCache_tw);
+	renderCacheLbl->setGeometry(10, 20, 160, 24);
+
+	QSpinBox * renderCacheSpinBox = new QSpinBox(renderCache_tw);
+	renderCacheSpinBox->setGeometry(180, 20, 100, 24);
+	renderCacheSpinBox->setRange(0, 1024 * 1024);
+	renderCacheSpinBox->setSingleStep(256);
+	renderCacheSpinBox->setSuffix(" MiB");
+	renderCacheSpinBox->setSpecialValueText(tr("Off"));
+	renderCacheSpinBox->setValue(m_renderCacheSize);
+	ToolTip::add(renderCacheSpinBox,
+			tr("Exporting a project keeps the renderings of its "
+				"instrument tracks, and tracks that weren't "
+				"changed are played from them the next time."));
+	connect(renderCacheSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(setRenderCacheSize(int)));
+
 
 	// Buffer size tab.
 	TabWidget * bufferSize_tw = new TabWidget(
@@ -578,8 +831,6 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 
 	connect(m_bufferSizeSlider, SIGNAL(valueChanged(int)),
 			this, SLOT(setBufferSize(int)));
-	connect(m_bufferSizeSlider, SIGNAL(valueChanged(int)),
-			this, SLOT(showRestartWarning()));
 
 	m_bufferSizeLbl = new QLabel(bufferSize_tw);
 	m_bufferSizeLbl->setGeometry(10, 40, 200, 24);
@@ -594,11 +845,45 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 			tr("Reset to default value"));
 
 
+	// Latency tab.
+	TabWidget * latency_tw = new TabWidget(
+			tr("Latency"), audio_w);
+	latency_tw->setFixedHeight(96);
+
+	m_latencyLbl = new QLabel(latency_tw);
+	m_latencyLbl->setGeometry(10, 18, 300, 70);
+	latencyMeasured(false);
+
+	QPushButton * latency_measure_btn = new QPushButton(
+			tr("Measure"), latency_tw);
+	latency_measure_btn->setGeometry(270, 60, 80, 28);
+	connect(latency_measure_btn, SIGNAL(clicked()),
+			this, SLOT(measureLatency()));
+	ToolTip::add(latency_measure_btn,
+			tr("Sends a click to the audio output and waits for it "
+				"to come back on the input, e.g. through a loopback "
+				"cable. Recordings are shifted by the measured "
+				"latency."));
+	connect(&Engine::mixer()->latencyProbe(), SIGNAL(measured(bool)),
+			this, SLOT(latencyMeasured(bool)));
+
+
 	// Audio layout ordering.
 	audio_layout->addWidget(audioiface_tw);
 	audio_layout->addWidget(as_w);
 	audio_layout->addWidget(hqaudio);
+	audio_layout->addWidget(workStealing);
+	audio_layout->addWidget(batchNotes);
+	audio_layout->addWidget(oneShotCache);
+	audio_layout->addWidget(asyncRemotePlugins);
+	audio_layout->addWidget(remoteWatchdog);
+	audio_layout->addWidget(lockMemory);
+	audio_layout->addWidget(flightRecorder);
+	audio_layout->addWidget(workerThreads_tw);
+	audio_layout->addWidget(cpuBudget_tw);
+	audio_layout->addWidget(renderCache_tw);
 	audio_layout->addWidget(bufferSize_tw);
+	audio_layout->addWidget(latency_tw);
 	audio_layout->addStretch();
 
 
@@ -713,10 +998,36 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 		m_assignableMidiDevices->setCurrentIndex(current);
 	}
 
+	// MIDI sync output tab.
+	TabWidget * midiSync_tw = new TabWidget(
+			tr("Sync output"), midi_w);
+
+	counter = 0;
+
+	addLedCheckBox(tr("Send MIDI clock"), midiSync_tw, counter,
+		m_midiClockOut, SLOT(toggleMidiClockOut(bool)), false);
+
+	addLedCheckBox(tr("Send MIDI time code"), midiSync_tw, counter,
+		m_midiTimeCodeOut, SLOT(toggleMidiTimeCodeOut(bool)), false);
+
+	counter++;
+
+	m_midiTimeCodeFps = new QComboBox(midiSync_tw);
+	m_midiTimeCodeFps->setGeometry(XDelta, YDelta * counter, 240, 28);
+	for (int fps : {24, 25, 30})
+	{
+		m_midiTimeCodeFps->addItem(tr("%1 frames per second").arg(fps), fps);
+	}
+	m_midiTimeCodeFps->setCurrentIndex(m_midiTimeCodeFps->findData(
+		ConfigManager::inst()->value("midi", "timecodefps", "25").toInt()));
+
+	midiSync_tw->setFixedHeight(YDelta + 28 + YDelta * counter);
+
 	// MIDI layout ordering.
 	midi_layout->addWidget(midiiface_tw);
 	midi_layout->addWidget(ms_w);
 	midi_layout->addWidget(midiAutoAssign_tw);
+	midi_layout->addWidget(midiSync_tw);
 	midi_layout->addStretch();
 
 
@@ -799,6 +1110,10 @@ SetupDialog::SetupDialog(ConfigTabs tab_to_open) :
 		SLOT(setGIGDir(const QString &)),
 		SLOT(openGIGDir()),
 		m_gigDirLineEdit);
+	addPathEntry(tr("Render cache directory"), m_renderCacheDir,
+		SLOT(setRenderCacheDir(const QString &)),
+		SLOT(openRenderCacheDir()),
+		m_renderCacheDirLineEdit);
 	addPathEntry(tr("Theme directory"), m_themeDir,
 		SLOT(setThemeDir(const QString &)),
 		SLOT(openThemeDir()),
@@ -948,6 +1263,10 @@ void SetupDialog::accept()
 					QString::number(m_vstAlwaysOnTop));
 	ConfigManager::inst()->setValue("ui", "syncvstplugins",
 					QString::number(m_syncVSTPlugins));
+	ConfigManager::inst()->setValue("ui", "vstsharedhost",
+					QString::number(m_vstSharedHost));
+	ConfigManager::inst()->setValue("ui", "vstsparehosts",
+					QString::number(m_vstSpareHosts));
 	ConfigManager::inst()->setValue("ui", "disableautoquit",
 					QString::number(m_disableAutoQuit));
 	ConfigManager::inst()->setValue("mixer", "audiodev",
@@ -956,12 +1275,51 @@ void SetupDialog::accept()
 					QString::number(m_NaNHandler));
 	ConfigManager::inst()->setValue("mixer", "hqaudio",
 					QString::number(m_hqAudioDev));
+	ConfigManager::inst()->setValue("mixer", "workstealing",
+					QString::number(m_workStealing));
+	ConfigManager::inst()->setValue("mixer", "flightrecorder",
+					QString::number(m_flightRecorder));
+	Engine::mixer()->profiler().flightRecorder().setEnabled(m_flightRecorder);
+	ConfigManager::inst()->setValue("mixer", "batchnotes",
+					QString::number(m_batchNotes));
+	ConfigManager::inst()->setValue("mixer", "oneshotcache",
+					QString::number(m_oneShotCache));
+	Engine::mixer()->setOneShotCaching(m_oneShotCache);
+	ConfigManager::inst()->setValue("mixer", "asyncremoteplugins",
+					QString::number(m_asyncRemotePlugins));
+	ConfigManager::inst()->setValue("mixer", "remotewatchdog",
+					QString::number(m_remoteWatchdog));
+	ConfigManager::inst()->setValue("mixer", "lockmemory",
+					QString::number(m_lockMemory));
+	ConfigManager::inst()->setValue("mixer", "cpubudget",
+					QString::number(m_cpuBudget));
+	Engine::mixer()->setCpuBudget(m_cpuBudget);
+	ConfigManager::inst()->setValue("mixer", "rendercachesize",
+					QString::number(m_renderCacheSize));
+	ConfigManager::inst()->setValue("mixer", "rendercachedir",
+					QDir::fromNativeSeparators(m_renderCacheDir));
+	ConfigManager::inst()->setValue("mixer", "workerthreads",
+					QString::number(m_workerThreads));
+	ConfigManager::inst()->setValue("mixer", "workerscheduling",
+					QString::number(m_workerScheduling));
+	ConfigManager::inst()->setValue("mixer", "workerpriority",
+					QString::number(m_workerPriority));
+	ConfigManager::inst()->setValue("mixer", "workeraffinity",
+					m_workerAffinity);
 	ConfigManager::inst()->setValue("mixer", "framesperaudiobuffer",
 					QString::number(m_bufferSize));
+	Engine::mixer()->changeFramesPerAudioBuffer(m_bufferSize);
 	ConfigManager::inst()->setValue("mixer", "mididev",
 					m_midiIfaceNames[m_midiInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("midi", "midiautoassign",
 					m_assignableMidiDevices->currentText());
+	ConfigManager::inst()->setValue("midi", "clockout",
+					QString::number(m_midiClockOut));
+	ConfigManager::inst()->setValue("midi", "timecodeout",
+					QString::number(m_midiTimeCodeOut));
+	ConfigManager::inst()->setValue("midi", "timecodefps",
+					m_midiTimeCodeFps->currentData().toString());
+	Engine::getSong()->midiSyncOutput().loadSettings();
 
 
 	ConfigManager::inst()->setWorkingDir(QDir::fromNativeSeparators(m_workingDir));
@@ -1134,6 +1492,18 @@ void SetupDialog::toggleSyncVSTPlugins(bool enabled)
 }
 
 
+void SetupDialog::toggleVSTSharedHost(bool enabled)
+{
+	m_vstSharedHost = enabled;
+}
+
+
+void SetupDialog::toggleVSTSpareHosts(bool enabled)
+{
+	m_vstSpareHosts = enabled;
+}
+
+
 void SetupDialog::vstEmbedMethodChanged()
 {
 	m_vstEmbedMethod = m_vstEmbedComboBox->currentData().toString();
@@ -1163,6 +1533,85 @@ void SetupDialog::toggleHQAudioDev(bool enabled)
 }
 
 
+void SetupDialog::toggleWorkStealing(bool enabled)
+{
+	m_workStealing = enabled;
+}
+
+
+void SetupDialog::toggleBatchNotes(bool enabled)
+{
+	m_batchNotes = enabled;
+}
+
+
+void SetupDialog::toggleOneShotCache(bool enabled)
+{
+	m_oneShotCache = enabled;
+}
+
+
+void SetupDialog::toggleAsyncRemotePlugins(bool enabled)
+{
+	m_asyncRemotePlugins = enabled;
+}
+
+
+void SetupDialog::toggleRemoteWatchdog(bool enabled)
+{
+	m_remoteWatchdog = enabled;
+}
+
+
+void SetupDialog::toggleLockMemory(bool enabled)
+{
+	m_lockMemory = enabled;
+}
+
+
+void SetupDialog::toggleFlightRecorder(bool enabled)
+{
+	m_flightRecorder = enabled;
+}
+
+
+void SetupDialog::setCpuBudget(int load)
+{
+	m_cpuBudget = load;
+}
+
+
+void SetupDialog::setRenderCacheSize(int size)
+{
+	m_renderCacheSize = size;
+}
+
+
+void SetupDialog::setWorkerThreads(int value)
+{
+	m_workerThreads = value;
+}
+
+
+void SetupDialog::setWorkerScheduling(int index)
+{
+	// the items are in the order of MixerWorkerThread::SchedulingPolicies
+	m_workerScheduling = index;
+}
+
+
+void SetupDialog::setWorkerPriority(int value)
+{
+	m_workerPriority = value;
+}
+
+
+void SetupDialog::setWorkerAffinity(const QString & cpus)
+{
+	m_workerAffinity = cpus;
+}
+
+
 void SetupDialog::audioInterfaceChanged(const QString & iface)
 {
 	for(AswMap::iterator it = m_audioIfaceSetupWidgets.begin();
@@ -1209,6 +1658,53 @@ void SetupDialog::resetBufferSize()
 }
 
 
+void SetupDialog::measureLatency()
+{
+	Mixer * mixer = Engine::mixer();
+	if (!mixer->audioDev()->supportsCapture())
+	{
+		m_latencyLbl->setText(tr("The audio interface doesn't "
+						"capture audio, so the latency can't be measured."));
+		return;
+	}
+	m_latencyLbl->setText(tr("Measuring..."));
+	mixer->latencyProbe().start(mixer->inputSampleRate());
+}
+
+
+void SetupDialog::latencyMeasured(bool success)
+{
+	Mixer * mixer = Engine::mixer();
+	const float outputRate = mixer->processingSampleRate();
+	QString text = tr("Nominal: %1 ms").arg(
+		1000.0f * mixer->nominalLatency() / outputRate, 0, 'f', 1);
+
+	const f_cnt_t device = mixer->audioDev()->outputLatency();
+	if (device >= 0)
+	{
+		text += "\n" + tr("Reported by the device: %1 ms").arg(
+			1000.0f * device / mixer->audioDev()->sampleRate(), 0, 'f', 1);
+	}
+
+	if (success)
+	{
+		text += "\n" + tr("Measured round trip: %1 ms").arg(
+			mixer->latencyProbe().measuredLatency(), 0, 'f', 1);
+	}
+	else if (mixer->latencyProbe().isRunning() == false &&
+			sender() == &mixer->latencyProbe())
+	{
+		text += "\n" + tr("No impulse came back from the input.");
+	}
+	else if (LatencyProbe::recordLatency() > 0)
+	{
+		text += "\n" + tr("Recordings are compensated by %1 ms").arg(
+			LatencyProbe::recordLatency(), 0, 'f', 1);
+	}
+	m_latencyLbl->setText(text);
+}
+
+
 // MIDI settings slots.
 
 void SetupDialog::midiInterfaceChanged(const QString & iface)
@@ -1223,6 +1719,18 @@ void SetupDialog::midiInterfaceChanged(const QString & iface)
 }
 
 
+void SetupDialog::toggleMidiClockOut(bool enabled)
+{
+	m_midiClockOut = enabled;
+}
+
+
+void SetupDialog::toggleMidiTimeCodeOut(bool enabled)
+{
+	m_midiTimeCodeOut = enabled;
+}
+
+
 // Paths settings slots.
 
 void SetupDialog::openWorkingDir()
@@ -1340,6 +1848,23 @@ void SetupDialog::setGIGDir(const QString & gigDir)
 }
 
 
+void SetupDialog::openRenderCacheDir()
+{
+	QString new_dir = FileDialog::getExistingDirectory(this,
+		tr("Choose the render cache directory"), m_renderCacheDir);
+	if(!new_dir.isEmpty())
+	{
+		m_renderCacheDirLineEdit->setText(new_dir);
+	}
+}
+
+
+void SetupDialog::setRenderCacheDir(const QString & renderCacheDir)
+{
+	m_renderCacheDir = renderCacheDir;
+}
+
+
 void SetupDialog::openThemeDir()
 {
 	QString new_dir = FileDialog::getExistingDirectory(this,
@@ -27,11 +27,14 @@
 #include <cmath>
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QLayout>
 #include <QMdiArea>
 #include <QScrollBar>
+#include <QTimer>
 #include <QWheelEvent>
 
+#include "AutomationSchedule.h"
 #include "TrackContainer.h"
 #include "BBTrack.h"
 #include "DataFile.h"
@@ -58,7 +61,8 @@ TrackContainerView::TrackContainerView( TrackContainer * _tc ) :
 	m_trackViews(),
 	m_scrollArea( new scrollArea( this ) ),
 	m_ppb( DEFAULT_PIXELS_PER_BAR ),
-	m_rubberBand( new RubberBand( m_scrollArea ) )
+	m_rubberBand( new RubberBand( m_scrollArea ) ),
+	m_realignQueued( false )
 {
 	m_tc->setHook( this );
 	//keeps the direction of the widget, undepended on the locale
@@ -85,7 +89,7 @@ TrackContainerView::TrackContainerView( TrackContainer * _tc ) :
 	connect( Engine::getSong(), SIGNAL( timeSignatureChanged( int, int ) ),
 						this, SLOT( realignTracks() ) );
 	connect( m_tc, SIGNAL( trackAdded( Track * ) ),
-			this, SLOT( createTrackView( Track * ) ),
+			this, SLOT( queueTrackView( Track * ) ),
 			Qt::QueuedConnection );
 }
 
@@ -128,7 +132,13 @@ TrackView * TrackContainerView::addTrackView( TrackView * _tv )
 	connect( this, SIGNAL( positionChanged( const TimePos & ) ),
 				_tv->getTrackContentWidget(),
 				SLOT( changePosition( const TimePos & ) ) );
-	realignTracks();
+
+	// once for all views added at a time, e.g. when loading a project
+	if( !m_realignQueued )
+	{
+		m_realignQueued = true;
+		QTimer::singleShot( 0, this, SLOT( realignAddedTracks() ) );
+	}
 	return( _tv );
 }
 
@@ -175,6 +185,7 @@ void TrackContainerView::moveTrackView( TrackView * trackView, int indexTo )
 
 	m_tc->m_tracks.remove( indexFrom );
 	m_tc->m_tracks.insert( indexTo, track );
+	AutomationSchedule::arrangementChanged();
 	m_trackViews.move( indexFrom, indexTo );
 
 	realignTracks();
@@ -244,6 +255,28 @@ void TrackContainerView::realignTracks()
 
 
 TrackView * TrackContainerView::createTrackView( Track * _t )
+{
+	// keep the views in the order of the tracks
+	while( !m_queuedTracks.isEmpty() )
+	{
+		QPointer<Track> track = m_queuedTracks.takeFirst();
+		if( track == _t )
+		{
+			break;
+		}
+		if( track )
+		{
+			createView( track );
+		}
+	}
+
+	return createView( _t );
+}
+
+
+
+
+TrackView * TrackContainerView::createView( Track * track )
 {
 	//m_tc->addJournalCheckPoint();
 
@@ -251,10 +284,55 @@ TrackView * TrackContainerView::createTrackView( Track * _t )
 	for( trackViewList::iterator it = m_trackViews.begin();
 						it != m_trackViews.end(); ++it )
 	{
-		if ( ( *it )->getTrack() == _t ) { return ( *it ); }
+		if ( ( *it )->getTrack() == track ) { return ( *it ); }
 	}
 
-	return _t->createView( this );
+	return track->createView( this );
+}
+
+
+
+
+void TrackContainerView::queueTrackView( Track * track )
+{
+	m_queuedTracks.push_back( track );
+	if( m_queuedTracks.size() == 1 )
+	{
+		QTimer::singleShot( 0, this, SLOT( createQueuedTrackViews() ) );
+	}
+}
+
+
+
+
+void TrackContainerView::createQueuedTrackViews()
+{
+	// The views of a large project are created in slices, so its first
+	// tracks show up and the song can be played before all are there
+	QElapsedTimer slice;
+	slice.start();
+	while( !m_queuedTracks.isEmpty() && slice.elapsed() < TrackViewSliceMs )
+	{
+		QPointer<Track> track = m_queuedTracks.takeFirst();
+		if( track )
+		{
+			createView( track );
+		}
+	}
+
+	if( !m_queuedTracks.isEmpty() )
+	{
+		QTimer::singleShot( 0, this, SLOT( createQueuedTrackViews() ) );
+	}
+}
+
+
+
+
+void TrackContainerView::realignAddedTracks()
+{
+	m_realignQueued = false;
+	realignTracks();
 }
 
 
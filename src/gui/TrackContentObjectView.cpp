@@ -254,6 +254,17 @@ bool TrackContentObjectView::needsUpdate()
 void TrackContentObjectView::setNeedsUpdate( bool b )
 { m_needsUpdate = b; }
 
+void TrackContentObjectView::fitPaintPixmap( QPixmap & pixmap ) const
+{
+	const qreal ratio = devicePixelRatioF();
+	if( pixmap.isNull() || pixmap.size() != size() * ratio ||
+		pixmap.devicePixelRatioF() != ratio )
+	{
+		pixmap = QPixmap( size() * ratio );
+		pixmap.setDevicePixelRatio( ratio );
+	}
+}
+
 /*! \brief Close a trackContentObjectView
  *
  *  Closes a track content object view by asking the track
@@ -324,7 +335,7 @@ void TrackContentObjectView::updateLength()
  */
 void TrackContentObjectView::updatePosition()
 {
-	m_trackView->getTrackContentWidget()->changePosition();
+	m_trackView->getTrackContentWidget()->updateTCOViewPosition( this );
 	// moving a TCO can result in change of song-length etc.,
 	// therefore we update the track-container
 	m_trackView->trackContainerView()->update();
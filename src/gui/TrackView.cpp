@@ -64,7 +64,8 @@ TrackView::TrackView( Track * track, TrackContainerView * tcv ) :
 	m_trackOperationsWidget( this ),    /*!< Our trackOperationsWidget */
 	m_trackSettingsWidget( this ),      /*!< Our trackSettingsWidget */
 	m_trackContentWidget( this ),       /*!< Our trackContentWidget */
-	m_action( NoAction )                /*!< The action we're currently performing */
+	m_action( NoAction ),               /*!< The action we're currently performing */
+	m_tcoViewsCreated( false )          /*!< Whether the TCOs have views yet */
 {
 	setAutoFillBackground( true );
 	QPalette pal;
@@ -108,13 +109,8 @@ TrackView::TrackView( Track * track, TrackContainerView * tcv ) :
 	connect( &m_trackOperationsWidget, SIGNAL( colorReset() ),
 			m_track, SLOT( trackColorReset() ) );
 
-	// create views for already existing TCOs
-	for( Track::tcoVector::iterator it =
-					m_track->m_trackContentObjects.begin();
-			it != m_track->m_trackContentObjects.end(); ++it )
-	{
-		createTCOView( *it );
-	}
+	// views for already existing TCOs are created in createTCOViews()
+	// once the track is shown
 
 	m_trackContainerView->addTrackView( this );
 }
@@ -171,6 +167,23 @@ void TrackView::update()
 
 
 
+void TrackView::createTCOViews()
+{
+	if( m_tcoViewsCreated )
+	{
+		return;
+	}
+	m_tcoViewsCreated = true;
+
+	for( TrackContentObject * tco : m_track->getTCOs() )
+	{
+		createTCOView( tco );
+	}
+}
+
+
+
+
 /*! \brief Create a menu for assigning/creating channels for this track.
  *
  */
@@ -431,6 +444,12 @@ void TrackView::paintEvent( QPaintEvent * pe )
  */
 void TrackView::createTCOView( TrackContentObject * tco )
 {
+	// TCOs added before the track was shown are created with the others
+	if( !m_tcoViewsCreated ||
+		m_trackContentWidget.hasTCOView( tco ) )
+	{
+		return;
+	}
 	TrackContentObjectView * tv = tco->createView( this );
 	if( tco->getSelectViewOnCreate() == true )
 	{
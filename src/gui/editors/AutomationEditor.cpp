@@ -28,6 +28,8 @@
 #include "AutomationEditor.h"
 
 #include <cmath>
+#include <limits>
+#include <vector>
 
 #include <QApplication>
 #include <QKeyEvent>
@@ -55,6 +57,7 @@
 #include "GuiApplication.h"
 #include "gui_templates.h"
 #include "MainWindow.h"
+#include "PerfLog.h"
 #include "PianoRoll.h"
 #include "ProjectJournal.h"
 #include "SongEditor.h"
@@ -99,6 +102,10 @@ AutomationEditor::AutomationEditor() :
 	m_mouseDownLeft(false),
 	m_mouseDownRight( false ),
 	m_scrollBack( false ),
+	m_curveKey{ nullptr, 0, 0, 0 },
+	m_curveRevision( 0 ),
+	m_curveDirtyFrom( 0 ),
+	m_curveDirtyTo( 0 ),
 	m_barLineColor(0, 0, 0),
 	m_beatLineColor(0, 0, 0),
 	m_lineColor(0, 0, 0),
@@ -756,6 +763,13 @@ void AutomationEditor::mouseMoveEvent(QMouseEvent * mouseEvent )
 						// If we moved the mouse past the beginning correct the position in ticks
 						posTicks = qMax(posTicks, 0);
 
+						// the node moves from the last tick to this one,
+						// both may be off its quantized position
+						const int quantization = AutomationPattern::quantization();
+						const int from = qMin<int>(m_drawLastTick, posTicks) - quantization;
+						const int to = qMax<int>(m_drawLastTick, posTicks) + quantization;
+						const bool curveUpToDate = invalidateCurve(from, to);
+
 						m_drawLastTick = posTicks;
 						m_drawLastLevel = level;
 
@@ -766,6 +780,7 @@ void AutomationEditor::mouseMoveEvent(QMouseEvent * mouseEvent )
 							true,
 							mouseEvent->modifiers() & Qt::ControlModifier
 						);
+						curveEdited(from, to, curveUpToDate);
 
 						Engine::getSong()->setModified();
 					}
@@ -842,7 +857,9 @@ void AutomationEditor::mouseMoveEvent(QMouseEvent * mouseEvent )
 						// Safety check
 						if (it != tm.end())
 						{
+							const bool curveUpToDate = invalidateCurve(POS(it), POS(it));
 							it.value().setOutValue(level);
+							curveEdited(POS(it), POS(it), curveUpToDate);
 							Engine::getSong()->setModified();
 						}
 					}
@@ -936,8 +953,177 @@ inline void AutomationEditor::drawAutomationPoint(QPainter & p, timeMap::iterato
 
 
 
+void AutomationEditor::updateCurve()
+{
+	const int position = m_currentPosition.getTicks();
+	const int columns = qMax( 0, width() - VALUES_WIDTH );
+	const CurveKey key = { m_pattern, position, m_ppb, columns };
+	if( !( key == m_curveKey ) ||
+		m_curveRevision != AutomationPattern::editRevision() )
+	{
+		m_curveKey = key;
+		m_curveRevision = AutomationPattern::editRevision();
+		m_curveMin.resize( columns );
+		m_curveMax.resize( columns );
+		m_curveDirtyFrom = 0;
+		m_curveDirtyTo = columns;
+	}
+
+	const timeMap & tm = m_pattern->getTimeMap();
+	const int firstNode = POS( tm.begin() );
+	const float ticksPerColumn =
+		static_cast<float>( TimePos::ticksPerBar() ) / m_ppb;
+
+	for( int c = m_curveDirtyFrom; c < m_curveDirtyTo; ++c )
+	{
+		const float begin = position + c * ticksPerColumn;
+		const float end = begin + ticksPerColumn;
+		if( end <= firstNode )
+		{
+			m_curveMin[c] = m_curveMax[c] =
+				std::numeric_limits<float>::quiet_NaN();
+			continue;
+		}
+
+		float lowest = std::numeric_limits<float>::max();
+		float highest = std::numeric_limits<float>::lowest();
+
+		// a few values of the baked curve...
+		const float from = qMax<float>( begin, firstNode );
+		const int samples = qBound( 1, static_cast<int>( std::ceil( end - from ) ), 4 );
+		const float step = ( end - from ) / samples;
+		for( int i = 0; i < samples; ++i )
+		{
+			const float t = from + i * step;
+			const int tick = static_cast<int>( t );
+			float value;
+			m_pattern->valuesAt( TimePos( tick ), t - tick, 1, &value, 1 );
+			lowest = qMin( lowest, value );
+			highest = qMax( highest, value );
+		}
+		// ...and the values of the nodes in the column, where the curve
+		// may jump
+		for( timeMap::const_iterator it =
+				tm.lowerBound( static_cast<int>( std::ceil( begin ) ) );
+			it != tm.end() && POS(it) < end; ++it )
+		{
+			lowest = qMin( lowest, qMin( INVAL(it), OUTVAL(it) ) );
+			highest = qMax( highest, qMax( INVAL(it), OUTVAL(it) ) );
+		}
+
+		m_curveMin[c] = lowest;
+		m_curveMax[c] = highest;
+	}
+	m_curveDirtyFrom = m_curveDirtyTo = 0;
+}
+
+
+
+
+void AutomationEditor::drawCurve( QPainter & p )
+{
+	// fill from the zero level to the values of each column, with one
+	// polygon for every run of columns after the first node
+	QPainterPath path;
+	const int columns = static_cast<int>( m_curveMax.size() );
+	int c = 0;
+	while( c < columns )
+	{
+		if( std::isnan( m_curveMax[c] ) )
+		{
+			++c;
+			continue;
+		}
+
+		const int first = c;
+		path.moveTo( VALUES_WIDTH + c, yCoordOfLevel( qMax( m_curveMax[c], 0.0f ) ) );
+		for( ; c < columns && !std::isnan( m_curveMax[c] ); ++c )
+		{
+			path.lineTo( VALUES_WIDTH + c + 0.5f,
+				yCoordOfLevel( qMax( m_curveMax[c], 0.0f ) ) );
+		}
+		path.lineTo( VALUES_WIDTH + c, yCoordOfLevel( qMax( m_curveMax[c - 1], 0.0f ) ) );
+		path.lineTo( VALUES_WIDTH + c, yCoordOfLevel( qMin( m_curveMin[c - 1], 0.0f ) ) );
+		for( int back = c - 1; back >= first; --back )
+		{
+			path.lineTo( VALUES_WIDTH + back + 0.5f,
+				yCoordOfLevel( qMin( m_curveMin[back], 0.0f ) ) );
+		}
+		path.lineTo( VALUES_WIDTH + first, yCoordOfLevel( qMin( m_curveMin[first], 0.0f ) ) );
+		path.closeSubpath();
+	}
+
+	p.setRenderHints( QPainter::Antialiasing, true );
+	p.fillPath( path, m_graphColor );
+	p.setRenderHints( QPainter::Antialiasing, false );
+}
+
+
+
+
+bool AutomationEditor::invalidateCurve( int fromTick, int toTick )
+{
+	const bool upToDate =
+		m_curveRevision == AutomationPattern::editRevision();
+
+	// the tangents of the two nodes on either side change as well, and
+	// after the last node the curve stays at its value
+	const timeMap & tm = m_pattern->getTimeMap();
+	timeMap::const_iterator it = tm.lowerBound( fromTick );
+	for( int i = 0; i < 2 && it != tm.begin(); ++i )
+	{
+		--it;
+	}
+	if( it != tm.end() )
+	{
+		fromTick = qMin( fromTick, POS(it) );
+	}
+	it = tm.upperBound( toTick );
+	for( int i = 0; i < 2 && it != tm.end(); ++i )
+	{
+		++it;
+	}
+	const int columns = static_cast<int>( m_curveMax.size() );
+	const int position = m_currentPosition.getTicks();
+	const float columnsPerTick =
+		static_cast<float>( m_ppb ) / TimePos::ticksPerBar();
+	const int from = qBound( 0, static_cast<int>( std::floor(
+			( fromTick - position ) * columnsPerTick ) ), columns );
+	const int to = it == tm.end() ? columns : qBound( 0, static_cast<int>( std::ceil(
+			( POS(it) - position ) * columnsPerTick ) ) + 1, columns );
+
+	if( m_curveDirtyFrom >= m_curveDirtyTo )
+	{
+		m_curveDirtyFrom = from;
+		m_curveDirtyTo = to;
+	}
+	else
+	{
+		m_curveDirtyFrom = qMin( m_curveDirtyFrom, from );
+		m_curveDirtyTo = qMax( m_curveDirtyTo, to );
+	}
+	return upToDate;
+}
+
+
+
+
+void AutomationEditor::curveEdited( int fromTick, int toTick, bool upToDate )
+{
+	// the nodes may have moved the range of changed columns
+	invalidateCurve( fromTick, toTick );
+	if( upToDate )
+	{
+		m_curveRevision = AutomationPattern::editRevision();
+	}
+}
+
+
+
+
 void AutomationEditor::paintEvent(QPaintEvent * pe )
 {
+	PerfTrace::Scope trace( "AutomationEditor::paintEvent", PerfTrace::Gui );
 	QStyleOption opt;
 	opt.initFrom( this );
 	QPainter p( this );
@@ -1145,74 +1331,26 @@ void AutomationEditor::paintEvent(QPaintEvent * pe )
 		//Don't bother doing/rendering anything if there is no automation points
 		if( time_map.size() > 0 )
 		{
-			timeMap::iterator it = time_map.begin();
-			while( it+1 != time_map.end() )
+			updateCurve();
+			drawCurve( p );
+
+			// nodes closer than a pixel would only be drawn over each other
+			const int margin = 5 * TimePos::ticksPerBar() / m_ppb;
+			int lastX = std::numeric_limits<int>::min();
+			for( timeMap::iterator it = time_map.lowerBound( m_currentPosition.getTicks() - margin );
+				it != time_map.end(); ++it )
 			{
-				// skip this section if it occurs completely before the
-				// visible area
-				int next_x = xCoordOfTick(POS(it+1));
-				if( next_x < 0 )
-				{
-					++it;
-					continue;
-				}
-
-				int x = xCoordOfTick(POS(it));
-				if( x > width() )
+				const int x = xCoordOfTick( POS(it) );
+				if( x > width() + 5 )
 				{
 					break;
 				}
-
-				float *values = m_pattern->valuesAfter(POS(it));
-
-				// We are creating a path to draw a polygon representing the values between two
-				// nodes. When we have two nodes with discrete progression, we will basically have
-				// a rectangle with the outValue of the first node (that's why nextValue will match
-				// the outValue of the current node). When we have nodes with linear or cubic progression
-				// the value of the end of the shape between the two nodes will be the inValue of
-				// the next node.
-				float nextValue;
-				if( m_pattern->progressionType() == AutomationPattern::DiscreteProgression )
-				{
-					nextValue = OUTVAL(it);
-				}
-				else
-				{
-					nextValue = INVAL(it + 1);
-				}
-
-				p.setRenderHints( QPainter::Antialiasing, true );
-				QPainterPath path;
-				path.moveTo(QPointF(xCoordOfTick(POS(it)), yCoordOfLevel(0)));
-				for (int i = 0; i < POS(it + 1) - POS(it); i++)
+				if( x != lastX )
 				{
-					path.lineTo(QPointF(xCoordOfTick(POS(it) + i), yCoordOfLevel(values[i])));
+					drawAutomationPoint( p, it );
+					lastX = x;
 				}
-				path.lineTo(QPointF(xCoordOfTick(POS(it + 1)), yCoordOfLevel(nextValue)));
-				path.lineTo(QPointF(xCoordOfTick(POS(it + 1)), yCoordOfLevel(0)));
-				path.lineTo(QPointF(xCoordOfTick(POS(it)), yCoordOfLevel(0)));
-				p.fillPath(path, m_graphColor);
-				p.setRenderHints( QPainter::Antialiasing, false );
-				delete [] values;
-
-				// Draw circle
-				drawAutomationPoint(p, it);
-
-				++it;
-			}
-
-			for (
-				int i = POS(it), x = xCoordOfTick(i);
-				x <= width();
-				i++, x = xCoordOfTick(i)
-			)
-			{
-				// Draws the rectangle representing the value after the last node (for
-				// that reason we use outValue).
-				drawLevelTick(p, i, OUTVAL(it));
 			}
-			// Draw circle(the last one)
-			drawAutomationPoint(p, it);
 		}
 	}
 	else
@@ -1303,48 +1441,6 @@ float AutomationEditor::yCoordOfLevel(float level )
 
 
 
-void AutomationEditor::drawLevelTick(QPainter & p, int tick, float value)
-{
-	int grid_bottom = height() - SCROLLBAR_SIZE - 1;
-	const int x = xCoordOfTick( tick );
-	int rect_width = xCoordOfTick( tick+1 ) - x;
-
-	// is the level in visible area?
-	if( ( value >= m_bottomLevel && value <= m_topLevel )
-			|| ( value > m_topLevel && m_topLevel >= 0 )
-			|| ( value < m_bottomLevel && m_bottomLevel <= 0 ) )
-	{
-		int y_start = yCoordOfLevel( value );
-		int rect_height;
-
-		if( m_y_auto )
-		{
-			int y_end = (int)( grid_bottom
-						+ ( grid_bottom - TOP_MARGIN )
-						* m_minLevel
-						/ ( m_maxLevel - m_minLevel ) );
-
-			rect_height = y_end - y_start;
-		}
-		else
-		{
-			rect_height = (int)( value * m_y_delta );
-		}
-
-		QBrush currentColor = m_graphColor;
-
-		p.fillRect( x, y_start, rect_width, rect_height, currentColor );
-	}
-#ifdef LMMS_DEBUG
-	else
-	{
-		printf("not in range\n");
-	}
-#endif
-}
-
-
-
 
 // Center the vertical scroll position on the first object's inValue
 void AutomationEditor::centerTopBottomScroll()
@@ -45,6 +45,7 @@
 #define __USE_XOPEN
 #endif
 
+#include <algorithm>
 #include <math.h>
 #include <utility>
 
@@ -64,6 +65,7 @@
 #include "InstrumentTrack.h"
 #include "MainWindow.h"
 #include "Pattern.h"
+#include "PerfLog.h"
 #include "SongEditor.h"
 #include "StepRecorderWidget.h"
 #include "TextFloat.h"
@@ -178,6 +180,14 @@ PianoRoll::PianoRoll() :
 	m_whiteKeySmallHeight(qFloor(m_keyLineHeight * 1.5)),
 	m_whiteKeyBigHeight(m_keyLineHeight * 2),
 	m_blackKeyHeight(m_keyLineHeight),
+	m_gridCacheKey(),
+	m_gridCacheUsage( tr( "Piano roll grid" ), [this]() -> qint64
+		{
+			return static_cast<qint64>( m_gridCache.width() ) *
+				m_gridCache.height() * m_gridCache.depth() / 8;
+		} ),
+	m_notesSorted( false ),
+	m_longestNote( 0 ),
 	m_lenOfNewNotes( TimePos( 0, DefaultTicksPerBar/4 ) ),
 	m_lastNoteVolume( DefaultVolume ),
 	m_lastNotePanning( DefaultPanning ),
@@ -302,6 +312,10 @@ PianoRoll::PianoRoll() :
 	// white position line follows timeline marker
 	m_positionLine = new PositionLine(this);
 
+	// take the notes played on the track, as many as came in at once
+	connect( gui->mainWindow(), SIGNAL( periodicUpdate() ),
+			this, SLOT( recordNotes() ) );
+
 	//update timeline when in step-recording mode
 	connect( &m_stepRecorderWidget, SIGNAL( positionChanged( const TimePos & ) ),
 			this, SLOT( updatePositionStepRecording( const TimePos & ) ) );
@@ -841,6 +855,7 @@ void PianoRoll::setCurrentPattern( Pattern* newPattern )
 	if( hasValidPattern() )
 	{
 		m_pattern->instrumentTrack()->disconnect( this );
+		m_pattern->instrumentTrack()->setRecordingNotes( false );
 	}
 
 	// force the song-editor to stop playing if it played pattern before
@@ -857,6 +872,7 @@ void PianoRoll::setCurrentPattern( Pattern* newPattern )
 
 	// set new data
 	m_pattern = newPattern;
+	m_notesSorted = false;
 	m_currentPosition = 0;
 	m_currentNote = NULL;
 	m_startKey = INITIAL_START_KEY;
@@ -899,9 +915,8 @@ void PianoRoll::setCurrentPattern( Pattern* newPattern )
 	// make sure to always get informed about the pattern being destroyed
 	connect( m_pattern, SIGNAL( destroyedPattern( Pattern* ) ), this, SLOT( hidePattern( Pattern* ) ) );
 
-	connect( m_pattern->instrumentTrack(), SIGNAL( midiNoteOn( const Note& ) ), this, SLOT( startRecordNote( const Note& ) ) );
-	connect( m_pattern->instrumentTrack(), SIGNAL( midiNoteOff( const Note& ) ), this, SLOT( finishRecordNote( const Note& ) ) );
-	connect( m_pattern->instrumentTrack()->pianoModel(), SIGNAL( dataChanged() ), this, SLOT( update() ) );
+	m_pattern->instrumentTrack()->setRecordingNotes( true );
+	connect( m_pattern->instrumentTrack()->pianoModel(), SIGNAL( dataChanged() ), this, SLOT( updateKeys() ) );
 
 	connect(m_pattern->instrumentTrack()->firstKeyModel(), SIGNAL(dataChanged()), this, SLOT(update()));
 	connect(m_pattern->instrumentTrack()->lastKeyModel(), SIGNAL(dataChanged()), this, SLOT(update()));
@@ -2992,6 +3007,7 @@ void PianoRoll::dragNotes(int x, int y, bool alt, bool shift, bool ctrl)
 
 void PianoRoll::paintEvent(QPaintEvent * pe )
 {
+	PerfTrace::Scope trace( "PianoRoll::paintEvent", PerfTrace::Gui );
 	bool drawNoteNames = ConfigManager::inst()->value( "ui", "printnotelabels").toInt();
 
 	QStyleOption opt;
@@ -3001,9 +3017,6 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 
 	QBrush bgColor = p.background();
 
-	// fill with bg color
-	p.fillRect( 0, 0, width(), height(), bgColor );
-
 	// set font-size to 80% of key line height
 	QFont f = p.font();
 	f.setPixelSize(m_keyLineHeight * 0.8);
@@ -3075,7 +3088,7 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 			// otherwise we add height
 			else { m_notesEditHeight += partialKeyVisible; }
 		}
-		int x, q = quantization(), tick;
+		int q = quantization();
 
 		// draw vertical quantization lines
 		// If we're over 100% zoom, we allow all quantization level grids
@@ -3092,19 +3105,6 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 				(tick - m_currentPosition) * m_ppb / TimePos::ticksPerBar()
 			);
 		};
-		p.setPen(m_lineColor);
-		for (tick = m_currentPosition - m_currentPosition % q,
-			x = xCoordOfTick(tick);
-			x <= width();
-			tick += q, x = xCoordOfTick(tick))
-		{
-			p.drawLine(x, keyAreaTop(), x, noteEditBottom());
-		}
-
-		// draw horizontal grid lines and piano notes
-		p.setClipRect(0, keyAreaTop(), width(), keyAreaBottom() - keyAreaTop());
-		// the first grid line from the top Y position
-		int grid_line_y = keyAreaTop() + m_keyLineHeight - 1;
 
 		// lambda function for returning the height of a key
 		auto keyHeight = [&](
@@ -3220,110 +3220,164 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 		};
 		// lambda for drawing the horizontal grid line
 		auto drawHorizontalLine = [&](
+			QPainter & g,
 			const int key,
 			const int y
 		)
 		{
-			if (key % KeysPerOctave == Key_C) { p.setPen(m_beatLineColor); }
-			else { p.setPen(m_lineColor); }
-			p.drawLine(m_whiteKeyWidth, y, width(), y);
+			if (key % KeysPerOctave == Key_C) { g.setPen(m_beatLineColor); }
+			else { g.setPen(m_lineColor); }
+			g.drawLine(m_whiteKeyWidth, y, width(), y);
 		};
-		// correct y offset of the top key
-		switch (prKeyOrder[topNote])
+		// lambda calling f(key, y) for the visible keys from the top, with
+		// the black keys after the white keys below them
+		auto forEachKey = [&](auto f)
 		{
-		case PR_WHITE_KEY_SMALL:
-		case PR_WHITE_KEY_BIG:
-			break;
-		case PR_BLACK_KEY:
-			// draw extra white key
-			drawKey(topKey + 1, grid_line_y - m_keyLineHeight);
-		}
-		// loop through visible keys
-		const int lastKey = qMax(0, topKey - m_pianoKeysVisible);
-		for (int key = topKey; key > lastKey; --key)
+			// the first grid line from the top Y position
+			int grid_line_y = keyAreaTop() + m_keyLineHeight - 1;
+			const int lastKey = qMax(0, topKey - m_pianoKeysVisible);
+			for (int key = topKey; key > lastKey; --key)
+			{
+				bool whiteKey = Piano::isWhiteKey(key);
+				if (whiteKey)
+				{
+					f(key, grid_line_y);
+					grid_line_y += m_keyLineHeight;
+				}
+				else
+				{
+					// next white key
+					f(key - 1, grid_line_y + m_keyLineHeight);
+					// black key over previous and next white key
+					f(key, grid_line_y);
+					// two keys so skip ahead properly
+					grid_line_y += m_keyLineHeight + m_keyLineHeight;
+					// capture double key
+					--key;
+				}
+			}
+		};
+
+		Song * song = Engine::getSong();
+		GridCacheKey gridKey;
+		gridKey.size = size();
+		gridKey.pixelRatio = devicePixelRatioF();
+		gridKey.position = m_currentPosition;
+		gridKey.ppb = m_ppb;
+		gridKey.topKey = topKey;
+		gridKey.keyLineHeight = m_keyLineHeight;
+		gridKey.keysVisible = m_pianoKeysVisible;
+		gridKey.notesEditHeight = m_notesEditHeight;
+		gridKey.quantization = q;
+		gridKey.timeSigNumerator = song->getTimeSigModel().getNumerator();
+		gridKey.timeSigDenominator = song->getTimeSigModel().getDenominator();
+		gridKey.markedSemiTones = m_markedSemiTones;
+		gridKey.colors = { bgColor.color().rgba(), m_lineColor.rgba(),
+			m_beatLineColor.rgba(), m_barLineColor.rgba(),
+			m_backgroundShade.rgba(), m_markedSemitoneColor.rgba() };
+
+		if (!(gridKey == m_gridCacheKey))
 		{
-			bool whiteKey = Piano::isWhiteKey(key);
-			if (whiteKey)
+			m_gridCacheKey = gridKey;
+			m_gridCache = QPixmap(size() * gridKey.pixelRatio);
+			m_gridCache.setDevicePixelRatio(gridKey.pixelRatio);
+			QPainter g(&m_gridCache);
+			g.fillRect(0, 0, width(), height(), bgColor);
+
+			int x, tick;
+			g.setPen(m_lineColor);
+			for (tick = m_currentPosition - m_currentPosition % q,
+				x = xCoordOfTick(tick);
+				x <= width();
+				tick += q, x = xCoordOfTick(tick))
 			{
-				drawKey(key, grid_line_y);
-				drawHorizontalLine(key, grid_line_y);
-				grid_line_y += m_keyLineHeight;
+				g.drawLine(x, keyAreaTop(), x, noteEditBottom());
 			}
-			else
+
+			// draw horizontal grid lines
+			g.setClipRect(0, keyAreaTop(), width(), keyAreaBottom() - keyAreaTop());
+			forEachKey([&](int key, int y) { drawHorizontalLine(g, key, y); });
+
+			// don't draw over keys
+			g.setClipRect(m_whiteKeyWidth, keyAreaTop(), width(), noteEditBottom() - keyAreaTop());
+
+			// draw alternating shading on bars
+			float timeSignature =
+				static_cast<float>(gridKey.timeSigNumerator) /
+				static_cast<float>(gridKey.timeSigDenominator);
+			float zoomFactor = m_zoomLevels[m_zoomingModel.value()];
+			//the bars which disappears at the left side by scrolling
+			int leftBars = m_currentPosition * zoomFactor / TimePos::ticksPerBar();
+			//iterates the visible bars and draw the shading on uneven bars
+			for (int x = m_whiteKeyWidth, barCount = leftBars;
+				x < width() + m_currentPosition * zoomFactor / timeSignature;
+				x += m_ppb, ++barCount)
 			{
-				// draw next white key
-				drawKey(key - 1, grid_line_y + m_keyLineHeight);
-				drawHorizontalLine(key - 1, grid_line_y + m_keyLineHeight);
-				// draw black key over previous and next white key
-				drawKey(key, grid_line_y);
-				drawHorizontalLine(key, grid_line_y);
-				// drew two grid keys so skip ahead properly
-				grid_line_y += m_keyLineHeight + m_keyLineHeight;
-				// capture double key draw
-				--key;
+				if ((barCount + leftBars) % 2 != 0)
+				{
+					g.fillRect(x - m_currentPosition * zoomFactor / timeSignature,
+						PR_TOP_MARGIN,
+						m_ppb,
+						height() - (PR_BOTTOM_MARGIN + PR_TOP_MARGIN),
+						m_backgroundShade);
+				}
 			}
-		}
 
-		// don't draw over keys
-		p.setClipRect(m_whiteKeyWidth, keyAreaTop(), width(), noteEditBottom() - keyAreaTop());
-
-		// draw alternating shading on bars
-		float timeSignature =
-			static_cast<float>(Engine::getSong()->getTimeSigModel().getNumerator()) /
-			static_cast<float>(Engine::getSong()->getTimeSigModel().getDenominator());
-		float zoomFactor = m_zoomLevels[m_zoomingModel.value()];
-		//the bars which disappears at the left side by scrolling
-		int leftBars = m_currentPosition * zoomFactor / TimePos::ticksPerBar();
-		//iterates the visible bars and draw the shading on uneven bars
-		for (int x = m_whiteKeyWidth, barCount = leftBars;
-			x < width() + m_currentPosition * zoomFactor / timeSignature;
-			x += m_ppb, ++barCount)
-		{
-			if ((barCount + leftBars) % 2 != 0)
+			// draw vertical beat lines
+			int ticksPerBeat = DefaultTicksPerBar / gridKey.timeSigDenominator;
+			g.setPen(m_beatLineColor);
+			for(tick = m_currentPosition - m_currentPosition % ticksPerBeat,
+				x = xCoordOfTick( tick );
+				x <= width();
+				tick += ticksPerBeat, x = xCoordOfTick(tick))
 			{
-				p.fillRect(x - m_currentPosition * zoomFactor / timeSignature,
-					PR_TOP_MARGIN,
-					m_ppb,
-					height() - (PR_BOTTOM_MARGIN + PR_TOP_MARGIN),
-					m_backgroundShade);
+				g.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
 			}
-		}
 
-		// draw vertical beat lines
-		int ticksPerBeat = DefaultTicksPerBar /
-			Engine::getSong()->getTimeSigModel().getDenominator();
-		p.setPen(m_beatLineColor);
-		for(tick = m_currentPosition - m_currentPosition % ticksPerBeat,
-			x = xCoordOfTick( tick );
-			x <= width();
-			tick += ticksPerBeat, x = xCoordOfTick(tick))
-		{
-			p.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
-		}
+			// draw vertical bar lines
+			g.setPen(m_barLineColor);
+			for(tick = m_currentPosition - m_currentPosition % TimePos::ticksPerBar(),
+				x = xCoordOfTick( tick );
+				x <= width();
+				tick += TimePos::ticksPerBar(), x = xCoordOfTick(tick))
+			{
+				g.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
+			}
 
-		// draw vertical bar lines
-		p.setPen(m_barLineColor);
-		for(tick = m_currentPosition - m_currentPosition % TimePos::ticksPerBar(),
-			x = xCoordOfTick( tick );
-			x <= width();
-			tick += TimePos::ticksPerBar(), x = xCoordOfTick(tick))
-		{
-			p.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
+			// draw marked semitones after the grid
+			for(x = 0; x < m_markedSemiTones.size(); ++x)
+			{
+				const int key_num = m_markedSemiTones.at(x);
+				const int y = keyAreaBottom() + 5 - m_keyLineHeight *
+					(key_num - m_startKey + 1);
+				if(y > keyAreaBottom()) { break; }
+				g.fillRect(m_whiteKeyWidth + 1,
+					y - m_keyLineHeight / 2,
+					width() - 10,
+					m_keyLineHeight + 1,
+					m_markedSemitoneColor);
+			}
 		}
+		p.drawPixmap(0, 0, m_gridCache);
 
-		// draw marked semitones after the grid
-		for(x = 0; x < m_markedSemiTones.size(); ++x)
+		// draw piano keys
+		p.setClipRect(0, keyAreaTop(), width(), keyAreaBottom() - keyAreaTop());
+		// correct y offset of the top key
+		switch (prKeyOrder[topNote])
 		{
-			const int key_num = m_markedSemiTones.at(x);
-			const int y = keyAreaBottom() + 5 - m_keyLineHeight *
-				(key_num - m_startKey + 1);
-			if(y > keyAreaBottom()) { break; }
-			p.fillRect(m_whiteKeyWidth + 1,
-				y - m_keyLineHeight / 2,
-				width() - 10,
-				m_keyLineHeight + 1,
-				m_markedSemitoneColor);
+		case PR_WHITE_KEY_SMALL:
+		case PR_WHITE_KEY_BIG:
+			break;
+		case PR_BLACK_KEY:
+			// draw extra white key
+			drawKey(topKey + 1, keyAreaTop() - 1);
 		}
+		forEachKey(drawKey);
+	}
+	else
+	{
+		// fill with bg color
+		p.fillRect( 0, 0, width(), height(), bgColor );
 	}
 
 	// reset clip
@@ -3432,8 +3486,24 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 		}
 		// -- End ghost pattern
 
-		for( const Note *note : m_pattern->notes() )
+		// only the notes in the exposed area are drawn, e.g. none when
+		// a key is pressed, or those around the playhead when it moves.
+		// The edit handles reach a little beyond their notes.
+		const QRect exposed = pe->rect().adjusted( -NOTE_EDIT_LINE_WIDTH - 2, 0,
+						NOTE_EDIT_LINE_WIDTH + 2, 0 );
+		const int exposedFrom = m_currentPosition + ( exposed.left() - m_whiteKeyWidth ) *
+						TimePos::ticksPerBar() / m_ppb - 1;
+		const int exposedTo = m_currentPosition + ( exposed.right() - m_whiteKeyWidth ) *
+						TimePos::ticksPerBar() / m_ppb + 1;
+		if( exposed.contains( rect() ) )
 		{
+			updateNoteIndex();
+		}
+		const auto visibleNotes = notesInRange( exposedFrom, exposedTo );
+
+		for( auto it = visibleNotes.first; it != visibleNotes.second; ++it )
+		{
+			const Note * note = *it;
 			int len_ticks = note->length();
 
 			if( len_ticks == 0 )
@@ -3446,6 +3516,10 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 			}
 
 			int pos_ticks = note->pos();
+			if( pos_ticks > exposedTo || pos_ticks + len_ticks < exposedFrom )
+			{
+				continue;
+			}
 
 			int note_width = len_ticks * m_ppb / TimePos::ticksPerBar();
 			const int x = ( pos_ticks - m_currentPosition ) *
@@ -3687,6 +3761,68 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 
 
 
+bool PianoRoll::GridCacheKey::operator==( const GridCacheKey & other ) const
+{
+	return size == other.size && pixelRatio == other.pixelRatio &&
+		position == other.position && ppb == other.ppb &&
+		topKey == other.topKey && keyLineHeight == other.keyLineHeight &&
+		keysVisible == other.keysVisible &&
+		notesEditHeight == other.notesEditHeight &&
+		quantization == other.quantization &&
+		timeSigNumerator == other.timeSigNumerator &&
+		timeSigDenominator == other.timeSigDenominator &&
+		markedSemiTones == other.markedSemiTones && colors == other.colors;
+}
+
+
+
+
+void PianoRoll::updateNoteIndex()
+{
+	m_notesSorted = true;
+	m_longestNote = 0;
+	const Note * previous = nullptr;
+	for( const Note * note : m_pattern->notes() )
+	{
+		// notes without a length are drawn 4 ticks long
+		m_longestNote = qMax<int>( m_longestNote, qMax<int>( note->length(), 4 ) );
+		if( previous && note->pos() < previous->pos() )
+		{
+			m_notesSorted = false;
+		}
+		previous = note;
+	}
+}
+
+
+
+
+std::pair<NoteVector::ConstIterator, NoteVector::ConstIterator>
+	PianoRoll::notesInRange( int from, int to ) const
+{
+	const NoteVector & notes = m_pattern->notes();
+	// notes being moved or resized are out of order until the edit is done
+	if( !m_notesSorted || m_action != ActionNone )
+	{
+		return { notes.cbegin(), notes.cend() };
+	}
+	const auto before = []( const Note * note, int tick )
+	{
+		return note->pos() < tick;
+	};
+	const auto after = []( int tick, const Note * note )
+	{
+		return tick < note->pos();
+	};
+	// no note starting earlier reaches into the range
+	return { std::lower_bound( notes.cbegin(), notes.cend(),
+					from - m_longestNote, before ),
+		std::upper_bound( notes.cbegin(), notes.cend(), to, after ) };
+}
+
+
+
+
 void PianoRoll::updateScrollbars()
 {
 	m_leftRightScroll->setGeometry(
@@ -4047,70 +4183,79 @@ void PianoRoll::stop()
 
 
 
-void PianoRoll::startRecordNote(const Note & n )
+void PianoRoll::recordNotes()
 {
-	if(hasValidPattern())
+	if( !hasValidPattern() )
 	{
-		if( m_recording &&
-			Engine::getSong()->isPlaying() &&
-			(Engine::getSong()->playMode() == desiredPlayModeForAccompany() ||
-			Engine::getSong()->playMode() == Song::Mode_PlayPattern ))
-		{
-			TimePos sub;
-			if( Engine::getSong()->playMode() == Song::Mode_PlaySong )
-			{
-				sub = m_pattern->startPosition();
-			}
-			Note n1( 1, Engine::getSong()->getPlayPos(
-						Engine::getSong()->playMode() ) - sub,
-					n.key(), n.getVolume(), n.getPanning() );
-			if( n1.pos() >= 0 )
-			{
-				m_recordingNotes << n1;
-			}
-		}
-		else if (m_stepRecorder.isRecording())
-		{
-			m_stepRecorder.notePressed(n);
-		}
+		return;
+	}
+	const QVector<InstrumentTrack::RecordedNote> notes =
+				m_pattern->instrumentTrack()->takeRecordedNotes();
+	if( notes.isEmpty() )
+	{
+		return;
 	}
-}
-
-
 
+	const Song * song = Engine::getSong();
+	const bool accompany = m_recording &&
+			( song->playMode() == desiredPlayModeForAccompany() ||
+				song->playMode() == Song::Mode_PlayPattern );
+	TimePos sub;
+	if( song->playMode() == Song::Mode_PlaySong )
+	{
+		sub = m_pattern->startPosition();
+	}
 
-void PianoRoll::finishRecordNote(const Note & n )
-{
-	if(hasValidPattern())
-	{
-		if( m_recording &&
-			Engine::getSong()->isPlaying() &&
-				( Engine::getSong()->playMode() ==
-						desiredPlayModeForAccompany() ||
-					Engine::getSong()->playMode() ==
-						Song::Mode_PlayPattern ) )
+	// the finished notes are added at once, which locks the track once
+	QVector<Note> finished;
+	for( const InstrumentTrack::RecordedNote & n : notes )
+	{
+		if( accompany && n.playing )
 		{
+			if( n.pressed )
+			{
+				Note n1( 1, n.position - sub, n.key, n.volume, n.panning );
+				if( n1.pos() >= 0 )
+				{
+					m_recordingNotes << n1;
+				}
+				continue;
+			}
 			for( QList<Note>::Iterator it = m_recordingNotes.begin();
 						it != m_recordingNotes.end(); ++it )
 			{
-				if( it->key() == n.key() )
+				if( it->key() == n.key )
 				{
-					Note n1( n.length(), it->pos(),
+					Note n1( n.length, it->pos(),
 							it->key(), it->getVolume(),
 							it->getPanning() );
 					n1.quantizeLength( quantization() );
-					m_pattern->addNote( n1 );
-					update();
+					n1.quantizePos( quantization() );
+					finished << n1;
 					m_recordingNotes.erase( it );
 					break;
 				}
 			}
 		}
-		else if (m_stepRecorder.isRecording())
+		else if( m_stepRecorder.isRecording() )
 		{
-			m_stepRecorder.noteReleased(n);
+			const Note n1( n.length, 0, n.key, n.volume, n.panning );
+			if( n.pressed )
+			{
+				m_stepRecorder.notePressed( n1 );
+			}
+			else
+			{
+				m_stepRecorder.noteReleased( n1 );
+			}
 		}
 	}
+
+	if( !finished.isEmpty() )
+	{
+		m_pattern->addNotes( finished );
+		update();
+	}
 }
 
 
@@ -4480,6 +4625,15 @@ void PianoRoll::updatePosition( const TimePos & t )
 }
 
 
+void PianoRoll::updateKeys()
+{
+	// pressed keys don't change anything else
+	update( 0, keyAreaTop(), m_whiteKeyWidth, keyAreaBottom() - keyAreaTop() );
+}
+
+
+
+
 void PianoRoll::updatePositionLineHeight()
 {
 	m_positionLine->setFixedHeight(keyAreaBottom() - keyAreaTop());
@@ -847,6 +847,14 @@ void SongEditor::zoomingChanged()
 
 void SongEditor::selectAllTcos( bool select )
 {
+	// TCOs of tracks which weren't shown yet have no views to select
+	if( select )
+	{
+		for( TrackView * tv : trackViews() )
+		{
+			tv->createTCOViews();
+		}
+	}
 	QVector<selectableObject *> so = select ? rubberBand()->selectableObjects() : rubberBand()->selectedObjects();
 	for( int i = 0; i < so.count(); ++i )
 	{
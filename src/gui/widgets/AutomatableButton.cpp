@@ -245,8 +245,6 @@ void automatableButtonGroup::activateButton( AutomatableButton * _btn )
 
 void automatableButtonGroup::modelChanged()
 {
-	connect( model(), SIGNAL( dataChanged() ),
-			this, SLOT( updateButtons() ) );
 	IntModelView::modelChanged();
 	updateButtons();
 }
@@ -254,6 +252,15 @@ void automatableButtonGroup::modelChanged()
 
 
 
+void automatableButtonGroup::modelDataChanged()
+{
+	updateButtons();
+	IntModelView::modelDataChanged();
+}
+
+
+
+
 void automatableButtonGroup::updateButtons()
 {
 	model()->setRange( 0, m_buttons.size() - 1 );
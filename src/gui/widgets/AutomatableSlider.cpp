@@ -108,8 +108,15 @@ void AutomatableSlider::modelChanged()
 {
 	QSlider::setRange( model()->minValue(), model()->maxValue() );
 	updateSlider();
-	connect( model(), SIGNAL( dataChanged() ),
-				this, SLOT( updateSlider() ) );
+}
+
+
+
+
+void AutomatableSlider::modelDataChanged()
+{
+	updateSlider();
+	IntModelView::modelDataChanged();
 }
 
 
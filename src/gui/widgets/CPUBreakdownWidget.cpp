@@ -0,0 +1,477 @@
+/*
+ * CPUBreakdownWidget.cpp - widget showing where the CPU time is spent
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCheckBox>
+#include <QHeaderView>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "CPUBreakdownWidget.h"
+#include "AudioPort.h"
+#include "BBTrackContainer.h"
+#include "BufferManager.h"
+#include "CompressedFrames.h"
+#include "Effect.h"
+#include "embed.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "InstrumentTrack.h"
+#include "LocklessAllocator.h"
+#include "MemoryUsage.h"
+#include "Mixer.h"
+#include "NotePlayHandle.h"
+#include "RealtimeMemory.h"
+#include "RemotePlugin.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
+
+CPUBreakdownWidget::CPUBreakdownWidget( QWidget * _parent ) :
+	QWidget( _parent, Qt::Tool ),
+	m_tree( new QTreeWidget( this ) ),
+	m_denormalCheck( new QCheckBox( tr( "Count samples in denormal range" ), this ) ),
+	m_elapsedNs( 0 ),
+	m_updateTimer()
+{
+	setWindowTitle( tr( "CPU breakdown" ) );
+	setWindowIcon( embed::getIconPixmap( "cpuload_bg" ) );
+	resize( 320, 400 );
+
+	QVBoxLayout * layout = new QVBoxLayout( this );
+	layout->setMargin( 0 );
+	layout->addWidget( m_tree );
+	layout->addWidget( m_denormalCheck );
+
+	m_tree->setColumnCount( 3 );
+	m_tree->setHeaderLabels( QStringList() << tr( "Name" ) << tr( "CPU" )
+							<< tr( "Denormals" ) );
+	m_tree->setColumnHidden( 2, true );
+	m_tree->header()->setSectionResizeMode( 0, QHeaderView::Stretch );
+	m_tree->header()->setStretchLastSection( false );
+	m_tree->setRootIsDecorated( true );
+
+	m_stagesItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Stages" ) ) );
+	m_tracksItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Tracks" ) ) );
+	m_fxChannelsItem = new QTreeWidgetItem( m_tree, QStringList( tr( "FX channels" ) ) );
+	m_notePoolItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Note pool" ) ) );
+	m_bufferPoolItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Buffer pool" ) ) );
+	m_locklessItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Lockless lists" ) ) );
+	m_lockedMemoryItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Locked memory" ) ) );
+	m_sampleMemoryItem = new QTreeWidgetItem( m_tree,
+				QStringList( tr( "Compressed samples" ) ) );
+	m_memoryItem = new QTreeWidgetItem( m_tree, QStringList( tr( "Memory" ) ) );
+	m_stagesItem->setExpanded( true );
+
+	for( QTreeWidgetItem * pool : { m_notePoolItem, m_bufferPoolItem } )
+	{
+		for( const QString & name : { tr( "In use" ), tr( "Peak" ),
+						tr( "Preallocated" ), tr( "Overflows" ) } )
+		{
+			QTreeWidgetItem * item = new QTreeWidgetItem( pool );
+			item->setText( 0, name );
+			item->setTextAlignment( 1, Qt::AlignRight );
+		}
+	}
+	for( const QString & name : { tr( "In use" ), tr( "Capacity" ),
+					tr( "Segments added" ), tr( "Failures" ) } )
+	{
+		QTreeWidgetItem * item = new QTreeWidgetItem( m_locklessItem );
+		item->setText( 0, name );
+		item->setTextAlignment( 1, Qt::AlignRight );
+	}
+	for( const QString & name : { tr( "Locked" ), tr( "Prefaulted" ),
+					tr( "In use" ), tr( "Huge pages" ), tr( "Limit" ),
+					tr( "Overflows" ) } )
+	{
+		QTreeWidgetItem * item = new QTreeWidgetItem( m_lockedMemoryItem );
+		item->setText( 0, name );
+		item->setTextAlignment( 1, Qt::AlignRight );
+	}
+	m_lockedMemoryItem->setTextAlignment( 1, Qt::AlignRight );
+	for( const QString & name : { tr( "Samples" ), tr( "Uncompressed" ),
+					tr( "Compressed" ), tr( "Decompressed blocks" ),
+					tr( "Saved" ) } )
+	{
+		QTreeWidgetItem * item = new QTreeWidgetItem( m_sampleMemoryItem );
+		item->setText( 0, name );
+		item->setTextAlignment( 1, Qt::AlignRight );
+	}
+	// in the order of MemoryUsage::Subsystems
+	for( const QString & name : { tr( "Samples" ), tr( "Instruments" ),
+					tr( "Effects" ), tr( "Undo history" ),
+					tr( "GUI caches" ) } )
+	{
+		QTreeWidgetItem * item = new QTreeWidgetItem( m_memoryItem );
+		item->setText( 0, name );
+		item->setTextAlignment( 1, Qt::AlignRight );
+	}
+	m_memoryItem->setTextAlignment( 1, Qt::AlignRight );
+
+	connect( &m_updateTimer, SIGNAL( timeout() ),
+					this, SLOT( updateBreakdown() ) );
+	connect( m_denormalCheck, SIGNAL( toggled( bool ) ),
+				this, SLOT( setDenormalCheckEnabled( bool ) ) );
+}
+
+
+
+
+CPUBreakdownWidget::~CPUBreakdownWidget()
+{
+	MixerProfiler::setDetailsEnabled( false );
+	MixerProfiler::setDenormalCheckEnabled( false );
+}
+
+
+
+
+void CPUBreakdownWidget::showEvent( QShowEvent * _se )
+{
+	// profiling tracks and effects costs a bit, so only do it while shown
+	MixerProfiler::setDetailsEnabled( true );
+	MixerProfiler::setDenormalCheckEnabled( m_denormalCheck->isChecked() );
+	m_lastTotals.clear();
+	m_lastDenormals.clear();
+	m_elapsed.start();
+	m_updateTimer.start( 500 );
+	QWidget::showEvent( _se );
+}
+
+
+
+
+void CPUBreakdownWidget::hideEvent( QHideEvent * _he )
+{
+	m_updateTimer.stop();
+	MixerProfiler::setDetailsEnabled( false );
+	MixerProfiler::setDenormalCheckEnabled( false );
+	QWidget::hideEvent( _he );
+}
+
+
+
+
+void CPUBreakdownWidget::updateBreakdown()
+{
+	m_elapsedNs = qMax<qint64>( 1, m_elapsed.nsecsElapsed() );
+	m_elapsed.restart();
+	m_totals.clear();
+	m_denormals.clear();
+
+	// the items are rebuilt, so remember which ones were expanded
+	m_expanded.clear();
+	for( QTreeWidgetItem * item : { m_stagesItem, m_tracksItem, m_fxChannelsItem } )
+	{
+		rememberExpanded( item );
+		qDeleteAll( item->takeChildren() );
+	}
+
+	const MixerProfiler & profiler = Engine::mixer()->profiler();
+	addItem( m_stagesItem, tr( "Song" ),
+			profiler.stageLoad( MixerProfiler::StageSong ) );
+	addItem( m_stagesItem, tr( "Play handles" ),
+			profiler.stageLoad( MixerProfiler::StagePlayHandles ) );
+	addItem( m_stagesItem, tr( "Track effects" ),
+			profiler.stageLoad( MixerProfiler::StageAudioPorts ) );
+	addItem( m_stagesItem, tr( "FX mixer" ),
+			profiler.stageLoad( MixerProfiler::StageMasterMix ) );
+	m_stagesItem->setText( 1, QString( "%1%" ).arg( Engine::mixer()->cpuLoad() ) );
+
+	TrackContainer::TrackList tracks = Engine::getSong()->tracks();
+	tracks += Engine::getBBTrackContainer()->tracks();
+	for( Track * track : tracks )
+	{
+		AudioPort * port = nullptr;
+		if( track->type() == Track::InstrumentTrack )
+		{
+			port = static_cast<InstrumentTrack *>( track )->audioPort();
+		}
+		else if( track->type() == Track::SampleTrack )
+		{
+			port = static_cast<SampleTrack *>( track )->audioPort();
+		}
+		if( port == nullptr )
+		{
+			continue;
+		}
+
+		QTreeWidgetItem * trackItem = addItem( m_tracksItem,
+					track->name(), port->processingTime(),
+					&port->denormals() );
+		if( track->type() == Track::InstrumentTrack )
+		{
+			const Instrument * instrument =
+				static_cast<InstrumentTrack *>( track )->instrument();
+			if( instrument && instrument->remotePlugin() )
+			{
+				addRemoteItem( trackItem, instrument->remotePlugin() );
+			}
+		}
+		if( port->effects() )
+		{
+			for( const Effect * effect : port->effects()->effects() )
+			{
+				addEffectItem( trackItem, effect );
+			}
+		}
+	}
+
+	FxMixer * fxMixer = Engine::fxMixer();
+	for( int i = 0; i < fxMixer->numChannels(); ++i )
+	{
+		FxChannel * ch = fxMixer->effectChannel( i );
+		QTreeWidgetItem * channelItem = addItem( m_fxChannelsItem,
+					ch->m_name, ch->m_processingTime );
+		for( const Effect * effect : ch->m_fxChain.effects() )
+		{
+			addEffectItem( channelItem, effect );
+		}
+	}
+
+	for( QTreeWidgetItem * item : { m_tracksItem, m_fxChannelsItem } )
+	{
+		restoreExpanded( item );
+	}
+
+	m_notePoolItem->child( 0 )->setText( 1, QString::number( NotePlayHandleManager::inUse() ) );
+	m_notePoolItem->child( 1 )->setText( 1, QString::number( NotePlayHandleManager::highWaterMark() ) );
+	m_notePoolItem->child( 2 )->setText( 1, QString::number( NotePlayHandleManager::capacity() ) );
+	m_notePoolItem->child( 3 )->setText( 1, QString::number( NotePlayHandleManager::overflows() ) );
+
+	m_bufferPoolItem->child( 0 )->setText( 1, QString::number( BufferManager::inUse() ) );
+	m_bufferPoolItem->child( 1 )->setText( 1, QString::number( BufferManager::highWaterMark() ) );
+	m_bufferPoolItem->child( 2 )->setText( 1, QString::number( BufferManager::capacity() ) );
+	m_bufferPoolItem->child( 3 )->setText( 1, QString::number( BufferManager::overflows() ) );
+	m_bufferPoolItem->setText( 1, QString::number( BufferManager::inUse() ) );
+
+	const LocklessAllocator::Usage elements = LocklessAllocator::usage();
+	m_locklessItem->child( 0 )->setText( 1, QString::number( elements.inUse ) );
+	m_locklessItem->child( 1 )->setText( 1, QString::number( elements.capacity ) );
+	m_locklessItem->child( 2 )->setText( 1, QString::number( elements.segmentsAdded ) );
+	m_locklessItem->child( 3 )->setText( 1, QString::number( elements.failures ) );
+
+	const auto megabytes = MemoryUsage::megabytes;
+	const RealtimeMemory::Usage locked = RealtimeMemory::usage();
+	m_lockedMemoryItem->setText( 1, locked.enabled ? megabytes( locked.lockedBytes ) : tr( "Off" ) );
+	m_lockedMemoryItem->child( 0 )->setText( 1, megabytes( locked.lockedBytes ) );
+	m_lockedMemoryItem->child( 1 )->setText( 1, megabytes( locked.poolBytes ) );
+	m_lockedMemoryItem->child( 2 )->setText( 1, megabytes( locked.inUse ) );
+	m_lockedMemoryItem->child( 3 )->setText( 1, megabytes( locked.hugePageBytes ) );
+	m_lockedMemoryItem->child( 4 )->setText( 1, locked.lockLimit < 0 ?
+					tr( "None" ) : megabytes( locked.lockLimit ) );
+	m_lockedMemoryItem->child( 5 )->setText( 1, QString::number( locked.overflows ) );
+
+	const CompressedFrames::Usage usage = CompressedFrames::usage();
+	const qint64 saved = usage.frameBytes - usage.compressedBytes - usage.cacheBytes;
+	m_sampleMemoryItem->child( 0 )->setText( 1, QString::number( usage.samples ) );
+	m_sampleMemoryItem->child( 1 )->setText( 1, megabytes( usage.frameBytes ) );
+	m_sampleMemoryItem->child( 2 )->setText( 1, megabytes( usage.compressedBytes ) );
+	m_sampleMemoryItem->child( 3 )->setText( 1, megabytes( usage.cacheBytes ) );
+	m_sampleMemoryItem->child( 4 )->setText( 1, megabytes( saved ) );
+	m_sampleMemoryItem->setText( 1, megabytes( saved ) );
+
+	updateMemory();
+
+	// forget about removed objects
+	m_lastTotals.swap( m_totals );
+	m_lastDenormals.swap( m_denormals );
+}
+
+
+
+
+void CPUBreakdownWidget::updateMemory()
+{
+	const MemoryUsage::Report report = MemoryUsage::collect();
+	m_memoryItem->setText( 1, MemoryUsage::megabytes( report.subsystems.total() ) );
+
+	for( int i = 0; i < MemoryUsage::NumSubsystems; ++i )
+	{
+		QTreeWidgetItem * subsystemItem = m_memoryItem->child( i );
+		subsystemItem->setText( 1, MemoryUsage::megabytes( report.subsystems.bytes[i] ) );
+		qDeleteAll( subsystemItem->takeChildren() );
+
+		// the tracks and FX channels holding memory of the subsystem
+		const auto addChild = [subsystemItem]( const QString & name, qint64 bytes )
+		{
+			if( bytes > 0 )
+			{
+				QTreeWidgetItem * item = new QTreeWidgetItem( subsystemItem );
+				item->setText( 0, name );
+				item->setText( 1, MemoryUsage::megabytes( bytes ) );
+				item->setTextAlignment( 1, Qt::AlignRight );
+			}
+		};
+		for( const MemoryUsage::Entry & entry : report.tracks )
+		{
+			addChild( entry.name, entry.bytes[i] );
+		}
+		for( const MemoryUsage::Entry & entry : report.fxChannels )
+		{
+			addChild( entry.name, entry.bytes[i] );
+		}
+		if( i == MemoryUsage::GuiCaches )
+		{
+			for( const auto & cache : report.caches )
+			{
+				addChild( cache.first, cache.second );
+			}
+		}
+	}
+}
+
+
+
+
+void CPUBreakdownWidget::setDenormalCheckEnabled( bool enabled )
+{
+	m_tree->setColumnHidden( 2, !enabled );
+	m_lastDenormals.clear();
+	if( isVisible() )
+	{
+		MixerProfiler::setDenormalCheckEnabled( enabled );
+	}
+}
+
+
+
+
+QTreeWidgetItem * CPUBreakdownWidget::addItem( QTreeWidgetItem * parent,
+		const QString & name, const MixerProfiler::TimeCounter & counter,
+		const MixerProfiler::DenormalCounter * denormals )
+{
+	const quint64 total = counter.total();
+	const quint64 last = m_lastTotals.value( &counter, total );
+	m_totals[&counter] = total;
+
+	// share of the time that passed in realtime, like the CPU load
+	QTreeWidgetItem * item = addItem( parent, name, static_cast<int>(
+				( total - last ) * 100 / m_elapsedNs ) );
+
+	if( denormals )
+	{
+		const quint64 count = denormals->total();
+		const quint64 lastCount = m_lastDenormals.value( denormals, count );
+		m_denormals[denormals] = count;
+		item->setText( 2, QString::number( count - lastCount ) );
+		item->setTextAlignment( 2, Qt::AlignRight );
+		if( count != lastCount )
+		{
+			// make the offenders stand out
+			item->setForeground( 2, Qt::red );
+		}
+	}
+	const quintptr key = reinterpret_cast<quintptr>( &counter );
+	item->setData( 0, Qt::UserRole, QVariant::fromValue( key ) );
+	return item;
+}
+
+
+
+
+QTreeWidgetItem * CPUBreakdownWidget::addItem( QTreeWidgetItem * parent,
+		const QString & name, int load )
+{
+	QTreeWidgetItem * item = new QTreeWidgetItem( parent );
+	item->setText( 0, name );
+	item->setText( 1, QString( "%1%" ).arg( load ) );
+	item->setTextAlignment( 1, Qt::AlignRight );
+	return item;
+}
+
+
+
+
+void CPUBreakdownWidget::addEffectItem( QTreeWidgetItem * parent,
+						const Effect * effect )
+{
+	QTreeWidgetItem * item = addItem( parent, effect->displayName(),
+						effect->processingTime(),
+						&effect->denormals() );
+	if( effect->remotePlugin() )
+	{
+		addRemoteItem( item, effect->remotePlugin() );
+	}
+}
+
+
+
+
+void CPUBreakdownWidget::addRemoteItem( QTreeWidgetItem * parent,
+						const RemotePlugin * plugin )
+{
+	// the time the audio threads were held up by the plugin process
+	QTreeWidgetItem * item = addItem( parent, tr( "Plugin process" ),
+							plugin->waitTime() );
+	addItem( item, tr( "Processing" ), plugin->pluginTime() );
+
+	const auto addValue = [item]( const QString & name, const QString & value )
+	{
+		QTreeWidgetItem * child = new QTreeWidgetItem( item );
+		child->setText( 0, name );
+		child->setText( 1, value );
+		child->setTextAlignment( 1, Qt::AlignRight );
+	};
+	addValue( tr( "Messages sent" ), QString::number( plugin->messagesSent() ) );
+	addValue( tr( "Messages received" ),
+				QString::number( plugin->messagesReceived() ) );
+	addValue( tr( "Shared memory" ), QString( "%1 KB" ).arg(
+					plugin->sharedMemorySize() / 1024 ) );
+	addValue( tr( "Skipped periods" ),
+				QString::number( plugin->skippedPeriods() ) );
+}
+
+
+
+
+void CPUBreakdownWidget::rememberExpanded( const QTreeWidgetItem * item )
+{
+	for( int i = 0; i < item->childCount(); ++i )
+	{
+		const QTreeWidgetItem * child = item->child( i );
+		if( child->isExpanded() )
+		{
+			m_expanded.insert( child->data( 0, Qt::UserRole ).value<quintptr>() );
+		}
+		rememberExpanded( child );
+	}
+}
+
+
+
+
+void CPUBreakdownWidget::restoreExpanded( QTreeWidgetItem * item )
+{
+	for( int i = 0; i < item->childCount(); ++i )
+	{
+		QTreeWidgetItem * child = item->child( i );
+		if( child->childCount() > 0 )
+		{
+			child->setExpanded( m_expanded.contains(
+				child->data( 0, Qt::UserRole ).value<quintptr>() ) );
+			restoreExpanded( child );
+		}
+	}
+}
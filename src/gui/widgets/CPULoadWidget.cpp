@@ -24,12 +24,15 @@
  */
 
 
+#include <QMouseEvent>
 #include <QPainter>
 
 #include "CPULoadWidget.h"
+#include "CPUBreakdownWidget.h"
 #include "embed.h"
 #include "Engine.h"
 #include "Mixer.h"
+#include "ToolTip.h"
 
 
 CPULoadWidget::CPULoadWidget( QWidget * _parent ) :
@@ -39,10 +42,12 @@ CPULoadWidget::CPULoadWidget( QWidget * _parent ) :
 	m_background( embed::getIconPixmap( "cpuload_bg" ) ),
 	m_leds( embed::getIconPixmap( "cpuload_leds" ) ),
 	m_changed( true ),
-	m_updateTimer()
+	m_updateTimer(),
+	m_breakdown( NULL )
 {
 	setAttribute( Qt::WA_OpaquePaintEvent, true );
 	setFixedSize( m_background.width(), m_background.height() );
+	ToolTip::add( this, tr( "Click to show the CPU breakdown" ) );
 
 	m_temp = QPixmap( width(), height() );
 	
@@ -89,6 +94,24 @@ void CPULoadWidget::paintEvent( QPaintEvent *  )
 
 
 
+void CPULoadWidget::mousePressEvent( QMouseEvent * _me )
+{
+	if( _me->button() != Qt::LeftButton )
+	{
+		QWidget::mousePressEvent( _me );
+		return;
+	}
+
+	if( m_breakdown == NULL )
+	{
+		m_breakdown = new CPUBreakdownWidget( this );
+	}
+	m_breakdown->setVisible( !m_breakdown->isVisible() );
+}
+
+
+
+
 void CPULoadWidget::updateCpuLoad()
 {
 	// smooth load-values a bit
@@ -56,6 +56,7 @@
 #include "ConfigManager.h"
 #include "TextFloat.h"
 #include "MainWindow.h"
+#include "PerfLog.h"
 
 
 TextFloat * Fader::s_textFloat = NULL;
@@ -340,6 +341,7 @@ inline int Fader::calculateDisplayPeak( float fPeak )
 
 void Fader::paintEvent( QPaintEvent * ev)
 {
+	PerfTrace::Scope trace( "Fader::paintEvent", PerfTrace::Gui );
 	QPainter painter(this);
 
 	// Draw the background
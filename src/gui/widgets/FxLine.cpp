@@ -67,7 +67,8 @@ FxLine::FxLine( QWidget * _parent, FxMixerView * _mv, int _channelIndex ) :
 	m_strokeOuterInactive( 0, 0, 0 ),
 	m_strokeInnerActive( 0, 0, 0 ),
 	m_strokeInnerInactive( 0, 0, 0 ),
-	m_inRename( false )
+	m_inRename( false ),
+	m_sleeping( false )
 {
 	if( !s_sendBgArrow )
 	{
@@ -148,6 +149,18 @@ void FxLine::setChannelIndex( int index )
 
 
 
+
+void FxLine::setSleeping( bool sleeping )
+{
+	if( sleeping != m_sleeping )
+	{
+		m_sleeping = sleeping;
+		update();
+	}
+}
+
+
+
 void FxLine::drawFxLine( QPainter* p, const FxLine *fxLine, bool isActive, bool sendToThis, bool receiveFromThis )
 {
 	auto channel = Engine::fxMixer()->effectChannel( m_channelIndex );
@@ -172,6 +185,12 @@ void FxLine::drawFxLine( QPainter* p, const FxLine *fxLine, bool isActive, bool
 					 isActive ? fxLine->backgroundActive().color() : p->background().color() );
 	}
 	
+	if( m_sleeping && !muted )
+	{
+		// dim the channel while nothing's going on in it
+		p->fillRect( fxLine->rect(), QColor( 0, 0, 0, 64 ) );
+	}
+
 	// inner border
 	p->setPen( isActive ? fxLine->strokeInnerActive() : fxLine->strokeInnerInactive() );
 	p->drawRect( 1, 1, width-3, height-3 );
@@ -30,6 +30,7 @@
 #include "InstrumentMidiIOView.h"
 #include "MidiPortMenu.h"
 #include "Engine.h"
+#include "ComboBox.h"
 #include "embed.h"
 #include "GroupBox.h"
 #include "gui_templates.h"
@@ -226,6 +227,31 @@ InstrumentMiscView::InstrumentMiscView(InstrumentTrack *it, QWidget *parent) :
 	tlabel->setFont( pointSize<8>( tlabel->font() ) );
 	m_pitchGroupBox->setModel( &it->m_useMasterPitchModel );
 	masterPitchLayout->addWidget( tlabel );
+
+	QWidget * polyphonyBox = new QWidget( this );
+	layout->addWidget( polyphonyBox );
+	QHBoxLayout * polyphonyLayout = new QHBoxLayout( polyphonyBox );
+	polyphonyLayout->setContentsMargins( 8, 8, 8, 8 );
+	polyphonyLayout->setSpacing( 8 );
+
+	m_maxPolyphonySpinBox = new LcdSpinBox( 3, polyphonyBox );
+	m_maxPolyphonySpinBox->addTextForValue( 0, "---" );
+	/*: This string must be be short, its width must be less than
+	 *  width of LCD spin-box of three digits */
+	m_maxPolyphonySpinBox->setLabel( tr( "VOICES" ) );
+	m_maxPolyphonySpinBox->setModel( it->maxPolyphonyModel() );
+	m_maxPolyphonySpinBox->setToolTip( tr( "Maximum number of notes playing "
+				"at the same time, including their release" ) );
+	polyphonyLayout->addWidget( m_maxPolyphonySpinBox );
+
+	m_voiceStealingComboBox = new ComboBox( polyphonyBox );
+	m_voiceStealingComboBox->setFixedSize( 120, ComboBox::DEFAULT_HEIGHT );
+	m_voiceStealingComboBox->setModel( it->voiceStealingModel() );
+	m_voiceStealingComboBox->setToolTip( tr( "Which note to fade out when "
+				"there are too many" ) );
+	polyphonyLayout->addWidget( m_voiceStealingComboBox );
+	polyphonyLayout->addStretch();
+
 	layout->addStretch();
 }
 
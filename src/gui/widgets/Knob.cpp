@@ -38,7 +38,6 @@
 #include "Knob.h"
 #include "CaptionMenu.h"
 #include "ConfigManager.h"
-#include "ControllerConnection.h"
 #include "DeprecationHelper.h"
 #include "embed.h"
 #include "gui_templates.h"
@@ -795,19 +794,6 @@ void Knob::enterValue()
 
 
 
-void Knob::friendlyUpdate()
-{
-	if (model() && (model()->controllerConnection() == NULL ||
-		model()->controllerConnection()->getController()->frequentUpdates() == false ||
-				Controller::runningFrames() % (256*4) == 0))
-	{
-		update();
-	}
-}
-
-
-
-
 QString Knob::displayValue() const
 {
 	if( isVolumeKnob() &&
@@ -824,19 +810,6 @@ QString Knob::displayValue() const
 
 
 
-void Knob::doConnections()
-{
-	if( model() != NULL )
-	{
-		QObject::connect( model(), SIGNAL( dataChanged() ),
-					this, SLOT( friendlyUpdate() ) );
-
-		QObject::connect( model(), SIGNAL( propertiesChanged() ),
-						this, SLOT( update() ) );
-	}
-}
-
-
 void Knob::changeEvent(QEvent * ev)
 {
 	if (ev->type() == QEvent::EnabledChange)
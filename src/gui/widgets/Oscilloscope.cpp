@@ -31,17 +31,18 @@
 #include "gui_templates.h"
 #include "MainWindow.h"
 #include "Mixer.h"
+#include "PerfLog.h"
 #include "Engine.h"
 #include "ToolTip.h"
 #include "Song.h"
 #include "embed.h"
-#include "BufferManager.h"
 
 
 Oscilloscope::Oscilloscope( QWidget * _p ) :
 	QWidget( _p ),
 	m_background( embed::getIconPixmap( "output_graph" ) ),
-	m_points( new QPointF[Engine::mixer()->framesPerPeriod()] ),
+	m_points( new QPointF[2 * VisualizationTap::MaxPoints] ),
+	m_snapshot( NULL ),
 	m_active( false ),
 	m_normalColor(71, 253, 133),
 	m_clippingColor(255, 64, 64)
@@ -50,12 +51,6 @@ Oscilloscope::Oscilloscope( QWidget * _p ) :
 	setAttribute( Qt::WA_OpaquePaintEvent, true );
 	setActive( ConfigManager::inst()->value( "ui", "displaywaveform").toInt() );
 
-	const fpp_t frames = Engine::mixer()->framesPerPeriod();
-	m_buffer = new sampleFrame[frames];
-
-	BufferManager::clear( m_buffer, frames );
-
-
 	ToolTip::add( this, tr( "Oscilloscope" ) );
 }
 
@@ -64,20 +59,11 @@ Oscilloscope::Oscilloscope( QWidget * _p ) :
 
 Oscilloscope::~Oscilloscope()
 {
-	delete[] m_buffer;
-	delete[] m_points;
-}
-
-
-
-
-void Oscilloscope::updateAudioBuffer( const surroundSampleFrame * buffer )
-{
-	if( !Engine::getSong()->isExporting() )
+	if( m_active )
 	{
-		const fpp_t fpp = Engine::mixer()->framesPerPeriod();
-		memcpy( m_buffer, buffer, sizeof( surroundSampleFrame ) * fpp );
+		Engine::mixer()->outputTap().detach();
 	}
+	delete[] m_points;
 }
 
 
@@ -85,24 +71,26 @@ void Oscilloscope::updateAudioBuffer( const surroundSampleFrame * buffer )
 
 void Oscilloscope::setActive( bool _active )
 {
+	if( _active == m_active )
+	{
+		return;
+	}
 	m_active = _active;
 	if( m_active )
 	{
+		// the mixer only reduces its output while someone looks at it
+		Engine::mixer()->outputTap().attach();
 		connect( gui->mainWindow(),
 					SIGNAL( periodicUpdate() ),
 					this, SLOT( update() ) );
-		connect( Engine::mixer(),
-			SIGNAL( nextAudioBuffer( const surroundSampleFrame* ) ),
-			this, SLOT( updateAudioBuffer( const surroundSampleFrame* ) ) );
 	}
 	else
 	{
+		Engine::mixer()->outputTap().detach();
+		m_snapshot = NULL;
 		disconnect( gui->mainWindow(),
 					SIGNAL( periodicUpdate() ),
 					this, SLOT( update() ) );
-		disconnect( Engine::mixer(),
-			SIGNAL( nextAudioBuffer( const surroundSampleFrame* ) ),
-			this, SLOT( updateAudioBuffer( const surroundSampleFrame* ) ) );
 		// we have to update (remove last waves),
 		// because timer doesn't do that anymore
 		update();
@@ -133,19 +121,38 @@ void Oscilloscope::setClippingColor(QColor const & clippingColor)
 
 void Oscilloscope::paintEvent( QPaintEvent * )
 {
+	PerfTrace::Scope trace( "Oscilloscope::paintEvent", PerfTrace::Gui );
 	QPainter p( this );
 
 	p.drawPixmap( 0, 0, m_background );
 
-	if( m_active && !Engine::getSong()->isExporting() )
+	if( m_active )
+	{
+		// keep showing the previous period if no new one arrived
+		const VisualizationTap::Snapshot * snapshot =
+					Engine::mixer()->outputTap().read();
+		if( snapshot != NULL )
+		{
+			m_snapshot = snapshot;
+		}
+	}
+
+	if( m_active && m_snapshot != NULL && !Engine::getSong()->isExporting() )
 	{
 		Mixer const * mixer = Engine::mixer();
 
 		float master_output = mixer->masterGain();
 
-		const fpp_t frames = mixer->framesPerPeriod();
-		Mixer::StereoSample peakValues = mixer->getPeakValues(m_buffer, frames);
-		const float max_level = qMax<float>( peakValues.left, peakValues.right );
+		const int points = m_snapshot->points;
+		float max_level = 0.0f;
+		for( int i = 0; i < points; ++i )
+		{
+			for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+			{
+				max_level = qMax( max_level, qMax( -m_snapshot->min[i][ch],
+									m_snapshot->max[i][ch] ) );
+			}
+		}
 
 		// Set the color of the line according to the maximum level
 		float const maxLevelWithAppliedMasterGain = max_level * master_output;
@@ -155,21 +162,24 @@ void Oscilloscope::paintEvent( QPaintEvent * )
 
 		// now draw all that stuff
 		int w = width() - 4;
-		const qreal xd = static_cast<qreal>(w) / frames;
+		const qreal xd = static_cast<qreal>(w) / points;
 		const qreal half_h = -( height() - 6 ) / 3.0 * static_cast<qreal>(master_output) - 1;
 		int x_base = 2;
 		const qreal y_base = height() / 2 - 0.5;
 
+		// each point covers several frames, go through both its
+		// extremes so the line spans everything in between
 		for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
 		{
-			for( int frame = 0; frame < frames; ++frame )
+			for( int i = 0; i < points; ++i )
 			{
-				sample_t const clippedSample = Mixer::clip(m_buffer[frame][ch]);
-				m_points[frame] = QPointF(
-					x_base + static_cast<qreal>(frame) * xd,
-					y_base + ( static_cast<qreal>(clippedSample) * half_h ) );
+				const qreal x = x_base + static_cast<qreal>(i) * xd;
+				const sample_t lo = Mixer::clip( m_snapshot->min[i][ch] );
+				const sample_t hi = Mixer::clip( m_snapshot->max[i][ch] );
+				m_points[2 * i] = QPointF( x, y_base + ( static_cast<qreal>( i % 2 ? hi : lo ) * half_h ) );
+				m_points[2 * i + 1] = QPointF( x, y_base + ( static_cast<qreal>( i % 2 ? lo : hi ) * half_h ) );
 			}
-			p.drawPolyline( m_points, frames );
+			p.drawPolyline( m_points, 2 * points );
 		}
 	}
 	else
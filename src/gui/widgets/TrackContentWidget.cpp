@@ -28,6 +28,7 @@
 #include <QContextMenuEvent>
 #include <QMenu>
 #include <QPainter>
+#include <QTimer>
 
 #include "AutomationPattern.h"
 #include "BBEditor.h"
@@ -36,6 +37,7 @@
 #include "DataFile.h"
 #include "Engine.h"
 #include "GuiApplication.h"
+#include "PerfLog.h"
 #include "Song.h"
 #include "SongEditor.h"
 #include "StringPairDrag.h"
@@ -144,9 +146,12 @@ void TrackContentWidget::addTCOView( TrackContentObjectView * tcov )
 	TrackContentObject * tco = tcov->getTrackContentObject();
 
 	m_tcoViews.push_back( tcov );
+	m_viewedTCOs.insert( tco );
 
+	// only the new view has to be placed, so loading a track doesn't take
+	// quadratic time
 	tco->saveJournallingState( false );
-	changePosition();
+	updateTCOViewPosition( tcov );
 	tco->restoreJournallingState();
 }
 
@@ -167,6 +172,7 @@ void TrackContentWidget::removeTCOView( TrackContentObjectView * tcov )
 	if( it != m_tcoViews.end() )
 	{
 		m_tcoViews.erase( it );
+		m_viewedTCOs.remove( tcov->getTrackContentObject() );
 		Engine::getSong()->setModified();
 	}
 }
@@ -248,34 +254,69 @@ void TrackContentWidget::changePosition( const TimePos & newPos )
 	for( tcoViewVector::iterator it = m_tcoViews.begin();
 						it != m_tcoViews.end(); ++it )
 	{
-		TrackContentObjectView * tcov = *it;
-		TrackContentObject * tco = tcov->getTrackContentObject();
-
+		TrackContentObject * tco = ( *it )->getTrackContentObject();
 		tco->changeLength( tco->length() );
 
-		const int ts = tco->startPosition();
-		const int te = tco->endPosition()-3;
-		if( ( ts >= begin && ts <= end ) ||
-			( te >= begin && te <= end ) ||
-			( ts <= begin && te >= end ) )
+		placeTCOView( *it, begin, end, ppb );
+	}
+	setUpdatesEnabled( true );
+
+	// redraw background
+//	update();
+}
+
+
+
+
+void TrackContentWidget::updateTCOViewPosition( TrackContentObjectView * tcov )
+{
+	const TrackContainerView * tcv = m_trackView->trackContainerView();
+	if( tcv == gui->getBBEditor()->trackContainerView() )
+	{
+		if( tcov->getTrackContentObject()->startPosition().getBar() ==
+					Engine::getBBTrackContainer()->currentBB() )
 		{
-			tcov->move( static_cast<int>( ( ts - begin ) * ppb /
-						TimePos::ticksPerBar() ),
-								tcov->y() );
-			if( !tcov->isVisible() )
-			{
-				tcov->show();
-			}
+			tcov->move( 0, tcov->y() );
+			tcov->raise();
+			tcov->show();
 		}
 		else
 		{
-			tcov->move( -tcov->width()-10, tcov->y() );
+			tcov->hide();
 		}
+		return;
 	}
-	setUpdatesEnabled( true );
 
-	// redraw background
-//	update();
+	const TimePos pos = tcv->currentPosition();
+	placeTCOView( tcov, pos, endPosition( pos ), tcv->pixelsPerBar() );
+}
+
+
+
+
+void TrackContentWidget::placeTCOView( TrackContentObjectView * tcov,
+						int begin, int end, float ppb )
+{
+	TrackContentObject * tco = tcov->getTrackContentObject();
+
+	const int ts = tco->startPosition();
+	const int te = tco->endPosition()-3;
+	if( ( ts >= begin && ts <= end ) ||
+		( te >= begin && te <= end ) ||
+		( ts <= begin && te >= end ) )
+	{
+		tcov->move( static_cast<int>( ( ts - begin ) * ppb /
+					TimePos::ticksPerBar() ),
+							tcov->y() );
+		if( !tcov->isVisible() )
+		{
+			tcov->show();
+		}
+	}
+	else
+	{
+		tcov->move( -tcov->width()-10, tcov->y() );
+	}
 }
 
 
@@ -596,6 +637,7 @@ void TrackContentWidget::mouseReleaseEvent( QMouseEvent * me )
  */
 void TrackContentWidget::paintEvent( QPaintEvent * pe )
 {
+	PerfTrace::Scope trace( "TrackContentWidget::paintEvent", PerfTrace::Gui );
 	// Assume even-pixels-per-bar. Makes sense, should be like this anyways
 	const TrackContainerView * tcv = m_trackView->trackContainerView();
 	int ppb = static_cast<int>( tcv->pixelsPerBar() );
@@ -606,6 +648,46 @@ void TrackContentWidget::paintEvent( QPaintEvent * pe )
 		p.drawTiledPixmap( rect(), m_background, QPoint(
 				tcv->currentPosition().getBar() * ppb, 0 ) );
 	}
+
+	// we're shown for the first time, stand in for the TCO views until
+	// they are created
+	if( !m_trackView->hasTCOViews() )
+	{
+		paintPlaceholders( p );
+		QTimer::singleShot( 0, m_trackView, [this]()
+		{
+			m_trackView->createTCOViews();
+		} );
+	}
+}
+
+
+
+
+void TrackContentWidget::paintPlaceholders( QPainter & p )
+{
+	const TrackContainerView * tcv = m_trackView->trackContainerView();
+	if( tcv == gui->getBBEditor()->trackContainerView() )
+	{
+		return;
+	}
+
+	const TimePos begin = tcv->currentPosition();
+	const float ppb = tcv->pixelsPerBar();
+	const QBrush trackBrush = getTrack()->useColor() ?
+				QBrush( getTrack()->color() ) : gridColor();
+
+	Track::tcoVector tcos;
+	getTrack()->getTCOsInRange( tcos, begin, endPosition( begin ) );
+	for( TrackContentObject * tco : tcos )
+	{
+		const int x = static_cast<int>( ( tco->startPosition() - begin ) *
+					ppb / TimePos::ticksPerBar() );
+		const int w = static_cast<int>( tco->length() * ppb /
+					TimePos::ticksPerBar() );
+		p.fillRect( x, 1, w, height() - 2, tco->usesCustomClipColor() ?
+				QBrush( tco->color() ) : trackBrush );
+	}
 }
 
 
@@ -337,6 +337,12 @@ void TrackOperationsWidget::updateMenu()
 	{
 		toMenu->addSeparator();
 		toMenu->addMenu(trackView->midiMenu());
+		if (trackView->model()->trackContainer() == Engine::getSong())
+		{
+			toMenu->addAction(trackView->model()->isFrozen()
+						? tr("Unfreeze this track") : tr("Freeze this track"),
+						trackView, SLOT(toggleFreeze()));
+		}
 	}
 	if( dynamic_cast<AutomationTrackView *>( m_trackView ) )
 	{
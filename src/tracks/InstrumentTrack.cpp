@@ -27,6 +27,8 @@
 #include <QDir>
 #include <QApplication>
 #include <QCloseEvent>
+#include <QEventLoop>
+#include <QFile>
 #include <QLabel>
 #include <QLayout>
 #include <QLineEdit>
@@ -35,6 +37,14 @@
 #include <QMessageBox>
 #include <QMdiSubWindow>
 #include <QPainter>
+#include <QProgressDialog>
+#include <QThread>
+#include <QTimer>
+#include <QUuid>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <chrono>
 
 #include "FileDialog.h"
 #include "AutomationPattern.h"
@@ -44,6 +54,7 @@
 #include "ConfigManager.h"
 #include "ControllerConnection.h"
 #include "DataFile.h"
+#include "Effect.h"
 #include "EffectChain.h"
 #include "EffectRackView.h"
 #include "embed.h"
@@ -71,6 +82,8 @@
 #include "Pattern.h"
 #include "PluginFactory.h"
 #include "PluginView.h"
+#include "RenderManager.h"
+#include "SampleBuffer.h"
 #include "SamplePlayHandle.h"
 #include "Song.h"
 #include "StringPairDrag.h"
@@ -91,6 +104,10 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_midiPort( tr( "unnamed_track" ), Engine::mixer()->midiClient(),
 								this, this ),
 	m_notes(),
+	m_queuedInEvents( MaxQueuedInEvents ),
+	m_inEventsScheduled( false ),
+	m_recordingNotes( false ),
+	m_recordedNotes( MaxRecordedNotes ),
 	m_sustainPedalPressed( false ),
 	m_silentBuffersProcessed( false ),
 	m_previewMode( false ),
@@ -98,6 +115,7 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_firstKeyModel(0, 0, NumKeys - 1, this, tr("First note")),
 	m_lastKeyModel(0, 0, NumKeys - 1, this, tr("Last note")),
 	m_hasAutoMidiDev( false ),
+	m_activeNotesPeriod( 0 ),
 	m_volumeModel( DefaultVolume, MinVolume, MaxVolume, 0.1f, this, tr( "Volume" ) ),
 	m_panningModel( DefaultPanning, PanningLeft, PanningRight, 0.1f, this, tr( "Panning" ) ),
 	m_audioPort( tr( "unnamed_track" ), true, &m_volumeModel, &m_panningModel, &m_mutedModel ),
@@ -105,12 +123,15 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	m_pitchRangeModel( 1, 1, 60, this, tr( "Pitch range" ) ),
 	m_effectChannelModel( 0, 0, 0, this, tr( "FX channel" ) ),
 	m_useMasterPitchModel( true, this, tr( "Master pitch") ),
+	m_maxPolyphonyModel( 0, 0, 256, this, tr( "Maximum polyphony" ) ),
+	m_voiceStealingModel( this, tr( "Voice stealing" ) ),
 	m_instrument( NULL ),
 	m_soundShaping( this ),
 	m_arpeggio( this ),
 	m_noteStacking( this ),
-	m_piano(this)
+	m_piano(this),
 //	m_microtuner(this)
+	m_frozenBuffer( nullptr )
 {
 	m_pitchModel.setCenterValue( 0 );
 	m_panningModel.setCenterValue( DefaultPanning );
@@ -120,12 +141,17 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 
 	m_effectChannelModel.setRange( 0, Engine::fxMixer()->numChannels()-1, 1);
 
+	m_voiceStealingModel.addItem( tr( "Oldest" ) );
+	m_voiceStealingModel.addItem( tr( "Quietest" ) );
+	m_voiceStealingModel.addItem( tr( "Same key" ) );
+
 	for( int i = 0; i < NumKeys; ++i )
 	{
 		m_notes[i] = NULL;
 		m_runningMidiNotes[i] = 0;
 	}
 
+	m_inEventsToPlay.reserve( MaxQueuedInEvents );
 
 	// Initialize the m_midiCCEnabled variable, but it's actually going to be connected
 	// to a LedButton
@@ -148,6 +174,12 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	connect(&m_pitchModel, SIGNAL(dataChanged()), this, SLOT(updatePitch()), Qt::DirectConnection);
 	connect(&m_pitchRangeModel, SIGNAL(dataChanged()), this, SLOT(updatePitchRange()), Qt::DirectConnection);
 	connect(&m_effectChannelModel, SIGNAL(dataChanged()), this, SLOT(updateEffectChannel()), Qt::DirectConnection);
+
+	m_audioPort.setPreMixHandler( [this]( const PlayHandleList & handles, sampleFrame * buffer )
+						{
+							processScheduledNotes( handles );
+							return renderVoices( handles, buffer );
+						} );
 }
 
 
@@ -178,9 +210,16 @@ InstrumentTrack::~InstrumentTrack()
 		s_autoAssignedTrack = NULL;
 	}
 
+	// keep the rendering of a frozen track for undoing its removal
+	unfreeze( false );
+
 	// kill all running notes and the iph
 	silenceAllNotes( true );
 
+	Engine::mixer()->requestChangeInModel();
+	Engine::mixer()->unscheduleQueuedInEvents( this );
+	Engine::mixer()->doneChangeInModel();
+
 	// now we're save deleting the instrument
 	if( m_instrument ) delete m_instrument;
 }
@@ -222,8 +261,8 @@ void InstrumentTrack::processAudioBuffer( sampleFrame* buf, const fpp_t frames,
 	m_audioPort.effects()->startRunning();
 
 	// get volume knob data
-	static const float DefaultVolumeRatio = 1.0f / DefaultVolume;
-	/*ValueBuffer * volBuf = m_volumeModel.valueBuffer();
+	/*static const float DefaultVolumeRatio = 1.0f / DefaultVolume;
+	ValueBuffer * volBuf = m_volumeModel.valueBuffer();
 	float v_scale = volBuf
 		? 1.0f
 		: getVolume() * DefaultVolumeRatio;*/
@@ -234,18 +273,121 @@ void InstrumentTrack::processAudioBuffer( sampleFrame* buf, const fpp_t frames,
 	if( m_instrument->flags().testFlag( Instrument::IsSingleStreamed ) == false && n != NULL )
 	{
 		const f_cnt_t offset = n->noteOffset();
+		// filters which can run in a batch are processed together with
+		// the other notes of the track in processScheduledNotes()
+		if( buf == n->buffer() && m_soundShaping.filterBatchable() )
+		{
+			m_soundShaping.scheduleNote( n, offset, frames - offset );
+			return;
+		}
 		m_soundShaping.processAudioBuffer( buf + offset, frames - offset, n );
-		const float vol = ( (float) n->getVolume() * DefaultVolumeRatio );
-		const panning_t pan = qBound( PanningLeft, n->getPanning(), PanningRight );
-		stereoVolumeVector vv = panningToVolumeVector( pan, vol );
-		for( f_cnt_t f = offset; f < frames; ++f )
+		applyNoteVolume( buf + offset, frames - offset, n );
+	}
+}
+
+
+
+
+stereoVolumeVector InstrumentTrack::noteVolume( const NotePlayHandle * n )
+{
+	static const float DefaultVolumeRatio = 1.0f / DefaultVolume;
+	const float vol = ( (float) n->getVolume() * DefaultVolumeRatio );
+	const panning_t pan = qBound( PanningLeft, n->getPanning(), PanningRight );
+	return panningToVolumeVector( pan, vol );
+}
+
+
+
+
+void InstrumentTrack::applyNoteVolume( sampleFrame * buf, const fpp_t frames, const NotePlayHandle * n )
+{
+	const stereoVolumeVector vv = noteVolume( n );
+	for( f_cnt_t f = 0; f < frames; ++f )
+	{
+		for( int c = 0; c < 2; ++c )
+		{
+			buf[f][c] *= vv.vol[c];
+		}
+	}
+	if( n->isStolen() )
+	{
+		n->applyStealFade( buf, frames );
+	}
+}
+
+
+
+
+void InstrumentTrack::processScheduledNotes( const PlayHandleList & handles )
+{
+	QVarLengthArray<NotePlayHandle *, 64> notes;
+	for( PlayHandle * handle : handles )
+	{
+		if( handle->type() != PlayHandle::TypeNotePlayHandle || !handle->buffer() )
 		{
-			for( int c = 0; c < 2; ++c )
+			continue;
+		}
+		NotePlayHandle * n = static_cast<NotePlayHandle *>( handle );
+		if( n->m_scheduledShaping.pending )
+		{
+			n->m_scheduledShaping.pending = false;
+			notes.append( n );
+		}
+	}
+	if( notes.isEmpty() )
+	{
+		return;
+	}
+
+	m_soundShaping.processNotes( notes.data(), notes.size() );
+	for( NotePlayHandle * n : notes )
+	{
+		const NotePlayHandle::ScheduledShaping & s = n->m_scheduledShaping;
+		applyNoteVolume( n->buffer() + s.offset, s.frames, n );
+	}
+}
+
+
+
+
+bool InstrumentTrack::renderVoices( const PlayHandleList & handles, sampleFrame * buffer )
+{
+	QVarLengthArray<NotePlayHandle *, 64> voices;
+	const bool playsPattern = Engine::getSong()->playMode() == Song::Mode_PlayPattern;
+	for( PlayHandle * handle : handles )
+	{
+		if( handle->type() != PlayHandle::TypeNotePlayHandle )
+		{
+			continue;
+		}
+		NotePlayHandle * n = static_cast<NotePlayHandle *>( handle );
+		if( n->m_voicePending )
+		{
+			n->m_voicePending = false;
+			if( playsPattern || !n->isBbTrackMuted() )
 			{
-				buf[f][c] *= vv.vol[c];
+				voices.append( n );
 			}
 		}
 	}
+	if( voices.isEmpty() || !m_instrument )
+	{
+		return false;
+	}
+
+	m_audioPort.effects()->startRunning();
+	m_instrument->playVoices( voices.data(), voices.size(), buffer );
+	return true;
+}
+
+
+
+
+bool InstrumentTrack::playsVoices() const
+{
+	return m_instrument != nullptr &&
+		m_instrument->flags().testFlag( Instrument::RendersVoices ) &&
+		!m_soundShaping.shapesNotes();
 }
 
 
@@ -288,6 +430,15 @@ void InstrumentTrack::processCCEvent(int controller)
 
 
 
+static qint64 steadyNanoseconds()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+}
+
+
+
+
 void InstrumentTrack::processInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	if (Engine::getSong()->isExporting() && event.source() == MidiEvent::Source::External)
@@ -295,6 +446,72 @@ void InstrumentTrack::processInEvent( const MidiEvent& event, const TimePos& tim
 		return;
 	}
 
+	// handling events of MIDI devices right away would start their notes
+	// at the beginning of the next period, however large it is, and lock
+	// the mixer for ending them
+	if( event.source() == MidiEvent::Source::External && !Mixer::isRenderingThread() )
+	{
+		if( m_queuedInEvents.tryPush( { event, time, offset, steadyNanoseconds() } ) &&
+			!m_inEventsScheduled.exchange( true ) )
+		{
+			Engine::mixer()->scheduleQueuedInEvents( this );
+		}
+		return;
+	}
+
+	playInEvent( event, time, offset );
+}
+
+
+
+
+void InstrumentTrack::processQueuedInEvents()
+{
+	// events coming in from now on have to schedule the track again
+	m_inEventsScheduled = false;
+
+	for( auto * e = m_queuedInEvents.popList(); e; )
+	{
+		m_inEventsToPlay.push_back( e->value );
+		auto * next = e->next;
+		m_queuedInEvents.free( e );
+		e = next;
+	}
+
+	// the newest event comes first, and several devices may have pushed
+	// their events in a slightly different order than they came in, which
+	// an insertion sort puts right without swapping simultaneous events
+	std::reverse( m_inEventsToPlay.begin(), m_inEventsToPlay.end() );
+	for( size_t i = 1; i < m_inEventsToPlay.size(); ++i )
+	{
+		const QueuedInEvent e = m_inEventsToPlay[i];
+		size_t j = i;
+		for( ; j > 0 && m_inEventsToPlay[j - 1].arrival > e.arrival; --j )
+		{
+			m_inEventsToPlay[j] = m_inEventsToPlay[j - 1];
+		}
+		m_inEventsToPlay[j] = e;
+	}
+
+	// an event which came in right now is played at the end of this period
+	// and one which is a period old at its beginning, so the latency is
+	// the same for all events
+	const qint64 now = steadyNanoseconds();
+	const f_cnt_t frames = Engine::mixer()->framesPerPeriod();
+	const double framesPerNanosecond = Engine::mixer()->processingSampleRate() / 1e9;
+	for( const QueuedInEvent & e : m_inEventsToPlay )
+	{
+		const f_cnt_t age = static_cast<f_cnt_t>( ( now - e.arrival ) * framesPerNanosecond );
+		playInEvent( e.event, e.time, qBound<f_cnt_t>( 0, frames - 1 - age + e.offset, frames - 1 ) );
+	}
+	m_inEventsToPlay.clear();
+}
+
+
+
+
+void InstrumentTrack::playInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
+{
 	bool eventHandled = false;
 
 	switch( event.type() )
@@ -380,7 +597,7 @@ void InstrumentTrack::processInEvent( const MidiEvent& event, const TimePos& tim
 									TimePos( static_cast<f_cnt_t>(
 									nph->totalFramesPlayed() /
 									Engine::framesPerTick() ) ) );
-								midiNoteOff( *nph );
+								recordNote( false, *nph );
 							}
 						}
 					}
@@ -487,7 +704,67 @@ void InstrumentTrack::processOutEvent( const MidiEvent& event, const TimePos& ti
 	}
 
 	// if appropriate, midi-port does futher routing
-	m_midiPort.processOutEvent( event, time );
+	m_midiPort.processOutEvent( event, time, offset );
+}
+
+
+
+
+void InstrumentTrack::setRecordingNotes( bool recording )
+{
+	m_recordingNotes = recording;
+	if( !recording )
+	{
+		takeRecordedNotes();
+	}
+}
+
+
+
+
+QVector<InstrumentTrack::RecordedNote> InstrumentTrack::takeRecordedNotes()
+{
+	QVector<RecordedNote> notes;
+	for( auto * e = m_recordedNotes.popList(); e; )
+	{
+		notes.push_back( e->value );
+		auto * next = e->next;
+		m_recordedNotes.free( e );
+		e = next;
+	}
+	// the newest note comes first
+	std::reverse( notes.begin(), notes.end() );
+	return notes;
+}
+
+
+
+
+void InstrumentTrack::recordNote( bool pressed, const NotePlayHandle & note )
+{
+	if( !m_recordingNotes.load( std::memory_order_relaxed ) )
+	{
+		return;
+	}
+
+	// the position of the frame the note starts or ends at
+	const Song * song = Engine::getSong();
+	const float framesPerTick = Engine::framesPerTick();
+	const Song::PlayPos & playPos = song->getPlayPos( song->playMode() );
+	const f_cnt_t frame = ( pressed ? note.offset() : note.framesBeforeRelease() ) +
+						static_cast<f_cnt_t>( playPos.currentFrame() );
+
+	RecordedNote recorded;
+	recorded.pressed = pressed;
+	recorded.key = note.key();
+	recorded.volume = note.getVolume();
+	recorded.panning = note.getPanning();
+	recorded.playing = song->isPlaying();
+	recorded.position = playPos.getTicks() + TimePos::fromFrames( frame, framesPerTick ).getTicks();
+	recorded.length = note.length();
+
+	// a full list means nobody took the notes for a long time
+	m_recordedNotes.tryPush( recorded );
 }
 
 
@@ -507,6 +784,14 @@ void InstrumentTrack::silenceAllNotes( bool removeIPH )
 	// invalidate all NotePlayHandles and PresetPreviewHandles linked to this track
 	m_processHandles.clear();
 
+	// the events which came in so far mustn't start new notes
+	for( auto * e = m_queuedInEvents.popList(); e; )
+	{
+		auto * next = e->next;
+		m_queuedInEvents.free( e );
+		e = next;
+	}
+
 	quint8 flags = PlayHandle::TypeNotePlayHandle | PlayHandle::TypePresetPreviewHandle;
 	if( removeIPH )
 	{
@@ -519,6 +804,90 @@ void InstrumentTrack::silenceAllNotes( bool removeIPH )
 
 
 
+const std::vector<const NotePlayHandle *> & InstrumentTrack::activeNotes() const
+{
+	static const std::vector<const NotePlayHandle *> none;
+	return m_activeNotesPeriod == Engine::mixer()->activeNotesPeriod()
+		? m_activeNotes : none;
+}
+
+
+
+
+void InstrumentTrack::limitPolyphony( NotePlayHandle * newNote )
+{
+	const int maxPolyphony = m_maxPolyphonyModel.value();
+	const int mode = m_voiceStealingModel.value();
+	if( maxPolyphony == 0 && mode != StealSameKey )
+	{
+		return;
+	}
+
+	// notes in their release still count, piling them up is what the limit
+	// is there for
+	QVarLengthArray<NotePlayHandle *, 64> voices;
+	for( NotePlayHandle * n : m_processHandles )
+	{
+		if( n != newNote && !n->isStolen() )
+		{
+			voices.append( n );
+		}
+	}
+
+	auto steal = [&voices]( int i )
+	{
+		NotePlayHandle * n = voices[i];
+		n->lock();
+		n->steal();
+		n->unlock();
+		voices.remove( i );
+	};
+
+	if( mode == StealSameKey )
+	{
+		for( int i = 0; i < voices.size(); ++i )
+		{
+			if( voices[i]->key() == newNote->key() )
+			{
+				steal( i-- );
+			}
+		}
+	}
+
+	while( maxPolyphony > 0 && voices.size() >= maxPolyphony )
+	{
+		int victim = 0;
+		if( mode == StealQuietest )
+		{
+			float level = voices[0]->audibility();
+			for( int i = 1; i < voices.size(); ++i )
+			{
+				const float l = voices[i]->audibility();
+				if( l < level )
+				{
+					level = l;
+					victim = i;
+				}
+			}
+		}
+		else
+		{
+			for( int i = 1; i < voices.size(); ++i )
+			{
+				if( voices[i]->totalFramesPlayed() >
+					voices[victim]->totalFramesPlayed() )
+				{
+					victim = i;
+				}
+			}
+		}
+		steal( victim );
+	}
+}
+
+
+
+
 f_cnt_t InstrumentTrack::beatLen( NotePlayHandle * _n ) const
 {
 	if( m_instrument != NULL )
@@ -544,6 +913,12 @@ void InstrumentTrack::playNote( NotePlayHandle* n, sampleFrame* workingBuffer )
 
 	if( n->isMasterNote() == false && m_instrument != NULL )
 	{
+		if( n->m_playsAsVoice )
+		{
+			// played together with the other notes in renderVoices()
+			n->m_voicePending = true;
+			return;
+		}
 		// all is done, so now lets play the note!
 		m_instrument->playNote( n, workingBuffer );
 	}
@@ -658,12 +1033,22 @@ void InstrumentTrack::removeMidiPortNode( DataFile & _dataFile )
 bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 							const f_cnt_t _offset, int _tco_num )
 {
-	if( ! m_instrument || ! tryLock() )
+	// tracks that can't be heard in an export don't start any notes
+	if( ! m_instrument || isBypassed() || ! tryLock() )
 	{
 		return false;
 	}
 	const float frames_per_tick = Engine::framesPerTick();
 
+	if( playsFrozen() )
+	{
+		// the rendering replaces the notes, which suspends the instrument.
+		// The song plays it with playFrozen(), also for frozen beat
+		// tracks, whose patterns are in the rendering.
+		unlock();
+		return _tco_num < 0;
+	}
+
 	tcoVector tcos;
 	::BBTrack * bb_track = NULL;
 	if( _tco_num >= 0 )
@@ -713,23 +1098,10 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 			cur_start -= p->startPosition();
 		}
 
-		// get all notes from the given pattern...
+		// only look at the notes starting within the current tick,
+		// without scanning the ones before it
 		const NoteVector & notes = p->notes();
-		// ...and set our index to zero
-		NoteVector::ConstIterator nit = notes.begin();
-
-		// very effective algorithm for playing notes that are
-		// posated within the current sample-frame
-
-
-		if( cur_start > 0 )
-		{
-			// skip notes which are posated before start-bar
-			while( nit != notes.end() && ( *nit )->pos() < cur_start )
-			{
-				++nit;
-			}
-		}
+		NoteVector::ConstIterator nit = p->firstNoteFrom( cur_start );
 
 		Note * cur_note;
 		while( nit != notes.end() &&
@@ -790,6 +1162,12 @@ void InstrumentTrack::saveTrackSpecificSettings( QDomDocument& doc, QDomElement
 	m_firstKeyModel.saveSettings(doc, thisElement, "firstkey");
 	m_lastKeyModel.saveSettings(doc, thisElement, "lastkey");
 	m_useMasterPitchModel.saveSettings( doc, thisElement, "usemasterpitch");
+	m_maxPolyphonyModel.saveSettings( doc, thisElement, "maxpolyphony" );
+	m_voiceStealingModel.saveSettings( doc, thisElement, "voicestealing" );
+	if( isFrozen() )
+	{
+		thisElement.setAttribute( "frozen", m_frozenFile );
+	}
 
 	// Save MIDI CC stuff
 	m_midiCCEnable->saveSettings(doc, thisElement, "enablecc");
@@ -841,6 +1219,9 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 	// remove the InstrumentPlayHandle if and only if we need to delete the instrument
 	silenceAllNotes(!reuseInstrument);
 
+	// the file is still needed if this is undoing an edit of the track
+	unfreeze( false );
+
 	lock();
 
 	m_volumeModel.loadSettings( thisElement, "vol" );
@@ -856,6 +1237,8 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 	m_firstKeyModel.loadSettings(thisElement, "firstkey");
 	m_lastKeyModel.loadSettings(thisElement, "lastkey");
 	m_useMasterPitchModel.loadSettings( thisElement, "usemasterpitch");
+	m_maxPolyphonyModel.loadSettings( thisElement, "maxpolyphony" );
+	m_voiceStealingModel.loadSettings( thisElement, "voicestealing" );
 
 	// clear effect-chain just in case we load an old preset without FX-data
 	m_audioPort.effects()->clear();
@@ -941,6 +1324,243 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 
 	updatePitchRange();
 	unlock();
+
+	// freeze the track again once its patterns are loaded as well
+	m_pendingFreezeFile = thisElement.attribute( "frozen" );
+	if( !m_pendingFreezeFile.isEmpty() )
+	{
+		if( Engine::getSong()->isLoadingProject() )
+		{
+			connect( Engine::getSong(), SIGNAL( projectLoaded() ),
+					this, SLOT( restoreFreeze() ), Qt::UniqueConnection );
+		}
+		else
+		{
+			QTimer::singleShot( 0, this, SLOT( restoreFreeze() ) );
+		}
+	}
+}
+
+
+
+
+bool InstrumentTrack::freeze( const QString & file )
+{
+	// the rendering is played by song position, which only works for a
+	// constant tempo
+	if( AutomationPattern::isAutomated( &Engine::getSong()->tempoModel() ) )
+	{
+		return false;
+	}
+
+	SampleBuffer * buffer = new SampleBuffer( file );
+	if( buffer->frames() <= 1 )
+	{
+		sharedObject::unref( buffer );
+		return false;
+	}
+
+	unfreeze( false );
+
+	Engine::mixer()->requestChangeInModel();
+	m_frozenBuffer = buffer;
+	m_audioPort.setFrozen( true );
+	Engine::mixer()->doneChangeInModel();
+	m_frozenFile = file;
+
+	// anything the rendering depends on invalidates it when edited
+	watchFreezeSource( this );
+	if( m_instrument )
+	{
+		watchFreezeSource( m_instrument );
+	}
+	m_freezeConnections << connect( m_audioPort.effects(), SIGNAL( dataChanged() ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	for( Effect * effect : m_audioPort.effects()->effects() )
+	{
+		watchFreezeSource( effect );
+	}
+	for( TrackContentObject * tco : getTCOs() )
+	{
+		watchFreezeSource( tco );
+	}
+	m_freezeConnections << connect( this, SIGNAL( trackContentObjectAdded( TrackContentObject * ) ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	m_freezeConnections << connect( this, SIGNAL( instrumentChanged() ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	m_freezeConnections << connect( Engine::getSong(), SIGNAL( tempoChanged( bpm_t ) ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	m_freezeConnections << connect( Engine::getSong(),
+					SIGNAL( timeSignatureChanged( int, int ) ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	// automating the tempo doesn't change its value until it's played
+	m_freezeConnections << connect( Engine::getSong(), SIGNAL( playbackStateChanged() ),
+					this, SLOT( unfreezeIfTempoAutomated() ), Qt::DirectConnection );
+
+	return true;
+}
+
+
+
+
+void InstrumentTrack::unfreeze( bool removeFile )
+{
+	for( const QMetaObject::Connection & connection : m_freezeConnections )
+	{
+		disconnect( connection );
+	}
+	m_freezeConnections.clear();
+
+	if( !isFrozen() )
+	{
+		return;
+	}
+
+	Engine::mixer()->requestChangeInModel();
+	SampleBuffer * buffer = m_frozenBuffer;
+	m_frozenBuffer = nullptr;
+	m_audioPort.setFrozen( false );
+	Engine::mixer()->doneChangeInModel();
+	sharedObject::unref( buffer );
+
+	if( removeFile )
+	{
+		QFile( m_frozenFile ).remove();
+	}
+	m_frozenFile.clear();
+}
+
+
+
+
+bool InstrumentTrack::playsFrozen() const
+{
+	const Song * song = Engine::getSong();
+	return isFrozen() && song->isPlaying()
+		&& song->playMode() == Song::Mode_PlaySong
+		&& m_frozenBuffer->sampleRate() == Engine::mixer()->processingSampleRate();
+}
+
+
+
+
+void InstrumentTrack::playFrozen( f_cnt_t frame, fpp_t frames, f_cnt_t offset )
+{
+	if( !playsFrozen() || isBypassed() || !tryLock() )
+	{
+		return;
+	}
+	if( frame < m_frozenBuffer->frames() )
+	{
+		m_audioPort.addFrozenFrames( m_frozenBuffer->data() + frame,
+			qMin<f_cnt_t>( frames, m_frozenBuffer->frames() - frame ), offset );
+	}
+	unlock();
+}
+
+
+
+
+QString InstrumentTrack::newFreezeFile() const
+{
+	// keep the renderings next to the project, or in the temporary
+	// directory as long as it wasn't saved
+	const QFileInfo project( Engine::getSong()->projectFileName() );
+	QDir dir = project.fileName().isEmpty()
+		? QDir( QDir::temp().filePath( "lmms-frozen" ) )
+		: QDir( project.absoluteDir().filePath( project.completeBaseName() + "-frozen" ) );
+	dir.mkpath( "." );
+
+	QString name = this->name();
+	name.remove( QRegExp( FILENAME_FILTER ) );
+	return dir.filePath( QString( "%1-%2.wav" ).arg( name ).arg(
+			QUuid::createUuid().toString().mid( 1, 8 ) ) );
+}
+
+
+
+
+void InstrumentTrack::freezeSourceChanged()
+{
+	// automations and controllers change models from the mixer threads
+	// while playing, but only edits have to be rendered again
+	if( !isFrozen() || Engine::getSong()->isLoadingProject()
+		|| QThread::currentThread() != QCoreApplication::instance()->thread() )
+	{
+		return;
+	}
+	// don't disconnect the signal that is being emitted
+	QTimer::singleShot( 0, this, [this]() { unfreeze(); } );
+}
+
+
+
+
+void InstrumentTrack::unfreezeIfTempoAutomated()
+{
+	Song * song = Engine::getSong();
+	if( isFrozen() && song->isPlaying()
+		&& AutomationPattern::isAutomated( &song->tempoModel() ) )
+	{
+		// don't disconnect the signal that is being emitted
+		QTimer::singleShot( 0, this, [this]() { unfreeze(); } );
+	}
+}
+
+
+
+
+void InstrumentTrack::restoreFreeze()
+{
+	const QString file = m_pendingFreezeFile;
+	m_pendingFreezeFile.clear();
+	if( !file.isEmpty() && trackContainer() == Engine::getSong() )
+	{
+		freeze( file );
+	}
+}
+
+
+
+
+void InstrumentTrack::watchFreezeSource( QObject * object )
+{
+	const auto isSource = [this]( AutomatableModel * model )
+	{
+		// (un)muting the track, or other tracks while rendering, doesn't
+		// change the rendering
+		return model != &m_mutedModel && model != getSoloModel();
+	};
+
+	const auto watch = [this]( QObject * sender )
+	{
+		m_freezeConnections << connect( sender, SIGNAL( dataChanged() ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	};
+
+	if( TrackContentObject * tco = dynamic_cast<TrackContentObject *>( object ) )
+	{
+		watch( tco );
+		m_freezeConnections << connect( tco, SIGNAL( lengthChanged() ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+		m_freezeConnections << connect( tco, SIGNAL( positionChanged() ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+		m_freezeConnections << connect( tco, SIGNAL( destroyedTCO() ),
+					this, SLOT( freezeSourceChanged() ), Qt::DirectConnection );
+	}
+
+	for( AutomatableModel * model : object->findChildren<AutomatableModel *>() )
+	{
+		if( !isSource( model ) )
+		{
+			continue;
+		}
+		watch( model );
+		for( AutomationPattern * pattern : AutomationPattern::patternsForModel( model ) )
+		{
+			watch( pattern );
+		}
+	}
 }
 
 
@@ -1228,6 +1848,86 @@ void InstrumentTrackView::createFxLine()
 
 
 
+/*! \brief Freeze the track by rendering it, or unfreeze it */
+void InstrumentTrackView::toggleFreeze()
+{
+	InstrumentTrack * track = model();
+	if( track->isFrozen() )
+	{
+		track->unfreeze();
+		Engine::getSong()->setModified();
+		return;
+	}
+
+	Song * song = Engine::getSong();
+	if( AutomationPattern::isAutomated( &song->tempoModel() ) )
+	{
+		QMessageBox::information( this, tr( "Freeze track" ),
+			tr( "Tracks can't be frozen while the tempo is automated." ) );
+		return;
+	}
+
+	song->stop();
+	// the rendering has to cover the whole song
+	song->setExportLoop( false );
+	song->setRenderBetweenMarkers( false );
+	song->setLoopRenderCount( 1 );
+
+	const QString file = track->newFreezeFile();
+	// floats keep what goes above 0 dBFS before the FX mixer
+	const OutputSettings os( Engine::mixer()->processingSampleRate(),
+				OutputSettings::BitRateSettings( 160, false ),
+				OutputSettings::Depth_32Bit );
+	auto renderManager = std::make_unique<RenderManager>(
+				Engine::mixer()->currentQualitySettings(), os,
+				ProjectRenderer::WaveFile, file );
+
+	QProgressDialog progress( tr( "Freezing %1..." ).arg( track->name() ),
+					tr( "Cancel" ), 0, 100, this );
+	progress.setWindowModality( Qt::ApplicationModal );
+	progress.setMinimumDuration( 0 );
+
+	QEventLoop loop;
+	bool finished = false;
+	connect( renderManager.get(), SIGNAL( progressChanged( int ) ),
+					&progress, SLOT( setValue( int ) ) );
+	connect( renderManager.get(), &RenderManager::finished,
+					[&]() { finished = true; loop.quit(); } );
+	connect( &progress, &QProgressDialog::canceled, [&]()
+		{
+			renderManager->abortProcessing();
+			loop.quit();
+		} );
+
+	renderManager->renderTrack( track );
+	if( !finished && !progress.wasCanceled() )
+	{
+		loop.exec();
+	}
+	// restores the audio device
+	renderManager.reset();
+	progress.close();
+
+	if( !finished )
+	{
+		QFile( file ).remove();
+	}
+	else if( track->freeze( file ) )
+	{
+		song->setModified();
+	}
+	else
+	{
+		QFile( file ).remove();
+		QMessageBox::warning( this, tr( "Freeze failed" ),
+			tr( "The track could not be rendered. The song may be "
+				"empty or too long to load the rendering." ) );
+	}
+}
+
+
+
+
 /*! \brief Assign a specific FX Channel for this track */
 void InstrumentTrackView::assignFxLine(int channelIndex)
 {
@@ -1675,6 +2375,8 @@ void InstrumentTrackWindow::modelChanged()
 	m_midiView->setModel( &m_track->m_midiPort );
 	m_effectView->setModel( m_track->m_audioPort.effects() );
 	m_miscView->pitchGroupBox()->setModel(&m_track->m_useMasterPitchModel);
+	m_miscView->maxPolyphonySpinBox()->setModel(&m_track->m_maxPolyphonyModel);
+	m_miscView->voiceStealingComboBox()->setModel(&m_track->m_voiceStealingModel);
 	updateName();
 }
 
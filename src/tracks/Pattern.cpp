@@ -30,6 +30,7 @@
 #include "InstrumentTrack.h"
 #include "PianoRoll.h"
 
+#include <algorithm>
 #include <limits>
 
 
@@ -44,7 +45,8 @@ Pattern::Pattern( InstrumentTrack * _instrument_track ) :
 	TrackContentObject( _instrument_track ),
 	m_instrumentTrack( _instrument_track ),
 	m_patternType( BeatPattern ),
-	m_steps( TimePos::stepsPerBar() )
+	m_steps( TimePos::stepsPerBar() ),
+	m_playCursor( 0 )
 {
 	if( _instrument_track->trackContainer()
 					== Engine::getBBTrackContainer() )
@@ -62,7 +64,8 @@ Pattern::Pattern( const Pattern& other ) :
 	TrackContentObject( other.m_instrumentTrack ),
 	m_instrumentTrack( other.m_instrumentTrack ),
 	m_patternType( other.m_patternType ),
-	m_steps( other.m_steps )
+	m_steps( other.m_steps ),
+	m_playCursor( 0 )
 {
 	for( NoteVector::ConstIterator it = other.m_notes.begin(); it != other.m_notes.end(); ++it )
 	{
@@ -203,6 +206,7 @@ Note * Pattern::addNote( const Note & _new_note, const bool _quant_pos )
 
 	instrumentTrack()->lock();
 	m_notes.insert(std::upper_bound(m_notes.begin(), m_notes.end(), new_note, Note::lessThan), new_note);
+	m_playCursor = 0;
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -216,6 +220,35 @@ Note * Pattern::addNote( const Note & _new_note, const bool _quant_pos )
 
 
 
+void Pattern::addNotes( const QVector<Note> & _notes )
+{
+	if( _notes.isEmpty() )
+	{
+		return;
+	}
+
+	instrumentTrack()->lock();
+	const int first = m_notes.size();
+	for( const Note & note : _notes )
+	{
+		m_notes.push_back( new Note( note ) );
+	}
+	// like adding them one by one, equal notes stay in the order added
+	std::stable_sort( m_notes.begin() + first, m_notes.end(), Note::lessThan );
+	std::inplace_merge( m_notes.begin(), m_notes.begin() + first, m_notes.end(),
+								Note::lessThan );
+	m_playCursor = 0;
+	instrumentTrack()->unlock();
+
+	checkType();
+	updateLength();
+
+	emit dataChanged();
+}
+
+
+
+
 void Pattern::removeNote( Note * _note_to_del )
 {
 	instrumentTrack()->lock();
@@ -230,6 +263,7 @@ void Pattern::removeNote( Note * _note_to_del )
 		}
 		++it;
 	}
+	m_playCursor = 0;
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -261,6 +295,34 @@ void Pattern::rearrangeAllNotes()
 {
 	// sort notes by start time
 	std::sort(m_notes.begin(), m_notes.end(), Note::lessThan);
+	m_playCursor = 0;
+}
+
+
+
+
+NoteVector::ConstIterator Pattern::firstNoteFrom( const TimePos & pos ) const
+{
+	const auto before = []( const Note * note, const TimePos & p )
+	{
+		return note->pos() < p;
+	};
+
+	// everything before the cursor starts before pos when playing
+	// forward, so only the rest has to be searched. Usually the note
+	// at the cursor is next already
+	NoteVector::ConstIterator from = m_notes.cbegin();
+	if( m_playCursor <= m_notes.size() &&
+		( m_playCursor == 0 || m_notes[m_playCursor - 1]->pos() < pos ) )
+	{
+		from += m_playCursor;
+	}
+
+	NoteVector::ConstIterator it = from == m_notes.cend() || !before( *from, pos )
+		? from
+		: std::lower_bound( from, m_notes.cend(), pos, before );
+	m_playCursor = it - m_notes.cbegin();
+	return it;
 }
 
 
@@ -274,6 +336,7 @@ void Pattern::clearNotes()
 		delete *it;
 	}
 	m_notes.clear();
+	m_playCursor = 0;
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -446,6 +509,8 @@ void Pattern::loadSettings( const QDomElement & _this )
 		}
 		node = node.nextSibling();
         }
+	// playing relies on the notes being sorted
+	rearrangeAllNotes();
 
 	m_steps = _this.attribute( "steps" ).toInt();
 	if( m_steps == 0 )
@@ -63,6 +63,11 @@ SampleTrack::~SampleTrack()
 bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 					const f_cnt_t _offset, int _tco_num )
 {
+	// tracks that can't be heard in an export aren't played
+	if( isBypassed() )
+	{
+		return false;
+	}
 	m_audioPort.effects()->startRunning();
 	bool played_a_note = false;	// will be return variable
 
@@ -118,6 +123,16 @@ bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 			else
 			{
 				sTco->setIsPlaying( false );
+				// let a streamed sample start loading a few seconds
+				// before it's played
+				const int ticksAhead = sTco->startPosition() - _start;
+				if( ticksAhead > 0 && ticksAhead * Engine::framesPerTick() <
+							2 * Engine::mixer()->processingSampleRate() )
+				{
+					const int offset = sTco->startTimeOffset();
+					sTco->sampleBuffer()->prefetch( qMax( -offset, 0 ) *
+						Engine::framesPerTick( sTco->sampleBuffer()->sampleRate() ) );
+				}
 			}
 			nowPlaying = nowPlaying || sTco->isPlaying();
 		}
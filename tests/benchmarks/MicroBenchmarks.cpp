@@ -0,0 +1,859 @@
+/*
+ * MicroBenchmarks.cpp - cost of DSP kernels and engine primitives
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Runs the kernels the render path spends its time in on their own, with
+// synthetic input, and prints what they cost per frame as JSON:
+//
+//   lmms-microbenchmarks [--filter TEXT]... [--min-time SECONDS]
+//                        [--output FILE] [--list]
+//
+// Every benchmark processes one period per run. It is run until the
+// minimum time has passed, in batches of runs, and the cost of a frame is
+// given over the batches. Benchmarks whose name contains one of the
+// filters are run, all of them without a filter. The mixing functions are
+// run with each instruction set the CPU supports.
+
+#include "lmmsconfig.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "AutomatableModel.h"
+#include "AutomationPattern.h"
+#include "BandLimitedWave.h"
+#include "BasicFilterBatch.h"
+#include "BasicFilters.h"
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "MixHelpers.h"
+#include "Mixer.h"
+#include "MixerWorkerThread.h"
+#include "Oscillator.h"
+#include "SampleBuffer.h"
+#include "ThreadableJob.h"
+#include "ValueBuffer.h"
+
+namespace
+{
+
+// bump when the benchmarks change, so older results aren't compared to
+const int Version = 1;
+
+const char * const SampleRate = "44100";
+const char * const FramesPerPeriod = "256";
+
+//! runs before measuring, so caches and branch predictors are warm
+const int WarmupRuns = 20;
+//! the runs measured at once, so the clock's overhead doesn't count
+const int RunsPerBatch = 16;
+
+
+qint64 nanoseconds()
+{
+	using namespace std::chrono;
+	return duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+//! Read after the benchmarks, so the compiler can't drop their output
+volatile float s_sink = 0;
+
+void consume(const sampleFrame * buf, int frames)
+{
+	s_sink = s_sink + buf[0][0] + buf[frames - 1][1];
+}
+
+
+//! A period of a sine, different on each channel
+std::vector<sampleFrame> testSignal(int frames)
+{
+	std::vector<sampleFrame> buf(frames);
+	for (int f = 0; f < frames; ++f)
+	{
+		buf[f][0] = 0.5f * std::sin(f * 0.05f);
+		buf[f][1] = 0.5f * std::cos(f * 0.03f);
+	}
+	return buf;
+}
+
+
+//! What a benchmark runs: @p run processes @p frames frames (or whatever
+//! its unit is) and @p state holds what it works on until it's done
+struct Kernel
+{
+	std::function<void()> run;
+	int frames;
+	std::shared_ptr<void> state;
+} ;
+
+
+struct Benchmark
+{
+	QString name;
+	const char * unit;
+	std::function<Kernel(int period)> build;
+} ;
+
+
+// mixing functions
+
+struct MixState
+{
+	MixState(int frames) :
+		src(testSignal(frames)),
+		dst(testSignal(frames)),
+		values(frames)
+	{
+		values.interpolate(0.2f, 0.8f);
+	}
+
+	std::vector<sampleFrame> src;
+	std::vector<sampleFrame> dst;
+	ValueBuffer values;
+} ;
+
+
+void addMixBenchmarks(std::vector<Benchmark> & list)
+{
+	typedef std::function<void(MixState &, int)> MixFunction;
+	const std::vector<std::pair<const char *, MixFunction>> functions = {
+		{"add", [](MixState & s, int n) {
+			MixHelpers::add(s.dst.data(), s.src.data(), n); }},
+		{"addMultiplied", [](MixState & s, int n) {
+			MixHelpers::addMultiplied(s.dst.data(), s.src.data(), 0.5f, n); }},
+		{"addSwappedMultiplied", [](MixState & s, int n) {
+			MixHelpers::addSwappedMultiplied(s.dst.data(), s.src.data(), 0.5f, n); }},
+		{"addMultipliedByBuffer", [](MixState & s, int n) {
+			MixHelpers::addMultipliedByBuffer(s.dst.data(), s.src.data(), 0.5f, &s.values, n); }},
+		{"addSanitizedMultiplied", [](MixState & s, int n) {
+			MixHelpers::addSanitizedMultiplied(s.dst.data(), s.src.data(), 0.5f, n); }},
+		{"addMultipliedStereo", [](MixState & s, int n) {
+			MixHelpers::addMultipliedStereo(s.dst.data(), s.src.data(), 0.3f, 0.7f, n); }},
+		{"multiplyAndAddMultiplied", [](MixState & s, int n) {
+			MixHelpers::multiplyAndAddMultiplied(s.dst.data(), s.src.data(), 0.5f, 0.5f, n); }},
+		{"analyze", [](MixState & s, int n) {
+			s_sink = s_sink + MixHelpers::analyze(s.src.data(), n).meanSquare; }},
+		{"sanitize", [](MixState & s, int n) {
+			MixHelpers::sanitize(s.dst.data(), n); }},
+		{"isSilent", [](MixState & s, int n) {
+			s_sink = s_sink + MixHelpers::isSilent(s.src.data(), n); }},
+	};
+
+	for (int i = 0; i < MixHelpers::NumInstructionSets; ++i)
+	{
+		const auto set = static_cast<MixHelpers::InstructionSets>(i);
+		if (!MixHelpers::isSupported(set))
+		{
+			continue;
+		}
+		for (const auto & function : functions)
+		{
+			const MixFunction mix = function.second;
+			list.push_back({QString("mix/%1/%2").arg(function.first)
+					.arg(QString(MixHelpers::instructionSetName(set)).toLower()),
+				"frame", [set, mix](int period)
+			{
+				// the instruction set is restored after each benchmark
+				MixHelpers::setInstructionSet(set);
+				auto state = std::make_shared<MixState>(period);
+				MixState * s = state.get();
+				return Kernel{[s, mix, period]() { mix(*s, period); }, period, state};
+			}});
+		}
+	}
+}
+
+
+// oscillators
+
+struct OscillatorState
+{
+	OscillatorState(int wave, int modulation, bool subOscillator, int frames) :
+		waveModel(wave, 0, Oscillator::NumWaveShapes - 1),
+		subWaveModel(Oscillator::SineWave, 0, Oscillator::NumWaveShapes - 1),
+		modulationModel(modulation, 0, Oscillator::NumModulationAlgos - 1),
+		frequency(440.0f),
+		subFrequency(220.0f),
+		detuning(1.0f / Engine::mixer()->processingSampleRate()),
+		phaseOffset(0.0f),
+		volume(1.0f),
+		buf(frames)
+	{
+		// a saw, played by UserDefinedWave
+		std::vector<sampleFrame> saw(256);
+		for (std::size_t f = 0; f < saw.size(); ++f)
+		{
+			saw[f][0] = saw[f][1] = f / 128.0f - 1.0f;
+		}
+		userWave.reset(new SampleBuffer(saw.data(), saw.size()));
+
+		Oscillator * sub = subOscillator
+			? new Oscillator(&subWaveModel, &modulationModel, subFrequency,
+				detuning, phaseOffset, volume)
+			: nullptr;
+		oscillator.reset(new Oscillator(&waveModel, &modulationModel,
+			frequency, detuning, phaseOffset, volume, sub));
+		oscillator->setUserWave(userWave.get());
+	}
+
+	IntModel waveModel;
+	IntModel subWaveModel;
+	IntModel modulationModel;
+	float frequency;
+	float subFrequency;
+	float detuning;
+	float phaseOffset;
+	float volume;
+	std::unique_ptr<SampleBuffer> userWave;
+	std::unique_ptr<Oscillator> oscillator;
+	std::vector<sampleFrame> buf;
+} ;
+
+
+Kernel oscillatorKernel(int wave, int modulation, bool subOscillator, int period)
+{
+	auto state = std::make_shared<OscillatorState>(wave, modulation, subOscillator, period);
+	OscillatorState * s = state.get();
+	return Kernel{[s, period]() {
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			s->oscillator->update(s->buf.data(), period, ch);
+		}
+		consume(s->buf.data(), period);
+	}, period, state};
+}
+
+
+void addOscillatorBenchmarks(std::vector<Benchmark> & list)
+{
+	const char * const waves[] = {"sine", "triangle", "saw", "square",
+		"moogsaw", "exponential", "noise", "userdefined"};
+	for (int wave = 0; wave < Oscillator::NumWaveShapes; ++wave)
+	{
+		list.push_back({QString("oscillator/%1").arg(waves[wave]), "frame",
+			[wave](int period) { return oscillatorKernel(wave, 0, false, period); }});
+	}
+
+	// a saw modulated by a sine
+	const char * const modulations[] = {"pm", "am", "mix", "sync", "fm"};
+	for (int modulation = 0; modulation < Oscillator::NumModulationAlgos; ++modulation)
+	{
+		list.push_back({QString("oscillator/saw-%1").arg(modulations[modulation]), "frame",
+			[modulation](int period)
+			{
+				return oscillatorKernel(Oscillator::SawWave, modulation, true, period);
+			}});
+	}
+}
+
+
+// band limited waves
+
+struct BandLimitedState
+{
+	BandLimitedState(int frames) :
+		phases(frames),
+		out(frames),
+		wavelength(BandLimitedWave::freqToLen(440.0f)),
+		phase(0.0f)
+	{
+	}
+
+	std::vector<float> phases;
+	std::vector<sample_t> out;
+	float wavelength;
+	float phase;
+} ;
+
+
+void addBandLimitedBenchmarks(std::vector<Benchmark> & list)
+{
+	const char * const waves[] = {"saw", "square", "triangle", "moog"};
+	for (int wave = 0; wave < BandLimitedWave::NumBLWaveforms; ++wave)
+	{
+		list.push_back({QString("bandlimited/%1").arg(waves[wave]), "frame",
+			[wave](int period)
+		{
+			auto state = std::make_shared<BandLimitedState>(period);
+			BandLimitedState * s = state.get();
+			return Kernel{[s, wave, period]() {
+				for (int f = 0; f < period; ++f)
+				{
+					s->phases[f] = s->phase + f / s->wavelength;
+				}
+				s->phase = fraction(s->phase + period / s->wavelength);
+				BandLimitedWave::oscillate(s->phases.data(), s->out.data(), period,
+					s->wavelength, static_cast<BandLimitedWave::Waveforms>(wave));
+				s_sink = s_sink + s->out[period - 1];
+			}, period, state};
+		}});
+	}
+}
+
+
+// filters
+
+typedef BasicFilters<DEFAULT_CHANNELS> Filter;
+
+struct FilterState
+{
+	FilterState(int type, int voices, int frames) :
+		in(testSignal(frames)),
+		out(frames)
+	{
+		for (int v = 0; v < voices; ++v)
+		{
+			filters.emplace_back(new Filter(Engine::mixer()->processingSampleRate()));
+			filters.back()->setFilterType(type);
+			filters.back()->calcFilterCoeffs(1000.0f + 500.0f * v, 0.5f);
+			pointers.push_back(filters.back().get());
+		}
+	}
+
+	std::vector<std::unique_ptr<Filter>> filters;
+	std::vector<Filter *> pointers;
+	std::vector<sampleFrame> in;
+	std::vector<sampleFrame> out;
+} ;
+
+
+void addFilterBenchmarks(std::vector<Benchmark> & list)
+{
+	const char * const types[] = {"lowpass", "hipass", "bandpass-csg",
+		"bandpass-czpg", "notch", "allpass", "moog", "doublelowpass",
+		"lowpass-rc12", "bandpass-rc12", "highpass-rc12", "lowpass-rc24",
+		"bandpass-rc24", "highpass-rc24", "formant", "doublemoog",
+		"lowpass-sv", "bandpass-sv", "highpass-sv", "notch-sv",
+		"fastformant", "tripole"};
+	for (int type = 0; type < Filter::NumFilters; ++type)
+	{
+		list.push_back({QString("filter/%1").arg(types[type]), "frame",
+			[type](int period)
+		{
+			auto state = std::make_shared<FilterState>(type, 1, period);
+			FilterState * s = state.get();
+			return Kernel{[s, period]() {
+				Filter * filter = s->pointers[0];
+				for (int f = 0; f < period; ++f)
+				{
+					for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+					{
+						s->out[f][ch] = filter->update(s->in[f][ch], ch);
+					}
+				}
+				consume(s->out.data(), period);
+			}, period, state};
+		}});
+	}
+
+	// BasicFilterBatch, per frame of one voice so it compares to the above
+	const int batchTypes[] = {Filter::LowPass, Filter::Moog};
+	for (int type : batchTypes)
+	{
+		list.push_back({QString("filter/batch-%1").arg(types[type]), "voice frame",
+			[type](int period)
+		{
+			const int voices = BasicFilterBatch::MaxVoices;
+			auto state = std::make_shared<FilterState>(type, voices, period);
+			FilterState * s = state.get();
+			return Kernel{[s, period, voices]() {
+				BasicFilterBatch batch(s->pointers.data(), voices);
+				float io[BasicFilterBatch::Lanes];
+				for (int f = 0; f < period; ++f)
+				{
+					for (int l = 0; l < BasicFilterBatch::Lanes; ++l)
+					{
+						io[l] = s->in[f][l % DEFAULT_CHANNELS];
+					}
+					batch.process(io);
+					s->out[f][0] = io[0];
+					s->out[f][1] = io[BasicFilterBatch::Lanes - 1];
+				}
+				batch.store();
+				consume(s->out.data(), period);
+			}, period * voices, state};
+		}});
+	}
+}
+
+
+// samples
+
+struct SampleState
+{
+	SampleState(int mode, int frames) :
+		buf(frames)
+	{
+		// a second of noise, looped
+		const int sampleFrames = Engine::mixer()->processingSampleRate();
+		std::vector<sampleFrame> data(sampleFrames);
+		for (sampleFrame & frame : data)
+		{
+			frame[0] = frame[1] = fastRandf(2.0f) - 1.0f;
+		}
+		sample.reset(new SampleBuffer(data.data(), sampleFrames));
+		state.reset(new SampleBuffer::handleState(false, mode));
+	}
+
+	std::unique_ptr<SampleBuffer> sample;
+	std::unique_ptr<SampleBuffer::handleState> state;
+	std::vector<sampleFrame> buf;
+} ;
+
+
+void addSampleBenchmarks(std::vector<Benchmark> & list)
+{
+	const std::pair<const char *, int> modes[] = {
+		{"zoh", SRC_ZERO_ORDER_HOLD},
+		{"linear", SRC_LINEAR},
+		{"sinc-fastest", SRC_SINC_FASTEST},
+		{"sinc-medium", SRC_SINC_MEDIUM_QUALITY},
+		{"sinc-best", SRC_SINC_BEST_QUALITY},
+	};
+	for (const auto & mode : modes)
+	{
+		// a fifth up, so it's resampled
+		const int interpolation = mode.second;
+		list.push_back({QString("sample/%1").arg(mode.first), "frame",
+			[interpolation](int period)
+		{
+			auto state = std::make_shared<SampleState>(interpolation, period);
+			SampleState * s = state.get();
+			return Kernel{[s, period]() {
+				s->sample->play(s->buf.data(), s->state.get(), period,
+					s->sample->frequency() * 1.5f, SampleBuffer::LoopOn);
+				consume(s->buf.data(), period);
+			}, period, state};
+		}});
+	}
+	list.push_back({"sample/original-pitch", "frame", [](int period)
+	{
+		auto state = std::make_shared<SampleState>(SRC_LINEAR, period);
+		SampleState * s = state.get();
+		return Kernel{[s, period]() {
+			s->sample->play(s->buf.data(), s->state.get(), period,
+				s->sample->frequency(), SampleBuffer::LoopOn);
+			consume(s->buf.data(), period);
+		}, period, state};
+	}});
+}
+
+
+// automation
+
+void addAutomationBenchmarks(std::vector<Benchmark> & list)
+{
+	list.push_back({"valuebuffer/interpolate", "frame", [](int period)
+	{
+		auto state = std::make_shared<ValueBuffer>(period);
+		ValueBuffer * s = state.get();
+		return Kernel{[s]() {
+			s->interpolate(0.1f, 0.9f);
+			s_sink = s_sink + s->value(s->length() - 1);
+		}, period, state};
+	}});
+
+	const std::pair<const char *, AutomationPattern::ProgressionTypes> progressions[] = {
+		{"discrete", AutomationPattern::DiscreteProgression},
+		{"linear", AutomationPattern::LinearProgression},
+		{"cubic", AutomationPattern::CubicHermiteProgression},
+	};
+	for (const auto & progression : progressions)
+	{
+		// a node every 16th over 16 bars, looked up at every tick like
+		// when it's played
+		const AutomationPattern::ProgressionTypes type = progression.second;
+		list.push_back({QString("automation/valueAt-%1").arg(progression.first), "lookup",
+			[type](int period)
+		{
+			auto state = std::make_shared<AutomationPattern>(nullptr);
+			AutomationPattern * s = state.get();
+			s->setProgressionType(type);
+			const int step = DefaultTicksPerBar / 16;
+			for (int tick = 0; tick <= 16 * DefaultTicksPerBar; tick += step)
+			{
+				s->putValue(TimePos(tick), std::sin(tick * 0.01f), false);
+			}
+			auto tick = std::make_shared<int>(0);
+			return Kernel{[s, tick, period]() {
+				float sum = 0;
+				for (int i = 0; i < period; ++i)
+				{
+					sum += s->valueAt(TimePos(*tick));
+					*tick = (*tick + 1) % (16 * DefaultTicksPerBar);
+				}
+				s_sink = s_sink + sum;
+			}, period, state};
+		}});
+	}
+}
+
+
+// worker threads
+
+class EmptyJob : public ThreadableJob
+{
+public:
+	bool requiresProcessing() const override
+	{
+		return true;
+	}
+
+protected:
+	void doProcessing() override
+	{
+	}
+} ;
+
+
+void addDispatchBenchmarks(std::vector<Benchmark> & list)
+{
+	const int jobCounts[] = {1, 8, 64};
+	for (int jobs : jobCounts)
+	{
+		// the jobs are empty, this is what handing them out costs
+		list.push_back({QString("workers/dispatch-%1").arg(jobs), "job",
+			[jobs](int)
+		{
+			auto state = std::make_shared<std::vector<EmptyJob>>(jobs);
+			std::vector<EmptyJob> * s = state.get();
+			return Kernel{[s]() {
+				MixerWorkerThread::resetJobQueue();
+				for (EmptyJob & job : *s)
+				{
+					MixerWorkerThread::addJob(&job);
+				}
+				MixerWorkerThread::startAndWaitForJobs();
+			}, jobs, state};
+		}});
+	}
+}
+
+
+// FX mixer
+
+//! Channels of the FX mixer, removed again when it's done
+struct FxMixerState
+{
+	FxMixerState(int frames) :
+		input(testSignal(frames)),
+		output(frames)
+	{
+	}
+
+	~FxMixerState()
+	{
+		Engine::fxMixer()->clear();
+	}
+
+	//! routes @p from to @p to instead of the master
+	void route(int from, int to)
+	{
+		Engine::fxMixer()->deleteChannelSend(from, 0);
+		Engine::fxMixer()->createChannelSend(from, to);
+	}
+
+	//! the channels the tracks mix into
+	std::vector<int> inputs;
+	std::vector<sampleFrame> input;
+	std::vector<sampleFrame> output;
+} ;
+
+
+Kernel fxMixerKernel(std::shared_ptr<FxMixerState> state, int period, bool useWorkerThreads)
+{
+	FxMixerState * s = state.get();
+	return Kernel{[s, useWorkerThreads]() {
+		FxMixer * mixer = Engine::fxMixer();
+		mixer->prepareMasterMix();
+		for (int channel : s->inputs)
+		{
+			mixer->mixToChannel(s->input.data(), channel);
+		}
+		mixer->masterMix(s->output.data(), useWorkerThreads);
+		consume(s->output.data(), s->output.size());
+	}, period, state};
+}
+
+
+void addFxMixerBenchmarks(std::vector<Benchmark> & list)
+{
+	// 16 channels into the master
+	auto flat = [](int period)
+	{
+		auto state = std::make_shared<FxMixerState>(period);
+		for (int i = 0; i < 16; ++i)
+		{
+			state->inputs.push_back(Engine::fxMixer()->createChannel());
+		}
+		return state;
+	};
+	list.push_back({"fxmixer/flat-16", "frame", [flat](int period)
+	{
+		return fxMixerKernel(flat(period), period, true);
+	}});
+	list.push_back({"fxmixer/flat-16-single-thread", "frame", [flat](int period)
+	{
+		return fxMixerKernel(flat(period), period, false);
+	}});
+
+	// 16 channels into 4 groups into the master
+	list.push_back({"fxmixer/groups-16-4", "frame", [](int period)
+	{
+		auto state = std::make_shared<FxMixerState>(period);
+		std::vector<int> groups;
+		for (int i = 0; i < 4; ++i)
+		{
+			groups.push_back(Engine::fxMixer()->createChannel());
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			const int channel = Engine::fxMixer()->createChannel();
+			state->route(channel, groups[i % 4]);
+			state->inputs.push_back(channel);
+		}
+		return fxMixerKernel(state, period, true);
+	}});
+
+	// 8 channels in a chain, which can't be processed in parallel
+	list.push_back({"fxmixer/chain-8", "frame", [](int period)
+	{
+		auto state = std::make_shared<FxMixerState>(period);
+		int previous = Engine::fxMixer()->createChannel();
+		state->inputs.push_back(previous);
+		for (int i = 1; i < 8; ++i)
+		{
+			const int channel = Engine::fxMixer()->createChannel();
+			state->route(previous, channel);
+			previous = channel;
+		}
+		return fxMixerKernel(state, period, true);
+	}});
+}
+
+
+const std::vector<Benchmark> & benchmarks()
+{
+	static std::vector<Benchmark> list;
+	if (list.empty())
+	{
+		addMixBenchmarks(list);
+		addOscillatorBenchmarks(list);
+		addBandLimitedBenchmarks(list);
+		addFilterBenchmarks(list);
+		addSampleBenchmarks(list);
+		addAutomationBenchmarks(list);
+		addDispatchBenchmarks(list);
+		addFxMixerBenchmarks(list);
+	}
+	return list;
+}
+
+
+//! mean, median, 99th percentile and minimum of @p values
+QJsonObject statistics(std::vector<double> values)
+{
+	QJsonObject result;
+	if (values.empty())
+	{
+		return result;
+	}
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	for (double value : values)
+	{
+		sum += value;
+	}
+	result["mean"] = sum / values.size();
+	result["p50"] = values[values.size() / 2];
+	result["p99"] = values[values.size() * 99 / 100];
+	result["min"] = values.front();
+	return result;
+}
+
+
+QJsonObject runBenchmark(const Benchmark & benchmark, double minTime)
+{
+	const int period = Engine::mixer()->framesPerPeriod();
+	const Kernel kernel = benchmark.build(period);
+
+	for (int i = 0; i < WarmupRuns; ++i)
+	{
+		kernel.run();
+	}
+
+	std::vector<double> perFrame;
+	const qint64 end = nanoseconds() + static_cast<qint64>(minTime * 1e9);
+	while (nanoseconds() < end || perFrame.size() < 10)
+	{
+		const qint64 begin = nanoseconds();
+		for (int i = 0; i < RunsPerBatch; ++i)
+		{
+			kernel.run();
+		}
+		perFrame.push_back(static_cast<double>(nanoseconds() - begin) /
+			(RunsPerBatch * kernel.frames));
+	}
+
+	QJsonObject result;
+	result["name"] = benchmark.name;
+	result["unit"] = benchmark.unit;
+	result["runs"] = static_cast<int>(perFrame.size() * RunsPerBatch);
+	result["ns_per_frame"] = statistics(perFrame);
+	return result;
+}
+
+
+bool selected(const Benchmark & benchmark, const QStringList & filters)
+{
+	if (filters.isEmpty())
+	{
+		return true;
+	}
+	for (const QString & filter : filters)
+	{
+		if (benchmark.name.contains(filter))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void printJson(const QJsonObject & object, FILE * file = stdout)
+{
+	fputs(QJsonDocument(object).toJson().constData(), file);
+	fflush(file);
+}
+
+} // namespace
+
+
+int main(int argc, char * argv[])
+{
+	QCoreApplication app(argc, argv);
+	const QStringList args = app.arguments();
+
+	QStringList filters;
+	QString output;
+	double minTime = 0.2;
+	bool list = false;
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString & arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+		if (arg == "--list")
+		{
+			list = true;
+		}
+		else if (arg == "--filter" && hasValue)
+		{
+			filters << args[++i];
+		}
+		else if (arg == "--min-time" && hasValue)
+		{
+			minTime = args[++i].toDouble();
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			output = args[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", qUtf8Printable(arg));
+			return EXIT_FAILURE;
+		}
+	}
+
+	// fixed settings instead of the user's configuration
+	ConfigManager::inst()->setValue("mixer", "samplerate", SampleRate);
+	ConfigManager::inst()->setValue("mixer", "framesperaudiobuffer", FramesPerPeriod);
+	Engine::init(true);
+	// nothing but the benchmarks may run
+	Engine::mixer()->stopProcessing();
+
+	if (list)
+	{
+		for (const Benchmark & benchmark : benchmarks())
+		{
+			if (selected(benchmark, filters))
+			{
+				printf("%s\n", qUtf8Printable(benchmark.name));
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+
+	const MixHelpers::InstructionSets instructionSet = MixHelpers::instructionSet();
+	QJsonArray results;
+	for (const Benchmark & benchmark : benchmarks())
+	{
+		if (!selected(benchmark, filters))
+		{
+			continue;
+		}
+		fprintf(stderr, "Running %s...\n", qUtf8Printable(benchmark.name));
+		results.append(runBenchmark(benchmark, minTime));
+		MixHelpers::setInstructionSet(instructionSet);
+	}
+
+	QJsonObject report;
+	report["version"] = Version;
+	report["samplerate"] = SampleRate;
+	report["frames_per_period"] = FramesPerPeriod;
+	report["instruction_set"] = MixHelpers::instructionSetName(instructionSet);
+	report["benchmarks"] = results;
+
+	if (output.isEmpty())
+	{
+		printJson(report);
+	}
+	else
+	{
+		QFile file(output);
+		if (!file.open(QIODevice::WriteOnly))
+		{
+			fprintf(stderr, "Can't write %s\n", qUtf8Printable(output));
+			return EXIT_FAILURE;
+		}
+		file.write(QJsonDocument(report).toJson());
+	}
+
+	return EXIT_SUCCESS;
+}
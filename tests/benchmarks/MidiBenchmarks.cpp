@@ -0,0 +1,495 @@
+/*
+ * MidiBenchmarks.cpp - latency and cost of MIDI input
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Plays synthetic MIDI streams in real time through a raw MIDI client, a
+// MidiPort and an instrument track with TripleOscillator, the way a device
+// and the audio thread would, and prints the results as JSON:
+//
+//   lmms-midi-benchmarks [--stream NAME]... [--seconds SECONDS]
+//                        [--output FILE] [--list]
+//
+// For each stream it measures what handing a message to the client costs
+// the thread of the device, what a period costs to render compared to one
+// without input, how long notes wait until the period they start in is
+// rendered, and how far their onsets are from the frames the time they
+// came in at maps to.
+
+#include "lmmsconfig.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ConfigManager.h"
+#include "DummyInstrument.h"
+#include "Engine.h"
+#include "InstrumentTrack.h"
+#include "MidiClient.h"
+#include "MidiPort.h"
+#include "Mixer.h"
+#include "NotePlayHandle.h"
+#include "Song.h"
+
+namespace
+{
+
+// bump when the streams change, so older results aren't compared to
+const int Version = 1;
+
+const char * const SampleRate = "44100";
+const char * const FramesPerPeriod = "256";
+
+//! periods rendered without input, for the cost of a period
+const int IdlePeriods = 200;
+
+
+qint64 nanoseconds()
+{
+	using namespace std::chrono;
+	return duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+void sleepUntil(qint64 time)
+{
+	const qint64 left = time - nanoseconds();
+	if (left > 0)
+	{
+		std::this_thread::sleep_for(std::chrono::nanoseconds(left));
+	}
+}
+
+
+//! The device the streams come from, its messages are handled on the
+//! thread sending them like those of a backend's thread
+class SyntheticMidiClient : public MidiClientRaw
+{
+public:
+	void send(const std::vector<unsigned char> & message)
+	{
+		processMessage(message.data(), message.size(), 0);
+	}
+
+protected:
+	void sendByte(const unsigned char) override
+	{
+	}
+} ;
+
+
+struct Message
+{
+	f_cnt_t frame;
+	std::vector<unsigned char> data;
+} ;
+
+typedef std::vector<Message> MessageList;
+
+
+//! Notes every @p every frames, @p length frames long, with the keys
+//! going up from @p firstKey over @p keys keys
+void addNotes(MessageList & messages, f_cnt_t frames, f_cnt_t every,
+		f_cnt_t length, int firstKey, int keys)
+{
+	int n = 0;
+	for (f_cnt_t frame = every; frame + length < frames; frame += every, ++n)
+	{
+		const unsigned char key = firstKey + n % keys;
+		messages.push_back({frame, {MidiNoteOn, key, 100}});
+		messages.push_back({frame + length, {MidiNoteOff, key, 0}});
+	}
+}
+
+
+MessageList sparseNotes(f_cnt_t frames, sample_rate_t rate)
+{
+	MessageList messages;
+	addNotes(messages, frames, rate / 10, rate / 20, 48, 24);
+	return messages;
+}
+
+
+MessageList noteStorm(f_cnt_t frames, sample_rate_t rate)
+{
+	MessageList messages;
+	addNotes(messages, frames, rate / 2000, rate / 50, 36, 60);
+	return messages;
+}
+
+
+MessageList denseControllers(f_cnt_t frames, sample_rate_t rate)
+{
+	MessageList messages;
+	const unsigned char controllers[] = {1, 7, 10, 11, 74};
+	int n = 0;
+	for (f_cnt_t frame = 0; frame < frames; frame += rate / 4000, ++n)
+	{
+		messages.push_back({frame, {MidiControlChange, controllers[n % 5],
+			static_cast<unsigned char>(n % 128)}});
+	}
+	addNotes(messages, frames, rate / 20, rate / 40, 48, 24);
+	return messages;
+}
+
+
+MessageList systemExclusive(f_cnt_t frames, sample_rate_t rate)
+{
+	MessageList messages;
+	for (f_cnt_t frame = 0; frame < frames; frame += rate / 200)
+	{
+		std::vector<unsigned char> data(64, 0x55);
+		data.front() = MidiSysEx;
+		data.back() = MidiEOX;
+		messages.push_back({frame, data});
+	}
+	addNotes(messages, frames, rate / 20, rate / 40, 48, 24);
+	return messages;
+}
+
+
+struct Stream
+{
+	const char * name;
+	const char * description;
+	MessageList (*build)(f_cnt_t frames, sample_rate_t rate);
+} ;
+
+const std::vector<Stream> & streams()
+{
+	static const std::vector<Stream> s = {
+		{"sparse", "a note every 100 ms", &sparseNotes},
+		{"note-storm", "2000 notes per second over 60 keys", &noteStorm},
+		{"dense-cc", "4000 controller changes per second and notes", &denseControllers},
+		{"sysex", "200 64-byte SysEx messages per second and notes", &systemExclusive},
+	};
+	return s;
+}
+
+
+//! mean, median, 99th percentile and maximum of @p values
+QJsonObject statistics(std::vector<double> values)
+{
+	QJsonObject result;
+	if (values.empty())
+	{
+		return result;
+	}
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	for (double value : values)
+	{
+		sum += value;
+	}
+	result["mean"] = sum / values.size();
+	result["p50"] = values[values.size() / 2];
+	result["p99"] = values[values.size() * 99 / 100];
+	result["max"] = values.back();
+	return result;
+}
+
+
+//! Renders the next period, called at the time its first frame is due,
+//! and returns how long that took
+qint64 renderPeriod(Mixer * mixer)
+{
+	const qint64 begin = nanoseconds();
+	mixer->nextBufferDone(mixer->nextBuffer());
+	return nanoseconds() - begin;
+}
+
+
+QJsonObject runStream(const Stream & stream, double seconds)
+{
+	Mixer * mixer = Engine::mixer();
+	const sample_rate_t rate = mixer->processingSampleRate();
+	const fpp_t period = mixer->framesPerPeriod();
+	const double periodNanoseconds = 1e9 * period / rate;
+
+	QJsonObject result;
+	result["name"] = stream.name;
+
+	auto track = dynamic_cast<InstrumentTrack *>(
+			Track::create(Track::InstrumentTrack, Engine::getSong()));
+	track->loadInstrument("tripleoscillator");
+	if (dynamic_cast<DummyInstrument *>(track->instrument()))
+	{
+		result["error"] = "TripleOscillator is not available, set LMMS_PLUGIN_DIR";
+		delete track;
+		return result;
+	}
+	SyntheticMidiClient client;
+	MidiPort * port = new MidiPort("benchmark", &client, track, nullptr, MidiPort::Input);
+
+	std::vector<double> idleRender;
+	for (int i = 0; i < IdlePeriods; ++i)
+	{
+		idleRender.push_back(renderPeriod(mixer) * 1e-3);
+	}
+
+	const f_cnt_t frames = static_cast<f_cnt_t>(seconds * rate);
+	MessageList messages = stream.build(frames, rate);
+	std::stable_sort(messages.begin(), messages.end(),
+		[](const Message & a, const Message & b) { return a.frame < b.frame; });
+
+	// the device sends the messages at their frames, in real time
+	std::vector<qint64> sentAt(messages.size());
+	std::vector<double> sendCost(messages.size());
+	const qint64 start = nanoseconds() + 100 * 1000 * 1000;
+	std::thread device([&]()
+	{
+		for (std::size_t i = 0; i < messages.size(); ++i)
+		{
+			sleepUntil(start + static_cast<qint64>(messages[i].frame * 1e9 / rate));
+			sentAt[i] = nanoseconds();
+			client.send(messages[i].data);
+			sendCost[i] = nanoseconds() - sentAt[i];
+		}
+	});
+
+	// a period is rendered when its first frame is due, like an audio
+	// device asks for it, until the last note had time to start
+	const int periods = (frames + rate / 10) / period;
+	std::vector<qint64> renderedAt(periods);
+	std::vector<double> render;
+	int latePeriods = 0;
+
+	struct Onset
+	{
+		int key;
+		f_cnt_t frame;
+	} ;
+	std::vector<Onset> onsets;
+	// frames played of the notes seen in the last period, a note which has
+	// played fewer frames is new even if it got the address of an old one
+	std::unordered_map<const NotePlayHandle *, f_cnt_t> seen;
+
+	for (int p = 0; p < periods; ++p)
+	{
+		const qint64 due = start + static_cast<qint64>(p * periodNanoseconds);
+		latePeriods += nanoseconds() > due + periodNanoseconds;
+		sleepUntil(due);
+		renderedAt[p] = nanoseconds();
+		render.push_back(renderPeriod(mixer) * 1e-3);
+
+		std::unordered_map<const NotePlayHandle *, f_cnt_t> playing;
+		for (const PlayHandle * handle : mixer->playHandles())
+		{
+			const auto note = dynamic_cast<const NotePlayHandle *>(handle);
+			if (!note || note->instrumentTrack() != track || note->hasParent() ||
+				note->totalFramesPlayed() == 0)
+			{
+				continue;
+			}
+			const f_cnt_t played = note->totalFramesPlayed();
+			const auto before = seen.find(note);
+			if (before == seen.end() || before->second > played)
+			{
+				onsets.push_back({note->key(), (p + 1) * period - played});
+			}
+			playing[note] = played;
+		}
+		seen.swap(playing);
+	}
+	device.join();
+
+	// where the note ons should have started: an event is played one
+	// period after it came in, at the end of the period it is handled in
+	std::map<int, std::deque<std::pair<double, qint64>>> expected;
+	int notes = 0;
+	for (std::size_t i = 0; i < messages.size(); ++i)
+	{
+		const auto & data = messages[i].data;
+		if (data[0] == MidiNoteOn)
+		{
+			const double frame = (sentAt[i] - start) * 1e-9 * rate + period - 1;
+			expected[data[1]].push_back({frame, sentAt[i]});
+			++notes;
+		}
+	}
+
+	std::vector<double> onsetError;
+	std::vector<double> queueDelay;
+	for (const Onset & onset : onsets)
+	{
+		auto & queue = expected[onset.key];
+		if (queue.empty())
+		{
+			continue;
+		}
+		onsetError.push_back(onset.frame - queue.front().first);
+		const int p = qBound(0, onset.frame / period, periods - 1);
+		queueDelay.push_back((renderedAt[p] - queue.front().second) * 1e-6);
+		queue.pop_front();
+	}
+
+	double renderSum = 0;
+	for (double r : render)
+	{
+		renderSum += r;
+	}
+	double idleSum = 0;
+	for (double r : idleRender)
+	{
+		idleSum += r;
+	}
+	const double extra = renderSum - idleSum / idleRender.size() * render.size();
+
+	std::vector<double> absoluteError;
+	for (double e : onsetError)
+	{
+		absoluteError.push_back(std::abs(e));
+	}
+
+	result["messages"] = static_cast<int>(messages.size());
+	result["notes"] = notes;
+	result["missed_notes"] = notes - static_cast<int>(onsetError.size());
+	result["send_ns"] = statistics(sendCost);
+	result["idle_render_us"] = statistics(idleRender);
+	result["render_us"] = statistics(render);
+	result["render_ns_per_message"] = messages.empty() ? 0.0 : extra * 1e3 / messages.size();
+	result["late_periods"] = latePeriods;
+	result["queue_delay_ms"] = statistics(queueDelay);
+	result["onset_error_frames"] = statistics(onsetError);
+	result["onset_error_abs_frames"] = statistics(absoluteError);
+
+	delete port;
+	delete track;
+	return result;
+}
+
+
+void printJson(const QJsonObject & object, FILE * file = stdout)
+{
+	fputs(QJsonDocument(object).toJson().constData(), file);
+	fflush(file);
+}
+
+} // namespace
+
+
+int main(int argc, char * argv[])
+{
+	QCoreApplication app(argc, argv);
+	const QStringList args = app.arguments();
+
+	QStringList names;
+	QString output;
+	double seconds = 5;
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString & arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+		if (arg == "--list")
+		{
+			for (const Stream & stream : streams())
+			{
+				printf("%-12s %s\n", stream.name, stream.description);
+			}
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--stream" && hasValue)
+		{
+			names << args[++i];
+		}
+		else if (arg == "--seconds" && hasValue)
+		{
+			seconds = args[++i].toDouble();
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			output = args[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", qUtf8Printable(arg));
+			return EXIT_FAILURE;
+		}
+	}
+
+	// fixed settings instead of the user's configuration
+	ConfigManager::inst()->setValue("mixer", "samplerate", SampleRate);
+	ConfigManager::inst()->setValue("mixer", "framesperaudiobuffer", FramesPerPeriod);
+	Engine::init(true);
+	// the periods are pulled below instead of by the audio device
+	Engine::mixer()->stopProcessing();
+
+	QJsonArray results;
+	bool failed = false;
+	for (const Stream & stream : streams())
+	{
+		if (!names.isEmpty() && !names.contains(stream.name))
+		{
+			continue;
+		}
+		fprintf(stderr, "Playing %s...\n", stream.name);
+		const QJsonObject result = runStream(stream, seconds);
+		if (result.contains("error"))
+		{
+			fprintf(stderr, "%s: %s\n", stream.name,
+				qUtf8Printable(result["error"].toString()));
+			failed = true;
+		}
+		results.append(result);
+	}
+
+	QJsonObject report;
+	report["version"] = Version;
+	report["samplerate"] = SampleRate;
+	report["frames_per_period"] = FramesPerPeriod;
+	report["seconds"] = seconds;
+	report["streams"] = results;
+
+	if (output.isEmpty())
+	{
+		printJson(report);
+	}
+	else
+	{
+		QFile file(output);
+		if (file.open(QIODevice::WriteOnly))
+		{
+			file.write(QJsonDocument(report).toJson());
+		}
+		else
+		{
+			fprintf(stderr, "Can't write %s\n", qUtf8Printable(output));
+			failed = true;
+		}
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
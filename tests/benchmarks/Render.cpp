@@ -0,0 +1,134 @@
+/*
+ * Render.cpp - headless rendering of the benchmark projects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "Render.h"
+
+#include <QFile>
+#include <QJsonDocument>
+
+#include <chrono>
+#include <cstdlib>
+
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "MixerProfiler.h"
+#include "Song.h"
+
+
+void initEngine(const char * sampleRate, int framesPerPeriod, int workerThreads)
+{
+	ConfigManager::inst()->setValue("mixer", "samplerate", sampleRate);
+	ConfigManager::inst()->setValue("mixer", "workerthreads",
+					QString::number(workerThreads));
+	srand(1);
+	Engine::init(true);
+
+	Mixer * mixer = Engine::mixer();
+	mixer->changeQuality(Mixer::qualitySettings(
+				Mixer::qualitySettings::Mode_HighQuality));
+	// the periods are pulled by renderSong() instead of by the audio device
+	mixer->stopProcessing();
+	// a render-only mixer doesn't read the buffer size from the settings
+	mixer->changeFramesPerAudioBuffer(framesPerPeriod);
+}
+
+
+QJsonObject renderSong(Song * song)
+{
+	Mixer * mixer = Engine::mixer();
+	song->setExportLoop(false);
+	song->setRenderBetweenMarkers(false);
+	song->setLoopRenderCount(1);
+
+	MixerProfiler & profiler = mixer->profiler();
+	quint64 stageTimes[MixerProfiler::StageCount];
+	for (int stage = 0; stage < MixerProfiler::StageCount; ++stage)
+	{
+		stageTimes[stage] = profiler.stageTime(
+				static_cast<MixerProfiler::Stages>(stage)).total();
+	}
+
+	const auto begin = std::chrono::steady_clock::now();
+	mixer->setPipelined(true);
+	const int latency = mixer->pipelineLatency();
+	song->startExport();
+	for (int i = 0; i < 1 + latency; ++i)
+	{
+		mixer->nextBufferDone(mixer->nextBuffer());
+	}
+	qint64 frames = 0;
+	while (!song->isExportDone())
+	{
+		mixer->nextBufferDone(mixer->nextBuffer());
+		frames += mixer->framesPerPeriod();
+	}
+	for (int i = 0; i < latency; ++i)
+	{
+		mixer->nextBufferDone(mixer->nextBuffer());
+	}
+	mixer->setPipelined(false);
+	song->stopExport();
+	const double seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - begin).count();
+
+	QJsonObject result;
+	result["frames_per_period"] = mixer->framesPerPeriod();
+	const double audioSeconds = static_cast<double>(frames)
+				/ mixer->processingSampleRate();
+	result["audio_seconds"] = audioSeconds;
+	result["render_seconds"] = seconds;
+	result["realtime_factor"] = seconds > 0 ? audioSeconds / seconds : 0.0;
+	QJsonObject stages;
+	for (int stage = 0; stage < MixerProfiler::StageCount; ++stage)
+	{
+		const auto s = static_cast<MixerProfiler::Stages>(stage);
+		stages[MixerProfiler::stageName(s)] =
+				(profiler.stageTime(s).total() - stageTimes[stage]) * 1e-9;
+	}
+	result["stage_seconds"] = stages;
+	result["peak_memory_kib"] = static_cast<double>(MixerProfiler::peakMemoryKiB());
+	return result;
+}
+
+
+void printJson(const QJsonObject & object, FILE * file)
+{
+	fputs(QJsonDocument(object).toJson().constData(), file);
+	fflush(file);
+}
+
+
+bool writeJson(const QString & fileName, const QJsonObject & object)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		fprintf(stderr, "Can't write %s\n", qUtf8Printable(fileName));
+		return false;
+	}
+	file.write(QJsonDocument(object).toJson());
+	return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Render.h - headless rendering of the benchmark projects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef BENCHMARK_RENDER_H
+#define BENCHMARK_RENDER_H
+
+#include <QJsonObject>
+
+#include <cstdio>
+
+class Song;
+
+
+//! Starts the engine without GUI and audio device, with the given settings
+//! instead of the user's configuration. @p workerThreads 0 lets the mixer
+//! choose. The mixer limits @p framesPerPeriod to MINIMUM_BUFFER_SIZE and
+//! DEFAULT_BUFFER_SIZE.
+void initEngine(const char * sampleRate, int framesPerPeriod, int workerThreads = 0);
+
+/*! Renders the whole @p song like ProjectRenderer, without encoding, and
+ *  returns "frames_per_period" the mixer rendered with, "audio_seconds",
+ *  "render_seconds", "realtime_factor", "stage_seconds" by stage of the
+ *  MixerProfiler and "peak_memory_kib".
+ */
+QJsonObject renderSong(Song * song);
+
+void printJson(const QJsonObject & object, FILE * file = stdout);
+
+bool writeJson(const QString & fileName, const QJsonObject & object);
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ * Scenarios.cpp - reference projects of the render benchmarks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "Scenarios.h"
+
+#include <cmath>
+#include <random>
+
+#include "AutomationPattern.h"
+#include "AutomationTrack.h"
+#include "DummyInstrument.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "InstrumentTrack.h"
+#include "lmms_constants.h"
+#include "Mixer.h"
+#include "Pattern.h"
+#include "SampleBuffer.h"
+#include "SampleTCO.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
+namespace
+{
+
+const unsigned Seed = 1;
+const int TicksPerBar = DefaultTicksPerBar;
+const int TicksPerStep = DefaultTicksPerBar / DefaultStepsPerBar;
+
+
+InstrumentTrack * addTripleOscillator(Song * song, QString & error)
+{
+	auto track = dynamic_cast<InstrumentTrack*>(
+				Track::create(Track::InstrumentTrack, song));
+	track->loadInstrument("tripleoscillator");
+	if (dynamic_cast<DummyInstrument*>(track->instrument()))
+	{
+		error = "TripleOscillator is not available, set LMMS_PLUGIN_DIR";
+	}
+	return track;
+}
+
+
+//! A pattern of @p bars bars at @p bar with a chord of @p voices notes of
+//! @p length ticks on every @p step ticks
+void addChords(InstrumentTrack * track, int bar, int bars, int step,
+		int length, int voices, std::minstd_rand & random)
+{
+	auto pattern = dynamic_cast<Pattern*>(
+				track->createTCO(TimePos(bar, 0)));
+	std::uniform_int_distribution<int> root(36, 72);
+	for (int pos = 0; pos < bars * TicksPerBar; pos += step)
+	{
+		const int key = root(random);
+		for (int voice = 0; voice < voices; ++voice)
+		{
+			pattern->addNote(Note(TimePos(length), TimePos(pos),
+						key + voice * 4), false);
+		}
+	}
+	pattern->changeLength(TimePos(bars, 0));
+}
+
+
+QString buildVoices(Song * song)
+{
+	// 8 tracks with 4 note chords every step, lasting 4 steps: about
+	// 128 voices at once
+	std::minstd_rand random(Seed);
+	QString error;
+	for (int t = 0; t < 8 && error.isEmpty(); ++t)
+	{
+		InstrumentTrack * track = addTripleOscillator(song, error);
+		addChords(track, 0, 16, TicksPerStep, 4 * TicksPerStep, 4, random);
+	}
+	return error;
+}
+
+
+QString buildSamples(Song * song)
+{
+	// a kit of 8 pieces, each on a track of its own, with a hit on
+	// most steps of 16 bars
+	std::minstd_rand random(Seed);
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	for (int piece = 0; piece < 8; ++piece)
+	{
+		auto track = dynamic_cast<SampleTrack*>(
+					Track::create(Track::SampleTrack, song));
+		const float frequency = 50.0f * (piece + 1);
+		const float noise = piece / 8.0f;
+		const float seconds = 0.2f + 0.1f * (piece % 4);
+		SampleBuffer * sample = drumSample(frequency, noise, seconds, random);
+		for (int step = 0; step < 16 * DefaultStepsPerBar; ++step)
+		{
+			if (chance(random) < 0.25f)
+			{
+				continue;
+			}
+			auto tco = dynamic_cast<SampleTCO*>(
+					track->createTCO(TimePos(step * TicksPerStep)));
+			// the clips share the sample like ones of the same file
+			tco->setSampleBuffer(sharedObject::ref(sample));
+		}
+		sharedObject::unref(sample);
+	}
+	return QString();
+}
+
+
+QString buildFxTree(Song * song)
+{
+	// 31 FX channels as a binary tree below the master, with 16 tracks
+	// on the leaves
+	FxMixer * fxMixer = Engine::fxMixer();
+	const int channels = 31;
+	for (int ch = 1; ch <= channels; ++ch)
+	{
+		fxMixer->createChannel();
+		if (ch > 1)
+		{
+			fxMixer->deleteChannelSend(ch, 0);
+			fxMixer->createChannelSend(ch, ch / 2, 0.7f);
+		}
+	}
+
+	std::minstd_rand random(Seed);
+	QString error;
+	for (int t = 0; t < 16 && error.isEmpty(); ++t)
+	{
+		InstrumentTrack * track = addTripleOscillator(song, error);
+		track->effectChannelModel()->setValue(16 + t);
+		addChords(track, 0, 16, 2 * TicksPerStep, 2 * TicksPerStep, 1, random);
+	}
+	return error;
+}
+
+
+QString buildAutomation(Song * song)
+{
+	// 8 tracks with their volume, panning and pitch automated by
+	// patterns with a point on every step
+	std::minstd_rand random(Seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	QString error;
+	Track * automationTrack = Track::create(Track::AutomationTrack, song);
+	for (int t = 0; t < 8 && error.isEmpty(); ++t)
+	{
+		InstrumentTrack * track = addTripleOscillator(song, error);
+		addChords(track, 0, 16, 2 * TicksPerStep, 2 * TicksPerStep, 2, random);
+
+		FloatModel * models[] = { track->volumeModel(),
+				track->panningModel(), track->pitchModel() };
+		for (FloatModel * model : models)
+		{
+			auto pattern = dynamic_cast<AutomationPattern*>(
+					automationTrack->createTCO(TimePos(0)));
+			pattern->setProgressionType(
+					AutomationPattern::LinearProgression);
+			pattern->addObject(model);
+			for (int step = 0; step <= 16 * DefaultStepsPerBar; ++step)
+			{
+				const float value = model->minValue() + unit(random)
+						* (model->maxValue() - model->minValue());
+				pattern->putValue(TimePos(step * TicksPerStep), value, false);
+			}
+		}
+	}
+	return error;
+}
+
+
+QString buildArrangement(Song * song)
+{
+	// 128 bars of 4 tracks with a pattern for every bar, so the song
+	// has to find the patterns to play among many
+	std::minstd_rand random(Seed);
+	QString error;
+	song->setTempo(174);
+	for (int t = 0; t < 4 && error.isEmpty(); ++t)
+	{
+		InstrumentTrack * track = addTripleOscillator(song, error);
+		for (int bar = 0; bar < 128; ++bar)
+		{
+			addChords(track, bar, 1, 4 * TicksPerStep,
+						2 * TicksPerStep, 2, random);
+		}
+	}
+	return error;
+}
+
+} // namespace
+
+
+const std::vector<Scenario> & scenarios()
+{
+	static const std::vector<Scenario> list = {
+		{ "voices", "Many TripleOscillator voices", buildVoices },
+		{ "samples", "Sample-heavy drum kit", buildSamples },
+		{ "fxtree", "Deep FX routing tree", buildFxTree },
+		{ "automation", "Heavy automation", buildAutomation },
+		{ "arrangement", "Long arrangement", buildArrangement },
+	};
+	return list;
+}
+
+
+const Scenario * findScenario(const QString & name)
+{
+	for (const Scenario & scenario : scenarios())
+	{
+		if (name == scenario.name)
+		{
+			return &scenario;
+		}
+	}
+	return nullptr;
+}
+
+
+SampleBuffer * drumSample(float frequency, float noise, float seconds,
+						std::minstd_rand & random)
+{
+	const sample_rate_t sampleRate = Engine::mixer()->processingSampleRate();
+	const f_cnt_t frames = static_cast<f_cnt_t>(seconds * sampleRate);
+	std::vector<sampleFrame> data(frames);
+	std::uniform_real_distribution<float> white(-1.0f, 1.0f);
+	float phase = 0.0f;
+	for (f_cnt_t f = 0; f < frames; ++f)
+	{
+		const float t = static_cast<float>(f) / sampleRate;
+		const float envelope = std::exp(-t * 8.0f / seconds);
+		phase += 2.0f * F_PI * frequency * (1.0f + 2.0f * envelope) / sampleRate;
+		const float value = envelope * ((1.0f - noise) * std::sin(phase)
+						+ noise * white(random));
+		data[f][0] = data[f][1] = 0.5f * value;
+	}
+	return new SampleBuffer(data.data(), frames);
+}
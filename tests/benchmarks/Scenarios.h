@@ -0,0 +1,58 @@
+/*
+ * Scenarios.h - reference projects of the render benchmarks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef BENCHMARK_SCENARIOS_H
+#define BENCHMARK_SCENARIOS_H
+
+#include <QString>
+#include <random>
+#include <vector>
+
+class SampleBuffer;
+class Song;
+
+
+/*! A reference project, built in code so it's the same on every machine and
+ *  doesn't depend on presets or sample files. Random choices are made with
+ *  a generator seeded with the same value for every run.
+ */
+struct Scenario
+{
+	const char * name;
+	const char * description;
+	//! Adds the tracks to the empty @p song, returns an error message if
+	//! something the project needs is missing
+	QString (*build)(Song * song);
+};
+
+const std::vector<Scenario> & scenarios();
+
+const Scenario * findScenario(const QString & name);
+
+//! A percussive sound of @p seconds: a falling sine, mixed with noise
+SampleBuffer * drumSample(float frequency, float noise, float seconds,
+						std::minstd_rand & random);
+
+#endif
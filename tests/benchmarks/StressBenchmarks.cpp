@@ -0,0 +1,341 @@
+/*
+ * StressBenchmarks.cpp - how the engine scales with synthetic projects
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+
+// Builds a synthetic project of the size given by the options of
+// StressProject and renders it with each number of threads and buffer size
+// in a process of its own, then prints how the realtime factor scales with
+// the threads, by stage of the mixer, and writes the results as JSON:
+//
+//   lmms-stress-benchmarks [PROJECT OPTIONS] [--threads N,...]
+//                          [--buffer-sizes FRAMES,...] [--output FILE]
+//                          [--save FILE]
+//
+// The threads are the rendering thread of the mixer and its workers, so
+// the fewest are 2. --save writes the project instead, e.g. to look at it
+// in LMMS.
+
+#include "lmmsconfig.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QStringList>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Engine.h"
+#include "Mixer.h"
+#include "MixerProfiler.h"
+#include "Render.h"
+#include "Song.h"
+#include "StressProject.h"
+
+namespace
+{
+
+const int Version = 1;
+
+const char * const SampleRate = "44100";
+
+
+//! "1,2,4" to numbers, empty if any of them isn't a positive number
+QVector<int> parseList(const QString & text)
+{
+	QVector<int> numbers;
+	for (const QString & item : text.split(',', QString::SkipEmptyParts))
+	{
+		bool ok = false;
+		const int number = item.toInt(&ok);
+		if (!ok || number <= 0)
+		{
+			return QVector<int>();
+		}
+		numbers.append(number);
+	}
+	return numbers;
+}
+
+
+//! 2, 4, 8... up to the number of cores, and that number
+QVector<int> defaultThreads()
+{
+	const int cores = qMax(2, QThread::idealThreadCount());
+	QVector<int> threads;
+	for (int n = 2; n < cores; n *= 2)
+	{
+		threads.append(n);
+	}
+	threads.append(cores);
+	return threads;
+}
+
+
+//! Renders @p project in this process and prints the result
+int runProject(const StressProject & project, int threads, int framesPerPeriod)
+{
+	initEngine(SampleRate, framesPerPeriod, threads - 1);
+
+	Song * song = Engine::getSong();
+	const QString error = project.build(song);
+	QJsonObject result;
+	if (!error.isEmpty())
+	{
+		result["error"] = error;
+		printJson(result);
+		return EXIT_FAILURE;
+	}
+	result = renderSong(song);
+	printJson(result);
+	return EXIT_SUCCESS;
+}
+
+
+int saveProject(const StressProject & project, const QString & fileName)
+{
+	initEngine(SampleRate, 256);
+
+	Song * song = Engine::getSong();
+	const QString error = project.build(song);
+	if (!error.isEmpty())
+	{
+		fprintf(stderr, "%s\n", qUtf8Printable(error));
+		return EXIT_FAILURE;
+	}
+	if (!song->saveProjectFile(fileName))
+	{
+		fprintf(stderr, "Can't write %s\n", qUtf8Printable(fileName));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+//! Renders @p project in a child process and returns its result
+QJsonObject runChild(const StressProject & project, int threads, int framesPerPeriod)
+{
+	QProcess child;
+	child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	child.start(QCoreApplication::applicationFilePath(), project.toArguments()
+			<< "--run" << QString::number(threads)
+			<< QString::number(framesPerPeriod));
+	child.waitForFinished(-1);
+
+	QJsonObject result = QJsonDocument::fromJson(
+					child.readAllStandardOutput()).object();
+	if (result.isEmpty())
+	{
+		result["error"] = QString("the benchmark exited with %1")
+						.arg(child.exitCode());
+	}
+	result["threads"] = threads;
+	if (!result.contains("frames_per_period"))
+	{
+		result["frames_per_period"] = framesPerPeriod;
+	}
+	return result;
+}
+
+
+//! Prints the realtime factor of the runs with @p framesPerPeriod, its
+//! speedup and efficiency against the fewest threads, and the share of
+//! each stage in the time of the mixer
+void printScaling(const QJsonArray & runs, int framesPerPeriod)
+{
+	fprintf(stderr, "\n%d frames per period\n%7s %9s %8s %10s",
+			framesPerPeriod, "threads", "realtime", "speedup", "efficiency");
+	for (int stage = 0; stage < MixerProfiler::StageCount; ++stage)
+	{
+		fprintf(stderr, " %12s", MixerProfiler::stageName(
+				static_cast<MixerProfiler::Stages>(stage)));
+	}
+	fputc('\n', stderr);
+
+	double firstFactor = 0;
+	int firstThreads = 0;
+	for (const QJsonValue & value : runs)
+	{
+		const QJsonObject run = value.toObject();
+		if (run["frames_per_period"].toInt() != framesPerPeriod ||
+							run.contains("error"))
+		{
+			continue;
+		}
+		const int threads = run["threads"].toInt();
+		const double factor = run["realtime_factor"].toDouble();
+		if (firstFactor <= 0)
+		{
+			firstFactor = factor;
+			firstThreads = threads;
+		}
+		const double speedup = firstFactor > 0 ? factor / firstFactor : 0;
+		const double efficiency = speedup * firstThreads / threads;
+		fprintf(stderr, "%7d %8.2fx %7.2fx %9.0f%%", threads, factor,
+						speedup, efficiency * 100.0);
+
+		const QJsonObject stages = run["stage_seconds"].toObject();
+		double total = 0;
+		for (const QJsonValue & seconds : stages)
+		{
+			total += seconds.toDouble();
+		}
+		for (int stage = 0; stage < MixerProfiler::StageCount; ++stage)
+		{
+			const double seconds = stages[MixerProfiler::stageName(
+				static_cast<MixerProfiler::Stages>(stage))].toDouble();
+			fprintf(stderr, " %11.0f%%", total > 0 ? seconds / total * 100.0 : 0.0);
+		}
+		fputc('\n', stderr);
+	}
+}
+
+
+void printUsage()
+{
+	fprintf(stderr, "Usage: lmms-stress-benchmarks [OPTIONS]\n\n");
+	StressProject::printUsage();
+	fprintf(stderr,
+		"  --threads N,...               rendering threads to compare\n"
+		"                                (2, 4, 8... up to the cores)\n"
+		"  --buffer-sizes FRAMES,...     frames per period, 32 to 256\n"
+		"                                (256)\n"
+		"  --output FILE                 write the results to FILE\n"
+		"  --save FILE                   write the project to FILE instead\n"
+		"                                of rendering it\n");
+}
+
+} // namespace
+
+
+int main(int argc, char * argv[])
+{
+	QCoreApplication app(argc, argv);
+	const QStringList args = app.arguments();
+
+	StressProject project;
+	QVector<int> threads = defaultThreads();
+	QVector<int> bufferSizes = { 256 };
+	QString output;
+	QString save;
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString & arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+		if (project.parseOption(args, i))
+		{
+			continue;
+		}
+		if (arg == "--run" && i + 2 < args.size())
+		{
+			return runProject(project, args[i + 1].toInt(), args[i + 2].toInt());
+		}
+		else if (arg == "--threads" && hasValue)
+		{
+			threads = parseList(args[++i]);
+		}
+		else if (arg == "--buffer-sizes" && hasValue)
+		{
+			bufferSizes = parseList(args[++i]);
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			output = args[++i];
+		}
+		else if (arg == "--save" && hasValue)
+		{
+			save = args[++i];
+		}
+		else
+		{
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (threads.isEmpty() || bufferSizes.isEmpty() ||
+		*std::min_element(threads.begin(), threads.end()) < 2)
+	{
+		fprintf(stderr, "The threads and buffer sizes have to be lists of "
+				"numbers, with at least 2 threads.\n");
+		return EXIT_FAILURE;
+	}
+	// the mixer splits larger buffers into periods of DEFAULT_BUFFER_SIZE,
+	// so larger sizes would really be rendered with 256 frames
+	const auto sizes = std::minmax_element(bufferSizes.begin(), bufferSizes.end());
+	if (*sizes.first < MINIMUM_BUFFER_SIZE || *sizes.second > DEFAULT_BUFFER_SIZE)
+	{
+		fprintf(stderr, "The buffer sizes have to be from %d to %d frames.\n",
+				MINIMUM_BUFFER_SIZE, DEFAULT_BUFFER_SIZE);
+		return EXIT_FAILURE;
+	}
+
+	if (!save.isEmpty())
+	{
+		return saveProject(project, save);
+	}
+
+	QJsonArray runs;
+	bool failed = false;
+	for (const int frames : bufferSizes)
+	{
+		for (const int n : threads)
+		{
+			fprintf(stderr, "Rendering with %d threads, %d frames per period...\n",
+									n, frames);
+			const QJsonObject run = runChild(project, n, frames);
+			if (run.contains("error"))
+			{
+				fprintf(stderr, "%s\n", qUtf8Printable(run["error"].toString()));
+				failed = true;
+			}
+			runs.append(run);
+		}
+	}
+	for (const int frames : bufferSizes)
+	{
+		printScaling(runs, frames);
+	}
+
+	QJsonObject report;
+	report["version"] = Version;
+	report["samplerate"] = SampleRate;
+	report["quality"] = "high";
+	report["cores"] = QThread::idealThreadCount();
+	report["project"] = project.toJson();
+	report["runs"] = runs;
+
+	if (!output.isEmpty())
+	{
+		failed |= !writeJson(output, report);
+	}
+	else
+	{
+		printJson(report);
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
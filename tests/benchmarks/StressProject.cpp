@@ -0,0 +1,296 @@
+/*
+ * StressProject.cpp - synthetic projects of configurable size
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "StressProject.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "AutomationPattern.h"
+#include "AutomationTrack.h"
+#include "DummyInstrument.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "InstrumentTrack.h"
+#include "Pattern.h"
+#include "SampleBuffer.h"
+#include "SampleTCO.h"
+#include "SampleTrack.h"
+#include "Scenarios.h"
+#include "Song.h"
+
+namespace
+{
+
+const unsigned Seed = 1;
+const int TicksPerBar = DefaultTicksPerBar;
+
+
+//! "tripleoscillator:8,kicker:2" to pairs of names and counts
+bool parseInstruments(const QString & text, QVector<QPair<QString, int>> & instruments)
+{
+	instruments.clear();
+	for (const QString & item : text.split(',', QString::SkipEmptyParts))
+	{
+		const QStringList parts = item.split(':');
+		bool ok = parts.size() == 1;
+		const int count = parts.size() == 2 ? parts[1].toInt(&ok) : 1;
+		if (!ok || count < 0)
+		{
+			return false;
+		}
+		instruments.append(qMakePair(parts[0].trimmed(), count));
+	}
+	return true;
+}
+
+
+//! A pattern over all @p bars with @p notesPerBar notes of random keys,
+//! each lasting until the next one
+void addNotes(InstrumentTrack * track, int bars, int notesPerBar,
+						std::minstd_rand & random)
+{
+	auto pattern = dynamic_cast<Pattern*>(track->createTCO(TimePos(0)));
+	std::uniform_int_distribution<int> key(36, 84);
+	const int step = std::max(1, TicksPerBar / std::max(1, notesPerBar));
+	for (int bar = 0; bar < bars; ++bar)
+	{
+		for (int n = 0; n < notesPerBar; ++n)
+		{
+			const int pos = bar * TicksPerBar + n * TicksPerBar / notesPerBar;
+			pattern->addNote(Note(TimePos(step), TimePos(pos), key(random)), false);
+		}
+	}
+	pattern->changeLength(TimePos(bars, 0));
+}
+
+
+//! Points on every 1 / @p perBar bars between the limits of @p model
+void addAutomation(Track * automationTrack, FloatModel * model, int bars,
+					int perBar, std::minstd_rand & random)
+{
+	auto pattern = dynamic_cast<AutomationPattern*>(
+				automationTrack->createTCO(TimePos(0)));
+	pattern->setProgressionType(AutomationPattern::LinearProgression);
+	pattern->addObject(model);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (int point = 0; point <= bars * perBar; ++point)
+	{
+		const float value = model->minValue() + unit(random)
+					* (model->maxValue() - model->minValue());
+		pattern->putValue(TimePos(point * TicksPerBar / perBar), value, false);
+	}
+}
+
+} // namespace
+
+
+bool StressProject::parseOption(const QStringList & args, int & i)
+{
+	if (i + 1 >= args.size())
+	{
+		return false;
+	}
+	const QString & arg = args[i];
+	const QString & value = args[i + 1];
+	bool ok = true;
+	if (arg == "--instruments")
+	{
+		ok = parseInstruments(value, instruments);
+	}
+	else if (arg == "--sample-tracks")
+	{
+		sampleTracks = value.toInt(&ok);
+	}
+	else if (arg == "--bars")
+	{
+		bars = value.toInt(&ok);
+		ok = ok && bars > 0;
+	}
+	else if (arg == "--notes-per-bar")
+	{
+		notesPerBar = value.toInt(&ok);
+	}
+	else if (arg == "--fx-channels")
+	{
+		fxChannels = value.toInt(&ok);
+	}
+	else if (arg == "--routing-depth")
+	{
+		routingDepth = value.toInt(&ok);
+		ok = ok && routingDepth > 0;
+	}
+	else if (arg == "--automation-per-bar")
+	{
+		automationPerBar = value.toInt(&ok);
+	}
+	else
+	{
+		return false;
+	}
+	if (!ok)
+	{
+		fprintf(stderr, "Invalid value \"%s\" of %s\n",
+				qUtf8Printable(value), qUtf8Printable(arg));
+		return false;
+	}
+	++i;
+	return true;
+}
+
+
+QStringList StressProject::toArguments() const
+{
+	QStringList names;
+	for (const auto & instrument : instruments)
+	{
+		names << QString("%1:%2").arg(instrument.first).arg(instrument.second);
+	}
+	return QStringList()
+		<< "--instruments" << names.join(',')
+		<< "--sample-tracks" << QString::number(sampleTracks)
+		<< "--bars" << QString::number(bars)
+		<< "--notes-per-bar" << QString::number(notesPerBar)
+		<< "--fx-channels" << QString::number(fxChannels)
+		<< "--routing-depth" << QString::number(routingDepth)
+		<< "--automation-per-bar" << QString::number(automationPerBar);
+}
+
+
+QJsonObject StressProject::toJson() const
+{
+	QJsonObject object;
+	QJsonObject counts;
+	for (const auto & instrument : instruments)
+	{
+		counts[instrument.first] = instrument.second;
+	}
+	object["instruments"] = counts;
+	object["sample_tracks"] = sampleTracks;
+	object["bars"] = bars;
+	object["notes_per_bar"] = notesPerBar;
+	object["fx_channels"] = fxChannels;
+	object["routing_depth"] = routingDepth;
+	object["automation_per_bar"] = automationPerBar;
+	return object;
+}
+
+
+QString StressProject::build(Song * song) const
+{
+	std::minstd_rand random(Seed);
+
+	// chains of routingDepth channels, each sending to the one before
+	FxMixer * fxMixer = Engine::fxMixer();
+	QVector<int> leaves;
+	for (int ch = 1; ch <= fxChannels; ++ch)
+	{
+		fxMixer->createChannel();
+		const bool lastOfChain = ch % routingDepth == 0 || ch == fxChannels;
+		if ((ch - 1) % routingDepth != 0)
+		{
+			fxMixer->deleteChannelSend(ch, 0);
+			fxMixer->createChannelSend(ch, ch - 1, 1.0f);
+		}
+		if (lastOfChain)
+		{
+			leaves.append(ch);
+		}
+	}
+	int nextLeaf = 0;
+	const auto leaf = [&leaves, &nextLeaf]()
+	{
+		return leaves.isEmpty() ? 0 : leaves[nextLeaf++ % leaves.size()];
+	};
+
+	Track * automationTrack = automationPerBar > 0 ?
+			Track::create(Track::AutomationTrack, song) : nullptr;
+	for (const auto & instrument : instruments)
+	{
+		for (int t = 0; t < instrument.second; ++t)
+		{
+			auto track = dynamic_cast<InstrumentTrack*>(
+					Track::create(Track::InstrumentTrack, song));
+			track->loadInstrument(instrument.first);
+			if (dynamic_cast<DummyInstrument*>(track->instrument()))
+			{
+				return QString("%1 is not available, set LMMS_PLUGIN_DIR")
+							.arg(instrument.first);
+			}
+			track->effectChannelModel()->setValue(leaf());
+			if (notesPerBar > 0)
+			{
+				addNotes(track, bars, notesPerBar, random);
+			}
+			if (automationTrack)
+			{
+				addAutomation(automationTrack, track->volumeModel(),
+						bars, automationPerBar, random);
+				addAutomation(automationTrack, track->panningModel(),
+						bars, automationPerBar, random);
+			}
+		}
+	}
+
+	// drum hits on three of four notes of the grid
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	for (int t = 0; t < sampleTracks; ++t)
+	{
+		auto track = dynamic_cast<SampleTrack*>(
+					Track::create(Track::SampleTrack, song));
+		track->effectChannelModel()->setValue(leaf());
+		SampleBuffer * sample = drumSample(50.0f * (t % 8 + 1),
+				(t % 8) / 8.0f, 0.2f + 0.1f * (t % 4), random);
+		for (int hit = 0; hit < bars * notesPerBar; ++hit)
+		{
+			if (chance(random) < 0.25f)
+			{
+				continue;
+			}
+			auto tco = dynamic_cast<SampleTCO*>(track->createTCO(
+					TimePos(hit * TicksPerBar / notesPerBar)));
+			tco->setSampleBuffer(sharedObject::ref(sample));
+		}
+		sharedObject::unref(sample);
+	}
+	return QString();
+}
+
+
+void StressProject::printUsage()
+{
+	fprintf(stderr,
+		"  --instruments NAME:COUNT,...  instrument tracks by plugin\n"
+		"                                (tripleoscillator:8)\n"
+		"  --sample-tracks N             sample tracks (4)\n"
+		"  --bars N                      length of the song (16)\n"
+		"  --notes-per-bar N             notes and sample hits per bar (8)\n"
+		"  --fx-channels N               FX channels (8)\n"
+		"  --routing-depth N             FX channels in a chain to the\n"
+		"                                master (2)\n"
+		"  --automation-per-bar N        points of the volume and panning\n"
+		"                                automation per bar (4)\n");
+}
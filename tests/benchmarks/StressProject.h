@@ -0,0 +1,77 @@
+/*
+ * StressProject.h - synthetic projects of configurable size
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef BENCHMARK_STRESS_PROJECT_H
+#define BENCHMARK_STRESS_PROJECT_H
+
+#include <QJsonObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class Song;
+
+
+/*! The size of a synthetic project, to see how the engine scales with it.
+ *  Like the scenarios, the project is built in code from a seeded
+ *  generator, so building it twice with the same settings gives the same
+ *  project.
+ *
+ *  The FX channels form chains of routingDepth channels, the first of each
+ *  chain sending to the master. Instrument and sample tracks are spread
+ *  over the last channels of the chains, so their sound passes the whole
+ *  chain.
+ */
+struct StressProject
+{
+	//! Instrument plugins by name, e.g. "tripleoscillator", and the
+	//! number of tracks with each
+	QVector<QPair<QString, int>> instruments = { { "tripleoscillator", 8 } };
+	int sampleTracks = 4;
+	int bars = 16;
+	int notesPerBar = 8;
+	int fxChannels = 8;
+	int routingDepth = 2;
+	//! Points per bar of the automation of volume and panning of every
+	//! instrument track, 0 for none
+	int automationPerBar = 4;
+
+	//! Reads the option at @p args[i] and its value, advancing @p i past
+	//! them. Returns false if it isn't an option of the project.
+	bool parseOption(const QStringList & args, int & i);
+	//! The options which give this project to parseOption()
+	QStringList toArguments() const;
+	QJsonObject toJson() const;
+
+	//! Adds the tracks, FX channels and automation to the empty @p song,
+	//! returns an error message if an instrument is missing
+	QString build(Song * song) const;
+
+	//! Prints the options of parseOption()
+	static void printUsage();
+};
+
+#endif
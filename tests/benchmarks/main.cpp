@@ -0,0 +1,267 @@
+/*
+ * main.cpp - headless runner of the render benchmarks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+// Renders each scenario of Scenarios.cpp in a process of its own, so the
+// peak memory is that of the scenario and no state is carried over, and
+// prints the results as JSON:
+//
+//   lmms-benchmarks [--scenario NAME]... [--output FILE]
+//                   [--baseline FILE] [--tolerance PERCENT]
+//                   [--save-baseline FILE] [--list]
+
+#include "lmmsconfig.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStringList>
+#include <QThread>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "Engine.h"
+#include "Render.h"
+#include "Scenarios.h"
+
+namespace
+{
+
+// bump when the scenarios change, so older baselines aren't compared to
+const int Version = 1;
+
+const char * const SampleRate = "44100";
+const int FramesPerPeriod = 256;
+
+//! Renders @p scenario in this process and prints the result
+int runScenario(const Scenario & scenario)
+{
+	initEngine(SampleRate, FramesPerPeriod);
+
+	QJsonObject result;
+	result["name"] = scenario.name;
+
+	Song * song = Engine::getSong();
+	const QString error = scenario.build(song);
+	if (!error.isEmpty())
+	{
+		result["error"] = error;
+		printJson(result);
+		return EXIT_FAILURE;
+	}
+
+	const QJsonObject rendered = renderSong(song);
+	for (auto it = rendered.begin(); it != rendered.end(); ++it)
+	{
+		result[it.key()] = it.value();
+	}
+	printJson(result);
+	return EXIT_SUCCESS;
+}
+
+
+//! Runs @p scenario in a child process and returns its result
+QJsonObject runChild(const Scenario & scenario)
+{
+	QProcess child;
+	child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	child.start(QCoreApplication::applicationFilePath(),
+				QStringList() << "--run" << scenario.name);
+	child.waitForFinished(-1);
+
+	const QJsonObject result = QJsonDocument::fromJson(
+					child.readAllStandardOutput()).object();
+	if (result.isEmpty())
+	{
+		QJsonObject failed;
+		failed["name"] = scenario.name;
+		failed["error"] = QString("the benchmark exited with %1")
+						.arg(child.exitCode());
+		return failed;
+	}
+	return result;
+}
+
+
+//! Prints the change of each result against @p baseline, returns the
+//! number of scenarios slower by more than @p tolerance percent
+int compare(const QJsonArray & results, const QJsonObject & baseline,
+							double tolerance)
+{
+	if (baseline["version"].toInt() != Version ||
+		baseline["samplerate"].toString() != SampleRate)
+	{
+		fprintf(stderr, "The baseline is of other scenarios or settings, "
+						"not comparing to it.\n");
+		return 0;
+	}
+
+	QJsonObject previous;
+	for (const QJsonValue & value : baseline["scenarios"].toArray())
+	{
+		previous[value.toObject()["name"].toString()] = value;
+	}
+
+	int regressions = 0;
+	for (const QJsonValue & value : results)
+	{
+		const QJsonObject result = value.toObject();
+		const QString name = result["name"].toString();
+		const double factor = result["realtime_factor"].toDouble();
+		const double before = previous[name].toObject()["realtime_factor"].toDouble();
+		if (result.contains("error") || before <= 0)
+		{
+			continue;
+		}
+		const double change = (factor / before - 1.0) * 100.0;
+		const bool regressed = change < -tolerance;
+		regressions += regressed;
+		fprintf(stderr, "%-12s %8.2fx realtime, %+6.1f%% %s\n",
+				qUtf8Printable(name), factor, change,
+				regressed ? "REGRESSION" : "");
+	}
+	return regressions;
+}
+
+
+} // namespace
+
+
+int main(int argc, char * argv[])
+{
+	QCoreApplication app(argc, argv);
+	const QStringList args = app.arguments();
+
+	QStringList names;
+	QString output;
+	QString baseline;
+	QString saveBaseline;
+	double tolerance = 10.0;
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString & arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+		if (arg == "--list")
+		{
+			for (const Scenario & scenario : scenarios())
+			{
+				printf("%-12s %s\n", scenario.name, scenario.description);
+			}
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--run" && hasValue)
+		{
+			const Scenario * scenario = findScenario(args[++i]);
+			return scenario ? runScenario(*scenario) : EXIT_FAILURE;
+		}
+		else if (arg == "--scenario" && hasValue)
+		{
+			names << args[++i];
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			output = args[++i];
+		}
+		else if (arg == "--baseline" && hasValue)
+		{
+			baseline = args[++i];
+		}
+		else if (arg == "--save-baseline" && hasValue)
+		{
+			saveBaseline = args[++i];
+		}
+		else if (arg == "--tolerance" && hasValue)
+		{
+			tolerance = args[++i].toDouble();
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", qUtf8Printable(arg));
+			return EXIT_FAILURE;
+		}
+	}
+
+	QJsonArray results;
+	bool failed = false;
+	for (const Scenario & scenario : scenarios())
+	{
+		if (!names.isEmpty() && !names.contains(scenario.name))
+		{
+			continue;
+		}
+		fprintf(stderr, "Rendering %s...\n", scenario.name);
+		const QJsonObject result = runChild(scenario);
+		if (result.contains("error"))
+		{
+			fprintf(stderr, "%s: %s\n", scenario.name,
+				qUtf8Printable(result["error"].toString()));
+			failed = true;
+		}
+		results.append(result);
+	}
+
+	QJsonObject report;
+	report["version"] = Version;
+	report["samplerate"] = SampleRate;
+	report["frames_per_period"] = FramesPerPeriod;
+	report["quality"] = "high";
+	report["threads"] = QThread::idealThreadCount();
+	report["scenarios"] = results;
+
+	if (!output.isEmpty())
+	{
+		failed |= !writeJson(output, report);
+	}
+	else
+	{
+		printJson(report);
+	}
+	if (!saveBaseline.isEmpty())
+	{
+		failed |= !writeJson(saveBaseline, report);
+	}
+
+	int regressions = 0;
+	if (!baseline.isEmpty())
+	{
+		QFile file(baseline);
+		if (file.open(QIODevice::ReadOnly))
+		{
+			regressions = compare(results,
+				QJsonDocument::fromJson(file.readAll()).object(),
+				tolerance);
+		}
+		else
+		{
+			fprintf(stderr, "No baseline at %s, save one with "
+					"--save-baseline.\n", qUtf8Printable(baseline));
+		}
+	}
+
+	return failed || regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/*
+ * ConvolutionEngineTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <cmath>
+#include <vector>
+
+#include "ConvolutionEngine.h"
+
+class ConvolutionEngineTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	//! Checks every partition size against plain convolution, with periods
+	//! that don't line up with the partitions
+	void MatchesDirectConvolutionTest()
+	{
+		const f_cnt_t irFrames = 3 * ConvolutionEngine::TailBlockSize + 100;
+		std::vector<sampleFrame> ir(irFrames);
+		for (f_cnt_t f = 0; f < irFrames; ++f)
+		{
+			ir[f][0] = std::sin(f * 0.01f) * std::exp(-f / 4000.f);
+			ir[f][1] = f % 97 == 0 ? 0.5f : 0.f;
+		}
+		ConvolutionEngine engine(ir.data(), irFrames);
+
+		const f_cnt_t frames = irFrames + 2000;
+		std::vector<sampleFrame> in(frames);
+		std::vector<sampleFrame> out(frames);
+		for (f_cnt_t f = 0; f < frames; ++f)
+		{
+			in[f][0] = std::cos(f * 0.37f);
+			in[f][1] = f == 5 ? 1.f : 0.f;
+		}
+
+		const fpp_t periods[] = {256, 100, 1, 333};
+		f_cnt_t done = 0;
+		for (int i = 0; done < frames; ++i)
+		{
+			const fpp_t count = qMin<f_cnt_t>(frames - done, periods[i % 4]);
+			engine.process(in.data() + done, out.data() + done, count);
+			done += count;
+		}
+
+		for (f_cnt_t f = 0; f < frames; f += 13)
+		{
+			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				double expected = 0;
+				for (f_cnt_t k = 0; k < irFrames && k <= f; ++k)
+				{
+					expected += in[f - k][ch] * ir[k][ch];
+				}
+				QVERIFY(std::abs(out[f][ch] - expected) < 1e-3);
+			}
+		}
+	}
+
+	void ResetForgetsInputTest()
+	{
+		sampleFrame ir[64] = {};
+		ir[10][0] = ir[10][1] = 1.f;
+		ConvolutionEngine engine(ir, 64);
+
+		sampleFrame in[16] = {};
+		in[0][0] = 1.f;
+		sampleFrame out[16];
+		engine.process(in, out, 16);
+		QCOMPARE(out[10][0], 1.f);
+
+		engine.reset();
+		sampleFrame silence[16] = {};
+		engine.process(silence, out, 16);
+		for (int f = 0; f < 16; ++f)
+		{
+			QVERIFY(std::abs(out[f][0]) < 1e-6);
+		}
+	}
+} ConvolutionEngineTests;
+
+#include "ConvolutionEngineTest.moc"
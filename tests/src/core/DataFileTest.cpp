@@ -0,0 +1,226 @@
+/*
+ * DataFileTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "BinaryDocument.h"
+#include "BlockCompression.h"
+#include "DataFile.h"
+#include "ProjectStream.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QTemporaryDir>
+
+class DataFileTest : QTestSuite
+{
+	Q_OBJECT
+	//! Whether the nodes have the same contents, ignoring the order of attributes
+	static bool equal(const QDomNode& a, const QDomNode& b)
+	{
+		if (a.nodeType() != b.nodeType() || a.nodeName() != b.nodeName() ||
+			a.nodeValue() != b.nodeValue())
+		{
+			return false;
+		}
+		const QDomNamedNodeMap attributes = a.attributes();
+		if (attributes.count() != b.attributes().count())
+		{
+			return false;
+		}
+		for (int i = 0; i < attributes.count(); ++i)
+		{
+			const QDomNode attribute = attributes.item(i);
+			if (b.toElement().attribute(attribute.nodeName(), "\n") != attribute.nodeValue())
+			{
+				return false;
+			}
+		}
+		QDomNode x = a.firstChild();
+		QDomNode y = b.firstChild();
+		for (; !x.isNull() && !y.isNull(); x = x.nextSibling(), y = y.nextSibling())
+		{
+			if (!equal(x, y)) { return false; }
+		}
+		return x.isNull() && y.isNull();
+	}
+
+private slots:
+	void BinaryDocumentTests()
+	{
+		DataFile dataFile(DataFile::SongProject);
+		QDomElement pattern = dataFile.createElement("pattern");
+		for (int i = 0; i < 100; ++i)
+		{
+			QDomElement note = dataFile.createElement("note");
+			note.setAttribute("pos", i * 48);
+			note.setAttribute("key", 60 - i);
+			note.setAttribute("vol", i % 2 ? "0.5" : "1");
+			note.setAttribute("pan", i % 3 ? "0.1" : "-100");
+			pattern.appendChild(note);
+		}
+		pattern.setAttribute("name", "<Pattern \"1\"> & ä");
+		pattern.setAttribute("leading", "007");
+		pattern.setAttribute("precise", "0.30000001192092896");
+		pattern.appendChild(dataFile.createTextNode("text"));
+		pattern.appendChild(dataFile.createElement("note"));
+		dataFile.content().appendChild(pattern);
+
+		QDomDocument decoded;
+		QVERIFY(BinaryDocument::decode(BinaryDocument::encode(dataFile), decoded));
+		QVERIFY(equal(dataFile.documentElement(), decoded.documentElement()));
+		QCOMPARE(decoded.doctype().name(), QString("lmms-project"));
+
+		// truncated data is rejected
+		const QByteArray encoded = BinaryDocument::encode(dataFile);
+		QVERIFY(!BinaryDocument::decode(encoded.left(encoded.size() / 2), decoded));
+	}
+
+	void BlockCompressionTests()
+	{
+		QByteArray data;
+		for (int i = 0; data.size() < 3 << 20; ++i)
+		{
+			data += QByteArray::number(i * 7919 % 10007) + " ";
+		}
+		const QByteArray compressed = BlockCompression::compress(data);
+		QVERIFY(BlockCompression::isCompressed(compressed));
+		QVERIFY(compressed.size() < data.size());
+		QCOMPARE(BlockCompression::uncompress(compressed), data);
+		QVERIFY(BlockCompression::uncompress(compressed.left(compressed.size() / 2)).isEmpty());
+
+		// as written by earlier versions
+		QVERIFY(!BlockCompression::isCompressed(qCompress(data)));
+		QCOMPARE(BlockCompression::uncompress(qCompress(data)), data);
+
+		QBuffer buffer;
+		buffer.setData(compressed);
+		buffer.open(QIODevice::ReadOnly);
+		BlockCompression::Reader reader(&buffer);
+		QVERIFY(reader.open(QIODevice::ReadOnly));
+		QCOMPARE(reader.readAll(), data);
+		QVERIFY(reader.atEnd());
+	}
+
+	void BinaryProjectTests()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		const QString fileName = dir.path() + "/binary.mmpb";
+		QVERIFY(DataFile::isBinaryProject(fileName));
+		QVERIFY(!DataFile::isBinaryProject(dir.path() + "/binary.mmpz"));
+
+		const QByteArray first("first chunk");
+		const QByteArray second(1000, 'x');
+		{
+			DataFile dataFile(DataFile::SongProject);
+			dataFile.setStoresBinary(true);
+			QCOMPARE(DataFile::owner(dataFile.content()), &dataFile);
+			dataFile.content().setAttribute("first", dataFile.addBinary(first));
+			dataFile.content().setAttribute("second", dataFile.addBinary(second));
+			QVERIFY(dataFile.writeFile(fileName));
+		}
+
+		DataFile loaded(fileName);
+		QCOMPARE(loaded.type(), DataFile::SongProject);
+		QCOMPARE(DataFile::owner(loaded.content()), &loaded);
+		QCOMPARE(loaded.binary(loaded.content().attribute("first").toInt()), first);
+		QCOMPARE(loaded.binary(loaded.content().attribute("second").toInt()), second);
+		QVERIFY(loaded.binary(2).isEmpty());
+		// the chunks are aligned within the file
+		QCOMPARE(reinterpret_cast<quintptr>(loaded.binary(1).constData()) % 16, quintptr(0));
+
+		// converted to XML, the chunks are kept in it
+		const QString xmlName = dir.path() + "/binary.mmp";
+		QVERIFY(loaded.writeFile(xmlName));
+		DataFile xml(xmlName);
+		QVERIFY(xml.documentElement().firstChildElement("binarydata").isNull());
+		QCOMPARE(xml.binary(xml.content().attribute("second").toInt()), second);
+		QVERIFY(equal(loaded.documentElement(), xml.documentElement()));
+	}
+
+	void ProjectStreamTests()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		const QString fileName = dir.path() + "/stream.mmp";
+		{
+			DataFile dataFile(DataFile::SongProject);
+			QDomElement container = dataFile.createElement("trackcontainer");
+			for (int i = 0; i < 3; ++i)
+			{
+				QDomElement track = dataFile.createElement("track");
+				track.setAttribute("name", QString("Track %1").arg(i));
+				QDomElement sample = dataFile.createElement("sampletco");
+				sample.setAttribute("src", QString("sample%1.wav").arg(i));
+				track.appendChild(sample);
+				container.appendChild(track);
+			}
+			dataFile.content().appendChild(container);
+			dataFile.content().appendChild(dataFile.createElement("fxmixer"));
+			QVERIFY(dataFile.writeFile(fileName));
+			QVERIFY(dataFile.writeFile(dir.path() + "/stream.mmpz"));
+
+			// files which need upgrading are loaded whole
+			dataFile.documentElement().setAttribute("creatorversion", "1.0.0");
+			QVERIFY(dataFile.writeFile(dir.path() + "/old.mmp"));
+		}
+
+		ProjectStream project(fileName);
+		QVERIFY(project.isStreamed());
+		QVERIFY(!project.hasLocalPlugins());
+		QCOMPARE(project.trackCount(), 3);
+		QCOMPARE(project.resourceFiles("sampletco"),
+			QStringList({"sample0.wav", "sample1.wav", "sample2.wav"}));
+
+		// everything but the tracks is in the DOM
+		const QDomElement container = project.dataFile().content().firstChildElement("trackcontainer");
+		QVERIFY(!container.isNull());
+		QVERIFY(container.firstChildElement("track").isNull());
+		QVERIFY(!project.dataFile().content().firstChildElement("fxmixer").isNull());
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const QDomElement track = project.nextTrack();
+			QCOMPARE(track.attribute("name"), QString("Track %1").arg(i));
+			QCOMPARE(track.parentNode().nodeName(), QString("trackcontainer"));
+			QCOMPARE(track.firstChildElement("sampletco").attribute("src"),
+				QString("sample%1.wav").arg(i));
+		}
+		QVERIFY(project.nextTrack().isNull());
+
+		ProjectStream compressed(dir.path() + "/stream.mmpz");
+		QVERIFY(compressed.isStreamed());
+		QCOMPARE(compressed.nextTrack().attribute("name"), QString("Track 0"));
+
+		ProjectStream old(dir.path() + "/old.mmp");
+		QVERIFY(!old.isStreamed());
+		QCOMPARE(old.trackCount(), 3);
+		QVERIFY(!old.dataFile().content().firstChildElement("trackcontainer")
+			.firstChildElement("track").isNull());
+		QVERIFY(old.nextTrack().isNull());
+	}
+} DataFileTests;
+
+#include "DataFileTest.moc"
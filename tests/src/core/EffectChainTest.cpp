@@ -0,0 +1,125 @@
+/*
+ * EffectChainTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "DummyEffect.h"
+#include "EffectChain.h"
+#include "PlanarBuffer.h"
+
+namespace
+{
+
+//! Scales the channels, in the layout it's asked for
+class ScaleEffect : public Effect
+{
+public:
+	ScaleEffect(bool planar, float left, float right) :
+		Effect(nullptr, nullptr, nullptr),
+		m_controls(this),
+		m_planar(planar),
+		m_gains{left, right}
+	{
+	}
+
+	EffectControls* controls() override
+	{
+		return &m_controls;
+	}
+
+	bool prefersPlanar() const override
+	{
+		return m_planar;
+	}
+
+	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override
+	{
+		++interleavedCalls;
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			buf[f][0] *= m_gains[0];
+			buf[f][1] *= m_gains[1];
+		}
+		return true;
+	}
+
+	bool processPlanarBuffer(PlanarBuffer& buf, const fpp_t frames) override
+	{
+		++planarCalls;
+		for (ch_cnt_t ch = 0; ch < buf.channels(); ++ch)
+		{
+			for (fpp_t f = 0; f < frames; ++f)
+			{
+				buf.channel(ch)[f] *= m_gains[ch];
+			}
+		}
+		return true;
+	}
+
+	int interleavedCalls = 0;
+	int planarCalls = 0;
+
+private:
+	DummyEffectControls m_controls;
+	bool m_planar;
+	float m_gains[DEFAULT_CHANNELS];
+} ;
+
+} // namespace
+
+class EffectChainTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void MixedLayoutsTest()
+	{
+		EffectChain chain(nullptr);
+		auto first = new ScaleEffect(true, 2.0f, 3.0f);
+		auto second = new ScaleEffect(false, 0.5f, -1.0f);
+		auto third = new ScaleEffect(true, 4.0f, 0.25f);
+		chain.appendEffect(first);
+		chain.appendEffect(second);
+		chain.appendEffect(third);
+
+		const fpp_t frames = 64;
+		sampleFrame buf[frames];
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			buf[f] = {f * 0.01f, -f * 0.01f};
+		}
+		QVERIFY(chain.processAudioBuffer(buf, frames, true));
+
+		QCOMPARE(first->planarCalls, 1);
+		QCOMPARE(first->interleavedCalls, 0);
+		QCOMPARE(second->interleavedCalls, 1);
+		QCOMPARE(third->planarCalls, 1);
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			QCOMPARE(buf[f][0], f * 0.01f * 2.0f * 0.5f * 4.0f);
+			QCOMPARE(buf[f][1], -f * 0.01f * 3.0f * -1.0f * 0.25f);
+		}
+	}
+} EffectChainTests;
+
+#include "EffectChainTest.moc"
@@ -0,0 +1,83 @@
+/*
+ * EngineContextTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+
+#include "QTestSuite.h"
+
+#include "ControllerGraph.h"
+#include "Engine.h"
+#include "EngineContext.h"
+#include "Mixer.h"
+#include "Song.h"
+
+class EngineContextTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void ScopeSelectsContextTest()
+	{
+		EngineContext * mainContext = Engine::context();
+		QCOMPARE(mainContext, EngineContext::mainContext());
+
+		EngineContext session(true);
+		QCOMPARE(Engine::context(), mainContext);
+		QVERIFY(session.song() != mainContext->song());
+		QVERIFY(session.mixer() != mainContext->mixer());
+		{
+			EngineContext::Scope scope(&session);
+			QCOMPARE(Engine::getSong(), session.song());
+			QCOMPARE(Engine::mixer(), session.mixer());
+			QCOMPARE(Engine::fxMixer(), session.fxMixer());
+		}
+		QCOMPARE(Engine::getSong(), mainContext->song());
+	}
+
+	void TimelinesAreIndependentTest()
+	{
+		EngineContext session(true);
+		const long mainPeriods = Engine::controllerGraph()->periods();
+		{
+			EngineContext::Scope scope(&session);
+			Engine::controllerGraph()->advance(256);
+			QCOMPARE(Engine::controllerGraph()->periods(), 1L);
+			QCOMPARE(Engine::controllerGraph()->frames(), 256u);
+		}
+		QCOMPARE(Engine::controllerGraph()->periods(), mainPeriods);
+	}
+
+	void PeriodsAreIndependentTest()
+	{
+		EngineContext session(true);
+		const long mainPeriod = EngineContext::mainContext()->period();
+		{
+			EngineContext::Scope scope(&session);
+			EngineContext::current()->nextPeriod();
+			QCOMPARE(EngineContext::current()->period(), 1L);
+		}
+		QCOMPARE(EngineContext::current()->period(), mainPeriod);
+	}
+} EngineContextTests;
+
+#include "EngineContextTest.moc"
@@ -0,0 +1,85 @@
+/*
+ * FxDelayTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "QTestSuite.h"
+
+#include "FxMixer.h"
+
+class FxDelayTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void DelaysAcrossPeriodsTest()
+	{
+		FxDelay delay;
+		delay.reserve(3);
+		delay.setDelay(3);
+
+		sampleFrame buf[4];
+		for (int f = 0; f < 4; ++f) { buf[f] = {f + 1.0f, -(f + 1.0f)}; }
+		delay.process(buf, buf, true, 4);
+		QCOMPARE(buf[0][0], 0.0f);
+		QCOMPARE(buf[2][0], 0.0f);
+		QCOMPARE(buf[3][0], 1.0f);
+		QCOMPARE(buf[3][1], -1.0f);
+		QVERIFY(delay.isPending());
+
+		// the rest of the signal comes out of silent input
+		for (int f = 0; f < 4; ++f) { buf[f] = {0.0f, 0.0f}; }
+		delay.process(buf, buf, false, 4);
+		QCOMPARE(buf[0][0], 2.0f);
+		QCOMPARE(buf[2][0], 4.0f);
+		QCOMPARE(buf[3][0], 0.0f);
+		QVERIFY(!delay.isPending());
+	}
+
+	void ChangingTheDelayClearsTest()
+	{
+		FxDelay delay;
+		sampleFrame in[2] = {{1.0f, 1.0f}, {1.0f, 1.0f}};
+		sampleFrame out[2];
+		delay.reserve(2);
+		delay.setDelay(2);
+		delay.process(in, out, true, 2);
+		delay.setDelay(1);
+		QVERIFY(!delay.isPending());
+		delay.process(in, out, true, 2);
+		QCOMPARE(out[0][0], 0.0f);
+		QCOMPARE(out[1][0], 1.0f);
+	}
+
+	void DelayIsLimitedToReservedTest()
+	{
+		FxDelay delay;
+		delay.setDelay(4);
+		QCOMPARE(delay.delay(), 0);
+
+		delay.reserve(2);
+		delay.setDelay(4);
+		QCOMPARE(delay.delay(), 2);
+	}
+} FxDelayTests;
+
+#include "FxDelayTest.moc"
@@ -0,0 +1,96 @@
+/*
+ * IndexedPoolTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <cstdint>
+
+#include "IndexedPool.h"
+
+typedef IndexedPool<4, 4> TestPool;
+
+class IndexedPoolTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void ReleasedElementsComeBackTest()
+	{
+		TestPool pool("test", 100, 64);
+		TestPool::ThreadCache cache(pool);
+		pool.grow();
+		QCOMPARE(pool.capacity(), 4);
+
+		void * first = pool.acquire(cache);
+		void * second = pool.acquire(cache);
+		QVERIFY(first != nullptr && second != nullptr && first != second);
+		QCOMPARE(reinterpret_cast<std::uintptr_t>(first) % 64, std::uintptr_t(0));
+		QCOMPARE(pool.inUse(), 2);
+
+		pool.release(cache, second);
+		QCOMPARE(pool.acquire(cache), second);
+		pool.release(cache, second);
+		pool.release(cache, first);
+		QCOMPARE(pool.inUse(), 0);
+		QCOMPARE(pool.highWaterMark(), 2);
+		pool.free();
+	}
+
+	void EmptyPoolOverflowsTest()
+	{
+		TestPool pool("test", 16, 8);
+		TestPool::ThreadCache cache(pool);
+		QVERIFY(pool.acquire(cache) == nullptr);
+		QCOMPARE(pool.overflows(), 1);
+
+		void * overflow = pool.acquireOverflow();
+		QCOMPARE(pool.inUse(), 1);
+		pool.release(cache, overflow);
+		QCOMPARE(pool.inUse(), 0);
+
+		// the overflow doesn't end up in the pool
+		pool.growIfRequested();
+		QCOMPARE(pool.capacity(), 4);
+		pool.free();
+	}
+
+	void FreeDropsCachedElementsTest()
+	{
+		TestPool pool("test", 16, 8);
+		TestPool::ThreadCache cache(pool);
+		pool.grow();
+		pool.release(cache, pool.acquire(cache));
+
+		pool.free();
+		pool.grow();
+		// only the new chunk's elements are handed out
+		for (int i = 0; i < 4; ++i)
+		{
+			QVERIFY(pool.acquire(cache) != nullptr);
+		}
+		QVERIFY(pool.acquire(cache) == nullptr);
+		pool.free();
+	}
+} IndexedPoolTests;
+
+#include "IndexedPoolTest.moc"
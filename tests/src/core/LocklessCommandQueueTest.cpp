@@ -0,0 +1,72 @@
+/*
+ * LocklessCommandQueueTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "LocklessCommandQueue.h"
+
+#include <QVector>
+
+class LocklessCommandQueueTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void ProcessesInPostingOrderTest()
+	{
+		LocklessCommandQueue queue;
+		QVector<int> done;
+		for (int i = 0; i < 5; ++i)
+		{
+			queue.post([&done, i]() { done.push_back(i); });
+		}
+		QVERIFY(queue.hasPending());
+		QCOMPARE(queue.process(), 5);
+		QVERIFY(!queue.hasPending());
+		QCOMPARE(done, QVector<int>({0, 1, 2, 3, 4}));
+		QCOMPARE(queue.process(), 0);
+	}
+
+	void CleanupAfterProcessingTest()
+	{
+		LocklessCommandQueue queue;
+		int changes = 0;
+		int cleanups = 0;
+		queue.post([&changes]() { ++changes; }, [&cleanups]() { ++cleanups; });
+
+		// nothing processed yet, nothing to clean up
+		queue.reclaim();
+		QCOMPARE(cleanups, 0);
+
+		queue.process();
+		QCOMPARE(changes, 1);
+		QCOMPARE(cleanups, 0);
+
+		queue.reclaim();
+		QCOMPARE(cleanups, 1);
+		queue.reclaim();
+		QCOMPARE(cleanups, 1);
+	}
+} LocklessCommandQueueTests;
+
+#include "LocklessCommandQueueTest.moc"
@@ -0,0 +1,110 @@
+/*
+ * MathTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "interpolation.h"
+#include "lmms_math.h"
+
+#include <cmath>
+
+class MathTest : QTestSuite
+{
+	Q_OBJECT
+
+	//! Largest error of approx against exact over [from, to)
+	template<class Approx, class Exact>
+	static double maxError(Approx approx, Exact exact, double from, double to, double step, bool relative)
+	{
+		double error = 0.0;
+		for (double x = from; x < to; x += step)
+		{
+			// compare against the exact value at the rounded argument
+			const float xf = static_cast<float>(x);
+			const double e = exact(static_cast<double>(xf));
+			const double d = std::fabs(approx(xf) - e);
+			error = std::max(error, relative ? d / std::fabs(e) : d);
+		}
+		return error;
+	}
+
+private slots:
+	void FastExpLogTest()
+	{
+		QVERIFY(maxError(fastExp2f, [](double x) { return std::exp2(x); }, -126, 126, 0.001, true) < 3e-7);
+		QVERIFY(maxError(fastExpf, [](double x) { return std::exp(x); }, -20, 20, 0.001, true) < 1.5e-6);
+		QVERIFY(maxError(fastLog2f, [](double x) { return std::log2(x); }, 0.5, 2, 1e-5, false) < 1.5e-7);
+		QVERIFY(maxError(fastLogf, [](double x) { return std::log(x); }, 1e-3, 1e3, 0.01, true) < 1e-6);
+		QVERIFY(maxError(fastAmpToDbfs, [](double x) { return 20.0 * std::log10(x); }, 1e-3, 4, 1e-4, false) < 1e-5);
+		QVERIFY(maxError(fastDbfsToAmp, [](double x) { return std::pow(10.0, x / 20.0); }, -120, 24, 0.01, true) < 1e-6);
+		// arguments out of range are limited
+		QCOMPARE(fastExp2f(-1e30f), fastExp2f(-126.0f));
+		QCOMPARE(fastExp2f(1e30f), fastExp2f(126.0f));
+	}
+
+	void FastTrigTest()
+	{
+		QVERIFY(maxError(fastTanhf, [](double x) { return std::tanh(x); }, -20, 20, 1e-4, false) < 2e-7);
+		QCOMPARE(fastTanhf(1e30f), 1.0f);
+		QCOMPARE(fastTanhf(-1e30f), -1.0f);
+		QVERIFY(maxError(fastSinf, [](double x) { return std::sin(x); }, -D_2PI, D_2PI, 1e-5, false) < 1e-6);
+		QVERIFY(maxError(fastSin2Pi, [](double x) { return std::sin(x * D_2PI); }, -2, 2, 1e-6, false) < 1.2e-6);
+	}
+
+	void BlockTest()
+	{
+		float in[67];
+		float out[67];
+		for (int i = 0; i < 67; ++i)
+		{
+			in[i] = (i - 33) * 0.1f;
+		}
+		mathBlock<fastTanhf>(in, out, 67);
+		for (int i = 0; i < 67; ++i)
+		{
+			QCOMPARE(out[i], fastTanhf(in[i]));
+		}
+
+		float v1[67];
+		float v2[67];
+		float v3[67];
+		float x[67];
+		for (int i = 0; i < 67; ++i)
+		{
+			v1[i] = in[i] * 2.0f;
+			v2[i] = -in[i];
+			v3[i] = 1.0f - in[i];
+			x[i] = i / 67.0f;
+		}
+		// out is one of the inputs
+		for (int i = 0; i < 67; ++i) { out[i] = in[i]; }
+		interpolateBlock<optimal4pInterpolate>(out, v1, v2, v3, x, out, 67);
+		for (int i = 0; i < 67; ++i)
+		{
+			QCOMPARE(out[i], optimal4pInterpolate(in[i], v1[i], v2[i], v3[i], x[i]));
+		}
+	}
+} MathTests;
+
+#include "MathTest.moc"
@@ -0,0 +1,82 @@
+/*
+ * MeterSnapshotTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "MeterSnapshot.h"
+
+class MeterSnapshotTest : QTestSuite
+{
+	Q_OBJECT
+private:
+	static void period(MeterSnapshot & meters, float peak)
+	{
+		meters.beginWrite();
+		meters.write(0, peak, peak / 2, false);
+		meters.publish();
+	}
+
+private slots:
+	void PublishesPeaksTest()
+	{
+		MeterSnapshot meters;
+		meters.resize(2);
+		QVERIFY(meters.read() == nullptr);
+
+		period(meters, 0.5f);
+		const MeterSnapshot::Snapshot * s = meters.read();
+		QVERIFY(s != nullptr);
+		QCOMPARE(s->size(), std::size_t(2));
+		QCOMPARE((*s)[0].peakLeft, 0.5f);
+		QCOMPARE((*s)[0].peakRight, 0.25f);
+		QVERIFY(!(*s)[0].sleeping);
+		QVERIFY((*s)[1].sleeping);
+
+		// read only once
+		QVERIFY(meters.read() == nullptr);
+	}
+
+	void KeepsPeaksUntilReadTest()
+	{
+		MeterSnapshot meters;
+		meters.resize(1);
+
+		// the first period is published at once, the peaks of the next
+		// ones are raised until it was read
+		period(meters, 0.9f);
+		period(meters, 0.3f);
+		period(meters, 0.1f);
+		QCOMPARE((*meters.read())[0].peakLeft, 0.9f);
+		QVERIFY(meters.read() == nullptr);
+
+		period(meters, 0.2f);
+		QCOMPARE((*meters.read())[0].peakLeft, 0.3f);
+
+		// a new snapshot starts over
+		period(meters, 0.2f);
+		QCOMPARE((*meters.read())[0].peakLeft, 0.2f);
+	}
+} MeterSnapshotTests;
+
+#include "MeterSnapshotTest.moc"
@@ -0,0 +1,212 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "MixHelpers.h"
+#include "ValueBuffer.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+class MixHelpersTest : QTestSuite
+{
+	Q_OBJECT
+
+	using Buffer = std::vector<sampleFrame>;
+	using Mix = std::function<void(sampleFrame*, int)>;
+
+	static float random(unsigned& seed)
+	{
+		seed = seed * 1103515245 + 12345;
+		return ((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+	}
+
+	static Buffer randomBuffer(int frames, unsigned seed)
+	{
+		Buffer buf(frames);
+		for (auto& frame : buf)
+		{
+			frame[0] = random(seed);
+			frame[1] = random(seed);
+		}
+		return buf;
+	}
+
+	//! Run mix with every supported instruction set and compare the result
+	//! to the one of the scalar implementation bit by bit
+	static bool matchesScalar(const Mix& mix)
+	{
+		bool matches = true;
+		// odd sizes to cover the scalar tails of the kernels
+		for (int frames : {0, 1, 3, 7, 16, 33, 256})
+		{
+			const Buffer initial = randomBuffer(frames, 42);
+			Buffer expected = initial;
+			MixHelpers::setInstructionSet(MixHelpers::InstructionSetScalar);
+			mix(expected.data(), frames);
+
+			for (int i = 0; i < MixHelpers::NumInstructionSets; ++i)
+			{
+				const auto set = static_cast<MixHelpers::InstructionSets>(i);
+				if (!MixHelpers::setInstructionSet(set)) { continue; }
+				Buffer result = initial;
+				mix(result.data(), frames);
+				if (memcmp(result.data(), expected.data(),
+					frames * sizeof(sampleFrame)) != 0)
+				{
+					qWarning("%s differs from scalar for %d frames",
+						MixHelpers::instructionSetName(set), frames);
+					matches = false;
+				}
+			}
+		}
+		return matches;
+	}
+
+	MixHelpers::InstructionSets m_detected;
+	bool m_nanHandler;
+
+private slots:
+	void initTestCase()
+	{
+		m_detected = MixHelpers::instructionSet();
+		m_nanHandler = MixHelpers::useNaNHandler();
+		MixHelpers::setNaNHandler(true);
+	}
+
+	void cleanupTestCase()
+	{
+		MixHelpers::setInstructionSet(m_detected);
+		MixHelpers::setNaNHandler(m_nanHandler);
+	}
+
+	void DetectedSetIsSupportedTest()
+	{
+		QVERIFY(MixHelpers::isSupported(m_detected));
+		QVERIFY(MixHelpers::isSupported(MixHelpers::InstructionSetScalar));
+	}
+
+	void AddTest()
+	{
+		const Buffer src = randomBuffer(256, 1);
+		QVERIFY(matchesScalar([&](sampleFrame* dst, int frames) {
+			MixHelpers::add(dst, src.data(), frames);
+			MixHelpers::addMultiplied(dst, src.data(), 0.7f, frames);
+			MixHelpers::addSwappedMultiplied(dst, src.data(), 0.3f, frames);
+			MixHelpers::addMultipliedStereo(dst, src.data(), 0.2f, 1.3f, frames);
+		}));
+	}
+
+	void MultiplyTest()
+	{
+		const Buffer src = randomBuffer(256, 2);
+		std::vector<sample_t> left(256), right(256);
+		unsigned seed = 3;
+		for (int i = 0; i < 256; ++i)
+		{
+			left[i] = random(seed);
+			right[i] = random(seed);
+		}
+		QVERIFY(matchesScalar([&](sampleFrame* dst, int frames) {
+			MixHelpers::multiplyAndAddMultiplied(dst, src.data(), 0.8f, 0.4f, frames);
+			MixHelpers::multiplyAndAddMultipliedJoined(dst, left.data(), right.data(), 0.5f, 0.25f, frames);
+		}));
+	}
+
+	void ByBufferTest()
+	{
+		Buffer src = randomBuffer(256, 4);
+		ValueBuffer coeffs1(256), coeffs2(256);
+		unsigned seed = 5;
+		for (int i = 0; i < 256; ++i)
+		{
+			coeffs1.values()[i] = random(seed);
+			coeffs2.values()[i] = random(seed);
+		}
+		QVERIFY(matchesScalar([&](sampleFrame* dst, int frames) {
+			MixHelpers::addMultipliedByBuffer(dst, src.data(), 0.6f, &coeffs1, frames);
+			MixHelpers::addMultipliedByBuffers(dst, src.data(), &coeffs1, &coeffs2, frames);
+		}));
+
+		// the sanitizing versions must drop exactly the same samples
+		src[1][0] = INFINITY;
+		src[5][1] = -INFINITY;
+		src[20][0] = NAN;
+		QVERIFY(matchesScalar([&](sampleFrame* dst, int frames) {
+			MixHelpers::addSanitizedMultiplied(dst, src.data(), 0.7f, frames);
+			MixHelpers::addSanitizedMultipliedByBuffer(dst, src.data(), 0.6f, &coeffs1, frames);
+			MixHelpers::addSanitizedMultipliedByBuffers(dst, src.data(), &coeffs1, &coeffs2, frames);
+		}));
+	}
+
+	void AnalyzeTest()
+	{
+		Buffer buf(33, sampleFrame{{0.0f, 0.0f}});
+		buf[3] = {{-0.5f, 0.25f}};
+		buf[32] = {{0.125f, -0.75f}};
+		for (int i = 0; i < MixHelpers::NumInstructionSets; ++i)
+		{
+			if (!MixHelpers::setInstructionSet(static_cast<MixHelpers::InstructionSets>(i))) { continue; }
+			MixHelpers::BufferAnalysis analysis = MixHelpers::analyze(buf.data(), 33);
+			QCOMPARE(analysis.peakLeft, 0.5f);
+			QCOMPARE(analysis.peakRight, 0.75f);
+			QCOMPARE(analysis.meanSquare, (0.25f + 0.0625f + 0.015625f + 0.5625f) / 33);
+			QVERIFY(!analysis.silent);
+			QVERIFY(!analysis.bad);
+
+			buf[20][1] = NAN;
+			analysis = MixHelpers::analyze(buf.data(), 33);
+			QVERIFY(analysis.bad);
+			// nans don't count as peaks
+			QCOMPARE(analysis.peakRight, 0.75f);
+			buf[20][1] = 0.0f;
+
+			QVERIFY(MixHelpers::analyze(buf.data(), 3).silent);
+		}
+	}
+
+	void IsSilentTest()
+	{
+		Buffer quiet(64, sampleFrame{{1e-9f, -1e-9f}});
+		for (int i = 0; i < MixHelpers::NumInstructionSets; ++i)
+		{
+			if (!MixHelpers::setInstructionSet(static_cast<MixHelpers::InstructionSets>(i))) { continue; }
+			quiet[37][1] = 0.0f;
+			QVERIFY(MixHelpers::isSilent(quiet.data(), 64));
+			// with 63 frames, the last one is in the scalar tail of every kernel
+			quiet[62][1] = 0.5f;
+			QVERIFY(!MixHelpers::isSilent(quiet.data(), 63));
+			QVERIFY(MixHelpers::isSilent(quiet.data(), 62));
+			quiet[62][1] = 0.0f;
+			quiet[2][0] = -0.5f;
+			QVERIFY(!MixHelpers::isSilent(quiet.data(), 64));
+			quiet[2][0] = 0.0f;
+		}
+	}
+} MixHelpersTests;
+
+#include "MixHelpersTest.moc"
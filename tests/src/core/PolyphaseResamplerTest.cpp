@@ -0,0 +1,115 @@
+/*
+ * PolyphaseResamplerTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "QTestSuite.h"
+
+#include "lmms_constants.h"
+#include "PolyphaseResampler.h"
+
+#include <cmath>
+#include <vector>
+
+class PolyphaseResamplerTest : QTestSuite
+{
+	Q_OBJECT
+
+	struct Result
+	{
+		double frameRatio;
+		// the largest difference to the ideally resampled sine
+		double error;
+		double peak;
+	} ;
+
+	//! Resample a sine of the given frequency in periods of 256 frames
+	static Result resampleSine(sample_rate_t inputRate, sample_rate_t outputRate, double frequency)
+	{
+		PolyphaseResampler resampler;
+		const bool ready = resampler.setup(inputRate, outputRate, SincResampler::SincMedium, 256);
+		Result result = {0.0, 0.0, 0.0};
+		if (!ready) { return result; }
+
+		std::vector<surroundSampleFrame> in(256);
+		std::vector<surroundSampleFrame> out(1024);
+		long inFrames = 0;
+		long outFrames = 0;
+		for (int period = 0; period < 200; ++period)
+		{
+			for (auto& frame : in)
+			{
+				frame.fill(static_cast<float>(std::sin(2 * D_PI * frequency * inFrames / inputRate)));
+				++inFrames;
+			}
+			const fpp_t produced = resampler.process(in.data(), 256, out.data(), 1024);
+			for (fpp_t f = 0; f < produced; ++f, ++outFrames)
+			{
+				// skip the filter's settling time
+				if (period < 10) { continue; }
+				const double t = static_cast<double>(outFrames) / outputRate - resampler.latency() / inputRate;
+				const double expected = std::sin(2 * D_PI * frequency * t);
+				result.error = std::fmax(result.error, std::fabs(out[f][0] - expected));
+				result.peak = std::fmax(result.peak, std::fabs(out[f][0]));
+			}
+		}
+		result.frameRatio = static_cast<double>(outFrames) / inFrames;
+		return result;
+	}
+
+private slots:
+	void DecimatesIntegerRatiosTest()
+	{
+		for (int factor : {2, 4, 8})
+		{
+			const Result passed = resampleSine(44100 * factor, 44100, 1000.0);
+			QCOMPARE(passed.frameRatio, 1.0 / factor);
+			QVERIFY(passed.error < 1e-3);
+
+			// above the output Nyquist frequency, so it must not alias back
+			const Result stopped = resampleSine(44100 * factor, 44100, 30000.0);
+			QVERIFY(stopped.peak < 1e-3);
+		}
+	}
+
+	void ResamplesRationalRatiosTest()
+	{
+		const Result down = resampleSine(48000, 44100, 1000.0);
+		QVERIFY(std::fabs(down.frameRatio - 44100.0 / 48000.0) < 1e-3);
+		QVERIFY(down.error < 1e-3);
+
+		const Result up = resampleSine(44100, 48000, 1000.0);
+		QVERIFY(std::fabs(up.frameRatio - 48000.0 / 44100.0) < 1e-3);
+		QVERIFY(up.error < 1e-3);
+	}
+
+	void RejectsTooManyPhasesTest()
+	{
+		PolyphaseResampler resampler;
+		// 44101 and 44100 are coprime
+		QVERIFY(!resampler.setup(44100, 44101, SincResampler::SincFastest, 256));
+		QVERIFY(resampler.setup(44100, 48000, SincResampler::SincFastest, 256));
+	}
+} PolyphaseResamplerTests;
+
+#include "PolyphaseResamplerTest.moc"
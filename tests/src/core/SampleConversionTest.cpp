@@ -0,0 +1,123 @@
+/*
+ * SampleConversionTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "QTestSuite.h"
+
+#include "SampleConversion.h"
+
+#include <cmath>
+#include <vector>
+
+class SampleConversionTest : QTestSuite
+{
+	Q_OBJECT
+
+	using Buffer = std::vector<surroundSampleFrame>;
+
+	//! A ramp from -1.5 to 1.5, so some samples clip
+	static Buffer ramp(int frames)
+	{
+		Buffer buf(frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			const float x = 3.0f * f / (frames - 1) - 1.5f;
+			for (auto& sample : buf[f]) { sample = x; }
+			buf[f][1] = -x;
+		}
+		return buf;
+	}
+
+private slots:
+	void ClipsAndRoundsS16Test()
+	{
+		// an odd size to cover the scalar tail after the SIMD loop
+		const int frames = 13;
+		const Buffer in = ramp(frames);
+		std::vector<int16_t> out(frames * SURROUND_CHANNELS);
+		SampleConversion::toS16(in.data(), frames, SURROUND_CHANNELS, 0.5f, out.data());
+		for (int f = 0; f < frames; ++f)
+		{
+			for (int ch = 0; ch < SURROUND_CHANNELS; ++ch)
+			{
+				const float x = std::fmax(-1.0f, std::fmin(1.0f, in[f][ch] * 0.5f));
+				QCOMPARE(out[f * SURROUND_CHANNELS + ch], static_cast<int16_t>(std::lrint(x * 32767.0f)));
+			}
+		}
+
+		SampleConversion::toS16(in.data(), frames, SURROUND_CHANNELS, 1.0f, out.data());
+		QCOMPARE(out[0], static_cast<int16_t>(-32767));
+		QCOMPARE(out[1], static_cast<int16_t>(32767));
+	}
+
+	void SwapsBytesTest()
+	{
+		Buffer in(9);
+		for (auto& frame : in) { frame.fill(1.0f); }
+		std::vector<int16_t> out(9 * SURROUND_CHANNELS);
+		SampleConversion::toS16(in.data(), 9, SURROUND_CHANNELS, 1.0f, out.data(), true);
+		for (int16_t sample : out)
+		{
+			QCOMPARE(static_cast<uint16_t>(sample), static_cast<uint16_t>(0xff7f));
+		}
+	}
+
+	void AlignsS24Test()
+	{
+		const int frames = 7;
+		const Buffer in = ramp(frames);
+		std::vector<int32_t> out(frames * SURROUND_CHANNELS);
+		SampleConversion::toS32(in.data(), frames, SURROUND_CHANNELS, 1.0f, out.data(), 24);
+		QCOMPARE(out[0], -8388607 * 256);
+		QCOMPARE(out[1], 8388607 * 256);
+		for (int32_t sample : out)
+		{
+			QCOMPARE(sample & 0xff, 0);
+		}
+	}
+
+	void DitherKeepsQuietSignalsTest()
+	{
+		// a DC offset of a third of the 16 bit step, which truncates to
+		// silence without dithering
+		const int frames = 20000;
+		Buffer in(frames);
+		for (auto& frame : in) { frame.fill(1.0f / (3.0f * 32767.0f)); }
+		std::vector<int16_t> out(frames * SURROUND_CHANNELS);
+
+		SampleConversion::toS16(in.data(), frames, SURROUND_CHANNELS, 1.0f, out.data());
+		for (int16_t sample : out) { QCOMPARE(sample, static_cast<int16_t>(0)); }
+
+		for (auto dithering : {SampleConversion::DitherTriangular, SampleConversion::DitherShaped})
+		{
+			SampleConversion::Ditherer ditherer(dithering);
+			SampleConversion::toS16(in.data(), frames, SURROUND_CHANNELS, 1.0f, out.data(), false, &ditherer);
+			double sum = 0;
+			for (int f = 0; f < frames; ++f) { sum += out[f * SURROUND_CHANNELS]; }
+			QVERIFY(std::fabs(sum / frames - 1.0 / 3.0) < 0.05);
+		}
+	}
+} SampleConversionTests;
+
+#include "SampleConversionTest.moc"
@@ -0,0 +1,85 @@
+/*
+ * VisualizationTapTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "VisualizationTap.h"
+
+class VisualizationTapTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void DisabledWithoutViewsTest()
+	{
+		VisualizationTap tap(4);
+		sampleFrame buf[8] = {};
+		tap.write(buf, 8);
+		QVERIFY(tap.read() == nullptr);
+	}
+
+	void ReducesToMinMaxTest()
+	{
+		VisualizationTap tap(2);
+		tap.attach();
+		sampleFrame buf[8];
+		for (int f = 0; f < 8; ++f)
+		{
+			buf[f][0] = f;
+			buf[f][1] = -f;
+		}
+		tap.write(buf, 8);
+
+		const VisualizationTap::Snapshot * s = tap.read();
+		QVERIFY(s != nullptr);
+		QCOMPARE(s->points, 2);
+		QCOMPARE(s->framesPerPoint, 4);
+		QCOMPARE(s->min[0][0], 0.f);
+		QCOMPARE(s->max[0][0], 3.f);
+		QCOMPARE(s->min[1][1], -7.f);
+		QCOMPARE(s->max[1][1], -4.f);
+		QCOMPARE(s->first[1][0], 4.f);
+
+		// read only once
+		QVERIFY(tap.read() == nullptr);
+	}
+
+	void AccumulatesUntilReadTest()
+	{
+		VisualizationTap tap(4);
+		tap.attach();
+		sampleFrame buf[4] = {};
+
+		// the first write is published at once, the next two are collected
+		tap.write(buf, 4, true);
+		tap.write(buf, 4, true);
+		tap.write(buf, 4, true);
+		QCOMPARE(tap.read()->frames, f_cnt_t(4));
+		QVERIFY(tap.read() == nullptr);
+
+		tap.write(buf, 4, true);
+		QCOMPARE(tap.read()->points, 12);
+	}
+} VisualizationTapTests;
+
+#include "VisualizationTapTest.moc"
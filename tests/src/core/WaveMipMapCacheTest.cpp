@@ -0,0 +1,101 @@
+/*
+ * WaveMipMapCacheTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+
+#include "QTestSuite.h"
+
+#include "lmms_constants.h"
+#include "WaveMipMapCache.h"
+
+#include <cmath>
+#include <vector>
+
+class WaveMipMapCacheTest : QTestSuite
+{
+	Q_OBJECT
+
+	//! The largest difference of table @p t to @p expected of the phase
+	template<class F>
+	static double tableError(const WaveMipMap & mipMap, int t, F expected)
+	{
+		double error = 0.0;
+		for (int i = 0; i < TLENS[t]; ++i)
+		{
+			const double phase = static_cast<double>(i) / TLENS[t];
+			error = std::fmax(error, std::fabs(mipMap.sampleAt(t, i) - expected(phase)));
+		}
+		return error;
+	}
+
+private slots:
+	void DropsHarmonicsAboveTableNyquistTest()
+	{
+		// the fundamental and the 20th harmonic
+		std::vector<float> wave(64);
+		for (int i = 0; i < 64; ++i)
+		{
+			const double phase = static_cast<double>(i) / 64;
+			wave[i] = static_cast<float>(std::sin(2 * D_PI * phase) + 0.5 * std::sin(2 * D_PI * 20 * phase));
+		}
+		const WaveMipMapCache::MipMapPtr mipMap = WaveMipMapCache::get(wave.data(), 64);
+		QVERIFY(mipMap != nullptr);
+
+		// 16 samples can't hold the 20th harmonic
+		QCOMPARE(TLENS[6], 16);
+		QVERIFY(tableError(*mipMap, 6, [](double p) { return std::sin(2 * D_PI * p); }) < 1e-5);
+
+		// 48 samples can
+		QCOMPARE(TLENS[9], 48);
+		QVERIFY(tableError(*mipMap, 9, [](double p) {
+			return std::sin(2 * D_PI * p) + 0.5 * std::sin(2 * D_PI * 20 * p); }) < 1e-5);
+	}
+
+	void SharesMipMapsOfEqualWavesTest()
+	{
+		std::vector<float> wave(32);
+		for (int i = 0; i < 32; ++i)
+		{
+			wave[i] = i < 16 ? 1.0f : -1.0f;
+		}
+		const WaveMipMapCache::MipMapPtr first = WaveMipMapCache::get(wave.data(), 32);
+		const WaveMipMapCache::MipMapPtr second = WaveMipMapCache::get(wave.data(), 32);
+		QCOMPARE(first.get(), second.get());
+
+		wave[0] = 0.0f;
+		const WaveMipMapCache::MipMapPtr other = WaveMipMapCache::get(wave.data(), 32);
+		QVERIFY(other.get() != first.get());
+	}
+
+	void BuildsOscillatorShapesTest()
+	{
+		const WaveMipMapCache::MipMapPtr sine = WaveMipMapCache::get(Oscillator::SineWave);
+		QVERIFY(sine != nullptr);
+		QVERIFY(tableError(*sine, 12, [](double p) { return std::sin(2 * D_PI * p); }) < 1e-4);
+
+		QVERIFY(WaveMipMapCache::get(Oscillator::WhiteNoise) == nullptr);
+	}
+} WaveMipMapCacheTests;
+
+#include "WaveMipMapCacheTest.moc"
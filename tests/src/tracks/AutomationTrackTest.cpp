@@ -27,12 +27,14 @@
 #include "QCoreApplication"
 
 #include "AutomationPattern.h"
+#include "AutomationSchedule.h"
 #include "AutomationTrack.h"
 #include "BBTrack.h"
 #include "BBTrackContainer.h"
 #include "DetuningHelper.h"
 #include "InstrumentTrack.h"
 #include "Pattern.h"
+#include "TempoMap.h"
 #include "TrackContainer.h"
 
 #include "Engine.h"
@@ -59,6 +61,12 @@ private slots:
 		QCOMPARE(p.valueAt(75), 0.75f);
 		QCOMPARE(p.valueAt(100), 1.0f);
 		QCOMPARE(p.valueAt(150), 1.0f);
+
+		float values[3];
+		p.valuesAt(50, 0.0f, 0.5f, values, 3);
+		QCOMPARE(values[0], 0.5f);
+		QCOMPARE(values[1], 0.505f);
+		QCOMPARE(values[2], 0.51f);
 	}
 
 	void testPatternDiscrete()
@@ -74,6 +82,29 @@ private slots:
 		QCOMPARE(p.valueAt(150), 1.0f);
 	}
 
+	void testPatternSeeking()
+	{
+		AutomationPattern p(nullptr);
+		p.setProgressionType(AutomationPattern::LinearProgression);
+		p.putValue(0, 0.0, false);
+		p.putValue(100, 1.0, false);
+		p.putValue(200, 0.0, false);
+
+		// forwards, backwards and jumping, as when looping and seeking
+		QCOMPARE(p.valueAt(50), 0.5f);
+		QCOMPARE(p.valueAt(150), 0.5f);
+		QCOMPARE(p.valueAt(250), 0.0f);
+		QCOMPARE(p.valueAt(175), 0.25f);
+		QCOMPARE(p.valueAt(25), 0.25f);
+		QCOMPARE(p.valueAt(100), 1.0f);
+
+		// edits take effect at once
+		p.putValue(100, 0.5, false);
+		QCOMPARE(p.valueAt(50), 0.25f);
+		p.setProgressionType(AutomationPattern::DiscreteProgression);
+		QCOMPARE(p.valueAt(50), 0.0f);
+	}
+
 	void testPatterns()
 	{
 		FloatModel model;
@@ -194,6 +225,95 @@ private slots:
 		QCOMPARE(song->automatedValuesAt(TimePos::ticksPerBar() + 5)[&model], 0.5f);
 	}
 
+	void testSchedule()
+	{
+		auto song = Engine::getSong();
+		auto bbContainer = Engine::getBBTrackContainer();
+		BBTrack bbTrack(song);
+		Track* bbAutomationTrack = Track::create(Track::AutomationTrack, bbContainer);
+
+		FloatModel model(0.0f, 0.0f, 1.0f, 0.001f);
+
+		auto p1 = dynamic_cast<AutomationPattern*>(bbAutomationTrack->getTCO(bbTrack.index()));
+		QVERIFY(p1);
+		p1->setProgressionType(AutomationPattern::LinearProgression);
+		p1->putValue(0, 0.0, false);
+		p1->putValue(10, 1.0, false);
+		p1->addObject(&model);
+
+		BBTCO tco(&bbTrack);
+		tco.changeLength(TimePos::ticksPerBar() * 2);
+		tco.movePosition(0);
+
+		AutomationTrack track(song);
+		AutomationPattern p2(&track);
+		p2.setProgressionType(AutomationPattern::DiscreteProgression);
+		p2.putValue(0, 0.25, false);
+		p2.movePosition(TimePos::ticksPerBar());
+		p2.addObject(&model);
+
+		AutomationSchedule schedule;
+		schedule.build(song, TrackList{song->globalAutomationTrack()} << song->tracks());
+		QVERIFY(schedule.isCurrent(song, -1));
+
+		// Seeking backwards has to give the same values as playing forwards
+		for (tick_t time : {0, 5, 10, TimePos::ticksPerBar() + 5, 3, TimePos::ticksPerBar() * 3})
+		{
+			schedule.apply(time, {});
+			QCOMPARE(model.value(), song->automatedValuesAt(time)[&model]);
+		}
+
+		// Muting is seen without rebuilding the schedule
+		p2.setMuted(true);
+		QVERIFY(schedule.isCurrent(song, -1));
+		schedule.apply(TimePos::ticksPerBar() + 5, {});
+		QCOMPARE(model.value(), 0.5f);
+
+		// Frames between the ticks follow the curve
+		schedule.render(0.5f, 0, 1);
+		ValueBuffer* buffer = model.valueBuffer();
+		QVERIFY(buffer);
+		QCOMPARE(buffer->value(0), 0.55f);
+
+		p2.movePosition(0);
+		QVERIFY(!schedule.isCurrent(song, -1));
+
+		delete bbAutomationTrack;
+	}
+
+	void testTempoMap()
+	{
+		auto song = Engine::getSong();
+		IntModel tempo(140, 10, 999);
+
+		AutomationTrack track(song);
+		AutomationPattern p(&track);
+		p.setProgressionType(AutomationPattern::DiscreteProgression);
+		p.putValue(0, 120, false);
+		p.putValue(TimePos::ticksPerBar(), 60, false);
+		p.addObject(&tempo);
+
+		AutomationSchedule schedule;
+		schedule.build(song, TrackList{song->globalAutomationTrack()} << song->tracks());
+		TempoMap map;
+		map.build(schedule, &tempo, 44100);
+		QVERIFY(map.isCurrent(&tempo, 44100));
+		QVERIFY(!map.isCurrent(&tempo, 48000));
+
+		const double bar = TimePos::ticksPerBar();
+		const double firstBar = bar * TempoMap::framesPerTick(44100, 120);
+		QCOMPARE(map.tempoAt(0), 120);
+		QCOMPARE(map.tempoAt(TimePos::ticksPerBar() * 4), 60);
+		QCOMPARE(map.framesAt(bar), firstBar);
+		QCOMPARE(map.framesAt(bar * 2), firstBar + bar * TempoMap::framesPerTick(44100, 60));
+		QCOMPARE(map.ticksAt(map.framesAt(bar * 1.5)), bar * 1.5);
+		QCOMPARE(map.millisecondsAt(bar), firstBar * 1000.0 / 44100);
+
+		// Editing the curve outdates the map
+		p.putValue(TimePos::ticksPerBar() * 2, 90, false);
+		QVERIFY(!map.isCurrent(&tempo, 44100));
+	}
+
 	void testGlobalAutomation()
 	{
 		// Global automation should not have priority, see https://github.com/LMMS/lmms/issues/4268